@@ -5,10 +5,13 @@
 
 #include "spdk/stdinc.h"
 
+#include "spdk/accel.h"
 #include "spdk/bdev.h"
+#include "spdk/env.h"
 #include "spdk/event.h"
 #include "spdk/fd.h"
 #include "spdk/string.h"
+#include "spdk/thread.h"
 #include "spdk/util.h"
 #include "spdk/vmd.h"
 
@@ -20,6 +23,7 @@
 
 #define TIMESPEC_TO_MS(time) ((time.tv_sec * 1000) + (time.tv_nsec / 1000000))
 #define STATUS_POLLER_PERIOD_SEC 1
+#define DD_MANIFEST_MAGIC "SPDKDDM1"
 
 struct spdk_dd_opts {
 	char		*input_file;
@@ -28,18 +32,22 @@ struct spdk_dd_opts {
 	char		*output_file_flags;
 	char		*input_bdev;
 	char		*output_bdev;
+	char		*manifest;
 	uint64_t	input_offset;
 	uint64_t	output_offset;
 	int64_t		io_unit_size;
 	int64_t		io_unit_count;
 	uint32_t	queue_depth;
+	uint32_t	num_threads;
 	bool		aio;
 	bool		sparse;
+	bool		skip_zeroes;
 };
 
 static struct spdk_dd_opts g_opts = {
 	.io_unit_size = 4096,
 	.queue_depth = 2,
+	.num_threads = 1,
 };
 
 enum dd_submit_type {
@@ -53,10 +61,12 @@ struct dd_io {
 	uint64_t		length;
 	struct iocb		iocb;
 	enum dd_submit_type	type;
+	uint32_t		crc;
 #ifdef SPDK_CONFIG_URING
 	int			idx;
 #endif
 	void			*buf;
+	struct dd_worker	*worker;
 	STAILQ_ENTRY(dd_io)	link;
 };
 
@@ -98,6 +108,22 @@ struct dd_target {
 	bool open;
 };
 
+/* Copies a part of the input on its own thread, used when --threads is specified */
+struct dd_worker {
+	struct spdk_thread	*thread;
+	struct spdk_io_channel	*input_ch;
+	struct spdk_io_channel	*output_ch;
+	struct dd_io		*ios;
+
+	/* Position of the next read and end of this worker's part of the input, in bytes */
+	uint64_t		pos;
+	uint64_t		end;
+
+	uint32_t		outstanding;
+	int			error;
+	bool			done;
+};
+
 struct dd_job {
 	struct dd_target	input;
 	struct dd_target	output;
@@ -126,6 +152,25 @@ struct dd_job {
 	uint64_t		total_bytes;
 	uint64_t		incremental_bytes;
 	struct spdk_poller	*status_poller;
+
+	struct dd_worker	*workers;
+	uint32_t		active_workers;
+
+	/* Bytes not written because they were zeroes (--sparse) or unchanged (--manifest) */
+	uint64_t		skipped_bytes;
+
+	/* CRC-32C of each I/O unit, computed in this run and loaded from the previous one */
+	struct spdk_io_channel	*accel_ch;
+	uint32_t		*crcs;
+	uint32_t		*prev_crcs;
+	uint64_t		num_units;
+};
+
+/* Header of the --manifest file, followed by the CRC-32C of each I/O unit */
+struct dd_manifest_header {
+	char		magic[8];
+	uint64_t	io_unit_size;
+	uint64_t	num_units;
 };
 
 struct dd_flags {
@@ -166,6 +211,102 @@ dd_cleanup_bdev(struct dd_target io)
 	spdk_bdev_close(io.u.bdev.desc);
 }
 
+static int
+dd_load_manifest(void)
+{
+	struct dd_manifest_header header;
+	FILE *file;
+	size_t size;
+
+	g_job.num_units = SPDK_CEIL_DIV(g_job.copy_size, g_opts.io_unit_size);
+	size = g_job.num_units * sizeof(uint32_t);
+
+	g_job.crcs = calloc(1, spdk_max(size, 1));
+	if (g_job.crcs == NULL) {
+		return -ENOMEM;
+	}
+
+	file = fopen(g_opts.manifest, "r");
+	if (file == NULL) {
+		if (errno != ENOENT) {
+			SPDK_ERRLOG("Could not open manifest %s: %s\n", g_opts.manifest, strerror(errno));
+			return -errno;
+		}
+
+		printf("No previous manifest found, copying everything\n");
+		return 0;
+	}
+
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+	    memcmp(header.magic, DD_MANIFEST_MAGIC, sizeof(header.magic)) != 0 ||
+	    header.io_unit_size != (uint64_t)g_opts.io_unit_size ||
+	    header.num_units != g_job.num_units) {
+		printf("Previous manifest doesn't match this copy, copying everything\n");
+		fclose(file);
+		return 0;
+	}
+
+	g_job.prev_crcs = malloc(spdk_max(size, 1));
+	if (g_job.prev_crcs == NULL) {
+		fclose(file);
+		return -ENOMEM;
+	}
+
+	if (fread(g_job.prev_crcs, sizeof(uint32_t), g_job.num_units, file) != g_job.num_units) {
+		printf("Previous manifest is truncated, copying everything\n");
+		free(g_job.prev_crcs);
+		g_job.prev_crcs = NULL;
+	}
+
+	fclose(file);
+	return 0;
+}
+
+static int
+dd_save_manifest(void)
+{
+	struct dd_manifest_header header = {};
+	char *tmp_path;
+	FILE *file;
+	int rc = 0;
+
+	memcpy(header.magic, DD_MANIFEST_MAGIC, sizeof(header.magic));
+	header.io_unit_size = g_opts.io_unit_size;
+	header.num_units = g_job.num_units;
+
+	/* Write a new file and rename it, so that an interrupted write doesn't lose the old one */
+	tmp_path = spdk_sprintf_alloc("%s.tmp", g_opts.manifest);
+	if (tmp_path == NULL) {
+		return -ENOMEM;
+	}
+
+	file = fopen(tmp_path, "w");
+	if (file == NULL) {
+		rc = -errno;
+		goto out;
+	}
+
+	if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+	    fwrite(g_job.crcs, sizeof(uint32_t), g_job.num_units, file) != g_job.num_units) {
+		rc = -EIO;
+	}
+
+	if (fclose(file) != 0 && rc == 0) {
+		rc = -errno;
+	}
+
+	if (rc == 0 && rename(tmp_path, g_opts.manifest) != 0) {
+		rc = -errno;
+	}
+out:
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not write manifest %s: %s\n", g_opts.manifest, strerror(-rc));
+		unlink(tmp_path);
+	}
+	free(tmp_path);
+	return rc;
+}
+
 static void
 dd_exit(int rc)
 {
@@ -208,6 +349,22 @@ dd_exit(int rc)
 
 	spdk_poller_unregister(&g_job.status_poller);
 
+	if (g_job.accel_ch != NULL) {
+		spdk_put_io_channel(g_job.accel_ch);
+		g_job.accel_ch = NULL;
+	}
+
+	if (rc == 0 && g_interrupt == false) {
+		if (g_job.skipped_bytes > 0) {
+			printf("Skipped writing %" PRIu64 " of %" PRIu64 " bytes\n", g_job.skipped_bytes,
+			       g_job.total_bytes);
+		}
+
+		if (g_opts.manifest != NULL) {
+			rc = dd_save_manifest();
+		}
+	}
+
 	spdk_app_stop(rc);
 }
 
@@ -226,9 +383,8 @@ dd_show_progress(bool finish)
 	uint64_t milliseconds;
 	uint64_t size, tmp_size;
 
-	size = g_job.incremental_bytes;
-
-	g_job.incremental_bytes = 0;
+	/* The workers update the incremental bytes from their own threads */
+	size = __atomic_exchange_n(&g_job.incremental_bytes, 0, __ATOMIC_RELAXED);
 	g_job.total_bytes += size;
 
 	if (finish) {
@@ -402,6 +558,81 @@ dd_target_write(struct dd_io *io)
 	}
 }
 
+static void
+dd_target_skip_write(struct dd_io *io)
+{
+	g_job.incremental_bytes += io->length;
+	g_job.skipped_bytes += io->length;
+	dd_target_seek(io);
+}
+
+static void
+_dd_target_checksum_done(void *cb_arg, int status)
+{
+	struct dd_io *io = cb_arg;
+	uint64_t read_region_start = g_opts.input_offset * g_opts.io_unit_size;
+	uint64_t idx = (io->offset - read_region_start) / g_opts.io_unit_size;
+	bool unchanged;
+
+	assert(g_job.outstanding > 0);
+	g_job.outstanding--;
+
+	if (status != 0) {
+		SPDK_ERRLOG("%s\n", strerror(-status));
+		g_error = status;
+		dd_target_write(io);
+		return;
+	}
+
+	assert(idx < g_job.num_units);
+	unchanged = g_job.prev_crcs != NULL && g_job.prev_crcs[idx] == io->crc;
+	g_job.crcs[idx] = io->crc;
+
+	if (unchanged) {
+		dd_target_skip_write(io);
+	} else {
+		dd_target_write(io);
+	}
+}
+
+static void
+dd_target_checksum(struct dd_io *io)
+{
+	int rc;
+
+	if (g_error != 0 || g_interrupt == true) {
+		/* Let dd_target_write() finish the job */
+		dd_target_write(io);
+		return;
+	}
+
+	g_job.outstanding++;
+	rc = spdk_accel_submit_crc32c(g_job.accel_ch, &io->crc, io->buf, 0, io->length,
+				      _dd_target_checksum_done, io);
+	if (rc != 0) {
+		SPDK_ERRLOG("%s\n", strerror(-rc));
+		assert(g_job.outstanding > 0);
+		g_job.outstanding--;
+		g_error = rc;
+		if (g_job.outstanding == 0) {
+			dd_exit(rc);
+		}
+	}
+}
+
+/* Decide whether the data that was just read needs to be written */
+static void
+dd_target_read_done(struct dd_io *io)
+{
+	if (g_opts.manifest != NULL) {
+		dd_target_checksum(io);
+	} else if (g_opts.skip_zeroes && g_error == 0 && spdk_mem_all_zero(io->buf, io->length)) {
+		dd_target_skip_write(io);
+	} else {
+		dd_target_write(io);
+	}
+}
+
 static void
 _dd_read_bdev_done(struct spdk_bdev_io *bdev_io,
 		   bool success,
@@ -413,7 +644,7 @@ _dd_read_bdev_done(struct spdk_bdev_io *bdev_io,
 
 	assert(g_job.outstanding > 0);
 	g_job.outstanding--;
-	dd_target_write(io);
+	dd_target_read_done(io);
 }
 
 static void
@@ -493,6 +724,12 @@ dd_target_populate_buffer(struct dd_io *io)
 
 	if (io->length == 0 || g_error != 0 || g_interrupt == true) {
 		if (g_job.outstanding == 0) {
+			if (g_error == 0 && g_interrupt == false && g_opts.skip_zeroes) {
+				/* Trailing zeroes might not have been written, extend the output file */
+				dd_finalize_output();
+				return;
+			}
+
 			if (g_error == 0) {
 				dd_show_progress(true);
 				printf("\n\n");
@@ -723,6 +960,12 @@ dd_target_seek(struct dd_io *io)
 
 	if (g_job.copy_size - read_offset == 0 || g_error != 0 || g_interrupt == true) {
 		if (g_job.outstanding == 0) {
+			if (g_error == 0 && g_interrupt == false && g_opts.skip_zeroes) {
+				/* Trailing zeroes might not have been written, extend the output file */
+				dd_finalize_output();
+				return;
+			}
+
 			if (g_error == 0) {
 				dd_show_progress(true);
 				printf("\n\n");
@@ -787,7 +1030,7 @@ dd_complete_poll(struct dd_io *io)
 		dd_target_read(io);
 		break;
 	case DD_READ:
-		dd_target_write(io);
+		dd_target_read_done(io);
 		break;
 	case DD_WRITE:
 		dd_target_seek(io);
@@ -883,7 +1126,8 @@ dd_open_file(struct dd_target *target, const char *fname, int flags, uint64_t sk
 		flags |= O_CREAT;
 	}
 
-	if (input == false && ((flags & O_APPEND) == 0)) {
+	/* With --manifest, the unchanged parts of the previous copy are kept */
+	if (input == false && ((flags & O_APPEND) == 0) && g_opts.manifest == NULL) {
 		flags |= O_TRUNC;
 	}
 
@@ -1051,6 +1295,231 @@ dd_register_buffers(void)
 }
 #endif
 
+static void dd_worker_read(struct dd_io *io);
+
+static void
+dd_worker_exited(void *ctx)
+{
+	struct dd_worker *worker = ctx;
+
+	if (worker->error != 0 && g_error == 0) {
+		SPDK_ERRLOG("%s\n", strerror(-worker->error));
+		g_error = worker->error;
+	}
+
+	assert(g_job.active_workers > 0);
+	if (--g_job.active_workers > 0) {
+		return;
+	}
+
+	if (g_error == 0) {
+		dd_show_progress(true);
+		printf("\n\n");
+	}
+	dd_exit(g_error);
+}
+
+static void
+dd_worker_check_done(struct dd_worker *worker)
+{
+	if (worker->outstanding > 0 || worker->done) {
+		return;
+	}
+
+	worker->done = true;
+	spdk_put_io_channel(worker->input_ch);
+	spdk_put_io_channel(worker->output_ch);
+	spdk_thread_send_msg(spdk_thread_get_app_thread(), dd_worker_exited, worker);
+	spdk_thread_exit(worker->thread);
+}
+
+static void
+dd_worker_write_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct dd_io *io = cb_arg;
+	struct dd_worker *worker = io->worker;
+
+	spdk_bdev_free_io(bdev_io);
+
+	assert(worker->outstanding > 0);
+	worker->outstanding--;
+	if (!success) {
+		worker->error = -EIO;
+		dd_worker_check_done(worker);
+		return;
+	}
+
+	__atomic_fetch_add(&g_job.incremental_bytes, io->length, __ATOMIC_RELAXED);
+	dd_worker_read(io);
+}
+
+static void
+dd_worker_read_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct dd_io *io = cb_arg;
+	struct dd_worker *worker = io->worker;
+	uint64_t write_offset;
+	int rc;
+
+	spdk_bdev_free_io(bdev_io);
+
+	assert(worker->outstanding > 0);
+	worker->outstanding--;
+	if (!success) {
+		worker->error = -EIO;
+	}
+
+	if (worker->error != 0 || g_interrupt == true) {
+		dd_worker_check_done(worker);
+		return;
+	}
+
+	write_offset = g_job.output.pos + io->offset - g_job.input.pos;
+	rc = spdk_bdev_write(g_job.output.u.bdev.desc, worker->output_ch, io->buf, write_offset,
+			     io->length, dd_worker_write_done, io);
+	if (rc != 0) {
+		worker->error = rc;
+		dd_worker_check_done(worker);
+		return;
+	}
+
+	worker->outstanding++;
+}
+
+static void
+dd_worker_read(struct dd_io *io)
+{
+	struct dd_worker *worker = io->worker;
+	int rc;
+
+	if (worker->pos >= worker->end || worker->error != 0 || g_interrupt == true) {
+		dd_worker_check_done(worker);
+		return;
+	}
+
+	io->offset = worker->pos;
+	io->length = spdk_min((uint64_t)g_opts.io_unit_size, worker->end - worker->pos);
+
+	rc = spdk_bdev_read(g_job.input.u.bdev.desc, worker->input_ch, io->buf, io->offset,
+			    io->length, dd_worker_read_done, io);
+	if (rc != 0) {
+		worker->error = rc;
+		dd_worker_check_done(worker);
+		return;
+	}
+
+	worker->pos += io->length;
+	worker->outstanding++;
+}
+
+static void
+dd_worker_run(void *ctx)
+{
+	struct dd_worker *worker = ctx;
+	uint32_t i;
+
+	worker->input_ch = spdk_bdev_get_io_channel(g_job.input.u.bdev.desc);
+	worker->output_ch = spdk_bdev_get_io_channel(g_job.output.u.bdev.desc);
+	if (worker->input_ch == NULL || worker->output_ch == NULL) {
+		worker->error = -ENOMEM;
+		worker->done = true;
+		if (worker->input_ch != NULL) {
+			spdk_put_io_channel(worker->input_ch);
+		}
+		if (worker->output_ch != NULL) {
+			spdk_put_io_channel(worker->output_ch);
+		}
+		spdk_thread_send_msg(spdk_thread_get_app_thread(), dd_worker_exited, worker);
+		spdk_thread_exit(worker->thread);
+		return;
+	}
+
+	for (i = 0; i < g_opts.queue_depth && !worker->done; i++) {
+		dd_worker_read(&worker->ios[i]);
+	}
+}
+
+/*
+ * Split the copy into --threads parts of whole I/O units, each one copied by a separate
+ * thread with its own channels and queue depth.  The threads are spread across the cores
+ * of the application.
+ */
+static int
+dd_start_workers(void)
+{
+	struct spdk_cpuset cpumask;
+	struct dd_worker *worker;
+	char name[32];
+	uint64_t units, part;
+	uint32_t i, j, core;
+
+	g_job.workers = calloc(g_opts.num_threads, sizeof(struct dd_worker));
+	if (g_job.workers == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < g_opts.num_threads; i++) {
+		worker = &g_job.workers[i];
+		worker->ios = calloc(g_opts.queue_depth, sizeof(struct dd_io));
+		if (worker->ios == NULL) {
+			return -ENOMEM;
+		}
+
+		for (j = 0; j < g_opts.queue_depth; j++) {
+			worker->ios[j].worker = worker;
+			worker->ios[j].buf = spdk_malloc(g_opts.io_unit_size, 0x1000, NULL,
+							 SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+			if (worker->ios[j].buf == NULL) {
+				SPDK_ERRLOG("%s - try smaller block size value\n", strerror(ENOMEM));
+				return -ENOMEM;
+			}
+		}
+	}
+
+	units = SPDK_CEIL_DIV(g_job.copy_size, g_opts.io_unit_size);
+	part = SPDK_CEIL_DIV(units, g_opts.num_threads) * g_opts.io_unit_size;
+
+	clock_gettime(CLOCK_REALTIME, &g_job.start_time);
+
+	g_job.status_poller = SPDK_POLLER_REGISTER(dd_status_poller, NULL,
+			      STATUS_POLLER_PERIOD_SEC * SPDK_SEC_TO_USEC);
+
+	core = spdk_env_get_first_core();
+	for (i = 0; i < g_opts.num_threads; i++) {
+		worker = &g_job.workers[i];
+		worker->pos = g_job.input.pos + spdk_min(g_job.copy_size, i * part);
+		worker->end = g_job.input.pos + spdk_min(g_job.copy_size, (i + 1) * part);
+
+		spdk_cpuset_zero(&cpumask);
+		spdk_cpuset_set_cpu(&cpumask, core, true);
+		snprintf(name, sizeof(name), "dd_worker_%u", i);
+
+		worker->thread = spdk_thread_create(name, &cpumask);
+		if (worker->thread == NULL) {
+			SPDK_ERRLOG("Could not create thread %s\n", name);
+			g_error = -ENOMEM;
+			break;
+		}
+
+		g_job.active_workers++;
+		spdk_thread_send_msg(worker->thread, dd_worker_run, worker);
+
+		core = spdk_env_get_next_core(core);
+		if (core == UINT32_MAX) {
+			core = spdk_env_get_first_core();
+		}
+	}
+
+	if (g_job.active_workers == 0) {
+		return g_error;
+	}
+
+	/* Let the workers which were already started finish, the error is reported afterwards */
+	g_interrupt = g_error != 0;
+
+	return 0;
+}
+
 static void
 dd_run(void *arg1)
 {
@@ -1155,6 +1624,37 @@ dd_run(void *arg1)
 		return;
 	}
 
+	if (g_opts.manifest != NULL) {
+		rc = dd_load_manifest();
+		if (rc != 0) {
+			dd_exit(rc);
+			return;
+		}
+
+		g_job.accel_ch = spdk_accel_get_io_channel();
+		if (g_job.accel_ch == NULL) {
+			SPDK_ERRLOG("Could not get accel channel: %s\n", strerror(ENOMEM));
+			dd_exit(-ENOMEM);
+			return;
+		}
+	}
+
+	if (g_opts.num_threads > 1) {
+		if (g_opts.io_unit_size % g_job.output.block_size != 0 ||
+		    g_job.copy_size % g_job.output.block_size != 0) {
+			SPDK_ERRLOG("--bs value and copy size must be multiples of output native block size (%d) "
+				    "with --threads\n", g_job.output.block_size);
+			dd_exit(-EINVAL);
+			return;
+		}
+
+		rc = dd_start_workers();
+		if (rc != 0) {
+			dd_exit(rc);
+		}
+		return;
+	}
+
 	g_job.ios = calloc(g_opts.queue_depth, sizeof(struct dd_io));
 	if (g_job.ios == NULL) {
 		SPDK_ERRLOG("%s\n", strerror(ENOMEM));
@@ -1244,6 +1744,9 @@ enum dd_cmdline_opts {
 	DD_OPTION_COUNT,
 	DD_OPTION_AIO,
 	DD_OPTION_SPARSE,
+	DD_OPTION_THREADS,
+	DD_OPTION_MANIFEST,
+	DD_OPTION_SKIP_ZEROES,
 };
 
 static struct option g_cmdline_opts[] = {
@@ -1325,6 +1828,24 @@ static struct option g_cmdline_opts[] = {
 		.flag = NULL,
 		.val = DD_OPTION_SPARSE,
 	},
+	{
+		.name = "threads",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = DD_OPTION_THREADS,
+	},
+	{
+		.name = "manifest",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = DD_OPTION_MANIFEST,
+	},
+	{
+		.name = "skip-zeroes",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = DD_OPTION_SKIP_ZEROES,
+	},
 	{
 		.name = NULL
 	}
@@ -1347,6 +1868,12 @@ usage(void)
 	printf(" --seek Skip this many I/O units at start of output. (default: 0)\n");
 	printf(" --aio Force usage of AIO. (by default io_uring is used if available)\n");
 	printf(" --sparse Enable hole skipping in input target\n");
+	printf(" --skip-zeroes Don't write I/O units containing only zeroes. The output must be zeroed\n"
+	       "               beforehand, e.g. a new file or a thin provisioned bdev.\n");
+	printf(" --threads Number of threads copying separate parts of the input in parallel, each one\n"
+	       "           with its own queue depth. Only for copies between bdevs. (default: 1)\n");
+	printf(" --manifest File with the checksums of the I/O units of the previous copy to the same\n"
+	       "            output. Unchanged I/O units are not written, and the file is updated.\n");
 	printf(" Available iflag and oflag values:\n");
 	printf("  append - append mode\n");
 	printf("  direct - use direct I/O for data\n");
@@ -1402,6 +1929,15 @@ parse_args(int argc, char *argv)
 	case DD_OPTION_SPARSE:
 		g_opts.sparse = true;
 		break;
+	case DD_OPTION_THREADS:
+		g_opts.num_threads = spdk_strtol(optarg, 10);
+		break;
+	case DD_OPTION_MANIFEST:
+		g_opts.manifest = strdup(argv);
+		break;
+	case DD_OPTION_SKIP_ZEROES:
+		g_opts.skip_zeroes = true;
+		break;
 	default:
 		usage();
 		return 1;
@@ -1412,7 +1948,7 @@ parse_args(int argc, char *argv)
 static void
 dd_free(void)
 {
-	uint32_t i;
+	uint32_t i, j;
 
 	free(g_opts.input_file);
 	free(g_opts.output_file);
@@ -1420,6 +1956,9 @@ dd_free(void)
 	free(g_opts.output_bdev);
 	free(g_opts.input_file_flags);
 	free(g_opts.output_file_flags);
+	free(g_opts.manifest);
+	free(g_job.crcs);
+	free(g_job.prev_crcs);
 
 
 	if (g_job.input.type == DD_TARGET_TYPE_FILE || g_job.output.type == DD_TARGET_TYPE_FILE) {
@@ -1443,6 +1982,22 @@ dd_free(void)
 
 		free(g_job.ios);
 	}
+
+	if (g_job.workers) {
+		for (i = 0; i < g_opts.num_threads; i++) {
+			if (g_job.workers[i].ios == NULL) {
+				continue;
+			}
+
+			for (j = 0; j < g_opts.queue_depth; j++) {
+				spdk_free(g_job.workers[i].ios[j].buf);
+			}
+
+			free(g_job.workers[i].ios);
+		}
+
+		free(g_job.workers);
+	}
 }
 
 int
@@ -1511,6 +2066,36 @@ main(int argc, char **argv)
 		goto end;
 	}
 
+	if ((int32_t)g_opts.num_threads <= 0) {
+		SPDK_ERRLOG("Invalid --threads value\n");
+		rc = EINVAL;
+		goto end;
+	}
+
+	if (g_opts.num_threads > 1 && (g_opts.input_bdev == NULL || g_opts.output_bdev == NULL)) {
+		SPDK_ERRLOG("--threads may be used only with --ib and --ob\n");
+		rc = EINVAL;
+		goto end;
+	}
+
+	if (g_opts.num_threads > 1 && g_opts.sparse) {
+		SPDK_ERRLOG("--threads may not be used with --sparse\n");
+		rc = EINVAL;
+		goto end;
+	}
+
+	if (g_opts.skip_zeroes && g_opts.num_threads > 1) {
+		SPDK_ERRLOG("--skip-zeroes may not be used with --threads\n");
+		rc = EINVAL;
+		goto end;
+	}
+
+	if (g_opts.manifest != NULL && (g_opts.sparse || g_opts.skip_zeroes || g_opts.num_threads > 1)) {
+		SPDK_ERRLOG("--manifest may not be used with --sparse, --skip-zeroes or --threads\n");
+		rc = EINVAL;
+		goto end;
+	}
+
 	rc = spdk_app_start(&opts, dd_run, NULL);
 	if (rc) {
 		SPDK_ERRLOG("Error occurred while performing copy\n");
@@ -4,9 +4,12 @@
  */
 
 #include "spdk/stdinc.h"
+#include "spdk/base64.h"
+#include "spdk/histogram_data.h"
 #include "spdk/jsonrpc.h"
 #include "spdk/rpc.h"
 #include "spdk/event.h"
+#include "spdk/string.h"
 #include "spdk/util.h"
 #include "spdk/env.h"
 
@@ -29,6 +32,8 @@
 #define RPC_MAX_THREADS 1024
 #define RPC_MAX_POLLERS 1024
 #define RPC_MAX_CORES 255
+#define RPC_MAX_IOBUF_MODULES 32
+#define RPC_MAX_IOBUF_SIZE_CLASSES 6
 #define MAX_THREAD_NAME 128
 #define MAX_POLLER_NAME 128
 #define MAX_THREADS 4096
@@ -66,20 +71,28 @@
 #define WINDOW_HEADER 12
 #define FROM_HEX 16
 #define THREAD_WIN_WIDTH 69
-#define THREAD_WIN_HEIGHT 9
+#define THREAD_WIN_HEIGHT 11
 #define THREAD_WIN_FIRST_COL 2
 #define CORE_WIN_FIRST_COL 16
 #define CORE_WIN_WIDTH 48
 #define CORE_WIN_HEIGHT 11
-#define POLLER_WIN_HEIGHT 8
+#define POLLER_WIN_HEIGHT 9
 #define POLLER_WIN_WIDTH 64
 #define POLLER_WIN_FIRST_COL 14
 #define FIRST_DATA_ROW 7
 #define HELP_WIN_WIDTH 88
-#define HELP_WIN_HEIGHT 24
+#define HELP_WIN_HEIGHT 25
 #define SCHEDULER_WIN_HEIGHT 7
 #define SCHEDULER_WIN_FIRST_COL 2
 #define MAX_SCHEDULER_PERIOD_STR_LEN 10
+#define IOBUF_WIN_WIDTH 88
+#define IOBUF_WIN_FIRST_COL 2
+#define MAX_IOBUF_MODULE_NAME_LEN 16
+#define MAX_IOBUF_POOL_STR_LEN 8
+#define MAX_IOBUF_COUNT_STR_LEN 11
+#define MAX_IOBUF_WAIT_STR_LEN 9
+#define HISTORY_LEN 52
+#define HISTORY_WIN_FIRST_COL 14
 
 enum tabs {
 	THREADS_TAB,
@@ -107,6 +120,7 @@ enum column_pollers_type {
 	COL_POLLERS_THREAD_NAME,
 	COL_POLLERS_RUN_COUNTER,
 	COL_POLLERS_PERIOD,
+	COL_POLLERS_P99,
 	COL_POLLERS_BUSY_COUNT,
 	COL_POLLERS_NONE = 255,
 };
@@ -138,14 +152,36 @@ struct col_desc {
 	bool disabled;
 };
 
+/* Rolling window of the values measured in the last HISTORY_LEN refresh periods */
+struct history_ring {
+	uint64_t values[HISTORY_LEN];
+	uint32_t next;
+	uint32_t count;
+};
+
 struct run_counter_history {
 	uint64_t poller_id;
 	uint64_t thread_id;
 	uint64_t last_run_counter;
 	uint64_t last_busy_counter;
+	/* Run count in each of the last periods */
+	struct history_ring runs;
 	TAILQ_ENTRY(run_counter_history) link;
 };
 
+struct thread_history {
+	uint64_t thread_id;
+	/* CPU usage (in hundredths of a percent) and core in each of the last periods */
+	struct history_ring usage;
+	struct history_ring core;
+	TAILQ_ENTRY(thread_history) link;
+};
+
+enum export_format {
+	EXPORT_FORMAT_CSV,
+	EXPORT_FORMAT_JSON,
+};
+
 uint8_t g_sleep_time = 1;
 uint16_t g_selected_row;
 uint16_t g_max_selected_row;
@@ -155,6 +191,9 @@ const char *g_tab_title[NUMBER_OF_TABS] = {"[1] THREADS", "[2] POLLERS", "[3] CO
 struct spdk_jsonrpc_client *g_rpc_client;
 static TAILQ_HEAD(, run_counter_history) g_run_counter_history = TAILQ_HEAD_INITIALIZER(
 			g_run_counter_history);
+static TAILQ_HEAD(, thread_history) g_thread_history = TAILQ_HEAD_INITIALIZER(g_thread_history);
+static FILE *g_export_file;
+static enum export_format g_export_format = EXPORT_FORMAT_CSV;
 WINDOW *g_menu_win, *g_tab_win[NUMBER_OF_TABS], *g_tabs[NUMBER_OF_TABS];
 PANEL *g_panels[NUMBER_OF_TABS];
 uint16_t g_max_row, g_max_col;
@@ -182,6 +221,7 @@ static struct col_desc g_col_desc[NUMBER_OF_TABS][TABS_COL_COUNT] = {
 		{.name = "On thread", .max_data_string = MAX_THREAD_NAME_LEN},
 		{.name = "Run count", .max_data_string = MAX_POLLER_RUN_COUNT},
 		{.name = "Period [us]", .max_data_string = MAX_PERIOD_STR_LEN},
+		{.name = "P99 [us]", .max_data_string = MAX_TIME_STR_LEN},
 		{.name = "Status (busy count)", .max_data_string = MAX_POLLER_IND_STR_LEN},
 		{.name = (char *)NULL}
 	},
@@ -220,6 +260,10 @@ struct rpc_poller_info {
 	uint64_t run_count;
 	uint64_t busy_count;
 	uint64_t period_ticks;
+	char *histogram;
+	uint32_t bucket_shift;
+	/* 99th percentile of ticks per run, 0 if poller histograms are disabled */
+	uint64_t p99_ticks;
 	enum spdk_poller_type type;
 	char thread_name[MAX_THREAD_NAME];
 	uint64_t thread_id;
@@ -255,10 +299,32 @@ struct rpc_scheduler {
 	uint64_t scheduler_period;
 };
 
+struct rpc_iobuf_pool_stats {
+	uint32_t bufsize;
+	uint64_t cache;
+	uint64_t main;
+	uint64_t retry;
+	uint64_t remote;
+};
+
+struct rpc_iobuf_module_stats {
+	char *module;
+	struct rpc_iobuf_pool_stats small_pool;
+	struct rpc_iobuf_pool_stats large_pool;
+	struct rpc_iobuf_pool_stats size_classes[RPC_MAX_IOBUF_SIZE_CLASSES];
+	size_t size_classes_count;
+	char *histogram;
+	uint32_t bucket_shift;
+	/* 99th percentile of ticks spent waiting for a buffer, 0 if no request had to wait */
+	uint64_t wait_p99_ticks;
+};
+
 struct rpc_thread_info g_threads_info[RPC_MAX_THREADS];
 struct rpc_poller_info g_pollers_info[RPC_MAX_POLLERS];
 struct rpc_core_info g_cores_info[RPC_MAX_CORES];
 struct rpc_scheduler g_scheduler_info;
+struct rpc_iobuf_module_stats g_iobuf_stats[RPC_MAX_IOBUF_MODULES];
+size_t g_iobuf_modules_count;
 
 static void
 init_str_len(void)
@@ -331,6 +397,8 @@ free_rpc_poller(struct rpc_poller_info *poller)
 	poller->name = NULL;
 	free(poller->state);
 	poller->state = NULL;
+	free(poller->histogram);
+	poller->histogram = NULL;
 }
 
 static void
@@ -358,8 +426,49 @@ static const struct spdk_json_object_decoder rpc_pollers_decoders[] = {
 	{"run_count", offsetof(struct rpc_poller_info, run_count), spdk_json_decode_uint64},
 	{"busy_count", offsetof(struct rpc_poller_info, busy_count), spdk_json_decode_uint64},
 	{"period_ticks", offsetof(struct rpc_poller_info, period_ticks), spdk_json_decode_uint64, true},
+	{"histogram", offsetof(struct rpc_poller_info, histogram), spdk_json_decode_string, true},
+	{"bucket_shift", offsetof(struct rpc_poller_info, bucket_shift), spdk_json_decode_uint32, true},
 };
 
+static void
+get_p99_ticks_cb(void *ctx, uint64_t start, uint64_t end, uint64_t count,
+		 uint64_t total, uint64_t so_far)
+{
+	uint64_t *p99_ticks = ctx;
+
+	if (count != 0 && *p99_ticks == 0 && so_far * 100 >= total * 99) {
+		*p99_ticks = end;
+	}
+}
+
+static uint64_t
+get_p99_ticks(const char *encoded_histogram, uint32_t bucket_shift)
+{
+	struct spdk_histogram_data *histogram;
+	uint64_t p99_ticks = 0;
+	size_t len, expected_len;
+
+	if (encoded_histogram == NULL || bucket_shift == 0 || bucket_shift >= 64) {
+		return 0;
+	}
+
+	histogram = spdk_histogram_data_alloc_sized(bucket_shift);
+	if (histogram == NULL) {
+		return 0;
+	}
+
+	/* Check the decoded length first, so that the buckets can't be overrun. */
+	expected_len = SPDK_HISTOGRAM_NUM_BUCKETS(histogram) * sizeof(uint64_t);
+	if (spdk_base64_decode(NULL, &len, encoded_histogram) == 0 && len == expected_len &&
+	    spdk_base64_decode(histogram->bucket, &len, encoded_histogram) == 0) {
+		spdk_histogram_data_iterate(histogram, get_p99_ticks_cb, &p99_ticks);
+	}
+
+	spdk_histogram_data_free(histogram);
+
+	return p99_ticks;
+}
+
 static int
 rpc_decode_pollers_array(struct spdk_json_val *poller, struct rpc_poller_info *out,
 			 uint64_t *poller_count,
@@ -380,6 +489,11 @@ rpc_decode_pollers_array(struct spdk_json_val *poller, struct rpc_poller_info *o
 			return rc;
 		}
 
+		out[*poller_count].p99_ticks = get_p99_ticks(out[*poller_count].histogram,
+					       out[*poller_count].bucket_shift);
+		free(out[*poller_count].histogram);
+		out[*poller_count].histogram = NULL;
+
 		(*poller_count)++;
 		if (*poller_count == RPC_MAX_POLLERS) {
 			return -1;
@@ -551,6 +665,76 @@ static const struct spdk_json_object_decoder rpc_scheduler_decoders[] = {
 	{"scheduler_period", offsetof(struct rpc_scheduler, scheduler_period), spdk_json_decode_uint64},
 };
 
+static void
+free_rpc_iobuf_stats(struct rpc_iobuf_module_stats *stats, size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		free(stats[i].module);
+		stats[i].module = NULL;
+		free(stats[i].histogram);
+		stats[i].histogram = NULL;
+	}
+}
+
+static const struct spdk_json_object_decoder rpc_iobuf_pool_stats_decoders[] = {
+	{"bufsize", offsetof(struct rpc_iobuf_pool_stats, bufsize), spdk_json_decode_uint32, true},
+	{"cache", offsetof(struct rpc_iobuf_pool_stats, cache), spdk_json_decode_uint64},
+	{"main", offsetof(struct rpc_iobuf_pool_stats, main), spdk_json_decode_uint64},
+	{"retry", offsetof(struct rpc_iobuf_pool_stats, retry), spdk_json_decode_uint64},
+	{"remote", offsetof(struct rpc_iobuf_pool_stats, remote), spdk_json_decode_uint64, true},
+};
+
+static int
+rpc_decode_iobuf_pool_stats(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object_relaxed(val, rpc_iobuf_pool_stats_decoders,
+					       SPDK_COUNTOF(rpc_iobuf_pool_stats_decoders), out);
+}
+
+static int
+rpc_decode_iobuf_size_classes(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_iobuf_module_stats *stats = SPDK_CONTAINEROF(out, struct rpc_iobuf_module_stats,
+					       size_classes);
+
+	return spdk_json_decode_array(val, rpc_decode_iobuf_pool_stats, stats->size_classes,
+				      RPC_MAX_IOBUF_SIZE_CLASSES, &stats->size_classes_count,
+				      sizeof(stats->size_classes[0]));
+}
+
+static const struct spdk_json_object_decoder rpc_iobuf_wait_histogram_decoders[] = {
+	{"histogram", offsetof(struct rpc_iobuf_module_stats, histogram), spdk_json_decode_string},
+	{"bucket_shift", offsetof(struct rpc_iobuf_module_stats, bucket_shift), spdk_json_decode_uint32},
+};
+
+static int
+rpc_decode_iobuf_wait_histogram(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_iobuf_module_stats *stats = SPDK_CONTAINEROF(out, struct rpc_iobuf_module_stats,
+					       histogram);
+
+	return spdk_json_decode_object_relaxed(val, rpc_iobuf_wait_histogram_decoders,
+					       SPDK_COUNTOF(rpc_iobuf_wait_histogram_decoders),
+					       stats);
+}
+
+static const struct spdk_json_object_decoder rpc_iobuf_module_stats_decoders[] = {
+	{"module", offsetof(struct rpc_iobuf_module_stats, module), spdk_json_decode_string},
+	{"small_pool", offsetof(struct rpc_iobuf_module_stats, small_pool), rpc_decode_iobuf_pool_stats},
+	{"large_pool", offsetof(struct rpc_iobuf_module_stats, large_pool), rpc_decode_iobuf_pool_stats},
+	{"size_classes", offsetof(struct rpc_iobuf_module_stats, size_classes), rpc_decode_iobuf_size_classes, true},
+	{"wait_histogram", offsetof(struct rpc_iobuf_module_stats, histogram), rpc_decode_iobuf_wait_histogram, true},
+};
+
+static int
+rpc_decode_iobuf_module_stats(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object_relaxed(val, rpc_iobuf_module_stats_decoders,
+					       SPDK_COUNTOF(rpc_iobuf_module_stats_decoders), out);
+}
+
 static int
 rpc_send_req(char *rpc_name, struct spdk_jsonrpc_client_response **resp)
 {
@@ -682,6 +866,58 @@ sort_threads(const void *p1, const void *p2)
 	return res;
 }
 
+static void
+history_ring_add(struct history_ring *ring, uint64_t value)
+{
+	ring->values[ring->next] = value;
+	ring->next = (ring->next + 1) % HISTORY_LEN;
+	ring->count = spdk_min(ring->count + 1, HISTORY_LEN);
+}
+
+/* Get i-th value of the ring, starting with the oldest one */
+static uint64_t
+history_ring_get(const struct history_ring *ring, uint32_t i)
+{
+	assert(i < ring->count);
+
+	return ring->values[(ring->next + HISTORY_LEN - ring->count + i) % HISTORY_LEN];
+}
+
+static struct thread_history *
+get_thread_history(uint64_t thread_id)
+{
+	struct thread_history *history;
+
+	TAILQ_FOREACH(history, &g_thread_history, link) {
+		if (history->thread_id == thread_id) {
+			return history;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+store_thread_history(struct rpc_thread_info *thread_info)
+{
+	struct thread_history *history;
+
+	history = get_thread_history(thread_info->id);
+	if (history == NULL) {
+		history = calloc(1, sizeof(*history));
+		if (history == NULL) {
+			fprintf(stderr, "Unable to allocate a history object in store_thread_history.\n");
+			return;
+		}
+		history->thread_id = thread_info->id;
+		TAILQ_INSERT_TAIL(&g_thread_history, history, link);
+	}
+
+	history_ring_add(&history->usage, get_cpu_usage(thread_info->busy - thread_info->last_busy,
+			 thread_info->idle - thread_info->last_idle));
+	history_ring_add(&history->core, (uint64_t)thread_info->core_num);
+}
+
 static void
 store_last_counters(uint64_t poller_id, uint64_t thread_id, uint64_t last_run_counter,
 		    uint64_t last_busy_counter)
@@ -690,6 +926,7 @@ store_last_counters(uint64_t poller_id, uint64_t thread_id, uint64_t last_run_co
 
 	TAILQ_FOREACH(history, &g_run_counter_history, link) {
 		if ((history->poller_id == poller_id) && (history->thread_id == thread_id)) {
+			history_ring_add(&history->runs, last_run_counter - history->last_run_counter);
 			history->last_run_counter = last_run_counter;
 			history->last_busy_counter = last_busy_counter;
 			return;
@@ -775,6 +1012,13 @@ get_thread_data(void)
 		}
 	}
 
+	for (i = 0; i < g_last_threads_count; i++) {
+		/* The first sample only provides a reference for the next ones */
+		if (g_threads_info[i].last_busy + g_threads_info[i].last_idle != 0) {
+			store_thread_history(&g_threads_info[i]);
+		}
+	}
+
 	qsort(g_threads_info, g_last_threads_count, sizeof(struct rpc_thread_info), sort_threads);
 
 	pthread_mutex_unlock(&g_thread_lock);
@@ -840,6 +1084,10 @@ subsort_pollers(enum column_pollers_type sort_column, const void *p1, const void
 		count1 = poller1->period_ticks;
 		count2 = poller2->period_ticks;
 		break;
+	case COL_POLLERS_P99:
+		count1 = poller1->p99_ticks;
+		count2 = poller2->p99_ticks;
+		break;
 	case COL_POLLERS_BUSY_COUNT:
 		count1 = poller1->busy_count;
 		count2 = poller2->busy_count;
@@ -1105,6 +1353,53 @@ get_scheduler_data(void)
 	return rc;
 }
 
+static int
+get_iobuf_data(void)
+{
+	struct spdk_jsonrpc_client_response *json_resp = NULL;
+	struct rpc_iobuf_module_stats *stats;
+	size_t count = 0, i;
+	int rc = 0;
+
+	rc = rpc_send_req("iobuf_get_stats", &json_resp);
+	if (rc) {
+		return rc;
+	}
+
+	stats = calloc(RPC_MAX_IOBUF_MODULES, sizeof(*stats));
+	if (stats == NULL) {
+		rc = -ENOMEM;
+		goto end;
+	}
+
+	if (spdk_json_decode_array(json_resp->result, rpc_decode_iobuf_module_stats, stats,
+				   RPC_MAX_IOBUF_MODULES, &count, sizeof(*stats))) {
+		/* Decoding may have failed half-way through the array */
+		free_rpc_iobuf_stats(stats, RPC_MAX_IOBUF_MODULES);
+		rc = -EINVAL;
+		goto end;
+	}
+
+	for (i = 0; i < count; i++) {
+		stats[i].wait_p99_ticks = get_p99_ticks(stats[i].histogram, stats[i].bucket_shift);
+		free(stats[i].histogram);
+		stats[i].histogram = NULL;
+	}
+
+	pthread_mutex_lock(&g_thread_lock);
+
+	free_rpc_iobuf_stats(g_iobuf_stats, g_iobuf_modules_count);
+	memcpy(g_iobuf_stats, stats, count * sizeof(*stats));
+	g_iobuf_modules_count = count;
+
+	pthread_mutex_unlock(&g_thread_lock);
+
+end:
+	free(stats);
+	spdk_jsonrpc_client_free_response(json_resp);
+	return rc;
+}
+
 enum str_alignment {
 	ALIGN_LEFT,
 	ALIGN_RIGHT,
@@ -1469,7 +1764,7 @@ draw_poller_tab_row(uint64_t current_row, uint8_t item_index)
 	uint64_t last_run_counter, last_busy_counter;
 	uint16_t col = TABS_DATA_START_COL;
 	char run_count[MAX_POLLER_RUN_COUNT], period_ticks[MAX_PERIOD_STR_LEN],
-	     status[MAX_POLLER_IND_STR_LEN];
+	     p99[MAX_TIME_STR_LEN], status[MAX_POLLER_IND_STR_LEN];
 
 	last_busy_counter = get_last_busy_counter(g_pollers_info[current_row].id,
 			    g_pollers_info[current_row].thread_id);
@@ -1514,7 +1809,17 @@ draw_poller_tab_row(uint64_t current_row, uint8_t item_index)
 			print_max_len(g_tabs[POLLERS_TAB], TABS_DATA_START_ROW + item_index, col,
 				      col_desc[COL_POLLERS_PERIOD].max_data_string, ALIGN_RIGHT, period_ticks);
 		}
-		col += col_desc[COL_POLLERS_PERIOD].max_data_string + 7;
+		col += col_desc[COL_POLLERS_PERIOD].max_data_string + 2;
+	}
+
+	if (!col_desc[COL_POLLERS_P99].disabled) {
+		if (g_pollers_info[current_row].p99_ticks != 0) {
+			snprintf(p99, MAX_TIME_STR_LEN, "%.2f", (double)g_pollers_info[current_row].p99_ticks *
+				 SPDK_SEC_TO_USEC / g_tick_rate);
+			print_max_len(g_tabs[POLLERS_TAB], TABS_DATA_START_ROW + item_index, col,
+				      col_desc[COL_POLLERS_P99].max_data_string, ALIGN_RIGHT, p99);
+		}
+		col += col_desc[COL_POLLERS_P99].max_data_string + 6;
 	}
 
 	if (!col_desc[COL_POLLERS_BUSY_COUNT].disabled) {
@@ -2284,6 +2589,72 @@ free_poller_history(void)
 	}
 }
 
+static void
+free_thread_history(void)
+{
+	struct thread_history *history, *tmp;
+
+	TAILQ_FOREACH_SAFE(history, &g_thread_history, link, tmp) {
+		TAILQ_REMOVE(&g_thread_history, history, link);
+		free(history);
+	}
+}
+
+static const struct history_ring *
+get_poller_run_history(uint64_t poller_id, uint64_t thread_id)
+{
+	struct run_counter_history *history;
+
+	TAILQ_FOREACH(history, &g_run_counter_history, link) {
+		if ((history->poller_id == poller_id) && (history->thread_id == thread_id)) {
+			return &history->runs;
+		}
+	}
+
+	return NULL;
+}
+
+/* Draw the values of a ring as a single line of characters of increasing height, scaled to
+ * max_value.  The newest value is on the right. */
+static void
+draw_sparkline(WINDOW *win, int row, int col, const struct history_ring *ring, uint64_t max_value)
+{
+	static const char levels[] = " _.-=+*#%@";
+	uint64_t value;
+	uint32_t i;
+
+	mvwhline(win, row, col, ' ', HISTORY_LEN);
+	if (ring == NULL) {
+		return;
+	}
+
+	for (i = 0; i < ring->count; i++) {
+		value = spdk_min(history_ring_get(ring, i), max_value);
+		if (max_value != 0 && value != 0) {
+			value = 1 + value * (sizeof(levels) - 3) / max_value;
+		}
+		mvwaddch(win, row, col + HISTORY_LEN - ring->count + i, levels[value]);
+	}
+}
+
+/* Mark the periods in which a thread has been moved to a different core */
+static void
+draw_core_moves(WINDOW *win, int row, int col, const struct history_ring *ring)
+{
+	uint32_t i;
+
+	mvwhline(win, row, col, ' ', HISTORY_LEN);
+	if (ring == NULL) {
+		return;
+	}
+
+	for (i = 1; i < ring->count; i++) {
+		if (history_ring_get(ring, i) != history_ring_get(ring, i - 1)) {
+			mvwaddch(win, row, col + HISTORY_LEN - ring->count + i, '^');
+		}
+	}
+}
+
 static uint64_t
 get_position_for_window(uint64_t window_size, uint64_t max_size)
 {
@@ -2309,6 +2680,7 @@ print_bottom_message(char *msg)
 static void
 draw_thread_win_content(WINDOW *thread_win, struct rpc_thread_info *thread_info)
 {
+	struct thread_history *history;
 	uint64_t current_row, i, time;
 	char idle_time[MAX_TIME_STR_LEN], busy_time[MAX_TIME_STR_LEN];
 
@@ -2345,14 +2717,22 @@ draw_thread_win_content(WINDOW *thread_win, struct rpc_thread_info *thread_info)
 	mvwprintw(thread_win, 4, THREAD_WIN_FIRST_COL + 59, "%" PRIu64,
 		  thread_info->paused_pollers_count);
 
-	mvwhline(thread_win, 5, 1, ACS_HLINE, THREAD_WIN_WIDTH - 2);
+	history = get_thread_history(thread_info->id);
+	print_left(thread_win, 5, THREAD_WIN_FIRST_COL, THREAD_WIN_WIDTH, "CPU % history:", COLOR_PAIR(5));
+	draw_sparkline(thread_win, 5, THREAD_WIN_FIRST_COL + HISTORY_WIN_FIRST_COL,
+		       history != NULL ? &history->usage : NULL, 10000);
+	print_left(thread_win, 6, THREAD_WIN_FIRST_COL, THREAD_WIN_WIDTH, "Core moves:", COLOR_PAIR(5));
+	draw_core_moves(thread_win, 6, THREAD_WIN_FIRST_COL + HISTORY_WIN_FIRST_COL,
+			history != NULL ? &history->core : NULL);
 
-	print_in_middle(thread_win, 6, 0, THREAD_WIN_WIDTH,
+	mvwhline(thread_win, 7, 1, ACS_HLINE, THREAD_WIN_WIDTH - 2);
+
+	print_in_middle(thread_win, 8, 0, THREAD_WIN_WIDTH,
 			"Pollers                          Type    Total run count   Period", COLOR_PAIR(5));
 
-	mvwhline(thread_win, 7, 1, ACS_HLINE, THREAD_WIN_WIDTH - 2);
+	mvwhline(thread_win, 9, 1, ACS_HLINE, THREAD_WIN_WIDTH - 2);
 
-	current_row = 8;
+	current_row = 10;
 
 	for (i = 0; i < g_last_pollers_count; i++) {
 		if (g_pollers_info[i].thread_id == thread_info->id) {
@@ -2718,8 +3098,10 @@ show_core(uint8_t current_page, uint8_t active_tab)
 static void
 draw_poller_win_content(WINDOW *poller_win, struct rpc_poller_info *poller_info)
 {
-	uint64_t last_run_counter, last_busy_counter, busy_count;
+	const struct history_ring *runs;
+	uint64_t last_run_counter, last_busy_counter, busy_count, max_runs = 0;
 	char poller_period[MAX_TIME_STR_LEN];
+	uint32_t i;
 
 	box(poller_win, 0, 0);
 
@@ -2767,6 +3149,13 @@ draw_poller_win_content(WINDOW *poller_win, struct rpc_poller_info *poller_info)
 		print_in_middle(poller_win, 6, 1, POLLER_WIN_WIDTH + 6, "Idle", COLOR_PAIR(7));
 	}
 
+	runs = get_poller_run_history(poller_info->id, poller_info->thread_id);
+	for (i = 0; runs != NULL && i < runs->count; i++) {
+		max_runs = spdk_max(max_runs, history_ring_get(runs, i));
+	}
+	print_left(poller_win, 7, 2, POLLER_WIN_WIDTH, "Runs:", COLOR_PAIR(5));
+	draw_sparkline(poller_win, 7, 2 + 8, runs, max_runs);
+
 	wnoutrefresh(poller_win);
 }
 
@@ -2958,6 +3347,226 @@ show_scheduler(uint8_t active_tab, uint8_t current_page)
 	delwin(scheduler_win);
 }
 
+static void
+draw_iobuf_pool_row(WINDOW *iobuf_win, int row, const char *module, const char *pool,
+		    struct rpc_iobuf_pool_stats *stats, uint64_t wait_p99_ticks)
+{
+	char wait[MAX_IOBUF_WAIT_STR_LEN + 1] = "";
+	uint64_t wait_us;
+
+	if (wait_p99_ticks != 0) {
+		wait_us = wait_p99_ticks * SPDK_SEC_TO_USEC / g_tick_rate;
+		snprintf(wait, sizeof(wait), "%" PRIu64, wait_us);
+	}
+
+	mvwprintw(iobuf_win, row, IOBUF_WIN_FIRST_COL,
+		  "%-*.*s %-*s %*" PRIu64 " %*" PRIu64 " %*" PRIu64 " %*" PRIu64 " %*s",
+		  MAX_IOBUF_MODULE_NAME_LEN, MAX_IOBUF_MODULE_NAME_LEN, module,
+		  MAX_IOBUF_POOL_STR_LEN, pool,
+		  MAX_IOBUF_COUNT_STR_LEN, stats->cache, MAX_IOBUF_COUNT_STR_LEN, stats->main,
+		  MAX_IOBUF_COUNT_STR_LEN, stats->retry, MAX_IOBUF_COUNT_STR_LEN, stats->remote,
+		  MAX_IOBUF_WAIT_STR_LEN, wait);
+}
+
+static void
+draw_iobuf_popup(WINDOW *iobuf_win, int iobuf_win_height, uint8_t active_tab,
+		 uint8_t current_page)
+{
+	struct rpc_iobuf_module_stats *stats;
+	char pool[MAX_IOBUF_POOL_STR_LEN + 1];
+	int row = 3;
+	size_t i, j;
+
+	box(iobuf_win, 0, 0);
+
+	wattron(iobuf_win, COLOR_PAIR(5));
+	mvwprintw(iobuf_win, 1, IOBUF_WIN_FIRST_COL, "%-*s %-*s %*s %*s %*s %*s %*s",
+		  MAX_IOBUF_MODULE_NAME_LEN, "Module", MAX_IOBUF_POOL_STR_LEN, "Pool",
+		  MAX_IOBUF_COUNT_STR_LEN, "Cache", MAX_IOBUF_COUNT_STR_LEN, "Main",
+		  MAX_IOBUF_COUNT_STR_LEN, "Retry", MAX_IOBUF_COUNT_STR_LEN, "Remote",
+		  MAX_IOBUF_WAIT_STR_LEN, "P99 [us]");
+	wattroff(iobuf_win, COLOR_PAIR(5));
+
+	mvwhline(iobuf_win, 2, 1, ACS_HLINE, IOBUF_WIN_WIDTH - 2);
+	mvwaddch(iobuf_win, 2, IOBUF_WIN_WIDTH, ACS_RTEE);
+
+	/* The wait time percentile covers all pools of a module, so it's shown on its first row */
+	for (i = 0; i < g_iobuf_modules_count && row < iobuf_win_height - 1; i++) {
+		stats = &g_iobuf_stats[i];
+
+		draw_iobuf_pool_row(iobuf_win, row++, stats->module, "small", &stats->small_pool,
+				    stats->wait_p99_ticks);
+		for (j = 0; j < stats->size_classes_count && row < iobuf_win_height - 1; j++) {
+			snprintf(pool, sizeof(pool), "%" PRIu32, stats->size_classes[j].bufsize);
+			draw_iobuf_pool_row(iobuf_win, row++, "", pool, &stats->size_classes[j], 0);
+		}
+		if (row < iobuf_win_height - 1) {
+			draw_iobuf_pool_row(iobuf_win, row++, "", "large", &stats->large_pool, 0);
+		}
+	}
+
+	refresh_tab(active_tab, current_page);
+	wnoutrefresh(iobuf_win);
+	refresh();
+}
+
+static void
+show_iobuf(uint8_t active_tab, uint8_t current_page)
+{
+	PANEL *iobuf_panel;
+	WINDOW *iobuf_win;
+	int iobuf_win_height;
+	bool stop_loop = false;
+	size_t i;
+	int c;
+
+	pthread_mutex_lock(&g_thread_lock);
+
+	/* Header, separator, borders and a row per pool of each module */
+	iobuf_win_height = 4;
+	for (i = 0; i < g_iobuf_modules_count; i++) {
+		iobuf_win_height += 2 + g_iobuf_stats[i].size_classes_count;
+	}
+	iobuf_win_height = spdk_min(iobuf_win_height, g_max_row);
+
+	iobuf_win = newwin(iobuf_win_height, IOBUF_WIN_WIDTH,
+			   get_position_for_window(iobuf_win_height, g_max_row),
+			   get_position_for_window(IOBUF_WIN_WIDTH, g_max_col));
+
+	keypad(iobuf_win, TRUE);
+	iobuf_panel = new_panel(iobuf_win);
+
+	top_panel(iobuf_panel);
+	update_panels();
+	doupdate();
+
+	draw_iobuf_popup(iobuf_win, iobuf_win_height, active_tab, current_page);
+	pthread_mutex_unlock(&g_thread_lock);
+
+	while (!stop_loop) {
+		c = wgetch(iobuf_win);
+
+		switch (c) {
+		case 27: /* ESC */
+			stop_loop = true;
+			break;
+		default:
+			break;
+		}
+	}
+
+	del_panel(iobuf_panel);
+	delwin(iobuf_win);
+}
+
+static int
+export_write_json(void *cb_ctx, const void *data, size_t size)
+{
+	return fwrite(data, 1, size, g_export_file) == size ? 0 : -1;
+}
+
+static void
+export_json(uint64_t timestamp)
+{
+	struct spdk_json_write_ctx *w;
+	struct rpc_thread_info *thread;
+	struct rpc_poller_info *poller;
+	struct thread_history *history;
+	uint64_t i;
+
+	w = spdk_json_write_begin(export_write_json, NULL, 0);
+	if (w == NULL) {
+		return;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "timestamp", timestamp);
+	spdk_json_write_named_uint64(w, "tick_rate", g_tick_rate);
+
+	spdk_json_write_named_array_begin(w, "threads");
+	for (i = 0; i < g_last_threads_count; i++) {
+		thread = &g_threads_info[i];
+		history = get_thread_history(thread->id);
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "name", thread->name);
+		spdk_json_write_named_uint64(w, "id", thread->id);
+		spdk_json_write_named_int32(w, "core", thread->core_num);
+		spdk_json_write_named_uint64(w, "busy", thread->busy - thread->last_busy);
+		spdk_json_write_named_uint64(w, "idle", thread->idle - thread->last_idle);
+		if (history != NULL && history->usage.count > 0) {
+			spdk_json_write_named_uint64(w, "cpu_usage",
+						     history_ring_get(&history->usage, history->usage.count - 1));
+		}
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_named_array_begin(w, "pollers");
+	for (i = 0; i < g_last_pollers_count; i++) {
+		poller = &g_pollers_info[i];
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "name", poller->name);
+		spdk_json_write_named_uint64(w, "id", poller->id);
+		spdk_json_write_named_uint64(w, "thread_id", poller->thread_id);
+		spdk_json_write_named_uint64(w, "run_count",
+					     poller->run_count - get_last_run_counter(poller->id, poller->thread_id));
+		spdk_json_write_named_uint64(w, "busy_count",
+					     poller->busy_count - get_last_busy_counter(poller->id, poller->thread_id));
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_object_end(w);
+	spdk_json_write_end(w);
+	fputc('\n', g_export_file);
+}
+
+static void
+export_csv(uint64_t timestamp)
+{
+	struct rpc_thread_info *thread;
+	struct rpc_poller_info *poller;
+	uint64_t i;
+
+	for (i = 0; i < g_last_threads_count; i++) {
+		thread = &g_threads_info[i];
+		fprintf(g_export_file, "%" PRIu64 ",thread,\"%s\",%" PRIu64 ",%d,%" PRIu64 ",%" PRIu64 "\n",
+			timestamp, thread->name, thread->id, thread->core_num,
+			thread->busy - thread->last_busy, thread->idle - thread->last_idle);
+	}
+
+	for (i = 0; i < g_last_pollers_count; i++) {
+		poller = &g_pollers_info[i];
+		fprintf(g_export_file, "%" PRIu64 ",poller,\"%s\",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+			"\n", timestamp, poller->name, poller->id, poller->thread_id,
+			poller->run_count - get_last_run_counter(poller->id, poller->thread_id),
+			poller->busy_count - get_last_busy_counter(poller->id, poller->thread_id));
+	}
+}
+
+/* Append the data gathered in the last refresh period to the export file */
+static void
+export_data(void)
+{
+	struct timespec now;
+	uint64_t timestamp;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	timestamp = now.tv_sec * SPDK_SEC_TO_USEC + now.tv_nsec / (SPDK_SEC_TO_NSEC / SPDK_SEC_TO_USEC);
+
+	pthread_mutex_lock(&g_thread_lock);
+	if (g_export_format == EXPORT_FORMAT_JSON) {
+		export_json(timestamp);
+	} else {
+		export_csv(timestamp);
+	}
+	pthread_mutex_unlock(&g_thread_lock);
+
+	fflush(g_export_file);
+}
+
 static void *
 data_thread_routine(void *arg)
 {
@@ -2998,6 +3607,14 @@ data_thread_routine(void *arg)
 		if (rc) {
 			print_bottom_message("ERROR occurred while getting scheduler data");
 		}
+		rc = get_iobuf_data();
+		if (rc) {
+			print_bottom_message("ERROR occurred while getting iobuf data");
+		}
+
+		if (g_export_file != NULL) {
+			export_data();
+		}
 
 		usleep(refresh_rate);
 	}
@@ -3067,6 +3684,8 @@ help_window_display(void)
 		   "application or last refresh", COLOR_PAIR(10));
 	print_left(help_win, ++row, col,  HELP_WIN_WIDTH,
 		   "[g] Scheduler pop-up - display current scheduler information", COLOR_PAIR(10));
+	print_left(help_win, ++row, col,  HELP_WIN_WIDTH,
+		   "[i] iobuf pop-up	- display iobuf statistics of each module", COLOR_PAIR(10));
 	print_left(help_win, ++row, col,  HELP_WIN_WIDTH, "[h] Help		- show this help window",
 		   COLOR_PAIR(10));
 
@@ -3207,6 +3826,9 @@ show_stats(pthread_t *data_thread)
 		case 'g':
 			show_scheduler(active_tab, current_page);
 			break;
+		case 'i':
+			show_iobuf(active_tab, current_page);
+			break;
 		case KEY_NPAGE: /* PgDown */
 			if (current_page + 1 < max_pages) {
 				current_page++;
@@ -3272,6 +3894,7 @@ show_stats(pthread_t *data_thread)
 	pthread_join(*data_thread, NULL);
 
 	free_poller_history();
+	free_thread_history();
 
 	/* Free memory holding current data states before quitting application */
 	for (i = 0; i < g_last_pollers_count; i++) {
@@ -3282,6 +3905,7 @@ show_stats(pthread_t *data_thread)
 	}
 	free_rpc_core_info(g_cores_info, g_last_cores_count);
 	free_rpc_scheduler(&g_scheduler_info);
+	free_rpc_iobuf_stats(g_iobuf_stats, g_iobuf_modules_count);
 }
 
 static void
@@ -3323,6 +3947,9 @@ finish(int sig)
 	/* End ncurses mode */
 	endwin();
 	spdk_jsonrpc_client_close(g_rpc_client);
+	if (g_export_file != NULL) {
+		fclose(g_export_file);
+	}
 	exit(0);
 }
 
@@ -3365,6 +3992,8 @@ usage(const char *program_name)
 	printf("\n");
 	printf("options:\n");
 	printf(" -r <path>  RPC connect address (default: /var/tmp/spdk.sock)\n");
+	printf(" -o <path>  export the data gathered in each refresh period to a file\n");
+	printf(" -f <fmt>   format of the exported data: csv (default) or json\n");
 	printf(" -h         show this usage\n");
 }
 
@@ -3469,20 +4098,46 @@ int
 main(int argc, char **argv)
 {
 	int op, rc;
-	char *socket = SPDK_DEFAULT_RPC_ADDR;
+	char *socket = SPDK_DEFAULT_RPC_ADDR, *export_path = NULL;
 	pthread_t data_thread;
 
-	while ((op = getopt(argc, argv, "r:h")) != -1) {
+	while ((op = getopt(argc, argv, "f:o:r:h")) != -1) {
 		switch (op) {
 		case 'r':
 			socket = optarg;
 			break;
+		case 'o':
+			export_path = optarg;
+			break;
+		case 'f':
+			if (strcmp(optarg, "csv") == 0) {
+				g_export_format = EXPORT_FORMAT_CSV;
+			} else if (strcmp(optarg, "json") == 0) {
+				g_export_format = EXPORT_FORMAT_JSON;
+			} else {
+				fprintf(stderr, "Unsupported export format: %s\n", optarg);
+				usage(argv[0]);
+				return 1;
+			}
+			break;
 		default:
 			usage(argv[0]);
 			return op == 'h' ? 0 : 1;
 		}
 	}
 
+	if (export_path != NULL) {
+		g_export_file = fopen(export_path, "a");
+		if (g_export_file == NULL) {
+			fprintf(stderr, "Could not open %s: %s\n", export_path, spdk_strerror(errno));
+			return 1;
+		}
+		if (g_export_format == EXPORT_FORMAT_CSV && ftell(g_export_file) == 0) {
+			fprintf(g_export_file, "timestamp,type,name,id,core_or_thread_id,"
+				"busy_ticks_or_run_count,idle_ticks_or_busy_count\n");
+		}
+	}
+
 	g_rpc_client = spdk_jsonrpc_client_connect(socket, socket[0] == '/' ? AF_UNIX : AF_INET);
 	if (!g_rpc_client) {
 		fprintf(stderr, "spdk_jsonrpc_client_connect() failed: %d\n", errno);
@@ -5,12 +5,16 @@
 
 #include "spdk/stdinc.h"
 #include "spdk/env.h"
+#include "spdk/histogram_data.h"
 #include "spdk/json.h"
 #include "spdk/likely.h"
 #include "spdk/string.h"
 #include "spdk/util.h"
 
 #include <map>
+#include <queue>
+#include <utility>
+#include <vector>
 
 extern "C" {
 #include "spdk/trace_parser.h"
@@ -21,6 +25,8 @@ static struct spdk_trace_parser *g_parser;
 static const struct spdk_trace_flags *g_flags;
 static struct spdk_json_write_ctx *g_json;
 static bool g_print_tsc = false;
+static bool g_print_latency = false;
+static size_t g_num_slowest = 10;
 
 /* This is a bit ugly, but we don't want to include env_dpdk in the app, while spdk_util, which we
  * do need, uses some of the functions implemented there.  We're not actually using the functions
@@ -318,6 +324,324 @@ print_json(void *cb_ctx, const void *data, size_t size)
 	return 0;
 }
 
+/*
+ * Latency analysis.  Entries describing the same request are grouped into spans: an object's span
+ * starts with the tracepoint creating it and ends with the last tracepoint referring to it.  If a
+ * tracepoint is related to another object (e.g. an NVMe request submitted for a bdev_io), the
+ * span of its object is attached to the span of the related one, so that a single span covers
+ * all the layers a request went through.  The time between each pair of consecutive tracepoints
+ * of a span is tallied as a stage, and the spans that took the longest are kept to be displayed
+ * along with their stages.
+ */
+struct span_event {
+	span_event(uint16_t _tpoint_id, uint64_t _tsc) : tpoint_id(_tpoint_id), tsc(_tsc) {}
+	uint16_t	tpoint_id;
+	uint64_t	tsc;
+};
+
+typedef std::pair<uint8_t, uint64_t> span_key;
+
+struct span {
+	uint16_t		lcore;
+	span_key		root;
+	std::vector<span_event>	events;
+};
+
+struct finished_span {
+	finished_span(uint64_t _duration, span_key _key, uint16_t _lcore, std::vector<span_event> _events) :
+		duration(_duration), key(_key), lcore(_lcore), events(_events) {}
+	uint64_t		duration;
+	span_key		key;
+	uint16_t		lcore;
+	std::vector<span_event>	events;
+};
+
+class compare_finished_span
+{
+public:
+	bool operator()(const finished_span &first, const finished_span &second) const
+	{
+		return first.duration > second.duration;
+	}
+};
+
+struct latency_stats {
+	latency_stats() : histogram(spdk_histogram_data_alloc()), count(0), sum(0), max(0)
+	{
+		if (histogram == NULL) {
+			throw std::bad_alloc();
+		}
+	}
+	~latency_stats()
+	{
+		spdk_histogram_data_free(histogram);
+	}
+	latency_stats(const latency_stats &) = delete;
+	latency_stats &operator=(const latency_stats &) = delete;
+
+	void tally(uint64_t ticks)
+	{
+		spdk_histogram_data_tally(histogram, ticks);
+		count++;
+		sum += ticks;
+		max = spdk_max(max, ticks);
+	}
+
+	spdk_histogram_data	*histogram;
+	uint64_t		count;
+	uint64_t		sum;
+	uint64_t		max;
+};
+
+/* Stages are identified by the object type of the span and the two tracepoints delimiting
+ * them.  The whole span uses SPDK_TRACE_MAX_TPOINT_ID for both of them. */
+typedef std::pair<uint8_t, std::pair<uint16_t, uint16_t>> stage_key;
+
+static std::map<span_key, span> g_spans;
+/* Index of the span of a given object ID, used to find the spans that are done */
+static std::map<std::pair<uint8_t, uint64_t>, uint64_t> g_span_ids;
+static std::map<stage_key, latency_stats> g_stages;
+static std::priority_queue<finished_span, std::vector<finished_span>, compare_finished_span>
+g_slowest;
+
+static void
+finish_span(std::map<span_key, span>::iterator it)
+{
+	span *s = &it->second;
+	uint64_t duration;
+	size_t i;
+
+	/* Spans attached to another one are accounted for by the root span */
+	if (s->root != it->first || s->events.empty()) {
+		g_spans.erase(it);
+		return;
+	}
+
+	for (i = 1; i < s->events.size(); ++i) {
+		g_stages[stage_key(it->first.first,
+				   std::make_pair(s->events[i - 1].tpoint_id, s->events[i].tpoint_id))]
+		.tally(s->events[i].tsc - s->events[i - 1].tsc);
+	}
+
+	duration = s->events.back().tsc - s->events.front().tsc;
+	g_stages[stage_key(it->first.first, std::make_pair(SPDK_TRACE_MAX_TPOINT_ID,
+			   SPDK_TRACE_MAX_TPOINT_ID))].tally(duration);
+
+	if (g_num_slowest > 0 &&
+	    (g_slowest.size() < g_num_slowest || g_slowest.top().duration < duration)) {
+		g_slowest.push(finished_span(duration, it->first, s->lcore, s->events));
+		if (g_slowest.size() > g_num_slowest) {
+			g_slowest.pop();
+		}
+	}
+
+	g_spans.erase(it);
+}
+
+static span_key
+get_span_root(const span_key &key)
+{
+	std::map<span_key, span>::iterator it = g_spans.find(key);
+
+	return it != g_spans.end() ? it->second.root : key;
+}
+
+static void
+process_span_event(struct spdk_trace_parser_entry *entry)
+{
+	struct spdk_trace_entry		*e = entry->entry;
+	const struct spdk_trace_tpoint	*d = &g_flags->tpoint[e->tpoint_id];
+	std::map<std::pair<uint8_t, uint64_t>, uint64_t>::iterator id;
+	std::map<span_key, span>::iterator it;
+	span_key key(d->object_type, entry->object_index);
+	span *s;
+
+	if (d->object_type == OBJECT_NONE || entry->object_index == UINT64_MAX) {
+		return;
+	}
+
+	if (d->new_object) {
+		/* A new object with the same ID means that the previous one is done */
+		id = g_span_ids.find(std::make_pair(d->object_type, e->object_id));
+		if (id != g_span_ids.end()) {
+			it = g_spans.find(span_key(d->object_type, id->second));
+			if (it != g_spans.end()) {
+				finish_span(it);
+			}
+		}
+		g_span_ids[std::make_pair(d->object_type, e->object_id)] = entry->object_index;
+	}
+
+	it = g_spans.find(key);
+	if (it == g_spans.end()) {
+		s = &g_spans[key];
+		s->lcore = entry->lcore;
+		s->root = key;
+	} else {
+		s = &it->second;
+	}
+
+	if (entry->related_type != OBJECT_NONE && s->root == key) {
+		s->root = get_span_root(span_key(entry->related_type, entry->related_index));
+	}
+
+	/* The root might be gone already, if its object was reused */
+	it = g_spans.find(s->root);
+	if (it == g_spans.end()) {
+		return;
+	}
+
+	it->second.events.push_back(span_event(e->tpoint_id, e->tsc));
+}
+
+struct percentile_ctx {
+	double		percentile;
+	uint64_t	value;
+};
+
+static void
+check_percentile(void *ctx, uint64_t start, uint64_t end, uint64_t count,
+		 uint64_t total, uint64_t so_far)
+{
+	struct percentile_ctx *pctx = (struct percentile_ctx *)ctx;
+
+	if (count == 0 || pctx->value != UINT64_MAX) {
+		return;
+	}
+
+	if (so_far >= (double)total * pctx->percentile / 100) {
+		pctx->value = end;
+	}
+}
+
+static uint64_t
+get_percentile(const latency_stats &stats, double percentile)
+{
+	struct percentile_ctx ctx;
+
+	ctx.percentile = percentile;
+	ctx.value = UINT64_MAX;
+
+	spdk_histogram_data_iterate(stats.histogram, check_percentile, &ctx);
+
+	/* Buckets are ranges, so don't report anything above the actual maximum */
+	return spdk_min(ctx.value, stats.max);
+}
+
+static const char *
+get_stage_tpoint_name(uint16_t tpoint_id)
+{
+	return tpoint_id == SPDK_TRACE_MAX_TPOINT_ID ? "total" : g_flags->tpoint[tpoint_id].name;
+}
+
+static void
+print_latency(uint64_t tsc_rate, uint64_t tsc_offset)
+{
+	std::map<stage_key, latency_stats>::iterator stage;
+	std::vector<finished_span> slowest;
+	char name[2 * sizeof(g_flags->tpoint[0].name) + 8];
+	uint8_t object_type = OBJECT_NONE;
+	size_t i, j;
+
+	while (!g_spans.empty()) {
+		finish_span(g_spans.begin());
+	}
+
+	while (!g_slowest.empty()) {
+		slowest.push_back(g_slowest.top());
+		g_slowest.pop();
+	}
+
+	if (g_json != NULL) {
+		spdk_json_write_named_array_begin(g_json, "stages");
+		for (stage = g_stages.begin(); stage != g_stages.end(); ++stage) {
+			const latency_stats &stats = stage->second;
+
+			spdk_json_write_object_begin(g_json);
+			spdk_json_write_named_string_fmt(g_json, "object", "%c",
+							 g_flags->object[stage->first.first].id_prefix);
+			if (stage->first.second.first != SPDK_TRACE_MAX_TPOINT_ID) {
+				spdk_json_write_named_uint32(g_json, "from", stage->first.second.first);
+				spdk_json_write_named_uint32(g_json, "to", stage->first.second.second);
+			}
+			spdk_json_write_named_uint64(g_json, "count", stats.count);
+			spdk_json_write_named_uint64(g_json, "avg", stats.sum / stats.count);
+			spdk_json_write_named_uint64(g_json, "p50", get_percentile(stats, 50));
+			spdk_json_write_named_uint64(g_json, "p99", get_percentile(stats, 99));
+			spdk_json_write_named_uint64(g_json, "max", stats.max);
+			spdk_json_write_object_end(g_json);
+		}
+		spdk_json_write_array_end(g_json);
+
+		spdk_json_write_named_array_begin(g_json, "slowest");
+		for (i = slowest.size(); i > 0; --i) {
+			const finished_span &fs = slowest[i - 1];
+
+			spdk_json_write_object_begin(g_json);
+			spdk_json_write_named_string_fmt(g_json, "id", "%c%" PRIu64,
+							 g_flags->object[fs.key.first].id_prefix,
+							 fs.key.second);
+			spdk_json_write_named_uint64(g_json, "lcore", fs.lcore);
+			spdk_json_write_named_uint64(g_json, "duration", fs.duration);
+			spdk_json_write_named_array_begin(g_json, "events");
+			for (j = 0; j < fs.events.size(); ++j) {
+				spdk_json_write_object_begin(g_json);
+				spdk_json_write_named_uint32(g_json, "tpoint", fs.events[j].tpoint_id);
+				spdk_json_write_named_uint64(g_json, "tsc", fs.events[j].tsc);
+				spdk_json_write_object_end(g_json);
+			}
+			spdk_json_write_array_end(g_json);
+			spdk_json_write_object_end(g_json);
+		}
+		spdk_json_write_array_end(g_json);
+		return;
+	}
+
+	for (stage = g_stages.begin(); stage != g_stages.end(); ++stage) {
+		const latency_stats &stats = stage->second;
+
+		if (stage->first.first != object_type) {
+			object_type = stage->first.first;
+			printf("\nLatency of '%c' spans (usec):\n", g_flags->object[object_type].id_prefix);
+			printf("%-*s %10s %10s %10s %10s %10s\n", (int)sizeof(name), "stage",
+			       "count", "avg", "p50", "p99", "max");
+		}
+
+		if (stage->first.second.first == SPDK_TRACE_MAX_TPOINT_ID) {
+			snprintf(name, sizeof(name), "total");
+		} else {
+			snprintf(name, sizeof(name), "%s -> %s",
+				 get_stage_tpoint_name(stage->first.second.first),
+				 get_stage_tpoint_name(stage->first.second.second));
+		}
+
+		printf("%-*s %10ju %10.3f %10.3f %10.3f %10.3f\n", (int)sizeof(name), name,
+		       stats.count, get_us_from_tsc(stats.sum / stats.count, tsc_rate),
+		       get_us_from_tsc(get_percentile(stats, 50), tsc_rate),
+		       get_us_from_tsc(get_percentile(stats, 99), tsc_rate),
+		       get_us_from_tsc(stats.max, tsc_rate));
+	}
+
+	if (slowest.empty()) {
+		return;
+	}
+
+	printf("\nSlowest spans (usec):\n");
+	for (i = slowest.size(); i > 0; --i) {
+		const finished_span &fs = slowest[i - 1];
+
+		printf("%c%-16ju lcore: %2d start: %10.3f time: %10.3f\n",
+		       g_flags->object[fs.key.first].id_prefix, fs.key.second, fs.lcore,
+		       get_us_from_tsc(fs.events.front().tsc - tsc_offset, tsc_rate),
+		       get_us_from_tsc(fs.duration, tsc_rate));
+		for (j = 0; j < fs.events.size(); ++j) {
+			printf("    %-*s %10.3f\n", (int)sizeof(g_flags->tpoint[0].name),
+			       get_stage_tpoint_name(fs.events[j].tpoint_id),
+			       get_us_from_tsc(fs.events[j].tsc - fs.events.front().tsc, tsc_rate));
+		}
+	}
+}
+
 static void
 usage(void)
 {
@@ -334,6 +658,14 @@ usage(void)
 	fprintf(stderr, "                 '-f' to specify a tracepoint file name\n");
 	fprintf(stderr, "                      (-s and -f are mutually exclusive)\n");
 	fprintf(stderr, "                 '-j' to use JSON to format the output\n");
+	fprintf(stderr, "                 '-b' to specify the beginning of the time window to\n");
+	fprintf(stderr, "                      display (in usec)\n");
+	fprintf(stderr, "                 '-e' to specify the end of the time window to\n");
+	fprintf(stderr, "                      display (in usec)\n");
+	fprintf(stderr, "                 '-l' to display latency of the requests' stages\n");
+	fprintf(stderr, "                      instead of the tracepoints\n");
+	fprintf(stderr, "                 '-n' to specify the number of slowest requests\n");
+	fprintf(stderr, "                      displayed with -l (default: 10)\n");
 }
 
 int
@@ -342,7 +674,8 @@ main(int argc, char **argv)
 	struct spdk_trace_parser_opts	opts;
 	struct spdk_trace_parser_entry	entry;
 	int				lcore = SPDK_TRACE_MAX_LCORE;
-	uint64_t			tsc_offset, entry_count;
+	uint64_t			tsc_offset, entry_count, tsc_begin, tsc_end;
+	double				begin_us = 0, end_us = 0;
 	const char			*app_name = NULL;
 	const char			*file_name = NULL;
 	int				op, i;
@@ -351,8 +684,22 @@ main(int argc, char **argv)
 	bool				json = false;
 
 	g_exe_name = argv[0];
-	while ((op = getopt(argc, argv, "c:f:i:jp:s:t")) != -1) {
+	while ((op = getopt(argc, argv, "b:c:e:f:i:jln:p:s:t")) != -1) {
 		switch (op) {
+		case 'b':
+			begin_us = atof(optarg);
+			if (begin_us < 0) {
+				fprintf(stderr, "Invalid beginning of the time window: %s\n", optarg);
+				exit(1);
+			}
+			break;
+		case 'e':
+			end_us = atof(optarg);
+			if (end_us <= 0) {
+				fprintf(stderr, "Invalid end of the time window: %s\n", optarg);
+				exit(1);
+			}
+			break;
 		case 'c':
 			lcore = atoi(optarg);
 			if (lcore > SPDK_TRACE_MAX_LCORE) {
@@ -380,6 +727,16 @@ main(int argc, char **argv)
 		case 'j':
 			json = true;
 			break;
+		case 'l':
+			g_print_latency = true;
+			break;
+		case 'n':
+			g_num_slowest = spdk_strtol(optarg, 10);
+			if ((long)g_num_slowest < 0) {
+				fprintf(stderr, "Invalid number of requests: %s\n", optarg);
+				exit(1);
+			}
+			break;
 		default:
 			usage();
 			exit(1);
@@ -430,7 +787,9 @@ main(int argc, char **argv)
 	} else {
 		spdk_json_write_object_begin(g_json);
 		print_tpoint_definitions();
-		spdk_json_write_named_array_begin(g_json, "entries");
+		if (!g_print_latency) {
+			spdk_json_write_named_array_begin(g_json, "entries");
+		}
 	}
 
 	for (i = 0; i < SPDK_TRACE_MAX_LCORE; ++i) {
@@ -443,15 +802,34 @@ main(int argc, char **argv)
 	}
 
 	tsc_offset = spdk_trace_parser_get_tsc_offset(g_parser);
+	tsc_begin = tsc_offset + (uint64_t)(begin_us * g_flags->tsc_rate / (1000 * 1000));
+	tsc_end = end_us > 0 ? tsc_offset + (uint64_t)(end_us * g_flags->tsc_rate / (1000 * 1000)) :
+		  UINT64_MAX;
+	if (tsc_begin > tsc_offset) {
+		spdk_trace_parser_seek(g_parser, tsc_begin);
+	}
+
 	while (spdk_trace_parser_next_entry(g_parser, &entry)) {
 		if (entry.entry->tsc < tsc_offset) {
 			continue;
 		}
-		process_event(&entry, g_flags->tsc_rate, tsc_offset);
+		if (entry.entry->tsc > tsc_end) {
+			break;
+		}
+		if (g_print_latency) {
+			process_span_event(&entry);
+		} else {
+			process_event(&entry, g_flags->tsc_rate, tsc_offset);
+		}
 	}
 
-	if (g_json != NULL) {
+	if (g_print_latency) {
+		print_latency(g_flags->tsc_rate, tsc_offset);
+	} else if (g_json != NULL) {
 		spdk_json_write_array_end(g_json);
+	}
+
+	if (g_json != NULL) {
 		spdk_json_write_object_end(g_json);
 		spdk_json_write_end(g_json);
 	}
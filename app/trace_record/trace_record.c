@@ -37,6 +37,9 @@ struct lcore_trace_record_ctx {
 
 	/* Total number of entries in lcore trace file */
 	uint64_t num_entries;
+
+	/* Number of entries overwritten in shm before they could be recorded */
+	uint64_t lost_entries;
 };
 
 struct aggr_trace_record_ctx {
@@ -45,8 +48,37 @@ struct aggr_trace_record_ctx {
 	int shm_fd;
 	struct lcore_trace_record_ctx lcore_ports[SPDK_TRACE_MAX_LCORE];
 	struct spdk_trace_histories *trace_histories;
+
+	/* Entries are copied out of shm here and checked before being written to the lcore file */
+	struct spdk_trace_entry *copy_buf;
+	uint64_t copy_buf_entries;
+
+	/* Maximum number of entries a single tracepoint can span */
+	uint64_t max_record_entries;
 };
 
+/* Returns the number of entries the largest tracepoint, together with its arguments, takes. */
+static uint64_t
+trace_max_record_entries(const struct spdk_trace_flags *flags)
+{
+	const struct spdk_trace_tpoint *tpoint;
+	uint64_t size, max_size = 0;
+	uint16_t i;
+	uint8_t j;
+
+	for (i = 0; i < SPDK_TRACE_MAX_TPOINT_ID; i++) {
+		tpoint = &flags->tpoint[i];
+		size = offsetof(struct spdk_trace_entry, args) -
+		       offsetof(struct spdk_trace_entry_buffer, data);
+		for (j = 0; j < tpoint->num_args; j++) {
+			size += tpoint->args[j].size;
+		}
+		max_size = spdk_max(max_size, size);
+	}
+
+	return SPDK_CEIL_DIV(max_size, sizeof(((struct spdk_trace_entry_buffer *)0)->data));
+}
+
 static int
 input_trace_file_mmap(struct aggr_trace_record_ctx *ctx, const char *shm_name)
 {
@@ -101,12 +133,26 @@ input_trace_file_mmap(struct aggr_trace_record_ctx *ctx, const char *shm_name)
 		ctx->lcore_ports[i].in_history = history;
 		ctx->lcore_ports[i].valid = (history != NULL);
 
+		if (history != NULL) {
+			ctx->copy_buf_entries = spdk_max(ctx->copy_buf_entries, history->num_entries);
+		}
+
 		if (g_verbose && history) {
 			printf("Number of trace entries for lcore (%d): %ju\n", i,
 			       history->num_entries);
 		}
 	}
 
+	ctx->copy_buf = calloc(ctx->copy_buf_entries, sizeof(struct spdk_trace_entry));
+	if (ctx->copy_buf == NULL) {
+		fprintf(stderr, "Failed to allocate memory for trace entries copy buffer.\n");
+		munmap(history_ptr, g_histories_size);
+		close(ctx->shm_fd);
+		return -1;
+	}
+
+	ctx->max_record_entries = trace_max_record_entries(&ctx->trace_histories->flags);
+
 	return 0;
 }
 
@@ -255,93 +301,39 @@ cont_read(int fildes, void *buf, size_t nbyte)
 	return nbyte;
 }
 
-static int
-lcore_trace_last_entry_idx(struct spdk_trace_history *in_history, int cir_next_idx)
-{
-	int last_idx;
-
-	if (cir_next_idx == 0) {
-		last_idx = in_history->num_entries - 1;
-	} else {
-		last_idx = cir_next_idx - 1;
-	}
-
-	return last_idx;
-}
-
-static int
-circular_buffer_padding_backward(int fd, struct spdk_trace_history *in_history,
-				 int cir_start, int cir_end)
-{
-	int rc;
-
-	if (cir_end <= cir_start) {
-		fprintf(stderr, "Wrong using of circular_buffer_padding_back\n");
-		return -1;
-	}
-
-	rc = cont_write(fd, &in_history->entries[cir_start],
-			sizeof(struct spdk_trace_entry) * (cir_end - cir_start));
-	if (rc < 0) {
-		fprintf(stderr, "Failed to append entries into lcore file\n");
-		return rc;
-	}
-
-	return 0;
-}
-
-static int
-circular_buffer_padding_across(int fd, struct spdk_trace_history *in_history,
-			       int cir_start, int cir_end)
+/* Copies the entries [start, end) out of the circular buffer of an lcore. */
+static void
+lcore_trace_copy_entries(struct spdk_trace_history *in_history, struct spdk_trace_entry *buf,
+			 uint64_t start, uint64_t end)
 {
-	int rc;
-	int num_entries = in_history->num_entries;
-
-	if (cir_end > cir_start) {
-		fprintf(stderr, "Wrong using of circular_buffer_padding_across\n");
-		return -1;
-	}
-
-	rc = cont_write(fd, &in_history->entries[cir_start],
-			sizeof(struct spdk_trace_entry) * (num_entries - cir_start));
-	if (rc < 0) {
-		fprintf(stderr, "Failed to append entries into lcore file backward\n");
-		return rc;
-	}
-
-	if (cir_end == 0) {
-		return 0;
-	}
+	uint64_t num_cir_entries = in_history->num_entries;
+	uint64_t cir_start = start & (num_cir_entries - 1);
+	uint64_t count = end - start;
+	uint64_t len = spdk_min(count, num_cir_entries - cir_start);
 
-	rc = cont_write(fd, &in_history->entries[0], sizeof(struct spdk_trace_entry) * cir_end);
-	if (rc < 0) {
-		fprintf(stderr, "Failed to append entries into lcore file forward\n");
-		return rc;
+	memcpy(buf, &in_history->entries[cir_start], len * sizeof(struct spdk_trace_entry));
+	if (len < count) {
+		memcpy(&buf[len], &in_history->entries[0], (count - len) * sizeof(struct spdk_trace_entry));
 	}
-
-	return 0;
-}
-
-static int
-circular_buffer_padding_all(int fd, struct spdk_trace_history *in_history,
-			    int cir_end)
-{
-	return circular_buffer_padding_across(fd, in_history, cir_end, cir_end);
 }
 
+/*
+ * Appends the entries recorded on an lcore since the last call to its lcore file.  The
+ * application keeps writing while they're copied, so next_entry, which counts all entries ever
+ * recorded on the lcore, is used as a sequence number: anything the writer may have lapped
+ * during the copy is dropped afterwards and accounted as lost, as are the entries overwritten
+ * before this call.  This needs no synchronization with the application.
+ */
 static int
-lcore_trace_record(struct lcore_trace_record_ctx *lcore_port)
+lcore_trace_record(struct aggr_trace_record_ctx *ctx, struct lcore_trace_record_ctx *lcore_port)
 {
 	struct spdk_trace_history	*in_history = lcore_port->in_history;
+	struct spdk_trace_entry		*buf = ctx->copy_buf;
 	uint64_t			rec_next_entry = lcore_port->rec_next_entry;
-	uint64_t			rec_num_entries = lcore_port->num_entries;
-	int				fd = lcore_port->fd;
-	uint64_t			shm_next_entry;
-	uint64_t			num_cir_entries;
-	uint64_t			shm_cir_next;
-	uint64_t			rec_cir_next;
+	uint64_t			num_cir_entries = in_history->num_entries;
+	uint64_t			shm_next_entry, cur_next_entry;
+	uint64_t			start, count, skip, lost = 0;
 	int				rc;
-	int				last_idx;
 
 	shm_next_entry = in_history->next_entry;
 
@@ -359,77 +351,66 @@ lcore_trace_record(struct lcore_trace_record_ctx *lcore_port)
 		return -1;
 	}
 
-	num_cir_entries = in_history->num_entries;
-	shm_cir_next = shm_next_entry & (num_cir_entries - 1);
-
-	/* Record first entry's tsc and corresponding entries when recording first time. */
-	if (lcore_port->first_entry_tsc == 0) {
-		if (shm_next_entry < num_cir_entries) {
-			/* Updates haven't been across circular buffer yet.
-			 * The first entry in shared memory is the eldest one.
-			 */
-			lcore_port->first_entry_tsc = in_history->entries[0].tsc;
+	/* Only the last num_cir_entries entries are still in shm */
+	start = rec_next_entry;
+	if (shm_next_entry - start > num_cir_entries) {
+		lost += shm_next_entry - num_cir_entries - start;
+		start = shm_next_entry - num_cir_entries;
+	}
+	count = shm_next_entry - start;
 
-			lcore_port->num_entries += shm_cir_next;
-			rc = circular_buffer_padding_backward(fd, in_history, 0, shm_cir_next);
-		} else {
-			/* Updates have already been across circular buffer.
-			 * The eldest entry in shared memory is pointed by shm_cir_next.
-			 */
-			lcore_port->first_entry_tsc = in_history->entries[shm_cir_next].tsc;
+	lcore_trace_copy_entries(in_history, buf, start, shm_next_entry);
 
-			lcore_port->num_entries += num_cir_entries;
-			rc = circular_buffer_padding_all(fd, in_history, shm_cir_next);
-		}
+	/* Make sure the copy is done before checking how far the writer got in the meantime */
+	spdk_smp_rmb();
+	cur_next_entry = in_history->next_entry;
 
-		goto out;
+	/* The tracepoint being written may span up to max_record_entries beyond next_entry, so
+	 * any entry within num_cir_entries of that point may have been overwritten. */
+	skip = 0;
+	if (cur_next_entry + ctx->max_record_entries > start + num_cir_entries) {
+		skip = spdk_min(cur_next_entry + ctx->max_record_entries - num_cir_entries - start, count);
 	}
 
-	if (shm_next_entry - rec_next_entry > num_cir_entries) {
-		/* There must be missed updates */
-		fprintf(stderr, "Trace-record missed %ju trace entries\n",
-			shm_next_entry - rec_next_entry - num_cir_entries);
-
-		lcore_port->num_entries += num_cir_entries;
-		rc = circular_buffer_padding_all(fd, in_history, shm_cir_next);
-	} else if (shm_next_entry - rec_next_entry == num_cir_entries) {
-		/* All circular buffer is updated */
-		lcore_port->num_entries += num_cir_entries;
-		rc = circular_buffer_padding_all(fd, in_history, shm_cir_next);
-	} else {
-		/* Part of circular buffer is updated */
-		rec_cir_next = rec_next_entry & (num_cir_entries - 1);
-
-		if (shm_cir_next > rec_cir_next) {
-			/* Updates are not across circular buffer */
-			lcore_port->num_entries += shm_cir_next - rec_cir_next;
-			rc = circular_buffer_padding_backward(fd, in_history, rec_cir_next, shm_cir_next);
-		} else {
-			/* Updates are across circular buffer */
-			lcore_port->num_entries += num_cir_entries - rec_cir_next + shm_cir_next;
-			rc = circular_buffer_padding_across(fd, in_history, rec_cir_next, shm_cir_next);
+	/* Don't start in the middle of a tracepoint spanning multiple entries */
+	if (skip > 0 || lost > 0) {
+		while (skip < count && buf[skip].tpoint_id == SPDK_TRACE_MAX_TPOINT_ID) {
+			skip++;
 		}
 	}
+	lost += skip;
 
-out:
-	if (rc) {
-		return rc;
+	if (lost > 0) {
+		lcore_port->lost_entries += lost;
+		if (g_verbose) {
+			fprintf(stderr, "Trace-record missed %ju trace entries for lcore %d\n", lost,
+				in_history->lcore);
+		}
 	}
 
-	if (g_verbose) {
-		printf("Append %ju trace_entry for lcore %d\n", lcore_port->num_entries - rec_num_entries,
-		       in_history->lcore);
+	if (skip < count) {
+		rc = cont_write(lcore_port->fd, &buf[skip], sizeof(struct spdk_trace_entry) * (count - skip));
+		if (rc < 0) {
+			fprintf(stderr, "Failed to append entries into lcore file\n");
+			return rc;
+		}
+
+		if (lcore_port->first_entry_tsc == 0) {
+			lcore_port->first_entry_tsc = buf[skip].tsc;
+		}
+		lcore_port->last_entry_tsc = buf[count - 1].tsc;
+		lcore_port->num_entries += count - skip;
+
+		if (g_verbose) {
+			printf("Append %ju trace_entry for lcore %d\n", count - skip, in_history->lcore);
+		}
 	}
 
 	/* Update tpoint_count info */
 	memcpy(lcore_port->out_history, lcore_port->in_history, sizeof(struct spdk_trace_history));
-
-	/* Update last_entry_tsc to align with appended entries */
-	last_idx = lcore_trace_last_entry_idx(in_history, shm_cir_next);
-	lcore_port->last_entry_tsc = in_history->entries[last_idx].tsc;
 	lcore_port->rec_next_entry = shm_next_entry;
 
-	return rc;
+	return 0;
 }
 
 static int
@@ -665,7 +646,7 @@ main(int argc, char **argv)
 			if (!lcore_port->valid) {
 				continue;
 			}
-			rc = lcore_trace_record(lcore_port);
+			rc = lcore_trace_record(&ctx, lcore_port);
 			if (rc) {
 				break;
 			}
@@ -697,6 +678,17 @@ main(int argc, char **argv)
 
 	}
 
+	for (i = 0; i < SPDK_TRACE_MAX_LCORE; i++) {
+		lcore_port = &ctx.lcore_ports[i];
+
+		if (lcore_port->lost_entries == 0) {
+			continue;
+		}
+
+		printf("Lost %ju trace entries for lcore (%d)\n", lcore_port->lost_entries, i);
+	}
+
+	free(ctx.copy_buf);
 	munmap(ctx.trace_histories, g_histories_size);
 	close(ctx.shm_fd);
 
@@ -17,6 +17,9 @@
 #define DATA_PATTERN 0x5a
 #define ALIGN_4K 0x1000
 #define COMP_BUF_PAD_PERCENTAGE 1.1L
+#define MAX_SEQUENCE_OPS 8
+/* The sequence workload chains several opcodes, so it doesn't map to a single one */
+#define ACCEL_PERF_WORKLOAD_SEQUENCE ACCEL_OPC_LAST
 
 static uint64_t	g_tsc_rate;
 static uint64_t g_tsc_end;
@@ -37,6 +40,19 @@ static uint32_t g_xor_src_count = 2;
 static bool g_verify = false;
 static const char *g_workload_type = NULL;
 static enum accel_opcode g_workload_selection;
+static enum accel_opcode g_seq_ops[MAX_SEQUENCE_OPS];
+static uint32_t g_seq_ops_count = 0;
+
+static const struct {
+	const char		*name;
+	enum accel_opcode	opcode;
+} g_seq_op_names[] = {
+	{ "copy", ACCEL_OPC_COPY },
+	{ "fill", ACCEL_OPC_FILL },
+	{ "crc32c", ACCEL_OPC_CRC32C },
+	/* Can't be appended, but adjacent copy and crc32c operations might be fused into it */
+	{ "copy_crc32c", ACCEL_OPC_COPY_CRC32C },
+};
 static struct worker_thread *g_workers = NULL;
 static int g_num_workers = 0;
 static char *g_cd_file_in_name = NULL;
@@ -82,6 +98,8 @@ struct ap_task {
 	struct ap_compress_seg *cur_seg;
 	struct worker_thread	*worker;
 	int			expected_status; /* used for the compare operation */
+	uint8_t			seq_pattern[2]; /* src and dst contents, sequence workload */
+	uint64_t		submit_tsc;
 	TAILQ_ENTRY(ap_task)	link;
 };
 
@@ -101,17 +119,57 @@ struct worker_thread {
 	void				*task_base;
 	struct display_info		display;
 	enum accel_opcode		workload;
+	/* Used by the sequence workload only */
+	struct spdk_accel_opcode_stats	seq_op_stats[ACCEL_OPC_LAST];
+	uint64_t			seq_latency_ticks;
+	uint64_t			seq_latency_min;
+	uint64_t			seq_latency_max;
 };
 
+static const char *
+seq_op_name(enum accel_opcode opcode)
+{
+	size_t i;
+
+	for (i = 0; i < SPDK_COUNTOF(g_seq_op_names); i++) {
+		if (g_seq_op_names[i].opcode == opcode) {
+			return g_seq_op_names[i].name;
+		}
+	}
+
+	return "unknown";
+}
+
+static void
+dump_sequence_config(void)
+{
+	const char *module_name = NULL;
+	uint32_t i;
+
+	printf("Sequence:       ");
+	for (i = 0; i < g_seq_ops_count; i++) {
+		printf("%s%s", seq_op_name(g_seq_ops[i]), i + 1 < g_seq_ops_count ? " -> " : "\n");
+	}
+	printf("Modules:        ");
+	for (i = 0; i < g_seq_ops_count; i++) {
+		if (spdk_accel_get_opc_module_name(g_seq_ops[i], &module_name)) {
+			module_name = "unknown";
+		}
+		printf("%s%s", module_name, i + 1 < g_seq_ops_count ? ", " : "\n");
+	}
+}
+
 static void
 dump_user_config(void)
 {
 	const char *module_name = NULL;
 	int rc;
 
-	rc = spdk_accel_get_opc_module_name(g_workload_selection, &module_name);
-	if (rc) {
-		printf("error getting module name (%d)\n", rc);
+	if (g_workload_selection != ACCEL_PERF_WORKLOAD_SEQUENCE) {
+		rc = spdk_accel_get_opc_module_name(g_workload_selection, &module_name);
+		if (rc) {
+			printf("error getting module name (%d)\n", rc);
+		}
 	}
 
 	printf("\nSPDK Configuration:\n");
@@ -134,7 +192,11 @@ dump_user_config(void)
 		printf("Transfer size:  %u bytes\n", g_xfer_size_bytes);
 	}
 	printf("vector count    %u\n", g_chained_count);
-	printf("Module:         %s\n", module_name);
+	if (g_workload_selection == ACCEL_PERF_WORKLOAD_SEQUENCE) {
+		dump_sequence_config();
+	} else {
+		printf("Module:         %s\n", module_name);
+	}
 	if (g_workload_selection == ACCEL_OPC_COMPRESS || g_workload_selection == ACCEL_OPC_DECOMPRESS) {
 		printf("File Name:      %s\n", g_cd_file_in_name);
 	}
@@ -156,7 +218,8 @@ usage(void)
 	printf("\t[-n number of channels]\n");
 	printf("\t[-o transfer size in bytes (default: 4KiB. For compress/decompress, 0 means the input file size)]\n");
 	printf("\t[-t time in seconds]\n");
-	printf("\t[-w workload type must be one of these: copy, fill, crc32c, copy_crc32c, compare, compress, decompress, dualcast, xor\n");
+	printf("\t[-w workload type must be one of these: copy, fill, crc32c, copy_crc32c, compare, compress, decompress, dualcast, xor, sequence\n");
+	printf("\t[-S for sequence workload, comma separated list of operations to chain: copy, fill, crc32c (e.g. fill,copy,crc32c)]\n");
 	printf("\t[-l for compress/decompress workloads, name of uncompressed input file\n");
 	printf("\t[-s for crc32c workload, use this seed value (default 0)\n");
 	printf("\t[-P for compare workload, percentage of operations that should miscompare (percent, default 0)\n");
@@ -167,6 +230,43 @@ usage(void)
 	printf("\t\tCan be used to spread operations across a wider range of memory.\n");
 }
 
+static int
+parse_sequence(const char *str)
+{
+	char *ops, *op, *tmp;
+	size_t i;
+	int rc = 0;
+
+	ops = strdup(str);
+	if (ops == NULL) {
+		return -ENOMEM;
+	}
+
+	g_seq_ops_count = 0;
+	for (op = strtok_r(ops, ",", &tmp); op != NULL; op = strtok_r(NULL, ",", &tmp)) {
+		if (g_seq_ops_count == MAX_SEQUENCE_OPS) {
+			fprintf(stderr, "At most %d operations can be chained\n", MAX_SEQUENCE_OPS);
+			rc = -EINVAL;
+			break;
+		}
+		for (i = 0; i < SPDK_COUNTOF(g_seq_op_names); i++) {
+			if (!strcmp(op, g_seq_op_names[i].name) &&
+			    g_seq_op_names[i].opcode != ACCEL_OPC_COPY_CRC32C) {
+				g_seq_ops[g_seq_ops_count++] = g_seq_op_names[i].opcode;
+				break;
+			}
+		}
+		if (i == SPDK_COUNTOF(g_seq_op_names)) {
+			fprintf(stderr, "Unsupported sequence operation: %s\n", op);
+			rc = -EINVAL;
+			break;
+		}
+	}
+
+	free(ops);
+	return rc;
+}
+
 static int
 parse_args(int argc, char *argv)
 {
@@ -228,6 +328,12 @@ parse_args(int argc, char *argv)
 	case 'x':
 		g_xor_src_count = argval;
 		break;
+	case 'S':
+		if (parse_sequence(optarg)) {
+			usage();
+			return 1;
+		}
+		break;
 	case 'y':
 		g_verify = true;
 		break;
@@ -251,6 +357,8 @@ parse_args(int argc, char *argv)
 			g_workload_selection = ACCEL_OPC_DECOMPRESS;
 		} else if (!strcmp(g_workload_type, "xor")) {
 			g_workload_selection = ACCEL_OPC_XOR;
+		} else if (!strcmp(g_workload_type, "sequence")) {
+			g_workload_selection = ACCEL_PERF_WORKLOAD_SEQUENCE;
 		} else {
 			usage();
 			return 1;
@@ -269,9 +377,23 @@ static void
 unregister_worker(void *arg1)
 {
 	struct worker_thread *worker = arg1;
-
-	spdk_accel_get_opcode_stats(worker->ch, worker->workload,
-				    &worker->stats, sizeof(worker->stats));
+	enum accel_opcode opcode;
+	size_t i;
+
+	if (worker->workload == ACCEL_PERF_WORKLOAD_SEQUENCE) {
+		/* Operations might be merged or elided within a sequence, so report what each
+		 * opcode actually executed, while the sequences themselves count as transfers */
+		for (i = 0; i < SPDK_COUNTOF(g_seq_op_names); i++) {
+			opcode = g_seq_op_names[i].opcode;
+			spdk_accel_get_opcode_stats(worker->ch, opcode,
+						    &worker->seq_op_stats[opcode],
+						    sizeof(worker->seq_op_stats[opcode]));
+		}
+		worker->stats.num_bytes = worker->stats.executed * g_xfer_size_bytes;
+	} else {
+		spdk_accel_get_opcode_stats(worker->ch, worker->workload,
+					    &worker->stats, sizeof(worker->stats));
+	}
 	free(worker->task_base);
 	spdk_put_io_channel(worker->ch);
 	spdk_thread_exit(spdk_get_thread());
@@ -309,6 +431,35 @@ accel_perf_construct_iovs(void *buf, uint64_t sz, struct iovec *iovs, uint32_t i
 	assert(sz == 0);
 }
 
+static int
+_get_task_sequence_bufs(struct ap_task *task)
+{
+	task->src = spdk_dma_zmalloc(g_xfer_size_bytes, 0, NULL);
+	task->dst = spdk_dma_zmalloc(g_xfer_size_bytes, 0, NULL);
+	if (task->src == NULL || task->dst == NULL) {
+		fprintf(stderr, "Unable to alloc data buffers\n");
+		return -ENOMEM;
+	}
+
+	task->src_iovs = calloc(g_chained_count, sizeof(struct iovec));
+	task->dst_iovs = calloc(g_chained_count, sizeof(struct iovec));
+	if (task->src_iovs == NULL || task->dst_iovs == NULL) {
+		fprintf(stderr, "cannot allocate iovs for task=%p\n", task);
+		return -ENOMEM;
+	}
+
+	task->src_iovcnt = task->dst_iovcnt = g_chained_count;
+	accel_perf_construct_iovs(task->src, g_xfer_size_bytes, task->src_iovs, task->src_iovcnt);
+	accel_perf_construct_iovs(task->dst, g_xfer_size_bytes, task->dst_iovs, task->dst_iovcnt);
+
+	task->seq_pattern[0] = DATA_PATTERN;
+	task->seq_pattern[1] = ~DATA_PATTERN;
+	memset(task->src, task->seq_pattern[0], g_xfer_size_bytes);
+	memset(task->dst, task->seq_pattern[1], g_xfer_size_bytes);
+
+	return 0;
+}
+
 static int
 _get_task_data_bufs(struct ap_task *task)
 {
@@ -316,6 +467,10 @@ _get_task_data_bufs(struct ap_task *task)
 	uint32_t i = 0;
 	int dst_buff_len = g_xfer_size_bytes;
 
+	if (g_workload_selection == ACCEL_PERF_WORKLOAD_SEQUENCE) {
+		return _get_task_sequence_bufs(task);
+	}
+
 	/* For dualcast, the DSA HW requires 4K alignment on destination addresses but
 	 * we do this for all modules to keep it simple.
 	 */
@@ -444,6 +599,55 @@ _get_task(struct worker_thread *worker)
 	return task;
 }
 
+/* Build a sequence of the requested operations.  The data moves between the src and dst buffers
+ * with each copy, while fill and crc32c work on the buffer holding the data at that point. */
+static int
+_submit_sequence(struct worker_thread *worker, struct ap_task *task)
+{
+	struct spdk_accel_sequence *seq = NULL;
+	struct iovec *iovs[2] = { task->src_iovs, task->dst_iovs };
+	uint32_t i, cur = 0;
+	int rc = 0;
+
+	for (i = 0; i < g_seq_ops_count && rc == 0; i++) {
+		switch (g_seq_ops[i]) {
+		case ACCEL_OPC_COPY:
+			rc = spdk_accel_append_copy(&seq, worker->ch, iovs[!cur], g_chained_count,
+						    NULL, NULL, iovs[cur], g_chained_count, NULL, NULL,
+						    0, NULL, NULL);
+			cur = !cur;
+			break;
+		case ACCEL_OPC_FILL:
+			/* The iovs of both buffers are contiguous */
+			rc = spdk_accel_append_fill(&seq, worker->ch, iovs[cur][0].iov_base,
+						    g_xfer_size_bytes, NULL, NULL, g_fill_pattern, 0,
+						    NULL, NULL);
+			break;
+		case ACCEL_OPC_CRC32C:
+			rc = spdk_accel_append_crc32c(&seq, worker->ch, &task->crc_dst, iovs[cur],
+						      g_chained_count, NULL, NULL, g_crc32c_seed,
+						      NULL, NULL);
+			break;
+		default:
+			assert(false);
+			rc = -EINVAL;
+			break;
+		}
+	}
+
+	if (rc != 0) {
+		if (seq != NULL) {
+			spdk_accel_sequence_abort(seq);
+		}
+		return rc;
+	}
+
+	task->submit_tsc = spdk_get_ticks();
+	spdk_accel_sequence_finish(seq, accel_done, task);
+
+	return 0;
+}
+
 /* Submit one operation using the same ap task that just completed. */
 static void
 _submit_single(struct worker_thread *worker, struct ap_task *task)
@@ -506,6 +710,9 @@ _submit_single(struct worker_thread *worker, struct ap_task *task)
 		rc = spdk_accel_submit_xor(worker->ch, task->dst, task->sources, g_xor_src_count,
 					   g_xfer_size_bytes, accel_done, task);
 		break;
+	case ACCEL_PERF_WORKLOAD_SEQUENCE:
+		rc = _submit_sequence(worker, task);
+		break;
 	default:
 		assert(false);
 		break;
@@ -542,6 +749,10 @@ _free_task_buffers(struct ap_task *task)
 			}
 			free(task->sources);
 		}
+	} else if (g_workload_selection == ACCEL_PERF_WORKLOAD_SEQUENCE) {
+		free(task->src_iovs);
+		free(task->dst_iovs);
+		spdk_dma_free(task->src);
 	} else {
 		spdk_dma_free(task->src);
 	}
@@ -574,6 +785,67 @@ _vector_memcmp(void *_dst, struct iovec *src_src_iovs, uint32_t iovcnt)
 	return 0;
 }
 
+static bool
+_buf_has_pattern(const uint8_t *buf, uint8_t pattern)
+{
+	int i;
+
+	for (i = 0; i < g_xfer_size_bytes; i++) {
+		if (buf[i] != pattern) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Replay the sequence on the contents of the task's buffers and check the results */
+static int
+_verify_sequence(struct ap_task *task)
+{
+	uint8_t *pattern = task->seq_pattern;
+	uint32_t i, cur = 0, crc32c = 0;
+	bool check_crc32c = false;
+	void *buf;
+	int rc = 0;
+
+	for (i = 0; i < g_seq_ops_count; i++) {
+		switch (g_seq_ops[i]) {
+		case ACCEL_OPC_COPY:
+			pattern[!cur] = pattern[cur];
+			cur = !cur;
+			break;
+		case ACCEL_OPC_FILL:
+			pattern[cur] = g_fill_pattern;
+			break;
+		case ACCEL_OPC_CRC32C:
+			buf = malloc(g_xfer_size_bytes);
+			if (buf == NULL) {
+				return -ENOMEM;
+			}
+			memset(buf, pattern[cur], g_xfer_size_bytes);
+			crc32c = spdk_crc32c_update(buf, g_xfer_size_bytes, ~g_crc32c_seed);
+			check_crc32c = true;
+			free(buf);
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	}
+
+	if (check_crc32c && task->crc_dst != crc32c) {
+		SPDK_NOTICELOG("CRC-32C miscompare\n");
+		rc = -EILSEQ;
+	}
+	if (!_buf_has_pattern(task->src, pattern[0]) || !_buf_has_pattern(task->dst, pattern[1])) {
+		SPDK_NOTICELOG("Data miscompare\n");
+		rc = -EILSEQ;
+	}
+
+	return rc;
+}
+
 static int _worker_stop(void *arg);
 
 static void
@@ -582,10 +854,21 @@ accel_done(void *arg1, int status)
 	struct ap_task *task = arg1;
 	struct worker_thread *worker = task->worker;
 	uint32_t sw_crc32c;
+	uint64_t latency;
 
 	assert(worker);
 	assert(worker->current_queue_depth > 0);
 
+	if (worker->workload == ACCEL_PERF_WORKLOAD_SEQUENCE && status == 0) {
+		latency = spdk_get_ticks() - task->submit_tsc;
+		worker->seq_latency_ticks += latency;
+		if (worker->stats.executed == 0 || latency < worker->seq_latency_min) {
+			worker->seq_latency_min = latency;
+		}
+		worker->seq_latency_max = spdk_max(worker->seq_latency_max, latency);
+		worker->stats.executed++;
+	}
+
 	if (g_verify && status == 0) {
 		switch (worker->workload) {
 		case ACCEL_OPC_COPY_CRC32C:
@@ -647,6 +930,11 @@ accel_done(void *arg1, int status)
 				worker->xfer_failed++;
 			}
 			break;
+		case ACCEL_PERF_WORKLOAD_SEQUENCE:
+			if (_verify_sequence(task)) {
+				worker->xfer_failed++;
+			}
+			break;
 		default:
 			assert(false);
 			break;
@@ -681,6 +969,46 @@ accel_done(void *arg1, int status)
 	}
 }
 
+static void
+dump_sequence_result(void)
+{
+	struct worker_thread *worker;
+	uint64_t executed[ACCEL_OPC_LAST] = {};
+	uint64_t total_completed = 0, latency_ticks = 0, latency_min = UINT64_MAX, latency_max = 0;
+	size_t i;
+	enum accel_opcode opcode;
+
+	for (worker = g_workers; worker != NULL; worker = worker->next) {
+		for (i = 0; i < SPDK_COUNTOF(g_seq_op_names); i++) {
+			opcode = g_seq_op_names[i].opcode;
+			executed[opcode] += worker->seq_op_stats[opcode].executed;
+		}
+		if (worker->stats.executed == 0) {
+			continue;
+		}
+		total_completed += worker->stats.executed;
+		latency_ticks += worker->seq_latency_ticks;
+		latency_min = spdk_min(latency_min, worker->seq_latency_min);
+		latency_max = spdk_max(latency_max, worker->seq_latency_max);
+	}
+
+	if (total_completed > 0) {
+		printf("Sequence latency (us): avg %.2f, min %.2f, max %.2f\n",
+		       (double)latency_ticks * SPDK_SEC_TO_USEC / g_tsc_rate / total_completed,
+		       (double)latency_min * SPDK_SEC_TO_USEC / g_tsc_rate,
+		       (double)latency_max * SPDK_SEC_TO_USEC / g_tsc_rate);
+	}
+
+	printf("Operations executed:\n");
+	for (i = 0; i < SPDK_COUNTOF(g_seq_op_names); i++) {
+		opcode = g_seq_op_names[i].opcode;
+		if (executed[opcode] > 0) {
+			printf("  %-12s %" PRIu64 "\n", seq_op_name(opcode), executed[opcode]);
+		}
+	}
+	printf("\n");
+}
+
 static int
 dump_result(void)
 {
@@ -719,6 +1047,10 @@ dump_result(void)
 	printf("Total:%15" PRIu64 "/s%9" PRIu64 " MiB/s%6" PRIu64 " %11" PRIu64"\n\n",
 	       total_xfer_per_sec, total_bw_in_MiBps, total_failed, total_miscompared);
 
+	if (g_workload_selection == ACCEL_PERF_WORKLOAD_SEQUENCE) {
+		dump_sequence_result();
+	}
+
 	return total_failed ? 1 : 0;
 }
 
@@ -1145,7 +1477,7 @@ main(int argc, char **argv)
 	g_opts.name = "accel_perf";
 	g_opts.reactor_mask = "0x1";
 	g_opts.shutdown_cb = shutdown_cb;
-	if (spdk_app_parse_args(argc, argv, &g_opts, "a:C:o:q:t:yw:P:f:T:l:x:", NULL, parse_args,
+	if (spdk_app_parse_args(argc, argv, &g_opts, "a:C:o:q:t:yw:P:f:T:l:x:S:", NULL, parse_args,
 				usage) != SPDK_APP_PARSE_ARGS_SUCCESS) {
 		g_rc = -1;
 		goto cleanup;
@@ -1159,7 +1491,8 @@ main(int argc, char **argv)
 	    (g_workload_selection != ACCEL_OPC_COMPRESS) &&
 	    (g_workload_selection != ACCEL_OPC_DECOMPRESS) &&
 	    (g_workload_selection != ACCEL_OPC_DUALCAST) &&
-	    (g_workload_selection != ACCEL_OPC_XOR)) {
+	    (g_workload_selection != ACCEL_OPC_XOR) &&
+	    (g_workload_selection != ACCEL_PERF_WORKLOAD_SEQUENCE)) {
 		usage();
 		g_rc = -1;
 		goto cleanup;
@@ -1189,6 +1522,14 @@ main(int argc, char **argv)
 		goto cleanup;
 	}
 
+	if (g_workload_selection == ACCEL_PERF_WORKLOAD_SEQUENCE &&
+	    (g_seq_ops_count == 0 || g_chained_count == 0)) {
+		fprintf(stderr, "sequence workload requires operations to be specified with -S\n");
+		usage();
+		g_rc = -1;
+		goto cleanup;
+	}
+
 	g_rc = spdk_app_start(&g_opts, accel_perf_prep, NULL);
 	if (g_rc) {
 		SPDK_ERRLOG("ERROR starting application\n");
@@ -24,6 +24,8 @@
 #define BDEVPERF_CONFIG_MAX_FILENAME 1024
 #define BDEVPERF_CONFIG_UNDEFINED -1
 #define BDEVPERF_CONFIG_ERROR -2
+/* Maximum number of arrivals waiting for a free task in open-loop mode */
+#define BDEVPERF_BACKLOG_SIZE (64 * 1024)
 
 struct bdevperf_task {
 	struct iovec			iov;
@@ -32,8 +34,12 @@ struct bdevperf_task {
 	void				*buf;
 	void				*md_buf;
 	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
 	struct bdevperf_task		*task_to_abort;
 	enum spdk_bdev_io_type		io_type;
+	/* Time the I/O was scheduled to be issued at in open-loop mode */
+	uint64_t			arrival_tsc;
+	struct bdevperf_replay_io	*replay_io;
 	TAILQ_ENTRY(bdevperf_task)	link;
 	struct spdk_bdev_io_wait_entry	bdev_io_wait;
 };
@@ -70,11 +76,16 @@ static struct spdk_conf *g_bdevperf_conf = NULL;
 static const char *g_bdevperf_conf_file = NULL;
 static double g_zipf_theta;
 static bool g_random_map = false;
+static uint64_t g_arrival_rate = 0;
+static bool g_arrival_constant = false;
+static const char *g_replay_file = NULL;
+static bool g_replay_fast = false;
 
 static struct spdk_cpuset g_all_cpuset;
 static struct spdk_poller *g_perf_timer = NULL;
 
 static void bdevperf_submit_single(struct bdevperf_job *job, struct bdevperf_task *task);
+static void bdevperf_job_issue_backlog(struct bdevperf_job *job, struct bdevperf_task *task);
 static void rpc_perform_tests_cb(void);
 
 static uint32_t g_bdev_count = 0;
@@ -101,6 +112,26 @@ static const double g_latency_cutoffs[] = {
 	-1,
 };
 
+/* I/O read from the trace replayed by the replay workload */
+struct bdevperf_trace_io {
+	/* Time relative to the beginning of the trace */
+	uint64_t			time_ns;
+	uint64_t			offset;
+	uint64_t			length;
+	enum spdk_bdev_io_type		io_type;
+};
+
+static struct bdevperf_trace_io *g_trace_ios;
+static uint64_t g_trace_io_count;
+
+/* I/O of the trace within the LBA range of a job */
+struct bdevperf_replay_io {
+	uint64_t			time_tsc;
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+	enum spdk_bdev_io_type		io_type;
+};
+
 struct latency_info {
 	uint64_t	min;
 	uint64_t	max;
@@ -152,6 +183,35 @@ struct bdevperf_job {
 	/* keep channel's histogram data before being destroyed */
 	struct spdk_histogram_data	*histogram;
 	struct spdk_bit_array		*random_map;
+
+	/* Open-loop mode, I/Os are issued when they arrive, either at arrival_rate
+	 * per second or at the times of a replayed trace, instead of whenever a
+	 * previous one completes.  Arrivals that find queue_depth I/Os already
+	 * outstanding wait in the backlog, and their latency, recorded in histogram,
+	 * includes that wait. */
+	bool				open_loop;
+	uint64_t			arrival_rate;
+	double				next_arrival_tsc;
+	struct spdk_poller		*arrival_poller;
+	uint64_t			*backlog;
+	uint32_t			backlog_head;
+	uint32_t			backlog_count;
+	uint64_t			arrivals_dropped;
+
+	/* Replay workload, I/Os are issued in the order of the trace and, unless they're
+	 * replayed as fast as possible, at the time they were issued relative to the
+	 * beginning of the trace. */
+	struct bdevperf_replay_io	*replay_ios;
+	uint64_t			replay_count;
+	/* Index of the next I/O to arrive and to be submitted */
+	uint64_t			replay_next;
+	uint64_t			replay_submitted;
+	uint64_t			replay_start_tsc;
+	uint64_t			replay_avg_size;
+
+	/* Reads and writes of the initial I/O, submitted together with spdk_bdev_submit_batch() */
+	struct spdk_bdev_batch_request	*batch_reqs;
+	uint32_t			batch_count;
 };
 
 struct spdk_bdevperf {
@@ -176,6 +236,7 @@ enum job_config_rw {
 	JOB_CONFIG_RW_UNMAP,
 	JOB_CONFIG_RW_FLUSH,
 	JOB_CONFIG_RW_WRITE_ZEROES,
+	JOB_CONFIG_RW_REPLAY,
 };
 
 /* Storing values from a section of job config file */
@@ -293,6 +354,15 @@ performance_dump_job(struct bdevperf_aggregate_stats *stats, struct bdevperf_job
 		printf("\t Verification LBA range: start 0x%" PRIx64 " length 0x%" PRIx64 "\n",
 		       job->ios_base, job->size_in_ios);
 	}
+	if (job->arrival_rate != 0) {
+		printf("\t Open-loop arrival rate: %" PRIu64 " IO/s (%s), %" PRIu64 " arrivals not issued\n",
+		       job->arrival_rate, g_arrival_constant ? "constant" : "poisson", job->arrivals_dropped);
+	}
+	if (job->replay_ios != NULL) {
+		printf("\t Trace replay%s: %" PRIu64 " of %" PRIu64 " I/Os issued\n",
+		       g_replay_fast ? " (as fast as possible)" : "",
+		       job->replay_next - job->arrivals_dropped, job->replay_count);
+	}
 
 	if (g_performance_dump_active == true) {
 		/* Use job's actual run time as Job has ended */
@@ -312,7 +382,11 @@ performance_dump_job(struct bdevperf_aggregate_stats *stats, struct bdevperf_job
 	}
 
 	tsc_rate = spdk_get_ticks_hz();
-	mb_per_second = io_per_second * job->io_size / (1024 * 1024);
+	if (job->replay_ios != NULL) {
+		mb_per_second = io_per_second * job->replay_avg_size / (1024 * 1024);
+	} else {
+		mb_per_second = io_per_second * job->io_size / (1024 * 1024);
+	}
 
 	spdk_histogram_data_iterate(job->histogram, get_avg_latency, &latency_info);
 
@@ -461,6 +535,8 @@ static void
 bdevperf_job_free(struct bdevperf_job *job)
 {
 	spdk_histogram_data_free(job->histogram);
+	free(job->backlog);
+	free(job->replay_ios);
 	spdk_bit_array_free(&job->outstanding);
 	spdk_bit_array_free(&job->random_map);
 	spdk_zipf_free(&job->zipf);
@@ -662,9 +738,12 @@ bdevperf_job_empty(struct bdevperf_job *job)
 
 	end_tsc = spdk_get_ticks() - g_start_tsc;
 	job->run_time_in_usec = end_tsc * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
-	/* keep histogram info before channel is destroyed */
-	spdk_bdev_channel_get_histogram(job->ch, bdevperf_channel_get_histogram_cb,
-					job->histogram);
+	/* keep histogram info before channel is destroyed, in open-loop mode the
+	 * latencies were already recorded on completion */
+	if (!job->open_loop) {
+		spdk_bdev_channel_get_histogram(job->ch, bdevperf_channel_get_histogram_cb,
+						job->histogram);
+	}
 	spdk_put_io_channel(job->ch);
 	spdk_bdev_close(job->bdev_desc);
 	spdk_thread_send_msg(g_main_thread, bdevperf_job_end, NULL);
@@ -703,6 +782,12 @@ bdevperf_job_drain(void *ctx)
 	if (job->reset) {
 		spdk_poller_unregister(&job->reset_timer);
 	}
+	if (job->open_loop) {
+		spdk_poller_unregister(&job->arrival_poller);
+		/* Arrivals still waiting in the backlog won't be issued anymore */
+		job->arrivals_dropped += job->backlog_count;
+		job->backlog_count = 0;
+	}
 
 	job->is_draining = true;
 
@@ -767,14 +852,14 @@ bdevperf_verify_dif(struct bdevperf_task *task, struct iovec *iovs, int iovcnt)
 	}
 
 	if (spdk_bdev_is_md_interleaved(bdev)) {
-		rc = spdk_dif_verify(iovs, iovcnt, job->io_size_blocks, &dif_ctx, &err_blk);
+		rc = spdk_dif_verify(iovs, iovcnt, task->num_blocks, &dif_ctx, &err_blk);
 	} else {
 		struct iovec md_iov = {
 			.iov_base	= task->md_buf,
-			.iov_len	= spdk_bdev_get_md_size(bdev) * job->io_size_blocks,
+			.iov_len	= spdk_bdev_get_md_size(bdev) * task->num_blocks,
 		};
 
-		rc = spdk_dix_verify(iovs, iovcnt, &md_iov, job->io_size_blocks, &dif_ctx, &err_blk);
+		rc = spdk_dix_verify(iovs, iovcnt, &md_iov, task->num_blocks, &dif_ctx, &err_blk);
 	}
 
 	if (rc != 0) {
@@ -851,6 +936,10 @@ bdevperf_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 		job->io_failed++;
 	}
 
+	if (job->open_loop) {
+		spdk_histogram_data_tally(job->histogram, spdk_get_ticks() - task->arrival_tsc);
+	}
+
 	if (job->verify) {
 		assert(task->offset_blocks / job->io_size_blocks >= job->ios_base);
 		offset_in_ios = task->offset_blocks / job->io_size_blocks - job->ios_base;
@@ -867,10 +956,12 @@ bdevperf_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 	 * to complete.  In this case, do not submit a new I/O to replace
 	 * the one just completed.
 	 */
-	if (!job->is_draining) {
-		bdevperf_submit_single(job, task);
-	} else {
+	if (job->is_draining) {
 		bdevperf_end_task(task);
+	} else if (job->open_loop) {
+		bdevperf_job_issue_backlog(job, task);
+	} else {
+		bdevperf_submit_single(job, task);
 	}
 }
 
@@ -942,14 +1033,14 @@ bdevperf_generate_dif(struct bdevperf_task *task)
 	}
 
 	if (spdk_bdev_is_md_interleaved(bdev)) {
-		rc = spdk_dif_generate(&task->iov, 1, job->io_size_blocks, &dif_ctx);
+		rc = spdk_dif_generate(&task->iov, 1, task->num_blocks, &dif_ctx);
 	} else {
 		struct iovec md_iov = {
 			.iov_base	= task->md_buf,
-			.iov_len	= spdk_bdev_get_md_size(bdev) * job->io_size_blocks,
+			.iov_len	= spdk_bdev_get_md_size(bdev) * task->num_blocks,
 		};
 
-		rc = spdk_dix_generate(&task->iov, 1, &md_iov, job->io_size_blocks, &dif_ctx);
+		rc = spdk_dix_generate(&task->iov, 1, &md_iov, task->num_blocks, &dif_ctx);
 	}
 
 	if (rc != 0) {
@@ -959,6 +1050,24 @@ bdevperf_generate_dif(struct bdevperf_task *task)
 	return rc;
 }
 
+static void
+bdevperf_batch_task(struct bdevperf_job *job, struct bdevperf_task *task,
+		    spdk_bdev_io_completion_cb cb_fn)
+{
+	struct spdk_bdev_batch_request *req;
+
+	assert(job->batch_count < (uint32_t)job->queue_depth);
+	req = &job->batch_reqs[job->batch_count++];
+	req->type = task->io_type;
+	req->iovs = &task->iov;
+	req->iovcnt = 1;
+	req->md_buf = task->md_buf;
+	req->offset_blocks = task->offset_blocks;
+	req->num_blocks = task->num_blocks;
+	req->cb = cb_fn;
+	req->cb_arg = task;
+}
+
 static void
 bdevperf_submit_task(void *arg)
 {
@@ -984,35 +1093,41 @@ bdevperf_submit_task(void *arg)
 			if (g_zcopy) {
 				spdk_bdev_zcopy_end(task->bdev_io, true, cb_fn, task);
 				return;
+			} else if (job->batch_reqs != NULL) {
+				bdevperf_batch_task(job, task, cb_fn);
 			} else {
 				rc = spdk_bdev_writev_blocks_with_md(desc, ch, &task->iov, 1,
 								     task->md_buf,
 								     task->offset_blocks,
-								     job->io_size_blocks,
+								     task->num_blocks,
 								     cb_fn, task);
 			}
 		}
 		break;
 	case SPDK_BDEV_IO_TYPE_FLUSH:
 		rc = spdk_bdev_flush_blocks(desc, ch, task->offset_blocks,
-					    job->io_size_blocks, bdevperf_complete, task);
+					    task->num_blocks, bdevperf_complete, task);
 		break;
 	case SPDK_BDEV_IO_TYPE_UNMAP:
 		rc = spdk_bdev_unmap_blocks(desc, ch, task->offset_blocks,
-					    job->io_size_blocks, bdevperf_complete, task);
+					    task->num_blocks, bdevperf_complete, task);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
 		rc = spdk_bdev_write_zeroes_blocks(desc, ch, task->offset_blocks,
-						   job->io_size_blocks, bdevperf_complete, task);
+						   task->num_blocks, bdevperf_complete, task);
 		break;
 	case SPDK_BDEV_IO_TYPE_READ:
 		if (g_zcopy) {
-			rc = spdk_bdev_zcopy_start(desc, ch, NULL, 0, task->offset_blocks, job->io_size_blocks,
+			rc = spdk_bdev_zcopy_start(desc, ch, NULL, 0, task->offset_blocks, task->num_blocks,
 						   true, bdevperf_zcopy_populate_complete, task);
+		} else if (job->batch_reqs != NULL) {
+			task->iov.iov_base = task->buf;
+			task->iov.iov_len = task->num_blocks * spdk_bdev_get_block_size(job->bdev);
+			bdevperf_batch_task(job, task, bdevperf_complete);
 		} else {
 			rc = spdk_bdev_read_blocks_with_md(desc, ch, task->buf, task->md_buf,
 							   task->offset_blocks,
-							   job->io_size_blocks,
+							   task->num_blocks,
 							   bdevperf_complete, task);
 		}
 		break;
@@ -1090,7 +1205,7 @@ bdevperf_prep_zcopy_write_task(void *arg)
 	int			rc;
 
 	rc = spdk_bdev_zcopy_start(job->bdev_desc, job->ch, NULL, 0,
-				   task->offset_blocks, job->io_size_blocks,
+				   task->offset_blocks, task->num_blocks,
 				   false, bdevperf_zcopy_get_buf_complete, task);
 	if (rc != 0) {
 		assert(rc == -ENOMEM);
@@ -1116,6 +1231,14 @@ bdevperf_job_get_task(struct bdevperf_job *job)
 	return task;
 }
 
+static void
+bdevperf_job_replay_done(struct bdevperf_job *job, struct bdevperf_task *task)
+{
+	/* The whole trace was issued, end the job without waiting for the run timer */
+	bdevperf_job_drain(job);
+	bdevperf_end_task(task);
+}
+
 static void
 bdevperf_submit_single(struct bdevperf_job *job, struct bdevperf_task *task)
 {
@@ -1123,6 +1246,28 @@ bdevperf_submit_single(struct bdevperf_job *job, struct bdevperf_task *task)
 	uint64_t rand_value;
 	uint32_t first_clear;
 
+	if (job->replay_ios != NULL) {
+		if (!job->open_loop) {
+			if (job->replay_next == job->replay_count) {
+				bdevperf_job_replay_done(job, task);
+				return;
+			}
+			task->replay_io = &job->replay_ios[job->replay_next++];
+		}
+
+		task->offset_blocks = task->replay_io->offset_blocks;
+		task->num_blocks = task->replay_io->num_blocks;
+		task->io_type = task->replay_io->io_type;
+		task->iov.iov_base = task->buf;
+		task->iov.iov_len = task->num_blocks * spdk_bdev_get_block_size(job->bdev);
+		if (g_zcopy && task->io_type == SPDK_BDEV_IO_TYPE_WRITE) {
+			bdevperf_prep_zcopy_write_task(task);
+		} else {
+			bdevperf_submit_task(task);
+		}
+		return;
+	}
+
 	if (job->zipf) {
 		offset_in_ios = spdk_zipf_generate(job->zipf);
 	} else if (job->is_random) {
@@ -1185,6 +1330,7 @@ bdevperf_submit_single(struct bdevperf_job *job, struct bdevperf_task *task)
 	 * is absolute (entire bdev LBA range).
 	 */
 	task->offset_blocks = (offset_in_ios + job->ios_base) * job->io_size_blocks;
+	task->num_blocks = job->io_size_blocks;
 
 	if (job->verify || job->reset) {
 		generate_data(task->buf, job->buf_size,
@@ -1222,6 +1368,108 @@ bdevperf_submit_single(struct bdevperf_job *job, struct bdevperf_task *task)
 	bdevperf_submit_task(task);
 }
 
+static double
+bdevperf_job_get_interarrival(struct bdevperf_job *job)
+{
+	double mean = (double)spdk_get_ticks_hz() / job->arrival_rate;
+
+	if (g_arrival_constant) {
+		return mean;
+	}
+
+	/* Exponentially distributed inter-arrival times make a Poisson arrival process */
+	return -log((rand_r(&job->seed) + 1.0) / ((double)RAND_MAX + 1.0)) * mean;
+}
+
+/* Submit an I/O that arrived, for the replay workload arrival is the index of the
+ * I/O in the trace, otherwise it's the time the I/O arrived at. */
+static void
+bdevperf_job_submit_arrival(struct bdevperf_job *job, struct bdevperf_task *task, uint64_t arrival)
+{
+	if (job->replay_ios != NULL) {
+		task->replay_io = &job->replay_ios[arrival];
+		task->arrival_tsc = job->replay_start_tsc + task->replay_io->time_tsc;
+	} else {
+		task->arrival_tsc = arrival;
+	}
+
+	bdevperf_submit_single(job, task);
+}
+
+static void
+bdevperf_job_issue_backlog(struct bdevperf_job *job, struct bdevperf_task *task)
+{
+	uint64_t arrival;
+
+	if (job->backlog_count == 0) {
+		if (job->replay_ios != NULL && job->replay_next == job->replay_count &&
+		    job->current_queue_depth == 0) {
+			bdevperf_job_replay_done(job, task);
+		} else {
+			TAILQ_INSERT_TAIL(&job->task_list, task, link);
+		}
+		return;
+	}
+
+	arrival = job->backlog[job->backlog_head];
+	job->backlog_head = (job->backlog_head + 1) % BDEVPERF_BACKLOG_SIZE;
+	job->backlog_count--;
+
+	bdevperf_job_submit_arrival(job, task, arrival);
+}
+
+static uint64_t
+bdevperf_job_next_arrival(struct bdevperf_job *job)
+{
+	uint64_t arrival;
+
+	if (job->replay_ios == NULL) {
+		arrival = (uint64_t)job->next_arrival_tsc;
+		job->next_arrival_tsc += bdevperf_job_get_interarrival(job);
+		return arrival;
+	}
+
+	arrival = job->replay_next++;
+	if (job->replay_next < job->replay_count) {
+		job->next_arrival_tsc = job->replay_start_tsc + job->replay_ios[job->replay_next].time_tsc;
+	} else {
+		job->next_arrival_tsc = INFINITY;
+	}
+
+	return arrival;
+}
+
+static int
+bdevperf_job_arrival(void *ctx)
+{
+	struct bdevperf_job *job = ctx;
+	struct bdevperf_task *task;
+	uint64_t now, arrival;
+	int count = 0;
+
+	now = spdk_get_ticks();
+	while (job->next_arrival_tsc <= now) {
+		arrival = bdevperf_job_next_arrival(job);
+		count++;
+
+		task = TAILQ_FIRST(&job->task_list);
+		if (job->backlog_count == 0 && job->current_queue_depth < job->queue_depth && task != NULL) {
+			TAILQ_REMOVE(&job->task_list, task, link);
+			bdevperf_job_submit_arrival(job, task, arrival);
+			if (job->is_draining) {
+				break;
+			}
+		} else if (job->backlog_count < BDEVPERF_BACKLOG_SIZE) {
+			job->backlog[(job->backlog_head + job->backlog_count) % BDEVPERF_BACKLOG_SIZE] = arrival;
+			job->backlog_count++;
+		} else {
+			job->arrivals_dropped++;
+		}
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
 static int reset_job(void *arg);
 
 static void
@@ -1289,6 +1537,28 @@ bdevperf_timeout_cb(void *cb_arg, struct spdk_bdev_io *bdev_io)
 	bdevperf_submit_task(task);
 }
 
+static void
+bdevperf_job_submit_batch(struct bdevperf_job *job)
+{
+	struct spdk_bdev_batch_request *reqs = job->batch_reqs;
+	uint32_t count = job->batch_count, num_submitted = 0, i;
+
+	job->batch_reqs = NULL;
+	job->batch_count = 0;
+
+	if (count > 0) {
+		spdk_bdev_submit_batch(job->bdev_desc, job->ch, reqs, count, &num_submitted);
+	}
+
+	/* Submit the rest one by one, which waits for a bdev_io on -ENOMEM or ends the job */
+	for (i = num_submitted; i < count; i++) {
+		job->current_queue_depth--;
+		bdevperf_submit_task(reqs[i].cb_arg);
+	}
+
+	free(reqs);
+}
+
 static void
 bdevperf_job_run(void *ctx)
 {
@@ -1308,10 +1578,31 @@ bdevperf_job_run(void *ctx)
 
 	spdk_bdev_set_timeout(job->bdev_desc, g_timeout_in_sec, bdevperf_timeout_cb, job);
 
-	for (i = 0; i < job->queue_depth; i++) {
+	if (job->replay_ios != NULL && job->replay_count == 0) {
+		bdevperf_job_drain_timer(job);
+		return;
+	}
+
+	if (job->open_loop) {
+		/* I/Os are submitted by the arrival poller, independently of completions */
+		job->next_arrival_tsc = spdk_get_ticks();
+		if (job->replay_ios != NULL) {
+			job->replay_start_tsc = spdk_get_ticks();
+			job->next_arrival_tsc = job->replay_start_tsc + job->replay_ios[0].time_tsc;
+		}
+		job->arrival_poller = SPDK_POLLER_REGISTER(bdevperf_job_arrival, job, 0);
+		return;
+	}
+
+	/* If the array can't be allocated, the I/O is submitted one by one */
+	job->batch_reqs = calloc(job->queue_depth, sizeof(*job->batch_reqs));
+
+	for (i = 0; i < job->queue_depth && !job->is_draining; i++) {
 		task = bdevperf_job_get_task(job);
 		bdevperf_submit_single(job, task);
 	}
+
+	bdevperf_job_submit_batch(job);
 }
 
 static void
@@ -1634,9 +1925,69 @@ job_init_rw(struct bdevperf_job *job, enum job_config_rw rw)
 	case JOB_CONFIG_RW_WRITE_ZEROES:
 		job->write_zeroes = true;
 		break;
+	case JOB_CONFIG_RW_REPLAY:
+		/* Unless it's replayed as fast as possible, the trace is replayed open-loop */
+		job->open_loop = !g_replay_fast;
+		break;
 	}
 }
 
+/* Pick the I/Os of the trace within the LBA range of the job */
+static int
+bdevperf_job_init_replay(struct bdevperf_job *job)
+{
+	struct bdevperf_trace_io *trace_io;
+	struct bdevperf_replay_io *replay_io;
+	uint32_t block_size, data_block_size;
+	uint64_t range_start, range_end, max_blocks = 0, total_size = 0, i;
+
+	block_size = spdk_bdev_get_block_size(job->bdev);
+	data_block_size = spdk_bdev_get_data_block_size(job->bdev);
+	range_start = job->ios_base * job->io_size_blocks;
+	range_end = range_start + job->size_in_ios * job->io_size_blocks;
+
+	job->replay_ios = calloc(spdk_max(g_trace_io_count, 1), sizeof(*job->replay_ios));
+	if (job->replay_ios == NULL) {
+		fprintf(stderr, "Unable to allocate memory for the trace replay.\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < g_trace_io_count; i++) {
+		trace_io = &g_trace_ios[i];
+		if (trace_io->length == 0 || trace_io->offset % data_block_size != 0 ||
+		    trace_io->length % data_block_size != 0) {
+			continue;
+		}
+
+		replay_io = &job->replay_ios[job->replay_count];
+		replay_io->offset_blocks = trace_io->offset / data_block_size;
+		replay_io->num_blocks = trace_io->length / data_block_size;
+		if (replay_io->offset_blocks < range_start ||
+		    replay_io->offset_blocks + replay_io->num_blocks > range_end) {
+			continue;
+		}
+
+		replay_io->time_tsc = (double)trace_io->time_ns * spdk_get_ticks_hz() / SPDK_SEC_TO_NSEC;
+		replay_io->io_type = trace_io->io_type;
+		if (replay_io->io_type == SPDK_BDEV_IO_TYPE_READ ||
+		    replay_io->io_type == SPDK_BDEV_IO_TYPE_WRITE) {
+			max_blocks = spdk_max(max_blocks, replay_io->num_blocks);
+		}
+		total_size += trace_io->length;
+		job->replay_count++;
+	}
+
+	if (job->replay_count == 0) {
+		SPDK_WARNLOG("No I/O of the trace falls within the LBA range of job %s\n", job->name);
+		return 0;
+	}
+
+	job->replay_avg_size = total_size / job->replay_count;
+	job->buf_size = spdk_max(job->buf_size, max_blocks * block_size);
+
+	return 0;
+}
+
 static int
 bdevperf_construct_job(struct spdk_bdev *bdev, struct job_config *config,
 		       struct spdk_thread *thread)
@@ -1672,8 +2023,21 @@ bdevperf_construct_job(struct spdk_bdev *bdev, struct job_config *config,
 	job->io_size_blocks = job->io_size / data_block_size;
 	job->buf_size = job->io_size_blocks * block_size;
 	job->abort = g_abort;
+	job->arrival_rate = g_arrival_rate;
+	job->open_loop = g_arrival_rate != 0;
 	job_init_rw(job, config->rw);
 
+	if (job->arrival_rate != 0 && (job->verify || job->reset || config->rw == JOB_CONFIG_RW_REPLAY)) {
+		fprintf(stderr, "Open-loop mode (-O) is not supported with verify, reset or replay workloads.\n");
+		bdevperf_job_free(job);
+		return -ENOTSUP;
+	}
+	if (config->rw == JOB_CONFIG_RW_REPLAY && g_trace_ios == NULL) {
+		fprintf(stderr, "Replay workload requires a trace (-I).\n");
+		bdevperf_job_free(job);
+		return -EINVAL;
+	}
+
 	if ((job->io_size % data_block_size) != 0) {
 		SPDK_ERRLOG("IO size (%d) is not multiples of data block size of bdev %s (%"PRIu32")\n",
 			    job->io_size, spdk_bdev_get_name(bdev), data_block_size);
@@ -1710,6 +2074,14 @@ bdevperf_construct_job(struct spdk_bdev *bdev, struct job_config *config,
 		job->zipf = spdk_zipf_create(job->size_in_ios, g_zipf_theta, 0);
 	}
 
+	if (config->rw == JOB_CONFIG_RW_REPLAY) {
+		rc = bdevperf_job_init_replay(job);
+		if (rc != 0) {
+			bdevperf_job_free(job);
+			return rc;
+		}
+	}
+
 	if (job->verify) {
 		if (job->size_in_ios >= UINT32_MAX) {
 			SPDK_ERRLOG("Due to constraints of verify operation, the job storage capacity is too large\n");
@@ -1741,6 +2113,15 @@ bdevperf_construct_job(struct spdk_bdev *bdev, struct job_config *config,
 
 	TAILQ_INIT(&job->task_list);
 
+	if (job->open_loop) {
+		job->backlog = calloc(BDEVPERF_BACKLOG_SIZE, sizeof(*job->backlog));
+		if (job->backlog == NULL) {
+			fprintf(stderr, "Failed to allocate open-loop backlog\n");
+			bdevperf_job_free(job);
+			return -ENOMEM;
+		}
+	}
+
 	if (g_random_map) {
 		if (job->size_in_ios >= UINT32_MAX) {
 			SPDK_ERRLOG("Due to constraints of the random map, the job storage capacity is too large\n");
@@ -1784,7 +2165,7 @@ bdevperf_construct_job(struct spdk_bdev *bdev, struct job_config *config,
 		}
 
 		if (spdk_bdev_is_md_separate(job->bdev)) {
-			task->md_buf = spdk_zmalloc(job->io_size_blocks *
+			task->md_buf = spdk_zmalloc(job->buf_size / block_size *
 						    spdk_bdev_get_md_size(job->bdev), 0, NULL,
 						    SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
 			if (!task->md_buf) {
@@ -1839,9 +2220,11 @@ parse_rw(const char *str, enum job_config_rw ret)
 		ret = JOB_CONFIG_RW_RW;
 	} else if (!strcmp(str, "randrw")) {
 		ret = JOB_CONFIG_RW_RANDRW;
+	} else if (!strcmp(str, "replay")) {
+		ret = JOB_CONFIG_RW_REPLAY;
 	} else {
 		fprintf(stderr, "rw must be one of\n"
-			"(read, write, randread, randwrite, rw, randrw, verify, reset, unmap, flush)\n");
+			"(read, write, randread, randwrite, rw, randrw, verify, reset, unmap, flush, replay)\n");
 		ret = BDEVPERF_CONFIG_ERROR;
 	}
 
@@ -2459,6 +2842,12 @@ bdevperf_parse_arg(int ch, char *arg)
 		g_random_map = true;
 	} else if (ch == 'E') {
 		g_one_thread_per_lcore = true;
+	} else if (ch == 'U') {
+		g_arrival_constant = true;
+	} else if (ch == 'I') {
+		g_replay_file = optarg;
+	} else if (ch == 'N') {
+		g_replay_fast = true;
 	} else {
 		tmp = spdk_strtoll(optarg, 10);
 		if (tmp < 0) {
@@ -2493,6 +2882,9 @@ bdevperf_parse_arg(int ch, char *arg)
 			g_show_performance_real_time = 1;
 			g_show_performance_period_in_usec = tmp * SPDK_SEC_TO_USEC;
 			break;
+		case 'O':
+			g_arrival_rate = tmp;
+			break;
 		default:
 			return -EINVAL;
 		}
@@ -2505,7 +2897,7 @@ bdevperf_usage(void)
 {
 	printf(" -q <depth>                io depth\n");
 	printf(" -o <size>                 io size in bytes\n");
-	printf(" -w <type>                 io pattern type, must be one of (read, write, randread, randwrite, rw, randrw, verify, reset, unmap, flush)\n");
+	printf(" -w <type>                 io pattern type, must be one of (read, write, randread, randwrite, rw, randrw, verify, reset, unmap, flush, replay)\n");
 	printf(" -t <time>                 time in seconds\n");
 	printf(" -k <timeout>              timeout in seconds to detect starved I/O (default is 0 and disabled)\n");
 	printf(" -M <percent>              rwmixread (100 for reads, 0 for writes)\n");
@@ -2525,6 +2917,104 @@ bdevperf_usage(void)
 	printf(" -l                        display latency histogram, default: disable. -l display summary, -ll display details\n");
 	printf(" -D                        use a random map for picking offsets not previously read or written (for all jobs)\n");
 	printf(" -E                        share per lcore thread among jobs. Available only if -j is not used.\n");
+	printf(" -O <iops>                 open-loop mode, issue I/O at <iops> per job regardless of completions\n");
+	printf("\t\t(-q limits the outstanding I/O, latency includes the time spent waiting for it)\n");
+	printf(" -U                        use constant instead of poisson distributed arrivals (only valid with -O)\n");
+	printf(" -I <filename>             I/O trace to replay with the replay workload\n");
+	printf("\t\t(one I/O per line: <time in us> <read|write|unmap|flush|write_zeroes> <offset> <length>)\n");
+	printf(" -N                        replay the trace as fast as possible instead of at its original timing\n");
+}
+
+static int
+parse_trace_io_type(const char *str, enum spdk_bdev_io_type *io_type)
+{
+	if (!strcmp(str, "read")) {
+		*io_type = SPDK_BDEV_IO_TYPE_READ;
+	} else if (!strcmp(str, "write")) {
+		*io_type = SPDK_BDEV_IO_TYPE_WRITE;
+	} else if (!strcmp(str, "unmap")) {
+		*io_type = SPDK_BDEV_IO_TYPE_UNMAP;
+	} else if (!strcmp(str, "flush")) {
+		*io_type = SPDK_BDEV_IO_TYPE_FLUSH;
+	} else if (!strcmp(str, "write_zeroes")) {
+		*io_type = SPDK_BDEV_IO_TYPE_WRITE_ZEROES;
+	} else {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int
+bdevperf_load_trace(const char *filename)
+{
+	struct bdevperf_trace_io *trace_io, *tmp;
+	uint64_t count = 0, size = 0, lineno = 0, prev_time_ns = 0;
+	char line[256], type[32];
+	double time_us;
+	FILE *file;
+	int rc = 0;
+
+	file = fopen(filename, "r");
+	if (file == NULL) {
+		fprintf(stderr, "Unable to open trace %s: %s\n", filename, spdk_strerror(errno));
+		return -errno;
+	}
+
+	while (fgets(line, sizeof(line), file) != NULL) {
+		lineno++;
+		if (line[0] == '#' || line[0] == '\n') {
+			continue;
+		}
+
+		if (count == size) {
+			size = spdk_max(size * 2, 1024);
+			tmp = realloc(g_trace_ios, size * sizeof(*g_trace_ios));
+			if (tmp == NULL) {
+				fprintf(stderr, "Unable to allocate memory for the trace.\n");
+				rc = -ENOMEM;
+				break;
+			}
+			g_trace_ios = tmp;
+		}
+
+		trace_io = &g_trace_ios[count];
+		if (sscanf(line, "%lf %31s %" SCNu64 " %" SCNu64, &time_us, type,
+			   &trace_io->offset, &trace_io->length) != 4 || time_us < 0 ||
+		    parse_trace_io_type(type, &trace_io->io_type) != 0) {
+			fprintf(stderr, "Invalid I/O at line %" PRIu64 " of trace %s\n", lineno, filename);
+			rc = -EINVAL;
+			break;
+		}
+
+		trace_io->time_ns = time_us * 1000;
+		if (trace_io->time_ns < prev_time_ns) {
+			fprintf(stderr, "I/O at line %" PRIu64 " of trace %s is out of order\n", lineno, filename);
+			rc = -EINVAL;
+			break;
+		}
+
+		prev_time_ns = trace_io->time_ns;
+		count++;
+	}
+
+	fclose(file);
+	if (rc != 0) {
+		free(g_trace_ios);
+		g_trace_ios = NULL;
+		return rc;
+	}
+
+	if (count == 0) {
+		fprintf(stderr, "Trace %s doesn't contain any I/O\n", filename);
+		free(g_trace_ios);
+		g_trace_ios = NULL;
+		return -EINVAL;
+	}
+
+	g_trace_io_count = count;
+
+	return 0;
 }
 
 static int
@@ -2569,6 +3059,26 @@ verify_test_params(struct spdk_app_opts *opts)
 		return 1;
 	}
 
+	if (g_arrival_constant && g_arrival_rate == 0) {
+		fprintf(stderr, "-U option must be specified with -O option\n");
+		return 1;
+	}
+
+	if (g_replay_fast && g_replay_file == NULL) {
+		fprintf(stderr, "-N option must be specified with -I option\n");
+		return 1;
+	}
+
+	if (g_replay_file != NULL && bdevperf_load_trace(g_replay_file) != 0) {
+		return 1;
+	}
+
+	if ((g_arrival_rate != 0 || (g_replay_file != NULL && !g_replay_fast)) &&
+	    g_latency_display_level == 0) {
+		/* Latency percentiles are the point of an open-loop run */
+		g_latency_display_level = 1;
+	}
+
 	if (g_io_size > SPDK_BDEV_LARGE_BUF_MAX_SIZE) {
 		printf("I/O size of %d is greater than zero copy threshold (%d).\n",
 		       g_io_size, SPDK_BDEV_LARGE_BUF_MAX_SIZE);
@@ -2651,7 +3161,7 @@ main(int argc, char **argv)
 	opts.rpc_addr = NULL;
 	opts.shutdown_cb = spdk_bdevperf_shutdown_cb;
 
-	if ((rc = spdk_app_parse_args(argc, argv, &opts, "Zzfq:o:t:w:k:CEF:M:P:S:T:Xlj:D", NULL,
+	if ((rc = spdk_app_parse_args(argc, argv, &opts, "Zzfq:o:t:w:k:CEF:I:M:NO:P:S:T:UXlj:D", NULL,
 				      bdevperf_parse_arg, bdevperf_usage)) !=
 	    SPDK_APP_PARSE_ARGS_SUCCESS) {
 		return rc;
@@ -2671,5 +3181,6 @@ main(int argc, char **argv)
 
 	spdk_app_fini();
 	free_job_config();
+	free(g_trace_ios);
 	return rc;
 }
@@ -0,0 +1,635 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/assert.h"
+#include "spdk/bdev.h"
+#include "spdk/blob.h"
+#include "spdk/blob_bdev.h"
+#include "spdk/env.h"
+#include "spdk/event.h"
+#include "spdk/log.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+static char *g_bdev_name;
+static uint32_t g_num_blobs = 16;
+static uint64_t g_blob_size = 64 * 1024 * 1024;
+static uint32_t g_io_size = 64 * 1024;
+static uint32_t g_queue_depth = 32;
+static uint32_t g_cluster_size;
+
+/*
+ * The benchmark goes through these phases in order, each one measuring a single kind of
+ * operation on all the blobs.
+ */
+enum perf_phase {
+	PERF_PHASE_INIT,
+	PERF_PHASE_CREATE,
+	PERF_PHASE_OPEN,
+	PERF_PHASE_SYNC_MD,
+	PERF_PHASE_FIRST_WRITE,
+	PERF_PHASE_OVERWRITE,
+	PERF_PHASE_SNAPSHOT,
+	PERF_PHASE_CLONE,
+	PERF_PHASE_COW_WRITE,
+	PERF_PHASE_CLOSE,
+	PERF_PHASE_UNLOAD,
+	PERF_PHASE_LOAD,
+	PERF_PHASE_REOPEN,
+	PERF_PHASE_COUNT,
+};
+
+static const struct {
+	const char	*name;
+	/* Data written to the blobs rather than metadata operations */
+	bool		io;
+	/* Done once for the blobstore rather than for each blob */
+	bool		once;
+} g_phases[] = {
+	[PERF_PHASE_INIT] = { "init", false, true },
+	[PERF_PHASE_CREATE] = { "create", false, false },
+	[PERF_PHASE_OPEN] = { "open", false, false },
+	[PERF_PHASE_SYNC_MD] = { "sync_md", false, false },
+	[PERF_PHASE_FIRST_WRITE] = { "first_write", true, false },
+	[PERF_PHASE_OVERWRITE] = { "overwrite", true, false },
+	[PERF_PHASE_SNAPSHOT] = { "snapshot", false, false },
+	[PERF_PHASE_CLONE] = { "clone", false, false },
+	[PERF_PHASE_COW_WRITE] = { "cow_write", true, false },
+	[PERF_PHASE_CLOSE] = { "close", false, false },
+	[PERF_PHASE_UNLOAD] = { "unload", false, true },
+	[PERF_PHASE_LOAD] = { "load", false, true },
+	[PERF_PHASE_REOPEN] = { "reopen", false, false },
+};
+SPDK_STATIC_ASSERT(SPDK_COUNTOF(g_phases) == PERF_PHASE_COUNT, "Incorrect number of phases");
+
+struct perf_blob {
+	spdk_blob_id		id;
+	spdk_blob_id		snapshot_id;
+	spdk_blob_id		clone_id;
+	struct spdk_blob	*blob;
+};
+
+struct perf_context {
+	struct spdk_bdev		*bdev;
+	struct spdk_blob_store		*bs;
+	struct spdk_io_channel		*channel;
+	struct perf_blob		*blobs;
+	uint8_t				*buf;
+	uint64_t			io_unit_size;
+	uint64_t			cluster_size;
+	uint64_t			blob_size;
+
+	enum perf_phase			phase;
+	bool				phase_running;
+	/* Blob the next operation or I/O of the phase is done on */
+	uint32_t			blob_index;
+	/* Offset of the next I/O within that blob and distance between two I/Os, in io units */
+	uint64_t			io_offset;
+	uint64_t			io_stride;
+	uint32_t			io_outstanding;
+
+	/* Statistics of the current phase */
+	uint64_t			tsc_rate;
+	uint64_t			start_tsc;
+	uint64_t			end_tsc;
+	uint64_t			op_start_tsc;
+	uint64_t			ops;
+	uint64_t			bytes;
+	uint64_t			total_latency_tsc;
+	uint64_t			min_latency_tsc;
+	uint64_t			max_latency_tsc;
+	/* Bytes written to the base bdev before the phase started */
+	uint64_t			dev_bytes_written;
+	struct spdk_bdev_io_stat	dev_stat;
+	int				rc;
+};
+
+static void perf_run_phase(struct perf_context *ctx);
+static void perf_next_op(struct perf_context *ctx);
+static void perf_cleanup(struct perf_context *ctx);
+
+static void
+blob_perf_usage(void)
+{
+	printf(" -b bdev       name of the bdev to run the blobstore on, its data is lost\n");
+	printf(" -C size       cluster size in bytes (default: blobstore default)\n");
+	printf(" -N count      number of blobs (default 16)\n");
+	printf(" -o size       I/O size in bytes (default 65536)\n");
+	printf(" -q depth      I/O queue depth (default 32)\n");
+	printf(" -S size       size of each blob in MiB (default 64)\n");
+}
+
+static int
+blob_perf_parse_arg(int ch, char *arg)
+{
+	long val;
+
+	if (ch == 'b') {
+		g_bdev_name = arg;
+		return 0;
+	}
+
+	val = spdk_strtol(arg, 10);
+	if (val <= 0) {
+		fprintf(stderr, "Invalid value of -%c: %s\n", ch, arg);
+		return -EINVAL;
+	}
+
+	switch (ch) {
+	case 'C':
+		g_cluster_size = val;
+		break;
+	case 'N':
+		g_num_blobs = val;
+		break;
+	case 'o':
+		g_io_size = val;
+		break;
+	case 'q':
+		g_queue_depth = val;
+		break;
+	case 'S':
+		g_blob_size = (uint64_t)val * 1024 * 1024;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+base_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev, void *event_ctx)
+{
+	SPDK_WARNLOG("Unsupported bdev event: type %d\n", type);
+}
+
+static void
+perf_print_phase(struct perf_context *ctx, uint64_t dev_bytes_written)
+{
+	double seconds = (double)(ctx->end_tsc - ctx->start_tsc) / ctx->tsc_rate;
+	double usec_per_tsc = (double)SPDK_SEC_TO_USEC / ctx->tsc_rate;
+
+	printf("%-12s %8" PRIu64 " %12.2f", g_phases[ctx->phase].name, ctx->ops,
+	       seconds > 0 ? ctx->ops / seconds : 0);
+
+	if (g_phases[ctx->phase].io) {
+		printf(" %10.2f MiB/s %35s %10.2f\n",
+		       seconds > 0 ? ctx->bytes / seconds / (1024 * 1024) : 0, "",
+		       ctx->bytes ? (double)dev_bytes_written / ctx->bytes : 0);
+	} else {
+		printf(" %16s %11.2f %11.2f %11.2f %10.2f KiB/op\n", "",
+		       ctx->ops ? ctx->total_latency_tsc * usec_per_tsc / ctx->ops : 0,
+		       ctx->min_latency_tsc * usec_per_tsc, ctx->max_latency_tsc * usec_per_tsc,
+		       ctx->ops ? (double)dev_bytes_written / ctx->ops / 1024 : 0);
+	}
+}
+
+static void
+perf_dev_stat_done(struct spdk_bdev *bdev, struct spdk_bdev_io_stat *stat, void *cb_arg, int rc)
+{
+	struct perf_context *ctx = cb_arg;
+
+	if (rc != 0) {
+		SPDK_WARNLOG("Unable to get the statistics of %s: %s\n", g_bdev_name,
+			     spdk_strerror(-rc));
+		stat->bytes_written = ctx->dev_bytes_written;
+	}
+
+	if (ctx->phase_running) {
+		perf_print_phase(ctx, stat->bytes_written - ctx->dev_bytes_written);
+		ctx->phase_running = false;
+		ctx->phase++;
+	}
+
+	ctx->dev_bytes_written = stat->bytes_written;
+	perf_run_phase(ctx);
+}
+
+static void
+perf_end_phase(struct perf_context *ctx)
+{
+	ctx->end_tsc = spdk_get_ticks();
+	spdk_bdev_get_device_stat(ctx->bdev, &ctx->dev_stat, perf_dev_stat_done, ctx);
+}
+
+static void
+perf_op_done(struct perf_context *ctx, int bserrno)
+{
+	uint64_t latency = spdk_get_ticks() - ctx->op_start_tsc;
+
+	if (bserrno != 0) {
+		SPDK_ERRLOG("%s of blob %" PRIu32 " failed: %s\n", g_phases[ctx->phase].name,
+			    ctx->blob_index, spdk_strerror(-bserrno));
+		ctx->rc = bserrno;
+		perf_cleanup(ctx);
+		return;
+	}
+
+	ctx->ops++;
+	ctx->total_latency_tsc += latency;
+	ctx->min_latency_tsc = spdk_min(ctx->min_latency_tsc, latency);
+	ctx->max_latency_tsc = spdk_max(ctx->max_latency_tsc, latency);
+
+	ctx->blob_index++;
+	perf_next_op(ctx);
+}
+
+static void
+perf_op_complete(void *cb_arg, int bserrno)
+{
+	perf_op_done(cb_arg, bserrno);
+}
+
+static void
+perf_init_complete(void *cb_arg, struct spdk_blob_store *bs, int bserrno)
+{
+	struct perf_context *ctx = cb_arg;
+
+	if (bserrno == 0) {
+		ctx->bs = bs;
+	}
+
+	perf_op_done(ctx, bserrno);
+}
+
+static void
+perf_blob_id_complete(void *cb_arg, spdk_blob_id blobid, int bserrno)
+{
+	struct perf_context *ctx = cb_arg;
+	struct perf_blob *pblob = &ctx->blobs[ctx->blob_index];
+
+	switch (ctx->phase) {
+	case PERF_PHASE_CREATE:
+		pblob->id = blobid;
+		break;
+	case PERF_PHASE_SNAPSHOT:
+		pblob->snapshot_id = blobid;
+		break;
+	case PERF_PHASE_CLONE:
+		pblob->clone_id = blobid;
+		break;
+	default:
+		assert(false);
+		break;
+	}
+
+	perf_op_done(ctx, bserrno);
+}
+
+static void
+perf_open_complete(void *cb_arg, struct spdk_blob *blob, int bserrno)
+{
+	struct perf_context *ctx = cb_arg;
+
+	if (bserrno == 0) {
+		ctx->blobs[ctx->blob_index].blob = blob;
+	}
+
+	perf_op_done(ctx, bserrno);
+}
+
+static void
+perf_unload_complete(void *cb_arg, int bserrno)
+{
+	struct perf_context *ctx = cb_arg;
+
+	ctx->bs = NULL;
+	perf_op_done(ctx, bserrno);
+}
+
+static void
+perf_close_complete(void *cb_arg, int bserrno)
+{
+	struct perf_context *ctx = cb_arg;
+
+	ctx->blobs[ctx->blob_index].blob = NULL;
+	perf_op_done(ctx, bserrno);
+}
+
+static int
+perf_setup_io(struct perf_context *ctx)
+{
+	ctx->io_unit_size = spdk_bs_get_io_unit_size(ctx->bs);
+	ctx->cluster_size = spdk_bs_get_cluster_size(ctx->bs);
+	ctx->blob_size = SPDK_ALIGN_CEIL(g_blob_size, ctx->cluster_size);
+
+	if (g_io_size % ctx->io_unit_size != 0 || g_io_size > ctx->cluster_size) {
+		SPDK_ERRLOG("I/O size needs to be a multiple of %" PRIu64 " up to %" PRIu64 "\n",
+			    ctx->io_unit_size, ctx->cluster_size);
+		return -EINVAL;
+	}
+
+	ctx->buf = spdk_zmalloc(g_io_size, ctx->io_unit_size, NULL, SPDK_ENV_LCORE_ID_ANY,
+				SPDK_MALLOC_DMA);
+	if (ctx->buf == NULL) {
+		return -ENOMEM;
+	}
+	memset(ctx->buf, 0x5a, g_io_size);
+
+	ctx->channel = spdk_bs_alloc_io_channel(ctx->bs);
+	if (ctx->channel == NULL) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void perf_io_submit(struct perf_context *ctx);
+
+static void
+perf_io_complete(void *cb_arg, int bserrno)
+{
+	struct perf_context *ctx = cb_arg;
+
+	ctx->io_outstanding--;
+	if (bserrno != 0) {
+		if (ctx->rc == 0) {
+			SPDK_ERRLOG("Write to blob %" PRIu32 " failed: %s\n", ctx->blob_index,
+				    spdk_strerror(-bserrno));
+			ctx->rc = bserrno;
+		}
+	} else {
+		ctx->ops++;
+		ctx->bytes += g_io_size;
+	}
+
+	if (ctx->rc == 0 && ctx->blob_index < g_num_blobs) {
+		perf_io_submit(ctx);
+		return;
+	}
+
+	if (ctx->io_outstanding == 0) {
+		if (ctx->rc != 0) {
+			perf_cleanup(ctx);
+		} else {
+			perf_end_phase(ctx);
+		}
+	}
+}
+
+static void
+perf_io_submit(struct perf_context *ctx)
+{
+	uint64_t length = g_io_size / ctx->io_unit_size;
+	uint64_t blob_length = ctx->blob_size / ctx->io_unit_size;
+	struct spdk_blob *blob;
+	uint64_t offset;
+
+	while (ctx->io_outstanding < g_queue_depth && ctx->rc == 0 &&
+	       ctx->blob_index < g_num_blobs) {
+		blob = ctx->blobs[ctx->blob_index].blob;
+		offset = ctx->io_offset;
+
+		ctx->io_offset += ctx->io_stride;
+		if (ctx->io_offset + length > blob_length) {
+			ctx->io_offset = 0;
+			ctx->blob_index++;
+		}
+
+		ctx->io_outstanding++;
+		spdk_blob_io_write(blob, ctx->channel, ctx->buf, offset, length, perf_io_complete, ctx);
+	}
+}
+
+static void
+perf_next_op(struct perf_context *ctx)
+{
+	struct spdk_bs_dev *bs_dev;
+	struct spdk_blob_opts blob_opts;
+	struct spdk_bs_opts bs_opts;
+	struct perf_blob *pblob;
+	int rc;
+
+	if (ctx->blob_index == (g_phases[ctx->phase].once ? 1 : g_num_blobs)) {
+		perf_end_phase(ctx);
+		return;
+	}
+
+	pblob = &ctx->blobs[ctx->blob_index];
+	ctx->op_start_tsc = spdk_get_ticks();
+
+	switch (ctx->phase) {
+	case PERF_PHASE_INIT:
+	case PERF_PHASE_LOAD:
+		rc = spdk_bdev_create_bs_dev_ext(g_bdev_name, base_bdev_event_cb, NULL, &bs_dev);
+		if (rc != 0) {
+			SPDK_ERRLOG("Could not create blob bdev on %s: %s\n", g_bdev_name,
+				    spdk_strerror(-rc));
+			perf_op_done(ctx, rc);
+			return;
+		}
+
+		spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+		if (ctx->phase == PERF_PHASE_INIT) {
+			if (g_cluster_size != 0) {
+				bs_opts.cluster_sz = g_cluster_size;
+			}
+			spdk_bs_init(bs_dev, &bs_opts, perf_init_complete, ctx);
+		} else {
+			spdk_bs_load(bs_dev, &bs_opts, perf_init_complete, ctx);
+		}
+		break;
+	case PERF_PHASE_CREATE:
+		spdk_blob_opts_init(&blob_opts, sizeof(blob_opts));
+		blob_opts.thin_provision = true;
+		blob_opts.num_clusters = ctx->blob_size / ctx->cluster_size;
+		spdk_bs_create_blob_ext(ctx->bs, &blob_opts, perf_blob_id_complete, ctx);
+		break;
+	case PERF_PHASE_OPEN:
+	case PERF_PHASE_REOPEN:
+		spdk_bs_open_blob(ctx->bs, pblob->id, perf_open_complete, ctx);
+		break;
+	case PERF_PHASE_SYNC_MD:
+		rc = spdk_blob_set_xattr(pblob->blob, "blob_perf", &ctx->op_start_tsc,
+					 sizeof(ctx->op_start_tsc));
+		if (rc != 0) {
+			perf_op_done(ctx, rc);
+			return;
+		}
+		spdk_blob_sync_md(pblob->blob, perf_op_complete, ctx);
+		break;
+	case PERF_PHASE_SNAPSHOT:
+		spdk_bs_create_snapshot(ctx->bs, pblob->id, NULL, perf_blob_id_complete, ctx);
+		break;
+	case PERF_PHASE_CLONE:
+		spdk_bs_create_clone(ctx->bs, pblob->snapshot_id, NULL, perf_blob_id_complete, ctx);
+		break;
+	case PERF_PHASE_CLOSE:
+		spdk_blob_close(pblob->blob, perf_close_complete, ctx);
+		break;
+	case PERF_PHASE_UNLOAD:
+		spdk_bs_free_io_channel(ctx->channel);
+		ctx->channel = NULL;
+		spdk_bs_unload(ctx->bs, perf_unload_complete, ctx);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+}
+
+static void
+perf_run_phase(struct perf_context *ctx)
+{
+	int rc;
+
+	if (ctx->phase == PERF_PHASE_INIT + 1) {
+		/* Now that the blobstore exists, its geometry is known */
+		rc = perf_setup_io(ctx);
+		if (rc != 0) {
+			ctx->rc = rc;
+			perf_cleanup(ctx);
+			return;
+		}
+	}
+
+	if (ctx->phase == PERF_PHASE_COUNT) {
+		perf_cleanup(ctx);
+		return;
+	}
+
+	ctx->phase_running = true;
+	ctx->blob_index = 0;
+	ctx->ops = 0;
+	ctx->bytes = 0;
+	ctx->total_latency_tsc = 0;
+	ctx->min_latency_tsc = UINT64_MAX;
+	ctx->max_latency_tsc = 0;
+	ctx->start_tsc = spdk_get_ticks();
+
+	if (g_phases[ctx->phase].io) {
+		ctx->io_offset = 0;
+		/*
+		 * Writing once to each cluster of the blobs after they were snapshotted makes every
+		 * write copy a whole cluster.
+		 */
+		ctx->io_stride = (ctx->phase == PERF_PHASE_COW_WRITE ? ctx->cluster_size : g_io_size) /
+				 ctx->io_unit_size;
+		perf_io_submit(ctx);
+	} else {
+		perf_next_op(ctx);
+	}
+}
+
+static void
+perf_cleanup_unload_complete(void *cb_arg, int bserrno)
+{
+	struct perf_context *ctx = cb_arg;
+
+	if (bserrno != 0) {
+		SPDK_ERRLOG("Failed to unload the blobstore: %s\n", spdk_strerror(-bserrno));
+		ctx->rc = ctx->rc ? : bserrno;
+	}
+
+	perf_cleanup(ctx);
+}
+
+static void
+perf_cleanup_close_complete(void *cb_arg, int bserrno)
+{
+	struct perf_context *ctx = cb_arg;
+
+	if (bserrno != 0) {
+		SPDK_ERRLOG("Failed to close a blob: %s\n", spdk_strerror(-bserrno));
+	}
+
+	perf_cleanup(ctx);
+}
+
+static void
+perf_cleanup(struct perf_context *ctx)
+{
+	struct spdk_blob_store *bs = ctx->bs;
+	struct spdk_blob *blob;
+	uint32_t i;
+
+	for (i = 0; i < g_num_blobs; i++) {
+		blob = ctx->blobs[i].blob;
+		if (blob != NULL) {
+			ctx->blobs[i].blob = NULL;
+			spdk_blob_close(blob, perf_cleanup_close_complete, ctx);
+			return;
+		}
+	}
+
+	if (ctx->channel != NULL) {
+		spdk_bs_free_io_channel(ctx->channel);
+		ctx->channel = NULL;
+	}
+
+	if (bs != NULL) {
+		ctx->bs = NULL;
+		spdk_bs_unload(bs, perf_cleanup_unload_complete, ctx);
+		return;
+	}
+
+	spdk_app_stop(ctx->rc);
+}
+
+static void
+blob_perf_start(void *arg1)
+{
+	struct perf_context *ctx = arg1;
+
+	ctx->tsc_rate = spdk_get_ticks_hz();
+
+	ctx->bdev = spdk_bdev_get_by_name(g_bdev_name);
+	if (ctx->bdev == NULL) {
+		SPDK_ERRLOG("Could not find bdev %s\n", g_bdev_name);
+		spdk_app_stop(-ENODEV);
+		return;
+	}
+
+	printf("%-12s %8s %12s %16s %11s %11s %11s %10s\n", "Phase", "ops", "ops/s", "",
+	       "avg (us)", "min (us)", "max (us)", "written");
+	printf("%-12s %8s %12s %16s %35s %10s\n", "", "", "", "throughput", "", "WA");
+
+	/* Get the amount of data written to the bdev so far, then start the first phase */
+	ctx->phase = PERF_PHASE_INIT;
+	spdk_bdev_get_device_stat(ctx->bdev, &ctx->dev_stat, perf_dev_stat_done, ctx);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_app_opts opts = {};
+	struct perf_context ctx = {};
+	int rc;
+
+	spdk_app_opts_init(&opts, sizeof(opts));
+	opts.name = "blob_perf";
+
+	rc = spdk_app_parse_args(argc, argv, &opts, "b:C:N:o:q:S:", NULL, blob_perf_parse_arg,
+				 blob_perf_usage);
+	if (rc != SPDK_APP_PARSE_ARGS_SUCCESS) {
+		exit(rc);
+	}
+
+	if (g_bdev_name == NULL) {
+		fprintf(stderr, "The bdev name (-b) is required\n");
+		blob_perf_usage();
+		exit(EXIT_FAILURE);
+	}
+
+	ctx.blobs = calloc(g_num_blobs, sizeof(*ctx.blobs));
+	if (ctx.blobs == NULL) {
+		fprintf(stderr, "Unable to allocate the blobs\n");
+		exit(EXIT_FAILURE);
+	}
+
+	rc = spdk_app_start(&opts, blob_perf_start, &ctx);
+	if (rc) {
+		SPDK_ERRLOG("ERROR running blob_perf\n");
+	}
+
+	spdk_free(ctx.buf);
+	free(ctx.blobs);
+
+	spdk_app_fini();
+	return rc;
+}
@@ -85,6 +85,9 @@ struct ns_entry {
 	bool			pi_loc;
 	enum spdk_nvme_pi_type	pi_type;
 	uint32_t		io_flags;
+	/* NUMA node of the device, SPDK_ENV_SOCKET_ID_ANY if unknown */
+	int			socket_id;
+	uint32_t		num_workers;
 	char			name[1024];
 };
 
@@ -157,6 +160,11 @@ struct ns_worker_ctx {
 	TAILQ_ENTRY(ns_worker_ctx)	link;
 
 	struct spdk_histogram_data	*histogram;
+
+	/* Snapshot of the statistics at the time of the last interval latency report */
+	struct spdk_histogram_data	*last_histogram;
+	uint64_t			last_report_io_completed;
+	uint64_t			last_report_total_tsc;
 };
 
 struct perf_task {
@@ -178,6 +186,30 @@ struct worker_thread {
 	TAILQ_HEAD(, ns_worker_ctx)	ns_ctx;
 	TAILQ_ENTRY(worker_thread)	link;
 	unsigned			lcore;
+	uint32_t			socket_id;
+	uint32_t			num_ns;
+};
+
+#define PERF_MAX_PROCESSES	64
+/* The histogram of each namespace context takes 8 * 2^precision * (65 - precision) bytes */
+#define PERF_MAX_LATENCY_PRECISION	12
+#define PERF_SHARED_STATS_NAME	"nvme_perf_shared_stats"
+
+struct perf_process_stats {
+	double		io_per_second;
+	double		mb_per_second;
+	uint64_t	io_completed;
+	uint64_t	total_tsc;
+	uint64_t	min_tsc;
+	uint64_t	max_tsc;
+};
+
+/* Shared by the cooperating perf processes, i.e. the ones using the same shared memory group */
+struct perf_shared_stats {
+	uint32_t			num_joined;
+	uint32_t			num_ready;
+	uint32_t			num_done;
+	struct perf_process_stats	procs[PERF_MAX_PROCESSES];
 };
 
 struct ns_fn_table {
@@ -202,6 +234,11 @@ static int g_outstanding_commands;
 
 static bool g_latency_ssd_tracking_enable;
 static int g_latency_sw_tracking_level;
+static uint32_t g_latency_bucket_shift = SPDK_HISTOGRAM_BUCKET_SHIFT_DEFAULT;
+static FILE *g_latency_json_file;
+static uint32_t g_latency_json_interval_in_sec = 1;
+/* Latency histogram of all namespaces over the last interval, used by the main core only */
+static struct spdk_histogram_data *g_interval_histogram;
 
 static bool g_vmd;
 static const char *g_workload_type;
@@ -211,6 +248,12 @@ static uint32_t g_num_namespaces;
 static TAILQ_HEAD(, worker_thread) g_workers = TAILQ_HEAD_INITIALIZER(g_workers);
 static uint32_t g_num_workers = 0;
 static bool g_use_every_core = false;
+static bool g_numa_local_cores = false;
+static bool g_shared_cq = false;
+static uint32_t g_num_processes = 1;
+static uint32_t g_process_idx;
+static struct perf_shared_stats *g_shared_stats;
+static struct perf_process_stats g_process_stats;
 static uint32_t g_main_core;
 static pthread_barrier_t g_worker_sync_barrier;
 
@@ -757,6 +800,7 @@ register_file(const char *path)
 	}
 	entry->size_in_ios = size / g_io_size_bytes;
 	entry->io_size_blocks = g_io_size_bytes / blklen;
+	entry->socket_id = SPDK_ENV_SOCKET_ID_ANY;
 
 	if (g_is_random) {
 		entry->seed = rand();
@@ -794,6 +838,8 @@ static void io_complete(void *ctx, const struct spdk_nvme_cpl *cpl);
 static void
 nvme_setup_payload(struct perf_task *task, uint8_t pattern)
 {
+	/* Allocate the buffers on the NUMA node of the device */
+	int socket_id = task->ns_ctx->entry->socket_id;
 	uint32_t max_io_size_bytes, max_io_md_size;
 	void *buf;
 	int rc;
@@ -802,9 +848,9 @@ nvme_setup_payload(struct perf_task *task, uint8_t pattern)
 	 * it's same with g_io_size_bytes for namespace without metadata.
 	 */
 	max_io_size_bytes = g_io_size_bytes + g_max_io_md_size * g_max_io_size_blocks;
-	buf = spdk_dma_zmalloc(max_io_size_bytes, g_io_align, NULL);
+	buf = spdk_zmalloc(max_io_size_bytes, g_io_align, NULL, socket_id, SPDK_MALLOC_DMA);
 	if (buf == NULL) {
-		fprintf(stderr, "task->buf spdk_dma_zmalloc failed\n");
+		fprintf(stderr, "task->buf spdk_zmalloc failed\n");
 		exit(1);
 	}
 	memset(buf, pattern, max_io_size_bytes);
@@ -818,10 +864,11 @@ nvme_setup_payload(struct perf_task *task, uint8_t pattern)
 
 	max_io_md_size = g_max_io_md_size * g_max_io_size_blocks;
 	if (max_io_md_size != 0) {
-		task->md_iov.iov_base = spdk_dma_zmalloc(max_io_md_size, g_io_align, NULL);
+		task->md_iov.iov_base = spdk_zmalloc(max_io_md_size, g_io_align, NULL, socket_id,
+						     SPDK_MALLOC_DMA);
 		task->md_iov.iov_len = max_io_md_size;
 		if (task->md_iov.iov_base == NULL) {
-			fprintf(stderr, "task->md_buf spdk_dma_zmalloc failed\n");
+			fprintf(stderr, "task->md_buf spdk_zmalloc failed\n");
 			spdk_dma_free(task->iovs[0].iov_base);
 			free(task->iovs);
 			exit(1);
@@ -1000,6 +1047,7 @@ nvme_init_ns_worker_ctx(struct ns_worker_ctx *ns_ctx)
 	opts.delay_cmd_submit = true;
 	opts.create_only = true;
 	opts.async_mode = true;
+	opts.shared_cq = g_shared_cq;
 
 	ns_ctx->u.nvme.group = spdk_nvme_poll_group_create(NULL, NULL);
 	if (ns_ctx->u.nvme.group == NULL) {
@@ -1231,6 +1279,7 @@ register_ns(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_ns *ns)
 	uint32_t max_xfer_size, entries, sector_size;
 	uint64_t ns_size;
 	struct spdk_nvme_io_qpair_opts opts;
+	struct spdk_pci_device *pci_dev;
 
 	cdata = spdk_nvme_ctrlr_get_data(ctrlr);
 
@@ -1282,6 +1331,11 @@ register_ns(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_ns *ns)
 	entry->fn_table = &nvme_fn_table;
 	entry->u.nvme.ctrlr = ctrlr;
 	entry->u.nvme.ns = ns;
+	entry->socket_id = SPDK_ENV_SOCKET_ID_ANY;
+	pci_dev = spdk_nvme_ctrlr_get_pci_device(ctrlr);
+	if (pci_dev != NULL && spdk_pci_device_get_socket_id(pci_dev) >= 0) {
+		entry->socket_id = spdk_pci_device_get_socket_id(pci_dev);
+	}
 	entry->num_io_requests = entries * spdk_divide_round_up(g_queue_depth, g_nr_io_queues_per_ns);
 
 	entry->size_in_ios = ns_size / g_io_size_bytes;
@@ -1567,10 +1621,10 @@ allocate_task(struct ns_worker_ctx *ns_ctx, int queue_depth)
 		exit(1);
 	}
 
-	ns_ctx->entry->fn_table->setup_payload(task, queue_depth % 8 + 1);
-
 	task->ns_ctx = ns_ctx;
 
+	ns_ctx->entry->fn_table->setup_payload(task, queue_depth % 8 + 1);
+
 	return task;
 }
 
@@ -1647,6 +1701,120 @@ print_periodic_performance(bool warmup)
 	fflush(stdout);
 }
 
+static const double g_latency_json_percentiles[] = {
+	0.50,
+	0.90,
+	0.99,
+	0.999,
+	0.9999,
+	-1,
+};
+
+struct latency_json_ctx {
+	const double	*percentile;
+	double		values[SPDK_COUNTOF(g_latency_json_percentiles)];
+	uint32_t	num_values;
+	uint64_t	min_tsc;
+	uint64_t	max_tsc;
+};
+
+static void
+collect_latency_json(void *_ctx, uint64_t start, uint64_t end, uint64_t count,
+		     uint64_t total, uint64_t so_far)
+{
+	struct latency_json_ctx *ctx = _ctx;
+
+	if (count == 0) {
+		return;
+	}
+
+	if (ctx->min_tsc == 0) {
+		ctx->min_tsc = start;
+	}
+	ctx->max_tsc = end;
+
+	while ((double)so_far / total >= *ctx->percentile && *ctx->percentile > 0) {
+		ctx->values[ctx->num_values++] = (double)end * 1000 * 1000 / g_tsc_rate;
+		ctx->percentile++;
+	}
+}
+
+/* Write a JSON line with the latency distribution of the I/O completed by all workers since the
+ * previous one.  The histograms of the other workers are read while they're being updated, so
+ * a few I/O completing meanwhile may be reported in the next interval instead. */
+static void
+print_latency_json(uint64_t elapsed_tsc, uint64_t interval_tsc)
+{
+	struct latency_json_ctx ctx = { .percentile = g_latency_json_percentiles };
+	struct worker_thread *worker;
+	struct ns_worker_ctx *ns_ctx;
+	uint64_t i, cur, last, io_completed = 0, total_tsc = 0;
+	double io_per_second;
+	uint32_t j;
+
+	spdk_histogram_data_reset(g_interval_histogram);
+
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		TAILQ_FOREACH(ns_ctx, &worker->ns_ctx, link) {
+			for (i = 0; i < SPDK_HISTOGRAM_NUM_BUCKETS(g_interval_histogram); i++) {
+				cur = ns_ctx->histogram->bucket[i];
+				last = ns_ctx->last_histogram->bucket[i];
+				/* The histogram might have been reset at the end of the warmup */
+				g_interval_histogram->bucket[i] += cur >= last ? cur - last : cur;
+				ns_ctx->last_histogram->bucket[i] = cur;
+			}
+
+			cur = ns_ctx->stats.io_completed;
+			last = ns_ctx->last_report_io_completed;
+			io_completed += cur >= last ? cur - last : cur;
+			ns_ctx->last_report_io_completed = cur;
+
+			cur = ns_ctx->stats.total_tsc;
+			last = ns_ctx->last_report_total_tsc;
+			total_tsc += cur >= last ? cur - last : cur;
+			ns_ctx->last_report_total_tsc = cur;
+		}
+	}
+
+	spdk_histogram_data_iterate(g_interval_histogram, collect_latency_json, &ctx);
+
+	io_per_second = (double)io_completed * g_tsc_rate / interval_tsc;
+	fprintf(g_latency_json_file, "{\"time_s\": %.3f, \"io_count\": %" PRIu64 ", "
+		"\"iops\": %.2f, \"mib_s\": %.2f",
+		(double)elapsed_tsc / g_tsc_rate, io_completed, io_per_second,
+		io_per_second * g_io_size_bytes / (1024 * 1024));
+
+	if (io_completed != 0) {
+		fprintf(g_latency_json_file, ", \"latency_us\": {\"avg\": %.3f, \"min\": %.3f",
+			((double)total_tsc / io_completed) * 1000 * 1000 / g_tsc_rate,
+			(double)ctx.min_tsc * 1000 * 1000 / g_tsc_rate);
+		for (j = 0; j < ctx.num_values; j++) {
+			fprintf(g_latency_json_file, ", \"p%g\": %.3f", g_latency_json_percentiles[j] * 100,
+				ctx.values[j]);
+		}
+		fprintf(g_latency_json_file, ", \"max\": %.3f}",
+			(double)ctx.max_tsc * 1000 * 1000 / g_tsc_rate);
+	}
+
+	fprintf(g_latency_json_file, "}\n");
+	fflush(g_latency_json_file);
+}
+
+static void
+reset_latency_json(void)
+{
+	struct worker_thread *worker;
+	struct ns_worker_ctx *ns_ctx;
+
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		TAILQ_FOREACH(ns_ctx, &worker->ns_ctx, link) {
+			spdk_histogram_data_reset(ns_ctx->last_histogram);
+			ns_ctx->last_report_io_completed = 0;
+			ns_ctx->last_report_total_tsc = 0;
+		}
+	}
+}
+
 static void
 perf_dump_transport_statistics(struct worker_thread *worker)
 {
@@ -1659,10 +1827,88 @@ perf_dump_transport_statistics(struct worker_thread *worker)
 	}
 }
 
+static int
+perf_shared_stats_init(void)
+{
+	g_shared_stats = spdk_memzone_reserve(PERF_SHARED_STATS_NAME, sizeof(*g_shared_stats),
+					      SPDK_ENV_SOCKET_ID_ANY, 0);
+	if (g_shared_stats == NULL) {
+		/* Another process got there first */
+		g_shared_stats = spdk_memzone_lookup(PERF_SHARED_STATS_NAME);
+	}
+	if (g_shared_stats == NULL) {
+		fprintf(stderr, "Unable to allocate the statistics shared between processes\n");
+		return -1;
+	}
+
+	g_process_idx = __atomic_fetch_add(&g_shared_stats->num_joined, 1, __ATOMIC_SEQ_CST);
+	if (g_process_idx >= g_num_processes) {
+		fprintf(stderr, "More than %u perf processes joined the shared memory group\n",
+			g_num_processes);
+		g_shared_stats = NULL;
+		return -1;
+	}
+
+	printf("Running as process %u of %u\n", g_process_idx, g_num_processes);
+
+	return 0;
+}
+
+static void
+perf_shared_stats_wait_ready(void)
+{
+	__atomic_add_fetch(&g_shared_stats->num_ready, 1, __ATOMIC_SEQ_CST);
+
+	while (__atomic_load_n(&g_shared_stats->num_ready, __ATOMIC_SEQ_CST) < g_num_processes &&
+	       !g_exit) {
+		usleep(100);
+	}
+}
+
+static void
+print_shared_stats(void)
+{
+	struct perf_process_stats total = { .min_tsc = UINT64_MAX };
+	struct perf_process_stats *stats;
+	uint32_t i;
+
+	g_shared_stats->procs[g_process_idx] = g_process_stats;
+	if (__atomic_add_fetch(&g_shared_stats->num_done, 1, __ATOMIC_SEQ_CST) != g_num_processes) {
+		printf("Results of all %u processes will be reported by the last one to finish\n\n",
+		       g_num_processes);
+		return;
+	}
+
+	for (i = 0; i < g_num_processes; i++) {
+		stats = &g_shared_stats->procs[i];
+		total.io_per_second += stats->io_per_second;
+		total.mb_per_second += stats->mb_per_second;
+		total.io_completed += stats->io_completed;
+		total.total_tsc += stats->total_tsc;
+		total.min_tsc = spdk_min(total.min_tsc, stats->min_tsc);
+		total.max_tsc = spdk_max(total.max_tsc, stats->max_tsc);
+	}
+
+	if (total.io_completed != 0) {
+		printf("========================================================\n");
+		printf("%-30s: %10s %10s %10s %10s %10s\n", "", "IOPS", "MiB/s", "Average", "min", "max");
+		printf("Total of %-3u processes        : %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+		       g_num_processes, total.io_per_second, total.mb_per_second,
+		       ((double)total.total_tsc / total.io_completed) * 1000 * 1000 / g_tsc_rate,
+		       (double)total.min_tsc * 1000 * 1000 / g_tsc_rate,
+		       (double)total.max_tsc * 1000 * 1000 / g_tsc_rate);
+		printf("\n");
+	}
+
+	spdk_memzone_free(PERF_SHARED_STATS_NAME);
+	g_shared_stats = NULL;
+}
+
 static int
 work_fn(void *arg)
 {
-	uint64_t tsc_start, tsc_end, tsc_current, tsc_next_print;
+	uint64_t tsc_start, tsc_end, tsc_current, tsc_next_print, tsc_next_json;
+	uint64_t json_interval_tsc = g_latency_json_interval_in_sec * g_tsc_rate;
 	struct worker_thread *worker = (struct worker_thread *) arg;
 	struct ns_worker_ctx *ns_ctx = NULL;
 	uint32_t unfinished_ns_ctx;
@@ -1687,9 +1933,23 @@ work_fn(void *arg)
 		return 1;
 	}
 
+	if (g_shared_stats != NULL) {
+		/* Start the workload together with the cooperating processes */
+		if (rc == PTHREAD_BARRIER_SERIAL_THREAD) {
+			perf_shared_stats_wait_ready();
+		}
+
+		rc = pthread_barrier_wait(&g_worker_sync_barrier);
+		if (rc != 0 && rc != PTHREAD_BARRIER_SERIAL_THREAD) {
+			printf("ERROR: failed to wait on thread sync barrier\n");
+			return 1;
+		}
+	}
+
 	tsc_start = spdk_get_ticks();
 	tsc_current = tsc_start;
 	tsc_next_print = tsc_current + g_tsc_rate;
+	tsc_next_json = tsc_current + json_interval_tsc;
 
 	if (g_warmup_time_in_sec) {
 		warmup = true;
@@ -1738,6 +1998,12 @@ work_fn(void *arg)
 			print_periodic_performance(warmup);
 		}
 
+		if (g_latency_json_file != NULL && worker->lcore == g_main_core && !warmup &&
+		    tsc_current > tsc_next_json) {
+			tsc_next_json += json_interval_tsc;
+			print_latency_json(tsc_current - tsc_start, json_interval_tsc);
+		}
+
 		if (tsc_current > tsc_end) {
 			if (warmup) {
 				/* Update test start and end time, clear statistics */
@@ -1755,6 +2021,11 @@ work_fn(void *arg)
 					printf("%c[2K", 27);
 				}
 
+				if (g_latency_json_file != NULL && worker->lcore == g_main_core) {
+					reset_latency_json();
+					tsc_next_json = tsc_start + json_interval_tsc;
+				}
+
 				warmup = false;
 			} else {
 				break;
@@ -1889,6 +2160,15 @@ usage(char *program_name)
 	printf("\t[--transport-tos <val> specify the type of service for RDMA transport. Default: 0 (disabled)]\n");
 	printf("\t[--rdma-srq-size <val> The size of a shared rdma receive queue. Default: 0 (disabled)]\n");
 	printf("\t[--use-every-core for each namespace, I/Os are submitted from all cores]\n");
+	printf("\t[--shared-cq share a completion queue between the PCIe qpairs of a namespace]\n");
+	printf("\t[--numa-local-cores associate namespaces with the cores on the NUMA node of their device]\n");
+	printf("\t[--num-processes <val> number of perf processes sharing the -i group ID to start together\n");
+	printf("\t\tand report the aggregated results of. default: 1]\n");
+	printf("\t[--latency-precision <val> number of bits of precision of the latency histograms, i.e. each bucket\n");
+	printf("\t\tspans at most 1/2^val of its latency. default: %d]\n", SPDK_HISTOGRAM_BUCKET_SHIFT_DEFAULT);
+	printf("\t[--latency-json <file> write the latency distribution of each interval as a JSON line to the file.\n");
+	printf("\t\tImplies -L]\n");
+	printf("\t[--latency-json-interval <sec> interval of the JSON latency reports. default: 1]\n");
 }
 
 static void
@@ -1926,6 +2206,34 @@ print_bucket(void *ctx, uint64_t start, uint64_t end, uint64_t count,
 	       so_far_pct, count);
 }
 
+static void
+print_merged_latency_summary(void)
+{
+	struct spdk_histogram_data *histogram;
+	struct worker_thread *worker;
+	struct ns_worker_ctx *ns_ctx;
+	const double *cutoff = g_latency_cutoffs;
+
+	histogram = spdk_histogram_data_alloc_sized(g_latency_bucket_shift);
+	if (histogram == NULL) {
+		return;
+	}
+
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		TAILQ_FOREACH(ns_ctx, &worker->ns_ctx, link) {
+			spdk_histogram_data_merge(histogram, ns_ctx->histogram);
+		}
+	}
+
+	printf("Summary latency data for all devices from all cores:\n");
+	printf("=================================================================================\n");
+
+	spdk_histogram_data_iterate(histogram, check_cutoff, &cutoff);
+
+	printf("\n");
+	spdk_histogram_data_free(histogram);
+}
+
 static void
 print_performance(void)
 {
@@ -1945,6 +2253,7 @@ print_performance(void)
 	min_latency_so_far = (double)UINT64_MAX;
 	max_latency_so_far = 0;
 	ns_count = 0;
+	g_process_stats.min_tsc = UINT64_MAX;
 
 	max_strlen = 0;
 	TAILQ_FOREACH(worker, &g_workers, link) {
@@ -1975,6 +2284,9 @@ print_performance(void)
 					max_latency_so_far = max_latency;
 				}
 
+				g_process_stats.min_tsc = spdk_min(g_process_stats.min_tsc, ns_ctx->stats.min_tsc);
+				g_process_stats.max_tsc = spdk_max(g_process_stats.max_tsc, ns_ctx->stats.max_tsc);
+
 				printf("%-*.*s from core %2u: %10.2f %10.2f %10.2f %10.2f %10.2f\n",
 				       max_strlen, max_strlen, ns_ctx->entry->name, worker->lcore,
 				       io_per_second, mb_per_second,
@@ -1995,6 +2307,11 @@ print_performance(void)
 		       max_strlen + 13, "Total", total_io_per_second, total_mb_per_second,
 		       sum_ave_latency, min_latency_so_far, max_latency_so_far);
 		printf("\n");
+
+		g_process_stats.io_per_second = total_io_per_second;
+		g_process_stats.mb_per_second = total_mb_per_second;
+		g_process_stats.io_completed = total_io_completed;
+		g_process_stats.total_tsc = total_io_tsc;
 	}
 
 	if (g_latency_sw_tracking_level == 0 || total_io_completed == 0) {
@@ -2014,6 +2331,10 @@ print_performance(void)
 		}
 	}
 
+	if (ns_count > 1) {
+		print_merged_latency_summary();
+	}
+
 	if (g_latency_sw_tracking_level == 1) {
 		return;
 	}
@@ -2098,6 +2419,9 @@ static void
 print_stats(void)
 {
 	print_performance();
+	if (g_shared_stats != NULL) {
+		print_shared_stats();
+	}
 	if (g_latency_ssd_tracking_enable) {
 		if (g_rw_percentage != 0) {
 			print_latency_statistics("Read", SPDK_NVME_INTEL_LOG_READ_CMD_LATENCY);
@@ -2403,6 +2727,18 @@ static const struct option g_perf_cmdline_opts[] = {
 	{"rdma-srq-size", required_argument, NULL, PERF_RDMA_SRQ_SIZE},
 #define PERF_USE_EVERY_CORE	269
 	{"use-every-core", no_argument, NULL, PERF_USE_EVERY_CORE},
+#define PERF_SHARED_CQ	270
+	{"shared-cq", no_argument, NULL, PERF_SHARED_CQ},
+#define PERF_NUMA_LOCAL_CORES	271
+	{"numa-local-cores", no_argument, NULL, PERF_NUMA_LOCAL_CORES},
+#define PERF_NUM_PROCESSES	272
+	{"num-processes", required_argument, NULL, PERF_NUM_PROCESSES},
+#define PERF_LATENCY_PRECISION	273
+	{"latency-precision", required_argument, NULL, PERF_LATENCY_PRECISION},
+#define PERF_LATENCY_JSON	274
+	{"latency-json", required_argument, NULL, PERF_LATENCY_JSON},
+#define PERF_LATENCY_JSON_INTERVAL	275
+	{"latency-json-interval", required_argument, NULL, PERF_LATENCY_JSON_INTERVAL},
 	/* Should be the last element */
 	{0, 0, 0, 0}
 };
@@ -2637,6 +2973,48 @@ parse_args(int argc, char **argv, struct spdk_env_opts *env_opts)
 		case PERF_USE_EVERY_CORE:
 			g_use_every_core = true;
 			break;
+		case PERF_SHARED_CQ:
+			g_shared_cq = true;
+			break;
+		case PERF_NUMA_LOCAL_CORES:
+			g_numa_local_cores = true;
+			break;
+		case PERF_NUM_PROCESSES:
+			val = spdk_strtol(optarg, 10);
+			if (val <= 0 || val > PERF_MAX_PROCESSES) {
+				fprintf(stderr, "Invalid number of processes, must be between 1 and %d\n",
+					PERF_MAX_PROCESSES);
+				return 1;
+			}
+			g_num_processes = val;
+			break;
+		case PERF_LATENCY_PRECISION:
+			val = spdk_strtol(optarg, 10);
+			if (val < 1 || val > PERF_MAX_LATENCY_PRECISION) {
+				fprintf(stderr, "Invalid latency precision, must be between 1 and %d\n",
+					PERF_MAX_LATENCY_PRECISION);
+				return 1;
+			}
+			g_latency_bucket_shift = val;
+			break;
+		case PERF_LATENCY_JSON:
+			if (g_latency_json_file != NULL) {
+				fclose(g_latency_json_file);
+			}
+			g_latency_json_file = fopen(optarg, "w");
+			if (g_latency_json_file == NULL) {
+				fprintf(stderr, "Unable to open %s: %s\n", optarg, strerror(errno));
+				return 1;
+			}
+			break;
+		case PERF_LATENCY_JSON_INTERVAL:
+			val = spdk_strtol(optarg, 10);
+			if (val <= 0) {
+				fprintf(stderr, "Invalid latency JSON interval\n");
+				return 1;
+			}
+			g_latency_json_interval_in_sec = val;
+			break;
 		case PERF_DEFAULT_SOCK_IMPL:
 			sock_impl = optarg;
 			rc = spdk_sock_set_default_impl(optarg);
@@ -2702,6 +3080,19 @@ parse_args(int argc, char **argv, struct spdk_env_opts *env_opts)
 		usage(argv[0]);
 		return 1;
 	}
+	if (g_num_processes > 1 && env_opts->shm_id < 0) {
+		fprintf(stderr, "--num-processes requires the processes to use the same -i (--shmem-grp-id)\n");
+		usage(argv[0]);
+		return 1;
+	}
+	if (g_latency_json_file != NULL && g_latency_sw_tracking_level == 0) {
+		/* The interval reports are built from the software latency histograms */
+		g_latency_sw_tracking_level = 1;
+	}
+	if (g_numa_local_cores && g_use_every_core) {
+		fprintf(stderr, "--numa-local-cores and --use-every-core are mutually exclusive\n");
+		return 1;
+	}
 
 	if (strncmp(g_workload_type, "rand", 4) == 0) {
 		g_is_random = 1;
@@ -2804,6 +3195,7 @@ register_workers(void)
 
 		TAILQ_INIT(&worker->ns_ctx);
 		worker->lcore = i;
+		worker->socket_id = spdk_env_get_socket_id(i);
 		TAILQ_INSERT_TAIL(&g_workers, worker, link);
 		g_num_workers++;
 	}
@@ -2824,6 +3216,7 @@ unregister_workers(void)
 		TAILQ_FOREACH_SAFE(ns_ctx, &worker->ns_ctx, link, tmp_ns_ctx) {
 			TAILQ_REMOVE(&worker->ns_ctx, ns_ctx, link);
 			spdk_histogram_data_free(ns_ctx->histogram);
+			spdk_histogram_data_free(ns_ctx->last_histogram);
 			free(ns_ctx);
 		}
 
@@ -2974,8 +3367,91 @@ allocate_ns_worker(struct ns_entry *entry, struct worker_thread *worker)
 	printf("Associating %s with lcore %d\n", entry->name, worker->lcore);
 	ns_ctx->stats.min_tsc = UINT64_MAX;
 	ns_ctx->entry = entry;
-	ns_ctx->histogram = spdk_histogram_data_alloc();
+	ns_ctx->histogram = spdk_histogram_data_alloc_sized(g_latency_bucket_shift);
+	if (g_latency_json_file != NULL) {
+		ns_ctx->last_histogram = spdk_histogram_data_alloc_sized(g_latency_bucket_shift);
+		if (ns_ctx->histogram == NULL || ns_ctx->last_histogram == NULL) {
+			spdk_histogram_data_free(ns_ctx->histogram);
+			spdk_histogram_data_free(ns_ctx->last_histogram);
+			free(ns_ctx);
+			return -1;
+		}
+	}
 	TAILQ_INSERT_TAIL(&worker->ns_ctx, ns_ctx, link);
+	worker->num_ns++;
+	entry->num_workers++;
+
+	return 0;
+}
+
+/* Returns the worker on the given NUMA node (any if SPDK_ENV_SOCKET_ID_ANY) with the fewest
+ * namespaces or NULL if there are no workers on that node */
+static struct worker_thread *
+get_least_loaded_worker(int socket_id)
+{
+	struct worker_thread *worker, *result = NULL;
+
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		if (socket_id != SPDK_ENV_SOCKET_ID_ANY && worker->socket_id != (uint32_t)socket_id) {
+			continue;
+		}
+		if (result == NULL || worker->num_ns < result->num_ns) {
+			result = worker;
+		}
+	}
+
+	return result;
+}
+
+/* Returns the namespace on the given NUMA node (any if SPDK_ENV_SOCKET_ID_ANY) with the fewest
+ * workers or NULL if there are no namespaces on that node */
+static struct ns_entry *
+get_least_loaded_ns(int socket_id)
+{
+	struct ns_entry *entry, *result = NULL;
+
+	TAILQ_FOREACH(entry, &g_namespaces, link) {
+		if (socket_id != SPDK_ENV_SOCKET_ID_ANY && entry->socket_id != socket_id) {
+			continue;
+		}
+		if (result == NULL || entry->num_workers < result->num_workers) {
+			result = entry;
+		}
+	}
+
+	return result;
+}
+
+static int
+associate_workers_with_local_ns(void)
+{
+	struct ns_entry		*entry;
+	struct worker_thread	*worker;
+
+	/* Spread the namespaces of each device across the workers on its NUMA node first... */
+	TAILQ_FOREACH(entry, &g_namespaces, link) {
+		worker = get_least_loaded_worker(entry->socket_id);
+		if (worker == NULL) {
+			worker = get_least_loaded_worker(SPDK_ENV_SOCKET_ID_ANY);
+		}
+		if (allocate_ns_worker(entry, worker) != 0) {
+			return -1;
+		}
+	}
+
+	/* ...and then give the remaining workers the local namespaces with the fewest workers */
+	TAILQ_FOREACH(worker, &g_workers, link) {
+		if (worker->num_ns != 0) {
+			continue;
+		}
+		entry = get_least_loaded_ns(worker->socket_id);
+		if (entry == NULL) {
+			entry = get_least_loaded_ns(SPDK_ENV_SOCKET_ID_ANY);
+		}
+		if (allocate_ns_worker(entry, worker) != 0) {
+			return -1;
+		}
+	}
 
 	return 0;
 }
@@ -2993,7 +3469,13 @@ associate_workers_with_ns(void)
 	 * 3) more workers than namespaces - each namespace is associated with one or more workers
 	 * 4) more namespaces than workers - each worker is associated with one or more namespaces
 	 * --use-every-core option enabled - every worker is associated with all namespaces
+	 * --numa-local-cores option enabled - same as the default, but namespaces are associated
+	 *   with the workers on the NUMA node of their device whenever possible
 	 */
+	if (g_numa_local_cores) {
+		return associate_workers_with_local_ns();
+	}
+
 	if (g_use_every_core) {
 		TAILQ_FOREACH(worker, &g_workers, link) {
 			TAILQ_FOREACH(entry, &g_namespaces, link) {
@@ -3172,6 +3654,20 @@ main(int argc, char **argv)
 		goto cleanup;
 	}
 
+	if (g_num_processes > 1 && perf_shared_stats_init() != 0) {
+		rc = -1;
+		goto cleanup;
+	}
+
+	if (g_latency_json_file != NULL) {
+		g_interval_histogram = spdk_histogram_data_alloc_sized(g_latency_bucket_shift);
+		if (g_interval_histogram == NULL) {
+			fprintf(stderr, "Unable to allocate the interval latency histogram\n");
+			rc = -1;
+			goto cleanup;
+		}
+	}
+
 	rc = pthread_barrier_init(&g_worker_sync_barrier, NULL, g_num_workers);
 	if (rc != 0) {
 		fprintf(stderr, "Unable to initialize thread sync barrier\n");
@@ -3209,6 +3705,10 @@ cleanup:
 	unregister_namespaces();
 	unregister_controllers();
 	unregister_workers();
+	spdk_histogram_data_free(g_interval_histogram);
+	if (g_latency_json_file != NULL) {
+		fclose(g_latency_json_file);
+	}
 
 	spdk_env_fini();
 
@@ -0,0 +1,728 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/thread.h"
+#include "spdk/env.h"
+#include "spdk/event.h"
+#include "spdk/histogram_data.h"
+#include "spdk/log.h"
+#include "spdk/queue.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+#include "spdk/sock.h"
+
+#define ACCEPT_TIMEOUT_US 1000
+#define DRAIN_TIMEOUT_US 1000000
+#define SERVER_CHUNK_SIZE (64 * 1024)
+#define SERVER_CHUNK_COUNT 16
+#define CLIENT_RECV_SIZE (64 * 1024)
+
+static char *g_host;
+static char *g_sock_impl_name;
+static int g_port;
+static bool g_is_server;
+static int g_zcopy;
+static char *g_psk_key;
+static char *g_psk_identity;
+static int g_num_connections = 1;
+static int g_msg_size = 4096;
+static int g_queue_depth = 1;
+static int g_time_in_sec = 10;
+
+/*
+ * A message sent by the client and echoed back by the server, or a chunk of received
+ * data the server sends back.
+ */
+struct perf_msg {
+	struct spdk_sock_request	req;
+	struct iovec			iov;
+	struct perf_conn		*conn;
+	uint8_t				*buf;
+	uint64_t			submit_tsc;
+	bool				write_done;
+	bool				echoed;
+	TAILQ_ENTRY(perf_msg)		link;
+};
+
+struct perf_conn {
+	struct perf_context		*ctx;
+	struct spdk_sock		*sock;
+	struct perf_msg			*msgs;
+	int				num_msgs;
+	TAILQ_HEAD(, perf_msg)		free_msgs;
+	/* Messages sent, in order, waiting to be echoed back */
+	TAILQ_HEAD(, perf_msg)		inflight_msgs;
+	int				outstanding;
+	uint8_t				*recv_buf;
+	int				recv_offset;
+	TAILQ_ENTRY(perf_conn)		link;
+};
+
+struct perf_context {
+	bool				is_running;
+	struct spdk_sock		*listen_sock;
+	struct spdk_sock_group		*group;
+	TAILQ_HEAD(, perf_conn)		conns;
+	struct spdk_poller		*accept_poller;
+	struct spdk_poller		*group_poller;
+	struct spdk_poller		*timer;
+
+	struct spdk_histogram_data	*histogram;
+	uint64_t			tsc_rate;
+	uint64_t			start_tsc;
+	uint64_t			end_tsc;
+	uint64_t			busy_tsc;
+	uint64_t			bytes_in;
+	uint64_t			bytes_out;
+	uint64_t			msgs_done;
+	struct spdk_sock_stats		stats;
+	int				rc;
+};
+
+static void
+sock_perf_usage(void)
+{
+	printf(" -C conns      number of connections (client only, default 1)\n");
+	printf(" -E psk_key    Default PSK KEY in hexadecimal digits, e.g. 1234567890ABCDEF (only applies when sock_impl == ssl)\n");
+	printf(" -H host_addr  host address\n");
+	printf(" -I psk_id     Default PSK ID, e.g. psk.spdk.io (only applies when sock_impl == ssl)\n");
+	printf(" -N sock_impl  socket implementation, e.g., -N posix, -N uring or -N ssl\n");
+	printf(" -O size       message size in bytes (client only, default 4096)\n");
+	printf(" -P port       port number\n");
+	printf(" -Q depth      messages in flight per connection (client only, default 1)\n");
+	printf(" -S            start in server mode, echoing back all the data received\n");
+	printf(" -T time       run time in seconds (client only, default 10)\n");
+	printf(" -z            disable zero copy send for the given sock implementation\n");
+	printf(" -Z            enable zero copy send for the given sock implementation\n");
+}
+
+static int
+sock_perf_parse_arg(int ch, char *arg)
+{
+	long val;
+
+	switch (ch) {
+	case 'E':
+		g_psk_key = arg;
+		return 0;
+	case 'H':
+		g_host = arg;
+		return 0;
+	case 'I':
+		g_psk_identity = arg;
+		return 0;
+	case 'N':
+		g_sock_impl_name = arg;
+		return 0;
+	case 'S':
+		g_is_server = true;
+		return 0;
+	case 'Z':
+		g_zcopy = 1;
+		return 0;
+	case 'z':
+		g_zcopy = 0;
+		return 0;
+	default:
+		break;
+	}
+
+	val = spdk_strtol(arg, 10);
+	if (val <= 0) {
+		fprintf(stderr, "Invalid value of -%c: %s\n", ch, arg);
+		return -EINVAL;
+	}
+
+	switch (ch) {
+	case 'C':
+		g_num_connections = val;
+		break;
+	case 'O':
+		g_msg_size = val;
+		break;
+	case 'P':
+		g_port = val;
+		break;
+	case 'Q':
+		g_queue_depth = val;
+		break;
+	case 'T':
+		g_time_in_sec = val;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void
+sock_perf_get_opts(struct spdk_sock_opts *opts, struct spdk_sock_impl_opts *impl_opts)
+{
+	size_t impl_opts_size = sizeof(*impl_opts);
+
+	spdk_sock_impl_get_opts(g_sock_impl_name, impl_opts, &impl_opts_size);
+	impl_opts->psk_key = g_psk_key;
+	impl_opts->psk_identity = g_psk_identity;
+
+	opts->opts_size = sizeof(*opts);
+	spdk_sock_get_default_opts(opts);
+	opts->zcopy = g_zcopy;
+	opts->impl_opts = impl_opts;
+	opts->impl_opts_size = sizeof(*impl_opts);
+}
+
+static void
+perf_conn_free(struct perf_conn *conn)
+{
+	int i;
+
+	for (i = 0; conn->msgs != NULL && i < conn->num_msgs; i++) {
+		free(conn->msgs[i].buf);
+	}
+	free(conn->msgs);
+	free(conn->recv_buf);
+	free(conn);
+}
+
+static struct perf_conn *
+perf_conn_alloc(struct perf_context *ctx, struct spdk_sock *sock, int num_msgs, int msg_size)
+{
+	struct perf_conn *conn;
+	int i;
+
+	conn = calloc(1, sizeof(*conn));
+	if (conn == NULL) {
+		return NULL;
+	}
+
+	conn->ctx = ctx;
+	conn->sock = sock;
+	conn->num_msgs = num_msgs;
+	conn->msgs = calloc(num_msgs, sizeof(*conn->msgs));
+	conn->recv_buf = malloc(spdk_max(msg_size, CLIENT_RECV_SIZE));
+	if (conn->msgs == NULL || conn->recv_buf == NULL) {
+		goto err;
+	}
+
+	TAILQ_INIT(&conn->free_msgs);
+	TAILQ_INIT(&conn->inflight_msgs);
+
+	for (i = 0; i < num_msgs; i++) {
+		conn->msgs[i].conn = conn;
+		conn->msgs[i].buf = malloc(msg_size);
+		if (conn->msgs[i].buf == NULL) {
+			goto err;
+		}
+		memset(conn->msgs[i].buf, 'a' + i % 26, msg_size);
+		TAILQ_INSERT_TAIL(&conn->free_msgs, &conn->msgs[i], link);
+	}
+
+	return conn;
+err:
+	perf_conn_free(conn);
+	return NULL;
+}
+
+static void
+perf_conn_close(struct perf_conn *conn)
+{
+	struct perf_context *ctx = conn->ctx;
+	struct spdk_sock_stats stats;
+
+	spdk_sock_get_stats(conn->sock, &stats);
+	ctx->stats.zcopy_sends += stats.zcopy_sends;
+	ctx->stats.copy_sends += stats.copy_sends;
+	ctx->stats.zcopy_copied += stats.zcopy_copied;
+
+	TAILQ_REMOVE(&ctx->conns, conn, link);
+	spdk_sock_group_remove_sock(ctx->group, conn->sock);
+	/* Aborts the outstanding writes, so the messages are done with afterwards */
+	spdk_sock_close(&conn->sock);
+	perf_conn_free(conn);
+}
+
+static void
+perf_finish(struct perf_context *ctx)
+{
+	struct perf_conn *conn, *tmp;
+
+	TAILQ_FOREACH_SAFE(conn, &ctx->conns, link, tmp) {
+		perf_conn_close(conn);
+	}
+
+	spdk_poller_unregister(&ctx->timer);
+	spdk_poller_unregister(&ctx->accept_poller);
+	spdk_poller_unregister(&ctx->group_poller);
+	spdk_sock_close(&ctx->listen_sock);
+	spdk_sock_group_close(&ctx->group);
+
+	spdk_app_stop(ctx->rc);
+}
+
+static int
+perf_group_poll(void *arg)
+{
+	struct perf_context *ctx = arg;
+	uint64_t tsc;
+	int rc;
+
+	tsc = spdk_get_ticks();
+	rc = spdk_sock_group_poll(ctx->group);
+	if (rc < 0) {
+		SPDK_ERRLOG("Failed to poll sock_group=%p\n", ctx->group);
+	}
+
+	/* Callbacks, including the sends they submit, run from within the group poll */
+	if (rc > 0) {
+		ctx->busy_tsc += spdk_get_ticks() - tsc;
+	}
+
+	return rc > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+/*
+ * Client
+ */
+
+static void client_msg_submit(struct perf_conn *conn);
+
+static void
+client_msg_put(struct perf_msg *msg)
+{
+	struct perf_conn *conn = msg->conn;
+
+	if (!msg->write_done || !msg->echoed) {
+		return;
+	}
+
+	conn->outstanding--;
+	TAILQ_INSERT_TAIL(&conn->free_msgs, msg, link);
+
+	if (conn->ctx->is_running) {
+		client_msg_submit(conn);
+	}
+}
+
+static void
+client_write_cb(void *cb_arg, int err)
+{
+	struct perf_msg *msg = cb_arg;
+
+	if (err < 0 && msg->conn->ctx->is_running) {
+		SPDK_ERRLOG("Failed to send message: %s\n", spdk_strerror(-err));
+		msg->conn->ctx->rc = err;
+		msg->conn->ctx->is_running = false;
+	}
+
+	msg->write_done = true;
+	client_msg_put(msg);
+}
+
+static void
+client_msg_submit(struct perf_conn *conn)
+{
+	struct perf_msg *msg;
+
+	msg = TAILQ_FIRST(&conn->free_msgs);
+	if (msg == NULL) {
+		return;
+	}
+	TAILQ_REMOVE(&conn->free_msgs, msg, link);
+
+	msg->write_done = false;
+	msg->echoed = false;
+	msg->iov.iov_base = msg->buf;
+	msg->iov.iov_len = g_msg_size;
+	msg->req.iovcnt = 1;
+	msg->req.cb_fn = client_write_cb;
+	msg->req.cb_arg = msg;
+	msg->submit_tsc = spdk_get_ticks();
+
+	TAILQ_INSERT_TAIL(&conn->inflight_msgs, msg, link);
+	conn->outstanding++;
+	conn->ctx->bytes_out += g_msg_size;
+
+	spdk_sock_writev_async(conn->sock, &msg->req);
+}
+
+static void
+client_sock_cb(void *arg, struct spdk_sock_group *group, struct spdk_sock *sock)
+{
+	struct perf_conn *conn = arg;
+	struct perf_context *ctx = conn->ctx;
+	struct perf_msg *msg;
+	uint64_t tsc;
+	ssize_t n;
+	int len;
+
+	n = spdk_sock_recv(sock, conn->recv_buf, CLIENT_RECV_SIZE);
+	if (n <= 0) {
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			return;
+		}
+
+		SPDK_ERRLOG("Connection closed by the server\n");
+		ctx->rc = -ENOTCONN;
+		ctx->is_running = false;
+		perf_conn_close(conn);
+		return;
+	}
+
+	ctx->bytes_in += n;
+	tsc = spdk_get_ticks();
+
+	/* The server echoes the messages back in order, slice the stream accordingly */
+	while (n > 0) {
+		len = spdk_min(n, g_msg_size - conn->recv_offset);
+		conn->recv_offset += len;
+		n -= len;
+
+		if (conn->recv_offset < g_msg_size) {
+			break;
+		}
+		conn->recv_offset = 0;
+
+		msg = TAILQ_FIRST(&conn->inflight_msgs);
+		assert(msg != NULL);
+		TAILQ_REMOVE(&conn->inflight_msgs, msg, link);
+
+		spdk_histogram_data_tally(ctx->histogram, tsc - msg->submit_tsc);
+		ctx->msgs_done++;
+		msg->echoed = true;
+		client_msg_put(msg);
+	}
+}
+
+static int
+client_drain_poll(void *arg)
+{
+	struct perf_context *ctx = arg;
+	struct perf_conn *conn;
+	uint64_t timeout = ctx->tsc_rate * DRAIN_TIMEOUT_US / SPDK_SEC_TO_USEC;
+
+	TAILQ_FOREACH(conn, &ctx->conns, link) {
+		if (conn->outstanding > 0 && spdk_get_ticks() - ctx->end_tsc < timeout) {
+			return SPDK_POLLER_IDLE;
+		}
+	}
+
+	perf_finish(ctx);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static int
+client_timeout(void *arg)
+{
+	struct perf_context *ctx = arg;
+
+	/* Stop sending and wait for the messages in flight */
+	ctx->is_running = false;
+	ctx->end_tsc = spdk_get_ticks();
+
+	spdk_poller_unregister(&ctx->timer);
+	ctx->timer = SPDK_POLLER_REGISTER(client_drain_poll, ctx, 0);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static int
+client_start(struct perf_context *ctx)
+{
+	struct spdk_sock_impl_opts impl_opts;
+	struct spdk_sock_opts opts;
+	struct spdk_sock *sock;
+	struct perf_conn *conn;
+	int i, j, rc;
+
+	ctx->histogram = spdk_histogram_data_alloc();
+	if (ctx->histogram == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->group = spdk_sock_group_create(NULL);
+	if (ctx->group == NULL) {
+		return -ENOMEM;
+	}
+
+	sock_perf_get_opts(&opts, &impl_opts);
+
+	SPDK_NOTICELOG("Connecting %d times to %s:%d with sock_impl(%s)\n", g_num_connections,
+		       g_host, g_port, g_sock_impl_name);
+
+	for (i = 0; i < g_num_connections; i++) {
+		sock = spdk_sock_connect_ext(g_host, g_port, g_sock_impl_name, &opts);
+		if (sock == NULL) {
+			SPDK_ERRLOG("connect error(%d): %s\n", errno, spdk_strerror(errno));
+			return -errno;
+		}
+
+		conn = perf_conn_alloc(ctx, sock, g_queue_depth, g_msg_size);
+		if (conn == NULL) {
+			spdk_sock_close(&sock);
+			return -ENOMEM;
+		}
+
+		rc = spdk_sock_group_add_sock(ctx->group, sock, client_sock_cb, conn);
+		if (rc != 0) {
+			spdk_sock_close(&conn->sock);
+			perf_conn_free(conn);
+			return rc;
+		}
+		TAILQ_INSERT_TAIL(&ctx->conns, conn, link);
+	}
+
+	ctx->is_running = true;
+	ctx->start_tsc = spdk_get_ticks();
+
+	TAILQ_FOREACH(conn, &ctx->conns, link) {
+		for (j = 0; j < g_queue_depth; j++) {
+			client_msg_submit(conn);
+		}
+	}
+
+	ctx->group_poller = SPDK_POLLER_REGISTER(perf_group_poll, ctx, 0);
+	ctx->timer = SPDK_POLLER_REGISTER(client_timeout, ctx, g_time_in_sec * SPDK_SEC_TO_USEC);
+
+	return 0;
+}
+
+static void
+check_cutoff(void *ctx, uint64_t start, uint64_t end, uint64_t count,
+	     uint64_t total, uint64_t so_far)
+{
+	double so_far_pct;
+	double **cutoff = ctx;
+	uint64_t tsc_rate = spdk_get_ticks_hz();
+
+	if (count == 0) {
+		return;
+	}
+
+	so_far_pct = (double)so_far / total;
+	while (so_far_pct >= **cutoff && **cutoff > 0) {
+		printf("%9.5f%% : %9.3fus\n", **cutoff * 100,
+		       (double)end * SPDK_SEC_TO_USEC / tsc_rate);
+		(*cutoff)++;
+	}
+}
+
+static void
+client_print_stats(struct perf_context *ctx)
+{
+	double cutoffs[] = {
+		0.01, 0.10, 0.25, 0.50, 0.75, 0.90, 0.95, 0.98, 0.99, 0.995, 0.999, 0.9999, -1
+	};
+	double *cutoff = cutoffs;
+	double seconds;
+	uint64_t bytes;
+
+	if (ctx->end_tsc <= ctx->start_tsc || ctx->msgs_done == 0) {
+		printf("No messages completed\n");
+		return;
+	}
+
+	seconds = (double)(ctx->end_tsc - ctx->start_tsc) / ctx->tsc_rate;
+	bytes = ctx->bytes_in + ctx->bytes_out;
+
+	printf("\nsock_impl %s, %d connection(s), message size %d, queue depth %d\n",
+	       g_sock_impl_name, g_num_connections, g_msg_size, g_queue_depth);
+	printf("========================================================\n");
+	printf("Messages/s          : %12.2f\n", ctx->msgs_done / seconds);
+	printf("Throughput          : %12.2f MiB/s (each direction)\n",
+	       (double)ctx->bytes_in / seconds / (1024 * 1024));
+	printf("Busy cycles/byte    : %12.2f (bytes sent and received)\n",
+	       bytes ? (double)ctx->busy_tsc / bytes : 0);
+	printf("Zero copy sends     : %12" PRIu64 " (%" PRIu64 " copied by the kernel)\n",
+	       ctx->stats.zcopy_sends, ctx->stats.zcopy_copied);
+	printf("Copy sends          : %12" PRIu64 "\n", ctx->stats.copy_sends);
+
+	printf("\nSummary latency data:\n");
+	printf("========================================================\n");
+	spdk_histogram_data_iterate(ctx->histogram, check_cutoff, &cutoff);
+	printf("\n");
+}
+
+/*
+ * Server
+ */
+
+static void
+server_write_cb(void *cb_arg, int err)
+{
+	struct perf_msg *msg = cb_arg;
+
+	TAILQ_INSERT_TAIL(&msg->conn->free_msgs, msg, link);
+}
+
+static void
+server_sock_cb(void *arg, struct spdk_sock_group *group, struct spdk_sock *sock)
+{
+	struct perf_conn *conn = arg;
+	struct perf_context *ctx = conn->ctx;
+	struct perf_msg *msg;
+	ssize_t n;
+
+	/* Without a free chunk the data stays in the socket until the echoes complete */
+	while ((msg = TAILQ_FIRST(&conn->free_msgs)) != NULL) {
+		n = spdk_sock_recv(sock, msg->buf, SERVER_CHUNK_SIZE);
+		if (n <= 0) {
+			if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				return;
+			}
+
+			SPDK_NOTICELOG("Connection closed\n");
+			perf_conn_close(conn);
+			return;
+		}
+
+		TAILQ_REMOVE(&conn->free_msgs, msg, link);
+		ctx->bytes_in += n;
+		ctx->bytes_out += n;
+
+		msg->iov.iov_base = msg->buf;
+		msg->iov.iov_len = n;
+		msg->req.iovcnt = 1;
+		msg->req.cb_fn = server_write_cb;
+		msg->req.cb_arg = msg;
+		spdk_sock_writev_async(sock, &msg->req);
+	}
+}
+
+static int
+server_accept_poll(void *arg)
+{
+	struct perf_context *ctx = arg;
+	struct spdk_sock *sock;
+	struct perf_conn *conn;
+	int count = 0;
+
+	while (1) {
+		sock = spdk_sock_accept(ctx->listen_sock);
+		if (sock == NULL) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				SPDK_ERRLOG("accept error(%d): %s\n", errno, spdk_strerror(errno));
+			}
+			break;
+		}
+
+		conn = perf_conn_alloc(ctx, sock, SERVER_CHUNK_COUNT, SERVER_CHUNK_SIZE);
+		if (conn == NULL) {
+			SPDK_ERRLOG("Failed to allocate the connection\n");
+			spdk_sock_close(&sock);
+			break;
+		}
+
+		if (spdk_sock_group_add_sock(ctx->group, sock, server_sock_cb, conn) != 0) {
+			SPDK_ERRLOG("Failed to add the connection to the sock group\n");
+			spdk_sock_close(&conn->sock);
+			perf_conn_free(conn);
+			break;
+		}
+		TAILQ_INSERT_TAIL(&ctx->conns, conn, link);
+		count++;
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static int
+server_start(struct perf_context *ctx)
+{
+	struct spdk_sock_impl_opts impl_opts;
+	struct spdk_sock_opts opts;
+
+	sock_perf_get_opts(&opts, &impl_opts);
+
+	ctx->listen_sock = spdk_sock_listen_ext(g_host, g_port, g_sock_impl_name, &opts);
+	if (ctx->listen_sock == NULL) {
+		SPDK_ERRLOG("Cannot create server socket\n");
+		return -1;
+	}
+
+	ctx->group = spdk_sock_group_create(NULL);
+	if (ctx->group == NULL) {
+		return -ENOMEM;
+	}
+
+	SPDK_NOTICELOG("Echo server listening on %s:%d with sock_impl(%s)\n", g_host, g_port,
+		       g_sock_impl_name);
+
+	ctx->is_running = true;
+	ctx->start_tsc = spdk_get_ticks();
+	ctx->accept_poller = SPDK_POLLER_REGISTER(server_accept_poll, ctx, ACCEPT_TIMEOUT_US);
+	ctx->group_poller = SPDK_POLLER_REGISTER(perf_group_poll, ctx, 0);
+
+	return 0;
+}
+
+static struct perf_context g_ctx;
+
+static void
+sock_perf_shutdown_cb(void)
+{
+	g_ctx.is_running = false;
+	g_ctx.end_tsc = spdk_get_ticks();
+	perf_finish(&g_ctx);
+}
+
+static void
+sock_perf_start(void *arg1)
+{
+	struct perf_context *ctx = arg1;
+	int rc;
+
+	ctx->tsc_rate = spdk_get_ticks_hz();
+
+	if (g_is_server) {
+		rc = server_start(ctx);
+	} else {
+		rc = client_start(ctx);
+	}
+
+	if (rc) {
+		ctx->rc = rc;
+		perf_finish(ctx);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_app_opts opts = {};
+	int rc = 0;
+
+	spdk_app_opts_init(&opts, sizeof(opts));
+	opts.name = "sock_perf";
+	opts.shutdown_cb = sock_perf_shutdown_cb;
+
+	rc = spdk_app_parse_args(argc, argv, &opts, "C:E:H:I:N:O:P:Q:ST:zZ", NULL,
+				 sock_perf_parse_arg, sock_perf_usage);
+	if (rc != SPDK_APP_PARSE_ARGS_SUCCESS) {
+		exit(rc);
+	}
+
+	TAILQ_INIT(&g_ctx.conns);
+
+	rc = spdk_app_start(&opts, sock_perf_start, &g_ctx);
+	if (rc) {
+		SPDK_ERRLOG("ERROR starting application\n");
+	}
+
+	if (g_is_server) {
+		printf("** %" PRIu64 " bytes echoed, %.2f busy cycles/byte **\n", g_ctx.bytes_in,
+		       g_ctx.bytes_in ? (double)g_ctx.busy_tsc / (2 * g_ctx.bytes_in) : 0);
+	} else if (rc == 0) {
+		client_print_stats(&g_ctx);
+	}
+
+	spdk_histogram_data_free(g_ctx.histogram);
+
+	spdk_app_fini();
+	return rc;
+}
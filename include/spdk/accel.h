@@ -13,6 +13,7 @@
 
 #include "spdk/stdinc.h"
 #include "spdk/dma.h"
+#include "spdk/dif.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,7 +41,9 @@ enum accel_opcode {
 	ACCEL_OPC_ENCRYPT		= 8,
 	ACCEL_OPC_DECRYPT		= 9,
 	ACCEL_OPC_XOR			= 10,
-	ACCEL_OPC_LAST			= 11,
+	ACCEL_OPC_DIF_VERIFY		= 11,
+	ACCEL_OPC_DIF_GENERATE		= 12,
+	ACCEL_OPC_LAST			= 13,
 };
 
 /**
@@ -312,6 +315,45 @@ int spdk_accel_submit_decompress(struct spdk_io_channel *ch, struct iovec *dst_i
 int spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uint32_t nsrcs,
 			  uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg);
 
+/**
+ * Submit a DIF verify request.  The protection information has to be interleaved with the data
+ * (extended LBA format).
+ *
+ * \param ch I/O channel associated with this call.
+ * \param iovs The io vector array holding the data blocks and their metadata.
+ * \param iovcnt The size of the io vectors.
+ * \param num_blocks Number of blocks to verify.
+ * \param ctx DIF context.  It has to stay valid until the operation completes.
+ * \param err Filled in with the details of the first error if the verification fails.
+ * \param cb_fn Called when this operation completes.  A failed verification is reported with
+ * -EIO status.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_dif_verify(struct spdk_io_channel *ch, struct iovec *iovs, size_t iovcnt,
+				 uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				 struct spdk_dif_error *err, spdk_accel_completion_cb cb_fn,
+				 void *cb_arg);
+
+/**
+ * Submit a DIF generate request.  The protection information is inserted in place into the
+ * metadata interleaved with the data (extended LBA format).
+ *
+ * \param ch I/O channel associated with this call.
+ * \param iovs The io vector array holding the data blocks and their metadata.
+ * \param iovcnt The size of the io vectors.
+ * \param num_blocks Number of blocks to generate the protection information for.
+ * \param ctx DIF context.  It has to stay valid until the operation completes.
+ * \param cb_fn Called when this operation completes.
+ * \param cb_arg Callback argument.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_accel_submit_dif_generate(struct spdk_io_channel *ch, struct iovec *iovs, size_t iovcnt,
+				   uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+				   spdk_accel_completion_cb cb_fn, void *cb_arg);
+
 /** Object grouping multiple accel operations to be executed at the same point in time */
 struct spdk_accel_sequence;
 
@@ -635,6 +677,24 @@ int spdk_accel_get_opc_module_name(enum accel_opcode opcode, const char **module
  */
 int spdk_accel_assign_opc(enum accel_opcode opcode, const char *name);
 
+/**
+ * Set the dispatch policy of an opcode.  Operations that are small enough or that exceed the
+ * queue depth of the module assigned to the opcode are executed by the software module instead.
+ * The policy has no effect if the opcode is assigned to the software module.  Operations using
+ * memory domains are always executed by the assigned module.
+ *
+ * \param opcode Accel Framework Opcode enum value.  Encrypt and decrypt operations cannot be
+ * dispatched, as crypto keys are bound to a single module.
+ * \param sw_max_bytes Operations of up to this many bytes are executed by the software module.
+ * 0 disables this threshold.
+ * \param max_queue_depth Maximum number of operations outstanding on the assigned module per
+ * IO channel, operations above it are executed by the software module.  0 means no limit.
+ *
+ * \return 0 on success, -EINVAL for invalid opcode or if the framework has started.
+ */
+int spdk_accel_set_opc_dispatch(enum accel_opcode opcode, uint64_t sw_max_bytes,
+				uint32_t max_queue_depth);
+
 struct spdk_json_write_ctx;
 
 /**
@@ -94,11 +94,16 @@ struct spdk_accel_task {
 		uint32_t			seed;
 		uint64_t			fill_pattern;
 		struct spdk_accel_crypto_key	*crypto_key;
+		struct {
+			const struct spdk_dif_ctx	*ctx;
+			struct spdk_dif_error		*err;
+		} dif;
 	};
 	union {
 		uint32_t		*crc_dst;
 		uint32_t		*output_size;
 		uint32_t		block_size; /* for crypto op */
+		uint32_t		num_blocks; /* for dif op */
 	};
 	struct {
 		struct spdk_accel_bounce_buffer s;
@@ -108,6 +113,8 @@ struct spdk_accel_task {
 	uint64_t			iv; /* Initialization vector (tweak) for crypto op */
 	int				flags;
 	int				status;
+	/* Set when the task is counted in the queue depth of the opcode's assigned module */
+	bool				inflight;
 	struct iovec			aux_iovs[SPDK_ACCEL_AUX_IOV_MAX];
 	TAILQ_ENTRY(spdk_accel_task)	link;
 	TAILQ_ENTRY(spdk_accel_task)	seq_link;
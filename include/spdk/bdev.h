@@ -204,8 +204,20 @@ struct spdk_bdev_opts {
 	uint32_t small_buf_pool_size;
 	/** Deprecated, use spdk_iobuf_set_opts() instead */
 	uint32_t large_buf_pool_size;
+
+	/**
+	 * Minimum size in bytes of a bounce buffer copy to be offloaded to the accel framework.
+	 * Smaller copies are done on the CPU.  Zero (default) disables the offload.
+	 */
+	uint32_t accel_copy_threshold;
+
+	/**
+	 * Maximum number of examine_disk callbacks in progress at a time.  Examining further bdevs
+	 * is deferred until some of them complete.  Zero (default) means no limit.
+	 */
+	uint32_t examine_queue_depth;
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_bdev_opts) == 32, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_bdev_opts) == 40, "Incorrect size");
 
 /**
  * Structure with optional IO request parameters
@@ -289,6 +301,13 @@ typedef void (*spdk_bdev_get_device_stat_cb)(struct spdk_bdev *bdev,
  */
 typedef void (*spdk_bdev_io_timeout_cb)(void *cb_arg, struct spdk_bdev_io *bdev_io);
 
+/**
+ * Block device completion batch callback
+ *
+ * \param cb_arg Callback argument
+ */
+typedef void (*spdk_bdev_completion_batch_cb)(void *cb_arg);
+
 /**
  * Initialize block device modules.
  *
@@ -459,6 +478,22 @@ struct spdk_bdev *spdk_bdev_desc_get_bdev(struct spdk_bdev_desc *desc);
 int spdk_bdev_set_timeout(struct spdk_bdev_desc *desc, uint64_t timeout_in_sec,
 			  spdk_bdev_io_timeout_cb cb_fn, void *cb_arg);
 
+/**
+ * Set a callback to be called after a batch of I/O completions has been delivered.
+ *
+ * Bdev modules may complete several I/O at once, e.g. all the I/O found completed
+ * while polling a device.  The completion callbacks of the I/O of a channel are then
+ * called back to back, and cb_fn is called once after the ones of the I/O submitted
+ * through this descriptor, on the same thread.  Work common to the completed I/O,
+ * like flushing responses to a transport, may be deferred until then.
+ *
+ * \param desc Block device descriptor.
+ * \param cb_fn Completion batch callback, NULL to stop being notified.
+ * \param cb_arg Callback argument
+ */
+void spdk_bdev_set_completion_batch_cb(struct spdk_bdev_desc *desc,
+				       spdk_bdev_completion_batch_cb cb_fn, void *cb_arg);
+
 /**
  * Check whether the block device supports the I/O type.
  *
@@ -520,6 +555,15 @@ uint32_t spdk_bdev_get_block_size(const struct spdk_bdev *bdev);
  */
 uint32_t spdk_bdev_get_write_unit_size(const struct spdk_bdev *bdev);
 
+/**
+ * Get the NUMA socket of the device backing a block device.
+ *
+ * \param bdev Block device to query.
+ *
+ * \return The socket ID, or SPDK_ENV_SOCKET_ID_ANY if it isn't known.
+ */
+int32_t spdk_bdev_get_socket_id(const struct spdk_bdev *bdev);
+
 /**
  * Get size of block device in logical blocks.
  *
@@ -561,6 +605,59 @@ void spdk_bdev_get_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits);
 void spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 				   void (*cb_fn)(void *cb_arg, int status), void *cb_arg);
 
+/**
+ * Select how the quality of service rate limits are enforced on a bdev.
+ *
+ * By default, all the rate limited I/O are funneled through a single QoS thread.
+ * In sharded mode, each channel submits its I/O directly, borrowing its quota from
+ * a pool refilled by the QoS thread each timeslice.  The mode can only be changed
+ * while no rate limit is set on the bdev.
+ *
+ * \param bdev Block device.
+ * \param sharded True to enforce the rate limits on each channel.
+ *
+ * \return 0 on success, -EBUSY if the QoS is already enabled on the bdev.
+ */
+int spdk_bdev_set_qos_sharded(struct spdk_bdev *bdev, bool sharded);
+
+/**
+ * Set the latency quality of service of a bdev.
+ *
+ * Bdevs sharing the same underlying device can be put in the same latency group.
+ * Whenever the p99 completion latency of a bdev with a latency target exceeds that
+ * target, the number of outstanding I/O of the bdevs in the group without a target
+ * is reduced, until the target is met again.
+ *
+ * \param bdev Block device.
+ * \param group Name of the latency group, NULL to remove the bdev from its group.
+ * \param target_us p99 latency target in microseconds, 0 to throttle this bdev on
+ * behalf of the other bdevs in the group.
+ * \param cb_fn Callback function to be called when the latency QoS has been updated.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_bdev_set_qos_latency_target(struct spdk_bdev *bdev, const char *group,
+				      uint64_t target_us,
+				      void (*cb_fn)(void *cb_arg, int status), void *cb_arg);
+
+/**
+ * Set up the coalescing of adjacent I/O on a bdev.
+ *
+ * Reads and writes to LBA-adjacent ranges submitted on the same channel within the
+ * time window are merged into a single I/O to the bdev module.  The completion of
+ * the merged I/O completes all the original I/O.  I/O with metadata, memory domains
+ * or accel sequences are never coalesced, nor is the I/O of channels with QoS rate
+ * limits.
+ *
+ * \param bdev Block device.
+ * \param window_us Time window in microseconds, 0 to disable the coalescing.
+ * \param max_blocks Maximum size in blocks of a coalesced I/O.
+ * \param cb_fn Callback function to be called when all the channels have been updated.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_bdev_set_io_coalescing(struct spdk_bdev *bdev, uint32_t window_us,
+				 uint32_t max_blocks,
+				 void (*cb_fn)(void *cb_arg, int status), void *cb_arg);
+
 /**
  * Get minimum I/O buffer address alignment for a bdev.
  *
@@ -1259,6 +1356,52 @@ int spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_chan
 				uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
 				struct spdk_bdev_ext_io_opts *opts);
 
+/** Read or write request submitted with spdk_bdev_submit_batch(). */
+struct spdk_bdev_batch_request {
+	/** SPDK_BDEV_IO_TYPE_READ or SPDK_BDEV_IO_TYPE_WRITE */
+	enum spdk_bdev_io_type		type;
+
+	/** The number of elements in iovs. */
+	int				iovcnt;
+
+	/** A scatter gather list of buffers. */
+	struct iovec			*iovs;
+
+	/** Separate metadata buffer, NULL if none. */
+	void				*md_buf;
+
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+
+	/** Called when the request is complete. */
+	spdk_bdev_io_completion_cb	cb;
+	void				*cb_arg;
+};
+
+/**
+ * Submit several read and write requests to the bdev on the given channel.
+ *
+ * Each request is processed as by spdk_bdev_readv_blocks_with_md() or
+ * spdk_bdev_writev_blocks_with_md().  The requests reaching the bdev module together
+ * are then handed to it in a single call, if the module supports it, so that it can
+ * notify the device once for all of them.
+ *
+ * \ingroup bdev_io_submit_functions
+ *
+ * \param desc Block device descriptor.
+ * \param ch I/O channel. Obtained by calling spdk_bdev_get_io_channel().
+ * \param reqs Array of requests.
+ * \param count The number of elements in reqs.
+ * \param num_submitted Set to the number of requests submitted. The callbacks of
+ * those requests will always be called, the ones of the remaining requests will not.
+ *
+ * \return 0 if all the requests were submitted, or the negated errno returned for
+ * the first request that failed to be submitted, as for spdk_bdev_readv_blocks_with_md().
+ */
+int spdk_bdev_submit_batch(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			   struct spdk_bdev_batch_request *reqs, uint32_t count,
+			   uint32_t *num_submitted);
+
 /**
  * Submit a compare request to the bdev on the given channel.
  *
@@ -1929,6 +2072,25 @@ typedef void (*spdk_bdev_histogram_status_cb)(void *cb_arg, int status);
 typedef void (*spdk_bdev_histogram_data_cb)(void *cb_arg, int status,
 		struct spdk_histogram_data *histogram);
 
+/**
+ * Number of I/O size buckets of the per-type histograms.  Bucket 0 holds the I/O of
+ * up to (1 << SPDK_BDEV_HISTOGRAM_SIZE_BUCKET_SHIFT) bytes, each following bucket
+ * doubles that size, and the last one holds all the larger I/O.  I/O types without
+ * a block range always go to bucket 0.
+ */
+#define SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS	8
+#define SPDK_BDEV_HISTOGRAM_SIZE_BUCKET_SHIFT	12
+
+/** Latency histograms of a bdev keyed by I/O type and size bucket */
+struct spdk_bdev_type_histograms {
+	/** NULL if no I/O of that type and size was completed */
+	struct spdk_histogram_data *histogram[SPDK_BDEV_NUM_IO_TYPES]
+	[SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS];
+};
+
+typedef void (*spdk_bdev_type_histograms_cb)(void *cb_arg, int status,
+		struct spdk_bdev_type_histograms *histograms);
+
 /**
  * Get the result of a previous seek function.
  * After calling spdk_bdev_seek_data or spdk_bdev_seek_hole, call this function
@@ -1976,6 +2138,41 @@ void spdk_bdev_histogram_get(struct spdk_bdev *bdev, struct spdk_histogram_data
 void spdk_bdev_channel_get_histogram(struct spdk_io_channel *ch, spdk_bdev_histogram_data_cb cb_fn,
 				     void *cb_arg);
 
+/**
+ * Enable or disable collecting latency histograms per I/O type and size on a bdev.
+ *
+ * \param bdev Block device.
+ * \param cb_fn Callback function to be called when histograms are enabled.
+ * \param cb_arg Argument to pass to cb_fn.
+ * \param enable Enable/disable flag
+ */
+void spdk_bdev_type_histograms_enable(struct spdk_bdev *bdev, spdk_bdev_histogram_status_cb cb_fn,
+				      void *cb_arg, bool enable);
+
+/**
+ * Get the per I/O type and size histograms of a bdev, merged over all its channels.
+ * The histograms passed to cb_fn are only valid during the execution of cb_fn.
+ *
+ * \param bdev Block device.
+ * \param reset Reset the histograms of the channels once they are merged.
+ * \param cb_fn Callback function to be called with data collected on bdev.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_bdev_type_histograms_get(struct spdk_bdev *bdev, bool reset,
+				   spdk_bdev_type_histograms_cb cb_fn, void *cb_arg);
+
+/**
+ * Get the per I/O type and size histograms of the specified channel for a bdev.
+ * The histograms passed to cb_fn are only valid during the execution of cb_fn.
+ *
+ * \param ch IO channel of bdev.
+ * \param reset Reset the histograms of the channel once cb_fn returns.
+ * \param cb_fn Callback function to process the histograms of the channel.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void spdk_bdev_channel_get_type_histograms(struct spdk_io_channel *ch, bool reset,
+		spdk_bdev_type_histograms_cb cb_fn, void *cb_arg);
+
 /**
  * Retrieves media events.  Can only be called from the context of
  * SPDK_BDEV_EVENT_MEDIA_MANAGEMENT event callback.  These events are sent by
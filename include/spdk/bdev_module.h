@@ -361,6 +361,15 @@ struct spdk_bdev_fn_table {
 
 	/** Check if bdev can handle spdk_accel_sequence to handle I/O of specific type. */
 	bool (*accel_sequence_supported)(void *ctx, enum spdk_bdev_io_type type);
+
+	/**
+	 * Process several I/O at once. Optional - may be NULL.
+	 *
+	 * Called instead of submit_request for the I/O reaching the module together
+	 * during spdk_bdev_submit_batch(). The array is only valid during the call.
+	 */
+	void (*submit_request_batch)(struct spdk_io_channel *ch, struct spdk_bdev_io **bdev_ios,
+				     uint32_t count);
 };
 
 /** bdev I/O completion status */
@@ -608,6 +617,15 @@ struct spdk_bdev {
 	/** function table for all LUN ops */
 	const struct spdk_bdev_fn_table *fn_table;
 
+	/**
+	 * NUMA socket the backing device is attached to. The id is valid only if id_valid is set
+	 * by the bdev module.
+	 */
+	struct {
+		uint32_t id : 31;
+		uint32_t id_valid : 1;
+	} numa;
+
 	/** Fields that are used internally by the bdev subsystem.  Bdev modules
 	 *  must not read or write to these fields.
 	 */
@@ -618,6 +636,18 @@ struct spdk_bdev {
 		/** True if the state of the QoS is being modified */
 		bool qos_mod_in_progress;
 
+		/** True if the QoS rate limits are enforced by each channel */
+		bool qos_sharded;
+
+		/** Latency QoS parameters */
+		struct spdk_bdev_latency_qos *latency_qos;
+
+		/** Time window in microseconds to coalesce adjacent I/O, 0 if disabled */
+		uint32_t coalesce_window_us;
+
+		/** Maximum size in blocks of a coalesced I/O */
+		uint32_t coalesce_max_blocks;
+
 		/**
 		 * SPDK spinlock protecting many of the internal fields of this structure. If
 		 * multiple locks need to be held, the following order must be used:
@@ -709,6 +739,15 @@ struct spdk_bdev {
 		/** accumulated I/O statistics for previously deleted channels of this bdev */
 		struct spdk_bdev_io_stat *stat;
 
+		/**
+		 * Monotonic I/O counters exported through the metrics library, periodically
+		 * updated by each thread with the activity of its channels.
+		 */
+		struct spdk_bdev_io_stat metrics_stat;
+
+		/** link in the list of bdevs exported through the metrics library */
+		TAILQ_ENTRY(spdk_bdev) metrics_link;
+
 		/** true if tracking the queue_depth of a device is in progress */
 		bool	qd_poll_in_progress;
 
@@ -716,6 +755,9 @@ struct spdk_bdev {
 		bool	histogram_enabled;
 		bool	histogram_in_progress;
 
+		/** per I/O type and size histograms enabled on this bdev */
+		bool	type_histograms_enabled;
+
 		/** Currently locked ranges for this bdev.  Used to populate new channels. */
 		lba_range_tailq_t locked_ranges;
 
@@ -815,6 +857,10 @@ struct spdk_bdev_io {
 			/** count of outstanding batched split I/Os */
 			uint32_t split_outstanding;
 
+			/** iov index and offset matching the current offset of the split I/O */
+			uint32_t split_iov_idx;
+			uint32_t split_iov_offset;
+
 			struct {
 				/** Whether the buffer should be populated with the real data */
 				uint8_t populate : 1;
@@ -969,6 +1015,9 @@ struct spdk_bdev_io {
 		struct iovec *orig_iovs;
 		int           orig_iovcnt;
 
+		/** Base bdev I/O lending its buffers to this zero-copy request */
+		struct spdk_bdev_io *zcopy_base_io;
+
 		/** Callback for when the aux buf is allocated */
 		spdk_bdev_io_get_aux_buf_cb get_aux_buf_cb;
 
@@ -1218,6 +1267,41 @@ void spdk_bdev_io_set_buf(struct spdk_bdev_io *bdev_io, void *buf, size_t len);
  */
 void spdk_bdev_io_set_md_buf(struct spdk_bdev_io *bdev_io, void *md_buf, size_t len);
 
+/**
+ * Forward a zero-copy request to the base bdev of a virtual bdev.
+ *
+ * In the start phase, the buffers exposed by the base bdev are lent to bdev_io, so that the
+ * caller reads or writes them directly instead of each bdev of the stack allocating its own.
+ * The base bdev's I/O is kept until the end phase, which is forwarded to it as well.  bdev_io
+ * is completed once the base bdev completes each phase.
+ *
+ * \param bdev_io Zero-copy I/O submitted to the virtual bdev, in either phase.
+ * \param desc Descriptor of the base bdev.
+ * \param ch I/O channel of the base bdev.
+ * \param offset_blocks Offset of the request on the base bdev, only used in the start phase.
+ *
+ * \return 0 on success, negative errno otherwise.  On -ENOMEM, the request may be resubmitted
+ * once an I/O becomes available, see spdk_bdev_queue_io_wait().
+ */
+int spdk_bdev_io_zcopy_forward(struct spdk_bdev_io *bdev_io, struct spdk_bdev_desc *desc,
+			       struct spdk_io_channel *ch, uint64_t offset_blocks);
+
+/**
+ * Start a batch of I/O completions on the current thread.
+ *
+ * Until spdk_bdev_io_complete_batch_end() is called, the completions of the I/O
+ * completed on this thread with spdk_bdev_io_complete() or one of its variants
+ * are held back.  They are then delivered grouped by channel, in the order they
+ * were completed in.  Batches may be nested, only the outermost one delivers the
+ * completions.
+ */
+void spdk_bdev_io_complete_batch_begin(void);
+
+/**
+ * End a batch of I/O completions started with spdk_bdev_io_complete_batch_begin().
+ */
+void spdk_bdev_io_complete_batch_end(void);
+
 /**
  * Complete a bdev_io
  *
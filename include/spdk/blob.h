@@ -302,8 +302,21 @@ struct spdk_bs_opts {
 	 * Context to pass with esnap_bs_dev_create.
 	 */
 	void *esnap_ctx;
+
+	/**
+	 * Number of blobs whose first metadata page spdk_bs_iter_first() and spdk_bs_iter_next()
+	 * read ahead of the blob they are opening, including the iteration done by spdk_bs_load().
+	 * 0 disables the read ahead.
+	 */
+	uint32_t iter_prefetch_depth;
+
+	/**
+	 * Size in MiB of the read cache shared by all esnap clones of the same external
+	 * snapshot. Each distinct external snapshot gets a cache of this size. 0 disables it.
+	 */
+	uint32_t esnap_cache_size_mb;
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 88, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 96, "Incorrect size");
 
 /**
  * Initialize a spdk_bs_opts structure to the default blobstore option values.
@@ -433,6 +446,25 @@ uint64_t spdk_bs_get_page_size(struct spdk_blob_store *bs);
  */
 uint64_t spdk_bs_get_io_unit_size(struct spdk_blob_store *bs);
 
+/**
+ * Set or remove the read cache of the blobstore.
+ *
+ * The read cache keeps the data of read-only blobs (snapshots) on a separate, faster device.
+ * Reads of a blob look it up by the blob that holds the data, so the clones of a snapshot
+ * share the cached data. Its content is not persistent and not kept across blobstore loads.
+ * On success the blobstore takes ownership of the device and destroys it when the cache is
+ * removed or the blobstore is unloaded. Must be called on the metadata thread.
+ *
+ * \param bs blobstore.
+ * \param cache_dev Device to keep the cache on, or NULL to remove the read cache.
+ * \param cb_fn Called when the cache is set on all channels of the blobstore. -EBUSY if a
+ * cache is already set, -ENOENT if there is no cache to remove, -EINVAL if the block size
+ * of the device doesn't fit the blobstore.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_bs_set_read_cache(struct spdk_blob_store *bs, struct spdk_bs_dev *cache_dev,
+			    spdk_bs_op_complete cb_fn, void *cb_arg);
+
 /**
  * Get the number of free clusters.
  *
@@ -761,6 +793,53 @@ void spdk_bs_inflate_blob(struct spdk_blob_store *bs, struct spdk_io_channel *ch
 void spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
 				  spdk_blob_id blobid, spdk_blob_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Copy clusters of a clone from its parent in the background.
+ *
+ * The listed clusters that are still unallocated in the blob, but hold data in the
+ * parent, are allocated and copied one at a time. Once a cluster is prefilled, a
+ * foreground write to it no longer has to wait for the copy. Clusters allocated by
+ * the foreground I/O in the meantime are skipped. Other operations that lock the
+ * blob, such as resize, snapshot or inflate, fail with -EBUSY until it completes.
+ *
+ * The blob must be kept open until cb_fn is called.
+ *
+ * \param blob Thin provisioned blob with a parent.
+ * \param channel IO channel used to copy the clusters.
+ * \param clusters Clusters to prefill in that order, e.g. the recently written ones.
+ * NULL prefills all clusters of the blob.
+ * \param num_clusters Number of entries in clusters. Ignored if clusters is NULL.
+ * \param clusters_per_sec Maximum number of clusters copied per second. 0 copies the
+ * clusters back to back.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_blob_prefill_clusters(struct spdk_blob *blob, struct spdk_io_channel *channel,
+				const uint64_t *clusters, uint64_t num_clusters, uint32_t clusters_per_sec,
+				spdk_blob_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Move the clusters of a blob next to each other in the background.
+ *
+ * The clusters are walked in blob order. A cluster that doesn't follow the previous one
+ * on disk is moved right after it, if that cluster of the blobstore is free. The I/O to
+ * the blob is frozen and drained while a cluster is copied and the metadata pointing to
+ * its new location is written out, so each move is atomic. Other operations that lock the
+ * blob, such as resize, snapshot, clone or inflate, fail with -EBUSY until it completes.
+ * A blob that has clones can't be defragmented and fails with -EBUSY.
+ *
+ * The blob must be kept open until cb_fn is called.
+ *
+ * \param blob Blob to defragment.
+ * \param channel IO channel used to copy the clusters.
+ * \param clusters_per_sec Maximum number of clusters moved per second. 0 moves the
+ * clusters back to back.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_blob_defragment(struct spdk_blob *blob, struct spdk_io_channel *channel,
+			  uint32_t clusters_per_sec, spdk_blob_op_complete cb_fn, void *cb_arg);
+
 struct spdk_blob_open_opts {
 	enum blob_clear_method  clear_method;
 
@@ -332,6 +332,37 @@ int spdk_file_write(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 int64_t spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 		       void *payload, uint64_t offset, uint64_t length);
 
+/**
+ * Read request of spdk_file_read_batch().
+ */
+struct spdk_file_read_req {
+	/** Buffer which will store the obtained data */
+	void		*payload;
+	/** The beginning position to read */
+	uint64_t	offset;
+	/** The size in bytes of data to read */
+	uint64_t	length;
+	/** Set on completion to the number of bytes read, or negated errno on failure */
+	int64_t		rc;
+};
+
+/**
+ * Read several ranges of the given file to user buffers.
+ *
+ * All the reads are submitted before waiting for any of them, so the reads that miss the
+ * cache are outstanding together instead of one after the other.
+ *
+ * \param file File to read.
+ * \param ctx The thread context for this operation
+ * \param reqs Array of read requests, the result of each is set in its rc.
+ * \param num_reqs Number of read requests.
+ *
+ * \return 0 if all the reads succeeded, the negated errno of the first one that failed
+ * otherwise.
+ */
+int spdk_file_read_batch(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
+			 struct spdk_file_read_req *reqs, size_t num_reqs);
+
 /**
  * Set cache size for the blobstore filesystem.
  *
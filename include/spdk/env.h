@@ -445,6 +445,16 @@ uint32_t spdk_mempool_mem_iter(struct spdk_mempool *mp, spdk_mempool_mem_cb_t me
  */
 struct spdk_mempool *spdk_mempool_lookup(const char *name);
 
+/**
+ * Get the memory pool an element belongs to.
+ *
+ * \param ele Element obtained from one of the memory pools through spdk_mempool_get() or
+ * spdk_mempool_get_bulk().
+ *
+ * \return a pointer to the memory pool owning the element.
+ */
+struct spdk_mempool *spdk_mempool_from_obj(void *ele);
+
 /**
  * Get the number of dedicated CPU cores utilized by this env abstraction.
  *
@@ -644,6 +654,24 @@ bool spdk_iommu_is_enabled(void);
  */
 uint64_t spdk_vtophys(const void *buf, uint64_t *size);
 
+/**
+ * Get the physical addresses of all buffers in an iovec array.
+ *
+ * Each buffer must be physically contiguous. Lookups that fall into the same
+ * 2MB region as the previous one on the calling thread are served from a
+ * per-thread cache, so this is cheaper than calling spdk_vtophys() for every
+ * element.
+ *
+ * \param iovs Array of buffers to translate.
+ * \param iovcnt Number of elements in iovs.
+ * \param phys_addrs Array of at least iovcnt elements that is filled with the
+ * physical address of each buffer.
+ *
+ * \return 0 on success, or -EFAULT if any buffer could not be translated or is
+ * not physically contiguous. The contents of phys_addrs are undefined on failure.
+ */
+int spdk_vtophys_iovs(const struct iovec *iovs, int iovcnt, uint64_t *phys_addrs);
+
 struct spdk_pci_addr {
 	uint32_t			domain;
 	uint8_t				bus;
@@ -168,8 +168,26 @@ struct spdk_app_opts {
 	 */
 	const char *lcore_map; /* lcore mapping */
 
+	/**
+	 * Poll the RPC server on a dedicated thread, so that only the RPC methods run on the
+	 * app thread.
+	 *
+	 * Default is `false`.
+	 */
+	bool rpc_thread;
+
+	/* Hole at bytes 225-227. */
+	uint8_t reserved225[3];
+
+	/**
+	 * Data structure used by the threads to keep track of their timed pollers.
+	 *
+	 * Default is `SPDK_THREAD_TIMER_RBTREE`.
+	 */
+	enum spdk_thread_timer_type thread_timer_type;
+
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_app_opts) == 224, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_app_opts) == 232, "Incorrect size");
 
 /**
  * Initialize the default value of opts
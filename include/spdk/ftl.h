@@ -69,6 +69,30 @@ struct ftl_stats {
 	uint64_t		io_activity_total;
 
 	struct ftl_stats_entry	entries[FTL_STATS_TYPE_MAX];
+
+	/* Number of bands picked for relocation by GC and the number of
+	 * blocks still valid in them at that time, i.e. the blocks GC had to move
+	 * to reclaim the bands.
+	 */
+	uint64_t		gc_bands;
+	uint64_t		gc_valid_blocks;
+
+	/* Number of L2P pages found in the L2P cache and the number of pages
+	 * that had to be read from the device when pinning them. Both stay at 0
+	 * when the whole L2P is kept in memory.
+	 */
+	uint64_t		l2p_cache_hits;
+	uint64_t		l2p_cache_misses;
+
+	/* Number of NV cache chunks compacted so far. The remaining fields
+	 * describe the current state of the NV cache: the total number of chunks,
+	 * the number of free chunks and the number of full chunks waiting for
+	 * compaction.
+	 */
+	uint64_t		nv_cache_chunks_compacted;
+	uint64_t		nv_cache_chunks;
+	uint64_t		nv_cache_chunks_free;
+	uint64_t		nv_cache_chunks_full;
 };
 
 typedef void (*spdk_ftl_stats_fn)(struct ftl_stats *stats, void *cb_arg);
@@ -109,10 +133,10 @@ struct spdk_ftl_conf {
 
 		/* Percentage of chunks to maintain free */
 		uint32_t			chunk_free_target;
-	} nv_cache;
 
-	/* Hole at bytes 0x60 - 0x67. */
-	uint8_t					reserved[4];
+		/* Number of compaction processes moving data to the base device in parallel */
+		uint32_t			compactors;
+	} nv_cache;
 
 	/* Name of base block device (zoned or non-zoned) */
 	char					*base_bdev;
@@ -29,6 +29,17 @@ extern "C" {
  */
 int spdk_rpc_initialize(const char *listen_addr);
 
+/**
+ * Like spdk_rpc_initialize(), but poll the JSON-RPC server on a dedicated (non-SPDK) thread.
+ * Accepting connections, receiving and parsing the requests and sending the responses are
+ * done on that thread, while the RPC methods are still called on the calling thread.
+ *
+ * \param listen_addr Path to a unix domain socket to listen on
+ *
+ * \return Negated errno on failure. 0 on success.
+ */
+int spdk_rpc_initialize_threaded(const char *listen_addr);
+
 /**
  * Shut down the SPDK JSON-RPC target
  */
@@ -50,10 +61,11 @@ void spdk_subsystem_init(spdk_subsystem_init_fn cb_fn, void *cb_arg);
 
 /**
  * Like spdk_subsystem_init, but additionally configure each subsystem using the provided JSON config
- * file. This will automatically start a JSON RPC server and then stop it.
+ * file. The file is streamed and the RPC methods of its entries are called directly, without
+ * going through an RPC server.
  *
  * \param json_config_file Path to a JSON config file.
- * \param rpc_addr Path to a unix domain socket to send configuration RPCs to.
+ * \param rpc_addr Unused, the configuration RPCs are no longer sent over a socket.
  * \param cb_fn Function called when the process is complete.
  * \param cb_arg User context passed to cb_fn.
  * \param stop_on_error Whether to stop initialization if one of the JSON RPCs fails.
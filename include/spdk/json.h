@@ -108,6 +108,75 @@ struct spdk_json_val {
 ssize_t spdk_json_parse(void *json, size_t size, struct spdk_json_val *values, size_t num_values,
 			void **end, uint32_t flags);
 
+/**
+ * Function called by a JSON stream to read more data.
+ *
+ * \param cb_ctx Context passed to spdk_json_stream_create().
+ * \param buf Buffer to read the data into.
+ * \param size Size of the buffer in bytes.
+ *
+ * \return Number of bytes read, 0 at the end of the data, or negative errno on failure.
+ */
+typedef ssize_t (*spdk_json_stream_read_fn)(void *cb_ctx, void *buf, size_t size);
+
+/**
+ * Incremental JSON parser, which reads the data in chunks and returns it one token or one
+ * value at a time, so that large documents can be processed without reading them entirely
+ * into memory.
+ */
+struct spdk_json_stream;
+
+/**
+ * Create a JSON stream.
+ *
+ * \param read_fn Function called to read the JSON data.
+ * \param cb_ctx Context passed to read_fn.
+ * \param flags SPDK_JSON_PARSE_FLAG_* flags.
+ *
+ * \return a pointer to the stream or NULL on failure.
+ */
+struct spdk_json_stream *spdk_json_stream_create(spdk_json_stream_read_fn read_fn, void *cb_ctx,
+		uint32_t flags);
+
+/**
+ * Free a JSON stream.
+ *
+ * \param stream Stream to free. If NULL, no operation is performed.
+ */
+void spdk_json_stream_free(struct spdk_json_stream *stream);
+
+/**
+ * Get the next token of a JSON stream.
+ *
+ * Objects and arrays are returned as separate SPDK_JSON_VAL_{OBJECT,ARRAY}_{BEGIN,END} tokens
+ * (with len set to 0), names as SPDK_JSON_VAL_NAME and other values as a single token.  The
+ * token is only valid until the next call on the stream.
+ *
+ * \param stream JSON stream.
+ * \param val Filled with the token.
+ *
+ * \return 1 if a token was returned, 0 at the end of the data, or negative on failure:
+ * SPDK_JSON_PARSE_INVALID, SPDK_JSON_PARSE_INCOMPLETE, SPDK_JSON_PARSE_MAX_DEPTH_EXCEEDED or
+ * negative errno returned by the read function.
+ */
+int spdk_json_stream_next(struct spdk_json_stream *stream, struct spdk_json_val *val);
+
+/**
+ * Parse the next complete value of a JSON stream, e.g. an element of an array or the value
+ * following a name returned by spdk_json_stream_next().  This can be mixed with
+ * spdk_json_stream_next() to skip values or to process the elements of large arrays one at
+ * a time.  The values are only valid until the next call on the stream.
+ *
+ * \param stream JSON stream.
+ * \param values Filled with a pointer to the parsed values, in the format used by
+ * spdk_json_parse().
+ *
+ * \return Number of values parsed, 0 if the enclosing array ended instead (its
+ * SPDK_JSON_VAL_ARRAY_END token is consumed), or negative on failure (see
+ * spdk_json_stream_next()).
+ */
+ssize_t spdk_json_stream_next_value(struct spdk_json_stream *stream, struct spdk_json_val **values);
+
 typedef int (*spdk_json_decode_fn)(const struct spdk_json_val *val, void *out);
 
 struct spdk_json_object_decoder {
@@ -110,11 +110,42 @@ int spdk_jsonrpc_server_poll(struct spdk_jsonrpc_server *server);
  */
 void spdk_jsonrpc_server_shutdown(struct spdk_jsonrpc_server *server);
 
+/**
+ * Callback receiving the response to a local JSON-RPC request.
+ *
+ * \param cb_arg Argument passed to spdk_jsonrpc_handle_local_request().
+ * \param resp Response to the request.  If the response couldn't be generated, both its
+ * result and error are NULL.  The response is only valid for the duration of the callback.
+ */
+typedef void (*spdk_jsonrpc_local_response_fn)(void *cb_arg,
+		struct spdk_jsonrpc_client_response *resp);
+
+/**
+ * Handle a JSON-RPC request locally, without going through a JSON-RPC server.
+ *
+ * The request is handled by the same user callback that the server would use.  Its response
+ * isn't sent anywhere, but passed to cb_fn, which might be called from any thread (the one
+ * the handler responds on) and even before this function returns.
+ *
+ * \param handle_request User callback to handle the request.
+ * \param method Method of the request, must be a JSON string.
+ * \param params Parameters of the request, NULL if there are none.  Must remain valid until
+ * cb_fn is called.
+ * \param cb_fn Callback receiving the response.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, negated errno on failure, in which case cb_fn won't be called.
+ */
+int spdk_jsonrpc_handle_local_request(spdk_jsonrpc_handle_request_fn handle_request,
+				      const struct spdk_json_val *method,
+				      const struct spdk_json_val *params,
+				      spdk_jsonrpc_local_response_fn cb_fn, void *cb_arg);
+
 /**
  * Return connection associated to \c request
  *
  * \param request JSON-RPC request
- * \return JSON RPC server connection
+ * \return JSON RPC server connection, NULL for local requests
  */
 struct spdk_jsonrpc_server_conn *spdk_jsonrpc_get_conn(struct spdk_jsonrpc_request *request);
 
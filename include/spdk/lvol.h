@@ -373,6 +373,36 @@ void spdk_lvol_inflate(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void
  */
 void spdk_lvol_decouple_parent(struct spdk_lvol *lvol, spdk_lvol_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Defragment lvol
+ *
+ * Clusters of the lvol are moved next to each other in the lvol store, where free
+ * clusters allow it. The lvol stays online, its I/O is only held while a cluster
+ * is being moved.
+ *
+ * \param lvol Handle to lvol
+ * \param clusters_per_sec Maximum number of clusters moved per second, 0 for no limit
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void spdk_lvol_defragment(struct spdk_lvol *lvol, uint32_t clusters_per_sec,
+			  spdk_lvol_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Prefill lvol
+ *
+ * Clusters of a clone lvol that hold data in its parent are copied in the
+ * background, so that the first write to each of them doesn't have to wait for
+ * the copy. The lvol stays thin provisioned and keeps its parent.
+ *
+ * \param lvol Handle to lvol
+ * \param clusters_per_sec Maximum number of clusters copied per second, 0 for no limit
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void spdk_lvol_prefill(struct spdk_lvol *lvol, uint32_t clusters_per_sec,
+		       spdk_lvol_op_complete cb_fn, void *cb_arg);
+
 /**
  * Determine if an lvol is degraded. A degraded lvol cannot perform IO.
  *
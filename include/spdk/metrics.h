@@ -0,0 +1,140 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+/** \file
+ * Metrics exporter
+ *
+ * Libraries register metrics sources, which are called to write their current values in the
+ * OpenMetrics text format whenever the metrics are scraped.  The metrics are served over HTTP by
+ * a dedicated (non-SPDK) thread, so scraping them doesn't involve the reactors.  Because of that,
+ * the sources are called on that thread and may only access data that is safe to read from any
+ * thread, e.g. counters aggregated periodically by the threads that own them.
+ */
+
+#ifndef SPDK_METRICS_H
+#define SPDK_METRICS_H
+
+#include "spdk/stdinc.h"
+#include "spdk/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Buffer the metrics are written to. */
+struct spdk_metrics_writer;
+
+enum spdk_metrics_type {
+	/** Monotonically increasing value */
+	SPDK_METRICS_COUNTER,
+	/** Value that can go up and down */
+	SPDK_METRICS_GAUGE,
+};
+
+/**
+ * Function writing the current values of the metrics of a source.
+ *
+ * \param w Writer to be used.
+ */
+typedef void (*spdk_metrics_collect_fn)(struct spdk_metrics_writer *w);
+
+/**
+ * Function called on the SPDK thread starting or stopping the metrics server, e.g. to start or
+ * stop the pollers aggregating the values of a source, so that they don't run while the metrics
+ * aren't exported.
+ */
+typedef void (*spdk_metrics_server_fn)(void);
+
+struct spdk_metrics_source {
+	const char			*name;
+	spdk_metrics_collect_fn		collect;
+	/* Optional, called when the metrics server is started */
+	spdk_metrics_server_fn		start;
+	/* Optional, called when the metrics server is stopped */
+	spdk_metrics_server_fn		stop;
+	TAILQ_ENTRY(spdk_metrics_source) tailq;
+};
+
+/**
+ * Register a metrics source.  Usually called through SPDK_METRICS_SOURCE_REGISTER().
+ *
+ * \param source Source to register.
+ */
+void spdk_metrics_source_register(struct spdk_metrics_source *source);
+
+/**
+ * Start a metric family.  Must be called before writing the values of a metric.  The name
+ * is prefixed with "spdk_" and, for counters, suffixed with "_total" in the values.
+ *
+ * \param w Writer to be used.
+ * \param name Name of the metric family.
+ * \param type Type of the metric.
+ * \param help Description of the metric.
+ */
+void spdk_metrics_write_family(struct spdk_metrics_writer *w, const char *name,
+			       enum spdk_metrics_type type, const char *help);
+
+/**
+ * Write a value of the current metric family.
+ *
+ * \param w Writer to be used.
+ * \param label Name of the label identifying the value (e.g. "bdev"), NULL if there's none.
+ * \param label_value Value of the label.
+ * \param value Value of the metric.
+ */
+void spdk_metrics_write_value(struct spdk_metrics_writer *w, const char *label,
+			      const char *label_value, uint64_t value);
+
+/**
+ * Start serving the metrics over HTTP at http://<addr>:<port>/metrics.  Must be called from an
+ * SPDK thread, the start callbacks of the sources are called on it.
+ *
+ * \param addr Address to listen on.
+ * \param port Port to listen on.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_metrics_server_start(const char *addr, uint16_t port);
+
+/**
+ * Stop serving the metrics.  Must be called from the SPDK thread that started the server.
+ */
+void spdk_metrics_server_stop(void);
+
+/**
+ * Register a metrics source at startup.
+ *
+ * \param _name Name of the source.
+ * \param _collect Function writing the metrics of the source.
+ */
+#define SPDK_METRICS_SOURCE_REGISTER(_name, _collect) \
+	SPDK_METRICS_SOURCE_REGISTER_EXT(_name, _collect, NULL, NULL)
+
+/**
+ * Register a metrics source at startup, with functions called when the server is started and
+ * stopped.
+ *
+ * \param _name Name of the source.
+ * \param _collect Function writing the metrics of the source.
+ * \param _start Function called when the metrics server is started, may be NULL.
+ * \param _stop Function called when the metrics server is stopped, may be NULL.
+ */
+#define SPDK_METRICS_SOURCE_REGISTER_EXT(_name, _collect, _start, _stop) \
+static struct spdk_metrics_source metrics_source_ ## _collect = { \
+	.name = _name, \
+	.collect = _collect, \
+	.start = _start, \
+	.stop = _stop, \
+}; \
+__attribute__((constructor)) static void metrics_source_ ## _collect ## _register(void) \
+{ \
+	spdk_metrics_source_register(&metrics_source_ ## _collect); \
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPDK_METRICS_H */
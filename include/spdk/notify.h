@@ -40,6 +40,11 @@ struct spdk_notify_event {
 typedef int (*spdk_notify_foreach_event_cb)(uint64_t idx, const struct spdk_notify_event *event,
 		void *ctx);
 
+/**
+ * Opaque listener of events, with a ring of its own.
+ */
+struct spdk_notify_listener;
+
 /**
  * Register \c type as new notification type.
  *
@@ -91,6 +96,55 @@ uint64_t spdk_notify_send(const char *type, const char *ctx);
 uint64_t spdk_notify_foreach_event(uint64_t start_idx, uint64_t max,
 				   spdk_notify_foreach_event_cb cb_fn, void *ctx);
 
+/**
+ * Start listening for events of the given types.
+ *
+ * Events of these types sent from now on are copied to a ring of the listener, from which they
+ * are retrieved by spdk_notify_listener_poll(). Unlike spdk_notify_foreach_event(), this doesn't
+ * take the lock protecting the event bus, so it's cheap enough to be called from a poller of the
+ * thread owning the listener. The listener is meant to be polled by a single thread at a time.
+ *
+ * \note This function is thread safe.
+ *
+ * \param types Names of the notification types to listen for, NULL to listen for all types.
+ * \param num_types Number of elements in \c types.
+ * \param ring_size Number of events the ring of the listener holds. Must be a power of 2. Events
+ * sent while the ring is full are dropped.
+ * \param cb_fn Callback called by spdk_notify_listener_poll() for each event.
+ * \param ctx User context passed to \c cb_fn.
+ * \return New listener or NULL on failure.
+ */
+struct spdk_notify_listener *spdk_notify_listen(const char **types, uint32_t num_types,
+		uint32_t ring_size, spdk_notify_foreach_event_cb cb_fn, void *ctx);
+
+/**
+ * Call the callback of the listener with the events queued in its ring.
+ *
+ * \param listener Listener to poll.
+ * \param max Maximum number of invocations of the callback.
+ * \return Number of events retrieved from the ring, including the one the callback returned
+ * non-zero for.
+ */
+uint32_t spdk_notify_listener_poll(struct spdk_notify_listener *listener, uint32_t max);
+
+/**
+ * Get the number of events dropped because the ring of the listener was full.
+ *
+ * \param listener Listener we are talking about.
+ * \return Number of dropped events.
+ */
+uint64_t spdk_notify_listener_get_dropped(const struct spdk_notify_listener *listener);
+
+/**
+ * Stop listening for events and free the listener.
+ *
+ * \note This function is thread safe, but must not race with spdk_notify_listener_poll() on the
+ * same listener.
+ *
+ * \param listener Listener to free.
+ */
+void spdk_notify_unlisten(struct spdk_notify_listener *listener);
+
 #ifdef __cplusplus
 }
 #endif
@@ -283,8 +283,16 @@ struct spdk_nvme_ctrlr_opts {
 	 * Set the IP protocol type of service value for RDMA transport. Default is 0, which means that the TOS will not be set.
 	 */
 	uint8_t transport_tos;
+
+	/**
+	 * Align the splits of write commands to the optimal write size, or else to the preferred
+	 * write granularity, of the namespace when it is a power of 2.
+	 *
+	 * Default is `false` (writes are split on the maximum transfer size only).
+	 */
+	bool align_write_splits;
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_ctrlr_opts) == 818, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_ctrlr_opts) == 819, "Incorrect size");
 
 /**
  * NVMe acceleration operation callback.
@@ -538,6 +546,11 @@ struct spdk_nvme_tcp_stat {
 	uint64_t nvme_completions;
 	uint64_t submitted_requests;
 	uint64_t queued_requests;
+	/* Data digests verified through accel, and the number of batches they were submitted in */
+	uint64_t data_digests;
+	uint64_t data_digest_batches;
+	/* Payload reads which also received the start of the next PDU */
+	uint64_t recv_lookaheads;
 };
 
 struct spdk_nvme_transport_poll_group_stat {
@@ -1594,8 +1607,27 @@ struct spdk_nvme_io_qpair_opts {
 	 */
 	bool async_mode;
 
-	/* Hole at bytes 66-71. */
-	uint8_t reserved66[6];
+	/**
+	 * When delay_cmd_submit is set, the doorbell is also rung as soon as this many
+	 * commands are pending submission, instead of waiting for the next call to
+	 * spdk_nvme_qpair_process_completions().  0 means no limit, which is the default.
+	 *
+	 * This only applies to PCIe transport.
+	 */
+	uint16_t delay_cmd_submit_batch_size;
+
+	/**
+	 * Attach the submission queue of this qpair to a completion queue shared with the
+	 * other qpairs of the same controller in the same poll group, instead of creating
+	 * a completion queue for each qpair.  The qpair must be added to a poll group before
+	 * it is connected, otherwise this flag is ignored.  Default is false.
+	 *
+	 * This only applies to PCIe transport.
+	 */
+	bool shared_cq;
+
+	/* Hole at bytes 69-71. */
+	uint8_t reserved69[3];
 } __attribute__((packed));
 SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_io_qpair_opts) == 72, "Incorrect size");
 
@@ -2930,6 +2962,27 @@ enum spdk_nvme_dealloc_logical_block_read_value spdk_nvme_ns_get_dealloc_logical
  */
 uint32_t spdk_nvme_ns_get_optimal_io_boundary(struct spdk_nvme_ns *ns);
 
+/**
+ * Get the preferred write granularity, in blocks, for the given namespace.
+ *
+ * Writes which are a multiple of this size, and aligned to it, avoid read-modify-write
+ * cycles in the controller.
+ *
+ * \param ns Namespace to query.
+ *
+ * \return the Namespace Preferred Write Granularity, in blocks, or 0 if it is not reported.
+ */
+uint32_t spdk_nvme_ns_get_preferred_write_granularity(struct spdk_nvme_ns *ns);
+
+/**
+ * Get the optimal write size, in blocks, for the given namespace.
+ *
+ * \param ns Namespace to query.
+ *
+ * \return the Namespace Optimal Write Size, in blocks, or 0 if it is not reported.
+ */
+uint32_t spdk_nvme_ns_get_optimal_write_size(struct spdk_nvme_ns *ns);
+
 /**
  * Get the NGUID for the given namespace.
  *
@@ -4023,6 +4076,17 @@ int spdk_nvme_cuse_unregister(struct spdk_nvme_ctrlr *ctrlr);
 int spdk_nvme_ctrlr_get_memory_domains(const struct spdk_nvme_ctrlr *ctrlr,
 				       struct spdk_memory_domain **domains, int array_size);
 
+/**
+ * Get the NUMA node of the local device used to access the controller, i.e. the NVMe
+ * device itself for PCIe or the RDMA device for RDMA.
+ *
+ * \param ctrlr Opaque handle to the NVMe controller.
+ *
+ * \return the NUMA node ID, or SPDK_ENV_SOCKET_ID_ANY if it is unknown or the transport
+ * doesn't report it.
+ */
+int32_t spdk_nvme_ctrlr_get_socket_id(struct spdk_nvme_ctrlr *ctrlr);
+
 /**
  * Opaque handle for a transport poll group. Used by the transport function table.
  */
@@ -4156,6 +4220,8 @@ struct spdk_nvme_transport_ops {
 	int (*ctrlr_ready)(struct spdk_nvme_ctrlr *ctrlr);
 
 	volatile struct spdk_nvme_registers *(*ctrlr_get_registers)(struct spdk_nvme_ctrlr *ctrlr);
+
+	int32_t (*ctrlr_get_socket_id)(struct spdk_nvme_ctrlr *ctrlr);
 };
 
 /**
@@ -4194,8 +4260,16 @@ struct spdk_nvme_transport_opts {
 	 * structure are valid. And the library will populate any remaining fields with default values.
 	 */
 	size_t opts_size;
+
+	/**
+	 * It is used for RDMA transport.
+	 *
+	 * Only one out of this many sends of a qpair is signaled. The send queue entries of the
+	 * others are retired by its completion. 0 or 1 means that all sends are signaled.
+	 */
+	uint32_t rdma_send_signal_interval;
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_transport_opts) == 12, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvme_transport_opts) == 16, "Incorrect size");
 
 /**
  * Get the current NVMe transport options.
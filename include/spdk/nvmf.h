@@ -130,6 +130,28 @@ struct spdk_nvmf_poll_group_stat {
 	uint64_t pending_bdev_io;
 	/* NVMe IO commands completed (excludes admin commands) */
 	uint64_t completed_nvme_io;
+	/* CONNECT commands completed, including the failed ones */
+	uint64_t connects;
+	uint64_t failed_connects;
+	/* cumulative and maximum CONNECT latency, in ticks */
+	uint64_t connect_latency_ticks;
+	uint64_t max_connect_latency_ticks;
+};
+
+/*
+ * NVMe IO accounting, kept per namespace in each poll group and per qpair (i.e. host).
+ * Operations and bytes only count successful commands, failed ones count as errors.
+ */
+struct spdk_nvmf_io_stat {
+	uint64_t bytes_read;
+	uint64_t num_read_ops;
+	uint64_t bytes_written;
+	uint64_t num_write_ops;
+	uint64_t num_other_ops;
+	uint64_t num_errors;
+	uint64_t read_latency_ticks;
+	uint64_t write_latency_ticks;
+	uint64_t other_latency_ticks;
 };
 
 /**
@@ -285,6 +307,37 @@ void spdk_nvmf_poll_group_destroy(struct spdk_nvmf_poll_group *group,
 int spdk_nvmf_poll_group_add(struct spdk_nvmf_poll_group *group,
 			     struct spdk_nvmf_qpair *qpair);
 
+/**
+ * Function to be called once a qpair has been moved to another poll group.
+ *
+ * \param cb_arg Callback argument passed to this function.
+ * \param status 0 if the qpair was moved, or negative errno if it failed.
+ */
+typedef void (*spdk_nvmf_poll_group_migrate_done_fn)(void *cb_arg, int status);
+
+/**
+ * Move an I/O qpair to another poll group without disconnecting it. The qpair
+ * stops processing new commands, waits for the ones in flight to complete and
+ * then continues on the thread of the new poll group.
+ *
+ * This function must be called from the thread of the qpair's poll group. It must
+ * not be used while the poll groups are being destroyed.
+ *
+ * \param qpair The qpair to move.
+ * \param group The poll group to move the qpair to.
+ * \param cb_fn A callback that will be called, on the calling thread, once the qpair is moved.
+ * \param cb_arg A context argument passed to cb_fn.
+ *
+ * \return 0 if the qpair is being moved.
+ * \return -ENOTSUP if the transport of the qpair doesn't support it.
+ * \return -EINVAL if the qpair is an admin qpair or already belongs to the group.
+ * \return -EBUSY if the qpair isn't active or is already being moved.
+ * \return -ENOMEM if the function specific context could not be allocated.
+ */
+int spdk_nvmf_poll_group_migrate_qpair(struct spdk_nvmf_qpair *qpair,
+				       struct spdk_nvmf_poll_group *group,
+				       spdk_nvmf_poll_group_migrate_done_fn cb_fn, void *cb_arg);
+
 typedef void (*nvmf_qpair_disconnect_cb)(void *ctx);
 
 /**
@@ -902,6 +955,45 @@ struct spdk_bdev *spdk_nvmf_ns_get_bdev(struct spdk_nvmf_ns *ns);
 void spdk_nvmf_ns_get_opts(const struct spdk_nvmf_ns *ns, struct spdk_nvmf_ns_opts *opts,
 			   size_t opts_size);
 
+/** Namespace QoS rate limit type */
+enum spdk_nvmf_ns_qos_rate_limit_type {
+	/** IOPS rate limit for both read and write */
+	SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT = 0,
+	/** Megabyte per second rate limit for both read and write */
+	SPDK_NVMF_NS_QOS_RW_BPS_RATE_LIMIT,
+	/** Megabyte per second rate limit for read only */
+	SPDK_NVMF_NS_QOS_R_BPS_RATE_LIMIT,
+	/** Megabyte per second rate limit for write only */
+	SPDK_NVMF_NS_QOS_W_BPS_RATE_LIMIT,
+	/** Keep last */
+	SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES
+};
+
+/**
+ * Set the QoS rate limits of a namespace.
+ *
+ * The limits are shared by all the hosts accessing the namespace. Unlike the bdev QoS, they
+ * are enforced by the transports before any data buffer is allocated or any data transfer is
+ * started for a read or a write, so the throttled IO doesn't hold resources shared with the
+ * other namespaces.
+ *
+ * \param ns Namespace to set the limits of.
+ * \param limits Rate limits ordered based on the @ref spdk_nvmf_ns_qos_rate_limit_type enum,
+ * 0 for no limit.
+ *
+ * \return 0 on success, or negated errno on failure.
+ */
+int spdk_nvmf_ns_set_qos_rate_limits(struct spdk_nvmf_ns *ns, const uint64_t *limits);
+
+/**
+ * Get the QoS rate limits of a namespace.
+ *
+ * \param ns Namespace to query.
+ * \param limits Output parameter for the rate limits ordered based on the
+ * @ref spdk_nvmf_ns_qos_rate_limit_type enum, 0 for no limit.
+ */
+void spdk_nvmf_ns_get_qos_rate_limits(const struct spdk_nvmf_ns *ns, uint64_t *limits);
+
 /**
  * Get the serial number of the specified subsystem.
  *
@@ -1148,6 +1240,34 @@ typedef void (*spdk_nvmf_tgt_resume_polling_cb_fn)(void *cb_arg, int status);
 int spdk_nvmf_tgt_resume_polling(struct spdk_nvmf_tgt *tgt,
 				 spdk_nvmf_tgt_resume_polling_cb_fn cb_fn, void *cb_arg);
 
+/**
+ * Function to be called once the qpairs of a target are rebalanced.
+ *
+ * \param cb_arg Callback argument passed to this function.
+ * \param status The number of qpairs moved, or negative errno if it failed.
+ */
+typedef void (*spdk_nvmf_tgt_rebalance_qpairs_cb_fn)(void *cb_arg, int status);
+
+/**
+ * Rebalance the I/O qpairs between the poll groups of the given target.
+ *
+ * The load of a poll group is the number of NVMe I/O commands completed by its
+ * qpairs since the previous call. If the gap between the most and the least
+ * loaded poll groups is large enough, the qpair of the most loaded group whose
+ * move narrows that gap the most is moved to the least loaded one, see
+ * spdk_nvmf_poll_group_migrate_qpair(). Calling this function periodically
+ * spreads long-lived connections according to their actual load.
+ *
+ * \param tgt The target to rebalance.
+ * \param cb_fn A callback that will be called once the rebalance is done.
+ * \param cb_arg A context argument passed to cb_fn.
+ *
+ * \return 0 if the rebalance was started, -EBUSY if one is already in progress, or
+ * -ENOMEM if the function specific context could not be allocated.
+ */
+int spdk_nvmf_tgt_rebalance_qpairs(struct spdk_nvmf_tgt *tgt,
+				   spdk_nvmf_tgt_rebalance_qpairs_cb_fn cb_fn, void *cb_arg);
+
 /**
  * Add listener to transport and begin accepting new connections.
  *
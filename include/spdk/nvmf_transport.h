@@ -100,6 +100,9 @@ struct spdk_nvmf_request {
 	enum spdk_nvmf_zcopy_phase	zcopy_phase;
 
 	TAILQ_ENTRY(spdk_nvmf_request)	link;
+
+	/* Tick at which an IO command was submitted to its namespace */
+	uint64_t			io_start_tsc;
 };
 
 enum spdk_nvmf_qpair_state {
@@ -125,6 +128,14 @@ struct spdk_nvmf_qpair {
 	uint16_t				sq_head_max;
 	bool					connect_received;
 	bool					disconnect_started;
+	/* Set while the qpair is being moved to another poll group */
+	bool					migrating;
+	/* Set while it is removed from the old poll group but not added to the new one yet */
+	bool					migrate_detached;
+
+	/* NVMe IO commands completed, and their number at the last rebalance of the target */
+	uint64_t				completed_nvme_io;
+	uint64_t				rebalance_nvme_io;
 
 	union {
 		struct spdk_nvmf_request	*first_fused_req;
@@ -133,6 +144,9 @@ struct spdk_nvmf_qpair {
 
 	TAILQ_HEAD(, spdk_nvmf_request)		outstanding;
 	TAILQ_ENTRY(spdk_nvmf_qpair)		link;
+
+	/* Accounting of the NVMe IO commands completed on this qpair */
+	struct spdk_nvmf_io_stat		io_stat;
 };
 
 struct spdk_nvmf_transport_pg_cache_buf {
@@ -148,6 +162,8 @@ struct spdk_nvmf_transport_poll_group {
 	uint32_t							buf_cache_size;
 	struct spdk_nvmf_poll_group					*group;
 	TAILQ_ENTRY(spdk_nvmf_transport_poll_group)			link;
+	/* Requests held back by the QoS of their namespace, before they wait for a buffer */
+	STAILQ_HEAD(, spdk_nvmf_request)				pending_qos_queue;
 };
 
 struct spdk_nvmf_poll_group {
@@ -180,6 +196,9 @@ struct spdk_nvmf_poll_group {
 	TAILQ_ENTRY(spdk_nvmf_poll_group)		link;
 
 	pthread_mutex_t					mutex;
+
+	/* I/O qpair CONNECTs waiting to be passed to their subsystem's thread together */
+	struct spdk_nvmf_io_connect_batch		*io_connect_batch;
 };
 
 struct spdk_nvmf_listener {
@@ -223,6 +242,7 @@ struct spdk_nvmf_transport {
 };
 
 typedef void (*spdk_nvmf_transport_qpair_fini_cb)(void *cb_arg);
+typedef void (*spdk_nvmf_transport_qpair_quiesce_cb)(void *cb_arg, int status);
 
 struct spdk_nvmf_transport_ops {
 	/**
@@ -347,6 +367,23 @@ struct spdk_nvmf_transport_ops {
 	int (*poll_group_remove)(struct spdk_nvmf_transport_poll_group *group,
 				 struct spdk_nvmf_qpair *qpair);
 
+	/**
+	 * Stop processing new commands on a qpair and call cb_fn, on the thread of its
+	 * poll group, once it has no request in flight. If the qpair is removed from its
+	 * poll group first, cb_fn is called with -ECANCELED. Optional, only needed to
+	 * move qpairs between poll groups.
+	 */
+	void (*qpair_quiesce)(struct spdk_nvmf_qpair *qpair,
+			      spdk_nvmf_transport_qpair_quiesce_cb cb_fn, void *cb_arg);
+
+	/**
+	 * Add a qpair quiesced by qpair_quiesce and removed from its former poll group
+	 * to another poll group, keeping its state, and resume processing its commands.
+	 * On failure, the qpair must still be removable from the group.
+	 */
+	int (*poll_group_migrate)(struct spdk_nvmf_transport_poll_group *group,
+				  struct spdk_nvmf_qpair *qpair);
+
 	/**
 	 * Poll the group to process I/O
 	 */
@@ -403,6 +440,12 @@ struct spdk_nvmf_transport_ops {
 	 */
 	void (*poll_group_dump_stat)(struct spdk_nvmf_transport_poll_group *group,
 				     struct spdk_json_write_ctx *w);
+
+	/*
+	 * Get the in-capsule data size the queue pair can receive. Optional, if not
+	 * provided, the in_capsule_data_size of the transport opts is used.
+	 */
+	uint32_t (*qpair_get_in_capsule_data_size)(struct spdk_nvmf_qpair *qpair);
 };
 
 /**
@@ -54,6 +54,48 @@ struct spdk_reduce_vol_params {
 	 *  of the chunk size.
 	 */
 	uint64_t		vol_size;
+
+	/**
+	 * Number of chunks buffered in the persistent memory file for
+	 *  writes smaller than a chunk.  Such writes are merged in the
+	 *  buffer and only compressed to the backing device once the
+	 *  chunk is complete or its buffer is needed for another chunk,
+	 *  instead of reading, decompressing and compressing the chunk
+	 *  again for each write.  0 disables the write buffer.
+	 */
+	uint32_t		write_buffer_chunks;
+};
+
+/** Number of buckets of the compression ratio histogram. */
+#define SPDK_REDUCE_RATIO_BUCKETS	10
+
+/**
+ * Statistics of the chunks written to an spdk_reduce_vol since it was
+ *  initialized or loaded.
+ */
+struct spdk_reduce_vol_stats {
+	/** Chunks written compressed. */
+	uint64_t		compressed_chunks;
+
+	/**
+	 * Chunks written uncompressed since compressing them didn't
+	 *  save a backing IO unit.
+	 */
+	uint64_t		incompressible_chunks;
+
+	/**
+	 * Chunks written uncompressed without trying to compress them,
+	 *  since their data looked random or the recent chunks didn't
+	 *  compress.
+	 */
+	uint64_t		bypassed_chunks;
+
+	/**
+	 * Written chunks by the space they use on the backing device.
+	 *  Bucket i counts the chunks using more than i and up to i + 1
+	 *  tenths of the chunk size.
+	 */
+	uint64_t		ratio_histogram[SPDK_REDUCE_RATIO_BUCKETS];
 };
 
 struct spdk_reduce_vol;
@@ -124,7 +166,9 @@ const struct spdk_uuid *spdk_reduce_vol_get_uuid(struct spdk_reduce_vol *vol);
  * \param backing_dev Structure describing the backing device to use for the new volume.
  * \param pm_file_dir Directory to use for creation of the persistent memory file to
  *                    use for the new volume.  This function will append the UUID as
- *		      the filename to create in this directory.
+ *		      the filename to create in this directory.  If NULL, the metadata
+ *		      is kept in memory and journaled to the beginning of the backing
+ *		      device instead, which reduces the size of the volume.
  * \param cb_fn Callback function to signal completion of the initialization process.
  * \param cb_arg Argument to pass to the callback function.
  */
@@ -175,8 +219,7 @@ void spdk_reduce_vol_destroy(struct spdk_reduce_backing_dev *backing_dev,
 /**
  * Read data from a libreduce compressed volume.
  *
- * This function will only read from logical blocks on the comparessed volume that
- * fall within the same chunk.
+ * A read spanning several chunks is split in one read per chunk, all issued at once.
  *
  * \param vol Volume to read data.
  * \param iov iovec array describing the data to be read
@@ -193,8 +236,8 @@ void spdk_reduce_vol_readv(struct spdk_reduce_vol *vol,
 /**
  * Write data to a libreduce compressed volume.
  *
- * This function will only write to logical blocks on the comparessed volume that
- * fall within the same chunk.
+ * A write spanning several chunks is split in one write per chunk, all issued at once, so
+ * the compression of a chunk overlaps with the backing writes of the others.
  *
  * \param vol Volume to write data.
  * \param iov iovec array describing the data to be written
@@ -218,6 +261,14 @@ void spdk_reduce_vol_writev(struct spdk_reduce_vol *vol,
  */
 const struct spdk_reduce_vol_params *spdk_reduce_vol_get_params(struct spdk_reduce_vol *vol);
 
+/**
+ * Get the compression statistics of a libreduce compressed volume.
+ *
+ * \param vol Previously loaded or initialized compressed volume.
+ * \param stats Structure to fill with the statistics of the volume.
+ */
+void spdk_reduce_vol_get_stats(struct spdk_reduce_vol *vol, struct spdk_reduce_vol_stats *stats);
+
 /**
  * Dump out key information for a libreduce compressed volume and its PMEM.
  *
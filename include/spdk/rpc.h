@@ -138,6 +138,45 @@ uint32_t spdk_rpc_get_state(void);
  */
 void spdk_rpc_set_allowlist(const char **rpc_allowlist);
 
+/**
+ * Call an RPC method locally, without going through the RPC server.  The method is subject
+ * to the same checks (allowlist, state mask) as if it was called over the RPC socket.
+ *
+ * \param method Name of the method.
+ * \param params Parameters of the method, NULL if there are none.  Must remain valid until
+ * cb_fn is called.
+ * \param cb_fn Callback receiving the response.  It might be called from any thread and even
+ * before this function returns.
+ * \param cb_arg Argument passed to cb_fn.
+ *
+ * \return 0 on success, negated errno on failure, in which case cb_fn won't be called.
+ */
+int spdk_rpc_call(const char *method, const struct spdk_json_val *params,
+		  spdk_jsonrpc_local_response_fn cb_fn, void *cb_arg);
+
+/**
+ * Function passing a request received by the RPC server to the thread the RPC methods run on.
+ *
+ * \param handle_request Function to call on that thread with the other parameters.
+ * \param request JSON-RPC request.
+ * \param method Method of the request.
+ * \param params Parameters of the request.
+ */
+typedef void (*spdk_rpc_dispatch_fn)(spdk_jsonrpc_handle_request_fn handle_request,
+				     struct spdk_jsonrpc_request *request,
+				     const struct spdk_json_val *method,
+				     const struct spdk_json_val *params);
+
+/**
+ * Set the function dispatching the requests received by the RPC server.  By default, the
+ * requests are handled directly on the thread calling spdk_rpc_accept().  Setting a dispatch
+ * function allows the server to be polled from a different thread than the one the RPC methods
+ * run on.
+ *
+ * \param dispatch_fn Dispatch function, NULL to handle the requests directly.
+ */
+void spdk_rpc_set_dispatch_fn(spdk_rpc_dispatch_fn dispatch_fn);
+
 #ifdef __cplusplus
 }
 #endif
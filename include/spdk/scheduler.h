@@ -17,6 +17,8 @@ extern "C" {
 #include "spdk/thread.h"
 #include "spdk/util.h"
 
+struct spdk_histogram_data;
+
 struct spdk_governor_capabilities {
 	bool priority; /* Core with higher base frequency */
 };
@@ -149,6 +151,8 @@ struct spdk_scheduler_thread_info {
 	struct spdk_thread_stats total_stats;
 	/* stats during the last scheduling period */
 	struct spdk_thread_stats current_stats;
+	/* NUMA socket of the I/O devices used by the thread, or SPDK_ENV_SOCKET_ID_ANY */
+	int32_t socket_id;
 };
 
 /**
@@ -166,6 +170,10 @@ struct spdk_scheduler_core_info {
 	uint32_t threads_count;
 	bool interrupt_mode;
 	struct spdk_scheduler_thread_info *thread_infos;
+	/* Latencies recorded with spdk_thread_record_latency() by the threads on this core
+	 * during the last scheduling period. NULL while latency histograms are disabled,
+	 * see spdk_thread_enable_latency_histograms(). */
+	struct spdk_histogram_data *current_latency_histogram;
 };
 
 /**
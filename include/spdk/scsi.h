@@ -226,6 +226,22 @@ struct spdk_scsi_lun *spdk_scsi_dev_get_next_lun(struct spdk_scsi_lun *prev_lun)
 bool spdk_scsi_dev_has_pending_tasks(const struct spdk_scsi_dev *dev,
 				     const struct spdk_scsi_port *initiator_port);
 
+/**
+ * Set the maximum number of tasks each initiator may have outstanding on each
+ * LUN of the SCSI device.
+ *
+ * Tasks beyond the limit are queued per initiator and submitted in order as
+ * earlier tasks of the same initiator complete, so that an initiator can't take
+ * the whole queue of a LUN from the other initiators sharing it. The limit also
+ * applies to LUNs added to the device later. It is meant to be set before tasks
+ * are submitted to the device.
+ *
+ * \param dev SCSI device.
+ * \param max_tasks Maximum number of outstanding tasks per initiator and LUN,
+ * or 0 for no limit.
+ */
+void spdk_scsi_dev_set_max_tasks_per_initiator(struct spdk_scsi_dev *dev, uint32_t max_tasks);
+
 /**
  * Destruct the SCSI device.
  *
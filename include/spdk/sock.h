@@ -149,6 +149,38 @@ struct spdk_sock_impl_opts {
 	 * Set default PSK identity. Used by ssl socket module.
 	 */
 	char *psk_identity;
+
+	/**
+	 * Enable or disable multishot receive into the sock group's provided buffer ring.
+	 * Used by uring socket module.
+	 */
+	bool enable_recv_multishot;
+
+	/**
+	 * Time in microseconds to busy poll the device queues of the sockets on receive,
+	 * 0 to disable. Used by posix socket module.
+	 */
+	uint32_t busy_poll_usecs;
+
+	/**
+	 * Enable or disable preferred busy polling, which keeps the device interrupts
+	 * masked as long as the application busy polls. Used by posix socket module.
+	 */
+	bool enable_prefer_busy_poll;
+};
+
+/**
+ * Send path statistics of a socket.
+ */
+struct spdk_sock_stats {
+	/** Number of sends submitted with MSG_ZEROCOPY. */
+	uint64_t zcopy_sends;
+
+	/** Number of sends submitted without MSG_ZEROCOPY, e.g. below zerocopy_threshold. */
+	uint64_t copy_sends;
+
+	/** Number of zero copy sends for which the kernel had to copy the data anyway. */
+	uint64_t zcopy_copied;
 };
 
 /**
@@ -334,6 +366,31 @@ int spdk_sock_flush(struct spdk_sock *sock);
  */
 ssize_t spdk_sock_recv(struct spdk_sock *sock, void *buf, size_t len);
 
+/**
+ * Receive the next chunk of data from the given socket without copying it.
+ *
+ * The data is left in a buffer owned by the socket layer (e.g. one of the sock group's
+ * receive buffers), which the caller may keep as long as it needs, e.g. to parse
+ * headers in place or to submit the payload further. It must be returned with
+ * spdk_sock_recv_buf_release() before the socket or its sock group is closed.
+ *
+ * \param sock Socket to receive from.
+ * \param buf Set to the start of the received data.
+ * \param ctx Set to the context to pass to spdk_sock_recv_buf_release().
+ *
+ * \return the length of the received data on success, 0 if the connection was closed
+ * by the peer, -1 on failure with errno set (EAGAIN if there's no data available).
+ */
+ssize_t spdk_sock_recv_next(struct spdk_sock *sock, void **buf, void **ctx);
+
+/**
+ * Return a buffer obtained with spdk_sock_recv_next().
+ *
+ * \param sock Socket the buffer was received from.
+ * \param ctx Context returned by spdk_sock_recv_next().
+ */
+void spdk_sock_recv_buf_release(struct spdk_sock *sock, void *ctx);
+
 /**
  * Write message to the given socket from the I/O vector array.
  *
@@ -375,6 +432,14 @@ ssize_t spdk_sock_readv(struct spdk_sock *sock, struct iovec *iov, int iovcnt);
  */
 void spdk_sock_readv_async(struct spdk_sock *sock, struct spdk_sock_request *req);
 
+/**
+ * Get the send path statistics of the given socket.
+ *
+ * \param sock Socket to get the statistics of.
+ * \param stats Filled in with the statistics.
+ */
+void spdk_sock_get_stats(struct spdk_sock *sock, struct spdk_sock_stats *stats);
+
 /**
  * Set the value used to specify the low water mark (in bytes) for this socket.
  *
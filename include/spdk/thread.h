@@ -47,6 +47,11 @@ struct spdk_poller;
 
 struct spdk_io_channel_iter;
 
+/**
+ * A set of messages sent to one or more threads at once.
+ */
+struct spdk_thread_msg_batch;
+
 /**
  * A function that is called each time a new thread is created.
  * The implementor of this function should frequently call
@@ -147,6 +152,14 @@ typedef int (*spdk_io_channel_create_cb)(void *io_device, void *ctx_buf);
  */
 typedef void (*spdk_io_channel_destroy_cb)(void *io_device, void *ctx_buf);
 
+/**
+ * I/O channel migration callback.
+ *
+ * \param io_device I/O device associated with this channel.
+ * \param ctx_buf Context for the I/O device.
+ */
+typedef void (*spdk_io_channel_migrate_cb)(void *io_device, void *ctx_buf);
+
 /**
  * I/O device unregister callback.
  *
@@ -187,6 +200,24 @@ typedef void (*spdk_channel_for_each_cpl)(struct spdk_io_channel_iter *i, int st
  */
 int spdk_thread_lib_init(spdk_new_thread_fn new_thread_fn, size_t ctx_sz);
 
+/**
+ * Data structure keeping track of the timed pollers of each thread.
+ */
+enum spdk_thread_timer_type {
+	/**
+	 * Red-black tree ordered by the next run time of the pollers. Insertion
+	 * costs O(log n), pollers due at the same time run in the order of
+	 * their next run time.
+	 */
+	SPDK_THREAD_TIMER_RBTREE = 0,
+
+	/**
+	 * Hierarchical timer wheel. Insertion and expiration cost O(1), pollers
+	 * due within the same microsecond run in the order they were queued.
+	 */
+	SPDK_THREAD_TIMER_WHEEL,
+};
+
 /**
  * Initialize the threading library. Must be called once prior to allocating any threads
  *
@@ -205,6 +236,19 @@ int spdk_thread_lib_init_ext(spdk_thread_op_fn thread_op_fn,
 			     spdk_thread_op_supported_fn thread_op_supported_fn,
 			     size_t ctx_sz, size_t msg_mempool_size);
 
+/**
+ * Select the data structure used by the threads to keep track of their timed
+ * pollers. Must be called before spdk_thread_lib_init() or
+ * spdk_thread_lib_init_ext(). The selection is reset to SPDK_THREAD_TIMER_RBTREE
+ * by spdk_thread_lib_fini().
+ *
+ * \param timer_type Data structure used by the threads to keep track of their timed pollers.
+ *
+ * \return 0 on success, -EINVAL if timer_type is unknown, -EBUSY if the threading
+ * library is already initialized.
+ */
+int spdk_thread_lib_set_timer_type(enum spdk_thread_timer_type timer_type);
+
 /**
  * Release all resources associated with this library.
  */
@@ -317,6 +361,36 @@ void *spdk_thread_get_ctx(struct spdk_thread *thread);
  */
 struct spdk_cpuset *spdk_thread_get_cpumask(struct spdk_thread *thread);
 
+/**
+ * Get the home NUMA socket of a thread.
+ *
+ * The home socket is the socket most of the I/O channels held by the thread are
+ * local to, as set by spdk_io_device_set_socket_id(). This function may only be
+ * called from the system thread currently polling the given thread.
+ *
+ * \param thread The thread to query.
+ *
+ * \return the home socket ID, or SPDK_ENV_SOCKET_ID_ANY if the thread does not hold
+ * any I/O channel bound to a socket.
+ */
+int32_t spdk_thread_get_socket_id(struct spdk_thread *thread);
+
+/**
+ * Notify a thread that it was placed on a core of the given NUMA socket.
+ *
+ * When the socket differs from the one the thread was previously placed on, the
+ * migration callbacks of the I/O devices it holds channels to are called from the
+ * thread the next time it is polled, see spdk_io_device_set_migrate_cb(). This is
+ * meant to be called by the framework moving threads between cores, from the system
+ * thread which is going to poll the given thread.
+ *
+ * \param thread The thread which was moved.
+ * \param socket_id Socket ID of the core the thread now runs on.
+ *
+ * \return 0 on success, negated errno on failure to notify the thread.
+ */
+int spdk_thread_notify_migration(struct spdk_thread *thread, int32_t socket_id);
+
 /**
  * Set the current thread's cpumask to the specified value. The thread may be
  * rescheduled to one of the CPUs specified in the cpumask.
@@ -479,6 +553,105 @@ uint64_t spdk_thread_get_last_tsc(struct spdk_thread *thread);
  */
 int spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx);
 
+/**
+ * Send a message to the given thread, allowing it to be executed by another thread.
+ *
+ * Works like spdk_thread_send_msg(), except that `fn` does not have to be executed
+ * on the given thread. If the target thread is busy, the message may be stolen and
+ * executed by another idle thread calling spdk_thread_steal_msgs() (e.g. one sharing
+ * the same reactor). Only use this for messages that do not depend on thread-local
+ * state, such as I/O channels or pollers of the target thread.
+ *
+ * \param thread The target thread.
+ * \param fn This function will be called on the given thread or on a thread stealing
+ * the message.
+ * \param ctx This context will be passed to fn when called.
+ *
+ * \return 0 on success
+ * \return -ENOMEM if the message could not be allocated
+ * \return -EIO if the message could not be sent to the destination thread
+ */
+int spdk_thread_send_stealable_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx);
+
+/**
+ * Get the number of stealable messages pending on a thread.
+ *
+ * \param thread The thread to query.
+ *
+ * \return the number of messages sent by spdk_thread_send_stealable_msg() that
+ * have not been executed yet.
+ */
+uint32_t spdk_thread_get_stealable_msg_count(const struct spdk_thread *thread);
+
+/**
+ * Steal stealable messages from another thread and execute them on the given thread.
+ *
+ * The messages are executed as if `thread` was polled, i.e. spdk_get_thread() returns
+ * `thread` while they run. This must be called from the same system thread that polls
+ * `thread`.
+ *
+ * \param thread The thread executing the stolen messages.
+ * \param victim The thread to steal the messages from.
+ * \param max_msgs The maximum number of messages to steal. Use 0 to steal as many
+ * messages as a single spdk_thread_poll() would run.
+ *
+ * \return the number of messages executed or -EINVAL if thread and victim are the same.
+ */
+int spdk_thread_steal_msgs(struct spdk_thread *thread, struct spdk_thread *victim,
+			   uint32_t max_msgs);
+
+/**
+ * Allocate a batch of messages.
+ *
+ * A batch collects messages to one or more threads, which are then sent by
+ * spdk_thread_msg_batch_submit() with a single ring operation and, in interrupt
+ * mode, a single notification per target thread.
+ *
+ * \param size The maximum number of messages the batch can hold.
+ *
+ * \return a pointer to the batch on success or NULL on failure.
+ */
+struct spdk_thread_msg_batch *spdk_thread_msg_batch_alloc(uint32_t size);
+
+/**
+ * Free a batch of messages. Messages added but not submitted are discarded.
+ *
+ * \param batch The batch to free. May be NULL.
+ */
+void spdk_thread_msg_batch_free(struct spdk_thread_msg_batch *batch);
+
+/**
+ * Add a message to a batch. The message is only sent by spdk_thread_msg_batch_submit().
+ *
+ * Messages to the same thread are executed in the order they were added.
+ *
+ * \param batch The batch to add the message to.
+ * \param thread The target thread.
+ * \param fn This function will be called on the given thread.
+ * \param ctx This context will be passed to fn when called.
+ *
+ * \return 0 on success
+ * \return -ENOSPC if the batch is full
+ * \return -EIO if the target thread is marked as exited
+ */
+int spdk_thread_msg_batch_add(struct spdk_thread_msg_batch *batch,
+			      const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx);
+
+/**
+ * Send all messages of a batch and reset it, so that it can be reused.
+ *
+ * The messages are sent asynchronously - i.e. spdk_thread_msg_batch_submit()
+ * will always return prior to any `fn` being called.
+ *
+ * \param batch The batch to submit.
+ *
+ * \return 0 on success
+ * \return -ENOMEM if the messages could not be allocated, none of them are sent
+ * \return -EIO if the messages could not be sent to some of the target threads,
+ * messages to the other threads are still sent
+ */
+int spdk_thread_msg_batch_submit(struct spdk_thread_msg_batch *batch);
+
 /**
  * Send a message to the given thread. Only one critical message can be outstanding at the same
  * time. It's intended to use this function in any cases that might interrupt the execution of the
@@ -545,6 +718,59 @@ void spdk_for_each_thread(spdk_msg_fn fn, void *ctx, spdk_msg_fn cpl);
  */
 void spdk_thread_set_interrupt_mode(bool enable_interrupt);
 
+/**
+ * Let threads switch between poll and interrupt mode on their own.
+ *
+ * A thread in poll mode whose pollers and messages found no work for longer than
+ * the idle budget switches itself into interrupt mode, and goes back to poll mode
+ * on the first event it processes. Threads set into interrupt mode explicitly with
+ * spdk_thread_set_interrupt_mode() are left in it. This applies to all threads.
+ *
+ * Only valid when thread interrupt facility is enabled by
+ * spdk_interrupt_mode_enable().
+ *
+ * \param idle_budget_us Time in microseconds a thread has to stay idle before it is
+ * switched into interrupt mode, or 0 to disable adaptive switching.
+ *
+ * \return 0 on success, -ENOTSUP if the thread interrupt facility is not enabled.
+ */
+int spdk_thread_set_adaptive_interrupt(uint64_t idle_budget_us);
+
+/**
+ * Get the idle budget set by spdk_thread_set_adaptive_interrupt().
+ *
+ * \return the idle budget in microseconds, 0 if adaptive switching is disabled.
+ */
+uint64_t spdk_thread_get_adaptive_interrupt(void);
+
+struct spdk_thread_intr_stats {
+	/* Number of adaptive switches into interrupt mode */
+	uint64_t to_intr_count;
+	/* Number of adaptive switches back to poll mode */
+	uint64_t to_poll_count;
+	/* Ticks spent in the switches, in total and for the longest one */
+	uint64_t transition_tsc;
+	uint64_t max_transition_tsc;
+};
+
+/**
+ * Get statistics about the adaptive mode switches of a thread.
+ *
+ * \param thread The thread to query.
+ * \param stats Output parameter for the statistics.
+ */
+void spdk_thread_get_intr_stats(struct spdk_thread *thread, struct spdk_thread_intr_stats *stats);
+
+/**
+ * Record the latency of an operation completed on the current thread, e.g. an I/O.
+ * Schedulers use these samples to steer the cores towards latency targets.
+ *
+ * This is a no-op unless a scheduler enabled latency collection.
+ *
+ * \param ticks Latency of the operation in ticks.
+ */
+void spdk_thread_record_latency(uint64_t ticks);
+
 /**
  * Register a poller on the current thread.
  *
@@ -638,6 +864,36 @@ void spdk_io_device_register(void *io_device, spdk_io_channel_create_cb create_c
 			     spdk_io_channel_destroy_cb destroy_cb, uint32_t ctx_size,
 			     const char *name);
 
+/**
+ * Set the NUMA socket the given I/O device is local to.
+ *
+ * This is a hint used e.g. by the schedulers to keep threads using this I/O device
+ * on cores of the same socket.  By default, I/O devices are not bound to any socket.
+ *
+ * \param io_device The pointer to io_device, previously registered by
+ * spdk_io_device_register().
+ * \param socket_id Socket ID the I/O device is local to, or SPDK_ENV_SOCKET_ID_ANY.
+ *
+ * \return 0 on success, -ENODEV if the io_device was not registered.
+ */
+int spdk_io_device_set_socket_id(void *io_device, int32_t socket_id);
+
+/**
+ * Set the callback called on each channel of the given I/O device after the thread
+ * owning the channel was moved to a core of another NUMA socket.
+ *
+ * The callback runs on the channel's thread, once it runs on the new core. It lets
+ * the I/O device re-home the per-thread resources of the channel, e.g. buffer caches,
+ * onto the new socket.
+ *
+ * \param io_device The pointer to io_device, previously registered by
+ * spdk_io_device_register().
+ * \param migrate_cb Function called on each channel after a migration, or NULL.
+ *
+ * \return 0 on success, -ENODEV if the io_device was not registered.
+ */
+int spdk_io_device_set_migrate_cb(void *io_device, spdk_io_channel_migrate_cb migrate_cb);
+
 /**
  * Unregister the opaque io_device context as an I/O device.
  *
@@ -945,6 +1201,19 @@ void spdk_spin_unlock(struct spdk_spinlock *sspin);
  */
 bool spdk_spin_held(struct spdk_spinlock *sspin);
 
+/** Maximum number of iobuf size classes, in addition to the small and large ones */
+#define SPDK_IOBUF_MAX_SIZE_CLASSES	6
+
+/** Maximum number of NUMA nodes with their own iobuf pools */
+#define SPDK_IOBUF_MAX_NUMA_NODES	8
+
+struct spdk_iobuf_size_class_opts {
+	/** Maximum number of buffers of this size class */
+	uint64_t pool_count;
+	/** Size of a single buffer of this size class */
+	uint32_t bufsize;
+};
+
 struct spdk_iobuf_opts {
 	/** Maximum number of small buffers */
 	uint64_t small_pool_count;
@@ -954,9 +1223,48 @@ struct spdk_iobuf_opts {
 	uint32_t small_bufsize;
 	/** Size of a single large buffer */
 	uint32_t large_bufsize;
+	/**
+	 * The size of spdk_iobuf_opts according to the caller of this library is used for ABI
+	 * compatibility.  The library uses this field to know how many fields in this structure
+	 * are valid.  New fields must be added at the end of the structure.
+	 */
+	size_t opts_size;
+	/** Number of size classes between the small and large ones */
+	uint32_t num_size_classes;
+	/**
+	 * Size classes between the small and large ones, by increasing buffer size.  Requests
+	 * are served from the smallest buffers they fit in.
+	 */
+	struct spdk_iobuf_size_class_opts size_classes[SPDK_IOBUF_MAX_SIZE_CLASSES];
+	/**
+	 * Allocate a separate set of pools on each NUMA node used by the application.  Pool
+	 * counts then apply to each node.  Channels use the pools of the node their thread runs
+	 * on and only take buffers from the other nodes once these are exhausted.
+	 */
+	bool enable_numa;
+	/**
+	 * Period of the cache rebalancing, in microseconds, 0 to disable it.  Each period, the
+	 * caches of the channels which haven't requested any buffers are shrunk, while the ones
+	 * of the channels which had to reach for the global pool are grown.
+	 */
+	uint32_t cache_rebalance_period_us;
+	/**
+	 * Number of buffers the caches may grow by in total, as a percentage of the buffers of
+	 * each pool.  The buffers released by shrinking the idle caches can be reused on top of
+	 * it.
+	 */
+	uint32_t cache_rebalance_budget;
+	/**
+	 * Create the pools of each NUMA node when the first channel on that node is initialized,
+	 * instead of creating all of them in spdk_iobuf_initialize().  This moves the cost of
+	 * allocating and touching the buffers out of the application startup.
+	 */
+	bool lazy_init;
 };
 
 struct spdk_iobuf_entry;
+struct spdk_iobuf_pool;
+struct spdk_histogram_data;
 
 typedef void (*spdk_iobuf_get_cb)(struct spdk_iobuf_entry *entry, void *buf);
 
@@ -965,6 +1273,10 @@ struct spdk_iobuf_entry {
 	spdk_iobuf_get_cb		cb_fn;
 	const void			*module;
 	STAILQ_ENTRY(spdk_iobuf_entry)	stailq;
+	/** Pool of the channel the entry is waiting on */
+	struct spdk_iobuf_pool		*pool;
+	/** Tick at which the entry started waiting */
+	uint64_t			wait_tsc;
 };
 
 
@@ -975,6 +1287,17 @@ struct spdk_iobuf_buffer {
 typedef STAILQ_HEAD(, spdk_iobuf_entry) spdk_iobuf_entry_stailq_t;
 typedef STAILQ_HEAD(, spdk_iobuf_buffer) spdk_iobuf_buffer_stailq_t;
 
+struct spdk_iobuf_pool_stats {
+	/** Buffer requests served from the channel's cache */
+	uint64_t	cache;
+	/** Buffer requests served from the global pool */
+	uint64_t	main;
+	/** Buffer requests which had to wait for a buffer to be released */
+	uint64_t	retry;
+	/** Buffer requests served from the pool of a remote NUMA node */
+	uint64_t	remote;
+};
+
 struct spdk_iobuf_pool {
 	/** Buffer pool */
 	struct spdk_mempool		*pool;
@@ -988,6 +1311,14 @@ struct spdk_iobuf_pool {
 	spdk_iobuf_entry_stailq_t	*queue;
 	/** Buffer size */
 	uint32_t			bufsize;
+	/** Statistics */
+	struct spdk_iobuf_pool_stats	stats;
+	/** Time spent waiting for a buffer, allocated once a request has to wait */
+	struct spdk_histogram_data	*wait_histogram;
+	/** Size of the cache requested at initialization */
+	uint32_t			init_cache_size;
+	/** Statistics at the previous cache rebalancing */
+	struct spdk_iobuf_pool_stats	rebalance_stats;
 };
 
 /** iobuf channel */
@@ -1000,6 +1331,31 @@ struct spdk_iobuf_channel {
 	const void			*module;
 	/** Parent IO channel */
 	struct spdk_io_channel		*parent;
+	/** Memory pools of the size classes, by increasing buffer size */
+	struct spdk_iobuf_pool		classes[SPDK_IOBUF_MAX_SIZE_CLASSES];
+	/** Number of size classes in use */
+	uint32_t			num_classes;
+	/** NUMA node of the pools the channel is bound to */
+	uint32_t			node;
+	/** Link in the list of iobuf channels of the thread */
+	TAILQ_ENTRY(spdk_iobuf_channel)	tailq;
+};
+
+/** Buffer wait time histograms use buckets of 2^N ticks at each power of two */
+#define SPDK_IOBUF_WAIT_HISTOGRAM_BUCKET_SHIFT	4
+
+/** iobuf statistics of a module, summed up over all of its channels */
+struct spdk_iobuf_module_stats {
+	/** Name of the module */
+	const char			*module;
+	/** Small buffer pool statistics */
+	struct spdk_iobuf_pool_stats	small_pool;
+	/** Large buffer pool statistics */
+	struct spdk_iobuf_pool_stats	large_pool;
+	/** Statistics of the size class pools, see spdk_iobuf_opts.num_size_classes */
+	struct spdk_iobuf_pool_stats	class_pools[SPDK_IOBUF_MAX_SIZE_CLASSES];
+	/** Time requests spent waiting for a buffer, in ticks, NULL if none had to wait */
+	struct spdk_histogram_data	*wait_histogram;
 };
 
 /**
@@ -1022,7 +1378,8 @@ void spdk_iobuf_finish(spdk_iobuf_finish_cb cb_fn, void *cb_arg);
 /**
  * Set iobuf options.  These options will be used during `spdk_iobuf_initialize()`.
  *
- * \param opts Options describing the size of the pools to reserve.
+ * \param opts Options describing the size of the pools to reserve.  opts_size must be set,
+ * usually by getting the current options with spdk_iobuf_get_opts() first.
  *
  * \return 0 on success, negative errno otherwise.
  */
@@ -1032,8 +1389,9 @@ int spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts);
  * Get iobuf options.
  *
  * \param opts Options to fill in.
+ * \param opts_size Must be set to sizeof(struct spdk_iobuf_opts).
  */
-void spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts);
+void spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts, size_t opts_size);
 
 /**
  * Register a module as an iobuf pool user.  Only registered users can request buffers from the
@@ -1046,12 +1404,16 @@ void spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts);
 int spdk_iobuf_register_module(const char *name);
 
 /**
- * Initialize an iobuf channel.
+ * Initialize an iobuf channel.  The channel is bound to the pools of the NUMA node of the core
+ * the calling thread is running on.
  *
  * \param ch iobuf channel to initialize.
  * \param name Name of the module registered via `spdk_iobuf_register_module()`.
  * \param small_cache_size Number of small buffers to be cached by this channel.
- * \param large_cache_size Number of large buffers to be cached by this channel.
+ * \param large_cache_size Number of large buffers to be cached by this channel.  The same
+ * number of buffers is cached for each of the size classes.
+ *
+ * The cache sizes change over time if `spdk_iobuf_opts.cache_rebalance_period_us` is set.
  *
  * \return 0 on success, negative errno otherwise.
  */
@@ -1065,6 +1427,17 @@ int spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
  */
 void spdk_iobuf_channel_fini(struct spdk_iobuf_channel *ch);
 
+/**
+ * Re-home the buffer cache of an iobuf channel after its thread was moved to a core
+ * of another NUMA socket.  The channel is bound to the pools of the new node and the
+ * cached buffers are exchanged for buffers taken from them.  This is meant to be called
+ * from the migration callback of the I/O device owning the iobuf channel, see
+ * spdk_io_device_set_migrate_cb().
+ *
+ * \param ch iobuf channel.
+ */
+void spdk_iobuf_channel_migrate(struct spdk_iobuf_channel *ch);
+
 typedef int (*spdk_iobuf_for_each_entry_fn)(struct spdk_iobuf_channel *ch,
 		struct spdk_iobuf_entry *entry, void *ctx);
 
@@ -1073,7 +1446,8 @@ typedef int (*spdk_iobuf_for_each_entry_fn)(struct spdk_iobuf_channel *ch,
  * using `ch`.  The iteration is stopped if the callback returns non-zero status.
  *
  * \param ch iobuf channel to iterate over.
- * \param pool Pool to iterate over (`small` or `large`).
+ * \param pool Pool to iterate over (`small`, `large` or one of `classes`), or NULL to iterate
+ * over all of them.
  * \param cb_fn Callback to execute on each entry on the queue that was requested using `ch`.
  * \param cb_ctx Argument passed to `cb_fn`.
  *
@@ -1119,6 +1493,21 @@ void *spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len, struct spdk_io
  */
 void spdk_iobuf_put(struct spdk_iobuf_channel *ch, void *buf, uint64_t len);
 
+typedef void (*spdk_iobuf_get_stats_cb)(struct spdk_iobuf_module_stats *modules,
+					uint32_t num_modules, void *cb_arg);
+
+/**
+ * Get iobuf statistics of each registered module.  The statistics are gathered from the
+ * channels of all threads.
+ *
+ * \param cb_fn Callback to be executed once the statistics are gathered.  The statistics are
+ * only valid during the callback.
+ * \param cb_arg Argument to pass to the callback function.
+ *
+ * \return 0 on success, negative errno otherwise.
+ */
+int spdk_iobuf_get_stats(spdk_iobuf_get_stats_cb cb_fn, void *cb_arg);
+
 #ifdef __cplusplus
 }
 #endif
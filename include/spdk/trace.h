@@ -224,6 +224,28 @@ void _spdk_trace_record(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id,
 #define spdk_trace_record(tpoint_id, poller_id, size, object_id, ...) \
 	spdk_trace_record_tsc(0, tpoint_id, poller_id, size, object_id, ## __VA_ARGS__)
 
+/**
+ * Set the sample rate of a tracepoint group.  With a rate of N, only one out of every N objects
+ * created on each thread is traced.  The objects are selected when they're created, so all of the
+ * tracepoints of a selected object are recorded, while none of the tracepoints of the other ones
+ * are.  Tracepoints not associated with any object are always recorded.
+ *
+ * \param group_name Name of the tracepoint group or "all".
+ * \param rate Sample rate.  0 or 1 disables sampling and records all the objects.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_trace_set_sample_rate(const char *group_name, uint32_t rate);
+
+/**
+ * Get the sample rate of a tracepoint group.
+ *
+ * \param group_id Tracepoint group id.
+ *
+ * \return sample rate of the group, 1 if all objects are traced.
+ */
+uint32_t spdk_trace_get_sample_rate(uint32_t group_id);
+
 /**
  * Get the current tpoint mask of the given tpoint group.
  *
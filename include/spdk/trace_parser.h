@@ -121,6 +121,18 @@ bool spdk_trace_parser_next_entry(struct spdk_trace_parser *parser,
  */
 uint64_t spdk_trace_parser_get_entry_count(const struct spdk_trace_parser *parser, uint16_t lcore);
 
+/**
+ * Move the parser to a given point in time.  The following calls to
+ * spdk_trace_parser_next_entry() will return entries starting with the first one recorded at or
+ * after that point.  The entries of each core are sorted, so it's done with a binary search
+ * and doesn't require parsing the entries preceding it.  Objects created before that point
+ * aren't known to the parser, so their entries will have object_index set to UINT64_MAX.
+ *
+ * \param parser Parser object to be used.
+ * \param tsc Timestamp (not adjusted by the offset) of the first entry to return.
+ */
+void spdk_trace_parser_seek(struct spdk_trace_parser *parser, uint64_t tsc);
+
 #ifdef __cplusplus
 }
 #endif
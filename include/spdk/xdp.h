@@ -0,0 +1,187 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+/** \file
+ * AF_XDP raw frame I/O
+ *
+ * A port is an AF_XDP socket bound to one queue of a network interface. All frames received
+ * on that queue bypass the kernel network stack and are handed to the application, which
+ * also transmits raw frames on it. It's meant to carry a user-space network stack, it doesn't
+ * implement any protocol itself.
+ */
+
+#ifndef SPDK_XDP_H
+#define SPDK_XDP_H
+
+#include "spdk/stdinc.h"
+#include "spdk/assert.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct spdk_xdp_port;
+
+/**
+ * A frame in the memory of a port.
+ */
+struct spdk_xdp_frame {
+	/** Start of the frame */
+	void		*buf;
+
+	/**
+	 * Length of the frame. For frames to transmit, it is set to the space available in
+	 * the buffer when they are allocated.
+	 */
+	uint32_t	len;
+};
+
+struct spdk_xdp_port_opts {
+	/**
+	 * The size of spdk_xdp_port_opts according to the caller of this library is used for ABI
+	 * compatibility. The library uses this field to know how many fields in this structure
+	 * are valid. And the library will populate any remaining fields with default values.
+	 */
+	size_t		opts_size;
+
+	/**
+	 * Number of frames in the memory of the port, shared by reception and transmission.
+	 * Must be a power of 2.
+	 */
+	uint32_t	num_frames;
+
+	/**
+	 * Size of each frame. Must be a power of 2, between 2048 and the page size.
+	 */
+	uint32_t	frame_size;
+
+	/**
+	 * Number of entries of each ring of the socket. Must be a power of 2.
+	 */
+	uint32_t	ring_size;
+
+	/**
+	 * Attach the XDP program in generic mode, for drivers without native XDP support.
+	 */
+	bool		skb_mode;
+
+	/**
+	 * Fail if the driver can't receive into and transmit from the port memory directly.
+	 * Otherwise, the frames are copied when that's not supported.
+	 */
+	bool		zero_copy;
+
+	/* Hole at bytes 22-23. */
+	uint8_t		reserved22[2];
+} __attribute__((packed));
+SPDK_STATIC_ASSERT(sizeof(struct spdk_xdp_port_opts) == 24, "Incorrect size");
+
+/**
+ * Get the default options of a port.
+ *
+ * \param opts Options to fill.
+ * \param opts_size Size of the opts structure.
+ */
+void spdk_xdp_port_get_default_opts(struct spdk_xdp_port_opts *opts, size_t opts_size);
+
+/**
+ * Open a port on a queue of a network interface.
+ *
+ * The first port of an interface attaches an XDP program to it, which redirects the frames
+ * received on the queues with a port and passes the others to the kernel. It is detached when
+ * the last port of the interface is closed.
+ *
+ * \param ifname Name of the network interface.
+ * \param queue_id Receive queue of the interface.
+ * \param opts Options of the port, NULL for the defaults.
+ * \param port Set to the opened port on success.
+ *
+ * \return 0 on success, negative errno on failure.
+ */
+int spdk_xdp_port_open(const char *ifname, uint32_t queue_id,
+		       const struct spdk_xdp_port_opts *opts, struct spdk_xdp_port **port);
+
+/**
+ * Close a port. Frames received or allocated from the port must not be used anymore.
+ *
+ * \param port Port to close.
+ */
+void spdk_xdp_port_close(struct spdk_xdp_port *port);
+
+/**
+ * Get the file descriptor of the socket of a port. It becomes readable when frames are
+ * received, which allows waiting for them in interrupt mode.
+ *
+ * \param port Port.
+ *
+ * \return the file descriptor.
+ */
+int spdk_xdp_port_get_fd(struct spdk_xdp_port *port);
+
+/**
+ * Receive frames. The frames must be given back with spdk_xdp_port_rx_release() once
+ * they are consumed, the port receives into them again.
+ *
+ * \param port Port.
+ * \param frames Array filled with the received frames.
+ * \param max_frames Size of the frames array.
+ *
+ * \return the number of frames received.
+ */
+int spdk_xdp_port_rx_burst(struct spdk_xdp_port *port, struct spdk_xdp_frame *frames,
+			   int max_frames);
+
+/**
+ * Give received frames back to a port.
+ *
+ * \param port Port.
+ * \param frames Frames returned by spdk_xdp_port_rx_burst().
+ * \param num_frames Number of frames.
+ */
+void spdk_xdp_port_rx_release(struct spdk_xdp_port *port, struct spdk_xdp_frame *frames,
+			      int num_frames);
+
+/**
+ * Allocate frames to transmit. The frames transmitted by the port are reclaimed automatically.
+ *
+ * \param port Port.
+ * \param frames Array filled with the allocated frames.
+ * \param num_frames Number of frames to allocate.
+ *
+ * \return the number of frames allocated, which is lower than num_frames if the port runs
+ * out of them.
+ */
+int spdk_xdp_port_tx_alloc(struct spdk_xdp_port *port, struct spdk_xdp_frame *frames,
+			   int num_frames);
+
+/**
+ * Transmit frames allocated with spdk_xdp_port_tx_alloc(). Their len must be set to the
+ * length of the data to send.
+ *
+ * \param port Port.
+ * \param frames Frames to transmit.
+ * \param num_frames Number of frames.
+ *
+ * \return the number of frames queued for transmission, from the start of the array. The
+ * other frames still belong to the caller, to be transmitted later or freed.
+ */
+int spdk_xdp_port_tx_burst(struct spdk_xdp_port *port, struct spdk_xdp_frame *frames,
+			   int num_frames);
+
+/**
+ * Free frames allocated with spdk_xdp_port_tx_alloc() without transmitting them.
+ *
+ * \param port Port.
+ * \param frames Frames to free.
+ * \param num_frames Number of frames.
+ */
+void spdk_xdp_port_tx_free(struct spdk_xdp_port *port, struct spdk_xdp_frame *frames,
+			   int num_frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPDK_XDP_H */
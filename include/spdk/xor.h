@@ -28,6 +28,40 @@ extern "C" {
  */
 int spdk_xor_gen(void *dest, void **sources, uint32_t n, uint32_t len);
 
+/**
+ * Generate the P and Q parity of RAID-6 from multiple source buffers.
+ *
+ * P is the XOR of the sources and Q is the Reed-Solomon syndrome, the sum of g^i * sources[i]
+ * in GF(2^8) with the generator g = 2 and the polynomial 0x11d.
+ *
+ * \param p P destination buffer, may be NULL to generate only Q.
+ * \param q Q destination buffer.
+ * \param sources Array of source buffers.
+ * \param n Number of source buffers in the array.
+ * \param len Length of each buffer in bytes.
+ * \return 0 on success, negative error code otherwise.
+ */
+int spdk_pq_gen(void *p, void *q, void **sources, uint32_t n, uint32_t len);
+
+/**
+ * Recover up to two lost buffers of a RAID-6 stripe generated by spdk_pq_gen().
+ *
+ * The lost buffers are identified by their index, 0 to n - 1 for the sources, n for P and
+ * n + 1 for Q. Pass the same index twice if only one buffer is lost. The lost buffers are
+ * overwritten with the recovered data and the others must hold valid data.
+ *
+ * \param sources Array of source buffers.
+ * \param p P buffer.
+ * \param q Q buffer.
+ * \param n Number of source buffers in the array.
+ * \param len Length of each buffer in bytes.
+ * \param fail_a Index of the first lost buffer.
+ * \param fail_b Index of the second lost buffer.
+ * \return 0 on success, negative error code otherwise.
+ */
+int spdk_pq_recover(void **sources, void *p, void *q, uint32_t n, uint32_t len, uint32_t fail_a,
+		    uint32_t fail_b);
+
 /**
  * Get the optimal buffer alignment for XOR functions.
  *
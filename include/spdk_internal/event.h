@@ -43,6 +43,31 @@ struct spdk_lw_thread {
 	struct spdk_thread_stats	current_stats;
 };
 
+/* Upper limit of spdk_reactor::event_batch_size */
+#define SPDK_REACTOR_EVENT_BATCH_SIZE_MAX	128
+
+enum spdk_reactor_event_policy {
+	/* Execute up to one batch of events per reactor loop iteration. */
+	SPDK_REACTOR_EVENT_POLICY_BATCH = 0,
+	/* Execute all events found queued at the start of each reactor loop iteration,
+	 * one batch after another, before polling the threads.
+	 */
+	SPDK_REACTOR_EVENT_POLICY_DRAIN,
+};
+
+struct spdk_reactor_event_stats {
+	/* Number of non-empty batches of events executed */
+	uint64_t	batch_count;
+	/* Number of events executed */
+	uint64_t	event_count;
+	/* Highest number of events found queued at once */
+	uint64_t	max_queue_depth;
+	/* Ticks spent executing events */
+	uint64_t	event_tsc;
+	/* Ticks spent polling the lightweight threads */
+	uint64_t	thread_tsc;
+};
+
 /**
  * Completion callback to set reactor into interrupt mode or poll mode.
  *
@@ -86,6 +111,11 @@ struct spdk_reactor {
 
 	struct spdk_fd_group				*fgrp;
 	int						resched_fd;
+
+	/* Maximum number of events executed at once */
+	uint32_t					event_batch_size;
+	enum spdk_reactor_event_policy			event_policy;
+	struct spdk_reactor_event_stats			event_stats;
 } __attribute__((aligned(SPDK_CACHE_LINE_SIZE)));
 
 int spdk_reactors_init(size_t msg_mempool_size);
@@ -46,6 +46,7 @@ struct spdk_sock {
 		uint8_t		reserved	: 7;
 	} flags;
 	struct spdk_sock_impl_opts	impl_opts;
+	struct spdk_sock_stats		stats;
 };
 
 struct spdk_sock_group {
@@ -78,6 +79,9 @@ struct spdk_net_impl {
 	ssize_t (*recv)(struct spdk_sock *sock, void *buf, size_t len);
 	ssize_t (*readv)(struct spdk_sock *sock, struct iovec *iov, int iovcnt);
 	ssize_t (*writev)(struct spdk_sock *sock, struct iovec *iov, int iovcnt);
+	/* Optional, implementations without it receive into a buffer allocated by the sock layer */
+	ssize_t (*recv_next)(struct spdk_sock *sock, void **buf, void **ctx);
+	void (*recv_buf_release)(struct spdk_sock *sock, void *ctx);
 
 	void (*writev_async)(struct spdk_sock *sock, struct spdk_sock_request *req);
 	void (*readv_async)(struct spdk_sock *sock, struct spdk_sock_request *req);
@@ -10,6 +10,7 @@
 #include "spdk/thread.h"
 
 struct spdk_poller;
+struct spdk_histogram_data;
 
 struct spdk_poller_stats {
 	uint64_t	run_count;
@@ -25,6 +26,40 @@ const char *spdk_poller_get_state_str(struct spdk_poller *poller);
 uint64_t spdk_poller_get_period_ticks(struct spdk_poller *poller);
 void spdk_poller_get_stats(struct spdk_poller *poller, struct spdk_poller_stats *stats);
 
+/**
+ * Enable or disable collecting histograms of the ticks spent in each poller
+ * invocation, for all pollers on all threads. Histograms are reset when disabled.
+ */
+void spdk_poller_enable_histograms(bool enable);
+bool spdk_poller_histograms_enabled(void);
+
+/**
+ * Get the histogram of ticks spent per invocation of the poller.
+ *
+ * \return the histogram or NULL if histograms are disabled or the poller
+ * hasn't run since they were enabled.
+ */
+const struct spdk_histogram_data *spdk_poller_get_histogram(struct spdk_poller *poller);
+
+/* Resolution of the histograms fed by spdk_thread_record_latency(), ~6% at ~8KiB each. */
+#define SPDK_THREAD_LATENCY_HISTOGRAM_BUCKET_SHIFT	4
+
+/**
+ * Enable or disable collecting the latencies passed to spdk_thread_record_latency()
+ * into per-thread histograms. Samples recorded before enabling are dropped.
+ */
+void spdk_thread_enable_latency_histograms(bool enable);
+bool spdk_thread_latency_histograms_enabled(void);
+
+/**
+ * Get the histogram of latencies recorded on the thread. Must be called from the
+ * thread's own system thread. The caller may reset it once it has been consumed.
+ *
+ * \return the histogram or NULL if latency histograms are disabled or nothing
+ * was recorded on the thread since they were enabled.
+ */
+struct spdk_histogram_data *spdk_thread_get_latency_histogram(struct spdk_thread *thread);
+
 const char *spdk_io_channel_get_io_device_name(struct spdk_io_channel *ch);
 int spdk_io_channel_get_ref_count(struct spdk_io_channel *ch);
 
@@ -74,6 +74,7 @@
 #define TRACE_TCP_QP_DESTROY					SPDK_TPOINT_ID(TRACE_GROUP_NVMF_TCP, 0x15)
 #define TRACE_TCP_QP_ABORT_REQ					SPDK_TPOINT_ID(TRACE_GROUP_NVMF_TCP, 0x16)
 #define TRACE_TCP_QP_RCV_STATE_CHANGE				SPDK_TPOINT_ID(TRACE_GROUP_NVMF_TCP, 0x17)
+#define TRACE_TCP_REQUEST_STATE_AWAIT_QOS			SPDK_TPOINT_ID(TRACE_GROUP_NVMF_TCP, 0x18)
 
 /* NVMe-of RDMA tracepoint definitions */
 #define TRACE_RDMA_REQUEST_STATE_NEW					SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x0)
@@ -94,6 +95,10 @@
 #define TRACE_RDMA_QP_STATE_CHANGE					SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0xF)
 #define TRACE_RDMA_QP_DISCONNECT					SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x10)
 #define TRACE_RDMA_QP_DESTROY						SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x11)
+#define TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_START			SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x12)
+#define TRACE_RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED			SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x13)
+#define TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_RELEASE			SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x14)
+#define TRACE_RDMA_REQUEST_STATE_AWAIT_QOS				SPDK_TPOINT_ID(TRACE_GROUP_NVMF_RDMA, 0x15)
 
 /* Thread tracepoint definitions */
 #define TRACE_THREAD_IOCH_GET		SPDK_TPOINT_ID(TRACE_GROUP_THREAD, 0x0)
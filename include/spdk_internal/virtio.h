@@ -101,11 +101,24 @@ struct virtio_dev_ops {
 struct vq_desc_extra {
 	void *cookie;
 	uint16_t ndescs;
+	/** Next free buffer id. Only used with packed virtqueues. */
+	uint16_t next;
+};
+
+/** Descriptor ring and event suppression areas of a packed virtqueue */
+struct vring_packed {
+	struct vring_packed_desc *desc;
+	struct vring_packed_desc_event *driver;
+	struct vring_packed_desc_event *device;
 };
 
 struct virtqueue {
 	struct virtio_dev *vdev; /**< owner of this virtqueue */
-	struct vring vq_ring;  /**< vring keeping desc, used and avail */
+	union {
+		struct vring vq_ring;  /**< vring keeping desc, used and avail */
+		struct vring_packed vq_packed_ring; /**< used if VIRTIO_F_RING_PACKED is negotiated */
+	};
+	bool vq_packed; /**< packed virtqueue layout is used */
 	/**
 	 * Last consumed descriptor in the used table,
 	 * trails vq_ring.used->idx.
@@ -143,6 +156,22 @@ struct virtqueue {
 	uint16_t req_end;
 	uint16_t reqs_finished;
 
+	/**
+	 * Packed virtqueue state. Descriptors are placed in the ring in order,
+	 * so the ring position of the head descriptor of the current request is
+	 * tracked separately from its buffer id (req_start). The head descriptor
+	 * flags are only written once the whole chain has been filled.
+	 */
+	uint16_t req_head_pos;
+	uint16_t req_head_flags;
+	bool req_head_wrap_counter;
+	bool avail_wrap_counter;
+	bool used_wrap_counter;
+	/** AVAIL/USED flag bits matching the current avail_wrap_counter */
+	uint16_t avail_used_flags;
+	/** Descriptors made available since the last notification */
+	uint16_t descs_finished;
+
 	struct vq_desc_extra vq_descx[0];
 };
 
@@ -165,6 +194,22 @@ typedef int (*virtio_pci_create_cb)(struct virtio_pci_ctx *pci_ctx, void *ctx);
 
 uint16_t virtio_recv_pkts(struct virtqueue *vq, void **io, uint32_t *len, uint16_t io_cnt);
 
+/**
+ * Get the addresses of the three areas of a virtqueue ring located at
+ * \c ring_addr. For split virtqueues these are the descriptor table, the
+ * available ring and the used ring. For packed virtqueues these are the
+ * descriptor ring and the driver and device event suppression structures.
+ * Backends should call this from their \c setup_queue callback.
+ *
+ * \param vq virtio queue
+ * \param ring_addr address of the ring memory, either virtual or physical
+ * \param desc_addr descriptor area address (output)
+ * \param driver_addr driver area address (output)
+ * \param device_addr device area address (output)
+ */
+void virtqueue_get_ring_addrs(struct virtqueue *vq, uint64_t ring_addr, uint64_t *desc_addr,
+			      uint64_t *driver_addr, uint64_t *device_addr);
+
 /**
  * Start a new request on the current vring head position and associate it
  * with an opaque cookie object. The previous request in given vq will be
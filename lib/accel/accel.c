@@ -38,6 +38,13 @@
 struct accel_module {
 	struct spdk_accel_module_if	*module;
 	bool				supports_memory_domains;
+	/* Software module used for operations not dispatched to the module above */
+	struct spdk_accel_module_if	*sw_module;
+};
+
+struct accel_opc_dispatch {
+	uint64_t			sw_max_bytes;
+	uint32_t			max_queue_depth;
 };
 
 /* Largest context size for all accel modules */
@@ -60,6 +67,7 @@ static struct spdk_spinlock g_keyring_spin;
 /* Global array mapping capabilities to modules */
 static struct accel_module g_modules_opc[ACCEL_OPC_LAST] = {};
 static char *g_modules_opc_override[ACCEL_OPC_LAST] = {};
+static struct accel_opc_dispatch g_opc_dispatch[ACCEL_OPC_LAST] = {};
 TAILQ_HEAD(, spdk_accel_driver) g_accel_drivers = TAILQ_HEAD_INITIALIZER(g_accel_drivers);
 static struct spdk_accel_driver *g_accel_driver;
 static struct spdk_accel_opts g_opts = {
@@ -74,7 +82,8 @@ static struct spdk_spinlock g_stats_lock;
 
 static const char *g_opcode_strings[ACCEL_OPC_LAST] = {
 	"copy", "fill", "dualcast", "compare", "crc32c", "copy_crc32c",
-	"compress", "decompress", "encrypt", "decrypt", "xor"
+	"compress", "decompress", "encrypt", "decrypt", "xor",
+	"dif_verify", "dif_generate"
 };
 
 enum accel_sequence_state {
@@ -91,6 +100,8 @@ enum accel_sequence_state {
 	ACCEL_SEQUENCE_STATE_NEXT_TASK,
 	ACCEL_SEQUENCE_STATE_PUSH_DATA,
 	ACCEL_SEQUENCE_STATE_AWAIT_PUSH_DATA,
+	ACCEL_SEQUENCE_STATE_DOMAIN_COPY,
+	ACCEL_SEQUENCE_STATE_AWAIT_DOMAIN_COPY,
 	ACCEL_SEQUENCE_STATE_DRIVER_EXEC,
 	ACCEL_SEQUENCE_STATE_DRIVER_AWAIT_TASK,
 	ACCEL_SEQUENCE_STATE_DRIVER_COMPLETE,
@@ -113,6 +124,8 @@ __attribute__((unused)) = {
 	[ACCEL_SEQUENCE_STATE_NEXT_TASK] = "next-task",
 	[ACCEL_SEQUENCE_STATE_PUSH_DATA] = "push-data",
 	[ACCEL_SEQUENCE_STATE_AWAIT_PUSH_DATA] = "await-push-data",
+	[ACCEL_SEQUENCE_STATE_DOMAIN_COPY] = "domain-copy",
+	[ACCEL_SEQUENCE_STATE_AWAIT_DOMAIN_COPY] = "await-domain-copy",
 	[ACCEL_SEQUENCE_STATE_DRIVER_EXEC] = "driver-exec",
 	[ACCEL_SEQUENCE_STATE_DRIVER_AWAIT_TASK] = "driver-await-task",
 	[ACCEL_SEQUENCE_STATE_DRIVER_COMPLETE] = "driver-complete",
@@ -136,6 +149,8 @@ struct accel_buffer {
 
 struct accel_io_channel {
 	struct spdk_io_channel			*module_ch[ACCEL_OPC_LAST];
+	struct spdk_io_channel			*sw_ch[ACCEL_OPC_LAST];
+	uint32_t				queue_depth[ACCEL_OPC_LAST];
 	void					*task_pool_base;
 	struct spdk_accel_sequence		*seq_pool_base;
 	struct accel_buffer			*buf_pool_base;
@@ -258,6 +273,24 @@ spdk_accel_assign_opc(enum accel_opcode opcode, const char *name)
 	return 0;
 }
 
+int
+spdk_accel_set_opc_dispatch(enum accel_opcode opcode, uint64_t sw_max_bytes,
+			    uint32_t max_queue_depth)
+{
+	if (g_modules_started == true) {
+		return -EINVAL;
+	}
+
+	if (opcode >= ACCEL_OPC_LAST || opcode == ACCEL_OPC_ENCRYPT || opcode == ACCEL_OPC_DECRYPT) {
+		return -EINVAL;
+	}
+
+	g_opc_dispatch[opcode].sw_max_bytes = sw_max_bytes;
+	g_opc_dispatch[opcode].max_queue_depth = max_queue_depth;
+
+	return 0;
+}
+
 void
 spdk_accel_task_complete(struct spdk_accel_task *accel_task, int status)
 {
@@ -271,6 +304,12 @@ spdk_accel_task_complete(struct spdk_accel_task *accel_task, int status)
 	 */
 	TAILQ_INSERT_HEAD(&accel_ch->task_pool, accel_task, link);
 
+	if (accel_task->inflight) {
+		assert(accel_ch->queue_depth[accel_task->op_code] > 0);
+		accel_ch->queue_depth[accel_task->op_code]--;
+		accel_task->inflight = false;
+	}
+
 	accel_update_task_stats(accel_ch, accel_task, executed, 1);
 	accel_update_task_stats(accel_ch, accel_task, num_bytes, accel_task->nbytes);
 	if (spdk_unlikely(status != 0)) {
@@ -299,10 +338,31 @@ _get_task(struct accel_io_channel *accel_ch, spdk_accel_completion_cb cb_fn, voi
 	accel_task->accel_ch = accel_ch;
 	accel_task->bounce.s.orig_iovs = NULL;
 	accel_task->bounce.d.orig_iovs = NULL;
+	accel_task->inflight = false;
 
 	return accel_task;
 }
 
+static inline bool
+accel_task_dispatch_sw(struct accel_io_channel *accel_ch, struct spdk_accel_task *task)
+{
+	struct accel_opc_dispatch *dispatch = &g_opc_dispatch[task->op_code];
+
+	/* The software module doesn't support memory domains */
+	if (task->src_domain != NULL || task->dst_domain != NULL) {
+		return false;
+	}
+	if (task->nbytes > 0 && task->nbytes <= dispatch->sw_max_bytes) {
+		return true;
+	}
+	if (dispatch->max_queue_depth > 0 &&
+	    accel_ch->queue_depth[task->op_code] >= dispatch->max_queue_depth) {
+		return true;
+	}
+
+	return false;
+}
+
 static inline int
 accel_submit_task(struct accel_io_channel *accel_ch, struct spdk_accel_task *task)
 {
@@ -310,8 +370,22 @@ accel_submit_task(struct accel_io_channel *accel_ch, struct spdk_accel_task *tas
 	struct spdk_accel_module_if *module = g_modules_opc[task->op_code].module;
 	int rc;
 
+	if (g_modules_opc[task->op_code].sw_module != NULL) {
+		if (accel_task_dispatch_sw(accel_ch, task)) {
+			module_ch = accel_ch->sw_ch[task->op_code];
+			module = g_modules_opc[task->op_code].sw_module;
+		} else {
+			accel_ch->queue_depth[task->op_code]++;
+			task->inflight = true;
+		}
+	}
+
 	rc = module->submit_tasks(module_ch, task);
 	if (spdk_unlikely(rc != 0)) {
+		if (task->inflight) {
+			accel_ch->queue_depth[task->op_code]--;
+			task->inflight = false;
+		}
 		accel_update_task_stats(accel_ch, task, failed, 1);
 	}
 
@@ -769,6 +843,61 @@ spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uin
 	return accel_submit_task(accel_ch, accel_task);
 }
 
+int
+spdk_accel_submit_dif_verify(struct spdk_io_channel *ch, struct iovec *iovs, size_t iovcnt,
+			     uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+			     struct spdk_dif_error *err, spdk_accel_completion_cb cb_fn,
+			     void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = iovs;
+	accel_task->s.iovcnt = iovcnt;
+	accel_task->nbytes = accel_get_iovlen(iovs, iovcnt);
+	accel_task->dif.ctx = ctx;
+	accel_task->dif.err = err;
+	accel_task->num_blocks = num_blocks;
+	accel_task->op_code = ACCEL_OPC_DIF_VERIFY;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+	accel_task->step_cb_fn = NULL;
+
+	return accel_submit_task(accel_ch, accel_task);
+}
+
+int
+spdk_accel_submit_dif_generate(struct spdk_io_channel *ch, struct iovec *iovs, size_t iovcnt,
+			       uint32_t num_blocks, const struct spdk_dif_ctx *ctx,
+			       spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct accel_io_channel *accel_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_accel_task *accel_task;
+
+	accel_task = _get_task(accel_ch, cb_fn, cb_arg);
+	if (accel_task == NULL) {
+		return -ENOMEM;
+	}
+
+	accel_task->s.iovs = iovs;
+	accel_task->s.iovcnt = iovcnt;
+	accel_task->nbytes = accel_get_iovlen(iovs, iovcnt);
+	accel_task->dif.ctx = ctx;
+	accel_task->dif.err = NULL;
+	accel_task->num_blocks = num_blocks;
+	accel_task->op_code = ACCEL_OPC_DIF_GENERATE;
+	accel_task->src_domain = NULL;
+	accel_task->dst_domain = NULL;
+	accel_task->step_cb_fn = NULL;
+
+	return accel_submit_task(accel_ch, accel_task);
+}
+
 static inline struct accel_buffer *
 accel_get_buf(struct accel_io_channel *ch, uint64_t len)
 {
@@ -1569,6 +1698,64 @@ accel_task_push_data(struct spdk_accel_sequence *seq, struct spdk_accel_task *ta
 	}
 }
 
+static bool
+accel_task_is_domain_copy(struct spdk_accel_task *task)
+{
+	/* A copy between a memory domain and local memory is exactly what pulling/pushing the data
+	 * does, so there's no need to go through a bounce buffer and execute the copy afterwards */
+	return task->op_code == ACCEL_OPC_COPY &&
+	       (task->src_domain == NULL) != (task->dst_domain == NULL);
+}
+
+static void
+accel_task_domain_copy_cb(void *ctx, int status)
+{
+	struct spdk_accel_sequence *seq = ctx;
+	struct spdk_accel_task *task = TAILQ_FIRST(&seq->tasks);
+
+	assert(seq->state == ACCEL_SEQUENCE_STATE_AWAIT_DOMAIN_COPY);
+	accel_update_task_stats(seq->ch, task, executed, 1);
+	accel_update_task_stats(seq->ch, task, num_bytes, task->nbytes);
+	if (spdk_likely(status == 0)) {
+		accel_sequence_set_state(seq, ACCEL_SEQUENCE_STATE_NEXT_TASK);
+	} else {
+		accel_update_task_stats(seq->ch, task, failed, 1);
+		accel_sequence_set_fail(seq, status);
+	}
+
+	accel_process_sequence(seq);
+}
+
+static void
+accel_task_domain_copy(struct spdk_accel_sequence *seq, struct spdk_accel_task *task)
+{
+	struct spdk_memory_domain *domain;
+	int rc;
+
+	assert(accel_task_is_domain_copy(task));
+	assert(task->src_domain != g_accel_domain && task->dst_domain != g_accel_domain);
+
+	if (task->src_domain != NULL) {
+		domain = task->src_domain;
+		rc = spdk_memory_domain_pull_data(task->src_domain, task->src_domain_ctx,
+						  task->s.iovs, task->s.iovcnt,
+						  task->d.iovs, task->d.iovcnt,
+						  accel_task_domain_copy_cb, seq);
+	} else {
+		domain = task->dst_domain;
+		rc = spdk_memory_domain_push_data(task->dst_domain, task->dst_domain_ctx,
+						  task->d.iovs, task->d.iovcnt,
+						  task->s.iovs, task->s.iovcnt,
+						  accel_task_domain_copy_cb, seq);
+	}
+
+	if (spdk_unlikely(rc != 0)) {
+		SPDK_ERRLOG("Failed to copy data using memory domain: %s, rc: %d\n",
+			    spdk_memory_domain_get_dma_device_id(domain), rc);
+		accel_sequence_set_fail(seq, rc);
+	}
+}
+
 static void
 accel_process_sequence(struct spdk_accel_sequence *seq)
 {
@@ -1610,6 +1797,10 @@ accel_process_sequence(struct spdk_accel_sequence *seq)
 				accel_sequence_set_state(seq, ACCEL_SEQUENCE_STATE_EXEC_TASK);
 				break;
 			}
+			if (accel_task_is_domain_copy(task)) {
+				accel_sequence_set_state(seq, ACCEL_SEQUENCE_STATE_DOMAIN_COPY);
+				break;
+			}
 			accel_sequence_set_state(seq, ACCEL_SEQUENCE_STATE_AWAIT_BOUNCEBUF);
 			rc = accel_sequence_check_bouncebuf(seq, task);
 			if (rc != 0) {
@@ -1653,6 +1844,12 @@ accel_process_sequence(struct spdk_accel_sequence *seq)
 			accel_sequence_set_state(seq, ACCEL_SEQUENCE_STATE_AWAIT_PUSH_DATA);
 			accel_task_push_data(seq, task);
 			break;
+		case ACCEL_SEQUENCE_STATE_DOMAIN_COPY:
+			SPDK_DEBUGLOG(accel, "Executing copy using memory domain, sequence: %p\n",
+				      seq);
+			accel_sequence_set_state(seq, ACCEL_SEQUENCE_STATE_AWAIT_DOMAIN_COPY);
+			accel_task_domain_copy(seq, task);
+			break;
 		case ACCEL_SEQUENCE_STATE_NEXT_TASK:
 			TAILQ_REMOVE(&seq->tasks, task, seq_link);
 			TAILQ_INSERT_TAIL(&seq->completed, task, seq_link);
@@ -1700,6 +1897,7 @@ accel_process_sequence(struct spdk_accel_sequence *seq)
 		case ACCEL_SEQUENCE_STATE_AWAIT_PULL_DATA:
 		case ACCEL_SEQUENCE_STATE_AWAIT_TASK:
 		case ACCEL_SEQUENCE_STATE_AWAIT_PUSH_DATA:
+		case ACCEL_SEQUENCE_STATE_AWAIT_DOMAIN_COPY:
 		case ACCEL_SEQUENCE_STATE_DRIVER_AWAIT_TASK:
 			break;
 		default:
@@ -1835,6 +2033,43 @@ accel_task_set_dstbuf(struct spdk_accel_task *task, struct spdk_accel_task *next
 	return true;
 }
 
+static bool
+accel_task_fuse_copy_crc32c(struct spdk_accel_task *task, struct spdk_accel_task *next)
+{
+	struct spdk_accel_task *copy, *crc;
+
+	if (g_modules_opc[ACCEL_OPC_COPY_CRC32C].module == NULL) {
+		return false;
+	}
+
+	copy = task->op_code == ACCEL_OPC_COPY ? task : next;
+	crc = task->op_code == ACCEL_OPC_CRC32C ? task : next;
+	assert(copy->op_code == ACCEL_OPC_COPY && crc->op_code == ACCEL_OPC_CRC32C);
+
+	/* Both operations need to read the same data to calculate the crc while copying it */
+	if (copy->src_domain != crc->src_domain) {
+		return false;
+	}
+	if (!accel_compare_iovs(copy->s.iovs, copy->s.iovcnt, crc->s.iovs, crc->s.iovcnt)) {
+		return false;
+	}
+
+	/* The fused operation replaces the first task, so that the order of any other operations
+	 * remains unchanged */
+	if (task == crc) {
+		task->d.iovs = copy->d.iovs;
+		task->d.iovcnt = copy->d.iovcnt;
+		task->dst_domain = copy->dst_domain;
+		task->dst_domain_ctx = copy->dst_domain_ctx;
+	} else {
+		task->crc_dst = crc->crc_dst;
+		task->seed = crc->seed;
+	}
+	task->op_code = ACCEL_OPC_COPY_CRC32C;
+
+	return true;
+}
+
 static void
 accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_task *task,
 			   struct spdk_accel_task **next_task)
@@ -1855,11 +2090,16 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 		    next->op_code != ACCEL_OPC_CRC32C) {
 			break;
 		}
-		if (task->dst_domain != next->src_domain) {
-			break;
-		}
-		if (!accel_compare_iovs(task->d.iovs, task->d.iovcnt,
+		if (task->dst_domain != next->src_domain ||
+		    !accel_compare_iovs(task->d.iovs, task->d.iovcnt,
 					next->s.iovs, next->s.iovcnt)) {
+			/* If the copy can't be removed, try to calculate the crc while copying */
+			if (next->op_code == ACCEL_OPC_CRC32C &&
+			    accel_task_fuse_copy_crc32c(task, next)) {
+				*next_task = TAILQ_NEXT(next, seq_link);
+				TAILQ_REMOVE(&seq->tasks, next, seq_link);
+				TAILQ_INSERT_TAIL(&seq->completed, next, seq_link);
+			}
 			break;
 		}
 		next->s.iovs = task->s.iovs;
@@ -1879,7 +2119,12 @@ accel_sequence_merge_tasks(struct spdk_accel_sequence *seq, struct spdk_accel_ta
 			break;
 		}
 		if (!accel_task_set_dstbuf(task, next)) {
-			break;
+			/* A crc32c followed by a copy of the same data can still be done in a
+			 * single pass */
+			if (task->op_code != ACCEL_OPC_CRC32C ||
+			    !accel_task_fuse_copy_crc32c(task, next)) {
+				break;
+			}
 		}
 		/* We're removing next_task from the tasks queue, so we need to update its pointer,
 		 * so that the TAILQ_FOREACH_SAFE() loop below works correctly */
@@ -1899,7 +2144,8 @@ spdk_accel_sequence_finish(struct spdk_accel_sequence *seq,
 {
 	struct spdk_accel_task *task, *next;
 
-	/* Try to remove any copy operations if possible */
+	/* Try to remove any copy operations if possible and fuse the remaining ones with adjacent
+	 * crc32c operations */
 	TAILQ_FOREACH_SAFE(task, &seq->tasks, seq_link, next) {
 		if (next == NULL) {
 			break;
@@ -2255,6 +2501,13 @@ accel_create_channel(void *io_device, void *ctx_buf)
 		if (accel_ch->module_ch[i] == NULL) {
 			goto err;
 		}
+		if (g_modules_opc[i].sw_module != NULL) {
+			accel_ch->sw_ch[i] = g_modules_opc[i].sw_module->get_io_channel();
+			if (accel_ch->sw_ch[i] == NULL) {
+				spdk_put_io_channel(accel_ch->module_ch[i]);
+				goto err;
+			}
+		}
 	}
 
 	rc = spdk_iobuf_channel_init(&accel_ch->iobuf, "accel", g_opts.small_cache_size,
@@ -2268,6 +2521,10 @@ accel_create_channel(void *io_device, void *ctx_buf)
 err:
 	for (j = 0; j < i; j++) {
 		spdk_put_io_channel(accel_ch->module_ch[j]);
+		if (accel_ch->sw_ch[j] != NULL) {
+			spdk_put_io_channel(accel_ch->sw_ch[j]);
+			accel_ch->sw_ch[j] = NULL;
+		}
 	}
 	free(accel_ch->task_pool_base);
 	free(accel_ch->seq_pool_base);
@@ -2290,6 +2547,15 @@ accel_add_stats(struct accel_stats *total, struct accel_stats *stats)
 	}
 }
 
+/* Framework level channel migration callback. */
+static void
+accel_migrate_channel(void *io_device, void *ctx_buf)
+{
+	struct accel_io_channel	*accel_ch = ctx_buf;
+
+	spdk_iobuf_channel_migrate(&accel_ch->iobuf);
+}
+
 /* Framework level channel destroy callback. */
 static void
 accel_destroy_channel(void *io_device, void *ctx_buf)
@@ -2303,6 +2569,10 @@ accel_destroy_channel(void *io_device, void *ctx_buf)
 		assert(accel_ch->module_ch[i] != NULL);
 		spdk_put_io_channel(accel_ch->module_ch[i]);
 		accel_ch->module_ch[i] = NULL;
+		if (accel_ch->sw_ch[i] != NULL) {
+			spdk_put_io_channel(accel_ch->sw_ch[i]);
+			accel_ch->sw_ch[i] = NULL;
+		}
 	}
 
 	/* Update global stats to make sure channel's stats aren't lost after a channel is gone */
@@ -2342,6 +2612,36 @@ accel_module_init_opcode(enum accel_opcode opcode)
 	}
 }
 
+static int
+accel_module_init_opcode_dispatch(enum accel_opcode opcode)
+{
+	struct accel_module *module = &g_modules_opc[opcode];
+	struct accel_opc_dispatch *dispatch = &g_opc_dispatch[opcode];
+	struct spdk_accel_module_if *sw_module;
+
+	if (dispatch->sw_max_bytes == 0 && dispatch->max_queue_depth == 0) {
+		return 0;
+	}
+
+	sw_module = _module_find_by_name("software");
+	if (sw_module == NULL || module->module == sw_module) {
+		return 0;
+	}
+
+	if (!sw_module->supports_opcode(opcode)) {
+		SPDK_ERRLOG("Software module doesn't support op code %d, it cannot be dispatched\n",
+			    opcode);
+		return -EINVAL;
+	}
+
+	module->sw_module = sw_module;
+	SPDK_DEBUGLOG(accel, "OPC 0x%x dispatched to %s up to %"PRIu64" bytes or above %"PRIu32
+		      " outstanding operations\n", opcode, sw_module->name, dispatch->sw_max_bytes,
+		      dispatch->max_queue_depth);
+
+	return 0;
+}
+
 int
 spdk_accel_initialize(void)
 {
@@ -2404,6 +2704,10 @@ spdk_accel_initialize(void)
 	for (op = 0; op < ACCEL_OPC_LAST; op++) {
 		assert(g_modules_opc[op].module != NULL);
 		accel_module_init_opcode(op);
+		rc = accel_module_init_opcode_dispatch(op);
+		if (rc != 0) {
+			goto error;
+		}
 	}
 
 	rc = spdk_iobuf_register_module("accel");
@@ -2418,6 +2722,7 @@ spdk_accel_initialize(void)
 	 */
 	spdk_io_device_register(&spdk_accel_module_list, accel_create_channel, accel_destroy_channel,
 				sizeof(struct accel_io_channel), "accel");
+	spdk_io_device_set_migrate_cb(&spdk_accel_module_list, accel_migrate_channel);
 
 	return 0;
 error:
@@ -2451,6 +2756,20 @@ accel_write_overridden_opc(struct spdk_json_write_ctx *w, const char *opc_str,
 	spdk_json_write_object_end(w);
 }
 
+static void
+accel_write_opc_dispatch(struct spdk_json_write_ctx *w, const char *opc_str,
+			 struct accel_opc_dispatch *dispatch)
+{
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "accel_set_opc_dispatch");
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "opname", opc_str);
+	spdk_json_write_named_uint64(w, "sw_max_bytes", dispatch->sw_max_bytes);
+	spdk_json_write_named_uint32(w, "max_queue_depth", dispatch->max_queue_depth);
+	spdk_json_write_object_end(w);
+	spdk_json_write_object_end(w);
+}
+
 static void
 __accel_crypto_key_dump_param(struct spdk_json_write_ctx *w, struct spdk_accel_crypto_key *key)
 {
@@ -2537,6 +2856,9 @@ spdk_accel_write_config_json(struct spdk_json_write_ctx *w)
 		if (g_modules_opc_override[i]) {
 			accel_write_overridden_opc(w, g_opcode_strings[i], g_modules_opc_override[i]);
 		}
+		if (g_opc_dispatch[i].sw_max_bytes != 0 || g_opc_dispatch[i].max_queue_depth != 0) {
+			accel_write_opc_dispatch(w, g_opcode_strings[i], &g_opc_dispatch[i]);
+		}
 	}
 
 	_accel_crypto_keys_write_config_json(w, true);
@@ -2585,6 +2907,8 @@ accel_io_device_unregister_cb(void *io_device)
 			g_modules_opc_override[op] = NULL;
 		}
 		g_modules_opc[op].module = NULL;
+		g_modules_opc[op].sw_module = NULL;
+		memset(&g_opc_dispatch[op], 0, sizeof(g_opc_dispatch[op]));
 	}
 
 	spdk_accel_module_finish();
@@ -175,6 +175,72 @@ cleanup:
 }
 SPDK_RPC_REGISTER("accel_assign_opc", rpc_accel_assign_opc, SPDK_RPC_STARTUP)
 
+struct rpc_accel_set_opc_dispatch {
+	char *opname;
+	uint64_t sw_max_bytes;
+	uint32_t max_queue_depth;
+};
+
+static const struct spdk_json_object_decoder rpc_accel_set_opc_dispatch_decoders[] = {
+	{"opname", offsetof(struct rpc_accel_set_opc_dispatch, opname), spdk_json_decode_string},
+	{
+		"sw_max_bytes", offsetof(struct rpc_accel_set_opc_dispatch, sw_max_bytes),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"max_queue_depth", offsetof(struct rpc_accel_set_opc_dispatch, max_queue_depth),
+		spdk_json_decode_uint32, true
+	},
+};
+
+static void
+rpc_accel_set_opc_dispatch(struct spdk_jsonrpc_request *request,
+			   const struct spdk_json_val *params)
+{
+	struct rpc_accel_set_opc_dispatch req = {};
+	const char *opcode_str;
+	enum accel_opcode opcode;
+	bool found = false;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_accel_set_opc_dispatch_decoders,
+				    SPDK_COUNTOF(rpc_accel_set_opc_dispatch_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(accel, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_PARSE_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	for (opcode = 0; opcode < ACCEL_OPC_LAST; opcode++) {
+		rc = _accel_get_opc_name(opcode, &opcode_str);
+		assert(!rc);
+		if (strcmp(opcode_str, req.opname) == 0) {
+			found = true;
+			break;
+		}
+	}
+
+	if (found == false) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid operation name");
+		goto cleanup;
+	}
+
+	rc = spdk_accel_set_opc_dispatch(opcode, req.sw_max_bytes, req.max_queue_depth);
+	if (rc) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "error setting opcode dispatch");
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free(req.opname);
+}
+SPDK_RPC_REGISTER("accel_set_opc_dispatch", rpc_accel_set_opc_dispatch, SPDK_RPC_STARTUP)
+
 struct rpc_accel_crypto_key_create {
 	struct spdk_accel_crypto_key_create_param param;
 };
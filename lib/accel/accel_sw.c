@@ -17,6 +17,7 @@
 #include "spdk/crc32.h"
 #include "spdk/util.h"
 #include "spdk/xor.h"
+#include "spdk/dif.h"
 
 #ifdef SPDK_CONFIG_ISAL
 #include "../isa-l/include/igzip_lib.h"
@@ -78,6 +79,8 @@ sw_accel_supports_opcode(enum accel_opcode opc)
 	case ACCEL_OPC_ENCRYPT:
 	case ACCEL_OPC_DECRYPT:
 	case ACCEL_OPC_XOR:
+	case ACCEL_OPC_DIF_VERIFY:
+	case ACCEL_OPC_DIF_GENERATE:
 		return true;
 	default:
 		return false;
@@ -442,6 +445,33 @@ _sw_accel_xor(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_t
 			    accel_task->d.iovs[0].iov_len);
 }
 
+static int
+_sw_accel_dif_verify(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	int rc;
+
+	rc = spdk_dif_verify(accel_task->s.iovs,
+			     accel_task->s.iovcnt,
+			     accel_task->num_blocks,
+			     accel_task->dif.ctx,
+			     accel_task->dif.err);
+	/* A protection information mismatch is reported as -1 */
+	if (rc != 0 && rc != -EINVAL) {
+		rc = -EIO;
+	}
+
+	return rc;
+}
+
+static int
+_sw_accel_dif_generate(struct sw_accel_io_channel *sw_ch, struct spdk_accel_task *accel_task)
+{
+	return spdk_dif_generate(accel_task->s.iovs,
+				 accel_task->s.iovcnt,
+				 accel_task->num_blocks,
+				 accel_task->dif.ctx);
+}
+
 static int
 sw_accel_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *accel_task)
 {
@@ -492,6 +522,12 @@ sw_accel_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *accel_
 		case ACCEL_OPC_DECRYPT:
 			rc = _sw_accel_decrypt(sw_ch, accel_task);
 			break;
+		case ACCEL_OPC_DIF_VERIFY:
+			rc = _sw_accel_dif_verify(sw_ch, accel_task);
+			break;
+		case ACCEL_OPC_DIF_GENERATE:
+			rc = _sw_accel_dif_generate(sw_ch, accel_task);
+			break;
 		default:
 			assert(false);
 			break;
@@ -20,6 +20,7 @@
 #include "spdk/util.h"
 #include "spdk/trace.h"
 #include "spdk/dma.h"
+#include "spdk/metrics.h"
 
 #include "spdk/bdev_module.h"
 #include "spdk/log.h"
@@ -57,6 +58,7 @@ int __itt_init_ittlib(const char *, __itt_group_id);
  */
 #define SPDK_BDEV_MAX_CHILDREN_UNMAP_WRITE_ZEROES_REQS (8)
 #define BDEV_RESET_CHECK_OUTSTANDING_IO_PERIOD 1000000
+#define BDEV_METRICS_UPDATE_PERIOD 1000000
 
 /* The maximum number of children requests for a COPY command
  * when splitting into children requests at a time.
@@ -108,6 +110,15 @@ struct spdk_bdev_mgr {
 
 	struct spdk_spinlock spinlock;
 
+	TAILQ_HEAD(, bdev_latency_group) latency_groups;
+
+	/* Bdevs whose examine_disk is deferred, see spdk_bdev_opts.examine_queue_depth */
+	TAILQ_HEAD(, bdev_examine_pending) examine_pending;
+	uint32_t examine_pending_count;
+	/* Number of examine_disk callbacks in progress, only accessed on the app thread */
+	uint32_t examine_disk_in_progress;
+	bool examine_dispatching;
+
 #ifdef SPDK_CONFIG_VTUNE
 	__itt_domain	*domain;
 #endif
@@ -117,10 +128,21 @@ static struct spdk_bdev_mgr g_bdev_mgr = {
 	.bdev_modules = TAILQ_HEAD_INITIALIZER(g_bdev_mgr.bdev_modules),
 	.bdevs = TAILQ_HEAD_INITIALIZER(g_bdev_mgr.bdevs),
 	.bdev_names = RB_INITIALIZER(g_bdev_mgr.bdev_names),
+	.latency_groups = TAILQ_HEAD_INITIALIZER(g_bdev_mgr.latency_groups),
+	.examine_pending = TAILQ_HEAD_INITIALIZER(g_bdev_mgr.examine_pending),
 	.init_complete = false,
 	.module_init_complete = false,
 };
 
+/*
+ * Bdevs exported through the metrics library.  The metrics are collected from a non-SPDK
+ * thread, which can't take spdk_spinlocks, so this list is protected by a regular mutex.
+ */
+static TAILQ_HEAD(, spdk_bdev) g_bdev_metrics_list = TAILQ_HEAD_INITIALIZER(g_bdev_metrics_list);
+static pthread_mutex_t g_bdev_metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* The metrics are only aggregated while the metrics server is running */
+static bool g_bdev_metrics_enabled;
+
 static void
 __attribute__((constructor))
 _bdev_init(void)
@@ -155,6 +177,12 @@ static spdk_bdev_fini_cb	g_fini_cb_fn = NULL;
 static void			*g_fini_cb_arg = NULL;
 static struct spdk_thread	*g_fini_thread = NULL;
 
+/* Completion batch opened on the current thread, see spdk_bdev_io_complete_batch_begin() */
+static __thread struct {
+	uint32_t				depth;
+	TAILQ_HEAD(, spdk_bdev_channel)		channels;
+} g_complete_batch;
+
 struct spdk_bdev_qos_limit {
 	/** IOs or bytes allowed per second (i.e., 1s). */
 	uint64_t limit;
@@ -180,7 +208,9 @@ struct spdk_bdev_qos_limit {
 };
 
 struct spdk_bdev_qos {
-	/** Types of structure of rate limits. */
+	/** Types of structure of rate limits.  In sharded mode, remaining_this_timeslice
+	 *  is the pool the channels borrow their quota from and is accessed atomically.
+	 */
 	struct spdk_bdev_qos_limit rate_limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
 
 	/** The channel that all I/O are funneled through. */
@@ -200,6 +230,121 @@ struct spdk_bdev_qos {
 
 	/** Poller that processes queued I/O commands each time slice. */
 	struct spdk_poller *poller;
+
+	/** Rate limits are enforced by each channel instead of the QoS thread. */
+	bool sharded;
+
+	/** Incremented each time the quota is refilled or the limits change. */
+	uint64_t timeslice_gen;
+};
+
+/* Amount of quota a channel borrows at once, as a fraction of the timeslice quota. */
+#define BDEV_QOS_SHARD_BATCH_SHIFT	4
+
+struct bdev_qos_shard {
+	/** Local share of the rate limits, borrowed from the QoS pool. */
+	struct spdk_bdev_qos_limit rate_limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+
+	/** Timeslice generation the local quota was borrowed in. */
+	uint64_t timeslice_gen;
+
+	/** Queue of I/O waiting for quota on this channel. */
+	bdev_io_tailq_t queued;
+
+	/** Poller that retries the queued I/O each time slice. */
+	struct spdk_poller *poller;
+};
+
+/* Period over which the latencies are checked against their target. */
+#define BDEV_LATENCY_QOS_WINDOW_IN_USEC	100000
+
+/* Bdevs sharing the same underlying device, throttled together. */
+struct bdev_latency_group {
+	char				*name;
+
+	/** Number of configured bdevs in the group, protected by g_bdev_mgr.spinlock. */
+	uint32_t			ref;
+
+	/** Number of windows in which a member missed its target, accessed atomically. */
+	uint64_t			violations;
+
+	TAILQ_ENTRY(bdev_latency_group)	link;
+};
+
+struct spdk_bdev_latency_qos {
+	struct bdev_latency_group	*group;
+
+	/** p99 latency target, 0 for a bdev throttled on behalf of the others. */
+	uint64_t			target_us;
+};
+
+struct bdev_latency_qos_channel {
+	/** Group of the bdev, NULL if latency QoS is not enabled. */
+	struct bdev_latency_group	*group;
+
+	/** p99 latency target in ticks, 0 for a throttled channel. */
+	uint64_t			target_ticks;
+
+	/** I/O completed in the current window and how many of them missed the target. */
+	uint64_t			completed;
+	uint64_t			over_target;
+
+	/** Group violations already accounted for. */
+	uint64_t			violations;
+
+	/** Maximum number of outstanding I/O, 0 if not throttled. */
+	uint64_t			max_outstanding;
+
+	/** Highest number of outstanding I/O in the current window. */
+	uint64_t			peak_outstanding;
+
+	/** I/O waiting for the number of outstanding I/O to drop. */
+	bdev_io_tailq_t			queued;
+
+	struct spdk_poller		*poller;
+};
+
+/* I/O merged into a single request to the bdev module. */
+struct bdev_coalesce_batch {
+	struct spdk_bdev_desc			*desc;
+	enum spdk_bdev_io_type			type;
+	uint64_t				offset_blocks;
+	uint64_t				num_blocks;
+	bdev_io_tailq_t				ios;
+	int					iovcnt;
+	struct iovec				iovs[SPDK_BDEV_IO_NUM_CHILD_IOV];
+	STAILQ_ENTRY(bdev_coalesce_batch)	link;
+};
+
+struct bdev_coalesce_channel {
+	/** Longest time an I/O waits to be merged, 0 if coalescing is disabled. */
+	uint32_t				window_us;
+
+	/** Largest merged I/O. */
+	uint32_t				max_blocks;
+
+	/** Batch still accepting I/O. */
+	struct bdev_coalesce_batch		*batch;
+
+	STAILQ_HEAD(, bdev_coalesce_batch)	free_batches;
+
+	struct spdk_poller			*poller;
+};
+
+/* Largest number of I/O handed to a bdev module at once */
+#define BDEV_SUBMIT_BATCH_SIZE	32
+
+/* I/O held back from the bdev module while a batch is being submitted. */
+struct bdev_submit_batch {
+	bool					active;
+	uint32_t				count;
+	struct spdk_bdev_io			*ios[BDEV_SUBMIT_BATCH_SIZE];
+};
+
+/* Completions held back on a channel while a completion batch is open on its thread. */
+struct bdev_complete_batch {
+	bdev_io_tailq_t				ios;
+	TAILQ_ENTRY(spdk_bdev_channel)		link;
 };
 
 struct spdk_bdev_mgmt_channel {
@@ -216,8 +361,13 @@ struct spdk_bdev_mgmt_channel {
 
 	struct spdk_iobuf_channel iobuf;
 
-	TAILQ_HEAD(, spdk_bdev_shared_resource)	shared_resources;
+	/* Indexed by the module channel, there may be one for each bdev on a thread */
+	RB_HEAD(bdev_shared_resource_tree, spdk_bdev_shared_resource)	shared_resources;
 	TAILQ_HEAD(, spdk_bdev_io_wait_entry)	io_wait_queue;
+
+	/* bdev channels on this thread, their stats are periodically added to the metrics */
+	TAILQ_HEAD(, spdk_bdev_channel)		channels;
+	struct spdk_poller			*metrics_poller;
 };
 
 /*
@@ -252,9 +402,19 @@ struct spdk_bdev_shared_resource {
 	/* Refcount of bdev channels using this resource */
 	uint32_t		ref;
 
-	TAILQ_ENTRY(spdk_bdev_shared_resource) link;
+	RB_ENTRY(spdk_bdev_shared_resource) node;
 };
 
+static int
+bdev_shared_resource_cmp(struct spdk_bdev_shared_resource *res1,
+			 struct spdk_bdev_shared_resource *res2)
+{
+	return (res1->shared_ch < res2->shared_ch ? -1 : res1->shared_ch > res2->shared_ch);
+}
+
+RB_GENERATE_STATIC(bdev_shared_resource_tree, spdk_bdev_shared_resource, node,
+		   bdev_shared_resource_cmp);
+
 #define BDEV_CH_RESET_IN_PROGRESS	(1 << 0)
 #define BDEV_CH_QOS_ENABLED		(1 << 1)
 
@@ -297,8 +457,21 @@ struct spdk_bdev_channel {
 
 	uint32_t		flags;
 
+	/* Local QoS state, only allocated when QoS is sharded */
+	struct bdev_qos_shard	*qos_shard;
+
+	struct bdev_latency_qos_channel latency_qos;
+
+	struct bdev_coalesce_channel coalesce;
+
+	struct bdev_submit_batch submit_batch;
+
+	struct bdev_complete_batch complete_batch;
+
 	struct spdk_histogram_data *histogram;
 
+	struct spdk_bdev_type_histograms *type_histograms;
+
 #ifdef SPDK_CONFIG_VTUNE
 	uint64_t		start_tsc;
 	uint64_t		interval_tsc;
@@ -309,6 +482,10 @@ struct spdk_bdev_channel {
 	bdev_io_tailq_t		queued_resets;
 
 	lba_range_tailq_t	locked_ranges;
+
+	/* Values of stat the last time they were added to the bdev's metrics */
+	struct spdk_bdev_io_stat metrics_prev;
+	TAILQ_ENTRY(spdk_bdev_channel) metrics_link;
 };
 
 struct media_event_entry {
@@ -340,6 +517,10 @@ struct spdk_bdev_desc {
 	spdk_bdev_io_timeout_cb	cb_fn;
 	void			*cb_arg;
 	struct spdk_poller	*io_timeout_poller;
+	struct {
+		spdk_bdev_completion_batch_cb	cb_fn;
+		void				*cb_arg;
+	}			completion_batch;
 	struct spdk_bdev_module_claim	*claim;
 };
 
@@ -353,6 +534,7 @@ struct set_qos_limit_ctx {
 	void (*cb_fn)(void *cb_arg, int status);
 	void *cb_arg;
 	struct spdk_bdev *bdev;
+	struct spdk_bdev_latency_qos *old_latency_qos;
 };
 
 struct spdk_bdev_channel_iter {
@@ -391,6 +573,10 @@ static int bdev_write_zero_buffer(struct spdk_bdev_io *bdev_io);
 static void bdev_enable_qos_msg(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
 				struct spdk_io_channel *ch, void *_ctx);
 static void bdev_enable_qos_done(struct spdk_bdev *bdev, void *_ctx, int status);
+static void bdev_latency_qos_free(struct spdk_bdev_latency_qos *latency_qos);
+static void bdev_type_histograms_tally(struct spdk_bdev_type_histograms *histograms,
+				       struct spdk_bdev_io *bdev_io, uint64_t tsc_diff);
+static void bdev_type_histograms_free(struct spdk_bdev_type_histograms *histograms);
 
 static int bdev_readv_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 				     struct iovec *iov, int iovcnt, void *md_buf, uint64_t offset_blocks,
@@ -414,6 +600,7 @@ static int bdev_unlock_lba_range(struct spdk_bdev_desc *desc, struct spdk_io_cha
 				 lock_range_cb cb_fn, void *cb_arg);
 
 static bool bdev_abort_queued_io(bdev_io_tailq_t *queue, struct spdk_bdev_io *bio_to_abort);
+static void bdev_abort_all_queued_io(bdev_io_tailq_t *queue, struct spdk_bdev_channel *ch);
 static bool bdev_abort_buf_io(struct spdk_bdev_mgmt_channel *ch, struct spdk_bdev_io *bio_to_abort);
 
 static bool claim_type_is_v2(enum spdk_bdev_claim_type type);
@@ -451,10 +638,12 @@ spdk_bdev_get_opts(struct spdk_bdev_opts *opts, size_t opts_size)
 	SET_FIELD(bdev_auto_examine);
 	SET_FIELD(small_buf_pool_size);
 	SET_FIELD(large_buf_pool_size);
+	SET_FIELD(accel_copy_threshold);
+	SET_FIELD(examine_queue_depth);
 
 	/* Do not remove this statement, you should always update this statement when you adding a new field,
 	 * and do not forget to add the SET_FIELD statement for your added field. */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_bdev_opts) == 32, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_bdev_opts) == 40, "Incorrect size");
 
 #undef SET_FIELD
 }
@@ -511,8 +700,10 @@ spdk_bdev_set_opts(struct spdk_bdev_opts *opts)
 	SET_FIELD(bdev_auto_examine);
 	SET_FIELD(small_buf_pool_size);
 	SET_FIELD(large_buf_pool_size);
+	SET_FIELD(accel_copy_threshold);
+	SET_FIELD(examine_queue_depth);
 
-	spdk_iobuf_get_opts(&iobuf_opts);
+	spdk_iobuf_get_opts(&iobuf_opts, sizeof(iobuf_opts));
 	iobuf_opts.small_pool_count = opts->small_buf_pool_size;
 	iobuf_opts.large_pool_count = opts->large_buf_pool_size;
 
@@ -628,6 +819,14 @@ spdk_bdev_wait_for_examine(spdk_bdev_wait_for_examine_cb cb_fn, void *cb_arg)
 	return 0;
 }
 
+struct bdev_examine_pending {
+	struct spdk_bdev *bdev;
+	TAILQ_ENTRY(bdev_examine_pending) link;
+};
+
+/* Module whose examine_config is being called, to tell its examine_done from an examine_disk one */
+static struct spdk_bdev_module *g_examine_config_module;
+
 struct spdk_bdev_examine_item {
 	char *name;
 	TAILQ_ENTRY(spdk_bdev_examine_item) link;
@@ -688,29 +887,17 @@ bdev_ok_to_examine(struct spdk_bdev *bdev)
 }
 
 static void
-bdev_examine(struct spdk_bdev *bdev)
+bdev_examine_disk_call(struct spdk_bdev_module *module, struct spdk_bdev *bdev)
+{
+	g_bdev_mgr.examine_disk_in_progress++;
+	module->examine_disk(bdev);
+}
+
+static void
+bdev_examine_disk(struct spdk_bdev *bdev)
 {
 	struct spdk_bdev_module *module;
 	struct spdk_bdev_module_claim *claim, *tmpclaim;
-	uint32_t action;
-
-	if (!bdev_ok_to_examine(bdev)) {
-		return;
-	}
-
-	TAILQ_FOREACH(module, &g_bdev_mgr.bdev_modules, internal.tailq) {
-		if (module->examine_config) {
-			spdk_spin_lock(&module->internal.spinlock);
-			action = module->internal.action_in_progress;
-			module->internal.action_in_progress++;
-			spdk_spin_unlock(&module->internal.spinlock);
-			module->examine_config(bdev);
-			if (action != module->internal.action_in_progress) {
-				SPDK_ERRLOG("examine_config for module %s did not call "
-					    "spdk_bdev_module_examine_done()\n", module->name);
-			}
-		}
-	}
 
 	spdk_spin_lock(&bdev->internal.spinlock);
 
@@ -723,7 +910,7 @@ bdev_examine(struct spdk_bdev *bdev)
 				module->internal.action_in_progress++;
 				spdk_spin_unlock(&module->internal.spinlock);
 				spdk_spin_unlock(&bdev->internal.spinlock);
-				module->examine_disk(bdev);
+				bdev_examine_disk_call(module, bdev);
 				spdk_spin_lock(&bdev->internal.spinlock);
 			}
 		}
@@ -736,7 +923,7 @@ bdev_examine(struct spdk_bdev *bdev)
 			module->internal.action_in_progress++;
 			spdk_spin_unlock(&module->internal.spinlock);
 			spdk_spin_unlock(&bdev->internal.spinlock);
-			module->examine_disk(bdev);
+			bdev_examine_disk_call(module, bdev);
 			return;
 		}
 		break;
@@ -768,7 +955,7 @@ bdev_examine(struct spdk_bdev *bdev)
 
 			/* Call examine_disk without holding internal.spinlock. */
 			spdk_spin_unlock(&bdev->internal.spinlock);
-			module->examine_disk(bdev);
+			bdev_examine_disk_call(module, bdev);
 			spdk_spin_lock(&bdev->internal.spinlock);
 		}
 
@@ -793,6 +980,124 @@ bdev_examine(struct spdk_bdev *bdev)
 	spdk_spin_unlock(&bdev->internal.spinlock);
 }
 
+static bool
+bdev_examine_disk_allowed(void)
+{
+	return g_bdev_opts.examine_queue_depth == 0 ||
+	       g_bdev_mgr.examine_disk_in_progress < g_bdev_opts.examine_queue_depth;
+}
+
+static void
+bdev_examine_pending_dispatch(void)
+{
+	struct bdev_examine_pending *pending;
+	bool removed = false;
+
+	/* examine_done may be called from within examine_disk, the loop below takes care of it */
+	if (g_bdev_mgr.examine_dispatching) {
+		return;
+	}
+
+	g_bdev_mgr.examine_dispatching = true;
+	while (bdev_examine_disk_allowed()) {
+		spdk_spin_lock(&g_bdev_mgr.spinlock);
+		pending = TAILQ_FIRST(&g_bdev_mgr.examine_pending);
+		if (pending != NULL) {
+			TAILQ_REMOVE(&g_bdev_mgr.examine_pending, pending, link);
+			removed = pending->bdev->internal.status != SPDK_BDEV_STATUS_READY;
+		}
+		spdk_spin_unlock(&g_bdev_mgr.spinlock);
+
+		if (pending == NULL) {
+			break;
+		}
+
+		/* The bdev stays registered until its examine is done, but it may have been
+		 * unregistered in the meantime, don't examine it anymore. */
+		if (!removed) {
+			bdev_examine_disk(pending->bdev);
+		}
+		free(pending);
+
+		/* Only drop the count after examine_disk has bumped the modules' actions, so that
+		 * waiting for examine doesn't complete in between */
+		g_bdev_mgr.examine_pending_count--;
+	}
+	g_bdev_mgr.examine_dispatching = false;
+}
+
+static void
+bdev_examine_disk_done(void *ctx)
+{
+	assert(g_bdev_mgr.examine_disk_in_progress > 0);
+	g_bdev_mgr.examine_disk_in_progress--;
+	bdev_examine_pending_dispatch();
+}
+
+static void
+bdev_examine_pending_remove(struct spdk_bdev *bdev)
+{
+	struct bdev_examine_pending *pending, *tmp;
+
+	assert(spdk_spin_held(&g_bdev_mgr.spinlock));
+
+	TAILQ_FOREACH_SAFE(pending, &g_bdev_mgr.examine_pending, link, tmp) {
+		if (pending->bdev == bdev) {
+			TAILQ_REMOVE(&g_bdev_mgr.examine_pending, pending, link);
+			g_bdev_mgr.examine_pending_count--;
+			free(pending);
+		}
+	}
+}
+
+static void
+bdev_examine(struct spdk_bdev *bdev)
+{
+	struct spdk_bdev_module *module;
+	struct bdev_examine_pending *pending;
+	uint32_t action;
+
+	if (!bdev_ok_to_examine(bdev)) {
+		return;
+	}
+
+	TAILQ_FOREACH(module, &g_bdev_mgr.bdev_modules, internal.tailq) {
+		if (module->examine_config) {
+			spdk_spin_lock(&module->internal.spinlock);
+			action = module->internal.action_in_progress;
+			module->internal.action_in_progress++;
+			spdk_spin_unlock(&module->internal.spinlock);
+			g_examine_config_module = module;
+			module->examine_config(bdev);
+			g_examine_config_module = NULL;
+			if (action != module->internal.action_in_progress) {
+				SPDK_ERRLOG("examine_config for module %s did not call "
+					    "spdk_bdev_module_examine_done()\n", module->name);
+			}
+		}
+	}
+
+	/*
+	 * examine_disk usually reads the bdev's metadata, so limit the number of bdevs examined at
+	 * once.  The others are queued, keeping their registration order.
+	 */
+	if (!bdev_examine_disk_allowed() || g_bdev_mgr.examine_pending_count > 0) {
+		pending = calloc(1, sizeof(*pending));
+		if (pending != NULL) {
+			pending->bdev = bdev;
+			spdk_spin_lock(&g_bdev_mgr.spinlock);
+			TAILQ_INSERT_TAIL(&g_bdev_mgr.examine_pending, pending, link);
+			g_bdev_mgr.examine_pending_count++;
+			spdk_spin_unlock(&g_bdev_mgr.spinlock);
+			return;
+		}
+
+		SPDK_WARNLOG("Unable to defer examine of bdev %s\n", bdev->name);
+	}
+
+	bdev_examine_disk(bdev);
+}
+
 int
 spdk_bdev_examine(const char *name)
 {
@@ -1258,6 +1563,34 @@ bdev_io_pull_data_done_and_track(void *ctx, int status)
 	bdev_io_pull_data_done(bdev_io, status);
 }
 
+/* Offload a bounce buffer copy to accel if it's large enough.  Returns 0 if the copy was
+ * submitted, in which case cb_fn is executed once it's done. */
+static int
+bdev_io_accel_copy(struct spdk_bdev_io *bdev_io, struct iovec *dst_iovs, uint32_t dst_iovcnt,
+		   struct iovec *src_iovs, uint32_t src_iovcnt, size_t len,
+		   spdk_accel_completion_cb cb_fn)
+{
+	struct spdk_bdev_channel *ch = bdev_io->internal.ch;
+	struct spdk_accel_sequence *seq = NULL;
+	int rc;
+
+	if (g_bdev_opts.accel_copy_threshold == 0 || len < g_bdev_opts.accel_copy_threshold) {
+		return -ENOTSUP;
+	}
+
+	rc = spdk_accel_append_copy(&seq, ch->accel_channel, dst_iovs, dst_iovcnt, NULL, NULL,
+				    src_iovs, src_iovcnt, NULL, NULL, 0, NULL, NULL);
+	if (spdk_unlikely(rc != 0)) {
+		return rc;
+	}
+
+	TAILQ_INSERT_TAIL(&ch->io_memory_domain, bdev_io, internal.link);
+	bdev_io_increment_outstanding(ch, ch->shared_resource);
+	spdk_accel_sequence_finish(seq, cb_fn, bdev_io);
+
+	return 0;
+}
+
 static void
 bdev_io_pull_data(struct spdk_bdev_io *bdev_io)
 {
@@ -1317,6 +1650,15 @@ bdev_io_pull_data(struct spdk_bdev_io *bdev_io)
 			}
 		} else {
 			assert(bdev_io->u.bdev.iovcnt == 1);
+			if (bdev_io_accel_copy(bdev_io, bdev_io->u.bdev.iovs, 1,
+					       bdev_io->internal.orig_iovs,
+					       bdev_io->internal.orig_iovcnt,
+					       bdev_io->u.bdev.iovs[0].iov_len,
+					       bdev_io_pull_data_done_and_track) == 0) {
+				/* Continue to submit IO in completion callback */
+				return;
+			}
+			/* Copy on the CPU if the operation couldn't be offloaded */
 			spdk_copy_iovs_to_buf(bdev_io->u.bdev.iovs[0].iov_base,
 					      bdev_io->u.bdev.iovs[0].iov_len,
 					      bdev_io->internal.orig_iovs,
@@ -1426,8 +1768,7 @@ spdk_bdev_io_put_aux_buf(struct spdk_bdev_io *bdev_io, void *buf)
 }
 
 static inline void
-bdev_submit_request(struct spdk_bdev *bdev, struct spdk_io_channel *ioch,
-		    struct spdk_bdev_io *bdev_io)
+bdev_io_release_accel_sequence(struct spdk_bdev_io *bdev_io)
 {
 	/* After a request is submitted to a bdev module, the ownership of an accel sequence
 	 * associated with that bdev_io is transferred to the bdev module. So, clear the internal
@@ -1437,10 +1778,55 @@ bdev_submit_request(struct spdk_bdev *bdev, struct spdk_io_channel *ioch,
 		assert(!bdev_io_needs_sequence_exec(bdev_io->internal.desc, bdev_io));
 		bdev_io->internal.accel_sequence = NULL;
 	}
+}
 
+static inline void
+bdev_submit_request(struct spdk_bdev *bdev, struct spdk_io_channel *ioch,
+		    struct spdk_bdev_io *bdev_io)
+{
+	bdev_io_release_accel_sequence(bdev_io);
 	bdev->fn_table->submit_request(ioch, bdev_io);
 }
 
+static void
+bdev_submit_batch_flush(struct spdk_bdev_channel *bdev_ch)
+{
+	struct bdev_submit_batch *batch = &bdev_ch->submit_batch;
+	struct spdk_bdev_io *bdev_ios[BDEV_SUBMIT_BATCH_SIZE];
+	uint32_t i, count = batch->count;
+
+	if (count == 0) {
+		return;
+	}
+
+	memcpy(bdev_ios, batch->ios, count * sizeof(bdev_ios[0]));
+	batch->count = 0;
+
+	for (i = 0; i < count; i++) {
+		bdev_io_release_accel_sequence(bdev_ios[i]);
+		bdev_ios[i]->internal.in_submit_request = true;
+	}
+
+	bdev_ch->bdev->fn_table->submit_request_batch(bdev_ch->channel, bdev_ios, count);
+
+	/* Completions are deferred while in_submit_request is set, so the bdev_ios are
+	 * still valid here. */
+	for (i = 0; i < count; i++) {
+		bdev_ios[i]->internal.in_submit_request = false;
+	}
+}
+
+static void
+bdev_submit_batch_add(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_io)
+{
+	struct bdev_submit_batch *batch = &bdev_ch->submit_batch;
+
+	batch->ios[batch->count++] = bdev_io;
+	if (batch->count == BDEV_SUBMIT_BATCH_SIZE) {
+		bdev_submit_batch_flush(bdev_ch);
+	}
+}
+
 static inline void
 bdev_ch_resubmit_io(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_io)
 {
@@ -1686,6 +2072,14 @@ bdev_io_push_bounce_data(struct spdk_bdev_io *bdev_io)
 						    bdev_io->internal.memory_domain));
 			}
 		} else {
+			if (bdev_io_accel_copy(bdev_io, bdev_io->internal.orig_iovs,
+					       bdev_io->internal.orig_iovcnt,
+					       &bdev_io->internal.bounce_iov, 1,
+					       bdev_io->internal.bounce_iov.iov_len,
+					       bdev_io_push_bounce_data_done_and_track) == 0) {
+				/* Continue IO completion in async callback */
+				return;
+			}
 			spdk_copy_buf_to_iovs(bdev_io->internal.orig_iovs,
 					      bdev_io->internal.orig_iovcnt,
 					      bdev_io->internal.bounce_iov.iov_base,
@@ -1846,6 +2240,49 @@ bdev_qos_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
 			spdk_json_write_named_uint64(w, qos_rpc_type[i], limits[i]);
 		}
 	}
+	if (bdev->internal.qos_sharded) {
+		spdk_json_write_named_bool(w, "sharded", true);
+	}
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+}
+
+static void
+bdev_latency_qos_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+{
+	struct spdk_bdev_latency_qos *latency_qos = bdev->internal.latency_qos;
+
+	if (!latency_qos) {
+		return;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "bdev_set_qos_latency_target");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "name", bdev->name);
+	spdk_json_write_named_string(w, "group", latency_qos->group->name);
+	spdk_json_write_named_uint64(w, "latency_target_us", latency_qos->target_us);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+}
+
+static void
+bdev_coalesce_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+{
+	if (bdev->internal.coalesce_window_us == 0) {
+		return;
+	}
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "method", "bdev_set_io_coalescing");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_string(w, "name", bdev->name);
+	spdk_json_write_named_uint32(w, "window_us", bdev->internal.coalesce_window_us);
+	spdk_json_write_named_uint32(w, "max_blocks", bdev->internal.coalesce_max_blocks);
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
@@ -1867,6 +2304,8 @@ spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_named_uint32(w, "bdev_io_pool_size", g_bdev_opts.bdev_io_pool_size);
 	spdk_json_write_named_uint32(w, "bdev_io_cache_size", g_bdev_opts.bdev_io_cache_size);
 	spdk_json_write_named_bool(w, "bdev_auto_examine", g_bdev_opts.bdev_auto_examine);
+	spdk_json_write_named_uint32(w, "accel_copy_threshold", g_bdev_opts.accel_copy_threshold);
+	spdk_json_write_named_uint32(w, "examine_queue_depth", g_bdev_opts.examine_queue_depth);
 	spdk_json_write_object_end(w);
 	spdk_json_write_object_end(w);
 
@@ -1886,6 +2325,8 @@ spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 		}
 
 		bdev_qos_config_json(bdev, w);
+		bdev_latency_qos_config_json(bdev, w);
+		bdev_coalesce_config_json(bdev, w);
 	}
 
 	spdk_spin_unlock(&g_bdev_mgr.spinlock);
@@ -1899,28 +2340,187 @@ spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 }
 
 static void
-bdev_mgmt_channel_destroy(void *io_device, void *ctx_buf)
+bdev_metrics_add(uint64_t *total, uint64_t *prev, uint64_t cur)
 {
-	struct spdk_bdev_mgmt_channel *ch = ctx_buf;
-	struct spdk_bdev_io *bdev_io;
-
-	spdk_iobuf_channel_fini(&ch->iobuf);
+	/* The channel's stat might have been reset since the last update, in which case only
+	 * the current value is added, so that the metrics never go backwards. */
+	__atomic_fetch_add(total, cur >= *prev ? cur - *prev : cur, __ATOMIC_RELAXED);
+	*prev = cur;
+}
 
-	while (!STAILQ_EMPTY(&ch->per_thread_cache)) {
-		bdev_io = STAILQ_FIRST(&ch->per_thread_cache);
-		STAILQ_REMOVE_HEAD(&ch->per_thread_cache, internal.buf_link);
-		ch->per_thread_cache_count--;
-		spdk_mempool_put(g_bdev_mgr.bdev_io_pool, (void *)bdev_io);
-	}
+static void
+bdev_channel_update_metrics(struct spdk_bdev_channel *ch)
+{
+	struct spdk_bdev_io_stat *total = &ch->bdev->internal.metrics_stat;
+	struct spdk_bdev_io_stat *prev = &ch->metrics_prev;
+	struct spdk_bdev_io_stat *cur = ch->stat;
 
-	assert(ch->per_thread_cache_count == 0);
+	bdev_metrics_add(&total->bytes_read, &prev->bytes_read, cur->bytes_read);
+	bdev_metrics_add(&total->num_read_ops, &prev->num_read_ops, cur->num_read_ops);
+	bdev_metrics_add(&total->bytes_written, &prev->bytes_written, cur->bytes_written);
+	bdev_metrics_add(&total->num_write_ops, &prev->num_write_ops, cur->num_write_ops);
+	bdev_metrics_add(&total->bytes_unmapped, &prev->bytes_unmapped, cur->bytes_unmapped);
+	bdev_metrics_add(&total->num_unmap_ops, &prev->num_unmap_ops, cur->num_unmap_ops);
+	bdev_metrics_add(&total->read_latency_ticks, &prev->read_latency_ticks,
+			 cur->read_latency_ticks);
+	bdev_metrics_add(&total->write_latency_ticks, &prev->write_latency_ticks,
+			 cur->write_latency_ticks);
+	bdev_metrics_add(&total->unmap_latency_ticks, &prev->unmap_latency_ticks,
+			 cur->unmap_latency_ticks);
 }
 
 static int
-bdev_mgmt_channel_create(void *io_device, void *ctx_buf)
+bdev_mgmt_channel_update_metrics(void *ctx)
 {
-	struct spdk_bdev_mgmt_channel *ch = ctx_buf;
-	struct spdk_bdev_io *bdev_io;
+	struct spdk_bdev_mgmt_channel *ch = ctx;
+	struct spdk_bdev_channel *bdev_ch;
+
+	if (TAILQ_EMPTY(&ch->channels)) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	TAILQ_FOREACH(bdev_ch, &ch->channels, metrics_link) {
+		bdev_channel_update_metrics(bdev_ch);
+	}
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+bdev_mgmt_channel_toggle_metrics(struct spdk_bdev_mgmt_channel *ch)
+{
+	if (!g_bdev_metrics_enabled) {
+		spdk_poller_unregister(&ch->metrics_poller);
+	} else if (ch->metrics_poller == NULL) {
+		ch->metrics_poller = SPDK_POLLER_REGISTER(bdev_mgmt_channel_update_metrics, ch,
+				     BDEV_METRICS_UPDATE_PERIOD);
+	}
+}
+
+static void
+bdev_toggle_metrics_msg(struct spdk_io_channel_iter *i)
+{
+	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i);
+
+	bdev_mgmt_channel_toggle_metrics(__io_ch_to_bdev_mgmt_ch(_ch));
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+bdev_toggle_metrics(bool enable)
+{
+	g_bdev_metrics_enabled = enable;
+
+	/* Channels created later check g_bdev_metrics_enabled themselves */
+	if (g_bdev_mgr.module_init_complete) {
+		spdk_for_each_channel(&g_bdev_mgr, bdev_toggle_metrics_msg, NULL, NULL);
+	}
+}
+
+static void
+bdev_metrics_start(void)
+{
+	bdev_toggle_metrics(true);
+}
+
+static void
+bdev_metrics_stop(void)
+{
+	bdev_toggle_metrics(false);
+}
+
+static void
+bdev_metrics_write(struct spdk_metrics_writer *w, const char *name, const char *help,
+		   size_t offset)
+{
+	struct spdk_bdev *bdev;
+	uint64_t *value;
+
+	spdk_metrics_write_family(w, name, SPDK_METRICS_COUNTER, help);
+	TAILQ_FOREACH(bdev, &g_bdev_metrics_list, internal.metrics_link) {
+		value = (uint64_t *)((char *)&bdev->internal.metrics_stat + offset);
+		spdk_metrics_write_value(w, "bdev", bdev->name,
+					 __atomic_load_n(value, __ATOMIC_RELAXED));
+	}
+}
+
+static void
+bdev_metrics_collect(struct spdk_metrics_writer *w)
+{
+	pthread_mutex_lock(&g_bdev_metrics_mutex);
+	bdev_metrics_write(w, "bdev_read_bytes", "Bytes read",
+			   offsetof(struct spdk_bdev_io_stat, bytes_read));
+	bdev_metrics_write(w, "bdev_read_ops", "Read operations completed",
+			   offsetof(struct spdk_bdev_io_stat, num_read_ops));
+	bdev_metrics_write(w, "bdev_read_latency_ticks", "Ticks spent processing reads",
+			   offsetof(struct spdk_bdev_io_stat, read_latency_ticks));
+	bdev_metrics_write(w, "bdev_write_bytes", "Bytes written",
+			   offsetof(struct spdk_bdev_io_stat, bytes_written));
+	bdev_metrics_write(w, "bdev_write_ops", "Write operations completed",
+			   offsetof(struct spdk_bdev_io_stat, num_write_ops));
+	bdev_metrics_write(w, "bdev_write_latency_ticks", "Ticks spent processing writes",
+			   offsetof(struct spdk_bdev_io_stat, write_latency_ticks));
+	bdev_metrics_write(w, "bdev_unmap_bytes", "Bytes unmapped",
+			   offsetof(struct spdk_bdev_io_stat, bytes_unmapped));
+	bdev_metrics_write(w, "bdev_unmap_ops", "Unmap operations completed",
+			   offsetof(struct spdk_bdev_io_stat, num_unmap_ops));
+	bdev_metrics_write(w, "bdev_unmap_latency_ticks", "Ticks spent processing unmaps",
+			   offsetof(struct spdk_bdev_io_stat, unmap_latency_ticks));
+	pthread_mutex_unlock(&g_bdev_metrics_mutex);
+}
+SPDK_METRICS_SOURCE_REGISTER_EXT("bdev", bdev_metrics_collect, bdev_metrics_start,
+				 bdev_metrics_stop)
+
+static void
+bdev_mgmt_channel_destroy(void *io_device, void *ctx_buf)
+{
+	struct spdk_bdev_mgmt_channel *ch = ctx_buf;
+	struct spdk_bdev_io *bdev_io;
+
+	assert(TAILQ_EMPTY(&ch->channels));
+	spdk_poller_unregister(&ch->metrics_poller);
+	spdk_iobuf_channel_fini(&ch->iobuf);
+
+	while (!STAILQ_EMPTY(&ch->per_thread_cache)) {
+		bdev_io = STAILQ_FIRST(&ch->per_thread_cache);
+		STAILQ_REMOVE_HEAD(&ch->per_thread_cache, internal.buf_link);
+		ch->per_thread_cache_count--;
+		spdk_mempool_put(g_bdev_mgr.bdev_io_pool, (void *)bdev_io);
+	}
+
+	assert(ch->per_thread_cache_count == 0);
+}
+
+static void
+bdev_mgmt_channel_migrate(void *io_device, void *ctx_buf)
+{
+	struct spdk_bdev_mgmt_channel *ch = ctx_buf;
+	struct spdk_bdev_io *bdev_io, *old;
+	uint32_t i;
+
+	spdk_iobuf_channel_migrate(&ch->iobuf);
+
+	/* Exchange the cached bdev_ios for ones taken from the new core, same as the iobuf
+	 * cache.  Each new bdev_io is taken before an old one is released, so that the cache
+	 * never shrinks and the old ones don't come right back. */
+	for (i = 0; i < ch->per_thread_cache_count; i++) {
+		bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool);
+		if (bdev_io == NULL) {
+			break;
+		}
+
+		old = STAILQ_FIRST(&ch->per_thread_cache);
+		STAILQ_REMOVE_HEAD(&ch->per_thread_cache, internal.buf_link);
+		spdk_mempool_put(g_bdev_mgr.bdev_io_pool, (void *)old);
+		STAILQ_INSERT_TAIL(&ch->per_thread_cache, bdev_io, internal.buf_link);
+	}
+}
+
+static int
+bdev_mgmt_channel_create(void *io_device, void *ctx_buf)
+{
+	struct spdk_bdev_mgmt_channel *ch = ctx_buf;
+	struct spdk_bdev_io *bdev_io;
 	uint32_t i;
 	int rc;
 
@@ -1947,8 +2547,11 @@ bdev_mgmt_channel_create(void *io_device, void *ctx_buf)
 		STAILQ_INSERT_HEAD(&ch->per_thread_cache, bdev_io, internal.buf_link);
 	}
 
-	TAILQ_INIT(&ch->shared_resources);
+	RB_INIT(&ch->shared_resources);
 	TAILQ_INIT(&ch->io_wait_queue);
+	TAILQ_INIT(&ch->channels);
+
+	bdev_mgmt_channel_toggle_metrics(ch);
 
 	return 0;
 }
@@ -1989,7 +2592,8 @@ bdev_module_all_actions_completed(void)
 			return false;
 		}
 	}
-	return true;
+
+	return g_bdev_mgr.examine_pending_count == 0;
 }
 
 static void
@@ -2041,6 +2645,17 @@ spdk_bdev_module_init_done(struct spdk_bdev_module *module)
 void
 spdk_bdev_module_examine_done(struct spdk_bdev_module *module)
 {
+	struct spdk_thread *app_thread = spdk_thread_get_app_thread();
+
+	/* examine_config completes synchronously, anything else ends an examine_disk */
+	if (module != g_examine_config_module || spdk_get_thread() != app_thread) {
+		if (spdk_get_thread() == app_thread) {
+			bdev_examine_disk_done(NULL);
+		} else {
+			spdk_thread_send_msg(app_thread, bdev_examine_disk_done, NULL);
+		}
+	}
+
 	bdev_module_action_done(module);
 }
 
@@ -2141,6 +2756,7 @@ spdk_bdev_initialize(spdk_bdev_init_cb cb_fn, void *cb_arg)
 				bdev_mgmt_channel_destroy,
 				sizeof(struct spdk_bdev_mgmt_channel),
 				"bdev_mgr");
+	spdk_io_device_set_migrate_cb(&g_bdev_mgr, bdev_mgmt_channel_migrate);
 
 	rc = bdev_modules_init();
 	g_bdev_mgr.module_init_complete = true;
@@ -2627,6 +3243,25 @@ _bdev_io_complete_in_submit(struct spdk_bdev_channel *bdev_ch,
 	bdev_io->internal.in_submit_request = false;
 }
 
+static inline bool
+bdev_latency_qos_queue_io(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_io)
+{
+	struct bdev_latency_qos_channel *lat = &bdev_ch->latency_qos;
+
+	if (lat->target_ticks != 0 || bdev_qos_io_to_limit(bdev_io) == false) {
+		return false;
+	}
+
+	if (lat->max_outstanding != 0 && bdev_ch->io_outstanding >= lat->max_outstanding) {
+		TAILQ_INSERT_TAIL(&lat->queued, bdev_io, internal.link);
+		return true;
+	}
+
+	lat->peak_outstanding = spdk_max(lat->peak_outstanding, bdev_ch->io_outstanding + 1);
+
+	return false;
+}
+
 static inline void
 bdev_io_do_submit(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_io)
 {
@@ -2639,6 +3274,7 @@ bdev_io_do_submit(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_i
 		struct spdk_bdev_io *bio_to_abort = bdev_io->u.abort.bio_to_abort;
 
 		if (bdev_abort_queued_io(&shared_resource->nomem_io, bio_to_abort) ||
+		    bdev_abort_queued_io(&bdev_ch->latency_qos.queued, bio_to_abort) ||
 		    bdev_abort_buf_io(mgmt_channel, bio_to_abort)) {
 			_bdev_io_complete_in_submit(bdev_ch, bdev_io,
 						    SPDK_BDEV_IO_STATUS_SUCCESS);
@@ -2655,9 +3291,18 @@ bdev_io_do_submit(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_i
 		return;
 	}
 
+	if (spdk_unlikely(bdev_ch->latency_qos.group != NULL) &&
+	    bdev_latency_qos_queue_io(bdev_ch, bdev_io)) {
+		return;
+	}
+
 	if (spdk_likely(TAILQ_EMPTY(&shared_resource->nomem_io))) {
 		bdev_ch->io_outstanding++;
 		shared_resource->io_outstanding++;
+		if (spdk_unlikely(bdev_ch->submit_batch.active)) {
+			bdev_submit_batch_add(bdev_ch, bdev_io);
+			return;
+		}
 		bdev_io->internal.in_submit_request = true;
 		bdev_submit_request(bdev, ch, bdev_io);
 		bdev_io->internal.in_submit_request = false;
@@ -2731,162 +3376,437 @@ bdev_qos_io_submit(struct spdk_bdev_channel *ch, struct spdk_bdev_qos *qos)
 }
 
 static void
-bdev_queue_io_wait_with_cb(struct spdk_bdev_io *bdev_io, spdk_bdev_io_wait_cb cb_fn)
+bdev_qos_shard_sync(struct bdev_qos_shard *shard, struct spdk_bdev_qos *qos)
 {
-	int rc;
+	struct spdk_bdev_qos_limit *limit;
+	uint64_t gen;
+	int i;
 
-	bdev_io->internal.waitq_entry.bdev = bdev_io->bdev;
-	bdev_io->internal.waitq_entry.cb_fn = cb_fn;
-	bdev_io->internal.waitq_entry.cb_arg = bdev_io;
-	rc = spdk_bdev_queue_io_wait(bdev_io->bdev, spdk_io_channel_from_ctx(bdev_io->internal.ch),
-				     &bdev_io->internal.waitq_entry);
-	if (rc != 0) {
-		SPDK_ERRLOG("Queue IO failed, rc=%d\n", rc);
-		bdev_io->internal.status = SPDK_BDEV_IO_STATUS_FAILED;
-		bdev_io->internal.cb(bdev_io, false, bdev_io->internal.caller_ctx);
+	gen = __atomic_load_n(&qos->timeslice_gen, __ATOMIC_ACQUIRE);
+	if (spdk_likely(shard->timeslice_gen == gen)) {
+		return;
+	}
+
+	shard->timeslice_gen = gen;
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limit = &shard->rate_limits[i];
+		limit->max_per_timeslice = qos->rate_limits[i].max_per_timeslice;
+		limit->queue_io = qos->rate_limits[i].queue_io;
+		limit->update_quota = qos->rate_limits[i].update_quota;
+
+		/* The quota left from the last timeslice expires, but an overrun is carried
+		 * over, same as on the QoS thread.
+		 */
+		if (limit->remaining_this_timeslice > 0) {
+			limit->remaining_this_timeslice = 0;
+		}
 	}
 }
 
 static bool
-bdev_rw_should_split(struct spdk_bdev_io *bdev_io)
+bdev_qos_shard_borrow(struct spdk_bdev_qos_limit *pool, struct spdk_bdev_qos_limit *limit)
 {
-	uint32_t io_boundary;
-	struct spdk_bdev *bdev = bdev_io->bdev;
-	uint32_t max_size = bdev->max_segment_size;
-	int max_segs = bdev->max_num_segments;
+	int64_t avail, take, want;
 
-	if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE && bdev->split_on_write_unit) {
-		io_boundary = bdev->write_unit_size;
-	} else if (bdev->split_on_optimal_io_boundary) {
-		io_boundary = bdev->optimal_io_boundary;
-	} else {
-		io_boundary = 0;
-	}
+	/* Take a batch at once to keep the shared pool off the fast path, along with
+	 * whatever is needed to pay back an overrun.
+	 */
+	want = spdk_max(limit->max_per_timeslice >> BDEV_QOS_SHARD_BATCH_SHIFT, 1) -
+	       limit->remaining_this_timeslice;
 
-	if (spdk_likely(!io_boundary && !max_segs && !max_size)) {
-		return false;
-	}
+	avail = __atomic_load_n(&pool->remaining_this_timeslice, __ATOMIC_RELAXED);
+	do {
+		if (avail <= 0) {
+			return false;
+		}
+		take = spdk_min(avail, want);
+	} while (!__atomic_compare_exchange_n(&pool->remaining_this_timeslice, &avail, avail - take,
+					      false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
 
-	if (io_boundary) {
-		uint64_t start_stripe, end_stripe;
+	limit->remaining_this_timeslice += take;
 
-		start_stripe = bdev_io->u.bdev.offset_blocks;
-		end_stripe = start_stripe + bdev_io->u.bdev.num_blocks - 1;
-		/* Avoid expensive div operations if possible.  These spdk_u32 functions are very cheap. */
-		if (spdk_likely(spdk_u32_is_pow2(io_boundary))) {
-			start_stripe >>= spdk_u32log2(io_boundary);
-			end_stripe >>= spdk_u32log2(io_boundary);
-		} else {
-			start_stripe /= io_boundary;
-			end_stripe /= io_boundary;
-		}
+	return true;
+}
 
-		if (start_stripe != end_stripe) {
-			return true;
-		}
+static bool
+bdev_qos_shard_queue_io(struct bdev_qos_shard *shard, struct spdk_bdev_qos *qos,
+			struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev_qos_limit *limit;
+	int i;
+
+	if (bdev_qos_io_to_limit(bdev_io) == false) {
+		return false;
 	}
 
-	if (max_segs) {
-		if (bdev_io->u.bdev.iovcnt > max_segs) {
-			return true;
+	bdev_qos_shard_sync(shard, qos);
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limit = &shard->rate_limits[i];
+		if (!limit->queue_io) {
+			continue;
 		}
-	}
 
-	if (max_size) {
-		for (int i = 0; i < bdev_io->u.bdev.iovcnt; i++) {
-			if (bdev_io->u.bdev.iovs[i].iov_len > max_size) {
+		while (limit->queue_io(limit, bdev_io) == true) {
+			if (!bdev_qos_shard_borrow(&qos->rate_limits[i], limit)) {
 				return true;
 			}
 		}
 	}
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limit = &shard->rate_limits[i];
+		if (!limit->update_quota) {
+			continue;
+		}
+
+		limit->update_quota(limit, bdev_io);
+	}
 
 	return false;
 }
 
-static bool
-bdev_unmap_should_split(struct spdk_bdev_io *bdev_io)
+static int
+bdev_qos_shard_io_submit(struct spdk_bdev_channel *ch, struct spdk_bdev_qos *qos)
 {
-	uint32_t num_unmap_segments;
+	struct bdev_qos_shard		*shard = ch->qos_shard;
+	struct spdk_bdev_io		*bdev_io = NULL, *tmp = NULL;
+	int				submitted_ios = 0;
 
-	if (!bdev_io->bdev->max_unmap || !bdev_io->bdev->max_unmap_segments) {
-		return false;
-	}
-	num_unmap_segments = spdk_divide_round_up(bdev_io->u.bdev.num_blocks, bdev_io->bdev->max_unmap);
-	if (num_unmap_segments > bdev_io->bdev->max_unmap_segments) {
-		return true;
+	TAILQ_FOREACH_SAFE(bdev_io, &shard->queued, internal.link, tmp) {
+		if (!bdev_qos_shard_queue_io(shard, qos, bdev_io)) {
+			TAILQ_REMOVE(&shard->queued, bdev_io, internal.link);
+			bdev_io_do_submit(ch, bdev_io);
+			submitted_ios++;
+		}
 	}
 
-	return false;
+	return submitted_ios;
 }
 
-static bool
-bdev_write_zeroes_should_split(struct spdk_bdev_io *bdev_io)
+static int
+bdev_qos_shard_poll(void *arg)
 {
-	if (!bdev_io->bdev->max_write_zeroes) {
-		return false;
-	}
+	struct spdk_bdev_channel *ch = arg;
 
-	if (bdev_io->u.bdev.num_blocks > bdev_io->bdev->max_write_zeroes) {
-		return true;
+	if (TAILQ_EMPTY(&ch->qos_shard->queued)) {
+		return SPDK_POLLER_IDLE;
 	}
 
-	return false;
+	return bdev_qos_shard_io_submit(ch, ch->bdev->internal.qos) > 0 ?
+	       SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 }
 
-static bool
-bdev_copy_should_split(struct spdk_bdev_io *bdev_io)
+static int
+bdev_qos_shard_create(struct spdk_bdev_channel *ch, struct spdk_bdev_qos *qos)
 {
-	if (bdev_io->bdev->max_copy != 0 &&
-	    bdev_io->u.bdev.num_blocks > bdev_io->bdev->max_copy) {
-		return true;
+	struct bdev_qos_shard *shard;
+
+	shard = calloc(1, sizeof(*shard));
+	if (shard == NULL) {
+		SPDK_ERRLOG("Unable to allocate memory for QoS shard\n");
+		return -ENOMEM;
 	}
 
-	return false;
-}
+	TAILQ_INIT(&shard->queued);
+	/* Pick up the limits on the first I/O. */
+	shard->timeslice_gen = qos->timeslice_gen - 1;
+	shard->poller = SPDK_POLLER_REGISTER(bdev_qos_shard_poll, ch,
+					     SPDK_BDEV_QOS_TIMESLICE_IN_USEC);
+	ch->qos_shard = shard;
 
-static bool
-bdev_io_should_split(struct spdk_bdev_io *bdev_io)
-{
-	switch (bdev_io->type) {
-	case SPDK_BDEV_IO_TYPE_READ:
-	case SPDK_BDEV_IO_TYPE_WRITE:
-		return bdev_rw_should_split(bdev_io);
-	case SPDK_BDEV_IO_TYPE_UNMAP:
-		return bdev_unmap_should_split(bdev_io);
-	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
-		return bdev_write_zeroes_should_split(bdev_io);
-	case SPDK_BDEV_IO_TYPE_COPY:
-		return bdev_copy_should_split(bdev_io);
-	default:
-		return false;
-	}
+	return 0;
 }
 
-static uint32_t
-_to_next_boundary(uint64_t offset, uint32_t boundary)
+static void
+bdev_qos_shard_destroy(struct spdk_bdev_channel *ch)
 {
-	return (boundary - (offset % boundary));
-}
-
-static void bdev_io_split_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg);
-
-static void _bdev_rw_split(void *_bdev_io);
+	struct bdev_qos_shard *shard = ch->qos_shard;
 
-static void bdev_unmap_split(struct spdk_bdev_io *bdev_io);
+	assert(TAILQ_EMPTY(&shard->queued));
+	spdk_poller_unregister(&shard->poller);
+	free(shard);
+	ch->qos_shard = NULL;
+}
 
 static void
-_bdev_unmap_split(void *_bdev_io)
+bdev_latency_qos_dispatch(struct spdk_bdev_channel *bdev_ch)
 {
-	return bdev_unmap_split((struct spdk_bdev_io *)_bdev_io);
-}
+	struct bdev_latency_qos_channel *lat = &bdev_ch->latency_qos;
+	struct spdk_bdev_io *bdev_io;
 
-static void bdev_write_zeroes_split(struct spdk_bdev_io *bdev_io);
+	while (!TAILQ_EMPTY(&lat->queued) &&
+	       (lat->max_outstanding == 0 || bdev_ch->io_outstanding < lat->max_outstanding)) {
+		bdev_io = TAILQ_FIRST(&lat->queued);
+		TAILQ_REMOVE(&lat->queued, bdev_io, internal.link);
+		bdev_io_do_submit(bdev_ch, bdev_io);
+	}
+}
 
 static void
-_bdev_write_zeroes_split(void *_bdev_io)
+bdev_latency_qos_complete(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_io,
+			  uint64_t tsc_diff)
 {
-	return bdev_write_zeroes_split((struct spdk_bdev_io *)_bdev_io);
-}
+	struct bdev_latency_qos_channel *lat = &bdev_ch->latency_qos;
+
+	if (lat->target_ticks == 0) {
+		bdev_latency_qos_dispatch(bdev_ch);
+		return;
+	}
+
+	if (bdev_qos_io_to_limit(bdev_io) == true) {
+		lat->completed++;
+		if (tsc_diff > lat->target_ticks) {
+			lat->over_target++;
+		}
+	}
+}
+
+static int
+bdev_latency_qos_poll(void *arg)
+{
+	struct spdk_bdev_channel *bdev_ch = arg;
+	struct bdev_latency_qos_channel *lat = &bdev_ch->latency_qos;
+	uint64_t violations;
+	int rc = SPDK_POLLER_IDLE;
+
+	if (lat->target_ticks != 0) {
+		/* The p99 latency is over the target if more than 1% of the I/O missed it. */
+		if (lat->over_target * 100 > lat->completed) {
+			__atomic_fetch_add(&lat->group->violations, 1, __ATOMIC_RELAXED);
+			rc = SPDK_POLLER_BUSY;
+		}
+		lat->completed = 0;
+		lat->over_target = 0;
+
+		return rc;
+	}
+
+	violations = __atomic_load_n(&lat->group->violations, __ATOMIC_RELAXED);
+	if (violations != lat->violations) {
+		/* Another bdev of the group missed its target, back off. */
+		lat->violations = violations;
+		if (lat->max_outstanding == 0) {
+			lat->max_outstanding = lat->peak_outstanding;
+		}
+		if (lat->max_outstanding != 0) {
+			lat->max_outstanding = spdk_max(lat->max_outstanding / 2, 1);
+			rc = SPDK_POLLER_BUSY;
+		}
+	} else if (lat->max_outstanding != 0) {
+		if (TAILQ_EMPTY(&lat->queued) && lat->peak_outstanding < lat->max_outstanding) {
+			/* Not limited during the whole window, stop throttling. */
+			lat->max_outstanding = 0;
+		} else {
+			lat->max_outstanding += spdk_max(lat->max_outstanding / 4, 1);
+		}
+		rc = SPDK_POLLER_BUSY;
+	}
+
+	lat->peak_outstanding = bdev_ch->io_outstanding;
+	bdev_latency_qos_dispatch(bdev_ch);
+
+	return rc;
+}
+
+static void
+bdev_latency_qos_channel_init(struct spdk_bdev_channel *bdev_ch,
+			      struct spdk_bdev_latency_qos *latency_qos)
+{
+	struct bdev_latency_qos_channel *lat = &bdev_ch->latency_qos;
+
+	assert(lat->group == NULL);
+	if (latency_qos == NULL) {
+		return;
+	}
+
+	lat->group = latency_qos->group;
+	lat->target_ticks = latency_qos->target_us * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+	lat->completed = 0;
+	lat->over_target = 0;
+	lat->violations = __atomic_load_n(&lat->group->violations, __ATOMIC_RELAXED);
+	lat->max_outstanding = 0;
+	lat->peak_outstanding = bdev_ch->io_outstanding;
+	lat->poller = SPDK_POLLER_REGISTER(bdev_latency_qos_poll, bdev_ch,
+					   BDEV_LATENCY_QOS_WINDOW_IN_USEC);
+}
+
+static void
+bdev_latency_qos_channel_fini(struct spdk_bdev_channel *bdev_ch)
+{
+	struct bdev_latency_qos_channel *lat = &bdev_ch->latency_qos;
+
+	assert(TAILQ_EMPTY(&lat->queued));
+	spdk_poller_unregister(&lat->poller);
+	lat->group = NULL;
+	lat->target_ticks = 0;
+}
+
+static void
+bdev_queue_io_wait_with_cb(struct spdk_bdev_io *bdev_io, spdk_bdev_io_wait_cb cb_fn)
+{
+	int rc;
+
+	bdev_io->internal.waitq_entry.bdev = bdev_io->bdev;
+	bdev_io->internal.waitq_entry.cb_fn = cb_fn;
+	bdev_io->internal.waitq_entry.cb_arg = bdev_io;
+	rc = spdk_bdev_queue_io_wait(bdev_io->bdev, spdk_io_channel_from_ctx(bdev_io->internal.ch),
+				     &bdev_io->internal.waitq_entry);
+	if (rc != 0) {
+		SPDK_ERRLOG("Queue IO failed, rc=%d\n", rc);
+		bdev_io->internal.status = SPDK_BDEV_IO_STATUS_FAILED;
+		bdev_io->internal.cb(bdev_io, false, bdev_io->internal.caller_ctx);
+	}
+}
+
+static uint32_t
+bdev_rw_io_boundary(struct spdk_bdev *bdev, enum spdk_bdev_io_type type)
+{
+	if (type == SPDK_BDEV_IO_TYPE_WRITE && bdev->split_on_write_unit) {
+		return bdev->write_unit_size;
+	} else if (bdev->split_on_optimal_io_boundary) {
+		return bdev->optimal_io_boundary;
+	} else {
+		return 0;
+	}
+}
+
+static bool
+bdev_rw_should_split(struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev *bdev = bdev_io->bdev;
+	uint32_t io_boundary = bdev_rw_io_boundary(bdev, bdev_io->type);
+	uint32_t max_size = bdev->max_segment_size;
+	int max_segs = bdev->max_num_segments;
+
+	if (spdk_likely(!io_boundary && !max_segs && !max_size)) {
+		return false;
+	}
+
+	if (io_boundary) {
+		uint64_t start_stripe, end_stripe;
+
+		start_stripe = bdev_io->u.bdev.offset_blocks;
+		end_stripe = start_stripe + bdev_io->u.bdev.num_blocks - 1;
+		/* Avoid expensive div operations if possible.  These spdk_u32 functions are very cheap. */
+		if (spdk_likely(spdk_u32_is_pow2(io_boundary))) {
+			start_stripe >>= spdk_u32log2(io_boundary);
+			end_stripe >>= spdk_u32log2(io_boundary);
+		} else {
+			start_stripe /= io_boundary;
+			end_stripe /= io_boundary;
+		}
+
+		if (start_stripe != end_stripe) {
+			return true;
+		}
+	}
+
+	if (max_segs) {
+		if (bdev_io->u.bdev.iovcnt > max_segs) {
+			return true;
+		}
+	}
+
+	if (max_size) {
+		for (int i = 0; i < bdev_io->u.bdev.iovcnt; i++) {
+			if (bdev_io->u.bdev.iovs[i].iov_len > max_size) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static bool
+bdev_unmap_should_split(struct spdk_bdev_io *bdev_io)
+{
+	uint32_t num_unmap_segments;
+
+	if (!bdev_io->bdev->max_unmap || !bdev_io->bdev->max_unmap_segments) {
+		return false;
+	}
+	num_unmap_segments = spdk_divide_round_up(bdev_io->u.bdev.num_blocks, bdev_io->bdev->max_unmap);
+	if (num_unmap_segments > bdev_io->bdev->max_unmap_segments) {
+		return true;
+	}
+
+	return false;
+}
+
+static bool
+bdev_write_zeroes_should_split(struct spdk_bdev_io *bdev_io)
+{
+	if (!bdev_io->bdev->max_write_zeroes) {
+		return false;
+	}
+
+	if (bdev_io->u.bdev.num_blocks > bdev_io->bdev->max_write_zeroes) {
+		return true;
+	}
+
+	return false;
+}
+
+static bool
+bdev_copy_should_split(struct spdk_bdev_io *bdev_io)
+{
+	if (bdev_io->bdev->max_copy != 0 &&
+	    bdev_io->u.bdev.num_blocks > bdev_io->bdev->max_copy) {
+		return true;
+	}
+
+	return false;
+}
+
+static void bdev_io_split_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg);
+
+static bool
+bdev_io_should_split(struct spdk_bdev_io *bdev_io)
+{
+	/* The children are built within the limits of the bdev already */
+	if (bdev_io->internal.cb == bdev_io_split_done) {
+		return false;
+	}
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		return bdev_rw_should_split(bdev_io);
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+		return bdev_unmap_should_split(bdev_io);
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+		return bdev_write_zeroes_should_split(bdev_io);
+	case SPDK_BDEV_IO_TYPE_COPY:
+		return bdev_copy_should_split(bdev_io);
+	default:
+		return false;
+	}
+}
+
+static uint32_t
+_to_next_boundary(uint64_t offset, uint32_t boundary)
+{
+	return (boundary - (offset % boundary));
+}
+
+static void _bdev_rw_split(void *_bdev_io);
+
+static void bdev_unmap_split(struct spdk_bdev_io *bdev_io);
+
+static void
+_bdev_unmap_split(void *_bdev_io)
+{
+	return bdev_unmap_split((struct spdk_bdev_io *)_bdev_io);
+}
+
+static void bdev_write_zeroes_split(struct spdk_bdev_io *bdev_io);
+
+static void
+_bdev_write_zeroes_split(void *_bdev_io)
+{
+	return bdev_write_zeroes_split((struct spdk_bdev_io *)_bdev_io);
+}
 
 static void bdev_copy_split(struct spdk_bdev_io *bdev_io);
 
@@ -3017,16 +3937,13 @@ _bdev_rw_split(void *_bdev_io)
 	remaining = bdev_io->u.bdev.split_remaining_num_blocks;
 	current_offset = bdev_io->u.bdev.split_current_offset_blocks;
 	parent_offset = bdev_io->u.bdev.offset_blocks;
-	parent_iov_offset = (current_offset - parent_offset) * blocklen;
 	parent_iovcnt = bdev_io->u.bdev.iovcnt;
 
-	for (parent_iovpos = 0; parent_iovpos < parent_iovcnt; parent_iovpos++) {
-		parent_iov = &bdev_io->u.bdev.iovs[parent_iovpos];
-		if (parent_iov_offset < parent_iov->iov_len) {
-			break;
-		}
-		parent_iov_offset -= parent_iov->iov_len;
-	}
+	/* Resume where the previous round of children stopped instead of walking the
+	 * parent iovs from the start.
+	 */
+	parent_iovpos = bdev_io->u.bdev.split_iov_idx;
+	parent_iov_offset = bdev_io->u.bdev.split_iov_offset;
 
 	child_iovcnt = 0;
 	while (remaining > 0 && parent_iovpos < parent_iovcnt &&
@@ -3126,6 +4043,9 @@ _bdev_rw_split(void *_bdev_io)
 		if (spdk_unlikely(rc)) {
 			return;
 		}
+
+		bdev_io->u.bdev.split_iov_idx = parent_iovpos;
+		bdev_io->u.bdev.split_iov_offset = parent_iov_offset;
 	}
 }
 
@@ -3306,6 +4226,8 @@ bdev_io_split(struct spdk_bdev_io *bdev_io)
 	bdev_io->u.bdev.split_current_offset_blocks = bdev_io->u.bdev.offset_blocks;
 	bdev_io->u.bdev.split_remaining_num_blocks = bdev_io->u.bdev.num_blocks;
 	bdev_io->u.bdev.split_outstanding = 0;
+	bdev_io->u.bdev.split_iov_idx = 0;
+	bdev_io->u.bdev.split_iov_offset = 0;
 	bdev_io->internal.status = SPDK_BDEV_IO_STATUS_SUCCESS;
 
 	switch (bdev_io->type) {
@@ -3363,12 +4285,24 @@ _bdev_io_submit(void *ctx)
 	if (bdev_ch->flags & BDEV_CH_RESET_IN_PROGRESS) {
 		_bdev_io_complete_in_submit(bdev_ch, bdev_io, SPDK_BDEV_IO_STATUS_ABORTED);
 	} else if (bdev_ch->flags & BDEV_CH_QOS_ENABLED) {
+		bdev_io_tailq_t *queued;
+
+		if (bdev_ch->qos_shard != NULL) {
+			queued = &bdev_ch->qos_shard->queued;
+		} else {
+			queued = &bdev->internal.qos->queued;
+		}
+
 		if (spdk_unlikely(bdev_io->type == SPDK_BDEV_IO_TYPE_ABORT) &&
-		    bdev_abort_queued_io(&bdev->internal.qos->queued, bdev_io->u.abort.bio_to_abort)) {
+		    bdev_abort_queued_io(queued, bdev_io->u.abort.bio_to_abort)) {
 			_bdev_io_complete_in_submit(bdev_ch, bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
 		} else {
-			TAILQ_INSERT_TAIL(&bdev->internal.qos->queued, bdev_io, internal.link);
-			bdev_qos_io_submit(bdev_ch, bdev->internal.qos);
+			TAILQ_INSERT_TAIL(queued, bdev_io, internal.link);
+			if (bdev_ch->qos_shard != NULL) {
+				bdev_qos_shard_io_submit(bdev_ch, bdev->internal.qos);
+			} else {
+				bdev_qos_io_submit(bdev_ch, bdev->internal.qos);
+			}
 		}
 	} else {
 		SPDK_ERRLOG("unknown bdev_ch flag %x found\n", bdev_ch->flags);
@@ -3433,49 +4367,289 @@ bdev_io_range_is_locked(struct spdk_bdev_io *bdev_io, struct lba_range *range)
 	}
 }
 
-void
-bdev_io_submit(struct spdk_bdev_io *bdev_io)
+static void
+bdev_coalesce_put_batch(struct spdk_bdev_channel *ch, struct bdev_coalesce_batch *batch)
 {
-	struct spdk_bdev *bdev = bdev_io->bdev;
-	struct spdk_thread *thread = spdk_bdev_io_get_thread(bdev_io);
+	assert(TAILQ_EMPTY(&batch->ios));
+	STAILQ_INSERT_HEAD(&ch->coalesce.free_batches, batch, link);
+}
+
+static void
+bdev_coalesce_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct bdev_coalesce_batch *batch = cb_arg;
 	struct spdk_bdev_channel *ch = bdev_io->internal.ch;
+	struct spdk_bdev_io *orig_io;
+	bdev_io_tailq_t ios;
 
-	assert(thread != NULL);
-	assert(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
+	spdk_bdev_free_io(bdev_io);
 
-	if (!TAILQ_EMPTY(&ch->locked_ranges)) {
-		struct lba_range *range;
+	TAILQ_INIT(&ios);
+	TAILQ_SWAP(&batch->ios, &ios, spdk_bdev_io, internal.link);
+	bdev_coalesce_put_batch(ch, batch);
 
-		TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
-			if (bdev_io_range_is_locked(bdev_io, range)) {
-				TAILQ_INSERT_TAIL(&ch->io_locked, bdev_io, internal.ch_link);
-				return;
-			}
+	while (!TAILQ_EMPTY(&ios)) {
+		orig_io = TAILQ_FIRST(&ios);
+		TAILQ_REMOVE(&ios, orig_io, internal.link);
+
+		/* The status of the merged I/O doesn't tell which of the I/O failed, so submit
+		 * them again one by one to get a status of their own. */
+		if (spdk_unlikely(!success)) {
+			_bdev_io_submit(orig_io);
+			continue;
 		}
-	}
 
-	TAILQ_INSERT_TAIL(&ch->io_submitted, bdev_io, internal.ch_link);
+		/* Same as a split parent, the merged I/O was accounted for instead. */
+		spdk_trace_record(TRACE_BDEV_IO_DONE, 0, 0, (uintptr_t)orig_io,
+				  orig_io->internal.caller_ctx);
+		TAILQ_REMOVE(&ch->io_submitted, orig_io, internal.ch_link);
+		orig_io->internal.status = SPDK_BDEV_IO_STATUS_SUCCESS;
+		orig_io->internal.cb(orig_io, true, orig_io->internal.caller_ctx);
+	}
+}
 
-	bdev_io->internal.submit_tsc = spdk_get_ticks();
-	spdk_trace_record_tsc(bdev_io->internal.submit_tsc, TRACE_BDEV_IO_START, 0, 0,
-			      (uintptr_t)bdev_io, (uint64_t)bdev_io->type, bdev_io->internal.caller_ctx,
-			      bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks,
-			      spdk_bdev_get_name(bdev));
+static void
+bdev_coalesce_flush(struct spdk_bdev_channel *ch)
+{
+	struct bdev_coalesce_batch *batch = ch->coalesce.batch;
+	struct spdk_io_channel *io_ch = spdk_io_channel_from_ctx(ch);
+	struct spdk_bdev_io *bdev_io;
+	int rc;
 
-	if (bdev_io->internal.split) {
-		bdev_io_split(bdev_io);
+	if (batch == NULL) {
 		return;
 	}
 
-	if (ch->flags & BDEV_CH_QOS_ENABLED) {
-		if ((thread == bdev->internal.qos->thread) || !bdev->internal.qos->thread) {
-			_bdev_io_submit(bdev_io);
-		} else {
-			bdev_io->internal.io_submit_ch = ch;
-			bdev_io->internal.ch = bdev->internal.qos->ch;
-			spdk_thread_send_msg(bdev->internal.qos->thread, _bdev_io_submit, bdev_io);
-		}
-	} else {
+	ch->coalesce.batch = NULL;
+
+	bdev_io = TAILQ_FIRST(&batch->ios);
+	if (TAILQ_NEXT(bdev_io, internal.link) == NULL) {
+		/* Nothing to merge with */
+		TAILQ_REMOVE(&batch->ios, bdev_io, internal.link);
+		bdev_coalesce_put_batch(ch, batch);
+		_bdev_io_submit(bdev_io);
+		return;
+	}
+
+	if (batch->type == SPDK_BDEV_IO_TYPE_READ) {
+		rc = bdev_readv_blocks_with_md(batch->desc, io_ch, batch->iovs, batch->iovcnt,
+					       NULL, batch->offset_blocks, batch->num_blocks,
+					       NULL, NULL, NULL, bdev_coalesce_done, batch);
+	} else {
+		rc = bdev_writev_blocks_with_md(batch->desc, io_ch, batch->iovs, batch->iovcnt,
+						NULL, batch->offset_blocks, batch->num_blocks,
+						NULL, NULL, NULL, bdev_coalesce_done, batch);
+	}
+
+	if (spdk_unlikely(rc != 0)) {
+		/* Out of bdev_io, submit the I/O as they are. */
+		while (!TAILQ_EMPTY(&batch->ios)) {
+			bdev_io = TAILQ_FIRST(&batch->ios);
+			TAILQ_REMOVE(&batch->ios, bdev_io, internal.link);
+			_bdev_io_submit(bdev_io);
+		}
+		bdev_coalesce_put_batch(ch, batch);
+	}
+}
+
+static bool
+bdev_io_can_coalesce(struct spdk_bdev_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	if (bdev_io->type != SPDK_BDEV_IO_TYPE_READ && bdev_io->type != SPDK_BDEV_IO_TYPE_WRITE) {
+		return false;
+	}
+
+	/* Neither merge a merged I/O again nor the children of a split I/O, which are
+	 * already built within the limits of the bdev. */
+	return ch->flags == 0 && bdev_io->internal.cb != bdev_coalesce_done &&
+	       bdev_io->internal.cb != bdev_io_split_done &&
+	       bdev_io->u.bdev.md_buf == NULL && bdev_io->internal.memory_domain == NULL &&
+	       bdev_io->internal.accel_sequence == NULL && bdev_io->internal.orig_iovcnt == 0 &&
+	       bdev_io->u.bdev.iovs[0].iov_base != NULL &&
+	       bdev_io->u.bdev.iovcnt <= SPDK_BDEV_IO_NUM_CHILD_IOV &&
+	       bdev_io->u.bdev.num_blocks < ch->coalesce.max_blocks;
+}
+
+static bool
+bdev_coalesce_batch_fits(struct spdk_bdev_channel *ch, struct bdev_coalesce_batch *batch,
+			 struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev *bdev = bdev_io->bdev;
+	uint64_t num_blocks = batch->num_blocks + bdev_io->u.bdev.num_blocks;
+	int iovcnt = batch->iovcnt + bdev_io->u.bdev.iovcnt;
+	uint32_t io_boundary;
+
+	if (batch->desc != bdev_io->internal.desc || batch->type != bdev_io->type ||
+	    batch->offset_blocks + batch->num_blocks != bdev_io->u.bdev.offset_blocks ||
+	    num_blocks > ch->coalesce.max_blocks || iovcnt > SPDK_BDEV_IO_NUM_CHILD_IOV) {
+		return false;
+	}
+
+	/* Don't build an I/O that would be split again */
+	io_boundary = bdev_rw_io_boundary(bdev, bdev_io->type);
+	if (io_boundary != 0 && batch->offset_blocks / io_boundary !=
+	    (batch->offset_blocks + num_blocks - 1) / io_boundary) {
+		return false;
+	}
+
+	return bdev->max_num_segments == 0 || iovcnt <= (int)bdev->max_num_segments;
+}
+
+static void
+bdev_io_coalesce(struct spdk_bdev_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct bdev_coalesce_batch *batch = ch->coalesce.batch;
+
+	if (!bdev_io_can_coalesce(ch, bdev_io)) {
+		/* Keep the I/O in order */
+		bdev_coalesce_flush(ch);
+		_bdev_io_submit(bdev_io);
+		return;
+	}
+
+	if (batch != NULL && !bdev_coalesce_batch_fits(ch, batch, bdev_io)) {
+		bdev_coalesce_flush(ch);
+		batch = NULL;
+	}
+
+	if (batch == NULL) {
+		batch = STAILQ_FIRST(&ch->coalesce.free_batches);
+		if (batch != NULL) {
+			STAILQ_REMOVE_HEAD(&ch->coalesce.free_batches, link);
+		} else {
+			batch = calloc(1, sizeof(*batch));
+			if (batch == NULL) {
+				_bdev_io_submit(bdev_io);
+				return;
+			}
+		}
+
+		TAILQ_INIT(&batch->ios);
+		batch->desc = bdev_io->internal.desc;
+		batch->type = bdev_io->type;
+		batch->offset_blocks = bdev_io->u.bdev.offset_blocks;
+		batch->num_blocks = 0;
+		batch->iovcnt = 0;
+		ch->coalesce.batch = batch;
+	}
+
+	TAILQ_INSERT_TAIL(&batch->ios, bdev_io, internal.link);
+	memcpy(&batch->iovs[batch->iovcnt], bdev_io->u.bdev.iovs,
+	       bdev_io->u.bdev.iovcnt * sizeof(struct iovec));
+	batch->iovcnt += bdev_io->u.bdev.iovcnt;
+	batch->num_blocks += bdev_io->u.bdev.num_blocks;
+
+	if (batch->num_blocks >= ch->coalesce.max_blocks ||
+	    batch->iovcnt == SPDK_BDEV_IO_NUM_CHILD_IOV) {
+		bdev_coalesce_flush(ch);
+	}
+}
+
+static int
+bdev_coalesce_poll(void *arg)
+{
+	struct spdk_bdev_channel *ch = arg;
+
+	if (ch->coalesce.batch == NULL) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	bdev_coalesce_flush(ch);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+bdev_coalesce_channel_update(struct spdk_bdev_channel *ch, uint32_t window_us,
+			     uint32_t max_blocks)
+{
+	bdev_coalesce_flush(ch);
+	spdk_poller_unregister(&ch->coalesce.poller);
+
+	ch->coalesce.window_us = window_us;
+	ch->coalesce.max_blocks = max_blocks;
+	if (window_us != 0) {
+		ch->coalesce.poller = SPDK_POLLER_REGISTER(bdev_coalesce_poll, ch, window_us);
+	}
+}
+
+static void
+bdev_coalesce_abort(struct spdk_bdev_channel *ch)
+{
+	struct bdev_coalesce_batch *batch = ch->coalesce.batch;
+
+	if (batch == NULL) {
+		return;
+	}
+
+	ch->coalesce.batch = NULL;
+	bdev_abort_all_queued_io(&batch->ios, ch);
+	bdev_coalesce_put_batch(ch, batch);
+}
+
+static void
+bdev_coalesce_channel_fini(struct spdk_bdev_channel *ch)
+{
+	struct bdev_coalesce_batch *batch;
+
+	assert(ch->coalesce.batch == NULL);
+	spdk_poller_unregister(&ch->coalesce.poller);
+
+	while (!STAILQ_EMPTY(&ch->coalesce.free_batches)) {
+		batch = STAILQ_FIRST(&ch->coalesce.free_batches);
+		STAILQ_REMOVE_HEAD(&ch->coalesce.free_batches, link);
+		free(batch);
+	}
+}
+
+void
+bdev_io_submit(struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev *bdev = bdev_io->bdev;
+	struct spdk_thread *thread = spdk_bdev_io_get_thread(bdev_io);
+	struct spdk_bdev_channel *ch = bdev_io->internal.ch;
+
+	assert(thread != NULL);
+	assert(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
+
+	if (!TAILQ_EMPTY(&ch->locked_ranges)) {
+		struct lba_range *range;
+
+		TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
+			if (bdev_io_range_is_locked(bdev_io, range)) {
+				TAILQ_INSERT_TAIL(&ch->io_locked, bdev_io, internal.ch_link);
+				return;
+			}
+		}
+	}
+
+	TAILQ_INSERT_TAIL(&ch->io_submitted, bdev_io, internal.ch_link);
+
+	bdev_io->internal.submit_tsc = spdk_get_ticks();
+	spdk_trace_record_tsc(bdev_io->internal.submit_tsc, TRACE_BDEV_IO_START, 0, 0,
+			      (uintptr_t)bdev_io, (uint64_t)bdev_io->type, bdev_io->internal.caller_ctx,
+			      bdev_io->u.bdev.offset_blocks, bdev_io->u.bdev.num_blocks,
+			      spdk_bdev_get_name(bdev));
+
+	if (bdev_io->internal.split) {
+		bdev_io_split(bdev_io);
+		return;
+	}
+
+	if (ch->flags & BDEV_CH_QOS_ENABLED) {
+		/* A sharded channel enforces the limits itself, no need to go through the
+		 * QoS thread. */
+		if (ch->qos_shard != NULL || (thread == bdev->internal.qos->thread) ||
+		    !bdev->internal.qos->thread) {
+			_bdev_io_submit(bdev_io);
+		} else {
+			bdev_io->internal.io_submit_ch = ch;
+			bdev_io->internal.ch = bdev->internal.qos->ch;
+			spdk_thread_send_msg(bdev->internal.qos->thread, _bdev_io_submit, bdev_io);
+		}
+	} else if (spdk_unlikely(ch->coalesce.window_us != 0)) {
+		bdev_io_coalesce(ch, bdev_io);
+	} else {
 		_bdev_io_submit(bdev_io);
 	}
 }
@@ -3636,6 +4810,33 @@ bdev_qos_update_max_quota_per_timeslice(struct spdk_bdev_qos *qos)
 	}
 
 	bdev_qos_set_ops(qos);
+
+	/* Let the shards pick up the new limits. */
+	__atomic_fetch_add(&qos->timeslice_gen, 1, __ATOMIC_RELEASE);
+}
+
+static int
+bdev_qos_refill_pool(struct spdk_bdev_qos *qos, uint64_t now)
+{
+	uint64_t timeslices = 0;
+	int i;
+
+	while (now >= (qos->last_timeslice + qos->timeslice_size)) {
+		qos->last_timeslice += qos->timeslice_size;
+		timeslices++;
+	}
+
+	/* Any quota the channels haven't borrowed in the last timeslice expires. The
+	 * overruns are carried over by the channels themselves.
+	 */
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		__atomic_store_n(&qos->rate_limits[i].remaining_this_timeslice,
+				 (int64_t)(qos->rate_limits[i].max_per_timeslice * timeslices),
+				 __ATOMIC_RELAXED);
+	}
+	__atomic_fetch_add(&qos->timeslice_gen, 1, __ATOMIC_RELEASE);
+
+	return SPDK_POLLER_BUSY;
 }
 
 static int
@@ -3654,6 +4855,10 @@ bdev_channel_poll_qos(void *arg)
 		return SPDK_POLLER_IDLE;
 	}
 
+	if (qos->sharded) {
+		return bdev_qos_refill_pool(qos, now);
+	}
+
 	/* Reset for next round of rate limiting */
 	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
 		/* We may have allowed the IOs or bytes to slightly overrun in the last
@@ -3694,6 +4899,16 @@ bdev_channel_destroy_resource(struct spdk_bdev_channel *ch)
 		free(range);
 	}
 
+	if (ch->qos_shard != NULL) {
+		bdev_qos_shard_destroy(ch);
+	}
+
+	if (ch->latency_qos.group != NULL) {
+		bdev_latency_qos_channel_fini(ch);
+	}
+
+	bdev_coalesce_channel_fini(ch);
+
 	spdk_put_io_channel(ch->channel);
 	spdk_put_io_channel(ch->accel_channel);
 
@@ -3708,22 +4923,32 @@ bdev_channel_destroy_resource(struct spdk_bdev_channel *ch)
 	shared_resource->ref--;
 	if (shared_resource->ref == 0) {
 		assert(shared_resource->io_outstanding == 0);
-		TAILQ_REMOVE(&shared_resource->mgmt_ch->shared_resources, shared_resource, link);
+		RB_REMOVE(bdev_shared_resource_tree, &shared_resource->mgmt_ch->shared_resources,
+			  shared_resource);
 		spdk_put_io_channel(spdk_io_channel_from_ctx(shared_resource->mgmt_ch));
 		free(shared_resource);
 	}
 }
 
-static void
+static int
 bdev_enable_qos(struct spdk_bdev *bdev, struct spdk_bdev_channel *ch)
 {
 	struct spdk_bdev_qos	*qos = bdev->internal.qos;
-	int			i;
+	bool			sharded;
+	int			i, rc;
 
 	assert(spdk_spin_held(&bdev->internal.spinlock));
 
 	/* Rate limiting on this bdev enabled */
 	if (qos) {
+		sharded = qos->ch != NULL ? qos->sharded : bdev->internal.qos_sharded;
+		if (sharded && ch->qos_shard == NULL) {
+			rc = bdev_qos_shard_create(ch, qos);
+			if (rc != 0) {
+				return rc;
+			}
+		}
+
 		if (qos->ch == NULL) {
 			struct spdk_io_channel *io_ch;
 
@@ -3738,6 +4963,7 @@ bdev_enable_qos(struct spdk_bdev *bdev, struct spdk_bdev_channel *ch)
 			qos->ch = ch;
 
 			qos->thread = spdk_io_channel_get_thread(io_ch);
+			qos->sharded = sharded;
 
 			TAILQ_INIT(&qos->queued);
 
@@ -3765,6 +4991,8 @@ bdev_enable_qos(struct spdk_bdev *bdev, struct spdk_bdev_channel *ch)
 
 		ch->flags |= BDEV_CH_QOS_ENABLED;
 	}
+
+	return 0;
 }
 
 struct poll_timeout_ctx {
@@ -3872,6 +5100,16 @@ bdev_poll_timeout_io(void *arg)
 	return SPDK_POLLER_BUSY;
 }
 
+void
+spdk_bdev_set_completion_batch_cb(struct spdk_bdev_desc *desc,
+				  spdk_bdev_completion_batch_cb cb_fn, void *cb_arg)
+{
+	spdk_spin_lock(&desc->spinlock);
+	desc->completion_batch.cb_fn = cb_fn;
+	desc->completion_batch.cb_arg = cb_arg;
+	spdk_spin_unlock(&desc->spinlock);
+}
+
 int
 spdk_bdev_set_timeout(struct spdk_bdev_desc *desc, uint64_t timeout_in_sec,
 		      spdk_bdev_io_timeout_cb cb_fn, void *cb_arg)
@@ -3906,7 +5144,7 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 	struct spdk_bdev_channel	*ch = ctx_buf;
 	struct spdk_io_channel		*mgmt_io_ch;
 	struct spdk_bdev_mgmt_channel	*mgmt_ch;
-	struct spdk_bdev_shared_resource *shared_resource;
+	struct spdk_bdev_shared_resource *shared_resource, find = {};
 	struct lba_range		*range;
 
 	ch->bdev = bdev;
@@ -3932,6 +5170,14 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 		}
 	}
 
+	assert(ch->type_histograms == NULL);
+	if (bdev->internal.type_histograms_enabled) {
+		ch->type_histograms = calloc(1, sizeof(*ch->type_histograms));
+		if (ch->type_histograms == NULL) {
+			SPDK_ERRLOG("Could not allocate per-type histograms\n");
+		}
+	}
+
 	mgmt_io_ch = spdk_get_io_channel(&g_bdev_mgr);
 	if (!mgmt_io_ch) {
 		spdk_put_io_channel(ch->channel);
@@ -3940,15 +5186,12 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 	}
 
 	mgmt_ch = __io_ch_to_bdev_mgmt_ch(mgmt_io_ch);
-	TAILQ_FOREACH(shared_resource, &mgmt_ch->shared_resources, link) {
-		if (shared_resource->shared_ch == ch->channel) {
-			spdk_put_io_channel(mgmt_io_ch);
-			shared_resource->ref++;
-			break;
-		}
-	}
-
-	if (shared_resource == NULL) {
+	find.shared_ch = ch->channel;
+	shared_resource = RB_FIND(bdev_shared_resource_tree, &mgmt_ch->shared_resources, &find);
+	if (shared_resource != NULL) {
+		spdk_put_io_channel(mgmt_io_ch);
+		shared_resource->ref++;
+	} else {
 		shared_resource = calloc(1, sizeof(*shared_resource));
 		if (shared_resource == NULL) {
 			spdk_put_io_channel(ch->channel);
@@ -3963,7 +5206,7 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 		shared_resource->nomem_threshold = 0;
 		shared_resource->shared_ch = ch->channel;
 		shared_resource->ref = 1;
-		TAILQ_INSERT_TAIL(&mgmt_ch->shared_resources, shared_resource, link);
+		RB_INSERT(bdev_shared_resource_tree, &mgmt_ch->shared_resources, shared_resource);
 	}
 
 	ch->io_outstanding = 0;
@@ -3976,6 +5219,9 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 	TAILQ_INIT(&ch->io_locked);
 	TAILQ_INIT(&ch->io_accel_exec);
 	TAILQ_INIT(&ch->io_memory_domain);
+	TAILQ_INIT(&ch->latency_qos.queued);
+	STAILQ_INIT(&ch->coalesce.free_batches);
+	TAILQ_INIT(&ch->complete_batch.ios);
 
 	ch->stat = bdev_alloc_io_stat(false);
 	if (ch->stat == NULL) {
@@ -4007,7 +5253,14 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 #endif
 
 	spdk_spin_lock(&bdev->internal.spinlock);
-	bdev_enable_qos(bdev, ch);
+	if (bdev_enable_qos(bdev, ch) != 0) {
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		bdev_channel_destroy_resource(ch);
+		return -1;
+	}
+	bdev_latency_qos_channel_init(ch, bdev->internal.latency_qos);
+	bdev_coalesce_channel_update(ch, bdev->internal.coalesce_window_us,
+				     bdev->internal.coalesce_max_blocks);
 
 	TAILQ_FOREACH(range, &bdev->internal.locked_ranges, tailq) {
 		struct lba_range *new_range;
@@ -4026,6 +5279,9 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 
 	spdk_spin_unlock(&bdev->internal.spinlock);
 
+	memset(&ch->metrics_prev, 0, sizeof(ch->metrics_prev));
+	TAILQ_INSERT_TAIL(&shared_resource->mgmt_ch->channels, ch, metrics_link);
+
 	return 0;
 }
 
@@ -4053,10 +5309,7 @@ bdev_abort_all_buf_io_cb(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry
 static void
 bdev_abort_all_buf_io(struct spdk_bdev_mgmt_channel *mgmt_ch, struct spdk_bdev_channel *ch)
 {
-	spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.small,
-				  bdev_abort_all_buf_io_cb, ch);
-	spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.large,
-				  bdev_abort_all_buf_io_cb, ch);
+	spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, NULL, bdev_abort_all_buf_io_cb, ch);
 }
 
 /*
@@ -4124,14 +5377,7 @@ bdev_abort_buf_io(struct spdk_bdev_mgmt_channel *mgmt_ch, struct spdk_bdev_io *b
 {
 	int rc;
 
-	rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.small,
-				       bdev_abort_buf_io_cb, bio_to_abort);
-	if (rc == 1) {
-		return true;
-	}
-
-	rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, &mgmt_ch->iobuf.large,
-				       bdev_abort_buf_io_cb, bio_to_abort);
+	rc = spdk_iobuf_for_each_entry(&mgmt_ch->iobuf, NULL, bdev_abort_buf_io_cb, bio_to_abort);
 	return rc == 1;
 }
 
@@ -4181,6 +5427,8 @@ bdev_qos_destroy(struct spdk_bdev *bdev)
 	new_qos->thread = NULL;
 	new_qos->poller = NULL;
 	TAILQ_INIT(&new_qos->queued);
+	/* Sharded channels stop enforcing the limits until the QoS is started again. */
+	new_qos->timeslice_gen++;
 	/*
 	 * The limit member of spdk_bdev_qos_limit structure is not zeroed.
 	 * It will be used later for the new QoS structure.
@@ -4399,14 +5647,27 @@ bdev_channel_destroy(void *io_device, void *ctx_buf)
 	spdk_bdev_add_io_stat(ch->bdev->internal.stat, ch->stat);
 	spdk_spin_unlock(&ch->bdev->internal.spinlock);
 
+	bdev_channel_update_metrics(ch);
+	TAILQ_REMOVE(&ch->shared_resource->mgmt_ch->channels, ch, metrics_link);
+
 	bdev_abort_all_queued_io(&ch->queued_resets, ch);
 
 	bdev_channel_abort_queued_ios(ch);
 
+	if (ch->qos_shard != NULL) {
+		bdev_abort_all_queued_io(&ch->qos_shard->queued, ch);
+	}
+	bdev_abort_all_queued_io(&ch->latency_qos.queued, ch);
+	bdev_coalesce_abort(ch);
+	assert(ch->submit_batch.count == 0);
+	assert(TAILQ_EMPTY(&ch->complete_batch.ios));
+
 	if (ch->histogram) {
 		spdk_histogram_data_free(ch->histogram);
 	}
 
+	bdev_type_histograms_free(ch->type_histograms);
+
 	bdev_channel_destroy_resource(ch);
 }
 
@@ -4581,6 +5842,12 @@ spdk_bdev_get_write_unit_size(const struct spdk_bdev *bdev)
 	return bdev->write_unit_size;
 }
 
+int32_t
+spdk_bdev_get_socket_id(const struct spdk_bdev *bdev)
+{
+	return bdev->numa.id_valid ? (int32_t)bdev->numa.id : SPDK_ENV_SOCKET_ID_ANY;
+}
+
 uint64_t
 spdk_bdev_get_num_blocks(const struct spdk_bdev *bdev)
 {
@@ -5511,6 +6778,57 @@ spdk_bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_chan
 					  num_blocks, NULL, NULL, NULL, cb, cb_arg);
 }
 
+int
+spdk_bdev_submit_batch(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       struct spdk_bdev_batch_request *reqs, uint32_t count,
+		       uint32_t *num_submitted)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
+	struct spdk_bdev_channel *bdev_ch = __io_ch_to_bdev_ch(ch);
+	struct spdk_bdev_batch_request *req;
+	bool outer;
+	uint32_t i;
+	int rc = 0;
+
+	/* Without a batch callback, the requests are submitted one by one.  Only the
+	 * outermost call flushes the batch. */
+	outer = !bdev_ch->submit_batch.active && bdev->fn_table->submit_request_batch != NULL;
+	if (outer) {
+		bdev_ch->submit_batch.active = true;
+	}
+
+	for (i = 0; i < count; i++) {
+		req = &reqs[i];
+		switch (req->type) {
+		case SPDK_BDEV_IO_TYPE_READ:
+			rc = spdk_bdev_readv_blocks_with_md(desc, ch, req->iovs, req->iovcnt,
+							    req->md_buf, req->offset_blocks,
+							    req->num_blocks, req->cb, req->cb_arg);
+			break;
+		case SPDK_BDEV_IO_TYPE_WRITE:
+			rc = spdk_bdev_writev_blocks_with_md(desc, ch, req->iovs, req->iovcnt,
+							     req->md_buf, req->offset_blocks,
+							     req->num_blocks, req->cb, req->cb_arg);
+			break;
+		default:
+			rc = -EINVAL;
+			break;
+		}
+		if (rc != 0) {
+			break;
+		}
+	}
+
+	if (outer) {
+		bdev_ch->submit_batch.active = false;
+		bdev_submit_batch_flush(bdev_ch);
+	}
+
+	*num_submitted = i;
+
+	return rc;
+}
+
 int
 spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 			    struct iovec *iov, int iovcnt,
@@ -5942,6 +7260,7 @@ spdk_bdev_zcopy_start(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 	bdev_io->u.bdev.zcopy.populate = populate ? 1 : 0;
 	bdev_io->u.bdev.zcopy.commit = 0;
 	bdev_io->u.bdev.zcopy.start = 1;
+	bdev_io->internal.zcopy_base_io = NULL;
 	bdev_io_init(bdev_io, bdev, cb_arg, cb);
 	bdev_io->u.bdev.memory_domain = NULL;
 	bdev_io->u.bdev.memory_domain_ctx = NULL;
@@ -5971,6 +7290,89 @@ spdk_bdev_zcopy_end(struct spdk_bdev_io *bdev_io, bool commit,
 	return 0;
 }
 
+static void
+bdev_zcopy_forward_abort_done(struct spdk_bdev_io *base_io, bool success, void *cb_arg)
+{
+	spdk_bdev_free_io(base_io);
+}
+
+/* Describes the buffers of base_io in the iovs of bdev_io, which belong to the caller. */
+static int
+bdev_io_zcopy_lend_iovs(struct spdk_bdev_io *bdev_io, struct spdk_bdev_io *base_io)
+{
+	int i;
+
+	if (bdev_io->u.bdev.iovs == base_io->u.bdev.iovs) {
+		/* The base bdev filled the caller's iovs directly */
+		bdev_io->u.bdev.iovcnt = base_io->u.bdev.iovcnt;
+		return 0;
+	}
+
+	if (bdev_io->u.bdev.iovs == NULL) {
+		bdev_io->u.bdev.iovs = &bdev_io->iov;
+		bdev_io->u.bdev.iovcnt = 1;
+	}
+
+	if (base_io->u.bdev.iovcnt > bdev_io->u.bdev.iovcnt) {
+		SPDK_ERRLOG("Base bdev %s exposed %d buffers, only %d can be lent\n",
+			    base_io->bdev->name, base_io->u.bdev.iovcnt, bdev_io->u.bdev.iovcnt);
+		return -ENOBUFS;
+	}
+
+	for (i = 0; i < base_io->u.bdev.iovcnt; i++) {
+		bdev_io->u.bdev.iovs[i] = base_io->u.bdev.iovs[i];
+	}
+	bdev_io->u.bdev.iovcnt = base_io->u.bdev.iovcnt;
+
+	return 0;
+}
+
+static void
+bdev_zcopy_forward_done(struct spdk_bdev_io *base_io, bool success, void *cb_arg)
+{
+	struct spdk_bdev_io *bdev_io = cb_arg;
+	int rc;
+
+	if (!bdev_io->u.bdev.zcopy.start || !success) {
+		bdev_io->internal.zcopy_base_io = NULL;
+		spdk_bdev_free_io(base_io);
+		spdk_bdev_io_complete(bdev_io, success ? SPDK_BDEV_IO_STATUS_SUCCESS :
+				      SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	rc = bdev_io_zcopy_lend_iovs(bdev_io, base_io);
+	if (spdk_unlikely(rc != 0)) {
+		rc = spdk_bdev_zcopy_end(base_io, false, bdev_zcopy_forward_abort_done, NULL);
+		assert(rc == 0);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	/* Keep the base I/O, its buffers are lent until the end phase */
+	bdev_io->internal.zcopy_base_io = base_io;
+	spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+int
+spdk_bdev_io_zcopy_forward(struct spdk_bdev_io *bdev_io, struct spdk_bdev_desc *desc,
+			   struct spdk_io_channel *ch, uint64_t offset_blocks)
+{
+	assert(bdev_io->type == SPDK_BDEV_IO_TYPE_ZCOPY);
+
+	if (!bdev_io->u.bdev.zcopy.start) {
+		assert(bdev_io->internal.zcopy_base_io != NULL);
+		return spdk_bdev_zcopy_end(bdev_io->internal.zcopy_base_io,
+					   bdev_io->u.bdev.zcopy.commit,
+					   bdev_zcopy_forward_done, bdev_io);
+	}
+
+	return spdk_bdev_zcopy_start(desc, ch, bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+				     offset_blocks, bdev_io->u.bdev.num_blocks,
+				     bdev_io->u.bdev.zcopy.populate, bdev_zcopy_forward_done,
+				     bdev_io);
+}
+
 int
 spdk_bdev_write_zeroes(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 		       uint64_t offset, uint64_t len,
@@ -6269,7 +7671,9 @@ bdev_reset_freeze_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bd
 
 	channel->flags |= BDEV_CH_RESET_IN_PROGRESS;
 
-	if ((channel->flags & BDEV_CH_QOS_ENABLED) != 0) {
+	if (channel->qos_shard != NULL) {
+		TAILQ_SWAP(&channel->qos_shard->queued, &tmp_queued, spdk_bdev_io, internal.link);
+	} else if ((channel->flags & BDEV_CH_QOS_ENABLED) != 0) {
 		/* The QoS object is always valid and readable while
 		 * the channel flag is set, so the lock here should not
 		 * be necessary. We're not in the fast path though, so
@@ -6282,6 +7686,8 @@ bdev_reset_freeze_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bd
 	}
 
 	bdev_abort_all_queued_io(&shared_resource->nomem_io, channel);
+	bdev_abort_all_queued_io(&channel->latency_qos.queued, channel);
+	bdev_coalesce_abort(channel);
 	bdev_abort_all_buf_io(mgmt_channel, channel);
 	bdev_abort_all_buf_io(mgmt_channel, channel);
 	bdev_abort_all_queued_io(&tmp_queued, channel);
@@ -6988,23 +8394,11 @@ _bdev_io_complete(void *ctx)
 }
 
 static inline void
-bdev_io_complete(void *ctx)
+bdev_io_complete_tsc(struct spdk_bdev_io *bdev_io, uint64_t tsc)
 {
-	struct spdk_bdev_io *bdev_io = ctx;
 	struct spdk_bdev_channel *bdev_ch = bdev_io->internal.ch;
-	uint64_t tsc, tsc_diff;
-
-	if (spdk_unlikely(bdev_io->internal.in_submit_request)) {
-		/*
-		 * Defer completion to avoid potential infinite recursion if the
-		 * user's completion callback issues a new I/O.
-		 */
-		spdk_thread_send_msg(spdk_bdev_io_get_thread(bdev_io),
-				     bdev_io_complete, bdev_io);
-		return;
-	}
+	uint64_t tsc_diff;
 
-	tsc = spdk_get_ticks();
 	tsc_diff = tsc - bdev_io->internal.submit_tsc;
 	spdk_trace_record_tsc(tsc, TRACE_BDEV_IO_DONE, 0, 0, (uintptr_t)bdev_io,
 			      bdev_io->internal.caller_ctx);
@@ -7015,10 +8409,51 @@ bdev_io_complete(void *ctx)
 		spdk_histogram_data_tally(bdev_io->internal.ch->histogram, tsc_diff);
 	}
 
+	if (spdk_unlikely(bdev_ch->type_histograms != NULL)) {
+		bdev_type_histograms_tally(bdev_ch->type_histograms, bdev_io, tsc_diff);
+	}
+
+	if (spdk_unlikely(bdev_ch->latency_qos.group != NULL)) {
+		bdev_latency_qos_complete(bdev_ch, bdev_io, tsc_diff);
+	}
+
 	bdev_io_update_io_stat(bdev_io, tsc_diff);
+	spdk_thread_record_latency(tsc_diff);
 	_bdev_io_complete(bdev_io);
 }
 
+static void
+bdev_complete_batch_add(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_io)
+{
+	if (TAILQ_EMPTY(&bdev_ch->complete_batch.ios)) {
+		TAILQ_INSERT_TAIL(&g_complete_batch.channels, bdev_ch, complete_batch.link);
+	}
+	TAILQ_INSERT_TAIL(&bdev_ch->complete_batch.ios, bdev_io, internal.link);
+}
+
+static inline void
+bdev_io_complete(void *ctx)
+{
+	struct spdk_bdev_io *bdev_io = ctx;
+
+	if (spdk_unlikely(bdev_io->internal.in_submit_request)) {
+		/*
+		 * Defer completion to avoid potential infinite recursion if the
+		 * user's completion callback issues a new I/O.
+		 */
+		spdk_thread_send_msg(spdk_bdev_io_get_thread(bdev_io),
+				     bdev_io_complete, bdev_io);
+		return;
+	}
+
+	if (g_complete_batch.depth != 0) {
+		bdev_complete_batch_add(bdev_io->internal.ch, bdev_io);
+		return;
+	}
+
+	bdev_io_complete_tsc(bdev_io, spdk_get_ticks());
+}
+
 /* The difference between this function and bdev_io_complete() is that this should be called to
  * complete IOs that haven't been submitted via bdev_io_submit(), as they weren't added onto the
  * io_submitted list and don't have submit_tsc updated.
@@ -7091,6 +8526,109 @@ bdev_io_complete_sequence_cb(void *ctx, int status)
 	bdev_io_complete(bdev_io);
 }
 
+/* The descriptor is referenced until the callback is called, as it may be closed by
+ * the completion callbacks of its I/O. */
+static void
+bdev_desc_completion_batch_get(struct spdk_bdev_desc *desc)
+{
+	spdk_spin_lock(&desc->spinlock);
+	desc->refs++;
+	spdk_spin_unlock(&desc->spinlock);
+}
+
+static void
+bdev_desc_completion_batch_done(struct spdk_bdev_desc *desc)
+{
+	spdk_bdev_completion_batch_cb cb_fn;
+	void *cb_arg;
+
+	spdk_spin_lock(&desc->spinlock);
+	desc->refs--;
+	if (desc->closed == true) {
+		if (desc->refs == 0) {
+			spdk_spin_unlock(&desc->spinlock);
+			bdev_desc_free(desc);
+			return;
+		}
+		spdk_spin_unlock(&desc->spinlock);
+		return;
+	}
+	cb_fn = desc->completion_batch.cb_fn;
+	cb_arg = desc->completion_batch.cb_arg;
+	spdk_spin_unlock(&desc->spinlock);
+
+	if (cb_fn != NULL) {
+		cb_fn(cb_arg);
+	}
+}
+
+static void
+bdev_complete_batch_flush(struct spdk_bdev_channel *bdev_ch, uint64_t tsc)
+{
+	struct spdk_bdev_io *bdev_io;
+	struct spdk_bdev_desc *desc = NULL;
+	bdev_io_tailq_t ios;
+
+	TAILQ_INIT(&ios);
+	TAILQ_SWAP(&bdev_ch->complete_batch.ios, &ios, spdk_bdev_io, internal.link);
+
+	while (!TAILQ_EMPTY(&ios)) {
+		bdev_io = TAILQ_FIRST(&ios);
+		TAILQ_REMOVE(&ios, bdev_io, internal.link);
+
+		/* Notify a descriptor once its consecutive completions are delivered. */
+		if (bdev_io->internal.desc != desc) {
+			if (desc != NULL) {
+				bdev_desc_completion_batch_done(desc);
+				desc = NULL;
+			}
+			if (bdev_io->internal.desc->completion_batch.cb_fn != NULL) {
+				desc = bdev_io->internal.desc;
+				bdev_desc_completion_batch_get(desc);
+			}
+		}
+
+		bdev_io_complete_tsc(bdev_io, tsc);
+	}
+
+	if (desc != NULL) {
+		bdev_desc_completion_batch_done(desc);
+	}
+}
+
+void
+spdk_bdev_io_complete_batch_begin(void)
+{
+	if (g_complete_batch.depth++ == 0) {
+		TAILQ_INIT(&g_complete_batch.channels);
+	}
+}
+
+void
+spdk_bdev_io_complete_batch_end(void)
+{
+	TAILQ_HEAD(, spdk_bdev_channel) channels;
+	struct spdk_bdev_channel *bdev_ch;
+	uint64_t tsc;
+
+	assert(g_complete_batch.depth > 0);
+	if (--g_complete_batch.depth != 0 || TAILQ_EMPTY(&g_complete_batch.channels)) {
+		return;
+	}
+
+	/* The completion callbacks may start a new batch. */
+	TAILQ_INIT(&channels);
+	TAILQ_SWAP(&g_complete_batch.channels, &channels, spdk_bdev_channel, complete_batch.link);
+
+	/* All the I/O of the batch share a single completion timestamp. */
+	tsc = spdk_get_ticks();
+	while (!TAILQ_EMPTY(&channels)) {
+		bdev_ch = TAILQ_FIRST(&channels);
+		TAILQ_REMOVE(&channels, bdev_ch, complete_batch.link);
+		bdev_complete_batch_flush(bdev_ch, tsc);
+	}
+}
+
 void
 spdk_bdev_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status status)
 {
@@ -7412,6 +8950,7 @@ bdev_register(struct spdk_bdev *bdev)
 	memset(&bdev->internal.claim, 0, sizeof(bdev->internal.claim));
 	bdev->internal.qd_poller = NULL;
 	bdev->internal.qos = NULL;
+	bdev->internal.latency_qos = NULL;
 
 	TAILQ_INIT(&bdev->internal.open_descs);
 	TAILQ_INIT(&bdev->internal.locked_ranges);
@@ -7469,7 +9008,7 @@ bdev_register(struct spdk_bdev *bdev)
 	}
 
 	if (!bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_COPY)) {
-		spdk_iobuf_get_opts(&iobuf_opts);
+		spdk_iobuf_get_opts(&iobuf_opts, sizeof(iobuf_opts));
 		bdev->max_copy = bdev_get_max_write(bdev, iobuf_opts.large_bufsize);
 	}
 
@@ -7494,6 +9033,11 @@ bdev_register(struct spdk_bdev *bdev)
 	SPDK_DEBUGLOG(bdev, "Inserting bdev %s into list\n", bdev->name);
 	TAILQ_INSERT_TAIL(&g_bdev_mgr.bdevs, bdev, internal.link);
 
+	memset(&bdev->internal.metrics_stat, 0, sizeof(bdev->internal.metrics_stat));
+	pthread_mutex_lock(&g_bdev_metrics_mutex);
+	TAILQ_INSERT_TAIL(&g_bdev_metrics_list, bdev, internal.metrics_link);
+	pthread_mutex_unlock(&g_bdev_metrics_mutex);
+
 	return 0;
 }
 
@@ -7515,8 +9059,13 @@ bdev_destroy_cb(void *io_device)
 	cb_fn = bdev->internal.unregister_cb;
 	cb_arg = bdev->internal.unregister_ctx;
 
+	pthread_mutex_lock(&g_bdev_metrics_mutex);
+	TAILQ_REMOVE(&g_bdev_metrics_list, bdev, internal.metrics_link);
+	pthread_mutex_unlock(&g_bdev_metrics_mutex);
+
 	spdk_spin_destroy(&bdev->internal.spinlock);
 	free(bdev->internal.qos);
+	bdev_latency_qos_free(bdev->internal.latency_qos);
 	bdev_free_io_stat(bdev->internal.stat);
 
 	rc = bdev->fn_table->destruct(bdev->ctxt);
@@ -7570,6 +9119,7 @@ bdev_unregister_unsafe(struct spdk_bdev *bdev)
 
 	/* If there are no descriptors, proceed removing the bdev */
 	if (rc == 0) {
+		bdev_examine_pending_remove(bdev);
 		TAILQ_REMOVE(&g_bdev_mgr.bdevs, bdev, internal.link);
 		SPDK_DEBUGLOG(bdev, "Removing bdev %s from list done\n", bdev->name);
 
@@ -8432,7 +9982,7 @@ spdk_bdev_desc_get_bdev(struct spdk_bdev_desc *desc)
 }
 
 int
-spdk_for_each_bdev(void *ctx, spdk_for_each_bdev_fn fn)
+bdev_for_each_bdev_after(const char *start_after, void *ctx, spdk_for_each_bdev_fn fn)
 {
 	struct spdk_bdev *bdev, *tmp;
 	struct spdk_bdev_desc *desc;
@@ -8441,7 +9991,16 @@ spdk_for_each_bdev(void *ctx, spdk_for_each_bdev_fn fn)
 	assert(fn != NULL);
 
 	spdk_spin_lock(&g_bdev_mgr.spinlock);
-	bdev = spdk_bdev_first();
+	if (start_after != NULL) {
+		bdev = bdev_get_by_name(start_after);
+		if (bdev == NULL) {
+			spdk_spin_unlock(&g_bdev_mgr.spinlock);
+			return -ENODEV;
+		}
+		bdev = spdk_bdev_next(bdev);
+	} else {
+		bdev = spdk_bdev_first();
+	}
 	while (bdev != NULL) {
 		rc = bdev_desc_alloc(bdev, _tmp_bdev_event_cb, NULL, &desc);
 		if (rc != 0) {
@@ -8475,6 +10034,12 @@ spdk_for_each_bdev(void *ctx, spdk_for_each_bdev_fn fn)
 	return rc;
 }
 
+int
+spdk_for_each_bdev(void *ctx, spdk_for_each_bdev_fn fn)
+{
+	return bdev_for_each_bdev_after(NULL, ctx, fn);
+}
+
 int
 spdk_for_each_bdev_leaf(void *ctx, spdk_for_each_bdev_fn fn)
 {
@@ -8724,9 +10289,24 @@ bdev_disable_qos_msg(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
 		     struct spdk_io_channel *ch, void *_ctx)
 {
 	struct spdk_bdev_channel *bdev_ch = __io_ch_to_bdev_ch(ch);
+	struct spdk_bdev_io *bdev_io;
+	bdev_io_tailq_t queued;
 
 	bdev_ch->flags &= ~BDEV_CH_QOS_ENABLED;
 
+	if (bdev_ch->qos_shard != NULL) {
+		/* Resubmit the I/O that were waiting for quota on this channel. */
+		TAILQ_INIT(&queued);
+		TAILQ_SWAP(&bdev_ch->qos_shard->queued, &queued, spdk_bdev_io, internal.link);
+		bdev_qos_shard_destroy(bdev_ch);
+
+		while (!TAILQ_EMPTY(&queued)) {
+			bdev_io = TAILQ_FIRST(&queued);
+			TAILQ_REMOVE(&queued, bdev_io, internal.link);
+			_bdev_io_submit(bdev_io);
+		}
+	}
+
 	spdk_bdev_for_each_channel_continue(i, 0);
 }
 
@@ -8748,11 +10328,12 @@ bdev_enable_qos_msg(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
 		    struct spdk_io_channel *ch, void *_ctx)
 {
 	struct spdk_bdev_channel *bdev_ch = __io_ch_to_bdev_ch(ch);
+	int rc;
 
 	spdk_spin_lock(&bdev->internal.spinlock);
-	bdev_enable_qos(bdev, bdev_ch);
+	rc = bdev_enable_qos(bdev, bdev_ch);
 	spdk_spin_unlock(&bdev->internal.spinlock);
-	spdk_bdev_for_each_channel_continue(i, 0);
+	spdk_bdev_for_each_channel_continue(i, rc);
 }
 
 static void
@@ -8890,6 +10471,229 @@ spdk_bdev_set_qos_rate_limits(struct spdk_bdev *bdev, uint64_t *limits,
 	spdk_spin_unlock(&bdev->internal.spinlock);
 }
 
+static struct bdev_latency_group *
+bdev_latency_group_get(const char *name)
+{
+	struct bdev_latency_group *group;
+
+	spdk_spin_lock(&g_bdev_mgr.spinlock);
+	TAILQ_FOREACH(group, &g_bdev_mgr.latency_groups, link) {
+		if (strcmp(group->name, name) == 0) {
+			group->ref++;
+			spdk_spin_unlock(&g_bdev_mgr.spinlock);
+			return group;
+		}
+	}
+
+	group = calloc(1, sizeof(*group));
+	if (group != NULL) {
+		group->name = strdup(name);
+		if (group->name == NULL) {
+			free(group);
+			group = NULL;
+		} else {
+			group->ref = 1;
+			TAILQ_INSERT_TAIL(&g_bdev_mgr.latency_groups, group, link);
+		}
+	}
+	spdk_spin_unlock(&g_bdev_mgr.spinlock);
+
+	return group;
+}
+
+static void
+bdev_latency_qos_free(struct spdk_bdev_latency_qos *latency_qos)
+{
+	struct bdev_latency_group *group;
+
+	if (latency_qos == NULL) {
+		return;
+	}
+
+	group = latency_qos->group;
+	spdk_spin_lock(&g_bdev_mgr.spinlock);
+	assert(group->ref > 0);
+	if (--group->ref == 0) {
+		TAILQ_REMOVE(&g_bdev_mgr.latency_groups, group, link);
+	} else {
+		group = NULL;
+	}
+	spdk_spin_unlock(&g_bdev_mgr.spinlock);
+
+	if (group != NULL) {
+		free(group->name);
+		free(group);
+	}
+	free(latency_qos);
+}
+
+static void
+bdev_latency_qos_update_msg(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+			    struct spdk_io_channel *ch, void *_ctx)
+{
+	struct spdk_bdev_channel *bdev_ch = __io_ch_to_bdev_ch(ch);
+	struct spdk_bdev_io *bdev_io;
+	bdev_io_tailq_t queued;
+
+	TAILQ_INIT(&queued);
+	TAILQ_SWAP(&bdev_ch->latency_qos.queued, &queued, spdk_bdev_io, internal.link);
+	if (bdev_ch->latency_qos.group != NULL) {
+		bdev_latency_qos_channel_fini(bdev_ch);
+	}
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	bdev_latency_qos_channel_init(bdev_ch, bdev->internal.latency_qos);
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	/* Resubmit the throttled I/O under the new settings. */
+	while (!TAILQ_EMPTY(&queued)) {
+		bdev_io = TAILQ_FIRST(&queued);
+		TAILQ_REMOVE(&queued, bdev_io, internal.link);
+		bdev_io_do_submit(bdev_ch, bdev_io);
+	}
+
+	spdk_bdev_for_each_channel_continue(i, 0);
+}
+
+static void
+bdev_latency_qos_update_done(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct set_qos_limit_ctx *ctx = _ctx;
+
+	bdev_latency_qos_free(ctx->old_latency_qos);
+	bdev_set_qos_limit_done(ctx, status);
+}
+
+void
+spdk_bdev_set_qos_latency_target(struct spdk_bdev *bdev, const char *group, uint64_t target_us,
+				 void (*cb_fn)(void *cb_arg, int status), void *cb_arg)
+{
+	struct set_qos_limit_ctx	*ctx;
+	struct spdk_bdev_latency_qos	*latency_qos = NULL;
+
+	if (group != NULL) {
+		latency_qos = calloc(1, sizeof(*latency_qos));
+		if (latency_qos == NULL) {
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
+
+		latency_qos->group = bdev_latency_group_get(group);
+		if (latency_qos->group == NULL) {
+			free(latency_qos);
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
+		latency_qos->target_us = target_us;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		bdev_latency_qos_free(latency_qos);
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->bdev = bdev;
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	if (bdev->internal.qos_mod_in_progress) {
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		bdev_latency_qos_free(latency_qos);
+		free(ctx);
+		cb_fn(cb_arg, -EAGAIN);
+		return;
+	}
+	bdev->internal.qos_mod_in_progress = true;
+
+	ctx->old_latency_qos = bdev->internal.latency_qos;
+	bdev->internal.latency_qos = latency_qos;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	spdk_bdev_for_each_channel(bdev, bdev_latency_qos_update_msg, ctx,
+				   bdev_latency_qos_update_done);
+}
+
+int
+spdk_bdev_set_qos_sharded(struct spdk_bdev *bdev, bool sharded)
+{
+	int rc = 0;
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	if (bdev->internal.qos_sharded != sharded) {
+		if (bdev->internal.qos != NULL || bdev->internal.qos_mod_in_progress) {
+			rc = -EBUSY;
+		} else {
+			bdev->internal.qos_sharded = sharded;
+		}
+	}
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	return rc;
+}
+
+struct bdev_coalesce_ctx {
+	void (*cb_fn)(void *cb_arg, int status);
+	void *cb_arg;
+};
+
+static void
+bdev_coalesce_update_msg(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+			 struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+	uint32_t window_us, max_blocks;
+
+	/* Always apply the latest settings, in case of concurrent updates. */
+	spdk_spin_lock(&bdev->internal.spinlock);
+	window_us = bdev->internal.coalesce_window_us;
+	max_blocks = bdev->internal.coalesce_max_blocks;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	bdev_coalesce_channel_update(ch, window_us, max_blocks);
+
+	spdk_bdev_for_each_channel_continue(i, 0);
+}
+
+static void
+bdev_coalesce_update_done(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct bdev_coalesce_ctx *ctx = _ctx;
+
+	ctx->cb_fn(ctx->cb_arg, status);
+	free(ctx);
+}
+
+void
+spdk_bdev_set_io_coalescing(struct spdk_bdev *bdev, uint32_t window_us, uint32_t max_blocks,
+			    void (*cb_fn)(void *cb_arg, int status), void *cb_arg)
+{
+	struct bdev_coalesce_ctx *ctx;
+
+	if (window_us != 0 && max_blocks < 2) {
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	bdev->internal.coalesce_window_us = window_us;
+	bdev->internal.coalesce_max_blocks = window_us != 0 ? max_blocks : 0;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	spdk_bdev_for_each_channel(bdev, bdev_coalesce_update_msg, ctx, bdev_coalesce_update_done);
+}
+
 struct spdk_bdev_histogram_ctx {
 	spdk_bdev_histogram_status_cb cb_fn;
 	void *cb_arg;
@@ -9070,6 +10874,291 @@ spdk_bdev_channel_get_histogram(struct spdk_io_channel *ch, spdk_bdev_histogram_
 	cb_fn(cb_arg, status, bdev_ch->histogram);
 }
 
+/* Per-type histograms are coarser, there may be many of them on each channel */
+#define BDEV_TYPE_HISTOGRAM_BUCKET_SHIFT	4
+
+static uint32_t
+bdev_io_get_size_bucket(struct spdk_bdev_io *bdev_io)
+{
+	uint64_t num_bytes;
+	uint32_t bucket;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_COMPARE:
+	case SPDK_BDEV_IO_TYPE_COMPARE_AND_WRITE:
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+	case SPDK_BDEV_IO_TYPE_COPY:
+		num_bytes = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
+		break;
+	default:
+		return 0;
+	}
+
+	if (num_bytes <= (1ULL << SPDK_BDEV_HISTOGRAM_SIZE_BUCKET_SHIFT)) {
+		return 0;
+	}
+
+	bucket = spdk_u64log2(num_bytes - 1) + 1 - SPDK_BDEV_HISTOGRAM_SIZE_BUCKET_SHIFT;
+
+	return spdk_min(bucket, SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS - 1);
+}
+
+static void
+bdev_type_histograms_tally(struct spdk_bdev_type_histograms *histograms,
+			   struct spdk_bdev_io *bdev_io, uint64_t tsc_diff)
+{
+	struct spdk_histogram_data **histogram;
+
+	histogram = &histograms->histogram[bdev_io->type][bdev_io_get_size_bucket(bdev_io)];
+	if (spdk_unlikely(*histogram == NULL)) {
+		/* Only allocated for the types and sizes actually seen on the channel */
+		*histogram = spdk_histogram_data_alloc_sized(BDEV_TYPE_HISTOGRAM_BUCKET_SHIFT);
+		if (*histogram == NULL) {
+			return;
+		}
+	}
+
+	spdk_histogram_data_tally(*histogram, tsc_diff);
+}
+
+static void
+bdev_type_histograms_reset(struct spdk_bdev_type_histograms *histograms)
+{
+	int type, bucket;
+
+	for (type = 0; type < SPDK_BDEV_NUM_IO_TYPES; type++) {
+		for (bucket = 0; bucket < SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS; bucket++) {
+			if (histograms->histogram[type][bucket] != NULL) {
+				spdk_histogram_data_reset(histograms->histogram[type][bucket]);
+			}
+		}
+	}
+}
+
+static void
+bdev_type_histograms_free(struct spdk_bdev_type_histograms *histograms)
+{
+	int type, bucket;
+
+	if (histograms == NULL) {
+		return;
+	}
+
+	for (type = 0; type < SPDK_BDEV_NUM_IO_TYPES; type++) {
+		for (bucket = 0; bucket < SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS; bucket++) {
+			spdk_histogram_data_free(histograms->histogram[type][bucket]);
+		}
+	}
+
+	free(histograms);
+}
+
+static int
+bdev_type_histograms_merge(struct spdk_bdev_type_histograms *dst,
+			   const struct spdk_bdev_type_histograms *src)
+{
+	struct spdk_histogram_data **histogram;
+	int type, bucket;
+
+	for (type = 0; type < SPDK_BDEV_NUM_IO_TYPES; type++) {
+		for (bucket = 0; bucket < SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS; bucket++) {
+			if (src->histogram[type][bucket] == NULL) {
+				continue;
+			}
+
+			histogram = &dst->histogram[type][bucket];
+			if (*histogram == NULL) {
+				*histogram = spdk_histogram_data_alloc_sized(
+						     BDEV_TYPE_HISTOGRAM_BUCKET_SHIFT);
+				if (*histogram == NULL) {
+					return -ENOMEM;
+				}
+			}
+
+			spdk_histogram_data_merge(*histogram, src->histogram[type][bucket]);
+		}
+	}
+
+	return 0;
+}
+
+static void
+bdev_type_histograms_disable_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+				     struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+
+	bdev_type_histograms_free(ch->type_histograms);
+	ch->type_histograms = NULL;
+
+	spdk_bdev_for_each_channel_continue(i, 0);
+}
+
+static void
+bdev_type_histograms_enable_channel_cb(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct spdk_bdev_histogram_ctx *ctx = _ctx;
+
+	if (status != 0) {
+		ctx->status = status;
+		ctx->bdev->internal.type_histograms_enabled = false;
+		spdk_bdev_for_each_channel(ctx->bdev, bdev_type_histograms_disable_channel, ctx,
+					   bdev_histogram_disable_channel_cb);
+	} else {
+		spdk_spin_lock(&ctx->bdev->internal.spinlock);
+		ctx->bdev->internal.histogram_in_progress = false;
+		spdk_spin_unlock(&ctx->bdev->internal.spinlock);
+		ctx->cb_fn(ctx->cb_arg, ctx->status);
+		free(ctx);
+	}
+}
+
+static void
+bdev_type_histograms_enable_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+				    struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+	int status = 0;
+
+	if (ch->type_histograms == NULL) {
+		ch->type_histograms = calloc(1, sizeof(*ch->type_histograms));
+		if (ch->type_histograms == NULL) {
+			status = -ENOMEM;
+		}
+	}
+
+	spdk_bdev_for_each_channel_continue(i, status);
+}
+
+void
+spdk_bdev_type_histograms_enable(struct spdk_bdev *bdev, spdk_bdev_histogram_status_cb cb_fn,
+				 void *cb_arg, bool enable)
+{
+	struct spdk_bdev_histogram_ctx *ctx;
+
+	ctx = calloc(1, sizeof(struct spdk_bdev_histogram_ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->bdev = bdev;
+	ctx->status = 0;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_spin_lock(&bdev->internal.spinlock);
+	if (bdev->internal.histogram_in_progress) {
+		spdk_spin_unlock(&bdev->internal.spinlock);
+		free(ctx);
+		cb_fn(cb_arg, -EAGAIN);
+		return;
+	}
+
+	bdev->internal.histogram_in_progress = true;
+	spdk_spin_unlock(&bdev->internal.spinlock);
+
+	bdev->internal.type_histograms_enabled = enable;
+
+	if (enable) {
+		spdk_bdev_for_each_channel(bdev, bdev_type_histograms_enable_channel, ctx,
+					   bdev_type_histograms_enable_channel_cb);
+	} else {
+		spdk_bdev_for_each_channel(bdev, bdev_type_histograms_disable_channel, ctx,
+					   bdev_histogram_disable_channel_cb);
+	}
+}
+
+struct spdk_bdev_type_histograms_ctx {
+	spdk_bdev_type_histograms_cb cb_fn;
+	void *cb_arg;
+	bool reset;
+	/** merged histograms from all channels */
+	struct spdk_bdev_type_histograms *histograms;
+};
+
+static void
+bdev_type_histograms_get_channel_cb(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct spdk_bdev_type_histograms_ctx *ctx = _ctx;
+
+	ctx->cb_fn(ctx->cb_arg, status, status == 0 ? ctx->histograms : NULL);
+	bdev_type_histograms_free(ctx->histograms);
+	free(ctx);
+}
+
+static void
+bdev_type_histograms_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+				 struct spdk_io_channel *_ch, void *_ctx)
+{
+	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
+	struct spdk_bdev_type_histograms_ctx *ctx = _ctx;
+	int status;
+
+	if (ch->type_histograms == NULL) {
+		status = -EFAULT;
+	} else {
+		status = bdev_type_histograms_merge(ctx->histograms, ch->type_histograms);
+		if (status == 0 && ctx->reset) {
+			bdev_type_histograms_reset(ch->type_histograms);
+		}
+	}
+
+	spdk_bdev_for_each_channel_continue(i, status);
+}
+
+void
+spdk_bdev_type_histograms_get(struct spdk_bdev *bdev, bool reset,
+			      spdk_bdev_type_histograms_cb cb_fn, void *cb_arg)
+{
+	struct spdk_bdev_type_histograms_ctx *ctx;
+
+	ctx = calloc(1, sizeof(struct spdk_bdev_type_histograms_ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM, NULL);
+		return;
+	}
+
+	ctx->histograms = calloc(1, sizeof(*ctx->histograms));
+	if (ctx->histograms == NULL) {
+		free(ctx);
+		cb_fn(cb_arg, -ENOMEM, NULL);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->reset = reset;
+
+	spdk_bdev_for_each_channel(bdev, bdev_type_histograms_get_channel, ctx,
+				   bdev_type_histograms_get_channel_cb);
+}
+
+void
+spdk_bdev_channel_get_type_histograms(struct spdk_io_channel *ch, bool reset,
+				      spdk_bdev_type_histograms_cb cb_fn, void *cb_arg)
+{
+	struct spdk_bdev_channel *bdev_ch = __io_ch_to_bdev_ch(ch);
+
+	assert(cb_fn != NULL);
+
+	if (bdev_ch->type_histograms == NULL) {
+		cb_fn(cb_arg, -EFAULT, NULL);
+		return;
+	}
+
+	cb_fn(cb_arg, 0, bdev_ch->type_histograms);
+
+	if (reset) {
+		bdev_type_histograms_reset(bdev_ch->type_histograms);
+	}
+}
+
 size_t
 spdk_bdev_get_media_events(struct spdk_bdev_desc *desc, struct spdk_bdev_media_event *events,
 			   size_t max_events)
@@ -31,4 +31,8 @@ typedef void (*bdev_reset_device_stat_cb)(struct spdk_bdev *bdev, void *cb_arg,
 void bdev_reset_device_stat(struct spdk_bdev *bdev, enum spdk_bdev_reset_stat_mode mode,
 			    bdev_reset_device_stat_cb cb, void *cb_arg);
 
+/* Same as spdk_for_each_bdev(), but starts with the bdev registered after the one named
+ * start_after (or the first bdev if it's NULL).  Returns -ENODEV if start_after doesn't exist. */
+int bdev_for_each_bdev_after(const char *start_after, void *ctx, spdk_for_each_bdev_fn fn);
+
 #endif /* SPDK_BDEV_INTERNAL_H */
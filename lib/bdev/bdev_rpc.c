@@ -29,6 +29,8 @@ struct spdk_rpc_set_bdev_opts {
 	bool bdev_auto_examine;
 	uint32_t small_buf_pool_size;
 	uint32_t large_buf_pool_size;
+	uint32_t accel_copy_threshold;
+	uint32_t examine_queue_depth;
 };
 
 static const struct spdk_json_object_decoder rpc_set_bdev_opts_decoders[] = {
@@ -37,6 +39,14 @@ static const struct spdk_json_object_decoder rpc_set_bdev_opts_decoders[] = {
 	{"bdev_auto_examine", offsetof(struct spdk_rpc_set_bdev_opts, bdev_auto_examine), spdk_json_decode_bool, true},
 	{"small_buf_pool_size", offsetof(struct spdk_rpc_set_bdev_opts, small_buf_pool_size), spdk_json_decode_uint32, true},
 	{"large_buf_pool_size", offsetof(struct spdk_rpc_set_bdev_opts, large_buf_pool_size), spdk_json_decode_uint32, true},
+	{
+		"accel_copy_threshold", offsetof(struct spdk_rpc_set_bdev_opts, accel_copy_threshold),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"examine_queue_depth", offsetof(struct spdk_rpc_set_bdev_opts, examine_queue_depth),
+		spdk_json_decode_uint32, true
+	},
 };
 
 static void
@@ -50,6 +60,8 @@ rpc_bdev_set_options(struct spdk_jsonrpc_request *request, const struct spdk_jso
 	rpc_opts.bdev_io_cache_size = UINT32_MAX;
 	rpc_opts.small_buf_pool_size = UINT32_MAX;
 	rpc_opts.large_buf_pool_size = UINT32_MAX;
+	rpc_opts.accel_copy_threshold = UINT32_MAX;
+	rpc_opts.examine_queue_depth = UINT32_MAX;
 	rpc_opts.bdev_auto_examine = true;
 
 	if (params != NULL) {
@@ -76,6 +88,12 @@ rpc_bdev_set_options(struct spdk_jsonrpc_request *request, const struct spdk_jso
 	if (rpc_opts.large_buf_pool_size != UINT32_MAX) {
 		bdev_opts.large_buf_pool_size = rpc_opts.large_buf_pool_size;
 	}
+	if (rpc_opts.accel_copy_threshold != UINT32_MAX) {
+		bdev_opts.accel_copy_threshold = rpc_opts.accel_copy_threshold;
+	}
+	if (rpc_opts.examine_queue_depth != UINT32_MAX) {
+		bdev_opts.examine_queue_depth = rpc_opts.examine_queue_depth;
+	}
 
 	rc = spdk_bdev_set_opts(&bdev_opts);
 
@@ -656,75 +674,68 @@ rpc_bdev_reset_iostat(struct spdk_jsonrpc_request *request, const struct spdk_js
 }
 SPDK_RPC_REGISTER("bdev_reset_iostat", rpc_bdev_reset_iostat, SPDK_RPC_RUNTIME)
 
+#define RPC_BDEV_GET_BDEVS_MAX_FIELDS 32
+
+struct rpc_bdev_fields {
+	size_t	num_fields;
+	char	*fields[RPC_BDEV_GET_BDEVS_MAX_FIELDS];
+};
+
 static int
-rpc_dump_bdev_info(void *ctx, struct spdk_bdev *bdev)
+rpc_decode_bdev_field(const struct spdk_json_val *val, void *out)
 {
-	struct spdk_json_write_ctx *w = ctx;
-	struct spdk_bdev_alias *tmp;
-	uint64_t qos_limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
-	struct spdk_memory_domain **domains;
-	char uuid_str[SPDK_UUID_STRING_LEN];
-	int i, rc;
+	return spdk_json_decode_string(val, out);
+}
 
-	spdk_json_write_object_begin(w);
+static int
+rpc_decode_bdev_fields(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_bdev_fields *fields = out;
 
-	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(bdev));
+	return spdk_json_decode_array(val, rpc_decode_bdev_field, fields->fields,
+				      RPC_BDEV_GET_BDEVS_MAX_FIELDS, &fields->num_fields, sizeof(char *));
+}
 
-	spdk_json_write_named_array_begin(w, "aliases");
+static void
+free_rpc_bdev_fields(struct rpc_bdev_fields *fields)
+{
+	size_t i;
 
-	TAILQ_FOREACH(tmp, spdk_bdev_get_aliases(bdev), tailq) {
-		spdk_json_write_string(w, tmp->alias.name);
+	for (i = 0; i < fields->num_fields; i++) {
+		free(fields->fields[i]);
 	}
+}
 
-	spdk_json_write_array_end(w);
-
-	spdk_json_write_named_string(w, "product_name", spdk_bdev_get_product_name(bdev));
-
-	spdk_json_write_named_uint32(w, "block_size", spdk_bdev_get_block_size(bdev));
-
-	spdk_json_write_named_uint64(w, "num_blocks", spdk_bdev_get_num_blocks(bdev));
-
-	spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &bdev->uuid);
-	spdk_json_write_named_string(w, "uuid", uuid_str);
+struct rpc_dump_bdev_ctx {
+	struct spdk_json_write_ctx	*w;
+	const struct rpc_bdev_fields	*fields;
+	uint64_t			max_count;
+	uint64_t			count;
+};
 
-	if (spdk_bdev_get_md_size(bdev) != 0) {
-		spdk_json_write_named_uint32(w, "md_size", spdk_bdev_get_md_size(bdev));
-		spdk_json_write_named_bool(w, "md_interleave", spdk_bdev_is_md_interleaved(bdev));
-		spdk_json_write_named_uint32(w, "dif_type", spdk_bdev_get_dif_type(bdev));
-		if (spdk_bdev_get_dif_type(bdev) != SPDK_DIF_DISABLE) {
-			spdk_json_write_named_bool(w, "dif_is_head_of_md", spdk_bdev_is_dif_head_of_md(bdev));
-			spdk_json_write_named_object_begin(w, "enabled_dif_check_types");
-			spdk_json_write_named_bool(w, "reftag",
-						   spdk_bdev_is_dif_check_enabled(bdev, SPDK_DIF_CHECK_TYPE_REFTAG));
-			spdk_json_write_named_bool(w, "apptag",
-						   spdk_bdev_is_dif_check_enabled(bdev, SPDK_DIF_CHECK_TYPE_APPTAG));
-			spdk_json_write_named_bool(w, "guard",
-						   spdk_bdev_is_dif_check_enabled(bdev, SPDK_DIF_CHECK_TYPE_GUARD));
-			spdk_json_write_object_end(w);
-		}
-	}
+/* Returns true if the key should be included in the output, i.e. no fields were requested
+ * or the key is one of them */
+static bool
+rpc_dump_bdev_field(struct rpc_dump_bdev_ctx *ctx, const char *key)
+{
+	size_t i;
 
-	spdk_json_write_named_object_begin(w, "assigned_rate_limits");
-	spdk_bdev_get_qos_rate_limits(bdev, qos_limits);
-	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
-		spdk_json_write_named_uint64(w, spdk_bdev_get_qos_rpc_type(i), qos_limits[i]);
+	if (ctx->fields == NULL || ctx->fields->num_fields == 0) {
+		return true;
 	}
-	spdk_json_write_object_end(w);
 
-	spdk_json_write_named_bool(w, "claimed",
-				   (bdev->internal.claim_type != SPDK_BDEV_CLAIM_NONE));
-	if (bdev->internal.claim_type != SPDK_BDEV_CLAIM_NONE) {
-		spdk_json_write_named_string(w, "claim_type",
-					     spdk_bdev_claim_get_name(bdev->internal.claim_type));
+	for (i = 0; i < ctx->fields->num_fields; i++) {
+		if (strcmp(ctx->fields->fields[i], key) == 0) {
+			return true;
+		}
 	}
 
-	spdk_json_write_named_bool(w, "zoned", bdev->zoned);
-	if (bdev->zoned) {
-		spdk_json_write_named_uint64(w, "zone_size", bdev->zone_size);
-		spdk_json_write_named_uint64(w, "max_open_zones", bdev->max_open_zones);
-		spdk_json_write_named_uint64(w, "optimal_open_zones", bdev->optimal_open_zones);
-	}
+	return false;
+}
 
+static void
+rpc_dump_bdev_io_types(struct spdk_json_write_ctx *w, struct spdk_bdev *bdev)
+{
 	spdk_json_write_named_object_begin(w, "supported_io_types");
 	spdk_json_write_named_bool(w, "read",
 				   spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_READ));
@@ -749,6 +760,13 @@ rpc_dump_bdev_info(void *ctx, struct spdk_bdev *bdev)
 	spdk_json_write_named_bool(w, "nvme_io",
 				   spdk_bdev_io_type_supported(bdev, SPDK_BDEV_IO_TYPE_NVME_IO));
 	spdk_json_write_object_end(w);
+}
+
+static void
+rpc_dump_bdev_memory_domains(struct spdk_json_write_ctx *w, struct spdk_bdev *bdev)
+{
+	struct spdk_memory_domain **domains;
+	int i, rc;
 
 	rc = spdk_bdev_get_memory_domains(bdev, NULL, 0);
 	if (rc > 0) {
@@ -774,10 +792,112 @@ rpc_dump_bdev_info(void *ctx, struct spdk_bdev *bdev)
 			SPDK_ERRLOG("Memory allocation failed\n");
 		}
 	}
+}
 
-	spdk_json_write_named_object_begin(w, "driver_specific");
-	spdk_bdev_dump_info_json(bdev, w);
-	spdk_json_write_object_end(w);
+static int
+rpc_dump_bdev_info(void *_ctx, struct spdk_bdev *bdev)
+{
+	struct rpc_dump_bdev_ctx *ctx = _ctx;
+	struct spdk_json_write_ctx *w = ctx->w;
+	struct spdk_bdev_alias *tmp;
+	uint64_t qos_limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+	char uuid_str[SPDK_UUID_STRING_LEN];
+	int i;
+
+	if (ctx->max_count != 0 && ctx->count == ctx->max_count) {
+		/* Positive value stops the iteration without reporting an error */
+		return 1;
+	}
+	ctx->count++;
+
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(bdev));
+
+	if (rpc_dump_bdev_field(ctx, "aliases")) {
+		spdk_json_write_named_array_begin(w, "aliases");
+
+		TAILQ_FOREACH(tmp, spdk_bdev_get_aliases(bdev), tailq) {
+			spdk_json_write_string(w, tmp->alias.name);
+		}
+
+		spdk_json_write_array_end(w);
+	}
+
+	if (rpc_dump_bdev_field(ctx, "product_name")) {
+		spdk_json_write_named_string(w, "product_name", spdk_bdev_get_product_name(bdev));
+	}
+
+	if (rpc_dump_bdev_field(ctx, "block_size")) {
+		spdk_json_write_named_uint32(w, "block_size", spdk_bdev_get_block_size(bdev));
+	}
+
+	if (rpc_dump_bdev_field(ctx, "num_blocks")) {
+		spdk_json_write_named_uint64(w, "num_blocks", spdk_bdev_get_num_blocks(bdev));
+	}
+
+	if (rpc_dump_bdev_field(ctx, "uuid")) {
+		spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &bdev->uuid);
+		spdk_json_write_named_string(w, "uuid", uuid_str);
+	}
+
+	if (spdk_bdev_get_md_size(bdev) != 0 && rpc_dump_bdev_field(ctx, "md_size")) {
+		spdk_json_write_named_uint32(w, "md_size", spdk_bdev_get_md_size(bdev));
+		spdk_json_write_named_bool(w, "md_interleave", spdk_bdev_is_md_interleaved(bdev));
+		spdk_json_write_named_uint32(w, "dif_type", spdk_bdev_get_dif_type(bdev));
+		if (spdk_bdev_get_dif_type(bdev) != SPDK_DIF_DISABLE) {
+			spdk_json_write_named_bool(w, "dif_is_head_of_md", spdk_bdev_is_dif_head_of_md(bdev));
+			spdk_json_write_named_object_begin(w, "enabled_dif_check_types");
+			spdk_json_write_named_bool(w, "reftag",
+						   spdk_bdev_is_dif_check_enabled(bdev, SPDK_DIF_CHECK_TYPE_REFTAG));
+			spdk_json_write_named_bool(w, "apptag",
+						   spdk_bdev_is_dif_check_enabled(bdev, SPDK_DIF_CHECK_TYPE_APPTAG));
+			spdk_json_write_named_bool(w, "guard",
+						   spdk_bdev_is_dif_check_enabled(bdev, SPDK_DIF_CHECK_TYPE_GUARD));
+			spdk_json_write_object_end(w);
+		}
+	}
+
+	if (rpc_dump_bdev_field(ctx, "assigned_rate_limits")) {
+		spdk_json_write_named_object_begin(w, "assigned_rate_limits");
+		spdk_bdev_get_qos_rate_limits(bdev, qos_limits);
+		for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+			spdk_json_write_named_uint64(w, spdk_bdev_get_qos_rpc_type(i), qos_limits[i]);
+		}
+		spdk_json_write_object_end(w);
+	}
+
+	if (rpc_dump_bdev_field(ctx, "claimed")) {
+		spdk_json_write_named_bool(w, "claimed",
+					   (bdev->internal.claim_type != SPDK_BDEV_CLAIM_NONE));
+		if (bdev->internal.claim_type != SPDK_BDEV_CLAIM_NONE) {
+			spdk_json_write_named_string(w, "claim_type",
+						     spdk_bdev_claim_get_name(bdev->internal.claim_type));
+		}
+	}
+
+	if (rpc_dump_bdev_field(ctx, "zoned")) {
+		spdk_json_write_named_bool(w, "zoned", bdev->zoned);
+		if (bdev->zoned) {
+			spdk_json_write_named_uint64(w, "zone_size", bdev->zone_size);
+			spdk_json_write_named_uint64(w, "max_open_zones", bdev->max_open_zones);
+			spdk_json_write_named_uint64(w, "optimal_open_zones", bdev->optimal_open_zones);
+		}
+	}
+
+	if (rpc_dump_bdev_field(ctx, "supported_io_types")) {
+		rpc_dump_bdev_io_types(w, bdev);
+	}
+
+	if (rpc_dump_bdev_field(ctx, "memory_domains")) {
+		rpc_dump_bdev_memory_domains(w, bdev);
+	}
+
+	if (rpc_dump_bdev_field(ctx, "driver_specific")) {
+		spdk_json_write_named_object_begin(w, "driver_specific");
+		spdk_bdev_dump_info_json(bdev, w);
+		spdk_json_write_object_end(w);
+	}
 
 	spdk_json_write_object_end(w);
 
@@ -785,8 +905,11 @@ rpc_dump_bdev_info(void *ctx, struct spdk_bdev *bdev)
 }
 
 struct rpc_bdev_get_bdevs {
-	char		*name;
-	uint64_t	timeout;
+	char			*name;
+	uint64_t		timeout;
+	char			*start_after;
+	uint64_t		max_count;
+	struct rpc_bdev_fields	fields;
 };
 
 struct rpc_bdev_get_bdevs_ctx {
@@ -800,18 +923,23 @@ static void
 free_rpc_bdev_get_bdevs(struct rpc_bdev_get_bdevs *r)
 {
 	free(r->name);
+	free(r->start_after);
+	free_rpc_bdev_fields(&r->fields);
 }
 
 static const struct spdk_json_object_decoder rpc_bdev_get_bdevs_decoders[] = {
 	{"name", offsetof(struct rpc_bdev_get_bdevs, name), spdk_json_decode_string, true},
 	{"timeout", offsetof(struct rpc_bdev_get_bdevs, timeout), spdk_json_decode_uint64, true},
+	{"start_after", offsetof(struct rpc_bdev_get_bdevs, start_after), spdk_json_decode_string, true},
+	{"max_count", offsetof(struct rpc_bdev_get_bdevs, max_count), spdk_json_decode_uint64, true},
+	{"fields", offsetof(struct rpc_bdev_get_bdevs, fields), rpc_decode_bdev_fields, true},
 };
 
 static int
 get_bdevs_poller(void *_ctx)
 {
 	struct rpc_bdev_get_bdevs_ctx *ctx = _ctx;
-	struct spdk_json_write_ctx *w;
+	struct rpc_dump_bdev_ctx dump_ctx = { .fields = &ctx->rpc.fields };
 	struct spdk_bdev_desc *desc;
 	int rc;
 
@@ -824,11 +952,11 @@ get_bdevs_poller(void *_ctx)
 		SPDK_ERRLOG("Timed out while waiting for bdev '%s' to appear\n", ctx->rpc.name);
 		spdk_jsonrpc_send_error_response(ctx->request, -ENODEV, spdk_strerror(ENODEV));
 	} else {
-		w = spdk_jsonrpc_begin_result(ctx->request);
-		spdk_json_write_array_begin(w);
-		rpc_dump_bdev_info(w, spdk_bdev_desc_get_bdev(desc));
-		spdk_json_write_array_end(w);
-		spdk_jsonrpc_end_result(ctx->request, w);
+		dump_ctx.w = spdk_jsonrpc_begin_result(ctx->request);
+		spdk_json_write_array_begin(dump_ctx.w);
+		rpc_dump_bdev_info(&dump_ctx, spdk_bdev_desc_get_bdev(desc));
+		spdk_json_write_array_end(dump_ctx.w);
+		spdk_jsonrpc_end_result(ctx->request, dump_ctx.w);
 
 		spdk_bdev_close(desc);
 	}
@@ -846,7 +974,7 @@ rpc_bdev_get_bdevs(struct spdk_jsonrpc_request *request,
 {
 	struct rpc_bdev_get_bdevs req = {};
 	struct rpc_bdev_get_bdevs_ctx *ctx;
-	struct spdk_json_write_ctx *w;
+	struct rpc_dump_bdev_ctx dump_ctx = {};
 	struct spdk_bdev_desc *desc = NULL;
 	int rc;
 
@@ -860,6 +988,14 @@ rpc_bdev_get_bdevs(struct spdk_jsonrpc_request *request,
 		return;
 	}
 
+	if (req.name && (req.start_after || req.max_count)) {
+		SPDK_ERRLOG("name cannot be combined with start_after or max_count\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "name cannot be combined with start_after or max_count");
+		free_rpc_bdev_get_bdevs(&req);
+		return;
+	}
+
 	if (req.name) {
 		rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
 		if (rc != 0) {
@@ -895,20 +1031,29 @@ rpc_bdev_get_bdevs(struct spdk_jsonrpc_request *request,
 		}
 	}
 
-	free_rpc_bdev_get_bdevs(&req);
-	w = spdk_jsonrpc_begin_result(request);
-	spdk_json_write_array_begin(w);
+	if (req.start_after && spdk_bdev_get_by_name(req.start_after) == NULL) {
+		SPDK_ERRLOG("bdev '%s' does not exist\n", req.start_after);
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		free_rpc_bdev_get_bdevs(&req);
+		return;
+	}
+
+	dump_ctx.fields = &req.fields;
+	dump_ctx.max_count = req.max_count;
+	dump_ctx.w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_array_begin(dump_ctx.w);
 
 	if (desc != NULL) {
-		rpc_dump_bdev_info(w, spdk_bdev_desc_get_bdev(desc));
+		rpc_dump_bdev_info(&dump_ctx, spdk_bdev_desc_get_bdev(desc));
 		spdk_bdev_close(desc);
 	} else {
-		spdk_for_each_bdev(w, rpc_dump_bdev_info);
+		bdev_for_each_bdev_after(req.start_after, &dump_ctx, rpc_dump_bdev_info);
 	}
 
-	spdk_json_write_array_end(w);
+	spdk_json_write_array_end(dump_ctx.w);
 
-	spdk_jsonrpc_end_result(request, w);
+	spdk_jsonrpc_end_result(request, dump_ctx.w);
+	free_rpc_bdev_get_bdevs(&req);
 }
 SPDK_RPC_REGISTER("bdev_get_bdevs", rpc_bdev_get_bdevs, SPDK_RPC_RUNTIME)
 
@@ -965,9 +1110,15 @@ SPDK_RPC_REGISTER("bdev_set_qd_sampling_period",
 		  rpc_bdev_set_qd_sampling_period,
 		  SPDK_RPC_RUNTIME)
 
+struct rpc_bdev_qos_sharded {
+	bool	value;
+	bool	set;
+};
+
 struct rpc_bdev_set_qos_limit {
-	char		*name;
-	uint64_t	limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+	char				*name;
+	uint64_t			limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+	struct rpc_bdev_qos_sharded	sharded;
 };
 
 static void
@@ -976,6 +1127,17 @@ free_rpc_bdev_set_qos_limit(struct rpc_bdev_set_qos_limit *r)
 	free(r->name);
 }
 
+static int
+decode_qos_sharded(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_bdev_qos_sharded *sharded = out;
+
+	/* Only change the QoS mode when explicitly requested. */
+	sharded->set = true;
+
+	return spdk_json_decode_bool(val, &sharded->value);
+}
+
 static const struct spdk_json_object_decoder rpc_bdev_set_qos_limit_decoders[] = {
 	{"name", offsetof(struct rpc_bdev_set_qos_limit, name), spdk_json_decode_string},
 	{
@@ -998,6 +1160,7 @@ static const struct spdk_json_object_decoder rpc_bdev_set_qos_limit_decoders[] =
 					     limits[SPDK_BDEV_QOS_W_BPS_RATE_LIMIT]),
 		spdk_json_decode_uint64, true
 	},
+	{"sharded", offsetof(struct rpc_bdev_set_qos_limit, sharded), decode_qos_sharded, true},
 };
 
 static void
@@ -1051,6 +1214,18 @@ rpc_bdev_set_qos_limit(struct spdk_jsonrpc_request *request,
 		goto cleanup;
 	}
 
+	if (req.sharded.set) {
+		rc = spdk_bdev_set_qos_sharded(spdk_bdev_desc_get_bdev(desc), req.sharded.value);
+		if (rc != 0) {
+			spdk_bdev_close(desc);
+			spdk_jsonrpc_send_error_response_fmt(request,
+							     SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+							     "Failed to set QoS mode: %s",
+							     spdk_strerror(-rc));
+			goto cleanup;
+		}
+	}
+
 	spdk_bdev_set_qos_rate_limits(spdk_bdev_desc_get_bdev(desc), req.limits,
 				      rpc_bdev_set_qos_limit_complete, request);
 
@@ -1062,6 +1237,151 @@ cleanup:
 
 SPDK_RPC_REGISTER("bdev_set_qos_limit", rpc_bdev_set_qos_limit, SPDK_RPC_RUNTIME)
 
+struct rpc_bdev_set_qos_latency_target {
+	char		*name;
+	char		*group;
+	uint64_t	latency_target_us;
+};
+
+static void
+free_rpc_bdev_set_qos_latency_target(struct rpc_bdev_set_qos_latency_target *r)
+{
+	free(r->name);
+	free(r->group);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_set_qos_latency_target_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_set_qos_latency_target, name), spdk_json_decode_string},
+	{"group", offsetof(struct rpc_bdev_set_qos_latency_target, group), spdk_json_decode_string, true},
+	{
+		"latency_target_us", offsetof(struct rpc_bdev_set_qos_latency_target, latency_target_us),
+		spdk_json_decode_uint64, true
+	},
+};
+
+static void
+rpc_bdev_set_qos_latency_target_complete(void *cb_arg, int status)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response_fmt(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						     "Failed to configure latency target: %s",
+						     spdk_strerror(-status));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+
+static void
+rpc_bdev_set_qos_latency_target(struct spdk_jsonrpc_request *request,
+				const struct spdk_json_val *params)
+{
+	struct rpc_bdev_set_qos_latency_target req = {};
+	struct spdk_bdev_desc *desc;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_set_qos_latency_target_decoders,
+				    SPDK_COUNTOF(rpc_bdev_set_qos_latency_target_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	if (req.group == NULL && req.latency_target_us != 0) {
+		spdk_jsonrpc_send_error_response(request, -EINVAL,
+						 "A latency target requires a group");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to open bdev '%s': %d\n", req.name, rc);
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bdev_set_qos_latency_target(spdk_bdev_desc_get_bdev(desc), req.group,
+					 req.latency_target_us,
+					 rpc_bdev_set_qos_latency_target_complete, request);
+
+	spdk_bdev_close(desc);
+
+cleanup:
+	free_rpc_bdev_set_qos_latency_target(&req);
+}
+SPDK_RPC_REGISTER("bdev_set_qos_latency_target", rpc_bdev_set_qos_latency_target,
+		  SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_set_io_coalescing {
+	char		*name;
+	uint32_t	window_us;
+	uint32_t	max_blocks;
+};
+
+static const struct spdk_json_object_decoder rpc_bdev_set_io_coalescing_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_set_io_coalescing, name), spdk_json_decode_string},
+	{"window_us", offsetof(struct rpc_bdev_set_io_coalescing, window_us), spdk_json_decode_uint32},
+	{
+		"max_blocks", offsetof(struct rpc_bdev_set_io_coalescing, max_blocks),
+		spdk_json_decode_uint32, true
+	},
+};
+
+static void
+rpc_bdev_set_io_coalescing_complete(void *cb_arg, int status)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response_fmt(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						     "Failed to configure I/O coalescing: %s",
+						     spdk_strerror(-status));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+
+static void
+rpc_bdev_set_io_coalescing(struct spdk_jsonrpc_request *request,
+			   const struct spdk_json_val *params)
+{
+	struct rpc_bdev_set_io_coalescing req = {
+		.max_blocks = 128,
+	};
+	struct spdk_bdev_desc *desc;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_set_io_coalescing_decoders,
+				    SPDK_COUNTOF(rpc_bdev_set_io_coalescing_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to open bdev '%s': %d\n", req.name, rc);
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bdev_set_io_coalescing(spdk_bdev_desc_get_bdev(desc), req.window_us, req.max_blocks,
+				    rpc_bdev_set_io_coalescing_complete, request);
+
+	spdk_bdev_close(desc);
+
+cleanup:
+	free(req.name);
+}
+SPDK_RPC_REGISTER("bdev_set_io_coalescing", rpc_bdev_set_io_coalescing, SPDK_RPC_RUNTIME)
+
 /* SPDK_RPC_ENABLE_BDEV_HISTOGRAM */
 
 struct rpc_bdev_enable_histogram_request {
@@ -1230,3 +1550,261 @@ cleanup:
 }
 
 SPDK_RPC_REGISTER("bdev_get_histogram", rpc_bdev_get_histogram, SPDK_RPC_RUNTIME)
+
+static void
+rpc_bdev_enable_type_histograms(struct spdk_jsonrpc_request *request,
+				const struct spdk_json_val *params)
+{
+	struct rpc_bdev_enable_histogram_request req = {NULL};
+	struct spdk_bdev_desc *desc;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_enable_histogram_request_decoders,
+				    SPDK_COUNTOF(rpc_bdev_enable_histogram_request_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &desc);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_bdev_type_histograms_enable(spdk_bdev_desc_get_bdev(desc), bdev_histogram_status_cb,
+					 request, req.enable);
+
+	spdk_bdev_close(desc);
+
+cleanup:
+	free_rpc_bdev_enable_histogram_request(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_enable_type_histograms", rpc_bdev_enable_type_histograms,
+		  SPDK_RPC_RUNTIME)
+
+static const char *const g_rpc_bdev_io_type_names[SPDK_BDEV_NUM_IO_TYPES] = {
+	[SPDK_BDEV_IO_TYPE_INVALID]		= "invalid",
+	[SPDK_BDEV_IO_TYPE_READ]		= "read",
+	[SPDK_BDEV_IO_TYPE_WRITE]		= "write",
+	[SPDK_BDEV_IO_TYPE_UNMAP]		= "unmap",
+	[SPDK_BDEV_IO_TYPE_FLUSH]		= "flush",
+	[SPDK_BDEV_IO_TYPE_RESET]		= "reset",
+	[SPDK_BDEV_IO_TYPE_NVME_ADMIN]		= "nvme_admin",
+	[SPDK_BDEV_IO_TYPE_NVME_IO]		= "nvme_io",
+	[SPDK_BDEV_IO_TYPE_NVME_IO_MD]		= "nvme_io_md",
+	[SPDK_BDEV_IO_TYPE_WRITE_ZEROES]	= "write_zeroes",
+	[SPDK_BDEV_IO_TYPE_ZCOPY]		= "zcopy",
+	[SPDK_BDEV_IO_TYPE_GET_ZONE_INFO]	= "get_zone_info",
+	[SPDK_BDEV_IO_TYPE_ZONE_MANAGEMENT]	= "zone_management",
+	[SPDK_BDEV_IO_TYPE_ZONE_APPEND]		= "zone_append",
+	[SPDK_BDEV_IO_TYPE_COMPARE]		= "compare",
+	[SPDK_BDEV_IO_TYPE_COMPARE_AND_WRITE]	= "compare_and_write",
+	[SPDK_BDEV_IO_TYPE_ABORT]		= "abort",
+	[SPDK_BDEV_IO_TYPE_SEEK_HOLE]		= "seek_hole",
+	[SPDK_BDEV_IO_TYPE_SEEK_DATA]		= "seek_data",
+	[SPDK_BDEV_IO_TYPE_COPY]		= "copy",
+};
+
+static void
+rpc_dump_type_histograms(struct spdk_json_write_ctx *w,
+			 const struct spdk_bdev_type_histograms *histograms)
+{
+	struct spdk_histogram_data *histogram;
+	char *encoded_histogram;
+	size_t src_len, dst_len;
+	uint64_t max_size;
+	int type, bucket, rc;
+
+	spdk_json_write_named_array_begin(w, "histograms");
+	for (type = 0; type < SPDK_BDEV_NUM_IO_TYPES; type++) {
+		for (bucket = 0; bucket < SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS; bucket++) {
+			histogram = histograms->histogram[type][bucket];
+			if (histogram == NULL) {
+				continue;
+			}
+
+			src_len = SPDK_HISTOGRAM_NUM_BUCKETS(histogram) * sizeof(uint64_t);
+			dst_len = spdk_base64_get_encoded_strlen(src_len) + 1;
+
+			encoded_histogram = malloc(dst_len);
+			if (encoded_histogram == NULL) {
+				SPDK_ERRLOG("Failed to allocate the encoded histogram\n");
+				continue;
+			}
+
+			rc = spdk_base64_encode(encoded_histogram, histogram->bucket, src_len);
+			if (rc != 0) {
+				SPDK_ERRLOG("Failed to encode the histogram: %s\n",
+					    spdk_strerror(-rc));
+				free(encoded_histogram);
+				continue;
+			}
+
+			spdk_json_write_object_begin(w);
+			spdk_json_write_named_string(w, "io_type", g_rpc_bdev_io_type_names[type]);
+			spdk_json_write_named_uint32(w, "size_bucket", bucket);
+			/* The last bucket has no upper bound */
+			if (bucket < SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS - 1) {
+				max_size = 1ULL << (SPDK_BDEV_HISTOGRAM_SIZE_BUCKET_SHIFT + bucket);
+				spdk_json_write_named_uint64(w, "max_size", max_size);
+			}
+			spdk_json_write_named_int64(w, "bucket_shift", histogram->bucket_shift);
+			spdk_json_write_named_string(w, "histogram", encoded_histogram);
+			spdk_json_write_object_end(w);
+
+			free(encoded_histogram);
+		}
+	}
+	spdk_json_write_array_end(w);
+}
+
+struct rpc_bdev_get_type_histograms {
+	char *name;
+	bool per_channel;
+	bool reset;
+};
+
+static const struct spdk_json_object_decoder rpc_bdev_get_type_histograms_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_get_type_histograms, name), spdk_json_decode_string},
+	{
+		"per_channel", offsetof(struct rpc_bdev_get_type_histograms, per_channel),
+		spdk_json_decode_bool, true
+	},
+	{"reset", offsetof(struct rpc_bdev_get_type_histograms, reset), spdk_json_decode_bool, true},
+};
+
+struct rpc_bdev_type_histograms_ctx {
+	struct spdk_jsonrpc_request *request;
+	struct spdk_json_write_ctx *w;
+	struct spdk_bdev_desc *desc;
+	bool reset;
+};
+
+static void
+rpc_bdev_type_histograms_cb(void *cb_arg, int status, struct spdk_bdev_type_histograms *histograms)
+{
+	struct rpc_bdev_type_histograms_ctx *ctx = cb_arg;
+	struct spdk_json_write_ctx *w;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(-status));
+		goto done;
+	}
+
+	w = spdk_jsonrpc_begin_result(ctx->request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_int64(w, "tsc_rate", spdk_get_ticks_hz());
+	rpc_dump_type_histograms(w, histograms);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(ctx->request, w);
+
+done:
+	spdk_bdev_close(ctx->desc);
+	free(ctx);
+}
+
+static void
+rpc_bdev_channel_type_histograms_cb(void *cb_arg, int status,
+				    struct spdk_bdev_type_histograms *histograms)
+{
+	struct rpc_bdev_type_histograms_ctx *ctx = cb_arg;
+	struct spdk_json_write_ctx *w = ctx->w;
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "thread_id", spdk_thread_get_id(spdk_get_thread()));
+	/* The histograms may have failed to be allocated for that channel */
+	if (status == 0) {
+		rpc_dump_type_histograms(w, histograms);
+	}
+	spdk_json_write_object_end(w);
+}
+
+static void
+rpc_bdev_get_per_channel_type_histograms(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
+		struct spdk_io_channel *ch, void *_ctx)
+{
+	struct rpc_bdev_type_histograms_ctx *ctx = _ctx;
+
+	spdk_bdev_channel_get_type_histograms(ch, ctx->reset, rpc_bdev_channel_type_histograms_cb,
+					      ctx);
+
+	spdk_bdev_for_each_channel_continue(i, 0);
+}
+
+static void
+rpc_bdev_get_per_channel_type_histograms_done(struct spdk_bdev *bdev, void *_ctx, int status)
+{
+	struct rpc_bdev_type_histograms_ctx *ctx = _ctx;
+
+	spdk_json_write_array_end(ctx->w);
+	spdk_json_write_object_end(ctx->w);
+	spdk_jsonrpc_end_result(ctx->request, ctx->w);
+
+	spdk_bdev_close(ctx->desc);
+	free(ctx);
+}
+
+static void
+rpc_bdev_get_type_histograms(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct rpc_bdev_get_type_histograms req = {NULL};
+	struct rpc_bdev_type_histograms_ctx *ctx;
+	struct spdk_bdev *bdev;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_get_type_histograms_decoders,
+				    SPDK_COUNTOF(rpc_bdev_get_type_histograms_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(ENOMEM));
+		goto cleanup;
+	}
+
+	rc = spdk_bdev_open_ext(req.name, false, dummy_bdev_event_cb, NULL, &ctx->desc);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		free(ctx);
+		goto cleanup;
+	}
+
+	bdev = spdk_bdev_desc_get_bdev(ctx->desc);
+	if (!bdev->internal.type_histograms_enabled) {
+		spdk_jsonrpc_send_error_response(request, -EINVAL,
+						 "Per-type histograms are not enabled");
+		spdk_bdev_close(ctx->desc);
+		free(ctx);
+		goto cleanup;
+	}
+
+	ctx->request = request;
+	ctx->reset = req.reset;
+
+	if (req.per_channel) {
+		ctx->w = spdk_jsonrpc_begin_result(request);
+		spdk_json_write_object_begin(ctx->w);
+		spdk_json_write_named_int64(ctx->w, "tsc_rate", spdk_get_ticks_hz());
+		spdk_json_write_named_array_begin(ctx->w, "channels");
+
+		spdk_bdev_for_each_channel(bdev, rpc_bdev_get_per_channel_type_histograms, ctx,
+					   rpc_bdev_get_per_channel_type_histograms_done);
+	} else {
+		spdk_bdev_type_histograms_get(bdev, req.reset, rpc_bdev_type_histograms_cb, ctx);
+	}
+
+cleanup:
+	free(req.name);
+}
+
+SPDK_RPC_REGISTER("bdev_get_type_histograms", rpc_bdev_get_type_histograms, SPDK_RPC_RUNTIME)
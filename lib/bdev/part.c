@@ -254,10 +254,6 @@ bdev_part_complete_io(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 			}
 		}
 		break;
-	case SPDK_BDEV_IO_TYPE_ZCOPY:
-		spdk_bdev_io_set_buf(part_io, bdev_io->u.bdev.iovs[0].iov_base,
-				     bdev_io->u.bdev.iovs[0].iov_len);
-		break;
 	default:
 		break;
 	}
@@ -341,9 +337,7 @@ spdk_bdev_part_submit_request_ext(struct spdk_bdev_part_channel *ch, struct spdk
 				     bdev_part_complete_io, bdev_io);
 		break;
 	case SPDK_BDEV_IO_TYPE_ZCOPY:
-		rc = spdk_bdev_zcopy_start(base_desc, base_ch, NULL, 0, remapped_offset,
-					   bdev_io->u.bdev.num_blocks, bdev_io->u.bdev.zcopy.populate,
-					   bdev_part_complete_io, bdev_io);
+		rc = spdk_bdev_io_zcopy_forward(bdev_io, base_desc, base_ch, remapped_offset);
 		break;
 	case SPDK_BDEV_IO_TYPE_COMPARE:
 		if (!bdev_io->u.bdev.md_buf) {
@@ -134,6 +134,24 @@ bs_claim_cluster(struct spdk_blob_store *bs)
 	return cluster_num;
 }
 
+static int
+bs_claim_cluster_at(struct spdk_blob_store *bs, uint32_t cluster_num)
+{
+	int rc;
+
+	assert(spdk_spin_held(&bs->used_lock));
+
+	rc = spdk_bit_pool_allocate_bit_at(bs->used_clusters, cluster_num);
+	if (rc != 0) {
+		return rc;
+	}
+
+	SPDK_DEBUGLOG(blob, "Claiming cluster %u\n", cluster_num);
+	bs->num_free_clusters--;
+
+	return 0;
+}
+
 static void
 bs_release_cluster(struct spdk_blob_store *bs, uint32_t cluster_num)
 {
@@ -148,6 +166,106 @@ bs_release_cluster(struct spdk_blob_store *bs, uint32_t cluster_num)
 	bs->num_free_clusters++;
 }
 
+/*
+ * Claim a batch of clusters for the channel, so that thin provisioned allocations on it don't
+ * need used_lock. The last SPDK_BS_CLUSTER_SLAB_SIZE free clusters are never put in a slab, so
+ * when the blobstore is nearly full the clusters are claimed one at a time instead.
+ */
+static void
+bs_channel_refill_cluster_slab(struct spdk_bs_channel *ch)
+{
+	struct spdk_blob_store *bs = ch->bs;
+	uint32_t cluster_num;
+
+	assert(ch->cluster_slab_head == ch->cluster_slab_cnt);
+	ch->cluster_slab_head = 0;
+	ch->cluster_slab_cnt = 0;
+
+	spdk_spin_lock(&bs->used_lock);
+	while (ch->cluster_slab_cnt < SPDK_BS_CLUSTER_SLAB_SIZE &&
+	       bs->num_free_clusters > SPDK_BS_CLUSTER_SLAB_SIZE) {
+		cluster_num = bs_claim_cluster(bs);
+		assert(cluster_num != UINT32_MAX);
+		ch->cluster_slab[ch->cluster_slab_cnt++] = cluster_num;
+	}
+	__atomic_add_fetch(&bs->num_slab_clusters, ch->cluster_slab_cnt, __ATOMIC_RELAXED);
+	spdk_spin_unlock(&bs->used_lock);
+}
+
+static void
+bs_channel_release_cluster_slab(struct spdk_bs_channel *ch)
+{
+	struct spdk_blob_store *bs = ch->bs;
+	uint32_t count = ch->cluster_slab_cnt - ch->cluster_slab_head;
+
+	if (count == 0) {
+		return;
+	}
+
+	spdk_spin_lock(&bs->used_lock);
+	while (ch->cluster_slab_head < ch->cluster_slab_cnt) {
+		bs_release_cluster(bs, ch->cluster_slab[ch->cluster_slab_head++]);
+	}
+	__atomic_sub_fetch(&bs->num_slab_clusters, count, __ATOMIC_RELAXED);
+	spdk_spin_unlock(&bs->used_lock);
+}
+
+struct bs_reclaim_cluster_slabs_ctx {
+	spdk_bs_op_complete	cb_fn;
+	void			*cb_arg;
+};
+
+static void
+bs_reclaim_cluster_slab_channel(struct spdk_io_channel_iter *i)
+{
+	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i);
+
+	bs_channel_release_cluster_slab(spdk_io_channel_get_ctx(_ch));
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+bs_reclaim_cluster_slabs_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct bs_reclaim_cluster_slabs_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	ctx->cb_fn(ctx->cb_arg, status);
+	free(ctx);
+}
+
+/*
+ * Return the clusters held in the slabs of all the channels to the blobstore. A slab is only
+ * accessed from the thread of its channel, so this is done with a message to each of them.
+ */
+static void
+bs_reclaim_cluster_slabs(struct spdk_blob_store *bs, spdk_bs_op_complete cb_fn, void *cb_arg)
+{
+	struct bs_reclaim_cluster_slabs_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	spdk_for_each_channel(bs, bs_reclaim_cluster_slab_channel, ctx,
+			      bs_reclaim_cluster_slabs_done);
+}
+
+/*
+ * Check whether claiming num_clusters requires the clusters held in the slabs of the channels.
+ * The clusters in the slabs aren't free in used_clusters, so a thick provisioned allocation
+ * must reclaim them first.
+ */
+static bool
+bs_cluster_slabs_needed(struct spdk_blob_store *bs, uint64_t num_clusters)
+{
+	return num_clusters > bs->num_free_clusters &&
+	       __atomic_load_n(&bs->num_slab_clusters, __ATOMIC_RELAXED) != 0;
+}
+
 static int
 blob_insert_cluster(struct spdk_blob *blob, uint32_t cluster_num, uint64_t cluster)
 {
@@ -209,6 +327,40 @@ bs_allocate_cluster(struct spdk_blob *blob, uint32_t cluster_num,
 	return 0;
 }
 
+/*
+ * Allocate a cluster for a thin provisioned write issued on the channel. The cluster is taken
+ * from the channel's slab, unless a new extent page is needed too or the slab can't be refilled,
+ * in which case it falls back to bs_allocate_cluster(). Either way the cluster only becomes
+ * persistent once the blob's metadata referencing it is synced.
+ */
+static int
+bs_channel_allocate_cluster(struct spdk_bs_channel *ch, struct spdk_blob *blob,
+			    uint32_t cluster_num, uint64_t *cluster, uint32_t *lowest_free_md_page)
+{
+	struct spdk_blob_store *bs = blob->bs;
+	int rc;
+
+	if (!blob->use_extent_table || *bs_cluster_to_extent_page(blob, cluster_num) != 0) {
+		if (ch->cluster_slab_head == ch->cluster_slab_cnt) {
+			bs_channel_refill_cluster_slab(ch);
+		}
+
+		if (ch->cluster_slab_head < ch->cluster_slab_cnt) {
+			*cluster = ch->cluster_slab[ch->cluster_slab_head++];
+			__atomic_sub_fetch(&bs->num_slab_clusters, 1, __ATOMIC_RELAXED);
+			SPDK_DEBUGLOG(blob, "Claiming cluster %" PRIu64 " for blob 0x%" PRIx64 "\n",
+				      *cluster, blob->id);
+			return 0;
+		}
+	}
+
+	spdk_spin_lock(&bs->used_lock);
+	rc = bs_allocate_cluster(blob, cluster_num, cluster, lowest_free_md_page, false);
+	spdk_spin_unlock(&bs->used_lock);
+
+	return rc;
+}
+
 static void
 blob_xattrs_init(struct spdk_blob_xattr_opts *xattrs)
 {
@@ -1340,12 +1492,16 @@ blob_serialize(const struct spdk_blob *blob, struct spdk_blob_md_page **pages,
 	return rc;
 }
 
+/* Number of extent pages read at once when loading a blob */
+#define BLOB_LOAD_EXTENT_PAGES_BATCH 64
+
 struct spdk_blob_load_ctx {
 	struct spdk_blob		*blob;
 
 	struct spdk_blob_md_page	*pages;
 	uint32_t			num_pages;
 	uint32_t			next_extent_page;
+	uint32_t			last_extent_page;
 	spdk_bs_sequence_t	        *seq;
 
 	spdk_bs_sequence_cpl		cb_fn;
@@ -1448,6 +1604,7 @@ blob_load_esnap(struct spdk_blob *blob, void *blob_ctx)
 			bs_dev->destroy(bs_dev);
 			return -EINVAL;
 		}
+		bs_dev = bs_create_esnap_cache_dev(bs, bs_dev, esnap_id, id_len);
 	}
 
 	blob->back_bs_dev = bs_dev;
@@ -1494,17 +1651,44 @@ blob_load_backing_dev(spdk_bs_sequence_t *seq, void *cb_arg)
 	blob_load_final(ctx, 0);
 }
 
+static int
+blob_load_unallocated_extent_page(struct spdk_blob *blob)
+{
+	void		*tmp;
+	uint64_t	sz;
+
+	/* Thin provisioned blobs can point to unallocated extent pages.
+	 * In this case blob size should be increased by up to the amount left in remaining_clusters_in_et. */
+
+	sz = spdk_min(blob->remaining_clusters_in_et, SPDK_EXTENTS_PER_EP);
+	blob->active.num_clusters += sz;
+	blob->remaining_clusters_in_et -= sz;
+
+	assert(spdk_blob_is_thin_provisioned(blob));
+
+	tmp = realloc(blob->active.clusters, blob->active.num_clusters * sizeof(*blob->active.clusters));
+	if (tmp == NULL) {
+		return -ENOMEM;
+	}
+	memset(tmp + sizeof(*blob->active.clusters) * blob->active.cluster_array_size, 0,
+	       sizeof(*blob->active.clusters) * (blob->active.num_clusters - blob->active.cluster_array_size));
+	blob->active.clusters = tmp;
+	blob->active.cluster_array_size = blob->active.num_clusters;
+
+	return 0;
+}
+
+static void blob_load_extent_pages(spdk_bs_sequence_t *seq, struct spdk_blob_load_ctx *ctx);
+
 static void
 blob_load_cpl_extents_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_blob_load_ctx	*ctx = cb_arg;
 	struct spdk_blob		*blob = ctx->blob;
 	struct spdk_blob_md_page	*page;
-	uint64_t			i;
 	uint32_t			crc;
-	uint64_t			lba;
-	void				*tmp;
-	uint64_t			sz;
+	uint64_t			i;
+	uint32_t			j = 0;
 
 	if (bserrno) {
 		SPDK_ERRLOG("Extent page read failed: %d\n", bserrno);
@@ -1512,18 +1696,20 @@ blob_load_cpl_extents_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		return;
 	}
 
-	if (ctx->pages == NULL) {
-		/* First iteration of this function, allocate buffer for single EXTENT_PAGE */
-		ctx->pages = spdk_zmalloc(SPDK_BS_PAGE_SIZE, 0,
-					  NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-		if (!ctx->pages) {
-			blob_load_final(ctx, -ENOMEM);
-			return;
+	/* Parse the batch in extent table order, the clusters are appended to the blob */
+	for (i = ctx->next_extent_page; i < ctx->last_extent_page; i++) {
+		if (blob->active.extent_pages[i] == 0) {
+			bserrno = blob_load_unallocated_extent_page(blob);
+			if (bserrno) {
+				blob_load_final(ctx, bserrno);
+				return;
+			}
+			assert(i + 1 < blob->active.num_extent_pages ||
+			       blob->remaining_clusters_in_et == 0);
+			continue;
 		}
-		ctx->num_pages = 1;
-		ctx->next_extent_page = 0;
-	} else {
-		page = &ctx->pages[0];
+
+		page = &ctx->pages[j++];
 		crc = blob_md_page_calc_crc(page);
 		if (crc != page->crc) {
 			blob_load_final(ctx, -EINVAL);
@@ -1542,40 +1728,71 @@ blob_load_cpl_extents_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		}
 	}
 
-	for (i = ctx->next_extent_page; i < blob->active.num_extent_pages; i++) {
-		if (blob->active.extent_pages[i] != 0) {
-			/* Extent page was allocated, read and parse it. */
-			lba = bs_md_page_to_lba(blob->bs, blob->active.extent_pages[i]);
-			ctx->next_extent_page = i + 1;
+	ctx->next_extent_page = ctx->last_extent_page;
+	if (ctx->next_extent_page < blob->active.num_extent_pages) {
+		blob_load_extent_pages(seq, ctx);
+		return;
+	}
 
-			bs_sequence_read_dev(seq, &ctx->pages[0], lba,
-					     bs_byte_to_lba(blob->bs, SPDK_BS_PAGE_SIZE),
-					     blob_load_cpl_extents_cpl, ctx);
-			return;
-		} else {
-			/* Thin provisioned blobs can point to unallocated extent pages.
-			 * In this case blob size should be increased by up to the amount left in remaining_clusters_in_et. */
+	blob_load_backing_dev(seq, ctx);
+}
 
-			sz = spdk_min(blob->remaining_clusters_in_et, SPDK_EXTENTS_PER_EP);
-			blob->active.num_clusters += sz;
-			blob->remaining_clusters_in_et -= sz;
+/*
+ * Read the next BLOB_LOAD_EXTENT_PAGES_BATCH allocated extent pages of the blob at once, instead
+ * of one after another, so that loading a large blob doesn't take a device round trip per extent
+ * page.
+ */
+static void
+blob_load_extent_pages(spdk_bs_sequence_t *seq, struct spdk_blob_load_ctx *ctx)
+{
+	struct spdk_blob	*blob = ctx->blob;
+	spdk_bs_batch_t		*batch;
+	uint32_t		count = 0;
+	uint64_t		lba;
+	uint64_t		i;
 
-			assert(spdk_blob_is_thin_provisioned(blob));
-			assert(i + 1 < blob->active.num_extent_pages || blob->remaining_clusters_in_et == 0);
+	if (ctx->pages == NULL) {
+		/* First iteration, allocate the buffer for a batch of EXTENT_PAGEs */
+		ctx->num_pages = spdk_min(blob->active.num_extent_pages,
+					  BLOB_LOAD_EXTENT_PAGES_BATCH);
+		ctx->pages = spdk_zmalloc(SPDK_BS_PAGE_SIZE * spdk_max(ctx->num_pages, 1), 0,
+					  NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+		if (!ctx->pages) {
+			blob_load_final(ctx, -ENOMEM);
+			return;
+		}
+		ctx->next_extent_page = 0;
+	}
 
-			tmp = realloc(blob->active.clusters, blob->active.num_clusters * sizeof(*blob->active.clusters));
-			if (tmp == NULL) {
-				blob_load_final(ctx, -ENOMEM);
-				return;
+	for (i = ctx->next_extent_page; i < blob->active.num_extent_pages; i++) {
+		if (blob->active.extent_pages[i] != 0) {
+			if (count == ctx->num_pages) {
+				break;
 			}
-			memset(tmp + sizeof(*blob->active.clusters) * blob->active.cluster_array_size, 0,
-			       sizeof(*blob->active.clusters) * (blob->active.num_clusters - blob->active.cluster_array_size));
-			blob->active.clusters = tmp;
-			blob->active.cluster_array_size = blob->active.num_clusters;
+			count++;
 		}
 	}
+	ctx->last_extent_page = i;
 
-	blob_load_backing_dev(seq, ctx);
+	if (count == 0) {
+		/* No extent page was allocated, there is nothing to read */
+		blob_load_cpl_extents_cpl(seq, ctx, 0);
+		return;
+	}
+
+	batch = bs_sequence_to_batch(seq, blob_load_cpl_extents_cpl, ctx);
+
+	count = 0;
+	for (i = ctx->next_extent_page; i < ctx->last_extent_page; i++) {
+		if (blob->active.extent_pages[i] != 0) {
+			/* Extent page was allocated, read and parse it. */
+			lba = bs_md_page_to_lba(blob->bs, blob->active.extent_pages[i]);
+			bs_batch_read_dev(batch, &ctx->pages[count++], lba,
+					  bs_byte_to_lba(blob->bs, SPDK_BS_PAGE_SIZE));
+		}
+	}
+
+	bs_batch_close(batch);
 }
 
 static void
@@ -1661,18 +1878,155 @@ blob_load_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	ctx->pages = NULL;
 
 	if (blob->extent_table_found) {
-		blob_load_cpl_extents_cpl(seq, ctx, 0);
+		blob_load_extent_pages(seq, ctx);
 	} else {
 		blob_load_backing_dev(seq, ctx);
 	}
 }
 
+/*
+ * The first md page of a blob, read ahead by the blob iterators so that the md reads of the next
+ * blobs are already in flight while the current one is handed to the caller. An entry is only
+ * kept while its blob is not open, so the page can't have changed since it was read.
+ */
+struct spdk_bs_md_prefetch {
+	struct spdk_blob_store		*bs;
+	uint32_t			page_num;
+	bool				on_list;
+	bool				done;
+	int				bserrno;
+	struct spdk_blob_md_page	*page;
+	/* The blob load waiting for the read to complete */
+	struct spdk_blob_load_ctx	*load_ctx;
+	TAILQ_ENTRY(spdk_bs_md_prefetch) link;
+};
+
+static void
+bs_md_prefetch_remove(struct spdk_bs_md_prefetch *prefetch)
+{
+	struct spdk_blob_store *bs = prefetch->bs;
+
+	assert(prefetch->on_list);
+	TAILQ_REMOVE(&bs->md_prefetches, prefetch, link);
+	bs->num_md_prefetches--;
+	prefetch->on_list = false;
+}
+
+static void
+bs_md_prefetch_free(struct spdk_bs_md_prefetch *prefetch)
+{
+	spdk_free(prefetch->page);
+	free(prefetch);
+}
+
+/* Forget a prefetched page. A read still in flight frees the entry when it completes. */
+static void
+bs_md_prefetch_drop(struct spdk_bs_md_prefetch *prefetch)
+{
+	bs_md_prefetch_remove(prefetch);
+	if (prefetch->done) {
+		bs_md_prefetch_free(prefetch);
+	}
+}
+
+static struct spdk_bs_md_prefetch *
+bs_md_prefetch_find(struct spdk_blob_store *bs, uint32_t page_num)
+{
+	struct spdk_bs_md_prefetch *prefetch;
+
+	TAILQ_FOREACH(prefetch, &bs->md_prefetches, link) {
+		if (prefetch->page_num == page_num) {
+			return prefetch;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+blob_load_prefetched(struct spdk_blob_load_ctx *ctx, struct spdk_bs_md_prefetch *prefetch)
+{
+	int bserrno = prefetch->bserrno;
+
+	memcpy(&ctx->pages[0], prefetch->page, SPDK_BS_PAGE_SIZE);
+	bs_md_prefetch_free(prefetch);
+
+	blob_load_cpl(ctx->seq, ctx, bserrno);
+}
+
+static void
+bs_md_prefetch_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_md_prefetch *prefetch = cb_arg;
+
+	prefetch->done = true;
+	prefetch->bserrno = bserrno;
+
+	if (prefetch->load_ctx != NULL) {
+		blob_load_prefetched(prefetch->load_ctx, prefetch);
+	} else if (!prefetch->on_list) {
+		bs_md_prefetch_free(prefetch);
+	} else if (bserrno != 0) {
+		/* Let the blob load read the page again and report the error itself */
+		bs_md_prefetch_drop(prefetch);
+	}
+}
+
+static void
+bs_md_prefetch_read_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	bs_sequence_finish(seq, bserrno);
+}
+
+static int
+bs_md_prefetch(struct spdk_blob_store *bs, uint32_t page_num)
+{
+	struct spdk_bs_md_prefetch	*prefetch;
+	struct spdk_bs_cpl		cpl;
+	spdk_bs_sequence_t		*seq;
+
+	prefetch = calloc(1, sizeof(*prefetch));
+	if (prefetch == NULL) {
+		return -ENOMEM;
+	}
+
+	prefetch->page = spdk_zmalloc(SPDK_BS_PAGE_SIZE, 0, NULL, SPDK_ENV_SOCKET_ID_ANY,
+				      SPDK_MALLOC_DMA);
+	if (prefetch->page == NULL) {
+		free(prefetch);
+		return -ENOMEM;
+	}
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = bs_md_prefetch_cpl;
+	cpl.u.blob_basic.cb_arg = prefetch;
+
+	seq = bs_sequence_start_bs(bs->md_channel, &cpl);
+	if (seq == NULL) {
+		bs_md_prefetch_free(prefetch);
+		return -ENOMEM;
+	}
+
+	prefetch->bs = bs;
+	prefetch->page_num = page_num;
+	prefetch->on_list = true;
+	TAILQ_INSERT_TAIL(&bs->md_prefetches, prefetch, link);
+	bs->num_md_prefetches++;
+
+	bs_sequence_read_dev(seq, prefetch->page, bs_md_page_to_lba(bs, page_num),
+			     bs_byte_to_lba(bs, SPDK_BS_PAGE_SIZE),
+			     bs_md_prefetch_read_cpl, prefetch);
+
+	return 0;
+}
+
 /* Load a blob from disk given a blobid */
 static void
 blob_load(spdk_bs_sequence_t *seq, struct spdk_blob *blob,
 	  spdk_bs_sequence_cpl cb_fn, void *cb_arg)
 {
 	struct spdk_blob_load_ctx *ctx;
+	struct spdk_bs_md_prefetch *prefetch;
 	struct spdk_blob_store *bs;
 	uint32_t page_num;
 	uint64_t lba;
@@ -1704,6 +2058,17 @@ blob_load(spdk_bs_sequence_t *seq, struct spdk_blob *blob,
 
 	blob->state = SPDK_BLOB_STATE_LOADING;
 
+	prefetch = bs_md_prefetch_find(bs, page_num);
+	if (prefetch != NULL) {
+		bs_md_prefetch_remove(prefetch);
+		if (prefetch->done) {
+			blob_load_prefetched(ctx, prefetch);
+		} else {
+			prefetch->load_ctx = ctx;
+		}
+		return;
+	}
+
 	bs_sequence_read_dev(seq, &ctx->pages[0], lba,
 			     bs_byte_to_lba(bs, SPDK_BS_PAGE_SIZE),
 			     blob_load_cpl, ctx);
@@ -2495,6 +2860,8 @@ struct spdk_blob_copy_cluster_ctx {
 	uint32_t new_extent_page;
 	spdk_bs_sequence_t *seq;
 	struct spdk_blob_md_page *new_cluster_page;
+	/* User op whose data was written into the new cluster in place of the copy */
+	spdk_bs_user_op_t *written_op;
 };
 
 static void
@@ -2511,7 +2878,10 @@ blob_allocate_and_copy_cluster_cpl(void *cb_arg, int bserrno)
 	while (!TAILQ_EMPTY(&requests)) {
 		op = TAILQ_FIRST(&requests);
 		TAILQ_REMOVE(&requests, op, link);
-		if (bserrno == 0) {
+		if (bserrno == 0 && op == ctx->written_op) {
+			/* The data is already in the cluster, just complete the op */
+			bs_user_op_abort(op, 0);
+		} else if (bserrno == 0) {
 			bs_user_op_execute(op);
 		} else {
 			bs_user_op_abort(op, bserrno);
@@ -2533,6 +2903,8 @@ blob_insert_cluster_cpl(void *cb_arg, int bserrno)
 			 * allocated the cluster first. Free our cluster
 			 * but continue without error. */
 			bserrno = 0;
+			/* The data written into our cluster has to go to the other one */
+			ctx->written_op = NULL;
 		}
 		spdk_spin_lock(&ctx->blob->bs->used_lock);
 		bs_release_cluster(ctx->blob->bs, ctx->new_cluster);
@@ -2563,22 +2935,51 @@ blob_write_copy_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 					 ctx->new_extent_page, ctx->new_cluster_page, blob_insert_cluster_cpl, ctx);
 }
 
+static void blob_write_copy(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno);
+
 static void
-blob_write_copy(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+blob_copy_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
+	struct spdk_blob *blob = ctx->blob;
 
-	if (bserrno != 0) {
-		/* The read failed, so jump to the final completion handler */
+	if (bserrno == 0) {
+		blob_write_copy_cpl(seq, ctx, 0);
+		return;
+	}
+
+	/* The copy offload failed, fall back to reading the cluster and writing it */
+	SPDK_DEBUGLOG(blob, "Copy of cluster failed (%d), falling back to read and write\n", bserrno);
+	assert(ctx->buf == NULL);
+	ctx->buf = spdk_malloc(blob->bs->cluster_sz, blob->back_bs_dev->blocklen,
+			       NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (!ctx->buf) {
 		bs_sequence_finish(seq, bserrno);
 		return;
 	}
 
-	/* Write whole cluster */
-	bs_sequence_write_dev(seq, ctx->buf,
-			      bs_cluster_to_lba(ctx->blob->bs, ctx->new_cluster),
-			      bs_cluster_to_lba(ctx->blob->bs, 1),
-			      blob_write_copy_cpl, ctx);
+	bs_sequence_read_bs_dev(seq, blob->back_bs_dev, ctx->buf,
+				bs_dev_page_to_lba(blob->back_bs_dev, ctx->page),
+				bs_dev_byte_to_lba(blob->back_bs_dev, blob->bs->cluster_sz),
+				blob_write_copy, ctx);
+}
+
+static void
+blob_write_copy(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
+
+	if (bserrno != 0) {
+		/* The read failed, so jump to the final completion handler */
+		bs_sequence_finish(seq, bserrno);
+		return;
+	}
+
+	/* Write whole cluster */
+	bs_sequence_write_dev(seq, ctx->buf,
+			      bs_cluster_to_lba(ctx->blob->bs, ctx->new_cluster),
+			      bs_cluster_to_lba(ctx->blob->bs, 1),
+			      blob_write_copy_cpl, ctx);
 }
 
 static bool
@@ -2600,7 +3001,52 @@ blob_copy(struct spdk_blob_copy_cluster_ctx *ctx, spdk_bs_user_op_t *op, uint64_
 			     bs_cluster_to_lba(blob->bs, ctx->new_cluster),
 			     src_lba,
 			     lba_count,
-			     blob_write_copy_cpl, ctx);
+			     blob_copy_cpl, ctx);
+}
+
+/*
+ * A write of a whole cluster doesn't need the data of the parent. Its payload can be written
+ * into the new cluster instead of the copy, before the cluster is inserted into the blob.
+ */
+static bool
+blob_user_op_overwrites_cluster(struct spdk_blob *blob, spdk_bs_user_op_t *op,
+				uint32_t cluster_start_page)
+{
+	struct spdk_bs_request_set *set = (struct spdk_bs_request_set *)op;
+	struct spdk_bs_user_op_args *args = &set->u.user_op;
+
+	if (args->type != SPDK_BLOB_WRITE && args->type != SPDK_BLOB_WRITEV) {
+		return false;
+	}
+
+	/* Memory domains are only handled when the op is executed */
+	if (set->ext_io_opts != NULL) {
+		return false;
+	}
+
+	return args->offset == cluster_start_page * bs_io_unit_per_page(blob->bs) &&
+	       args->length == bs_io_units_per_cluster(blob);
+}
+
+static void
+blob_write_user_op(struct spdk_blob_copy_cluster_ctx *ctx, spdk_bs_user_op_t *op)
+{
+	struct spdk_bs_user_op_args *args = &((struct spdk_bs_request_set *)op)->u.user_op;
+	struct spdk_blob_store *bs = ctx->blob->bs;
+
+	ctx->written_op = op;
+
+	if (args->type == SPDK_BLOB_WRITE) {
+		bs_sequence_write_dev(ctx->seq, args->payload,
+				      bs_cluster_to_lba(bs, ctx->new_cluster),
+				      bs_cluster_to_lba(bs, 1),
+				      blob_write_copy_cpl, ctx);
+	} else {
+		bs_sequence_writev_dev(ctx->seq, args->payload, args->iovcnt,
+				       bs_cluster_to_lba(bs, ctx->new_cluster),
+				       bs_cluster_to_lba(bs, 1),
+				       blob_write_copy_cpl, ctx);
+	}
 }
 
 static void
@@ -2615,6 +3061,7 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 	uint32_t cluster_number;
 	bool is_zeroes;
 	bool can_copy;
+	bool overwrite;
 	uint64_t copy_src_lba;
 	int rc;
 
@@ -2648,11 +3095,12 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 	ctx->new_cluster_page = ch->new_cluster_page;
 	memset(ctx->new_cluster_page, 0, SPDK_BS_PAGE_SIZE);
 	can_copy = blob_can_copy(blob, cluster_start_page, &copy_src_lba);
+	overwrite = blob_user_op_overwrites_cluster(blob, op, cluster_start_page);
 
 	is_zeroes = blob->back_bs_dev->is_zeroes(blob->back_bs_dev,
 			bs_dev_page_to_lba(blob->back_bs_dev, cluster_start_page),
 			bs_dev_byte_to_lba(blob->back_bs_dev, blob->bs->cluster_sz));
-	if (blob->parent_id != SPDK_BLOBID_INVALID && !is_zeroes && !can_copy) {
+	if (blob->parent_id != SPDK_BLOBID_INVALID && !is_zeroes && !can_copy && !overwrite) {
 		ctx->buf = spdk_malloc(blob->bs->cluster_sz, blob->back_bs_dev->blocklen,
 				       NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
 		if (!ctx->buf) {
@@ -2664,10 +3112,8 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 		}
 	}
 
-	spdk_spin_lock(&blob->bs->used_lock);
-	rc = bs_allocate_cluster(blob, cluster_number, &ctx->new_cluster, &ctx->new_extent_page,
-				 false);
-	spdk_spin_unlock(&blob->bs->used_lock);
+	rc = bs_channel_allocate_cluster(ch, blob, cluster_number, &ctx->new_cluster,
+					 &ctx->new_extent_page);
 	if (rc != 0) {
 		spdk_free(ctx->buf);
 		free(ctx);
@@ -2694,7 +3140,9 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 	TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
 
 	if (blob->parent_id != SPDK_BLOBID_INVALID && !is_zeroes) {
-		if (can_copy) {
+		if (overwrite) {
+			blob_write_user_op(ctx, op);
+		} else if (can_copy) {
 			blob_copy(ctx, op, copy_src_lba);
 		} else {
 			/* Read cluster from backing device */
@@ -2884,6 +3332,14 @@ blob_request_submit_op_split(struct spdk_io_channel *ch, struct spdk_blob *blob,
 	blob_request_submit_op_split_next(ctx, 0);
 }
 
+static inline struct bs_read_cache_channel *
+bs_channel_read_cache(struct spdk_io_channel *_ch)
+{
+	struct spdk_bs_channel *bs_channel = spdk_io_channel_get_ctx(_ch);
+
+	return bs_channel->read_cache_channel;
+}
+
 static void
 blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blob,
 			      void *payload, uint64_t offset, uint64_t length,
@@ -2922,19 +3378,33 @@ blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blo
 	case SPDK_BLOB_READ: {
 		spdk_bs_batch_t *batch;
 
+		if (spdk_unlikely(bs_channel_read_cache(_ch) != NULL)) {
+			struct iovec iov = { .iov_base = payload,
+				       .iov_len = length * blob->bs->io_unit_size
+			};
+
+			if (bs_read_cache_readv(blob, _ch, &iov, 1, offset, length, cb_fn, cb_arg,
+						NULL) == 0) {
+				return;
+			}
+		}
+
+		if (spdk_likely(is_allocated)) {
+			/* Read from the blob */
+			if (bs_direct_rw_dev(_ch, &cpl, blob, true, payload, lba, lba_count) != 0) {
+				cb_fn(cb_arg, -ENOMEM);
+			}
+			return;
+		}
+
 		batch = bs_batch_open(_ch, &cpl, blob);
 		if (!batch) {
 			cb_fn(cb_arg, -ENOMEM);
 			return;
 		}
 
-		if (is_allocated) {
-			/* Read from the blob */
-			bs_batch_read_dev(batch, payload, lba, lba_count);
-		} else {
-			/* Read from the backing block device */
-			bs_batch_read_bs_dev(batch, blob->back_bs_dev, payload, lba, lba_count);
-		}
+		/* Read from the backing block device */
+		bs_batch_read_bs_dev(batch, blob->back_bs_dev, payload, lba, lba_count);
 
 		bs_batch_close(batch);
 		break;
@@ -2950,17 +3420,21 @@ blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blo
 				return;
 			}
 
+			if (op_type == SPDK_BLOB_WRITE) {
+				if (bs_direct_rw_dev(_ch, &cpl, blob, false, payload, lba,
+						     lba_count) != 0) {
+					cb_fn(cb_arg, -ENOMEM);
+				}
+				return;
+			}
+
 			batch = bs_batch_open(_ch, &cpl, blob);
 			if (!batch) {
 				cb_fn(cb_arg, -ENOMEM);
 				return;
 			}
 
-			if (op_type == SPDK_BLOB_WRITE) {
-				bs_batch_write_dev(batch, payload, lba, lba_count);
-			} else {
-				bs_batch_write_zeroes_dev(batch, lba, lba_count);
-			}
+			bs_batch_write_zeroes_dev(batch, lba, lba_count);
 
 			bs_batch_close(batch);
 		} else {
@@ -3189,9 +3663,21 @@ blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel *_chan
 			return;
 		}
 
+		if (read && spdk_unlikely(bs_channel_read_cache(_channel) != NULL) &&
+		    bs_read_cache_readv(blob, _channel, iov, iovcnt, offset, length, cb_fn, cb_arg,
+					ext_io_opts) == 0) {
+			return;
+		}
+
 		is_allocated = blob_calculate_lba_and_lba_count(blob, offset, length, &lba, &lba_count);
 
-		if (read) {
+		if (spdk_likely(is_allocated)) {
+			/* Single IO to the blob's cluster, no need for a sequence */
+			if (bs_direct_rwv_dev(_channel, &cpl, blob, read, iov, iovcnt, lba,
+					      lba_count, ext_io_opts) != 0) {
+				cb_fn(cb_arg, -ENOMEM);
+			}
+		} else if (read) {
 			spdk_bs_sequence_t *seq;
 
 			seq = bs_sequence_start_blob(_channel, &cpl, blob);
@@ -3202,40 +3688,22 @@ blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel *_chan
 
 			seq->ext_io_opts = ext_io_opts;
 
-			if (is_allocated) {
-				bs_sequence_readv_dev(seq, iov, iovcnt, lba, lba_count, rw_iov_done, NULL);
-			} else {
-				bs_sequence_readv_bs_dev(seq, blob->back_bs_dev, iov, iovcnt, lba, lba_count,
-							 rw_iov_done, NULL);
-			}
+			bs_sequence_readv_bs_dev(seq, blob->back_bs_dev, iov, iovcnt, lba, lba_count,
+						 rw_iov_done, NULL);
 		} else {
-			if (is_allocated) {
-				spdk_bs_sequence_t *seq;
-
-				seq = bs_sequence_start_blob(_channel, &cpl, blob);
-				if (!seq) {
-					cb_fn(cb_arg, -ENOMEM);
-					return;
-				}
-
-				seq->ext_io_opts = ext_io_opts;
-
-				bs_sequence_writev_dev(seq, iov, iovcnt, lba, lba_count, rw_iov_done, NULL);
-			} else {
-				/* Queue this operation and allocate the cluster */
-				spdk_bs_user_op_t *op;
+			/* Queue this operation and allocate the cluster */
+			spdk_bs_user_op_t *op;
 
-				op = bs_user_op_alloc(_channel, &cpl, SPDK_BLOB_WRITEV, blob, iov, iovcnt, offset,
-						      length);
-				if (!op) {
-					cb_fn(cb_arg, -ENOMEM);
-					return;
-				}
+			op = bs_user_op_alloc(_channel, &cpl, SPDK_BLOB_WRITEV, blob, iov, iovcnt,
+					      offset, length);
+			if (!op) {
+				cb_fn(cb_arg, -ENOMEM);
+				return;
+			}
 
-				op->ext_io_opts = ext_io_opts;
+			op->ext_io_opts = ext_io_opts;
 
-				bs_allocate_and_copy_cluster(blob, _channel, offset, op);
-			}
+			bs_allocate_and_copy_cluster(blob, _channel, offset, op);
 		}
 	} else {
 		struct rw_iov_ctx *ctx;
@@ -3349,6 +3817,11 @@ bs_channel_create(void *io_device, void *ctx_buf)
 	TAILQ_INIT(&channel->queued_io);
 	RB_INIT(&channel->esnap_channels);
 
+	if (bs->read_cache != NULL) {
+		/* Reads just go to the blob if the cache channel can't be created */
+		channel->read_cache_channel = bs_read_cache_channel_create(bs->read_cache);
+	}
+
 	return 0;
 }
 
@@ -3371,6 +3844,10 @@ bs_channel_destroy(void *io_device, void *ctx_buf)
 	}
 
 	blob_esnap_destroy_bs_channel(channel);
+	bs_channel_release_cluster_slab(channel);
+	if (channel->read_cache_channel != NULL) {
+		bs_read_cache_channel_destroy(channel->read_cache_channel);
+	}
 
 	free(channel->req_mem);
 	spdk_free(channel->new_cluster_page);
@@ -3385,12 +3862,21 @@ bs_dev_destroy(void *io_device)
 
 	bs->dev->destroy(bs->dev);
 
+	while (!TAILQ_EMPTY(&bs->md_prefetches)) {
+		bs_md_prefetch_drop(TAILQ_FIRST(&bs->md_prefetches));
+	}
+
 	RB_FOREACH_SAFE(blob, spdk_blob_tree, &bs->open_blobs, blob_tmp) {
 		RB_REMOVE(spdk_blob_tree, &bs->open_blobs, blob);
 		spdk_bit_array_clear(bs->open_blobids, blob->id);
 		blob_free(blob);
 	}
 
+	/* The esnap caches go away with the last esnap clone using them */
+	assert(TAILQ_EMPTY(&bs->esnap_caches));
+	if (bs->read_cache != NULL) {
+		bs_read_cache_free(bs->read_cache);
+	}
 	spdk_spin_destroy(&bs->used_lock);
 
 	spdk_bit_array_free(&bs->open_blobids);
@@ -3542,6 +4028,8 @@ spdk_bs_opts_init(struct spdk_bs_opts *opts, size_t opts_size)
 	SET_FIELD(force_recover, false);
 	SET_FIELD(esnap_bs_dev_create, NULL);
 	SET_FIELD(esnap_ctx, NULL);
+	SET_FIELD(iter_prefetch_depth, SPDK_BLOB_OPTS_ITER_PREFETCH_DEPTH);
+	SET_FIELD(esnap_cache_size_mb, 0);
 
 #undef FIELD_OK
 #undef SET_FIELD
@@ -3641,6 +4129,9 @@ bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_st
 
 	RB_INIT(&bs->open_blobs);
 	TAILQ_INIT(&bs->snapshots);
+	TAILQ_INIT(&bs->pending_cluster_inserts);
+	TAILQ_INIT(&bs->md_prefetches);
+	TAILQ_INIT(&bs->esnap_caches);
 	bs->dev = dev;
 	bs->md_thread = spdk_get_thread();
 	assert(bs->md_thread != NULL);
@@ -3671,6 +4162,9 @@ bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_st
 	memcpy(&bs->bstype, &opts->bstype, sizeof(opts->bstype));
 	bs->esnap_bs_dev_create = opts->esnap_bs_dev_create;
 	bs->esnap_ctx = opts->esnap_ctx;
+	/* Leave most of the md channel's requests to the md operations themselves */
+	bs->iter_prefetch_depth = spdk_min(opts->iter_prefetch_depth, bs->max_channel_ops / 2);
+	bs->esnap_cache_size = (uint64_t)opts->esnap_cache_size_mb * 1024 * 1024;
 
 	/* The metadata is assumed to be at least 1 page */
 	bs->used_md_pages = spdk_bit_array_create(1);
@@ -4749,12 +5243,14 @@ bs_opts_copy(struct spdk_bs_opts *src, struct spdk_bs_opts *dst)
 	SET_FIELD(force_recover);
 	SET_FIELD(esnap_bs_dev_create);
 	SET_FIELD(esnap_ctx);
+	SET_FIELD(iter_prefetch_depth);
+	SET_FIELD(esnap_cache_size_mb);
 
 	dst->opts_size = src->opts_size;
 
 	/* You should not remove this statement, but need to update the assert statement
 	 * if you add a new field, and also add a corresponding SET_FIELD statement */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 88, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 96, "Incorrect size");
 
 #undef FIELD_OK
 #undef SET_FIELD
@@ -5552,6 +6048,19 @@ bs_unload_write_used_clusters_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bse
 	bs_write_super(seq, ctx->bs, ctx->super, bs_unload_write_super_cpl, ctx);
 }
 
+static void
+bs_unload_cluster_slabs_reclaimed(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_load_ctx	*ctx = cb_arg;
+
+	if (bserrno != 0) {
+		bs_unload_finish(ctx, bserrno);
+		return;
+	}
+
+	bs_write_used_clusters(ctx->seq, ctx, bs_unload_write_used_clusters_cpl);
+}
+
 static void
 bs_unload_write_used_blobids_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
@@ -5565,7 +6074,8 @@ bs_unload_write_used_blobids_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bser
 		return;
 	}
 
-	bs_write_used_clusters(seq, ctx, bs_unload_write_used_clusters_cpl);
+	/* Clusters left in the slabs of the channels must not be persisted as used */
+	bs_reclaim_cluster_slabs(ctx->bs, bs_unload_cluster_slabs_reclaimed, ctx);
 }
 
 static void
@@ -5790,7 +6300,7 @@ spdk_bs_get_io_unit_size(struct spdk_blob_store *bs)
 uint64_t
 spdk_bs_free_cluster_count(struct spdk_blob_store *bs)
 {
-	return bs->num_free_clusters;
+	return bs->num_free_clusters + __atomic_load_n(&bs->num_slab_clusters, __ATOMIC_RELAXED);
 }
 
 uint64_t
@@ -5956,6 +6466,75 @@ blob_opts_copy(const struct spdk_blob_opts *src, struct spdk_blob_opts *dst)
 #undef SET_FIELD
 }
 
+struct bs_create_blob_ctx {
+	struct spdk_blob		*blob;
+	uint64_t			num_clusters;
+	spdk_blob_op_with_id_complete	cb_fn;
+	void				*cb_arg;
+};
+
+static void
+bs_create_blob_fail(struct spdk_blob_store *bs, struct spdk_blob *blob, uint32_t page_idx,
+		    uint64_t num_clusters, int rc, spdk_blob_op_with_id_complete cb_fn, void *cb_arg)
+{
+	SPDK_ERRLOG("Failed to create blob: %s, size in clusters/size: %lu (clusters)\n",
+		    spdk_strerror(rc), num_clusters);
+	if (blob != NULL) {
+		blob_free(blob);
+	}
+	spdk_spin_lock(&bs->used_lock);
+	spdk_bit_array_clear(bs->used_blobids, page_idx);
+	bs_release_md_page(bs, page_idx);
+	spdk_spin_unlock(&bs->used_lock);
+	cb_fn(cb_arg, 0, rc);
+}
+
+static void
+bs_create_blob_resize(struct spdk_blob *blob, uint64_t num_clusters,
+		      spdk_blob_op_with_id_complete cb_fn, void *cb_arg)
+{
+	struct spdk_bs_cpl	cpl;
+	spdk_bs_sequence_t	*seq;
+	int rc;
+
+	rc = blob_resize(blob, num_clusters);
+	if (rc < 0) {
+		goto error;
+	}
+	cpl.type = SPDK_BS_CPL_TYPE_BLOBID;
+	cpl.u.blobid.cb_fn = cb_fn;
+	cpl.u.blobid.cb_arg = cb_arg;
+	cpl.u.blobid.blobid = blob->id;
+
+	seq = bs_sequence_start_bs(blob->bs->md_channel, &cpl);
+	if (!seq) {
+		rc = -ENOMEM;
+		goto error;
+	}
+
+	blob_persist(seq, blob, bs_create_blob_cpl, blob);
+	return;
+
+error:
+	bs_create_blob_fail(blob->bs, blob, bs_blobid_to_page(blob->id), num_clusters, rc, cb_fn,
+			    cb_arg);
+}
+
+static void
+bs_create_blob_cluster_slabs_reclaimed(void *cb_arg, int bserrno)
+{
+	struct bs_create_blob_ctx *ctx = cb_arg;
+	struct spdk_blob *blob = ctx->blob;
+
+	if (bserrno != 0) {
+		bs_create_blob_fail(blob->bs, blob, bs_blobid_to_page(blob->id), ctx->num_clusters,
+				    bserrno, ctx->cb_fn, ctx->cb_arg);
+	} else {
+		bs_create_blob_resize(blob, ctx->num_clusters, ctx->cb_fn, ctx->cb_arg);
+	}
+	free(ctx);
+}
+
 static void
 bs_create_blob(struct spdk_blob_store *bs,
 	       const struct spdk_blob_opts *opts,
@@ -5964,10 +6543,9 @@ bs_create_blob(struct spdk_blob_store *bs,
 {
 	struct spdk_blob	*blob;
 	uint32_t		page_idx;
-	struct spdk_bs_cpl	cpl;
 	struct spdk_blob_opts	opts_local;
 	struct spdk_blob_xattr_opts internal_xattrs_default;
-	spdk_bs_sequence_t	*seq;
+	struct bs_create_blob_ctx *ctx;
 	spdk_blob_id		id;
 	int rc;
 
@@ -6042,35 +6620,26 @@ bs_create_blob(struct spdk_blob_store *bs,
 		}
 	}
 
-	rc = blob_resize(blob, opts_local.num_clusters);
-	if (rc < 0) {
-		goto error;
-	}
-	cpl.type = SPDK_BS_CPL_TYPE_BLOBID;
-	cpl.u.blobid.cb_fn = cb_fn;
-	cpl.u.blobid.cb_arg = cb_arg;
-	cpl.u.blobid.blobid = blob->id;
-
-	seq = bs_sequence_start_bs(bs->md_channel, &cpl);
-	if (!seq) {
-		rc = -ENOMEM;
-		goto error;
+	if (!spdk_blob_is_thin_provisioned(blob) &&
+	    bs_cluster_slabs_needed(bs, opts_local.num_clusters)) {
+		ctx = calloc(1, sizeof(*ctx));
+		if (ctx == NULL) {
+			rc = -ENOMEM;
+			goto error;
+		}
+		ctx->blob = blob;
+		ctx->num_clusters = opts_local.num_clusters;
+		ctx->cb_fn = cb_fn;
+		ctx->cb_arg = cb_arg;
+		bs_reclaim_cluster_slabs(bs, bs_create_blob_cluster_slabs_reclaimed, ctx);
+		return;
 	}
 
-	blob_persist(seq, blob, bs_create_blob_cpl, blob);
+	bs_create_blob_resize(blob, opts_local.num_clusters, cb_fn, cb_arg);
 	return;
 
 error:
-	SPDK_ERRLOG("Failed to create blob: %s, size in clusters/size: %lu (clusters)\n",
-		    spdk_strerror(rc), opts_local.num_clusters);
-	if (blob != NULL) {
-		blob_free(blob);
-	}
-	spdk_spin_lock(&bs->used_lock);
-	spdk_bit_array_clear(bs->used_blobids, page_idx);
-	bs_release_md_page(bs, page_idx);
-	spdk_spin_unlock(&bs->used_lock);
-	cb_fn(cb_arg, 0, rc);
+	bs_create_blob_fail(bs, blob, page_idx, opts_local.num_clusters, rc, cb_fn, cb_arg);
 }
 
 void
@@ -6811,12 +7380,49 @@ bs_inflate_blob_touch_next(void *cb_arg, int bserrno)
 	}
 }
 
+static uint64_t
+bs_inflate_blob_clusters_needed(struct spdk_clone_snapshot_ctx *ctx)
+{
+	struct spdk_blob *_blob = ctx->original.blob;
+	uint64_t clusters_needed = 0;
+	uint64_t i;
+
+	for (i = 0; i < _blob->active.num_clusters; i++) {
+		if (bs_cluster_needs_allocation(_blob, i, ctx->allocate_all)) {
+			clusters_needed++;
+		}
+	}
+
+	return clusters_needed;
+}
+
+static void
+bs_inflate_blob_start(void *cb_arg, int bserrno)
+{
+	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+
+	if (bserrno != 0) {
+		bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
+		return;
+	}
+
+	/* Do two passes - one to verify that we can obtain enough clusters
+	 * and another to actually claim them.
+	 */
+	if (bs_inflate_blob_clusters_needed(ctx) > ctx->original.blob->bs->num_free_clusters) {
+		/* Not enough free clusters. Cannot satisfy the request. */
+		bs_clone_snapshot_origblob_cleanup(ctx, -ENOSPC);
+		return;
+	}
+
+	ctx->cluster = 0;
+	bs_inflate_blob_touch_next(ctx, 0);
+}
+
 static void
 bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 {
 	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
-	uint64_t clusters_needed;
-	uint64_t i;
 
 	if (bserrno != 0) {
 		bs_clone_snapshot_cleanup_finish(ctx, bserrno);
@@ -6863,24 +7469,12 @@ bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 		return;
 	}
 
-	/* Do two passes - one to verify that we can obtain enough clusters
-	 * and another to actually claim them.
-	 */
-	clusters_needed = 0;
-	for (i = 0; i < _blob->active.num_clusters; i++) {
-		if (bs_cluster_needs_allocation(_blob, i, ctx->allocate_all)) {
-			clusters_needed++;
-		}
-	}
-
-	if (clusters_needed > _blob->bs->num_free_clusters) {
-		/* Not enough free clusters. Cannot satisfy the request. */
-		bs_clone_snapshot_origblob_cleanup(ctx, -ENOSPC);
+	if (bs_cluster_slabs_needed(_blob->bs, bs_inflate_blob_clusters_needed(ctx))) {
+		bs_reclaim_cluster_slabs(_blob->bs, bs_inflate_blob_start, ctx);
 		return;
 	}
 
-	ctx->cluster = 0;
-	bs_inflate_blob_touch_next(ctx, 0);
+	bs_inflate_blob_start(ctx, 0);
 }
 
 static void
@@ -6919,19 +7513,652 @@ spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel
 }
 /* END spdk_bs_inflate_blob */
 
-/* START spdk_blob_resize */
-struct spdk_bs_resize_ctx {
-	spdk_blob_op_complete cb_fn;
-	void *cb_arg;
-	struct spdk_blob *blob;
-	uint64_t sz;
-	int rc;
+/* START spdk_blob_prefill_clusters */
+
+struct spdk_blob_prefill_ctx {
+	struct spdk_blob		*blob;
+	struct spdk_io_channel		*channel;
+	struct spdk_poller		*poller;
+	uint64_t			period_us;
+
+	/* Clusters to prefill in that order, or NULL for all clusters of the blob */
+	uint64_t			*clusters;
+	uint64_t			num_clusters;
+	uint64_t			next;
+
+	spdk_blob_op_complete		cb_fn;
+	void				*cb_arg;
 };
 
+static void blob_prefill_next(void *cb_arg, int bserrno);
+
 static void
-bs_resize_unfreeze_cpl(void *cb_arg, int rc)
+blob_prefill_done(struct spdk_blob_prefill_ctx *ctx, int bserrno)
 {
-	struct spdk_bs_resize_ctx *ctx = (struct spdk_bs_resize_ctx *)cb_arg;
+	ctx->blob->locked_operation_in_progress = false;
+	ctx->cb_fn(ctx->cb_arg, bserrno);
+	free(ctx->clusters);
+	free(ctx);
+}
+
+static bool
+blob_prefill_cluster_needed(struct spdk_blob *blob, uint64_t cluster)
+{
+	struct spdk_bs_dev *back_bs_dev = blob->back_bs_dev;
+	uint64_t page;
+
+	if (cluster >= blob->active.num_clusters || blob->active.clusters[cluster] != 0) {
+		/* Out of range after a resize, or already written by the foreground I/O */
+		return false;
+	}
+
+	page = bs_cluster_to_page(blob->bs, cluster);
+	return !back_bs_dev->is_zeroes(back_bs_dev, bs_dev_page_to_lba(back_bs_dev, page),
+				       bs_dev_byte_to_lba(back_bs_dev, blob->bs->cluster_sz));
+}
+
+static int
+blob_prefill_poll(void *arg)
+{
+	struct spdk_blob_prefill_ctx *ctx = arg;
+
+	spdk_poller_unregister(&ctx->poller);
+	blob_prefill_next(ctx, 0);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+blob_prefill_cluster_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_prefill_ctx *ctx = cb_arg;
+
+	if (bserrno != 0 || ctx->period_us == 0) {
+		blob_prefill_next(ctx, bserrno);
+		return;
+	}
+
+	ctx->poller = SPDK_POLLER_REGISTER(blob_prefill_poll, ctx, ctx->period_us);
+	if (ctx->poller == NULL) {
+		blob_prefill_done(ctx, -ENOMEM);
+	}
+}
+
+static void
+blob_prefill_next(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_prefill_ctx *ctx = cb_arg;
+	struct spdk_blob *blob = ctx->blob;
+	struct spdk_bs_cpl cpl;
+	spdk_bs_user_op_t *op;
+	uint64_t cluster = 0;
+	uint64_t offset;
+
+	if (bserrno != 0) {
+		blob_prefill_done(ctx, bserrno);
+		return;
+	}
+
+	for (; ctx->next < ctx->num_clusters; ctx->next++) {
+		cluster = ctx->clusters ? ctx->clusters[ctx->next] : ctx->next;
+		if (blob_prefill_cluster_needed(blob, cluster)) {
+			break;
+		}
+	}
+
+	if (ctx->next == ctx->num_clusters) {
+		blob_prefill_done(ctx, 0);
+		return;
+	}
+
+	ctx->next++;
+	offset = bs_cluster_to_lba(blob->bs, cluster);
+
+	/* Use a dummy 0B read as a context for cluster copy, same as inflate */
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = blob_prefill_cluster_cpl;
+	cpl.u.blob_basic.cb_arg = ctx;
+
+	op = bs_user_op_alloc(ctx->channel, &cpl, SPDK_BLOB_READ, blob, NULL, 0, offset, 0);
+	if (!op) {
+		blob_prefill_done(ctx, -ENOMEM);
+		return;
+	}
+
+	bs_allocate_and_copy_cluster(blob, ctx->channel, offset, op);
+}
+
+void
+spdk_blob_prefill_clusters(struct spdk_blob *blob, struct spdk_io_channel *channel,
+			   const uint64_t *clusters, uint64_t num_clusters,
+			   uint32_t clusters_per_sec, spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_blob_prefill_ctx *ctx;
+
+	blob_verify_md_op(blob);
+
+	if (blob->parent_id == SPDK_BLOBID_INVALID || blob->data_ro ||
+	    !spdk_blob_is_thin_provisioned(blob)) {
+		cb_fn(cb_arg, -EINVAL);
+		return;
+	}
+
+	if (blob->locked_operation_in_progress) {
+		cb_fn(cb_arg, -EBUSY);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	if (clusters != NULL) {
+		ctx->clusters = calloc(num_clusters, sizeof(*ctx->clusters));
+		if (!ctx->clusters) {
+			free(ctx);
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
+		memcpy(ctx->clusters, clusters, num_clusters * sizeof(*ctx->clusters));
+		ctx->num_clusters = num_clusters;
+	} else {
+		ctx->num_clusters = blob->active.num_clusters;
+	}
+
+	ctx->blob = blob;
+	ctx->channel = channel;
+	ctx->period_us = clusters_per_sec ? SPDK_SEC_TO_USEC / clusters_per_sec : 0;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	blob->locked_operation_in_progress = true;
+	blob_prefill_next(ctx, 0);
+}
+
+/* END spdk_blob_prefill_clusters */
+
+/* START spdk_blob_defragment */
+
+/* How often the channels are checked again for I/O to the blob issued before it was frozen */
+#define BLOB_DEFRAG_DRAIN_POLL_US	100
+
+struct spdk_blob_defrag_ctx {
+	struct spdk_blob		*blob;
+	struct spdk_io_channel		*channel;
+	struct spdk_poller		*poller;
+	uint64_t			period_us;
+	void				*buf;
+	struct spdk_blob_md_page	*extent_page;
+
+	/* Cluster of the blob being moved and its old and new location */
+	uint64_t			next;
+	uint32_t			prev_cluster_num;
+	uint32_t			old_cluster_num;
+	uint32_t			new_cluster_num;
+	int				rc;
+
+	spdk_blob_op_complete		cb_fn;
+	void				*cb_arg;
+};
+
+static void blob_defrag_next(struct spdk_blob_defrag_ctx *ctx);
+static void blob_sync_md(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_arg);
+static void blob_write_extent_page(struct spdk_blob *blob, uint32_t extent, uint64_t cluster_num,
+				   struct spdk_blob_md_page *page, spdk_blob_op_complete cb_fn,
+				   void *cb_arg);
+
+static void
+blob_defrag_done(struct spdk_blob_defrag_ctx *ctx, int bserrno)
+{
+	ctx->blob->locked_operation_in_progress = false;
+	ctx->cb_fn(ctx->cb_arg, bserrno);
+	spdk_free(ctx->extent_page);
+	spdk_free(ctx->buf);
+	free(ctx);
+}
+
+static int
+blob_defrag_poll(void *arg)
+{
+	struct spdk_blob_defrag_ctx *ctx = arg;
+
+	spdk_poller_unregister(&ctx->poller);
+	blob_defrag_next(ctx);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+blob_defrag_unfreeze_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_defrag_ctx *ctx = cb_arg;
+
+	if (ctx->rc != 0 || ctx->period_us == 0) {
+		if (ctx->rc != 0) {
+			blob_defrag_done(ctx, ctx->rc);
+		} else {
+			blob_defrag_next(ctx);
+		}
+		return;
+	}
+
+	ctx->poller = SPDK_POLLER_REGISTER(blob_defrag_poll, ctx, ctx->period_us);
+	if (ctx->poller == NULL) {
+		blob_defrag_done(ctx, -ENOMEM);
+	}
+}
+
+static void
+blob_defrag_sync_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_defrag_ctx *ctx = cb_arg;
+	struct spdk_blob_store *bs = ctx->blob->bs;
+	uint32_t release_cluster_num = ctx->old_cluster_num;
+
+	if (bserrno != 0) {
+		/* Keep the data where the metadata on disk still points to */
+		ctx->blob->active.clusters[ctx->next] = bs_cluster_to_lba(bs, ctx->old_cluster_num);
+		release_cluster_num = ctx->new_cluster_num;
+		ctx->rc = bserrno;
+	} else {
+		ctx->prev_cluster_num = ctx->new_cluster_num;
+	}
+
+	spdk_spin_lock(&bs->used_lock);
+	bs_release_cluster(bs, release_cluster_num);
+	spdk_spin_unlock(&bs->used_lock);
+
+	ctx->next++;
+	blob_unfreeze_io(ctx->blob, blob_defrag_unfreeze_cpl, ctx);
+}
+
+static void
+blob_defrag_copy_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_defrag_ctx *ctx = cb_arg;
+	struct spdk_blob *blob = ctx->blob;
+
+	if (bserrno != 0) {
+		spdk_spin_lock(&blob->bs->used_lock);
+		bs_release_cluster(blob->bs, ctx->new_cluster_num);
+		spdk_spin_unlock(&blob->bs->used_lock);
+		ctx->rc = bserrno;
+		blob_unfreeze_io(blob, blob_defrag_unfreeze_cpl, ctx);
+		return;
+	}
+
+	/*
+	 * The md page holding the cluster is written out in a single I/O, so the switch to the
+	 * new cluster is atomic.
+	 */
+	blob->active.clusters[ctx->next] = bs_cluster_to_lba(blob->bs, ctx->new_cluster_num);
+	if (blob->use_extent_table) {
+		blob_write_extent_page(blob, *bs_cluster_to_extent_page(blob, ctx->next), ctx->next,
+				       ctx->extent_page, blob_defrag_sync_cpl, ctx);
+	} else {
+		blob->state = SPDK_BLOB_STATE_DIRTY;
+		blob_sync_md(blob, blob_defrag_sync_cpl, ctx);
+	}
+}
+
+static void
+blob_defrag_seq_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	bs_sequence_finish(seq, bserrno);
+}
+
+static void
+blob_defrag_write(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_defrag_ctx *ctx = cb_arg;
+	struct spdk_blob_store *bs = ctx->blob->bs;
+
+	if (bserrno != 0) {
+		bs_sequence_finish(seq, bserrno);
+		return;
+	}
+
+	bs_sequence_write_dev(seq, ctx->buf, bs_cluster_to_lba(bs, ctx->new_cluster_num),
+			      bs_cluster_to_lba(bs, 1), blob_defrag_seq_cpl, NULL);
+}
+
+static void
+blob_defrag_copy(struct spdk_blob_defrag_ctx *ctx)
+{
+	struct spdk_blob_store *bs = ctx->blob->bs;
+	struct spdk_bs_cpl cpl;
+	spdk_bs_sequence_t *seq;
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = blob_defrag_copy_cpl;
+	cpl.u.blob_basic.cb_arg = ctx;
+
+	seq = bs_sequence_start_bs(ctx->channel, &cpl);
+	if (!seq) {
+		blob_defrag_copy_cpl(ctx, -ENOMEM);
+		return;
+	}
+
+	if (bs->dev->copy != NULL) {
+		bs_sequence_copy_dev(seq, bs_cluster_to_lba(bs, ctx->new_cluster_num),
+				     bs_cluster_to_lba(bs, ctx->old_cluster_num),
+				     bs_cluster_to_lba(bs, 1), blob_defrag_seq_cpl, NULL);
+	} else {
+		bs_sequence_read_dev(seq, ctx->buf, bs_cluster_to_lba(bs, ctx->old_cluster_num),
+				     bs_cluster_to_lba(bs, 1), blob_defrag_write, ctx);
+	}
+}
+
+static void blob_defrag_drain(struct spdk_blob_defrag_ctx *ctx);
+
+static int
+blob_defrag_drain_poll(void *arg)
+{
+	struct spdk_blob_defrag_ctx *ctx = arg;
+
+	spdk_poller_unregister(&ctx->poller);
+	blob_defrag_drain(ctx);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+blob_defrag_drain_channel(struct spdk_io_channel_iter *i)
+{
+	struct spdk_blob_defrag_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_bs_channel *ch = spdk_io_channel_get_ctx(_ch);
+	uint32_t j;
+
+	for (j = 0; j < ch->bs->max_channel_ops; j++) {
+		if (ch->req_mem[j].io_blob == ctx->blob) {
+			spdk_for_each_channel_continue(i, -EBUSY);
+			return;
+		}
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+blob_defrag_drain_cpl(struct spdk_io_channel_iter *i, int status)
+{
+	struct spdk_blob_defrag_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_blob_store *bs = ctx->blob->bs;
+
+	if (status == 0) {
+		blob_defrag_copy(ctx);
+		return;
+	}
+
+	ctx->poller = SPDK_POLLER_REGISTER(blob_defrag_drain_poll, ctx, BLOB_DEFRAG_DRAIN_POLL_US);
+	if (ctx->poller == NULL) {
+		spdk_spin_lock(&bs->used_lock);
+		bs_release_cluster(bs, ctx->new_cluster_num);
+		spdk_spin_unlock(&bs->used_lock);
+		ctx->rc = -ENOMEM;
+		blob_unfreeze_io(ctx->blob, blob_defrag_unfreeze_cpl, ctx);
+	}
+}
+
+/*
+ * Freezing the blob only queues new I/O. Wait for the I/O already sent to the device to
+ * complete, so that no write lands in the old cluster after it was copied.
+ */
+static void
+blob_defrag_drain(struct spdk_blob_defrag_ctx *ctx)
+{
+	spdk_for_each_channel(ctx->blob->bs, blob_defrag_drain_channel, ctx,
+			      blob_defrag_drain_cpl);
+}
+
+static void
+blob_defrag_frozen_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_defrag_ctx *ctx = cb_arg;
+	struct spdk_blob_store *bs = ctx->blob->bs;
+
+	if (bserrno != 0) {
+		spdk_spin_lock(&bs->used_lock);
+		bs_release_cluster(bs, ctx->new_cluster_num);
+		spdk_spin_unlock(&bs->used_lock);
+		blob_defrag_done(ctx, bserrno);
+		return;
+	}
+
+	blob_defrag_drain(ctx);
+}
+
+static void
+blob_defrag_next(struct spdk_blob_defrag_ctx *ctx)
+{
+	struct spdk_blob *blob = ctx->blob;
+	struct spdk_blob_store *bs = blob->bs;
+	uint32_t cluster_num = 0;
+	int rc;
+
+	for (; ctx->next < blob->active.num_clusters; ctx->next++) {
+		if (blob->active.clusters[ctx->next] == 0) {
+			/* Unallocated cluster of a thin provisioned blob */
+			continue;
+		}
+
+		cluster_num = bs_lba_to_cluster(bs, blob->active.clusters[ctx->next]);
+		if (ctx->prev_cluster_num == UINT32_MAX ||
+		    cluster_num == ctx->prev_cluster_num + 1) {
+			ctx->prev_cluster_num = cluster_num;
+			continue;
+		}
+
+		spdk_spin_lock(&bs->used_lock);
+		rc = bs_claim_cluster_at(bs, ctx->prev_cluster_num + 1);
+		spdk_spin_unlock(&bs->used_lock);
+		if (rc != 0) {
+			/* The cluster we'd like to move to is in use, continue from this one */
+			ctx->prev_cluster_num = cluster_num;
+			continue;
+		}
+
+		break;
+	}
+
+	if (ctx->next == blob->active.num_clusters) {
+		blob_defrag_done(ctx, 0);
+		return;
+	}
+
+	ctx->old_cluster_num = cluster_num;
+	ctx->new_cluster_num = ctx->prev_cluster_num + 1;
+	SPDK_DEBUGLOG(blob, "Moving cluster %" PRIu64 " of blob 0x%" PRIx64 " from %u to %u\n",
+		      ctx->next, blob->id, ctx->old_cluster_num, ctx->new_cluster_num);
+
+	/* Stop the I/O to the blob while the cluster is copied and the map updated */
+	blob_freeze_io(blob, blob_defrag_frozen_cpl, ctx);
+}
+
+void
+spdk_blob_defragment(struct spdk_blob *blob, struct spdk_io_channel *channel,
+		     uint32_t clusters_per_sec, spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_blob_defrag_ctx *ctx;
+	struct spdk_blob_list *snapshot_entry;
+
+	blob_verify_md_op(blob);
+
+	if (blob->locked_operation_in_progress) {
+		cb_fn(cb_arg, -EBUSY);
+		return;
+	}
+
+	/*
+	 * The clones read the clusters they didn't write from the blob, without going through
+	 * its frozen I/O. Creating a clone is refused while the blob is locked below.
+	 */
+	snapshot_entry = bs_get_snapshot_entry(blob->bs, blob->id);
+	if (snapshot_entry != NULL && snapshot_entry->clone_count > 0) {
+		SPDK_DEBUGLOG(blob, "Cannot defragment blob 0x%" PRIx64 " with clones\n", blob->id);
+		cb_fn(cb_arg, -EBUSY);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	if (blob->bs->dev->copy == NULL) {
+		ctx->buf = spdk_malloc(blob->bs->cluster_sz, blob->bs->dev->blocklen, NULL,
+				       SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+		if (!ctx->buf) {
+			free(ctx);
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
+	}
+
+	if (blob->use_extent_table) {
+		ctx->extent_page = spdk_zmalloc(SPDK_BS_PAGE_SIZE, 0, NULL, SPDK_ENV_SOCKET_ID_ANY,
+						SPDK_MALLOC_DMA);
+		if (!ctx->extent_page) {
+			spdk_free(ctx->buf);
+			free(ctx);
+			cb_fn(cb_arg, -ENOMEM);
+			return;
+		}
+	}
+
+	ctx->blob = blob;
+	ctx->channel = channel;
+	ctx->period_us = clusters_per_sec ? SPDK_SEC_TO_USEC / clusters_per_sec : 0;
+	ctx->prev_cluster_num = UINT32_MAX;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	blob->locked_operation_in_progress = true;
+	blob_defrag_next(ctx);
+}
+
+/* END spdk_blob_defragment */
+
+/* START spdk_bs_set_read_cache */
+struct bs_read_cache_set_ctx {
+	struct spdk_blob_store	*bs;
+	struct bs_read_cache	*cache;
+	spdk_bs_op_complete	cb_fn;
+	void			*cb_arg;
+};
+
+static void
+bs_read_cache_attach_channel(struct spdk_io_channel_iter *i)
+{
+	struct bs_read_cache_set_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_bs_channel *ch = spdk_io_channel_get_ctx(spdk_io_channel_iter_get_channel(i));
+
+	/* Channels created since the cache was set already have it */
+	if (ch->read_cache_channel == NULL) {
+		ch->read_cache_channel = bs_read_cache_channel_create(ctx->cache);
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+bs_read_cache_channel_drained(void *cb_arg)
+{
+	struct spdk_io_channel_iter *i = cb_arg;
+	struct spdk_bs_channel *ch = spdk_io_channel_get_ctx(spdk_io_channel_iter_get_channel(i));
+
+	bs_read_cache_channel_destroy(ch->read_cache_channel);
+	ch->read_cache_channel = NULL;
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+bs_read_cache_detach_channel(struct spdk_io_channel_iter *i)
+{
+	struct spdk_bs_channel *ch = spdk_io_channel_get_ctx(spdk_io_channel_iter_get_channel(i));
+
+	if (ch->read_cache_channel == NULL) {
+		spdk_for_each_channel_continue(i, 0);
+		return;
+	}
+
+	bs_read_cache_channel_drain(ch->read_cache_channel, bs_read_cache_channel_drained, i);
+}
+
+static void
+bs_read_cache_set_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct bs_read_cache_set_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	if (ctx->bs->read_cache == NULL) {
+		bs_read_cache_free(ctx->cache);
+	}
+
+	ctx->cb_fn(ctx->cb_arg, status);
+	free(ctx);
+}
+
+void
+spdk_bs_set_read_cache(struct spdk_blob_store *bs, struct spdk_bs_dev *cache_dev,
+		       spdk_bs_op_complete cb_fn, void *cb_arg)
+{
+	struct bs_read_cache_set_ctx *ctx;
+	int rc;
+
+	assert(spdk_get_thread() == bs->md_thread);
+
+	if ((cache_dev != NULL) == (bs->read_cache != NULL)) {
+		cb_fn(cb_arg, cache_dev != NULL ? -EBUSY : -ENOENT);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+	ctx->bs = bs;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	if (cache_dev == NULL) {
+		ctx->cache = bs->read_cache;
+		bs->read_cache = NULL;
+		spdk_for_each_channel(bs, bs_read_cache_detach_channel, ctx, bs_read_cache_set_done);
+		return;
+	}
+
+	rc = bs_read_cache_create(bs, cache_dev, &ctx->cache);
+	if (rc != 0) {
+		free(ctx);
+		cb_fn(cb_arg, rc);
+		return;
+	}
+
+	bs->read_cache = ctx->cache;
+	spdk_for_each_channel(bs, bs_read_cache_attach_channel, ctx, bs_read_cache_set_done);
+}
+
+/* END spdk_bs_set_read_cache */
+
+/* START spdk_blob_resize */
+struct spdk_bs_resize_ctx {
+	spdk_blob_op_complete cb_fn;
+	void *cb_arg;
+	struct spdk_blob *blob;
+	uint64_t sz;
+	int rc;
+};
+
+static void
+bs_resize_unfreeze_cpl(void *cb_arg, int rc)
+{
+	struct spdk_bs_resize_ctx *ctx = (struct spdk_bs_resize_ctx *)cb_arg;
 
 	if (rc != 0) {
 		SPDK_ERRLOG("Unfreeze failed, rc=%d\n", rc);
@@ -6948,10 +8175,21 @@ bs_resize_unfreeze_cpl(void *cb_arg, int rc)
 	free(ctx);
 }
 
+static void
+bs_resize_cluster_slabs_reclaimed(void *cb_arg, int rc)
+{
+	struct spdk_bs_resize_ctx *ctx = (struct spdk_bs_resize_ctx *)cb_arg;
+
+	ctx->rc = rc != 0 ? rc : blob_resize(ctx->blob, ctx->sz);
+
+	blob_unfreeze_io(ctx->blob, bs_resize_unfreeze_cpl, ctx);
+}
+
 static void
 bs_resize_freeze_cpl(void *cb_arg, int rc)
 {
 	struct spdk_bs_resize_ctx *ctx = (struct spdk_bs_resize_ctx *)cb_arg;
+	struct spdk_blob *blob = ctx->blob;
 
 	if (rc != 0) {
 		ctx->blob->locked_operation_in_progress = false;
@@ -6960,6 +8198,12 @@ bs_resize_freeze_cpl(void *cb_arg, int rc)
 		return;
 	}
 
+	if (!spdk_blob_is_thin_provisioned(blob) && ctx->sz > blob->active.num_clusters &&
+	    bs_cluster_slabs_needed(blob->bs, ctx->sz - blob->active.num_clusters)) {
+		bs_reclaim_cluster_slabs(blob->bs, bs_resize_cluster_slabs_reclaimed, ctx);
+		return;
+	}
+
 	ctx->rc = blob_resize(ctx->blob, ctx->sz);
 
 	blob_unfreeze_io(ctx->blob, bs_resize_unfreeze_cpl, ctx);
@@ -7032,6 +8276,10 @@ bs_delete_persist_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		return;
 	}
 
+	if (blob->bs->read_cache != NULL) {
+		bs_read_cache_invalidate(blob->bs->read_cache, blob->id);
+	}
+
 	/*
 	 * This will immediately decrement the ref_count and call
 	 *  the completion routine since the metadata state is clean.
@@ -7614,6 +8862,7 @@ bs_open_blob_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_blob *blob = cb_arg;
 	struct spdk_blob *existing;
+	struct spdk_bs_md_prefetch *prefetch;
 
 	if (bserrno != 0) {
 		blob_free(blob);
@@ -7633,6 +8882,12 @@ bs_open_blob_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 
 	blob->open_ref++;
 
+	/* The md of an open blob can change, so a page read ahead of this open is stale */
+	prefetch = bs_md_prefetch_find(blob->bs, bs_blobid_to_page(blob->id));
+	if (prefetch != NULL) {
+		bs_md_prefetch_drop(prefetch);
+	}
+
 	spdk_bit_array_set(blob->bs->open_blobids, blob->id);
 	RB_INSERT(spdk_blob_tree, &blob->bs->open_blobs, blob);
 
@@ -7813,6 +9068,9 @@ struct spdk_blob_insert_cluster_ctx {
 	int			rc;
 	spdk_blob_op_complete	cb_fn;
 	void			*cb_arg;
+	/* Inserts persisted together with this one */
+	TAILQ_HEAD(, spdk_blob_insert_cluster_ctx) batch;
+	TAILQ_ENTRY(spdk_blob_insert_cluster_ctx) link;
 };
 
 static void
@@ -7917,10 +9175,81 @@ blob_write_extent_page(struct spdk_blob *blob, uint32_t extent, uint64_t cluster
 	bs_mark_dirty(seq, blob->bs, blob_write_extent_page_ready, ctx);
 }
 
+static void
+blob_insert_cluster_batch_cb(void *arg, int bserrno)
+{
+	struct spdk_blob_insert_cluster_ctx *ctx = arg, *tmp;
+
+	while ((tmp = TAILQ_FIRST(&ctx->batch)) != NULL) {
+		TAILQ_REMOVE(&ctx->batch, tmp, link);
+		blob_insert_cluster_msg_cb(tmp, bserrno);
+	}
+
+	blob_insert_cluster_msg_cb(ctx, bserrno);
+}
+
+static bool
+blob_insert_cluster_same_md(struct spdk_blob_insert_cluster_ctx *ctx,
+			    struct spdk_blob_insert_cluster_ctx *other)
+{
+	if (ctx->blob != other->blob) {
+		return false;
+	}
+
+	if (!ctx->blob->use_extent_table) {
+		return true;
+	}
+
+	return bs_cluster_to_extent_page(ctx->blob, ctx->cluster_num) ==
+	       bs_cluster_to_extent_page(other->blob, other->cluster_num);
+}
+
+/*
+ * Persist the cluster inserts that arrived on the md thread since the last call. All the inserts
+ * into one blob (or into one extent page of it, when the extent table is used) share a single md
+ * sync, so a burst of first writes doesn't turn into a burst of md writes for the same pages.
+ */
+static void
+bs_insert_clusters_flush(void *arg)
+{
+	struct spdk_blob_store *bs = arg;
+	struct spdk_blob_insert_cluster_ctx *ctx, *other, *tmp;
+	TAILQ_HEAD(, spdk_blob_insert_cluster_ctx) inserts;
+	uint32_t *extent_page;
+
+	TAILQ_INIT(&inserts);
+	TAILQ_SWAP(&bs->pending_cluster_inserts, &inserts, spdk_blob_insert_cluster_ctx, link);
+
+	while ((ctx = TAILQ_FIRST(&inserts)) != NULL) {
+		TAILQ_REMOVE(&inserts, ctx, link);
+
+		TAILQ_FOREACH_SAFE(other, &inserts, link, tmp) {
+			if (blob_insert_cluster_same_md(ctx, other)) {
+				TAILQ_REMOVE(&inserts, other, link);
+				TAILQ_INSERT_TAIL(&ctx->batch, other, link);
+			}
+		}
+
+		if (ctx->blob->use_extent_table == false) {
+			/* Extent table is not used, proceed with sync of md that will only use
+			 * extents_rle. */
+			ctx->blob->state = SPDK_BLOB_STATE_DIRTY;
+			blob_sync_md(ctx->blob, blob_insert_cluster_batch_cb, ctx);
+		} else {
+			/* Extent page already allocated. The whole page is serialized from the
+			 * blob, so a single write covers all the clusters inserted into it. */
+			extent_page = bs_cluster_to_extent_page(ctx->blob, ctx->cluster_num);
+			blob_write_extent_page(ctx->blob, *extent_page, ctx->cluster_num, ctx->page,
+					       blob_insert_cluster_batch_cb, ctx);
+		}
+	}
+}
+
 static void
 blob_insert_cluster_msg(void *arg)
 {
 	struct spdk_blob_insert_cluster_ctx *ctx = arg;
+	struct spdk_blob_store *bs = ctx->blob->bs;
 	uint32_t *extent_page;
 
 	ctx->rc = blob_insert_cluster(ctx->blob, ctx->cluster_num, ctx->cluster);
@@ -7929,37 +9258,35 @@ blob_insert_cluster_msg(void *arg)
 		return;
 	}
 
-	if (ctx->blob->use_extent_table == false) {
-		/* Extent table is not used, proceed with sync of md that will only use extents_rle. */
-		ctx->blob->state = SPDK_BLOB_STATE_DIRTY;
-		blob_sync_md(ctx->blob, blob_insert_cluster_msg_cb, ctx);
-		return;
-	}
+	if (ctx->blob->use_extent_table) {
+		extent_page = bs_cluster_to_extent_page(ctx->blob, ctx->cluster_num);
+		if (*extent_page == 0) {
+			/* Extent page requires allocation.
+			 * It was already claimed in the used_md_pages map and placed in ctx. */
+			assert(ctx->extent_page != 0);
+			assert(spdk_bit_array_get(bs->used_md_pages, ctx->extent_page) == true);
+			blob_write_extent_page(ctx->blob, ctx->extent_page, ctx->cluster_num,
+					       ctx->page, blob_insert_new_ep_cb, ctx);
+			return;
+		}
 
-	extent_page = bs_cluster_to_extent_page(ctx->blob, ctx->cluster_num);
-	if (*extent_page == 0) {
-		/* Extent page requires allocation.
-		 * It was already claimed in the used_md_pages map and placed in ctx. */
-		assert(ctx->extent_page != 0);
-		assert(spdk_bit_array_get(ctx->blob->bs->used_md_pages, ctx->extent_page) == true);
-		blob_write_extent_page(ctx->blob, ctx->extent_page, ctx->cluster_num, ctx->page,
-				       blob_insert_new_ep_cb, ctx);
-	} else {
 		/* It is possible for original thread to allocate extent page for
 		 * different cluster in the same extent page. In such case proceed with
 		 * updating the existing extent page, but release the additional one. */
 		if (ctx->extent_page != 0) {
-			spdk_spin_lock(&ctx->blob->bs->used_lock);
-			assert(spdk_bit_array_get(ctx->blob->bs->used_md_pages, ctx->extent_page) == true);
-			bs_release_md_page(ctx->blob->bs, ctx->extent_page);
-			spdk_spin_unlock(&ctx->blob->bs->used_lock);
+			spdk_spin_lock(&bs->used_lock);
+			assert(spdk_bit_array_get(bs->used_md_pages, ctx->extent_page) == true);
+			bs_release_md_page(bs, ctx->extent_page);
+			spdk_spin_unlock(&bs->used_lock);
 			ctx->extent_page = 0;
 		}
-		/* Extent page already allocated.
-		 * Every cluster allocation, requires just an update of single extent page. */
-		blob_write_extent_page(ctx->blob, *extent_page, ctx->cluster_num, ctx->page,
-				       blob_insert_cluster_msg_cb, ctx);
 	}
+
+	/* Give the inserts already queued on the md thread a chance to join this one */
+	if (TAILQ_EMPTY(&bs->pending_cluster_inserts)) {
+		spdk_thread_send_msg(bs->md_thread, bs_insert_clusters_flush, bs);
+	}
+	TAILQ_INSERT_TAIL(&bs->pending_cluster_inserts, ctx, link);
 }
 
 static void
@@ -7983,6 +9310,7 @@ blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
 	ctx->page = page;
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
+	TAILQ_INIT(&ctx->batch);
 
 	spdk_thread_send_msg(blob->bs->md_thread, blob_insert_cluster_msg, ctx);
 }
@@ -8157,6 +9485,41 @@ struct spdk_bs_iter_ctx {
 	void *cb_arg;
 };
 
+/* Read ahead the first md page of up to iter_prefetch_depth blobs following page_num */
+static void
+bs_iter_prefetch(struct spdk_blob_store *bs, uint64_t page_num)
+{
+	struct spdk_bs_md_prefetch *prefetch, *tmp;
+	uint64_t next = page_num;
+
+	/* Drop the pages the iteration moved past, e.g. of blobs deleted in the meantime */
+	TAILQ_FOREACH_SAFE(prefetch, &bs->md_prefetches, link, tmp) {
+		if (prefetch->page_num < page_num) {
+			bs_md_prefetch_drop(prefetch);
+		}
+	}
+
+	prefetch = TAILQ_LAST(&bs->md_prefetches, spdk_bs_md_prefetch_tailq);
+	if (prefetch != NULL) {
+		next = spdk_max(next, prefetch->page_num);
+	}
+
+	while (bs->num_md_prefetches < bs->iter_prefetch_depth) {
+		next = spdk_bit_array_find_first_set(bs->used_blobids, next + 1);
+		if (next >= spdk_bit_array_capacity(bs->used_blobids)) {
+			break;
+		}
+
+		if (blob_lookup(bs, bs_page_to_blobid(next)) != NULL) {
+			continue;
+		}
+
+		if (bs_md_prefetch(bs, next) != 0) {
+			break;
+		}
+	}
+}
+
 static void
 bs_iter_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 {
@@ -8180,6 +9543,7 @@ bs_iter_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 
 	id = bs_page_to_blobid(ctx->page_num);
 
+	bs_iter_prefetch(bs, ctx->page_num);
 	spdk_bs_open_blob(bs, id, bs_iter_cpl, ctx);
 }
 
@@ -9038,6 +10402,8 @@ static void
 blob_frozen_set_back_bs_dev(void *_ctx, struct spdk_blob *blob, int bserrno)
 {
 	struct set_bs_dev_ctx	*ctx = _ctx;
+	const void		*esnap_id;
+	size_t			id_len;
 
 	if (bserrno != 0) {
 		SPDK_ERRLOG("blob 0x%" PRIx64 ": failed to release old back_bs_dev with error %d\n",
@@ -9053,6 +10419,10 @@ blob_frozen_set_back_bs_dev(void *_ctx, struct spdk_blob *blob, int bserrno)
 
 	SPDK_NOTICELOG("blob 0x%" PRIx64 ": hotplugged back_bs_dev\n", blob->id);
 	blob->back_bs_dev = ctx->back_bs_dev;
+	if (blob_get_xattr_value(blob, BLOB_EXTERNAL_SNAPSHOT_ID, &esnap_id, &id_len, true) == 0) {
+		blob->back_bs_dev = bs_create_esnap_cache_dev(blob->bs, blob->back_bs_dev, esnap_id,
+				    id_len);
+	}
 	ctx->bserrno = 0;
 
 	blob_unfreeze_io(blob, blob_set_back_bs_dev_done, ctx);
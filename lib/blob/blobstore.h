@@ -25,8 +25,12 @@
 #define SPDK_BLOB_OPTS_NUM_MD_PAGES UINT32_MAX
 #define SPDK_BLOB_OPTS_MAX_MD_OPS 32
 #define SPDK_BLOB_OPTS_DEFAULT_CHANNEL_OPS 512
+#define SPDK_BLOB_OPTS_ITER_PREFETCH_DEPTH 16
 #define SPDK_BLOB_BLOBID_HIGH_BIT (1ULL << 32)
 
+/* Number of clusters a channel claims at once for thin provisioned allocations */
+#define SPDK_BS_CLUSTER_SLAB_SIZE 32
+
 struct spdk_xattr {
 	uint32_t	index;
 	uint16_t	value_len;
@@ -172,6 +176,8 @@ struct spdk_blob_store {
 	uint64_t			total_clusters;
 	uint64_t			total_data_clusters;
 	uint64_t			num_free_clusters;	/* Protected by used_lock */
+	/* Claimed, but not yet used, clusters in the channels' slabs. Atomic. */
+	uint64_t			num_slab_clusters;
 	uint64_t			pages_per_cluster;
 	uint8_t				pages_per_cluster_shift;
 	uint32_t			io_unit_size;
@@ -197,6 +203,21 @@ struct spdk_blob_store {
 	uint32_t			esnap_channels_unloading;
 	spdk_bs_op_complete		esnap_unload_cb_fn;
 	void				*esnap_unload_cb_arg;
+
+	/* Cluster inserts waiting to be persisted together, only accessed on md thread */
+	TAILQ_HEAD(, spdk_blob_insert_cluster_ctx) pending_cluster_inserts;
+
+	/* First md pages read ahead by the blob iterators, only accessed on md thread */
+	uint32_t			iter_prefetch_depth;
+	uint32_t			num_md_prefetches;
+	TAILQ_HEAD(spdk_bs_md_prefetch_tailq, spdk_bs_md_prefetch) md_prefetches;
+
+	/* Read caches shared by the esnap clones of each esnap, only accessed on md thread */
+	uint64_t			esnap_cache_size;
+	TAILQ_HEAD(, blob_esnap_cache)	esnap_caches;
+
+	/* Cache of read-only blob data on a separate device, set on md thread */
+	struct bs_read_cache		*read_cache;
 };
 
 struct spdk_bs_channel {
@@ -214,7 +235,14 @@ struct spdk_bs_channel {
 	TAILQ_HEAD(, spdk_bs_request_set) need_cluster_alloc;
 	TAILQ_HEAD(, spdk_bs_request_set) queued_io;
 
+	/* Clusters claimed ahead of time for thin provisioning, used without taking used_lock */
+	uint32_t			cluster_slab[SPDK_BS_CLUSTER_SLAB_SIZE];
+	uint32_t			cluster_slab_head;
+	uint32_t			cluster_slab_cnt;
+
 	RB_HEAD(blob_esnap_channel_tree, blob_esnap_channel) esnap_channels;
+
+	struct bs_read_cache_channel	*read_cache_channel;
 };
 
 /** operation type */
@@ -430,9 +458,24 @@ SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_super_block) == 0x1000, "Invalid super
 
 struct spdk_bs_dev *bs_create_zeroes_dev(void);
 struct spdk_bs_dev *bs_create_blob_bs_dev(struct spdk_blob *blob);
+struct spdk_bs_dev *bs_create_esnap_cache_dev(struct spdk_blob_store *bs, struct spdk_bs_dev *base,
+		const void *esnap_id, size_t id_len);
 struct spdk_io_channel *blob_esnap_get_io_channel(struct spdk_io_channel *ch,
 		struct spdk_blob *blob);
 
+int bs_read_cache_create(struct spdk_blob_store *bs, struct spdk_bs_dev *dev,
+			 struct bs_read_cache **cache);
+void bs_read_cache_free(struct bs_read_cache *cache);
+struct bs_read_cache_channel *bs_read_cache_channel_create(struct bs_read_cache *cache);
+void bs_read_cache_channel_drain(struct bs_read_cache_channel *ch,
+				 void (*cb_fn)(void *cb_arg), void *cb_arg);
+void bs_read_cache_channel_destroy(struct bs_read_cache_channel *ch);
+int bs_read_cache_readv(struct spdk_blob *blob, struct spdk_io_channel *channel,
+			struct iovec *iov, int iovcnt, uint64_t offset, uint64_t length,
+			spdk_blob_op_complete cb_fn, void *cb_arg,
+			struct spdk_blob_ext_io_opts *ext_io_opts);
+void bs_read_cache_invalidate(struct bs_read_cache *cache, spdk_blob_id blobid);
+
 /* Unit Conversions
  *
  * The blobstore works with several different units:
@@ -0,0 +1,377 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+/*
+ * Read-through cache in front of external snapshot devices.
+ *
+ * All esnap clones of a blobstore that refer to the same esnap ID share one cache, so blocks
+ * of a golden image that many clones read (e.g. while booting) are only read from the esnap
+ * device once. The cache is direct mapped, with lines of BLOB_ESNAP_CACHE_LINE_SIZE bytes.
+ * Reads that span more than a line, or that use memory domains, bypass it.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/blob.h"
+#include "spdk/env.h"
+#include "spdk/log.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#include "blobstore.h"
+
+#define BLOB_ESNAP_CACHE_LINE_SIZE	(64 * 1024)
+
+struct blob_esnap_cache {
+	TAILQ_ENTRY(blob_esnap_cache)	link;
+	struct spdk_blob_store		*bs;
+	uint32_t			ref;
+
+	void				*id;
+	size_t				id_len;
+
+	struct spdk_spinlock		lock;
+	uint32_t			num_lines;
+	/* Line number + 1 of the data held by each slot, 0 if empty. Protected by lock. */
+	uint64_t			*tags;
+	uint8_t				*buf;
+};
+
+struct blob_esnap_cache_dev {
+	struct spdk_bs_dev		bs_dev;
+	struct spdk_bs_dev		*base;
+	struct blob_esnap_cache		*cache;
+};
+
+struct blob_esnap_cache_read {
+	struct blob_esnap_cache_dev	*dev;
+	struct spdk_bs_dev_cb_args	base_cb_args;
+	struct spdk_bs_dev_cb_args	*cb_args;
+	/* Holds the payload of plain reads, whose iovec only lives on the stack */
+	struct iovec			single_iov;
+	struct iovec			*iov;
+	int				iovcnt;
+	uint64_t			offset;
+	uint64_t			length;
+	uint64_t			line;
+	uint8_t				*buf;
+};
+
+static struct blob_esnap_cache *
+blob_esnap_cache_get(struct spdk_blob_store *bs, const void *id, size_t id_len)
+{
+	struct blob_esnap_cache *cache;
+
+	TAILQ_FOREACH(cache, &bs->esnap_caches, link) {
+		if (cache->id_len == id_len && memcmp(cache->id, id, id_len) == 0) {
+			cache->ref++;
+			return cache;
+		}
+	}
+
+	cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	cache->num_lines = bs->esnap_cache_size / BLOB_ESNAP_CACHE_LINE_SIZE;
+	cache->id = malloc(id_len);
+	cache->tags = calloc(cache->num_lines, sizeof(*cache->tags));
+	cache->buf = malloc((size_t)cache->num_lines * BLOB_ESNAP_CACHE_LINE_SIZE);
+	if (cache->id == NULL || cache->tags == NULL || cache->buf == NULL) {
+		free(cache->buf);
+		free(cache->tags);
+		free(cache->id);
+		free(cache);
+		return NULL;
+	}
+
+	memcpy(cache->id, id, id_len);
+	cache->id_len = id_len;
+	cache->bs = bs;
+	cache->ref = 1;
+	spdk_spin_init(&cache->lock);
+	TAILQ_INSERT_TAIL(&bs->esnap_caches, cache, link);
+
+	return cache;
+}
+
+static void
+blob_esnap_cache_put(struct blob_esnap_cache *cache)
+{
+	assert(cache->ref > 0);
+	if (--cache->ref > 0) {
+		return;
+	}
+
+	TAILQ_REMOVE(&cache->bs->esnap_caches, cache, link);
+	spdk_spin_destroy(&cache->lock);
+	free(cache->buf);
+	free(cache->tags);
+	free(cache->id);
+	free(cache);
+}
+
+/* Must be called with the cache lock held */
+static inline uint8_t *
+blob_esnap_cache_line(struct blob_esnap_cache *cache, uint64_t line)
+{
+	uint32_t slot = line % cache->num_lines;
+
+	if (cache->tags[slot] != line + 1) {
+		return NULL;
+	}
+
+	return cache->buf + (size_t)slot * BLOB_ESNAP_CACHE_LINE_SIZE;
+}
+
+static void
+blob_esnap_cache_read_cpl(struct spdk_io_channel *channel, void *cb_arg, int bserrno)
+{
+	struct blob_esnap_cache_read *req = cb_arg;
+	struct blob_esnap_cache *cache = req->dev->cache;
+	struct spdk_bs_dev_cb_args *cb_args = req->cb_args;
+	uint32_t slot;
+
+	if (bserrno == 0) {
+		slot = req->line % cache->num_lines;
+
+		spdk_spin_lock(&cache->lock);
+		memcpy(cache->buf + (size_t)slot * BLOB_ESNAP_CACHE_LINE_SIZE, req->buf,
+		       BLOB_ESNAP_CACHE_LINE_SIZE);
+		cache->tags[slot] = req->line + 1;
+		spdk_spin_unlock(&cache->lock);
+
+		spdk_copy_buf_to_iovs(req->iov, req->iovcnt,
+				      req->buf + req->offset % BLOB_ESNAP_CACHE_LINE_SIZE,
+				      req->length);
+	}
+
+	spdk_free(req->buf);
+	free(req);
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, bserrno);
+}
+
+/*
+ * Returns true if the read was handled through the cache, false if it has to go to the
+ * esnap device as it is.
+ */
+static bool
+blob_esnap_cache_read(struct blob_esnap_cache_dev *dev, struct spdk_io_channel *channel,
+		      struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+		      struct spdk_bs_dev_cb_args *cb_args)
+{
+	struct blob_esnap_cache *cache = dev->cache;
+	struct spdk_bs_dev *base = dev->base;
+	struct blob_esnap_cache_read *req;
+	uint64_t offset = lba * base->blocklen;
+	uint64_t length = (uint64_t)lba_count * base->blocklen;
+	uint64_t line = offset / BLOB_ESNAP_CACHE_LINE_SIZE;
+	uint8_t *data;
+
+	if (line != (offset + length - 1) / BLOB_ESNAP_CACHE_LINE_SIZE ||
+	    (line + 1) * BLOB_ESNAP_CACHE_LINE_SIZE > base->blockcnt * base->blocklen) {
+		/* Only reads within a line that is entirely on the device are cached */
+		return false;
+	}
+
+	spdk_spin_lock(&cache->lock);
+	data = blob_esnap_cache_line(cache, line);
+	if (data != NULL) {
+		spdk_copy_buf_to_iovs(iov, iovcnt, data + offset % BLOB_ESNAP_CACHE_LINE_SIZE,
+				      length);
+		spdk_spin_unlock(&cache->lock);
+		cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, 0);
+		return true;
+	}
+	spdk_spin_unlock(&cache->lock);
+
+	/* Miss, read the whole line and fill the cache with it */
+	req = calloc(1, sizeof(*req));
+	if (req == NULL) {
+		return false;
+	}
+
+	req->buf = spdk_malloc(BLOB_ESNAP_CACHE_LINE_SIZE, base->blocklen, NULL,
+			       SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (req->buf == NULL) {
+		free(req);
+		return false;
+	}
+
+	req->dev = dev;
+	req->cb_args = cb_args;
+	if (iovcnt == 1) {
+		req->single_iov = *iov;
+		iov = &req->single_iov;
+	}
+	req->iov = iov;
+	req->iovcnt = iovcnt;
+	req->offset = offset;
+	req->length = length;
+	req->line = line;
+	req->base_cb_args.cb_fn = blob_esnap_cache_read_cpl;
+	req->base_cb_args.channel = cb_args->channel;
+	req->base_cb_args.cb_arg = req;
+
+	base->read(base, channel, req->buf, line * BLOB_ESNAP_CACHE_LINE_SIZE / base->blocklen,
+		   BLOB_ESNAP_CACHE_LINE_SIZE / base->blocklen, &req->base_cb_args);
+	return true;
+}
+
+static void
+esnap_cache_dev_read(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel, void *payload,
+		     uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	struct blob_esnap_cache_dev *dev = (struct blob_esnap_cache_dev *)bs_dev;
+	struct iovec iov = {
+		.iov_base = payload,
+		.iov_len = (size_t)lba_count * dev->base->blocklen,
+	};
+
+	if (!blob_esnap_cache_read(dev, channel, &iov, 1, lba, lba_count, cb_args)) {
+		dev->base->read(dev->base, channel, payload, lba, lba_count, cb_args);
+	}
+}
+
+static void
+esnap_cache_dev_readv(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel,
+		      struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+		      struct spdk_bs_dev_cb_args *cb_args)
+{
+	struct blob_esnap_cache_dev *dev = (struct blob_esnap_cache_dev *)bs_dev;
+
+	if (!blob_esnap_cache_read(dev, channel, iov, iovcnt, lba, lba_count, cb_args)) {
+		dev->base->readv(dev->base, channel, iov, iovcnt, lba, lba_count, cb_args);
+	}
+}
+
+static void
+esnap_cache_dev_readv_ext(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel,
+			  struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+			  struct spdk_bs_dev_cb_args *cb_args,
+			  struct spdk_blob_ext_io_opts *ext_opts)
+{
+	struct blob_esnap_cache_dev *dev = (struct blob_esnap_cache_dev *)bs_dev;
+
+	/* The payload may not be accessible by the CPU */
+	dev->base->readv_ext(dev->base, channel, iov, iovcnt, lba, lba_count, cb_args, ext_opts);
+}
+
+static void
+esnap_cache_dev_write(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel, void *payload,
+		      uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, -EPERM);
+	assert(false);
+}
+
+static void
+esnap_cache_dev_writev(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel,
+		       struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+		       struct spdk_bs_dev_cb_args *cb_args)
+{
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, -EPERM);
+	assert(false);
+}
+
+static struct spdk_io_channel *
+esnap_cache_dev_create_channel(struct spdk_bs_dev *bs_dev)
+{
+	struct blob_esnap_cache_dev *dev = (struct blob_esnap_cache_dev *)bs_dev;
+
+	return dev->base->create_channel(dev->base);
+}
+
+static void
+esnap_cache_dev_destroy_channel(struct spdk_bs_dev *bs_dev, struct spdk_io_channel *channel)
+{
+	struct blob_esnap_cache_dev *dev = (struct blob_esnap_cache_dev *)bs_dev;
+
+	dev->base->destroy_channel(dev->base, channel);
+}
+
+static void
+esnap_cache_dev_destroy(struct spdk_bs_dev *bs_dev)
+{
+	struct blob_esnap_cache_dev *dev = (struct blob_esnap_cache_dev *)bs_dev;
+
+	blob_esnap_cache_put(dev->cache);
+	dev->base->destroy(dev->base);
+	free(dev);
+}
+
+static struct spdk_bdev *
+esnap_cache_dev_get_base_bdev(struct spdk_bs_dev *bs_dev)
+{
+	struct blob_esnap_cache_dev *dev = (struct blob_esnap_cache_dev *)bs_dev;
+
+	return dev->base->get_base_bdev ? dev->base->get_base_bdev(dev->base) : NULL;
+}
+
+static bool
+esnap_cache_dev_is_zeroes(struct spdk_bs_dev *bs_dev, uint64_t lba, uint64_t lba_count)
+{
+	struct blob_esnap_cache_dev *dev = (struct blob_esnap_cache_dev *)bs_dev;
+
+	return dev->base->is_zeroes(dev->base, lba, lba_count);
+}
+
+static bool
+esnap_cache_dev_translate_lba(struct spdk_bs_dev *bs_dev, uint64_t lba, uint64_t *base_lba)
+{
+	struct blob_esnap_cache_dev *dev = (struct blob_esnap_cache_dev *)bs_dev;
+
+	return dev->base->translate_lba(dev->base, lba, base_lba);
+}
+
+static bool
+esnap_cache_dev_is_degraded(struct spdk_bs_dev *bs_dev)
+{
+	struct blob_esnap_cache_dev *dev = (struct blob_esnap_cache_dev *)bs_dev;
+
+	return dev->base->is_degraded ? dev->base->is_degraded(dev->base) : false;
+}
+
+struct spdk_bs_dev *
+bs_create_esnap_cache_dev(struct spdk_blob_store *bs, struct spdk_bs_dev *base,
+			  const void *esnap_id, size_t id_len)
+{
+	struct blob_esnap_cache_dev *dev;
+
+	if (bs->esnap_cache_size < BLOB_ESNAP_CACHE_LINE_SIZE ||
+	    BLOB_ESNAP_CACHE_LINE_SIZE % base->blocklen != 0) {
+		return base;
+	}
+
+	dev = calloc(1, sizeof(*dev));
+	if (dev == NULL) {
+		return base;
+	}
+
+	dev->cache = blob_esnap_cache_get(bs, esnap_id, id_len);
+	if (dev->cache == NULL) {
+		SPDK_NOTICELOG("Failed to allocate the external snapshot cache, not using it\n");
+		free(dev);
+		return base;
+	}
+
+	dev->base = base;
+	dev->bs_dev.blockcnt = base->blockcnt;
+	dev->bs_dev.blocklen = base->blocklen;
+	dev->bs_dev.create_channel = esnap_cache_dev_create_channel;
+	dev->bs_dev.destroy_channel = esnap_cache_dev_destroy_channel;
+	dev->bs_dev.destroy = esnap_cache_dev_destroy;
+	dev->bs_dev.read = esnap_cache_dev_read;
+	dev->bs_dev.readv = esnap_cache_dev_readv;
+	dev->bs_dev.readv_ext = esnap_cache_dev_readv_ext;
+	dev->bs_dev.write = esnap_cache_dev_write;
+	dev->bs_dev.writev = esnap_cache_dev_writev;
+	dev->bs_dev.get_base_bdev = esnap_cache_dev_get_base_bdev;
+	dev->bs_dev.is_zeroes = esnap_cache_dev_is_zeroes;
+	dev->bs_dev.translate_lba = esnap_cache_dev_translate_lba;
+	dev->bs_dev.is_degraded = esnap_cache_dev_is_degraded;
+
+	return &dev->bs_dev;
+}
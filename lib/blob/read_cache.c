@@ -0,0 +1,471 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+/*
+ * Read cache for the data of read-only blobs, kept on a separate (faster) device.
+ *
+ * A read is looked up by the blob that holds its data, walking from the blob through its
+ * parent snapshots, so all the clones of a snapshot share the cached data. Only data of
+ * read-only blobs is cached, it can't change until the blob is deleted. The cache is direct
+ * mapped, with lines of BS_READ_CACHE_LINE_SIZE bytes, and the tags are kept in memory
+ * only. A miss that can fill a line reads the whole line through the blob, copies the
+ * requested part to the caller and writes the line to the cache device before completing.
+ * Reads that span more than a line, or that use memory domains, bypass it.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/blob.h"
+#include "spdk/env.h"
+#include "spdk/log.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#include "blobstore.h"
+
+#define BS_READ_CACHE_LINE_SIZE		(64 * 1024)
+/* Line fills in progress per channel, each holds a line sized buffer */
+#define BS_READ_CACHE_MAX_FILLS		8
+
+enum bs_read_cache_line_state {
+	BS_READ_CACHE_LINE_EMPTY,
+	BS_READ_CACHE_LINE_FILLING,
+	BS_READ_CACHE_LINE_VALID,
+};
+
+struct bs_read_cache_line {
+	spdk_blob_id			blobid;
+	uint32_t			line;
+	/* Hits reading from the slot, it can't be refilled until they complete */
+	uint16_t			readers;
+	/* Bumped on invalidation so that a fill in progress isn't marked valid */
+	uint8_t				gen;
+	uint8_t				state;
+};
+SPDK_STATIC_ASSERT(sizeof(struct bs_read_cache_line) == 16, "Incorrect size");
+
+struct bs_read_cache {
+	struct spdk_bs_dev		*dev;
+	uint64_t			num_lines;
+	uint64_t			io_units_per_line;
+	uint64_t			dev_blocks_per_line;
+	uint64_t			dev_blocks_per_io_unit;
+
+	struct spdk_spinlock		lock;
+	/* Protected by lock */
+	struct bs_read_cache_line	*lines;
+};
+
+struct bs_read_cache_channel {
+	struct bs_read_cache		*cache;
+	struct spdk_io_channel		*dev_channel;
+	uint32_t			outstanding;
+	uint32_t			fills;
+	/* Set while a request of the cache itself is submitted to the blob */
+	bool				bypass;
+
+	void				(*drain_cb_fn)(void *cb_arg);
+	void				*drain_cb_arg;
+};
+
+struct bs_read_cache_req {
+	struct bs_read_cache_channel	*ch;
+	struct spdk_blob		*blob;
+	struct spdk_io_channel		*channel;
+	spdk_blob_op_complete		cb_fn;
+	void				*cb_arg;
+
+	/* Holds the payload of plain reads, whose iovec only lives on the stack */
+	struct iovec			single_iov;
+	struct iovec			*iov;
+	int				iovcnt;
+	uint64_t			offset;
+	uint64_t			length;
+
+	spdk_blob_id			blobid;
+	uint64_t			line;
+	uint64_t			slot;
+	uint8_t				gen;
+	/* Whole line read through the blob, only for fills */
+	uint8_t				*buf;
+
+	struct spdk_bs_dev_cb_args	cb_args;
+};
+
+int
+bs_read_cache_create(struct spdk_blob_store *bs, struct spdk_bs_dev *dev,
+		     struct bs_read_cache **_cache)
+{
+	struct bs_read_cache *cache;
+
+	if (BS_READ_CACHE_LINE_SIZE % dev->blocklen != 0 || bs->io_unit_size % dev->blocklen != 0 ||
+	    bs->cluster_sz % BS_READ_CACHE_LINE_SIZE != 0) {
+		SPDK_ERRLOG("Read cache block size %" PRIu32 " doesn't fit the blobstore\n",
+			    dev->blocklen);
+		return -EINVAL;
+	}
+
+	cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		return -ENOMEM;
+	}
+
+	cache->num_lines = dev->blockcnt * dev->blocklen / BS_READ_CACHE_LINE_SIZE;
+	if (cache->num_lines == 0) {
+		free(cache);
+		return -EINVAL;
+	}
+
+	cache->lines = calloc(cache->num_lines, sizeof(*cache->lines));
+	if (cache->lines == NULL) {
+		free(cache);
+		return -ENOMEM;
+	}
+
+	cache->dev = dev;
+	cache->io_units_per_line = BS_READ_CACHE_LINE_SIZE / bs->io_unit_size;
+	cache->dev_blocks_per_line = BS_READ_CACHE_LINE_SIZE / dev->blocklen;
+	cache->dev_blocks_per_io_unit = bs->io_unit_size / dev->blocklen;
+	spdk_spin_init(&cache->lock);
+
+	*_cache = cache;
+	return 0;
+}
+
+void
+bs_read_cache_free(struct bs_read_cache *cache)
+{
+	cache->dev->destroy(cache->dev);
+	spdk_spin_destroy(&cache->lock);
+	free(cache->lines);
+	free(cache);
+}
+
+struct bs_read_cache_channel *
+bs_read_cache_channel_create(struct bs_read_cache *cache)
+{
+	struct bs_read_cache_channel *ch;
+
+	ch = calloc(1, sizeof(*ch));
+	if (ch == NULL) {
+		return NULL;
+	}
+
+	ch->dev_channel = cache->dev->create_channel(cache->dev);
+	if (ch->dev_channel == NULL) {
+		free(ch);
+		return NULL;
+	}
+	ch->cache = cache;
+
+	return ch;
+}
+
+void
+bs_read_cache_channel_drain(struct bs_read_cache_channel *ch, void (*cb_fn)(void *cb_arg),
+			    void *cb_arg)
+{
+	if (ch->outstanding == 0) {
+		cb_fn(cb_arg);
+		return;
+	}
+
+	ch->drain_cb_fn = cb_fn;
+	ch->drain_cb_arg = cb_arg;
+}
+
+void
+bs_read_cache_channel_destroy(struct bs_read_cache_channel *ch)
+{
+	assert(ch->outstanding == 0);
+
+	ch->cache->dev->destroy_channel(ch->cache->dev, ch->dev_channel);
+	free(ch);
+}
+
+void
+bs_read_cache_invalidate(struct bs_read_cache *cache, spdk_blob_id blobid)
+{
+	uint64_t i;
+
+	spdk_spin_lock(&cache->lock);
+	for (i = 0; i < cache->num_lines; i++) {
+		if (cache->lines[i].state != BS_READ_CACHE_LINE_EMPTY &&
+		    cache->lines[i].blobid == blobid) {
+			cache->lines[i].state = BS_READ_CACHE_LINE_EMPTY;
+			cache->lines[i].gen++;
+		}
+	}
+	spdk_spin_unlock(&cache->lock);
+}
+
+/*
+ * Returns the blob that holds the data of the io_unit: the blob itself if the cluster is
+ * allocated in it, or the first parent snapshot with the cluster allocated. NULL if it reads
+ * as zeroes or from an external snapshot.
+ */
+static struct spdk_blob *
+bs_read_cache_get_owner(struct spdk_blob *blob, uint64_t io_unit)
+{
+	while (io_unit < spdk_blob_get_num_io_units(blob)) {
+		if (bs_io_unit_is_allocated(blob, io_unit)) {
+			return blob;
+		}
+
+		if (blob->parent_id == SPDK_BLOBID_INVALID || spdk_blob_is_esnap_clone(blob)) {
+			break;
+		}
+
+		blob = ((struct spdk_blob_bs_dev *)blob->back_bs_dev)->blob;
+	}
+
+	return NULL;
+}
+
+static inline uint64_t
+bs_read_cache_slot(struct bs_read_cache *cache, spdk_blob_id blobid, uint64_t line)
+{
+	return (blobid * 0x9E3779B97F4A7C15ULL + line) % cache->num_lines;
+}
+
+static void
+bs_read_cache_req_complete(struct bs_read_cache_req *req, int bserrno)
+{
+	struct bs_read_cache_channel *ch = req->ch;
+
+	req->cb_fn(req->cb_arg, bserrno);
+	spdk_free(req->buf);
+	free(req);
+
+	assert(ch->outstanding > 0);
+	if (--ch->outstanding == 0 && ch->drain_cb_fn != NULL) {
+		ch->drain_cb_fn(ch->drain_cb_arg);
+	}
+}
+
+static void
+bs_read_cache_blob_cpl(void *cb_arg, int bserrno)
+{
+	bs_read_cache_req_complete(cb_arg, bserrno);
+}
+
+/* Read the requested range through the blob, as if there was no cache */
+static void
+bs_read_cache_read_blob(struct bs_read_cache_req *req)
+{
+	struct bs_read_cache_channel *ch = req->ch;
+
+	ch->bypass = true;
+	spdk_blob_io_readv(req->blob, req->channel, req->iov, req->iovcnt, req->offset,
+			   req->length, bs_read_cache_blob_cpl, req);
+	ch->bypass = false;
+}
+
+static void
+bs_read_cache_hit_cpl(struct spdk_io_channel *channel, void *cb_arg, int bserrno)
+{
+	struct bs_read_cache_req *req = cb_arg;
+	struct bs_read_cache *cache = req->ch->cache;
+	struct bs_read_cache_line *line = &cache->lines[req->slot];
+
+	spdk_spin_lock(&cache->lock);
+	assert(line->readers > 0);
+	line->readers--;
+	if (bserrno != 0 && line->gen == req->gen) {
+		line->state = BS_READ_CACHE_LINE_EMPTY;
+		line->gen++;
+	}
+	spdk_spin_unlock(&cache->lock);
+
+	if (bserrno != 0) {
+		SPDK_DEBUGLOG(blob, "Read cache read failed (%d), reading blob 0x%" PRIx64 "\n",
+			      bserrno, req->blob->id);
+		bs_read_cache_read_blob(req);
+		return;
+	}
+
+	bs_read_cache_req_complete(req, 0);
+}
+
+static void
+bs_read_cache_fill_cpl(struct spdk_io_channel *channel, void *cb_arg, int bserrno)
+{
+	struct bs_read_cache_req *req = cb_arg;
+	struct bs_read_cache *cache = req->ch->cache;
+	struct bs_read_cache_line *line = &cache->lines[req->slot];
+
+	spdk_spin_lock(&cache->lock);
+	if (line->gen == req->gen) {
+		assert(line->state == BS_READ_CACHE_LINE_FILLING);
+		line->state = bserrno == 0 ? BS_READ_CACHE_LINE_VALID : BS_READ_CACHE_LINE_EMPTY;
+	}
+	spdk_spin_unlock(&cache->lock);
+
+	req->ch->fills--;
+	/* The caller already has the data, a failed fill only leaves the line empty */
+	bs_read_cache_req_complete(req, 0);
+}
+
+static void
+bs_read_cache_fill_abort(struct bs_read_cache_req *req)
+{
+	struct bs_read_cache *cache = req->ch->cache;
+	struct bs_read_cache_line *line = &cache->lines[req->slot];
+
+	spdk_spin_lock(&cache->lock);
+	if (line->gen == req->gen) {
+		line->state = BS_READ_CACHE_LINE_EMPTY;
+		line->gen++;
+	}
+	spdk_spin_unlock(&cache->lock);
+
+	req->ch->fills--;
+}
+
+static void
+bs_read_cache_fill_read_cpl(void *cb_arg, int bserrno)
+{
+	struct bs_read_cache_req *req = cb_arg;
+	struct bs_read_cache *cache = req->ch->cache;
+	struct spdk_blob *owner;
+
+	if (bserrno != 0) {
+		bs_read_cache_fill_abort(req);
+		bs_read_cache_read_blob(req);
+		return;
+	}
+
+	spdk_copy_buf_to_iovs(req->iov, req->iovcnt,
+			      req->buf + (req->offset % cache->io_units_per_line) * req->blob->bs->io_unit_size,
+			      req->length * req->blob->bs->io_unit_size);
+
+	/*
+	 * A write to the blob may have allocated the cluster in the meantime. The data read is
+	 * still right for the caller, but it can't be cached as the data of the snapshot.
+	 */
+	owner = bs_read_cache_get_owner(req->blob, req->offset);
+	if (owner == NULL || owner->id != req->blobid) {
+		bs_read_cache_fill_abort(req);
+		bs_read_cache_req_complete(req, 0);
+		return;
+	}
+
+	req->cb_args.cb_fn = bs_read_cache_fill_cpl;
+	req->cb_args.cb_arg = req;
+	req->cb_args.channel = req->ch->dev_channel;
+	cache->dev->write(cache->dev, req->ch->dev_channel, req->buf,
+			  req->slot * cache->dev_blocks_per_line, cache->dev_blocks_per_line,
+			  &req->cb_args);
+}
+
+/*
+ * Returns 0 if the read was handled through the cache, -ENOENT if it has to go to the blob
+ * as it is.
+ */
+int
+bs_read_cache_readv(struct spdk_blob *blob, struct spdk_io_channel *channel,
+		    struct iovec *iov, int iovcnt, uint64_t offset, uint64_t length,
+		    spdk_blob_op_complete cb_fn, void *cb_arg,
+		    struct spdk_blob_ext_io_opts *ext_io_opts)
+{
+	struct spdk_bs_channel *bs_channel = spdk_io_channel_get_ctx(channel);
+	struct bs_read_cache_channel *ch = bs_channel->read_cache_channel;
+	struct bs_read_cache *cache;
+	struct bs_read_cache_line *line;
+	struct bs_read_cache_req *req;
+	struct spdk_blob *owner;
+	uint64_t line_num, slot;
+	bool hit, fill = false;
+
+	if (ch == NULL || ch->bypass || ch->drain_cb_fn != NULL ||
+	    (ext_io_opts != NULL && ext_io_opts->memory_domain != NULL)) {
+		return -ENOENT;
+	}
+
+	cache = ch->cache;
+	line_num = offset / cache->io_units_per_line;
+	if (line_num != (offset + length - 1) / cache->io_units_per_line) {
+		return -ENOENT;
+	}
+
+	owner = bs_read_cache_get_owner(blob, offset);
+	if (owner == NULL || !owner->data_ro) {
+		return -ENOENT;
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (req == NULL) {
+		return -ENOENT;
+	}
+
+	slot = bs_read_cache_slot(cache, owner->id, line_num);
+	line = &cache->lines[slot];
+
+	spdk_spin_lock(&cache->lock);
+	hit = line->state == BS_READ_CACHE_LINE_VALID && line->blobid == owner->id &&
+	      line->line == line_num;
+	if (hit) {
+		line->readers++;
+	} else if (ch->fills < BS_READ_CACHE_MAX_FILLS && line->readers == 0 &&
+		   line->state != BS_READ_CACHE_LINE_FILLING) {
+		line->blobid = owner->id;
+		line->line = line_num;
+		line->state = BS_READ_CACHE_LINE_FILLING;
+		line->gen++;
+		fill = true;
+	}
+	req->gen = line->gen;
+	spdk_spin_unlock(&cache->lock);
+
+	if (!hit && !fill) {
+		free(req);
+		return -ENOENT;
+	}
+
+	req->ch = ch;
+	req->blob = blob;
+	req->channel = channel;
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+	if (iovcnt == 1) {
+		req->single_iov = *iov;
+		iov = &req->single_iov;
+	}
+	req->iov = iov;
+	req->iovcnt = iovcnt;
+	req->offset = offset;
+	req->length = length;
+	req->blobid = owner->id;
+	req->line = line_num;
+	req->slot = slot;
+	ch->outstanding++;
+
+	if (hit) {
+		req->cb_args.cb_fn = bs_read_cache_hit_cpl;
+		req->cb_args.cb_arg = req;
+		req->cb_args.channel = ch->dev_channel;
+		cache->dev->readv(cache->dev, ch->dev_channel, iov, iovcnt,
+				  slot * cache->dev_blocks_per_line +
+				  (offset % cache->io_units_per_line) * cache->dev_blocks_per_io_unit,
+				  length * cache->dev_blocks_per_io_unit, &req->cb_args);
+		return 0;
+	}
+
+	ch->fills++;
+	req->buf = spdk_malloc(BS_READ_CACHE_LINE_SIZE, blob->bs->dev->blocklen, NULL,
+			       SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (req->buf == NULL) {
+		bs_read_cache_fill_abort(req);
+		bs_read_cache_read_blob(req);
+		return 0;
+	}
+
+	/* Miss, read the whole line through the blob and fill the cache with it */
+	ch->bypass = true;
+	spdk_blob_io_read(blob, channel, req->buf, line_num * cache->io_units_per_line,
+			  cache->io_units_per_line, bs_read_cache_fill_read_cpl, req);
+	ch->bypass = false;
+
+	return 0;
+}
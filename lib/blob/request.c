@@ -11,6 +11,7 @@
 
 #include "spdk/thread.h"
 #include "spdk/queue.h"
+#include "spdk/likely.h"
 
 #include "spdk/log.h"
 
@@ -58,6 +59,7 @@ bs_request_set_complete(struct spdk_bs_request_set *set)
 	struct spdk_bs_cpl cpl = set->cpl;
 	int bserrno = set->bserrno;
 
+	set->io_blob = NULL;
 	TAILQ_INSERT_TAIL(&set->channel->reqs, set, link);
 
 	bs_call_cpl(&cpl, bserrno);
@@ -100,6 +102,118 @@ bs_sequence_start(struct spdk_io_channel *_channel, struct spdk_bs_cpl *cpl,
 	return (spdk_bs_sequence_t *)set;
 }
 
+static void
+bs_direct_completion(struct spdk_io_channel *channel, void *cb_arg, int bserrno)
+{
+	struct spdk_bs_request_set *set = cb_arg;
+
+	set->bserrno = bserrno;
+	bs_request_set_complete(set);
+}
+
+static inline struct spdk_bs_request_set *
+bs_direct_start(struct spdk_io_channel *_channel, struct spdk_bs_cpl *cpl,
+		struct spdk_blob *blob)
+{
+	struct spdk_bs_channel		*channel = spdk_io_channel_get_ctx(_channel);
+	struct spdk_bs_request_set	*set;
+
+	set = TAILQ_FIRST(&channel->reqs);
+	if (spdk_unlikely(!set)) {
+		return NULL;
+	}
+	TAILQ_REMOVE(&channel->reqs, set, link);
+
+	set->cpl = *cpl;
+	set->bserrno = 0;
+	set->channel = channel;
+	set->back_channel = NULL;
+	set->io_blob = blob;
+
+	set->cb_args.cb_fn = bs_direct_completion;
+	set->cb_args.cb_arg = set;
+	set->cb_args.channel = channel->dev_channel;
+	set->ext_io_opts = NULL;
+
+	return set;
+}
+
+/*
+ * Use for blob IO that maps to a single IO on the blobstore device, i.e. IO within one
+ * allocated cluster. Unlike a sequence or a batch, the request completes straight from the
+ * device callback, and no esnap channel is looked up.
+ */
+int
+bs_direct_rw_dev(struct spdk_io_channel *_channel, struct spdk_bs_cpl *cpl,
+		 struct spdk_blob *blob, bool read, void *payload, uint64_t lba,
+		 uint32_t lba_count)
+{
+	struct spdk_bs_request_set	*set;
+	struct spdk_bs_channel		*channel;
+
+	set = bs_direct_start(_channel, cpl, blob);
+	if (spdk_unlikely(!set)) {
+		return -ENOMEM;
+	}
+	channel = set->channel;
+
+	if (read) {
+		SPDK_DEBUGLOG(blob_rw, "Reading %" PRIu32 " blocks from LBA %" PRIu64 "\n",
+			      lba_count, lba);
+		channel->dev->read(channel->dev, channel->dev_channel, payload, lba, lba_count,
+				   &set->cb_args);
+	} else {
+		SPDK_DEBUGLOG(blob_rw, "Writing %" PRIu32 " blocks to LBA %" PRIu64 "\n",
+			      lba_count, lba);
+		channel->dev->write(channel->dev, channel->dev_channel, payload, lba, lba_count,
+				    &set->cb_args);
+	}
+
+	return 0;
+}
+
+int
+bs_direct_rwv_dev(struct spdk_io_channel *_channel, struct spdk_bs_cpl *cpl,
+		  struct spdk_blob *blob, bool read, struct iovec *iov, int iovcnt,
+		  uint64_t lba, uint32_t lba_count, struct spdk_blob_ext_io_opts *ext_io_opts)
+{
+	struct spdk_bs_request_set	*set;
+	struct spdk_bs_dev		*dev;
+	struct spdk_io_channel		*dev_channel;
+
+	set = bs_direct_start(_channel, cpl, blob);
+	if (spdk_unlikely(!set)) {
+		return -ENOMEM;
+	}
+	dev = set->channel->dev;
+	dev_channel = set->channel->dev_channel;
+	set->ext_io_opts = ext_io_opts;
+
+	if (read) {
+		SPDK_DEBUGLOG(blob_rw, "Reading %" PRIu32 " blocks from LBA %" PRIu64 "\n",
+			      lba_count, lba);
+		if (ext_io_opts) {
+			assert(dev->readv_ext);
+			dev->readv_ext(dev, dev_channel, iov, iovcnt, lba, lba_count, &set->cb_args,
+				       ext_io_opts);
+		} else {
+			dev->readv(dev, dev_channel, iov, iovcnt, lba, lba_count, &set->cb_args);
+		}
+	} else {
+		SPDK_DEBUGLOG(blob_rw, "Writing %" PRIu32 " blocks to LBA %" PRIu64 "\n",
+			      lba_count, lba);
+		if (ext_io_opts) {
+			assert(dev->writev_ext);
+			dev->writev_ext(dev, dev_channel, iov, iovcnt, lba, lba_count, &set->cb_args,
+					ext_io_opts);
+		} else {
+			dev->writev(dev, dev_channel, iov, iovcnt, lba, lba_count, &set->cb_args);
+		}
+	}
+
+	return 0;
+}
+
 /* Use when performing IO directly on the blobstore (e.g. metadata - not a blob). */
 spdk_bs_sequence_t *
 bs_sequence_start_bs(struct spdk_io_channel *_channel, struct spdk_bs_cpl *cpl)
@@ -350,6 +464,7 @@ bs_batch_open(struct spdk_io_channel *_channel, struct spdk_bs_cpl *cpl, struct
 	set->bserrno = 0;
 	set->channel = channel;
 	set->back_channel = back_channel;
+	set->io_blob = blob;
 
 	set->u.batch.cb_fn = NULL;
 	set->u.batch.cb_arg = NULL;
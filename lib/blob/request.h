@@ -96,6 +96,12 @@ struct spdk_bs_request_set {
 	 */
 	struct spdk_io_channel		*back_channel;
 
+	/*
+	 * Blob whose clusters the request reads or writes on the blobstore device, until it
+	 * completes. NULL for other requests.
+	 */
+	struct spdk_blob		*io_blob;
+
 	struct spdk_bs_dev_cb_args	cb_args;
 
 	union {
@@ -174,6 +180,14 @@ void bs_sequence_finish(spdk_bs_sequence_t *seq, int bserrno);
 
 void bs_user_op_sequence_finish(void *cb_arg, int bserrno);
 
+int bs_direct_rw_dev(struct spdk_io_channel *channel, struct spdk_bs_cpl *cpl,
+		     struct spdk_blob *blob, bool read, void *payload, uint64_t lba,
+		     uint32_t lba_count);
+
+int bs_direct_rwv_dev(struct spdk_io_channel *channel, struct spdk_bs_cpl *cpl,
+		      struct spdk_blob *blob, bool read, struct iovec *iov, int iovcnt,
+		      uint64_t lba, uint32_t lba_count, struct spdk_blob_ext_io_opts *ext_io_opts);
+
 spdk_bs_batch_t *bs_batch_open(struct spdk_io_channel *channel,
 			       struct spdk_bs_cpl *cpl, struct spdk_blob *blob);
 
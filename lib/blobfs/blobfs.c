@@ -31,7 +31,6 @@
 
 static uint64_t g_fs_cache_size = BLOBFS_DEFAULT_CACHE_SIZE;
 static struct spdk_mempool *g_cache_pool;
-static TAILQ_HEAD(, spdk_file) g_caches = TAILQ_HEAD_INITIALIZER(g_caches);
 static struct spdk_poller *g_cache_pool_mgmt_poller;
 static struct spdk_thread *g_cache_pool_thread;
 #define BLOBFS_CACHE_POOL_POLL_PERIOD_IN_US 1000ULL
@@ -84,6 +83,9 @@ cache_buffer_free(struct cache_buffer *cache_buffer)
 }
 
 #define CACHE_READAHEAD_THRESHOLD	(128 * 1024)
+/* Readahead window in cache buffers, when sequential reads start and at most */
+#define CACHE_READAHEAD_MIN_BUFFERS	2
+#define CACHE_READAHEAD_MAX_BUFFERS	8
 
 struct spdk_file {
 	struct spdk_filesystem	*fs;
@@ -97,6 +99,7 @@ struct spdk_file {
 	uint64_t		append_pos;
 	uint64_t		seq_byte_count;
 	uint64_t		next_seq_offset;
+	uint32_t		readahead_buffers;
 	uint32_t		priority;
 	TAILQ_ENTRY(spdk_file)	tailq;
 	spdk_blob_id		blobid;
@@ -104,11 +107,29 @@ struct spdk_file {
 	pthread_spinlock_t	lock;
 	struct cache_buffer	*last;
 	struct cache_tree	*tree;
+	struct blobfs_cache_shard *cache_shard;
 	TAILQ_HEAD(open_requests_head, spdk_fs_request) open_requests;
 	TAILQ_HEAD(sync_requests_head, spdk_fs_request) sync_requests;
 	TAILQ_ENTRY(spdk_file)	cache_tailq;
 };
 
+/*
+ * Files with cache buffers, in the order they got them, spread over several lists so that
+ *  threads adding and reclaiming buffers of different files don't serialize on one lock.
+ *  The file lock may be held when taking the shard lock, the other way around only with
+ *  pthread_spin_trylock().
+ */
+#define BLOBFS_CACHE_SHARDS	8
+
+struct blobfs_cache_shard {
+	pthread_spinlock_t		lock;
+	TAILQ_HEAD(, spdk_file)		files;
+};
+
+static struct blobfs_cache_shard g_cache_shards[BLOBFS_CACHE_SHARDS];
+static uint32_t g_cache_shard_next;
+static uint32_t g_cache_reclaim_shard;
+
 struct spdk_deleted_file {
 	spdk_blob_id	id;
 	TAILQ_ENTRY(spdk_deleted_file)	tailq;
@@ -289,8 +310,14 @@ __stop_cache_pool_mgmt(void *ctx)
 static void
 initialize_global_cache(void)
 {
+	int i;
+
 	pthread_mutex_lock(&g_cache_init_lock);
 	if (g_fs_count == 0) {
+		for (i = 0; i < BLOBFS_CACHE_SHARDS; i++) {
+			pthread_spin_init(&g_cache_shards[i].lock, 0);
+			TAILQ_INIT(&g_cache_shards[i].files);
+		}
 		g_cache_pool_thread = spdk_thread_create("cache_pool_mgmt", NULL);
 		assert(g_cache_pool_thread != NULL);
 		spdk_thread_send_msg(g_cache_pool_thread, __start_cache_pool_mgmt, NULL);
@@ -629,6 +656,8 @@ file_alloc(struct spdk_filesystem *fs)
 	}
 
 	file->fs = fs;
+	file->cache_shard = &g_cache_shards[__atomic_fetch_add(&g_cache_shard_next, 1,
+					    __ATOMIC_RELAXED) % BLOBFS_CACHE_SHARDS];
 	TAILQ_INIT(&file->open_requests);
 	TAILQ_INIT(&file->sync_requests);
 	TAILQ_INSERT_TAIL(&fs->files, file, tailq);
@@ -1986,11 +2015,12 @@ spdk_fs_get_cache_size(void)
 
 static void __file_flush(void *ctx);
 
-/* Try to free some cache buffers from this file.
+/* Try to free some cache buffers from this file, with its shard locked.
  */
 static int
 reclaim_cache_buffers(struct spdk_file *file)
 {
+	struct blobfs_cache_shard *shard = file->cache_shard;
 	int rc;
 
 	BLOBFS_TRACE(file, "free=%s\n", file->name);
@@ -2010,10 +2040,10 @@ reclaim_cache_buffers(struct spdk_file *file)
 	}
 	tree_free_buffers(file->tree);
 
-	TAILQ_REMOVE(&g_caches, file, cache_tailq);
+	TAILQ_REMOVE(&shard->files, file, cache_tailq);
 	/* If not freed, put it in the end of the queue */
 	if (file->tree->present_mask != 0) {
-		TAILQ_INSERT_TAIL(&g_caches, file, cache_tailq);
+		TAILQ_INSERT_TAIL(&shard->files, file, cache_tailq);
 	} else {
 		file->last = NULL;
 	}
@@ -2022,68 +2052,111 @@ reclaim_cache_buffers(struct spdk_file *file)
 	return 0;
 }
 
-static int
-_blobfs_cache_pool_reclaim(void *arg)
+/* Returns true if buffers were freed from some file of the shard */
+static bool
+blobfs_cache_shard_reclaim(struct blobfs_cache_shard *shard)
 {
 	struct spdk_file *file, *tmp;
+	bool reclaimed = false;
 	int rc;
 
-	if (!blobfs_cache_pool_need_reclaim()) {
-		return SPDK_POLLER_IDLE;
-	}
+	pthread_spin_lock(&shard->lock);
 
-	TAILQ_FOREACH_SAFE(file, &g_caches, cache_tailq, tmp) {
+	TAILQ_FOREACH_SAFE(file, &shard->files, cache_tailq, tmp) {
 		if (!file->open_for_writing &&
 		    file->priority == SPDK_FILE_PRIORITY_LOW) {
 			rc = reclaim_cache_buffers(file);
 			if (rc < 0) {
 				continue;
 			}
+			reclaimed = true;
 			if (!blobfs_cache_pool_need_reclaim()) {
-				return SPDK_POLLER_BUSY;
+				goto out;
 			}
 			break;
 		}
 	}
 
-	TAILQ_FOREACH_SAFE(file, &g_caches, cache_tailq, tmp) {
+	TAILQ_FOREACH_SAFE(file, &shard->files, cache_tailq, tmp) {
 		if (!file->open_for_writing) {
 			rc = reclaim_cache_buffers(file);
 			if (rc < 0) {
 				continue;
 			}
+			reclaimed = true;
 			if (!blobfs_cache_pool_need_reclaim()) {
-				return SPDK_POLLER_BUSY;
+				goto out;
 			}
 			break;
 		}
 	}
 
-	TAILQ_FOREACH_SAFE(file, &g_caches, cache_tailq, tmp) {
+	TAILQ_FOREACH_SAFE(file, &shard->files, cache_tailq, tmp) {
 		rc = reclaim_cache_buffers(file);
 		if (rc < 0) {
 			continue;
 		}
+		reclaimed = true;
 		break;
 	}
 
+out:
+	pthread_spin_unlock(&shard->lock);
+	return reclaimed;
+}
+
+/* Returns true if buffers were freed, trying the given shard first */
+static bool
+blobfs_cache_reclaim(uint32_t first_shard)
+{
+	struct blobfs_cache_shard *shard;
+	uint32_t i;
+	bool reclaimed = false;
+
+	for (i = 0; i < BLOBFS_CACHE_SHARDS; i++) {
+		shard = &g_cache_shards[(first_shard + i) % BLOBFS_CACHE_SHARDS];
+		if (blobfs_cache_shard_reclaim(shard)) {
+			reclaimed = true;
+			if (!blobfs_cache_pool_need_reclaim()) {
+				break;
+			}
+		}
+	}
+
+	return reclaimed;
+}
+
+static int
+_blobfs_cache_pool_reclaim(void *arg)
+{
+	if (!blobfs_cache_pool_need_reclaim()) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	/* Start from a different shard each time, not to always drain the first ones */
+	blobfs_cache_reclaim(g_cache_reclaim_shard++);
+
 	return SPDK_POLLER_BUSY;
 }
 
 static void
-_add_file_to_cache_pool(void *ctx)
+file_cache_shard_add(struct spdk_file *file)
 {
-	struct spdk_file *file = ctx;
+	struct blobfs_cache_shard *shard = file->cache_shard;
 
-	TAILQ_INSERT_TAIL(&g_caches, file, cache_tailq);
+	pthread_spin_lock(&shard->lock);
+	TAILQ_INSERT_TAIL(&shard->files, file, cache_tailq);
+	pthread_spin_unlock(&shard->lock);
 }
 
 static void
-_remove_file_from_cache_pool(void *ctx)
+file_cache_shard_remove(struct spdk_file *file)
 {
-	struct spdk_file *file = ctx;
+	struct blobfs_cache_shard *shard = file->cache_shard;
 
-	TAILQ_REMOVE(&g_caches, file, cache_tailq);
+	pthread_spin_lock(&shard->lock);
+	TAILQ_REMOVE(&shard->files, file, cache_tailq);
+	pthread_spin_unlock(&shard->lock);
 }
 
 static struct cache_buffer *
@@ -2110,7 +2183,13 @@ cache_insert_buffer(struct spdk_file *file, uint64_t offset)
 			free(buf);
 			return NULL;
 		}
-		usleep(BLOBFS_CACHE_POOL_POLL_PERIOD_IN_US);
+		/*
+		 * Reclaim buffers right away rather than waiting for the cache pool thread,
+		 *  starting with the files sharing the shard of this one.
+		 */
+		if (!blobfs_cache_reclaim(file->cache_shard - g_cache_shards)) {
+			usleep(BLOBFS_CACHE_POOL_POLL_PERIOD_IN_US);
+		}
 	} while (true);
 
 	buf->buf_size = CACHE_BUFFER_SIZE;
@@ -2122,7 +2201,7 @@ cache_insert_buffer(struct spdk_file *file, uint64_t offset)
 	file->tree = tree_insert_buffer(file->tree, buf);
 
 	if (need_update) {
-		spdk_thread_send_msg(g_cache_pool_thread, _add_file_to_cache_pool, file);
+		file_cache_shard_add(file);
 	}
 
 	return buf;
@@ -2153,8 +2232,9 @@ static void
 __file_cache_finish_sync(void *ctx, int bserrno)
 {
 	struct spdk_file *file;
-	struct spdk_fs_request *sync_req = ctx;
+	struct spdk_fs_request *sync_req = ctx, *req, *tmp;
 	struct spdk_fs_cb_args *sync_args;
+	TAILQ_HEAD(, spdk_fs_request) done = TAILQ_HEAD_INITIALIZER(done);
 
 	sync_args = &sync_req->args;
 	file = sync_args->file;
@@ -2165,11 +2245,26 @@ __file_cache_finish_sync(void *ctx, int bserrno)
 			  0, file->name);
 	BLOBFS_TRACE(file, "sync done offset=%jx\n", sync_args->op.sync.offset);
 	TAILQ_REMOVE(&file->sync_requests, sync_req, args.op.sync.tailq);
+	TAILQ_INSERT_TAIL(&done, sync_req, args.op.sync.tailq);
+
+	/*
+	 * The length just persisted may cover other sync requests, e.g. of several writers
+	 *  syncing a log. Complete them together instead of updating the xattr for each one.
+	 */
+	TAILQ_FOREACH_SAFE(req, &file->sync_requests, args.op.sync.tailq, tmp) {
+		if (req->args.op.sync.offset <= file->length_xattr) {
+			assert(!req->args.op.sync.xattr_in_progress);
+			TAILQ_REMOVE(&file->sync_requests, req, args.op.sync.tailq);
+			TAILQ_INSERT_TAIL(&done, req, args.op.sync.tailq);
+		}
+	}
 	pthread_spin_unlock(&file->lock);
 
-	sync_args->fn.file_op(sync_args->arg, bserrno);
+	TAILQ_FOREACH_SAFE(req, &done, args.op.sync.tailq, tmp) {
+		req->args.fn.file_op(req->args.arg, bserrno);
+		free_fs_request(req);
+	}
 
-	free_fs_request(sync_req);
 	__check_sync_reqs(file);
 }
 
@@ -2592,16 +2687,57 @@ check_readahead(struct spdk_file *file, uint64_t offset,
 	file->fs->send_request(__readahead, req);
 }
 
-int64_t
-spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
-	       void *payload, uint64_t offset, uint64_t length)
+/*
+ * Scale the readahead window with the access pattern of the file: it opens once
+ *  CACHE_READAHEAD_THRESHOLD bytes were read sequentially, doubles each time the reads move
+ *  to the next cache buffer and closes on the first read that isn't sequential. The read
+ *  starting a new sequence doesn't count toward the threshold, so large random reads don't
+ *  trigger readahead.
+ */
+static void
+file_readahead(struct spdk_file *file, uint64_t offset, uint64_t length,
+	       struct spdk_fs_channel *channel)
+{
+	uint32_t i;
+
+	if (offset != file->next_seq_offset) {
+		file->seq_byte_count = 0;
+		file->readahead_buffers = 0;
+		file->next_seq_offset = offset + length;
+		return;
+	}
+
+	file->seq_byte_count += length;
+	file->next_seq_offset = offset + length;
+	if (file->seq_byte_count < CACHE_READAHEAD_THRESHOLD) {
+		return;
+	}
+
+	if (file->readahead_buffers == 0) {
+		file->readahead_buffers = CACHE_READAHEAD_MIN_BUFFERS;
+	} else if ((offset >> CACHE_BUFFER_SHIFT) != ((offset + length) >> CACHE_BUFFER_SHIFT)) {
+		file->readahead_buffers = spdk_min(file->readahead_buffers * 2,
+						   CACHE_READAHEAD_MAX_BUFFERS);
+	}
+
+	for (i = 0; i < file->readahead_buffers; i++) {
+		check_readahead(file, offset + i * CACHE_BUFFER_SIZE, channel);
+	}
+}
+
+/*
+ * Copy what is cached and send the rest to the dispatch thread, without waiting. Returns the
+ *  number of bytes that will be read, each of the sub_reads completions posts the channel
+ *  semaphore and errors are set in arg->rwerrno.
+ */
+static uint64_t
+file_read_submit(struct spdk_file *file, struct spdk_fs_channel *channel,
+		 void *payload, uint64_t offset, uint64_t length,
+		 struct rw_from_file_arg *arg, uint32_t *sub_reads)
 {
-	struct spdk_fs_channel *channel = (struct spdk_fs_channel *)ctx;
 	uint64_t final_offset, final_length;
-	uint32_t sub_reads = 0;
 	struct cache_buffer *buf;
 	uint64_t read_len;
-	struct rw_from_file_arg arg = {};
 
 	pthread_spin_lock(&file->lock);
 
@@ -2618,18 +2754,10 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 		length = file->append_pos - offset;
 	}
 
-	if (offset != file->next_seq_offset) {
-		file->seq_byte_count = 0;
-	}
-	file->seq_byte_count += length;
-	file->next_seq_offset = offset + length;
-	if (file->seq_byte_count >= CACHE_READAHEAD_THRESHOLD) {
-		check_readahead(file, offset, channel);
-		check_readahead(file, offset + CACHE_BUFFER_SIZE, channel);
-	}
+	file_readahead(file, offset, length, channel);
 
-	arg.channel = channel;
-	arg.rwerrno = 0;
+	arg->channel = channel;
+	arg->rwerrno = 0;
 	final_length = 0;
 	final_offset = offset + length;
 	while (offset < final_offset) {
@@ -2642,10 +2770,10 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 		buf = tree_find_filled_buffer(file->tree, offset);
 		if (buf == NULL) {
 			pthread_spin_unlock(&file->lock);
-			ret = __send_rw_from_file(file, payload, offset, length, true, &arg);
+			ret = __send_rw_from_file(file, payload, offset, length, true, arg);
 			pthread_spin_lock(&file->lock);
 			if (ret == 0) {
-				sub_reads++;
+				(*sub_reads)++;
 			}
 		} else {
 			read_len = length;
@@ -2657,7 +2785,7 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 			if ((offset + read_len) % CACHE_BUFFER_SIZE == 0) {
 				tree_remove_buffer(file->tree, buf);
 				if (file->tree->present_mask == 0) {
-					spdk_thread_send_msg(g_cache_pool_thread, _remove_file_from_cache_pool, file);
+					file_cache_shard_remove(file);
 				}
 			}
 		}
@@ -2665,13 +2793,27 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 		if (ret == 0) {
 			final_length += length;
 		} else {
-			arg.rwerrno = ret;
+			arg->rwerrno = ret;
 			break;
 		}
 		payload += length;
 		offset += length;
 	}
 	pthread_spin_unlock(&file->lock);
+
+	return final_length;
+}
+
+int64_t
+spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
+	       void *payload, uint64_t offset, uint64_t length)
+{
+	struct spdk_fs_channel *channel = (struct spdk_fs_channel *)ctx;
+	uint64_t final_length;
+	uint32_t sub_reads = 0;
+	struct rw_from_file_arg arg = {};
+
+	final_length = file_read_submit(file, channel, payload, offset, length, &arg, &sub_reads);
 	while (sub_reads > 0) {
 		sem_wait(&channel->sem);
 		sub_reads--;
@@ -2683,6 +2825,48 @@ spdk_file_read(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
 	}
 }
 
+int
+spdk_file_read_batch(struct spdk_file *file, struct spdk_fs_thread_ctx *ctx,
+		     struct spdk_file_read_req *reqs, size_t num_reqs)
+{
+	struct spdk_fs_channel *channel = (struct spdk_fs_channel *)ctx;
+	struct rw_from_file_arg *args;
+	uint32_t sub_reads = 0;
+	int rc = 0;
+	size_t i;
+
+	args = calloc(num_reqs, sizeof(*args));
+	if (args == NULL) {
+		for (i = 0; i < num_reqs; i++) {
+			reqs[i].rc = -ENOMEM;
+		}
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < num_reqs; i++) {
+		reqs[i].rc = file_read_submit(file, channel, reqs[i].payload, reqs[i].offset,
+					      reqs[i].length, &args[i], &sub_reads);
+	}
+
+	/* All the completions post the same semaphore, wait for them together */
+	while (sub_reads > 0) {
+		sem_wait(&channel->sem);
+		sub_reads--;
+	}
+
+	for (i = 0; i < num_reqs; i++) {
+		if (args[i].rwerrno != 0) {
+			reqs[i].rc = args[i].rwerrno;
+			if (rc == 0) {
+				rc = args[i].rwerrno;
+			}
+		}
+	}
+	free(args);
+
+	return rc;
+}
+
 static void
 _file_sync(struct spdk_file *file, struct spdk_fs_channel *channel,
 	   spdk_file_op_complete cb_fn, void *cb_arg)
@@ -2891,18 +3075,6 @@ spdk_file_get_id(struct spdk_file *file, void *id, size_t size)
 	return sizeof(spdk_blob_id);
 }
 
-static void
-_file_free(void *ctx)
-{
-	struct spdk_file *file = ctx;
-
-	TAILQ_REMOVE(&g_caches, file, cache_tailq);
-
-	free(file->name);
-	free(file->tree);
-	free(file);
-}
-
 static void
 file_free(struct spdk_file *file)
 {
@@ -2918,8 +3090,12 @@ file_free(struct spdk_file *file)
 
 	tree_free_buffers(file->tree);
 	assert(file->tree->present_mask == 0);
-	spdk_thread_send_msg(g_cache_pool_thread, _file_free, file);
+	file_cache_shard_remove(file);
 	pthread_spin_unlock(&file->lock);
+
+	free(file->name);
+	free(file->tree);
+	free(file);
 }
 
 SPDK_LOG_REGISTER_COMPONENT(blobfs)
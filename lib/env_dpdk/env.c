@@ -319,6 +319,12 @@ spdk_mempool_lookup(const char *name)
 	return (struct spdk_mempool *)rte_mempool_lookup(name);
 }
 
+struct spdk_mempool *
+spdk_mempool_from_obj(void *ele)
+{
+	return (struct spdk_mempool *)rte_mempool_from_obj(ele);
+}
+
 bool
 spdk_process_is_primary(void)
 {
@@ -101,6 +101,9 @@ struct spdk_mem_map {
 	struct map_256tb map_256tb;
 	pthread_mutex_t mutex;
 	uint64_t default_translation;
+	/* Bumped every time any translation in the map changes. Lets the per-thread
+	 * vtophys cache detect stale entries without taking the mutex. */
+	uint64_t generation;
 	struct spdk_mem_map_ops ops;
 	void *cb_ctx;
 	TAILQ_ENTRY(spdk_mem_map) tailq;
@@ -366,14 +369,11 @@ spdk_mem_register(void *vaddr, size_t len)
 	}
 
 	seg_vaddr = vaddr;
-	seg_len = 0;
-	while (len > 0) {
-		spdk_mem_map_set_translation(g_mem_reg_map, (uint64_t)vaddr, VALUE_2MB,
-					     seg_len == 0 ? REG_MAP_REGISTERED | REG_MAP_NOTIFY_START : REG_MAP_REGISTERED);
-		seg_len += VALUE_2MB;
-		vaddr += VALUE_2MB;
-		len -= VALUE_2MB;
-	}
+	seg_len = len;
+	spdk_mem_map_set_translation(g_mem_reg_map, (uint64_t)vaddr, VALUE_2MB,
+				     REG_MAP_REGISTERED | REG_MAP_NOTIFY_START);
+	spdk_mem_map_set_translation(g_mem_reg_map, (uint64_t)vaddr + VALUE_2MB, len - VALUE_2MB,
+				     REG_MAP_REGISTERED);
 
 	TAILQ_FOREACH(map, &g_spdk_mem_maps, tailq) {
 		rc = map->ops.notify_cb(map->cb_ctx, map, SPDK_MEM_MAP_NOTIFY_REGISTER, seg_vaddr, seg_len);
@@ -570,14 +570,19 @@ mem_map_get_map_1gb(struct spdk_mem_map *map, uint64_t vfn_2mb)
 	return map_1gb;
 }
 
-int
-spdk_mem_map_set_translation(struct spdk_mem_map *map, uint64_t vaddr, uint64_t size,
-			     uint64_t translation)
+/*
+ * Set the translation of every 2MB page in [vaddr, vaddr + size). The translation of
+ * each following page is the one of the previous page plus step, so a physically
+ * contiguous region (e.g. a whole 1GB hugepage) can be set in a single pass.
+ */
+static int
+mem_map_set_translation(struct spdk_mem_map *map, uint64_t vaddr, uint64_t size,
+			uint64_t translation, uint64_t step)
 {
 	uint64_t vfn_2mb;
 	struct map_1gb *map_1gb;
 	uint64_t idx_1gb;
-	struct map_2mb *map_2mb;
+	int rc = 0;
 
 	if ((uintptr_t)vaddr & ~MASK_256TB) {
 		DEBUG_PRINT("invalid usermode virtual address %" PRIu64 "\n", vaddr);
@@ -596,19 +601,30 @@ spdk_mem_map_set_translation(struct spdk_mem_map *map, uint64_t vaddr, uint64_t
 	while (size) {
 		map_1gb = mem_map_get_map_1gb(map, vfn_2mb);
 		if (!map_1gb) {
-			DEBUG_PRINT("could not get %p map\n", (void *)vaddr);
-			return -ENOMEM;
+			DEBUG_PRINT("could not get %p map\n", (void *)(vfn_2mb << SHIFT_2MB));
+			rc = -ENOMEM;
+			break;
 		}
 
-		idx_1gb = MAP_1GB_IDX(vfn_2mb);
-		map_2mb = &map_1gb->map[idx_1gb];
-		map_2mb->translation_2mb = translation;
-
-		size -= VALUE_2MB;
-		vfn_2mb++;
+		/* Fill in everything that falls into this 1GB map before looking up the next one */
+		for (idx_1gb = MAP_1GB_IDX(vfn_2mb); idx_1gb < SPDK_COUNTOF(map_1gb->map) && size; idx_1gb++) {
+			map_1gb->map[idx_1gb].translation_2mb = translation;
+			translation += step;
+			size -= VALUE_2MB;
+			vfn_2mb++;
+		}
 	}
 
-	return 0;
+	__atomic_fetch_add(&map->generation, 1, __ATOMIC_RELEASE);
+
+	return rc;
+}
+
+int
+spdk_mem_map_set_translation(struct spdk_mem_map *map, uint64_t vaddr, uint64_t size,
+			     uint64_t translation)
+{
+	return mem_map_set_translation(map, vaddr, size, translation, 0);
 }
 
 int
@@ -954,6 +970,42 @@ vtophys_get_paddr_memseg(uint64_t vaddr)
 	return SPDK_VTOPHYS_ERROR;
 }
 
+/*
+ * Set the translations for a range of DPDK-managed memory. Each hugepage is
+ * physically contiguous, so the memseg is looked up once per hugepage rather
+ * than once per 2MB, which matters with 1GB hugepages.
+ */
+static int
+vtophys_set_translation_memseg(struct spdk_mem_map *map, uint64_t vaddr, uint64_t len)
+{
+	struct rte_memseg *seg;
+	uint64_t paddr, seg_len;
+	int rc;
+
+	while (len > 0) {
+		seg = rte_mem_virt2memseg((void *)(uintptr_t)vaddr, NULL);
+		if (seg == NULL || seg->iova == RTE_BAD_IOVA) {
+			DEBUG_PRINT("could not get phys addr for %p\n", (void *)vaddr);
+			return -EFAULT;
+		}
+
+		paddr = seg->iova + (vaddr - seg->addr_64);
+		seg_len = (seg->addr_64 + seg->len - vaddr) & ~MASK_2MB;
+		/* Pages smaller than 2MB are still translated in 2MB units */
+		seg_len = spdk_min(spdk_max(seg_len, VALUE_2MB), len);
+
+		rc = mem_map_set_translation(map, vaddr, seg_len, paddr, VALUE_2MB);
+		if (rc != 0) {
+			return rc;
+		}
+
+		vaddr += seg_len;
+		len -= seg_len;
+	}
+
+	return 0;
+}
+
 /* Try to get the paddr from /proc/self/pagemap */
 static uint64_t
 vtophys_get_paddr_pagemap(uint64_t vaddr)
@@ -1096,14 +1148,9 @@ vtophys_notify(void *cb_ctx, struct spdk_mem_map *map,
 				if (rc) {
 					return -EFAULT;
 				}
-				while (len > 0) {
-					rc = spdk_mem_map_set_translation(map, (uint64_t)vaddr, VALUE_2MB, paddr);
-					if (rc != 0) {
-						return rc;
-					}
-					vaddr += VALUE_2MB;
-					paddr += VALUE_2MB;
-					len -= VALUE_2MB;
+				rc = mem_map_set_translation(map, (uint64_t)vaddr, len, paddr, VALUE_2MB);
+				if (rc != 0) {
+					return rc;
 				}
 			} else
 #endif
@@ -1152,20 +1199,9 @@ vtophys_notify(void *cb_ctx, struct spdk_mem_map *map,
 			}
 		} else {
 			/* This is an address managed by DPDK. Just setup the translations. */
-			while (len > 0) {
-				paddr = vtophys_get_paddr_memseg((uint64_t)vaddr);
-				if (paddr == SPDK_VTOPHYS_ERROR) {
-					DEBUG_PRINT("could not get phys addr for %p\n", vaddr);
-					return -EFAULT;
-				}
-
-				rc = spdk_mem_map_set_translation(map, (uint64_t)vaddr, VALUE_2MB, paddr);
-				if (rc != 0) {
-					return rc;
-				}
-
-				vaddr += VALUE_2MB;
-				len -= VALUE_2MB;
+			rc = vtophys_set_translation_memseg(map, (uint64_t)vaddr, len);
+			if (rc != 0) {
+				return rc;
 			}
 		}
 
@@ -1249,16 +1285,7 @@ vtophys_notify(void *cb_ctx, struct spdk_mem_map *map,
 			}
 		}
 #endif
-		while (len > 0) {
-			rc = spdk_mem_map_clear_translation(map, (uint64_t)vaddr, VALUE_2MB);
-			if (rc != 0) {
-				return rc;
-			}
-
-			vaddr += VALUE_2MB;
-			len -= VALUE_2MB;
-		}
-
+		rc = spdk_mem_map_clear_translation(map, (uint64_t)vaddr, len);
 		break;
 	default:
 		SPDK_UNREACHABLE();
@@ -1498,13 +1525,54 @@ vtophys_init(void)
 	return 0;
 }
 
+/*
+ * Last 2MB region translated by spdk_vtophys() on this thread. Consecutive
+ * lookups (e.g. one per page while building a PRP list) usually land in the
+ * same region, so this skips the walk through the map for most of them.
+ */
+struct vtophys_cache {
+	uint64_t vfn_2mb;
+	uint64_t paddr_2mb;
+	uint64_t generation;
+};
+
+static __thread struct vtophys_cache g_vtophys_cache = {
+	.vfn_2mb = UINT64_MAX,
+};
+
+static inline uint64_t
+vtophys_translate_2mb(uint64_t vaddr, uint64_t *size)
+{
+	struct vtophys_cache *cache = &g_vtophys_cache;
+	uint64_t vfn_2mb, generation, paddr_2mb;
+
+	vfn_2mb = vaddr >> SHIFT_2MB;
+	generation = __atomic_load_n(&g_vtophys_map->generation, __ATOMIC_ACQUIRE);
+
+	/* A cached entry is only good for lookups that end within its 2MB region.
+	 * Anything longer needs the contiguity walk in spdk_mem_map_translate(). */
+	if (spdk_likely(cache->vfn_2mb == vfn_2mb && cache->generation == generation) &&
+	    (size == NULL || *size <= VALUE_2MB - _2MB_OFFSET(vaddr))) {
+		return cache->paddr_2mb;
+	}
+
+	paddr_2mb = spdk_mem_map_translate(g_vtophys_map, vaddr, size);
+	if (paddr_2mb != SPDK_VTOPHYS_ERROR) {
+		cache->vfn_2mb = vfn_2mb;
+		cache->paddr_2mb = paddr_2mb;
+		cache->generation = generation;
+	}
+
+	return paddr_2mb;
+}
+
 uint64_t
 spdk_vtophys(const void *buf, uint64_t *size)
 {
 	uint64_t vaddr, paddr_2mb;
 
 	vaddr = (uint64_t)buf;
-	paddr_2mb = spdk_mem_map_translate(g_vtophys_map, vaddr, size);
+	paddr_2mb = vtophys_translate_2mb(vaddr, size);
 
 	/*
 	 * SPDK_VTOPHYS_ERROR has all bits set, so if the lookup returned SPDK_VTOPHYS_ERROR,
@@ -1520,6 +1588,27 @@ spdk_vtophys(const void *buf, uint64_t *size)
 	}
 }
 
+int
+spdk_vtophys_iovs(const struct iovec *iovs, int iovcnt, uint64_t *phys_addrs)
+{
+	uint64_t vaddr, paddr_2mb, len;
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		vaddr = (uint64_t)iovs[i].iov_base;
+		len = iovs[i].iov_len;
+
+		paddr_2mb = vtophys_translate_2mb(vaddr, &len);
+		if (spdk_unlikely(paddr_2mb == SPDK_VTOPHYS_ERROR || len != iovs[i].iov_len)) {
+			return -EFAULT;
+		}
+
+		phys_addrs[i] = paddr_2mb + (vaddr & MASK_2MB);
+	}
+
+	return 0;
+}
+
 int
 spdk_mem_get_fd_and_offset(void *vaddr, uint64_t *offset)
 {
@@ -39,6 +39,7 @@ struct spdk_app {
 	bool				stopped;
 	const char			*rpc_addr;
 	const char			**rpc_allowlist;
+	bool				rpc_thread;
 	int				shm_id;
 	spdk_app_shutdown_cb		shutdown_cb;
 	int				rc;
@@ -131,6 +132,10 @@ static const struct option g_cmdline_options[] = {
 	{"msg-mempool-size",		required_argument,	NULL, MSG_MEMPOOL_SIZE_OPT_IDX},
 #define LCORES_OPT_IDX	271
 	{"lcores",			required_argument,	NULL, LCORES_OPT_IDX},
+#define RPC_THREAD_OPT_IDX	272
+	{"rpc-thread",			no_argument,		NULL, RPC_THREAD_OPT_IDX},
+#define TIMER_WHEEL_OPT_IDX	273
+	{"timer-wheel",			no_argument,		NULL, TIMER_WHEEL_OPT_IDX},
 };
 
 static void
@@ -213,6 +218,8 @@ spdk_app_opts_init(struct spdk_app_opts *opts, size_t opts_size)
 	SET_FIELD(disable_signal_handlers, false);
 	SET_FIELD(msg_mempool_size, SPDK_DEFAULT_MSG_MEMPOOL_SIZE);
 	SET_FIELD(rpc_allowlist, NULL);
+	SET_FIELD(rpc_thread, false);
+	SET_FIELD(thread_timer_type, SPDK_THREAD_TIMER_RBTREE);
 #undef SET_FIELD
 }
 
@@ -264,6 +271,18 @@ app_start_application(void)
 	g_start_fn(g_start_arg);
 }
 
+static int
+app_rpc_initialize(void)
+{
+	spdk_rpc_set_allowlist(g_spdk_app.rpc_allowlist);
+
+	if (g_spdk_app.rpc_thread) {
+		return spdk_rpc_initialize_threaded(g_spdk_app.rpc_addr);
+	}
+
+	return spdk_rpc_initialize(g_spdk_app.rpc_addr);
+}
+
 static void
 app_start_rpc(int rc, void *arg1)
 {
@@ -272,9 +291,7 @@ app_start_rpc(int rc, void *arg1)
 		return;
 	}
 
-	spdk_rpc_set_allowlist(g_spdk_app.rpc_allowlist);
-
-	rc = spdk_rpc_initialize(g_spdk_app.rpc_addr);
+	rc = app_rpc_initialize();
 	if (rc) {
 		spdk_app_stop(rc);
 		return;
@@ -472,9 +489,7 @@ bootstrap_fn(void *arg1)
 		if (!g_delay_subsystem_init) {
 			spdk_subsystem_init(app_start_rpc, NULL);
 		} else {
-			spdk_rpc_set_allowlist(g_spdk_app.rpc_allowlist);
-
-			rc = spdk_rpc_initialize(g_spdk_app.rpc_addr);
+			rc = app_rpc_initialize();
 			if (rc) {
 				spdk_app_stop(rc);
 				return;
@@ -525,10 +540,12 @@ app_copy_opts(struct spdk_app_opts *opts, struct spdk_app_opts *opts_user, size_
 	SET_FIELD(msg_mempool_size);
 	SET_FIELD(rpc_allowlist);
 	SET_FIELD(vf_token);
+	SET_FIELD(rpc_thread);
+	SET_FIELD(thread_timer_type);
 
 	/* You should not remove this statement, but need to update the assert statement
 	 * if you add a new field, and also add a corresponding SET_FIELD statement */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_app_opts) == 224, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_app_opts) == 232, "Incorrect size");
 
 #undef SET_FIELD
 }
@@ -705,6 +722,7 @@ spdk_app_start(struct spdk_app_opts *opts_user, spdk_msg_fn start_fn,
 	g_spdk_app.json_config_ignore_errors = opts->json_config_ignore_errors;
 	g_spdk_app.rpc_addr = opts->rpc_addr;
 	g_spdk_app.rpc_allowlist = opts->rpc_allowlist;
+	g_spdk_app.rpc_thread = opts->rpc_thread;
 	g_spdk_app.shm_id = opts->shm_id;
 	g_spdk_app.shutdown_cb = opts->shutdown_cb;
 	g_spdk_app.rc = 0;
@@ -737,6 +755,11 @@ spdk_app_start(struct spdk_app_opts *opts_user, spdk_msg_fn start_fn,
 
 	SPDK_NOTICELOG("Total cores available: %d\n", spdk_env_get_core_count());
 
+	if (spdk_thread_lib_set_timer_type(opts->thread_timer_type) != 0) {
+		SPDK_ERRLOG("Invalid thread timer type %d\n", opts->thread_timer_type);
+		return 1;
+	}
+
 	if ((rc = spdk_reactors_init(opts->msg_mempool_size)) != 0) {
 		SPDK_ERRLOG("Reactor Initialization failed: rc = %d\n", rc);
 		return 1;
@@ -907,6 +930,8 @@ usage(void (*app_usage)(void))
 	       SPDK_APP_DEFAULT_NUM_TRACE_ENTRIES);
 	printf("                                 Tracepoints vary in size and can use more than one trace entry.\n");
 	printf("     --rpcs-allowed	   comma-separated list of permitted RPCS\n");
+	printf("     --rpc-thread          poll the RPC server on a dedicated thread\n");
+	printf("     --timer-wheel         keep track of timed pollers with a timer wheel\n");
 	printf("     --env-context         Opaque context for use of the env implementation\n");
 	printf("     --vfio-vf-token       VF token (UUID) shared between SR-IOV PF and VFs for vfio_pci driver\n");
 	spdk_log_usage(stdout, "-L");
@@ -1095,6 +1120,12 @@ spdk_app_parse_args(int argc, char **argv, struct spdk_app_opts *opts,
 		case WAIT_FOR_RPC_OPT_IDX:
 			opts->delay_subsystem_init = true;
 			break;
+		case RPC_THREAD_OPT_IDX:
+			opts->rpc_thread = true;
+			break;
+		case TIMER_WHEEL_OPT_IDX:
+			opts->thread_timer_type = SPDK_THREAD_TIMER_WHEEL;
+			break;
 		case PCI_BLOCKED_OPT_IDX:
 			if (opts->pci_allowed) {
 				free(opts->pci_allowed);
@@ -5,7 +5,9 @@
 
 #include "spdk/stdinc.h"
 
+#include "spdk/base64.h"
 #include "spdk/event.h"
+#include "spdk/histogram_data.h"
 #include "spdk/rpc.h"
 #include "spdk/string.h"
 #include "spdk/util.h"
@@ -171,6 +173,7 @@ _rpc_thread_get_stats(void *arg)
 	struct spdk_cpuset tmp_mask = {};
 	struct spdk_poller *poller;
 	struct spdk_thread_stats stats;
+	struct spdk_thread_intr_stats intr_stats;
 	uint64_t active_pollers_count = 0;
 	uint64_t timed_pollers_count = 0;
 	uint64_t paused_pollers_count = 0;
@@ -202,6 +205,16 @@ _rpc_thread_get_stats(void *arg)
 		spdk_json_write_named_uint64(ctx->w, "active_pollers_count", active_pollers_count);
 		spdk_json_write_named_uint64(ctx->w, "timed_pollers_count", timed_pollers_count);
 		spdk_json_write_named_uint64(ctx->w, "paused_pollers_count", paused_pollers_count);
+		if (spdk_thread_get_adaptive_interrupt() != 0) {
+			spdk_thread_get_intr_stats(thread, &intr_stats);
+			spdk_json_write_named_object_begin(ctx->w, "adaptive_interrupt");
+			spdk_json_write_named_uint64(ctx->w, "to_intr_count", intr_stats.to_intr_count);
+			spdk_json_write_named_uint64(ctx->w, "to_poll_count", intr_stats.to_poll_count);
+			spdk_json_write_named_uint64(ctx->w, "transition_ticks", intr_stats.transition_tsc);
+			spdk_json_write_named_uint64(ctx->w, "max_transition_ticks",
+						     intr_stats.max_transition_tsc);
+			spdk_json_write_object_end(ctx->w);
+		}
 		spdk_json_write_object_end(ctx->w);
 	}
 }
@@ -221,9 +234,34 @@ rpc_thread_get_stats(struct spdk_jsonrpc_request *request,
 
 SPDK_RPC_REGISTER("thread_get_stats", rpc_thread_get_stats, SPDK_RPC_RUNTIME)
 
+static void
+rpc_write_poller_histogram(const struct spdk_histogram_data *histogram,
+			   struct spdk_json_write_ctx *w)
+{
+	char *encoded_histogram;
+	size_t src_len, dst_len;
+
+	src_len = SPDK_HISTOGRAM_NUM_BUCKETS(histogram) * sizeof(uint64_t);
+	dst_len = spdk_base64_get_encoded_strlen(src_len) + 1;
+
+	encoded_histogram = malloc(dst_len);
+	if (encoded_histogram == NULL) {
+		SPDK_ERRLOG("Failed to allocate poller histogram\n");
+		return;
+	}
+
+	if (spdk_base64_encode(encoded_histogram, histogram->bucket, src_len) == 0) {
+		spdk_json_write_named_string(w, "histogram", encoded_histogram);
+		spdk_json_write_named_int64(w, "bucket_shift", histogram->bucket_shift);
+	}
+
+	free(encoded_histogram);
+}
+
 static void
 rpc_get_poller(struct spdk_poller *poller, struct spdk_json_write_ctx *w)
 {
+	const struct spdk_histogram_data *histogram;
 	struct spdk_poller_stats stats;
 	uint64_t period_ticks;
 
@@ -239,6 +277,10 @@ rpc_get_poller(struct spdk_poller *poller, struct spdk_json_write_ctx *w)
 	if (period_ticks) {
 		spdk_json_write_named_uint64(w, "period_ticks", period_ticks);
 	}
+	histogram = spdk_poller_get_histogram(poller);
+	if (histogram != NULL) {
+		rpc_write_poller_histogram(histogram, w);
+	}
 	spdk_json_write_object_end(w);
 }
 
@@ -292,6 +334,81 @@ rpc_thread_get_pollers(struct spdk_jsonrpc_request *request,
 
 SPDK_RPC_REGISTER("thread_get_pollers", rpc_thread_get_pollers, SPDK_RPC_RUNTIME)
 
+struct rpc_thread_monitor_poller_histograms {
+	bool enabled;
+};
+
+static const struct spdk_json_object_decoder rpc_thread_monitor_poller_histograms_decoders[] = {
+	{"enabled", offsetof(struct rpc_thread_monitor_poller_histograms, enabled), spdk_json_decode_bool},
+};
+
+static void
+rpc_thread_monitor_poller_histograms(struct spdk_jsonrpc_request *request,
+				     const struct spdk_json_val *params)
+{
+	struct rpc_thread_monitor_poller_histograms req = {};
+	struct spdk_json_write_ctx *w;
+
+	if (params != NULL) {
+		if (spdk_json_decode_object(params, rpc_thread_monitor_poller_histograms_decoders,
+					    SPDK_COUNTOF(rpc_thread_monitor_poller_histograms_decoders),
+					    &req)) {
+			SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+			return;
+		}
+
+		spdk_poller_enable_histograms(req.enabled);
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_bool(w, "enabled", spdk_poller_histograms_enabled());
+
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+SPDK_RPC_REGISTER("thread_monitor_poller_histograms", rpc_thread_monitor_poller_histograms,
+		  SPDK_RPC_RUNTIME)
+
+struct rpc_thread_set_adaptive_interrupt {
+	uint64_t idle_budget_us;
+};
+
+static const struct spdk_json_object_decoder rpc_thread_set_adaptive_interrupt_decoders[] = {
+	{"idle_budget_us", offsetof(struct rpc_thread_set_adaptive_interrupt, idle_budget_us), spdk_json_decode_uint64},
+};
+
+static void
+rpc_thread_set_adaptive_interrupt(struct spdk_jsonrpc_request *request,
+				  const struct spdk_json_val *params)
+{
+	struct rpc_thread_set_adaptive_interrupt req = {};
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_thread_set_adaptive_interrupt_decoders,
+				    SPDK_COUNTOF(rpc_thread_set_adaptive_interrupt_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "spdk_json_decode_object failed");
+		return;
+	}
+
+	rc = spdk_thread_set_adaptive_interrupt(req.idle_budget_us);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+
+SPDK_RPC_REGISTER("thread_set_adaptive_interrupt", rpc_thread_set_adaptive_interrupt,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
 static void
 rpc_get_io_channel(struct spdk_io_channel *ch, struct spdk_json_write_ctx *w)
 {
@@ -350,6 +467,11 @@ rpc_framework_get_reactors_done(void *arg1, void *arg2)
 
 #define GET_DELTA(end, start)	(end >= start ? end - start : 0)
 
+static const char *const g_reactor_event_policy_names[] = {
+	[SPDK_REACTOR_EVENT_POLICY_BATCH] = "batch",
+	[SPDK_REACTOR_EVENT_POLICY_DRAIN] = "drain",
+};
+
 static void
 _rpc_framework_get_reactors(void *arg1, void *arg2)
 {
@@ -372,6 +494,18 @@ _rpc_framework_get_reactors(void *arg1, void *arg2)
 	spdk_json_write_named_uint64(ctx->w, "busy", reactor->busy_tsc);
 	spdk_json_write_named_uint64(ctx->w, "idle", reactor->idle_tsc);
 	spdk_json_write_named_bool(ctx->w, "in_interrupt", reactor->in_interrupt);
+	spdk_json_write_named_uint32(ctx->w, "event_batch_size", reactor->event_batch_size);
+	spdk_json_write_named_string(ctx->w, "event_policy",
+				     g_reactor_event_policy_names[reactor->event_policy]);
+
+	spdk_json_write_named_object_begin(ctx->w, "event_stats");
+	spdk_json_write_named_uint64(ctx->w, "batches", reactor->event_stats.batch_count);
+	spdk_json_write_named_uint64(ctx->w, "events", reactor->event_stats.event_count);
+	spdk_json_write_named_uint64(ctx->w, "max_queue_depth",
+				     reactor->event_stats.max_queue_depth);
+	spdk_json_write_named_uint64(ctx->w, "event_ticks", reactor->event_stats.event_tsc);
+	spdk_json_write_named_uint64(ctx->w, "thread_ticks", reactor->event_stats.thread_tsc);
+	spdk_json_write_object_end(ctx->w);
 
 	governor = spdk_governor_get();
 	if (governor != NULL) {
@@ -432,6 +566,127 @@ rpc_framework_get_reactors(struct spdk_jsonrpc_request *request,
 
 SPDK_RPC_REGISTER("framework_get_reactors", rpc_framework_get_reactors, SPDK_RPC_RUNTIME)
 
+struct rpc_framework_set_reactor_event_opts {
+	struct spdk_jsonrpc_request *request;
+	uint32_t lcore;
+	uint32_t batch_size;
+	char *policy;
+	int policy_id;
+};
+
+static const struct spdk_json_object_decoder rpc_framework_set_reactor_event_opts_decoders[] = {
+	{"lcore", offsetof(struct rpc_framework_set_reactor_event_opts, lcore), spdk_json_decode_uint32, true},
+	{"batch_size", offsetof(struct rpc_framework_set_reactor_event_opts, batch_size), spdk_json_decode_uint32, true},
+	{"policy", offsetof(struct rpc_framework_set_reactor_event_opts, policy), spdk_json_decode_string, true},
+};
+
+static void
+free_rpc_framework_set_reactor_event_opts(struct rpc_framework_set_reactor_event_opts *req)
+{
+	free(req->policy);
+	free(req);
+}
+
+static void
+rpc_framework_set_reactor_event_opts_done(void *arg1, void *arg2)
+{
+	struct rpc_framework_set_reactor_event_opts *req = arg1;
+
+	spdk_jsonrpc_send_bool_response(req->request, true);
+	free_rpc_framework_set_reactor_event_opts(req);
+}
+
+static void
+_rpc_framework_set_reactor_event_opts(void *arg1, void *arg2)
+{
+	struct rpc_framework_set_reactor_event_opts *req = arg1;
+	struct spdk_reactor *reactor;
+
+	/* Each reactor updates its own settings, as they are read on every iteration. */
+	reactor = spdk_reactor_get(spdk_env_get_current_core());
+	assert(reactor != NULL);
+
+	if (req->lcore != UINT32_MAX && req->lcore != reactor->lcore) {
+		return;
+	}
+
+	if (req->batch_size != 0) {
+		reactor->event_batch_size = req->batch_size;
+	}
+	if (req->policy_id >= 0) {
+		reactor->event_policy = req->policy_id;
+	}
+}
+
+static void
+rpc_framework_set_reactor_event_opts(struct spdk_jsonrpc_request *request,
+				     const struct spdk_json_val *params)
+{
+	struct rpc_framework_set_reactor_event_opts *req;
+	size_t i;
+
+	req = calloc(1, sizeof(*req));
+	if (req == NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Memory allocation error");
+		return;
+	}
+
+	req->request = request;
+	req->lcore = UINT32_MAX;
+	req->policy_id = -1;
+
+	if (params != NULL &&
+	    spdk_json_decode_object(params, rpc_framework_set_reactor_event_opts_decoders,
+				    SPDK_COUNTOF(rpc_framework_set_reactor_event_opts_decoders),
+				    req)) {
+		SPDK_DEBUGLOG(app_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		goto err;
+	}
+
+	if (req->lcore != UINT32_MAX &&
+	    (spdk_reactor_get(req->lcore) == NULL ||
+	     !spdk_cpuset_get_cpu(spdk_app_get_core_mask(), req->lcore))) {
+		spdk_jsonrpc_send_error_response_fmt(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						     "Invalid lcore %u", req->lcore);
+		goto err;
+	}
+
+	if (req->batch_size > SPDK_REACTOR_EVENT_BATCH_SIZE_MAX) {
+		spdk_jsonrpc_send_error_response_fmt(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						     "batch_size must be between 1 and %u",
+						     SPDK_REACTOR_EVENT_BATCH_SIZE_MAX);
+		goto err;
+	}
+
+	if (req->policy != NULL) {
+		for (i = 0; i < SPDK_COUNTOF(g_reactor_event_policy_names); i++) {
+			if (strcmp(req->policy, g_reactor_event_policy_names[i]) == 0) {
+				req->policy_id = i;
+				break;
+			}
+		}
+		if (req->policy_id < 0) {
+			spdk_jsonrpc_send_error_response_fmt(request,
+							     SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+							     "Unknown policy %s", req->policy);
+			goto err;
+		}
+	}
+
+	spdk_for_each_reactor(_rpc_framework_set_reactor_event_opts, req, NULL,
+			      rpc_framework_set_reactor_event_opts_done);
+	return;
+
+err:
+	free_rpc_framework_set_reactor_event_opts(req);
+}
+
+SPDK_RPC_REGISTER("framework_set_reactor_event_opts", rpc_framework_set_reactor_event_opts,
+		  SPDK_RPC_RUNTIME)
+
 struct rpc_set_scheduler_ctx {
 	char *name;
 	uint64_t period;
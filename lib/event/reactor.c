@@ -8,6 +8,7 @@
 
 #include "spdk_internal/event.h"
 #include "spdk_internal/usdt.h"
+#include "spdk_internal/thread.h"
 
 #include "spdk/log.h"
 #include "spdk/thread.h"
@@ -16,6 +17,7 @@
 #include "spdk/scheduler.h"
 #include "spdk/string.h"
 #include "spdk/fd_group.h"
+#include "spdk/histogram_data.h"
 
 #ifdef __linux__
 #include <sys/prctl.h>
@@ -150,6 +152,9 @@ reactor_construct(struct spdk_reactor *reactor, uint32_t lcore)
 	reactor->thread_count = 0;
 	spdk_cpuset_zero(&reactor->notify_cpuset);
 
+	reactor->event_batch_size = SPDK_EVENT_BATCH_SIZE;
+	reactor->event_policy = SPDK_REACTOR_EVENT_POLICY_BATCH;
+
 	reactor->events = spdk_ring_create(SPDK_RING_TYPE_MP_SC, 65536, SPDK_ENV_SOCKET_ID_ANY);
 	if (reactor->events == NULL) {
 		SPDK_ERRLOG("Failed to allocate events ring\n");
@@ -294,6 +299,7 @@ spdk_reactors_fini(void)
 
 		if (g_core_infos != NULL) {
 			free(g_core_infos[i].thread_infos);
+			spdk_histogram_data_free(g_core_infos[i].current_latency_histogram);
 		}
 	}
 
@@ -527,10 +533,13 @@ static inline int
 event_queue_run_batch(void *arg)
 {
 	struct spdk_reactor *reactor = arg;
-	size_t count, i;
-	void *events[SPDK_EVENT_BATCH_SIZE];
+	size_t count, i, batch_size = reactor->event_batch_size, depth;
+	void *events[SPDK_REACTOR_EVENT_BATCH_SIZE_MAX];
 	struct spdk_thread *thread;
 	struct spdk_lw_thread *lw_thread;
+	uint64_t tsc;
+
+	assert(batch_size > 0 && batch_size <= SPDK_REACTOR_EVENT_BATCH_SIZE_MAX);
 
 #ifdef DEBUG
 	/*
@@ -538,7 +547,7 @@ event_queue_run_batch(void *arg)
 	 * so we will never actually read uninitialized data from events, but just to be sure
 	 * (and to silence a static analyzer false positive), initialize the array to NULL pointers.
 	 */
-	memset(events, 0, sizeof(events));
+	memset(events, 0, batch_size * sizeof(events[0]));
 #endif
 
 	/* Operate event notification if this reactor currently runs in interrupt state */
@@ -556,7 +565,7 @@ event_queue_run_batch(void *arg)
 			return -errno;
 		}
 
-		count = spdk_ring_dequeue(reactor->events, events, SPDK_EVENT_BATCH_SIZE);
+		count = spdk_ring_dequeue(reactor->events, events, batch_size);
 
 		if (spdk_ring_count(reactor->events) != 0) {
 			/* Trigger new notification if there are still events in event-queue waiting for processing. */
@@ -567,13 +576,25 @@ event_queue_run_batch(void *arg)
 			}
 		}
 	} else {
-		count = spdk_ring_dequeue(reactor->events, events, SPDK_EVENT_BATCH_SIZE);
+		count = spdk_ring_dequeue(reactor->events, events, batch_size);
 	}
 
 	if (count == 0) {
 		return 0;
 	}
 
+	/* The queue can only be deeper than the batch if the batch is full. */
+	depth = count;
+	if (count == batch_size) {
+		depth += spdk_ring_count(reactor->events);
+	}
+	if (depth > reactor->event_stats.max_queue_depth) {
+		reactor->event_stats.max_queue_depth = depth;
+	}
+	reactor->event_stats.batch_count++;
+	reactor->event_stats.event_count += count;
+	tsc = spdk_get_ticks();
+
 	/* Execute the events. There are still some remaining events
 	 * that must occur on an SPDK thread. To accommodate those, try to
 	 * run them on the first thread in the list, if it exists. */
@@ -598,9 +619,34 @@ event_queue_run_batch(void *arg)
 
 	spdk_mempool_put_bulk(g_spdk_event_mempool, events, count);
 
+	reactor->event_stats.event_tsc += spdk_get_ticks() - tsc;
+
 	return (int)count;
 }
 
+static void
+reactor_run_events(struct spdk_reactor *reactor)
+{
+	size_t budget;
+	int count;
+
+	count = event_queue_run_batch(reactor);
+	if (reactor->event_policy != SPDK_REACTOR_EVENT_POLICY_DRAIN ||
+	    count < (int)reactor->event_batch_size) {
+		return;
+	}
+
+	/* Don't chase events queued in the meantime, so that threads can't be starved. */
+	budget = spdk_ring_count(reactor->events);
+	while (budget > 0) {
+		count = event_queue_run_batch(reactor);
+		if (count <= 0) {
+			break;
+		}
+		budget -= spdk_min(budget, (size_t)count);
+	}
+}
+
 /* 1s */
 #define CONTEXT_SWITCH_MONITOR_PERIOD 1000000
 
@@ -773,6 +819,40 @@ _reactors_scheduler_balance(void *arg1, void *arg2)
 	_reactors_scheduler_update_core_mode(NULL);
 }
 
+static void
+_reactor_gather_latency(struct spdk_reactor *reactor, struct spdk_scheduler_core_info *core_info)
+{
+	struct spdk_lw_thread *lw_thread;
+	struct spdk_histogram_data *histogram;
+
+	if (!spdk_thread_latency_histograms_enabled()) {
+		spdk_histogram_data_free(core_info->current_latency_histogram);
+		core_info->current_latency_histogram = NULL;
+		return;
+	}
+
+	if (core_info->current_latency_histogram == NULL) {
+		core_info->current_latency_histogram =
+			spdk_histogram_data_alloc_sized(SPDK_THREAD_LATENCY_HISTOGRAM_BUCKET_SHIFT);
+		if (core_info->current_latency_histogram == NULL) {
+			/* The scheduler just sees no latency data for this period. */
+			SPDK_ERRLOG("Failed to allocate latency histogram on %u\n", reactor->lcore);
+			return;
+		}
+	} else {
+		spdk_histogram_data_reset(core_info->current_latency_histogram);
+	}
+
+	/* Threads run on this very system thread, so their histograms can be consumed here. */
+	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
+		histogram = spdk_thread_get_latency_histogram(spdk_thread_get_from_ctx(lw_thread));
+		if (histogram != NULL) {
+			spdk_histogram_data_merge(core_info->current_latency_histogram, histogram);
+			spdk_histogram_data_reset(histogram);
+		}
+	}
+}
+
 /* Phase 1 of thread scheduling is to gather metrics on the existing threads */
 static void
 _reactors_scheduler_gather_metrics(void *arg1, void *arg2)
@@ -794,6 +874,7 @@ _reactors_scheduler_gather_metrics(void *arg1, void *arg2)
 	core_info->total_busy_tsc = reactor->busy_tsc;
 	core_info->interrupt_mode = reactor->in_interrupt;
 	core_info->threads_count = 0;
+	_reactor_gather_latency(reactor, core_info);
 
 	SPDK_DEBUGLOG(reactor, "Gathering metrics on %u\n", reactor->lcore);
 
@@ -814,6 +895,7 @@ _reactors_scheduler_gather_metrics(void *arg1, void *arg2)
 			thread = spdk_thread_get_from_ctx(lw_thread);
 			assert(thread != NULL);
 			core_info->thread_infos[i].thread_id = spdk_thread_get_id(thread);
+			core_info->thread_infos[i].socket_id = spdk_thread_get_socket_id(thread);
 			core_info->thread_infos[i].total_stats = lw_thread->total_stats;
 			core_info->thread_infos[i].current_stats = lw_thread->current_stats;
 			core_info->threads_count++;
@@ -889,15 +971,45 @@ reactor_interrupt_run(struct spdk_reactor *reactor)
 	spdk_fd_group_wait(reactor->fgrp, block_timeout);
 }
 
+static int
+reactor_steal_msgs(struct spdk_reactor *reactor, struct spdk_thread *thread)
+{
+	struct spdk_lw_thread	*lw_thread;
+	struct spdk_thread	*victim = NULL, *tmp;
+	uint32_t		count, max_count = 0;
+
+	/* Steal from the sibling with the deepest backlog of stealable messages. */
+	TAILQ_FOREACH(lw_thread, &reactor->threads, link) {
+		tmp = spdk_thread_get_from_ctx(lw_thread);
+		if (tmp == thread) {
+			continue;
+		}
+
+		count = spdk_thread_get_stealable_msg_count(tmp);
+		if (count > max_count) {
+			max_count = count;
+			victim = tmp;
+		}
+	}
+
+	if (victim == NULL) {
+		return 0;
+	}
+
+	return spdk_thread_steal_msgs(thread, victim, 0);
+}
+
 static void
 _reactor_run(struct spdk_reactor *reactor)
 {
 	struct spdk_thread	*thread;
 	struct spdk_lw_thread	*lw_thread, *tmp;
-	uint64_t		now;
+	uint64_t		now, start, event_tsc;
 	int			rc;
 
-	event_queue_run_batch(reactor);
+	event_tsc = reactor->event_stats.event_tsc;
+	reactor_run_events(reactor);
+	event_tsc = reactor->event_stats.event_tsc - event_tsc;
 
 	/* If no threads are present on the reactor,
 	 * tsc_last gets outdated. Update it to track
@@ -909,11 +1021,20 @@ _reactor_run(struct spdk_reactor *reactor)
 		return;
 	}
 
+	/* The time spent in events ends up in the busy or idle time of the first thread,
+	 * so take it out of the time spent in threads. */
+	start = reactor->tsc_last;
 	TAILQ_FOREACH_SAFE(lw_thread, &reactor->threads, link, tmp) {
 		thread = spdk_thread_get_from_ctx(lw_thread);
 		rc = spdk_thread_poll(thread, 0, reactor->tsc_last);
 
 		now = spdk_thread_get_last_tsc(thread);
+		if (rc == 0 && reactor->thread_count > 1 &&
+		    reactor_steal_msgs(reactor, thread) > 0) {
+			/* This thread was idle, so it ran messages stolen from a busy sibling. */
+			rc = 1;
+			now = spdk_get_ticks();
+		}
 		if (rc == 0) {
 			reactor->idle_tsc += now - reactor->tsc_last;
 		} else if (rc > 0) {
@@ -923,6 +1044,8 @@ _reactor_run(struct spdk_reactor *reactor)
 
 		reactor_post_process_lw_thread(reactor, lw_thread);
 	}
+	reactor->event_stats.thread_tsc += reactor->tsc_last - start -
+					   spdk_min(event_tsc, reactor->tsc_last - start);
 }
 
 static int
@@ -1123,6 +1246,7 @@ _schedule_thread(void *arg1, void *arg2)
 	struct spdk_reactor *reactor;
 	uint32_t current_core;
 	struct spdk_fd_group *grp;
+	int rc;
 
 	current_core = spdk_env_get_current_core();
 	reactor = spdk_reactor_get(current_core);
@@ -1140,10 +1264,14 @@ _schedule_thread(void *arg1, void *arg2)
 	TAILQ_INSERT_TAIL(&reactor->threads, lw_thread, link);
 	reactor->thread_count++;
 
+	/* Let the thread re-home its channels if it just moved to another socket. */
+	rc = spdk_thread_notify_migration(thread, spdk_env_get_socket_id(current_core));
+	if (rc < 0) {
+		SPDK_ERRLOG("Failed to notify spdk_thread of migration: %s.\n", spdk_strerror(-rc));
+	}
+
 	/* Operate thread intr if running with full interrupt ability */
 	if (spdk_interrupt_mode_is_enabled()) {
-		int rc;
-
 		if (reactor->in_interrupt) {
 			grp = spdk_thread_get_interrupt_fd_group(thread);
 			rc = spdk_fd_group_nest(reactor->fgrp, grp);
@@ -471,12 +471,13 @@ is_band_relocateable(struct ftl_band *band)
 
 static void
 get_band_phys_info(struct spdk_ftl_dev *dev, uint64_t phys_id,
-		   double *invalidity, double *wr_cnt)
+		   double *invalidity, double *wr_cnt, double *age)
 {
 	struct ftl_band *band;
 	uint64_t band_id = phys_id * dev->num_logical_bands_in_physical;
+	uint64_t num_relocateable = 0;
 
-	*wr_cnt = *invalidity = 0.0L;
+	*wr_cnt = *invalidity = *age = 0.0L;
 	for (; band_id < ftl_get_num_bands(dev); band_id++) {
 		band = &dev->bands[band_id];
 
@@ -491,31 +492,53 @@ get_band_phys_info(struct spdk_ftl_dev *dev, uint64_t phys_id,
 		}
 
 		*invalidity += _band_invalidity(band);
+		*age += dev->sb->seq_id - band->md->close_seq_id;
+		num_relocateable++;
 	}
 
 	*invalidity /= dev->num_logical_bands_in_physical;
 	*wr_cnt /= dev->num_logical_bands_in_physical;
+	if (num_relocateable) {
+		*age /= num_relocateable;
+	}
+}
+
+/*
+ * Cost-benefit of relocating a band, as used by log-structured file systems: the space reclaimed,
+ * weighted by the age of the data, per cost of reading the band and writing its valid data. Older
+ * bands are preferred, since the data still valid in them is likely to remain valid, while the
+ * data in young bands is still being invalidated by the user.
+ */
+static double
+band_gc_benefit(double invalidity, double age)
+{
+	double validity = 1.0L - invalidity;
+
+	/* The age counts in sequence ids since the band was closed */
+	return invalidity * (age + 1.0L) / (1.0L + validity);
 }
 
 static bool
-band_cmp(double a_invalidity, double a_wr_cnt,
-	 double b_invalidity, double b_wr_cnt,
+band_cmp(double a_invalidity, double a_wr_cnt, double a_age,
+	 double b_invalidity, double b_wr_cnt, double b_age,
 	 uint64_t a_id, uint64_t b_id)
 {
 	assert(a_id != FTL_BAND_PHYS_ID_INVALID);
 	assert(b_id != FTL_BAND_PHYS_ID_INVALID);
-	double diff = a_invalidity - b_invalidity;
+	double a_benefit = band_gc_benefit(a_invalidity, a_age);
+	double b_benefit = band_gc_benefit(b_invalidity, b_age);
+	double diff = a_benefit - b_benefit;
 	if (diff < 0.0L) {
 		diff *= -1.0L;
 	}
 
 	/* Use the following metrics for picking bands for GC (in order):
-	 * - relative invalidity
-	 * - if invalidity is similar (within 10% points), then their write counts (how many times band was written to)
+	 * - cost-benefit of the relocation
+	 * - if cost-benefit is similar (within 10%), then their write counts (how many times band was written to)
 	 * - if write count is equal, then pick based on their placement on base device (lower LBAs win)
 	 */
-	if (diff > 0.1L) {
-		return a_invalidity > b_invalidity;
+	if (diff > 0.1L * spdk_max(a_benefit, b_benefit)) {
+		return a_benefit > b_benefit;
 	}
 
 	if (a_wr_cnt != b_wr_cnt) {
@@ -533,6 +556,9 @@ band_start_gc(struct spdk_ftl_dev *dev, struct ftl_band *band)
 	TAILQ_REMOVE(&dev->shut_bands, band, queue_entry);
 	band->reloc = true;
 
+	dev->stats.gc_bands++;
+	dev->stats.gc_valid_blocks += band->p2l_map.num_valid;
+
 	FTL_DEBUGLOG(dev, "Band to GC, id %u\n", band->id);
 }
 
@@ -572,6 +598,7 @@ ftl_band_search_next_to_reloc(struct spdk_ftl_dev *dev)
 {
 	double invalidity, max_invalidity = 0.0L;
 	double wr_cnt, max_wr_cnt = 0.0L;
+	double age, max_age = 0.0L;
 	uint64_t phys_id = FTL_BAND_PHYS_ID_INVALID;
 	struct ftl_band *band;
 	uint64_t i, band_count;
@@ -604,18 +631,16 @@ ftl_band_search_next_to_reloc(struct spdk_ftl_dev *dev)
 		band = &dev->bands[i];
 
 		/* Calculate entire band physical group invalidity */
-		get_band_phys_info(dev, band->phys_id, &invalidity, &wr_cnt);
+		get_band_phys_info(dev, band->phys_id, &invalidity, &wr_cnt, &age);
 
 		if (invalidity != 0.0L) {
 			if (phys_id == FTL_BAND_PHYS_ID_INVALID ||
-			    band_cmp(invalidity, wr_cnt, max_invalidity, max_wr_cnt,
+			    band_cmp(invalidity, wr_cnt, age, max_invalidity, max_wr_cnt, max_age,
 				     band->phys_id, phys_id)) {
 				max_wr_cnt = wr_cnt;
+				max_invalidity = invalidity;
+				max_age = age;
 				phys_id = band->phys_id;
-
-				if (invalidity > max_invalidity) {
-					max_invalidity = invalidity;
-				}
 			}
 		}
 	}
@@ -828,7 +828,12 @@ _ftl_get_stats(void *_ctx)
 {
 	struct ftl_get_stats_ctx *stats_ctx = _ctx;
 
-	*stats_ctx->stats = stats_ctx->dev->stats;
+	struct spdk_ftl_dev *dev = stats_ctx->dev;
+
+	*stats_ctx->stats = dev->stats;
+	stats_ctx->stats->nv_cache_chunks = dev->nv_cache.chunk_count;
+	stats_ctx->stats->nv_cache_chunks_free = dev->nv_cache.chunk_free_count;
+	stats_ctx->stats->nv_cache_chunks_full = dev->nv_cache.chunk_full_count;
 
 	if (spdk_thread_send_msg(stats_ctx->thread, _ftl_get_stats_cb, stats_ctx)) {
 		ftl_abort();
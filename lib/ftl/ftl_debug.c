@@ -214,6 +214,11 @@ ftl_dev_dump_stats(const struct spdk_ftl_dev *dev)
 	FTL_NOTICELOG(dev, "total writes:        %"PRIu64"\n", write_total);
 	FTL_NOTICELOG(dev, "user writes:         %"PRIu64"\n", write_user);
 	FTL_NOTICELOG(dev, "WAF:                 %.4lf\n", waf);
+	FTL_NOTICELOG(dev, "GC bands:            %"PRIu64"\n", dev->stats.gc_bands);
+	FTL_NOTICELOG(dev, "GC valid blocks:     %"PRIu64"\n", dev->stats.gc_valid_blocks);
+	FTL_NOTICELOG(dev, "L2P cache hits:      %"PRIu64"\n", dev->stats.l2p_cache_hits);
+	FTL_NOTICELOG(dev, "L2P cache misses:    %"PRIu64"\n", dev->stats.l2p_cache_misses);
+	FTL_NOTICELOG(dev, "compacted chunks:    %"PRIu64"\n", dev->stats.nv_cache_chunks_compacted);
 #ifdef DEBUG
 	FTL_NOTICELOG(dev, "limits:\n");
 	for (i = 0; i < SPDK_FTL_LIMIT_MAX; ++i) {
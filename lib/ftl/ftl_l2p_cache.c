@@ -46,6 +46,7 @@ struct ftl_l2p_page {
 	uint64_t pin_ref_cnt;
 	struct ftl_l2p_cache_page_io_ctx ctx;
 	bool on_lru_list;
+	uint8_t ref; /* Clock hand passes the page survives, see ftl_l2p_cache_page_touch() */
 	void *page_buffer;
 	uint64_t ckpt_seq_id;
 	ftl_df_obj_id obj_id;
@@ -213,6 +214,27 @@ ftl_l2p_cache_lru_promote_page(struct ftl_l2p_cache *cache, struct ftl_l2p_page
 	ftl_l2p_cache_lru_add_page(cache, page);
 }
 
+/*
+ * The rank list works as a clock, with the hand at its tail. Pages accessed since the hand last
+ * passed them get another round instead of being evicted. Dirty pages can collect more rounds,
+ * since evicting them costs a write and they are likely to be updated again.
+ */
+#define FTL_L2P_CACHE_PAGE_REF_MAX_CLEAN	1
+#define FTL_L2P_CACHE_PAGE_REF_MAX_DIRTY	3
+/* Maximum number of pages the hand passes when looking for a page to evict */
+#define FTL_L2P_CACHE_EVICT_SCAN_MAX		64
+
+static inline void
+ftl_l2p_cache_page_touch(struct ftl_l2p_page *page)
+{
+	uint8_t ref_max = page->updates ? FTL_L2P_CACHE_PAGE_REF_MAX_DIRTY :
+			  FTL_L2P_CACHE_PAGE_REF_MAX_CLEAN;
+
+	if (page->ref < ref_max) {
+		page->ref++;
+	}
+}
+
 static inline void
 ftl_l2p_cache_page_insert(struct ftl_l2p_cache *cache, struct ftl_l2p_page *page)
 {
@@ -242,12 +264,6 @@ ftl_l2p_cache_get_coldest_page(struct ftl_l2p_cache *cache)
 	return TAILQ_LAST(&cache->lru_list, l2p_lru_list);
 }
 
-static inline struct ftl_l2p_page *
-ftl_l2p_cache_get_hotter_page(struct ftl_l2p_page *page)
-{
-	return TAILQ_PREV(page, l2p_lru_list, list_entry);
-}
-
 static inline uint64_t
 ftl_l2p_cache_page_get_bdev_offset(struct ftl_l2p_cache *cache,
 				   struct ftl_l2p_page *page)
@@ -819,6 +835,7 @@ l2p_shm_restore_clean(struct spdk_ftl_dev *dev)
 
 		page->pin_ref_cnt = 0;
 		page->on_lru_list = 0;
+		page->ref = 0;
 		memset(&page->ctx, 0, sizeof(page->ctx));
 
 		ftl_l2p_cache_lru_add_page(cache, page);
@@ -867,6 +884,7 @@ l2p_shm_restore_dirty(struct spdk_ftl_dev *dev)
 
 		page->pin_ref_cnt = 0;
 		page->on_lru_list = 0;
+		page->ref = 0;
 		memset(&page->ctx, 0, sizeof(page->ctx));
 
 		ftl_l2p_cache_lru_add_page(cache, page);
@@ -1037,6 +1055,7 @@ ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
 		/* Try get page and pin */
 		page = get_l2p_page_by_df_id(cache, i);
 		if (page) {
+			dev->stats.l2p_cache_hits++;
 			if (ftl_l2p_cache_page_is_pinnable(page)) {
 				/* Page available and we can pin it */
 				page_set->pinned_cnt++;
@@ -1051,6 +1070,7 @@ ftl_l2p_cache_pin(struct spdk_ftl_dev *dev, struct ftl_l2p_pin_ctx *pin_ctx)
 			}
 		} else {
 			/* The page is not in the cache, queue the page_set to page in */
+			dev->stats.l2p_cache_misses++;
 			defer_pin = true;
 		}
 	}
@@ -1102,7 +1122,7 @@ ftl_l2p_cache_get(struct spdk_ftl_dev *dev, uint64_t lba)
 		ftl_bitmap_clear(dev->unmap_map, page->page_no);
 	}
 
-	ftl_l2p_cache_lru_promote_page(cache, page);
+	ftl_l2p_cache_page_touch(page);
 	addr = ftl_l2p_cache_get_addr(dev, cache, page, lba);
 
 	return addr;
@@ -1125,7 +1145,7 @@ ftl_l2p_cache_set(struct spdk_ftl_dev *dev, uint64_t lba, ftl_addr addr)
 	}
 
 	page->updates++;
-	ftl_l2p_cache_lru_promote_page(cache, page);
+	ftl_l2p_cache_page_touch(page);
 	ftl_l2p_cache_set_addr(dev, cache, page, lba, addr);
 }
 
@@ -1367,28 +1387,29 @@ ftl_l2p_cache_process_page_sets(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *
 static struct ftl_l2p_page *
 eviction_get_page(struct spdk_ftl_dev *dev, struct ftl_l2p_cache *cache)
 {
-	uint64_t i = 0;
+	uint64_t i;
 	struct ftl_l2p_page *page = ftl_l2p_cache_get_coldest_page(cache);
 
-	while (page) {
-		ftl_bug(L2P_CACHE_PAGE_READY != page->state);
-		ftl_bug(page->pin_ref_cnt);
-
-		if (ftl_l2p_cache_page_can_evict(page)) {
-			ftl_l2p_cache_lru_remove_page(cache, page);
-			return page;
-		}
-
-		/*
-		 * Practically only one iteration is needed to find a page. It is because
-		 * the rank of pages contains only ready and unpinned pages
-		 */
-		ftl_bug(++i > 1024);
+	/* Move the referenced pages to the head. If all of the scanned pages were referenced,
+	 * evict the coldest one anyway, to keep the eviction going under pressure.
+	 */
+	for (i = 0; page && page->ref && i < FTL_L2P_CACHE_EVICT_SCAN_MAX; i++) {
+		page->ref--;
+		ftl_l2p_cache_lru_promote_page(cache, page);
+		page = ftl_l2p_cache_get_coldest_page(cache);
+	}
 
-		page = ftl_l2p_cache_get_hotter_page(page);
+	if (!page) {
+		return NULL;
 	}
 
-	return NULL;
+	/* The rank of pages contains only ready and unpinned pages */
+	ftl_bug(L2P_CACHE_PAGE_READY != page->state);
+	ftl_bug(page->pin_ref_cnt);
+	ftl_bug(!ftl_l2p_cache_page_can_evict(page));
+
+	ftl_l2p_cache_lru_remove_page(cache, page);
+	return page;
 }
 
 static void
@@ -156,7 +156,7 @@ ftl_nv_cache_init(struct spdk_ftl_dev *dev)
 	nv_cache->chunk_compaction_threshold = nv_cache->chunk_count *
 					       dev->conf.nv_cache.chunk_compaction_threshold / 100;
 	TAILQ_INIT(&nv_cache->compactor_list);
-	for (i = 0; i < FTL_NV_CACHE_NUM_COMPACTORS; i++) {
+	for (i = 0; i < dev->conf.nv_cache.compactors; i++) {
 		compactor = compactor_alloc(dev);
 
 		if (!compactor) {
@@ -189,7 +189,7 @@ ftl_nv_cache_init(struct spdk_ftl_dev *dev)
 	 * plus one backup each for high invalidity chunks processing (if there's a backlog of chunks with extremely
 	 * small, even 0, validity then they can be processed by the compactors quickly and trigger a lot of updates
 	 * to free state at once) */
-	nv_cache->free_chunk_md_pool = ftl_mempool_create(2 * FTL_NV_CACHE_NUM_COMPACTORS,
+	nv_cache->free_chunk_md_pool = ftl_mempool_create(2 * dev->conf.nv_cache.compactors,
 				       sizeof(struct ftl_nv_cache_chunk_md),
 				       FTL_BLOCK_SIZE,
 				       SPDK_ENV_SOCKET_ID_ANY);
@@ -529,6 +529,7 @@ chunk_compaction_advance(struct ftl_nv_cache_chunk *chunk, uint64_t num_blocks)
 	nv_cache->chunk_comp_count--;
 
 	compaction_stats_update(chunk);
+	SPDK_CONTAINEROF(nv_cache, struct spdk_ftl_dev, nv_cache)->stats.nv_cache_chunks_compacted++;
 
 	ftl_chunk_free(chunk);
 }
@@ -1318,6 +1319,7 @@ void
 ftl_nv_cache_process(struct spdk_ftl_dev *dev)
 {
 	struct ftl_nv_cache *nv_cache = &dev->nv_cache;
+	uint32_t i;
 
 	assert(dev->nv_cache.bdev_desc);
 
@@ -1332,10 +1334,19 @@ ftl_nv_cache_process(struct spdk_ftl_dev *dev)
 		ftl_add_io_activity(dev);
 	}
 
-	if (is_compaction_required(nv_cache) && !TAILQ_EMPTY(&nv_cache->compactor_list)) {
-		struct ftl_nv_cache_compactor *comp =
-			TAILQ_FIRST(&nv_cache->compactor_list);
+	/*
+	 * Start all the idle compactors needed, so that compaction keeps up with bursts of writes.
+	 * A compactor can go back to the list right away (e.g. if its read can't be submitted),
+	 * so don't start more than there are.
+	 */
+	for (i = 0; i < dev->conf.nv_cache.compactors; i++) {
+		struct ftl_nv_cache_compactor *comp;
+
+		if (!is_compaction_required(nv_cache) || TAILQ_EMPTY(&nv_cache->compactor_list)) {
+			break;
+		}
 
+		comp = TAILQ_FIRST(&nv_cache->compactor_list);
 		TAILQ_REMOVE(&nv_cache->compactor_list, comp, entry);
 
 		compaction_process_start(comp);
@@ -26,7 +26,9 @@
 
 #define FTL_NVC_VERSION_CURRENT FTL_NVC_VERSION_1
 
+/* Default and maximum number of compactors */
 #define FTL_NV_CACHE_NUM_COMPACTORS 8
+#define FTL_NV_CACHE_MAX_COMPACTORS 64
 
 /*
  * Parameters controlling nv cache write throttling.
@@ -35,6 +35,14 @@ struct ftl_mngt_recovery_ctx {
 		uint32_t i;
 	} iter;
 	uint64_t p2l_ckpt_seq_id[FTL_LAYOUT_REGION_TYPE_P2L_COUNT];
+	/* Range of LBAs found in the P2L of each closed band, filled in when its P2L is first read.
+	 * Only allocated when recovery needs more than one iteration, so that later iterations can skip
+	 * reading the P2L of bands with no LBAs in their range.
+	 */
+	struct ftl_mngt_recovery_band_lbas {
+		uint64_t lba_first;
+		uint64_t lba_last;
+	} *band_lbas;
 };
 
 static const struct ftl_mngt_process_desc g_desc_recovery_iteration;
@@ -120,6 +128,20 @@ ftl_mngt_recovery_init(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt)
 	FTL_NOTICELOG(dev, "Recovery iterations: %"PRIu64"\n", iterations);
 	dev->sb->ckpt_seq_id = 0;
 
+	if (iterations > 1) {
+		uint64_t i, num_bands = ftl_get_num_bands(dev);
+
+		ctx->band_lbas = calloc(num_bands, sizeof(*ctx->band_lbas));
+		if (!ctx->band_lbas) {
+			ftl_mngt_fail_step(mngt);
+			return;
+		}
+
+		for (i = 0; i < num_bands; i++) {
+			ctx->band_lbas[i].lba_first = FTL_LBA_INVALID;
+		}
+	}
+
 	/* Initialize region */
 	ctx->l2p_snippet.region = dev->layout.region[FTL_LAYOUT_REGION_TYPE_L2P];
 	/* Limit blocks in region, it will be needed for ftl_md_set_region */
@@ -164,6 +186,9 @@ ftl_mngt_recovery_deinit(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt
 	ctx->l2p_snippet.md = NULL;
 	ctx->l2p_snippet.seq_id = NULL;
 
+	free(ctx->band_lbas);
+	ctx->band_lbas = NULL;
+
 	ftl_mngt_next_step(mngt);
 }
 
@@ -254,10 +279,29 @@ struct band_md_ctx {
 	uint64_t id;
 };
 
+static bool
+recovery_band_in_iter(struct ftl_mngt_recovery_ctx *ctx, struct ftl_band *band)
+{
+	struct ftl_mngt_recovery_band_lbas *lbas;
+
+	if (!ctx->band_lbas) {
+		return true;
+	}
+
+	lbas = &ctx->band_lbas[band->id];
+	if (lbas->lba_first == FTL_LBA_INVALID) {
+		/* P2L of the band hasn't been read yet */
+		return true;
+	}
+
+	return lbas->lba_first < ctx->iter.lba_last && lbas->lba_last >= ctx->iter.lba_first;
+}
+
 static void
 ftl_mngt_recovery_walk_band_tail_md(struct spdk_ftl_dev *dev, struct ftl_mngt_process *mngt,
 				    ftl_band_md_cb cb)
 {
+	struct ftl_mngt_recovery_ctx *pctx = ftl_mngt_get_caller_ctx(mngt);
 	struct band_md_ctx *sctx = ftl_mngt_get_step_ctx(mngt);
 	uint64_t num_bands = ftl_get_num_bands(dev);
 
@@ -295,6 +339,12 @@ ftl_mngt_recovery_walk_band_tail_md(struct spdk_ftl_dev *dev, struct ftl_mngt_pr
 				continue;
 			}
 
+			if (!recovery_band_in_iter(pctx, band)) {
+				/* None of the LBAs in the band's P2L belong to this iteration */
+				sctx->id++;
+				continue;
+			}
+
 			band->md->df_p2l_map = FTL_DF_OBJ_ID_INVALID;
 			if (ftl_band_alloc_p2l_map(band)) {
 				/* No more free P2L map, try later */
@@ -404,6 +454,7 @@ restore_band_l2p_cb(struct ftl_band *band, void *cntx, enum ftl_md_status status
 	struct spdk_ftl_dev *dev = band->dev;
 	ftl_addr addr, curr_addr;
 	uint64_t i, lba, seq_id, num_blks_in_band;
+	uint64_t lba_first = dev->num_lbas, lba_last = 0;
 	uint32_t band_map_crc;
 	int rc = 0;
 
@@ -438,6 +489,10 @@ restore_band_l2p_cb(struct ftl_band *band, void *cntx, enum ftl_md_status status
 			rc = -EINVAL;
 			break;
 		}
+
+		lba_first = spdk_min(lba_first, lba);
+		lba_last = spdk_max(lba_last, lba);
+
 		if (lba < pctx->iter.lba_first || lba >= pctx->iter.lba_last) {
 			continue;
 		}
@@ -476,6 +531,11 @@ restore_band_l2p_cb(struct ftl_band *band, void *cntx, enum ftl_md_status status
 		pctx->l2p_snippet.seq_id[lba_off] = seq_id;
 	}
 
+	if (!rc && pctx->band_lbas && FTL_BAND_STATE_CLOSED == band->md->state) {
+		/* An empty P2L is left with lba_first past the last LBA, so it's never in range */
+		pctx->band_lbas[band->id].lba_first = lba_first;
+		pctx->band_lbas[band->id].lba_last = lba_last;
+	}
 
 cleanup:
 	ftl_band_release_p2l_map(band);
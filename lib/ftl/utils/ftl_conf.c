@@ -26,6 +26,7 @@ static const struct spdk_ftl_conf g_default_conf = {
 	.nv_cache = {
 		.chunk_compaction_threshold = 80,
 		.chunk_free_target = 5,
+		.compactors = FTL_NV_CACHE_NUM_COMPACTORS,
 	},
 	.fast_shutdown = true,
 };
@@ -162,6 +163,11 @@ ftl_conf_is_valid(const struct spdk_ftl_conf *conf)
 		return false;
 	}
 
+	if (conf->nv_cache.compactors == 0 ||
+	    conf->nv_cache.compactors > FTL_NV_CACHE_MAX_COMPACTORS) {
+		return false;
+	}
+
 	if (conf->l2p_dram_limit == 0) {
 		return false;
 	}
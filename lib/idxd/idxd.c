@@ -31,19 +31,32 @@ spdk_idxd_get_socket(struct spdk_idxd_device *idxd)
 	return idxd->socket_id;
 }
 
-static inline void
+static inline int
 _submit_to_hw(struct spdk_idxd_io_channel *chan, struct idxd_ops *op)
 {
-	STAILQ_INSERT_TAIL(&chan->ops_outstanding, op, link);
+	int retry = 0;
+
 	/*
 	 * We must barrier before writing the descriptor to ensure that data
 	 * has been correctly flushed from the associated data buffers before DMA
 	 * operations begin.
 	 */
 	_spdk_wmb();
-	movdir64b(chan->portal + chan->portal_offset, op->desc);
+	if (chan->shared_wq) {
+		/* A shared WQ rejects the descriptor when it's full, so retry a few times before
+		 * letting the caller resubmit it later. */
+		while (enqcmd(chan->portal + chan->portal_offset, op->desc)) {
+			if (++retry == IDXD_ENQCMD_RETRY_COUNT) {
+				return -EBUSY;
+			}
+		}
+	} else {
+		movdir64b(chan->portal + chan->portal_offset, op->desc);
+	}
 	chan->portal_offset = (chan->portal_offset + chan->idxd->chan_per_device * PORTAL_STRIDE) &
 			      PORTAL_MASK;
+
+	return 0;
 }
 
 inline static int
@@ -137,9 +150,9 @@ idxd_vtophys_iter_next(struct idxd_vtophys_iter *iter,
 	return len;
 }
 
-/* helper function for DSA specific spdk_idxd_get_channel() stuff */
+/* helper function for the batch specific spdk_idxd_get_channel() stuff */
 static int
-_dsa_alloc_batches(struct spdk_idxd_io_channel *chan, int num_descriptors)
+_idxd_alloc_batches(struct spdk_idxd_io_channel *chan, int num_descriptors, size_t comp_rec_size)
 {
 	struct idxd_batch *batch;
 	struct idxd_hw_desc *desc;
@@ -179,7 +192,7 @@ _dsa_alloc_batches(struct spdk_idxd_io_channel *chan, int num_descriptors)
 		}
 
 		for (j = 0; j < DESC_PER_BATCH; j++) {
-			rc = _vtophys(chan, &op->hw, &desc->completion_addr, sizeof(struct dsa_hw_comp_record));
+			rc = _vtophys(chan, &op->hw, &desc->completion_addr, comp_rec_size);
 			if (rc) {
 				SPDK_ERRLOG("Failed to translate batch entry completion memory\n");
 				goto error_user;
@@ -227,13 +240,14 @@ spdk_idxd_get_channel(struct spdk_idxd_device *idxd)
 
 	chan->idxd = idxd;
 	chan->pasid_enabled = idxd->pasid_enabled;
+	chan->shared_wq = idxd->shared_wq;
 	STAILQ_INIT(&chan->ops_pool);
 	TAILQ_INIT(&chan->batch_pool);
 	STAILQ_INIT(&chan->ops_outstanding);
 
 	/* Assign WQ, portal */
 	pthread_mutex_lock(&idxd->num_channels_lock);
-	if (idxd->num_channels == idxd->chan_per_device) {
+	if (!idxd->shared_wq && idxd->num_channels == idxd->chan_per_device) {
 		/* too many channels sharing this device */
 		pthread_mutex_unlock(&idxd->num_channels_lock);
 		SPDK_ERRLOG("Too many channels sharing this device\n");
@@ -267,13 +281,15 @@ spdk_idxd_get_channel(struct spdk_idxd_device *idxd)
 
 	if (idxd->type == IDXD_DEV_TYPE_DSA) {
 		comp_rec_size = sizeof(struct dsa_hw_comp_record);
-		if (_dsa_alloc_batches(chan, num_descriptors)) {
-			goto error;
-		}
 	} else {
 		comp_rec_size = sizeof(struct iaa_hw_comp_record);
 	}
 
+	/* Both DSA and IAA operations are accumulated in batches until the channel is polled */
+	if (_idxd_alloc_batches(chan, num_descriptors, comp_rec_size)) {
+		goto error;
+	}
+
 	for (i = 0; i < num_descriptors; i++) {
 		STAILQ_INSERT_TAIL(&chan->ops_pool, op, link);
 		op->desc = desc;
@@ -565,14 +581,25 @@ idxd_batch_submit(struct spdk_idxd_io_channel *chan,
 		op->cb_fn = batch->user_ops[0].cb_fn;
 		op->cb_arg = batch->user_ops[0].cb_arg;
 		op->crc_dst = batch->user_ops[0].crc_dst;
-		_free_batch(batch, chan);
 	} else {
 		/* Command specific. */
 		desc->opcode = IDXD_OPCODE_BATCH;
 		desc->desc_list_addr = batch->user_desc_addr;
 		desc->desc_count = batch->index;
 		assert(batch->index <= DESC_PER_BATCH);
+	}
+
+	/* Submit operation. */
+	rc = _submit_to_hw(chan, op);
+	if (rc) {
+		/* The WQ is full, leave the batch open so that it's resubmitted later */
+		STAILQ_INSERT_HEAD(&chan->ops_pool, op, link);
+		return rc;
+	}
 
+	if (batch->index == 1) {
+		_free_batch(batch, chan);
+	} else {
 		/* Add the batch elements completion contexts to the outstanding list to be polled. */
 		for (i = 0 ; i < batch->index; i++) {
 			batch->refcnt++;
@@ -582,10 +609,8 @@ idxd_batch_submit(struct spdk_idxd_io_channel *chan,
 		batch->index = UINT8_MAX;
 	}
 
+	STAILQ_INSERT_TAIL(&chan->ops_outstanding, op, link);
 	chan->batch = NULL;
-
-	/* Submit operation. */
-	_submit_to_hw(chan, op);
 	SPDK_DEBUGLOG(idxd, "Submitted batch %p\n", batch);
 
 	return 0;
@@ -1160,8 +1185,13 @@ _idxd_submit_compress_single(struct spdk_idxd_io_channel *chan, void *dst, const
 	uint64_t src_addr, dst_addr;
 	int rc;
 
+	rc = _idxd_setup_batch(chan);
+	if (rc) {
+		return rc;
+	}
+
 	/* Common prep. */
-	rc = _idxd_prep_command(chan, cb_fn, cb_arg, flags, &desc, &op);
+	rc = _idxd_prep_batch_cmd(chan, cb_fn, cb_arg, flags, &desc, &op);
 	if (rc) {
 		return rc;
 	}
@@ -1188,10 +1218,9 @@ _idxd_submit_compress_single(struct spdk_idxd_io_channel *chan, void *dst, const
 	desc->compr_flags = IAA_COMP_FLAGS;
 	op->output_size = output_size;
 
-	_submit_to_hw(chan, op);
-	return 0;
+	return _idxd_flush_batch(chan);
 error:
-	STAILQ_INSERT_TAIL(&chan->ops_pool, op, link);
+	chan->batch->index--;
 	return rc;
 }
 
@@ -1228,8 +1257,13 @@ _idxd_submit_decompress_single(struct spdk_idxd_io_channel *chan, void *dst, con
 	uint64_t src_addr, dst_addr;
 	int rc;
 
+	rc = _idxd_setup_batch(chan);
+	if (rc) {
+		return rc;
+	}
+
 	/* Common prep. */
-	rc = _idxd_prep_command(chan, cb_fn, cb_arg, flags, &desc, &op);
+	rc = _idxd_prep_batch_cmd(chan, cb_fn, cb_arg, flags, &desc, &op);
 	if (rc) {
 		return rc;
 	}
@@ -1252,10 +1286,9 @@ _idxd_submit_decompress_single(struct spdk_idxd_io_channel *chan, void *dst, con
 	desc->iaa.max_dst_size = nbytes_dst;
 	desc->decompr_flags = IAA_DECOMP_FLAGS;
 
-	_submit_to_hw(chan, op);
-	return 0;
+	return _idxd_flush_batch(chan);
 error:
-	STAILQ_INSERT_TAIL(&chan->ops_pool, op, link);
+	chan->batch->index--;
 	return rc;
 }
 
@@ -1310,7 +1343,12 @@ spdk_idxd_submit_raw_desc(struct spdk_idxd_io_channel *chan,
 	desc->completion_addr = comp_addr;
 
 	/* Submit operation. */
-	_submit_to_hw(chan, op);
+	rc = _submit_to_hw(chan, op);
+	if (rc) {
+		STAILQ_INSERT_HEAD(&chan->ops_pool, op, link);
+		return rc;
+	}
+	STAILQ_INSERT_TAIL(&chan->ops_outstanding, op, link);
 
 	return 0;
 }
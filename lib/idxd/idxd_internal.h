@@ -26,11 +26,29 @@ static inline void movdir64b(void *dst, const void *src)
 		     : "d"(src), "a"(dst));
 }
 
+/* Returns true if the descriptor was not accepted by the shared WQ and needs to be retried */
+static inline bool enqcmd(void *dst, const void *src)
+{
+	uint8_t retry;
+
+	asm volatile(".byte 0xf2, 0x0f, 0x38, 0xf8, 0x02\n\t"
+		     "setz %0"
+		     : "=r"(retry), "=m"(*(char *)dst)
+		     : "d"(src), "a"(dst)
+		     : "cc", "memory");
+
+	return retry;
+}
+
 #define IDXD_REGISTER_TIMEOUT_US		50
 #define IDXD_DRAIN_TIMEOUT_US			500000
 
+#define WQ_MODE_SHARED		0
 #define WQ_MODE_DEDICATED	1
 
+/* Number of times a descriptor is resubmitted to a shared WQ before giving up */
+#define IDXD_ENQCMD_RETRY_COUNT	32
+
 /* TODO: consider setting the max per batch limit via RPC. */
 
 /* The following sets up a max desc count per batch of 32 */
@@ -75,6 +93,7 @@ struct spdk_idxd_io_channel {
 	uint32_t				portal_offset;
 
 	bool					pasid_enabled;
+	bool					shared_wq;
 
 	/* The currently open batch */
 	struct idxd_batch			*batch;
@@ -141,6 +160,8 @@ struct spdk_idxd_device {
 	uint32_t			chan_per_device;
 	pthread_mutex_t			num_channels_lock;
 	bool				pasid_enabled;
+	/* Descriptors are submitted with ENQCMD and any number of channels can share the WQ */
+	bool				shared_wq;
 	enum idxd_dev			type;
 	struct iaa_aecs			*aecs;
 	uint64_t			aecs_addr;
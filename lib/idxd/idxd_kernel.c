@@ -6,6 +6,7 @@
 #include "spdk/stdinc.h"
 
 #include <accel-config/libaccel_config.h>
+#include <cpuid.h>
 
 #include "spdk/env.h"
 #include "spdk/util.h"
@@ -52,6 +53,19 @@ kernel_idxd_device_destruct(struct spdk_idxd_device *idxd)
 
 static struct spdk_idxd_impl g_kernel_idxd_impl;
 
+static bool
+kernel_idxd_enqcmd_supported(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	/* CPUID.(EAX=07H, ECX=0H):ECX.ENQCMD[bit 29] */
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+		return false;
+	}
+
+	return ecx & (1u << 29);
+}
+
 static int
 kernel_idxd_probe(void *cb_ctx, spdk_idxd_attach_cb attach_cb, spdk_idxd_probe_cb probe_cb)
 {
@@ -121,9 +135,14 @@ kernel_idxd_probe(void *cb_ctx, spdk_idxd_attach_cb attach_cb, spdk_idxd_probe_c
 				continue;
 			}
 
-			/* TODO: For now, only support dedicated WQ */
+			/* Shared WQs need ENQCMD, which submits descriptors tagged with the
+			 * process' PASID */
 			mode = accfg_wq_get_mode(wq);
-			if (mode != ACCFG_WQ_DEDICATED) {
+			if (mode == ACCFG_WQ_SHARED &&
+			    (!pasid_enabled || !kernel_idxd_enqcmd_supported())) {
+				continue;
+			}
+			if (mode != ACCFG_WQ_DEDICATED && mode != ACCFG_WQ_SHARED) {
 				continue;
 			}
 
@@ -154,6 +173,7 @@ kernel_idxd_probe(void *cb_ctx, spdk_idxd_attach_cb attach_cb, spdk_idxd_probe_c
 			}
 
 			kernel_idxd->wq = wq;
+			kernel_idxd->idxd.shared_wq = mode == ACCFG_WQ_SHARED;
 
 			/* Since we only use a single WQ, the total size is the size of this WQ */
 			kernel_idxd->idxd.total_wq_size = accfg_wq_get_size(wq);
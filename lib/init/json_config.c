@@ -8,7 +8,7 @@
 
 #include "spdk/init.h"
 #include "spdk/util.h"
-#include "spdk/file.h"
+#include "spdk/json.h"
 #include "spdk/log.h"
 #include "spdk/env.h"
 #include "spdk/thread.h"
@@ -42,94 +42,58 @@
  *
  */
 
-struct load_json_config_ctx;
-typedef void (*client_resp_handler)(struct load_json_config_ctx *,
-				    struct spdk_jsonrpc_client_response *);
-
-#define RPC_SOCKET_PATH_MAX SPDK_SIZEOF_MEMBER(struct sockaddr_un, sun_path)
-
-/* 1s connections timeout */
-#define RPC_CLIENT_CONNECT_TIMEOUT_US (1U * 1000U * 1000U)
-
 /*
- * Currently there is no timeout in SPDK for any RPC command. This result that
- * we can't put a hard limit during configuration load as it most likely randomly fail.
- * So just print WARNLOG every 10s. */
-#define RPC_CLIENT_REQUEST_TIMEOUT_US (10U * 1000 * 1000)
-
+ * The configuration is streamed from the file, so that it doesn't have to be read and parsed
+ * as a whole, and each "config" entry is executed by calling its RPC method directly, without
+ * going through the RPC server.  The file is read twice: once for the STARTUP methods and once
+ * for the RUNTIME ones.
+ */
 struct load_json_config_ctx {
 	/* Thread used during configuration. */
 	struct spdk_thread *thread;
 	spdk_subsystem_init_fn cb_fn;
 	void *cb_arg;
 	bool stop_on_error;
+	/* Set if an RPC failed and stop_on_error is set */
+	int rc;
 
-	/* Current subsystem */
-	struct spdk_json_val *subsystems; /* "subsystems" array */
-	struct spdk_json_val *subsystems_it; /* current subsystem array position in "subsystems" array */
-
-	struct spdk_json_val *subsystem_name; /* current subsystem name */
-
-	/* Current "config" entry we are processing */
-	struct spdk_json_val *config; /* "config" array */
-	struct spdk_json_val *config_it; /* current config position in "config" array */
-
-	/* Current request id we are sending. */
-	uint32_t rpc_request_id;
-
-	/* Whole configuration file read and parsed. */
-	size_t json_data_size;
-	char *json_data;
-
-	size_t values_cnt;
-	struct spdk_json_val *values;
-
-	char rpc_socket_path_temp[RPC_SOCKET_PATH_MAX + 1];
-
-	struct spdk_jsonrpc_client *client_conn;
-	struct spdk_poller *client_conn_poller;
+	FILE *file;
+	struct spdk_json_stream *stream;
 
-	client_resp_handler client_resp_cb;
+	/* Current subsystem */
+	char *subsystem_name;
+	bool subsystem_config;
 
-	/* Timeout for current RPC client action. */
-	uint64_t timeout;
+	/* Tick at which the whole configuration and the current subsystem started loading */
+	uint64_t start_tsc;
+	uint64_t subsystem_tsc;
 };
 
+static uint64_t
+app_json_config_elapsed_us(uint64_t start_tsc)
+{
+	return (spdk_get_ticks() - start_tsc) * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+}
+
 static void app_json_config_load_subsystem(void *_ctx);
+static void app_json_config_load_subsystem_config_entry(void *_ctx);
 
 static void
 app_json_config_load_done(struct load_json_config_ctx *ctx, int rc)
 {
-	spdk_poller_unregister(&ctx->client_conn_poller);
-	if (ctx->client_conn != NULL) {
-		spdk_jsonrpc_client_close(ctx->client_conn);
-	}
-
-	spdk_rpc_finish();
-
 	SPDK_DEBUG_APP_CFG("Config load finished with rc %d\n", rc);
+	if (rc == 0) {
+		SPDK_NOTICELOG("JSON configuration loaded in %" PRIu64 " us\n",
+			       app_json_config_elapsed_us(ctx->start_tsc));
+	}
 	ctx->cb_fn(rc, ctx->cb_arg);
 
-	free(ctx->json_data);
-	free(ctx->values);
-	free(ctx);
-}
-
-static void
-rpc_client_set_timeout(struct load_json_config_ctx *ctx, uint64_t timeout_us)
-{
-	ctx->timeout = spdk_get_ticks() + timeout_us * spdk_get_ticks_hz() / (1000 * 1000);
-}
-
-static int
-rpc_client_check_timeout(struct load_json_config_ctx *ctx)
-{
-	if (ctx->timeout < spdk_get_ticks()) {
-		SPDK_WARNLOG("RPC client command timeout.\n");
-		return -ETIMEDOUT;
+	spdk_json_stream_free(ctx->stream);
+	if (ctx->file != NULL) {
+		fclose(ctx->file);
 	}
-
-	return 0;
+	free(ctx->subsystem_name);
+	free(ctx);
 }
 
 struct json_write_buf {
@@ -151,143 +115,56 @@ json_write_stdout(void *cb_ctx, const void *data, size_t size)
 	return rc == size ? 0 : -1;
 }
 
-static int
-rpc_client_poller(void *arg)
-{
-	struct load_json_config_ctx *ctx = arg;
-	struct spdk_jsonrpc_client_response *resp;
-	client_resp_handler cb;
-	int rc;
-
-	assert(spdk_get_thread() == ctx->thread);
-
-	rc = spdk_jsonrpc_client_poll(ctx->client_conn, 0);
-	if (rc == 0) {
-		rc = rpc_client_check_timeout(ctx);
-		if (rc == -ETIMEDOUT) {
-			rpc_client_set_timeout(ctx, RPC_CLIENT_REQUEST_TIMEOUT_US);
-			rc = 0;
-		}
-	}
-
-	if (rc == 0) {
-		/* No response yet */
-		return SPDK_POLLER_BUSY;
-	} else if (rc < 0) {
-		app_json_config_load_done(ctx, rc);
-		return SPDK_POLLER_BUSY;
-	}
-
-	resp = spdk_jsonrpc_client_get_response(ctx->client_conn);
-	assert(resp);
-
-	if (resp->error) {
-		struct json_write_buf buf = {};
-		struct spdk_json_write_ctx *w = spdk_json_write_begin(json_write_stdout,
-						&buf, SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE);
-
-		if (w == NULL) {
-			SPDK_ERRLOG("error response: (?)\n");
-		} else {
-			spdk_json_write_val(w, resp->error);
-			spdk_json_write_end(w);
-			SPDK_ERRLOG("error response: \n%s\n", buf.data);
-		}
-	}
-
-	if (resp->error && ctx->stop_on_error) {
-		spdk_jsonrpc_client_free_response(resp);
-		app_json_config_load_done(ctx, -EINVAL);
-	} else {
-		/* We have response so we must have callback for it. */
-		cb = ctx->client_resp_cb;
-		assert(cb != NULL);
-
-		/* Mark we are done with this handler. */
-		ctx->client_resp_cb = NULL;
-		cb(ctx, resp);
-	}
-
-
-	return SPDK_POLLER_BUSY;
-}
-
-static int
-rpc_client_connect_poller(void *_ctx)
-{
-	struct load_json_config_ctx *ctx = _ctx;
-	int rc;
-
-	rc = spdk_jsonrpc_client_poll(ctx->client_conn, 0);
-	if (rc != -ENOTCONN) {
-		/* We are connected. Start regular poller and issue first request */
-		spdk_poller_unregister(&ctx->client_conn_poller);
-		ctx->client_conn_poller = SPDK_POLLER_REGISTER(rpc_client_poller, ctx, 100);
-		app_json_config_load_subsystem(ctx);
-	} else {
-		rc = rpc_client_check_timeout(ctx);
-		if (rc) {
-			app_json_config_load_done(ctx, rc);
-		}
-
-		return SPDK_POLLER_IDLE;
-	}
-
-	return SPDK_POLLER_BUSY;
-}
-
-static int
-client_send_request(struct load_json_config_ctx *ctx, struct spdk_jsonrpc_client_request *request,
-		    client_resp_handler client_resp_cb)
+static ssize_t
+app_json_config_read_cb(void *cb_ctx, void *buf, size_t size)
 {
-	int rc;
-
-	assert(spdk_get_thread() == ctx->thread);
-
-	ctx->client_resp_cb = client_resp_cb;
-	rpc_client_set_timeout(ctx, RPC_CLIENT_REQUEST_TIMEOUT_US);
-	rc = spdk_jsonrpc_client_send_request(ctx->client_conn, request);
+	FILE *file = cb_ctx;
+	size_t rc;
 
-	if (rc) {
-		SPDK_DEBUG_APP_CFG("Sending request to client failed (%d)\n", rc);
+	rc = fread(buf, 1, size, file);
+	if (rc == 0 && ferror(file)) {
+		return -EIO;
 	}
 
 	return rc;
 }
 
+/* Get the next token of the configuration, returns 0 on success */
 static int
-cap_string(const struct spdk_json_val *val, void *out)
+app_json_config_next(struct load_json_config_ctx *ctx, struct spdk_json_val *val)
 {
-	const struct spdk_json_val **vptr = out;
+	int rc;
 
-	if (val->type != SPDK_JSON_VAL_STRING) {
+	rc = spdk_json_stream_next(ctx->stream, val);
+	if (rc <= 0) {
+		SPDK_ERRLOG("Parsing JSON configuration failed (%d)\n", rc);
 		return -EINVAL;
 	}
 
-	*vptr = val;
 	return 0;
 }
 
 static int
-cap_object(const struct spdk_json_val *val, void *out)
+app_json_config_skip_value(struct load_json_config_ctx *ctx)
 {
-	const struct spdk_json_val **vptr = out;
+	struct spdk_json_val *values;
+	ssize_t rc;
 
-	if (val->type != SPDK_JSON_VAL_OBJECT_BEGIN) {
+	rc = spdk_json_stream_next_value(ctx->stream, &values);
+	if (rc <= 0) {
+		SPDK_ERRLOG("Parsing JSON configuration failed (%zd)\n", rc);
 		return -EINVAL;
 	}
 
-	*vptr = val;
 	return 0;
 }
 
-
 static int
-cap_array_or_null(const struct spdk_json_val *val, void *out)
+cap_object(const struct spdk_json_val *val, void *out)
 {
 	const struct spdk_json_val **vptr = out;
 
-	if (val->type != SPDK_JSON_VAL_ARRAY_BEGIN && val->type != SPDK_JSON_VAL_NULL) {
+	if (val->type != SPDK_JSON_VAL_OBJECT_BEGIN) {
 		return -EINVAL;
 	}
 
@@ -305,42 +182,79 @@ static struct spdk_json_object_decoder jsonrpc_cmd_decoders[] = {
 	{"params", offsetof(struct config_entry, params), cap_object, true}
 };
 
-static void app_json_config_load_subsystem_config_entry(void *_ctx);
+static void
+app_json_config_load_subsystem_config_entry_next(void *_ctx)
+{
+	struct load_json_config_ctx *ctx = _ctx;
+
+	if (ctx->rc != 0) {
+		app_json_config_load_done(ctx, ctx->rc);
+		return;
+	}
 
+	app_json_config_load_subsystem_config_entry(ctx);
+}
+
+/* Might be called from any thread */
 static void
-app_json_config_load_subsystem_config_entry_next(struct load_json_config_ctx *ctx,
+app_json_config_load_subsystem_config_entry_done(void *cb_arg,
 		struct spdk_jsonrpc_client_response *resp)
 {
-	/* Don't care about the response */
-	spdk_jsonrpc_client_free_response(resp);
+	struct load_json_config_ctx *ctx = cb_arg;
 
-	ctx->config_it = spdk_json_next(ctx->config_it);
-	app_json_config_load_subsystem_config_entry(ctx);
+	if (resp->error) {
+		struct json_write_buf buf = {};
+		struct spdk_json_write_ctx *w = spdk_json_write_begin(json_write_stdout,
+						&buf, SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE);
+
+		if (w == NULL) {
+			SPDK_ERRLOG("error response: (?)\n");
+		} else {
+			spdk_json_write_val(w, resp->error);
+			spdk_json_write_end(w);
+			SPDK_ERRLOG("error response: \n%s\n", buf.data);
+		}
+	} else if (resp->result == NULL) {
+		SPDK_ERRLOG("error response: (?)\n");
+	}
+
+	if (resp->result == NULL && ctx->stop_on_error) {
+		ctx->rc = -EINVAL;
+	}
+
+	/* The parameters of the request are released once the next entry is parsed, so this is
+	 * done only after the response was received. */
+	spdk_thread_send_msg(ctx->thread, app_json_config_load_subsystem_config_entry_next, ctx);
 }
 
+static void app_json_config_load_subsystem_keys(struct load_json_config_ctx *ctx);
+
 /* Load "config" entry */
 static void
 app_json_config_load_subsystem_config_entry(void *_ctx)
 {
 	struct load_json_config_ctx *ctx = _ctx;
-	struct spdk_jsonrpc_client_request *rpc_request;
-	struct spdk_json_write_ctx *w;
+	struct spdk_json_val *values;
 	struct config_entry cfg = {};
-	struct spdk_json_val *params_end;
-	size_t params_len = 0;
 	uint32_t state_mask = 0, cur_state_mask, startup_runtime = SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME;
-	int rc;
+	ssize_t rc;
 
-	if (ctx->config_it == NULL) {
-		SPDK_DEBUG_APP_CFG("Subsystem '%.*s': configuration done.\n", ctx->subsystem_name->len,
-				   (char *)ctx->subsystem_name->start);
-		ctx->subsystems_it = spdk_json_next(ctx->subsystems_it);
-		/* Invoke later to avoid recurrence */
-		spdk_thread_send_msg(ctx->thread, app_json_config_load_subsystem, ctx);
+	assert(spdk_get_thread() == ctx->thread);
+
+	rc = spdk_json_stream_next_value(ctx->stream, &values);
+	if (rc < 0) {
+		SPDK_ERRLOG("Parsing JSON configuration failed (%zd)\n", rc);
+		app_json_config_load_done(ctx, -EINVAL);
 		return;
 	}
 
-	if (spdk_json_decode_object(ctx->config_it, jsonrpc_cmd_decoders,
+	if (rc == 0) {
+		/* End of the "config" array */
+		app_json_config_load_subsystem_keys(ctx);
+		return;
+	}
+
+	if (spdk_json_decode_object(values, jsonrpc_cmd_decoders,
 				    SPDK_COUNTOF(jsonrpc_cmd_decoders), &cfg)) {
 		SPDK_ERRLOG("Failed to decode config entry\n");
 		app_json_config_load_done(ctx, -EINVAL);
@@ -357,7 +271,6 @@ app_json_config_load_subsystem_config_entry(void *_ctx)
 	if ((state_mask & cur_state_mask) != cur_state_mask) {
 		SPDK_DEBUG_APP_CFG("Method '%s' not allowed -> skipping\n", cfg.method);
 		/* Invoke later to avoid recurrence */
-		ctx->config_it = spdk_json_next(ctx->config_it);
 		spdk_thread_send_msg(ctx->thread, app_json_config_load_subsystem_config_entry, ctx);
 		goto out;
 	}
@@ -366,56 +279,164 @@ app_json_config_load_subsystem_config_entry(void *_ctx)
 		 * We should not call such methods twice, so ignore the second attempt in RUNTIME state */
 		SPDK_DEBUG_APP_CFG("Method '%s' has already been run in STARTUP state\n", cfg.method);
 		/* Invoke later to avoid recurrence */
-		ctx->config_it = spdk_json_next(ctx->config_it);
 		spdk_thread_send_msg(ctx->thread, app_json_config_load_subsystem_config_entry, ctx);
 		goto out;
 	}
 
 	SPDK_DEBUG_APP_CFG("\tmethod: %s\n", cfg.method);
 
-	if (cfg.params) {
-		/* Get _END by skipping params and going back by one element. */
-		params_end = cfg.params + spdk_json_val_len(cfg.params) - 1;
+	rc = spdk_rpc_call(cfg.method, cfg.params, app_json_config_load_subsystem_config_entry_done,
+			   ctx);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to call method '%s': %s\n", cfg.method, spdk_strerror(-rc));
+		app_json_config_load_done(ctx, rc);
+		goto out;
+	}
+out:
+	free(cfg.method);
+}
+
+/*
+ * Process the keys of the current subsystem object until its "config" array or its end.  The
+ * "subsystem" and "config" keys may come in any order, other keys are ignored.
+ */
+static void
+app_json_config_load_subsystem_keys(struct load_json_config_ctx *ctx)
+{
+	struct spdk_json_val val;
+	int rc;
 
-		/* Need to add one character to include '}' */
-		params_len = params_end->start - cfg.params->start + 1;
+	while (true) {
+		rc = app_json_config_next(ctx, &val);
+		if (rc != 0) {
+			app_json_config_load_done(ctx, rc);
+			return;
+		}
+
+		if (val.type == SPDK_JSON_VAL_OBJECT_END) {
+			break;
+		}
 
-		SPDK_DEBUG_APP_CFG("\tparams: %.*s\n", (int)params_len, (char *)cfg.params->start);
+		assert(val.type == SPDK_JSON_VAL_NAME);
+		if (spdk_json_strequal(&val, "subsystem")) {
+			rc = app_json_config_next(ctx, &val);
+			if (rc != 0 || val.type != SPDK_JSON_VAL_STRING) {
+				goto invalid;
+			}
+
+			free(ctx->subsystem_name);
+			ctx->subsystem_name = spdk_json_strdup(&val);
+			if (ctx->subsystem_name == NULL) {
+				app_json_config_load_done(ctx, -ENOMEM);
+				return;
+			}
+
+			SPDK_DEBUG_APP_CFG("Loading subsystem '%s' configuration\n", ctx->subsystem_name);
+		} else if (spdk_json_strequal(&val, "config")) {
+			rc = app_json_config_next(ctx, &val);
+			if (rc != 0 || (val.type != SPDK_JSON_VAL_ARRAY_BEGIN &&
+					val.type != SPDK_JSON_VAL_NULL)) {
+				goto invalid;
+			}
+
+			ctx->subsystem_config = true;
+			if (val.type == SPDK_JSON_VAL_ARRAY_BEGIN) {
+				app_json_config_load_subsystem_config_entry(ctx);
+				return;
+			}
+		} else {
+			rc = app_json_config_skip_value(ctx);
+			if (rc != 0) {
+				app_json_config_load_done(ctx, rc);
+				return;
+			}
+		}
 	}
 
-	rpc_request = spdk_jsonrpc_client_create_request();
-	if (!rpc_request) {
-		app_json_config_load_done(ctx, -errno);
-		goto out;
+	if (ctx->subsystem_name == NULL || !ctx->subsystem_config) {
+		goto invalid;
 	}
 
-	w = spdk_jsonrpc_begin_request(rpc_request, ctx->rpc_request_id, NULL);
-	if (!w) {
-		spdk_jsonrpc_client_free_request(rpc_request);
-		app_json_config_load_done(ctx, -ENOMEM);
-		goto out;
+	SPDK_DEBUG_APP_CFG("Subsystem '%s': configuration done.\n", ctx->subsystem_name);
+	SPDK_INFOLOG(app_config, "Subsystem '%s': %s configuration loaded in %" PRIu64 " us\n",
+		     ctx->subsystem_name, spdk_rpc_get_state() == SPDK_RPC_STARTUP ? "startup" : "runtime",
+		     app_json_config_elapsed_us(ctx->subsystem_tsc));
+	/* Invoke later to avoid recurrence */
+	spdk_thread_send_msg(ctx->thread, app_json_config_load_subsystem, ctx);
+	return;
+
+invalid:
+	SPDK_ERRLOG("Failed to parse subsystem configuration\n");
+	app_json_config_load_done(ctx, -EINVAL);
+}
+
+/*
+ * Start reading the configuration file from its beginning and look for the "subsystems" array.
+ * Returns 0 if the stream is positioned at the first subsystem, 1 if there are no subsystems.
+ */
+static int
+app_json_config_load_begin(struct load_json_config_ctx *ctx)
+{
+	struct spdk_json_val val;
+	int rc;
+
+	rewind(ctx->file);
+	spdk_json_stream_free(ctx->stream);
+	ctx->stream = spdk_json_stream_create(app_json_config_read_cb, ctx->file,
+					      SPDK_JSON_PARSE_FLAG_ALLOW_COMMENTS |
+					      SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE);
+	if (ctx->stream == NULL) {
+		return -ENOMEM;
 	}
 
-	spdk_json_write_named_string(w, "method", cfg.method);
+	rc = app_json_config_next(ctx, &val);
+	if (rc != 0) {
+		return rc;
+	}
 
-	if (cfg.params) {
-		/* No need to parse "params". Just dump the whole content of "params"
-		 * directly into the request and let the remote side verify it. */
-		spdk_json_write_name(w, "params");
-		spdk_json_write_val_raw(w, cfg.params->start, params_len);
+	if (val.type != SPDK_JSON_VAL_OBJECT_BEGIN) {
+		SPDK_ERRLOG("Invalid JSON configuration: not enclosed in {}.\n");
+		return -EINVAL;
 	}
 
-	spdk_jsonrpc_end_request(rpc_request, w);
+	while (true) {
+		rc = app_json_config_next(ctx, &val);
+		if (rc != 0) {
+			return rc;
+		}
 
-	rc = client_send_request(ctx, rpc_request, app_json_config_load_subsystem_config_entry_next);
+		if (val.type == SPDK_JSON_VAL_OBJECT_END) {
+			if (spdk_rpc_get_state() == SPDK_RPC_STARTUP) {
+				SPDK_WARNLOG("No 'subsystems' key JSON configuration file.\n");
+			}
+			return 1;
+		}
+
+		if (spdk_json_strequal(&val, "subsystems")) {
+			break;
+		}
+
+		rc = app_json_config_skip_value(ctx);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	rc = app_json_config_next(ctx, &val);
 	if (rc != 0) {
-		app_json_config_load_done(ctx, -rc);
-		goto out;
+		return rc;
 	}
-out:
-	free(cfg.method);
+
+	if (val.type != SPDK_JSON_VAL_ARRAY_BEGIN) {
+		SPDK_ERRLOG("Invalid JSON configuration: 'subsystems' should be an array.\n");
+		return -EINVAL;
+	}
+
+	return 0;
 }
 
+static void app_json_config_load_end(struct load_json_config_ctx *ctx);
+
 static void
 subsystem_init_done(int rc, void *arg1)
 {
@@ -431,130 +452,72 @@ subsystem_init_done(int rc, void *arg1)
 	SPDK_DEBUG_APP_CFG("'framework_start_init' done - continuing configuration\n");
 
 	assert(ctx != NULL);
-	if (ctx->subsystems) {
-		ctx->subsystems_it = spdk_json_array_first(ctx->subsystems);
+	rc = app_json_config_load_begin(ctx);
+	if (rc < 0) {
+		app_json_config_load_done(ctx, rc);
+	} else if (rc > 0) {
+		app_json_config_load_end(ctx);
+	} else {
+		app_json_config_load_subsystem(ctx);
 	}
-
-	app_json_config_load_subsystem(ctx);
 }
 
-static struct spdk_json_object_decoder subsystem_decoders[] = {
-	{"subsystem", offsetof(struct load_json_config_ctx, subsystem_name), cap_string},
-	{"config", offsetof(struct load_json_config_ctx, config), cap_array_or_null}
-};
+/* All subsystems were walked for the current state */
+static void
+app_json_config_load_end(struct load_json_config_ctx *ctx)
+{
+	if (spdk_rpc_get_state() == SPDK_RPC_STARTUP) {
+		SPDK_DEBUG_APP_CFG("No more entries for current state, calling 'framework_start_init'\n");
+		spdk_subsystem_init(subsystem_init_done, ctx);
+	} else {
+		app_json_config_load_done(ctx, 0);
+	}
+}
 
 /*
- * Start loading subsystem pointed by ctx->subsystems_it. This must point to the
- * beginning of the "subsystem" object in "subsystems" array or be NULL. If it is
- * NULL then no more subsystems to load.
+ * Start loading the next subsystem of the "subsystems" array.
  *
  * There are two iterations:
  *
  * In first iteration only STARTUP RPC methods are used, other methods are ignored. When
- * allsubsystems are walked the ctx->subsystems_it became NULL and "framework_start_init"
- * is called to let the SPDK move to RUNTIME state (initialize all subsystems) and
- * second iteration begins.
+ * all subsystems are walked "framework_start_init" is called to let the SPDK move to
+ * RUNTIME state (initialize all subsystems) and second iteration begins, reading the
+ * file again.
  *
  * In second iteration "subsystems" array is walked through again, this time only
- * RUNTIME RPC methods are used. When ctx->subsystems_it became NULL second time it
- * indicate that there is no more subsystems to load. The cb_fn is called to finish
+ * RUNTIME RPC methods are used. When the end of the array is reached the second time it
+ * indicates that there are no more subsystems to load. The cb_fn is called to finish
  * configuration.
  */
 static void
 app_json_config_load_subsystem(void *_ctx)
 {
 	struct load_json_config_ctx *ctx = _ctx;
+	struct spdk_json_val val;
+	int rc;
 
-	if (ctx->subsystems_it == NULL) {
-		if (spdk_rpc_get_state() == SPDK_RPC_STARTUP) {
-			SPDK_DEBUG_APP_CFG("No more entries for current state, calling 'framework_start_init'\n");
-			spdk_subsystem_init(subsystem_init_done, ctx);
-		} else {
-			app_json_config_load_done(ctx, 0);
-		}
+	rc = app_json_config_next(ctx, &val);
+	if (rc != 0) {
+		app_json_config_load_done(ctx, rc);
+		return;
+	}
 
+	if (val.type == SPDK_JSON_VAL_ARRAY_END) {
+		app_json_config_load_end(ctx);
 		return;
 	}
 
-	/* Capture subsystem name and config array */
-	if (spdk_json_decode_object(ctx->subsystems_it, subsystem_decoders,
-				    SPDK_COUNTOF(subsystem_decoders), ctx)) {
+	if (val.type != SPDK_JSON_VAL_OBJECT_BEGIN) {
 		SPDK_ERRLOG("Failed to parse subsystem configuration\n");
 		app_json_config_load_done(ctx, -EINVAL);
 		return;
 	}
 
-	SPDK_DEBUG_APP_CFG("Loading subsystem '%.*s' configuration\n", ctx->subsystem_name->len,
-			   (char *)ctx->subsystem_name->start);
-
-	/* Get 'config' array first configuration entry */
-	ctx->config_it = spdk_json_array_first(ctx->config);
-	app_json_config_load_subsystem_config_entry(ctx);
-}
-
-static void *
-read_file(const char *filename, size_t *size)
-{
-	FILE *file = fopen(filename, "r");
-	void *data;
-
-	if (file == NULL) {
-		/* errno is set by fopen */
-		return NULL;
-	}
-
-	data = spdk_posix_file_load(file, size);
-	fclose(file);
-	return data;
-}
-
-static int
-app_json_config_read(const char *config_file, struct load_json_config_ctx *ctx)
-{
-	struct spdk_json_val *values = NULL;
-	void *json = NULL, *end;
-	ssize_t values_cnt, rc;
-	size_t json_size;
-
-	json = read_file(config_file, &json_size);
-	if (!json) {
-		SPDK_ERRLOG("Read JSON configuration file %s failed: %s\n",
-			    config_file, spdk_strerror(errno));
-		return -errno;
-	}
-
-	rc = spdk_json_parse(json, json_size, NULL, 0, &end,
-			     SPDK_JSON_PARSE_FLAG_ALLOW_COMMENTS);
-	if (rc < 0) {
-		SPDK_ERRLOG("Parsing JSON configuration failed (%zd)\n", rc);
-		goto err;
-	}
-
-	values_cnt = rc;
-	values = calloc(values_cnt, sizeof(struct spdk_json_val));
-	if (values == NULL) {
-		SPDK_ERRLOG("Out of memory\n");
-		goto err;
-	}
-
-	rc = spdk_json_parse(json, json_size, values, values_cnt, &end,
-			     SPDK_JSON_PARSE_FLAG_ALLOW_COMMENTS);
-	if (rc != values_cnt) {
-		SPDK_ERRLOG("Parsing JSON configuration failed (%zd)\n", rc);
-		goto err;
-	}
-
-	ctx->json_data = json;
-	ctx->json_data_size = json_size;
-
-	ctx->values = values;
-	ctx->values_cnt = values_cnt;
-
-	return 0;
-err:
-	free(json);
-	free(values);
-	return rc;
+	free(ctx->subsystem_name);
+	ctx->subsystem_name = NULL;
+	ctx->subsystem_config = false;
+	ctx->subsystem_tsc = spdk_get_ticks();
+	app_json_config_load_subsystem_keys(ctx);
 }
 
 void
@@ -575,62 +538,31 @@ spdk_subsystem_init_from_json_config(const char *json_config_file, const char *r
 	ctx->cb_arg = cb_arg;
 	ctx->stop_on_error = stop_on_error;
 	ctx->thread = spdk_get_thread();
+	ctx->start_tsc = spdk_get_ticks();
 
-	rc = app_json_config_read(json_config_file, ctx);
-	if (rc) {
-		goto fail;
-	}
-
-	/* Capture subsystems array */
-	rc = spdk_json_find_array(ctx->values, "subsystems", NULL, &ctx->subsystems);
-	switch (rc) {
-	case 0:
-		/* Get first subsystem */
-		ctx->subsystems_it = spdk_json_array_first(ctx->subsystems);
-		if (ctx->subsystems_it == NULL) {
-			SPDK_NOTICELOG("'subsystems' configuration is empty\n");
-		}
-		break;
-	case -EPROTOTYPE:
-		SPDK_ERRLOG("Invalid JSON configuration: not enclosed in {}.\n");
-		goto fail;
-	case -ENOENT:
-		SPDK_WARNLOG("No 'subsystems' key JSON configuration file.\n");
-		break;
-	case -EDOM:
-		SPDK_ERRLOG("Invalid JSON configuration: 'subsystems' should be an array.\n");
-		goto fail;
-	default:
-		SPDK_ERRLOG("Failed to parse JSON configuration.\n");
+	ctx->file = fopen(json_config_file, "r");
+	if (ctx->file == NULL) {
+		SPDK_ERRLOG("Read JSON configuration file %s failed: %s\n",
+			    json_config_file, spdk_strerror(errno));
 		goto fail;
 	}
 
-	/* If rpc_addr is not an Unix socket use default address as prefix. */
-	if (rpc_addr == NULL || rpc_addr[0] != '/') {
-		rpc_addr = SPDK_DEFAULT_RPC_ADDR;
-	}
-
-	/* FIXME: rpc client should use socketpair() instead of this temporary socket nonsense */
-	rc = snprintf(ctx->rpc_socket_path_temp, sizeof(ctx->rpc_socket_path_temp), "%s.%d_config",
-		      rpc_addr, getpid());
-	if (rc >= (int)sizeof(ctx->rpc_socket_path_temp)) {
-		SPDK_ERRLOG("Socket name create failed\n");
+	if (!spdk_rpc_verify_methods()) {
 		goto fail;
 	}
 
-	rc = spdk_rpc_initialize(ctx->rpc_socket_path_temp);
-	if (rc) {
-		goto fail;
-	}
+	/* The RPC methods are called directly, so there's no RPC server to set the state */
+	spdk_rpc_set_state(SPDK_RPC_STARTUP);
 
-	ctx->client_conn = spdk_jsonrpc_client_connect(ctx->rpc_socket_path_temp, AF_UNIX);
-	if (ctx->client_conn == NULL) {
-		SPDK_ERRLOG("Failed to connect to '%s'\n", ctx->rpc_socket_path_temp);
+	rc = app_json_config_load_begin(ctx);
+	if (rc < 0) {
 		goto fail;
+	} else if (rc > 0) {
+		app_json_config_load_end(ctx);
+		return;
 	}
 
-	rpc_client_set_timeout(ctx, RPC_CLIENT_CONNECT_TIMEOUT_US);
-	ctx->client_conn_poller = SPDK_POLLER_REGISTER(rpc_client_connect_poller, ctx, 100);
+	app_json_config_load_subsystem(ctx);
 	return;
 
 fail:
@@ -10,11 +10,27 @@
 #include "spdk/thread.h"
 #include "spdk/log.h"
 #include "spdk/rpc.h"
+#include "spdk/string.h"
 
 #define RPC_SELECT_INTERVAL	4000 /* 4ms */
 
 static struct spdk_poller *g_rpc_poller = NULL;
 
+/* Dedicated thread polling the server, the methods are still called on g_rpc_app_thread */
+static struct {
+	pthread_t		thread;
+	bool			running;
+	volatile bool		stop;
+} g_rpc_server_thread;
+static struct spdk_thread *g_rpc_app_thread;
+
+struct rpc_dispatch_ctx {
+	spdk_jsonrpc_handle_request_fn	handle_request;
+	struct spdk_jsonrpc_request	*request;
+	const struct spdk_json_val	*method;
+	const struct spdk_json_val	*params;
+};
+
 static int
 rpc_subsystem_poll(void *arg)
 {
@@ -22,8 +38,56 @@ rpc_subsystem_poll(void *arg)
 	return SPDK_POLLER_BUSY;
 }
 
-int
-spdk_rpc_initialize(const char *listen_addr)
+static void
+rpc_dispatch_msg(void *arg)
+{
+	struct rpc_dispatch_ctx *ctx = arg;
+
+	ctx->handle_request(ctx->request, ctx->method, ctx->params);
+	free(ctx);
+}
+
+static void
+rpc_dispatch(spdk_jsonrpc_handle_request_fn handle_request, struct spdk_jsonrpc_request *request,
+	     const struct spdk_json_val *method, const struct spdk_json_val *params)
+{
+	struct rpc_dispatch_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(ENOMEM));
+		return;
+	}
+
+	ctx->handle_request = handle_request;
+	ctx->request = request;
+	ctx->method = method;
+	ctx->params = params;
+
+	/* The request, including its method and params, stays valid until it's responded to */
+	if (spdk_thread_send_msg(g_rpc_app_thread, rpc_dispatch_msg, ctx) != 0) {
+		free(ctx);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(ENOMEM));
+	}
+}
+
+static void *
+rpc_server_thread(void *arg)
+{
+	spdk_unaffinitize_thread();
+
+	while (!g_rpc_server_thread.stop) {
+		spdk_rpc_accept();
+		usleep(RPC_SELECT_INTERVAL);
+	}
+
+	return NULL;
+}
+
+static int
+rpc_initialize(const char *listen_addr, bool server_thread)
 {
 	int rc;
 
@@ -47,15 +111,52 @@ spdk_rpc_initialize(const char *listen_addr)
 
 	spdk_rpc_set_state(SPDK_RPC_STARTUP);
 
+	if (server_thread) {
+		g_rpc_app_thread = spdk_get_thread();
+		spdk_rpc_set_dispatch_fn(rpc_dispatch);
+		g_rpc_server_thread.stop = false;
+
+		rc = pthread_create(&g_rpc_server_thread.thread, NULL, rpc_server_thread, NULL);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to create RPC server thread: %s\n", spdk_strerror(rc));
+			spdk_rpc_set_dispatch_fn(NULL);
+			spdk_rpc_close();
+			return -rc;
+		}
+
+		pthread_setname_np(g_rpc_server_thread.thread, "rpc_server");
+		g_rpc_server_thread.running = true;
+		return 0;
+	}
+
 	/* Register a poller to periodically check for RPCs */
 	g_rpc_poller = SPDK_POLLER_REGISTER(rpc_subsystem_poll, NULL, RPC_SELECT_INTERVAL);
 
 	return 0;
 }
 
+int
+spdk_rpc_initialize(const char *listen_addr)
+{
+	return rpc_initialize(listen_addr, false);
+}
+
+int
+spdk_rpc_initialize_threaded(const char *listen_addr)
+{
+	return rpc_initialize(listen_addr, true);
+}
+
 void
 spdk_rpc_finish(void)
 {
+	if (g_rpc_server_thread.running) {
+		g_rpc_server_thread.stop = true;
+		pthread_join(g_rpc_server_thread.thread, NULL);
+		g_rpc_server_thread.running = false;
+		spdk_rpc_set_dispatch_fn(NULL);
+	}
+
 	spdk_rpc_close();
 	spdk_poller_unregister(&g_rpc_poller);
 }
@@ -14,6 +14,7 @@
 #include "spdk/env.h"
 
 #include "spdk/json.h"
+#include "spdk/util.h"
 
 #include "subsystem.h"
 
@@ -30,6 +31,9 @@ static void *g_subsystem_start_arg = NULL;
 static spdk_msg_fn g_subsystem_stop_fn = NULL;
 static void *g_subsystem_stop_arg = NULL;
 static struct spdk_thread *g_fini_thread = NULL;
+/* Tick at which the initialization of all subsystems and of the current one started */
+static uint64_t g_subsystems_init_tsc;
+static uint64_t g_subsystem_init_tsc;
 
 void
 spdk_add_subsystem(struct spdk_subsystem *subsystem)
@@ -134,6 +138,12 @@ subsystem_sort(void)
 	TAILQ_SWAP(&sorted_list, &g_subsystems, spdk_subsystem, tailq);
 }
 
+static uint64_t
+subsystem_ticks_to_us(uint64_t ticks)
+{
+	return ticks * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+}
+
 void
 spdk_subsystem_init_next(int rc)
 {
@@ -153,15 +163,20 @@ spdk_subsystem_init_next(int rc)
 	if (!g_next_subsystem) {
 		g_next_subsystem = TAILQ_FIRST(&g_subsystems);
 	} else {
+		SPDK_INFOLOG(init, "Subsystem %s initialized in %" PRIu64 " us\n", g_next_subsystem->name,
+			     subsystem_ticks_to_us(spdk_get_ticks() - g_subsystem_init_tsc));
 		g_next_subsystem = TAILQ_NEXT(g_next_subsystem, tailq);
 	}
 
 	if (!g_next_subsystem) {
 		g_subsystems_initialized = true;
+		SPDK_NOTICELOG("All subsystems initialized in %" PRIu64 " us\n",
+			       subsystem_ticks_to_us(spdk_get_ticks() - g_subsystems_init_tsc));
 		g_subsystem_start_fn(0, g_subsystem_start_arg);
 		return;
 	}
 
+	g_subsystem_init_tsc = spdk_get_ticks();
 	if (g_next_subsystem->init) {
 		g_next_subsystem->init();
 	} else {
@@ -196,6 +211,7 @@ spdk_subsystem_init(spdk_subsystem_init_fn cb_fn, void *cb_arg)
 
 	subsystem_sort();
 
+	g_subsystems_init_tsc = spdk_get_ticks();
 	spdk_subsystem_init_next(0);
 }
 
@@ -261,3 +277,5 @@ subsystem_config_json(struct spdk_json_write_ctx *w, struct spdk_subsystem *subs
 		spdk_json_write_null(w);
 	}
 }
+
+SPDK_LOG_REGISTER_COMPONENT(init)
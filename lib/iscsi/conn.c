@@ -6,6 +6,7 @@
 
 #include "spdk/stdinc.h"
 
+#include "spdk/accel.h"
 #include "spdk/endian.h"
 #include "spdk/env.h"
 #include "spdk/likely.h"
@@ -34,9 +35,29 @@
 
 #define SPDK_ISCSI_CONNECTION_STATUS(status, rnstr) case(status): return(rnstr)
 
-static struct spdk_iscsi_conn *g_conns_array = NULL;
+/* Connection objects are carved out of slabs which are allocated on demand,
+ *  so that memory use follows the number of connections actually seen. Each
+ *  NUMA socket keeps its own free list, and a connection is taken from the
+ *  socket of the poll group it will run on.
+ */
+#define ISCSI_CONNS_PER_SLAB	64
+
+struct iscsi_conn_slab {
+	TAILQ_ENTRY(iscsi_conn_slab)	link;
+	struct spdk_iscsi_conn		conns[ISCSI_CONNS_PER_SLAB];
+};
+
+struct iscsi_conn_cache {
+	int					socket_id;
+	TAILQ_HEAD(, spdk_iscsi_conn)		free_conns;
+	TAILQ_ENTRY(iscsi_conn_cache)		link;
+};
+
+static TAILQ_HEAD(, iscsi_conn_slab) g_conn_slabs = TAILQ_HEAD_INITIALIZER(g_conn_slabs);
+static TAILQ_HEAD(, iscsi_conn_cache) g_conn_caches = TAILQ_HEAD_INITIALIZER(g_conn_caches);
+static uint32_t g_num_conns;
+static uint32_t g_max_conns;
 
-static TAILQ_HEAD(, spdk_iscsi_conn) g_free_conns = TAILQ_HEAD_INITIALIZER(g_free_conns);
 static TAILQ_HEAD(, spdk_iscsi_conn) g_active_conns = TAILQ_HEAD_INITIALIZER(g_active_conns);
 
 static pthread_mutex_t g_conns_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -46,21 +67,95 @@ static struct spdk_poller *g_shutdown_timer = NULL;
 static void iscsi_conn_sock_cb(void *arg, struct spdk_sock_group *group,
 			       struct spdk_sock *sock);
 
+static struct iscsi_conn_cache *
+iscsi_conn_cache_get(int socket_id)
+{
+	struct iscsi_conn_cache *cache;
+
+	TAILQ_FOREACH(cache, &g_conn_caches, link) {
+		if (cache->socket_id == socket_id) {
+			return cache;
+		}
+	}
+
+	cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	cache->socket_id = socket_id;
+	TAILQ_INIT(&cache->free_conns);
+	TAILQ_INSERT_TAIL(&g_conn_caches, cache, link);
+
+	return cache;
+}
+
+static int
+iscsi_conn_cache_grow(struct iscsi_conn_cache *cache)
+{
+	struct iscsi_conn_slab *slab;
+	uint32_t i, num;
+
+	if (g_num_conns >= g_max_conns) {
+		return -ENOMEM;
+	}
+
+	slab = spdk_zmalloc(sizeof(*slab), 0, NULL, cache->socket_id, SPDK_MALLOC_DMA);
+	if (slab == NULL && cache->socket_id != SPDK_ENV_SOCKET_ID_ANY) {
+		slab = spdk_zmalloc(sizeof(*slab), 0, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	}
+	if (slab == NULL) {
+		return -ENOMEM;
+	}
+
+	/* IDs are never reused by another slab, so they stay unique and stable. */
+	num = spdk_min(ISCSI_CONNS_PER_SLAB, g_max_conns - g_num_conns);
+	for (i = 0; i < num; i++) {
+		slab->conns[i].id = g_num_conns + i;
+		slab->conns[i].socket_id = cache->socket_id;
+		TAILQ_INSERT_TAIL(&cache->free_conns, &slab->conns[i], conn_link);
+	}
+	g_num_conns += num;
+
+	TAILQ_INSERT_TAIL(&g_conn_slabs, slab, link);
+
+	return 0;
+}
+
 static struct spdk_iscsi_conn *
-allocate_conn(void)
+allocate_conn(int socket_id)
 {
-	struct spdk_iscsi_conn	*conn;
+	struct iscsi_conn_cache *cache, *tmp;
+	struct spdk_iscsi_conn	*conn = NULL;
 
 	pthread_mutex_lock(&g_conns_mutex);
-	conn = TAILQ_FIRST(&g_free_conns);
+	cache = iscsi_conn_cache_get(socket_id);
+	if (cache == NULL) {
+		goto exit;
+	}
+
+	if (TAILQ_EMPTY(&cache->free_conns) && iscsi_conn_cache_grow(cache) != 0) {
+		/* Out of budget for new slabs. Fall back to a free connection
+		 *  from any other socket rather than refusing the login.
+		 */
+		TAILQ_FOREACH(tmp, &g_conn_caches, link) {
+			if (!TAILQ_EMPTY(&tmp->free_conns)) {
+				cache = tmp;
+				break;
+			}
+		}
+	}
+
+	conn = TAILQ_FIRST(&cache->free_conns);
 	if (conn != NULL) {
 		assert(!conn->is_valid);
-		TAILQ_REMOVE(&g_free_conns, conn, conn_link);
+		TAILQ_REMOVE(&cache->free_conns, conn, conn_link);
 		SPDK_ISCSI_CONNECTION_MEMSET(conn);
 		conn->is_valid = 1;
 
 		TAILQ_INSERT_TAIL(&g_active_conns, conn, conn_link);
 	}
+exit:
 	pthread_mutex_unlock(&g_conns_mutex);
 
 	return conn;
@@ -69,13 +164,24 @@ allocate_conn(void)
 static void
 _free_conn(struct spdk_iscsi_conn *conn)
 {
+	struct iscsi_conn_cache *cache;
+
 	TAILQ_REMOVE(&g_active_conns, conn, conn_link);
 
 	memset(conn->portal_host, 0, sizeof(conn->portal_host));
 	memset(conn->portal_port, 0, sizeof(conn->portal_port));
 	conn->is_valid = 0;
 
-	TAILQ_INSERT_TAIL(&g_free_conns, conn, conn_link);
+	/* The cache of the slab's socket was created when the slab was allocated. */
+	TAILQ_FOREACH(cache, &g_conn_caches, link) {
+		if (cache->socket_id == conn->socket_id) {
+			break;
+		}
+	}
+	assert(cache != NULL);
+
+	/* Recently freed connections are reused first while they are still hot in cache. */
+	TAILQ_INSERT_HEAD(&cache->free_conns, conn, conn_link);
 }
 
 static void
@@ -89,25 +195,32 @@ free_conn(struct spdk_iscsi_conn *conn)
 static void
 _iscsi_conns_cleanup(void)
 {
-	free(g_conns_array);
+	struct iscsi_conn_slab *slab, *tmp_slab;
+	struct iscsi_conn_cache *cache, *tmp_cache;
+
+	TAILQ_FOREACH_SAFE(slab, &g_conn_slabs, link, tmp_slab) {
+		TAILQ_REMOVE(&g_conn_slabs, slab, link);
+		spdk_free(slab);
+	}
+
+	TAILQ_FOREACH_SAFE(cache, &g_conn_caches, link, tmp_cache) {
+		TAILQ_REMOVE(&g_conn_caches, cache, link);
+		free(cache);
+	}
+
+	g_num_conns = 0;
 }
 
 int
 initialize_iscsi_conns(void)
 {
-	uint32_t i;
-
 	SPDK_DEBUGLOG(iscsi, "spdk_iscsi_init\n");
 
-	g_conns_array = calloc(MAX_ISCSI_CONNECTIONS, sizeof(struct spdk_iscsi_conn));
-	if (g_conns_array == NULL) {
-		return -ENOMEM;
-	}
-
-	for (i = 0; i < MAX_ISCSI_CONNECTIONS; i++) {
-		g_conns_array[i].id = i;
-		TAILQ_INSERT_TAIL(&g_free_conns, &g_conns_array[i], conn_link);
-	}
+	/* Slabs are allocated as connections arrive. MAX_ISCSI_CONNECTIONS is
+	 *  only a floor of the limit now, which follows MaxConnections above it.
+	 */
+	g_max_conns = spdk_max(MAX_ISCSI_CONNECTIONS, g_iscsi.MaxConnections);
+	g_num_conns = 0;
 
 	return 0;
 }
@@ -173,7 +286,16 @@ iscsi_conn_construct(struct spdk_iscsi_portal *portal,
 	struct spdk_iscsi_conn *conn;
 	int i, rc;
 
-	conn = allocate_conn();
+	/* Get the first poll group. */
+	pg = TAILQ_FIRST(&g_iscsi.poll_group_head);
+	if (pg == NULL) {
+		SPDK_ERRLOG("There is no poll group.\n");
+		assert(false);
+		return -1;
+	}
+
+	/* Place the connection on the NUMA socket of the poll group it will run on. */
+	conn = allocate_conn(pg->socket_id);
 	if (conn == NULL) {
 		SPDK_ERRLOG("Could not allocate connection.\n");
 		return -1;
@@ -249,14 +371,6 @@ iscsi_conn_construct(struct spdk_iscsi_portal *portal,
 	SPDK_DEBUGLOG(iscsi, "Launching connection on acceptor thread\n");
 	conn->pending_task_cnt = 0;
 
-	/* Get the first poll group. */
-	pg = TAILQ_FIRST(&g_iscsi.poll_group_head);
-	if (pg == NULL) {
-		SPDK_ERRLOG("There is no poll group.\n");
-		assert(false);
-		goto error_return;
-	}
-
 	conn->pg = pg;
 	spdk_thread_send_msg(spdk_io_channel_get_thread(spdk_io_channel_from_ctx(pg)),
 			     iscsi_conn_start, conn);
@@ -313,11 +427,16 @@ iscsi_conn_free_tasks(struct spdk_iscsi_conn *conn)
 	 *  have to ensure there is no associated task in conn->queued_datain_tasks.
 	 */
 	TAILQ_FOREACH_SAFE(pdu, &conn->write_pdu_list, tailq, tmp_pdu) {
+		if (pdu->data_digest_pending) {
+			/* Freed once the accel framework is done with it */
+			continue;
+		}
 		TAILQ_REMOVE(&conn->write_pdu_list, pdu, tailq);
 		iscsi_conn_free_pdu(conn, pdu);
 	}
+	conn->write_pdu_next = NULL;
 
-	if (conn->pending_task_cnt) {
+	if (conn->pending_task_cnt || conn->data_digest_pending_cnt) {
 		return -1;
 	}
 
@@ -699,10 +818,6 @@ iscsi_get_active_conns(struct spdk_iscsi_tgt_node *target)
 	struct spdk_iscsi_conn *conn;
 	int num = 0;
 
-	if (g_conns_array == MAP_FAILED) {
-		return 0;
-	}
-
 	pthread_mutex_lock(&g_conns_mutex);
 	TAILQ_FOREACH(conn, &g_active_conns, conn_link) {
 		if (target == NULL || conn->target == target) {
@@ -778,6 +893,14 @@ static void
 _iscsi_conn_request_logout(void *ctx)
 {
 	struct spdk_iscsi_conn *conn = ctx;
+	struct spdk_thread *thread;
+
+	/* The connection may have been moved to another poll group meanwhile */
+	thread = spdk_io_channel_get_thread(spdk_io_channel_from_ctx(conn->pg));
+	if (thread != spdk_get_thread()) {
+		spdk_thread_send_msg(thread, _iscsi_conn_request_logout, conn);
+		return;
+	}
 
 	if (conn->state > ISCSI_CONN_STATE_RUNNING ||
 	    conn->logout_request_timer != NULL) {
@@ -810,10 +933,6 @@ iscsi_conns_request_logout(struct spdk_iscsi_tgt_node *target, int pg_tag)
 {
 	struct spdk_iscsi_conn	*conn;
 
-	if (g_conns_array == MAP_FAILED) {
-		return;
-	}
-
 	pthread_mutex_lock(&g_conns_mutex);
 	TAILQ_FOREACH(conn, &g_active_conns, conn_link) {
 		if ((target == NULL) ||
@@ -858,10 +977,6 @@ iscsi_drop_conns(struct spdk_iscsi_conn *conn, const char *conn_match,
 
 	num = 0;
 	pthread_mutex_lock(&g_conns_mutex);
-	if (g_conns_array == MAP_FAILED) {
-		goto exit;
-	}
-
 	TAILQ_FOREACH(xconn, &g_active_conns, conn_link) {
 		if (xconn == conn) {
 			continue;
@@ -903,7 +1018,6 @@ iscsi_drop_conns(struct spdk_iscsi_conn *conn, const char *conn_match,
 		}
 	}
 
-exit:
 	pthread_mutex_unlock(&g_conns_mutex);
 
 	if (num != 0) {
@@ -1419,12 +1533,99 @@ iscsi_conn_pdu_generic_complete(void *cb_arg)
 {
 }
 
+static void
+iscsi_conn_flush_write_pdus(struct spdk_iscsi_conn *conn)
+{
+	struct spdk_iscsi_pdu *pdu;
+
+	if (conn->write_pdus_corked) {
+		return;
+	}
+
+	while ((pdu = conn->write_pdu_next) != NULL && !pdu->data_digest_pending) {
+		if (spdk_unlikely(conn->state >= ISCSI_CONN_STATE_EXITING)) {
+			return;
+		}
+
+		conn->write_pdu_next = TAILQ_NEXT(pdu, tailq);
+
+		pdu->sock_req.iovcnt = iscsi_build_iovs(conn, pdu->iov, SPDK_COUNTOF(pdu->iov), pdu,
+							&pdu->mapped_length);
+		pdu->sock_req.cb_fn = _iscsi_conn_pdu_write_done;
+		pdu->sock_req.cb_arg = pdu;
+
+		spdk_trace_record(TRACE_ISCSI_FLUSH_WRITEBUF_START, conn->id, pdu->mapped_length,
+				  (uintptr_t)pdu, pdu->sock_req.iovcnt);
+		spdk_sock_writev_async(conn->sock, &pdu->sock_req);
+	}
+}
+
+static void
+iscsi_conn_data_digest_done(void *cb_arg, int status)
+{
+	struct spdk_iscsi_pdu *pdu = cb_arg;
+	struct spdk_iscsi_conn *conn = pdu->conn;
+	uint32_t crc32c;
+
+	assert(conn->data_digest_pending_cnt > 0);
+	pdu->data_digest_pending = false;
+	conn->data_digest_pending_cnt--;
+
+	if (spdk_likely(status == 0)) {
+		crc32c = pdu->crc32c ^ SPDK_CRC32C_XOR;
+	} else {
+		crc32c = iscsi_pdu_calc_data_digest(pdu);
+	}
+	MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
+
+	iscsi_conn_flush_write_pdus(conn);
+}
+
+/* Submit the data digest computation of a PDU to the accel framework. Completions
+ * are gathered by the accel poller, so the digests of all the PDUs built during
+ * a poll iteration are computed in one batch, while the socket keeps sending the
+ * PDUs queued before them.
+ */
+static int
+iscsi_conn_submit_data_digest(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu)
+{
+	static uint8_t pad[ISCSI_ALIGNMENT - 1];
+	uint32_t data_len = DGET24(pdu->bhs.data_segment_len);
+	uint32_t iovcnt = 1;
+	int rc;
+
+	if (conn->pg == NULL || conn->pg->accel_channel == NULL || pdu->dif_insert_or_strip) {
+		return -ENOTSUP;
+	}
+
+	pdu->data_digest_iovs[0].iov_base = pdu->data;
+	pdu->data_digest_iovs[0].iov_len = data_len;
+	if (data_len % ISCSI_ALIGNMENT != 0) {
+		pdu->data_digest_iovs[1].iov_base = pad;
+		pdu->data_digest_iovs[1].iov_len = ISCSI_ALIGNMENT - data_len % ISCSI_ALIGNMENT;
+		iovcnt++;
+	}
+
+	pdu->data_digest_pending = true;
+	conn->data_digest_pending_cnt++;
+
+	rc = spdk_accel_submit_crc32cv(conn->pg->accel_channel, &pdu->crc32c, pdu->data_digest_iovs,
+				       iovcnt, 0, iscsi_conn_data_digest_done, pdu);
+	if (spdk_unlikely(rc != 0)) {
+		pdu->data_digest_pending = false;
+		conn->data_digest_pending_cnt--;
+	}
+
+	return rc;
+}
+
 void
 iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 		     iscsi_conn_xfer_complete_cb cb_fn,
 		     void *cb_arg)
 {
 	uint32_t crc32c;
+	bool calc_data_digest = false;
 	ssize_t rc;
 
 	if (spdk_unlikely(pdu->dif_insert_or_strip)) {
@@ -1443,11 +1644,7 @@ iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 			MAKE_DIGEST_WORD(pdu->header_digest, crc32c);
 		}
 
-		/* Data Digest */
-		if (conn->data_digest && DGET24(pdu->bhs.data_segment_len) != 0) {
-			crc32c = iscsi_pdu_calc_data_digest(pdu);
-			MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
-		}
+		calc_data_digest = conn->data_digest && DGET24(pdu->bhs.data_segment_len) != 0;
 	}
 
 	pdu->cb_fn = cb_fn;
@@ -1457,14 +1654,32 @@ iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 	if (spdk_unlikely(conn->state >= ISCSI_CONN_STATE_EXITING)) {
 		return;
 	}
-	pdu->sock_req.iovcnt = iscsi_build_iovs(conn, pdu->iov, SPDK_COUNTOF(pdu->iov), pdu,
-						&pdu->mapped_length);
-	pdu->sock_req.cb_fn = _iscsi_conn_pdu_write_done;
-	pdu->sock_req.cb_arg = pdu;
 
-	spdk_trace_record(TRACE_ISCSI_FLUSH_WRITEBUF_START, conn->id, pdu->mapped_length, (uintptr_t)pdu,
-			  pdu->sock_req.iovcnt);
-	spdk_sock_writev_async(conn->sock, &pdu->sock_req);
+	/* Data Digest */
+	if (calc_data_digest && iscsi_conn_submit_data_digest(conn, pdu) != 0) {
+		crc32c = iscsi_pdu_calc_data_digest(pdu);
+		MAKE_DIGEST_WORD(pdu->data_digest, crc32c);
+	}
+
+	if (conn->write_pdu_next == NULL) {
+		conn->write_pdu_next = pdu;
+	}
+	iscsi_conn_flush_write_pdus(conn);
+}
+
+void
+iscsi_conn_cork_write_pdus(struct spdk_iscsi_conn *conn)
+{
+	assert(!conn->write_pdus_corked);
+	conn->write_pdus_corked = true;
+}
+
+void
+iscsi_conn_uncork_write_pdus(struct spdk_iscsi_conn *conn)
+{
+	assert(conn->write_pdus_corked);
+	conn->write_pdus_corked = false;
+	iscsi_conn_flush_write_pdus(conn);
 }
 
 static void
@@ -1491,9 +1706,29 @@ static void
 iscsi_conn_full_feature_migrate(void *arg)
 {
 	struct spdk_iscsi_conn *conn = arg;
+	struct spdk_iscsi_tgt_node *target;
+	struct spdk_iscsi_poll_group *pg = conn->pg;
 
 	assert(conn->state != ISCSI_CONN_STATE_EXITED);
 
+	/* The target node may have been moved to another poll group by the
+	 * rebalancer after this message was sent. Follow it, so that all the
+	 * connections of a target node stay on the same poll group.
+	 */
+	if (conn->sess->session_type == SESSION_TYPE_NORMAL) {
+		target = conn->sess->target;
+		pthread_mutex_lock(&target->mutex);
+		pg = target->pg;
+		pthread_mutex_unlock(&target->mutex);
+	}
+
+	if (pg != conn->pg) {
+		conn->pg = pg;
+		spdk_thread_send_msg(spdk_io_channel_get_thread(spdk_io_channel_from_ctx(pg)),
+				     iscsi_conn_full_feature_migrate, conn);
+		return;
+	}
+
 	/* Note: it is possible that connection could have moved to EXITING
 	 * state after this message was sent. We will still add it to the
 	 * poll group in this case.  When the poll group is polled
@@ -1563,6 +1798,190 @@ iscsi_conn_schedule(struct spdk_iscsi_conn *conn)
 			     iscsi_conn_full_feature_migrate, conn);
 }
 
+#define ISCSI_CONN_MIGRATE_POLL_PERIOD_US	100
+
+static void
+iscsi_conn_migrate_done(void *arg)
+{
+	struct spdk_iscsi_conn *conn = arg;
+	int rc;
+
+	iscsi_conn_open_luns(conn);
+	iscsi_poll_group_add_conn(conn->pg, conn);
+	conn->migrate_pg = NULL;
+
+	/* Handle the PDU parked while draining, if any. The socket may not have
+	 * anything else to read to wake the connection up.
+	 */
+	if (conn->state == ISCSI_CONN_STATE_RUNNING) {
+		rc = iscsi_handle_incoming_pdus(conn);
+		if (rc < 0) {
+			conn->state = ISCSI_CONN_STATE_EXITING;
+		}
+	}
+}
+
+static bool
+iscsi_conn_is_drained(struct spdk_iscsi_conn *conn)
+{
+	struct spdk_iscsi_lun *iscsi_lun;
+
+	if (conn->pending_task_cnt != 0 || conn->data_digest_pending_cnt != 0 ||
+	    conn->pdu_recv_state == ISCSI_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD ||
+	    !TAILQ_EMPTY(&conn->write_pdu_list) ||
+	    !TAILQ_EMPTY(&conn->queued_datain_tasks) ||
+	    !TAILQ_EMPTY(&conn->queued_r2t_tasks) ||
+	    !TAILQ_EMPTY(&conn->active_r2t_tasks)) {
+		return false;
+	}
+
+	TAILQ_FOREACH(iscsi_lun, &conn->luns, tailq) {
+		if (iscsi_lun->remove_poller != NULL) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int
+iscsi_conn_migrate_poll(void *arg)
+{
+	struct spdk_iscsi_conn *conn = arg;
+	int rc;
+
+	if (conn->state != ISCSI_CONN_STATE_RUNNING || conn->logout_request_timer != NULL ||
+	    conn->logout_timer != NULL) {
+		/* The connection is going away, there's no point in moving it. */
+		spdk_poller_unregister(&conn->migrate_poller);
+		conn->migrate_pg = NULL;
+		if (conn->state == ISCSI_CONN_STATE_RUNNING) {
+			rc = iscsi_handle_incoming_pdus(conn);
+			if (rc < 0) {
+				conn->state = ISCSI_CONN_STATE_EXITING;
+			}
+		}
+		return SPDK_POLLER_BUSY;
+	}
+
+	if (!iscsi_conn_is_drained(conn)) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	spdk_poller_unregister(&conn->migrate_poller);
+
+	/* Nothing refers to the I/O channels of this thread anymore */
+	iscsi_poll_group_remove_conn(conn->pg, conn);
+	iscsi_conn_close_luns(conn);
+
+	conn->pg = conn->migrate_pg;
+	spdk_thread_send_msg(spdk_io_channel_get_thread(spdk_io_channel_from_ctx(conn->pg)),
+			     iscsi_conn_migrate_done, conn);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static bool
+iscsi_conn_can_migrate(struct spdk_iscsi_conn *conn)
+{
+	return conn->state == ISCSI_CONN_STATE_RUNNING && conn->full_feature &&
+	       conn->migrate_pg == NULL && conn->logout_request_timer == NULL &&
+	       conn->logout_timer == NULL;
+}
+
+struct iscsi_tgt_node_migrate_ctx {
+	struct spdk_iscsi_tgt_node	*target;
+	struct spdk_iscsi_poll_group	*src_pg;
+	struct spdk_iscsi_poll_group	*dst_pg;
+};
+
+static void
+_iscsi_tgt_node_migrate_conns(void *arg)
+{
+	struct iscsi_tgt_node_migrate_ctx *ctx = arg;
+	struct spdk_iscsi_tgt_node *target = ctx->target;
+	struct spdk_iscsi_poll_group *src_pg = ctx->src_pg;
+	struct spdk_iscsi_poll_group *dst_pg = ctx->dst_pg;
+	struct spdk_iscsi_tgt_node *tmp;
+	struct spdk_iscsi_conn *conn;
+
+	free(ctx);
+
+	pthread_mutex_lock(&g_iscsi.mutex);
+
+	/* The target node might have been destructed in the meantime */
+	TAILQ_FOREACH(tmp, &g_iscsi.target_head, tailq) {
+		if (tmp == target) {
+			break;
+		}
+	}
+	if (tmp == NULL) {
+		pthread_mutex_unlock(&g_iscsi.mutex);
+		return;
+	}
+
+	pthread_mutex_lock(&target->mutex);
+
+	if (target->pg != src_pg || target->num_active_conns == 0) {
+		goto unlock;
+	}
+
+	/* Move either all the connections of the target node or none of them */
+	STAILQ_FOREACH(conn, &src_pg->connections, pg_link) {
+		if (conn->sess != NULL && conn->sess->target == target &&
+		    !iscsi_conn_can_migrate(conn)) {
+			goto unlock;
+		}
+	}
+
+	SPDK_DEBUGLOG(iscsi, "Moving target %s to another poll group\n", target->name);
+	target->pg = dst_pg;
+
+	STAILQ_FOREACH(conn, &src_pg->connections, pg_link) {
+		if (conn->sess != NULL && conn->sess->target == target) {
+			conn->migrate_pg = dst_pg;
+			conn->migrate_poller = SPDK_POLLER_REGISTER(iscsi_conn_migrate_poll, conn,
+						ISCSI_CONN_MIGRATE_POLL_PERIOD_US);
+		}
+	}
+
+unlock:
+	pthread_mutex_unlock(&target->mutex);
+	pthread_mutex_unlock(&g_iscsi.mutex);
+}
+
+/* Move all the connections of a target node to another poll group. New commands
+ *  are held back while the in-flight ones complete on the current poll group,
+ *  then each connection is handed over with its LUNs reopened on the new one.
+ */
+void
+iscsi_tgt_node_migrate_conns(struct spdk_iscsi_tgt_node *target,
+			     struct spdk_iscsi_poll_group *pg)
+{
+	struct iscsi_tgt_node_migrate_ctx *ctx;
+	struct spdk_iscsi_poll_group *src_pg;
+
+	pthread_mutex_lock(&target->mutex);
+	src_pg = target->pg;
+	pthread_mutex_unlock(&target->mutex);
+
+	if (src_pg == NULL || src_pg == pg) {
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return;
+	}
+
+	ctx->target = target;
+	ctx->src_pg = src_pg;
+	ctx->dst_pg = pg;
+
+	spdk_thread_send_msg(spdk_io_channel_get_thread(spdk_io_channel_from_ctx(src_pg)),
+			     _iscsi_tgt_node_migrate_conns, ctx);
+}
+
 static int
 logout_timeout(void *arg)
 {
@@ -55,6 +55,8 @@ struct spdk_iscsi_lun {
 struct spdk_iscsi_conn {
 	int				id;
 	int				is_valid;
+	/* NUMA socket of the slab this connection was allocated from */
+	int				socket_id;
 	/*
 	 * All fields below this point are reinitialized each time the
 	 *  connection object is allocated.  Make sure to update the
@@ -103,6 +105,18 @@ struct spdk_iscsi_conn {
 	TAILQ_HEAD(, spdk_iscsi_pdu) write_pdu_list;
 	TAILQ_HEAD(, spdk_iscsi_pdu) snack_pdu_list;
 
+	/* First PDU of write_pdu_list not handed to the socket yet. PDUs are
+	 *  written in order, so any PDU queued behind one whose data digest is
+	 *  still being computed has to wait for it.
+	 */
+	struct spdk_iscsi_pdu *write_pdu_next;
+	uint32_t data_digest_pending_cnt;
+
+	/* While set, PDUs are queued to write_pdu_list but not handed to the
+	 *  socket, so that a burst of PDUs reaches the socket back to back.
+	 */
+	bool write_pdus_corked;
+
 	uint32_t pending_r2t;
 
 	uint16_t cid;
@@ -162,6 +176,14 @@ struct spdk_iscsi_conn {
 
 	STAILQ_ENTRY(spdk_iscsi_conn) pg_link;
 	bool			is_stopped;  /* Set true when connection is stopped for migration */
+
+	/* Poll group this connection is being moved to by the rebalancer. New
+	 *  commands are held back until the in-flight ones are done.
+	 */
+	struct spdk_iscsi_poll_group	*migrate_pg;
+	struct spdk_poller		*migrate_poller;
+	/* PDUs received since the poll group load was last sampled */
+	uint32_t			recv_pdu_cnt;
 	TAILQ_HEAD(queued_r2t_tasks, spdk_iscsi_task)	queued_r2t_tasks;
 	TAILQ_HEAD(active_r2t_tasks, spdk_iscsi_task)	active_r2t_tasks;
 	TAILQ_HEAD(queued_datain_tasks, spdk_iscsi_task)	queued_datain_tasks;
@@ -186,6 +208,8 @@ void iscsi_conn_schedule(struct spdk_iscsi_conn *conn);
 void iscsi_conn_logout(struct spdk_iscsi_conn *conn);
 int iscsi_drop_conns(struct spdk_iscsi_conn *conn,
 		     const char *conn_match, int drop_all);
+void iscsi_tgt_node_migrate_conns(struct spdk_iscsi_tgt_node *target,
+				  struct spdk_iscsi_poll_group *pg);
 int iscsi_conn_handle_queued_datain_tasks(struct spdk_iscsi_conn *conn);
 int iscsi_conn_abort_queued_datain_task(struct spdk_iscsi_conn *conn,
 					uint32_t ref_task_tag);
@@ -199,6 +223,8 @@ int iscsi_conn_readv_data(struct spdk_iscsi_conn *conn,
 void iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 			  iscsi_conn_xfer_complete_cb cb_fn,
 			  void *cb_arg);
+void iscsi_conn_cork_write_pdus(struct spdk_iscsi_conn *conn);
+void iscsi_conn_uncork_write_pdus(struct spdk_iscsi_conn *conn);
 
 void iscsi_conn_free_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu);
 
@@ -2882,8 +2882,9 @@ iscsi_conn_datain_pdu_complete(void *arg)
 static int
 iscsi_send_datain(struct spdk_iscsi_conn *conn,
 		  struct spdk_iscsi_task *task, int datain_flag,
-		  int residual_len, int offset, int DataSN, int len)
+		  int residual_len, int offset, int DataSN, int len, bool last)
 {
+	iscsi_conn_xfer_complete_cb cb_fn;
 	struct spdk_iscsi_pdu *rsp_pdu;
 	struct iscsi_bhs_data_in *rsph;
 	uint32_t task_tag;
@@ -2979,7 +2980,17 @@ iscsi_send_datain(struct spdk_iscsi_conn *conn,
 		}
 	}
 
-	iscsi_conn_write_pdu(conn, rsp_pdu, iscsi_conn_datain_pdu_complete, conn);
+	/* Only the last Data-In PDU of the task releases the task and lets the next
+	 *  queued read be submitted. Deferred PDUs kept for SNACK may be released in
+	 *  any order, so all of them have to check then.
+	 */
+	if (last || conn->sess->ErrorRecoveryLevel >= 1) {
+		cb_fn = iscsi_conn_datain_pdu_complete;
+	} else {
+		cb_fn = iscsi_conn_pdu_generic_complete;
+	}
+
+	iscsi_conn_write_pdu(conn, rsp_pdu, cb_fn, conn);
 
 	return DataSN;
 }
@@ -3029,6 +3040,12 @@ iscsi_transfer_in(struct spdk_iscsi_conn *conn, struct spdk_iscsi_task *task)
 	DataSN = primary->datain_datasn;
 	sent_status = 0;
 
+	/* The Data-In PDUs reference the data buffer of the task directly. Hand
+	 *  them to the socket together, so that they are gathered into as few
+	 *  vectored, and possibly zero-copy, sends as possible.
+	 */
+	iscsi_conn_cork_write_pdus(conn);
+
 	/* calculate the number of sequences for all data-in pdus */
 	datain_seq_cnt = 1 + ((transfer_len - 1) / (int)conn->sess->MaxBurstLength);
 	for (i = 0; i < datain_seq_cnt; i++) {
@@ -3061,10 +3078,12 @@ iscsi_transfer_in(struct spdk_iscsi_conn *conn, struct spdk_iscsi_task *task)
 				      conn->StatSN, DataSN, offset, len);
 
 			DataSN = iscsi_send_datain(conn, task, datain_flag, residual_len,
-						   offset, DataSN, len);
+						   offset, DataSN, len, offset + len == transfer_len);
 		}
 	}
 
+	iscsi_conn_uncork_write_pdus(conn);
+
 	if (task != primary) {
 		primary->scsi.data_transferred += task->scsi.data_transferred;
 	}
@@ -4817,6 +4836,17 @@ iscsi_read_pdu(struct spdk_iscsi_conn *conn)
 				}
 			}
 
+			/* While the connection is being moved to another poll group, only
+			 *  let through the PDUs needed to complete the in-flight tasks and
+			 *  to keep the connection alive. Others are parked here and handled
+			 *  once the move is done.
+			 */
+			if (spdk_unlikely(conn->migrate_pg != NULL) &&
+			    pdu->bhs.opcode != ISCSI_OP_SCSI_DATAOUT &&
+			    pdu->bhs.opcode != ISCSI_OP_NOPOUT) {
+				return 0;
+			}
+
 			rc = iscsi_pdu_hdr_handle(conn, pdu);
 			if (rc < 0) {
 				SPDK_ERRLOG("Critical error is detected. Close the connection\n");
@@ -4848,6 +4878,7 @@ iscsi_read_pdu(struct spdk_iscsi_conn *conn)
 			}
 			if (rc == 0) {
 				spdk_trace_record(TRACE_ISCSI_TASK_EXECUTED, 0, 0, (uintptr_t)pdu);
+				conn->recv_pdu_cnt++;
 				iscsi_put_pdu(pdu);
 				conn->pdu_in_progress = NULL;
 				conn->pdu_recv_state = ISCSI_PDU_RECV_STATE_AWAIT_PDU_READY;
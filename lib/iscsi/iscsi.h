@@ -49,6 +49,10 @@
 #define DEFAULT_TIMEOUT 60
 #define MAX_NOPININTERVAL 60
 #define DEFAULT_NOPININTERVAL 30
+#define DEFAULT_CONN_REBALANCE_INTERVAL 0
+/* Minimum busy percentage gap between two poll groups to move a target node */
+#define ISCSI_REBALANCE_LOAD_GAP 20
+#define DEFAULT_MAX_LUN_TASKS_PER_INITIATOR 0
 
 /*
  * SPDK iSCSI target currently only supports 64KB as the maximum data segment length
@@ -164,6 +168,9 @@ struct spdk_iscsi_pdu {
 	uint32_t data_offset;
 	uint32_t crc32c;
 	bool dif_insert_or_strip;
+	/* Data digest is being computed by the accel framework */
+	bool data_digest_pending;
+	struct iovec data_digest_iovs[2];
 	struct spdk_dif_ctx dif_ctx;
 	struct spdk_iscsi_conn *conn;
 
@@ -287,7 +294,15 @@ struct spdk_iscsi_poll_group {
 	struct spdk_poller				*nop_poller;
 	STAILQ_HEAD(connections, spdk_iscsi_conn)	connections;
 	struct spdk_sock_group				*sock_group;
+	struct spdk_io_channel				*accel_channel;
+	int						socket_id;
 	TAILQ_ENTRY(spdk_iscsi_poll_group)		link;
+
+	/* Load sampling for connection rebalancing */
+	uint64_t					last_busy_tsc;
+	uint64_t					last_idle_tsc;
+	uint64_t					recv_pdus;
+	uint32_t					load;
 };
 
 struct spdk_iscsi_opts {
@@ -314,6 +329,8 @@ struct spdk_iscsi_opts {
 	uint32_t pdu_pool_size;
 	uint32_t immediate_data_pool_size;
 	uint32_t data_out_pool_size;
+	uint32_t conn_rebalance_interval;
+	uint32_t max_lun_tasks_per_initiator;
 };
 
 struct spdk_iscsi_globals {
@@ -350,6 +367,9 @@ struct spdk_iscsi_globals {
 	uint32_t pdu_pool_size;
 	uint32_t immediate_data_pool_size;
 	uint32_t data_out_pool_size;
+	uint32_t conn_rebalance_interval;
+	struct spdk_poller *rebalance_poller;
+	uint32_t max_lun_tasks_per_initiator;
 
 	struct spdk_mempool *pdu_pool;
 	struct spdk_mempool *pdu_immediate_data_pool;
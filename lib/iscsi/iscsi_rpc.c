@@ -1653,6 +1653,8 @@ static const struct spdk_json_object_decoder rpc_set_iscsi_opts_decoders[] = {
 	{"pdu_pool_size", offsetof(struct spdk_iscsi_opts, pdu_pool_size), spdk_json_decode_uint32, true},
 	{"immediate_data_pool_size", offsetof(struct spdk_iscsi_opts, immediate_data_pool_size), spdk_json_decode_uint32, true},
 	{"data_out_pool_size", offsetof(struct spdk_iscsi_opts, data_out_pool_size), spdk_json_decode_uint32, true},
+	{"conn_rebalance_interval", offsetof(struct spdk_iscsi_opts, conn_rebalance_interval), spdk_json_decode_uint32, true},
+	{"max_lun_tasks_per_initiator", offsetof(struct spdk_iscsi_opts, max_lun_tasks_per_initiator), spdk_json_decode_uint32, true},
 };
 
 static void
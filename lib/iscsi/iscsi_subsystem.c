@@ -4,6 +4,7 @@
  *   All rights reserved.
  */
 
+#include "spdk/accel.h"
 #include "spdk/string.h"
 #include "spdk/likely.h"
 
@@ -290,6 +291,12 @@ iscsi_log_globals(void)
 
 	SPDK_DEBUGLOG(iscsi, "MaxR2TPerConnection %d\n",
 		      g_iscsi.MaxR2TPerConnection);
+
+	SPDK_DEBUGLOG(iscsi, "ConnRebalanceInterval %d\n",
+		      g_iscsi.conn_rebalance_interval);
+
+	SPDK_DEBUGLOG(iscsi, "MaxLunTasksPerInitiator %d\n",
+		      g_iscsi.max_lun_tasks_per_initiator);
 }
 
 #define NUM_PDU_PER_CONNECTION(opts)	(2 * (opts->MaxQueueDepth +	\
@@ -324,6 +331,8 @@ iscsi_opts_init(struct spdk_iscsi_opts *opts)
 	opts->pdu_pool_size = PDU_POOL_SIZE(opts);
 	opts->immediate_data_pool_size = IMMEDIATE_DATA_POOL_SIZE(opts);
 	opts->data_out_pool_size = DATA_OUT_POOL_SIZE(opts);
+	opts->conn_rebalance_interval = DEFAULT_CONN_REBALANCE_INTERVAL;
+	opts->max_lun_tasks_per_initiator = DEFAULT_MAX_LUN_TASKS_PER_INITIATOR;
 }
 
 struct spdk_iscsi_opts *
@@ -401,6 +410,8 @@ iscsi_opts_copy(struct spdk_iscsi_opts *src)
 	dst->pdu_pool_size = src->pdu_pool_size;
 	dst->immediate_data_pool_size = src->immediate_data_pool_size;
 	dst->data_out_pool_size = src->data_out_pool_size;
+	dst->conn_rebalance_interval = src->conn_rebalance_interval;
+	dst->max_lun_tasks_per_initiator = src->max_lun_tasks_per_initiator;
 
 	return dst;
 }
@@ -553,6 +564,8 @@ iscsi_set_global_params(struct spdk_iscsi_opts *opts)
 	g_iscsi.pdu_pool_size = opts->pdu_pool_size;
 	g_iscsi.immediate_data_pool_size = opts->immediate_data_pool_size;
 	g_iscsi.data_out_pool_size = opts->data_out_pool_size;
+	g_iscsi.conn_rebalance_interval = opts->conn_rebalance_interval;
+	g_iscsi.max_lun_tasks_per_initiator = opts->max_lun_tasks_per_initiator;
 
 	iscsi_log_globals();
 
@@ -929,6 +942,101 @@ iscsi_init_complete(int rc)
 	cb_fn(cb_arg, rc);
 }
 
+static void
+iscsi_poll_group_sample_load(struct spdk_io_channel_iter *i)
+{
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_iscsi_poll_group *pg = spdk_io_channel_get_ctx(ch);
+	struct spdk_iscsi_conn *conn;
+	struct spdk_thread_stats stats;
+	uint64_t busy, idle;
+
+	if (spdk_thread_get_stats(&stats) == 0) {
+		busy = stats.busy_tsc - pg->last_busy_tsc;
+		idle = stats.idle_tsc - pg->last_idle_tsc;
+		pg->load = busy + idle != 0 ? busy * 100 / (busy + idle) : 0;
+		pg->last_busy_tsc = stats.busy_tsc;
+		pg->last_idle_tsc = stats.idle_tsc;
+	}
+
+	/* All the connections of a target node are on the same poll group, so
+	 * the counters of a target node are only updated from this thread.
+	 */
+	pg->recv_pdus = 0;
+	STAILQ_FOREACH(conn, &pg->connections, pg_link) {
+		if (conn->full_feature && conn->sess != NULL && conn->sess->target != NULL) {
+			conn->sess->target->recv_pdus += conn->recv_pdu_cnt;
+			pg->recv_pdus += conn->recv_pdu_cnt;
+		}
+		conn->recv_pdu_cnt = 0;
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+iscsi_rebalance_conns(struct spdk_io_channel_iter *i, int status)
+{
+	struct spdk_iscsi_poll_group *pg, *max_pg = NULL, *min_pg = NULL;
+	struct spdk_iscsi_tgt_node *target, *best = NULL;
+	uint64_t gap, load, best_load = 0;
+
+	pthread_mutex_lock(&g_iscsi.mutex);
+
+	TAILQ_FOREACH(pg, &g_iscsi.poll_group_head, link) {
+		if (max_pg == NULL || pg->load > max_pg->load) {
+			max_pg = pg;
+		}
+		if (min_pg == NULL || pg->load < min_pg->load) {
+			min_pg = pg;
+		}
+	}
+
+	if (max_pg == NULL || max_pg->recv_pdus == 0 ||
+	    max_pg->load < min_pg->load + ISCSI_REBALANCE_LOAD_GAP) {
+		goto out;
+	}
+
+	/* Estimate the share of its poll group's load each target node accounts for
+	 * from the PDUs it received. Pick the busiest one which still fits into half
+	 * the gap, so that the two poll groups don't just swap places.
+	 */
+	gap = (max_pg->load - min_pg->load) / 2;
+	TAILQ_FOREACH(target, &g_iscsi.target_head, tailq) {
+		if (target->pg != max_pg || target->num_active_conns == 0) {
+			continue;
+		}
+
+		load = max_pg->load * target->recv_pdus / max_pg->recv_pdus;
+		if (load <= gap && load > best_load) {
+			best = target;
+			best_load = load;
+		}
+	}
+
+	if (best != NULL) {
+		SPDK_DEBUGLOG(iscsi, "Moving target %s (load %" PRIu64 "%%) from poll group "
+			      "with load %u%% to one with load %u%%\n", best->name, best_load,
+			      max_pg->load, min_pg->load);
+		iscsi_tgt_node_migrate_conns(best, min_pg);
+	}
+
+out:
+	TAILQ_FOREACH(target, &g_iscsi.target_head, tailq) {
+		target->recv_pdus = 0;
+	}
+
+	pthread_mutex_unlock(&g_iscsi.mutex);
+}
+
+static int
+iscsi_rebalance_poll(void *ctx)
+{
+	spdk_for_each_channel(&g_iscsi, iscsi_poll_group_sample_load, NULL, iscsi_rebalance_conns);
+
+	return SPDK_POLLER_BUSY;
+}
+
 static void
 iscsi_parse_configuration(void)
 {
@@ -946,6 +1054,11 @@ iscsi_parse_configuration(void)
 		}
 	}
 
+	if (g_iscsi.conn_rebalance_interval != 0) {
+		g_iscsi.rebalance_poller = SPDK_POLLER_REGISTER(iscsi_rebalance_poll, NULL,
+					   g_iscsi.conn_rebalance_interval * 1000000ULL);
+	}
+
 	iscsi_init_complete(rc);
 }
 
@@ -993,9 +1106,15 @@ iscsi_poll_group_create(void *io_device, void *ctx_buf)
 	struct spdk_iscsi_poll_group *pg = ctx_buf;
 
 	STAILQ_INIT(&pg->connections);
+	pg->socket_id = spdk_env_get_socket_id(spdk_env_get_current_core());
 	pg->sock_group = spdk_sock_group_create(NULL);
 	assert(pg->sock_group != NULL);
 
+	/* Data digests of outgoing PDUs are computed through the accel framework
+	 * if it's available. Otherwise they are computed inline.
+	 */
+	pg->accel_channel = spdk_accel_get_io_channel();
+
 	pg->poller = SPDK_POLLER_REGISTER(iscsi_poll_group_poll, pg, 0);
 	/* set the period to 1 sec */
 	pg->nop_poller = SPDK_POLLER_REGISTER(iscsi_poll_group_handle_nop, pg, 1000000);
@@ -1014,6 +1133,9 @@ iscsi_poll_group_destroy(void *io_device, void *ctx_buf)
 	assert(pg->sock_group != NULL);
 
 	spdk_sock_group_close(&pg->sock_group);
+	if (pg->accel_channel != NULL) {
+		spdk_put_io_channel(pg->accel_channel);
+	}
 	spdk_poller_unregister(&pg->poller);
 	spdk_poller_unregister(&pg->nop_poller);
 
@@ -1152,6 +1274,7 @@ spdk_iscsi_fini(spdk_iscsi_fini_cb cb_fn, void *cb_arg)
 	g_fini_cb_fn = cb_fn;
 	g_fini_cb_arg = cb_arg;
 
+	spdk_poller_unregister(&g_iscsi.rebalance_poller);
 	iscsi_portal_grp_close_all();
 	shutdown_iscsi_conns();
 }
@@ -1260,6 +1383,9 @@ iscsi_opts_info_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_named_uint32(w, "immediate_data_pool_size",
 				     g_iscsi.immediate_data_pool_size);
 	spdk_json_write_named_uint32(w, "data_out_pool_size", g_iscsi.data_out_pool_size);
+	spdk_json_write_named_uint32(w, "conn_rebalance_interval", g_iscsi.conn_rebalance_interval);
+	spdk_json_write_named_uint32(w, "max_lun_tasks_per_initiator",
+				     g_iscsi.max_lun_tasks_per_initiator);
 
 	spdk_json_write_object_end(w);
 }
@@ -1111,6 +1111,8 @@ struct spdk_iscsi_tgt_node *iscsi_tgt_node_construct(int target_index,
 		return NULL;
 	}
 
+	spdk_scsi_dev_set_max_tasks_per_initiator(target->dev, g_iscsi.max_lun_tasks_per_initiator);
+
 	TAILQ_INIT(&target->pg_map_head);
 	rc = iscsi_target_node_add_pg_ig_maps(target, pg_tag_list,
 					      ig_tag_list, num_maps);
@@ -58,6 +58,11 @@ struct spdk_iscsi_tgt_node {
 	 */
 	uint32_t num_active_conns;
 	struct spdk_iscsi_poll_group *pg;
+	/**
+	 * PDUs received on the connections of this target node during the
+	 *  current rebalance period.
+	 */
+	uint64_t recv_pdus;
 
 	int num_pg_maps;
 	TAILQ_HEAD(, spdk_iscsi_pg_map) pg_map_head;
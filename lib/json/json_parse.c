@@ -4,6 +4,7 @@
  */
 
 #include "spdk/json.h"
+#include "spdk/util.h"
 
 #include "spdk_internal/utf.h"
 
@@ -355,7 +356,7 @@ json_valid_comment(const uint8_t *start, const uint8_t *buf_end)
 	p += 2;
 
 	if (multiline) {
-		while (p != buf_end - 1) {
+		while (p < buf_end - 1) {
 			if (p[0] == '*' && p[1] == '/') {
 				/* Include the terminating star and slash in the comment */
 				return p - start + 2;
@@ -638,3 +639,400 @@ done_invalid:
 	rc = SPDK_JSON_PARSE_INVALID;
 	goto done_rc;
 }
+
+#define JSON_STREAM_READ_SIZE	(64 * 1024)
+
+struct spdk_json_stream {
+	spdk_json_stream_read_fn	read_fn;
+	void				*cb_ctx;
+	uint32_t			flags;
+
+	uint8_t				*buf;
+	size_t				buf_size;
+	/* Number of bytes read into buf */
+	size_t				len;
+	/* Number of bytes of buf already consumed */
+	size_t				pos;
+	bool				eof;
+
+	enum {
+		STREAM_STATE_VALUE,
+		STREAM_STATE_VALUE_SEPARATOR,
+		STREAM_STATE_NAME,
+		STREAM_STATE_NAME_SEPARATOR,
+		STREAM_STATE_END,
+	} state;
+	bool				trailing_comma;
+	size_t				depth;
+	enum spdk_json_val_type		containers[SPDK_JSON_MAX_NESTING_DEPTH];
+
+	/* Values returned by spdk_json_stream_next_value() */
+	struct spdk_json_val		*values;
+	size_t				num_values;
+};
+
+struct spdk_json_stream *
+spdk_json_stream_create(spdk_json_stream_read_fn read_fn, void *cb_ctx, uint32_t flags)
+{
+	struct spdk_json_stream *stream;
+
+	stream = calloc(1, sizeof(*stream));
+	if (stream == NULL) {
+		return NULL;
+	}
+
+	stream->buf_size = JSON_STREAM_READ_SIZE;
+	stream->buf = malloc(stream->buf_size);
+	if (stream->buf == NULL) {
+		free(stream);
+		return NULL;
+	}
+
+	stream->read_fn = read_fn;
+	stream->cb_ctx = cb_ctx;
+	stream->flags = flags;
+	stream->state = STREAM_STATE_VALUE;
+
+	return stream;
+}
+
+void
+spdk_json_stream_free(struct spdk_json_stream *stream)
+{
+	if (stream == NULL) {
+		return;
+	}
+
+	free(stream->values);
+	free(stream->buf);
+	free(stream);
+}
+
+/*
+ * Read more data into the buffer, dropping the data that was already consumed.  The amount of
+ * data requested is at least equal to the amount of unconsumed data, so that reparsing a value
+ * that spans multiple reads stays linear in its size.
+ */
+static int
+json_stream_fill(struct spdk_json_stream *stream)
+{
+	size_t avail, size;
+	uint8_t *buf;
+	ssize_t rc;
+
+	if (stream->eof) {
+		return 0;
+	}
+
+	if (stream->pos > 0) {
+		memmove(stream->buf, stream->buf + stream->pos, stream->len - stream->pos);
+		stream->len -= stream->pos;
+		stream->pos = 0;
+	}
+
+	avail = spdk_max(stream->len, (size_t)JSON_STREAM_READ_SIZE);
+	if (stream->buf_size - stream->len < avail) {
+		size = spdk_max(stream->buf_size * 2, stream->len + avail);
+		buf = realloc(stream->buf, size);
+		if (buf == NULL) {
+			return -ENOMEM;
+		}
+
+		stream->buf = buf;
+		stream->buf_size = size;
+	}
+
+	do {
+		rc = stream->read_fn(stream->cb_ctx, stream->buf + stream->len,
+				     stream->buf_size - stream->len);
+	} while (rc == -EINTR || rc == -EAGAIN);
+
+	if (rc < 0) {
+		return rc;
+	}
+
+	if (rc == 0) {
+		stream->eof = true;
+	}
+
+	stream->len += rc;
+	return rc;
+}
+
+/* Skip whitespace and comments.  On success, the stream is positioned at a token or at EOF. */
+static int
+json_stream_skip_ws(struct spdk_json_stream *stream)
+{
+	uint8_t c;
+	int rc;
+
+	while (true) {
+		if (stream->pos == stream->len) {
+			if (stream->eof) {
+				return 0;
+			}
+
+			rc = json_stream_fill(stream);
+			if (rc < 0) {
+				return rc;
+			}
+			continue;
+		}
+
+		c = stream->buf[stream->pos];
+		if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+			stream->pos++;
+			continue;
+		}
+
+		if (c != '/' || !(stream->flags & SPDK_JSON_PARSE_FLAG_ALLOW_COMMENTS)) {
+			return 0;
+		}
+
+		rc = json_valid_comment(stream->buf + stream->pos, stream->buf + stream->len);
+		if (rc == SPDK_JSON_PARSE_INCOMPLETE && !stream->eof) {
+			rc = json_stream_fill(stream);
+			if (rc < 0) {
+				return rc;
+			}
+			continue;
+		}
+
+		if (rc < 0) {
+			return SPDK_JSON_PARSE_INVALID;
+		}
+
+		stream->pos += rc;
+	}
+}
+
+/* Parse the complete value the stream is positioned at into stream->values */
+static ssize_t
+json_stream_parse_value(struct spdk_json_stream *stream)
+{
+	struct spdk_json_val *values;
+	ssize_t rc;
+	void *end;
+	int fill_rc;
+	uint8_t c;
+
+	/*
+	 * Don't decode in place before it's known that the whole value is in the buffer.  A number
+	 * ending at the end of the buffer might continue in the data that wasn't read yet.
+	 */
+	while (true) {
+		rc = spdk_json_parse(stream->buf + stream->pos, stream->len - stream->pos, NULL, 0, &end,
+				     stream->flags & ~SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE);
+		if (stream->eof) {
+			break;
+		}
+
+		c = stream->buf[stream->pos];
+		if (rc != SPDK_JSON_PARSE_INCOMPLETE &&
+		    !(rc > 0 && (uint8_t *)end == stream->buf + stream->len && (c == '-' || isdigit(c)))) {
+			break;
+		}
+
+		fill_rc = json_stream_fill(stream);
+		if (fill_rc < 0) {
+			return fill_rc;
+		}
+	}
+
+	if (rc < 0) {
+		return rc;
+	}
+
+	if ((size_t)rc > stream->num_values) {
+		values = realloc(stream->values, rc * sizeof(*values));
+		if (values == NULL) {
+			return -ENOMEM;
+		}
+
+		stream->values = values;
+		stream->num_values = rc;
+	}
+
+	rc = spdk_json_parse(stream->buf + stream->pos, stream->len - stream->pos, stream->values,
+			     stream->num_values, &end, stream->flags);
+	assert(rc > 0);
+	stream->pos = (uint8_t *)end - stream->buf;
+
+	stream->state = stream->depth ? STREAM_STATE_VALUE_SEPARATOR : STREAM_STATE_END;
+	stream->trailing_comma = false;
+
+	return rc;
+}
+
+static int
+json_stream_end_container(struct spdk_json_stream *stream, struct spdk_json_val *val)
+{
+	enum spdk_json_val_type type;
+	uint8_t c = stream->buf[stream->pos];
+
+	if (stream->trailing_comma || stream->depth == 0) {
+		return SPDK_JSON_PARSE_INVALID;
+	}
+
+	type = stream->containers[stream->depth - 1];
+	if (c == '}') {
+		if (type != SPDK_JSON_VAL_OBJECT_BEGIN ||
+		    (stream->state != STREAM_STATE_NAME && stream->state != STREAM_STATE_VALUE_SEPARATOR)) {
+			return SPDK_JSON_PARSE_INVALID;
+		}
+		val->type = SPDK_JSON_VAL_OBJECT_END;
+	} else if (c == ']') {
+		if (type != SPDK_JSON_VAL_ARRAY_BEGIN ||
+		    (stream->state != STREAM_STATE_VALUE && stream->state != STREAM_STATE_VALUE_SEPARATOR)) {
+			return SPDK_JSON_PARSE_INVALID;
+		}
+		val->type = SPDK_JSON_VAL_ARRAY_END;
+	} else {
+		return SPDK_JSON_PARSE_INVALID;
+	}
+
+	val->start = stream->buf + stream->pos;
+	val->len = 0;
+	stream->pos++;
+	stream->depth--;
+	stream->state = stream->depth ? STREAM_STATE_VALUE_SEPARATOR : STREAM_STATE_END;
+	stream->trailing_comma = false;
+
+	return 1;
+}
+
+/*
+ * Skip whitespace and the separators preceding the next token.  Returns 1 if the stream is
+ * positioned at a token, 0 at the end of the text.
+ */
+static int
+json_stream_next_token(struct spdk_json_stream *stream)
+{
+	uint8_t c;
+	int rc;
+
+	while (true) {
+		rc = json_stream_skip_ws(stream);
+		if (rc < 0) {
+			return rc;
+		}
+
+		if (stream->pos == stream->len) {
+			return stream->state == STREAM_STATE_END ? 0 : SPDK_JSON_PARSE_INCOMPLETE;
+		}
+
+		c = stream->buf[stream->pos];
+		switch (stream->state) {
+		case STREAM_STATE_VALUE_SEPARATOR:
+			if (c != ',') {
+				return 1;
+			}
+			stream->pos++;
+			stream->state = stream->containers[stream->depth - 1] == SPDK_JSON_VAL_ARRAY_BEGIN ?
+					STREAM_STATE_VALUE : STREAM_STATE_NAME;
+			stream->trailing_comma = true;
+			break;
+		case STREAM_STATE_NAME_SEPARATOR:
+			if (c != ':') {
+				return SPDK_JSON_PARSE_INVALID;
+			}
+			stream->pos++;
+			stream->state = STREAM_STATE_VALUE;
+			break;
+		case STREAM_STATE_END:
+			/* Only whitespace is allowed after the complete value */
+			return SPDK_JSON_PARSE_INVALID;
+		default:
+			return 1;
+		}
+	}
+}
+
+int
+spdk_json_stream_next(struct spdk_json_stream *stream, struct spdk_json_val *val)
+{
+	uint8_t c;
+	ssize_t rc;
+
+	rc = json_stream_next_token(stream);
+	if (rc <= 0) {
+		return rc;
+	}
+
+	c = stream->buf[stream->pos];
+	if (c == '}' || c == ']') {
+		return json_stream_end_container(stream, val);
+	}
+
+	switch (stream->state) {
+	case STREAM_STATE_NAME:
+		if (c != '"') {
+			return SPDK_JSON_PARSE_INVALID;
+		}
+
+		rc = json_stream_parse_value(stream);
+		if (rc < 0) {
+			return rc;
+		}
+
+		*val = stream->values[0];
+		val->type = SPDK_JSON_VAL_NAME;
+		stream->state = STREAM_STATE_NAME_SEPARATOR;
+		return 1;
+	case STREAM_STATE_VALUE:
+		if (c == '{' || c == '[') {
+			if (stream->depth == SPDK_JSON_MAX_NESTING_DEPTH) {
+				return SPDK_JSON_PARSE_MAX_DEPTH_EXCEEDED;
+			}
+
+			val->type = c == '{' ? SPDK_JSON_VAL_OBJECT_BEGIN : SPDK_JSON_VAL_ARRAY_BEGIN;
+			val->start = stream->buf + stream->pos;
+			val->len = 0;
+			stream->containers[stream->depth++] = val->type;
+			stream->state = c == '{' ? STREAM_STATE_NAME : STREAM_STATE_VALUE;
+			stream->trailing_comma = false;
+			stream->pos++;
+			return 1;
+		}
+
+		rc = json_stream_parse_value(stream);
+		if (rc < 0) {
+			return rc;
+		}
+
+		assert(rc == 1);
+		*val = stream->values[0];
+		return 1;
+	default:
+		return SPDK_JSON_PARSE_INVALID;
+	}
+}
+
+ssize_t
+spdk_json_stream_next_value(struct spdk_json_stream *stream, struct spdk_json_val **values)
+{
+	struct spdk_json_val val;
+	ssize_t rc;
+
+	rc = json_stream_next_token(stream);
+	if (rc <= 0) {
+		return rc == 0 ? SPDK_JSON_PARSE_INVALID : rc;
+	}
+
+	if (stream->buf[stream->pos] == ']' && stream->state != STREAM_STATE_NAME) {
+		rc = json_stream_end_container(stream, &val);
+		return rc < 0 ? rc : 0;
+	}
+
+	if (stream->state != STREAM_STATE_VALUE) {
+		return SPDK_JSON_PARSE_INVALID;
+	}
+
+	rc = json_stream_parse_value(stream);
+	if (rc < 0) {
+		return rc;
+	}
+
+	*values = stream->values;
+	return rc;
+}
@@ -42,6 +42,10 @@ struct spdk_jsonrpc_request {
 
 	struct spdk_json_write_ctx *response;
 
+	/* Callback receiving the response to a local request (with no connection) */
+	spdk_jsonrpc_local_response_fn local_cb_fn;
+	void *local_cb_arg;
+
 	STAILQ_ENTRY(spdk_jsonrpc_request) link;
 };
 
@@ -123,6 +127,9 @@ int jsonrpc_parse_request(struct spdk_jsonrpc_server_conn *conn, const void *jso
 /* Must be called only from server poll thread */
 void jsonrpc_free_request(struct spdk_jsonrpc_request *request);
 
+/* Pass the response to the callback of a local request and free it */
+void jsonrpc_complete_local_request(struct spdk_jsonrpc_request *request);
+
 /*
  * Parse JSON data as RPC command response.
  *
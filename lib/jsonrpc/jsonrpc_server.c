@@ -30,6 +30,21 @@ static const struct spdk_json_object_decoder jsonrpc_request_decoders[] = {
 	{"id", offsetof(struct jsonrpc_request, id), capture_val, true},
 };
 
+static const struct spdk_json_object_decoder jsonrpc_local_response_decoders[] = {
+	{"jsonrpc", offsetof(struct spdk_jsonrpc_client_response, version), capture_val},
+	{"id", offsetof(struct spdk_jsonrpc_client_response, id), capture_val},
+	{"result", offsetof(struct spdk_jsonrpc_client_response, result), capture_val, true},
+	{"error", offsetof(struct spdk_jsonrpc_client_response, error), capture_val, true},
+};
+
+/* Local requests always expect a response, so they need an id */
+static char g_local_request_id_str[] = "0";
+static const struct spdk_json_val g_local_request_id = {
+	.start = g_local_request_id_str,
+	.len = sizeof(g_local_request_id_str) - 1,
+	.type = SPDK_JSON_VAL_NUMBER,
+};
+
 static void
 parse_single_request(struct spdk_jsonrpc_request *request, struct spdk_json_val *values)
 {
@@ -214,6 +229,71 @@ jsonrpc_parse_request(struct spdk_jsonrpc_server_conn *conn, const void *json, s
 	return len;
 }
 
+int
+spdk_jsonrpc_handle_local_request(spdk_jsonrpc_handle_request_fn handle_request,
+				  const struct spdk_json_val *method,
+				  const struct spdk_json_val *params,
+				  spdk_jsonrpc_local_response_fn cb_fn, void *cb_arg)
+{
+	struct spdk_jsonrpc_request *request;
+
+	assert(method != NULL && method->type == SPDK_JSON_VAL_STRING);
+
+	request = calloc(1, sizeof(*request));
+	if (request == NULL) {
+		return -ENOMEM;
+	}
+
+	request->id = &g_local_request_id;
+	request->local_cb_fn = cb_fn;
+	request->local_cb_arg = cb_arg;
+
+	request->send_buf_size = SPDK_JSONRPC_SEND_BUF_SIZE_INIT;
+	request->send_buf = malloc(request->send_buf_size);
+	if (request->send_buf == NULL) {
+		free(request);
+		return -ENOMEM;
+	}
+
+	request->response = spdk_json_write_begin(jsonrpc_server_write_cb, request, 0);
+	if (request->response == NULL) {
+		free(request->send_buf);
+		free(request);
+		return -ENOMEM;
+	}
+
+	handle_request(request, method, params);
+
+	return 0;
+}
+
+void
+jsonrpc_complete_local_request(struct spdk_jsonrpc_request *request)
+{
+	struct spdk_jsonrpc_client_response resp = {};
+	ssize_t rc;
+
+	/* The response is parsed from the send buffer, so that it's the same as the one a client
+	 * would receive. */
+	rc = spdk_json_parse(request->send_buf, request->send_len, NULL, 0, NULL, 0);
+	if (rc > 0) {
+		request->values_cnt = rc;
+		request->values = calloc(request->values_cnt, sizeof(request->values[0]));
+	}
+
+	if (request->values == NULL ||
+	    spdk_json_parse(request->send_buf, request->send_len, request->values, request->values_cnt,
+			    NULL, SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE) != rc ||
+	    spdk_json_decode_object(request->values, jsonrpc_local_response_decoders,
+				    SPDK_COUNTOF(jsonrpc_local_response_decoders), &resp)) {
+		SPDK_ERRLOG("Failed to parse the response to a local request\n");
+		memset(&resp, 0, sizeof(resp));
+	}
+
+	request->local_cb_fn(request->local_cb_arg, &resp);
+	jsonrpc_free_request(request);
+}
+
 struct spdk_jsonrpc_server_conn *
 spdk_jsonrpc_get_conn(struct spdk_jsonrpc_request *request)
 {
@@ -269,7 +349,9 @@ jsonrpc_free_request(struct spdk_jsonrpc_request *request)
 	/* We must send or skip response explicitly */
 	assert(request->response == NULL);
 
-	request->conn->outstanding_requests--;
+	if (request->conn != NULL) {
+		request->conn->outstanding_requests--;
+	}
 	free(request->recv_buffer);
 	free(request->values);
 	free(request->send_buf);
@@ -308,6 +308,11 @@ jsonrpc_server_send_response(struct spdk_jsonrpc_request *request)
 {
 	struct spdk_jsonrpc_server_conn *conn = request->conn;
 
+	if (conn == NULL) {
+		jsonrpc_complete_local_request(request);
+		return;
+	}
+
 	/* Queue the response to be sent */
 	pthread_spin_lock(&conn->queue_lock);
 	STAILQ_INSERT_TAIL(&conn->send_queue, request, link);
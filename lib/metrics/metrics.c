@@ -0,0 +1,395 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/env.h"
+#include "spdk/log.h"
+#include "spdk/metrics.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+#define METRICS_WRITER_INITIAL_SIZE	(64 * 1024)
+#define METRICS_REQUEST_MAX_SIZE	4096
+#define METRICS_IO_TIMEOUT_MS		1000
+#define METRICS_CONTENT_TYPE		"application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+struct spdk_metrics_writer {
+	char			*buf;
+	size_t			len;
+	size_t			size;
+	bool			failed;
+	/* Name and type of the current family */
+	char			family[128];
+	enum spdk_metrics_type	type;
+};
+
+static TAILQ_HEAD(, spdk_metrics_source) g_metrics_sources =
+	TAILQ_HEAD_INITIALIZER(g_metrics_sources);
+static pthread_mutex_t g_metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static struct {
+	pthread_t	thread;
+	int		sockfd;
+	/* Written to wake up the server thread when it should stop */
+	int		stop_fd[2];
+	bool		running;
+} g_metrics_server = {
+	.sockfd = -1,
+	.stop_fd = { -1, -1 },
+};
+
+void
+spdk_metrics_source_register(struct spdk_metrics_source *source)
+{
+	pthread_mutex_lock(&g_metrics_mutex);
+	TAILQ_INSERT_TAIL(&g_metrics_sources, source, tailq);
+	pthread_mutex_unlock(&g_metrics_mutex);
+}
+
+static void
+metrics_writer_append(struct spdk_metrics_writer *w, const char *format, ...)
+{
+	va_list args;
+	size_t size;
+	char *buf;
+	int rc;
+
+	if (w->failed) {
+		return;
+	}
+
+	while (true) {
+		va_start(args, format);
+		rc = vsnprintf(w->buf + w->len, w->size - w->len, format, args);
+		va_end(args);
+		if (rc < 0) {
+			w->failed = true;
+			return;
+		}
+
+		if ((size_t)rc < w->size - w->len) {
+			w->len += rc;
+			return;
+		}
+
+		size = spdk_max(w->size * 2, w->len + rc + 1);
+		buf = realloc(w->buf, size);
+		if (buf == NULL) {
+			w->failed = true;
+			return;
+		}
+
+		w->buf = buf;
+		w->size = size;
+	}
+}
+
+void
+spdk_metrics_write_family(struct spdk_metrics_writer *w, const char *name,
+			  enum spdk_metrics_type type, const char *help)
+{
+	snprintf(w->family, sizeof(w->family), "spdk_%s", name);
+	w->type = type;
+
+	metrics_writer_append(w, "# TYPE %s %s\n# HELP %s %s\n", w->family,
+			      type == SPDK_METRICS_COUNTER ? "counter" : "gauge", w->family, help);
+}
+
+void
+spdk_metrics_write_value(struct spdk_metrics_writer *w, const char *label,
+			 const char *label_value, uint64_t value)
+{
+	const char *suffix = w->type == SPDK_METRICS_COUNTER ? "_total" : "";
+	const char *c;
+
+	if (label == NULL) {
+		metrics_writer_append(w, "%s%s %" PRIu64 "\n", w->family, suffix, value);
+		return;
+	}
+
+	metrics_writer_append(w, "%s%s{%s=\"", w->family, suffix, label);
+	for (c = label_value; *c != '\0'; c++) {
+		switch (*c) {
+		case '\\':
+			metrics_writer_append(w, "\\\\");
+			break;
+		case '"':
+			metrics_writer_append(w, "\\\"");
+			break;
+		case '\n':
+			metrics_writer_append(w, "\\n");
+			break;
+		default:
+			metrics_writer_append(w, "%c", *c);
+			break;
+		}
+	}
+	metrics_writer_append(w, "\"} %" PRIu64 "\n", value);
+}
+
+/* Collect the metrics of all sources, the returned buffer needs to be freed by the caller */
+static char *
+metrics_collect(size_t *len)
+{
+	struct spdk_metrics_writer w = {};
+	struct spdk_metrics_source *source;
+
+	w.size = METRICS_WRITER_INITIAL_SIZE;
+	w.buf = malloc(w.size);
+	if (w.buf == NULL) {
+		return NULL;
+	}
+
+	pthread_mutex_lock(&g_metrics_mutex);
+	TAILQ_FOREACH(source, &g_metrics_sources, tailq) {
+		source->collect(&w);
+	}
+	pthread_mutex_unlock(&g_metrics_mutex);
+
+	metrics_writer_append(&w, "# EOF\n");
+	if (w.failed) {
+		free(w.buf);
+		return NULL;
+	}
+
+	*len = w.len;
+	return w.buf;
+}
+
+static int
+metrics_send(int fd, const char *buf, size_t len)
+{
+	ssize_t rc;
+
+	while (len > 0) {
+		rc = send(fd, buf, len, MSG_NOSIGNAL);
+		if (rc < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -errno;
+		}
+
+		buf += rc;
+		len -= rc;
+	}
+
+	return 0;
+}
+
+static void
+metrics_send_response(int fd, const char *status, const char *content_type,
+		      const char *body, size_t len)
+{
+	char header[256];
+	int rc;
+
+	rc = snprintf(header, sizeof(header), "HTTP/1.1 %s\r\nContent-Type: %s\r\n"
+		      "Content-Length: %zu\r\nConnection: close\r\n\r\n", status, content_type, len);
+	assert(rc > 0 && (size_t)rc < sizeof(header));
+
+	if (metrics_send(fd, header, rc) == 0 && len > 0) {
+		metrics_send(fd, body, len);
+	}
+}
+
+static void
+metrics_handle_conn(int fd)
+{
+	char request[METRICS_REQUEST_MAX_SIZE + 1];
+	struct timeval timeout = {
+		.tv_sec = METRICS_IO_TIMEOUT_MS / 1000,
+		.tv_usec = (METRICS_IO_TIMEOUT_MS % 1000) * 1000,
+	};
+	size_t offset = 0, len;
+	ssize_t rc;
+	char *body;
+
+	/* Don't let a stalled client block the server */
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	while (offset < METRICS_REQUEST_MAX_SIZE) {
+		rc = recv(fd, request + offset, METRICS_REQUEST_MAX_SIZE - offset, 0);
+		if (rc <= 0) {
+			return;
+		}
+
+		offset += rc;
+		request[offset] = '\0';
+		if (strstr(request, "\r\n\r\n") != NULL) {
+			break;
+		}
+	}
+
+	request[offset] = '\0';
+	if (strncmp(request, "GET /metrics ", strlen("GET /metrics ")) != 0) {
+		metrics_send_response(fd, "404 Not Found", "text/plain", NULL, 0);
+		return;
+	}
+
+	body = metrics_collect(&len);
+	if (body == NULL) {
+		metrics_send_response(fd, "500 Internal Server Error", "text/plain", NULL, 0);
+		return;
+	}
+
+	metrics_send_response(fd, "200 OK", METRICS_CONTENT_TYPE, body, len);
+	free(body);
+}
+
+static void *
+metrics_server_thread(void *arg)
+{
+	struct pollfd fds[2];
+	int fd, rc;
+
+	spdk_unaffinitize_thread();
+
+	fds[0].fd = g_metrics_server.sockfd;
+	fds[0].events = POLLIN;
+	fds[1].fd = g_metrics_server.stop_fd[0];
+	fds[1].events = POLLIN;
+
+	while (true) {
+		rc = poll(fds, SPDK_COUNTOF(fds), -1);
+		if (rc < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			SPDK_ERRLOG("poll() failed: %s\n", spdk_strerror(errno));
+			break;
+		}
+
+		if (fds[1].revents != 0) {
+			break;
+		}
+
+		if (fds[0].revents & POLLIN) {
+			fd = accept4(g_metrics_server.sockfd, NULL, NULL, SOCK_CLOEXEC);
+			if (fd < 0) {
+				continue;
+			}
+
+			metrics_handle_conn(fd);
+			close(fd);
+		}
+	}
+
+	return NULL;
+}
+
+static void
+metrics_server_close(void)
+{
+	if (g_metrics_server.sockfd >= 0) {
+		close(g_metrics_server.sockfd);
+		g_metrics_server.sockfd = -1;
+	}
+	if (g_metrics_server.stop_fd[0] >= 0) {
+		close(g_metrics_server.stop_fd[0]);
+		close(g_metrics_server.stop_fd[1]);
+		g_metrics_server.stop_fd[0] = g_metrics_server.stop_fd[1] = -1;
+	}
+}
+
+int
+spdk_metrics_server_start(const char *addr, uint16_t port)
+{
+	struct spdk_metrics_source *source;
+	struct addrinfo hints = {}, *res;
+	char portstr[8];
+	int rc, val = 1;
+
+	if (g_metrics_server.running) {
+		return -EEXIST;
+	}
+
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+	snprintf(portstr, sizeof(portstr), "%" PRIu16, port);
+
+	rc = getaddrinfo(addr, portstr, &hints, &res);
+	if (rc != 0) {
+		SPDK_ERRLOG("Invalid metrics server address %s:%s: %s\n", addr, portstr, gai_strerror(rc));
+		return -EINVAL;
+	}
+
+	g_metrics_server.sockfd = socket(res->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (g_metrics_server.sockfd < 0) {
+		rc = -errno;
+		goto err;
+	}
+
+	setsockopt(g_metrics_server.sockfd, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+	if (bind(g_metrics_server.sockfd, res->ai_addr, res->ai_addrlen) != 0 ||
+	    listen(g_metrics_server.sockfd, 16) != 0) {
+		rc = -errno;
+		SPDK_ERRLOG("Could not listen on %s:%s: %s\n", addr, portstr, spdk_strerror(-rc));
+		goto err;
+	}
+
+	if (pipe2(g_metrics_server.stop_fd, O_CLOEXEC) != 0) {
+		rc = -errno;
+		goto err;
+	}
+
+	rc = pthread_create(&g_metrics_server.thread, NULL, metrics_server_thread, NULL);
+	if (rc != 0) {
+		rc = -rc;
+		goto err;
+	}
+
+	freeaddrinfo(res);
+	g_metrics_server.running = true;
+
+	pthread_mutex_lock(&g_metrics_mutex);
+	TAILQ_FOREACH(source, &g_metrics_sources, tailq) {
+		if (source->start != NULL) {
+			source->start();
+		}
+	}
+	pthread_mutex_unlock(&g_metrics_mutex);
+
+	SPDK_NOTICELOG("Serving metrics at http://%s:%s/metrics\n", addr, portstr);
+
+	return 0;
+err:
+	freeaddrinfo(res);
+	metrics_server_close();
+	return rc;
+}
+
+void
+spdk_metrics_server_stop(void)
+{
+	struct spdk_metrics_source *source;
+	char c = 0;
+
+	if (!g_metrics_server.running) {
+		return;
+	}
+
+	if (write(g_metrics_server.stop_fd[1], &c, sizeof(c)) != sizeof(c)) {
+		SPDK_ERRLOG("Failed to stop the metrics server thread\n");
+		return;
+	}
+
+	pthread_join(g_metrics_server.thread, NULL);
+	metrics_server_close();
+	g_metrics_server.running = false;
+
+	pthread_mutex_lock(&g_metrics_mutex);
+	TAILQ_FOREACH(source, &g_metrics_sources, tailq) {
+		if (source->stop != NULL) {
+			source->stop();
+		}
+	}
+	pthread_mutex_unlock(&g_metrics_mutex);
+}
+
+SPDK_LOG_REGISTER_COMPONENT(metrics)
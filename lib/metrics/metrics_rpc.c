@@ -0,0 +1,64 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/rpc.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+#include "spdk/metrics.h"
+#include "spdk/log.h"
+
+struct rpc_metrics_server_start {
+	char *address;
+	uint16_t port;
+};
+
+static const struct spdk_json_object_decoder rpc_metrics_server_start_decoders[] = {
+	{"address", offsetof(struct rpc_metrics_server_start, address), spdk_json_decode_string, true},
+	{"port", offsetof(struct rpc_metrics_server_start, port), spdk_json_decode_uint16},
+};
+
+static void
+rpc_metrics_server_start(struct spdk_jsonrpc_request *request,
+			 const struct spdk_json_val *params)
+{
+	struct rpc_metrics_server_start req = {};
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_metrics_server_start_decoders,
+				    SPDK_COUNTOF(rpc_metrics_server_start_decoders), &req)) {
+		SPDK_DEBUGLOG(metrics, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		goto cleanup;
+	}
+
+	rc = spdk_metrics_server_start(req.address ? req.address : "127.0.0.1", req.port);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+cleanup:
+	free(req.address);
+}
+SPDK_RPC_REGISTER("metrics_server_start", rpc_metrics_server_start,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
+static void
+rpc_metrics_server_stop(struct spdk_jsonrpc_request *request,
+			const struct spdk_json_val *params)
+{
+	if (params != NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "metrics_server_stop requires no parameters");
+		return;
+	}
+
+	spdk_metrics_server_stop();
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("metrics_server_stop", rpc_metrics_server_stop,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
@@ -0,0 +1,170 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/env.h"
+#include "spdk/log.h"
+#include "spdk/metrics.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#define METRICS_THREAD_UPDATE_PERIOD	1000000
+
+struct metrics_thread_stats {
+	char		*name;
+	uint64_t	busy_tsc;
+	uint64_t	idle_tsc;
+};
+
+struct metrics_thread_snapshot {
+	struct metrics_thread_stats	*stats;
+	size_t				count;
+	size_t				size;
+};
+
+/*
+ * Stats of all the threads, gathered periodically by the thread that started the metrics server
+ * and read by the metrics server thread.
+ */
+static struct metrics_thread_snapshot *g_metrics_thread_snapshot;
+static pthread_mutex_t g_metrics_thread_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct spdk_poller *g_metrics_thread_poller;
+static bool g_metrics_thread_update_pending;
+
+static void
+metrics_thread_snapshot_free(struct metrics_thread_snapshot *snapshot)
+{
+	size_t i;
+
+	if (snapshot == NULL) {
+		return;
+	}
+
+	for (i = 0; i < snapshot->count; i++) {
+		free(snapshot->stats[i].name);
+	}
+	free(snapshot->stats);
+	free(snapshot);
+}
+
+static void
+metrics_thread_get_stats(void *ctx)
+{
+	struct metrics_thread_snapshot *snapshot = ctx;
+	struct metrics_thread_stats *stats;
+	struct spdk_thread_stats thread_stats;
+	size_t size;
+
+	if (spdk_thread_get_stats(&thread_stats) != 0) {
+		return;
+	}
+
+	if (snapshot->count == snapshot->size) {
+		size = spdk_max(snapshot->size * 2, 16);
+		stats = realloc(snapshot->stats, size * sizeof(*stats));
+		if (stats == NULL) {
+			return;
+		}
+
+		snapshot->stats = stats;
+		snapshot->size = size;
+	}
+
+	stats = &snapshot->stats[snapshot->count];
+	stats->name = strdup(spdk_thread_get_name(spdk_get_thread()));
+	if (stats->name == NULL) {
+		return;
+	}
+
+	stats->busy_tsc = thread_stats.busy_tsc;
+	stats->idle_tsc = thread_stats.idle_tsc;
+	snapshot->count++;
+}
+
+static void
+metrics_thread_update_done(void *ctx)
+{
+	struct metrics_thread_snapshot *snapshot = ctx, *old;
+
+	pthread_mutex_lock(&g_metrics_thread_mutex);
+	old = g_metrics_thread_snapshot;
+	g_metrics_thread_snapshot = snapshot;
+	pthread_mutex_unlock(&g_metrics_thread_mutex);
+
+	metrics_thread_snapshot_free(old);
+	g_metrics_thread_update_pending = false;
+}
+
+static int
+metrics_thread_update(void *ctx)
+{
+	struct metrics_thread_snapshot *snapshot;
+
+	if (g_metrics_thread_update_pending) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	/* Don't keep the thread from exiting if the server wasn't stopped */
+	if (!spdk_thread_is_running(spdk_get_thread())) {
+		spdk_poller_unregister(&g_metrics_thread_poller);
+		return SPDK_POLLER_IDLE;
+	}
+
+	snapshot = calloc(1, sizeof(*snapshot));
+	if (snapshot == NULL) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	g_metrics_thread_update_pending = true;
+	spdk_for_each_thread(metrics_thread_get_stats, snapshot, metrics_thread_update_done);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+metrics_thread_start(void)
+{
+	assert(g_metrics_thread_poller == NULL);
+	g_metrics_thread_poller = SPDK_POLLER_REGISTER(metrics_thread_update, NULL,
+				  METRICS_THREAD_UPDATE_PERIOD);
+}
+
+static void
+metrics_thread_stop(void)
+{
+	spdk_poller_unregister(&g_metrics_thread_poller);
+}
+
+static void
+metrics_thread_write(struct spdk_metrics_writer *w, const char *name, const char *help,
+		     size_t offset)
+{
+	struct metrics_thread_snapshot *snapshot = g_metrics_thread_snapshot;
+	size_t i;
+
+	spdk_metrics_write_family(w, name, SPDK_METRICS_COUNTER, help);
+	for (i = 0; snapshot != NULL && i < snapshot->count; i++) {
+		spdk_metrics_write_value(w, "thread", snapshot->stats[i].name,
+					 *(uint64_t *)((char *)&snapshot->stats[i] + offset));
+	}
+}
+
+static void
+metrics_thread_collect(struct spdk_metrics_writer *w)
+{
+	pthread_mutex_lock(&g_metrics_thread_mutex);
+	metrics_thread_write(w, "thread_busy_ticks", "Ticks spent doing work",
+			     offsetof(struct metrics_thread_stats, busy_tsc));
+	metrics_thread_write(w, "thread_idle_ticks", "Ticks spent idle",
+			     offsetof(struct metrics_thread_stats, idle_tsc));
+	pthread_mutex_unlock(&g_metrics_thread_mutex);
+
+	spdk_metrics_write_family(w, "ticks_per_second", SPDK_METRICS_GAUGE,
+				  "Number of ticks per second");
+	spdk_metrics_write_value(w, NULL, NULL, spdk_get_ticks_hz());
+}
+SPDK_METRICS_SOURCE_REGISTER_EXT("thread", metrics_thread_collect, metrics_thread_start,
+				 metrics_thread_stop)
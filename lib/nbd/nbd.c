@@ -25,6 +25,8 @@
 #define NBD_STOP_BUSY_WAITING_MS	10000
 #define NBD_BUSY_POLLING_INTERVAL_US	20000
 #define NBD_IO_TIMEOUT_S		60
+#define NBD_XMIT_IOV_MAX		64
+#define NBD_MAX_CONNECTIONS		64
 
 enum nbd_io_state_t {
 	/* Receiving or ready to receive nbd request header */
@@ -38,7 +40,7 @@ enum nbd_io_state_t {
 };
 
 struct nbd_io {
-	struct spdk_nbd_disk	*nbd;
+	struct nbd_conn		*conn;
 	enum nbd_io_state_t	state;
 
 	void			*payload;
@@ -59,33 +61,55 @@ struct nbd_io {
 	TAILQ_ENTRY(nbd_io)	tailq;
 };
 
-struct spdk_nbd_disk {
-	struct spdk_bdev	*bdev;
-	struct spdk_bdev_desc	*bdev_desc;
+/*
+ * One socket of an nbd device. Each connection is polled by its own spdk_thread,
+ * the kernel spreads the requests over them by its hardware queues.
+ */
+struct nbd_conn {
+	struct spdk_nbd_disk	*nbd;
+	uint32_t		id;
+	/* Only cleared by the nbd thread, once the connection reported it's stopped */
+	struct spdk_thread	*thread;
 	struct spdk_io_channel	*ch;
-	int			dev_fd;
-	char			*nbd_path;
 	int			kernel_sp_fd;
 	int			spdk_sp_fd;
 	struct spdk_poller	*nbd_poller;
 	struct spdk_interrupt	*intr;
 	bool			interrupt_mode;
+
+	struct nbd_io		*io_in_recv;
+	TAILQ_HEAD(, nbd_io)	received_io_list;
+	TAILQ_HEAD(, nbd_io)	executed_io_list;
+	TAILQ_HEAD(, nbd_io)	processing_io_list;
+
+	bool			is_closing;
+	bool			is_stopped;
+	/* count of nbd_io in nbd_conn */
+	int			io_count;
+};
+
+struct spdk_nbd_disk {
+	struct spdk_bdev	*bdev;
+	struct spdk_bdev_desc	*bdev_desc;
+	/* Thread that started the nbd, and polls its first connection */
+	struct spdk_thread	*thread;
+	int			dev_fd;
+	char			*nbd_path;
 	uint32_t		buf_align;
 
+	struct nbd_conn		*conns;
+	uint32_t		num_conns;
+	/* Connections whose socket has been given to the kernel */
+	uint32_t		num_socks_set;
+	uint32_t		num_conns_stopped;
+
 	struct spdk_poller	*retry_poller;
 	int			retry_count;
 	/* Synchronize nbd_start_kernel pthread and nbd_stop */
 	bool			has_nbd_pthread;
 
-	struct nbd_io		*io_in_recv;
-	TAILQ_HEAD(, nbd_io)	received_io_list;
-	TAILQ_HEAD(, nbd_io)	executed_io_list;
-	TAILQ_HEAD(, nbd_io)	processing_io_list;
-
 	bool			is_started;
 	bool			is_closing;
-	/* count of nbd_io in spdk_nbd_disk */
-	int			io_count;
 
 	TAILQ_ENTRY(spdk_nbd_disk)	tailq;
 };
@@ -100,8 +124,9 @@ static void *g_fini_cb_arg;
 
 static void _nbd_fini(void *arg1);
 
-static int nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io);
-static int nbd_io_recv_internal(struct spdk_nbd_disk *nbd);
+static int nbd_submit_bdev_io(struct nbd_conn *conn, struct nbd_io *io);
+static int nbd_io_recv_internal(struct nbd_conn *conn);
+static int _nbd_stop(void *arg);
 
 int
 spdk_nbd_init(void)
@@ -210,6 +235,12 @@ nbd_disk_get_bdev_name(struct spdk_nbd_disk *nbd)
 	return spdk_bdev_get_name(nbd->bdev);
 }
 
+uint32_t
+nbd_disk_get_num_connections(struct spdk_nbd_disk *nbd)
+{
+	return nbd->num_conns;
+}
+
 void
 spdk_nbd_write_config_json(struct spdk_json_write_ctx *w)
 {
@@ -225,6 +256,9 @@ spdk_nbd_write_config_json(struct spdk_json_write_ctx *w)
 		spdk_json_write_named_object_begin(w, "params");
 		spdk_json_write_named_string(w, "nbd_device",  nbd_disk_get_nbd_path(nbd));
 		spdk_json_write_named_string(w, "bdev_name", nbd_disk_get_bdev_name(nbd));
+		if (nbd->num_conns > 1) {
+			spdk_json_write_named_uint32(w, "num_connections", nbd->num_conns);
+		}
 		spdk_json_write_object_end(w);
 
 		spdk_json_write_object_end(w);
@@ -245,7 +279,7 @@ nbd_disconnect(struct spdk_nbd_disk *nbd)
 }
 
 static struct nbd_io *
-nbd_get_io(struct spdk_nbd_disk *nbd)
+nbd_get_io(struct nbd_conn *conn)
 {
 	struct nbd_io *io;
 
@@ -254,23 +288,23 @@ nbd_get_io(struct spdk_nbd_disk *nbd)
 		return NULL;
 	}
 
-	io->nbd = nbd;
+	io->conn = conn;
 	to_be32(&io->resp.magic, NBD_REPLY_MAGIC);
 
-	nbd->io_count++;
+	conn->io_count++;
 
 	return io;
 }
 
 static void
-nbd_put_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
+nbd_put_io(struct nbd_conn *conn, struct nbd_io *io)
 {
 	if (io->payload) {
 		spdk_free(io->payload);
 	}
 	free(io);
 
-	nbd->io_count--;
+	conn->io_count--;
 }
 
 /*
@@ -281,49 +315,167 @@ nbd_put_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
  *         0 all nbd_io gotten are freed.
  */
 static int
-nbd_cleanup_io(struct spdk_nbd_disk *nbd)
+nbd_cleanup_io(struct nbd_conn *conn)
 {
 	/* Try to read the remaining nbd commands in the socket */
-	while (nbd_io_recv_internal(nbd) > 0);
+	while (nbd_io_recv_internal(conn) > 0);
 
 	/* free io_in_recv */
-	if (nbd->io_in_recv != NULL) {
-		nbd_put_io(nbd, nbd->io_in_recv);
-		nbd->io_in_recv = NULL;
+	if (conn->io_in_recv != NULL) {
+		nbd_put_io(conn, conn->io_in_recv);
+		conn->io_in_recv = NULL;
 	}
 
 	/*
 	 * Some nbd_io may be under executing in bdev.
 	 * Wait for their done operation.
 	 */
-	if (nbd->io_count != 0) {
+	if (conn->io_count != 0) {
 		return 1;
 	}
 
 	return 0;
 }
 
-static int
-_nbd_stop(void *arg)
+static void
+nbd_conn_thread_exit(void *arg)
 {
-	struct spdk_nbd_disk *nbd = arg;
+	spdk_thread_exit(spdk_get_thread());
+}
 
-	if (nbd->nbd_poller) {
-		spdk_poller_unregister(&nbd->nbd_poller);
+static void
+nbd_conn_released(void *arg)
+{
+	struct nbd_conn *conn = arg;
+	struct spdk_nbd_disk *nbd = conn->nbd;
+
+	assert(spdk_get_thread() == nbd->thread);
+
+	nbd->num_conns_stopped++;
+	if (nbd->num_conns_stopped == nbd->num_conns) {
+		_nbd_stop(nbd);
 	}
+}
 
-	if (nbd->intr) {
-		spdk_interrupt_unregister(&nbd->intr);
+static void
+nbd_conn_release(void *arg)
+{
+	struct nbd_conn *conn = arg;
+	struct spdk_nbd_disk *nbd = conn->nbd;
+
+	/*
+	 * Messages are processed in order, so all the messages the nbd thread sent to
+	 * this connection before it was released are done and the nbd can be freed.
+	 */
+	spdk_thread_send_msg(nbd->thread, nbd_conn_released, conn);
+	if (spdk_get_thread() != nbd->thread) {
+		spdk_thread_exit(spdk_get_thread());
 	}
+}
+
+static void
+nbd_conn_stopped(void *arg)
+{
+	struct nbd_conn *conn = arg;
+	struct spdk_nbd_disk *nbd = conn->nbd;
+
+	assert(spdk_get_thread() == nbd->thread);
 
-	if (nbd->spdk_sp_fd >= 0) {
-		close(nbd->spdk_sp_fd);
-		nbd->spdk_sp_fd = -1;
+	/* No more messages are sent to the connection thread after this one */
+	spdk_thread_send_msg(conn->thread, nbd_conn_release, conn);
+	conn->thread = NULL;
+
+	/* A closed connection takes down the whole device */
+	if (!nbd->is_closing) {
+		spdk_nbd_stop(nbd);
+	}
+}
+
+static void
+nbd_conn_stop(struct nbd_conn *conn)
+{
+	if (conn->is_stopped) {
+		return;
 	}
+	conn->is_stopped = true;
 
-	if (nbd->kernel_sp_fd >= 0) {
-		close(nbd->kernel_sp_fd);
-		nbd->kernel_sp_fd = -1;
+	if (conn->nbd_poller) {
+		spdk_poller_unregister(&conn->nbd_poller);
+	}
+
+	if (conn->intr) {
+		spdk_interrupt_unregister(&conn->intr);
+	}
+
+	if (conn->spdk_sp_fd >= 0) {
+		close(conn->spdk_sp_fd);
+		conn->spdk_sp_fd = -1;
+	}
+
+	if (conn->ch) {
+		spdk_put_io_channel(conn->ch);
+		conn->ch = NULL;
+	}
+
+	spdk_thread_send_msg(conn->nbd->thread, nbd_conn_stopped, conn);
+}
+
+/*
+ * Stop the connection once all its nbd_io are executed.
+ *
+ * \return 0 if the connection is stopped, 1 otherwise.
+ */
+static int
+nbd_conn_try_stop(struct nbd_conn *conn)
+{
+	int rc;
+
+	conn->is_closing = true;
+
+	rc = nbd_cleanup_io(conn);
+	if (!rc) {
+		nbd_conn_stop(conn);
+	}
+
+	return rc;
+}
+
+static void
+nbd_conn_close(void *arg)
+{
+	struct nbd_conn *conn = arg;
+
+	if (!conn->is_stopped) {
+		nbd_conn_try_stop(conn);
+	}
+}
+
+static int
+_nbd_stop(void *arg)
+{
+	struct spdk_nbd_disk *nbd = arg;
+	struct nbd_conn *conn;
+	uint32_t i;
+
+	for (i = 0; i < nbd->num_conns; i++) {
+		conn = &nbd->conns[i];
+
+		/* The connections are only polled once the nbd is started */
+		assert(conn->nbd_poller == NULL && conn->ch == NULL);
+		if (conn->thread != NULL && conn->thread != nbd->thread) {
+			spdk_thread_send_msg(conn->thread, nbd_conn_thread_exit, NULL);
+			conn->thread = NULL;
+		}
+
+		if (conn->spdk_sp_fd >= 0) {
+			close(conn->spdk_sp_fd);
+			conn->spdk_sp_fd = -1;
+		}
+
+		if (conn->kernel_sp_fd >= 0) {
+			close(conn->kernel_sp_fd);
+			conn->kernel_sp_fd = -1;
+		}
 	}
 
 	/* Continue the stop procedure after the exit of nbd_start_kernel pthread */
@@ -359,11 +511,6 @@ _nbd_stop(void *arg)
 		free(nbd->nbd_path);
 	}
 
-	if (nbd->ch) {
-		spdk_put_io_channel(nbd->ch);
-		nbd->ch = NULL;
-	}
-
 	if (nbd->bdev_desc) {
 		spdk_bdev_close(nbd->bdev_desc);
 		nbd->bdev_desc = NULL;
@@ -371,6 +518,7 @@ _nbd_stop(void *arg)
 
 	nbd_disk_unregister(nbd);
 
+	free(nbd->conns);
 	free(nbd);
 
 	return 0;
@@ -379,10 +527,11 @@ _nbd_stop(void *arg)
 int
 spdk_nbd_stop(struct spdk_nbd_disk *nbd)
 {
-	int rc = 0;
+	struct nbd_conn *conn;
+	uint32_t i;
 
 	if (nbd == NULL) {
-		return rc;
+		return 0;
 	}
 
 	nbd->is_closing = true;
@@ -394,14 +543,23 @@ spdk_nbd_stop(struct spdk_nbd_disk *nbd)
 
 	/*
 	 * Stop action should be called only after all nbd_io are executed.
+	 * Each connection is stopped by its own thread, the last one to
+	 * report back finishes stopping the nbd.
 	 */
+	for (i = 0; i < nbd->num_conns; i++) {
+		conn = &nbd->conns[i];
+		if (conn->thread == NULL) {
+			continue;
+		}
 
-	rc = nbd_cleanup_io(nbd);
-	if (!rc) {
-		_nbd_stop(nbd);
+		if (conn->thread == spdk_get_thread()) {
+			nbd_conn_close(conn);
+		} else {
+			spdk_thread_send_msg(conn->thread, nbd_conn_close, conn);
+		}
 	}
 
-	return rc;
+	return 1;
 }
 
 static int64_t
@@ -431,7 +589,7 @@ static void
 nbd_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
 	struct nbd_io	*io = cb_arg;
-	struct spdk_nbd_disk *nbd = io->nbd;
+	struct nbd_conn *conn = io->conn;
 
 	if (success) {
 		io->resp.error = 0;
@@ -444,12 +602,12 @@ nbd_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 	/* When there begins to have executed_io, enable socket writable notice in order to
 	 * get it processed in nbd_io_xmit
 	 */
-	if (nbd->interrupt_mode && TAILQ_EMPTY(&nbd->executed_io_list)) {
-		spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
+	if (conn->interrupt_mode && TAILQ_EMPTY(&conn->executed_io_list)) {
+		spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
 	}
 
-	TAILQ_REMOVE(&nbd->processing_io_list, io, tailq);
-	TAILQ_INSERT_TAIL(&nbd->executed_io_list, io, tailq);
+	TAILQ_REMOVE(&conn->processing_io_list, io, tailq);
+	TAILQ_INSERT_TAIL(&conn->executed_io_list, io, tailq);
 
 	if (bdev_io != NULL) {
 		spdk_bdev_free_io(bdev_io);
@@ -460,13 +618,13 @@ static void
 nbd_resubmit_io(void *arg)
 {
 	struct nbd_io *io = (struct nbd_io *)arg;
-	struct spdk_nbd_disk *nbd = io->nbd;
+	struct nbd_conn *conn = io->conn;
 	int rc = 0;
 
-	rc = nbd_submit_bdev_io(nbd, io);
+	rc = nbd_submit_bdev_io(conn, io);
 	if (rc) {
 		SPDK_INFOLOG(nbd, "nbd: io resubmit for dev %s , io_type %d, returned %d.\n",
-			     nbd_disk_get_bdev_name(nbd), from_be32(&io->req.type), rc);
+			     nbd_disk_get_bdev_name(conn->nbd), from_be32(&io->req.type), rc);
 	}
 }
 
@@ -474,13 +632,13 @@ static void
 nbd_queue_io(struct nbd_io *io)
 {
 	int rc;
-	struct spdk_bdev *bdev = io->nbd->bdev;
+	struct spdk_bdev *bdev = io->conn->nbd->bdev;
 
 	io->bdev_io_wait.bdev = bdev;
 	io->bdev_io_wait.cb_fn = nbd_resubmit_io;
 	io->bdev_io_wait.cb_arg = io;
 
-	rc = spdk_bdev_queue_io_wait(bdev, io->nbd->ch, &io->bdev_io_wait);
+	rc = spdk_bdev_queue_io_wait(bdev, io->conn->ch, &io->bdev_io_wait);
 	if (rc != 0) {
 		SPDK_ERRLOG("Queue io failed in nbd_queue_io, rc=%d.\n", rc);
 		nbd_io_done(NULL, false, io);
@@ -488,10 +646,11 @@ nbd_queue_io(struct nbd_io *io)
 }
 
 static int
-nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
+nbd_submit_bdev_io(struct nbd_conn *conn, struct nbd_io *io)
 {
+	struct spdk_nbd_disk *nbd = conn->nbd;
 	struct spdk_bdev_desc *desc = nbd->bdev_desc;
-	struct spdk_io_channel *ch = nbd->ch;
+	struct spdk_io_channel *ch = conn->ch;
 	int rc = 0;
 
 	switch (from_be32(&io->req.type)) {
@@ -534,17 +693,17 @@ nbd_submit_bdev_io(struct spdk_nbd_disk *nbd, struct nbd_io *io)
 }
 
 static int
-nbd_io_exec(struct spdk_nbd_disk *nbd)
+nbd_io_exec(struct nbd_conn *conn)
 {
 	struct nbd_io *io, *io_tmp;
 	int io_count = 0;
 	int ret = 0;
 
-	if (!TAILQ_EMPTY(&nbd->received_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->received_io_list, tailq, io_tmp) {
-			TAILQ_REMOVE(&nbd->received_io_list, io, tailq);
-			TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
-			ret = nbd_submit_bdev_io(nbd, io);
+	if (!TAILQ_EMPTY(&conn->received_io_list)) {
+		TAILQ_FOREACH_SAFE(io, &conn->received_io_list, tailq, io_tmp) {
+			TAILQ_REMOVE(&conn->received_io_list, io, tailq);
+			TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
+			ret = nbd_submit_bdev_io(conn, io);
 			if (ret < 0) {
 				return ret;
 			}
@@ -557,27 +716,27 @@ nbd_io_exec(struct spdk_nbd_disk *nbd)
 }
 
 static int
-nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
+nbd_io_recv_internal(struct nbd_conn *conn)
 {
 	struct nbd_io *io;
 	int ret = 0;
 	int received = 0;
 
-	if (nbd->io_in_recv == NULL) {
-		nbd->io_in_recv = nbd_get_io(nbd);
-		if (!nbd->io_in_recv) {
+	if (conn->io_in_recv == NULL) {
+		conn->io_in_recv = nbd_get_io(conn);
+		if (!conn->io_in_recv) {
 			return -ENOMEM;
 		}
 	}
 
-	io = nbd->io_in_recv;
+	io = conn->io_in_recv;
 
 	if (io->state == NBD_IO_RECV_REQ) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, (char *)&io->req + io->offset,
+		ret = nbd_socket_rw(conn->spdk_sp_fd, (char *)&io->req + io->offset,
 				    sizeof(io->req) - io->offset, true);
 		if (ret < 0) {
-			nbd_put_io(nbd, io);
-			nbd->io_in_recv = NULL;
+			nbd_put_io(conn, io);
+			conn->io_in_recv = NULL;
 			return ret;
 		}
 
@@ -591,18 +750,18 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 			/* req magic check */
 			if (from_be32(&io->req.magic) != NBD_REQUEST_MAGIC) {
 				SPDK_ERRLOG("invalid request magic\n");
-				nbd_put_io(nbd, io);
-				nbd->io_in_recv = NULL;
+				nbd_put_io(conn, io);
+				conn->io_in_recv = NULL;
 				return -EINVAL;
 			}
 
 			if (from_be32(&io->req.type) == NBD_CMD_DISC) {
-				nbd->is_closing = true;
-				nbd->io_in_recv = NULL;
-				if (nbd->interrupt_mode && TAILQ_EMPTY(&nbd->executed_io_list)) {
-					spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
+				conn->is_closing = true;
+				conn->io_in_recv = NULL;
+				if (conn->interrupt_mode && TAILQ_EMPTY(&conn->executed_io_list)) {
+					spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN | SPDK_INTERRUPT_EVENT_OUT);
 				}
-				nbd_put_io(nbd, io);
+				nbd_put_io(conn, io);
 				/* After receiving NBD_CMD_DISC, nbd will not receive any new commands */
 				return received;
 			}
@@ -617,12 +776,12 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 
 			/* io payload allocate */
 			if (io->payload_size) {
-				io->payload = spdk_malloc(io->payload_size, nbd->buf_align, NULL,
+				io->payload = spdk_malloc(io->payload_size, conn->nbd->buf_align, NULL,
 							  SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
 				if (io->payload == NULL) {
 					SPDK_ERRLOG("could not allocate io->payload of size %d\n", io->payload_size);
-					nbd_put_io(nbd, io);
-					nbd->io_in_recv = NULL;
+					nbd_put_io(conn, io);
+					conn->io_in_recv = NULL;
 					return -ENOMEM;
 				}
 			} else {
@@ -634,22 +793,22 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 				io->state = NBD_IO_RECV_PAYLOAD;
 			} else {
 				io->state = NBD_IO_XMIT_RESP;
-				if (spdk_likely((!nbd->is_closing) && nbd->is_started)) {
-					TAILQ_INSERT_TAIL(&nbd->received_io_list, io, tailq);
+				if (spdk_likely(!conn->is_closing)) {
+					TAILQ_INSERT_TAIL(&conn->received_io_list, io, tailq);
 				} else {
-					TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
+					TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
 					nbd_io_done(NULL, false, io);
 				}
-				nbd->io_in_recv = NULL;
+				conn->io_in_recv = NULL;
 			}
 		}
 	}
 
 	if (io->state == NBD_IO_RECV_PAYLOAD) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset, true);
+		ret = nbd_socket_rw(conn->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset, true);
 		if (ret < 0) {
-			nbd_put_io(nbd, io);
-			nbd->io_in_recv = NULL;
+			nbd_put_io(conn, io);
+			conn->io_in_recv = NULL;
 			return ret;
 		}
 
@@ -660,13 +819,13 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 		if (io->offset == io->payload_size) {
 			io->offset = 0;
 			io->state = NBD_IO_XMIT_RESP;
-			if (spdk_likely((!nbd->is_closing) && nbd->is_started)) {
-				TAILQ_INSERT_TAIL(&nbd->received_io_list, io, tailq);
+			if (spdk_likely(!conn->is_closing)) {
+				TAILQ_INSERT_TAIL(&conn->received_io_list, io, tailq);
 			} else {
-				TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
+				TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
 				nbd_io_done(NULL, false, io);
 			}
-			nbd->io_in_recv = NULL;
+			conn->io_in_recv = NULL;
 		}
 
 	}
@@ -675,24 +834,24 @@ nbd_io_recv_internal(struct spdk_nbd_disk *nbd)
 }
 
 static int
-nbd_io_recv(struct spdk_nbd_disk *nbd)
+nbd_io_recv(struct nbd_conn *conn)
 {
 	int i, rc, ret = 0;
 
 	/*
 	 * nbd server should not accept request after closing command
 	 */
-	if (nbd->is_closing) {
+	if (conn->is_closing) {
 		return 0;
 	}
 
 	for (i = 0; i < GET_IO_LOOP_COUNT; i++) {
-		rc = nbd_io_recv_internal(nbd);
+		rc = nbd_io_recv_internal(conn);
 		if (rc < 0) {
 			return rc;
 		}
 		ret += rc;
-		if (nbd->is_closing) {
+		if (conn->is_closing) {
 			break;
 		}
 	}
@@ -700,117 +859,163 @@ nbd_io_recv(struct spdk_nbd_disk *nbd)
 	return ret;
 }
 
+static inline bool
+nbd_io_has_xmit_payload(struct nbd_io *io)
+{
+	/* transmit payload only when NBD_CMD_READ with no resp error */
+	return from_be32(&io->req.type) == NBD_CMD_READ && io->resp.error == 0 && io->payload_size != 0;
+}
+
+/* Describe the part of the response of io that is left to transmit */
 static int
-nbd_io_xmit_internal(struct spdk_nbd_disk *nbd)
+nbd_io_xmit_iovs(struct nbd_io *io, struct iovec *iovs)
 {
-	struct nbd_io *io;
-	int ret = 0;
-	int sent = 0;
+	int iovcnt = 0;
 
-	io = TAILQ_FIRST(&nbd->executed_io_list);
-	if (io == NULL) {
-		return 0;
+	if (io->state == NBD_IO_XMIT_RESP) {
+		iovs[iovcnt].iov_base = (char *)&io->resp + io->offset;
+		iovs[iovcnt].iov_len = sizeof(io->resp) - io->offset;
+		iovcnt++;
+		if (nbd_io_has_xmit_payload(io)) {
+			iovs[iovcnt].iov_base = io->payload;
+			iovs[iovcnt].iov_len = io->payload_size;
+			iovcnt++;
+		}
+	} else {
+		assert(io->state == NBD_IO_XMIT_PAYLOAD);
+		iovs[iovcnt].iov_base = io->payload + io->offset;
+		iovs[iovcnt].iov_len = io->payload_size - io->offset;
+		iovcnt++;
 	}
 
-	/* Remove IO from list now assuming it will be completed.  It will be inserted
-	 *  back to the head if it cannot be completed.  This approach is specifically
-	 *  taken to work around a scan-build use-after-free mischaracterization.
-	 */
-	TAILQ_REMOVE(&nbd->executed_io_list, io, tailq);
+	return iovcnt;
+}
 
-	/* resp error and handler are already set in io_done */
+/*
+ * Account len transmitted bytes to io.
+ *
+ * \return the number of bytes consumed by io, *done is set when it is fully transmitted.
+ */
+static size_t
+nbd_io_xmit_advance(struct nbd_io *io, size_t len, bool *done)
+{
+	size_t consumed = 0, remaining;
 
+	*done = false;
 	if (io->state == NBD_IO_XMIT_RESP) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, (char *)&io->resp + io->offset,
-				    sizeof(io->resp) - io->offset, false);
-		if (ret <= 0) {
-			goto reinsert;
+		remaining = sizeof(io->resp) - io->offset;
+		if (len < remaining) {
+			io->offset += len;
+			return len;
 		}
 
-		io->offset += ret;
-		sent = ret;
-
 		/* response is fully transmitted */
-		if (io->offset == sizeof(io->resp)) {
-			io->offset = 0;
-
-			/* transmit payload only when NBD_CMD_READ with no resp error */
-			if (from_be32(&io->req.type) != NBD_CMD_READ || io->resp.error != 0) {
-				nbd_put_io(nbd, io);
-				return 0;
-			} else {
-				io->state = NBD_IO_XMIT_PAYLOAD;
-			}
+		io->offset = 0;
+		consumed = remaining;
+		len -= remaining;
+		if (!nbd_io_has_xmit_payload(io)) {
+			*done = true;
+			return consumed;
 		}
+		io->state = NBD_IO_XMIT_PAYLOAD;
 	}
 
-	if (io->state == NBD_IO_XMIT_PAYLOAD) {
-		ret = nbd_socket_rw(nbd->spdk_sp_fd, io->payload + io->offset, io->payload_size - io->offset,
-				    false);
-		if (ret <= 0) {
-			goto reinsert;
-		}
-
-		io->offset += ret;
-		sent += ret;
-
-		/* read payload is fully transmitted */
-		if (io->offset == io->payload_size) {
-			nbd_put_io(nbd, io);
-			return sent;
-		}
+	remaining = io->payload_size - io->offset;
+	if (len < remaining) {
+		io->offset += len;
+		return consumed + len;
 	}
 
-reinsert:
-	TAILQ_INSERT_HEAD(&nbd->executed_io_list, io, tailq);
-	return ret < 0 ? ret : sent;
+	/* read payload is fully transmitted */
+	*done = true;
+	return consumed + remaining;
 }
 
+/*
+ * Transmit the responses of the executed nbd_io, gathering as many of them
+ * as fit in NBD_XMIT_IOV_MAX iovecs into each writev().
+ */
 static int
-nbd_io_xmit(struct spdk_nbd_disk *nbd)
+nbd_io_xmit(struct nbd_conn *conn)
 {
-	int ret = 0;
-	int rc;
+	struct iovec iovs[NBD_XMIT_IOV_MAX];
+	struct nbd_io *io, *io_tmp;
+	size_t len, total;
+	ssize_t rc;
+	int iovcnt, i, sent = 0;
+	bool done;
+
+	while (!TAILQ_EMPTY(&conn->executed_io_list)) {
+		iovcnt = 0;
+		TAILQ_FOREACH(io, &conn->executed_io_list, tailq) {
+			if (iovcnt + 2 > NBD_XMIT_IOV_MAX) {
+				break;
+			}
+			iovcnt += nbd_io_xmit_iovs(io, &iovs[iovcnt]);
+		}
 
-	while (!TAILQ_EMPTY(&nbd->executed_io_list)) {
-		rc = nbd_io_xmit_internal(nbd);
-		if (rc < 0) {
-			return rc;
+		rc = writev(conn->spdk_sp_fd, iovs, iovcnt);
+		if (rc == 0) {
+			return -EIO;
+		} else if (rc < 0) {
+			if (errno != EAGAIN) {
+				return -errno;
+			}
+			break;
 		}
 
-		ret += rc;
+		sent += rc;
+		len = rc;
+		TAILQ_FOREACH_SAFE(io, &conn->executed_io_list, tailq, io_tmp) {
+			if (len == 0) {
+				break;
+			}
+			len -= nbd_io_xmit_advance(io, len, &done);
+			if (done) {
+				TAILQ_REMOVE(&conn->executed_io_list, io, tailq);
+				nbd_put_io(conn, io);
+			}
+		}
+
+		/* The socket is full, try again on the next poll */
+		for (total = 0, i = 0; i < iovcnt; i++) {
+			total += iovs[i].iov_len;
+		}
+		if ((size_t)rc < total) {
+			break;
+		}
 	}
 
 	/* When there begins to have no executed_io, disable socket writable notice */
-	if (nbd->interrupt_mode) {
-		spdk_interrupt_set_event_types(nbd->intr, SPDK_INTERRUPT_EVENT_IN);
+	if (conn->interrupt_mode && TAILQ_EMPTY(&conn->executed_io_list)) {
+		spdk_interrupt_set_event_types(conn->intr, SPDK_INTERRUPT_EVENT_IN);
 	}
 
-	return ret;
+	return sent;
 }
 
 /**
- * Poll an NBD instance.
+ * Poll an NBD connection.
  *
  * \return 0 on success or negated errno values on error (e.g. connection closed).
  */
 static int
-_nbd_poll(struct spdk_nbd_disk *nbd)
+_nbd_poll(struct nbd_conn *conn)
 {
 	int received, sent, executed;
 
 	/* transmit executed io first */
-	sent = nbd_io_xmit(nbd);
+	sent = nbd_io_xmit(conn);
 	if (sent < 0) {
 		return sent;
 	}
 
-	received = nbd_io_recv(nbd);
+	received = nbd_io_recv(conn);
 	if (received < 0) {
 		return received;
 	}
 
-	executed = nbd_io_exec(nbd);
+	executed = nbd_io_exec(conn);
 	if (executed < 0) {
 		return executed;
 	}
@@ -821,18 +1026,18 @@ _nbd_poll(struct spdk_nbd_disk *nbd)
 static int
 nbd_poll(void *arg)
 {
-	struct spdk_nbd_disk *nbd = arg;
+	struct nbd_conn *conn = arg;
 	int rc;
 
-	rc = _nbd_poll(nbd);
+	rc = _nbd_poll(conn);
 	if (rc < 0) {
-		SPDK_INFOLOG(nbd, "nbd_poll() returned %s (%d); closing connection\n",
-			     spdk_strerror(-rc), rc);
-		_nbd_stop(nbd);
+		SPDK_INFOLOG(nbd, "nbd_poll() returned %s (%d); closing connection %u\n",
+			     spdk_strerror(-rc), rc, conn->id);
+		nbd_conn_stop(conn);
 		return SPDK_POLLER_IDLE;
 	}
-	if (nbd->is_closing) {
-		spdk_nbd_stop(nbd);
+	if (conn->is_closing) {
+		nbd_conn_try_stop(conn);
 	}
 
 	return rc == 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
@@ -854,26 +1059,56 @@ nbd_start_kernel(void *arg)
 }
 
 static void
-nbd_bdev_hot_remove(struct spdk_nbd_disk *nbd)
+nbd_conn_hot_remove(void *arg)
 {
+	struct nbd_conn *conn = arg;
 	struct nbd_io *io, *io_tmp;
 
-	nbd->is_closing = true;
-	nbd_cleanup_io(nbd);
+	if (conn->is_stopped) {
+		return;
+	}
 
-	if (!TAILQ_EMPTY(&nbd->received_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->received_io_list, tailq, io_tmp) {
-			TAILQ_REMOVE(&nbd->received_io_list, io, tailq);
-			TAILQ_INSERT_TAIL(&nbd->processing_io_list, io, tailq);
+	conn->is_closing = true;
+	nbd_cleanup_io(conn);
+
+	if (!TAILQ_EMPTY(&conn->received_io_list)) {
+		TAILQ_FOREACH_SAFE(io, &conn->received_io_list, tailq, io_tmp) {
+			TAILQ_REMOVE(&conn->received_io_list, io, tailq);
+			TAILQ_INSERT_TAIL(&conn->processing_io_list, io, tailq);
 		}
 	}
-	if (!TAILQ_EMPTY(&nbd->processing_io_list)) {
-		TAILQ_FOREACH_SAFE(io, &nbd->processing_io_list, tailq, io_tmp) {
+	if (!TAILQ_EMPTY(&conn->processing_io_list)) {
+		TAILQ_FOREACH_SAFE(io, &conn->processing_io_list, tailq, io_tmp) {
 			nbd_io_done(NULL, false, io);
 		}
 	}
 }
 
+static void
+nbd_bdev_hot_remove(struct spdk_nbd_disk *nbd)
+{
+	struct nbd_conn *conn;
+	uint32_t i;
+
+	nbd->is_closing = true;
+	if (!nbd->is_started) {
+		return;
+	}
+
+	for (i = 0; i < nbd->num_conns; i++) {
+		conn = &nbd->conns[i];
+		if (conn->thread == NULL) {
+			continue;
+		}
+
+		if (conn->thread == spdk_get_thread()) {
+			nbd_conn_hot_remove(conn);
+		} else {
+			spdk_thread_send_msg(conn->thread, nbd_conn_hot_remove, conn);
+		}
+	}
+}
+
 static void
 nbd_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
 		  void *event_ctx)
@@ -897,9 +1132,59 @@ struct spdk_nbd_start_ctx {
 static void
 nbd_poller_set_interrupt_mode(struct spdk_poller *poller, void *cb_arg, bool interrupt_mode)
 {
-	struct spdk_nbd_disk *nbd = cb_arg;
+	struct nbd_conn *conn = cb_arg;
 
-	nbd->interrupt_mode = interrupt_mode;
+	conn->interrupt_mode = interrupt_mode;
+}
+
+static void
+nbd_conn_start(void *arg)
+{
+	struct nbd_conn *conn = arg;
+	struct spdk_nbd_disk *nbd = conn->nbd;
+
+	assert(spdk_get_thread() == conn->thread);
+
+	/* nbd may have been asked to stop before the connection started polling */
+	conn->is_closing = nbd->is_closing;
+
+	conn->ch = spdk_bdev_get_io_channel(nbd->bdev_desc);
+	if (conn->ch == NULL) {
+		SPDK_ERRLOG("could not get io channel for connection %u of %s\n", conn->id, nbd->nbd_path);
+		nbd_conn_stop(conn);
+		return;
+	}
+
+	if (spdk_interrupt_mode_is_enabled()) {
+		conn->intr = SPDK_INTERRUPT_REGISTER(conn->spdk_sp_fd, nbd_poll, conn);
+	}
+
+	conn->nbd_poller = SPDK_POLLER_REGISTER(nbd_poll, conn, 0);
+	spdk_poller_register_interrupt(conn->nbd_poller, nbd_poller_set_interrupt_mode, conn);
+}
+
+static int
+nbd_create_conn_threads(struct spdk_nbd_disk *nbd)
+{
+	char thread_name[32];
+	const char *dev_name;
+	uint32_t i;
+
+	dev_name = strrchr(nbd->nbd_path, '/');
+	dev_name = dev_name ? dev_name + 1 : nbd->nbd_path;
+
+	/* The first connection is polled by the nbd thread */
+	nbd->conns[0].thread = nbd->thread;
+	for (i = 1; i < nbd->num_conns; i++) {
+		snprintf(thread_name, sizeof(thread_name), "%s_conn%u", dev_name, i);
+		nbd->conns[i].thread = spdk_thread_create(thread_name, NULL);
+		if (nbd->conns[i].thread == NULL) {
+			SPDK_ERRLOG("could not create thread %s\n", thread_name);
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
 }
 
 static void
@@ -908,6 +1193,7 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 	int		rc;
 	pthread_t	tid;
 	unsigned long	nbd_flags = 0;
+	uint32_t	i;
 
 	rc = ioctl(ctx->nbd->dev_fd, NBD_SET_BLKSIZE, spdk_bdev_get_block_size(ctx->nbd->bdev));
 	if (rc == -1) {
@@ -944,6 +1230,14 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 		nbd_flags |= NBD_FLAG_SEND_TRIM;
 	}
 #endif
+#ifdef NBD_FLAG_CAN_MULTI_CONN
+	/* The kernel refuses to use more than one socket without it. A flush is
+	 * executed on the bdev, so it covers the writes of all the connections.
+	 */
+	if (ctx->nbd->num_conns > 1) {
+		nbd_flags |= NBD_FLAG_CAN_MULTI_CONN;
+	}
+#endif
 
 	if (nbd_flags) {
 		rc = ioctl(ctx->nbd->dev_fd, NBD_SET_FLAGS, nbd_flags);
@@ -954,6 +1248,11 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 		}
 	}
 
+	rc = nbd_create_conn_threads(ctx->nbd);
+	if (rc != 0) {
+		goto err;
+	}
+
 	ctx->nbd->has_nbd_pthread = true;
 	rc = pthread_create(&tid, NULL, nbd_start_kernel, ctx->nbd);
 	if (rc != 0) {
@@ -970,13 +1269,6 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 		goto err;
 	}
 
-	if (spdk_interrupt_mode_is_enabled()) {
-		ctx->nbd->intr = SPDK_INTERRUPT_REGISTER(ctx->nbd->spdk_sp_fd, nbd_poll, ctx->nbd);
-	}
-
-	ctx->nbd->nbd_poller = SPDK_POLLER_REGISTER(nbd_poll, ctx->nbd, 0);
-	spdk_poller_register_interrupt(ctx->nbd->nbd_poller, nbd_poller_set_interrupt_mode, ctx->nbd);
-
 	if (ctx->cb_fn) {
 		ctx->cb_fn(ctx->cb_arg, ctx->nbd, 0);
 	}
@@ -984,6 +1276,10 @@ nbd_start_complete(struct spdk_nbd_start_ctx *ctx)
 	/* nbd will possibly receive stop command while initing */
 	ctx->nbd->is_started = true;
 
+	for (i = 0; i < ctx->nbd->num_conns; i++) {
+		spdk_thread_send_msg(ctx->nbd->conns[i].thread, nbd_conn_start, &ctx->nbd->conns[i]);
+	}
+
 	free(ctx);
 	return;
 
@@ -999,44 +1295,52 @@ static int
 nbd_enable_kernel(void *arg)
 {
 	struct spdk_nbd_start_ctx *ctx = arg;
+	struct spdk_nbd_disk *nbd = ctx->nbd;
 	int rc;
 
-	/* Declare device setup by this process */
-	rc = ioctl(ctx->nbd->dev_fd, NBD_SET_SOCK, ctx->nbd->kernel_sp_fd);
+	/* Declare device setup by this process, with one socket per connection */
+	while (nbd->num_socks_set < nbd->num_conns) {
+		rc = ioctl(nbd->dev_fd, NBD_SET_SOCK, nbd->conns[nbd->num_socks_set].kernel_sp_fd);
+		if (rc) {
+			break;
+		}
+		nbd->num_socks_set++;
+	}
 
-	if (rc) {
+	if (nbd->num_socks_set < nbd->num_conns) {
 		if (errno == EBUSY) {
-			if (ctx->nbd->retry_poller == NULL) {
-				ctx->nbd->retry_count = NBD_START_BUSY_WAITING_MS * 1000ULL / NBD_BUSY_POLLING_INTERVAL_US;
-				ctx->nbd->retry_poller = SPDK_POLLER_REGISTER(nbd_enable_kernel, ctx,
-							 NBD_BUSY_POLLING_INTERVAL_US);
+			if (nbd->retry_poller == NULL) {
+				nbd->retry_count = NBD_START_BUSY_WAITING_MS * 1000ULL / NBD_BUSY_POLLING_INTERVAL_US;
+				nbd->retry_poller = SPDK_POLLER_REGISTER(nbd_enable_kernel, ctx,
+						    NBD_BUSY_POLLING_INTERVAL_US);
 				return SPDK_POLLER_BUSY;
-			} else if (ctx->nbd->retry_count-- > 0) {
+			} else if (nbd->retry_count-- > 0) {
 				/* Repeatedly unregister and register retry poller to avoid scan-build error */
-				spdk_poller_unregister(&ctx->nbd->retry_poller);
-				ctx->nbd->retry_poller = SPDK_POLLER_REGISTER(nbd_enable_kernel, ctx,
-							 NBD_BUSY_POLLING_INTERVAL_US);
+				spdk_poller_unregister(&nbd->retry_poller);
+				nbd->retry_poller = SPDK_POLLER_REGISTER(nbd_enable_kernel, ctx,
+						    NBD_BUSY_POLLING_INTERVAL_US);
 				return SPDK_POLLER_BUSY;
 			}
 		}
 
 		SPDK_ERRLOG("ioctl(NBD_SET_SOCK) failed: %s\n", spdk_strerror(errno));
-		if (ctx->nbd->retry_poller) {
-			spdk_poller_unregister(&ctx->nbd->retry_poller);
+		rc = -errno;
+		if (nbd->retry_poller) {
+			spdk_poller_unregister(&nbd->retry_poller);
 		}
 
-		_nbd_stop(ctx->nbd);
+		_nbd_stop(nbd);
 
 		if (ctx->cb_fn) {
-			ctx->cb_fn(ctx->cb_arg, NULL, -errno);
+			ctx->cb_fn(ctx->cb_arg, NULL, rc);
 		}
 
 		free(ctx);
 		return SPDK_POLLER_BUSY;
 	}
 
-	if (ctx->nbd->retry_poller) {
-		spdk_poller_unregister(&ctx->nbd->retry_poller);
+	if (nbd->retry_poller) {
+		spdk_poller_unregister(&nbd->retry_poller);
 	}
 
 	nbd_start_complete(ctx);
@@ -1047,12 +1351,34 @@ nbd_enable_kernel(void *arg)
 void
 spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	       spdk_nbd_start_cb cb_fn, void *cb_arg)
+{
+	spdk_nbd_start_ext(bdev_name, nbd_path, 1, cb_fn, cb_arg);
+}
+
+void
+spdk_nbd_start_ext(const char *bdev_name, const char *nbd_path, uint32_t num_connections,
+		   spdk_nbd_start_cb cb_fn, void *cb_arg)
 {
 	struct spdk_nbd_start_ctx	*ctx = NULL;
 	struct spdk_nbd_disk		*nbd = NULL;
+	struct nbd_conn			*conn;
 	struct spdk_bdev		*bdev;
 	int				rc;
 	int				sp[2];
+	uint32_t			i;
+
+	if (num_connections == 0 || num_connections > NBD_MAX_CONNECTIONS) {
+		SPDK_ERRLOG("invalid number of connections %u\n", num_connections);
+		rc = -EINVAL;
+		goto err;
+	}
+#ifndef NBD_FLAG_CAN_MULTI_CONN
+	if (num_connections > 1) {
+		SPDK_ERRLOG("multiple nbd connections are not supported\n");
+		rc = -ENOTSUP;
+		goto err;
+	}
+#endif
 
 	nbd = calloc(1, sizeof(*nbd));
 	if (nbd == NULL) {
@@ -1061,8 +1387,24 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	}
 
 	nbd->dev_fd = -1;
-	nbd->spdk_sp_fd = -1;
-	nbd->kernel_sp_fd = -1;
+	nbd->thread = spdk_get_thread();
+
+	nbd->conns = calloc(num_connections, sizeof(*nbd->conns));
+	if (nbd->conns == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+	nbd->num_conns = num_connections;
+	for (i = 0; i < num_connections; i++) {
+		conn = &nbd->conns[i];
+		conn->nbd = nbd;
+		conn->id = i;
+		conn->spdk_sp_fd = -1;
+		conn->kernel_sp_fd = -1;
+		TAILQ_INIT(&conn->received_io_list);
+		TAILQ_INIT(&conn->executed_io_list);
+		TAILQ_INIT(&conn->processing_io_list);
+	}
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (ctx == NULL) {
@@ -1083,18 +1425,20 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 	bdev = spdk_bdev_desc_get_bdev(nbd->bdev_desc);
 	nbd->bdev = bdev;
 
-	nbd->ch = spdk_bdev_get_io_channel(nbd->bdev_desc);
 	nbd->buf_align = spdk_max(spdk_bdev_get_buf_align(bdev), 64);
 
-	rc = socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sp);
-	if (rc != 0) {
-		SPDK_ERRLOG("socketpair failed\n");
-		rc = -errno;
-		goto err;
+	for (i = 0; i < num_connections; i++) {
+		rc = socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sp);
+		if (rc != 0) {
+			SPDK_ERRLOG("socketpair failed\n");
+			rc = -errno;
+			goto err;
+		}
+
+		nbd->conns[i].spdk_sp_fd = sp[0];
+		nbd->conns[i].kernel_sp_fd = sp[1];
 	}
 
-	nbd->spdk_sp_fd = sp[0];
-	nbd->kernel_sp_fd = sp[1];
 	nbd->nbd_path = strdup(nbd_path);
 	if (!nbd->nbd_path) {
 		SPDK_ERRLOG("strdup allocation failure\n");
@@ -1102,10 +1446,6 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		goto err;
 	}
 
-	TAILQ_INIT(&nbd->received_io_list);
-	TAILQ_INIT(&nbd->executed_io_list);
-	TAILQ_INIT(&nbd->processing_io_list);
-
 	/* Add nbd_disk to the end of disk list */
 	rc = nbd_disk_register(ctx->nbd);
 	if (rc != 0) {
@@ -1119,8 +1459,8 @@ spdk_nbd_start(const char *bdev_name, const char *nbd_path,
 		goto err;
 	}
 
-	SPDK_INFOLOG(nbd, "Enabling kernel access to bdev %s via %s\n",
-		     bdev_name, nbd_path);
+	SPDK_INFOLOG(nbd, "Enabling kernel access to bdev %s via %s with %u connection(s)\n",
+		     bdev_name, nbd_path, num_connections);
 
 	nbd_enable_kernel(ctx);
 	return;
@@ -20,11 +20,39 @@ struct spdk_notify_type {
 	TAILQ_ENTRY(spdk_notify_type) tailq;
 };
 
+struct notify_listener_entry {
+	uint64_t idx;
+	struct spdk_notify_event event;
+};
+
+struct spdk_notify_listener {
+	/* Types to listen for, all types if there are none */
+	char (*types)[SPDK_NOTIFY_MAX_NAME_SIZE];
+	uint32_t num_types;
+
+	spdk_notify_foreach_event_cb cb_fn;
+	void *ctx;
+
+	/*
+	 * Single producer, single consumer ring.  Senders are serialized by g_events_lock, so
+	 * only the head and tail themselves need to be accessed atomically.
+	 */
+	struct notify_listener_entry *ring;
+	uint32_t ring_mask;
+	uint64_t head;
+	uint64_t tail;
+	uint64_t dropped;
+
+	TAILQ_ENTRY(spdk_notify_listener) tailq;
+};
+
 pthread_mutex_t g_events_lock = PTHREAD_MUTEX_INITIALIZER;
 static struct spdk_notify_event g_events[SPDK_NOTIFY_MAX_EVENTS];
 static uint64_t g_events_head;
 
 static TAILQ_HEAD(, spdk_notify_type) g_notify_types = TAILQ_HEAD_INITIALIZER(g_notify_types);
+static TAILQ_HEAD(, spdk_notify_listener) g_notify_listeners =
+	TAILQ_HEAD_INITIALIZER(g_notify_listeners);
 
 struct spdk_notify_type *
 spdk_notify_type_register(const char *type)
@@ -81,11 +109,49 @@ spdk_notify_foreach_type(spdk_notify_foreach_type_cb cb, void *ctx)
 	pthread_mutex_unlock(&g_events_lock);
 }
 
+static bool
+notify_listener_match(const struct spdk_notify_listener *listener, const char *type)
+{
+	uint32_t i;
+
+	if (listener->num_types == 0) {
+		return true;
+	}
+
+	for (i = 0; i < listener->num_types; i++) {
+		if (strcmp(listener->types[i], type) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void
+notify_listener_enqueue(struct spdk_notify_listener *listener, uint64_t idx,
+			const struct spdk_notify_event *ev)
+{
+	struct notify_listener_entry *entry;
+	uint64_t tail;
+
+	tail = __atomic_load_n(&listener->tail, __ATOMIC_ACQUIRE);
+	if (listener->head - tail > listener->ring_mask) {
+		__atomic_store_n(&listener->dropped, listener->dropped + 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	entry = &listener->ring[listener->head & listener->ring_mask];
+	entry->idx = idx;
+	entry->event = *ev;
+	__atomic_store_n(&listener->head, listener->head + 1, __ATOMIC_RELEASE);
+}
+
 uint64_t
 spdk_notify_send(const char *type, const char *ctx)
 {
 	uint64_t head;
 	struct spdk_notify_event *ev;
+	struct spdk_notify_listener *listener;
 
 	pthread_mutex_lock(&g_events_lock);
 	head = g_events_head;
@@ -94,6 +160,12 @@ spdk_notify_send(const char *type, const char *ctx)
 	ev = &g_events[head % SPDK_NOTIFY_MAX_EVENTS];
 	spdk_strcpy_pad(ev->type, type, sizeof(ev->type), '\0');
 	spdk_strcpy_pad(ev->ctx, ctx, sizeof(ev->ctx), '\0');
+
+	TAILQ_FOREACH(listener, &g_notify_listeners, tailq) {
+		if (notify_listener_match(listener, ev->type)) {
+			notify_listener_enqueue(listener, head, ev);
+		}
+	}
 	pthread_mutex_unlock(&g_events_lock);
 
 	return head;
@@ -120,3 +192,114 @@ spdk_notify_foreach_event(uint64_t start_idx, uint64_t max,
 
 	return i;
 }
+
+struct spdk_notify_listener *
+spdk_notify_listen(const char **types, uint32_t num_types, uint32_t ring_size,
+		   spdk_notify_foreach_event_cb cb_fn, void *ctx)
+{
+	struct spdk_notify_listener *listener;
+	uint32_t i;
+
+	if (cb_fn == NULL) {
+		SPDK_ERRLOG("Notification listener callback is required\n");
+		return NULL;
+	}
+
+	if (ring_size == 0 || !spdk_u32_is_pow2(ring_size)) {
+		SPDK_ERRLOG("Notification listener ring size %" PRIu32 " is not a power of 2\n",
+			    ring_size);
+		return NULL;
+	}
+
+	if (types == NULL) {
+		num_types = 0;
+	}
+
+	listener = calloc(1, sizeof(*listener));
+	if (listener == NULL) {
+		return NULL;
+	}
+
+	listener->ring = calloc(ring_size, sizeof(*listener->ring));
+	if (listener->ring == NULL) {
+		goto err;
+	}
+
+	if (num_types > 0) {
+		listener->types = calloc(num_types, sizeof(*listener->types));
+		if (listener->types == NULL) {
+			goto err;
+		}
+	}
+
+	for (i = 0; i < num_types; i++) {
+		if (!types[i] || !types[i][0] || strlen(types[i]) >= SPDK_NOTIFY_MAX_NAME_SIZE) {
+			SPDK_ERRLOG("Invalid notification type to listen for\n");
+			goto err;
+		}
+		snprintf(listener->types[i], sizeof(listener->types[i]), "%s", types[i]);
+	}
+
+	listener->num_types = num_types;
+	listener->ring_mask = ring_size - 1;
+	listener->cb_fn = cb_fn;
+	listener->ctx = ctx;
+
+	pthread_mutex_lock(&g_events_lock);
+	TAILQ_INSERT_TAIL(&g_notify_listeners, listener, tailq);
+	pthread_mutex_unlock(&g_events_lock);
+
+	return listener;
+err:
+	free(listener->types);
+	free(listener->ring);
+	free(listener);
+	return NULL;
+}
+
+uint32_t
+spdk_notify_listener_poll(struct spdk_notify_listener *listener, uint32_t max)
+{
+	struct notify_listener_entry *entry;
+	uint64_t head, tail;
+	uint32_t i;
+
+	head = __atomic_load_n(&listener->head, __ATOMIC_ACQUIRE);
+	tail = listener->tail;
+
+	for (i = 0; tail < head && i < max;) {
+		entry = &listener->ring[tail & listener->ring_mask];
+		tail++;
+		i++;
+		if (listener->cb_fn(entry->idx, &entry->event, listener->ctx)) {
+			break;
+		}
+	}
+
+	/* Give the entries back to the senders only once the callback is done with them */
+	__atomic_store_n(&listener->tail, tail, __ATOMIC_RELEASE);
+
+	return i;
+}
+
+uint64_t
+spdk_notify_listener_get_dropped(const struct spdk_notify_listener *listener)
+{
+	return __atomic_load_n(&listener->dropped, __ATOMIC_RELAXED);
+}
+
+void
+spdk_notify_unlisten(struct spdk_notify_listener *listener)
+{
+	if (listener == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&g_events_lock);
+	TAILQ_REMOVE(&g_notify_listeners, listener, tailq);
+	pthread_mutex_unlock(&g_events_lock);
+
+	free(listener->types);
+	free(listener->ring);
+	free(listener);
+}
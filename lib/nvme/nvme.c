@@ -963,6 +963,7 @@ nvme_ctrlr_opts_init(struct spdk_nvme_ctrlr_opts *opts,
 	SET_FIELD(disable_read_ana_log_page);
 	SET_FIELD(disable_read_changed_ns_list_log_page);
 	SET_FIELD_ARRAY(psk);
+	SET_FIELD(align_write_splits);
 
 #undef FIELD_OK
 #undef SET_FIELD
@@ -238,6 +238,8 @@ spdk_nvme_ctrlr_get_default_ctrlr_opts(struct spdk_nvme_ctrlr_opts *opts, size_t
 		memset(opts->psk, 0, sizeof(opts->psk));
 	}
 
+	SET_FIELD(align_write_splits, false);
+
 #undef FIELD_OK
 #undef SET_FIELD
 }
@@ -354,6 +356,14 @@ spdk_nvme_ctrlr_get_default_io_qpair_opts(struct spdk_nvme_ctrlr *ctrlr,
 		opts->async_mode = false;
 	}
 
+	if (FIELD_OK(delay_cmd_submit_batch_size)) {
+		opts->delay_cmd_submit_batch_size = 0;
+	}
+
+	if (FIELD_OK(shared_cq)) {
+		opts->shared_cq = false;
+	}
+
 #undef FIELD_OK
 }
 
@@ -2449,36 +2459,103 @@ nvme_ctrlr_identify_active_ns(struct spdk_nvme_ctrlr *ctrlr)
 	return 0;
 }
 
+/*
+ * Identify commands are submitted for up to this many namespaces of a controller at once, instead
+ * of one after the other, so that controllers with many namespaces initialize faster.
+ */
+#define NVME_CTRLR_IDENTIFY_NS_BATCH	16
+
 static void
-nvme_ctrlr_identify_ns_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
+nvme_ctrlr_identify_ns_batch_continue(struct spdk_nvme_ctrlr *ctrlr)
 {
-	struct spdk_nvme_ns *ns = (struct spdk_nvme_ns *)arg;
-	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
+	struct spdk_nvme_ns *ns;
+	uint32_t max_outstanding;
 	uint32_t nsid;
 	int rc;
 
-	if (spdk_nvme_cpl_is_error(cpl)) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	if (ctrlr->identify_ns_batch.submitting) {
+		/* Completed while being submitted, the loop below carries on */
 		return;
 	}
 
-	nvme_ns_set_identify_data(ns);
+	/* Leave some admin queue entries for the other admin commands (AERs, keep alive) */
+	max_outstanding = spdk_max(1, spdk_min(NVME_CTRLR_IDENTIFY_NS_BATCH,
+					       ctrlr->opts.admin_queue_size / 2));
 
-	/* move on to the next active NS */
-	nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, ns->id);
-	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
-	if (ns == NULL) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_ID_DESCS,
-				     ctrlr->opts.admin_timeout_ms);
+	ctrlr->identify_ns_batch.submitting = true;
+	while (ctrlr->identify_ns_batch.nsid != 0 && !ctrlr->identify_ns_batch.stop &&
+	       ctrlr->identify_ns_batch.outstanding < max_outstanding) {
+		nsid = ctrlr->identify_ns_batch.nsid;
+		ctrlr->identify_ns_batch.nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, nsid);
+
+		ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
+		if (ns == NULL) {
+			continue;
+		}
+		ns->ctrlr = ctrlr;
+		ns->id = nsid;
+
+		ctrlr->identify_ns_batch.outstanding++;
+		rc = ctrlr->identify_ns_batch.submit_fn(ns);
+		if (rc) {
+			ctrlr->identify_ns_batch.outstanding--;
+			ctrlr->identify_ns_batch.rc = rc;
+			ctrlr->identify_ns_batch.stop = true;
+		}
+	}
+	ctrlr->identify_ns_batch.submitting = false;
+
+	if (ctrlr->identify_ns_batch.outstanding > 0) {
 		return;
 	}
-	ns->ctrlr = ctrlr;
-	ns->id = nsid;
 
-	rc = nvme_ctrlr_identify_ns_async(ns);
-	if (rc) {
+	if (ctrlr->identify_ns_batch.rc) {
 		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
+	} else {
+		nvme_ctrlr_set_state(ctrlr, ctrlr->identify_ns_batch.next_state,
+				     ctrlr->opts.admin_timeout_ms);
+	}
+}
+
+/*
+ * Submit the command issued by submit_fn for all the active namespaces and move on to next_state
+ * once they completed.
+ */
+static int
+nvme_ctrlr_identify_ns_batch_start(struct spdk_nvme_ctrlr *ctrlr,
+				   int (*submit_fn)(struct spdk_nvme_ns *ns),
+				   enum nvme_ctrlr_state next_state)
+{
+	ctrlr->identify_ns_batch.nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
+	ctrlr->identify_ns_batch.outstanding = 0;
+	ctrlr->identify_ns_batch.submit_fn = submit_fn;
+	ctrlr->identify_ns_batch.next_state = next_state;
+	ctrlr->identify_ns_batch.stop = false;
+	ctrlr->identify_ns_batch.submitting = false;
+	ctrlr->identify_ns_batch.rc = 0;
+
+	nvme_ctrlr_identify_ns_batch_continue(ctrlr);
+
+	return ctrlr->identify_ns_batch.outstanding == 0 ? ctrlr->identify_ns_batch.rc : 0;
+}
+
+static void
+nvme_ctrlr_identify_ns_async_done(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_ns *ns = (struct spdk_nvme_ns *)arg;
+	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
+
+	assert(ctrlr->identify_ns_batch.outstanding > 0);
+	ctrlr->identify_ns_batch.outstanding--;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		ctrlr->identify_ns_batch.rc = -ENXIO;
+		ctrlr->identify_ns_batch.stop = true;
+	} else {
+		nvme_ns_set_identify_data(ns);
 	}
+
+	nvme_ctrlr_identify_ns_batch_continue(ctrlr);
 }
 
 static int
@@ -2499,28 +2576,8 @@ nvme_ctrlr_identify_ns_async(struct spdk_nvme_ns *ns)
 static int
 nvme_ctrlr_identify_namespaces(struct spdk_nvme_ctrlr *ctrlr)
 {
-	uint32_t nsid;
-	struct spdk_nvme_ns *ns;
-	int rc;
-
-	nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
-	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
-	if (ns == NULL) {
-		/* No active NS, move on to the next state */
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_ID_DESCS,
-				     ctrlr->opts.admin_timeout_ms);
-		return 0;
-	}
-
-	ns->ctrlr = ctrlr;
-	ns->id = nsid;
-
-	rc = nvme_ctrlr_identify_ns_async(ns);
-	if (rc) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
-	}
-
-	return rc;
+	return nvme_ctrlr_identify_ns_batch_start(ctrlr, nvme_ctrlr_identify_ns_async,
+			NVME_CTRLR_STATE_IDENTIFY_ID_DESCS);
 }
 
 static int
@@ -2635,8 +2692,9 @@ nvme_ctrlr_identify_id_desc_async_done(void *arg, const struct spdk_nvme_cpl *cp
 {
 	struct spdk_nvme_ns *ns = (struct spdk_nvme_ns *)arg;
 	struct spdk_nvme_ctrlr *ctrlr = ns->ctrlr;
-	uint32_t nsid;
-	int rc;
+
+	assert(ctrlr->identify_ns_batch.outstanding > 0);
+	ctrlr->identify_ns_batch.outstanding--;
 
 	if (spdk_nvme_cpl_is_error(cpl)) {
 		/*
@@ -2651,26 +2709,12 @@ nvme_ctrlr_identify_id_desc_async_done(void *arg, const struct spdk_nvme_cpl *cp
 		 * it is too generic and was added in order to handle controllers that
 		 * violate the NVMe 1.1 spec by not supporting ACTIVE LIST).
 		 */
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC,
-				     ctrlr->opts.admin_timeout_ms);
-		return;
-	}
-
-	nvme_ns_set_id_desc_list_data(ns);
-
-	/* move on to the next active NS */
-	nsid = spdk_nvme_ctrlr_get_next_active_ns(ctrlr, ns->id);
-	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
-	if (ns == NULL) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC,
-				     ctrlr->opts.admin_timeout_ms);
-		return;
+		ctrlr->identify_ns_batch.stop = true;
+	} else {
+		nvme_ns_set_id_desc_list_data(ns);
 	}
 
-	rc = nvme_ctrlr_identify_id_desc_async(ns);
-	if (rc) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
-	}
+	nvme_ctrlr_identify_ns_batch_continue(ctrlr);
 }
 
 static int
@@ -2690,10 +2734,6 @@ nvme_ctrlr_identify_id_desc_async(struct spdk_nvme_ns *ns)
 static int
 nvme_ctrlr_identify_id_desc_namespaces(struct spdk_nvme_ctrlr *ctrlr)
 {
-	uint32_t nsid;
-	struct spdk_nvme_ns *ns;
-	int rc;
-
 	if ((ctrlr->vs.raw < SPDK_NVME_VERSION(1, 3, 0) &&
 	     !(ctrlr->cap.bits.css & SPDK_NVME_CAP_CSS_IOCS)) ||
 	    (ctrlr->quirks & NVME_QUIRK_IDENTIFY_CNS)) {
@@ -2704,21 +2744,8 @@ nvme_ctrlr_identify_id_desc_namespaces(struct spdk_nvme_ctrlr *ctrlr)
 		return 0;
 	}
 
-	nsid = spdk_nvme_ctrlr_get_first_active_ns(ctrlr);
-	ns = spdk_nvme_ctrlr_get_ns(ctrlr, nsid);
-	if (ns == NULL) {
-		/* No active NS, move on to the next state */
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC,
-				     ctrlr->opts.admin_timeout_ms);
-		return 0;
-	}
-
-	rc = nvme_ctrlr_identify_id_desc_async(ns);
-	if (rc) {
-		nvme_ctrlr_set_state(ctrlr, NVME_CTRLR_STATE_ERROR, NVME_TIMEOUT_INFINITE);
-	}
-
-	return rc;
+	return nvme_ctrlr_identify_ns_batch_start(ctrlr, nvme_ctrlr_identify_id_desc_async,
+			NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC);
 }
 
 static void
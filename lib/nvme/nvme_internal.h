@@ -195,6 +195,9 @@ extern struct spdk_nvme_transport_opts g_spdk_nvme_transport_opts;
 /* This value indicates that a read from a PCIe register is invalid. This can happen when a device is no longer present */
 #define SPDK_NVME_INVALID_REGISTER_VALUE 0xFFFFFFFFu
 
+/* The maximum number of SGL elements copied into a request, to not walk the SGL callbacks again. */
+#define NVME_REQUEST_INLINE_IOVS	4
+
 enum nvme_payload_type {
 	NVME_PAYLOAD_TYPE_INVALID = 0,
 
@@ -238,6 +241,13 @@ struct nvme_payload {
 
 	/** Virtual memory address of a single virtually contiguous metadata buffer */
 	void *md;
+
+	/**
+	 * Copy of a SGL payload, starting at offset 0, taken once when the request is built.
+	 *  If iovcnt is 0, the SGL callbacks have to be used instead.
+	 */
+	struct iovec *iovs;
+	uint32_t iovcnt;
 };
 
 #define NVME_PAYLOAD_CONTIG(contig_, md_) \
@@ -261,6 +271,58 @@ nvme_payload_type(const struct nvme_payload *payload) {
 	return payload->reset_sgl_fn ? NVME_PAYLOAD_TYPE_SGL : NVME_PAYLOAD_TYPE_CONTIG;
 }
 
+/**
+ * Iterator over the elements of a SGL payload. It walks the copy of the SGL if the payload
+ *  has one, and calls the SGL callbacks otherwise.
+ */
+struct nvme_sgl_iter {
+	const struct nvme_payload	*payload;
+	uint32_t			iovpos;
+	uint32_t			iov_offset;
+};
+
+static inline void
+nvme_sgl_iter_init(struct nvme_sgl_iter *iter, const struct nvme_payload *payload,
+		   uint32_t offset)
+{
+	iter->payload = payload;
+	iter->iovpos = 0;
+	iter->iov_offset = 0;
+
+	if (payload->iovcnt == 0) {
+		payload->reset_sgl_fn(payload->contig_or_cb_arg, offset);
+		return;
+	}
+
+	while (iter->iovpos < payload->iovcnt && offset >= payload->iovs[iter->iovpos].iov_len) {
+		offset -= payload->iovs[iter->iovpos].iov_len;
+		iter->iovpos++;
+	}
+	iter->iov_offset = offset;
+}
+
+static inline int
+nvme_sgl_iter_next(struct nvme_sgl_iter *iter, void **address, uint32_t *length)
+{
+	const struct nvme_payload *payload = iter->payload;
+	const struct iovec *iov;
+
+	if (payload->iovcnt == 0) {
+		return payload->next_sge_fn(payload->contig_or_cb_arg, address, length);
+	}
+
+	if (spdk_unlikely(iter->iovpos >= payload->iovcnt)) {
+		return -EINVAL;
+	}
+
+	iov = &payload->iovs[iter->iovpos++];
+	*address = (uint8_t *)iov->iov_base + iter->iov_offset;
+	*length = iov->iov_len - iter->iov_offset;
+	iter->iov_offset = 0;
+
+	return 0;
+}
+
 struct nvme_error_cmd {
 	bool				do_not_submit;
 	uint64_t			timeout_tsc;
@@ -375,6 +437,12 @@ struct nvme_request {
 	spdk_nvme_cmd_cb		user_cb_fn;
 	void				*user_cb_arg;
 	void				*user_buffer;
+
+	/**
+	 * Storage for the copy of a SGL payload. Children of a split request point to
+	 *  the one of their parent.
+	 */
+	struct iovec			iovs[NVME_REQUEST_INLINE_IOVS];
 };
 
 struct nvme_completion_poll_status {
@@ -512,6 +580,9 @@ struct spdk_nvme_ns {
 	uint32_t			sectors_per_max_io;
 	uint32_t			sectors_per_max_io_no_md;
 	uint32_t			sectors_per_stripe;
+	/* Preferred write granularity and optimal write size, 0 if not reported */
+	uint32_t			sectors_per_write_granularity;
+	uint32_t			sectors_per_optimal_write;
 	uint32_t			id;
 	uint16_t			flags;
 	bool				active;
@@ -912,6 +983,19 @@ struct spdk_nvme_ctrlr {
 	int				state;
 	uint64_t			state_timeout_tsc;
 
+	/* Namespace identify commands submitted in batches during initialization */
+	struct {
+		/* Next active namespace to submit the command for, 0 once all were submitted */
+		uint32_t		nsid;
+		uint32_t		outstanding;
+		int			(*submit_fn)(struct spdk_nvme_ns *ns);
+		enum nvme_ctrlr_state	next_state;
+		/* Stop submitting commands, e.g. after an ignored error */
+		bool			stop;
+		bool			submitting;
+		int			rc;
+	} identify_ns_batch;
+
 	uint64_t			next_keep_alive_tick;
 	uint64_t			keep_alive_interval_ticks;
 
@@ -57,6 +57,18 @@ nvme_ns_set_identify_data(struct spdk_nvme_ns *ns)
 		ns->sectors_per_stripe = 0;
 	}
 
+	if (nsdata->nsfeat.optperf) {
+		/* 0's based values */
+		ns->sectors_per_write_granularity = nsdata->npwg + 1;
+		ns->sectors_per_optimal_write = nsdata->nows + 1;
+		SPDK_DEBUGLOG(nvme, "ns %u preferred write granularity %" PRIu32 " blocks, "
+			      "optimal write size %" PRIu32 " blocks\n", ns->id,
+			      ns->sectors_per_write_granularity, ns->sectors_per_optimal_write);
+	} else {
+		ns->sectors_per_write_granularity = 0;
+		ns->sectors_per_optimal_write = 0;
+	}
+
 	if (ns->ctrlr->cdata.oncs.dsm) {
 		ns->flags |= SPDK_NVME_NS_DEALLOCATE_SUPPORTED;
 	}
@@ -360,6 +372,18 @@ spdk_nvme_ns_get_optimal_io_boundary(struct spdk_nvme_ns *ns)
 	return ns->sectors_per_stripe;
 }
 
+uint32_t
+spdk_nvme_ns_get_preferred_write_granularity(struct spdk_nvme_ns *ns)
+{
+	return ns->sectors_per_write_granularity;
+}
+
+uint32_t
+spdk_nvme_ns_get_optimal_write_size(struct spdk_nvme_ns *ns)
+{
+	return ns->sectors_per_optimal_write;
+}
+
 static const void *
 nvme_ns_find_id_desc(const struct spdk_nvme_ns *ns, enum spdk_nvme_nidt type, size_t *length)
 {
@@ -568,6 +592,8 @@ nvme_ns_destruct(struct spdk_nvme_ns *ns)
 	ns->sectors_per_max_io = 0;
 	ns->sectors_per_max_io_no_md = 0;
 	ns->sectors_per_stripe = 0;
+	ns->sectors_per_write_granularity = 0;
+	ns->sectors_per_optimal_write = 0;
 	ns->flags = 0;
 	ns->csi = SPDK_NVME_CSI_NVM;
 }
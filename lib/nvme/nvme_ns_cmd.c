@@ -112,7 +112,7 @@ _nvme_ns_cmd_split_request(struct spdk_nvme_ns *ns,
 		lba_count = sectors_per_max_io - (lba & sector_mask);
 		lba_count = spdk_min(remaining_lba_count, lba_count);
 
-		child = _nvme_add_child_request(ns, qpair, payload, payload_offset, md_offset,
+		child = _nvme_add_child_request(ns, qpair, &req->payload, payload_offset, md_offset,
 						lba, lba_count, cb_fn, cb_arg, opc,
 						io_flags, apptag_mask, apptag, cdw13, req, true, rc);
 		if (child == NULL) {
@@ -186,9 +186,7 @@ _nvme_ns_cmd_split_request_prp(struct spdk_nvme_ns *ns,
 			       uint32_t io_flags, struct nvme_request *req,
 			       uint16_t apptag_mask, uint16_t apptag, uint32_t cdw13, int *rc)
 {
-	spdk_nvme_req_reset_sgl_cb reset_sgl_fn = req->payload.reset_sgl_fn;
-	spdk_nvme_req_next_sge_cb next_sge_fn = req->payload.next_sge_fn;
-	void *sgl_cb_arg = req->payload.contig_or_cb_arg;
+	struct nvme_sgl_iter iter;
 	bool start_valid, end_valid, last_sge, child_equals_parent;
 	uint64_t child_lba = lba;
 	uint32_t req_current_length = 0;
@@ -197,8 +195,8 @@ _nvme_ns_cmd_split_request_prp(struct spdk_nvme_ns *ns,
 	uint32_t page_size = qpair->ctrlr->page_size;
 	uintptr_t address;
 
-	reset_sgl_fn(sgl_cb_arg, payload_offset);
-	next_sge_fn(sgl_cb_arg, (void **)&address, &sge_length);
+	nvme_sgl_iter_init(&iter, &req->payload, payload_offset);
+	nvme_sgl_iter_next(&iter, (void **)&address, &sge_length);
 	while (req_current_length < req->payload_size) {
 
 		if (sge_length == 0) {
@@ -241,7 +239,7 @@ _nvme_ns_cmd_split_request_prp(struct spdk_nvme_ns *ns,
 			child_length += sge_length;
 			req_current_length += sge_length;
 			if (req_current_length < req->payload_size) {
-				next_sge_fn(sgl_cb_arg, (void **)&address, &sge_length);
+				nvme_sgl_iter_next(&iter, (void **)&address, &sge_length);
 				/*
 				 * If the next SGE is not page aligned, we will need to create a
 				 *  child request for what we have so far, and then start a new
@@ -277,7 +275,7 @@ _nvme_ns_cmd_split_request_prp(struct spdk_nvme_ns *ns,
 			 *  call to _nvme_ns_cmd_rw() to not bother with checking for SGL splitting
 			 *  since we have already verified it here.
 			 */
-			child = _nvme_add_child_request(ns, qpair, payload, payload_offset, md_offset,
+			child = _nvme_add_child_request(ns, qpair, &req->payload, payload_offset, md_offset,
 							child_lba, child_lba_count,
 							cb_fn, cb_arg, opc, io_flags,
 							apptag_mask, apptag, cdw13, req, false, rc);
@@ -309,9 +307,7 @@ _nvme_ns_cmd_split_request_sgl(struct spdk_nvme_ns *ns,
 			       uint32_t io_flags, struct nvme_request *req,
 			       uint16_t apptag_mask, uint16_t apptag, uint32_t cdw13, int *rc)
 {
-	spdk_nvme_req_reset_sgl_cb reset_sgl_fn = req->payload.reset_sgl_fn;
-	spdk_nvme_req_next_sge_cb next_sge_fn = req->payload.next_sge_fn;
-	void *sgl_cb_arg = req->payload.contig_or_cb_arg;
+	struct nvme_sgl_iter iter;
 	uint64_t child_lba = lba;
 	uint32_t req_current_length = 0;
 	uint32_t child_length = 0;
@@ -321,11 +317,11 @@ _nvme_ns_cmd_split_request_sgl(struct spdk_nvme_ns *ns,
 
 	max_sges = ns->ctrlr->max_sges;
 
-	reset_sgl_fn(sgl_cb_arg, payload_offset);
+	nvme_sgl_iter_init(&iter, &req->payload, payload_offset);
 	num_sges = 0;
 
 	while (req_current_length < req->payload_size) {
-		next_sge_fn(sgl_cb_arg, (void **)&address, &sge_length);
+		nvme_sgl_iter_next(&iter, (void **)&address, &sge_length);
 
 		if (req_current_length + sge_length > req->payload_size) {
 			sge_length = req->payload_size - req_current_length;
@@ -361,7 +357,7 @@ _nvme_ns_cmd_split_request_sgl(struct spdk_nvme_ns *ns,
 			 *  call to _nvme_ns_cmd_rw() to not bother with checking for SGL splitting
 			 *  since we have already verified it here.
 			 */
-			child = _nvme_add_child_request(ns, qpair, payload, payload_offset, md_offset,
+			child = _nvme_add_child_request(ns, qpair, &req->payload, payload_offset, md_offset,
 							child_lba, child_lba_count,
 							cb_fn, cb_arg, opc, io_flags,
 							apptag_mask, apptag, cdw13, req, false, rc);
@@ -384,6 +380,59 @@ _nvme_ns_cmd_split_request_sgl(struct spdk_nvme_ns *ns,
 	return req;
 }
 
+/*
+ * Copy a short SGL into the request, so that splitting it and building the command,
+ *  for PCIe, walk this copy rather than calling the SGL callbacks again. The copy is
+ *  abandoned if the SGL has more elements than the request can hold.
+ */
+static void
+_nvme_ns_cmd_copy_sgl(struct nvme_request *req)
+{
+	struct nvme_payload *payload = &req->payload;
+	uint32_t remaining = req->payload_size;
+	uint32_t iovcnt = 0, length;
+	void *address;
+
+	payload->reset_sgl_fn(payload->contig_or_cb_arg, 0);
+	while (remaining > 0) {
+		if (iovcnt == NVME_REQUEST_INLINE_IOVS ||
+		    payload->next_sge_fn(payload->contig_or_cb_arg, &address, &length) != 0 ||
+		    length == 0) {
+			return;
+		}
+		length = spdk_min(length, remaining);
+		req->iovs[iovcnt].iov_base = address;
+		req->iovs[iovcnt].iov_len = length;
+		remaining -= length;
+		iovcnt++;
+	}
+
+	payload->iovs = req->iovs;
+	payload->iovcnt = iovcnt;
+}
+
+/*
+ * Return the number of blocks that the children of a split write are aligned to, or 0.
+ * Only power of 2 sizes which fit into a single command are used.
+ */
+static uint32_t
+_nvme_ns_get_write_split_granularity(struct spdk_nvme_ns *ns, uint32_t sectors_per_max_io)
+{
+	uint32_t granularity;
+
+	granularity = ns->sectors_per_optimal_write;
+	if (granularity > 1 && granularity <= sectors_per_max_io && spdk_u32_is_pow2(granularity)) {
+		return granularity;
+	}
+
+	granularity = ns->sectors_per_write_granularity;
+	if (granularity > 1 && granularity <= sectors_per_max_io && spdk_u32_is_pow2(granularity)) {
+		return granularity;
+	}
+
+	return 0;
+}
+
 static inline struct nvme_request *
 _nvme_ns_cmd_rw(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 		const struct nvme_payload *payload, uint32_t payload_offset, uint32_t md_offset,
@@ -394,6 +443,7 @@ _nvme_ns_cmd_rw(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 	uint32_t		sector_size = _nvme_get_host_buffer_sector_size(ns, io_flags);
 	uint32_t		sectors_per_max_io = _nvme_get_sectors_per_max_io(ns, io_flags);
 	uint32_t		sectors_per_stripe = ns->sectors_per_stripe;
+	uint32_t		granularity;
 
 	assert(rc != NULL);
 	assert(*rc == 0);
@@ -408,6 +458,11 @@ _nvme_ns_cmd_rw(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 	req->payload_offset = payload_offset;
 	req->md_offset = md_offset;
 
+	if (qpair->trtype == SPDK_NVME_TRANSPORT_PCIE && payload_offset == 0 &&
+	    req->payload.iovcnt == 0 && nvme_payload_type(&req->payload) == NVME_PAYLOAD_TYPE_SGL) {
+		_nvme_ns_cmd_copy_sgl(req);
+	}
+
 	/* Zone append commands cannot be split. */
 	if (opc == SPDK_NVME_OPC_ZONE_APPEND) {
 		assert(ns->csi == SPDK_NVME_CSI_ZNS);
@@ -433,6 +488,20 @@ _nvme_ns_cmd_rw(struct spdk_nvme_ns *ns, struct spdk_nvme_qpair *qpair,
 						  cb_arg, opc,
 						  io_flags, req, sectors_per_stripe, sectors_per_stripe - 1, apptag_mask, apptag, cdw13, rc);
 	} else if (lba_count > sectors_per_max_io) {
+		granularity = 0;
+		if (opc == SPDK_NVME_OPC_WRITE && ns->ctrlr->opts.align_write_splits) {
+			granularity = _nvme_ns_get_write_split_granularity(ns, sectors_per_max_io);
+		}
+		if (granularity != 0) {
+			/*
+			 * End the first child on a granularity boundary, so that all the others
+			 * start on one and are a multiple of it, except for the last one.
+			 */
+			return _nvme_ns_cmd_split_request(ns, qpair, payload, payload_offset, md_offset,
+							  lba, lba_count, cb_fn, cb_arg, opc, io_flags, req,
+							  sectors_per_max_io & ~(granularity - 1),
+							  granularity - 1, apptag_mask, apptag, cdw13, rc);
+		}
 		return _nvme_ns_cmd_split_request(ns, qpair, payload, payload_offset, md_offset, lba, lba_count,
 						  cb_fn,
 						  cb_arg, opc,
@@ -314,6 +314,14 @@ nvme_pcie_ctrlr_get_max_sges(struct spdk_nvme_ctrlr *ctrlr)
 	return NVME_MAX_SGL_DESCRIPTORS;
 }
 
+static int32_t
+nvme_pcie_ctrlr_get_socket_id(struct spdk_nvme_ctrlr *ctrlr)
+{
+	struct nvme_pcie_ctrlr *pctrlr = nvme_pcie_ctrlr(ctrlr);
+
+	return spdk_pci_device_get_socket_id(pctrlr->devhandle);
+}
+
 static void
 nvme_pcie_ctrlr_map_cmb(struct nvme_pcie_ctrlr *pctrlr)
 {
@@ -381,8 +389,14 @@ nvme_pcie_ctrlr_unmap_cmb(struct nvme_pcie_ctrlr *pctrlr)
 {
 	int rc = 0;
 	union spdk_nvme_cmbloc_register cmbloc;
+	struct nvme_pcie_cmb_region *region;
 	void *addr = pctrlr->cmb.bar_va;
 
+	while ((region = STAILQ_FIRST(&pctrlr->cmb.free_regions)) != NULL) {
+		STAILQ_REMOVE_HEAD(&pctrlr->cmb.free_regions, link);
+		spdk_free(region);
+	}
+
 	if (addr) {
 		if (pctrlr->cmb.mem_register_addr) {
 			spdk_mem_unregister(pctrlr->cmb.mem_register_addr, pctrlr->cmb.mem_register_size);
@@ -909,6 +923,7 @@ static struct spdk_nvme_ctrlr *
 	pctrlr->is_remapped = false;
 	pctrlr->ctrlr.is_removed = false;
 	pctrlr->devhandle = devhandle;
+	STAILQ_INIT(&pctrlr->cmb.free_regions);
 	pctrlr->ctrlr.opts = *opts;
 	pctrlr->ctrlr.trid = *trid;
 	pctrlr->ctrlr.opts.admin_queue_size = spdk_max(pctrlr->ctrlr.opts.admin_queue_size,
@@ -1083,6 +1098,7 @@ const struct spdk_nvme_transport_ops pcie_ops = {
 
 	.ctrlr_get_max_xfer_size = nvme_pcie_ctrlr_get_max_xfer_size,
 	.ctrlr_get_max_sges = nvme_pcie_ctrlr_get_max_sges,
+	.ctrlr_get_socket_id = nvme_pcie_ctrlr_get_socket_id,
 
 	.ctrlr_reserve_cmb = nvme_pcie_ctrlr_reserve_cmb,
 	.ctrlr_map_cmb = nvme_pcie_ctrlr_map_io_cmb,
@@ -35,6 +35,23 @@ nvme_pcie_vtophys(struct spdk_nvme_ctrlr *ctrlr, const void *buf, uint64_t *size
 	}
 }
 
+static inline int
+nvme_pcie_vtophys_iovs(struct spdk_nvme_ctrlr *ctrlr, const struct iovec *iovs, int iovcnt,
+		       uint64_t *phys_addrs)
+{
+	int i;
+
+	if (spdk_likely(ctrlr->trid.trtype == SPDK_NVME_TRANSPORT_PCIE)) {
+		return spdk_vtophys_iovs(iovs, iovcnt, phys_addrs);
+	}
+
+	for (i = 0; i < iovcnt; i++) {
+		phys_addrs[i] = (uint64_t)(uintptr_t)iovs[i].iov_base;
+	}
+
+	return 0;
+}
+
 int
 nvme_pcie_qpair_reset(struct spdk_nvme_qpair *qpair)
 {
@@ -56,6 +73,10 @@ nvme_pcie_qpair_reset(struct spdk_nvme_qpair *qpair)
 		pqpair->cpl[i].status.p = 0;
 	}
 
+	/* Completions moved from a shared completion queue follow the same phase rules. */
+	pqpair->cpl_tail = 0;
+	pqpair->flags.cpl_tail_phase = 1;
+
 	return 0;
 }
 
@@ -72,6 +93,7 @@ nvme_pcie_ctrlr_alloc_cmb(struct spdk_nvme_ctrlr *ctrlr, uint64_t size, uint64_t
 			  uint64_t *phys_addr)
 {
 	struct nvme_pcie_ctrlr *pctrlr = nvme_pcie_ctrlr(ctrlr);
+	struct nvme_pcie_cmb_region *region;
 	uintptr_t addr;
 
 	if (pctrlr->cmb.mem_register_addr != NULL) {
@@ -79,6 +101,17 @@ nvme_pcie_ctrlr_alloc_cmb(struct spdk_nvme_ctrlr *ctrlr, uint64_t size, uint64_t
 		return NULL;
 	}
 
+	/* Reuse the region of a destroyed queue first, they all have the same size usually */
+	STAILQ_FOREACH(region, &pctrlr->cmb.free_regions, link) {
+		if (region->size == size && ((uintptr_t)region->vaddr & (alignment - 1)) == 0) {
+			STAILQ_REMOVE(&pctrlr->cmb.free_regions, region, nvme_pcie_cmb_region, link);
+			addr = (uintptr_t)region->vaddr;
+			*phys_addr = region->phys_addr;
+			spdk_free(region);
+			return (void *)addr;
+		}
+	}
+
 	addr = (uintptr_t)pctrlr->cmb.bar_va + pctrlr->cmb.current_offset;
 	addr = (addr + (alignment - 1)) & ~(alignment - 1);
 
@@ -94,6 +127,26 @@ nvme_pcie_ctrlr_alloc_cmb(struct spdk_nvme_ctrlr *ctrlr, uint64_t size, uint64_t
 	return (void *)addr;
 }
 
+static void
+nvme_pcie_ctrlr_free_cmb(struct spdk_nvme_ctrlr *ctrlr, void *vaddr, uint64_t phys_addr,
+			 uint64_t size)
+{
+	struct nvme_pcie_ctrlr *pctrlr = nvme_pcie_ctrlr(ctrlr);
+	struct nvme_pcie_cmb_region *region;
+
+	/* The controller is shared between processes, so is the list of free regions */
+	region = spdk_zmalloc(sizeof(*region), 0, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_SHARE);
+	if (region == NULL) {
+		SPDK_ERRLOG("Failed to allocate CMB region, %" PRIu64 " bytes of CMB are lost\n", size);
+		return;
+	}
+
+	region->vaddr = vaddr;
+	region->phys_addr = phys_addr;
+	region->size = size;
+	STAILQ_INSERT_HEAD(&pctrlr->cmb.free_regions, region, link);
+}
+
 int
 nvme_pcie_qpair_construct(struct spdk_nvme_qpair *qpair,
 			  const struct spdk_nvme_io_qpair_opts *opts)
@@ -378,7 +431,7 @@ nvme_pcie_ctrlr_cmd_create_io_sq(struct spdk_nvme_ctrlr *ctrlr,
 	cmd->cdw10_bits.create_io_q.qsize = pqpair->num_entries - 1;
 	cmd->cdw11_bits.create_io_sq.pc = 1;
 	cmd->cdw11_bits.create_io_sq.qprio = io_que->qprio;
-	cmd->cdw11_bits.create_io_sq.cqid = io_que->id;
+	cmd->cdw11_bits.create_io_sq.cqid = pqpair->flags.shared_cq ? pqpair->cq->id : io_que->id;
 	cmd->dptr.prp.prp1 = pqpair->cmd_bus_addr;
 
 	return nvme_ctrlr_submit_admin_request(ctrlr, req);
@@ -422,6 +475,338 @@ nvme_pcie_ctrlr_cmd_delete_io_sq(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme
 	return nvme_ctrlr_submit_admin_request(ctrlr, req);
 }
 
+static int
+nvme_pcie_ctrlr_cmd_create_shared_io_cq(struct spdk_nvme_ctrlr *ctrlr, struct nvme_pcie_cq *cq,
+					spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	struct nvme_request *req;
+	struct spdk_nvme_cmd *cmd;
+
+	req = nvme_allocate_request_null(ctrlr->adminq, cb_fn, cb_arg);
+	if (req == NULL) {
+		return -ENOMEM;
+	}
+
+	cmd = &req->cmd;
+	cmd->opc = SPDK_NVME_OPC_CREATE_IO_CQ;
+
+	cmd->cdw10_bits.create_io_q.qid = cq->id;
+	cmd->cdw10_bits.create_io_q.qsize = cq->num_entries - 1;
+
+	cmd->cdw11_bits.create_io_cq.pc = 1;
+	cmd->dptr.prp.prp1 = cq->cpl_bus_addr;
+
+	return nvme_ctrlr_submit_admin_request(ctrlr, req);
+}
+
+static int
+nvme_pcie_ctrlr_cmd_delete_shared_io_cq(struct spdk_nvme_ctrlr *ctrlr, struct nvme_pcie_cq *cq,
+					spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	struct nvme_request *req;
+	struct spdk_nvme_cmd *cmd;
+
+	req = nvme_allocate_request_null(ctrlr->adminq, cb_fn, cb_arg);
+	if (req == NULL) {
+		return -ENOMEM;
+	}
+
+	cmd = &req->cmd;
+	cmd->opc = SPDK_NVME_OPC_DELETE_IO_CQ;
+	cmd->cdw10_bits.delete_io_q.qid = cq->id;
+
+	return nvme_ctrlr_submit_admin_request(ctrlr, req);
+}
+
+static uint16_t
+nvme_pcie_cq_num_entries(struct spdk_nvme_ctrlr *ctrlr)
+{
+	return spdk_min(ctrlr->cap.bits.mqes + 1u, NVME_PCIE_MAX_SHARED_CQ_ENTRIES);
+}
+
+static void
+nvme_pcie_cq_set_id(struct nvme_pcie_cq *cq, uint16_t qid)
+{
+	struct nvme_pcie_ctrlr *pctrlr = nvme_pcie_ctrlr(cq->ctrlr);
+
+	cq->id = qid;
+	cq->cq_hdbl = pctrlr->doorbell_base + (2 * qid + 1) * pctrlr->doorbell_stride_u32;
+}
+
+static void
+nvme_pcie_cq_reset(struct nvme_pcie_cq *cq)
+{
+	uint32_t i;
+
+	cq->cq_head = 0;
+	cq->phase = 1;
+	for (i = 0; i < cq->num_entries; i++) {
+		cq->cpl[i].status.p = 0;
+	}
+}
+
+static inline bool
+nvme_pcie_cq_is_ready(struct nvme_pcie_cq *cq)
+{
+	return cq->state == NVME_PCIE_CQ_READY &&
+	       cq->generation == nvme_pcie_ctrlr(cq->ctrlr)->queue_generation;
+}
+
+static struct nvme_pcie_cq *
+nvme_pcie_cq_create(struct spdk_nvme_ctrlr *ctrlr, struct nvme_pcie_poll_group *group)
+{
+	struct nvme_pcie_cq	*cq;
+	size_t			page_align = sysconf(_SC_PAGESIZE);
+	size_t			queue_align, queue_len;
+	int32_t			qid;
+
+	cq = calloc(1, sizeof(*cq));
+	if (cq == NULL) {
+		SPDK_ERRLOG("Failed to allocate shared completion queue\n");
+		return NULL;
+	}
+
+	cq->ctrlr = ctrlr;
+	cq->num_entries = nvme_pcie_cq_num_entries(ctrlr);
+	cq->max_completions_cap = cq->num_entries / 4;
+	cq->max_completions_cap = spdk_max(cq->max_completions_cap, NVME_MIN_COMPLETIONS);
+	cq->max_completions_cap = spdk_min(cq->max_completions_cap, NVME_MAX_COMPLETIONS);
+
+	queue_len = cq->num_entries * sizeof(struct spdk_nvme_cpl);
+	queue_align = spdk_max(spdk_align32pow2(queue_len), page_align);
+	cq->cpl = spdk_zmalloc(queue_len, queue_align, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (cq->cpl == NULL) {
+		SPDK_ERRLOG("alloc shared cq cpl failed\n");
+		free(cq);
+		return NULL;
+	}
+
+	cq->cpl_bus_addr = nvme_pcie_vtophys(ctrlr, cq->cpl, NULL);
+	if (cq->cpl_bus_addr == SPDK_VTOPHYS_ERROR) {
+		SPDK_ERRLOG("spdk_vtophys(cq->cpl) failed\n");
+		spdk_free(cq->cpl);
+		free(cq);
+		return NULL;
+	}
+
+	/* The completion queue takes a queue ID of its own, leaving its submission queue unused. */
+	qid = spdk_nvme_ctrlr_alloc_qid(ctrlr);
+	if (qid < 0) {
+		spdk_free(cq->cpl);
+		free(cq);
+		return NULL;
+	}
+	nvme_pcie_cq_set_id(cq, qid);
+
+	cq->generation = nvme_pcie_ctrlr(ctrlr)->queue_generation;
+	cq->stat = &group->stats;
+	cq->group = group;
+	TAILQ_INIT(&cq->pqpairs);
+	TAILQ_INSERT_TAIL(&group->cqs, cq, link);
+
+	return cq;
+}
+
+static void
+nvme_pcie_cq_put(struct nvme_pcie_cq *cq)
+{
+	assert(cq->refs > 0);
+	if (--cq->refs > 0) {
+		return;
+	}
+
+	assert(TAILQ_EMPTY(&cq->pqpairs));
+	if (cq->group != NULL) {
+		TAILQ_REMOVE(&cq->group->cqs, cq, link);
+	}
+	if (cq->id != 0) {
+		spdk_nvme_ctrlr_free_qid(cq->ctrlr, cq->id);
+	}
+	spdk_free(cq->cpl);
+	free(cq);
+}
+
+/* A controller reset frees all of the queue IDs, so take the one of the completion queue again. */
+static int
+nvme_pcie_cq_reclaim_qid(struct nvme_pcie_cq *cq)
+{
+	struct spdk_nvme_ctrlr *ctrlr = cq->ctrlr;
+	int32_t qid;
+
+	nvme_robust_mutex_lock(&ctrlr->ctrlr_lock);
+	if (cq->id != 0 && ctrlr->free_io_qids != NULL &&
+	    spdk_bit_array_get(ctrlr->free_io_qids, cq->id)) {
+		spdk_bit_array_clear(ctrlr->free_io_qids, cq->id);
+		nvme_robust_mutex_unlock(&ctrlr->ctrlr_lock);
+		return 0;
+	}
+	nvme_robust_mutex_unlock(&ctrlr->ctrlr_lock);
+
+	cq->id = 0;
+	qid = spdk_nvme_ctrlr_alloc_qid(ctrlr);
+	if (qid < 0) {
+		return -ENOSPC;
+	}
+	nvme_pcie_cq_set_id(cq, qid);
+
+	return 0;
+}
+
+static void
+nvme_pcie_qpair_detach_cq(struct nvme_pcie_qpair *pqpair)
+{
+	struct nvme_pcie_cq *cq = pqpair->cq;
+
+	TAILQ_REMOVE(&cq->pqpairs, pqpair, cq_link);
+	cq->num_trackers -= pqpair->num_entries - pqpair->max_completions_cap;
+	pqpair->cq = NULL;
+	pqpair->flags.shared_cq = 0;
+	nvme_pcie_cq_put(cq);
+}
+
+static int
+nvme_pcie_qpair_attach_cq(struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_pcie_qpair		*pqpair = nvme_pcie_qpair(qpair);
+	struct spdk_nvme_ctrlr		*ctrlr = qpair->ctrlr;
+	struct nvme_pcie_ctrlr		*pctrlr = nvme_pcie_ctrlr(ctrlr);
+	struct nvme_pcie_poll_group	*group;
+	struct nvme_pcie_cq		*cq = pqpair->cq;
+	uint32_t			num_trackers;
+	int				rc;
+
+	group = SPDK_CONTAINEROF(qpair->poll_group, struct nvme_pcie_poll_group, group);
+	num_trackers = pqpair->num_entries - pqpair->max_completions_cap;
+
+	if (cq != NULL && cq->group != group) {
+		/* The qpair was moved to another poll group. */
+		nvme_pcie_qpair_detach_cq(pqpair);
+		cq = NULL;
+	}
+
+	if (cq == NULL) {
+		if (num_trackers >= nvme_pcie_cq_num_entries(ctrlr)) {
+			return -ENOSPC;
+		}
+
+		TAILQ_FOREACH(cq, &group->cqs, link) {
+			if (cq->ctrlr == ctrlr && cq->num_trackers + num_trackers < cq->num_entries) {
+				break;
+			}
+		}
+
+		if (cq == NULL) {
+			cq = nvme_pcie_cq_create(ctrlr, group);
+			if (cq == NULL) {
+				return -ENOMEM;
+			}
+		}
+
+		cq->refs++;
+		cq->num_trackers += num_trackers;
+		TAILQ_INSERT_TAIL(&cq->pqpairs, pqpair, cq_link);
+		pqpair->cq = cq;
+	}
+
+	if (cq->generation != pctrlr->queue_generation || cq->id == 0) {
+		/* The controller was reset, which deleted the completion queue. */
+		cq->state = NVME_PCIE_CQ_NONE;
+		cq->generation = pctrlr->queue_generation;
+		rc = nvme_pcie_cq_reclaim_qid(cq);
+		if (rc != 0) {
+			nvme_pcie_qpair_detach_cq(pqpair);
+			return rc;
+		}
+	}
+
+	pqpair->flags.shared_cq = 1;
+
+	return 0;
+}
+
+/* Move a completion to the completion ring of its qpair, as the controller would have done. */
+static inline void
+nvme_pcie_qpair_push_cpl(struct nvme_pcie_qpair *pqpair, const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_nvme_cpl *dst = &pqpair->cpl[pqpair->cpl_tail];
+
+	*dst = *cpl;
+	dst->status.p = pqpair->flags.cpl_tail_phase;
+
+	if (spdk_unlikely(++pqpair->cpl_tail == pqpair->num_entries)) {
+		pqpair->cpl_tail = 0;
+		pqpair->flags.cpl_tail_phase = !pqpair->flags.cpl_tail_phase;
+	}
+}
+
+static inline void
+nvme_pcie_cq_ring_doorbell(struct nvme_pcie_cq *cq)
+{
+	cq->stat->cq_mmio_doorbell_updates++;
+	g_thread_mmio_ctrlr = nvme_pcie_ctrlr(cq->ctrlr);
+	spdk_mmio_write_4(cq->cq_hdbl, cq->cq_head);
+	g_thread_mmio_ctrlr = NULL;
+}
+
+static uint32_t
+nvme_pcie_cq_process_completions(struct nvme_pcie_cq *cq)
+{
+	struct nvme_pcie_qpair	*pqpair;
+	struct spdk_nvme_cpl	*cpl;
+	uint32_t		num_completions = 0, num_pending = 0;
+
+	if (spdk_unlikely(!nvme_pcie_cq_is_ready(cq))) {
+		return 0;
+	}
+
+	while (num_completions < cq->num_entries) {
+		cpl = &cq->cpl[cq->cq_head];
+
+		if (cpl->status.p != cq->phase) {
+			break;
+		}
+
+#if defined(__PPC64__) || defined(__riscv) || defined(__loongarch__)
+		/*
+		 * This memory barrier prevents reordering of load cpl phase and cpl sqid/cid
+		 */
+		spdk_mb();
+#elif defined(__aarch64__)
+		__asm volatile("dmb oshld" ::: "memory");
+#endif
+
+		if (spdk_unlikely(++cq->cq_head == cq->num_entries)) {
+			cq->cq_head = 0;
+			cq->phase = !cq->phase;
+		}
+
+		TAILQ_FOREACH(pqpair, &cq->pqpairs, cq_link) {
+			if (pqpair->qpair.id == cpl->sqid) {
+				break;
+			}
+		}
+
+		if (spdk_likely(pqpair != NULL)) {
+			nvme_pcie_qpair_push_cpl(pqpair, cpl);
+		} else {
+			SPDK_ERRLOG("cpl does not map to an attached submission queue\n");
+			spdk_nvme_print_completion(cpl->sqid, cpl);
+		}
+
+		num_completions++;
+		if (++num_pending == cq->max_completions_cap) {
+			nvme_pcie_cq_ring_doorbell(cq);
+			num_pending = 0;
+		}
+	}
+
+	if (num_pending > 0) {
+		nvme_pcie_cq_ring_doorbell(cq);
+	}
+
+	return num_completions;
+}
+
 static void
 nvme_completion_sq_error_delete_cq_cb(void *arg, const struct spdk_nvme_cpl *cpl)
 {
@@ -456,6 +841,13 @@ nvme_completion_create_sq_cb(void *arg, const struct spdk_nvme_cpl *cpl)
 	}
 
 	if (spdk_nvme_cpl_is_error(cpl)) {
+		if (pqpair->flags.shared_cq) {
+			/* The completion queue is still used by other qpairs. */
+			SPDK_ERRLOG("nvme_create_io_sq failed!\n");
+			pqpair->pcie_state = NVME_PCIE_QPAIR_FAILED;
+			return;
+		}
+
 		SPDK_ERRLOG("nvme_create_io_sq failed, deleting cq!\n");
 		rc = nvme_pcie_ctrlr_cmd_delete_io_cq(qpair->ctrlr, qpair, nvme_completion_sq_error_delete_cq_cb,
 						      qpair);
@@ -522,6 +914,85 @@ nvme_completion_create_cq_cb(void *arg, const struct spdk_nvme_cpl *cpl)
 	pqpair->pcie_state = NVME_PCIE_QPAIR_WAIT_FOR_SQ;
 }
 
+static void
+nvme_completion_create_shared_cq_cb(void *arg, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_pcie_cq	*cq = arg;
+	struct nvme_pcie_qpair	*pqpair, *tmp;
+	int			rc;
+
+	if (spdk_nvme_cpl_is_error(cpl)) {
+		SPDK_ERRLOG("nvme_create_io_cq failed!\n");
+		cq->state = NVME_PCIE_CQ_NONE;
+	} else {
+		cq->state = NVME_PCIE_CQ_READY;
+	}
+
+	/* Hold the completion queue, destroying the qpairs may release it. */
+	cq->refs++;
+
+	TAILQ_FOREACH_SAFE(pqpair, &cq->pqpairs, cq_link, tmp) {
+		if (pqpair->pcie_state != NVME_PCIE_QPAIR_WAIT_FOR_CQ) {
+			continue;
+		}
+
+		if (pqpair->flags.defer_destruction) {
+			/* See nvme_completion_create_cq_cb(). */
+			nvme_pcie_qpair_destroy(&pqpair->qpair);
+			continue;
+		}
+
+		if (cq->state != NVME_PCIE_CQ_READY) {
+			pqpair->pcie_state = NVME_PCIE_QPAIR_FAILED;
+			continue;
+		}
+
+		rc = nvme_pcie_ctrlr_cmd_create_io_sq(cq->ctrlr, &pqpair->qpair,
+						      nvme_completion_create_sq_cb, &pqpair->qpair);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to send request to create_io_sq with rc=%d\n", rc);
+			pqpair->pcie_state = NVME_PCIE_QPAIR_FAILED;
+			continue;
+		}
+		pqpair->pcie_state = NVME_PCIE_QPAIR_WAIT_FOR_SQ;
+	}
+
+	nvme_pcie_cq_put(cq);
+}
+
+static int
+nvme_pcie_qpair_connect_shared_cq(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair)
+{
+	struct nvme_pcie_qpair	*pqpair = nvme_pcie_qpair(qpair);
+	struct nvme_pcie_cq	*cq = pqpair->cq;
+	int			rc;
+
+	if (cq->state == NVME_PCIE_CQ_READY) {
+		rc = nvme_pcie_ctrlr_cmd_create_io_sq(ctrlr, qpair, nvme_completion_create_sq_cb, qpair);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to send request to create_io_sq\n");
+			return rc;
+		}
+		pqpair->pcie_state = NVME_PCIE_QPAIR_WAIT_FOR_SQ;
+		return 0;
+	}
+
+	if (cq->state == NVME_PCIE_CQ_NONE) {
+		nvme_pcie_cq_reset(cq);
+		rc = nvme_pcie_ctrlr_cmd_create_shared_io_cq(ctrlr, cq, nvme_completion_create_shared_cq_cb,
+				cq);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to send request to create_io_cq\n");
+			return rc;
+		}
+		cq->state = NVME_PCIE_CQ_WAIT;
+	}
+
+	/* The submission queue is created once the completion queue is. */
+	pqpair->pcie_state = NVME_PCIE_QPAIR_WAIT_FOR_CQ;
+	return 0;
+}
+
 static int
 _nvme_pcie_ctrlr_create_io_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair,
 				 uint16_t qid)
@@ -547,6 +1018,21 @@ _nvme_pcie_ctrlr_create_io_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme
 		}
 	}
 
+	if (pqpair->use_shared_cq && qpair->poll_group != NULL && ctrlr->shadow_doorbell == NULL) {
+		rc = nvme_pcie_qpair_attach_cq(qpair);
+		if (rc == 0) {
+			rc = nvme_pcie_qpair_connect_shared_cq(ctrlr, qpair);
+			if (rc != 0) {
+				nvme_qpair_set_state(qpair, NVME_QPAIR_DISCONNECTED);
+			}
+			return rc;
+		}
+		SPDK_INFOLOG(nvme, "Can't share a completion queue with qpair %u (rc=%d), creating one\n",
+			     qid, rc);
+	} else if (pqpair->cq != NULL) {
+		nvme_pcie_qpair_detach_cq(pqpair);
+	}
+
 	rc = nvme_pcie_ctrlr_cmd_create_io_cq(ctrlr, qpair, nvme_completion_create_cq_cb, qpair);
 
 	if (rc != 0) {
@@ -583,6 +1069,7 @@ nvme_pcie_ctrlr_disconnect_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme
 		 * Then we can abort trackers safely because the Controller Level Reset deletes
 		 * all I/O SQ/CQs.
 		 */
+		nvme_pcie_ctrlr(ctrlr)->queue_generation++;
 		nvme_ctrlr_disable(ctrlr);
 	}
 }
@@ -620,6 +1107,24 @@ nvme_pcie_copy_command(struct spdk_nvme_cmd *dst, const struct spdk_nvme_cmd *sr
 #endif
 }
 
+static inline bool
+nvme_pcie_qpair_delayed_cmds_full(struct nvme_pcie_qpair *pqpair)
+{
+	uint16_t num_delayed;
+
+	if (spdk_likely(pqpair->delay_cmd_submit_batch_size == 0)) {
+		return false;
+	}
+
+	if (pqpair->sq_tail >= pqpair->last_sq_tail) {
+		num_delayed = pqpair->sq_tail - pqpair->last_sq_tail;
+	} else {
+		num_delayed = pqpair->num_entries - pqpair->last_sq_tail + pqpair->sq_tail;
+	}
+
+	return num_delayed >= pqpair->delay_cmd_submit_batch_size;
+}
+
 void
 nvme_pcie_qpair_submit_tracker(struct spdk_nvme_qpair *qpair, struct nvme_tracker *tr)
 {
@@ -662,6 +1167,9 @@ nvme_pcie_qpair_submit_tracker(struct spdk_nvme_qpair *qpair, struct nvme_tracke
 
 	if (!pqpair->flags.delay_cmd_submit) {
 		nvme_pcie_qpair_ring_sq_doorbell(qpair);
+	} else if (nvme_pcie_qpair_delayed_cmds_full(pqpair)) {
+		nvme_pcie_qpair_ring_sq_doorbell(qpair);
+		pqpair->last_sq_tail = pqpair->sq_tail;
 	}
 }
 
@@ -945,7 +1453,9 @@ nvme_pcie_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_
 
 	if (num_completions > 0) {
 		pqpair->stat->completions += num_completions;
-		nvme_pcie_qpair_ring_cq_doorbell(qpair);
+		if (spdk_likely(!pqpair->flags.shared_cq)) {
+			nvme_pcie_qpair_ring_cq_doorbell(qpair);
+		}
 	} else {
 		pqpair->stat->idle_polls++;
 	}
@@ -1003,13 +1513,19 @@ nvme_pcie_qpair_destroy(struct spdk_nvme_qpair *qpair)
 	if (nvme_qpair_is_admin_queue(qpair)) {
 		nvme_pcie_admin_qpair_destroy(qpair);
 	}
+	if (pqpair->cq != NULL) {
+		nvme_pcie_qpair_detach_cq(pqpair);
+	}
 	/*
 	 * We check sq_vaddr and cq_vaddr to see if the user specified the memory
 	 * buffers when creating the I/O queue.
 	 * If the user specified them, we cannot free that memory.
-	 * Nor do we free it if it's in the CMB.
+	 * If it's in the CMB, it is released for the next queues.
 	 */
-	if (!pqpair->sq_vaddr && pqpair->cmd && !pqpair->sq_in_cmb) {
+	if (pqpair->sq_in_cmb) {
+		nvme_pcie_ctrlr_free_cmb(qpair->ctrlr, pqpair->cmd, pqpair->cmd_bus_addr,
+					 pqpair->num_entries * sizeof(struct spdk_nvme_cmd));
+	} else if (!pqpair->sq_vaddr && pqpair->cmd) {
 		spdk_free(pqpair->cmd);
 	}
 	if (!pqpair->cq_vaddr && pqpair->cpl) {
@@ -1055,6 +1571,8 @@ nvme_pcie_ctrlr_create_io_qpair(struct spdk_nvme_ctrlr *ctrlr, uint16_t qid,
 
 	pqpair->num_entries = opts->io_queue_size;
 	pqpair->flags.delay_cmd_submit = opts->delay_cmd_submit;
+	pqpair->delay_cmd_submit_batch_size = opts->delay_cmd_submit_batch_size;
+	pqpair->use_shared_cq = opts->shared_cq;
 
 	qpair = &pqpair->qpair;
 
@@ -1129,12 +1647,26 @@ nvme_pcie_ctrlr_delete_io_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_
 	 * completed any outstanding I/O. Try to complete them. If they don't complete,
 	 * they'll be marked as aborted and completed below. */
 	if (qpair->active_proc == nvme_ctrlr_get_current_process(ctrlr)) {
+		if (pqpair->flags.shared_cq) {
+			nvme_pcie_cq_process_completions(pqpair->cq);
+		}
 		nvme_pcie_qpair_process_completions(qpair, 0);
 	}
 
 	memset(status, 0, sizeof(*status));
 	/* Delete the completion queue */
-	rc = nvme_pcie_ctrlr_cmd_delete_io_cq(ctrlr, qpair, nvme_completion_poll_cb, status);
+	if (pqpair->flags.shared_cq) {
+		/* A shared completion queue goes away along with the last qpair attached to it. */
+		if (pqpair->cq->refs > 1 || !nvme_pcie_cq_is_ready(pqpair->cq)) {
+			free(status);
+			goto clear_shadow_doorbells;
+		}
+		pqpair->cq->state = NVME_PCIE_CQ_NONE;
+		rc = nvme_pcie_ctrlr_cmd_delete_shared_io_cq(ctrlr, pqpair->cq, nvme_completion_poll_cb,
+				status);
+	} else {
+		rc = nvme_pcie_ctrlr_cmd_delete_io_cq(ctrlr, qpair, nvme_completion_poll_cb, status);
+	}
 	if (rc != 0) {
 		SPDK_ERRLOG("Failed to send request to delete_io_cq with rc=%d\n", rc);
 		free(status);
@@ -1188,6 +1720,9 @@ nvme_pcie_fail_request_bad_vtophys(struct spdk_nvme_qpair *qpair, struct nvme_tr
 						1 /* do not retry */, true);
 }
 
+/* Number of PRP entries translated at once by nvme_pcie_prp_list_append() */
+#define NVME_PCIE_PRP_BATCH 32
+
 /*
  * Append PRP list entries to describe a virtually contiguous buffer starting at virt_addr of len bytes.
  *
@@ -1200,8 +1735,10 @@ nvme_pcie_prp_list_append(struct spdk_nvme_ctrlr *ctrlr, struct nvme_tracker *tr
 {
 	struct spdk_nvme_cmd *cmd = &tr->req->cmd;
 	uintptr_t page_mask = page_size - 1;
+	struct iovec iovs[NVME_PCIE_PRP_BATCH];
+	uint64_t phys_addrs[NVME_PCIE_PRP_BATCH];
 	uint64_t phys_addr;
-	uint32_t i;
+	uint32_t i, n, k, seg_len;
 
 	SPDK_DEBUGLOG(nvme, "prp_index:%u virt_addr:%p len:%u\n",
 		      *prp_index, virt_addr, (uint32_t)len);
@@ -1213,42 +1750,51 @@ nvme_pcie_prp_list_append(struct spdk_nvme_ctrlr *ctrlr, struct nvme_tracker *tr
 
 	i = *prp_index;
 	while (len) {
-		uint32_t seg_len;
+		/* Split the next part of the buffer into one segment per PRP entry */
+		for (n = 0; len > 0 && n < NVME_PCIE_PRP_BATCH; n++) {
+			/*
+			 * prp_index 0 is stored in prp1, and the rest are stored in the prp[] array,
+			 * so prp_index == count is valid.
+			 */
+			if (spdk_unlikely(i + n > SPDK_COUNTOF(tr->u.prp))) {
+				SPDK_ERRLOG("out of PRP entries\n");
+				return -EFAULT;
+			}
 
-		/*
-		 * prp_index 0 is stored in prp1, and the rest are stored in the prp[] array,
-		 * so prp_index == count is valid.
-		 */
-		if (spdk_unlikely(i > SPDK_COUNTOF(tr->u.prp))) {
-			SPDK_ERRLOG("out of PRP entries\n");
-			return -EFAULT;
+			if (i + n == 0) {
+				seg_len = page_size - ((uintptr_t)virt_addr & page_mask);
+			} else {
+				seg_len = page_size;
+			}
+
+			seg_len = spdk_min(seg_len, len);
+			iovs[n].iov_base = virt_addr;
+			iovs[n].iov_len = seg_len;
+			virt_addr += seg_len;
+			len -= seg_len;
 		}
 
-		phys_addr = nvme_pcie_vtophys(ctrlr, virt_addr, NULL);
-		if (spdk_unlikely(phys_addr == SPDK_VTOPHYS_ERROR)) {
-			SPDK_ERRLOG("vtophys(%p) failed\n", virt_addr);
+		if (spdk_unlikely(nvme_pcie_vtophys_iovs(ctrlr, iovs, n, phys_addrs) != 0)) {
+			SPDK_ERRLOG("vtophys(%p) failed\n", iovs[0].iov_base);
 			return -EFAULT;
 		}
 
-		if (i == 0) {
-			SPDK_DEBUGLOG(nvme, "prp1 = %p\n", (void *)phys_addr);
-			cmd->dptr.prp.prp1 = phys_addr;
-			seg_len = page_size - ((uintptr_t)virt_addr & page_mask);
-		} else {
-			if ((phys_addr & page_mask) != 0) {
-				SPDK_ERRLOG("PRP %u not page aligned (%p)\n", i, virt_addr);
-				return -EFAULT;
+		for (k = 0; k < n; k++, i++) {
+			phys_addr = phys_addrs[k];
+			if (i == 0) {
+				SPDK_DEBUGLOG(nvme, "prp1 = %p\n", (void *)phys_addr);
+				cmd->dptr.prp.prp1 = phys_addr;
+			} else {
+				if ((phys_addr & page_mask) != 0) {
+					SPDK_ERRLOG("PRP %u not page aligned (%p)\n", i,
+						    iovs[k].iov_base);
+					return -EFAULT;
+				}
+
+				SPDK_DEBUGLOG(nvme, "prp[%u] = %p\n", i - 1, (void *)phys_addr);
+				tr->u.prp[i - 1] = phys_addr;
 			}
-
-			SPDK_DEBUGLOG(nvme, "prp[%u] = %p\n", i - 1, (void *)phys_addr);
-			tr->u.prp[i - 1] = phys_addr;
-			seg_len = page_size;
 		}
-
-		seg_len = spdk_min(seg_len, len);
-		virt_addr += seg_len;
-		len -= seg_len;
-		i++;
 	}
 
 	cmd->psdt = SPDK_NVME_PSDT_PRP;
@@ -1388,6 +1934,7 @@ nvme_pcie_qpair_build_hw_sgl_request(struct spdk_nvme_qpair *qpair, struct nvme_
 	uint64_t phys_addr, mapping_length;
 	uint32_t remaining_transfer_len, remaining_user_sge_len, length;
 	struct spdk_nvme_sgl_descriptor *sgl;
+	struct nvme_sgl_iter iter;
 	uint32_t nseg = 0;
 
 	/*
@@ -1397,7 +1944,7 @@ nvme_pcie_qpair_build_hw_sgl_request(struct spdk_nvme_qpair *qpair, struct nvme_
 	assert(nvme_payload_type(&req->payload) == NVME_PAYLOAD_TYPE_SGL);
 	assert(req->payload.reset_sgl_fn != NULL);
 	assert(req->payload.next_sge_fn != NULL);
-	req->payload.reset_sgl_fn(req->payload.contig_or_cb_arg, req->payload_offset);
+	nvme_sgl_iter_init(&iter, &req->payload, req->payload_offset);
 
 	sgl = tr->u.sgl;
 	req->cmd.psdt = SPDK_NVME_PSDT_SGL_MPTR_CONTIG;
@@ -1406,8 +1953,7 @@ nvme_pcie_qpair_build_hw_sgl_request(struct spdk_nvme_qpair *qpair, struct nvme_
 	remaining_transfer_len = req->payload_size;
 
 	while (remaining_transfer_len > 0) {
-		rc = req->payload.next_sge_fn(req->payload.contig_or_cb_arg,
-					      &virt_addr, &remaining_user_sge_len);
+		rc = nvme_sgl_iter_next(&iter, &virt_addr, &remaining_user_sge_len);
 		if (rc) {
 			nvme_pcie_fail_request_bad_vtophys(qpair, tr);
 			return -EFAULT;
@@ -1522,18 +2068,19 @@ nvme_pcie_qpair_build_prps_sgl_request(struct spdk_nvme_qpair *qpair, struct nvm
 	uint32_t remaining_transfer_len, length;
 	uint32_t prp_index = 0;
 	uint32_t page_size = qpair->ctrlr->page_size;
+	struct nvme_sgl_iter iter;
 
 	/*
 	 * Build scattered payloads.
 	 */
 	assert(nvme_payload_type(&req->payload) == NVME_PAYLOAD_TYPE_SGL);
 	assert(req->payload.reset_sgl_fn != NULL);
-	req->payload.reset_sgl_fn(req->payload.contig_or_cb_arg, req->payload_offset);
+	assert(req->payload.next_sge_fn != NULL);
+	nvme_sgl_iter_init(&iter, &req->payload, req->payload_offset);
 
 	remaining_transfer_len = req->payload_size;
 	while (remaining_transfer_len > 0) {
-		assert(req->payload.next_sge_fn != NULL);
-		rc = req->payload.next_sge_fn(req->payload.contig_or_cb_arg, &virt_addr, &length);
+		rc = nvme_sgl_iter_next(&iter, &virt_addr, &length);
 		if (rc) {
 			nvme_pcie_fail_request_bad_vtophys(qpair, tr);
 			return -EFAULT;
@@ -1714,6 +2261,8 @@ nvme_pcie_poll_group_create(void)
 		return NULL;
 	}
 
+	TAILQ_INIT(&group->cqs);
+
 	return &group->group;
 }
 
@@ -1750,7 +2299,9 @@ int64_t
 nvme_pcie_poll_group_process_completions(struct spdk_nvme_transport_poll_group *tgroup,
 		uint32_t completions_per_qpair, spdk_nvme_disconnected_qpair_cb disconnected_qpair_cb)
 {
+	struct nvme_pcie_poll_group *group = SPDK_CONTAINEROF(tgroup, struct nvme_pcie_poll_group, group);
 	struct spdk_nvme_qpair *qpair, *tmp_qpair;
+	struct nvme_pcie_cq *cq;
 	int32_t local_completions = 0;
 	int64_t total_completions = 0;
 
@@ -1758,6 +2309,11 @@ nvme_pcie_poll_group_process_completions(struct spdk_nvme_transport_poll_group *
 		disconnected_qpair_cb(qpair, tgroup->group->ctx);
 	}
 
+	/* Move the completions of the shared completion queues to their qpairs first. */
+	TAILQ_FOREACH(cq, &group->cqs, link) {
+		nvme_pcie_cq_process_completions(cq);
+	}
+
 	STAILQ_FOREACH_SAFE(qpair, &tgroup->connected_qpairs, poll_group_stailq, tmp_qpair) {
 		local_completions = spdk_nvme_qpair_process_completions(qpair, completions_per_qpair);
 		if (spdk_unlikely(local_completions < 0)) {
@@ -1774,10 +2330,20 @@ nvme_pcie_poll_group_process_completions(struct spdk_nvme_transport_poll_group *
 int
 nvme_pcie_poll_group_destroy(struct spdk_nvme_transport_poll_group *tgroup)
 {
+	struct nvme_pcie_poll_group *group = SPDK_CONTAINEROF(tgroup, struct nvme_pcie_poll_group, group);
+	struct nvme_pcie_cq *cq, *tmp;
+
 	if (!STAILQ_EMPTY(&tgroup->connected_qpairs) || !STAILQ_EMPTY(&tgroup->disconnected_qpairs)) {
 		return -EBUSY;
 	}
 
+	/* Completion queues still used by qpairs removed from the group outlive it. */
+	TAILQ_FOREACH_SAFE(cq, &group->cqs, link, tmp) {
+		TAILQ_REMOVE(&group->cqs, cq, link);
+		cq->group = NULL;
+		cq->stat = &g_dummy_stat;
+	}
+
 	free(tgroup);
 
 	return 0;
@@ -24,6 +24,17 @@
 /* Minimum admin queue size */
 #define NVME_PCIE_MIN_ADMIN_QUEUE_SIZE	(256)
 
+/* Maximum number of entries of a completion queue shared by several I/O qpairs */
+#define NVME_PCIE_MAX_SHARED_CQ_ENTRIES	(4096)
+
+/* Region of the controller memory buffer which was released and can be allocated again */
+struct nvme_pcie_cmb_region {
+	void					*vaddr;
+	uint64_t				phys_addr;
+	uint64_t				size;
+	STAILQ_ENTRY(nvme_pcie_cmb_region)	link;
+};
+
 /* PCIe transport extensions for spdk_nvme_ctrlr */
 struct nvme_pcie_ctrlr {
 	struct spdk_nvme_ctrlr ctrlr;
@@ -47,6 +58,9 @@ struct nvme_pcie_ctrlr {
 		/* Current offset of controller memory buffer, relative to start of BAR virt addr */
 		uint64_t current_offset;
 
+		/* Regions released by destroyed submission queues */
+		STAILQ_HEAD(, nvme_pcie_cmb_region) free_regions;
+
 		void *mem_register_addr;
 		size_t mem_register_size;
 	} cmb;
@@ -75,6 +89,9 @@ struct nvme_pcie_ctrlr {
 	bool is_remapped;
 
 	volatile uint32_t *doorbell_base;
+
+	/* Incremented each time all of the I/O queues are deleted by a controller reset */
+	uint32_t queue_generation;
 };
 
 extern __thread struct nvme_pcie_ctrlr *g_thread_mmio_ctrlr;
@@ -109,9 +126,12 @@ SPDK_STATIC_ASSERT(sizeof(struct nvme_tracker) == 4096, "nvme_tracker is not 4K"
 SPDK_STATIC_ASSERT((offsetof(struct nvme_tracker, u.sgl) & 7) == 0, "SGL must be Qword aligned");
 SPDK_STATIC_ASSERT((offsetof(struct nvme_tracker, meta_sgl) & 7) == 0, "SGL must be Qword aligned");
 
+struct nvme_pcie_cq;
+
 struct nvme_pcie_poll_group {
 	struct spdk_nvme_transport_poll_group group;
 	struct spdk_nvme_pcie_stat stats;
+	TAILQ_HEAD(, nvme_pcie_cq) cqs;
 };
 
 enum nvme_pcie_qpair_state {
@@ -121,6 +141,49 @@ enum nvme_pcie_qpair_state {
 	NVME_PCIE_QPAIR_FAILED,
 };
 
+enum nvme_pcie_cq_state {
+	NVME_PCIE_CQ_NONE = 0,
+	NVME_PCIE_CQ_WAIT,
+	NVME_PCIE_CQ_READY,
+};
+
+/*
+ * I/O completion queue shared by the qpairs of a controller within a poll group.
+ * The poll group moves each completion to the completion ring of the qpair it belongs to,
+ * which is then processed the same way as if the controller had posted it there.
+ */
+struct nvme_pcie_cq {
+	/* Completion queue head doorbell */
+	volatile uint32_t *cq_hdbl;
+
+	struct spdk_nvme_cpl *cpl;
+
+	struct spdk_nvme_pcie_stat *stat;
+
+	uint16_t num_entries;
+	uint16_t cq_head;
+	uint16_t max_completions_cap;
+	uint16_t id;
+	uint8_t phase;
+	uint8_t state;
+
+	/* Qpairs with their submission queue attached to this completion queue */
+	TAILQ_HEAD(, nvme_pcie_qpair) pqpairs;
+
+	/* Number of trackers of the attached qpairs, must stay below num_entries */
+	uint32_t num_trackers;
+	uint32_t refs;
+
+	/* Value of nvme_pcie_ctrlr::queue_generation the queue was created with */
+	uint32_t generation;
+
+	uint64_t cpl_bus_addr;
+
+	struct spdk_nvme_ctrlr *ctrlr;
+	struct nvme_pcie_poll_group *group;
+	TAILQ_ENTRY(nvme_pcie_cq) link;
+};
+
 /* PCIe transport extensions for spdk_nvme_qpair */
 struct nvme_pcie_qpair {
 	/* Submission queue tail doorbell */
@@ -151,17 +214,25 @@ struct nvme_pcie_qpair {
 
 	uint16_t max_completions_cap;
 
+	/* Commands delayed before the doorbell is rung, 0 for no limit */
+	uint16_t delay_cmd_submit_batch_size;
+
 	uint16_t last_sq_tail;
 	uint16_t sq_tail;
 	uint16_t cq_head;
 	uint16_t sq_head;
 
+	/* Where the next completion moved from a shared completion queue goes */
+	uint16_t cpl_tail;
+
 	struct {
 		uint8_t phase			: 1;
 		uint8_t delay_cmd_submit	: 1;
 		uint8_t has_shadow_doorbell	: 1;
 		uint8_t has_pending_vtophys_failures : 1;
 		uint8_t defer_destruction	: 1;
+		uint8_t shared_cq		: 1;
+		uint8_t cpl_tail_phase		: 1;
 	} flags;
 
 	/*
@@ -192,6 +263,13 @@ struct nvme_pcie_qpair {
 	bool sq_in_cmb;
 	bool shared_stats;
 
+	/* Requested with spdk_nvme_io_qpair_opts::shared_cq */
+	bool use_shared_cq;
+
+	/* Shared completion queue the submission queue is attached to, if any */
+	struct nvme_pcie_cq *cq;
+	TAILQ_ENTRY(nvme_pcie_qpair) cq_link;
+
 	uint64_t cmd_bus_addr;
 	uint64_t cpl_bus_addr;
 
@@ -89,6 +89,8 @@ struct nvme_rdma_memory_domain {
 enum nvme_rdma_wr_type {
 	RDMA_WR_TYPE_RECV,
 	RDMA_WR_TYPE_SEND,
+	/* Unsignaled sends only get a completion when they are flushed */
+	RDMA_WR_TYPE_UNSIGNALED_SEND,
 };
 
 struct nvme_rdma_wr {
@@ -231,6 +233,13 @@ struct nvme_rdma_qpair {
 	/* Count of outstanding send objects */
 	uint16_t				current_num_sends;
 
+	/* Each send_signal_interval-th send is signaled, retiring the unsignaled ones before it */
+	uint16_t				send_signal_interval;
+	uint16_t				num_unsignaled_sends;
+	/* Send queue entries which were not retired by a signaled completion yet */
+	uint32_t				num_sq_entries;
+	uint32_t				max_send_wr;
+
 	/* Placed at the end of the struct since it is not used frequently */
 	struct rdma_cm_event			*evt;
 	struct nvme_rdma_poller			*poller;
@@ -255,13 +264,18 @@ enum NVME_RDMA_COMPLETION_FLAGS {
 struct spdk_nvme_rdma_req {
 	uint16_t				id;
 	uint16_t				completion_flags: 2;
-	uint16_t				reserved: 14;
+	uint16_t				unsignaled: 1;
+	uint16_t				reserved: 13;
+	/* Send queue entries retired by the completion of this send, if it is signaled */
+	uint16_t				retired_sends;
 	/* if completion of RDMA_RECV received before RDMA_SEND, we will complete nvme request
 	 * during processing of RDMA_SEND. To complete the request we must know the response
 	 * received in RDMA_RECV, so store it in this field */
 	struct spdk_nvme_rdma_rsp		*rdma_rsp;
 
 	struct nvme_rdma_wr			rdma_wr;
+	/* Used as wr_id of the send instead of rdma_wr when it is unsignaled */
+	struct nvme_rdma_wr			unsignaled_rdma_wr;
 
 	struct ibv_send_wr			send_wr;
 
@@ -675,12 +689,19 @@ exit:
 	return rqpair->evt_cb(rqpair, rc);
 }
 
+static inline int
+nvme_rdma_qpair_num_wc(struct nvme_rdma_qpair *rqpair, struct nvme_rdma_poller *poller)
+{
+	/* With an SRQ, the receive completions are already accounted for by the poller. */
+	return poller->srq ? rqpair->num_entries : WC_PER_QPAIR(rqpair->num_entries);
+}
+
 static int
 nvme_rdma_resize_cq(struct nvme_rdma_qpair *rqpair, struct nvme_rdma_poller *poller)
 {
 	int	current_num_wc, required_num_wc;
 
-	required_num_wc = poller->required_num_wc + WC_PER_QPAIR(rqpair->num_entries);
+	required_num_wc = poller->required_num_wc + nvme_rdma_qpair_num_wc(rqpair, poller);
 	current_num_wc = poller->current_num_wc;
 	if (current_num_wc < required_num_wc) {
 		current_num_wc = spdk_max(current_num_wc * 2, required_num_wc);
@@ -716,11 +737,9 @@ nvme_rdma_qpair_set_poller(struct spdk_nvme_qpair *qpair)
 		return -EINVAL;
 	}
 
-	if (!poller->srq) {
-		if (nvme_rdma_resize_cq(rqpair, poller)) {
-			nvme_rdma_poll_group_put_poller(group, poller);
-			return -EPROTO;
-		}
+	if (nvme_rdma_resize_cq(rqpair, poller)) {
+		nvme_rdma_poll_group_put_poller(group, poller);
+		return -EPROTO;
 	}
 
 	rqpair->cq = poller->cq;
@@ -732,6 +751,21 @@ nvme_rdma_qpair_set_poller(struct spdk_nvme_qpair *qpair)
 	return 0;
 }
 
+static void
+nvme_rdma_qpair_put_poller(struct nvme_rdma_qpair *rqpair)
+{
+	struct nvme_rdma_poll_group	*group = nvme_rdma_poll_group(rqpair->qpair.poll_group);
+	struct nvme_rdma_poller		*poller = rqpair->poller;
+
+	/* The CQ isn't shrunk, but its entries can be used by the next qpairs */
+	poller->required_num_wc -= nvme_rdma_qpair_num_wc(rqpair, poller);
+	assert(poller->required_num_wc >= 0);
+	nvme_rdma_poll_group_put_poller(group, poller);
+
+	rqpair->poller = NULL;
+	rqpair->cq = NULL;
+}
+
 static int
 nvme_rdma_qpair_init(struct nvme_rdma_qpair *rqpair)
 {
@@ -739,6 +773,7 @@ nvme_rdma_qpair_init(struct nvme_rdma_qpair *rqpair)
 	struct spdk_rdma_qp_init_attr	attr = {};
 	struct ibv_device_attr	dev_attr;
 	struct nvme_rdma_ctrlr	*rctrlr;
+	uint32_t		interval;
 
 	rc = ibv_query_device(rqpair->cm_id->verbs, &dev_attr);
 	if (rc != 0) {
@@ -746,6 +781,21 @@ nvme_rdma_qpair_init(struct nvme_rdma_qpair *rqpair)
 		return -1;
 	}
 
+	/*
+	 * Unsignaled sends keep their send queue entry until a later signaled send completes,
+	 * even if their request is already done. Make room in the send queue for them.
+	 */
+	interval = spdk_min(g_spdk_nvme_transport_opts.rdma_send_signal_interval,
+			    rqpair->num_entries);
+	rqpair->max_send_wr = rqpair->num_entries;
+	if (interval > 1 && (uint32_t)dev_attr.max_qp_wr > rqpair->num_entries) {
+		rqpair->max_send_wr = spdk_min(rqpair->num_entries + interval - 1,
+					       (uint32_t)dev_attr.max_qp_wr);
+	}
+	rqpair->send_signal_interval = rqpair->max_send_wr - rqpair->num_entries + 1;
+	rqpair->num_unsignaled_sends = 0;
+	rqpair->num_sq_entries = 0;
+
 	if (rqpair->qpair.poll_group) {
 		assert(!rqpair->cq);
 		rc = nvme_rdma_qpair_set_poller(&rqpair->qpair);
@@ -772,7 +822,7 @@ nvme_rdma_qpair_init(struct nvme_rdma_qpair *rqpair)
 	attr.stats =		rqpair->poller ? &rqpair->poller->stats.rdma_stats : NULL;
 	attr.send_cq		= rqpair->cq;
 	attr.recv_cq		= rqpair->cq;
-	attr.cap.max_send_wr	= rqpair->num_entries; /* SEND operations */
+	attr.cap.max_send_wr	= rqpair->max_send_wr; /* SEND operations */
 	if (rqpair->srq) {
 		attr.srq	= rqpair->srq->srq;
 	} else {
@@ -812,6 +862,7 @@ nvme_rdma_reset_failed_sends(struct nvme_rdma_qpair *rqpair,
 	while (bad_send_wr != NULL) {
 		assert(rqpair->current_num_sends > 0);
 		rqpair->current_num_sends--;
+		rqpair->num_sq_entries--;
 		bad_send_wr = bad_send_wr->next;
 	}
 }
@@ -1010,6 +1061,7 @@ nvme_rdma_create_reqs(struct nvme_rdma_qpair *rqpair)
 
 		rdma_req = &rqpair->rdma_reqs[i];
 		rdma_req->rdma_wr.type = RDMA_WR_TYPE_SEND;
+		rdma_req->unsignaled_rdma_wr.type = RDMA_WR_TYPE_UNSIGNALED_SEND;
 		cmd = &rqpair->cmds[i];
 
 		rdma_req->id = i;
@@ -1894,15 +1946,9 @@ nvme_rdma_qpair_destroy(struct nvme_rdma_qpair *rqpair)
 	}
 
 	if (rqpair->poller) {
-		struct nvme_rdma_poll_group     *group;
-
 		assert(qpair->poll_group);
-		group = nvme_rdma_poll_group(qpair->poll_group);
-
-		nvme_rdma_poll_group_put_poller(group, rqpair->poller);
+		nvme_rdma_qpair_put_poller(rqpair);
 
-		rqpair->poller = NULL;
-		rqpair->cq = NULL;
 		if (rqpair->srq) {
 			rqpair->srq = NULL;
 			rqpair->rsps = NULL;
@@ -2297,6 +2343,25 @@ nvme_rdma_ctrlr_destruct(struct spdk_nvme_ctrlr *ctrlr)
 	return 0;
 }
 
+static inline void
+nvme_rdma_req_set_send_flags(struct nvme_rdma_qpair *rqpair, struct spdk_nvme_rdma_req *rdma_req)
+{
+	if (rqpair->num_unsignaled_sends + 1 < rqpair->send_signal_interval) {
+		rdma_req->send_wr.wr_id = (uint64_t)&rdma_req->unsignaled_rdma_wr;
+		rdma_req->send_wr.send_flags = 0;
+		rdma_req->unsignaled = 1;
+		rqpair->num_unsignaled_sends++;
+	} else {
+		rdma_req->send_wr.wr_id = (uint64_t)&rdma_req->rdma_wr;
+		rdma_req->send_wr.send_flags = IBV_SEND_SIGNALED;
+		rdma_req->unsignaled = 0;
+		rdma_req->retired_sends = rqpair->num_unsignaled_sends + 1;
+		rqpair->num_unsignaled_sends = 0;
+	}
+
+	rqpair->num_sq_entries++;
+}
+
 static int
 nvme_rdma_qpair_submit_request(struct spdk_nvme_qpair *qpair,
 			       struct nvme_request *req)
@@ -2309,6 +2374,15 @@ nvme_rdma_qpair_submit_request(struct spdk_nvme_qpair *qpair,
 	assert(rqpair != NULL);
 	assert(req != NULL);
 
+	if (spdk_unlikely(rqpair->send_signal_interval > 1 &&
+			  rqpair->num_sq_entries >= rqpair->max_send_wr)) {
+		/* The send queue is full of unsignaled sends waiting to be retired. */
+		if (rqpair->poller) {
+			rqpair->poller->stats.queued_requests++;
+		}
+		return -EAGAIN;
+	}
+
 	rdma_req = nvme_rdma_req_get(rqpair);
 	if (spdk_unlikely(!rdma_req)) {
 		if (rqpair->poller) {
@@ -2327,6 +2401,7 @@ nvme_rdma_qpair_submit_request(struct spdk_nvme_qpair *qpair,
 
 	assert(rqpair->current_num_sends < rqpair->num_entries);
 	rqpair->current_num_sends++;
+	nvme_rdma_req_set_send_flags(rqpair, rdma_req);
 
 	wr = &rdma_req->send_wr;
 	wr->next = NULL;
@@ -2543,6 +2618,13 @@ nvme_rdma_process_recv_completion(struct nvme_rdma_poller *poller, struct ibv_wc
 	rdma_req->completion_flags |= NVME_RDMA_RECV_COMPLETED;
 	rdma_req->rdma_rsp = rdma_rsp;
 
+	if (rdma_req->unsignaled && !(rdma_req->completion_flags & NVME_RDMA_SEND_COMPLETED)) {
+		/* The response means that the send was executed, it won't have a completion. */
+		rdma_req->completion_flags |= NVME_RDMA_SEND_COMPLETED;
+		assert(rqpair->current_num_sends > 0);
+		rqpair->current_num_sends--;
+	}
+
 	if ((rdma_req->completion_flags & NVME_RDMA_SEND_COMPLETED) == 0) {
 		return 0;
 	}
@@ -2621,6 +2703,8 @@ nvme_rdma_process_send_completion(struct nvme_rdma_poller *poller,
 	rdma_req->completion_flags |= NVME_RDMA_SEND_COMPLETED;
 	assert(rqpair->current_num_sends > 0);
 	rqpair->current_num_sends--;
+	assert(rqpair->num_sq_entries >= rdma_req->retired_sends);
+	rqpair->num_sq_entries -= rdma_req->retired_sends;
 
 	if ((rdma_req->completion_flags & NVME_RDMA_RECV_COMPLETED) == 0) {
 		return 0;
@@ -2640,6 +2724,44 @@ nvme_rdma_process_send_completion(struct nvme_rdma_poller *poller,
 	return 1;
 }
 
+static inline int
+nvme_rdma_process_unsignaled_send_completion(struct nvme_rdma_poller *poller,
+		struct nvme_rdma_qpair *rdma_qpair,
+		struct ibv_wc *wc, struct nvme_rdma_wr *rdma_wr)
+{
+	struct nvme_rdma_qpair		*rqpair;
+	struct spdk_nvme_rdma_req	*rdma_req;
+
+	/* Only flushed sends complete without being signaled */
+	assert(wc->status != IBV_WC_SUCCESS);
+
+	rdma_req = SPDK_CONTAINEROF(rdma_wr, struct spdk_nvme_rdma_req, unsignaled_rdma_wr);
+	rqpair = rdma_req->req ? nvme_rdma_qpair(rdma_req->req->qpair) : NULL;
+	if (!rqpair) {
+		rqpair = rdma_qpair != NULL ? rdma_qpair : get_rdma_qpair_from_wc(poller->group, wc);
+		if (!rqpair) {
+			assert(poller);
+			return 0;
+		}
+	}
+
+	/*
+	 * If the response was received, the send was already accounted for, and the request
+	 * may have been completed and reused since. Only account for the send if the request
+	 * still waits for it. The receive queue entries are handled by the receive completions.
+	 */
+	if (rdma_req->req != NULL && rdma_req->unsignaled &&
+	    !(rdma_req->completion_flags & NVME_RDMA_SEND_COMPLETED)) {
+		rdma_req->completion_flags |= NVME_RDMA_SEND_COMPLETED;
+		assert(rqpair->current_num_sends > 0);
+		rqpair->current_num_sends--;
+	}
+
+	nvme_rdma_log_wc_status(rqpair, wc);
+	nvme_rdma_fail_qpair(&rqpair->qpair, 0);
+	return -ENXIO;
+}
+
 static int
 nvme_rdma_cq_process_completions(struct ibv_cq *cq, uint32_t batch_size,
 				 struct nvme_rdma_poller *poller,
@@ -2672,6 +2794,11 @@ nvme_rdma_cq_process_completions(struct ibv_cq *cq, uint32_t batch_size,
 			_rc = nvme_rdma_process_send_completion(poller, rdma_qpair, &wc[i], rdma_wr);
 			break;
 
+		case RDMA_WR_TYPE_UNSIGNALED_SEND:
+			_rc = nvme_rdma_process_unsignaled_send_completion(poller, rdma_qpair,
+					&wc[i], rdma_wr);
+			break;
+
 		default:
 			SPDK_ERRLOG("Received an unexpected opcode on the CQ: %d\n", rdma_wr->type);
 			return -ECANCELED;
@@ -2893,7 +3020,7 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 	struct ibv_device_attr dev_attr;
 	struct spdk_rdma_srq_init_attr srq_init_attr = {};
 	struct nvme_rdma_rsp_opts opts;
-	int num_cqe;
+	int num_cqe, required_num_wc;
 	int rc;
 
 	poller = calloc(1, sizeof(*poller));
@@ -2956,13 +3083,16 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 		}
 
 		/*
-		 * When using an srq, fix the size of the completion queue at startup.
-		 * The initiator sends only send and recv WRs. Hence, the multiplier is 2.
-		 * (The target sends also data WRs. Hence, the multiplier is 3.)
+		 * When using an srq, size the completion queue at startup for its recv WRs
+		 * and as many send WRs. The initiator sends only send and recv WRs. Hence,
+		 * the multiplier is 2. (The target sends also data WRs. Hence, the multiplier
+		 * is 3.) Each qpair then adds the send WRs of its queue depth.
 		 */
 		num_cqe = g_spdk_nvme_transport_opts.rdma_srq_size * 2;
+		required_num_wc = g_spdk_nvme_transport_opts.rdma_srq_size;
 	} else {
 		num_cqe = DEFAULT_NVME_RDMA_CQ_SIZE;
+		required_num_wc = 0;
 	}
 
 	poller->cq = ibv_create_cq(poller->device, num_cqe, group, NULL, 0);
@@ -2975,7 +3105,7 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 	STAILQ_INSERT_HEAD(&group->pollers, poller, link);
 	group->num_pollers++;
 	poller->current_num_wc = num_cqe;
-	poller->required_num_wc = 0;
+	poller->required_num_wc = required_num_wc;
 	return poller;
 
 fail:
@@ -3073,15 +3203,11 @@ nvme_rdma_poll_group_remove(struct spdk_nvme_transport_poll_group *tgroup,
 			    struct spdk_nvme_qpair *qpair)
 {
 	struct nvme_rdma_qpair		*rqpair = nvme_rdma_qpair(qpair);
-	struct nvme_rdma_poll_group	*group = nvme_rdma_poll_group(tgroup);
 
 	assert(qpair->poll_group_tailq_head == &tgroup->disconnected_qpairs);
 
 	if (rqpair->poller) {
-		nvme_rdma_poll_group_put_poller(group, rqpair->poller);
-
-		rqpair->poller = NULL;
-		rqpair->cq = NULL;
+		nvme_rdma_qpair_put_poller(rqpair);
 	}
 
 	return 0;
@@ -3286,6 +3412,34 @@ nvme_rdma_ctrlr_get_memory_domains(const struct spdk_nvme_ctrlr *ctrlr,
 	return 1;
 }
 
+static int32_t
+nvme_rdma_ctrlr_get_socket_id(struct spdk_nvme_ctrlr *ctrlr)
+{
+	struct nvme_rdma_qpair *rqpair = nvme_rdma_qpair(ctrlr->adminq);
+	char path[PATH_MAX];
+	FILE *file;
+	int socket_id;
+
+	if (rqpair->cm_id == NULL || rqpair->cm_id->verbs == NULL) {
+		return SPDK_ENV_SOCKET_ID_ANY;
+	}
+
+	snprintf(path, sizeof(path), "%s/device/numa_node",
+		 rqpair->cm_id->verbs->device->ibdev_path);
+	file = fopen(path, "r");
+	if (file == NULL) {
+		return SPDK_ENV_SOCKET_ID_ANY;
+	}
+
+	/* The kernel reports -1 if the device isn't attached to a specific node. */
+	if (fscanf(file, "%d", &socket_id) != 1 || socket_id < 0) {
+		socket_id = SPDK_ENV_SOCKET_ID_ANY;
+	}
+	fclose(file);
+
+	return socket_id;
+}
+
 void
 spdk_nvme_rdma_init_hooks(struct spdk_nvme_rdma_hooks *hooks)
 {
@@ -3311,6 +3465,7 @@ const struct spdk_nvme_transport_ops rdma_ops = {
 
 	.ctrlr_get_max_xfer_size = nvme_rdma_ctrlr_get_max_xfer_size,
 	.ctrlr_get_max_sges = nvme_rdma_ctrlr_get_max_sges,
+	.ctrlr_get_socket_id = nvme_rdma_ctrlr_get_socket_id,
 
 	.ctrlr_create_io_qpair = nvme_rdma_ctrlr_create_io_qpair,
 	.ctrlr_delete_io_qpair = nvme_rdma_ctrlr_delete_io_qpair,
@@ -41,6 +41,14 @@
  */
 #define NVME_TCP_CTRLR_MAX_TRANSPORT_ACK_TIMEOUT	31
 
+/*
+ * Bytes read past the end of a C2H data payload. This is the size of a response
+ * capsule header with its digest, so that most of the time the header of the
+ * next PDU comes with the same readv() as the payload.
+ */
+#define NVME_TCP_RECV_LOOKAHEAD_SIZE \
+	(sizeof(struct spdk_nvme_tcp_rsp) + SPDK_NVME_TCP_DIGEST_LEN)
+
 
 /* NVMe TCP transport extensions for spdk_nvme_ctrlr */
 struct nvme_tcp_ctrlr {
@@ -55,6 +63,12 @@ struct nvme_tcp_poll_group {
 
 	TAILQ_HEAD(, nvme_tcp_qpair) needs_poll;
 	struct spdk_nvme_tcp_stat stats;
+
+	/* While completions are processed, the data digests to verify through accel are
+	 * collected here and submitted together at the end of the pass.
+	 */
+	bool in_completions;
+	TAILQ_HEAD(, nvme_tcp_req) ddgst_reqs;
 };
 
 /* NVMe TCP qpair extensions for spdk_nvme_qpair */
@@ -100,6 +114,11 @@ struct nvme_tcp_qpair {
 	uint64_t				icreq_timeout_tsc;
 
 	bool					shared_stats;
+
+	/* Start of the next PDU, read from the socket along with a C2H data payload */
+	uint8_t					recv_lookahead[NVME_TCP_RECV_LOOKAHEAD_SIZE];
+	uint8_t					recv_lookahead_len;
+	uint8_t					recv_lookahead_off;
 };
 
 enum nvme_tcp_req_state {
@@ -147,6 +166,7 @@ struct nvme_tcp_req {
 	uint32_t				r2tl_remain_next;
 	struct nvme_tcp_qpair			*tqpair;
 	TAILQ_ENTRY(nvme_tcp_req)		link;
+	TAILQ_ENTRY(nvme_tcp_req)		ddgst_link;
 	struct spdk_nvme_cpl			rsp;
 };
 
@@ -297,6 +317,8 @@ fail:
 }
 
 static void nvme_tcp_qpair_abort_reqs(struct spdk_nvme_qpair *qpair, uint32_t dnr);
+static void nvme_tcp_poll_group_drop_ddgsts(struct nvme_tcp_poll_group *tgroup,
+		struct nvme_tcp_qpair *tqpair);
 
 static void
 nvme_tcp_ctrlr_disconnect_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_qpair *qpair)
@@ -312,6 +334,13 @@ nvme_tcp_ctrlr_disconnect_qpair(struct spdk_nvme_ctrlr *ctrlr, struct spdk_nvme_
 		tqpair->needs_poll = false;
 	}
 
+	if (qpair->poll_group != NULL) {
+		nvme_tcp_poll_group_drop_ddgsts(nvme_tcp_poll_group(qpair->poll_group), tqpair);
+	}
+
+	tqpair->recv_lookahead_len = 0;
+	tqpair->recv_lookahead_off = 0;
+
 	rc = spdk_sock_close(&tqpair->sock);
 
 	if (tqpair->sock != NULL) {
@@ -1114,6 +1143,41 @@ end:
 	nvme_tcp_c2h_data_payload_handle(tqpair, tcp_req->pdu, &dummy_reaped);
 }
 
+static void
+nvme_tcp_req_submit_ddgst(struct nvme_tcp_poll_group *tgroup, struct nvme_tcp_req *tcp_req)
+{
+	tgroup->stats.data_digests++;
+	tgroup->group.group->accel_fn_table.submit_accel_crc32c(tgroup->group.group->ctx,
+			&tcp_req->pdu->data_digest_crc32, tcp_req->pdu->data_iov,
+			tcp_req->pdu->data_iovcnt, 0, tcp_data_recv_crc32_done, tcp_req);
+}
+
+/* Submit the data digests collected in this pass back to back, so that the accel module
+ * can put them in a single batch, e.g. a DSA batch descriptor.
+ */
+static void
+nvme_tcp_poll_group_submit_ddgsts(struct nvme_tcp_poll_group *tgroup)
+{
+	struct nvme_tcp_req *tcp_req;
+
+	while ((tcp_req = TAILQ_FIRST(&tgroup->ddgst_reqs)) != NULL) {
+		TAILQ_REMOVE(&tgroup->ddgst_reqs, tcp_req, ddgst_link);
+		nvme_tcp_req_submit_ddgst(tgroup, tcp_req);
+	}
+}
+
+static void
+nvme_tcp_poll_group_drop_ddgsts(struct nvme_tcp_poll_group *tgroup, struct nvme_tcp_qpair *tqpair)
+{
+	struct nvme_tcp_req *tcp_req, *tmp;
+
+	TAILQ_FOREACH_SAFE(tcp_req, &tgroup->ddgst_reqs, ddgst_link, tmp) {
+		if (tcp_req->tqpair == tqpair) {
+			TAILQ_REMOVE(&tgroup->ddgst_reqs, tcp_req, ddgst_link);
+		}
+	}
+}
+
 static void
 nvme_tcp_pdu_payload_handle(struct nvme_tcp_qpair *tqpair,
 			    uint32_t *reaped)
@@ -1150,9 +1214,15 @@ nvme_tcp_pdu_payload_handle(struct nvme_tcp_qpair *tqpair,
 			tcp_req->pdu->data_len = pdu->data_len;
 
 			nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
-			tgroup->group.group->accel_fn_table.submit_accel_crc32c(tgroup->group.group->ctx,
-					&tcp_req->pdu->data_digest_crc32, tcp_req->pdu->data_iov,
-					tcp_req->pdu->data_iovcnt, 0, tcp_data_recv_crc32_done, tcp_req);
+			/* Without the success flag, the response capsule follows the data,
+			 * so don't hold the digest back.
+			 */
+			if (tgroup->in_completions &&
+			    (pdu->hdr.c2h_data.common.flags & SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS)) {
+				TAILQ_INSERT_TAIL(&tgroup->ddgst_reqs, tcp_req, ddgst_link);
+			} else {
+				nvme_tcp_req_submit_ddgst(tgroup, tcp_req);
+			}
 			return;
 		}
 
@@ -1608,6 +1678,91 @@ nvme_tcp_pdu_psh_handle(struct nvme_tcp_qpair *tqpair, uint32_t *reaped)
 
 }
 
+static inline bool
+nvme_tcp_qpair_has_lookahead(struct nvme_tcp_qpair *tqpair)
+{
+	return tqpair->recv_lookahead_off < tqpair->recv_lookahead_len;
+}
+
+/* Read a PDU header, starting with the bytes which came with the previous payload. */
+static int
+nvme_tcp_qpair_read_hdr(struct nvme_tcp_qpair *tqpair, uint32_t bytes, uint8_t *buf)
+{
+	uint32_t len = 0, avail;
+	int rc;
+
+	if (spdk_unlikely(nvme_tcp_qpair_has_lookahead(tqpair))) {
+		avail = tqpair->recv_lookahead_len - tqpair->recv_lookahead_off;
+		len = spdk_min(bytes, avail);
+		memcpy(buf, &tqpair->recv_lookahead[tqpair->recv_lookahead_off], len);
+		tqpair->recv_lookahead_off += len;
+		if (len == bytes) {
+			return len;
+		}
+	}
+
+	rc = nvme_tcp_read_data(tqpair->sock, bytes - len, buf + len);
+	if (rc < 0) {
+		return rc;
+	}
+
+	return len + rc;
+}
+
+/*
+ * Read the payload of a PDU into its data buffers and advance pdu->rw_offset.
+ * For C2H data, the start of the next PDU is read with the same readv() into
+ * the lookahead buffer.
+ */
+static int
+nvme_tcp_qpair_read_payload(struct nvme_tcp_qpair *tqpair, struct nvme_tcp_pdu *pdu,
+			    uint32_t data_len)
+{
+	struct iovec iov[NVME_TCP_MAX_SGL_DESCRIPTORS + 2];
+	struct iovec lookahead_iov;
+	uint32_t remaining, avail;
+	int iovcnt, rc;
+
+	if (spdk_unlikely(nvme_tcp_qpair_has_lookahead(tqpair))) {
+		iovcnt = nvme_tcp_build_payload_iovs(iov, NVME_TCP_MAX_SGL_DESCRIPTORS + 1, pdu,
+						     pdu->ddgst_enable, NULL);
+		lookahead_iov.iov_base = &tqpair->recv_lookahead[tqpair->recv_lookahead_off];
+		avail = tqpair->recv_lookahead_len - tqpair->recv_lookahead_off;
+		lookahead_iov.iov_len = spdk_min(avail, data_len - pdu->rw_offset);
+		rc = spdk_iovcpy(&lookahead_iov, 1, iov, iovcnt);
+		tqpair->recv_lookahead_off += rc;
+		pdu->rw_offset += rc;
+		if (pdu->rw_offset == data_len) {
+			return 0;
+		}
+	}
+
+	iovcnt = nvme_tcp_build_payload_iovs(iov, NVME_TCP_MAX_SGL_DESCRIPTORS + 1, pdu,
+					     pdu->ddgst_enable, NULL);
+	assert(iovcnt >= 0);
+	if (pdu->hdr.common.pdu_type == SPDK_NVME_TCP_PDU_TYPE_C2H_DATA) {
+		iov[iovcnt].iov_base = tqpair->recv_lookahead;
+		iov[iovcnt].iov_len = NVME_TCP_RECV_LOOKAHEAD_SIZE;
+		iovcnt++;
+	}
+
+	rc = nvme_tcp_readv_data(tqpair->sock, iov, iovcnt);
+	if (rc < 0) {
+		return rc;
+	}
+
+	remaining = data_len - pdu->rw_offset;
+	if ((uint32_t)rc > remaining) {
+		tqpair->recv_lookahead_len = rc - remaining;
+		tqpair->recv_lookahead_off = 0;
+		tqpair->stats->recv_lookaheads++;
+		rc = remaining;
+	}
+	pdu->rw_offset += rc;
+
+	return 0;
+}
+
 static int
 nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped, uint32_t max_completions)
 {
@@ -1636,9 +1791,9 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped, uint32_t max_
 		/* Wait for the pdu common header */
 		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_CH:
 			assert(pdu->ch_valid_bytes < sizeof(struct spdk_nvme_tcp_common_pdu_hdr));
-			rc = nvme_tcp_read_data(tqpair->sock,
-						sizeof(struct spdk_nvme_tcp_common_pdu_hdr) - pdu->ch_valid_bytes,
-						(uint8_t *)&pdu->hdr.common + pdu->ch_valid_bytes);
+			rc = nvme_tcp_qpair_read_hdr(tqpair, sizeof(struct spdk_nvme_tcp_common_pdu_hdr) -
+						     pdu->ch_valid_bytes,
+						     (uint8_t *)&pdu->hdr.common + pdu->ch_valid_bytes);
 			if (rc < 0) {
 				nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_QUIESCING);
 				break;
@@ -1654,9 +1809,8 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped, uint32_t max_
 		/* Wait for the pdu specific header  */
 		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PSH:
 			assert(pdu->psh_valid_bytes < pdu->psh_len);
-			rc = nvme_tcp_read_data(tqpair->sock,
-						pdu->psh_len - pdu->psh_valid_bytes,
-						(uint8_t *)&pdu->hdr.raw + sizeof(struct spdk_nvme_tcp_common_pdu_hdr) + pdu->psh_valid_bytes);
+			rc = nvme_tcp_qpair_read_hdr(tqpair, pdu->psh_len - pdu->psh_valid_bytes,
+						     (uint8_t *)&pdu->hdr.raw + sizeof(struct spdk_nvme_tcp_common_pdu_hdr) + pdu->psh_valid_bytes);
 			if (rc < 0) {
 				nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_QUIESCING);
 				break;
@@ -1684,13 +1838,12 @@ nvme_tcp_read_pdu(struct nvme_tcp_qpair *tqpair, uint32_t *reaped, uint32_t max_
 				pdu->ddgst_enable = true;
 			}
 
-			rc = nvme_tcp_read_payload_data(tqpair->sock, pdu);
+			rc = nvme_tcp_qpair_read_payload(tqpair, pdu, data_len);
 			if (rc < 0) {
 				nvme_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_QUIESCING);
 				break;
 			}
 
-			pdu->rw_offset += rc;
 			if (pdu->rw_offset < data_len) {
 				return NVME_TCP_PDU_IN_PROGRESS;
 			}
@@ -1762,6 +1915,7 @@ static int
 nvme_tcp_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_completions)
 {
 	struct nvme_tcp_qpair *tqpair = nvme_tcp_qpair(qpair);
+	struct nvme_tcp_poll_group *pgroup;
 	uint32_t reaped;
 	int rc;
 
@@ -1791,6 +1945,14 @@ nvme_tcp_qpair_process_completions(struct spdk_nvme_qpair *qpair, uint32_t max_c
 		goto fail;
 	}
 
+	/* The socket won't report the bytes already read into the lookahead buffer. */
+	if (spdk_unlikely(nvme_tcp_qpair_has_lookahead(tqpair)) && qpair->poll_group &&
+	    !tqpair->needs_poll) {
+		pgroup = nvme_tcp_poll_group(qpair->poll_group);
+		TAILQ_INSERT_TAIL(&pgroup->needs_poll, tqpair, link);
+		tqpair->needs_poll = true;
+	}
+
 	if (spdk_unlikely(tqpair->qpair.ctrlr->timeout_enabled)) {
 		nvme_tcp_qpair_check_timeout(qpair);
 	}
@@ -2252,6 +2414,7 @@ nvme_tcp_poll_group_create(void)
 	}
 
 	TAILQ_INIT(&group->needs_poll);
+	TAILQ_INIT(&group->ddgst_reqs);
 
 	group->sock_group = spdk_sock_group_create(group);
 	if (group->sock_group == NULL) {
@@ -2362,6 +2525,7 @@ nvme_tcp_poll_group_process_completions(struct spdk_nvme_transport_poll_group *t
 	group->num_completions = 0;
 	group->stats.polls++;
 
+	group->in_completions = true;
 	num_events = spdk_sock_group_poll(group->sock_group);
 
 	STAILQ_FOREACH_SAFE(qpair, &tgroup->disconnected_qpairs, poll_group_stailq, tmp_qpair) {
@@ -2374,6 +2538,12 @@ nvme_tcp_poll_group_process_completions(struct spdk_nvme_transport_poll_group *t
 		nvme_tcp_qpair_sock_cb(&tqpair->qpair, group->sock_group, tqpair->sock);
 	}
 
+	group->in_completions = false;
+	if (!TAILQ_EMPTY(&group->ddgst_reqs)) {
+		group->stats.data_digest_batches++;
+		nvme_tcp_poll_group_submit_ddgsts(group);
+	}
+
 	if (spdk_unlikely(num_events < 0)) {
 		return num_events;
 	}
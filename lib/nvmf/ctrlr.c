@@ -361,6 +361,7 @@ nvmf_ctrlr_create(struct spdk_nvmf_subsystem *subsystem,
 	struct spdk_nvmf_transport *transport = req->qpair->transport;
 	struct spdk_nvme_transport_id listen_trid = {};
 	bool subsys_has_multi_iocs = false;
+	uint32_t in_capsule_data_size;
 
 	ctrlr = calloc(1, sizeof(*ctrlr));
 	if (ctrlr == NULL) {
@@ -391,6 +392,14 @@ nvmf_ctrlr_create(struct spdk_nvmf_subsystem *subsystem,
 
 	nvmf_ctrlr_cdata_init(transport, subsystem, &ctrlr->cdata);
 
+	/* The listener the host connected to may receive less in-capsule data than the transport */
+	in_capsule_data_size = nvmf_transport_qpair_get_in_capsule_data_size(req->qpair);
+	if (in_capsule_data_size < transport->opts.in_capsule_data_size) {
+		in_capsule_data_size += sizeof(struct spdk_nvme_cmd);
+		ctrlr->cdata.nvmf_specific.ioccsz = spdk_min(ctrlr->cdata.nvmf_specific.ioccsz,
+						    in_capsule_data_size / 16);
+	}
+
 	/*
 	 * KAS: This field indicates the granularity of the Keep Alive Timer in 100ms units.
 	 * If this field is cleared to 0h, then Keep Alive is not supported.
@@ -406,8 +415,10 @@ nvmf_ctrlr_create(struct spdk_nvmf_subsystem *subsystem,
 		ctrlr->feat.async_event_configuration.bits.ana_change_notice = 1;
 	}
 	ctrlr->feat.volatile_write_cache.bits.wce = 1;
-	/* Coalescing Disable */
-	ctrlr->feat.interrupt_vector_configuration.bits.cd = 1;
+	/* Coalescing Disable, fabrics controllers don't send interrupts */
+	if (spdk_nvme_trtype_is_fabrics(transport->ops->type)) {
+		ctrlr->feat.interrupt_vector_configuration.bits.cd = 1;
+	}
 
 	if (ctrlr->subsys->subtype == SPDK_NVMF_SUBTYPE_DISCOVERY) {
 		/*
@@ -617,6 +628,14 @@ nvmf_ctrlr_add_io_qpair(void *ctx)
 		goto end;
 	}
 
+	if ((sizeof(struct spdk_nvme_cmd) + nvmf_transport_qpair_get_in_capsule_data_size(qpair)) /
+	    16 < ctrlr->cdata.nvmf_specific.ioccsz) {
+		SPDK_ERRLOG("Got I/O connect with in-capsule data size below IOCCSZ %u\n",
+			    ctrlr->cdata.nvmf_specific.ioccsz);
+		SPDK_NVMF_INVALID_CONNECT_CMD(rsp, qid);
+		goto end;
+	}
+
 	/* check if we would exceed ctrlr connection limit */
 	if (qpair->qid >= spdk_bit_array_capacity(ctrlr->qpair_mask)) {
 		SPDK_ERRLOG("Requested QID %u but Max QID is %u\n",
@@ -704,6 +723,81 @@ _nvmf_ctrlr_add_io_qpair(void *ctx)
 	spdk_thread_send_msg(admin_qpair->group->thread, nvmf_ctrlr_add_io_qpair, req);
 }
 
+/* Up to this many I/O qpair CONNECTs are handed over to the subsystem's thread in one message */
+#define NVMF_IO_CONNECT_BATCH_SIZE	32
+
+struct spdk_nvmf_io_connect_batch {
+	struct spdk_nvmf_subsystem	*subsystem;
+	uint32_t			num_reqs;
+	struct spdk_nvmf_request	*reqs[NVMF_IO_CONNECT_BATCH_SIZE];
+};
+
+static void
+nvmf_ctrlr_add_io_qpairs(void *ctx)
+{
+	struct spdk_nvmf_io_connect_batch *batch = ctx;
+	uint32_t i;
+
+	for (i = 0; i < batch->num_reqs; i++) {
+		_nvmf_ctrlr_add_io_qpair(batch->reqs[i]);
+	}
+
+	free(batch);
+}
+
+static void
+nvmf_poll_group_send_io_connects(struct spdk_nvmf_poll_group *group)
+{
+	struct spdk_nvmf_io_connect_batch *batch = group->io_connect_batch;
+
+	group->io_connect_batch = NULL;
+	spdk_thread_send_msg(batch->subsystem->thread, nvmf_ctrlr_add_io_qpairs, batch);
+}
+
+static void
+nvmf_poll_group_flush_io_connects(void *ctx)
+{
+	struct spdk_nvmf_poll_group *group = ctx;
+
+	if (group->io_connect_batch != NULL) {
+		nvmf_poll_group_send_io_connects(group);
+	}
+}
+
+/*
+ * When lots of hosts connect at once, the CONNECTs a poll group receives while polling its
+ * transports are collected and passed to the subsystem's thread together, once we're done
+ * polling, rather than sending it a message for each of them.
+ */
+static void
+nvmf_ctrlr_queue_io_connect(struct spdk_nvmf_request *req, struct spdk_nvmf_subsystem *subsystem)
+{
+	struct spdk_nvmf_poll_group *group = req->qpair->group;
+	struct spdk_nvmf_io_connect_batch *batch = group->io_connect_batch;
+
+	if (batch != NULL && batch->subsystem != subsystem) {
+		nvmf_poll_group_send_io_connects(group);
+		batch = NULL;
+	}
+
+	if (batch == NULL) {
+		batch = calloc(1, sizeof(*batch));
+		if (spdk_unlikely(batch == NULL)) {
+			spdk_thread_send_msg(subsystem->thread, _nvmf_ctrlr_add_io_qpair, req);
+			return;
+		}
+
+		batch->subsystem = subsystem;
+		group->io_connect_batch = batch;
+		spdk_thread_send_msg(group->thread, nvmf_poll_group_flush_io_connects, group);
+	}
+
+	batch->reqs[batch->num_reqs++] = req;
+	if (batch->num_reqs == NVMF_IO_CONNECT_BATCH_SIZE) {
+		nvmf_poll_group_send_io_connects(group);
+	}
+}
+
 static bool
 nvmf_qpair_access_allowed(struct spdk_nvmf_qpair *qpair, struct spdk_nvmf_subsystem *subsystem,
 			  const char *hostnqn)
@@ -830,7 +924,7 @@ _nvmf_ctrlr_connect(struct spdk_nvmf_request *req)
 			return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
 		}
 	} else {
-		spdk_thread_send_msg(subsystem->thread, _nvmf_ctrlr_add_io_qpair, req);
+		nvmf_ctrlr_queue_io_connect(req, subsystem);
 		return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
 	}
 }
@@ -888,6 +982,7 @@ spdk_nvmf_ctrlr_connect(struct spdk_nvmf_request *req)
 
 	sgroup->mgmt_io_outstanding++;
 	TAILQ_INSERT_TAIL(&qpair->outstanding, req, link);
+	req->io_start_tsc = spdk_get_ticks();
 
 	status = _nvmf_ctrlr_connect(req);
 
@@ -1680,6 +1775,28 @@ nvmf_ctrlr_set_features_volatile_write_cache(struct spdk_nvmf_request *req)
 	return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 }
 
+static int
+nvmf_ctrlr_set_features_interrupt_coalescing(struct spdk_nvmf_request *req)
+{
+	struct spdk_nvmf_ctrlr *ctrlr = req->qpair->ctrlr;
+	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
+	struct spdk_nvme_cpl *rsp = &req->rsp->nvme_cpl;
+
+	SPDK_DEBUGLOG(nvmf, "Set Features - Interrupt Coalescing (cdw11 = 0x%0x)\n", cmd->cdw11);
+
+	/* Fabrics controllers don't send interrupts, it's up to the transport otherwise */
+	if (spdk_nvme_trtype_is_fabrics(req->qpair->transport->ops->type)) {
+		rsp->status.sct = SPDK_NVME_SCT_COMMAND_SPECIFIC;
+		rsp->status.sc = SPDK_NVME_SC_FEATURE_NOT_CHANGEABLE;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	ctrlr->feat.interrupt_coalescing.raw = cmd->cdw11;
+	ctrlr->feat.interrupt_coalescing.bits.reserved = 0;
+
+	return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+}
+
 static int
 nvmf_ctrlr_set_features_write_atomicity(struct spdk_nvmf_request *req)
 {
@@ -1986,7 +2103,7 @@ nvmf_ctrlr_set_features_number_of_queues(struct spdk_nvmf_request *req)
 	return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 }
 
-SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_ctrlr) == 4920,
+SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_ctrlr) == 5008,
 		   "Please check migration fields that need to be added or not");
 
 static void
@@ -3474,9 +3591,7 @@ nvmf_ctrlr_set_features(struct spdk_nvmf_request *req)
 	case SPDK_NVME_FEAT_NUMBER_OF_QUEUES:
 		return nvmf_ctrlr_set_features_number_of_queues(req);
 	case SPDK_NVME_FEAT_INTERRUPT_COALESCING:
-		response->status.sct = SPDK_NVME_SCT_COMMAND_SPECIFIC;
-		response->status.sc = SPDK_NVME_SC_FEATURE_NOT_CHANGEABLE;
-		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+		return nvmf_ctrlr_set_features_interrupt_coalescing(req);
 	case SPDK_NVME_FEAT_WRITE_ATOMICITY:
 		return nvmf_ctrlr_set_features_write_atomicity(req);
 	case SPDK_NVME_FEAT_ASYNC_EVENT_CONFIGURATION:
@@ -4308,6 +4423,46 @@ spdk_nvmf_request_free(struct spdk_nvmf_request *req)
 	return 0;
 }
 
+static inline void
+nvmf_io_stat_update(struct spdk_nvmf_io_stat *stat, uint8_t opc, uint32_t length,
+		    uint64_t ticks, bool error)
+{
+	if (spdk_unlikely(error)) {
+		stat->num_errors++;
+		return;
+	}
+
+	switch (opc) {
+	case SPDK_NVME_OPC_READ:
+		stat->bytes_read += length;
+		stat->num_read_ops++;
+		stat->read_latency_ticks += ticks;
+		break;
+	case SPDK_NVME_OPC_WRITE:
+		stat->bytes_written += length;
+		stat->num_write_ops++;
+		stat->write_latency_ticks += ticks;
+		break;
+	default:
+		stat->num_other_ops++;
+		stat->other_latency_ticks += ticks;
+		break;
+	}
+}
+
+static void
+nvmf_poll_group_stat_connect(struct spdk_nvmf_poll_group_stat *stat, uint64_t ticks,
+			     bool is_error)
+{
+	stat->connects++;
+	if (is_error) {
+		stat->failed_connects++;
+	}
+
+	stat->connect_latency_ticks += ticks;
+	stat->max_connect_latency_ticks = spdk_max(stat->max_connect_latency_ticks, ticks);
+}
+
 static void
 _nvmf_request_complete(void *ctx)
 {
@@ -4320,6 +4475,11 @@ _nvmf_request_complete(void *ctx)
 	uint32_t nsid;
 	bool paused;
 	uint8_t opcode;
+	/* Saved for the IO accounting, the request can't be accessed once completed */
+	uint32_t length = req->length;
+	uint64_t io_start_tsc = req->io_start_tsc;
+	uint64_t ticks;
+	bool is_error;
 
 	rsp->sqid = 0;
 	rsp->status.p = 0;
@@ -4334,6 +4494,7 @@ _nvmf_request_complete(void *ctx)
 		is_aer = req->cmd->nvme_cmd.opc == SPDK_NVME_OPC_ASYNC_EVENT_REQUEST;
 		if (spdk_likely(qpair->qid != 0)) {
 			qpair->group->stat.completed_nvme_io++;
+			qpair->completed_nvme_io++;
 		}
 
 		/*
@@ -4354,6 +4515,13 @@ _nvmf_request_complete(void *ctx)
 		spdk_nvme_print_completion(qpair->qid, rsp);
 	}
 
+	is_error = spdk_nvme_cpl_is_error(rsp);
+
+	if (spdk_unlikely(nvmf_request_is_fabric_connect(req))) {
+		nvmf_poll_group_stat_connect(&qpair->group->stat, spdk_get_ticks() - io_start_tsc,
+					     is_error);
+	}
+
 	switch (req->zcopy_phase) {
 	case NVMF_ZCOPY_PHASE_NONE:
 		TAILQ_REMOVE(&qpair->outstanding, req, link);
@@ -4395,7 +4563,13 @@ _nvmf_request_complete(void *ctx)
 
 				/* NOTE: This implicitly also checks for 0, since 0 - 1 wraps around to UINT32_MAX. */
 				if (spdk_likely(nsid - 1 < sgroup->num_ns)) {
-					sgroup->ns_info[nsid - 1].io_outstanding--;
+					ns_info = &sgroup->ns_info[nsid - 1];
+					ns_info->io_outstanding--;
+					ticks = spdk_get_ticks() - io_start_tsc;
+					nvmf_io_stat_update(&ns_info->io_stat, opcode, length,
+							    ticks, is_error);
+					nvmf_io_stat_update(&qpair->io_stat, opcode, length,
+							    ticks, is_error);
 				}
 			}
 		}
@@ -4475,6 +4649,7 @@ nvmf_check_subsystem_active(struct spdk_nvmf_request *req)
 		sgroup = &qpair->group->sgroups[qpair->ctrlr->subsys->id];
 		assert(sgroup != NULL);
 	} else if (spdk_unlikely(nvmf_request_is_fabric_connect(req))) {
+		req->io_start_tsc = spdk_get_ticks();
 		sgroup = nvmf_subsystem_pg_from_connect_cmd(req);
 	}
 
@@ -4490,6 +4665,7 @@ nvmf_check_subsystem_active(struct spdk_nvmf_request *req)
 			sgroup->mgmt_io_outstanding++;
 		} else {
 			nsid = req->cmd->nvme_cmd.nsid;
+			req->io_start_tsc = spdk_get_ticks();
 
 			/* NOTE: This implicitly also checks for 0, since 0 - 1 wraps around to UINT32_MAX. */
 			if (spdk_unlikely(nsid - 1 >= sgroup->num_ns)) {
@@ -4537,6 +4713,106 @@ nvmf_check_subsystem_active(struct spdk_nvmf_request *req)
 	return true;
 }
 
+static void
+nvmf_ns_qos_refill(struct spdk_nvmf_ns_qos *qos, uint64_t now)
+{
+	uint64_t last_timeslice = __atomic_load_n(&qos->last_timeslice, __ATOMIC_RELAXED);
+	int64_t remaining;
+	int i;
+
+	if (spdk_likely(now - last_timeslice < qos->timeslice_size)) {
+		return;
+	}
+
+	/* Only one of the poll groups refills the budget of a timeslice */
+	if (!__atomic_compare_exchange_n(&qos->last_timeslice, &last_timeslice, now, false,
+					 __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+		return;
+	}
+
+	for (i = 0; i < SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		if (qos->max_per_timeslice[i] == 0) {
+			continue;
+		}
+
+		/* Any budget left over expires, while an overrun reduces the next timeslice */
+		remaining = __atomic_load_n(&qos->remaining_this_timeslice[i], __ATOMIC_RELAXED);
+		__atomic_fetch_add(&qos->remaining_this_timeslice[i],
+				   (int64_t)qos->max_per_timeslice[i] - spdk_max(remaining, 0),
+				   __ATOMIC_RELAXED);
+	}
+}
+
+static bool
+nvmf_ns_qos_limit_applies(int type, uint8_t opc)
+{
+	switch (type) {
+	case SPDK_NVMF_NS_QOS_R_BPS_RATE_LIMIT:
+		return opc == SPDK_NVME_OPC_READ;
+	case SPDK_NVMF_NS_QOS_W_BPS_RATE_LIMIT:
+		return opc == SPDK_NVME_OPC_WRITE;
+	default:
+		return true;
+	}
+}
+
+bool
+nvmf_request_qos_admit(struct spdk_nvmf_request *req, bool force)
+{
+	struct spdk_nvmf_qpair *qpair = req->qpair;
+	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
+	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	struct spdk_nvmf_ns *ns;
+	struct spdk_nvmf_ns_qos *qos;
+	uint64_t num_bytes;
+	int i;
+
+	if (qpair->ctrlr == NULL || nvmf_qpair_is_admin_queue(qpair) ||
+	    (cmd->opc != SPDK_NVME_OPC_READ && cmd->opc != SPDK_NVME_OPC_WRITE)) {
+		return true;
+	}
+
+	/* The namespace can't be removed while it's active in this poll group. Otherwise,
+	 * the request is queued by nvmf_check_subsystem_active() anyway. */
+	sgroup = &qpair->group->sgroups[qpair->ctrlr->subsys->id];
+	if (sgroup->state != SPDK_NVMF_SUBSYSTEM_ACTIVE || cmd->nsid - 1 >= sgroup->num_ns ||
+	    sgroup->ns_info[cmd->nsid - 1].state != SPDK_NVMF_SUBSYSTEM_ACTIVE) {
+		return true;
+	}
+
+	ns = _nvmf_subsystem_get_ns(qpair->ctrlr->subsys, cmd->nsid);
+	qos = ns != NULL ? __atomic_load_n(&ns->qos, __ATOMIC_ACQUIRE) : NULL;
+	if (spdk_likely(qos == NULL)) {
+		return true;
+	}
+
+	/* Fused commands have to be submitted back to back */
+	force |= cmd->fuse != SPDK_NVME_CMD_FUSE_NONE;
+
+	nvmf_ns_qos_refill(qos, spdk_get_ticks());
+
+	for (i = 0; i < SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES && !force; i++) {
+		if (qos->max_per_timeslice[i] > 0 && nvmf_ns_qos_limit_applies(i, cmd->opc) &&
+		    __atomic_load_n(&qos->remaining_this_timeslice[i], __ATOMIC_RELAXED) <= 0) {
+			return false;
+		}
+	}
+
+	num_bytes = ((from_le32(&cmd->cdw12) & 0xFFFFu) + 1ull) *
+		    spdk_bdev_get_block_size(ns->bdev);
+	for (i = 0; i < SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		if (qos->max_per_timeslice[i] == 0 || !nvmf_ns_qos_limit_applies(i, cmd->opc)) {
+			continue;
+		}
+
+		__atomic_fetch_sub(&qos->remaining_this_timeslice[i],
+				   i == SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT ? 1 : num_bytes,
+				   __ATOMIC_RELAXED);
+	}
+
+	return true;
+}
+
 void
 spdk_nvmf_request_exec(struct spdk_nvmf_request *req)
 {
@@ -34,6 +34,8 @@ struct nvmf_qpair_disconnect_ctx {
 	struct spdk_thread *thread;
 	void *ctx;
 	uint16_t qid;
+	/* IO accounting of the qpair, folded into the controller's */
+	struct spdk_nvmf_io_stat io_stat;
 };
 
 /*
@@ -350,6 +352,10 @@ _nvmf_tgt_destroy_next_transport(void *ctx)
 		pthread_mutex_destroy(&tgt->mutex);
 		free(tgt);
 
+		if (TAILQ_EMPTY(&g_nvmf_tgts)) {
+			nvmf_ptpl_worker_stop();
+		}
+
 		if (destroy_cb_fn) {
 			destroy_cb_fn(destroy_cb_arg, 0);
 		}
@@ -463,6 +469,7 @@ nvmf_write_subsystem_config_json(struct spdk_json_write_ctx *w,
 	const struct spdk_nvme_transport_id *trid;
 	struct spdk_nvmf_ns *ns;
 	struct spdk_nvmf_ns_opts ns_opts;
+	uint64_t qos_limits[SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES];
 	uint32_t max_namespaces;
 	char uuid_str[SPDK_UUID_STRING_LEN];
 
@@ -561,6 +568,34 @@ nvmf_write_subsystem_config_json(struct spdk_json_write_ctx *w,
 
 		/* } */
 		spdk_json_write_object_end(w);
+
+		if (ns->qos == NULL) {
+			continue;
+		}
+
+		spdk_nvmf_ns_get_qos_rate_limits(ns, qos_limits);
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "nvmf_subsystem_ns_set_qos_limit");
+
+		/*     "params" : { */
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "nqn", spdk_nvmf_subsystem_get_nqn(subsystem));
+		spdk_json_write_named_uint32(w, "nsid", spdk_nvmf_ns_get_id(ns));
+		spdk_json_write_named_uint64(w, "rw_ios_per_sec",
+					     qos_limits[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT]);
+		spdk_json_write_named_uint64(w, "rw_mbytes_per_sec",
+					     qos_limits[SPDK_NVMF_NS_QOS_RW_BPS_RATE_LIMIT]);
+		spdk_json_write_named_uint64(w, "r_mbytes_per_sec",
+					     qos_limits[SPDK_NVMF_NS_QOS_R_BPS_RATE_LIMIT]);
+		spdk_json_write_named_uint64(w, "w_mbytes_per_sec",
+					     qos_limits[SPDK_NVMF_NS_QOS_W_BPS_RATE_LIMIT]);
+
+		/*     } "params" */
+		spdk_json_write_object_end(w);
+
+		/* } */
+		spdk_json_write_object_end(w);
 	}
 
 	for (listener = spdk_nvmf_subsystem_get_first_listener(subsystem); listener != NULL;
@@ -935,6 +970,221 @@ spdk_nvmf_tgt_resume_polling(struct spdk_nvmf_tgt *tgt, spdk_nvmf_tgt_resume_pol
 	return 0;
 }
 
+/* Minimum gap between the most and the least loaded poll groups, in percent of
+ * the load of the former, for a qpair to be moved. */
+#define NVMF_TGT_REBALANCE_MIN_GAP_PCT 10
+
+struct nvmf_tgt_rebalance_ctx {
+	struct spdk_nvmf_tgt			*tgt;
+	struct spdk_thread			*thread;
+	spdk_nvmf_tgt_rebalance_qpairs_cb_fn	cb_fn;
+	void					*cb_arg;
+
+	struct spdk_nvmf_poll_group		*busiest;
+	struct spdk_nvmf_poll_group		*idlest;
+	uint64_t				busiest_load;
+	uint64_t				idlest_load;
+	bool					move;
+
+	/* The sample reset and the qpair move, if any */
+	int					pending;
+	int					status;
+};
+
+static void
+nvmf_tgt_rebalance_complete(struct nvmf_tgt_rebalance_ctx *ctx)
+{
+	assert(ctx->pending > 0);
+	if (--ctx->pending > 0) {
+		return;
+	}
+
+	ctx->tgt->rebalance_in_progress = false;
+	if (ctx->cb_fn) {
+		ctx->cb_fn(ctx->cb_arg, ctx->status);
+	}
+	free(ctx);
+}
+
+static void
+_nvmf_tgt_rebalance_migrate_done(void *_ctx)
+{
+	nvmf_tgt_rebalance_complete(_ctx);
+}
+
+static void
+nvmf_tgt_rebalance_migrate_done(void *_ctx, int status)
+{
+	struct nvmf_tgt_rebalance_ctx *ctx = _ctx;
+
+	/* Called on the thread of the poll group the qpair was moved from. The
+	 * rebalance can't complete before the message below is handled. */
+	if (status == 0) {
+		ctx->status = 1;
+	} else {
+		SPDK_ERRLOG("Failed to move a qpair while rebalancing: %s\n",
+			    spdk_strerror(-status));
+	}
+
+	spdk_thread_send_msg(ctx->thread, _nvmf_tgt_rebalance_migrate_done, ctx);
+}
+
+static inline uint64_t
+nvmf_qpair_get_load(struct spdk_nvmf_qpair *qpair)
+{
+	return qpair->completed_nvme_io - qpair->rebalance_nvme_io;
+}
+
+/* Pick the qpair whose load is the closest to half of the gap. Moving a qpair
+ * with a load at least as large as the gap wouldn't make things better. */
+static struct spdk_nvmf_qpair *
+nvmf_tgt_rebalance_pick_qpair(struct spdk_nvmf_poll_group *group, uint64_t gap)
+{
+	struct spdk_nvmf_qpair *qpair, *best = NULL;
+	uint64_t load, dist, best_dist = UINT64_MAX;
+
+	TAILQ_FOREACH(qpair, &group->qpairs, link) {
+		if (nvmf_qpair_is_admin_queue(qpair) || qpair->state != SPDK_NVMF_QPAIR_ACTIVE ||
+		    qpair->ctrlr == NULL || qpair->migrating ||
+		    !nvmf_transport_qpair_can_migrate(qpair)) {
+			continue;
+		}
+
+		load = nvmf_qpair_get_load(qpair);
+		if (load == 0 || load >= gap) {
+			continue;
+		}
+
+		dist = spdk_max(2 * load, gap) - spdk_min(2 * load, gap);
+		if (dist < best_dist) {
+			best = qpair;
+			best_dist = dist;
+		}
+	}
+
+	return best;
+}
+
+static void
+_nvmf_tgt_rebalance_reset_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct nvmf_tgt_rebalance_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	nvmf_tgt_rebalance_complete(ctx);
+}
+
+static void
+_nvmf_tgt_rebalance_reset(struct spdk_io_channel_iter *i)
+{
+	struct nvmf_tgt_rebalance_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_nvmf_poll_group *group = spdk_io_channel_get_ctx(ch);
+	struct spdk_nvmf_qpair *qpair;
+	int rc;
+
+	if (ctx->move && group == ctx->busiest) {
+		qpair = nvmf_tgt_rebalance_pick_qpair(group, ctx->busiest_load - ctx->idlest_load);
+		if (qpair != NULL) {
+			SPDK_NOTICELOG("Moving qpair %u of controller 0x%hx from %s to %s\n",
+				       qpair->qid, qpair->ctrlr->cntlid,
+				       spdk_thread_get_name(group->thread),
+				       spdk_thread_get_name(ctx->idlest->thread));
+			/* Accessed out of the target thread, but it can't complete before
+			 * this iteration is over. */
+			ctx->pending++;
+			rc = spdk_nvmf_poll_group_migrate_qpair(qpair, ctx->idlest,
+					nvmf_tgt_rebalance_migrate_done, ctx);
+			if (rc != 0) {
+				ctx->pending--;
+				SPDK_ERRLOG("Failed to move qpair %p: %s\n", qpair,
+					    spdk_strerror(-rc));
+			}
+		}
+	}
+
+	TAILQ_FOREACH(qpair, &group->qpairs, link) {
+		qpair->rebalance_nvme_io = qpair->completed_nvme_io;
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+_nvmf_tgt_rebalance_get_load_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct nvmf_tgt_rebalance_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	uint64_t gap;
+
+	if (ctx->busiest != ctx->idlest) {
+		gap = ctx->busiest_load - ctx->idlest_load;
+		ctx->move = gap > 0 &&
+			    gap * 100 >= ctx->busiest_load * NVMF_TGT_REBALANCE_MIN_GAP_PCT;
+	}
+
+	SPDK_DEBUGLOG(nvmf, "Rebalance: busiest load %" PRIu64 ", idlest load %" PRIu64 "\n",
+		      ctx->busiest_load, ctx->idlest_load);
+
+	spdk_for_each_channel(ctx->tgt,
+			      _nvmf_tgt_rebalance_reset,
+			      ctx,
+			      _nvmf_tgt_rebalance_reset_done);
+}
+
+static void
+_nvmf_tgt_rebalance_get_load(struct spdk_io_channel_iter *i)
+{
+	struct nvmf_tgt_rebalance_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_nvmf_poll_group *group = spdk_io_channel_get_ctx(ch);
+	struct spdk_nvmf_qpair *qpair;
+	uint64_t load = 0;
+
+	TAILQ_FOREACH(qpair, &group->qpairs, link) {
+		load += nvmf_qpair_get_load(qpair);
+	}
+
+	if (ctx->busiest == NULL || load > ctx->busiest_load) {
+		ctx->busiest = group;
+		ctx->busiest_load = load;
+	}
+	if (ctx->idlest == NULL || load < ctx->idlest_load) {
+		ctx->idlest = group;
+		ctx->idlest_load = load;
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+int
+spdk_nvmf_tgt_rebalance_qpairs(struct spdk_nvmf_tgt *tgt,
+			       spdk_nvmf_tgt_rebalance_qpairs_cb_fn cb_fn, void *cb_arg)
+{
+	struct nvmf_tgt_rebalance_ctx *ctx;
+
+	if (tgt->rebalance_in_progress || tgt->state != NVMF_TGT_RUNNING) {
+		return -EBUSY;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		return -ENOMEM;
+	}
+
+	tgt->rebalance_in_progress = true;
+
+	ctx->tgt = tgt;
+	ctx->thread = spdk_get_thread();
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->pending = 1;
+
+	spdk_for_each_channel(tgt,
+			      _nvmf_tgt_rebalance_get_load,
+			      ctx,
+			      _nvmf_tgt_rebalance_get_load_done);
+	return 0;
+}
+
 struct spdk_nvmf_subsystem *
 spdk_nvmf_tgt_find_subsystem(struct spdk_nvmf_tgt *tgt, const char *subnqn)
 {
@@ -1091,6 +1341,167 @@ spdk_nvmf_poll_group_add(struct spdk_nvmf_poll_group *group,
 	return rc;
 }
 
+struct nvmf_qpair_migrate_ctx {
+	struct spdk_nvmf_qpair				*qpair;
+	struct spdk_nvmf_poll_group			*group;
+	struct spdk_thread				*thread;
+	spdk_nvmf_poll_group_migrate_done_fn		cb_fn;
+	void						*cb_arg;
+	int						status;
+};
+
+static struct spdk_nvmf_transport_poll_group *
+nvmf_poll_group_get_tgroup(struct spdk_nvmf_poll_group *group,
+			   struct spdk_nvmf_transport *transport)
+{
+	struct spdk_nvmf_transport_poll_group *tgroup;
+
+	TAILQ_FOREACH(tgroup, &group->tgroups, link) {
+		if (tgroup->transport == transport) {
+			return tgroup;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+_nvmf_qpair_migrate_done(void *_ctx)
+{
+	struct nvmf_qpair_migrate_ctx *ctx = _ctx;
+
+	if (ctx->cb_fn) {
+		ctx->cb_fn(ctx->cb_arg, ctx->status);
+	}
+	free(ctx);
+}
+
+static void
+_nvmf_qpair_migrate_add(void *_ctx)
+{
+	struct nvmf_qpair_migrate_ctx *ctx = _ctx;
+	struct spdk_nvmf_qpair *qpair = ctx->qpair;
+	struct spdk_nvmf_poll_group *group = ctx->group;
+	struct spdk_nvmf_transport_poll_group *tgroup;
+	struct spdk_nvmf_ctrlr *ctrlr = qpair->ctrlr;
+	int rc;
+
+	tgroup = nvmf_poll_group_get_tgroup(group, qpair->transport);
+	assert(tgroup != NULL);
+
+	rc = nvmf_transport_poll_group_migrate(tgroup, qpair);
+
+	SPDK_DTRACE_PROBE2_TICKS(nvmf_poll_group_add_qpair, qpair,
+				 spdk_thread_get_id(group->thread));
+	TAILQ_INSERT_TAIL(&group->qpairs, qpair, link);
+	group->stat.current_io_qpairs++;
+	qpair->migrate_detached = false;
+	qpair->migrating = false;
+
+	if (rc != 0) {
+		SPDK_ERRLOG("Unable to add the qpair to the new poll group, disconnecting it.\n");
+		ctx->status = rc;
+		spdk_nvmf_qpair_disconnect(qpair, NULL, NULL);
+	} else if (ctrlr->disconnect_in_progress ||
+		   group->sgroups[ctrlr->subsys->id].state == SPDK_NVMF_SUBSYSTEM_INACTIVE) {
+		/* The qpair didn't belong to any poll group while its controller or
+		 * subsystem was being torn down, disconnect it now. */
+		ctx->status = -ECANCELED;
+		spdk_nvmf_qpair_disconnect(qpair, NULL, NULL);
+	}
+
+	spdk_thread_send_msg(ctx->thread, _nvmf_qpair_migrate_done, ctx);
+}
+
+static void
+nvmf_qpair_migrate_quiesced(void *_ctx, int status)
+{
+	struct nvmf_qpair_migrate_ctx *ctx = _ctx;
+	struct spdk_nvmf_qpair *qpair = ctx->qpair;
+	struct spdk_nvmf_poll_group *old_group = qpair->group;
+	struct spdk_nvmf_transport_poll_group *tgroup;
+	int rc;
+
+	if (status == 0 && qpair->state != SPDK_NVMF_QPAIR_ACTIVE) {
+		status = -ECANCELED;
+	}
+
+	if (status != 0) {
+		/* The qpair is being disconnected */
+		qpair->migrating = false;
+		ctx->status = status;
+		_nvmf_qpair_migrate_done(ctx);
+		return;
+	}
+
+	assert(TAILQ_EMPTY(&qpair->outstanding));
+	SPDK_DTRACE_PROBE2_TICKS(nvmf_poll_group_remove_qpair, qpair,
+				 spdk_thread_get_id(old_group->thread));
+
+	tgroup = nvmf_poll_group_get_tgroup(old_group, qpair->transport);
+	assert(tgroup != NULL);
+	rc = nvmf_transport_poll_group_remove(tgroup, qpair);
+	if (rc) {
+		SPDK_ERRLOG("Cannot remove qpair=%p from transport group=%p\n", qpair, tgroup);
+	}
+
+	TAILQ_REMOVE(&old_group->qpairs, qpair, link);
+	assert(old_group->stat.current_io_qpairs > 0);
+	old_group->stat.current_io_qpairs--;
+
+	/* From now on, disconnects are forwarded to the new poll group and held there
+	 * until the qpair is added to it. */
+	qpair->migrate_detached = true;
+	qpair->group = ctx->group;
+
+	spdk_thread_send_msg(ctx->group->thread, _nvmf_qpair_migrate_add, ctx);
+}
+
+int
+spdk_nvmf_poll_group_migrate_qpair(struct spdk_nvmf_qpair *qpair,
+				   struct spdk_nvmf_poll_group *group,
+				   spdk_nvmf_poll_group_migrate_done_fn cb_fn, void *cb_arg)
+{
+	struct nvmf_qpair_migrate_ctx *ctx;
+
+	assert(qpair->group != NULL);
+	assert(spdk_get_thread() == qpair->group->thread);
+
+	if (!nvmf_transport_qpair_can_migrate(qpair)) {
+		return -ENOTSUP;
+	}
+
+	if (nvmf_qpair_is_admin_queue(qpair) || group == qpair->group ||
+	    nvmf_poll_group_get_tgroup(group, qpair->transport) == NULL) {
+		return -EINVAL;
+	}
+
+	if (qpair->state != SPDK_NVMF_QPAIR_ACTIVE || qpair->ctrlr == NULL ||
+	    qpair->disconnect_started || qpair->migrating) {
+		return -EBUSY;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		return -ENOMEM;
+	}
+
+	ctx->qpair = qpair;
+	ctx->group = group;
+	ctx->thread = spdk_get_thread();
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	SPDK_DEBUGLOG(nvmf, "Move qpair %p (qid %u) from %s to %s\n", qpair, qpair->qid,
+		      spdk_thread_get_name(qpair->group->thread),
+		      spdk_thread_get_name(group->thread));
+
+	qpair->migrating = true;
+	nvmf_transport_qpair_quiesce(qpair, nvmf_qpair_migrate_quiesced, ctx);
+
+	return 0;
+}
+
 static void
 _nvmf_ctrlr_destruct(void *ctx)
 {
@@ -1106,6 +1517,7 @@ _nvmf_ctrlr_free_from_qpair(void *ctx)
 	struct spdk_nvmf_ctrlr *ctrlr = qpair_ctx->ctrlr;
 	uint32_t count;
 
+	nvmf_io_stat_add(&ctrlr->io_stat, &qpair_ctx->io_stat);
 	spdk_bit_array_clear(ctrlr->qpair_mask, qpair_ctx->qid);
 	count = spdk_bit_array_count_set(ctrlr->qpair_mask);
 	if (count == 0) {
@@ -1232,6 +1644,7 @@ _nvmf_qpair_destroy(void *ctx, int status)
 	}
 
 	qpair_ctx->ctrlr = ctrlr;
+	qpair_ctx->io_stat = qpair->io_stat;
 	spdk_nvmf_poll_group_remove(qpair);
 	nvmf_transport_qpair_fini(qpair, _nvmf_transport_qpair_fini_complete, qpair_ctx);
 }
@@ -1272,8 +1685,9 @@ spdk_nvmf_qpair_disconnect(struct spdk_nvmf_qpair *qpair, nvmf_qpair_disconnect_
 	}
 
 	assert(group != NULL);
-	if (spdk_get_thread() != group->thread) {
-		/* clear the atomic so we can set it on the next call on the proper thread. */
+	if (spdk_get_thread() != group->thread || spdk_unlikely(qpair->migrate_detached)) {
+		/* clear the atomic so we can set it on the next call on the proper thread.
+		 * A qpair being moved is disconnected once it's added to its new poll group. */
 		__atomic_clear(&qpair->disconnect_started, __ATOMIC_RELAXED);
 		qpair_ctx = calloc(1, sizeof(struct nvmf_qpair_disconnect_ctx));
 		if (!qpair_ctx) {
@@ -1806,6 +2220,11 @@ spdk_nvmf_poll_group_dump_stat(struct spdk_nvmf_poll_group *group, struct spdk_j
 	spdk_json_write_named_uint32(w, "current_io_qpairs", group->stat.current_io_qpairs);
 	spdk_json_write_named_uint64(w, "pending_bdev_io", group->stat.pending_bdev_io);
 	spdk_json_write_named_uint64(w, "completed_nvme_io", group->stat.completed_nvme_io);
+	spdk_json_write_named_uint64(w, "connects", group->stat.connects);
+	spdk_json_write_named_uint64(w, "failed_connects", group->stat.failed_connects);
+	spdk_json_write_named_uint64(w, "connect_latency_ticks", group->stat.connect_latency_ticks);
+	spdk_json_write_named_uint64(w, "max_connect_latency_ticks",
+				     group->stat.max_connect_latency_ticks);
 
 	spdk_json_write_named_array_begin(w, "transports");
 
@@ -71,6 +71,8 @@ struct spdk_nvmf_tgt {
 	uint16_t				crdt[3];
 	uint16_t				num_poll_groups;
 
+	bool					rebalance_in_progress;
+
 	TAILQ_ENTRY(spdk_nvmf_tgt)		link;
 };
 
@@ -125,6 +127,9 @@ struct spdk_nvmf_subsystem_pg_ns_info {
 	/* I/O outstanding to this namespace */
 	uint64_t			io_outstanding;
 	enum spdk_nvmf_subsystem_state	state;
+
+	/* I/O completed to this namespace by this poll group */
+	struct spdk_nvmf_io_stat	io_stat;
 };
 
 typedef void(*spdk_nvmf_poll_group_mod_done)(void *cb_arg, int status);
@@ -151,6 +156,21 @@ struct spdk_nvmf_registrant {
 	uint64_t rkey;
 };
 
+/*
+ * Rate limits of a namespace, shared by the poll groups of all its hosts. The budget of
+ * each timeslice is taken from atomically and may be overdrawn a bit by concurrent IO,
+ * which is accounted for in the next timeslice, like the bdev QoS does.
+ */
+struct spdk_nvmf_ns_qos {
+	/* Rate limits per second, in IOs or bytes, 0 if there's no limit */
+	uint64_t	limits[SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES];
+	/* IOs or bytes allowed in each timeslice, 0 if there's no limit */
+	uint64_t	max_per_timeslice[SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES];
+	int64_t		remaining_this_timeslice[SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES];
+	uint64_t	last_timeslice;
+	uint64_t	timeslice_size;
+};
+
 struct spdk_nvmf_ns {
 	uint32_t nsid;
 	uint32_t anagrpid;
@@ -174,10 +194,20 @@ struct spdk_nvmf_ns {
 	char *ptpl_file;
 	/* Persist Through Power Loss feature is enabled */
 	bool ptpl_activated;
+	/* Number of reservation changes to be written to ptpl_file */
+	uint64_t ptpl_updates;
+	/* Value of ptpl_updates when the last write of ptpl_file started */
+	uint64_t ptpl_updates_written;
+	/* Write of ptpl_file in progress, NULL if none */
+	struct nvmf_ns_ptpl_write *ptpl_write;
+	/* Reservation requests waiting for their change to be written to ptpl_file */
+	TAILQ_HEAD(, nvmf_ns_ptpl_waiter) ptpl_waiters;
 	/* ZCOPY supported on bdev device */
 	bool zcopy;
 	/* Command Set Identifier */
 	enum spdk_nvme_csi csi;
+	/* QoS rate limits, allocated once they are first set and kept until the ns is removed */
+	struct spdk_nvmf_ns_qos *qos;
 };
 
 /*
@@ -249,11 +279,20 @@ struct spdk_nvmf_ctrlr {
 	bool				acre_enabled;
 	bool				dynamic_ctrlr;
 
+	/* IO accounting of the IO qpairs of this controller that are already gone */
+	struct spdk_nvmf_io_stat	io_stat;
+
 	TAILQ_ENTRY(spdk_nvmf_ctrlr)	link;
+	LIST_ENTRY(spdk_nvmf_ctrlr)	hash_link;
 };
 
 #define NVMF_MAX_LISTENERS_PER_SUBSYSTEM	16
 
+/* Number of buckets of the hash of the controllers of a subsystem by cntlid, a power of 2 */
+#define NVMF_SUBSYSTEM_CTRLR_HASH_SIZE		1024
+
+LIST_HEAD(nvmf_ctrlr_hash_bucket, spdk_nvmf_ctrlr);
+
 struct spdk_nvmf_subsystem {
 	struct spdk_thread				*thread;
 
@@ -290,6 +329,8 @@ struct spdk_nvmf_subsystem {
 	uint16_t					max_cntlid;
 
 	TAILQ_HEAD(, spdk_nvmf_ctrlr)			ctrlrs;
+	/* Controllers hashed by cntlid, so that CONNECTs don't have to walk the list */
+	struct nvmf_ctrlr_hash_bucket			ctrlr_hash[NVMF_SUBSYSTEM_CTRLR_HASH_SIZE];
 
 	/* A mutex used to protect the hosts list and allow_any_host flag. Unlike the namespace
 	 * array, this list is not used on the I/O path (it's needed for handling things like
@@ -344,6 +385,14 @@ bool nvmf_ctrlr_copy_supported(struct spdk_nvmf_ctrlr *ctrlr);
 void nvmf_ctrlr_ns_changed(struct spdk_nvmf_ctrlr *ctrlr, uint32_t nsid);
 bool nvmf_ctrlr_use_zcopy(struct spdk_nvmf_request *req);
 
+/*
+ * Check the QoS rate limits of the namespace a read or a write is for. The transports call
+ * this before allocating any data buffer or starting any data transfer for the request, and
+ * retry it later as long as it returns false. Once it returns true, the request is accounted
+ * against the limits. Requests that can't be held back are accounted with force set.
+ */
+bool nvmf_request_qos_admit(struct spdk_nvmf_request *req, bool force);
+
 void nvmf_bdev_ctrlr_identify_ns(struct spdk_nvmf_ns *ns, struct spdk_nvme_ns_data *nsdata,
 				 bool dif_insert_or_strip);
 int nvmf_bdev_ctrlr_read_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
@@ -413,6 +462,8 @@ void nvmf_ctrlr_async_event_discovery_log_change_notice(void *ctx);
 void nvmf_ctrlr_async_event_reservation_notification(struct spdk_nvmf_ctrlr *ctrlr);
 
 void nvmf_ns_reservation_request(void *ctx);
+/* Stop the thread writing reservation changes to PTPL files, once its queued writes are done */
+void nvmf_ptpl_worker_stop(void);
 void nvmf_ctrlr_reservation_notice_log(struct spdk_nvmf_ctrlr *ctrlr,
 				       struct spdk_nvmf_ns *ns,
 				       enum spdk_nvme_reservation_notification_log_page_type type);
@@ -455,6 +506,20 @@ nvmf_qpair_is_admin_queue(struct spdk_nvmf_qpair *qpair)
 	return qpair->qid == 0;
 }
 
+static inline void
+nvmf_io_stat_add(struct spdk_nvmf_io_stat *dst, const struct spdk_nvmf_io_stat *src)
+{
+	dst->bytes_read += src->bytes_read;
+	dst->num_read_ops += src->num_read_ops;
+	dst->bytes_written += src->bytes_written;
+	dst->num_write_ops += src->num_write_ops;
+	dst->num_other_ops += src->num_other_ops;
+	dst->num_errors += src->num_errors;
+	dst->read_latency_ticks += src->read_latency_ticks;
+	dst->write_latency_ticks += src->write_latency_ticks;
+	dst->other_latency_ticks += src->other_latency_ticks;
+}
+
 /**
  * Initiates a zcopy start operation
  *
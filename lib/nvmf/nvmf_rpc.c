@@ -157,32 +157,97 @@ decode_ns_uuid(const struct spdk_json_val *val, void *out)
 	return rc;
 }
 
+#define RPC_GET_SUBSYSTEM_MAX_FIELDS 16
+
 struct rpc_get_subsystem {
 	char *nqn;
 	char *tgt_name;
+	char *start_after;
+	uint64_t max_count;
+	size_t num_fields;
+	char *fields[RPC_GET_SUBSYSTEM_MAX_FIELDS];
 };
 
+static int
+decode_rpc_get_subsystem_field(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_string(val, out);
+}
+
+static int
+decode_rpc_get_subsystem_fields(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_get_subsystem *req = SPDK_CONTAINEROF(out, struct rpc_get_subsystem, fields);
+
+	return spdk_json_decode_array(val, decode_rpc_get_subsystem_field, req->fields,
+				      RPC_GET_SUBSYSTEM_MAX_FIELDS, &req->num_fields, sizeof(char *));
+}
+
 static const struct spdk_json_object_decoder rpc_get_subsystem_decoders[] = {
 	{"nqn", offsetof(struct rpc_get_subsystem, nqn), spdk_json_decode_string, true},
 	{"tgt_name", offsetof(struct rpc_get_subsystem, tgt_name), spdk_json_decode_string, true},
+	{"start_after", offsetof(struct rpc_get_subsystem, start_after), spdk_json_decode_string, true},
+	{"max_count", offsetof(struct rpc_get_subsystem, max_count), spdk_json_decode_uint64, true},
+	{"fields", offsetof(struct rpc_get_subsystem, fields), decode_rpc_get_subsystem_fields, true},
 };
 
 static void
-dump_nvmf_subsystem(struct spdk_json_write_ctx *w, struct spdk_nvmf_subsystem *subsystem)
+free_rpc_get_subsystem(struct rpc_get_subsystem *req)
 {
-	struct spdk_nvmf_host			*host;
-	struct spdk_nvmf_subsystem_listener	*listener;
+	size_t i;
 
-	spdk_json_write_object_begin(w);
+	free(req->nqn);
+	free(req->tgt_name);
+	free(req->start_after);
+	for (i = 0; i < req->num_fields; i++) {
+		free(req->fields[i]);
+	}
+}
 
-	spdk_json_write_named_string(w, "nqn", spdk_nvmf_subsystem_get_nqn(subsystem));
-	spdk_json_write_name(w, "subtype");
-	if (spdk_nvmf_subsystem_get_type(subsystem) == SPDK_NVMF_SUBTYPE_NVME) {
-		spdk_json_write_string(w, "NVMe");
-	} else {
-		spdk_json_write_string(w, "Discovery");
+/* Check whether a key was requested through the "fields" parameter (all keys are if it's empty) */
+static bool
+rpc_get_subsystem_field(const struct rpc_get_subsystem *req, const char *key)
+{
+	size_t i;
+
+	if (req->num_fields == 0) {
+		return true;
+	}
+
+	for (i = 0; i < req->num_fields; i++) {
+		if (strcmp(req->fields[i], key) == 0) {
+			return true;
+		}
 	}
 
+	return false;
+}
+
+static void
+dump_nvmf_ns_qos(struct spdk_json_write_ctx *w, struct spdk_nvmf_ns *ns)
+{
+	uint64_t limits[SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES];
+
+	spdk_nvmf_ns_get_qos_rate_limits(ns, limits);
+
+	spdk_json_write_named_object_begin(w, "qos");
+	spdk_json_write_named_uint64(w, "rw_ios_per_sec",
+				     limits[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT]);
+	spdk_json_write_named_uint64(w, "rw_mbytes_per_sec",
+				     limits[SPDK_NVMF_NS_QOS_RW_BPS_RATE_LIMIT]);
+	spdk_json_write_named_uint64(w, "r_mbytes_per_sec",
+				     limits[SPDK_NVMF_NS_QOS_R_BPS_RATE_LIMIT]);
+	spdk_json_write_named_uint64(w, "w_mbytes_per_sec",
+				     limits[SPDK_NVMF_NS_QOS_W_BPS_RATE_LIMIT]);
+	spdk_json_write_object_end(w);
+}
+
+static void
+dump_nvmf_subsystem_listen_addresses(struct spdk_json_write_ctx *w,
+				     struct spdk_nvmf_subsystem *subsystem)
+{
+	struct spdk_nvmf_subsystem_listener *listener;
+
 	spdk_json_write_named_array_begin(w, "listen_addresses");
 
 	for (listener = spdk_nvmf_subsystem_get_first_listener(subsystem); listener != NULL;
@@ -206,73 +271,122 @@ dump_nvmf_subsystem(struct spdk_json_write_ctx *w, struct spdk_nvmf_subsystem *s
 		spdk_json_write_object_end(w);
 	}
 	spdk_json_write_array_end(w);
+}
 
-	spdk_json_write_named_bool(w, "allow_any_host",
-				   spdk_nvmf_subsystem_get_allow_any_host(subsystem));
-
-	spdk_json_write_named_array_begin(w, "hosts");
+static void
+dump_nvmf_subsystem_namespaces(struct spdk_json_write_ctx *w,
+			       struct spdk_nvmf_subsystem *subsystem)
+{
+	struct spdk_nvmf_ns *ns;
+	struct spdk_nvmf_ns_opts ns_opts;
 
-	for (host = spdk_nvmf_subsystem_get_first_host(subsystem); host != NULL;
-	     host = spdk_nvmf_subsystem_get_next_host(subsystem, host)) {
+	spdk_json_write_named_array_begin(w, "namespaces");
+	for (ns = spdk_nvmf_subsystem_get_first_ns(subsystem); ns != NULL;
+	     ns = spdk_nvmf_subsystem_get_next_ns(subsystem, ns)) {
+		spdk_nvmf_ns_get_opts(ns, &ns_opts, sizeof(ns_opts));
 		spdk_json_write_object_begin(w);
-		spdk_json_write_named_string(w, "nqn", spdk_nvmf_host_get_nqn(host));
+		spdk_json_write_named_int32(w, "nsid", spdk_nvmf_ns_get_id(ns));
+		spdk_json_write_named_string(w, "bdev_name",
+					     spdk_bdev_get_name(spdk_nvmf_ns_get_bdev(ns)));
+		/* NOTE: "name" is kept for compatibility only - new code should use bdev_name. */
+		spdk_json_write_named_string(w, "name",
+					     spdk_bdev_get_name(spdk_nvmf_ns_get_bdev(ns)));
+
+		if (!spdk_mem_all_zero(ns_opts.nguid, sizeof(ns_opts.nguid))) {
+			spdk_json_write_name(w, "nguid");
+			json_write_hex_str(w, ns_opts.nguid, sizeof(ns_opts.nguid));
+		}
+
+		if (!spdk_mem_all_zero(ns_opts.eui64, sizeof(ns_opts.eui64))) {
+			spdk_json_write_name(w, "eui64");
+			json_write_hex_str(w, ns_opts.eui64, sizeof(ns_opts.eui64));
+		}
+
+		if (!spdk_uuid_is_null(&ns_opts.uuid)) {
+			char uuid_str[SPDK_UUID_STRING_LEN];
+
+			spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &ns_opts.uuid);
+			spdk_json_write_named_string(w, "uuid", uuid_str);
+		}
+
+		if (nvmf_subsystem_get_ana_reporting(subsystem)) {
+			spdk_json_write_named_uint32(w, "anagrpid", ns_opts.anagrpid);
+		}
+
+		if (ns->qos != NULL) {
+			dump_nvmf_ns_qos(w, ns);
+		}
+
 		spdk_json_write_object_end(w);
 	}
 	spdk_json_write_array_end(w);
+}
 
-	if (spdk_nvmf_subsystem_get_type(subsystem) == SPDK_NVMF_SUBTYPE_NVME) {
-		struct spdk_nvmf_ns *ns;
-		struct spdk_nvmf_ns_opts ns_opts;
-		uint32_t max_namespaces;
-
-		spdk_json_write_named_string(w, "serial_number", spdk_nvmf_subsystem_get_sn(subsystem));
+static void
+dump_nvmf_subsystem(struct spdk_json_write_ctx *w, struct spdk_nvmf_subsystem *subsystem,
+		    const struct rpc_get_subsystem *req)
+{
+	struct spdk_nvmf_host *host;
 
-		spdk_json_write_named_string(w, "model_number", spdk_nvmf_subsystem_get_mn(subsystem));
+	spdk_json_write_object_begin(w);
 
-		max_namespaces = spdk_nvmf_subsystem_get_max_namespaces(subsystem);
-		if (max_namespaces != 0) {
-			spdk_json_write_named_uint32(w, "max_namespaces", max_namespaces);
+	spdk_json_write_named_string(w, "nqn", spdk_nvmf_subsystem_get_nqn(subsystem));
+	if (rpc_get_subsystem_field(req, "subtype")) {
+		spdk_json_write_name(w, "subtype");
+		if (spdk_nvmf_subsystem_get_type(subsystem) == SPDK_NVMF_SUBTYPE_NVME) {
+			spdk_json_write_string(w, "NVMe");
+		} else {
+			spdk_json_write_string(w, "Discovery");
 		}
+	}
 
-		spdk_json_write_named_uint32(w, "min_cntlid", spdk_nvmf_subsystem_get_min_cntlid(subsystem));
-		spdk_json_write_named_uint32(w, "max_cntlid", spdk_nvmf_subsystem_get_max_cntlid(subsystem));
+	if (rpc_get_subsystem_field(req, "listen_addresses")) {
+		dump_nvmf_subsystem_listen_addresses(w, subsystem);
+	}
 
-		spdk_json_write_named_array_begin(w, "namespaces");
-		for (ns = spdk_nvmf_subsystem_get_first_ns(subsystem); ns != NULL;
-		     ns = spdk_nvmf_subsystem_get_next_ns(subsystem, ns)) {
-			spdk_nvmf_ns_get_opts(ns, &ns_opts, sizeof(ns_opts));
+	if (rpc_get_subsystem_field(req, "allow_any_host")) {
+		spdk_json_write_named_bool(w, "allow_any_host",
+					   spdk_nvmf_subsystem_get_allow_any_host(subsystem));
+	}
+
+	if (rpc_get_subsystem_field(req, "hosts")) {
+		spdk_json_write_named_array_begin(w, "hosts");
+
+		for (host = spdk_nvmf_subsystem_get_first_host(subsystem); host != NULL;
+		     host = spdk_nvmf_subsystem_get_next_host(subsystem, host)) {
 			spdk_json_write_object_begin(w);
-			spdk_json_write_named_int32(w, "nsid", spdk_nvmf_ns_get_id(ns));
-			spdk_json_write_named_string(w, "bdev_name",
-						     spdk_bdev_get_name(spdk_nvmf_ns_get_bdev(ns)));
-			/* NOTE: "name" is kept for compatibility only - new code should use bdev_name. */
-			spdk_json_write_named_string(w, "name",
-						     spdk_bdev_get_name(spdk_nvmf_ns_get_bdev(ns)));
-
-			if (!spdk_mem_all_zero(ns_opts.nguid, sizeof(ns_opts.nguid))) {
-				spdk_json_write_name(w, "nguid");
-				json_write_hex_str(w, ns_opts.nguid, sizeof(ns_opts.nguid));
-			}
+			spdk_json_write_named_string(w, "nqn", spdk_nvmf_host_get_nqn(host));
+			spdk_json_write_object_end(w);
+		}
+		spdk_json_write_array_end(w);
+	}
 
-			if (!spdk_mem_all_zero(ns_opts.eui64, sizeof(ns_opts.eui64))) {
-				spdk_json_write_name(w, "eui64");
-				json_write_hex_str(w, ns_opts.eui64, sizeof(ns_opts.eui64));
-			}
+	if (spdk_nvmf_subsystem_get_type(subsystem) == SPDK_NVMF_SUBTYPE_NVME) {
+		uint32_t max_namespaces;
+
+		if (rpc_get_subsystem_field(req, "serial_number")) {
+			spdk_json_write_named_string(w, "serial_number", spdk_nvmf_subsystem_get_sn(subsystem));
+		}
 
-			if (!spdk_uuid_is_null(&ns_opts.uuid)) {
-				char uuid_str[SPDK_UUID_STRING_LEN];
+		if (rpc_get_subsystem_field(req, "model_number")) {
+			spdk_json_write_named_string(w, "model_number", spdk_nvmf_subsystem_get_mn(subsystem));
+		}
 
-				spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &ns_opts.uuid);
-				spdk_json_write_named_string(w, "uuid", uuid_str);
-			}
+		max_namespaces = spdk_nvmf_subsystem_get_max_namespaces(subsystem);
+		if (max_namespaces != 0 && rpc_get_subsystem_field(req, "max_namespaces")) {
+			spdk_json_write_named_uint32(w, "max_namespaces", max_namespaces);
+		}
 
-			if (nvmf_subsystem_get_ana_reporting(subsystem)) {
-				spdk_json_write_named_uint32(w, "anagrpid", ns_opts.anagrpid);
-			}
+		if (rpc_get_subsystem_field(req, "min_cntlid")) {
+			spdk_json_write_named_uint32(w, "min_cntlid", spdk_nvmf_subsystem_get_min_cntlid(subsystem));
+		}
+		if (rpc_get_subsystem_field(req, "max_cntlid")) {
+			spdk_json_write_named_uint32(w, "max_cntlid", spdk_nvmf_subsystem_get_max_cntlid(subsystem));
+		}
 
-			spdk_json_write_object_end(w);
+		if (rpc_get_subsystem_field(req, "namespaces")) {
+			dump_nvmf_subsystem_namespaces(w, subsystem);
 		}
-		spdk_json_write_array_end(w);
 	}
 	spdk_json_write_object_end(w);
 }
@@ -285,6 +399,7 @@ rpc_nvmf_get_subsystems(struct spdk_jsonrpc_request *request,
 	struct spdk_json_write_ctx *w;
 	struct spdk_nvmf_subsystem *subsystem = NULL;
 	struct spdk_nvmf_tgt *tgt;
+	uint64_t count = 0;
 
 	if (params) {
 		if (spdk_json_decode_object(params, rpc_get_subsystem_decoders,
@@ -292,26 +407,32 @@ rpc_nvmf_get_subsystems(struct spdk_jsonrpc_request *request,
 					    &req)) {
 			SPDK_ERRLOG("spdk_json_decode_object failed\n");
 			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS, "Invalid parameters");
+			free_rpc_get_subsystem(&req);
 			return;
 		}
 	}
 
+	if (req.nqn && (req.start_after || req.max_count)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "nqn cannot be combined with start_after or max_count");
+		free_rpc_get_subsystem(&req);
+		return;
+	}
+
 	tgt = spdk_nvmf_get_tgt(req.tgt_name);
 	if (!tgt) {
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
 						 "Unable to find a target.");
-		free(req.tgt_name);
-		free(req.nqn);
+		free_rpc_get_subsystem(&req);
 		return;
 	}
 
-	if (req.nqn) {
-		subsystem = spdk_nvmf_tgt_find_subsystem(tgt, req.nqn);
+	if (req.nqn || req.start_after) {
+		subsystem = spdk_nvmf_tgt_find_subsystem(tgt, req.nqn ? req.nqn : req.start_after);
 		if (!subsystem) {
-			SPDK_ERRLOG("subsystem '%s' does not exist\n", req.nqn);
+			SPDK_ERRLOG("subsystem '%s' does not exist\n", req.nqn ? req.nqn : req.start_after);
 			spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
-			free(req.tgt_name);
-			free(req.nqn);
+			free_rpc_get_subsystem(&req);
 			return;
 		}
 	}
@@ -319,19 +440,22 @@ rpc_nvmf_get_subsystems(struct spdk_jsonrpc_request *request,
 	w = spdk_jsonrpc_begin_result(request);
 	spdk_json_write_array_begin(w);
 
-	if (subsystem) {
-		dump_nvmf_subsystem(w, subsystem);
+	if (req.nqn) {
+		dump_nvmf_subsystem(w, subsystem, &req);
 	} else {
-		for (subsystem = spdk_nvmf_subsystem_get_first(tgt); subsystem != NULL;
-		     subsystem = spdk_nvmf_subsystem_get_next(subsystem)) {
-			dump_nvmf_subsystem(w, subsystem);
+		/* Subsystems are iterated in subsystem ID order, so the listing can be resumed
+		 * right after the last subsystem of the previous page */
+		subsystem = subsystem ? spdk_nvmf_subsystem_get_next(subsystem) :
+			    spdk_nvmf_subsystem_get_first(tgt);
+		for (; subsystem != NULL && (req.max_count == 0 || count < req.max_count);
+		     subsystem = spdk_nvmf_subsystem_get_next(subsystem), count++) {
+			dump_nvmf_subsystem(w, subsystem, &req);
 		}
 	}
 
 	spdk_json_write_array_end(w);
 	spdk_jsonrpc_end_result(request, w);
-	free(req.tgt_name);
-	free(req.nqn);
+	free_rpc_get_subsystem(&req);
 }
 SPDK_RPC_REGISTER("nvmf_get_subsystems", rpc_nvmf_get_subsystems, SPDK_RPC_RUNTIME)
 
@@ -2181,6 +2305,85 @@ rpc_nvmf_get_stats(struct spdk_jsonrpc_request *request,
 
 SPDK_RPC_REGISTER("nvmf_get_stats", rpc_nvmf_get_stats, SPDK_RPC_RUNTIME)
 
+struct rpc_nvmf_rebalance_qpairs_ctx {
+	char *tgt_name;
+	struct spdk_jsonrpc_request *request;
+};
+
+static const struct spdk_json_object_decoder rpc_rebalance_qpairs_decoders[] = {
+	{"tgt_name", offsetof(struct rpc_nvmf_rebalance_qpairs_ctx, tgt_name),
+	 spdk_json_decode_string, true},
+};
+
+static void
+free_rebalance_qpairs_ctx(struct rpc_nvmf_rebalance_qpairs_ctx *ctx)
+{
+	free(ctx->tgt_name);
+	free(ctx);
+}
+
+static void
+rpc_nvmf_rebalance_qpairs_done(void *cb_arg, int status)
+{
+	struct rpc_nvmf_rebalance_qpairs_ctx *ctx = cb_arg;
+	struct spdk_json_write_ctx *w;
+
+	if (status < 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, status, spdk_strerror(-status));
+	} else {
+		w = spdk_jsonrpc_begin_result(ctx->request);
+		spdk_json_write_int32(w, status);
+		spdk_jsonrpc_end_result(ctx->request, w);
+	}
+
+	free_rebalance_qpairs_ctx(ctx);
+}
+
+static void
+rpc_nvmf_rebalance_qpairs(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct rpc_nvmf_rebalance_qpairs_ctx *ctx;
+	struct spdk_nvmf_tgt *tgt;
+	int rc;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Memory allocation error");
+		return;
+	}
+	ctx->request = request;
+
+	if (params) {
+		if (spdk_json_decode_object(params, rpc_rebalance_qpairs_decoders,
+					    SPDK_COUNTOF(rpc_rebalance_qpairs_decoders),
+					    ctx)) {
+			SPDK_ERRLOG("spdk_json_decode_object failed\n");
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+							 "Invalid parameters");
+			free_rebalance_qpairs_ctx(ctx);
+			return;
+		}
+	}
+
+	tgt = spdk_nvmf_get_tgt(ctx->tgt_name);
+	if (!tgt) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target.");
+		free_rebalance_qpairs_ctx(ctx);
+		return;
+	}
+
+	rc = spdk_nvmf_tgt_rebalance_qpairs(tgt, rpc_nvmf_rebalance_qpairs_done, ctx);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		free_rebalance_qpairs_ctx(ctx);
+	}
+}
+
+SPDK_RPC_REGISTER("nvmf_rebalance_qpairs", rpc_nvmf_rebalance_qpairs, SPDK_RPC_RUNTIME)
+
 static void
 dump_nvmf_ctrlr(struct spdk_json_write_ctx *w, struct spdk_nvmf_ctrlr *ctrlr)
 {
@@ -2229,6 +2432,8 @@ dump_nvmf_qpair(struct spdk_json_write_ctx *w, struct spdk_nvmf_qpair *qpair)
 	spdk_json_write_named_uint32(w, "cntlid", qpair->ctrlr->cntlid);
 	spdk_json_write_named_uint32(w, "qid", qpair->qid);
 	spdk_json_write_named_string(w, "state", nvmf_qpair_state_str(qpair->state));
+	/* The same name as the poll group in nvmf_get_stats */
+	spdk_json_write_named_string(w, "thread", spdk_thread_get_name(qpair->group->thread));
 
 	if (spdk_nvmf_qpair_get_listen_trid(qpair, &listen_trid) == 0) {
 		nvmf_transport_listen_dump_opts(qpair->transport, &listen_trid, w);
@@ -2501,3 +2706,366 @@ rpc_nvmf_subsystem_get_listeners(struct spdk_jsonrpc_request *request,
 }
 SPDK_RPC_REGISTER("nvmf_subsystem_get_listeners", rpc_nvmf_subsystem_get_listeners,
 		  SPDK_RPC_RUNTIME);
+
+struct rpc_nvmf_host_io_stat {
+	uint16_t			cntlid;
+	char				hostnqn[SPDK_NVMF_NQN_MAX_LEN + 1];
+	struct spdk_nvmf_io_stat	stat;
+};
+
+struct rpc_nvmf_ns_io_stat {
+	/* 0 if there was no namespace when the RPC was received */
+	uint32_t			nsid;
+	struct spdk_nvmf_io_stat	stat;
+};
+
+struct rpc_nvmf_get_io_stats_ctx {
+	char				*nqn;
+	char				*tgt_name;
+	struct spdk_jsonrpc_request	*request;
+	/* The subsystem is only compared against, it may go away while iterating */
+	struct spdk_nvmf_subsystem	*subsystem;
+	uint32_t			subsystem_id;
+	/* Indexed by nsid - 1 */
+	struct rpc_nvmf_ns_io_stat	*ns_stats;
+	uint32_t			num_ns;
+	struct rpc_nvmf_host_io_stat	*hosts;
+	uint32_t			num_hosts;
+};
+
+static const struct spdk_json_object_decoder rpc_nvmf_get_io_stats_decoders[] = {
+	{"nqn", offsetof(struct rpc_nvmf_get_io_stats_ctx, nqn), spdk_json_decode_string},
+	{"tgt_name", offsetof(struct rpc_nvmf_get_io_stats_ctx, tgt_name), spdk_json_decode_string,
+	 true},
+};
+
+static void
+free_rpc_nvmf_get_io_stats_ctx(struct rpc_nvmf_get_io_stats_ctx *ctx)
+{
+	free(ctx->nqn);
+	free(ctx->tgt_name);
+	free(ctx->ns_stats);
+	free(ctx->hosts);
+	free(ctx);
+}
+
+static struct spdk_nvmf_io_stat *
+rpc_nvmf_get_host_io_stat(struct rpc_nvmf_get_io_stats_ctx *ctx, struct spdk_nvmf_ctrlr *ctrlr)
+{
+	struct rpc_nvmf_host_io_stat *hosts, *host;
+	uint32_t i;
+
+	for (i = 0; i < ctx->num_hosts; i++) {
+		if (ctx->hosts[i].cntlid == ctrlr->cntlid) {
+			return &ctx->hosts[i].stat;
+		}
+	}
+
+	hosts = realloc(ctx->hosts, (ctx->num_hosts + 1) * sizeof(*hosts));
+	if (hosts == NULL) {
+		return NULL;
+	}
+	ctx->hosts = hosts;
+
+	host = &hosts[ctx->num_hosts++];
+	memset(host, 0, sizeof(*host));
+	host->cntlid = ctrlr->cntlid;
+	snprintf(host->hostnqn, sizeof(host->hostnqn), "%s", ctrlr->hostnqn);
+
+	return &host->stat;
+}
+
+static void
+dump_nvmf_io_stat(struct spdk_json_write_ctx *w, const struct spdk_nvmf_io_stat *stat)
+{
+	spdk_json_write_named_uint64(w, "bytes_read", stat->bytes_read);
+	spdk_json_write_named_uint64(w, "num_read_ops", stat->num_read_ops);
+	spdk_json_write_named_uint64(w, "bytes_written", stat->bytes_written);
+	spdk_json_write_named_uint64(w, "num_write_ops", stat->num_write_ops);
+	spdk_json_write_named_uint64(w, "num_other_ops", stat->num_other_ops);
+	spdk_json_write_named_uint64(w, "num_errors", stat->num_errors);
+	spdk_json_write_named_uint64(w, "read_latency_ticks", stat->read_latency_ticks);
+	spdk_json_write_named_uint64(w, "write_latency_ticks", stat->write_latency_ticks);
+	spdk_json_write_named_uint64(w, "other_latency_ticks", stat->other_latency_ticks);
+}
+
+static void
+rpc_nvmf_get_io_stats_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct rpc_nvmf_get_io_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_json_write_ctx *w;
+	uint32_t idx;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(ctx->request, status, spdk_strerror(-status));
+		free_rpc_nvmf_get_io_stats_ctx(ctx);
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(ctx->request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "tick_rate", spdk_get_ticks_hz());
+
+	spdk_json_write_named_array_begin(w, "namespaces");
+	for (idx = 0; idx < ctx->num_ns; idx++) {
+		if (ctx->ns_stats[idx].nsid == 0) {
+			continue;
+		}
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "nsid", ctx->ns_stats[idx].nsid);
+		dump_nvmf_io_stat(w, &ctx->ns_stats[idx].stat);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_named_array_begin(w, "hosts");
+	for (idx = 0; idx < ctx->num_hosts; idx++) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "cntlid", ctx->hosts[idx].cntlid);
+		spdk_json_write_named_string(w, "hostnqn", ctx->hosts[idx].hostnqn);
+		dump_nvmf_io_stat(w, &ctx->hosts[idx].stat);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(ctx->request, w);
+
+	free_rpc_nvmf_get_io_stats_ctx(ctx);
+}
+
+static void
+rpc_nvmf_get_io_stats(struct spdk_io_channel_iter *i)
+{
+	struct rpc_nvmf_get_io_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_nvmf_poll_group *group;
+	struct spdk_nvmf_subsystem_poll_group *sgroup;
+	struct spdk_nvmf_qpair *qpair;
+	struct spdk_nvmf_io_stat *stat;
+	uint32_t idx;
+
+	group = spdk_io_channel_get_ctx(spdk_io_channel_iter_get_channel(i));
+
+	if (ctx->subsystem_id < group->num_sgroups) {
+		sgroup = &group->sgroups[ctx->subsystem_id];
+		for (idx = 0; idx < spdk_min(sgroup->num_ns, ctx->num_ns); idx++) {
+			nvmf_io_stat_add(&ctx->ns_stats[idx].stat, &sgroup->ns_info[idx].io_stat);
+		}
+	}
+
+	TAILQ_FOREACH(qpair, &group->qpairs, link) {
+		if (qpair->ctrlr == NULL || qpair->ctrlr->subsys != ctx->subsystem) {
+			continue;
+		}
+
+		stat = rpc_nvmf_get_host_io_stat(ctx, qpair->ctrlr);
+		if (stat == NULL) {
+			spdk_for_each_channel_continue(i, -ENOMEM);
+			return;
+		}
+
+		if (nvmf_qpair_is_admin_queue(qpair)) {
+			/* The admin qpair runs on the controller's thread, so it's safe to pick
+			 * up the IO accounting of its IO qpairs that are already gone. */
+			nvmf_io_stat_add(stat, &qpair->ctrlr->io_stat);
+		} else {
+			nvmf_io_stat_add(stat, &qpair->io_stat);
+		}
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+rpc_nvmf_subsystem_get_io_stats(struct spdk_jsonrpc_request *request,
+				const struct spdk_json_val *params)
+{
+	struct rpc_nvmf_get_io_stats_ctx *ctx;
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_ns *ns;
+	struct spdk_nvmf_tgt *tgt;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Out of memory");
+		return;
+	}
+
+	ctx->request = request;
+
+	if (spdk_json_decode_object(params, rpc_nvmf_get_io_stats_decoders,
+				    SPDK_COUNTOF(rpc_nvmf_get_io_stats_decoders),
+				    ctx)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		free_rpc_nvmf_get_io_stats_ctx(ctx);
+		return;
+	}
+
+	tgt = spdk_nvmf_get_tgt(ctx->tgt_name);
+	if (!tgt) {
+		SPDK_ERRLOG("Unable to find a target object.\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target");
+		free_rpc_nvmf_get_io_stats_ctx(ctx);
+		return;
+	}
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, ctx->nqn);
+	if (!subsystem) {
+		SPDK_ERRLOG("Unable to find subsystem with NQN %s\n", ctx->nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		free_rpc_nvmf_get_io_stats_ctx(ctx);
+		return;
+	}
+
+	ctx->subsystem = subsystem;
+	ctx->subsystem_id = subsystem->id;
+	ctx->num_ns = subsystem->max_nsid;
+	if (ctx->num_ns > 0) {
+		ctx->ns_stats = calloc(ctx->num_ns, sizeof(*ctx->ns_stats));
+		if (!ctx->ns_stats) {
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+							 "Out of memory");
+			free_rpc_nvmf_get_io_stats_ctx(ctx);
+			return;
+		}
+	}
+
+	for (ns = spdk_nvmf_subsystem_get_first_ns(subsystem); ns != NULL;
+	     ns = spdk_nvmf_subsystem_get_next_ns(subsystem, ns)) {
+		ctx->ns_stats[ns->nsid - 1].nsid = ns->nsid;
+	}
+
+	/* The counters are read without pausing the subsystem, so that monitoring
+	 * doesn't get in the way of the IO. */
+	spdk_for_each_channel(tgt, rpc_nvmf_get_io_stats, ctx, rpc_nvmf_get_io_stats_done);
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_get_io_stats", rpc_nvmf_subsystem_get_io_stats,
+		  SPDK_RPC_RUNTIME);
+
+struct rpc_nvmf_ns_set_qos_limit {
+	char *nqn;
+	char *tgt_name;
+	uint32_t nsid;
+	uint64_t limits[SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES];
+};
+
+static void
+free_rpc_nvmf_ns_set_qos_limit(struct rpc_nvmf_ns_set_qos_limit *r)
+{
+	free(r->nqn);
+	free(r->tgt_name);
+}
+
+static const struct spdk_json_object_decoder rpc_nvmf_ns_set_qos_limit_decoders[] = {
+	{"nqn", offsetof(struct rpc_nvmf_ns_set_qos_limit, nqn), spdk_json_decode_string},
+	{"nsid", offsetof(struct rpc_nvmf_ns_set_qos_limit, nsid), spdk_json_decode_uint32},
+	{
+		"tgt_name", offsetof(struct rpc_nvmf_ns_set_qos_limit, tgt_name),
+		spdk_json_decode_string, true
+	},
+	{
+		"rw_ios_per_sec", offsetof(struct rpc_nvmf_ns_set_qos_limit,
+					   limits[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"rw_mbytes_per_sec", offsetof(struct rpc_nvmf_ns_set_qos_limit,
+					      limits[SPDK_NVMF_NS_QOS_RW_BPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"r_mbytes_per_sec", offsetof(struct rpc_nvmf_ns_set_qos_limit,
+					     limits[SPDK_NVMF_NS_QOS_R_BPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+	{
+		"w_mbytes_per_sec", offsetof(struct rpc_nvmf_ns_set_qos_limit,
+					     limits[SPDK_NVMF_NS_QOS_W_BPS_RATE_LIMIT]),
+		spdk_json_decode_uint64, true
+	},
+};
+
+static void
+rpc_nvmf_subsystem_ns_set_qos_limit(struct spdk_jsonrpc_request *request,
+				    const struct spdk_json_val *params)
+{
+	struct rpc_nvmf_ns_set_qos_limit req = {};
+	uint64_t limits[SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES];
+	struct spdk_nvmf_subsystem *subsystem;
+	struct spdk_nvmf_ns *ns;
+	struct spdk_nvmf_tgt *tgt;
+	bool specified = false;
+	int i, rc;
+
+	for (i = 0; i < SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		req.limits[i] = UINT64_MAX;
+	}
+
+	if (spdk_json_decode_object(params, rpc_nvmf_ns_set_qos_limit_decoders,
+				    SPDK_COUNTOF(rpc_nvmf_ns_set_qos_limit_decoders),
+				    &req)) {
+		SPDK_ERRLOG("spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		goto cleanup;
+	}
+
+	tgt = spdk_nvmf_get_tgt(req.tgt_name);
+	if (!tgt) {
+		SPDK_ERRLOG("Unable to find a target object.\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "Unable to find a target");
+		goto cleanup;
+	}
+
+	subsystem = spdk_nvmf_tgt_find_subsystem(tgt, req.nqn);
+	if (!subsystem) {
+		SPDK_ERRLOG("Unable to find subsystem with NQN %s\n", req.nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		goto cleanup;
+	}
+
+	ns = spdk_nvmf_subsystem_get_ns(subsystem, req.nsid);
+	if (!ns) {
+		SPDK_ERRLOG("Unable to find namespace %u in subsystem %s\n", req.nsid, req.nqn);
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		goto cleanup;
+	}
+
+	/* The limits that aren't specified are left as they are */
+	spdk_nvmf_ns_get_qos_rate_limits(ns, limits);
+	for (i = 0; i < SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		if (req.limits[i] != UINT64_MAX) {
+			limits[i] = req.limits[i];
+			specified = true;
+		}
+	}
+
+	if (!specified) {
+		SPDK_ERRLOG("No rate limits specified\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "No rate limits specified");
+		goto cleanup;
+	}
+
+	rc = spdk_nvmf_ns_set_qos_rate_limits(ns, limits);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free_rpc_nvmf_ns_set_qos_limit(&req);
+}
+SPDK_RPC_REGISTER("nvmf_subsystem_ns_set_qos_limit", rpc_nvmf_subsystem_ns_set_qos_limit,
+		  SPDK_RPC_RUNTIME);
@@ -62,9 +62,18 @@ enum spdk_nvmf_rdma_request_state {
 	/* Initial state when request first received */
 	RDMA_REQUEST_STATE_NEW,
 
+	/* The request is queued until the QoS rate limits of its namespace allow it. */
+	RDMA_REQUEST_STATE_AWAITING_QOS,
+
 	/* The request is queued until a data buffer is available. */
 	RDMA_REQUEST_STATE_NEED_BUFFER,
 
+	/* The request is waiting for zcopy_start to finish */
+	RDMA_REQUEST_STATE_AWAITING_ZCOPY_START,
+
+	/* The request has received a zero-copy buffer */
+	RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED,
+
 	/* The request is waiting on RDMA queue depth availability
 	 * to transfer data from the host to the controller.
 	 */
@@ -98,6 +107,9 @@ enum spdk_nvmf_rdma_request_state {
 	 */
 	RDMA_REQUEST_STATE_COMPLETING,
 
+	/* The request is waiting for zcopy buffers to be released */
+	RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE,
+
 	/* The request completed and can be marked free. */
 	RDMA_REQUEST_STATE_COMPLETED,
 
@@ -111,6 +123,9 @@ SPDK_TRACE_REGISTER_FN(nvmf_trace, "nvmf_rdma", TRACE_GROUP_NVMF_RDMA)
 	spdk_trace_register_description("RDMA_REQ_NEW", TRACE_RDMA_REQUEST_STATE_NEW,
 					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 1,
 					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
+	spdk_trace_register_description("RDMA_REQ_AWAIT_QOS", TRACE_RDMA_REQUEST_STATE_AWAIT_QOS,
+					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
+					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
 	spdk_trace_register_description("RDMA_REQ_NEED_BUFFER", TRACE_RDMA_REQUEST_STATE_NEED_BUFFER,
 					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
 					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
@@ -154,6 +169,18 @@ SPDK_TRACE_REGISTER_FN(nvmf_trace, "nvmf_rdma", TRACE_GROUP_NVMF_RDMA)
 					TRACE_RDMA_REQUEST_STATE_COMPLETED,
 					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
 					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
+	spdk_trace_register_description("RDMA_REQ_WAIT_ZCPY_STRT",
+					TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_START,
+					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
+					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
+	spdk_trace_register_description("RDMA_REQ_ZCPY_START_CPL",
+					TRACE_RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED,
+					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
+					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
+	spdk_trace_register_description("RDMA_REQ_WAIT_ZCPY_RLS",
+					TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_RELEASE,
+					OWNER_NONE, OBJECT_NVMF_RDMA_IO, 0,
+					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
 
 	spdk_trace_register_description("RDMA_QP_CREATE", TRACE_RDMA_QP_CREATE,
 					OWNER_NONE, OBJECT_NONE, 0,
@@ -198,6 +225,9 @@ struct spdk_nvmf_rdma_recv {
 
 	struct spdk_nvmf_rdma_qpair		*qpair;
 
+	/* Shared receive queue the recv is posted to, NULL if not using an SRQ */
+	struct spdk_rdma_srq			*srq;
+
 	/* In-capsule data buffer */
 	uint8_t					*buf;
 
@@ -334,6 +364,9 @@ struct spdk_nvmf_rdma_qpair {
 	/* The maximum number of SGEs per WR on the recv queue */
 	uint32_t				max_recv_sge;
 
+	/* In-capsule data size accepted on the connection, the recv buffers may be larger */
+	uint32_t				in_capsule_data_size;
+
 	struct spdk_nvmf_rdma_resources		*resources;
 
 	STAILQ_HEAD(, spdk_nvmf_rdma_request)	pending_rdma_read_queue;
@@ -387,6 +420,14 @@ struct spdk_nvmf_rdma_poller_stat {
 	struct spdk_rdma_qp_stats		qp_stats;
 };
 
+/* Shared receive queue of a poller for connections with a smaller in-capsule data size */
+struct spdk_nvmf_rdma_poller_srq {
+	uint32_t				in_capsule_data_size;
+	struct spdk_rdma_srq			*srq;
+	struct spdk_nvmf_rdma_resources		*resources;
+	STAILQ_ENTRY(spdk_nvmf_rdma_poller_srq)	link;
+};
+
 struct spdk_nvmf_rdma_poller {
 	struct spdk_nvmf_rdma_device		*device;
 	struct spdk_nvmf_rdma_poll_group	*group;
@@ -403,6 +444,11 @@ struct spdk_nvmf_rdma_poller {
 	struct spdk_rdma_srq			*srq;
 
 	struct spdk_nvmf_rdma_resources		*resources;
+
+	/* Shared receive queues created on demand for the listeners with a smaller
+	 * in-capsule data size than the transport */
+	STAILQ_HEAD(, spdk_nvmf_rdma_poller_srq)	srqs;
+
 	struct spdk_nvmf_rdma_poller_stat	stat;
 
 	spdk_poller_destroy_cb			destroy_cb;
@@ -425,6 +471,8 @@ struct spdk_nvmf_rdma_poll_group {
 	struct spdk_nvmf_transport_poll_group		group;
 	struct spdk_nvmf_rdma_poll_group_stat		stat;
 	TAILQ_HEAD(, spdk_nvmf_rdma_poller)		pollers;
+	/* NUMA node of the core the poll group was created on */
+	int						numa_id;
 	TAILQ_ENTRY(spdk_nvmf_rdma_poll_group)		link;
 };
 
@@ -442,6 +490,8 @@ struct spdk_nvmf_rdma_device {
 	struct ibv_pd				*pd;
 
 	int					num_srq;
+	/* NUMA node the device is attached to, SPDK_ENV_SOCKET_ID_ANY if unknown */
+	int					numa_id;
 	bool					need_destroy;
 	bool					ready_to_destroy;
 	bool					is_ready;
@@ -453,15 +503,22 @@ struct spdk_nvmf_rdma_port {
 	const struct spdk_nvme_transport_id	*trid;
 	struct rdma_cm_id			*id;
 	struct spdk_nvmf_rdma_device		*device;
+	/* The size of the in-capsule data buffers of the connections accepted by the port */
+	uint32_t				in_capsule_data_size;
 	TAILQ_ENTRY(spdk_nvmf_rdma_port)	link;
 };
 
+struct rdma_listen_opts {
+	uint32_t	in_capsule_data_size;
+};
+
 struct rdma_transport_opts {
 	int		num_cqe;
 	uint32_t	max_srq_depth;
 	bool		no_srq;
 	bool		no_wr_batching;
 	int		acceptor_backlog;
+	bool		numa_aware_placement;
 };
 
 struct spdk_nvmf_rdma_transport {
@@ -519,6 +576,17 @@ static const struct spdk_json_object_decoder rdma_transport_opts_decoder[] = {
 		"acceptor_backlog", offsetof(struct rdma_transport_opts, acceptor_backlog),
 		spdk_json_decode_int32, true
 	},
+	{
+		"numa_aware_placement", offsetof(struct rdma_transport_opts, numa_aware_placement),
+		spdk_json_decode_bool, true
+	},
+};
+
+static const struct spdk_json_object_decoder rdma_listen_opts_decoder[] = {
+	{
+		"in_capsule_data_size", offsetof(struct rdma_listen_opts, in_capsule_data_size),
+		spdk_json_decode_uint32, true
+	},
 };
 
 static int
@@ -743,6 +811,7 @@ nvmf_rdma_resources_create(struct spdk_nvmf_rdma_resource_opts *opts)
 	for (i = 0; i < opts->max_queue_depth; i++) {
 		rdma_recv = &resources->recvs[i];
 		rdma_recv->qpair = opts->qpair;
+		rdma_recv->srq = srq;
 
 		/* Set up memory to receive commands */
 		if (resources->bufs) {
@@ -947,14 +1016,13 @@ nvmf_rdma_qpair_destroy(struct spdk_nvmf_rdma_qpair *rqpair)
 }
 
 static int
-nvmf_rdma_resize_cq(struct spdk_nvmf_rdma_qpair *rqpair, struct spdk_nvmf_rdma_device *device)
+nvmf_rdma_poller_resize_cq(struct spdk_nvmf_rdma_poller *rpoller,
+			   struct spdk_nvmf_rdma_device *device, int num_wr)
 {
-	struct spdk_nvmf_rdma_poller	*rpoller;
 	int				rc, num_cqe, required_num_wr;
 
 	/* Enlarge CQ size dynamically */
-	rpoller = rqpair->poller;
-	required_num_wr = rpoller->required_num_wr + MAX_WR_PER_QP(rqpair->max_queue_depth);
+	required_num_wr = rpoller->required_num_wr + num_wr;
 	num_cqe = rpoller->num_cqe;
 	if (num_cqe < required_num_wr) {
 		num_cqe = spdk_max(num_cqe * 2, required_num_wr);
@@ -987,12 +1055,17 @@ nvmf_rdma_resize_cq(struct spdk_nvmf_rdma_qpair *rqpair, struct spdk_nvmf_rdma_d
 	return 0;
 }
 
+static int
+nvmf_rdma_resize_cq(struct spdk_nvmf_rdma_qpair *rqpair, struct spdk_nvmf_rdma_device *device)
+{
+	return nvmf_rdma_poller_resize_cq(rqpair->poller, device,
+					  MAX_WR_PER_QP(rqpair->max_queue_depth));
+}
+
 static int
 nvmf_rdma_qpair_initialize(struct spdk_nvmf_qpair *qpair)
 {
 	struct spdk_nvmf_rdma_qpair		*rqpair;
-	struct spdk_nvmf_rdma_transport		*rtransport;
-	struct spdk_nvmf_transport		*transport;
 	struct spdk_nvmf_rdma_resource_opts	opts;
 	struct spdk_nvmf_rdma_device		*device;
 	struct spdk_rdma_qp_init_attr		qp_init_attr = {};
@@ -1036,16 +1109,14 @@ nvmf_rdma_qpair_initialize(struct spdk_nvmf_qpair *qpair)
 	spdk_trace_record(TRACE_RDMA_QP_CREATE, 0, 0, (uintptr_t)rqpair);
 	SPDK_DEBUGLOG(rdma, "New RDMA Connection: %p\n", qpair);
 
-	if (rqpair->poller->srq == NULL) {
-		rtransport = SPDK_CONTAINEROF(qpair->transport, struct spdk_nvmf_rdma_transport, transport);
-		transport = &rtransport->transport;
-
+	/* With an SRQ, the resources of the SRQ were already picked up by the poll group */
+	if (rqpair->srq == NULL) {
 		opts.qp = rqpair->rdma_qp;
 		opts.map = device->map;
 		opts.qpair = rqpair;
 		opts.shared = false;
 		opts.max_queue_depth = rqpair->max_queue_depth;
-		opts.in_capsule_data_size = transport->opts.in_capsule_data_size;
+		opts.in_capsule_data_size = rqpair->in_capsule_data_size;
 
 		rqpair->resources = nvmf_rdma_resources_create(&opts);
 
@@ -1054,8 +1125,6 @@ nvmf_rdma_qpair_initialize(struct spdk_nvmf_qpair *qpair)
 			rdma_destroy_qp(rqpair->cm_id);
 			goto error;
 		}
-	} else {
-		rqpair->resources = rqpair->poller->resources;
 	}
 
 	rqpair->current_recv_depth = 0;
@@ -1325,6 +1394,7 @@ nvmf_rdma_connect(struct spdk_nvmf_transport *transport, struct rdma_cm_event *e
 	rqpair->device = port->device;
 	rqpair->max_queue_depth = max_queue_depth;
 	rqpair->max_read_depth = max_read_depth;
+	rqpair->in_capsule_data_size = port->in_capsule_data_size;
 	rqpair->cm_id = event->id;
 	rqpair->listen_id = event->listen_id;
 	rqpair->qpair.transport = transport;
@@ -1670,6 +1740,44 @@ err_exit:
 	return rc;
 }
 
+/* Build the RDMA_WRITE out of the buffers lent by the bdev through zcopy_start. Those don't
+ * come from the transport's pool, so their memory keys are looked up in the device's memory
+ * map, which registers an MR for every region as soon as it's added with spdk_mem_register().
+ */
+static int
+nvmf_rdma_request_fill_zcopy_iovs(struct spdk_nvmf_rdma_poll_group *rgroup,
+				  struct spdk_nvmf_rdma_device *device,
+				  struct spdk_nvmf_rdma_request *rdma_req)
+{
+	struct spdk_nvmf_rdma_qpair	*rqpair;
+	struct spdk_nvmf_request	*req = &rdma_req->req;
+	uint32_t			length = 0;
+	int				i, rc;
+
+	rqpair = SPDK_CONTAINEROF(req->qpair, struct spdk_nvmf_rdma_qpair, qpair);
+
+	if (spdk_unlikely(req->iovcnt > (int)rqpair->max_send_sge)) {
+		SPDK_ERRLOG("Zero-copy buffer of request %p has too many iovs: %d\n", rdma_req,
+			    req->iovcnt);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < req->iovcnt; i++) {
+		length += req->iov[i].iov_len;
+	}
+
+	rdma_req->iovpos = 0;
+	rc = nvmf_rdma_fill_wr_sgl(rgroup, device, rdma_req, &rdma_req->data.wr,
+				   spdk_min(length, req->length));
+	if (spdk_unlikely(rc != 0)) {
+		return rc;
+	}
+
+	rdma_req->num_outstanding_data_wr = 1;
+
+	return 0;
+}
+
 static int
 nvmf_rdma_request_fill_iovs_multi_sgl(struct spdk_nvmf_rdma_transport *rtransport,
 				      struct spdk_nvmf_rdma_device *device,
@@ -1796,11 +1904,13 @@ nvmf_rdma_request_parse_sgl(struct spdk_nvmf_rdma_transport *rtransport,
 			    struct spdk_nvmf_rdma_request *rdma_req)
 {
 	struct spdk_nvmf_request		*req = &rdma_req->req;
+	struct spdk_nvmf_rdma_qpair		*rqpair;
 	struct spdk_nvme_cpl			*rsp;
 	struct spdk_nvme_sgl_descriptor		*sgl;
 	int					rc;
 	uint32_t				length;
 
+	rqpair = SPDK_CONTAINEROF(req->qpair, struct spdk_nvmf_rdma_qpair, qpair);
 	rsp = &req->rsp->nvme_cpl;
 	sgl = &req->cmd->nvme_cmd.dptr.sgl1;
 
@@ -1827,6 +1937,16 @@ nvmf_rdma_request_parse_sgl(struct spdk_nvmf_rdma_transport *rtransport,
 		/* fill request length and populate iovs */
 		req->length = length;
 
+		/* Reads may be served straight from the bdev's buffers, the data is written to
+		 * the host from them once zcopy_start completes. */
+		if (req->xfer == SPDK_NVME_DATA_CONTROLLER_TO_HOST && !req->dif_enabled &&
+		    nvmf_ctrlr_use_zcopy(req)) {
+			SPDK_DEBUGLOG(rdma, "Using zero-copy to execute request %p\n", rdma_req);
+			nvmf_rdma_setup_request(rdma_req);
+			req->data_from_pool = false;
+			return 0;
+		}
+
 		rc = nvmf_rdma_request_fill_iovs(rtransport, device, rdma_req);
 		if (spdk_unlikely(rc < 0)) {
 			if (rc == -EINVAL) {
@@ -1849,7 +1969,7 @@ nvmf_rdma_request_parse_sgl(struct spdk_nvmf_rdma_transport *rtransport,
 	} else if (sgl->generic.type == SPDK_NVME_SGL_TYPE_DATA_BLOCK &&
 		   sgl->unkeyed.subtype == SPDK_NVME_SGL_SUBTYPE_OFFSET) {
 		uint64_t offset = sgl->address;
-		uint32_t max_len = rtransport->transport.opts.in_capsule_data_size;
+		uint32_t max_len = rqpair->in_capsule_data_size;
 
 		SPDK_DEBUGLOG(nvmf, "In-capsule data: offset 0x%" PRIx64 ", length 0x%x\n",
 			      offset, sgl->unkeyed.length);
@@ -1931,6 +2051,7 @@ _nvmf_rdma_request_free(struct spdk_nvmf_rdma_request *rdma_req,
 	rdma_req->req.data = NULL;
 	rdma_req->offset = 0;
 	rdma_req->req.dif_enabled = false;
+	rdma_req->req.zcopy_phase = NVMF_ZCOPY_PHASE_NONE;
 	rdma_req->fused_failed = false;
 	if (rdma_req->fused_pair) {
 		/* This req was part of a valid fused pair, but failed before it got to
@@ -2026,12 +2147,19 @@ nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 	/* If the queue pair is in an error state, force the request to the completed state
 	 * to release resources. */
 	if (rqpair->ibv_state == IBV_QPS_ERR || rqpair->qpair.state != SPDK_NVMF_QPAIR_ACTIVE) {
-		if (rdma_req->state == RDMA_REQUEST_STATE_NEED_BUFFER) {
+		if (rdma_req->state == RDMA_REQUEST_STATE_AWAITING_QOS) {
+			STAILQ_REMOVE(&rgroup->group.pending_qos_queue, &rdma_req->req,
+				      spdk_nvmf_request, buf_link);
+		} else if (rdma_req->state == RDMA_REQUEST_STATE_NEED_BUFFER) {
 			STAILQ_REMOVE(&rgroup->group.pending_buf_queue, &rdma_req->req, spdk_nvmf_request, buf_link);
 		} else if (rdma_req->state == RDMA_REQUEST_STATE_DATA_TRANSFER_TO_CONTROLLER_PENDING) {
 			STAILQ_REMOVE(&rqpair->pending_rdma_read_queue, rdma_req, spdk_nvmf_rdma_request, state_link);
 		} else if (rdma_req->state == RDMA_REQUEST_STATE_DATA_TRANSFER_TO_HOST_PENDING) {
 			STAILQ_REMOVE(&rqpair->pending_rdma_write_queue, rdma_req, spdk_nvmf_rdma_request, state_link);
+		} else if (rdma_req->state == RDMA_REQUEST_STATE_AWAITING_ZCOPY_START ||
+			   rdma_req->state == RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE) {
+			/* The bdev's zcopy callback will kick the request out of this state */
+			return false;
 		}
 		rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
 	}
@@ -2089,6 +2217,28 @@ nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 				break;
 			}
 
+			/* Hold the request back before it takes any buffer or RDMA READ if its
+			 * namespace is over its rate limits. */
+			if (spdk_unlikely(!nvmf_request_qos_admit(&rdma_req->req, false))) {
+				rdma_req->state = RDMA_REQUEST_STATE_AWAITING_QOS;
+				STAILQ_INSERT_TAIL(&rgroup->group.pending_qos_queue, &rdma_req->req,
+						   buf_link);
+				break;
+			}
+
+			rdma_req->state = RDMA_REQUEST_STATE_NEED_BUFFER;
+			STAILQ_INSERT_TAIL(&rgroup->group.pending_buf_queue, &rdma_req->req, buf_link);
+			break;
+		case RDMA_REQUEST_STATE_AWAITING_QOS:
+			spdk_trace_record(TRACE_RDMA_REQUEST_STATE_AWAIT_QOS, 0, 0,
+					  (uintptr_t)rdma_req, (uintptr_t)rqpair);
+
+			if (!nvmf_request_qos_admit(&rdma_req->req, false)) {
+				break;
+			}
+
+			STAILQ_REMOVE(&rgroup->group.pending_qos_queue, &rdma_req->req,
+				      spdk_nvmf_request, buf_link);
 			rdma_req->state = RDMA_REQUEST_STATE_NEED_BUFFER;
 			STAILQ_INSERT_TAIL(&rgroup->group.pending_buf_queue, &rdma_req->req, buf_link);
 			break;
@@ -2111,6 +2261,14 @@ nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 				break;
 			}
 
+			/* Get a zcopy buffer if the request can be serviced through zcopy */
+			if (spdk_nvmf_request_using_zcopy(&rdma_req->req)) {
+				STAILQ_REMOVE_HEAD(&rgroup->group.pending_buf_queue, buf_link);
+				rdma_req->state = RDMA_REQUEST_STATE_AWAITING_ZCOPY_START;
+				spdk_nvmf_request_zcopy_start(&rdma_req->req);
+				break;
+			}
+
 			if (rdma_req->req.iovcnt == 0) {
 				/* No buffers available. */
 				rgroup->stat.pending_data_buffer++;
@@ -2131,6 +2289,34 @@ nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 
 			rdma_req->state = RDMA_REQUEST_STATE_READY_TO_EXECUTE;
 			break;
+		case RDMA_REQUEST_STATE_AWAITING_ZCOPY_START:
+			spdk_trace_record(TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_START, 0, 0,
+					  (uintptr_t)rdma_req, (uintptr_t)rqpair);
+			/* Some external code must kick a request into
+			 * RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED to escape this state. */
+			break;
+		case RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED:
+			spdk_trace_record(TRACE_RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED, 0, 0,
+					  (uintptr_t)rdma_req, (uintptr_t)rqpair);
+			if (spdk_unlikely(spdk_nvme_cpl_is_error(rsp))) {
+				SPDK_DEBUGLOG(rdma, "Zero-copy start failed for request %p\n",
+					      rdma_req);
+				rdma_req->state = RDMA_REQUEST_STATE_READY_TO_COMPLETE;
+				break;
+			}
+
+			/* Only reads use zero-copy, the data is already in the bdev's buffers */
+			assert(rdma_req->req.xfer == SPDK_NVME_DATA_CONTROLLER_TO_HOST);
+			rc = nvmf_rdma_request_fill_zcopy_iovs(rgroup, device, rdma_req);
+			if (spdk_unlikely(rc != 0)) {
+				rsp->status.sct = SPDK_NVME_SCT_GENERIC;
+				rsp->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+				rdma_req->state = RDMA_REQUEST_STATE_READY_TO_COMPLETE;
+				break;
+			}
+
+			rdma_req->state = RDMA_REQUEST_STATE_EXECUTED;
+			break;
 		case RDMA_REQUEST_STATE_DATA_TRANSFER_TO_CONTROLLER_PENDING:
 			spdk_trace_record(TRACE_RDMA_REQUEST_STATE_DATA_TRANSFER_TO_CONTROLLER_PENDING, 0, 0,
 					  (uintptr_t)rdma_req, (uintptr_t)rqpair);
@@ -2331,10 +2517,25 @@ nvmf_rdma_request_process(struct spdk_nvmf_rdma_transport *rtransport,
 			/* Some external code must kick a request into RDMA_REQUEST_STATE_COMPLETED
 			 * to escape this state. */
 			break;
+		case RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE:
+			spdk_trace_record(TRACE_RDMA_REQUEST_STATE_AWAIT_ZCOPY_RELEASE, 0, 0,
+					  (uintptr_t)rdma_req, (uintptr_t)rqpair);
+			/* Some external code must kick a request into RDMA_REQUEST_STATE_COMPLETED
+			 * to escape this state. */
+			break;
 		case RDMA_REQUEST_STATE_COMPLETED:
 			spdk_trace_record(TRACE_RDMA_REQUEST_STATE_COMPLETED, 0, 0,
 					  (uintptr_t)rdma_req, (uintptr_t)rqpair);
 
+			if (rdma_req->req.zcopy_bdev_io != NULL) {
+				/* The data has been written to the host (or the request failed),
+				 * give the buffers back to the bdev before freeing the request. */
+				assert(spdk_nvmf_request_using_zcopy(&rdma_req->req));
+				rdma_req->state = RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE;
+				spdk_nvmf_request_zcopy_end(&rdma_req->req, false);
+				break;
+			}
+
 			rqpair->poller->stat.request_latency += spdk_get_ticks() - rdma_req->receive_tsc;
 			_nvmf_rdma_request_free(rdma_req, rtransport);
 			break;
@@ -2400,6 +2601,28 @@ static bool nvmf_rdma_retry_listen_port(struct spdk_nvmf_rdma_transport *rtransp
 static void destroy_ib_device(struct spdk_nvmf_rdma_transport *rtransport,
 			      struct spdk_nvmf_rdma_device *device);
 
+static int
+nvmf_rdma_get_device_numa_id(struct ibv_context *context)
+{
+	char path[PATH_MAX];
+	FILE *file;
+	int numa_id;
+
+	snprintf(path, sizeof(path), "%s/device/numa_node", context->device->ibdev_path);
+	file = fopen(path, "r");
+	if (file == NULL) {
+		return SPDK_ENV_SOCKET_ID_ANY;
+	}
+
+	/* The kernel reports -1 on systems without NUMA */
+	if (fscanf(file, "%d", &numa_id) != 1 || numa_id < 0) {
+		numa_id = SPDK_ENV_SOCKET_ID_ANY;
+	}
+	fclose(file);
+
+	return numa_id;
+}
+
 static int
 create_ib_device(struct spdk_nvmf_rdma_transport *rtransport, struct ibv_context *context,
 		 struct spdk_nvmf_rdma_device **new_device)
@@ -2450,6 +2673,8 @@ create_ib_device(struct spdk_nvmf_rdma_transport *rtransport, struct ibv_context
 		return rc;
 	}
 
+	device->numa_id = nvmf_rdma_get_device_numa_id(device->context);
+
 	TAILQ_INSERT_TAIL(&rtransport->devices, device, link);
 	SPDK_DEBUGLOG(rdma, "New device %p is added to RDMA trasport\n", device);
 
@@ -2573,7 +2798,8 @@ nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 		     "  max_io_qpairs_per_ctrlr=%d, io_unit_size=%d,\n"
 		     "  in_capsule_data_size=%d, max_aq_depth=%d,\n"
 		     "  num_shared_buffers=%d, num_cqe=%d, max_srq_depth=%d, no_srq=%d,"
-		     "  acceptor_backlog=%d, no_wr_batching=%d abort_timeout_sec=%d\n",
+		     "  acceptor_backlog=%d, no_wr_batching=%d abort_timeout_sec=%d\n"
+		     "  numa_aware_placement=%d\n",
 		     opts->max_queue_depth,
 		     opts->max_io_size,
 		     opts->max_qpairs_per_ctrlr - 1,
@@ -2586,7 +2812,8 @@ nvmf_rdma_create(struct spdk_nvmf_transport_opts *opts)
 		     rtransport->rdma_opts.no_srq,
 		     rtransport->rdma_opts.acceptor_backlog,
 		     rtransport->rdma_opts.no_wr_batching,
-		     opts->abort_timeout_sec);
+		     opts->abort_timeout_sec,
+		     rtransport->rdma_opts.numa_aware_placement);
 
 	/* I/O unit size cannot be larger than max I/O size */
 	if (opts->io_unit_size > opts->max_io_size) {
@@ -2748,6 +2975,8 @@ nvmf_rdma_dump_opts(struct spdk_nvmf_transport *transport, struct spdk_json_writ
 	}
 	spdk_json_write_named_int32(w, "acceptor_backlog", rtransport->rdma_opts.acceptor_backlog);
 	spdk_json_write_named_bool(w, "no_wr_batching", rtransport->rdma_opts.no_wr_batching);
+	spdk_json_write_named_bool(w, "numa_aware_placement",
+				   rtransport->rdma_opts.numa_aware_placement);
 }
 
 static int
@@ -2808,8 +3037,47 @@ static int nvmf_rdma_trid_from_cm_id(struct rdma_cm_id *id,
 static bool nvmf_rdma_rescan_devices(struct spdk_nvmf_rdma_transport *rtransport);
 
 static int
-nvmf_rdma_listen(struct spdk_nvmf_transport *transport, const struct spdk_nvme_transport_id *trid,
-		 struct spdk_nvmf_listen_opts *listen_opts)
+nvmf_rdma_parse_listen_opts(struct spdk_nvmf_transport *transport,
+			    const struct spdk_nvmf_listen_opts *listen_opts,
+			    struct rdma_listen_opts *opts)
+{
+	uint32_t min_in_capsule_data_size;
+
+	opts->in_capsule_data_size = transport->opts.in_capsule_data_size;
+	if (listen_opts == NULL || listen_opts->transport_specific == NULL) {
+		return 0;
+	}
+
+	if (spdk_json_decode_object_relaxed(listen_opts->transport_specific,
+					    rdma_listen_opts_decoder,
+					    SPDK_COUNTOF(rdma_listen_opts_decoder), opts)) {
+		SPDK_ERRLOG("spdk_json_decode_object_relaxed failed\n");
+		return -EINVAL;
+	}
+
+	if (opts->in_capsule_data_size == transport->opts.in_capsule_data_size) {
+		return 0;
+	}
+
+	/* The in-capsule data size is advertised to the host in 16 byte units */
+	min_in_capsule_data_size = sizeof(struct spdk_nvme_sgl_descriptor) *
+				   SPDK_NVMF_MAX_SGL_ENTRIES;
+	if (opts->in_capsule_data_size < min_in_capsule_data_size ||
+	    opts->in_capsule_data_size > transport->opts.in_capsule_data_size ||
+	    opts->in_capsule_data_size % 16 != 0) {
+		SPDK_ERRLOG("Listener in_capsule_data_size %u must be a multiple of 16 "
+			    "in [%u, %u]\n",
+			    opts->in_capsule_data_size, min_in_capsule_data_size,
+			    transport->opts.in_capsule_data_size);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int
+_nvmf_rdma_listen(struct spdk_nvmf_transport *transport, const struct spdk_nvme_transport_id *trid,
+		  uint32_t in_capsule_data_size)
 {
 	struct spdk_nvmf_rdma_transport	*rtransport;
 	struct spdk_nvmf_rdma_device	*device;
@@ -2835,6 +3103,7 @@ nvmf_rdma_listen(struct spdk_nvmf_transport *transport, const struct spdk_nvme_t
 	}
 
 	port->trid = trid;
+	port->in_capsule_data_size = in_capsule_data_size;
 
 	switch (trid->adrfam) {
 	case SPDK_NVMF_ADRFAM_IPV4:
@@ -2924,6 +3193,41 @@ nvmf_rdma_listen(struct spdk_nvmf_transport *transport, const struct spdk_nvme_t
 	return 0;
 }
 
+static int
+nvmf_rdma_listen(struct spdk_nvmf_transport *transport, const struct spdk_nvme_transport_id *trid,
+		 struct spdk_nvmf_listen_opts *listen_opts)
+{
+	struct rdma_listen_opts opts;
+	int rc;
+
+	rc = nvmf_rdma_parse_listen_opts(transport, listen_opts, &opts);
+	if (rc) {
+		return rc;
+	}
+
+	return _nvmf_rdma_listen(transport, trid, opts.in_capsule_data_size);
+}
+
+static void
+nvmf_rdma_listen_dump_opts(struct spdk_nvmf_transport *transport,
+			   const struct spdk_nvme_transport_id *trid, struct spdk_json_write_ctx *w)
+{
+	struct spdk_nvmf_rdma_transport	*rtransport;
+	struct spdk_nvmf_rdma_port	*port;
+
+	rtransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_rdma_transport, transport);
+
+	TAILQ_FOREACH(port, &rtransport->ports, link) {
+		if (spdk_nvme_transport_id_compare(port->trid, trid) == 0) {
+			break;
+		}
+	}
+
+	if (port && port->in_capsule_data_size != transport->opts.in_capsule_data_size) {
+		spdk_json_write_named_uint32(w, "in_capsule_data_size", port->in_capsule_data_size);
+	}
+}
+
 static void
 nvmf_rdma_stop_listen_ex(struct spdk_nvmf_transport *transport,
 			 const struct spdk_nvme_transport_id *trid, bool need_retry)
@@ -3199,7 +3503,8 @@ nvmf_rdma_retry_listen_port(struct spdk_nvmf_rdma_transport *rtransport)
 	new_create = nvmf_rdma_rescan_devices(rtransport);
 
 	TAILQ_FOREACH_SAFE(port, &rtransport->retry_ports, link, tmp_port) {
-		rc = nvmf_rdma_listen(&rtransport->transport, port->trid, NULL);
+		rc = _nvmf_rdma_listen(&rtransport->transport, port->trid,
+				       port->in_capsule_data_size);
 
 		TAILQ_REMOVE(&rtransport->retry_ports, port, link);
 		if (rc) {
@@ -3240,6 +3545,15 @@ nvmf_rdma_qpair_process_pending(struct spdk_nvmf_rdma_transport *rtransport,
 		}
 	}
 
+	/* The requests held back by QoS are retried by the poll group, unless draining. */
+	if (drain) {
+		STAILQ_FOREACH_SAFE(req, &rqpair->poller->group->group.pending_qos_queue, buf_link,
+				    tmp) {
+			rdma_req = SPDK_CONTAINEROF(req, struct spdk_nvmf_rdma_request, req);
+			nvmf_rdma_request_process(rtransport, rdma_req);
+		}
+	}
+
 	/* Then we handle request waiting on memory buffers. */
 	STAILQ_FOREACH_SAFE(req, &rqpair->poller->group->group.pending_buf_queue, buf_link, tmp) {
 		rdma_req = SPDK_CONTAINEROF(req, struct spdk_nvmf_rdma_request, req);
@@ -3392,6 +3706,7 @@ nvmf_rdma_handle_cm_event_addr_change(struct spdk_nvmf_transport *transport,
 	const struct spdk_nvme_transport_id	*trid;
 	struct spdk_nvmf_rdma_port		*port;
 	struct spdk_nvmf_rdma_transport		*rtransport;
+	uint32_t				in_capsule_data_size;
 	bool					event_acked = false;
 
 	rtransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_rdma_transport, transport);
@@ -3401,6 +3716,7 @@ nvmf_rdma_handle_cm_event_addr_change(struct spdk_nvmf_transport *transport,
 			rdma_ack_cm_event(event);
 			event_acked = true;
 			trid = port->trid;
+			in_capsule_data_size = port->in_capsule_data_size;
 			break;
 		}
 	}
@@ -3409,7 +3725,7 @@ nvmf_rdma_handle_cm_event_addr_change(struct spdk_nvmf_transport *transport,
 		nvmf_rdma_disconnect_qpairs_on_port(rtransport, port);
 
 		nvmf_rdma_stop_listen(transport, trid);
-		nvmf_rdma_listen(transport, trid, NULL);
+		_nvmf_rdma_listen(transport, trid, in_capsule_data_size);
 	}
 
 	return event_acked;
@@ -3840,14 +4156,50 @@ nvmf_rdma_discover(struct spdk_nvmf_transport *transport,
 	entry->tsas.rdma.rdma_cms = SPDK_NVMF_RDMA_CMS_RDMA_CM;
 }
 
+static int
+nvmf_rdma_poller_create_srq(struct spdk_nvmf_rdma_poller *poller, uint32_t in_capsule_data_size,
+			    struct spdk_rdma_srq **out_srq,
+			    struct spdk_nvmf_rdma_resources **out_resources)
+{
+	struct spdk_nvmf_rdma_device		*device = poller->device;
+	struct spdk_rdma_srq_init_attr		srq_init_attr;
+	struct spdk_nvmf_rdma_resource_opts	opts;
+
+	device->num_srq++;
+	memset(&srq_init_attr, 0, sizeof(srq_init_attr));
+	srq_init_attr.pd = device->pd;
+	srq_init_attr.stats = &poller->stat.qp_stats.recv;
+	srq_init_attr.srq_init_attr.attr.max_wr = poller->max_srq_depth;
+	srq_init_attr.srq_init_attr.attr.max_sge = spdk_min(device->attr.max_sge,
+			NVMF_DEFAULT_RX_SGE);
+	*out_srq = spdk_rdma_srq_create(&srq_init_attr);
+	if (!*out_srq) {
+		SPDK_ERRLOG("Unable to create shared receive queue, errno %d\n", errno);
+		return -1;
+	}
+
+	opts.qp = *out_srq;
+	opts.map = device->map;
+	opts.qpair = NULL;
+	opts.shared = true;
+	opts.max_queue_depth = poller->max_srq_depth;
+	opts.in_capsule_data_size = in_capsule_data_size;
+
+	*out_resources = nvmf_rdma_resources_create(&opts);
+	if (!*out_resources) {
+		SPDK_ERRLOG("Unable to allocate resources for shared receive queue.\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 static int
 nvmf_rdma_poller_create(struct spdk_nvmf_rdma_transport *rtransport,
 			struct spdk_nvmf_rdma_poll_group *rgroup, struct spdk_nvmf_rdma_device *device,
 			struct spdk_nvmf_rdma_poller **out_poller)
 {
 	struct spdk_nvmf_rdma_poller		*poller;
-	struct spdk_rdma_srq_init_attr		srq_init_attr;
-	struct spdk_nvmf_rdma_resource_opts	opts;
 	int					num_cqe;
 
 	poller = calloc(1, sizeof(*poller));
@@ -3863,6 +4215,7 @@ nvmf_rdma_poller_create(struct spdk_nvmf_rdma_transport *rtransport,
 	RB_INIT(&poller->qpairs);
 	STAILQ_INIT(&poller->qpairs_pending_send);
 	STAILQ_INIT(&poller->qpairs_pending_recv);
+	STAILQ_INIT(&poller->srqs);
 
 	TAILQ_INSERT_TAIL(&rgroup->pollers, poller, link);
 	SPDK_DEBUGLOG(rdma, "Create poller %p on device %p in poll group %p.\n", poller, device, rgroup);
@@ -3873,28 +4226,9 @@ nvmf_rdma_poller_create(struct spdk_nvmf_rdma_transport *rtransport,
 		}
 		poller->max_srq_depth = spdk_min((int)rtransport->rdma_opts.max_srq_depth, device->attr.max_srq_wr);
 
-		device->num_srq++;
-		memset(&srq_init_attr, 0, sizeof(srq_init_attr));
-		srq_init_attr.pd = device->pd;
-		srq_init_attr.stats = &poller->stat.qp_stats.recv;
-		srq_init_attr.srq_init_attr.attr.max_wr = poller->max_srq_depth;
-		srq_init_attr.srq_init_attr.attr.max_sge = spdk_min(device->attr.max_sge, NVMF_DEFAULT_RX_SGE);
-		poller->srq = spdk_rdma_srq_create(&srq_init_attr);
-		if (!poller->srq) {
-			SPDK_ERRLOG("Unable to create shared receive queue, errno %d\n", errno);
-			return -1;
-		}
-
-		opts.qp = poller->srq;
-		opts.map = device->map;
-		opts.qpair = NULL;
-		opts.shared = true;
-		opts.max_queue_depth = poller->max_srq_depth;
-		opts.in_capsule_data_size = rtransport->transport.opts.in_capsule_data_size;
-
-		poller->resources = nvmf_rdma_resources_create(&opts);
-		if (!poller->resources) {
-			SPDK_ERRLOG("Unable to allocate resources for shared receive queue.\n");
+		if (nvmf_rdma_poller_create_srq(poller,
+						rtransport->transport.opts.in_capsule_data_size,
+						&poller->srq, &poller->resources)) {
 			return -1;
 		}
 	}
@@ -3917,9 +4251,82 @@ nvmf_rdma_poller_create(struct spdk_nvmf_rdma_transport *rtransport,
 		return -1;
 	}
 	poller->num_cqe = num_cqe;
+	if (poller->srq) {
+		poller->required_num_wr = num_cqe;
+	}
 	return 0;
 }
 
+static void
+nvmf_rdma_poller_srq_destroy(struct spdk_nvmf_rdma_poller_srq *psrq)
+{
+	if (psrq->resources) {
+		nvmf_rdma_resources_destroy(psrq->resources);
+	}
+	if (psrq->srq) {
+		spdk_rdma_srq_destroy(psrq->srq);
+		SPDK_DEBUGLOG(rdma, "Destroyed RDMA shared queue %p\n", psrq->srq);
+	}
+	free(psrq);
+}
+
+/*
+ * Connections of the listeners with a smaller in-capsule data size get an SRQ of their
+ * own, so that the recv buffers of the poller are sized for them and not for the transport.
+ * If it can't be created, the default SRQ of the poller is used, its buffers are large enough.
+ */
+static void
+nvmf_rdma_poller_get_srq(struct spdk_nvmf_rdma_transport *rtransport,
+			 struct spdk_nvmf_rdma_poller *poller, struct spdk_nvmf_rdma_qpair *rqpair)
+{
+	struct spdk_nvmf_rdma_device		*device = poller->device;
+	struct spdk_nvmf_rdma_poller_srq	*psrq;
+
+	rqpair->srq = poller->srq;
+	rqpair->resources = poller->resources;
+	if (poller->srq == NULL ||
+	    rqpair->in_capsule_data_size >= rtransport->transport.opts.in_capsule_data_size) {
+		return;
+	}
+
+	STAILQ_FOREACH(psrq, &poller->srqs, link) {
+		if (psrq->in_capsule_data_size == rqpair->in_capsule_data_size) {
+			rqpair->srq = psrq->srq;
+			rqpair->resources = psrq->resources;
+			return;
+		}
+	}
+
+	if (device->num_srq >= device->attr.max_srq) {
+		return;
+	}
+
+	psrq = calloc(1, sizeof(*psrq));
+	if (!psrq) {
+		SPDK_ERRLOG("Unable to allocate memory for shared receive queue\n");
+		return;
+	}
+
+	psrq->in_capsule_data_size = rqpair->in_capsule_data_size;
+	if (nvmf_rdma_poller_create_srq(poller, psrq->in_capsule_data_size, &psrq->srq,
+					&psrq->resources)) {
+		nvmf_rdma_poller_srq_destroy(psrq);
+		return;
+	}
+
+	/* The same formula as for the default SRQ of the poller */
+	if (nvmf_rdma_poller_resize_cq(poller, device, poller->max_srq_depth * 3)) {
+		nvmf_rdma_poller_srq_destroy(psrq);
+		return;
+	}
+
+	SPDK_DEBUGLOG(rdma, "Created SRQ %p with in-capsule data size %u on poller %p\n",
+		      psrq->srq, psrq->in_capsule_data_size, poller);
+	STAILQ_INSERT_TAIL(&poller->srqs, psrq, link);
+	rqpair->srq = psrq->srq;
+	rqpair->resources = psrq->resources;
+}
+
 static void
 _nvmf_rdma_register_poller_in_group(void *c)
 {
@@ -3959,6 +4366,7 @@ nvmf_rdma_poll_group_create(struct spdk_nvmf_transport *transport,
 	}
 
 	TAILQ_INIT(&rgroup->pollers);
+	rgroup->numa_id = spdk_env_get_socket_id(spdk_env_get_current_core());
 
 	TAILQ_FOREACH(device, &rtransport->devices, link) {
 		rc = nvmf_rdma_poller_create(rtransport, rgroup, device, &poller);
@@ -3993,21 +4401,61 @@ nvmf_poll_group_get_io_qpair_count(struct spdk_nvmf_poll_group *pg)
 	return count;
 }
 
+/* Find the least loaded poll group on the given NUMA node, starting from the next I/O poll
+ * group so that groups with the same load are used in turn. */
+static struct spdk_nvmf_rdma_poll_group *
+nvmf_rdma_get_numa_io_poll_group(struct spdk_nvmf_rdma_transport *rtransport, int numa_id)
+{
+	struct spdk_nvmf_rdma_poll_group *pg_start, *pg_current, *pg_min = NULL;
+	uint32_t count, min_value = UINT32_MAX;
+
+	pg_start = rtransport->conn_sched.next_io_pg;
+	pg_current = pg_start;
+	do {
+		if (pg_current->numa_id == numa_id) {
+			count = nvmf_poll_group_get_io_qpair_count(pg_current->group.group);
+			if (count < min_value) {
+				min_value = count;
+				pg_min = pg_current;
+			}
+		}
+
+		pg_current = TAILQ_NEXT(pg_current, link);
+		if (pg_current == NULL) {
+			pg_current = TAILQ_FIRST(&rtransport->poll_groups);
+		}
+	} while (pg_current != pg_start);
+
+	return pg_min;
+}
+
 static struct spdk_nvmf_transport_poll_group *
 nvmf_rdma_get_optimal_poll_group(struct spdk_nvmf_qpair *qpair)
 {
 	struct spdk_nvmf_rdma_transport *rtransport;
+	struct spdk_nvmf_rdma_qpair *rqpair;
 	struct spdk_nvmf_rdma_poll_group **pg;
+	struct spdk_nvmf_rdma_poll_group *pg_numa = NULL;
 	struct spdk_nvmf_transport_poll_group *result;
 	uint32_t count;
 
 	rtransport = SPDK_CONTAINEROF(qpair->transport, struct spdk_nvmf_rdma_transport, transport);
+	rqpair = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_rdma_qpair, qpair);
 
 	if (TAILQ_EMPTY(&rtransport->poll_groups)) {
 		return NULL;
 	}
 
-	if (qpair->qid == 0) {
+	/* Keep the I/O qpairs on the cores local to the device, if there are any */
+	if (qpair->qid != 0 && rtransport->rdma_opts.numa_aware_placement &&
+	    rqpair->device != NULL && rqpair->device->numa_id != SPDK_ENV_SOCKET_ID_ANY) {
+		pg_numa = nvmf_rdma_get_numa_io_poll_group(rtransport, rqpair->device->numa_id);
+	}
+
+	if (pg_numa != NULL) {
+		pg = &rtransport->conn_sched.next_io_pg;
+		*pg = pg_numa;
+	} else if (qpair->qid == 0) {
 		pg = &rtransport->conn_sched.next_admin_pg;
 	} else {
 		struct spdk_nvmf_rdma_poll_group *pg_min, *pg_start, *pg_current;
@@ -4053,6 +4501,7 @@ static void
 nvmf_rdma_poller_destroy(struct spdk_nvmf_rdma_poller *poller)
 {
 	struct spdk_nvmf_rdma_qpair	*qpair, *tmp_qpair;
+	struct spdk_nvmf_rdma_poller_srq	*psrq;
 	int				rc;
 
 	TAILQ_REMOVE(&poller->group->pollers, poller, link);
@@ -4060,6 +4509,11 @@ nvmf_rdma_poller_destroy(struct spdk_nvmf_rdma_poller *poller)
 		nvmf_rdma_qpair_destroy(qpair);
 	}
 
+	while ((psrq = STAILQ_FIRST(&poller->srqs)) != NULL) {
+		STAILQ_REMOVE_HEAD(&poller->srqs, link);
+		nvmf_rdma_poller_srq_destroy(psrq);
+	}
+
 	if (poller->srq) {
 		if (poller->resources) {
 			nvmf_rdma_resources_destroy(poller->resources);
@@ -4135,12 +4589,14 @@ static int
 nvmf_rdma_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 			 struct spdk_nvmf_qpair *qpair)
 {
+	struct spdk_nvmf_rdma_transport		*rtransport;
 	struct spdk_nvmf_rdma_poll_group	*rgroup;
 	struct spdk_nvmf_rdma_qpair		*rqpair;
 	struct spdk_nvmf_rdma_device		*device;
 	struct spdk_nvmf_rdma_poller		*poller;
 	int					rc;
 
+	rtransport = SPDK_CONTAINEROF(group->transport, struct spdk_nvmf_rdma_transport, transport);
 	rgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_rdma_poll_group, group);
 	rqpair = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_rdma_qpair, qpair);
 
@@ -4163,13 +4619,14 @@ nvmf_rdma_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 	}
 
 	rqpair->poller = poller;
-	rqpair->srq = rqpair->poller->srq;
+	nvmf_rdma_poller_get_srq(rtransport, poller, rqpair);
 
 	rc = nvmf_rdma_qpair_initialize(qpair);
 	if (rc < 0) {
 		SPDK_ERRLOG("Failed to initialize nvmf_rdma_qpair with qpair=%p\n", qpair);
 		rqpair->poller = NULL;
 		rqpair->srq = NULL;
+		rqpair->resources = NULL;
 		return -1;
 	}
 
@@ -4211,6 +4668,13 @@ nvmf_rdma_poll_group_remove(struct spdk_nvmf_transport_poll_group *group,
 	return 0;
 }
 
+static int
+nvmf_rdma_req_is_completing(struct spdk_nvmf_rdma_request *rdma_req)
+{
+	return rdma_req->state == RDMA_REQUEST_STATE_TRANSFERRING_CONTROLLER_TO_HOST ||
+	       rdma_req->state == RDMA_REQUEST_STATE_COMPLETING;
+}
+
 static int
 nvmf_rdma_request_free(struct spdk_nvmf_request *req)
 {
@@ -4220,6 +4684,16 @@ nvmf_rdma_request_free(struct spdk_nvmf_request *req)
 	struct spdk_nvmf_rdma_qpair *rqpair = SPDK_CONTAINEROF(rdma_req->req.qpair,
 					      struct spdk_nvmf_rdma_qpair, qpair);
 
+	if (spdk_unlikely(rdma_req->req.zcopy_bdev_io != NULL)) {
+		/* Aborted zero-copy request. The buffers must be released on the way to the
+		 * completed state; if its data is still in flight, the completion of the send
+		 * takes it there. */
+		if (!nvmf_rdma_req_is_completing(rdma_req)) {
+			nvmf_rdma_request_process(rtransport, rdma_req);
+		}
+		return 0;
+	}
+
 	/*
 	 * AER requests are freed when a qpair is destroyed. The recv corresponding to that request
 	 * needs to be returned to the shared receive queue or the poll group will eventually be
@@ -4250,9 +4724,16 @@ nvmf_rdma_request_complete(struct spdk_nvmf_request *req)
 	struct spdk_nvmf_rdma_qpair     *rqpair = SPDK_CONTAINEROF(rdma_req->req.qpair,
 			struct spdk_nvmf_rdma_qpair, qpair);
 
-	if (rqpair->ibv_state != IBV_QPS_ERR) {
+	if (rdma_req->state == RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE) {
+		/* The zero-copy buffers were released, the request can be freed */
+		rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
+	} else if (rqpair->ibv_state != IBV_QPS_ERR) {
 		/* The connection is alive, so process the request as normal */
-		rdma_req->state = RDMA_REQUEST_STATE_EXECUTED;
+		if (rdma_req->state == RDMA_REQUEST_STATE_AWAITING_ZCOPY_START) {
+			rdma_req->state = RDMA_REQUEST_STATE_ZCOPY_START_COMPLETED;
+		} else {
+			rdma_req->state = RDMA_REQUEST_STATE_EXECUTED;
+		}
 	} else {
 		/* The connection is dead. Move the request directly to the completed state. */
 		rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
@@ -4303,15 +4784,6 @@ get_rdma_qpair_from_wc(struct spdk_nvmf_rdma_poller *rpoller, struct ibv_wc *wc)
 	return RB_FIND(qpairs_tree, &rpoller->qpairs, &find);
 }
 
-#ifdef DEBUG
-static int
-nvmf_rdma_req_is_completing(struct spdk_nvmf_rdma_request *rdma_req)
-{
-	return rdma_req->state == RDMA_REQUEST_STATE_TRANSFERRING_CONTROLLER_TO_HOST ||
-	       rdma_req->state == RDMA_REQUEST_STATE_COMPLETING;
-}
-#endif
-
 static void
 _poller_reset_failed_recvs(struct spdk_nvmf_rdma_poller *rpoller, struct ibv_recv_wr *bad_recv_wr,
 			   int rc)
@@ -4347,6 +4819,7 @@ _poller_submit_recvs(struct spdk_nvmf_rdma_transport *rtransport,
 		     struct spdk_nvmf_rdma_poller *rpoller)
 {
 	struct spdk_nvmf_rdma_qpair	*rqpair;
+	struct spdk_nvmf_rdma_poller_srq	*psrq;
 	struct ibv_recv_wr		*bad_recv_wr;
 	int				rc;
 
@@ -4355,6 +4828,12 @@ _poller_submit_recvs(struct spdk_nvmf_rdma_transport *rtransport,
 		if (rc) {
 			_poller_reset_failed_recvs(rpoller, bad_recv_wr, rc);
 		}
+		STAILQ_FOREACH(psrq, &rpoller->srqs, link) {
+			rc = spdk_rdma_srq_flush_recv_wrs(psrq->srq, &bad_recv_wr);
+			if (rc) {
+				_poller_reset_failed_recvs(rpoller, bad_recv_wr, rc);
+			}
+		}
 	} else {
 		while (!STAILQ_EMPTY(&rpoller->qpairs_pending_recv)) {
 			rqpair = STAILQ_FIRST(&rpoller->qpairs_pending_recv);
@@ -4557,8 +5036,9 @@ nvmf_rdma_poller_poll(struct spdk_nvmf_rdma_transport *rtransport,
 					int rc;
 
 					rdma_recv->wr.next = NULL;
-					spdk_rdma_srq_queue_recv_wrs(rpoller->srq, &rdma_recv->wr);
-					rc = spdk_rdma_srq_flush_recv_wrs(rpoller->srq, &bad_wr);
+					spdk_rdma_srq_queue_recv_wrs(rdma_recv->srq,
+								     &rdma_recv->wr);
+					rc = spdk_rdma_srq_flush_recv_wrs(rdma_recv->srq, &bad_wr);
 					if (rc) {
 						SPDK_ERRLOG("Failed to re-post recv WR to SRQ, err %d\n", rc);
 					}
@@ -4707,11 +5187,20 @@ nvmf_rdma_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 	struct spdk_nvmf_rdma_transport *rtransport;
 	struct spdk_nvmf_rdma_poll_group *rgroup;
 	struct spdk_nvmf_rdma_poller	*rpoller, *tmp;
+	struct spdk_nvmf_request	*req, *req_tmp;
+	struct spdk_nvmf_rdma_request	*rdma_req;
 	int				count, rc;
 
 	rtransport = SPDK_CONTAINEROF(group->transport, struct spdk_nvmf_rdma_transport, transport);
 	rgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_rdma_poll_group, group);
 
+	/* Retry the requests held back by QoS, the pollers submit the work they start. These may
+	 * belong to different namespaces, so keep going after one that's still throttled. */
+	STAILQ_FOREACH_SAFE(req, &group->pending_qos_queue, buf_link, req_tmp) {
+		rdma_req = SPDK_CONTAINEROF(req, struct spdk_nvmf_rdma_request, req);
+		nvmf_rdma_request_process(rtransport, rdma_req);
+	}
+
 	count = 0;
 	TAILQ_FOREACH_SAFE(rpoller, &rgroup->pollers, link, tmp) {
 		rc = nvmf_rdma_poller_poll(rtransport, rpoller);
@@ -4808,6 +5297,16 @@ nvmf_rdma_qpair_get_listen_trid(struct spdk_nvmf_qpair *qpair,
 	return nvmf_rdma_trid_from_cm_id(rqpair->listen_id, trid, false);
 }
 
+static uint32_t
+nvmf_rdma_qpair_get_in_capsule_data_size(struct spdk_nvmf_qpair *qpair)
+{
+	struct spdk_nvmf_rdma_qpair	*rqpair;
+
+	rqpair = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_rdma_qpair, qpair);
+
+	return rqpair->in_capsule_data_size;
+}
+
 void
 spdk_nvmf_rdma_init_hooks(struct spdk_nvme_rdma_hooks *hooks)
 {
@@ -4846,6 +5345,13 @@ _nvmf_rdma_qpair_abort_request(void *ctx)
 		}
 		break;
 
+	case RDMA_REQUEST_STATE_AWAITING_QOS:
+		STAILQ_REMOVE(&rqpair->poller->group->group.pending_qos_queue,
+			      &rdma_req_to_abort->req, spdk_nvmf_request, buf_link);
+
+		nvmf_rdma_request_set_abort_status(req, rdma_req_to_abort);
+		break;
+
 	case RDMA_REQUEST_STATE_NEED_BUFFER:
 		STAILQ_REMOVE(&rqpair->poller->group->group.pending_buf_queue,
 			      &rdma_req_to_abort->req, spdk_nvmf_request, buf_link);
@@ -4983,6 +5489,7 @@ const struct spdk_nvmf_transport_ops spdk_nvmf_transport_rdma = {
 	.destroy = nvmf_rdma_destroy,
 
 	.listen = nvmf_rdma_listen,
+	.listen_dump_opts = nvmf_rdma_listen_dump_opts,
 	.stop_listen = nvmf_rdma_stop_listen,
 	.cdata_init = nvmf_rdma_cdata_init,
 
@@ -5005,6 +5512,8 @@ const struct spdk_nvmf_transport_ops spdk_nvmf_transport_rdma = {
 	.qpair_abort_request = nvmf_rdma_qpair_abort_request,
 
 	.poll_group_dump_stat = nvmf_rdma_poll_group_dump_stat,
+
+	.qpair_get_in_capsule_data_size = nvmf_rdma_qpair_get_in_capsule_data_size,
 };
 
 SPDK_NVMF_TRANSPORT_REGISTER(rdma, &spdk_nvmf_transport_rdma);
@@ -43,6 +43,36 @@ enum spdk_nvmf_nqn_domain_states {
 	SPDK_NVMF_DOMAIN_ACCEPT_ANY = 2
 };
 
+/* Reservation changes are written to ptpl_file in batches by a worker thread
+ * shared by all namespaces, so that the subsystem threads never block on file
+ * I/O. A write started while none is in progress for the namespace carries all
+ * the changes made so far, and the requests which made them complete once it's
+ * done. Changes made while it is in progress are left to the next write,
+ * started when it completes.
+ */
+struct nvmf_ns_ptpl_waiter {
+	struct spdk_nvmf_request		*req;
+	TAILQ_ENTRY(nvmf_ns_ptpl_waiter)	link;
+};
+
+struct nvmf_ns_ptpl_write {
+	/* NULL if the namespace is removed meanwhile */
+	struct spdk_nvmf_ns			*ns;
+	struct spdk_thread			*thread;
+	char					*file;
+	struct spdk_nvmf_reservation_info	info;
+	int					rc;
+	TAILQ_HEAD(, nvmf_ns_ptpl_waiter)	waiters;
+	TAILQ_ENTRY(nvmf_ns_ptpl_write)		link;
+};
+
+static pthread_mutex_t g_ptpl_worker_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_ptpl_worker_cond = PTHREAD_COND_INITIALIZER;
+static TAILQ_HEAD(, nvmf_ns_ptpl_write) g_ptpl_writes = TAILQ_HEAD_INITIALIZER(g_ptpl_writes);
+static pthread_t g_ptpl_worker;
+static bool g_ptpl_worker_running;
+static bool g_ptpl_worker_exit;
+
 static int _nvmf_subsystem_destroy(struct spdk_nvmf_subsystem *subsystem);
 
 /* Returns true if is a valid ASCII string as defined by the NVMe spec */
@@ -1328,10 +1358,16 @@ spdk_nvmf_subsystem_remove_ns(struct spdk_nvmf_subsystem *subsystem, uint32_t ns
 
 	subsystem->ana_group[ns->anagrpid - 1]--;
 
+	/* Requests waiting for ptpl_file keep the subsystem from being paused */
+	assert(TAILQ_EMPTY(&ns->ptpl_waiters));
+	if (ns->ptpl_write != NULL) {
+		ns->ptpl_write->ns = NULL;
+	}
 	free(ns->ptpl_file);
 	nvmf_ns_reservation_clear_all_registrants(ns);
 	spdk_bdev_module_release_bdev(ns->bdev);
 	spdk_bdev_close(ns->desc);
+	free(ns->qos);
 	free(ns);
 
 	for (transport = spdk_nvmf_transport_get_first(subsystem->tgt); transport;
@@ -1723,6 +1759,7 @@ spdk_nvmf_subsystem_add_ns_ext(struct spdk_nvmf_subsystem *subsystem, const char
 	ns->anagrpid = opts.anagrpid;
 	subsystem->ana_group[ns->anagrpid - 1]++;
 	TAILQ_INIT(&ns->registrants);
+	TAILQ_INIT(&ns->ptpl_waiters);
 	if (ptpl_file) {
 		rc = nvmf_ns_load_reservation(ptpl_file, &info);
 		if (!rc) {
@@ -1838,6 +1875,93 @@ spdk_nvmf_ns_get_opts(const struct spdk_nvmf_ns *ns, struct spdk_nvmf_ns_opts *o
 	memcpy(opts, &ns->opts, spdk_min(sizeof(ns->opts), opts_size));
 }
 
+#define NVMF_NS_QOS_TIMESLICE_IN_USEC		1000
+#define NVMF_NS_QOS_MIN_IO_PER_TIMESLICE	1
+#define NVMF_NS_QOS_MIN_BYTE_PER_TIMESLICE	512
+
+static bool
+nvmf_ns_qos_is_iops_rate_limit(enum spdk_nvmf_ns_qos_rate_limit_type type)
+{
+	return type == SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT;
+}
+
+int
+spdk_nvmf_ns_set_qos_rate_limits(struct spdk_nvmf_ns *ns, const uint64_t *limits)
+{
+	struct spdk_nvmf_ns_qos *qos = ns->qos;
+	uint64_t limit, max_per_timeslice, min_per_timeslice;
+	bool enable = false;
+	int i;
+
+	for (i = 0; i < SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		if (!nvmf_ns_qos_is_iops_rate_limit(i) && limits[i] > UINT64_MAX / (1024 * 1024)) {
+			SPDK_ERRLOG("Rate limit %" PRIu64 " MB/s is out of range\n", limits[i]);
+			return -EINVAL;
+		}
+		enable |= limits[i] != 0;
+	}
+
+	if (qos == NULL) {
+		if (!enable) {
+			/* Nothing to disable */
+			return 0;
+		}
+
+		qos = calloc(1, sizeof(*qos));
+		if (qos == NULL) {
+			return -ENOMEM;
+		}
+		qos->timeslice_size = NVMF_NS_QOS_TIMESLICE_IN_USEC * spdk_get_ticks_hz() /
+				      SPDK_SEC_TO_USEC;
+		qos->last_timeslice = spdk_get_ticks();
+	}
+
+	for (i = 0; i < SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limit = limits[i];
+		if (nvmf_ns_qos_is_iops_rate_limit(i)) {
+			min_per_timeslice = NVMF_NS_QOS_MIN_IO_PER_TIMESLICE;
+		} else {
+			/* Change from megabyte to byte rate limit */
+			limit *= 1024 * 1024;
+			min_per_timeslice = NVMF_NS_QOS_MIN_BYTE_PER_TIMESLICE;
+		}
+
+		max_per_timeslice = 0;
+		if (limit != 0) {
+			max_per_timeslice = limit /
+					    (SPDK_SEC_TO_USEC / NVMF_NS_QOS_TIMESLICE_IN_USEC);
+			max_per_timeslice = spdk_max(max_per_timeslice, min_per_timeslice);
+		}
+
+		/* The poll groups may be reading these, but there's no harm in them picking up the
+		 * new limits one by one. */
+		qos->limits[i] = limit;
+		qos->max_per_timeslice[i] = max_per_timeslice;
+		__atomic_store_n(&qos->remaining_this_timeslice[i], (int64_t)max_per_timeslice,
+				 __ATOMIC_RELAXED);
+	}
+
+	if (ns->qos == NULL) {
+		__atomic_store_n(&ns->qos, qos, __ATOMIC_RELEASE);
+	}
+
+	return 0;
+}
+
+void
+spdk_nvmf_ns_get_qos_rate_limits(const struct spdk_nvmf_ns *ns, uint64_t *limits)
+{
+	int i;
+
+	for (i = 0; i < SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limits[i] = ns->qos ? ns->qos->limits[i] : 0;
+		if (!nvmf_ns_qos_is_iops_rate_limit(i)) {
+			/* Change from byte to megabyte which is user visible. */
+			limits[i] = limits[i] / 1024 / 1024;
+		}
+	}
+}
+
 const char *
 spdk_nvmf_subsystem_get_sn(const struct spdk_nvmf_subsystem *subsystem)
 {
@@ -1947,6 +2071,16 @@ nvmf_subsystem_set_cntlid_range(struct spdk_nvmf_subsystem *subsystem,
 	return 0;
 }
 
+SPDK_STATIC_ASSERT((NVMF_SUBSYSTEM_CTRLR_HASH_SIZE & (NVMF_SUBSYSTEM_CTRLR_HASH_SIZE - 1)) == 0,
+		   "The ctrlr hash size must be a power of 2");
+
+static inline struct nvmf_ctrlr_hash_bucket *
+nvmf_subsystem_ctrlr_bucket(struct spdk_nvmf_subsystem *subsystem, uint16_t cntlid)
+{
+	/* cntlids are mostly handed out sequentially, so there's no need for anything fancier */
+	return &subsystem->ctrlr_hash[cntlid & (NVMF_SUBSYSTEM_CTRLR_HASH_SIZE - 1)];
+}
+
 static uint16_t
 nvmf_subsystem_gen_cntlid(struct spdk_nvmf_subsystem *subsystem)
 {
@@ -1990,6 +2124,7 @@ nvmf_subsystem_add_ctrlr(struct spdk_nvmf_subsystem *subsystem, struct spdk_nvmf
 	}
 
 	TAILQ_INSERT_TAIL(&subsystem->ctrlrs, ctrlr, link);
+	LIST_INSERT_HEAD(nvmf_subsystem_ctrlr_bucket(subsystem, ctrlr->cntlid), ctrlr, hash_link);
 
 	SPDK_DTRACE_PROBE3(nvmf_subsystem_add_ctrlr, subsystem->subnqn, ctrlr, ctrlr->hostnqn);
 
@@ -2007,6 +2142,7 @@ nvmf_subsystem_remove_ctrlr(struct spdk_nvmf_subsystem *subsystem,
 	SPDK_DEBUGLOG(nvmf, "remove ctrlr %p id 0x%x from subsys %p %s\n", ctrlr, ctrlr->cntlid, subsystem,
 		      subsystem->subnqn);
 	TAILQ_REMOVE(&subsystem->ctrlrs, ctrlr, link);
+	LIST_REMOVE(ctrlr, hash_link);
 }
 
 struct spdk_nvmf_ctrlr *
@@ -2014,7 +2150,7 @@ nvmf_subsystem_get_ctrlr(struct spdk_nvmf_subsystem *subsystem, uint16_t cntlid)
 {
 	struct spdk_nvmf_ctrlr *ctrlr;
 
-	TAILQ_FOREACH(ctrlr, &subsystem->ctrlrs, link) {
+	LIST_FOREACH(ctrlr, nvmf_subsystem_ctrlr_bucket(subsystem, cntlid), hash_link) {
 		if (ctrlr->cntlid == cntlid) {
 			return ctrlr;
 		}
@@ -2302,41 +2438,224 @@ exit:
 	return rc;
 }
 
-static int
-nvmf_ns_update_reservation_info(struct spdk_nvmf_ns *ns)
+static void
+nvmf_ns_get_reservation_info(struct spdk_nvmf_ns *ns, struct spdk_nvmf_reservation_info *info)
 {
-	struct spdk_nvmf_reservation_info info;
 	struct spdk_nvmf_registrant *reg, *tmp;
 	uint32_t i = 0;
 
-	assert(ns != NULL);
-
-	if (!ns->bdev || !ns->ptpl_file) {
-		return 0;
-	}
-
-	memset(&info, 0, sizeof(info));
-	spdk_uuid_fmt_lower(info.bdev_uuid, sizeof(info.bdev_uuid), spdk_bdev_get_uuid(ns->bdev));
+	memset(info, 0, sizeof(*info));
+	spdk_uuid_fmt_lower(info->bdev_uuid, sizeof(info->bdev_uuid), spdk_bdev_get_uuid(ns->bdev));
 
 	if (ns->rtype) {
-		info.rtype = ns->rtype;
-		info.crkey = ns->crkey;
+		info->rtype = ns->rtype;
+		info->crkey = ns->crkey;
 		if (!nvmf_ns_reservation_all_registrants_type(ns)) {
 			assert(ns->holder != NULL);
-			spdk_uuid_fmt_lower(info.holder_uuid, sizeof(info.holder_uuid), &ns->holder->hostid);
+			spdk_uuid_fmt_lower(info->holder_uuid, sizeof(info->holder_uuid), &ns->holder->hostid);
 		}
 	}
 
 	TAILQ_FOREACH_SAFE(reg, &ns->registrants, link, tmp) {
-		spdk_uuid_fmt_lower(info.registrants[i].host_uuid, sizeof(info.registrants[i].host_uuid),
+		spdk_uuid_fmt_lower(info->registrants[i].host_uuid, sizeof(info->registrants[i].host_uuid),
 				    &reg->hostid);
-		info.registrants[i++].rkey = reg->rkey;
+		info->registrants[i++].rkey = reg->rkey;
+	}
+
+	info->num_regs = i;
+	info->ptpl_activated = ns->ptpl_activated;
+}
+
+static void nvmf_ns_reservation_update_sgroup(struct spdk_nvmf_request *req);
+
+static void
+nvmf_ns_ptpl_complete_waiters(struct nvmf_ns_ptpl_write *write)
+{
+	struct nvmf_ns_ptpl_waiter *waiter, *tmp;
+
+	TAILQ_FOREACH_SAFE(waiter, &write->waiters, link, tmp) {
+		TAILQ_REMOVE(&write->waiters, waiter, link);
+		if (write->rc != 0) {
+			waiter->req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+			waiter->req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		}
+		nvmf_ns_reservation_update_sgroup(waiter->req);
+		free(waiter);
+	}
+}
+
+static void nvmf_ns_ptpl_flush(struct spdk_nvmf_ns *ns);
+
+static void
+nvmf_ns_ptpl_write_done(void *ctx)
+{
+	struct nvmf_ns_ptpl_write *write = ctx;
+	struct spdk_nvmf_ns *ns = write->ns;
+
+	if (write->rc != 0) {
+		SPDK_ERRLOG("Failed to write reservation information to %s\n", write->file);
+	}
+
+	if (ns != NULL) {
+		ns->ptpl_write = NULL;
+		nvmf_ns_ptpl_flush(ns);
+	}
+
+	nvmf_ns_ptpl_complete_waiters(write);
+
+	free(write->file);
+	free(write);
+}
+
+static void *
+nvmf_ptpl_worker(void *ctx)
+{
+	struct nvmf_ns_ptpl_write *write;
+	int rc;
+
+	spdk_unaffinitize_thread();
+
+	pthread_mutex_lock(&g_ptpl_worker_mutex);
+	while (true) {
+		write = TAILQ_FIRST(&g_ptpl_writes);
+		if (write == NULL) {
+			if (g_ptpl_worker_exit) {
+				break;
+			}
+			pthread_cond_wait(&g_ptpl_worker_cond, &g_ptpl_worker_mutex);
+			continue;
+		}
+
+		TAILQ_REMOVE(&g_ptpl_writes, write, link);
+		pthread_mutex_unlock(&g_ptpl_worker_mutex);
+
+		write->rc = nvmf_ns_reservation_update(write->file, &write->info);
+		while ((rc = spdk_thread_send_msg(write->thread, nvmf_ns_ptpl_write_done,
+						  write)) == -ENOMEM) {
+			usleep(100);
+		}
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to complete the write of %s\n", write->file);
+		}
+
+		pthread_mutex_lock(&g_ptpl_worker_mutex);
+	}
+	pthread_mutex_unlock(&g_ptpl_worker_mutex);
+
+	return NULL;
+}
+
+/* Queue the write to the worker thread, starting it if it's not running yet */
+static int
+nvmf_ptpl_worker_submit(struct nvmf_ns_ptpl_write *write)
+{
+	int rc;
+
+	pthread_mutex_lock(&g_ptpl_worker_mutex);
+	if (!g_ptpl_worker_running) {
+		g_ptpl_worker_exit = false;
+		rc = pthread_create(&g_ptpl_worker, NULL, nvmf_ptpl_worker, NULL);
+		if (rc != 0) {
+			pthread_mutex_unlock(&g_ptpl_worker_mutex);
+			return -rc;
+		}
+		g_ptpl_worker_running = true;
+	}
+
+	TAILQ_INSERT_TAIL(&g_ptpl_writes, write, link);
+	pthread_cond_signal(&g_ptpl_worker_cond);
+	pthread_mutex_unlock(&g_ptpl_worker_mutex);
+
+	return 0;
+}
+
+void
+nvmf_ptpl_worker_stop(void)
+{
+	pthread_mutex_lock(&g_ptpl_worker_mutex);
+	if (!g_ptpl_worker_running) {
+		pthread_mutex_unlock(&g_ptpl_worker_mutex);
+		return;
+	}
+
+	/* The worker finishes the queued writes before exiting */
+	g_ptpl_worker_exit = true;
+	pthread_cond_signal(&g_ptpl_worker_cond);
+	pthread_mutex_unlock(&g_ptpl_worker_mutex);
+
+	pthread_join(g_ptpl_worker, NULL);
+	g_ptpl_worker_running = false;
+}
+
+static void
+nvmf_ns_ptpl_flush_in_place(struct spdk_nvmf_ns *ns)
+{
+	struct nvmf_ns_ptpl_write write = {};
+
+	write.file = ns->ptpl_file;
+	nvmf_ns_get_reservation_info(ns, &write.info);
+	TAILQ_INIT(&write.waiters);
+	TAILQ_CONCAT(&write.waiters, &ns->ptpl_waiters, link);
+	ns->ptpl_updates_written = ns->ptpl_updates;
+
+	write.rc = nvmf_ns_reservation_update(write.file, &write.info);
+	if (write.rc != 0) {
+		SPDK_ERRLOG("Failed to write reservation information to %s\n", write.file);
+	}
+
+	nvmf_ns_ptpl_complete_waiters(&write);
+}
+
+static void
+nvmf_ns_ptpl_flush(struct spdk_nvmf_ns *ns)
+{
+	struct nvmf_ns_ptpl_write *write;
+	int rc;
+
+	if (ns->ptpl_write != NULL || ns->ptpl_updates == ns->ptpl_updates_written) {
+		return;
 	}
 
-	info.num_regs = i;
-	info.ptpl_activated = ns->ptpl_activated;
+	write = calloc(1, sizeof(*write));
+	if (write == NULL) {
+		nvmf_ns_ptpl_flush_in_place(ns);
+		return;
+	}
 
-	return nvmf_ns_reservation_update(ns->ptpl_file, &info);
+	write->file = strdup(ns->ptpl_file);
+	if (write->file == NULL) {
+		free(write);
+		nvmf_ns_ptpl_flush_in_place(ns);
+		return;
+	}
+
+	write->ns = ns;
+	write->thread = spdk_get_thread();
+	nvmf_ns_get_reservation_info(ns, &write->info);
+	TAILQ_INIT(&write->waiters);
+	TAILQ_CONCAT(&write->waiters, &ns->ptpl_waiters, link);
+	ns->ptpl_updates_written = ns->ptpl_updates;
+	ns->ptpl_write = write;
+
+	rc = nvmf_ptpl_worker_submit(write);
+	if (rc != 0) {
+		SPDK_NOTICELOG("Can't start the PTPL worker to write %s, writing it in place\n",
+			       write->file);
+		write->rc = nvmf_ns_reservation_update(write->file, &write->info);
+		nvmf_ns_ptpl_write_done(write);
+	}
+}
+
+static void
+nvmf_ns_update_reservation_info(struct spdk_nvmf_ns *ns)
+{
+	assert(ns != NULL);
+
+	if (!ns->bdev || !ns->ptpl_file) {
+		return;
+	}
+
+	ns->ptpl_updates++;
 }
 
 static struct spdk_nvmf_registrant *
@@ -2720,10 +3039,7 @@ nvmf_ns_reservation_register(struct spdk_nvmf_ns *ns,
 
 exit:
 	if (update_sgroup) {
-		rc = nvmf_ns_update_reservation_info(ns);
-		if (rc != 0) {
-			status = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
-		}
+		nvmf_ns_update_reservation_info(ns);
 	}
 	req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
 	req->rsp->nvme_cpl.status.sc = status;
@@ -2890,9 +3206,7 @@ exit:
 		}
 	}
 	if (update_sgroup && ns->ptpl_activated) {
-		if (nvmf_ns_update_reservation_info(ns)) {
-			status = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
-		}
+		nvmf_ns_update_reservation_info(ns);
 	}
 	req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
 	req->rsp->nvme_cpl.status.sc = status;
@@ -2997,9 +3311,7 @@ nvmf_ns_reservation_release(struct spdk_nvmf_ns *ns,
 
 exit:
 	if (update_sgroup && ns->ptpl_activated) {
-		if (nvmf_ns_update_reservation_info(ns)) {
-			status = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
-		}
+		nvmf_ns_update_reservation_info(ns);
 	}
 	req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
 	req->rsp->nvme_cpl.status.sc = status;
@@ -3098,20 +3410,42 @@ _nvmf_ns_reservation_update_done(struct spdk_nvmf_subsystem *subsystem,
 	spdk_thread_send_msg(group->thread, nvmf_ns_reservation_complete, req);
 }
 
+static void
+nvmf_ns_reservation_update_sgroup(struct spdk_nvmf_request *req)
+{
+	struct spdk_nvmf_ctrlr *ctrlr = req->qpair->ctrlr;
+	struct subsystem_update_ns_ctx *update_ctx;
+
+	/* update reservation information to subsystem's poll group */
+	update_ctx = calloc(1, sizeof(*update_ctx));
+	if (update_ctx == NULL) {
+		SPDK_ERRLOG("Can't alloc subsystem poll group update context\n");
+		_nvmf_ns_reservation_update_done(ctrlr->subsys, (void *)req, 0);
+		return;
+	}
+	update_ctx->subsystem = ctrlr->subsys;
+	update_ctx->cb_fn = _nvmf_ns_reservation_update_done;
+	update_ctx->cb_arg = req;
+
+	nvmf_subsystem_update_ns(ctrlr->subsys, subsystem_update_ns_done, update_ctx);
+}
+
 void
 nvmf_ns_reservation_request(void *ctx)
 {
 	struct spdk_nvmf_request *req = (struct spdk_nvmf_request *)ctx;
 	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
 	struct spdk_nvmf_ctrlr *ctrlr = req->qpair->ctrlr;
-	struct subsystem_update_ns_ctx *update_ctx;
+	struct nvmf_ns_ptpl_waiter *waiter;
 	uint32_t nsid;
 	struct spdk_nvmf_ns *ns;
 	bool update_sgroup = false;
+	uint64_t ptpl_updates;
 
 	nsid = cmd->nsid;
 	ns = _nvmf_subsystem_get_ns(ctrlr->subsys, nsid);
 	assert(ns != NULL);
+	ptpl_updates = ns->ptpl_updates;
 
 	switch (cmd->opc) {
 	case SPDK_NVME_OPC_RESERVATION_REGISTER:
@@ -3130,22 +3464,26 @@ nvmf_ns_reservation_request(void *ctx)
 		break;
 	}
 
-	/* update reservation information to subsystem's poll group */
-	if (update_sgroup) {
-		update_ctx = calloc(1, sizeof(*update_ctx));
-		if (update_ctx == NULL) {
-			SPDK_ERRLOG("Can't alloc subsystem poll group update context\n");
-			goto update_done;
+	/* The change is only complete once it's written to ptpl_file */
+	if (ns->ptpl_updates != ptpl_updates) {
+		assert(update_sgroup);
+		waiter = calloc(1, sizeof(*waiter));
+		if (waiter != NULL) {
+			waiter->req = req;
+			TAILQ_INSERT_TAIL(&ns->ptpl_waiters, waiter, link);
+			nvmf_ns_ptpl_flush(ns);
+			return;
 		}
-		update_ctx->subsystem = ctrlr->subsys;
-		update_ctx->cb_fn = _nvmf_ns_reservation_update_done;
-		update_ctx->cb_arg = req;
+		SPDK_ERRLOG("Can't alloc reservation persistence waiter, not waiting for %s\n",
+			    ns->ptpl_file);
+		nvmf_ns_ptpl_flush(ns);
+	}
 
-		nvmf_subsystem_update_ns(ctrlr->subsys, subsystem_update_ns_done, update_ctx);
+	if (update_sgroup) {
+		nvmf_ns_reservation_update_sgroup(req);
 		return;
 	}
 
-update_done:
 	_nvmf_ns_reservation_update_done(ctrlr->subsys, (void *)req, 0);
 }
 
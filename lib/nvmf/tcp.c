@@ -29,6 +29,7 @@
 #define SPDK_NVMF_TCP_DEFAULT_SOCK_PRIORITY 0
 #define SPDK_NVMF_TCP_DEFAULT_CONTROL_MSG_NUM 32
 #define SPDK_NVMF_TCP_DEFAULT_SUCCESS_OPTIMIZATION true
+#define SPDK_NVMF_TCP_SEND_BUF_SIZE (64 * 1024)
 
 #define SPDK_NVMF_TCP_MIN_IO_QUEUE_DEPTH 2
 #define SPDK_NVMF_TCP_MAX_IO_QUEUE_DEPTH 65535
@@ -57,44 +58,47 @@ enum spdk_nvmf_tcp_req_state {
 	/* Initial state when request first received */
 	TCP_REQUEST_STATE_NEW = 1,
 
+	/* The request is queued until the QoS rate limits of its namespace allow it. */
+	TCP_REQUEST_STATE_AWAITING_QOS = 2,
+
 	/* The request is queued until a data buffer is available. */
-	TCP_REQUEST_STATE_NEED_BUFFER = 2,
+	TCP_REQUEST_STATE_NEED_BUFFER = 3,
 
 	/* The request is waiting for zcopy_start to finish */
-	TCP_REQUEST_STATE_AWAITING_ZCOPY_START = 3,
+	TCP_REQUEST_STATE_AWAITING_ZCOPY_START = 4,
 
 	/* The request has received a zero-copy buffer */
-	TCP_REQUEST_STATE_ZCOPY_START_COMPLETED = 4,
+	TCP_REQUEST_STATE_ZCOPY_START_COMPLETED = 5,
 
 	/* The request is currently transferring data from the host to the controller. */
-	TCP_REQUEST_STATE_TRANSFERRING_HOST_TO_CONTROLLER = 5,
+	TCP_REQUEST_STATE_TRANSFERRING_HOST_TO_CONTROLLER = 6,
 
 	/* The request is waiting for the R2T send acknowledgement. */
-	TCP_REQUEST_STATE_AWAITING_R2T_ACK = 6,
+	TCP_REQUEST_STATE_AWAITING_R2T_ACK = 7,
 
 	/* The request is ready to execute at the block device */
-	TCP_REQUEST_STATE_READY_TO_EXECUTE = 7,
+	TCP_REQUEST_STATE_READY_TO_EXECUTE = 8,
 
 	/* The request is currently executing at the block device */
-	TCP_REQUEST_STATE_EXECUTING = 8,
+	TCP_REQUEST_STATE_EXECUTING = 9,
 
 	/* The request is waiting for zcopy buffers to be committed */
-	TCP_REQUEST_STATE_AWAITING_ZCOPY_COMMIT = 9,
+	TCP_REQUEST_STATE_AWAITING_ZCOPY_COMMIT = 10,
 
 	/* The request finished executing at the block device */
-	TCP_REQUEST_STATE_EXECUTED = 10,
+	TCP_REQUEST_STATE_EXECUTED = 11,
 
 	/* The request is ready to send a completion */
-	TCP_REQUEST_STATE_READY_TO_COMPLETE = 11,
+	TCP_REQUEST_STATE_READY_TO_COMPLETE = 12,
 
 	/* The request is currently transferring final pdus from the controller to the host. */
-	TCP_REQUEST_STATE_TRANSFERRING_CONTROLLER_TO_HOST = 12,
+	TCP_REQUEST_STATE_TRANSFERRING_CONTROLLER_TO_HOST = 13,
 
 	/* The request is waiting for zcopy buffers to be released (without committing) */
-	TCP_REQUEST_STATE_AWAITING_ZCOPY_RELEASE = 13,
+	TCP_REQUEST_STATE_AWAITING_ZCOPY_RELEASE = 14,
 
 	/* The request completed and can be marked free. */
-	TCP_REQUEST_STATE_COMPLETED = 14,
+	TCP_REQUEST_STATE_COMPLETED = 15,
 
 	/* Terminator */
 	TCP_REQUEST_NUM_STATES,
@@ -117,6 +121,10 @@ SPDK_TRACE_REGISTER_FN(nvmf_tcp_trace, "nvmf_tcp", TRACE_GROUP_NVMF_TCP)
 					TRACE_TCP_REQUEST_STATE_NEW,
 					OWNER_NVMF_TCP, OBJECT_NVMF_TCP_IO, 1,
 					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
+	spdk_trace_register_description("TCP_REQ_AWAIT_QOS",
+					TRACE_TCP_REQUEST_STATE_AWAIT_QOS,
+					OWNER_NVMF_TCP, OBJECT_NVMF_TCP_IO, 0,
+					SPDK_TRACE_ARG_TYPE_PTR, "qpair");
 	spdk_trace_register_description("TCP_REQ_NEED_BUFFER",
 					TRACE_TCP_REQUEST_STATE_NEED_BUFFER,
 					OWNER_NVMF_TCP, OBJECT_NVMF_TCP_IO, 0,
@@ -230,6 +238,8 @@ struct spdk_nvmf_tcp_req  {
 	 */
 	bool					pdu_in_use;
 	bool					has_in_capsule_data;
+	/* The in-capsule data buffer was taken from the qpair's shared list */
+	bool					has_shared_icd_buf;
 	bool					fused_failed;
 
 	/* transfer_tag */
@@ -246,6 +256,24 @@ struct spdk_nvmf_tcp_req  {
 	TAILQ_ENTRY(spdk_nvmf_tcp_req)		state_link;
 };
 
+/* Buffer collecting small PDUs of a qpair, sent to the socket as a single request */
+struct spdk_nvmf_tcp_send_buf {
+	/* The sock request ends with a 0 length iovec, the iovec must follow it */
+	struct spdk_sock_request		sock_req;
+	struct iovec				iov;
+
+	struct spdk_nvmf_tcp_qpair		*tqpair;
+	uint8_t					*buf;
+	uint32_t				len;
+	/* The buffer was handed over to the socket and can't be filled anymore */
+	bool					submitted;
+	/* PDUs copied into the buffer, completed once it is sent */
+	TAILQ_HEAD(, nvme_tcp_pdu)		pdus;
+};
+SPDK_STATIC_ASSERT(offsetof(struct spdk_nvmf_tcp_send_buf, sock_req) +
+		   sizeof(struct spdk_sock_request) == offsetof(struct spdk_nvmf_tcp_send_buf, iov),
+		   "Compiler inserted padding between iov and sock_req");
+
 struct spdk_nvmf_tcp_qpair {
 	struct spdk_nvmf_qpair			qpair;
 	struct spdk_nvmf_tcp_poll_group		*group;
@@ -287,6 +315,24 @@ struct spdk_nvmf_tcp_qpair {
 	uint32_t				resource_count;
 	uint32_t				recv_buf_size;
 
+	/* In-capsule buffers shared by the requests when in_capsule_buf_num is
+	 * smaller than the queue depth. bufs is NULL in that case. */
+	struct spdk_nvmf_tcp_control_msg_list	*icd_buf_list;
+	/* Request waiting for a buffer from icd_buf_list */
+	struct spdk_nvmf_tcp_req		*icd_buf_waiter;
+
+	/* Only allocated when PDU coalescing is enabled */
+	struct spdk_nvmf_tcp_send_buf		*send_buf;
+	/* Linked in the poll group while send_buf holds PDUs to submit */
+	TAILQ_ENTRY(spdk_nvmf_tcp_qpair)	send_link;
+
+	/* Set while the qpair is moved to another poll group. No new PDU is read
+	 * and migrate_cb_fn is called once the requests in flight are done. */
+	bool					migrating;
+	spdk_nvmf_transport_qpair_quiesce_cb	migrate_cb_fn;
+	void					*migrate_cb_arg;
+	TAILQ_ENTRY(spdk_nvmf_tcp_qpair)	migrate_link;
+
 	struct spdk_nvmf_tcp_port		*port;
 
 	/* IP address */
@@ -323,6 +369,10 @@ struct spdk_nvmf_tcp_poll_group {
 
 	TAILQ_HEAD(, spdk_nvmf_tcp_qpair)	qpairs;
 	TAILQ_HEAD(, spdk_nvmf_tcp_qpair)	await_req;
+	/* qpairs with coalesced PDUs waiting to be submitted to their socket */
+	TAILQ_HEAD(, spdk_nvmf_tcp_qpair)	send_pending;
+	/* qpairs waiting for their requests to complete before being moved */
+	TAILQ_HEAD(, spdk_nvmf_tcp_qpair)	migrating;
 
 	struct spdk_io_channel			*accel_channel;
 	struct spdk_nvmf_tcp_control_msg_list	*control_msg_list;
@@ -340,6 +390,8 @@ struct tcp_transport_opts {
 	bool		c2h_success;
 	uint16_t	control_msg_num;
 	uint32_t	sock_priority;
+	uint16_t	in_capsule_buf_num;
+	uint32_t	pdu_coalesce_size;
 };
 
 struct spdk_nvmf_tcp_transport {
@@ -367,6 +419,14 @@ static const struct spdk_json_object_decoder tcp_transport_opts_decoder[] = {
 		"sock_priority", offsetof(struct tcp_transport_opts, sock_priority),
 		spdk_json_decode_uint32, true
 	},
+	{
+		"in_capsule_buf_num", offsetof(struct tcp_transport_opts, in_capsule_buf_num),
+		spdk_json_decode_uint16, true
+	},
+	{
+		"pdu_coalesce_size", offsetof(struct tcp_transport_opts, pdu_coalesce_size),
+		spdk_json_decode_uint32, true
+	},
 };
 
 static bool nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
@@ -375,6 +435,10 @@ static void nvmf_tcp_poll_group_destroy(struct spdk_nvmf_transport_poll_group *g
 
 static void _nvmf_tcp_send_c2h_data(struct spdk_nvmf_tcp_qpair *tqpair,
 				    struct spdk_nvmf_tcp_req *tcp_req);
+static struct spdk_nvmf_tcp_control_msg_list *nvmf_tcp_control_msg_list_create(
+	uint16_t num_messages, uint32_t msg_size);
+static void nvmf_tcp_control_msg_list_free(struct spdk_nvmf_tcp_control_msg_list *list);
+static void nvmf_tcp_qpair_submit_send_buf(struct spdk_nvmf_tcp_qpair *tqpair);
 
 static inline void
 nvmf_tcp_req_set_state(struct spdk_nvmf_tcp_req *tcp_req,
@@ -417,6 +481,7 @@ nvmf_tcp_req_get(struct spdk_nvmf_tcp_qpair *tqpair)
 	memset(&tcp_req->rsp, 0, sizeof(tcp_req->rsp));
 	tcp_req->h2c_offset = 0;
 	tcp_req->has_in_capsule_data = false;
+	tcp_req->has_shared_icd_buf = false;
 	tcp_req->req.dif_enabled = false;
 	tcp_req->req.zcopy_phase = NVMF_ZCOPY_PHASE_NONE;
 
@@ -483,14 +548,19 @@ nvmf_tcp_cleanup_all_states(struct spdk_nvmf_tcp_qpair *tqpair)
 	nvmf_tcp_drain_state_queue(tqpair, TCP_REQUEST_STATE_TRANSFERRING_CONTROLLER_TO_HOST);
 	nvmf_tcp_drain_state_queue(tqpair, TCP_REQUEST_STATE_NEW);
 
-	/* Wipe the requests waiting for buffer from the global list */
+	/* Wipe the requests waiting for QoS or buffer from the global lists */
 	TAILQ_FOREACH_SAFE(tcp_req, &tqpair->tcp_req_working_queue, state_link, req_tmp) {
-		if (tcp_req->state == TCP_REQUEST_STATE_NEED_BUFFER) {
+		if (tcp_req->state == TCP_REQUEST_STATE_AWAITING_QOS) {
+			STAILQ_REMOVE(&tqpair->group->group.pending_qos_queue, &tcp_req->req,
+				      spdk_nvmf_request, buf_link);
+		} else if (tcp_req->state == TCP_REQUEST_STATE_NEED_BUFFER) {
 			STAILQ_REMOVE(&tqpair->group->group.pending_buf_queue, &tcp_req->req,
 				      spdk_nvmf_request, buf_link);
 		}
 	}
+	tqpair->icd_buf_waiter = NULL;
 
+	nvmf_tcp_drain_state_queue(tqpair, TCP_REQUEST_STATE_AWAITING_QOS);
 	nvmf_tcp_drain_state_queue(tqpair, TCP_REQUEST_STATE_NEED_BUFFER);
 	nvmf_tcp_drain_state_queue(tqpair, TCP_REQUEST_STATE_EXECUTING);
 	nvmf_tcp_drain_state_queue(tqpair, TCP_REQUEST_STATE_TRANSFERRING_HOST_TO_CONTROLLER);
@@ -527,6 +597,8 @@ _nvmf_tcp_qpair_destroy(void *_tqpair)
 
 	SPDK_DEBUGLOG(nvmf_tcp, "enter\n");
 
+	/* Hand the coalesced PDUs over to the socket, so that closing it completes them */
+	nvmf_tcp_qpair_submit_send_buf(tqpair);
 	err = spdk_sock_close(&tqpair->sock);
 	assert(err == 0);
 	nvmf_tcp_cleanup_all_states(tqpair);
@@ -549,6 +621,11 @@ _nvmf_tcp_qpair_destroy(void *_tqpair)
 	spdk_dma_free(tqpair->pdus);
 	free(tqpair->reqs);
 	spdk_free(tqpair->bufs);
+	nvmf_tcp_control_msg_list_free(tqpair->icd_buf_list);
+	if (tqpair->send_buf) {
+		spdk_free(tqpair->send_buf->buf);
+		free(tqpair->send_buf);
+	}
 	free(tqpair);
 
 	if (cb_fn != NULL) {
@@ -577,6 +654,10 @@ nvmf_tcp_dump_opts(struct spdk_nvmf_transport *transport, struct spdk_json_write
 	ttransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_tcp_transport, transport);
 	spdk_json_write_named_bool(w, "c2h_success", ttransport->tcp_opts.c2h_success);
 	spdk_json_write_named_uint32(w, "sock_priority", ttransport->tcp_opts.sock_priority);
+	spdk_json_write_named_uint32(w, "in_capsule_buf_num",
+				     ttransport->tcp_opts.in_capsule_buf_num);
+	spdk_json_write_named_uint32(w, "pdu_coalesce_size",
+				     ttransport->tcp_opts.pdu_coalesce_size);
 }
 
 static int
@@ -636,7 +717,8 @@ nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 		     "  in_capsule_data_size=%d, max_aq_depth=%d\n"
 		     "  num_shared_buffers=%d, c2h_success=%d,\n"
 		     "  dif_insert_or_strip=%d, sock_priority=%d\n"
-		     "  abort_timeout_sec=%d, control_msg_num=%hu\n",
+		     "  abort_timeout_sec=%d, control_msg_num=%hu\n"
+		     "  in_capsule_buf_num=%hu, pdu_coalesce_size=%u\n",
 		     opts->max_queue_depth,
 		     opts->max_io_size,
 		     opts->max_qpairs_per_ctrlr - 1,
@@ -648,7 +730,9 @@ nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 		     opts->dif_insert_or_strip,
 		     ttransport->tcp_opts.sock_priority,
 		     opts->abort_timeout_sec,
-		     ttransport->tcp_opts.control_msg_num);
+		     ttransport->tcp_opts.control_msg_num,
+		     ttransport->tcp_opts.in_capsule_buf_num,
+		     ttransport->tcp_opts.pdu_coalesce_size);
 
 	if (ttransport->tcp_opts.sock_priority > SPDK_NVMF_TCP_DEFAULT_MAX_SOCK_PRIORITY) {
 		SPDK_ERRLOG("Unsupported socket_priority=%d, the current range is: 0 to %d\n"
@@ -665,6 +749,13 @@ nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 		ttransport->tcp_opts.control_msg_num = SPDK_NVMF_TCP_DEFAULT_CONTROL_MSG_NUM;
 	}
 
+	if (ttransport->tcp_opts.pdu_coalesce_size > SPDK_NVMF_TCP_SEND_BUF_SIZE) {
+		SPDK_WARNLOG("TCP param pdu_coalesce_size %u can't be larger than %u. Using %u\n",
+			     ttransport->tcp_opts.pdu_coalesce_size, SPDK_NVMF_TCP_SEND_BUF_SIZE,
+			     SPDK_NVMF_TCP_SEND_BUF_SIZE);
+		ttransport->tcp_opts.pdu_coalesce_size = SPDK_NVMF_TCP_SEND_BUF_SIZE;
+	}
+
 	/* I/O unit size cannot be larger than max I/O size */
 	if (opts->io_unit_size > opts->max_io_size) {
 		SPDK_WARNLOG("TCP param io_unit_size %u can't be larger than max_io_size %u. Using max_io_size as io_unit_size\n",
@@ -953,6 +1044,79 @@ _pdu_write_done(struct nvme_tcp_pdu *pdu, int err)
 	pdu->sock_req.cb_fn(pdu->sock_req.cb_arg, err);
 }
 
+static void
+_send_buf_write_done(void *cb_arg, int err)
+{
+	struct spdk_nvmf_tcp_send_buf *send_buf = cb_arg;
+	struct nvme_tcp_pdu *pdu, *tmp;
+	TAILQ_HEAD(, nvme_tcp_pdu) pdus = TAILQ_HEAD_INITIALIZER(pdus);
+
+	/* The PDU callbacks may write new PDUs, so let them fill the buffer again */
+	TAILQ_SWAP(&pdus, &send_buf->pdus, nvme_tcp_pdu, tailq);
+	send_buf->len = 0;
+	send_buf->submitted = false;
+
+	TAILQ_FOREACH_SAFE(pdu, &pdus, tailq, tmp) {
+		TAILQ_REMOVE(&pdus, pdu, tailq);
+		_pdu_write_done(pdu, err);
+	}
+}
+
+static void
+nvmf_tcp_qpair_submit_send_buf(struct spdk_nvmf_tcp_qpair *tqpair)
+{
+	struct spdk_nvmf_tcp_send_buf *send_buf = tqpair->send_buf;
+
+	if (send_buf == NULL || send_buf->len == 0 || send_buf->submitted) {
+		return;
+	}
+
+	TAILQ_REMOVE(&tqpair->group->send_pending, tqpair, send_link);
+	send_buf->submitted = true;
+	send_buf->iov.iov_base = send_buf->buf;
+	send_buf->iov.iov_len = send_buf->len;
+	send_buf->sock_req.iovcnt = 1;
+	spdk_sock_writev_async(tqpair->sock, &send_buf->sock_req);
+}
+
+/* Copy a small PDU into the qpair's send buffer instead of queueing it on its own. The buffer
+ * is submitted before the next socket poll, or earlier if a PDU has to be written directly. */
+static bool
+nvmf_tcp_qpair_coalesce_pdu(struct spdk_nvmf_tcp_qpair *tqpair, struct nvme_tcp_pdu *pdu,
+			    uint32_t length)
+{
+	struct spdk_nvmf_tcp_send_buf *send_buf = tqpair->send_buf;
+	struct spdk_nvmf_tcp_transport *ttransport;
+
+	if (send_buf == NULL || send_buf->submitted || tqpair->group == NULL ||
+	    pdu->hdr.common.pdu_type == SPDK_NVME_TCP_PDU_TYPE_IC_RESP ||
+	    pdu->hdr.common.pdu_type == SPDK_NVME_TCP_PDU_TYPE_C2H_TERM_REQ) {
+		return false;
+	}
+
+	ttransport = SPDK_CONTAINEROF(tqpair->qpair.transport, struct spdk_nvmf_tcp_transport,
+				      transport);
+	if (length > ttransport->tcp_opts.pdu_coalesce_size) {
+		return false;
+	}
+
+	if (send_buf->len + length > SPDK_NVMF_TCP_SEND_BUF_SIZE) {
+		nvmf_tcp_qpair_submit_send_buf(tqpair);
+		return false;
+	}
+
+	if (send_buf->len == 0) {
+		TAILQ_INSERT_TAIL(&tqpair->group->send_pending, tqpair, send_link);
+	}
+
+	spdk_copy_iovs_to_buf(send_buf->buf + send_buf->len, length, pdu->iov,
+			      pdu->sock_req.iovcnt);
+	send_buf->len += length;
+	TAILQ_INSERT_TAIL(&send_buf->pdus, pdu, tailq);
+
+	return true;
+}
+
 static void
 _tcp_write_pdu(struct nvme_tcp_pdu *pdu)
 {
@@ -962,6 +1126,12 @@ _tcp_write_pdu(struct nvme_tcp_pdu *pdu)
 
 	pdu->sock_req.iovcnt = nvme_tcp_build_iovs(pdu->iov, SPDK_COUNTOF(pdu->iov), pdu,
 			       tqpair->host_hdgst_enable, tqpair->host_ddgst_enable, &mapped_length);
+	if (nvmf_tcp_qpair_coalesce_pdu(tqpair, pdu, mapped_length)) {
+		return;
+	}
+
+	/* Keep the PDUs in order */
+	nvmf_tcp_qpair_submit_send_buf(tqpair);
 	spdk_sock_writev_async(tqpair->sock, &pdu->sock_req);
 
 	if (pdu->hdr.common.pdu_type == SPDK_NVME_TCP_PDU_TYPE_IC_RESP ||
@@ -1084,9 +1254,13 @@ nvmf_tcp_qpair_init_mem_resource(struct spdk_nvmf_tcp_qpair *tqpair)
 {
 	uint32_t i;
 	struct spdk_nvmf_transport_opts *opts;
+	struct spdk_nvmf_tcp_transport *ttransport;
 	uint32_t in_capsule_data_size;
+	uint16_t in_capsule_buf_num;
 
 	opts = &tqpair->qpair.transport->opts;
+	ttransport = SPDK_CONTAINEROF(tqpair->qpair.transport, struct spdk_nvmf_tcp_transport,
+				      transport);
 
 	in_capsule_data_size = opts->in_capsule_data_size;
 	if (opts->dif_insert_or_strip) {
@@ -1101,7 +1275,17 @@ nvmf_tcp_qpair_init_mem_resource(struct spdk_nvmf_tcp_qpair *tqpair)
 		return -1;
 	}
 
-	if (in_capsule_data_size) {
+	in_capsule_buf_num = ttransport->tcp_opts.in_capsule_buf_num;
+	if (in_capsule_data_size && in_capsule_buf_num &&
+	    in_capsule_buf_num < tqpair->resource_count) {
+		/* Fewer buffers than requests, the requests take them from a shared list */
+		tqpair->icd_buf_list = nvmf_tcp_control_msg_list_create(in_capsule_buf_num,
+				       in_capsule_data_size);
+		if (!tqpair->icd_buf_list) {
+			SPDK_ERRLOG("Unable to allocate ICD buffers on tqpair=%p.\n", tqpair);
+			return -1;
+		}
+	} else if (in_capsule_data_size) {
 		tqpair->bufs = spdk_zmalloc(tqpair->resource_count * in_capsule_data_size, 0x1000,
 					    NULL, SPDK_ENV_LCORE_ID_ANY,
 					    SPDK_MALLOC_DMA);
@@ -1110,6 +1294,24 @@ nvmf_tcp_qpair_init_mem_resource(struct spdk_nvmf_tcp_qpair *tqpair)
 			return -1;
 		}
 	}
+	if (ttransport->tcp_opts.pdu_coalesce_size) {
+		tqpair->send_buf = calloc(1, sizeof(*tqpair->send_buf));
+		if (!tqpair->send_buf) {
+			SPDK_ERRLOG("Unable to allocate send buffer on tqpair=%p.\n", tqpair);
+			return -1;
+		}
+		tqpair->send_buf->buf = spdk_zmalloc(SPDK_NVMF_TCP_SEND_BUF_SIZE, 0x1000, NULL,
+						     SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+		if (!tqpair->send_buf->buf) {
+			SPDK_ERRLOG("Unable to allocate send buffer on tqpair=%p.\n", tqpair);
+			return -1;
+		}
+		tqpair->send_buf->tqpair = tqpair;
+		tqpair->send_buf->sock_req.cb_fn = _send_buf_write_done;
+		tqpair->send_buf->sock_req.cb_arg = tqpair->send_buf;
+		TAILQ_INIT(&tqpair->send_buf->pdus);
+	}
+
 	/* prepare memory space for receiving pdus and tcp_req */
 	/* Add additional 1 member, which will be used for mgmt_pdu owned by the tqpair */
 	tqpair->pdus = spdk_dma_zmalloc((2 * tqpair->resource_count + 1) * sizeof(*tqpair->pdus), 0x1000,
@@ -1291,7 +1493,7 @@ nvmf_tcp_discover(struct spdk_nvmf_transport *transport,
 }
 
 static struct spdk_nvmf_tcp_control_msg_list *
-nvmf_tcp_control_msg_list_create(uint16_t num_messages)
+nvmf_tcp_control_msg_list_create(uint16_t num_messages, uint32_t msg_size)
 {
 	struct spdk_nvmf_tcp_control_msg_list *list;
 	struct spdk_nvmf_tcp_control_msg *msg;
@@ -1303,8 +1505,8 @@ nvmf_tcp_control_msg_list_create(uint16_t num_messages)
 		return NULL;
 	}
 
-	list->msg_buf = spdk_zmalloc(num_messages * SPDK_NVME_TCP_IN_CAPSULE_DATA_MAX_SIZE,
-				     NVMF_DATA_BUFFER_ALIGNMENT, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	list->msg_buf = spdk_zmalloc(num_messages * msg_size, NVMF_DATA_BUFFER_ALIGNMENT, NULL,
+				     SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
 	if (!list->msg_buf) {
 		SPDK_ERRLOG("Failed to allocate memory for control message buffers\n");
 		free(list);
@@ -1314,8 +1516,7 @@ nvmf_tcp_control_msg_list_create(uint16_t num_messages)
 	STAILQ_INIT(&list->free_msgs);
 
 	for (i = 0; i < num_messages; i++) {
-		msg = (struct spdk_nvmf_tcp_control_msg *)((char *)list->msg_buf + i *
-				SPDK_NVME_TCP_IN_CAPSULE_DATA_MAX_SIZE);
+		msg = (struct spdk_nvmf_tcp_control_msg *)((char *)list->msg_buf + i * msg_size);
 		STAILQ_INSERT_TAIL(&list->free_msgs, msg, link);
 	}
 
@@ -1352,6 +1553,8 @@ nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport,
 
 	TAILQ_INIT(&tgroup->qpairs);
 	TAILQ_INIT(&tgroup->await_req);
+	TAILQ_INIT(&tgroup->send_pending);
+	TAILQ_INIT(&tgroup->migrating);
 
 	ttransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_tcp_transport, transport);
 
@@ -1359,7 +1562,9 @@ nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport,
 		SPDK_DEBUGLOG(nvmf_tcp, "ICD %u is less than min required for admin/fabric commands (%u). "
 			      "Creating control messages list\n", transport->opts.in_capsule_data_size,
 			      SPDK_NVME_TCP_IN_CAPSULE_DATA_MAX_SIZE);
-		tgroup->control_msg_list = nvmf_tcp_control_msg_list_create(ttransport->tcp_opts.control_msg_num);
+		tgroup->control_msg_list = nvmf_tcp_control_msg_list_create(
+						   ttransport->tcp_opts.control_msg_num,
+						   SPDK_NVME_TCP_IN_CAPSULE_DATA_MAX_SIZE);
 		if (!tgroup->control_msg_list) {
 			goto cleanup;
 		}
@@ -2190,6 +2395,9 @@ nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
 		switch (tqpair->recv_state) {
 		/* Wait for the common header  */
 		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY:
+			if (spdk_unlikely(tqpair->migrating)) {
+				return NVME_TCP_PDU_IN_PROGRESS;
+			}
 			if (!pdu) {
 				pdu = SLIST_FIRST(&tqpair->tcp_pdu_free_queue);
 				if (spdk_unlikely(!pdu)) {
@@ -2333,6 +2541,24 @@ nvmf_tcp_control_msg_put(struct spdk_nvmf_tcp_control_msg_list *list, void *_msg
 	STAILQ_INSERT_HEAD(&list->free_msgs, msg, link);
 }
 
+static void
+nvmf_tcp_qpair_put_icd_buf(struct spdk_nvmf_tcp_qpair *tqpair, void *buf)
+{
+	struct spdk_nvmf_tcp_req *waiter = tqpair->icd_buf_waiter;
+
+	nvmf_tcp_control_msg_put(tqpair->icd_buf_list, buf);
+
+	if (waiter != NULL) {
+		/* The qpair doesn't read further PDUs until the waiting capsule gets a buffer,
+		 * so let it retry first instead of waiting behind other requests. */
+		tqpair->icd_buf_waiter = NULL;
+		assert(waiter->state == TCP_REQUEST_STATE_NEED_BUFFER);
+		STAILQ_REMOVE(&tqpair->group->group.pending_buf_queue, &waiter->req,
+			      spdk_nvmf_request, buf_link);
+		STAILQ_INSERT_HEAD(&tqpair->group->group.pending_buf_queue, &waiter->req, buf_link);
+	}
+}
+
 static int
 nvmf_tcp_req_parse_sgl(struct spdk_nvmf_tcp_req *tcp_req,
 		       struct spdk_nvmf_transport *transport,
@@ -2448,6 +2674,16 @@ nvmf_tcp_req_parse_sgl(struct spdk_nvmf_tcp_req *tcp_req,
 				fes = SPDK_NVME_TCP_TERM_REQ_FES_DATA_TRANSFER_LIMIT_EXCEEDED;
 				goto fatal_err;
 			}
+		} else if (tqpair->icd_buf_list != NULL) {
+			req->iov[0].iov_base = nvmf_tcp_control_msg_get(tqpair->icd_buf_list);
+			if (!req->iov[0].iov_base) {
+				/* No available buffers. Queue this request up. */
+				SPDK_DEBUGLOG(nvmf_tcp, "No available shared ICD buffers. "
+					      "Queueing request %p\n", tcp_req);
+				tqpair->icd_buf_waiter = tcp_req;
+				return 0;
+			}
+			tcp_req->has_shared_icd_buf = true;
 		} else {
 			req->iov[0].iov_base = tcp_req->buf;
 		}
@@ -2732,7 +2968,10 @@ nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
 
 	/* If the qpair is not active, we need to abort the outstanding requests. */
 	if (tqpair->qpair.state != SPDK_NVMF_QPAIR_ACTIVE) {
-		if (tcp_req->state == TCP_REQUEST_STATE_NEED_BUFFER) {
+		if (tcp_req->state == TCP_REQUEST_STATE_AWAITING_QOS) {
+			STAILQ_REMOVE(&group->pending_qos_queue, &tcp_req->req, spdk_nvmf_request,
+				      buf_link);
+		} else if (tcp_req->state == TCP_REQUEST_STATE_NEED_BUFFER) {
 			STAILQ_REMOVE(&group->pending_buf_queue, &tcp_req->req, spdk_nvmf_request, buf_link);
 		}
 		nvmf_tcp_req_set_state(tcp_req, TCP_REQUEST_STATE_COMPLETED);
@@ -2796,6 +3035,30 @@ nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
 				nvmf_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
 			}
 
+			/* Hold the request back before it takes any buffer or sends an R2T if its
+			 * namespace is over its rate limits. In capsule data is already on its way
+			 * and has to be received before any other PDU, so it's only accounted. */
+			if (spdk_unlikely(!nvmf_request_qos_admit(&tcp_req->req,
+					  tcp_req->has_in_capsule_data))) {
+				nvmf_tcp_req_set_state(tcp_req, TCP_REQUEST_STATE_AWAITING_QOS);
+				STAILQ_INSERT_TAIL(&group->pending_qos_queue, &tcp_req->req,
+						   buf_link);
+				break;
+			}
+
+			nvmf_tcp_req_set_state(tcp_req, TCP_REQUEST_STATE_NEED_BUFFER);
+			STAILQ_INSERT_TAIL(&group->pending_buf_queue, &tcp_req->req, buf_link);
+			break;
+		case TCP_REQUEST_STATE_AWAITING_QOS:
+			spdk_trace_record(TRACE_TCP_REQUEST_STATE_AWAIT_QOS, tqpair->qpair.qid, 0,
+					  (uintptr_t)tcp_req, tqpair);
+
+			if (!nvmf_request_qos_admit(&tcp_req->req, false)) {
+				break;
+			}
+
+			STAILQ_REMOVE(&group->pending_qos_queue, &tcp_req->req, spdk_nvmf_request,
+				      buf_link);
 			nvmf_tcp_req_set_state(tcp_req, TCP_REQUEST_STATE_NEED_BUFFER);
 			STAILQ_INSERT_TAIL(&group->pending_buf_queue, &tcp_req->req, buf_link);
 			break;
@@ -3031,6 +3294,9 @@ nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
 				SPDK_DEBUGLOG(nvmf_tcp, "Put buf to control msg list\n");
 				nvmf_tcp_control_msg_put(tgroup->control_msg_list,
 							 tcp_req->req.iov[0].iov_base);
+			} else if (tcp_req->has_shared_icd_buf) {
+				nvmf_tcp_qpair_put_icd_buf(tqpair, tcp_req->req.iov[0].iov_base);
+				tcp_req->has_shared_icd_buf = false;
 			} else if (tcp_req->req.zcopy_bdev_io != NULL) {
 				/* If the request has an unreleased zcopy bdev_io, it's either a
 				 * read, a failed write, or the qpair is being disconnected */
@@ -3134,6 +3400,70 @@ nvmf_tcp_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 	return 0;
 }
 
+static void
+nvmf_tcp_qpair_migrate_done(struct spdk_nvmf_tcp_qpair *tqpair, int status)
+{
+	spdk_nvmf_transport_qpair_quiesce_cb cb_fn = tqpair->migrate_cb_fn;
+
+	TAILQ_REMOVE(&tqpair->group->migrating, tqpair, migrate_link);
+	tqpair->migrate_cb_fn = NULL;
+	cb_fn(tqpair->migrate_cb_arg, status);
+}
+
+static bool
+nvmf_tcp_qpair_is_quiesced(struct spdk_nvmf_tcp_qpair *tqpair)
+{
+	/* The PDU prefetched for the next command is the only one in use */
+	return tqpair->recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY &&
+	       tqpair->tcp_pdu_working_count == (tqpair->pdu_in_progress != NULL ? 1 : 0) &&
+	       tqpair->state_cntr[TCP_REQUEST_STATE_FREE] == tqpair->resource_count;
+}
+
+static void
+nvmf_tcp_qpair_quiesce(struct spdk_nvmf_qpair *qpair,
+		       spdk_nvmf_transport_qpair_quiesce_cb cb_fn, void *cb_arg)
+{
+	struct spdk_nvmf_tcp_qpair *tqpair;
+
+	tqpair = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_tcp_qpair, qpair);
+	assert(!tqpair->migrating);
+	tqpair->migrating = true;
+	tqpair->migrate_cb_fn = cb_fn;
+	tqpair->migrate_cb_arg = cb_arg;
+	/* Checked by the poll group, so that cb_fn is never called from here */
+	TAILQ_INSERT_TAIL(&tqpair->group->migrating, tqpair, migrate_link);
+}
+
+static int
+nvmf_tcp_poll_group_migrate(struct spdk_nvmf_transport_poll_group *group,
+			    struct spdk_nvmf_qpair *qpair)
+{
+	struct spdk_nvmf_tcp_poll_group	*tgroup;
+	struct spdk_nvmf_tcp_qpair	*tqpair;
+	int				rc;
+
+	tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
+	tqpair = SPDK_CONTAINEROF(qpair, struct spdk_nvmf_tcp_qpair, qpair);
+
+	assert(tqpair->migrating && tqpair->migrate_cb_fn == NULL);
+	assert(tqpair->recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
+
+	SPDK_DEBUGLOG(nvmf_tcp, "move tqpair=%p to the tgroup=%p\n", tqpair, tgroup);
+	tqpair->group = tgroup;
+	TAILQ_INSERT_TAIL(&tgroup->qpairs, tqpair, link);
+	tqpair->migrating = false;
+
+	rc = spdk_sock_group_add_sock(tgroup->sock_group, tqpair->sock,
+				      nvmf_tcp_sock_cb, tqpair);
+	if (rc != 0) {
+		SPDK_ERRLOG("Could not add sock to sock_group: %s (%d)\n",
+			    spdk_strerror(errno), errno);
+		return -1;
+	}
+
+	return 0;
+}
+
 static int
 nvmf_tcp_poll_group_remove(struct spdk_nvmf_transport_poll_group *group,
 			   struct spdk_nvmf_qpair *qpair)
@@ -3148,6 +3478,10 @@ nvmf_tcp_poll_group_remove(struct spdk_nvmf_transport_poll_group *group,
 	assert(tqpair->group == tgroup);
 
 	SPDK_DEBUGLOG(nvmf_tcp, "remove tqpair=%p from the tgroup=%p\n", tqpair, tgroup);
+	nvmf_tcp_qpair_submit_send_buf(tqpair);
+	if (spdk_unlikely(tqpair->migrate_cb_fn != NULL)) {
+		nvmf_tcp_qpair_migrate_done(tqpair, -ECANCELED);
+	}
 	if (tqpair->recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_REQ) {
 		TAILQ_REMOVE(&tgroup->await_req, tqpair, link);
 	} else {
@@ -3228,6 +3562,13 @@ nvmf_tcp_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 		return 0;
 	}
 
+	/* These may belong to different namespaces, so keep going after one that's still
+	 * throttled. */
+	STAILQ_FOREACH_SAFE(req, &group->pending_qos_queue, buf_link, req_tmp) {
+		tcp_req = SPDK_CONTAINEROF(req, struct spdk_nvmf_tcp_req, req);
+		nvmf_tcp_req_process(ttransport, tcp_req);
+	}
+
 	STAILQ_FOREACH_SAFE(req, &group->pending_buf_queue, buf_link, req_tmp) {
 		tcp_req = SPDK_CONTAINEROF(req, struct spdk_nvmf_tcp_req, req);
 		if (nvmf_tcp_req_process(ttransport, tcp_req) == false) {
@@ -3235,6 +3576,16 @@ nvmf_tcp_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 		}
 	}
 
+	TAILQ_FOREACH_SAFE(tqpair, &tgroup->send_pending, send_link, tqpair_tmp) {
+		nvmf_tcp_qpair_submit_send_buf(tqpair);
+	}
+
+	TAILQ_FOREACH_SAFE(tqpair, &tgroup->migrating, migrate_link, tqpair_tmp) {
+		if (nvmf_tcp_qpair_is_quiesced(tqpair)) {
+			nvmf_tcp_qpair_migrate_done(tqpair, 0);
+		}
+	}
+
 	rc = spdk_sock_group_poll(tgroup->sock_group);
 	if (rc < 0) {
 		SPDK_ERRLOG("Failed to poll sock_group=%p\n", tgroup->sock_group);
@@ -3340,6 +3691,14 @@ _nvmf_tcp_qpair_abort_request(void *ctx)
 		}
 		break;
 
+	case TCP_REQUEST_STATE_AWAITING_QOS:
+		STAILQ_REMOVE(&tqpair->group->group.pending_qos_queue,
+			      &tcp_req_to_abort->req, spdk_nvmf_request, buf_link);
+
+		nvmf_tcp_req_set_abort_status(req, tcp_req_to_abort);
+		nvmf_tcp_req_process(ttransport, tcp_req_to_abort);
+		break;
+
 	case TCP_REQUEST_STATE_NEED_BUFFER:
 		STAILQ_REMOVE(&tqpair->group->group.pending_buf_queue,
 			      &tcp_req_to_abort->req, spdk_nvmf_request, buf_link);
@@ -3444,6 +3803,8 @@ const struct spdk_nvmf_transport_ops spdk_nvmf_transport_tcp = {
 	.poll_group_destroy = nvmf_tcp_poll_group_destroy,
 	.poll_group_add = nvmf_tcp_poll_group_add,
 	.poll_group_remove = nvmf_tcp_poll_group_remove,
+	.qpair_quiesce = nvmf_tcp_qpair_quiesce,
+	.poll_group_migrate = nvmf_tcp_poll_group_migrate,
 	.poll_group_poll = nvmf_tcp_poll_group_poll,
 
 	.req_free = nvmf_tcp_req_free,
@@ -110,11 +110,12 @@ nvmf_transport_listen_dump_opts(struct spdk_nvmf_transport *transport,
 	spdk_json_write_named_string(w, "traddr", trid->traddr);
 	spdk_json_write_named_string(w, "trsvcid", trid->trsvcid);
 
+	spdk_json_write_object_end(w);
+
+	/* Transport specific listen opts are decoded from the top level of the RPC params */
 	if (transport->ops->listen_dump_opts) {
 		transport->ops->listen_dump_opts(transport, trid, w);
 	}
-
-	spdk_json_write_object_end(w);
 }
 
 spdk_nvme_transport_type_t
@@ -572,6 +573,7 @@ nvmf_transport_poll_group_create(struct spdk_nvmf_transport *transport,
 	tgroup->transport = transport;
 
 	STAILQ_INIT(&tgroup->pending_buf_queue);
+	STAILQ_INIT(&tgroup->pending_qos_queue);
 	STAILQ_INIT(&tgroup->buf_cache);
 
 	if (transport->opts.buf_cache_size == 0) {
@@ -654,7 +656,7 @@ nvmf_transport_poll_group_destroy(struct spdk_nvmf_transport_poll_group *group)
 
 	transport = group->transport;
 
-	if (!STAILQ_EMPTY(&group->pending_buf_queue)) {
+	if (!STAILQ_EMPTY(&group->pending_buf_queue) || !STAILQ_EMPTY(&group->pending_qos_queue)) {
 		SPDK_ERRLOG("Pending I/O list wasn't empty on poll group destruction\n");
 	}
 
@@ -704,6 +706,35 @@ nvmf_transport_poll_group_remove(struct spdk_nvmf_transport_poll_group *group,
 	return rc;
 }
 
+bool
+nvmf_transport_qpair_can_migrate(struct spdk_nvmf_qpair *qpair)
+{
+	return qpair->transport->ops->qpair_quiesce != NULL &&
+	       qpair->transport->ops->poll_group_migrate != NULL;
+}
+
+void
+nvmf_transport_qpair_quiesce(struct spdk_nvmf_qpair *qpair,
+			     spdk_nvmf_transport_qpair_quiesce_cb cb_fn, void *cb_arg)
+{
+	assert(nvmf_transport_qpair_can_migrate(qpair));
+
+	qpair->transport->ops->qpair_quiesce(qpair, cb_fn, cb_arg);
+}
+
+int
+nvmf_transport_poll_group_migrate(struct spdk_nvmf_transport_poll_group *group,
+				  struct spdk_nvmf_qpair *qpair)
+{
+	SPDK_DTRACE_PROBE3(nvmf_transport_poll_group_migrate, qpair, qpair->qid,
+			   spdk_thread_get_id(group->group->thread));
+
+	assert(qpair->transport == group->transport);
+	assert(nvmf_transport_qpair_can_migrate(qpair));
+
+	return group->transport->ops->poll_group_migrate(group, qpair);
+}
+
 int
 nvmf_transport_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 {
@@ -753,6 +784,16 @@ nvmf_transport_qpair_get_listen_trid(struct spdk_nvmf_qpair *qpair,
 	return qpair->transport->ops->qpair_get_listen_trid(qpair, trid);
 }
 
+uint32_t
+nvmf_transport_qpair_get_in_capsule_data_size(struct spdk_nvmf_qpair *qpair)
+{
+	if (qpair->transport->ops->qpair_get_in_capsule_data_size) {
+		return qpair->transport->ops->qpair_get_in_capsule_data_size(qpair);
+	}
+
+	return qpair->transport->opts.in_capsule_data_size;
+}
+
 void
 nvmf_transport_qpair_abort_request(struct spdk_nvmf_qpair *qpair,
 				   struct spdk_nvmf_request *req)
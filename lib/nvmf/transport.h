@@ -29,6 +29,14 @@ int nvmf_transport_poll_group_add(struct spdk_nvmf_transport_poll_group *group,
 int nvmf_transport_poll_group_remove(struct spdk_nvmf_transport_poll_group *group,
 				     struct spdk_nvmf_qpair *qpair);
 
+bool nvmf_transport_qpair_can_migrate(struct spdk_nvmf_qpair *qpair);
+
+void nvmf_transport_qpair_quiesce(struct spdk_nvmf_qpair *qpair,
+				  spdk_nvmf_transport_qpair_quiesce_cb cb_fn, void *cb_arg);
+
+int nvmf_transport_poll_group_migrate(struct spdk_nvmf_transport_poll_group *group,
+				      struct spdk_nvmf_qpair *qpair);
+
 int nvmf_transport_poll_group_poll(struct spdk_nvmf_transport_poll_group *group);
 
 int nvmf_transport_req_free(struct spdk_nvmf_request *req);
@@ -47,6 +55,8 @@ int nvmf_transport_qpair_get_local_trid(struct spdk_nvmf_qpair *qpair,
 int nvmf_transport_qpair_get_listen_trid(struct spdk_nvmf_qpair *qpair,
 		struct spdk_nvme_transport_id *trid);
 
+uint32_t nvmf_transport_qpair_get_in_capsule_data_size(struct spdk_nvmf_qpair *qpair);
+
 void nvmf_transport_qpair_abort_request(struct spdk_nvmf_qpair *qpair,
 					struct spdk_nvmf_request *req);
 
@@ -45,6 +45,12 @@
 #define NVMF_VFIO_USER_SET_EVENTIDX_MAX_ATTEMPTS 3
 #define NVMF_VFIO_USER_EVENTIDX_POLL UINT32_MAX
 
+/*
+ * Number of consecutive empty polls after which an SQ is parked when adaptive
+ * SQ polling is enabled.
+ */
+#define NVMF_VFIO_USER_SQ_PARK_IDLE_POLLS 1000
+
 #define NVMF_VFIO_USER_MAX_QPAIRS_PER_CTRLR 512
 #define NVMF_VFIO_USER_DEFAULT_MAX_QPAIRS_PER_CTRLR (NVMF_VFIO_USER_MAX_QPAIRS_PER_CTRLR / 4)
 
@@ -304,6 +310,13 @@ struct nvmf_vfio_user_sq {
 	/* Whether a shadow doorbell eventidx needs setting. */
 	bool					need_rearm;
 
+	/*
+	 * Adaptive SQ polling: consecutive empty polls, and whether the SQ is
+	 * parked, i.e. not polled until the host writes its BAR0 doorbell.
+	 */
+	uint32_t				idle_polls;
+	volatile bool				parked;
+
 	/* multiple SQs can be mapped to the same CQ */
 	uint16_t				cqid;
 
@@ -348,6 +361,19 @@ struct nvmf_vfio_user_cq {
 
 	uint32_t				last_head;
 	uint32_t				last_trigger_irq_tail;
+
+	/*
+	 * Interrupt coalescing: number of CQEs posted since the last IRQ, and
+	 * when that IRQ has to be sent at the latest.
+	 */
+	uint32_t				coalesced_cqes;
+	uint64_t				coalesce_deadline_tsc;
+
+	/*
+	 * CQEs were posted in pre-copy state since the CQ was last marked
+	 * dirty, see handle_dirty_cq().
+	 */
+	bool					dirty;
 };
 
 struct nvmf_vfio_user_poll_group {
@@ -409,6 +435,21 @@ struct nvmf_vfio_user_poll_group {
 		uint64_t poll_reqs_squared;
 		uint64_t cqh_admin_writes;
 		uint64_t cqh_io_writes;
+
+		/*
+		 * Number of times an idle SQ was parked by adaptive SQ polling,
+		 * and un-parked by a BAR0 doorbell write handled by this poll
+		 * group.
+		 */
+		uint64_t sq_parks;
+		uint64_t sq_unparks;
+
+		/*
+		 * Number of IRQs sent for coalesced CQEs, and number of CQEs
+		 * posted with interrupt coalescing.
+		 */
+		uint64_t coalesced_irqs;
+		uint64_t coalesced_cqes;
 	} stats;
 };
 
@@ -437,6 +478,12 @@ struct nvmf_vfio_user_ctrlr {
 	/* Controller is in source VM when doing live migration */
 	bool					in_source_vm;
 
+	/*
+	 * The controller keeps running in pre-copy state, with the client
+	 * fetching the guest pages dirtied by our DMA writes incrementally.
+	 */
+	bool					in_pre_copy;
+
 	struct spdk_thread			*thread;
 	struct spdk_poller			*vfu_ctx_poller;
 	struct spdk_interrupt			*intr;
@@ -516,6 +563,7 @@ struct nvmf_vfio_user_transport_opts {
 	bool					disable_shadow_doorbells;
 	bool					disable_compare;
 	bool					enable_intr_mode_sq_spreading;
+	bool					enable_adaptive_sq_polling;
 };
 
 struct nvmf_vfio_user_transport {
@@ -978,6 +1026,8 @@ vfio_user_ctrlr_switch_doorbells(struct nvmf_vfio_user_ctrlr *ctrlr, bool shadow
 			sq->dbl_tailp = doorbells + queue_index(sq->qid, false);
 
 			ctrlr->sqs[i]->need_rearm = shadow;
+			ctrlr->sqs[i]->idle_polls = 0;
+			ctrlr->sqs[i]->parked = false;
 		}
 
 		if (cq != NULL) {
@@ -1228,6 +1278,11 @@ static const struct spdk_json_object_decoder vfio_user_transport_opts_decoder[]
 		offsetof(struct nvmf_vfio_user_transport, transport_opts.enable_intr_mode_sq_spreading),
 		spdk_json_decode_bool, true
 	},
+	{
+		"enable_adaptive_sq_polling",
+		offsetof(struct nvmf_vfio_user_transport, transport_opts.enable_adaptive_sq_polling),
+		spdk_json_decode_bool, true
+	},
 };
 
 static struct spdk_nvmf_transport *
@@ -1300,6 +1355,17 @@ nvmf_vfio_user_create(struct spdk_nvmf_transport_opts *opts)
 		 * to send pending IRQs.
 		 */
 		vu_transport->transport_opts.disable_adaptive_irq = true;
+
+		/* All the SQs are already armed to wake us up in interrupt mode. */
+		vu_transport->transport_opts.enable_adaptive_sq_polling = false;
+	}
+
+	/*
+	 * Parked SQs are woken up by BAR0 doorbell writes, which the host is
+	 * only asked to do through the shadow doorbell event indexes.
+	 */
+	if (vu_transport->transport_opts.disable_shadow_doorbells) {
+		vu_transport->transport_opts.enable_adaptive_sq_polling = false;
 	}
 
 	SPDK_DEBUGLOG(nvmf_vfio, "vfio_user transport: disable_mappable_bar0=%d\n",
@@ -1308,6 +1374,8 @@ nvmf_vfio_user_create(struct spdk_nvmf_transport_opts *opts)
 		      vu_transport->transport_opts.disable_adaptive_irq);
 	SPDK_DEBUGLOG(nvmf_vfio, "vfio_user transport: disable_shadow_doorbells=%d\n",
 		      vu_transport->transport_opts.disable_shadow_doorbells);
+	SPDK_DEBUGLOG(nvmf_vfio, "vfio_user transport: enable_adaptive_sq_polling=%d\n",
+		      vu_transport->transport_opts.enable_adaptive_sq_polling);
 
 	return &vu_transport->transport;
 
@@ -1604,6 +1672,101 @@ vfio_user_poll_group_rearm(struct nvmf_vfio_user_poll_group *vu_group)
 	return count;
 }
 
+/*
+ * Whether an idle SQ can be parked: like in interrupt mode, that relies on the
+ * shadow doorbell event index to make the host write the BAR0 doorbell on its
+ * next submission. The Admin queue is always polled.
+ */
+static inline bool
+sq_adaptive_polling(struct nvmf_vfio_user_sq *sq)
+{
+	struct nvmf_vfio_user_ctrlr *ctrlr = sq->ctrlr;
+
+	return ctrlr->transport->transport_opts.enable_adaptive_sq_polling &&
+	       ctrlr->sdbl != NULL && sq->qid != 0;
+}
+
+/*
+ * Stop polling an idle SQ until the host writes its BAR0 doorbell, see
+ * vfio_user_sq_unpark(). The doorbell write is handled on the controller's
+ * thread, which might not be ours, so the SQ is marked as parked before the
+ * event index is set.
+ */
+static void
+vfio_user_sq_park(struct nvmf_vfio_user_sq *sq,
+		  struct nvmf_vfio_user_poll_group *vu_group)
+{
+	struct nvmf_vfio_user_ctrlr *ctrlr = sq->ctrlr;
+	struct nvmf_vfio_user_cq *cq = ctrlr->cqs[sq->cqid];
+	volatile uint32_t *sq_tail_eidx;
+	uint32_t cq_tail;
+
+	sq->idle_polls = 0;
+
+	/*
+	 * Outstanding requests, or an IRQ suppressed or coalesced by
+	 * post_completion(), still need this SQ to be polled.
+	 */
+	if (ctrlr->state != VFIO_USER_CTRLR_RUNNING ||
+	    !TAILQ_EMPTY(&sq->qpair.outstanding) || cq->coalesced_cqes != 0) {
+		return;
+	}
+
+	if (ctrlr->adaptive_irqs_enabled && cq->ien) {
+		cq_tail = *cq_tailp(cq);
+		if (cq_tail != cq->last_trigger_irq_tail && cq_tail != *cq_dbl_headp(cq)) {
+			return;
+		}
+	}
+
+	sq_tail_eidx = ctrlr->sdbl->eventidxs + queue_index(sq->qid, false);
+
+	sq->parked = true;
+	spdk_mb();
+
+	*sq_tail_eidx = *sq_dbl_tailp(sq);
+
+	/* See set_sq_eventidx(). */
+	spdk_mb();
+
+	if (*sq_dbl_tailp(sq) != *sq_headp(sq)) {
+		/* The host submitted without writing to BAR0, keep polling. */
+		*sq_tail_eidx = NVMF_VFIO_USER_EVENTIDX_POLL;
+		sq->parked = false;
+		return;
+	}
+
+	SPDK_DEBUGLOG(vfio_user_db, "%s: parked sqid:%u\n", ctrlr_id(ctrlr), sq->qid);
+
+	vu_group->stats.sq_parks++;
+}
+
+/*
+ * The host wrote the BAR0 tail doorbell of an SQ: resume polling it, and stop
+ * asking for BAR0 writes. The event index is reset even if the SQ wasn't
+ * parked, as an SQ might have lost the race in vfio_user_sq_park() after the
+ * host has seen its event index.
+ */
+static void
+vfio_user_sq_unpark(struct nvmf_vfio_user_sq *sq,
+		    struct nvmf_vfio_user_poll_group *vu_group)
+{
+	if (!sq_adaptive_polling(sq)) {
+		return;
+	}
+
+	sq->ctrlr->sdbl->eventidxs[queue_index(sq->qid, false)] = NVMF_VFIO_USER_EVENTIDX_POLL;
+
+	if (sq->parked) {
+		spdk_wmb();
+		sq->parked = false;
+		vu_group->stats.sq_unparks++;
+
+		SPDK_DEBUGLOG(vfio_user_db, "%s: unparked sqid:%u\n",
+			      ctrlr_id(sq->ctrlr), sq->qid);
+	}
+}
+
 static int
 acq_setup(struct nvmf_vfio_user_ctrlr *ctrlr)
 {
@@ -1719,6 +1882,73 @@ cq_is_full(struct nvmf_vfio_user_cq *cq)
 	return free_cq_slots == 0;
 }
 
+/*
+ * Whether the host asked for I/O completion interrupts to be coalesced. The
+ * Aggregation Time has to be enforced by polling, so this isn't supported in
+ * interrupt mode.
+ */
+static inline bool
+ctrlr_irq_coalescing(struct nvmf_vfio_user_ctrlr *ctrlr)
+{
+	return ctrlr->ctrlr != NULL &&
+	       ctrlr->ctrlr->feat.interrupt_coalescing.bits.time != 0 &&
+	       !in_interrupt_mode(ctrlr->transport);
+}
+
+static int
+cq_trigger_coalesced_irq(struct nvmf_vfio_user_ctrlr *ctrlr, struct nvmf_vfio_user_cq *cq)
+{
+	struct nvmf_vfio_user_poll_group *vu_group;
+	int err;
+
+	assert(cq->group != NULL);
+	vu_group = SPDK_CONTAINEROF(cq->group, struct nvmf_vfio_user_poll_group, group);
+
+	cq->coalesced_cqes = 0;
+
+	err = vfu_irq_trigger(ctrlr->endpoint->vfu_ctx, cq->iv);
+	if (err != 0) {
+		SPDK_ERRLOG("%s: failed to trigger interrupt: %m\n",
+			    ctrlr_id(ctrlr));
+		return err;
+	}
+
+	vu_group->stats.coalesced_irqs++;
+
+	return 0;
+}
+
+/*
+ * Coalesce the IRQ of a CQE just posted: it's sent once the Aggregation
+ * Threshold is reached or, at the latest, once the Aggregation Time has
+ * elapsed since the first CQE it covers, see handle_coalesced_irq().
+ */
+static int
+cq_coalesce_irq(struct nvmf_vfio_user_ctrlr *ctrlr, struct nvmf_vfio_user_cq *cq)
+{
+	union spdk_nvme_feat_interrupt_coalescing coalescing;
+	struct nvmf_vfio_user_poll_group *vu_group;
+
+	coalescing = ctrlr->ctrlr->feat.interrupt_coalescing;
+
+	assert(cq->group != NULL);
+	vu_group = SPDK_CONTAINEROF(cq->group, struct nvmf_vfio_user_poll_group, group);
+	vu_group->stats.coalesced_cqes++;
+
+	if (cq->coalesced_cqes++ == 0) {
+		/* The Aggregation Time is in 100 microsecond increments. */
+		cq->coalesce_deadline_tsc = spdk_get_ticks() +
+					    coalescing.bits.time * spdk_get_ticks_hz() / 10000;
+	}
+
+	/* The Aggregation Threshold is 0's based. */
+	if (cq->coalesced_cqes <= coalescing.bits.thr) {
+		return 0;
+	}
+
+	return cq_trigger_coalesced_irq(ctrlr, cq);
+}
+
 /*
  * Posts a CQE in the completion queue.
  *
@@ -1791,8 +2021,23 @@ post_completion(struct nvmf_vfio_user_ctrlr *ctrlr, struct nvmf_vfio_user_cq *cq
 	spdk_wmb();
 	cq_tail_advance(cq);
 
-	if ((cq->qid == 0 || !ctrlr->adaptive_irqs_enabled) &&
-	    cq->ien && ctrlr_interrupt_enabled(ctrlr)) {
+	if (spdk_unlikely(ctrlr->in_pre_copy)) {
+		cq->dirty = true;
+	}
+
+	if (!cq->ien || !ctrlr_interrupt_enabled(ctrlr)) {
+		return 0;
+	}
+
+	/*
+	 * Interrupt coalescing, when the host asked for it, takes precedence
+	 * over adaptive IRQs. Admin completions are never coalesced.
+	 */
+	if (cq->qid != 0 && ctrlr_irq_coalescing(ctrlr)) {
+		return cq_coalesce_irq(ctrlr, cq);
+	}
+
+	if (cq->qid == 0 || !ctrlr->adaptive_irqs_enabled) {
 		err = vfu_irq_trigger(ctrlr->endpoint->vfu_ctx, cq->iv);
 		if (err != 0) {
 			SPDK_ERRLOG("%s: failed to trigger interrupt: %m\n",
@@ -2081,6 +2326,9 @@ handle_create_io_sq(struct nvmf_vfio_user_ctrlr *ctrlr,
 	 */
 	*sq_dbl_tailp(sq) = 0;
 
+	sq->idle_polls = 0;
+	sq->parked = false;
+
 	if (ctrlr->sdbl != NULL) {
 		sq->need_rearm = true;
 
@@ -2165,6 +2413,7 @@ handle_create_io_cq(struct nvmf_vfio_user_ctrlr *ctrlr,
 	cq->iv = cmd->cdw11_bits.create_io_cq.iv;
 	cq->phase = true;
 	cq->cq_state = VFIO_USER_CQ_CREATED;
+	cq->coalesced_cqes = 0;
 
 	*cq_tailp(cq) = 0;
 
@@ -2951,6 +3200,8 @@ handle_dbl_access(struct nvmf_vfio_user_ctrlr *ctrlr, uint32_t *buf,
 		group->stats.cqh_admin_writes++;
 	} else if (pos & 1) {
 		group->stats.cqh_io_writes++;
+	} else if (ctrlr->sqs[pos / 2] != NULL) {
+		vfio_user_sq_unpark(ctrlr->sqs[pos / 2], group);
 	}
 
 	SPDK_DEBUGLOG(vfio_user_db, "%s: updating BAR0 doorbell %s:%ld to %u\n",
@@ -3708,6 +3959,7 @@ vfio_user_migr_ctrlr_construct_qps(struct nvmf_vfio_user_ctrlr *vu_ctrlr,
 			cq->ien = migr_qp.cq.ien;
 			cq->iv = migr_qp.cq.iv;
 			cq->phase = migr_qp.cq.phase;
+			cq->coalesced_cqes = 0;
 			addr = map_one(vu_ctrlr->endpoint->vfu_ctx,
 				       cq->mapping.prp1, cq->size * 16,
 				       cq->mapping.sg, &cq->mapping.iov,
@@ -3892,12 +4144,14 @@ vfio_user_migration_device_state_transition(vfu_ctx_t *vfu_ctx, vfu_migr_state_t
 
 	switch (state) {
 	case VFU_MIGR_STATE_STOP_AND_COPY:
+		vu_ctrlr->in_pre_copy = false;
 		vu_ctrlr->in_source_vm = true;
 		vu_ctrlr->state = VFIO_USER_CTRLR_MIGRATING;
 		vfio_user_migr_ctrlr_mark_dirty(vu_ctrlr);
 		vfio_user_migr_ctrlr_save_data(vu_ctrlr);
 		break;
 	case VFU_MIGR_STATE_STOP:
+		vu_ctrlr->in_pre_copy = false;
 		vu_ctrlr->state = VFIO_USER_CTRLR_MIGRATING;
 		/* The controller associates with source VM is dead now, we will resume
 		 * the subsystem after destroying the controller data structure, then the
@@ -3909,6 +4163,13 @@ vfio_user_migration_device_state_transition(vfu_ctx_t *vfu_ctx, vfu_migr_state_t
 		break;
 	case VFU_MIGR_STATE_PRE_COPY:
 		assert(vu_ctrlr->state == VFIO_USER_CTRLR_PAUSED);
+		/*
+		 * The controller is resumed once vfu_device_quiesced() returns,
+		 * see vfio_user_quiesce_done(). The pages dirtied by data
+		 * transfers are marked by vfu_sgl_put(), the CQs by
+		 * handle_dirty_cq().
+		 */
+		vu_ctrlr->in_pre_copy = true;
 		break;
 	case VFU_MIGR_STATE_RESUME:
 		/*
@@ -3935,6 +4196,8 @@ vfio_user_migration_device_state_transition(vfu_ctx_t *vfu_ctx, vfu_migr_state_t
 		sq->size = 0;
 		break;
 	case VFU_MIGR_STATE_RUNNING:
+		/* Pre-copy cancelled. */
+		vu_ctrlr->in_pre_copy = false;
 
 		if (vu_ctrlr->state != VFIO_USER_CTRLR_MIGRATING) {
 			break;
@@ -3983,6 +4246,12 @@ vfio_user_migration_get_pending_bytes(vfu_ctx_t *vfu_ctx)
 	if (ctrlr->migr_data_prepared) {
 		assert(ctrlr->state == VFIO_USER_CTRLR_MIGRATING);
 		pending_bytes = 0;
+	} else if (ctrlr->in_pre_copy) {
+		/*
+		 * The device state is only saved in stop-and-copy state, the
+		 * client only needs the dirty pages during pre-copy.
+		 */
+		pending_bytes = 0;
 	} else {
 		pending_bytes = vfio_user_migr_data_len();
 	}
@@ -5625,6 +5894,52 @@ handle_suppressed_irq(struct nvmf_vfio_user_ctrlr *ctrlr,
 	cq->last_head = cq_head;
 }
 
+/*
+ * Send the IRQ of coalesced CQEs once the Aggregation Time has elapsed, see
+ * cq_coalesce_irq().
+ */
+static void
+handle_coalesced_irq(struct nvmf_vfio_user_ctrlr *ctrlr,
+		     struct nvmf_vfio_user_sq *sq)
+{
+	struct nvmf_vfio_user_cq *cq = ctrlr->cqs[sq->cqid];
+
+	if (spdk_likely(cq->coalesced_cqes == 0) ||
+	    spdk_get_ticks() < cq->coalesce_deadline_tsc) {
+		return;
+	}
+
+	if (!cq->ien || !ctrlr_interrupt_enabled(ctrlr)) {
+		cq->coalesced_cqes = 0;
+		return;
+	}
+
+	cq_trigger_coalesced_irq(ctrlr, cq);
+}
+
+/*
+ * In pre-copy state, mark the pages of CQs we've posted to dirty so that they
+ * are sent incrementally: the CQs stay mapped, so vfu_sgl_put() isn't called
+ * for them. Marking them once per poll instead of on each CQE batches the
+ * updates of the dirty page bitmap.
+ */
+static void
+handle_dirty_cq(struct nvmf_vfio_user_ctrlr *ctrlr,
+		struct nvmf_vfio_user_sq *sq)
+{
+	struct nvmf_vfio_user_cq *cq = ctrlr->cqs[sq->cqid];
+
+	if (spdk_likely(!cq->dirty)) {
+		return;
+	}
+
+	cq->dirty = false;
+
+	if (q_addr(&cq->mapping) != NULL) {
+		vfu_sgl_mark_dirty(ctrlr->endpoint->vfu_ctx, cq->mapping.sg, 1);
+	}
+}
+
 /* Returns the number of commands processed, or a negative value on error. */
 static int
 nvmf_vfio_user_sq_poll(struct nvmf_vfio_user_sq *sq)
@@ -5649,6 +5964,9 @@ nvmf_vfio_user_sq_poll(struct nvmf_vfio_user_sq *sq)
 		handle_suppressed_irq(ctrlr, sq);
 	}
 
+	handle_coalesced_irq(ctrlr, sq);
+	handle_dirty_cq(ctrlr, sq);
+
 	/* On aarch64 platforms, doorbells update from guest VM may not be seen
 	 * on SPDK target side. This is because there is memory type mismatch
 	 * situation here. That is on guest VM side, the doorbells are treated as
@@ -5730,12 +6048,28 @@ nvmf_vfio_user_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 			continue;
 		}
 
+		if (sq->parked) {
+			if (spdk_likely(sq_adaptive_polling(sq))) {
+				continue;
+			}
+			sq->parked = false;
+		}
+
 		ret = nvmf_vfio_user_sq_poll(sq);
 
 		if (spdk_unlikely(ret < 0)) {
 			return ret;
 		}
 
+		if (ret == 0) {
+			if (sq_adaptive_polling(sq) &&
+			    ++sq->idle_polls >= NVMF_VFIO_USER_SQ_PARK_IDLE_POLLS) {
+				vfio_user_sq_park(sq, vu_group);
+			}
+		} else {
+			sq->idle_polls = 0;
+		}
+
 		count += ret;
 	}
 
@@ -5842,6 +6176,10 @@ nvmf_vfio_user_poll_group_dump_stat(struct spdk_nvmf_transport_poll_group *group
 
 	spdk_json_write_named_uint64(w, "cqh_admin_writes", vu_group->stats.cqh_admin_writes);
 	spdk_json_write_named_uint64(w, "cqh_io_writes", vu_group->stats.cqh_io_writes);
+	spdk_json_write_named_uint64(w, "sq_parks", vu_group->stats.sq_parks);
+	spdk_json_write_named_uint64(w, "sq_unparks", vu_group->stats.sq_unparks);
+	spdk_json_write_named_uint64(w, "coalesced_irqs", vu_group->stats.coalesced_irqs);
+	spdk_json_write_named_uint64(w, "coalesced_cqes", vu_group->stats.coalesced_cqes);
 }
 
 static void
@@ -13,6 +13,7 @@
 #include "spdk/util.h"
 #include "spdk/log.h"
 #include "spdk/memory.h"
+#include "spdk/crc32.h"
 
 #include "libpmem.h"
 
@@ -30,7 +31,7 @@
 struct spdk_reduce_vol_superblock {
 	uint8_t				signature[8];
 	struct spdk_reduce_vol_params	params;
-	uint8_t				reserved[4048];
+	uint8_t				reserved[4040];
 };
 SPDK_STATIC_ASSERT(sizeof(struct spdk_reduce_vol_superblock) == 4096, "size incorrect");
 
@@ -41,8 +42,61 @@ SPDK_STATIC_ASSERT(sizeof(SPDK_REDUCE_SIGNATURE) - 1 ==
 
 #define REDUCE_PATH_MAX 4096
 
+/*
+ * Without a pm file, the metadata is kept in DRAM and journaled to the backing device.  Its
+ *  image is checkpointed after the path, and updates since the checkpoint are appended to a
+ *  log following the image.
+ */
+#define REDUCE_MD_CHECKPOINT_OFFSET	8192
+#define REDUCE_MD_IMAGE_OFFSET		12288
+#define REDUCE_MD_ALIGNMENT		4096
+
+/* The metadata image and the log are read and written in pieces of this size. */
+#define REDUCE_MD_IO_SIZE		(1024 * 1024)
+
+#define REDUCE_MD_SIGNATURE		"SPDKRDMD"
+
+/* Written to REDUCE_MD_CHECKPOINT_OFFSET once the metadata image is written. */
+struct reduce_md_checkpoint {
+	uint8_t				signature[8];
+	/* Sequence number and log offset of the first batch to replay over the image. */
+	uint64_t			seq;
+	uint64_t			log_start;
+	uint32_t			crc;
+	uint8_t				reserved[4068];
+};
+SPDK_STATIC_ASSERT(sizeof(struct reduce_md_checkpoint) == REDUCE_MD_ALIGNMENT, "size incorrect");
+
+/* Header of a batch of metadata updates in the log, followed by the records. */
+struct reduce_md_log_batch {
+	uint8_t				signature[8];
+	uint64_t			seq;
+	uint32_t			num_records;
+	/* Size of the batch including the header, a multiple of the backing block size. */
+	uint32_t			size;
+	/* CRC of the whole batch, computed with this field set to 0. */
+	uint32_t			crc;
+	uint32_t			reserved;
+};
+SPDK_STATIC_ASSERT(sizeof(struct reduce_md_log_batch) == 32, "size incorrect");
+
 #define REDUCE_ZERO_BUF_SIZE 0x100000
 
+/*
+ * Compression is skipped for chunks whose sampled bytes have a collision entropy above
+ *  7.5 bits per byte, i.e. whose sum of squared byte counts is below 1 / 2^7.5 of the
+ *  squared number of samples.  Uniformly random data is estimated at about 7.8 bits.
+ */
+#define REDUCE_ENTROPY_SAMPLES		2048
+#define REDUCE_ENTROPY_DIVISOR		181
+
+/*
+ * After this many chunks in a row that didn't compress, only one chunk out of
+ *  REDUCE_BYPASS_PROBE_INTERVAL is compressed, until one of them does again.
+ */
+#define REDUCE_BYPASS_STREAK		8
+#define REDUCE_BYPASS_PROBE_INTERVAL	64
+
 /**
  * Describes a persistent memory file used to hold metadata associated with a
  *  compressed volume.
@@ -63,6 +117,21 @@ struct spdk_reduce_chunk_map {
 	uint64_t		io_unit_index[0];
 };
 
+/* A metadata update in the log: the chunk map now backing a chunk of the volume. */
+struct reduce_md_log_record {
+	uint64_t			logical_map_index;
+	uint64_t			chunk_map_index;
+	struct spdk_reduce_chunk_map	chunk;
+};
+
+/* Header of a write buffer entry in the pm file, followed by the chunk data. */
+struct spdk_reduce_write_buffer {
+	/* Chunk buffered in this entry, or REDUCE_EMPTY_MAP_ENTRY if the entry is free. */
+	uint64_t		logical_map_index;
+	/* One bit per logical block of the chunk, set if the block was written. */
+	uint64_t		valid_blocks[0];
+};
+
 struct spdk_reduce_vol_request {
 	/**
 	 *  Scratch buffer used for uncompressed chunk.  This is used for:
@@ -106,10 +175,48 @@ struct spdk_reduce_vol_request {
 	uint64_t				length;
 	uint64_t				chunk_map_index;
 	struct spdk_reduce_chunk_map		*chunk;
+	/* Set if this request writes back a write buffer entry. */
+	struct spdk_reduce_write_buffer		*write_buffer;
+	struct iovec				write_buffer_iov;
 	spdk_reduce_vol_op_complete		cb_fn;
 	void					*cb_arg;
 	TAILQ_ENTRY(spdk_reduce_vol_request)	tailq;
+	TAILQ_ENTRY(spdk_reduce_vol_request)	md_log_tailq;
+	struct spdk_reduce_vol_cb_args		backing_cb_args;
+};
+
+/* State of the metadata journal on the backing device, when there is no pm file. */
+struct reduce_md_log {
+	/* Location and size of the log on the backing device, in bytes. */
+	uint64_t				offset;
+	uint64_t				size;
+	/* Log offsets of the oldest batch still needed, and of the end of the last batch. */
+	uint64_t				head;
+	uint64_t				tail;
+	/* Sequence number of the next batch. */
+	uint64_t				seq;
+	uint32_t				record_size;
+	uint32_t				max_batch_size;
+
+	/* The batch collecting updates, and the batch being written. */
+	uint8_t					*open_buf;
+	uint32_t				open_len;
+	uint32_t				open_records;
+	TAILQ_HEAD(, spdk_reduce_vol_request)	open_reqs;
+	uint8_t					*write_buf;
+	uint64_t				write_pos;
+	uint32_t				write_len;
+	bool					writing;
+	TAILQ_HEAD(, spdk_reduce_vol_request)	write_reqs;
+	struct iovec				iov;
 	struct spdk_reduce_vol_cb_args		backing_cb_args;
+
+	struct reduce_md_checkpoint		*checkpoint;
+	bool					checkpointing;
+	uint64_t				checkpoint_seq;
+	uint64_t				checkpoint_log_start;
+	spdk_reduce_vol_op_complete		checkpoint_cb_fn;
+	void					*checkpoint_cb_arg;
 };
 
 struct spdk_reduce_vol {
@@ -123,10 +230,26 @@ struct spdk_reduce_vol {
 	struct spdk_reduce_vol_superblock	*pm_super;
 	uint64_t				*pm_logical_map;
 	uint64_t				*pm_chunk_maps;
+	uint8_t					*pm_write_buffers;
 
 	struct spdk_bit_array			*allocated_chunk_maps;
 	struct spdk_bit_array			*allocated_backing_io_units;
 
+	/* Write buffer entries being written back to the backing device. */
+	struct spdk_bit_array			*write_buffers_flushing;
+	uint32_t				write_buffer_header_size;
+	uint32_t				write_buffer_evict_index;
+
+	/* Set when the metadata is journaled to the backing device instead of a pm file. */
+	struct reduce_md_log			*md_log;
+	spdk_reduce_vol_op_complete		unload_cb_fn;
+	void					*unload_cb_arg;
+
+	/* Recent chunks that didn't compress, and chunks not compressed since. */
+	uint32_t				incompressible_streak;
+	uint32_t				bypass_count;
+	struct spdk_reduce_vol_stats		stats;
+
 	struct spdk_reduce_vol_request		*request_mem;
 	TAILQ_HEAD(, spdk_reduce_vol_request)	free_requests;
 	TAILQ_HEAD(, spdk_reduce_vol_request)	executing_requests;
@@ -150,9 +273,21 @@ static int g_vol_count = 0;
  */
 #define REDUCE_NUM_EXTRA_CHUNKS 128
 
+static inline bool
+_reduce_vol_md_in_dram(struct spdk_reduce_vol *vol)
+{
+	/* Volumes without a pm file store an empty path on the backing device. */
+	return vol->pm_file.path[0] == '\0';
+}
+
 static void
 _reduce_persist(struct spdk_reduce_vol *vol, const void *addr, size_t len)
 {
+	if (_reduce_vol_md_in_dram(vol)) {
+		/* The update is journaled to the backing device, see _reduce_md_log_append(). */
+		return;
+	}
+
 	if (vol->pm_file.pm_is_pmem) {
 		pmem_persist(addr, len);
 	} else {
@@ -261,6 +396,36 @@ _get_vol_size(uint64_t chunk_size, uint64_t backing_dev_size)
 	return num_chunks * chunk_size;
 }
 
+static uint32_t
+_get_pm_write_buffer_header_size(uint64_t chunk_size, uint64_t logical_block_size)
+{
+	uint64_t valid_blocks_size;
+
+	valid_blocks_size = spdk_divide_round_up(chunk_size / logical_block_size, 64) *
+			    sizeof(uint64_t);
+
+	/* Round up to next cacheline. */
+	return spdk_divide_round_up(sizeof(struct spdk_reduce_write_buffer) + valid_blocks_size,
+				    REDUCE_PM_SIZE_ALIGNMENT) * REDUCE_PM_SIZE_ALIGNMENT;
+}
+
+static uint64_t
+_get_pm_write_buffers_size(struct spdk_reduce_vol_params *params)
+{
+	uint64_t chunk_size;
+
+	if (params->write_buffer_chunks == 0) {
+		return 0;
+	}
+
+	chunk_size = spdk_divide_round_up(params->chunk_size, REDUCE_PM_SIZE_ALIGNMENT) *
+		     REDUCE_PM_SIZE_ALIGNMENT;
+
+	return params->write_buffer_chunks *
+	       (_get_pm_write_buffer_header_size(params->chunk_size, params->logical_block_size) +
+		chunk_size);
+}
+
 static uint64_t
 _get_pm_file_size(struct spdk_reduce_vol_params *params)
 {
@@ -270,9 +435,64 @@ _get_pm_file_size(struct spdk_reduce_vol_params *params)
 	total_pm_size += _get_pm_logical_map_size(params->vol_size, params->chunk_size);
 	total_pm_size += _get_pm_total_chunks_size(params->vol_size, params->chunk_size,
 			 params->backing_io_unit_size);
+	total_pm_size += _get_pm_write_buffers_size(params);
 	return total_pm_size;
 }
 
+static uint32_t
+_get_md_log_record_size(struct spdk_reduce_vol_params *params)
+{
+	return offsetof(struct reduce_md_log_record, chunk) +
+	       _reduce_vol_get_chunk_struct_size(params->chunk_size / params->backing_io_unit_size);
+}
+
+/* A batch holds the updates of all the requests of the volume. */
+static uint32_t
+_get_md_log_max_batch_size(struct spdk_reduce_vol_params *params, uint32_t blocklen)
+{
+	uint64_t size;
+
+	size = sizeof(struct reduce_md_log_batch) +
+	       REDUCE_NUM_VOL_REQUESTS * _get_md_log_record_size(params);
+
+	return spdk_divide_round_up(size, blocklen) * blocklen;
+}
+
+static uint64_t
+_get_md_image_size(struct spdk_reduce_vol_params *params)
+{
+	return spdk_divide_round_up(_get_pm_file_size(params), REDUCE_MD_ALIGNMENT) *
+	       REDUCE_MD_ALIGNMENT;
+}
+
+/*
+ * Size the log like the image: a checkpoint, started once half of the log is used, then
+ *  writes about twice the data that was logged since the previous one.
+ */
+static uint64_t
+_get_md_log_size(struct spdk_reduce_vol_params *params, uint32_t blocklen)
+{
+	uint64_t size;
+
+	size = spdk_max(_get_md_image_size(params),
+			4 * (uint64_t)_get_md_log_max_batch_size(params, blocklen));
+
+	return spdk_divide_round_up(size, REDUCE_MD_ALIGNMENT) * REDUCE_MD_ALIGNMENT;
+}
+
+/* Size at the beginning of the backing device used by the metadata, without a pm file. */
+static uint64_t
+_get_md_size(struct spdk_reduce_vol_params *params, uint32_t blocklen)
+{
+	uint64_t size;
+
+	size = REDUCE_MD_IMAGE_OFFSET + _get_md_image_size(params) +
+	       _get_md_log_size(params, blocklen);
+
+	return spdk_divide_round_up(size, params->backing_io_unit_size) *
+	       params->backing_io_unit_size;
+}
+
 const struct spdk_uuid *
 spdk_reduce_vol_get_uuid(struct spdk_reduce_vol *vol)
 {
@@ -282,7 +502,7 @@ spdk_reduce_vol_get_uuid(struct spdk_reduce_vol *vol)
 static void
 _initialize_vol_pm_pointers(struct spdk_reduce_vol *vol)
 {
-	uint64_t logical_map_size;
+	uint64_t logical_map_size, chunk_maps_size;
 
 	/* Superblock is at the beginning of the pm file. */
 	vol->pm_super = (struct spdk_reduce_vol_superblock *)vol->pm_file.pm_buf;
@@ -293,6 +513,13 @@ _initialize_vol_pm_pointers(struct spdk_reduce_vol *vol)
 	/* Chunks maps follow the logical map. */
 	logical_map_size = _get_pm_logical_map_size(vol->params.vol_size, vol->params.chunk_size);
 	vol->pm_chunk_maps = (uint64_t *)((uint8_t *)vol->pm_logical_map + logical_map_size);
+
+	/* Write buffers follow the chunk maps. */
+	chunk_maps_size = _get_pm_total_chunks_size(vol->params.vol_size, vol->params.chunk_size,
+			  vol->params.backing_io_unit_size);
+	vol->pm_write_buffers = (uint8_t *)vol->pm_chunk_maps + chunk_maps_size;
+	vol->write_buffer_header_size = _get_pm_write_buffer_header_size(vol->params.chunk_size,
+					vol->params.logical_block_size);
 }
 
 /* We need 2 iovs during load - one for the superblock, another for the path */
@@ -305,6 +532,8 @@ struct reduce_init_load_ctx {
 	void					*cb_arg;
 	struct iovec				iov[LOAD_IOV_COUNT];
 	void					*path;
+	/* Log read when loading a volume without a pm file. */
+	uint8_t					*md_log_buf;
 };
 
 static inline bool
@@ -427,22 +656,218 @@ _allocate_vol_requests(struct spdk_reduce_vol *vol)
 	return rc;
 }
 
+struct reduce_md_io_ctx {
+	struct spdk_reduce_vol		*vol;
+	uint8_t				*buf;
+	uint64_t			offset;
+	uint64_t			len;
+	uint64_t			pos;
+	bool				is_write;
+	struct iovec			iov;
+	struct spdk_reduce_vol_cb_args	backing_cb_args;
+	spdk_reduce_vol_op_complete	cb_fn;
+	void				*cb_arg;
+};
+
+static void
+_reduce_md_io_next(void *cb_arg, int reduce_errno)
+{
+	struct reduce_md_io_ctx *ctx = cb_arg;
+	struct spdk_reduce_backing_dev *backing_dev = ctx->vol->backing_dev;
+	spdk_reduce_vol_op_complete cb_fn;
+	uint64_t lba;
+
+	if (reduce_errno != 0 || ctx->pos == ctx->len) {
+		cb_fn = ctx->cb_fn;
+		cb_arg = ctx->cb_arg;
+		free(ctx);
+		cb_fn(cb_arg, reduce_errno);
+		return;
+	}
+
+	ctx->iov.iov_base = ctx->buf + ctx->pos;
+	ctx->iov.iov_len = spdk_min(ctx->len - ctx->pos, REDUCE_MD_IO_SIZE);
+	lba = (ctx->offset + ctx->pos) / backing_dev->blocklen;
+	ctx->pos += ctx->iov.iov_len;
+
+	if (ctx->is_write) {
+		backing_dev->writev(backing_dev, &ctx->iov, 1, lba,
+				    ctx->iov.iov_len / backing_dev->blocklen, &ctx->backing_cb_args);
+	} else {
+		backing_dev->readv(backing_dev, &ctx->iov, 1, lba,
+				   ctx->iov.iov_len / backing_dev->blocklen, &ctx->backing_cb_args);
+	}
+}
+
+/* Read or write a metadata region of the backing device, in pieces of REDUCE_MD_IO_SIZE. */
+static void
+_reduce_md_io(struct spdk_reduce_vol *vol, void *buf, uint64_t offset, uint64_t len,
+	      bool is_write, spdk_reduce_vol_op_complete cb_fn, void *cb_arg)
+{
+	struct reduce_md_io_ctx *ctx;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->vol = vol;
+	ctx->buf = buf;
+	ctx->offset = offset;
+	ctx->len = len;
+	ctx->is_write = is_write;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->backing_cb_args.cb_fn = _reduce_md_io_next;
+	ctx->backing_cb_args.cb_arg = ctx;
+	_reduce_md_io_next(ctx, 0);
+}
+
+static int
+_reduce_md_log_create(struct spdk_reduce_vol *vol)
+{
+	struct reduce_md_log *log;
+	uint32_t blocklen = vol->backing_dev->blocklen;
+
+	log = calloc(1, sizeof(*log));
+	if (log == NULL) {
+		return -ENOMEM;
+	}
+
+	log->offset = REDUCE_MD_IMAGE_OFFSET + _get_md_image_size(&vol->params);
+	log->size = _get_md_log_size(&vol->params, blocklen);
+	log->record_size = _get_md_log_record_size(&vol->params);
+	log->max_batch_size = _get_md_log_max_batch_size(&vol->params, blocklen);
+	log->open_len = sizeof(struct reduce_md_log_batch);
+	TAILQ_INIT(&log->open_reqs);
+	TAILQ_INIT(&log->write_reqs);
+
+	log->open_buf = spdk_zmalloc(log->max_batch_size, REDUCE_MD_ALIGNMENT, NULL,
+				     SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	log->write_buf = spdk_zmalloc(log->max_batch_size, REDUCE_MD_ALIGNMENT, NULL,
+				      SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	log->checkpoint = spdk_zmalloc(sizeof(*log->checkpoint), REDUCE_MD_ALIGNMENT, NULL,
+				       SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	vol->md_log = log;
+	if (log->open_buf == NULL || log->write_buf == NULL || log->checkpoint == NULL) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void
+_reduce_md_log_free(struct spdk_reduce_vol *vol)
+{
+	struct reduce_md_log *log = vol->md_log;
+
+	if (log == NULL) {
+		return;
+	}
+
+	spdk_free(log->open_buf);
+	spdk_free(log->write_buf);
+	spdk_free(log->checkpoint);
+	free(log);
+	vol->md_log = NULL;
+}
+
+static uint32_t
+_reduce_md_checkpoint_crc(struct reduce_md_checkpoint *checkpoint)
+{
+	return spdk_crc32c_update(checkpoint, offsetof(struct reduce_md_checkpoint, crc), 0);
+}
+
+static void _reduce_md_log_submit(struct spdk_reduce_vol *vol);
+
+static void
+_reduce_md_checkpoint_done(void *cb_arg, int reduce_errno)
+{
+	struct spdk_reduce_vol *vol = cb_arg;
+	struct reduce_md_log *log = vol->md_log;
+	spdk_reduce_vol_op_complete cb_fn = log->checkpoint_cb_fn;
+
+	if (reduce_errno == 0) {
+		/* The log before the checkpoint is not needed anymore. */
+		log->head = log->checkpoint_log_start;
+	} else {
+		SPDK_ERRLOG("failed to checkpoint the metadata: %d\n", reduce_errno);
+	}
+
+	log->checkpointing = false;
+	log->checkpoint_cb_fn = NULL;
+	_reduce_md_log_submit(vol);
+
+	if (cb_fn != NULL) {
+		cb_fn(log->checkpoint_cb_arg, reduce_errno);
+	}
+}
+
+static void
+_reduce_md_checkpoint_image_done(void *cb_arg, int reduce_errno)
+{
+	struct spdk_reduce_vol *vol = cb_arg;
+	struct reduce_md_checkpoint *checkpoint = vol->md_log->checkpoint;
+
+	if (reduce_errno != 0) {
+		_reduce_md_checkpoint_done(vol, reduce_errno);
+		return;
+	}
+
+	/* Writing the checkpoint block commits the image. */
+	memset(checkpoint, 0, sizeof(*checkpoint));
+	memcpy(checkpoint->signature, REDUCE_MD_SIGNATURE, sizeof(checkpoint->signature));
+	checkpoint->seq = vol->md_log->checkpoint_seq;
+	checkpoint->log_start = vol->md_log->checkpoint_log_start;
+	checkpoint->crc = _reduce_md_checkpoint_crc(checkpoint);
+	_reduce_md_io(vol, checkpoint, REDUCE_MD_CHECKPOINT_OFFSET, sizeof(*checkpoint), true,
+		      _reduce_md_checkpoint_done, vol);
+}
+
+/*
+ * Write the metadata image while the updates keep being logged.  It may already contain some
+ *  of the updates logged after the checkpoint started, replaying these again is harmless.
+ *  This is only started between batch writes, so the log start and sequence number are
+ *  those of the next batch.
+ */
+static void
+_reduce_md_checkpoint(struct spdk_reduce_vol *vol)
+{
+	struct reduce_md_log *log = vol->md_log;
+
+	assert(!log->checkpointing && !log->writing);
+	log->checkpointing = true;
+	log->checkpoint_seq = log->seq;
+	log->checkpoint_log_start = log->tail;
+	_reduce_md_io(vol, vol->pm_file.pm_buf, REDUCE_MD_IMAGE_OFFSET,
+		      _get_md_image_size(&vol->params), true, _reduce_md_checkpoint_image_done, vol);
+}
+
 static void
 _init_load_cleanup(struct spdk_reduce_vol *vol, struct reduce_init_load_ctx *ctx)
 {
 	if (ctx != NULL) {
 		spdk_free(ctx->path);
+		spdk_free(ctx->md_log_buf);
 		free(ctx);
 	}
 
 	if (vol != NULL) {
 		if (vol->pm_file.pm_buf != NULL) {
-			pmem_unmap(vol->pm_file.pm_buf, vol->pm_file.size);
+			if (_reduce_vol_md_in_dram(vol)) {
+				spdk_free(vol->pm_file.pm_buf);
+			} else {
+				pmem_unmap(vol->pm_file.pm_buf, vol->pm_file.size);
+			}
 		}
 
+		_reduce_md_log_free(vol);
+
 		spdk_free(vol->backing_super);
 		spdk_bit_array_free(&vol->allocated_chunk_maps);
 		spdk_bit_array_free(&vol->allocated_backing_io_units);
+		spdk_bit_array_free(&vol->write_buffers_flushing);
 		free(vol->request_mem);
 		free(vol->buf_iov_mem);
 		spdk_free(vol->buf_mem);
@@ -512,6 +937,41 @@ _init_write_path_cpl(void *cb_arg, int reduce_errno)
 				 &init_ctx->backing_cb_args);
 }
 
+static void
+_init_write_path(struct reduce_init_load_ctx *init_ctx)
+{
+	struct spdk_reduce_vol *vol = init_ctx->vol;
+
+	memcpy(init_ctx->path, vol->pm_file.path, REDUCE_PATH_MAX);
+	init_ctx->iov[0].iov_base = init_ctx->path;
+	init_ctx->iov[0].iov_len = REDUCE_PATH_MAX;
+	init_ctx->backing_cb_args.cb_fn = _init_write_path_cpl;
+	init_ctx->backing_cb_args.cb_arg = init_ctx;
+	/* Write path to offset 4K on backing device - just after where the super
+	 *  block will be written.  We wait until this is committed before writing the
+	 *  super block to guarantee we don't get the super block written without the
+	 *  the path if the system crashed in the middle of a write operation.
+	 */
+	vol->backing_dev->writev(vol->backing_dev, init_ctx->iov, 1,
+				 REDUCE_BACKING_DEV_PATH_OFFSET / vol->backing_dev->blocklen,
+				 REDUCE_PATH_MAX / vol->backing_dev->blocklen,
+				 &init_ctx->backing_cb_args);
+}
+
+static void
+_init_write_checkpoint_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *init_ctx = cb_arg;
+
+	if (reduce_errno != 0) {
+		init_ctx->cb_fn(init_ctx->cb_arg, NULL, reduce_errno);
+		_init_load_cleanup(init_ctx->vol, init_ctx);
+		return;
+	}
+
+	_init_write_path(init_ctx);
+}
+
 static int
 _allocate_bit_arrays(struct spdk_reduce_vol *vol)
 {
@@ -521,15 +981,29 @@ _allocate_bit_arrays(struct spdk_reduce_vol *vol)
 	total_chunks = _get_total_chunks(vol->params.vol_size, vol->params.chunk_size);
 	vol->allocated_chunk_maps = spdk_bit_array_create(total_chunks);
 	total_backing_io_units = total_chunks * (vol->params.chunk_size / vol->params.backing_io_unit_size);
+
+	num_metadata_io_units = (sizeof(*vol->backing_super) + REDUCE_PATH_MAX) /
+				vol->backing_dev->blocklen;
+	if (_reduce_vol_md_in_dram(vol)) {
+		/* The metadata image and log come before the data, see _get_md_size(). */
+		num_metadata_io_units = _get_md_size(&vol->params, vol->backing_dev->blocklen) /
+					vol->params.backing_io_unit_size;
+		total_backing_io_units += num_metadata_io_units;
+	}
 	vol->allocated_backing_io_units = spdk_bit_array_create(total_backing_io_units);
 
 	if (vol->allocated_chunk_maps == NULL || vol->allocated_backing_io_units == NULL) {
 		return -ENOMEM;
 	}
 
+	if (vol->params.write_buffer_chunks > 0) {
+		vol->write_buffers_flushing = spdk_bit_array_create(vol->params.write_buffer_chunks);
+		if (vol->write_buffers_flushing == NULL) {
+			return -ENOMEM;
+		}
+	}
+
 	/* Set backing io unit bits associated with metadata. */
-	num_metadata_io_units = (sizeof(*vol->backing_super) + REDUCE_PATH_MAX) /
-				vol->backing_dev->blocklen;
 	for (i = 0; i < num_metadata_io_units; i++) {
 		spdk_bit_array_set(vol->allocated_backing_io_units, i);
 	}
@@ -545,23 +1019,29 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 {
 	struct spdk_reduce_vol *vol;
 	struct reduce_init_load_ctx *init_ctx;
-	uint64_t backing_dev_size;
+	uint64_t backing_dev_size, md_size;
 	size_t mapped_len;
 	int dir_len, max_dir_len, rc;
 
-	/* We need to append a path separator and the UUID to the supplied
-	 * path.
-	 */
-	max_dir_len = REDUCE_PATH_MAX - SPDK_UUID_STRING_LEN - 1;
-	dir_len = strnlen(pm_file_dir, max_dir_len);
-	/* Strip trailing slash if the user provided one - we will add it back
-	 * later when appending the filename.
-	 */
-	if (pm_file_dir[dir_len - 1] == '/') {
-		dir_len--;
-	}
-	if (dir_len == max_dir_len) {
-		SPDK_ERRLOG("pm_file_dir (%s) too long\n", pm_file_dir);
+	if (pm_file_dir != NULL) {
+		/* We need to append a path separator and the UUID to the supplied
+		 * path.
+		 */
+		max_dir_len = REDUCE_PATH_MAX - SPDK_UUID_STRING_LEN - 1;
+		dir_len = strnlen(pm_file_dir, max_dir_len);
+		/* Strip trailing slash if the user provided one - we will add it back
+		 * later when appending the filename.
+		 */
+		if (pm_file_dir[dir_len - 1] == '/') {
+			dir_len--;
+		}
+		if (dir_len == max_dir_len) {
+			SPDK_ERRLOG("pm_file_dir (%s) too long\n", pm_file_dir);
+			cb_fn(cb_arg, NULL, -EINVAL);
+			return;
+		}
+	} else if (params->write_buffer_chunks > 0) {
+		SPDK_ERRLOG("write buffer requires a pm file\n");
 		cb_fn(cb_arg, NULL, -EINVAL);
 		return;
 	}
@@ -575,6 +1055,11 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 
 	backing_dev_size = backing_dev->blockcnt * backing_dev->blocklen;
 	params->vol_size = _get_vol_size(params->chunk_size, backing_dev_size);
+	if (pm_file_dir == NULL && params->vol_size > 0) {
+		/* Leave room for the metadata, sized for the volume without it. */
+		md_size = spdk_min(_get_md_size(params, backing_dev->blocklen), backing_dev_size);
+		params->vol_size = _get_vol_size(params->chunk_size, backing_dev_size - md_size);
+	}
 	if (params->vol_size == 0) {
 		SPDK_ERRLOG("backing device is too small\n");
 		cb_fn(cb_arg, NULL, -EINVAL);
@@ -625,28 +1110,39 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 		spdk_uuid_generate(&params->uuid);
 	}
 
-	memcpy(vol->pm_file.path, pm_file_dir, dir_len);
-	vol->pm_file.path[dir_len] = '/';
-	spdk_uuid_fmt_lower(&vol->pm_file.path[dir_len + 1], SPDK_UUID_STRING_LEN,
-			    &params->uuid);
 	vol->pm_file.size = _get_pm_file_size(params);
-	vol->pm_file.pm_buf = pmem_map_file(vol->pm_file.path, vol->pm_file.size,
-					    PMEM_FILE_CREATE | PMEM_FILE_EXCL, 0600,
-					    &mapped_len, &vol->pm_file.pm_is_pmem);
-	if (vol->pm_file.pm_buf == NULL) {
-		SPDK_ERRLOG("could not pmem_map_file(%s): %s\n",
-			    vol->pm_file.path, strerror(errno));
-		cb_fn(cb_arg, NULL, -errno);
-		_init_load_cleanup(vol, init_ctx);
-		return;
-	}
+	if (pm_file_dir != NULL) {
+		memcpy(vol->pm_file.path, pm_file_dir, dir_len);
+		vol->pm_file.path[dir_len] = '/';
+		spdk_uuid_fmt_lower(&vol->pm_file.path[dir_len + 1], SPDK_UUID_STRING_LEN,
+				    &params->uuid);
+		vol->pm_file.pm_buf = pmem_map_file(vol->pm_file.path, vol->pm_file.size,
+						    PMEM_FILE_CREATE | PMEM_FILE_EXCL, 0600,
+						    &mapped_len, &vol->pm_file.pm_is_pmem);
+		if (vol->pm_file.pm_buf == NULL) {
+			SPDK_ERRLOG("could not pmem_map_file(%s): %s\n",
+				    vol->pm_file.path, strerror(errno));
+			cb_fn(cb_arg, NULL, -errno);
+			_init_load_cleanup(vol, init_ctx);
+			return;
+		}
 
-	if (vol->pm_file.size != mapped_len) {
-		SPDK_ERRLOG("could not map entire pmem file (size=%" PRIu64 " mapped=%" PRIu64 ")\n",
-			    vol->pm_file.size, mapped_len);
-		cb_fn(cb_arg, NULL, -ENOMEM);
-		_init_load_cleanup(vol, init_ctx);
-		return;
+		if (vol->pm_file.size != mapped_len) {
+			SPDK_ERRLOG("could not map entire pmem file (size=%" PRIu64 " mapped=%" PRIu64 ")\n",
+				    vol->pm_file.size, mapped_len);
+			cb_fn(cb_arg, NULL, -ENOMEM);
+			_init_load_cleanup(vol, init_ctx);
+			return;
+		}
+	} else {
+		/* Keep the metadata in DRAM, it is journaled to the backing device. */
+		vol->pm_file.pm_buf = spdk_zmalloc(_get_md_image_size(params), REDUCE_MD_ALIGNMENT,
+						   NULL, SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+		if (vol->pm_file.pm_buf == NULL) {
+			cb_fn(cb_arg, NULL, -ENOMEM);
+			_init_load_cleanup(vol, init_ctx);
+			return;
+		}
 	}
 
 	vol->backing_io_units_per_chunk = params->chunk_size / params->backing_io_unit_size;
@@ -680,42 +1176,258 @@ spdk_reduce_vol_init(struct spdk_reduce_vol_params *params,
 	init_ctx->cb_fn = cb_fn;
 	init_ctx->cb_arg = cb_arg;
 
-	memcpy(init_ctx->path, vol->pm_file.path, REDUCE_PATH_MAX);
-	init_ctx->iov[0].iov_base = init_ctx->path;
-	init_ctx->iov[0].iov_len = REDUCE_PATH_MAX;
-	init_ctx->backing_cb_args.cb_fn = _init_write_path_cpl;
-	init_ctx->backing_cb_args.cb_arg = init_ctx;
-	/* Write path to offset 4K on backing device - just after where the super
-	 *  block will be written.  We wait until this is committed before writing the
-	 *  super block to guarantee we don't get the super block written without the
-	 *  the path if the system crashed in the middle of a write operation.
-	 */
-	vol->backing_dev->writev(vol->backing_dev, init_ctx->iov, 1,
-				 REDUCE_BACKING_DEV_PATH_OFFSET / vol->backing_dev->blocklen,
-				 REDUCE_PATH_MAX / vol->backing_dev->blocklen,
-				 &init_ctx->backing_cb_args);
+	if (pm_file_dir == NULL) {
+		rc = _reduce_md_log_create(vol);
+		if (rc != 0) {
+			cb_fn(cb_arg, NULL, rc);
+			_init_load_cleanup(vol, init_ctx);
+			return;
+		}
+
+		/*
+		 * Start the sequence from the uuid, so that batches left on the backing device by
+		 *  a previous volume are never replayed.
+		 */
+		memcpy(&vol->md_log->seq, &vol->params.uuid, sizeof(vol->md_log->seq));
+		/* The metadata image must be on the backing device before the super block. */
+		vol->md_log->checkpoint_cb_fn = _init_write_checkpoint_cpl;
+		vol->md_log->checkpoint_cb_arg = init_ctx;
+		_reduce_md_checkpoint(vol);
+		return;
+	}
+
+	_init_write_path(init_ctx);
 }
 
 static void destroy_load_cb(void *cb_arg, struct spdk_reduce_vol *vol, int reduce_errno);
 
 static void
-_load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
+_load_allocate_maps(struct reduce_init_load_ctx *load_ctx)
 {
-	struct reduce_init_load_ctx *load_ctx = cb_arg;
 	struct spdk_reduce_vol *vol = load_ctx->vol;
-	uint64_t backing_dev_size;
 	uint64_t i, num_chunks, logical_map_index;
 	struct spdk_reduce_chunk_map *chunk;
-	size_t mapped_len;
 	uint32_t j;
 	int rc;
 
-	rc = _alloc_zero_buff();
-	if (rc) {
-		goto error;
+	rc = _allocate_vol_requests(vol);
+	if (rc != 0) {
+		load_ctx->cb_fn(load_ctx->cb_arg, NULL, rc);
+		_init_load_cleanup(vol, load_ctx);
+		return;
 	}
 
-	if (memcmp(vol->backing_super->signature,
+	_initialize_vol_pm_pointers(vol);
+
+	num_chunks = vol->params.vol_size / vol->params.chunk_size;
+	for (i = 0; i < num_chunks; i++) {
+		logical_map_index = vol->pm_logical_map[i];
+		if (logical_map_index == REDUCE_EMPTY_MAP_ENTRY) {
+			continue;
+		}
+		spdk_bit_array_set(vol->allocated_chunk_maps, logical_map_index);
+		chunk = _reduce_vol_get_chunk_map(vol, logical_map_index);
+		for (j = 0; j < vol->backing_io_units_per_chunk; j++) {
+			if (chunk->io_unit_index[j] != REDUCE_EMPTY_MAP_ENTRY) {
+				spdk_bit_array_set(vol->allocated_backing_io_units, chunk->io_unit_index[j]);
+			}
+		}
+	}
+
+	load_ctx->cb_fn(load_ctx->cb_arg, vol, 0);
+	/* Only clean up the ctx - the vol has been passed to the application
+	 *  for use now that volume load was successful.
+	 */
+	_init_load_cleanup(NULL, load_ctx);
+}
+
+static void
+_load_md_failed(struct reduce_init_load_ctx *load_ctx, int reduce_errno)
+{
+	load_ctx->cb_fn(load_ctx->cb_arg, NULL, reduce_errno);
+	_init_load_cleanup(load_ctx->vol, load_ctx);
+}
+
+static bool
+_load_md_batch_is_valid(struct spdk_reduce_vol *vol, struct reduce_md_log_batch *batch,
+			uint64_t seq, uint64_t max_size)
+{
+	uint32_t crc;
+
+	if (max_size < sizeof(*batch) ||
+	    memcmp(batch->signature, REDUCE_MD_SIGNATURE, sizeof(batch->signature)) != 0 ||
+	    batch->seq != seq || batch->size > max_size ||
+	    batch->size % vol->backing_dev->blocklen != 0 ||
+	    batch->size < sizeof(*batch) + (uint64_t)batch->num_records * vol->md_log->record_size) {
+		return false;
+	}
+
+	crc = batch->crc;
+	batch->crc = 0;
+
+	return spdk_crc32c_update(batch, batch->size, 0) == crc;
+}
+
+/* Apply the batches logged since the checkpoint, up to the first one missing or torn. */
+static int
+_load_md_log_replay(struct spdk_reduce_vol *vol, uint8_t *log_buf)
+{
+	struct reduce_md_log *log = vol->md_log;
+	struct reduce_md_log_batch *batch;
+	struct reduce_md_log_record *record;
+	uint64_t pos, end, seq, num_chunks, total_chunks;
+	uint32_t i;
+
+	num_chunks = vol->params.vol_size / vol->params.chunk_size;
+	total_chunks = _get_total_chunks(vol->params.vol_size, vol->params.chunk_size);
+	pos = end = log->checkpoint->log_start;
+	seq = log->checkpoint->seq;
+
+	while (true) {
+		batch = (struct reduce_md_log_batch *)(log_buf + pos);
+		if (!_load_md_batch_is_valid(vol, batch, seq, log->size - pos)) {
+			/* The batch goes to the start of the log when it doesn't fit at the end. */
+			if (pos == 0) {
+				break;
+			}
+			pos = 0;
+			continue;
+		}
+
+		for (i = 0; i < batch->num_records; i++) {
+			record = (struct reduce_md_log_record *)((uint8_t *)(batch + 1) +
+					i * log->record_size);
+			if (record->logical_map_index >= num_chunks ||
+			    record->chunk_map_index >= total_chunks) {
+				SPDK_ERRLOG("invalid metadata log record\n");
+				return -EILSEQ;
+			}
+
+			vol->pm_logical_map[record->logical_map_index] = record->chunk_map_index;
+			memcpy(_reduce_vol_get_chunk_map(vol, record->chunk_map_index),
+			       &record->chunk,
+			       _reduce_vol_get_chunk_struct_size(vol->backing_io_units_per_chunk));
+		}
+
+		pos += batch->size;
+		end = pos;
+		seq++;
+	}
+
+	log->head = log->checkpoint->log_start;
+	log->tail = end;
+	log->seq = seq;
+
+	return 0;
+}
+
+static void
+_load_md_log_read_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *load_ctx = cb_arg;
+
+	if (reduce_errno == 0) {
+		reduce_errno = _load_md_log_replay(load_ctx->vol, load_ctx->md_log_buf);
+	}
+
+	if (reduce_errno != 0) {
+		_load_md_failed(load_ctx, reduce_errno);
+		return;
+	}
+
+	_load_allocate_maps(load_ctx);
+}
+
+static void
+_load_md_image_read_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *load_ctx = cb_arg;
+	struct spdk_reduce_vol *vol = load_ctx->vol;
+	struct reduce_md_log *log = vol->md_log;
+
+	if (reduce_errno != 0) {
+		_load_md_failed(load_ctx, reduce_errno);
+		return;
+	}
+
+	_initialize_vol_pm_pointers(vol);
+
+	load_ctx->md_log_buf = spdk_malloc(log->size, REDUCE_MD_ALIGNMENT, NULL,
+					   SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	if (load_ctx->md_log_buf == NULL) {
+		_load_md_failed(load_ctx, -ENOMEM);
+		return;
+	}
+
+	_reduce_md_io(vol, load_ctx->md_log_buf, log->offset, log->size, false,
+		      _load_md_log_read_cpl, load_ctx);
+}
+
+static void
+_load_md_checkpoint_read_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *load_ctx = cb_arg;
+	struct spdk_reduce_vol *vol = load_ctx->vol;
+	struct reduce_md_checkpoint *checkpoint = vol->md_log->checkpoint;
+
+	if (reduce_errno == 0 &&
+	    (memcmp(checkpoint->signature, REDUCE_MD_SIGNATURE,
+		    sizeof(checkpoint->signature)) != 0 ||
+	     checkpoint->crc != _reduce_md_checkpoint_crc(checkpoint) ||
+	     checkpoint->log_start > vol->md_log->size)) {
+		SPDK_ERRLOG("invalid metadata checkpoint\n");
+		reduce_errno = -EILSEQ;
+	}
+
+	if (reduce_errno != 0) {
+		_load_md_failed(load_ctx, reduce_errno);
+		return;
+	}
+
+	_reduce_md_io(vol, vol->pm_file.pm_buf, REDUCE_MD_IMAGE_OFFSET,
+		      _get_md_image_size(&vol->params), false, _load_md_image_read_cpl, load_ctx);
+}
+
+/* Load the metadata image of a volume without a pm file, and replay its log. */
+static void
+_load_md(struct reduce_init_load_ctx *load_ctx)
+{
+	struct spdk_reduce_vol *vol = load_ctx->vol;
+	int rc;
+
+	vol->pm_file.pm_buf = spdk_zmalloc(_get_md_image_size(&vol->params), REDUCE_MD_ALIGNMENT,
+					   NULL, SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
+	if (vol->pm_file.pm_buf == NULL) {
+		_load_md_failed(load_ctx, -ENOMEM);
+		return;
+	}
+
+	rc = _reduce_md_log_create(vol);
+	if (rc != 0) {
+		_load_md_failed(load_ctx, rc);
+		return;
+	}
+
+	_reduce_md_io(vol, vol->md_log->checkpoint, REDUCE_MD_CHECKPOINT_OFFSET,
+		      sizeof(*vol->md_log->checkpoint), false, _load_md_checkpoint_read_cpl,
+		      load_ctx);
+}
+
+static void
+_load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_init_load_ctx *load_ctx = cb_arg;
+	struct spdk_reduce_vol *vol = load_ctx->vol;
+	uint64_t backing_dev_size;
+	size_t mapped_len;
+	int rc;
+
+	rc = _alloc_zero_buff();
+	if (rc) {
+		goto error;
+	}
+
+	if (memcmp(vol->backing_super->signature,
 		   SPDK_REDUCE_SIGNATURE,
 		   sizeof(vol->backing_super->signature)) != 0) {
 		/* This backing device isn't a libreduce backing device. */
@@ -754,6 +1466,11 @@ _load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
 	}
 
 	vol->pm_file.size = _get_pm_file_size(&vol->params);
+	if (_reduce_vol_md_in_dram(vol)) {
+		_load_md(load_ctx);
+		return;
+	}
+
 	vol->pm_file.pm_buf = pmem_map_file(vol->pm_file.path, 0, 0, 0, &mapped_len,
 					    &vol->pm_file.pm_is_pmem);
 	if (vol->pm_file.pm_buf == NULL) {
@@ -769,33 +1486,7 @@ _load_read_super_and_path_cpl(void *cb_arg, int reduce_errno)
 		goto error;
 	}
 
-	rc = _allocate_vol_requests(vol);
-	if (rc != 0) {
-		goto error;
-	}
-
-	_initialize_vol_pm_pointers(vol);
-
-	num_chunks = vol->params.vol_size / vol->params.chunk_size;
-	for (i = 0; i < num_chunks; i++) {
-		logical_map_index = vol->pm_logical_map[i];
-		if (logical_map_index == REDUCE_EMPTY_MAP_ENTRY) {
-			continue;
-		}
-		spdk_bit_array_set(vol->allocated_chunk_maps, logical_map_index);
-		chunk = _reduce_vol_get_chunk_map(vol, logical_map_index);
-		for (j = 0; j < vol->backing_io_units_per_chunk; j++) {
-			if (chunk->io_unit_index[j] != REDUCE_EMPTY_MAP_ENTRY) {
-				spdk_bit_array_set(vol->allocated_backing_io_units, chunk->io_unit_index[j]);
-			}
-		}
-	}
-
-	load_ctx->cb_fn(load_ctx->cb_arg, vol, 0);
-	/* Only clean up the ctx - the vol has been passed to the application
-	 *  for use now that volume load was successful.
-	 */
-	_init_load_cleanup(NULL, load_ctx);
+	_load_allocate_maps(load_ctx);
 	return;
 
 error:
@@ -868,6 +1559,25 @@ spdk_reduce_vol_load(struct spdk_reduce_backing_dev *backing_dev,
 				&load_ctx->backing_cb_args);
 }
 
+static void
+_unload_vol(struct spdk_reduce_vol *vol, spdk_reduce_vol_op_complete cb_fn, void *cb_arg)
+{
+	if (--g_vol_count == 0) {
+		spdk_free(g_zero_buf);
+	}
+	assert(g_vol_count >= 0);
+	_init_load_cleanup(vol, NULL);
+	cb_fn(cb_arg, 0);
+}
+
+static void
+_unload_checkpoint_cpl(void *cb_arg, int reduce_errno)
+{
+	struct spdk_reduce_vol *vol = cb_arg;
+
+	_unload_vol(vol, vol->unload_cb_fn, vol->unload_cb_arg);
+}
+
 void
 spdk_reduce_vol_unload(struct spdk_reduce_vol *vol,
 		       spdk_reduce_vol_op_complete cb_fn, void *cb_arg)
@@ -879,12 +1589,16 @@ spdk_reduce_vol_unload(struct spdk_reduce_vol *vol,
 		return;
 	}
 
-	if (--g_vol_count == 0) {
-		spdk_free(g_zero_buf);
+	if (vol->md_log != NULL && vol->md_log->checkpointing) {
+		/* Let the checkpoint finish, the image is still being written from the vol. */
+		vol->unload_cb_fn = cb_fn;
+		vol->unload_cb_arg = cb_arg;
+		vol->md_log->checkpoint_cb_fn = _unload_checkpoint_cpl;
+		vol->md_log->checkpoint_cb_arg = vol;
+		return;
 	}
-	assert(g_vol_count >= 0);
-	_init_load_cleanup(vol, NULL);
-	cb_fn(cb_arg, 0);
+
+	_unload_vol(vol, cb_fn, cb_arg);
 }
 
 struct reduce_destroy_ctx {
@@ -903,7 +1617,7 @@ destroy_unload_cpl(void *cb_arg, int reduce_errno)
 {
 	struct reduce_destroy_ctx *destroy_ctx = cb_arg;
 
-	if (destroy_ctx->reduce_errno == 0) {
+	if (destroy_ctx->reduce_errno == 0 && destroy_ctx->pm_path[0] != '\0') {
 		if (unlink(destroy_ctx->pm_path)) {
 			SPDK_ERRLOG("%s could not be unlinked: %s\n",
 				    destroy_ctx->pm_path, strerror(errno));
@@ -987,6 +1701,96 @@ _request_spans_chunk_boundary(struct spdk_reduce_vol *vol, uint64_t offset, uint
 	return (start_chunk != end_chunk);
 }
 
+static inline uint64_t
+_reduce_vol_get_write_buffer_entry_size(struct spdk_reduce_vol *vol)
+{
+	return vol->write_buffer_header_size +
+	       spdk_divide_round_up(vol->params.chunk_size, REDUCE_PM_SIZE_ALIGNMENT) *
+	       REDUCE_PM_SIZE_ALIGNMENT;
+}
+
+static struct spdk_reduce_write_buffer *
+_reduce_vol_get_write_buffer(struct spdk_reduce_vol *vol, uint32_t index)
+{
+	assert(index < vol->params.write_buffer_chunks);
+
+	return (struct spdk_reduce_write_buffer *)(vol->pm_write_buffers +
+			index * _reduce_vol_get_write_buffer_entry_size(vol));
+}
+
+static inline uint32_t
+_reduce_vol_get_write_buffer_index(struct spdk_reduce_vol *vol, struct spdk_reduce_write_buffer *wb)
+{
+	uint64_t offset = (uint8_t *)wb - vol->pm_write_buffers;
+
+	return offset / _reduce_vol_get_write_buffer_entry_size(vol);
+}
+
+static inline uint8_t *
+_reduce_write_buffer_data(struct spdk_reduce_vol *vol, struct spdk_reduce_write_buffer *wb)
+{
+	return (uint8_t *)wb + vol->write_buffer_header_size;
+}
+
+static inline bool
+_reduce_write_buffer_block_is_valid(struct spdk_reduce_write_buffer *wb, uint64_t block)
+{
+	return (wb->valid_blocks[block / 64] & (1ULL << (block % 64))) != 0;
+}
+
+static struct spdk_reduce_write_buffer *
+_reduce_vol_find_write_buffer(struct spdk_reduce_vol *vol, uint64_t logical_map_index)
+{
+	struct spdk_reduce_write_buffer *wb;
+	uint32_t i;
+
+	for (i = 0; i < vol->params.write_buffer_chunks; i++) {
+		wb = _reduce_vol_get_write_buffer(vol, i);
+		if (wb->logical_map_index == logical_map_index) {
+			return wb;
+		}
+	}
+
+	return NULL;
+}
+
+/* Copy the blocks written to a write buffer entry into the user buffers of a read request. */
+static void
+_reduce_write_buffer_copy_out(struct spdk_reduce_vol_request *req,
+			      struct spdk_reduce_write_buffer *wb)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+	uint32_t lbsize = vol->params.logical_block_size;
+	uint64_t block, chunk_offset;
+	uint8_t *data;
+	size_t len, skip;
+	struct spdk_iov_xfer ix;
+
+	chunk_offset = req->offset % vol->logical_blocks_per_chunk;
+	data = _reduce_write_buffer_data(vol, wb);
+	spdk_iov_xfer_init(&ix, req->iov, req->iovcnt);
+
+	for (block = chunk_offset; block < chunk_offset + req->length; block++) {
+		if (_reduce_write_buffer_block_is_valid(wb, block)) {
+			spdk_iov_xfer_from_buf(&ix, data + block * lbsize, lbsize);
+			continue;
+		}
+
+		/* Skip the block, the user buffer already holds the data from the backing device */
+		len = lbsize;
+		while (len > 0) {
+			if (ix.cur_iov_offset == ix.iovs[ix.cur_iov_idx].iov_len) {
+				ix.cur_iov_idx++;
+				ix.cur_iov_offset = 0;
+				continue;
+			}
+			skip = spdk_min(len, ix.iovs[ix.cur_iov_idx].iov_len - ix.cur_iov_offset);
+			ix.cur_iov_offset += skip;
+			len -= skip;
+		}
+	}
+}
+
 typedef void (*reduce_request_fn)(void *_req, int reduce_errno);
 
 static void
@@ -1014,14 +1818,197 @@ _reduce_vol_complete_req(struct spdk_reduce_vol_request *req, int reduce_errno)
 	TAILQ_INSERT_HEAD(&vol->free_requests, req, tailq);
 }
 
+static void
+_reduce_vol_release_chunk_map(struct spdk_reduce_vol *vol, uint64_t chunk_map_index)
+{
+	struct spdk_reduce_chunk_map *chunk;
+	uint32_t i;
+
+	chunk = _reduce_vol_get_chunk_map(vol, chunk_map_index);
+	for (i = 0; i < vol->backing_io_units_per_chunk; i++) {
+		if (chunk->io_unit_index[i] == REDUCE_EMPTY_MAP_ENTRY) {
+			break;
+		}
+		assert(spdk_bit_array_get(vol->allocated_backing_io_units, chunk->io_unit_index[i]) == true);
+		spdk_bit_array_clear(vol->allocated_backing_io_units, chunk->io_unit_index[i]);
+		chunk->io_unit_index[i] = REDUCE_EMPTY_MAP_ENTRY;
+	}
+	spdk_bit_array_clear(vol->allocated_chunk_maps, chunk_map_index);
+}
+
+static void
+_reduce_vol_update_logical_map(struct spdk_reduce_vol *vol, uint64_t logical_map_index,
+			       uint64_t chunk_map_index)
+{
+	uint64_t old_chunk_map_index;
+
+	old_chunk_map_index = vol->pm_logical_map[logical_map_index];
+	if (old_chunk_map_index != REDUCE_EMPTY_MAP_ENTRY) {
+		_reduce_vol_release_chunk_map(vol, old_chunk_map_index);
+	}
+
+	/*
+	 * We don't need to persist the clearing of the old chunk map here.  The old chunk map
+	 * becomes invalid after we update the logical map, since the old chunk map will no
+	 * longer have a reference to it in the logical map.
+	 */
+
+	/* Persist the new chunk map.  This must be persisted before we update the logical map. */
+	_reduce_persist(vol, _reduce_vol_get_chunk_map(vol, chunk_map_index),
+			_reduce_vol_get_chunk_struct_size(vol->backing_io_units_per_chunk));
+
+	vol->pm_logical_map[logical_map_index] = chunk_map_index;
+
+	_reduce_persist(vol, &vol->pm_logical_map[logical_map_index], sizeof(uint64_t));
+}
+
+static bool
+_reduce_md_log_get_room(struct reduce_md_log *log, uint32_t len, uint64_t *pos)
+{
+	/* The tail never catches up with the head, they are only equal when the log is empty. */
+	if (log->tail >= log->head) {
+		if (log->tail + len <= log->size) {
+			*pos = log->tail;
+			return true;
+		}
+		if (len < log->head) {
+			*pos = 0;
+			return true;
+		}
+		return false;
+	}
+
+	if (log->tail + len < log->head) {
+		*pos = log->tail;
+		return true;
+	}
+
+	return false;
+}
+
+static void
+_reduce_md_log_write_done(void *cb_arg, int reduce_errno)
+{
+	struct spdk_reduce_vol *vol = cb_arg;
+	struct reduce_md_log *log = vol->md_log;
+	struct spdk_reduce_vol_request *req, *tmp;
+	TAILQ_HEAD(, spdk_reduce_vol_request) reqs;
+	uint64_t used;
+
+	log->writing = false;
+	TAILQ_INIT(&reqs);
+	TAILQ_SWAP(&reqs, &log->write_reqs, spdk_reduce_vol_request, md_log_tailq);
+
+	if (reduce_errno == 0) {
+		log->tail = log->write_pos + log->write_len;
+		log->seq++;
+	} else {
+		SPDK_ERRLOG("failed to write the metadata log: %d\n", reduce_errno);
+	}
+
+	/* The updates must be in the logical map before a checkpoint takes its image. */
+	TAILQ_FOREACH(req, &reqs, md_log_tailq) {
+		if (reduce_errno == 0) {
+			_reduce_vol_update_logical_map(vol, req->logical_map_index,
+						       req->chunk_map_index);
+		} else {
+			_reduce_vol_release_chunk_map(vol, req->chunk_map_index);
+		}
+	}
+
+	used = log->tail >= log->head ? log->tail - log->head : log->size - log->head + log->tail;
+	if (used > log->size / 2 && !log->checkpointing) {
+		_reduce_md_checkpoint(vol);
+	}
+
+	TAILQ_FOREACH_SAFE(req, &reqs, md_log_tailq, tmp) {
+		TAILQ_REMOVE(&reqs, req, md_log_tailq);
+		_reduce_vol_complete_req(req, reduce_errno);
+	}
+
+	_reduce_md_log_submit(vol);
+}
+
+/* Write the open batch, unless a batch is already being written. */
+static void
+_reduce_md_log_submit(struct spdk_reduce_vol *vol)
+{
+	struct reduce_md_log *log = vol->md_log;
+	struct spdk_reduce_backing_dev *backing_dev = vol->backing_dev;
+	struct reduce_md_log_batch *batch;
+	uint32_t len;
+	uint64_t pos;
+	uint8_t *buf;
+
+	if (log->writing || log->open_records == 0) {
+		return;
+	}
+
+	len = spdk_divide_round_up(log->open_len, backing_dev->blocklen) * backing_dev->blocklen;
+	if (!_reduce_md_log_get_room(log, len, &pos)) {
+		/* The batch is written once the checkpoint frees the start of the log. */
+		if (!log->checkpointing) {
+			_reduce_md_checkpoint(vol);
+		}
+		return;
+	}
+
+	batch = (struct reduce_md_log_batch *)log->open_buf;
+	memset(log->open_buf + log->open_len, 0, len - log->open_len);
+	memcpy(batch->signature, REDUCE_MD_SIGNATURE, sizeof(batch->signature));
+	batch->seq = log->seq;
+	batch->num_records = log->open_records;
+	batch->size = len;
+	batch->crc = 0;
+	batch->reserved = 0;
+	batch->crc = spdk_crc32c_update(batch, len, 0);
+
+	buf = log->write_buf;
+	log->write_buf = log->open_buf;
+	log->open_buf = buf;
+	log->open_len = sizeof(*batch);
+	log->open_records = 0;
+	TAILQ_SWAP(&log->write_reqs, &log->open_reqs, spdk_reduce_vol_request, md_log_tailq);
+
+	log->writing = true;
+	log->write_pos = pos;
+	log->write_len = len;
+	log->iov.iov_base = log->write_buf;
+	log->iov.iov_len = len;
+	log->backing_cb_args.cb_fn = _reduce_md_log_write_done;
+	log->backing_cb_args.cb_arg = vol;
+	backing_dev->writev(backing_dev, &log->iov, 1, (log->offset + pos) / backing_dev->blocklen,
+			    len / backing_dev->blocklen, &log->backing_cb_args);
+}
+
+/*
+ * Journal the new chunk map of a request.  The logical map is only updated, and the old
+ *  chunk map released, once its batch is on the backing device.
+ */
+static void
+_reduce_md_log_append(struct spdk_reduce_vol_request *req)
+{
+	struct reduce_md_log *log = req->vol->md_log;
+	struct reduce_md_log_record *record;
+
+	assert(log->open_len + log->record_size <= log->max_batch_size);
+	record = (struct reduce_md_log_record *)(log->open_buf + log->open_len);
+	record->logical_map_index = req->logical_map_index;
+	record->chunk_map_index = req->chunk_map_index;
+	memcpy(&record->chunk, req->chunk,
+	       _reduce_vol_get_chunk_struct_size(req->vol->backing_io_units_per_chunk));
+	log->open_len += log->record_size;
+	log->open_records++;
+	TAILQ_INSERT_TAIL(&log->open_reqs, req, md_log_tailq);
+
+	_reduce_md_log_submit(req->vol);
+}
+
 static void
 _write_write_done(void *_req, int reduce_errno)
 {
 	struct spdk_reduce_vol_request *req = _req;
 	struct spdk_reduce_vol *vol = req->vol;
-	uint64_t old_chunk_map_index;
-	struct spdk_reduce_chunk_map *old_chunk;
-	uint32_t i;
 
 	if (reduce_errno != 0) {
 		req->reduce_errno = reduce_errno;
@@ -1037,33 +2024,12 @@ _write_write_done(void *_req, int reduce_errno)
 		return;
 	}
 
-	old_chunk_map_index = vol->pm_logical_map[req->logical_map_index];
-	if (old_chunk_map_index != REDUCE_EMPTY_MAP_ENTRY) {
-		old_chunk = _reduce_vol_get_chunk_map(vol, old_chunk_map_index);
-		for (i = 0; i < vol->backing_io_units_per_chunk; i++) {
-			if (old_chunk->io_unit_index[i] == REDUCE_EMPTY_MAP_ENTRY) {
-				break;
-			}
-			assert(spdk_bit_array_get(vol->allocated_backing_io_units, old_chunk->io_unit_index[i]) == true);
-			spdk_bit_array_clear(vol->allocated_backing_io_units, old_chunk->io_unit_index[i]);
-			old_chunk->io_unit_index[i] = REDUCE_EMPTY_MAP_ENTRY;
-		}
-		spdk_bit_array_clear(vol->allocated_chunk_maps, old_chunk_map_index);
+	if (vol->md_log != NULL) {
+		_reduce_md_log_append(req);
+		return;
 	}
 
-	/*
-	 * We don't need to persist the clearing of the old chunk map here.  The old chunk map
-	 * becomes invalid after we update the logical map, since the old chunk map will no
-	 * longer have a reference to it in the logical map.
-	 */
-
-	/* Persist the new chunk map.  This must be persisted before we update the logical map. */
-	_reduce_persist(vol, req->chunk,
-			_reduce_vol_get_chunk_struct_size(vol->backing_io_units_per_chunk));
-
-	vol->pm_logical_map[req->logical_map_index] = req->chunk_map_index;
-
-	_reduce_persist(vol, &vol->pm_logical_map[req->logical_map_index], sizeof(uint64_t));
+	_reduce_vol_update_logical_map(vol, req->logical_map_index, req->chunk_map_index);
 
 	_reduce_vol_complete_req(req, 0);
 }
@@ -1127,8 +2093,10 @@ _reduce_vol_write_chunk(struct spdk_reduce_vol_request *req, reduce_request_fn n
 	req->chunk->compressed_size =
 		req->chunk_is_compressed ? compressed_size : vol->params.chunk_size;
 
-	/* if the chunk is uncompressed we need to copy the data from the host buffers. */
-	if (req->chunk_is_compressed == false) {
+	/* if the chunk is uncompressed we need to copy the data from the host buffers.  A write
+	 *  buffer write back already merged the whole chunk in the scratch buffer.
+	 */
+	if (req->chunk_is_compressed == false && req->write_buffer == NULL) {
 		chunk_offset = req->offset % vol->logical_blocks_per_chunk;
 		buf = req->decomp_buf;
 		total_len = chunk_offset * vol->params.logical_block_size;
@@ -1167,10 +2135,25 @@ _reduce_vol_write_chunk(struct spdk_reduce_vol_request *req, reduce_request_fn n
 	_issue_backing_ops(req, vol, next_fn, true /* write */);
 }
 
+static void
+_reduce_vol_count_chunk(struct spdk_reduce_vol *vol, uint32_t num_io_units)
+{
+	uint64_t bucket = 0;
+
+	if (num_io_units > 0) {
+		bucket = ((uint64_t)num_io_units * vol->params.backing_io_unit_size *
+			  SPDK_REDUCE_RATIO_BUCKETS - 1) / vol->params.chunk_size;
+	}
+
+	vol->stats.ratio_histogram[spdk_min(bucket, SPDK_REDUCE_RATIO_BUCKETS - 1)]++;
+}
+
 static void
 _write_compress_done(void *_req, int reduce_errno)
 {
 	struct spdk_reduce_vol_request *req = _req;
+	struct spdk_reduce_vol *vol = req->vol;
+	uint32_t num_io_units;
 
 	/* Negative reduce_errno indicates failure for compression operations.
 	 * Just write the uncompressed data instead.  Force this to happen
@@ -1179,8 +2162,21 @@ _write_compress_done(void *_req, int reduce_errno)
 	 * the uncompressed buffer to disk.
 	 */
 	if (reduce_errno < 0) {
-		req->backing_cb_args.output_size = req->vol->params.chunk_size;
+		req->backing_cb_args.output_size = vol->params.chunk_size;
+	}
+
+	num_io_units = spdk_divide_round_up(req->backing_cb_args.output_size,
+					    vol->params.backing_io_unit_size);
+	if (num_io_units < vol->backing_io_units_per_chunk) {
+		vol->stats.compressed_chunks++;
+		vol->incompressible_streak = 0;
+		vol->bypass_count = 0;
+	} else {
+		num_io_units = vol->backing_io_units_per_chunk;
+		vol->stats.incompressible_chunks++;
+		vol->incompressible_streak++;
 	}
+	_reduce_vol_count_chunk(vol, num_io_units);
 
 	_reduce_vol_write_chunk(req, _write_write_done, req->backing_cb_args.output_size);
 }
@@ -1199,6 +2195,68 @@ _reduce_vol_compress_chunk(struct spdk_reduce_vol_request *req, reduce_request_f
 				   &req->backing_cb_args);
 }
 
+/*
+ * Estimate the collision entropy of the chunk from a fixed number of its bytes.  Chunks of
+ *  already compressed or encrypted data are very unlikely to save a backing io unit.
+ */
+static bool
+_reduce_vol_chunk_is_random(struct spdk_reduce_vol_request *req)
+{
+	uint32_t counts[UINT8_MAX + 1] = {};
+	uint64_t stride, pos = 0, num_samples = 0, sum = 0;
+	uint8_t *buf;
+	int i;
+
+	stride = spdk_max(req->vol->params.chunk_size / REDUCE_ENTROPY_SAMPLES, 1);
+	for (i = 0; i < req->decomp_iovcnt; i++) {
+		buf = req->decomp_iov[i].iov_base;
+		for (; pos < req->decomp_iov[i].iov_len; pos += stride) {
+			counts[buf[pos]]++;
+			num_samples++;
+		}
+		pos -= req->decomp_iov[i].iov_len;
+	}
+
+	for (i = 0; i <= UINT8_MAX; i++) {
+		sum += (uint64_t)counts[i] * counts[i];
+	}
+
+	return sum * REDUCE_ENTROPY_DIVISOR <= num_samples * num_samples;
+}
+
+static bool
+_reduce_vol_bypass_compression(struct spdk_reduce_vol_request *req)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+
+	if (_reduce_vol_chunk_is_random(req)) {
+		return true;
+	}
+
+	/* Compress a chunk now and then, to notice when the data compresses again. */
+	if (vol->incompressible_streak >= REDUCE_BYPASS_STREAK) {
+		return ++vol->bypass_count % REDUCE_BYPASS_PROBE_INTERVAL != 0;
+	}
+
+	return false;
+}
+
+/* Compress the chunk and write it, or write it uncompressed if it is not worth trying. */
+static void
+_write_compress_chunk(struct spdk_reduce_vol_request *req)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+
+	if (_reduce_vol_bypass_compression(req)) {
+		vol->stats.bypassed_chunks++;
+		_reduce_vol_count_chunk(vol, vol->backing_io_units_per_chunk);
+		_reduce_vol_write_chunk(req, _write_write_done, vol->params.chunk_size);
+		return;
+	}
+
+	_reduce_vol_compress_chunk(req, _write_compress_done);
+}
+
 static void
 _reduce_vol_decompress_chunk_scratch(struct spdk_reduce_vol_request *req, reduce_request_fn next_fn)
 {
@@ -1400,7 +2458,7 @@ _write_decompress_done(void *_req, int reduce_errno)
 	}
 
 	_prepare_compress_chunk(req, false);
-	_reduce_vol_compress_chunk(req, _write_compress_done);
+	_write_compress_chunk(req);
 }
 
 static void
@@ -1425,6 +2483,7 @@ _write_read_done(void *_req, int reduce_errno)
 	if (req->chunk_is_compressed) {
 		_reduce_vol_decompress_chunk_scratch(req, _write_decompress_done);
 	} else {
+		req->backing_cb_args.output_size = req->chunk->compressed_size;
 		_write_decompress_done(req, req->chunk->compressed_size);
 	}
 }
@@ -1434,6 +2493,7 @@ _read_decompress_done(void *_req, int reduce_errno)
 {
 	struct spdk_reduce_vol_request *req = _req;
 	struct spdk_reduce_vol *vol = req->vol;
+	struct spdk_reduce_write_buffer *wb;
 
 	/* Negative reduce_errno indicates failure for compression operations. */
 	if (reduce_errno < 0) {
@@ -1461,6 +2521,12 @@ _read_decompress_done(void *_req, int reduce_errno)
 		}
 	}
 
+	/* Blocks written to the write buffer are newer than the chunk on the backing device. */
+	wb = _reduce_vol_find_write_buffer(vol, req->logical_map_index);
+	if (wb != NULL) {
+		_reduce_write_buffer_copy_out(req, wb);
+	}
+
 	_reduce_vol_complete_req(req, 0);
 }
 
@@ -1500,6 +2566,7 @@ _read_read_done(void *_req, int reduce_errno)
 			buf += req->iov[i].iov_len;
 		}
 
+		req->backing_cb_args.output_size = req->chunk->compressed_size;
 		_read_decompress_done(req, req->chunk->compressed_size);
 	}
 }
@@ -1552,10 +2619,131 @@ _check_overlap(struct spdk_reduce_vol *vol, uint64_t logical_map_index)
 	return false;
 }
 
+/* A request spanning chunks, split in one request per chunk that all run concurrently */
+struct reduce_split_ctx {
+	spdk_reduce_vol_op_complete	cb_fn;
+	void				*cb_arg;
+	uint64_t			outstanding;
+	int				reduce_errno;
+	/* REDUCE_MAX_IOVECS iovecs for each chunk */
+	struct iovec			iov[];
+};
+
+static void
+_reduce_vol_split_cpl(void *cb_arg, int reduce_errno)
+{
+	struct reduce_split_ctx *ctx = cb_arg;
+
+	if (reduce_errno != 0 && ctx->reduce_errno == 0) {
+		ctx->reduce_errno = reduce_errno;
+	}
+
+	if (--ctx->outstanding == 0) {
+		ctx->cb_fn(ctx->cb_arg, ctx->reduce_errno);
+		free(ctx);
+	}
+}
+
+static void
+_reduce_vol_split_request(struct spdk_reduce_vol *vol, struct iovec *iov, int iovcnt,
+			  uint64_t offset, uint64_t length, bool read,
+			  spdk_reduce_vol_op_complete cb_fn, void *cb_arg)
+{
+	struct reduce_split_ctx *ctx;
+	struct iovec *chunk_iov;
+	uint64_t num_chunks, chunk_length, remaining, iov_offset = 0;
+	int chunk_iovcnt, i = 0;
+
+	num_chunks = (offset + length - 1) / vol->logical_blocks_per_chunk -
+		     offset / vol->logical_blocks_per_chunk + 1;
+	ctx = calloc(1, sizeof(*ctx) + num_chunks * REDUCE_MAX_IOVECS * sizeof(struct iovec));
+	if (ctx == NULL) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	/* Held until all the chunks are submitted, some may complete immediately */
+	ctx->outstanding = 1;
+
+	chunk_iov = ctx->iov;
+	while (length > 0) {
+		chunk_length = spdk_min(length, vol->logical_blocks_per_chunk -
+					offset % vol->logical_blocks_per_chunk);
+
+		/* The user iovecs covering this chunk, each chunk needs at most all of them */
+		remaining = chunk_length * vol->params.logical_block_size;
+		for (chunk_iovcnt = 0; remaining > 0; chunk_iovcnt++) {
+			assert(i < iovcnt && chunk_iovcnt < REDUCE_MAX_IOVECS);
+			chunk_iov[chunk_iovcnt].iov_base = (uint8_t *)iov[i].iov_base + iov_offset;
+			chunk_iov[chunk_iovcnt].iov_len = spdk_min(remaining,
+							   iov[i].iov_len - iov_offset);
+			remaining -= chunk_iov[chunk_iovcnt].iov_len;
+			iov_offset += chunk_iov[chunk_iovcnt].iov_len;
+			if (iov_offset == iov[i].iov_len) {
+				iov_offset = 0;
+				i++;
+			}
+		}
+
+		ctx->outstanding++;
+		if (read) {
+			spdk_reduce_vol_readv(vol, chunk_iov, chunk_iovcnt, offset, chunk_length,
+					      _reduce_vol_split_cpl, ctx);
+		} else {
+			spdk_reduce_vol_writev(vol, chunk_iov, chunk_iovcnt, offset, chunk_length,
+					       _reduce_vol_split_cpl, ctx);
+		}
+
+		chunk_iov += REDUCE_MAX_IOVECS;
+		offset += chunk_length;
+		length -= chunk_length;
+	}
+
+	_reduce_vol_split_cpl(ctx, 0);
+}
+
+/* Returns true if the read was completed from the write buffer. */
+static bool
+_reduce_vol_write_buffer_readv(struct spdk_reduce_vol_request *req)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+	struct spdk_reduce_write_buffer *wb;
+	uint64_t block, chunk_offset;
+	int i;
+
+	wb = _reduce_vol_find_write_buffer(vol, req->logical_map_index);
+	if (wb == NULL) {
+		return false;
+	}
+
+	if (vol->pm_logical_map[req->logical_map_index] != REDUCE_EMPTY_MAP_ENTRY) {
+		/* Read the chunk unless all the blocks are buffered, see _read_decompress_done */
+		chunk_offset = req->offset % vol->logical_blocks_per_chunk;
+		for (block = chunk_offset; block < chunk_offset + req->length; block++) {
+			if (!_reduce_write_buffer_block_is_valid(wb, block)) {
+				return false;
+			}
+		}
+	} else {
+		for (i = 0; i < req->iovcnt; i++) {
+			memset(req->iov[i].iov_base, 0, req->iov[i].iov_len);
+		}
+	}
+
+	_reduce_write_buffer_copy_out(req, wb);
+	_reduce_vol_complete_req(req, 0);
+	return true;
+}
+
 static void
 _start_readv_request(struct spdk_reduce_vol_request *req)
 {
 	TAILQ_INSERT_TAIL(&req->vol->executing_requests, req, tailq);
+	if (_reduce_vol_write_buffer_readv(req)) {
+		return;
+	}
+
 	_reduce_vol_read_chunk(req, _read_read_done);
 }
 
@@ -1574,20 +2762,21 @@ spdk_reduce_vol_readv(struct spdk_reduce_vol *vol,
 		return;
 	}
 
-	if (_request_spans_chunk_boundary(vol, offset, length)) {
+	if (!_iov_array_is_valid(vol, iov, iovcnt, length)) {
 		cb_fn(cb_arg, -EINVAL);
 		return;
 	}
 
-	if (!_iov_array_is_valid(vol, iov, iovcnt, length)) {
-		cb_fn(cb_arg, -EINVAL);
+	if (_request_spans_chunk_boundary(vol, offset, length)) {
+		_reduce_vol_split_request(vol, iov, iovcnt, offset, length, true, cb_fn, cb_arg);
 		return;
 	}
 
 	logical_map_index = offset / vol->logical_blocks_per_chunk;
 	overlapped = _check_overlap(vol, logical_map_index);
 
-	if (!overlapped && vol->pm_logical_map[logical_map_index] == REDUCE_EMPTY_MAP_ENTRY) {
+	if (!overlapped && vol->pm_logical_map[logical_map_index] == REDUCE_EMPTY_MAP_ENTRY &&
+	    _reduce_vol_find_write_buffer(vol, logical_map_index) == NULL) {
 		/*
 		 * This chunk hasn't been allocated.  So treat the data as all
 		 * zeroes for this chunk - do the memset and immediately complete
@@ -1615,6 +2804,7 @@ spdk_reduce_vol_readv(struct spdk_reduce_vol *vol,
 	req->logical_map_index = logical_map_index;
 	req->length = length;
 	req->copy_after_decompress = false;
+	req->write_buffer = NULL;
 	req->cb_fn = cb_fn;
 	req->cb_arg = cb_arg;
 
@@ -1625,12 +2815,270 @@ spdk_reduce_vol_readv(struct spdk_reduce_vol *vol,
 	}
 }
 
+static bool
+_reduce_write_buffer_is_complete(struct spdk_reduce_vol *vol, struct spdk_reduce_write_buffer *wb)
+{
+	uint64_t block;
+
+	for (block = 0; block < vol->logical_blocks_per_chunk; block++) {
+		if (!_reduce_write_buffer_block_is_valid(wb, block)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+_write_buffer_compress(struct spdk_reduce_vol_request *req)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+	uint32_t lbsize = vol->params.logical_block_size;
+	uint8_t *data = _reduce_write_buffer_data(vol, req->write_buffer);
+	uint64_t block;
+
+	/* Merge the buffered blocks over the old chunk, or zeroes if it was never written. */
+	for (block = 0; block < vol->logical_blocks_per_chunk; block++) {
+		if (_reduce_write_buffer_block_is_valid(req->write_buffer, block)) {
+			memcpy(req->decomp_buf + block * lbsize, data + block * lbsize, lbsize);
+		}
+	}
+
+	req->decomp_iov[0].iov_base = req->decomp_buf;
+	req->decomp_iov[0].iov_len = vol->params.chunk_size;
+	req->decomp_iovcnt = 1;
+	_write_compress_chunk(req);
+}
+
+static void
+_write_buffer_decompress_done(void *_req, int reduce_errno)
+{
+	struct spdk_reduce_vol_request *req = _req;
+
+	/* Negative reduce_errno indicates failure for compression operations. */
+	if (reduce_errno < 0) {
+		_reduce_vol_complete_req(req, reduce_errno);
+		return;
+	}
+
+	/* Positive reduce_errno indicates that the output size field in the backing_cb_args
+	 * represents the output_size.
+	 */
+	if (req->backing_cb_args.output_size != req->vol->params.chunk_size) {
+		_reduce_vol_complete_req(req, -EIO);
+		return;
+	}
+
+	_write_buffer_compress(req);
+}
+
+static void
+_write_buffer_read_done(void *_req, int reduce_errno)
+{
+	struct spdk_reduce_vol_request *req = _req;
+
+	if (reduce_errno != 0) {
+		req->reduce_errno = reduce_errno;
+	}
+
+	assert(req->num_backing_ops > 0);
+	if (--req->num_backing_ops > 0) {
+		return;
+	}
+
+	if (req->reduce_errno != 0) {
+		_reduce_vol_complete_req(req, req->reduce_errno);
+		return;
+	}
+
+	if (req->chunk_is_compressed) {
+		_reduce_vol_decompress_chunk_scratch(req, _write_buffer_decompress_done);
+	} else {
+		_write_buffer_compress(req);
+	}
+}
+
+static void
+_start_write_buffer_writeback(struct spdk_reduce_vol_request *req)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+
+	if (_reduce_write_buffer_is_complete(vol, req->write_buffer)) {
+		req->rmw = false;
+		_write_buffer_compress(req);
+		return;
+	}
+
+	if (vol->pm_logical_map[req->logical_map_index] != REDUCE_EMPTY_MAP_ENTRY) {
+		/* Read the old chunk for the blocks that were not written. */
+		req->rmw = true;
+		_reduce_vol_read_chunk(req, _write_buffer_read_done);
+		return;
+	}
+
+	req->rmw = false;
+	memset(req->decomp_buf, 0, vol->params.chunk_size);
+	_write_buffer_compress(req);
+}
+
+static void
+_write_buffer_writeback_done(void *cb_arg, int reduce_errno)
+{
+	struct spdk_reduce_vol_request *req = cb_arg;
+	struct spdk_reduce_vol *vol = req->vol;
+	struct spdk_reduce_write_buffer *wb = req->write_buffer;
+
+	if (reduce_errno == 0) {
+		/* The chunk is on the backing device now, so the entry can be reused. */
+		wb->logical_map_index = REDUCE_EMPTY_MAP_ENTRY;
+		_reduce_persist(vol, &wb->logical_map_index, sizeof(wb->logical_map_index));
+	} else {
+		/* Keep the entry, it is written back again when it is needed. */
+		SPDK_ERRLOG("failed to write back chunk %" PRIu64 ": %d\n",
+			    req->logical_map_index, reduce_errno);
+	}
+
+	spdk_bit_array_clear(vol->write_buffers_flushing,
+			     _reduce_vol_get_write_buffer_index(vol, wb));
+	req->write_buffer = NULL;
+}
+
+static void
+_reduce_vol_write_back(struct spdk_reduce_vol *vol, uint32_t index)
+{
+	struct spdk_reduce_write_buffer *wb = _reduce_vol_get_write_buffer(vol, index);
+	struct spdk_reduce_vol_request *req;
+
+	if (spdk_bit_array_get(vol->write_buffers_flushing, index)) {
+		return;
+	}
+
+	/* If no request is available, the entry stays buffered until it is needed again. */
+	req = TAILQ_FIRST(&vol->free_requests);
+	if (req == NULL) {
+		return;
+	}
+
+	spdk_bit_array_set(vol->write_buffers_flushing, index);
+
+	TAILQ_REMOVE(&vol->free_requests, req, tailq);
+	req->type = REDUCE_IO_WRITEV;
+	req->vol = vol;
+	req->write_buffer_iov.iov_base = req->decomp_buf;
+	req->write_buffer_iov.iov_len = vol->params.chunk_size;
+	req->iov = &req->write_buffer_iov;
+	req->iovcnt = 1;
+	req->offset = wb->logical_map_index * vol->logical_blocks_per_chunk;
+	req->logical_map_index = wb->logical_map_index;
+	req->length = vol->logical_blocks_per_chunk;
+	req->copy_after_decompress = false;
+	req->write_buffer = wb;
+	req->cb_fn = _write_buffer_writeback_done;
+	req->cb_arg = req;
+
+	if (!_check_overlap(vol, req->logical_map_index)) {
+		_start_writev_request(req);
+	} else {
+		TAILQ_INSERT_TAIL(&vol->queued_requests, req, tailq);
+	}
+}
+
+static struct spdk_reduce_write_buffer *
+_reduce_vol_get_free_write_buffer(struct spdk_reduce_vol *vol)
+{
+	return _reduce_vol_find_write_buffer(vol, REDUCE_EMPTY_MAP_ENTRY);
+}
+
+static void
+_reduce_vol_evict_write_buffer(struct spdk_reduce_vol *vol)
+{
+	uint32_t i, index;
+
+	for (i = 0; i < vol->params.write_buffer_chunks; i++) {
+		index = vol->write_buffer_evict_index;
+		vol->write_buffer_evict_index = (index + 1) % vol->params.write_buffer_chunks;
+		if (!spdk_bit_array_get(vol->write_buffers_flushing, index)) {
+			_reduce_vol_write_back(vol, index);
+			return;
+		}
+	}
+}
+
+/* Returns true if the write was completed in the write buffer. */
+static bool
+_reduce_vol_write_buffer_writev(struct spdk_reduce_vol_request *req)
+{
+	struct spdk_reduce_vol *vol = req->vol;
+	struct spdk_reduce_write_buffer *wb;
+	uint32_t lbsize = vol->params.logical_block_size;
+	uint64_t block, chunk_offset;
+	bool new_entry = false;
+	uint8_t *data;
+
+	if (vol->params.write_buffer_chunks == 0) {
+		return false;
+	}
+
+	wb = _reduce_vol_find_write_buffer(vol, req->logical_map_index);
+	if (wb == NULL) {
+		/* A full chunk has nothing to merge, compress it right away. */
+		if (req->length == vol->logical_blocks_per_chunk) {
+			return false;
+		}
+
+		wb = _reduce_vol_get_free_write_buffer(vol);
+		if (wb == NULL) {
+			/* The write back may complete inline and free an entry. */
+			_reduce_vol_evict_write_buffer(vol);
+			wb = _reduce_vol_get_free_write_buffer(vol);
+			if (wb == NULL) {
+				return false;
+			}
+		}
+
+		memset(wb->valid_blocks, 0, vol->write_buffer_header_size - sizeof(*wb));
+		new_entry = true;
+	}
+
+	/* Persist the data before the valid bits, and these before the entry becomes used. */
+	chunk_offset = req->offset % vol->logical_blocks_per_chunk;
+	data = _reduce_write_buffer_data(vol, wb) + chunk_offset * lbsize;
+	spdk_copy_iovs_to_buf(data, req->length * lbsize, req->iov, req->iovcnt);
+	_reduce_persist(vol, data, req->length * lbsize);
+
+	for (block = chunk_offset; block < chunk_offset + req->length; block++) {
+		wb->valid_blocks[block / 64] |= 1ULL << (block % 64);
+	}
+	_reduce_persist(vol, wb->valid_blocks, vol->write_buffer_header_size - sizeof(*wb));
+
+	if (new_entry) {
+		wb->logical_map_index = req->logical_map_index;
+		_reduce_persist(vol, &wb->logical_map_index, sizeof(wb->logical_map_index));
+	}
+
+	if (_reduce_write_buffer_is_complete(vol, wb)) {
+		_reduce_vol_write_back(vol, _reduce_vol_get_write_buffer_index(vol, wb));
+	}
+
+	_reduce_vol_complete_req(req, 0);
+	return true;
+}
+
 static void
 _start_writev_request(struct spdk_reduce_vol_request *req)
 {
 	struct spdk_reduce_vol *vol = req->vol;
 
 	TAILQ_INSERT_TAIL(&req->vol->executing_requests, req, tailq);
+	if (req->write_buffer != NULL) {
+		_start_write_buffer_writeback(req);
+		return;
+	}
+
+	if (_reduce_vol_write_buffer_writev(req)) {
+		return;
+	}
+
 	if (vol->pm_logical_map[req->logical_map_index] != REDUCE_EMPTY_MAP_ENTRY) {
 		if ((req->length * vol->params.logical_block_size) < vol->params.chunk_size) {
 			/* Read old chunk, then overwrite with data from this write
@@ -1645,7 +3093,7 @@ _start_writev_request(struct spdk_reduce_vol_request *req)
 	req->rmw = false;
 
 	_prepare_compress_chunk(req, true);
-	_reduce_vol_compress_chunk(req, _write_compress_done);
+	_write_compress_chunk(req);
 }
 
 void
@@ -1662,13 +3110,13 @@ spdk_reduce_vol_writev(struct spdk_reduce_vol *vol,
 		return;
 	}
 
-	if (_request_spans_chunk_boundary(vol, offset, length)) {
+	if (!_iov_array_is_valid(vol, iov, iovcnt, length)) {
 		cb_fn(cb_arg, -EINVAL);
 		return;
 	}
 
-	if (!_iov_array_is_valid(vol, iov, iovcnt, length)) {
-		cb_fn(cb_arg, -EINVAL);
+	if (_request_spans_chunk_boundary(vol, offset, length)) {
+		_reduce_vol_split_request(vol, iov, iovcnt, offset, length, false, cb_fn, cb_arg);
 		return;
 	}
 
@@ -1690,6 +3138,7 @@ spdk_reduce_vol_writev(struct spdk_reduce_vol *vol,
 	req->logical_map_index = logical_map_index;
 	req->length = length;
 	req->copy_after_decompress = false;
+	req->write_buffer = NULL;
 	req->cb_fn = cb_fn;
 	req->cb_arg = cb_arg;
 
@@ -1706,6 +3155,12 @@ spdk_reduce_vol_get_params(struct spdk_reduce_vol *vol)
 	return &vol->params;
 }
 
+void
+spdk_reduce_vol_get_stats(struct spdk_reduce_vol *vol, struct spdk_reduce_vol_stats *stats)
+{
+	memcpy(stats, &vol->stats, sizeof(*stats));
+}
+
 void
 spdk_reduce_vol_print_info(struct spdk_reduce_vol *vol)
 {
@@ -1718,6 +3173,7 @@ spdk_reduce_vol_print_info(struct spdk_reduce_vol *vol)
 	SPDK_NOTICELOG("\tvol->params.logical_block_size = 0x%x\n", vol->params.logical_block_size);
 	SPDK_NOTICELOG("\tvol->params.chunk_size = 0x%x\n", vol->params.chunk_size);
 	SPDK_NOTICELOG("\tvol->params.vol_size = 0x%" PRIx64 "\n", vol->params.vol_size);
+	SPDK_NOTICELOG("\tvol->params.write_buffer_chunks = %u\n", vol->params.write_buffer_chunks);
 	num_chunks = _get_total_chunks(vol->params.vol_size, vol->params.chunk_size);
 	SPDK_NOTICELOG("\ttotal chunks (including extra) = 0x%" PRIx64 "\n", num_chunks);
 	SPDK_NOTICELOG("\ttotal chunks (excluding extra) = 0x%" PRIx64 "\n",
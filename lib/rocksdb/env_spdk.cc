@@ -172,6 +172,7 @@ public:
 	virtual ~SpdkRandomAccessFile();
 
 	virtual Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override;
+	virtual Status MultiRead(ReadRequest *reqs, size_t num_reqs) override;
 	virtual Status InvalidateCache(size_t offset, size_t length) override;
 };
 
@@ -197,6 +198,33 @@ SpdkRandomAccessFile::Read(uint64_t offset, size_t n, Slice *result, char *scrat
 	}
 }
 
+Status
+SpdkRandomAccessFile::MultiRead(ReadRequest *reqs, size_t num_reqs)
+{
+	std::vector<struct spdk_file_read_req> file_reqs(num_reqs);
+
+	for (size_t i = 0; i < num_reqs; i++) {
+		file_reqs[i].payload = reqs[i].scratch;
+		file_reqs[i].offset = reqs[i].offset;
+		file_reqs[i].length = reqs[i].len;
+	}
+
+	set_channel();
+	spdk_file_read_batch(mFile, g_sync_args.channel, file_reqs.data(), num_reqs);
+
+	for (size_t i = 0; i < num_reqs; i++) {
+		if (file_reqs[i].rc >= 0) {
+			reqs[i].result = Slice(reqs[i].scratch, file_reqs[i].rc);
+			reqs[i].status = Status::OK();
+		} else {
+			reqs[i].status = Status::IOError(spdk_file_get_name(mFile),
+							 strerror(-file_reqs[i].rc));
+		}
+	}
+
+	return Status::OK();
+}
+
 Status
 SpdkRandomAccessFile::InvalidateCache(__attribute__((unused)) size_t offset,
 				      __attribute__((unused)) size_t length)
@@ -24,6 +24,7 @@ static struct spdk_jsonrpc_server *g_jsonrpc_server = NULL;
 static uint32_t g_rpc_state;
 static bool g_rpcs_correct = true;
 static char **g_rpcs_allowlist = NULL;
+static spdk_rpc_dispatch_fn g_rpc_dispatch_fn = NULL;
 
 struct spdk_rpc_method {
 	const char *name;
@@ -141,6 +142,37 @@ jsonrpc_handler(struct spdk_jsonrpc_request *request,
 	}
 }
 
+static void
+jsonrpc_dispatch(struct spdk_jsonrpc_request *request,
+		 const struct spdk_json_val *method,
+		 const struct spdk_json_val *params)
+{
+	if (g_rpc_dispatch_fn != NULL) {
+		g_rpc_dispatch_fn(jsonrpc_handler, request, method, params);
+	} else {
+		jsonrpc_handler(request, method, params);
+	}
+}
+
+void
+spdk_rpc_set_dispatch_fn(spdk_rpc_dispatch_fn dispatch_fn)
+{
+	g_rpc_dispatch_fn = dispatch_fn;
+}
+
+int
+spdk_rpc_call(const char *method, const struct spdk_json_val *params,
+	      spdk_jsonrpc_local_response_fn cb_fn, void *cb_arg)
+{
+	struct spdk_json_val method_val = {
+		.start = (void *)method,
+		.len = strlen(method),
+		.type = SPDK_JSON_VAL_STRING,
+	};
+
+	return spdk_jsonrpc_handle_local_request(jsonrpc_handler, &method_val, params, cb_fn, cb_arg);
+}
+
 int
 spdk_rpc_listen(const char *listen_addr)
 {
@@ -194,7 +226,7 @@ spdk_rpc_listen(const char *listen_addr)
 	g_jsonrpc_server = spdk_jsonrpc_server_listen(AF_UNIX, 0,
 			   (struct sockaddr *)&g_rpc_listen_addr_unix,
 			   sizeof(g_rpc_listen_addr_unix),
-			   jsonrpc_handler);
+			   jsonrpc_dispatch);
 	if (g_jsonrpc_server == NULL) {
 		SPDK_ERRLOG("spdk_jsonrpc_server_listen() failed\n");
 		close(g_rpc_lock_fd);
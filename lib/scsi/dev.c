@@ -166,6 +166,7 @@ spdk_scsi_dev_add_lun_ext(struct spdk_scsi_dev *dev, const char *bdev_name, int
 	}
 
 	lun->dev = dev;
+	lun->max_tasks_per_initiator = dev->max_tasks_per_initiator;
 
 	if (lun_id != -1) {
 		lun->id = lun_id;
@@ -470,6 +471,18 @@ spdk_scsi_dev_get_next_lun(struct spdk_scsi_lun *prev_lun)
 	return lun;
 }
 
+void
+spdk_scsi_dev_set_max_tasks_per_initiator(struct spdk_scsi_dev *dev, uint32_t max_tasks)
+{
+	struct spdk_scsi_lun *lun;
+
+	dev->max_tasks_per_initiator = max_tasks;
+
+	TAILQ_FOREACH(lun, &dev->luns, tailq) {
+		lun->max_tasks_per_initiator = max_tasks;
+	}
+}
+
 bool
 spdk_scsi_dev_has_pending_tasks(const struct spdk_scsi_dev *dev,
 				const struct spdk_scsi_port *initiator_port)
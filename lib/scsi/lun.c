@@ -13,15 +13,23 @@
 
 static void scsi_lun_execute_tasks(struct spdk_scsi_lun *lun);
 static void _scsi_lun_execute_mgmt_task(struct spdk_scsi_lun *lun);
+static void scsi_lun_initiator_complete_task(struct spdk_scsi_lun *lun,
+		const struct spdk_scsi_port *initiator_port);
 
 void
 scsi_lun_complete_task(struct spdk_scsi_lun *lun, struct spdk_scsi_task *task)
 {
+	const struct spdk_scsi_port *initiator_port = task->initiator_port;
+
 	if (lun) {
 		TAILQ_REMOVE(&lun->tasks, task, scsi_link);
 		spdk_trace_record(TRACE_SCSI_TASK_DONE, lun->dev->id, 0, (uintptr_t)task);
 	}
 	task->cpl_fn(task);
+
+	if (lun && spdk_unlikely(!TAILQ_EMPTY(&lun->initiators))) {
+		scsi_lun_initiator_complete_task(lun, initiator_port);
+	}
 }
 
 static void
@@ -222,6 +230,126 @@ _scsi_lun_execute_task(struct spdk_scsi_lun *lun, struct spdk_scsi_task *task)
 	}
 }
 
+static struct spdk_scsi_lun_initiator *
+scsi_lun_find_initiator(const struct spdk_scsi_lun *lun,
+			const struct spdk_scsi_port *initiator_port)
+{
+	struct spdk_scsi_lun_initiator *initiator;
+
+	TAILQ_FOREACH(initiator, &lun->initiators, link) {
+		if (initiator->initiator_port == initiator_port) {
+			return initiator;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+scsi_lun_initiator_dispatch(struct spdk_scsi_lun *lun, struct spdk_scsi_lun_initiator *initiator)
+{
+	struct spdk_scsi_task *task;
+
+	/* Tasks which complete inline come back here through
+	 * scsi_lun_complete_task(). The loop below takes the slots they release.
+	 */
+	if (initiator->dispatching) {
+		return;
+	}
+
+	initiator->dispatching = true;
+	while ((task = TAILQ_FIRST(&initiator->queued_tasks)) != NULL) {
+		/* Once the LUN is removed, queued tasks are aborted without limit. */
+		if (lun->max_tasks_per_initiator != 0 && !lun->removed &&
+		    initiator->outstanding >= lun->max_tasks_per_initiator) {
+			break;
+		}
+
+		TAILQ_REMOVE(&initiator->queued_tasks, task, scsi_link);
+		initiator->outstanding++;
+		_scsi_lun_execute_task(lun, task);
+	}
+	initiator->dispatching = false;
+}
+
+static void
+scsi_lun_initiator_complete_task(struct spdk_scsi_lun *lun,
+				 const struct spdk_scsi_port *initiator_port)
+{
+	struct spdk_scsi_lun_initiator *initiator;
+
+	initiator = scsi_lun_find_initiator(lun, initiator_port);
+	if (initiator == NULL) {
+		return;
+	}
+
+	/* Tasks submitted before the limit was set were not counted. */
+	if (initiator->outstanding > 0) {
+		initiator->outstanding--;
+	}
+
+	scsi_lun_initiator_dispatch(lun, initiator);
+}
+
+static void
+scsi_lun_free_initiators(struct spdk_scsi_lun *lun)
+{
+	struct spdk_scsi_lun_initiator *initiator, *tmp;
+
+	TAILQ_FOREACH_SAFE(initiator, &lun->initiators, link, tmp) {
+		assert(TAILQ_EMPTY(&initiator->queued_tasks));
+		TAILQ_REMOVE(&lun->initiators, initiator, link);
+		free(initiator);
+	}
+}
+
+/* Submit the task to the bdev, or queue it behind the other tasks of its
+ * initiator if the initiator already has as many tasks outstanding as allowed.
+ */
+static void
+scsi_lun_submit_task(struct spdk_scsi_lun *lun, struct spdk_scsi_task *task)
+{
+	struct spdk_scsi_lun_initiator *initiator;
+
+	if (spdk_likely(lun->max_tasks_per_initiator == 0 && TAILQ_EMPTY(&lun->initiators))) {
+		_scsi_lun_execute_task(lun, task);
+		return;
+	}
+
+	initiator = scsi_lun_find_initiator(lun, task->initiator_port);
+	if (initiator == NULL) {
+		initiator = calloc(1, sizeof(*initiator));
+		if (spdk_unlikely(initiator == NULL)) {
+			/* Rather submit it unaccounted than fail it. */
+			_scsi_lun_execute_task(lun, task);
+			return;
+		}
+
+		initiator->initiator_port = task->initiator_port;
+		TAILQ_INIT(&initiator->queued_tasks);
+		TAILQ_INSERT_TAIL(&lun->initiators, initiator, link);
+	}
+
+	TAILQ_INSERT_TAIL(&initiator->queued_tasks, task, scsi_link);
+	scsi_lun_initiator_dispatch(lun, initiator);
+}
+
+static bool
+scsi_lun_has_queued_tasks(const struct spdk_scsi_lun *lun,
+			  const struct spdk_scsi_port *initiator_port)
+{
+	struct spdk_scsi_lun_initiator *initiator;
+
+	TAILQ_FOREACH(initiator, &lun->initiators, link) {
+		if ((initiator_port == NULL || initiator->initiator_port == initiator_port) &&
+		    !TAILQ_EMPTY(&initiator->queued_tasks)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 static void
 scsi_lun_append_task(struct spdk_scsi_lun *lun, struct spdk_scsi_task *task)
 {
@@ -235,7 +363,7 @@ scsi_lun_execute_tasks(struct spdk_scsi_lun *lun)
 
 	TAILQ_FOREACH_SAFE(task, &lun->pending_tasks, scsi_link, task_tmp) {
 		TAILQ_REMOVE(&lun->pending_tasks, task, scsi_link);
-		_scsi_lun_execute_task(lun, task);
+		scsi_lun_submit_task(lun, task);
 	}
 }
 
@@ -256,7 +384,7 @@ scsi_lun_execute_task(struct spdk_scsi_lun *lun, struct spdk_scsi_task *task)
 		scsi_lun_execute_tasks(lun);
 	} else {
 		/* Execute the IO task directly. */
-		_scsi_lun_execute_task(lun, task);
+		scsi_lun_submit_task(lun, task);
 	}
 }
 
@@ -265,6 +393,7 @@ _scsi_lun_remove(void *arg)
 {
 	struct spdk_scsi_lun *lun = (struct spdk_scsi_lun *)arg;
 
+	scsi_pr_store_detach(lun);
 	spdk_bdev_close(lun->bdev_desc);
 	spdk_scsi_dev_delete_lun(lun->dev, lun);
 	free(lun);
@@ -280,6 +409,8 @@ scsi_lun_remove(struct spdk_scsi_lun *lun)
 		free(reg);
 	}
 
+	scsi_lun_free_initiators(lun);
+
 	spdk_thread_exec_msg(lun->thread, _scsi_lun_remove, lun);
 }
 
@@ -341,11 +472,15 @@ static void
 _scsi_lun_hot_remove(void *arg1)
 {
 	struct spdk_scsi_lun *lun = arg1;
+	struct spdk_scsi_lun_initiator *initiator;
 
 	/* If lun->removed is set, no new task can be submitted to the LUN.
 	 * Execute previously queued tasks, which will be immediately aborted.
 	 */
 	scsi_lun_execute_tasks(lun);
+	TAILQ_FOREACH(initiator, &lun->initiators, link) {
+		scsi_lun_initiator_dispatch(lun, initiator);
+	}
 
 	/* Then we only need to wait for all outstanding tasks to be completed
 	 * before notifying the upper layer about the removal.
@@ -461,6 +596,7 @@ struct spdk_scsi_lun *scsi_lun_construct(const char *bdev_name,
 
 	TAILQ_INIT(&lun->open_descs);
 	TAILQ_INIT(&lun->reg_head);
+	TAILQ_INIT(&lun->initiators);
 
 	return lun;
 }
@@ -610,6 +746,10 @@ scsi_lun_has_pending_tasks(const struct spdk_scsi_lun *lun,
 {
 	struct spdk_scsi_task *task;
 
+	if (scsi_lun_has_queued_tasks(lun, initiator_port)) {
+		return true;
+	}
+
 	if (initiator_port == NULL) {
 		return _scsi_lun_has_pending_tasks(lun) ||
 		       scsi_lun_has_outstanding_tasks(lun);
@@ -57,6 +57,24 @@ struct spdk_scsi_pr_reservation {
 	uint64_t				crkey;
 };
 
+#define SCSI_PR_CHECK_CACHE_SIZE		8
+
+#define SCSI_PR_ACCESS_VALID			0x1
+#define SCSI_PR_ACCESS_READ			0x2
+#define SCSI_PR_ACCESS_WRITE			0x4
+
+/* Result of a reservation check for an I_T nexus, valid while gen matches
+ * spdk_scsi_lun.pr_state_gen.
+ */
+struct spdk_scsi_pr_check_entry {
+	const struct spdk_scsi_port		*initiator_port;
+	const struct spdk_scsi_port		*target_port;
+	uint32_t				gen;
+	uint32_t				access;
+};
+
+struct scsi_pr_store;
+
 struct spdk_scsi_dev {
 	int					id;
 	int					is_allocated;
@@ -72,6 +90,20 @@ struct spdk_scsi_dev {
 	struct spdk_scsi_port			port[SPDK_SCSI_DEV_MAX_PORTS];
 
 	uint8_t					protocol_id;
+
+	/* Applied to all the LUNs of the device. See spdk_scsi_lun.max_tasks_per_initiator. */
+	uint32_t				max_tasks_per_initiator;
+};
+
+/* Tasks of an I_T nexus on a LUN, when the LUN bounds the number of tasks
+ * each initiator may have outstanding.
+ */
+struct spdk_scsi_lun_initiator {
+	const struct spdk_scsi_port		*initiator_port;
+	uint32_t				outstanding;
+	bool					dispatching;
+	TAILQ_HEAD(, spdk_scsi_task)		queued_tasks;
+	TAILQ_ENTRY(spdk_scsi_lun_initiator)	link;
 };
 
 struct spdk_scsi_lun_desc {
@@ -129,6 +161,15 @@ struct spdk_scsi_lun {
 	struct spdk_scsi_pr_reservation reservation;
 	/** Reservation holder for SPC2 RESERVE(6) and RESERVE(10) */
 	struct spdk_scsi_pr_registrant scsi2_holder;
+	/**
+	 * Bumped on every change of the registrants or the reservation, to invalidate
+	 * pr_check_cache. Unlike pr_generation it is never reported to initiators.
+	 */
+	uint32_t pr_state_gen;
+	/** Access allowed to recently checked I_T nexuses under the current reservation */
+	struct spdk_scsi_pr_check_entry pr_check_cache[SCSI_PR_CHECK_CACHE_SIZE];
+	/** Store the reservation state is written to, if any */
+	struct scsi_pr_store *pr_store;
 
 	/** List of open descriptors for this LUN. */
 	TAILQ_HEAD(, spdk_scsi_lun_desc) open_descs;
@@ -153,6 +194,16 @@ struct spdk_scsi_lun {
 
 	/** The LUN is resizing */
 	bool resizing;
+
+	/**
+	 * Maximum number of tasks each initiator may have submitted to the bdev, 0 for
+	 * no limit. Tasks beyond it wait in a queue of their initiator, so that one
+	 * initiator can't take the whole queue of the bdev from the others.
+	 */
+	uint32_t max_tasks_per_initiator;
+
+	/** Per initiator task queues, created once max_tasks_per_initiator is set */
+	TAILQ_HEAD(, spdk_scsi_lun_initiator) initiators;
 };
 
 struct spdk_scsi_lun *scsi_lun_construct(const char *bdev_name,
@@ -189,6 +240,13 @@ int scsi_pr_out(struct spdk_scsi_task *task, uint8_t *cdb, uint8_t *data, uint16
 int scsi_pr_in(struct spdk_scsi_task *task, uint8_t *cdb, uint8_t *data, uint16_t data_len);
 int scsi_pr_check(struct spdk_scsi_task *task);
 
+typedef void (*scsi_pr_store_cb)(void *cb_arg, int rc);
+
+int scsi_pr_store_attach(struct spdk_scsi_lun *lun, const char *bdev_name,
+			 scsi_pr_store_cb cb_fn, void *cb_arg);
+void scsi_pr_store_detach(struct spdk_scsi_lun *lun);
+void scsi_pr_store_persist(struct spdk_scsi_lun *lun);
+
 int scsi2_reserve(struct spdk_scsi_task *task, uint8_t *cdb);
 int scsi2_release(struct spdk_scsi_task *task);
 int scsi2_reserve_check(struct spdk_scsi_task *task);
@@ -6,6 +6,7 @@
 #include "scsi_internal.h"
 
 #include "spdk/endian.h"
+#include "spdk/likely.h"
 
 /* Get registrant by I_T nexus */
 static struct spdk_scsi_pr_registrant *
@@ -22,6 +23,23 @@ scsi_pr_get_registrant(struct spdk_scsi_lun *lun,
 		}
 	}
 
+	if (initiator_port == NULL || target_port == NULL) {
+		return NULL;
+	}
+
+	/* Registrants loaded from a reservation store aren't bound to any port until
+	 * their I_T nexus logs in again, so match them by port names.
+	 */
+	TAILQ_FOREACH(reg, &lun->reg_head, link) {
+		if (reg->initiator_port == NULL && reg->target_port == NULL &&
+		    strcmp(reg->initiator_port_name, initiator_port->name) == 0 &&
+		    strcmp(reg->target_port_name, target_port->name) == 0) {
+			reg->initiator_port = initiator_port;
+			reg->target_port = target_port;
+			return reg;
+		}
+	}
+
 	return NULL;
 }
 
@@ -69,6 +87,13 @@ scsi_pr_has_reservation(struct spdk_scsi_lun *lun)
 	return !(lun->reservation.holder == NULL);
 }
 
+/* Registrants or reservation changed, cached checks are stale */
+static inline void
+scsi_pr_state_changed(struct spdk_scsi_lun *lun)
+{
+	lun->pr_state_gen++;
+}
+
 static int
 scsi_pr_register_registrant(struct spdk_scsi_lun *lun,
 			    struct spdk_scsi_port *initiator_port,
@@ -103,6 +128,7 @@ scsi_pr_register_registrant(struct spdk_scsi_lun *lun,
 	reg->rkey = sa_rkey;
 	TAILQ_INSERT_TAIL(&lun->reg_head, reg, link);
 	lun->pr_generation++;
+	scsi_pr_state_changed(lun);
 
 	return 0;
 }
@@ -116,6 +142,7 @@ scsi_pr_release_reservation(struct spdk_scsi_lun *lun, struct spdk_scsi_pr_regis
 		      "with type %u\n", lun->reservation.rtype);
 
 	/* TODO: Unit Attention */
+	scsi_pr_state_changed(lun);
 	all_regs = scsi_pr_is_all_registrants_type(lun);
 	if (all_regs && !TAILQ_EMPTY(&lun->reg_head)) {
 		lun->reservation.holder = TAILQ_FIRST(&lun->reg_head);
@@ -134,6 +161,7 @@ scsi_pr_reserve_reservation(struct spdk_scsi_lun *lun,
 	lun->reservation.rtype = type;
 	lun->reservation.crkey = rkey;
 	lun->reservation.holder = holder;
+	scsi_pr_state_changed(lun);
 }
 
 static void
@@ -149,6 +177,7 @@ scsi_pr_unregister_registrant(struct spdk_scsi_lun *lun,
 
 	free(reg);
 	lun->pr_generation++;
+	scsi_pr_state_changed(lun);
 }
 
 static void
@@ -160,6 +189,7 @@ scsi_pr_replace_registrant_key(struct spdk_scsi_lun *lun,
 		      "reservation key 0x%"PRIx64"\n", sa_rkey);
 	reg->rkey = sa_rkey;
 	lun->pr_generation++;
+	scsi_pr_state_changed(lun);
 }
 
 static int
@@ -506,6 +536,7 @@ scsi_pr_out(struct spdk_scsi_task *task, uint8_t *cdb,
 	enum spdk_scsi_pr_scope_code scope;
 	enum spdk_scsi_pr_type_code rtype;
 	struct spdk_scsi_pr_out_param_list *param = (struct spdk_scsi_pr_out_param_list *)data;
+	uint32_t state_gen = task->lun->pr_state_gen;
 
 	action = cdb[1] & 0x0f;
 	scope = (cdb[2] >> 4) & 0x0f;
@@ -550,6 +581,13 @@ scsi_pr_out(struct spdk_scsi_task *task, uint8_t *cdb,
 		goto invalid;
 	}
 
+	/* The command completes without waiting for the store, which is written
+	 * in the background.
+	 */
+	if (task->lun->pr_state_gen != state_gen) {
+		scsi_pr_store_persist(task->lun);
+	}
+
 	return rc;
 
 invalid:
@@ -730,6 +768,58 @@ invalid:
 	return -EINVAL;
 }
 
+/* Access allowed to a registrant, or to an unregistered I_T nexus if reg is NULL */
+static uint32_t
+scsi_pr_get_access(struct spdk_scsi_lun *lun, struct spdk_scsi_pr_registrant *reg)
+{
+	if (scsi_pr_registrant_is_holder(lun, reg)) {
+		return SCSI_PR_ACCESS_READ | SCSI_PR_ACCESS_WRITE;
+	}
+
+	switch (lun->reservation.rtype) {
+	case SPDK_SCSI_PR_WRITE_EXCLUSIVE:
+		return SCSI_PR_ACCESS_READ;
+	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS:
+		return 0;
+	case SPDK_SCSI_PR_WRITE_EXCLUSIVE_REGS_ONLY:
+	case SPDK_SCSI_PR_WRITE_EXCLUSIVE_ALL_REGS:
+		return reg ? SCSI_PR_ACCESS_READ | SCSI_PR_ACCESS_WRITE : SCSI_PR_ACCESS_READ;
+	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS_REGS_ONLY:
+	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS_ALL_REGS:
+		return reg ? SCSI_PR_ACCESS_READ | SCSI_PR_ACCESS_WRITE : 0;
+	default:
+		return SCSI_PR_ACCESS_READ | SCSI_PR_ACCESS_WRITE;
+	}
+}
+
+/* Reads and writes look up the access of their I_T nexus in a small cache
+ * instead of walking the registrants. The LUN runs all its tasks on a single
+ * thread, so the cache needs no locking, and any change of the reservation
+ * state invalidates it as a whole by bumping pr_state_gen.
+ */
+static uint32_t
+scsi_pr_check_access(struct spdk_scsi_lun *lun, struct spdk_scsi_task *task)
+{
+	struct spdk_scsi_pr_check_entry *entry;
+	struct spdk_scsi_pr_registrant *reg;
+
+	entry = &lun->pr_check_cache[((uintptr_t)task->initiator_port / sizeof(struct spdk_scsi_port)) %
+				     SCSI_PR_CHECK_CACHE_SIZE];
+	if (spdk_likely(entry->access != 0 && entry->gen == lun->pr_state_gen &&
+			entry->initiator_port == task->initiator_port &&
+			entry->target_port == task->target_port)) {
+		return entry->access;
+	}
+
+	reg = scsi_pr_get_registrant(lun, task->initiator_port, task->target_port);
+	entry->initiator_port = task->initiator_port;
+	entry->target_port = task->target_port;
+	entry->gen = lun->pr_state_gen;
+	entry->access = SCSI_PR_ACCESS_VALID | scsi_pr_get_access(lun, reg);
+
+	return entry->access;
+}
+
 int
 scsi_pr_check(struct spdk_scsi_task *task)
 {
@@ -738,7 +828,7 @@ scsi_pr_check(struct spdk_scsi_task *task)
 	enum spdk_scsi_pr_type_code rtype;
 	enum spdk_scsi_pr_out_service_action_code action;
 	struct spdk_scsi_pr_registrant *reg;
-	bool dma_to_device = false;
+	uint32_t access;
 
 	/* no reservation holders */
 	if (!scsi_pr_has_reservation(lun)) {
@@ -748,6 +838,37 @@ scsi_pr_check(struct spdk_scsi_task *task)
 	rtype = lun->reservation.rtype;
 	assert(rtype != 0);
 
+	/* For most SBC R/W commands */
+	switch (cdb[0]) {
+	case SPDK_SBC_READ_6:
+	case SPDK_SBC_READ_10:
+	case SPDK_SBC_READ_12:
+	case SPDK_SBC_READ_16:
+		access = SCSI_PR_ACCESS_READ;
+		break;
+	case SPDK_SBC_WRITE_6:
+	case SPDK_SBC_WRITE_10:
+	case SPDK_SBC_WRITE_12:
+	case SPDK_SBC_WRITE_16:
+	case SPDK_SBC_UNMAP:
+	case SPDK_SBC_SYNCHRONIZE_CACHE_10:
+	case SPDK_SBC_SYNCHRONIZE_CACHE_16:
+		access = SCSI_PR_ACCESS_WRITE;
+		break;
+	default:
+		access = 0;
+		break;
+	}
+
+	if (access != 0) {
+		if (spdk_likely(scsi_pr_check_access(lun, task) & access)) {
+			return 0;
+		}
+		SPDK_ERRLOG("CHECK: reservation type %u rejects command 0x%x\n",
+			    rtype, cdb[0]);
+		goto conflict;
+	}
+
 	reg = scsi_pr_get_registrant(lun, task->initiator_port, task->target_port);
 	/* current I_T nexus hold the reservation */
 	if (scsi_pr_registrant_is_holder(lun, reg)) {
@@ -807,66 +928,11 @@ scsi_pr_check(struct spdk_scsi_task *task)
 			SPDK_ERRLOG("CHECK: PR OUT invalid action %u\n", action);
 			goto conflict;
 		}
-
-	/* For most SBC R/W commands */
-	default:
-		break;
-	}
-
-	switch (cdb[0]) {
-	case SPDK_SBC_READ_6:
-	case SPDK_SBC_READ_10:
-	case SPDK_SBC_READ_12:
-	case SPDK_SBC_READ_16:
-		break;
-	case SPDK_SBC_WRITE_6:
-	case SPDK_SBC_WRITE_10:
-	case SPDK_SBC_WRITE_12:
-	case SPDK_SBC_WRITE_16:
-	case SPDK_SBC_UNMAP:
-	case SPDK_SBC_SYNCHRONIZE_CACHE_10:
-	case SPDK_SBC_SYNCHRONIZE_CACHE_16:
-		dma_to_device = true;
-		break;
 	default:
 		SPDK_ERRLOG("CHECK: unsupported SCSI command cdb 0x%x\n", cdb[0]);
 		goto conflict;
 	}
 
-	switch (rtype) {
-	case SPDK_SCSI_PR_WRITE_EXCLUSIVE:
-		if (dma_to_device) {
-			SPDK_ERRLOG("CHECK: Write Exclusive reservation type "
-				    "rejects command 0x%x\n", cdb[0]);
-			goto conflict;
-		}
-		break;
-	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS:
-		SPDK_ERRLOG("CHECK: Exclusive Access reservation type "
-			    "rejects command 0x%x\n", cdb[0]);
-		goto conflict;
-	case SPDK_SCSI_PR_WRITE_EXCLUSIVE_REGS_ONLY:
-	case SPDK_SCSI_PR_WRITE_EXCLUSIVE_ALL_REGS:
-		if (!reg && dma_to_device) {
-			SPDK_ERRLOG("CHECK: Registrants only reservation "
-				    "type  reject command 0x%x\n", cdb[0]);
-			goto conflict;
-		}
-		break;
-	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS_REGS_ONLY:
-	case SPDK_SCSI_PR_EXCLUSIVE_ACCESS_ALL_REGS:
-		if (!reg) {
-			SPDK_ERRLOG("CHECK: All Registrants reservation "
-				    "type  reject command 0x%x\n", cdb[0]);
-			goto conflict;
-		}
-		break;
-	default:
-		break;
-	}
-
-	return 0;
-
 conflict:
 	spdk_scsi_task_set_status(task, SPDK_SCSI_STATUS_RESERVATION_CONFLICT,
 				  SPDK_SCSI_SENSE_NO_SENSE,
@@ -981,6 +1047,7 @@ scsi2_reserve(struct spdk_scsi_task *task, uint8_t *cdb)
 
 	lun->reservation.flags = SCSI_SPC2_RESERVE;
 	lun->reservation.holder = &lun->scsi2_holder;
+	scsi_pr_state_changed(lun);
 
 	return 0;
 }
@@ -1009,6 +1076,7 @@ scsi2_release(struct spdk_scsi_task *task)
 
 	memset(&lun->reservation, 0, sizeof(struct spdk_scsi_pr_reservation));
 	memset(&lun->scsi2_holder, 0, sizeof(struct spdk_scsi_pr_registrant));
+	scsi_pr_state_changed(lun);
 
 	return 0;
 }
@@ -0,0 +1,589 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+/*
+ * Reservation store of a LUN.
+ *
+ * The registrants and the persistent reservation of a LUN are kept in memory
+ * and checked there by every task. When a store is attached, each PERSISTENT
+ * RESERVE OUT command which changes them also serializes them into a record,
+ * which is written to the start of the store bdev in the background, so that
+ * another node taking over the LUN can load them back.
+ *
+ * Records are serialized on the thread executing the tasks of the LUN and
+ * handed over to the thread which opened the LUN, which owns the store bdev.
+ * Only one write is in flight at a time. Records produced meanwhile replace
+ * each other, so only the newest one is written after it.
+ */
+
+#include "scsi_internal.h"
+
+#include "spdk/crc32.h"
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#define SCSI_PR_STORE_MAGIC		0x5053495343534450ULL
+#define SCSI_PR_STORE_VERSION		1
+#define SCSI_PR_STORE_MAX_REGISTRANTS	64
+
+struct scsi_pr_store_registrant {
+	uint64_t	rkey;
+	uint16_t	relative_target_port_id;
+	uint16_t	transport_id_len;
+	uint8_t		reserved[4];
+	char		transport_id[SPDK_SCSI_MAX_TRANSPORT_ID_LENGTH];
+	char		initiator_port_name[SPDK_SCSI_PORT_MAX_NAME_LENGTH];
+	char		target_port_name[SPDK_SCSI_PORT_MAX_NAME_LENGTH];
+	uint8_t		reserved2[3];
+};
+SPDK_STATIC_ASSERT(sizeof(struct scsi_pr_store_registrant) == 784, "Incorrect size");
+
+struct scsi_pr_store_header {
+	uint64_t	magic;
+	uint32_t	version;
+	/* CRC32C of the header and the registrants, computed with this field zeroed */
+	uint32_t	crc;
+	/* Incremented by each record written */
+	uint64_t	seq;
+	uint64_t	crkey;
+	uint32_t	pr_generation;
+	uint32_t	rtype;
+	/* Index of the reservation holder in the registrants plus one, 0 if none */
+	uint32_t	holder;
+	uint32_t	num_registrants;
+	uint8_t		reserved[16];
+};
+SPDK_STATIC_ASSERT(sizeof(struct scsi_pr_store_header) == 64, "Incorrect size");
+
+#define SCSI_PR_STORE_RECORD_SIZE	(sizeof(struct scsi_pr_store_header) + \
+		SCSI_PR_STORE_MAX_REGISTRANTS * sizeof(struct scsi_pr_store_registrant))
+
+struct scsi_pr_store_record {
+	struct scsi_pr_store		*store;
+	void				*buf;
+};
+
+struct scsi_pr_store {
+	/* NULL once the LUN is removed */
+	struct spdk_scsi_lun		*lun;
+
+	/* Thread which opened the LUN; the bdev is only accessed from it */
+	struct spdk_thread		*thread;
+	struct spdk_bdev_desc		*desc;
+	struct spdk_io_channel		*ch;
+	char				*bdev_name;
+	uint64_t			num_blocks;
+	size_t				buf_size;
+	size_t				buf_align;
+
+	/* Sequence number of the last record serialized */
+	uint64_t			seq;
+
+	/* Records sent to the store thread and not received yet */
+	uint32_t			num_msgs;
+
+	/* Record being written, or being read while the store is attached */
+	struct scsi_pr_store_record	*writing;
+	struct scsi_pr_store_record	*pending;
+	struct spdk_bdev_io_wait_entry	bdev_io_wait;
+	bool				io_waiting;
+
+	bool				removed;
+	bool				detached;
+
+	scsi_pr_store_cb		cb_fn;
+	void				*cb_arg;
+};
+
+static void scsi_pr_store_process(struct scsi_pr_store *store);
+
+static struct scsi_pr_store_record *
+scsi_pr_store_record_alloc(struct scsi_pr_store *store)
+{
+	struct scsi_pr_store_record *record;
+
+	record = calloc(1, sizeof(*record));
+	if (record == NULL) {
+		return NULL;
+	}
+
+	record->buf = spdk_dma_zmalloc(store->buf_size, store->buf_align, NULL);
+	if (record->buf == NULL) {
+		free(record);
+		return NULL;
+	}
+	record->store = store;
+
+	return record;
+}
+
+static void
+scsi_pr_store_record_free(struct scsi_pr_store_record *record)
+{
+	spdk_dma_free(record->buf);
+	free(record);
+}
+
+static int
+scsi_pr_store_serialize(struct scsi_pr_store *store, struct spdk_scsi_lun *lun, void *buf)
+{
+	struct scsi_pr_store_header *hdr = buf;
+	struct scsi_pr_store_registrant *regs = (struct scsi_pr_store_registrant *)(hdr + 1);
+	struct spdk_scsi_pr_registrant *reg;
+	bool spc2_reserve = lun->reservation.flags & SCSI_SPC2_RESERVE;
+	uint32_t i = 0;
+
+	TAILQ_FOREACH(reg, &lun->reg_head, link) {
+		if (i == SCSI_PR_STORE_MAX_REGISTRANTS) {
+			SPDK_ERRLOG("LUN %s has more than %u registrants, can't store them\n",
+				    spdk_scsi_lun_get_bdev_name(lun), SCSI_PR_STORE_MAX_REGISTRANTS);
+			return -ENOSPC;
+		}
+
+		regs[i].rkey = reg->rkey;
+		regs[i].relative_target_port_id = reg->relative_target_port_id;
+		regs[i].transport_id_len = reg->transport_id_len;
+		memcpy(regs[i].transport_id, reg->transport_id, reg->transport_id_len);
+		snprintf(regs[i].initiator_port_name, sizeof(regs[i].initiator_port_name), "%s",
+			 reg->initiator_port_name);
+		snprintf(regs[i].target_port_name, sizeof(regs[i].target_port_name), "%s",
+			 reg->target_port_name);
+		if (!spc2_reserve && lun->reservation.holder == reg) {
+			hdr->holder = i + 1;
+		}
+		i++;
+	}
+
+	hdr->magic = SCSI_PR_STORE_MAGIC;
+	hdr->version = SCSI_PR_STORE_VERSION;
+	hdr->seq = ++store->seq;
+	hdr->pr_generation = lun->pr_generation;
+	/* SPC-2 reservations don't survive a reset of the target, so aren't stored */
+	if (!spc2_reserve) {
+		hdr->crkey = lun->reservation.crkey;
+		hdr->rtype = lun->reservation.rtype;
+	}
+	hdr->num_registrants = i;
+	hdr->crc = spdk_crc32c_update(buf, sizeof(*hdr) + i * sizeof(*regs), 0);
+
+	return 0;
+}
+
+static void
+scsi_pr_store_free_registrants(struct spdk_scsi_lun *lun)
+{
+	struct spdk_scsi_pr_registrant *reg, *tmp;
+
+	TAILQ_FOREACH_SAFE(reg, &lun->reg_head, link, tmp) {
+		TAILQ_REMOVE(&lun->reg_head, reg, link);
+		free(reg);
+	}
+}
+
+static int
+scsi_pr_store_load(struct scsi_pr_store *store, struct spdk_scsi_lun *lun, void *buf)
+{
+	struct scsi_pr_store_header *hdr = buf;
+	struct scsi_pr_store_registrant *regs = (struct scsi_pr_store_registrant *)(hdr + 1);
+	struct spdk_scsi_pr_registrant *reg, *holder = NULL;
+	uint32_t crc, i;
+
+	if (hdr->magic != SCSI_PR_STORE_MAGIC) {
+		SPDK_NOTICELOG("No reservation state found on %s\n", store->bdev_name);
+		return 0;
+	}
+
+	if (hdr->version != SCSI_PR_STORE_VERSION ||
+	    hdr->num_registrants > SCSI_PR_STORE_MAX_REGISTRANTS ||
+	    hdr->holder > hdr->num_registrants) {
+		SPDK_ERRLOG("Invalid reservation state on %s\n", store->bdev_name);
+		return -EINVAL;
+	}
+
+	crc = hdr->crc;
+	hdr->crc = 0;
+	if (spdk_crc32c_update(buf, sizeof(*hdr) + hdr->num_registrants * sizeof(*regs), 0) != crc) {
+		SPDK_ERRLOG("Reservation state on %s is corrupted\n", store->bdev_name);
+		return -EILSEQ;
+	}
+
+	store->seq = hdr->seq;
+
+	if (!TAILQ_EMPTY(&lun->reg_head) || lun->reservation.holder != NULL) {
+		SPDK_NOTICELOG("LUN %s already has reservation state, overwriting the one on %s\n",
+			       spdk_scsi_lun_get_bdev_name(lun), store->bdev_name);
+		return 0;
+	}
+
+	for (i = 0; i < hdr->num_registrants; i++) {
+		if (regs[i].transport_id_len > SPDK_SCSI_MAX_TRANSPORT_ID_LENGTH) {
+			SPDK_ERRLOG("Invalid registrant %u on %s\n", i, store->bdev_name);
+			scsi_pr_store_free_registrants(lun);
+			return -EINVAL;
+		}
+
+		reg = calloc(1, sizeof(*reg));
+		if (reg == NULL) {
+			scsi_pr_store_free_registrants(lun);
+			return -ENOMEM;
+		}
+
+		/* Port pointers are bound when the I_T nexus logs in again. */
+		reg->rkey = regs[i].rkey;
+		reg->relative_target_port_id = regs[i].relative_target_port_id;
+		reg->transport_id_len = regs[i].transport_id_len;
+		memcpy(reg->transport_id, regs[i].transport_id, reg->transport_id_len);
+		snprintf(reg->initiator_port_name, sizeof(reg->initiator_port_name), "%.*s",
+			 (int)sizeof(regs[i].initiator_port_name), regs[i].initiator_port_name);
+		snprintf(reg->target_port_name, sizeof(reg->target_port_name), "%.*s",
+			 (int)sizeof(regs[i].target_port_name), regs[i].target_port_name);
+		TAILQ_INSERT_TAIL(&lun->reg_head, reg, link);
+
+		if (i + 1 == hdr->holder) {
+			holder = reg;
+		}
+	}
+
+	if (holder != NULL) {
+		lun->reservation.rtype = hdr->rtype;
+		lun->reservation.crkey = hdr->crkey;
+		lun->reservation.holder = holder;
+	}
+	lun->pr_generation = hdr->pr_generation;
+	lun->pr_state_gen++;
+
+	SPDK_NOTICELOG("Loaded %u registrants of LUN %s from %s\n", hdr->num_registrants,
+		       spdk_scsi_lun_get_bdev_name(lun), store->bdev_name);
+
+	return 0;
+}
+
+static void
+scsi_pr_store_free(struct scsi_pr_store *store)
+{
+	if (store->pending != NULL) {
+		scsi_pr_store_record_free(store->pending);
+	}
+	if (store->ch != NULL) {
+		spdk_put_io_channel(store->ch);
+	}
+	if (store->desc != NULL) {
+		spdk_bdev_close(store->desc);
+	}
+	free(store->bdev_name);
+	free(store);
+}
+
+static void
+scsi_pr_store_write_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct scsi_pr_store *store = cb_arg;
+	struct scsi_pr_store_header *hdr = store->writing->buf;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		SPDK_ERRLOG("Failed to write reservation state %" PRIu64 " to %s\n",
+			    hdr->seq, store->bdev_name);
+	}
+
+	scsi_pr_store_record_free(store->writing);
+	store->writing = NULL;
+
+	scsi_pr_store_process(store);
+}
+
+static void
+scsi_pr_store_resubmit(void *arg)
+{
+	struct scsi_pr_store *store = arg;
+
+	store->io_waiting = false;
+	scsi_pr_store_process(store);
+}
+
+static void
+scsi_pr_store_process(struct scsi_pr_store *store)
+{
+	struct scsi_pr_store_record *record;
+	int rc;
+
+	/* Completion of the read of the stored state or of the write in progress
+	 * comes back here.
+	 */
+	if (store->writing != NULL || store->io_waiting) {
+		return;
+	}
+
+	if (store->pending != NULL && store->desc != NULL && !store->removed) {
+		record = store->pending;
+		rc = spdk_bdev_write_blocks(store->desc, store->ch, record->buf, 0,
+					    store->num_blocks, scsi_pr_store_write_done, store);
+		if (rc == 0) {
+			store->pending = NULL;
+			store->writing = record;
+			return;
+		} else if (rc == -ENOMEM) {
+			store->bdev_io_wait.bdev = spdk_bdev_desc_get_bdev(store->desc);
+			store->bdev_io_wait.cb_fn = scsi_pr_store_resubmit;
+			store->bdev_io_wait.cb_arg = store;
+			rc = spdk_bdev_queue_io_wait(store->bdev_io_wait.bdev, store->ch,
+						     &store->bdev_io_wait);
+			if (rc == 0) {
+				store->io_waiting = true;
+				return;
+			}
+		}
+
+		SPDK_ERRLOG("Failed to write reservation state to %s: %s\n", store->bdev_name,
+			    spdk_strerror(-rc));
+		store->pending = NULL;
+		scsi_pr_store_record_free(record);
+	}
+
+	if (store->removed && store->desc != NULL) {
+		if (store->pending != NULL) {
+			scsi_pr_store_record_free(store->pending);
+			store->pending = NULL;
+		}
+		spdk_put_io_channel(store->ch);
+		store->ch = NULL;
+		spdk_bdev_close(store->desc);
+		store->desc = NULL;
+	}
+
+	if (store->detached && __atomic_load_n(&store->num_msgs, __ATOMIC_SEQ_CST) == 0) {
+		scsi_pr_store_free(store);
+	}
+}
+
+static void
+_scsi_pr_store_queue_record(void *arg)
+{
+	struct scsi_pr_store_record *record = arg;
+	struct scsi_pr_store *store = record->store;
+
+	__atomic_fetch_sub(&store->num_msgs, 1, __ATOMIC_SEQ_CST);
+
+	/* A record not written yet is superseded by the newer one */
+	if (store->pending != NULL) {
+		scsi_pr_store_record_free(store->pending);
+	}
+	store->pending = record;
+
+	scsi_pr_store_process(store);
+}
+
+void
+scsi_pr_store_persist(struct spdk_scsi_lun *lun)
+{
+	struct scsi_pr_store *store = lun->pr_store;
+	struct scsi_pr_store_record *record;
+	int rc;
+
+	if (store == NULL) {
+		return;
+	}
+
+	record = scsi_pr_store_record_alloc(store);
+	if (record == NULL) {
+		SPDK_ERRLOG("Failed to allocate reservation state record of LUN %s\n",
+			    spdk_scsi_lun_get_bdev_name(lun));
+		return;
+	}
+
+	rc = scsi_pr_store_serialize(store, lun, record->buf);
+	if (rc != 0) {
+		scsi_pr_store_record_free(record);
+		return;
+	}
+
+	__atomic_fetch_add(&store->num_msgs, 1, __ATOMIC_SEQ_CST);
+	rc = spdk_thread_send_msg(store->thread, _scsi_pr_store_queue_record, record);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to send reservation state record of LUN %s\n",
+			    spdk_scsi_lun_get_bdev_name(lun));
+		__atomic_fetch_sub(&store->num_msgs, 1, __ATOMIC_SEQ_CST);
+		scsi_pr_store_record_free(record);
+	}
+}
+
+static void
+scsi_pr_store_read_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct scsi_pr_store *store = cb_arg;
+	struct spdk_scsi_lun *lun = store->lun;
+	struct scsi_pr_store_record *record = store->writing;
+	scsi_pr_store_cb attach_cb_fn = store->cb_fn;
+	void *attach_cb_arg = store->cb_arg;
+	int rc;
+
+	spdk_bdev_free_io(bdev_io);
+	store->writing = NULL;
+
+	if (!success) {
+		SPDK_ERRLOG("Failed to read reservation state from %s\n", store->bdev_name);
+		rc = -EIO;
+	} else if (lun == NULL || store->removed) {
+		rc = -ENODEV;
+	} else if (lun->io_channel != NULL) {
+		/* An initiator started to use the LUN meanwhile */
+		rc = -EBUSY;
+	} else {
+		rc = scsi_pr_store_load(store, lun, record->buf);
+	}
+
+	if (rc == 0) {
+		/* Write back the state now in effect */
+		memset(record->buf, 0, store->buf_size);
+		rc = scsi_pr_store_serialize(store, lun, record->buf);
+	}
+
+	if (rc == 0) {
+		if (store->pending != NULL) {
+			scsi_pr_store_record_free(store->pending);
+		}
+		store->pending = record;
+	} else {
+		scsi_pr_store_record_free(record);
+		if (lun != NULL) {
+			lun->pr_store = NULL;
+		}
+		store->lun = NULL;
+		store->detached = true;
+	}
+
+	scsi_pr_store_process(store);
+
+	attach_cb_fn(attach_cb_arg, rc);
+}
+
+static void
+scsi_pr_store_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+		       void *event_ctx)
+{
+	struct scsi_pr_store *store = event_ctx;
+
+	switch (type) {
+	case SPDK_BDEV_EVENT_REMOVE:
+		SPDK_ERRLOG("Reservation store %s removed, reservation state is no longer persisted\n",
+			    store->bdev_name);
+		store->removed = true;
+		scsi_pr_store_process(store);
+		break;
+	default:
+		SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
+		break;
+	}
+}
+
+int
+scsi_pr_store_attach(struct spdk_scsi_lun *lun, const char *bdev_name,
+		     scsi_pr_store_cb cb_fn, void *cb_arg)
+{
+	struct scsi_pr_store *store;
+	struct scsi_pr_store_record *record;
+	struct spdk_bdev *bdev;
+	uint32_t block_size;
+	int rc;
+
+	assert(spdk_get_thread() == lun->thread);
+
+	if (lun->removed) {
+		return -ENODEV;
+	}
+
+	if (lun->pr_store != NULL) {
+		return -EEXIST;
+	}
+
+	/* The state can only be loaded before any initiator uses the LUN */
+	if (lun->io_channel != NULL) {
+		return -EBUSY;
+	}
+
+	store = calloc(1, sizeof(*store));
+	if (store == NULL) {
+		return -ENOMEM;
+	}
+
+	rc = spdk_bdev_open_ext(bdev_name, true, scsi_pr_store_event_cb, store, &store->desc);
+	if (rc != 0) {
+		SPDK_ERRLOG("bdev %s cannot be opened, error=%d\n", bdev_name, rc);
+		free(store);
+		return rc;
+	}
+
+	store->bdev_name = strdup(bdev_name);
+	if (store->bdev_name == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	bdev = spdk_bdev_desc_get_bdev(store->desc);
+	block_size = spdk_bdev_get_block_size(bdev);
+	store->num_blocks = SPDK_CEIL_DIV(SCSI_PR_STORE_RECORD_SIZE, block_size);
+	if (spdk_bdev_get_num_blocks(bdev) < store->num_blocks) {
+		SPDK_ERRLOG("bdev %s is too small to store reservation state\n", bdev_name);
+		rc = -ENOSPC;
+		goto err;
+	}
+	store->buf_size = store->num_blocks * block_size;
+	store->buf_align = spdk_bdev_get_buf_align(bdev);
+	store->thread = lun->thread;
+
+	store->ch = spdk_bdev_get_io_channel(store->desc);
+	if (store->ch == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	record = scsi_pr_store_record_alloc(store);
+	if (record == NULL) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	/* The read is tracked as the I/O in flight, so that records of changes
+	 * made meanwhile wait for it.
+	 */
+	rc = spdk_bdev_read_blocks(store->desc, store->ch, record->buf, 0,
+				   store->num_blocks, scsi_pr_store_read_done, store);
+	if (rc != 0) {
+		scsi_pr_store_record_free(record);
+		goto err;
+	}
+
+	store->writing = record;
+	store->lun = lun;
+	store->cb_fn = cb_fn;
+	store->cb_arg = cb_arg;
+	lun->pr_store = store;
+
+	return 0;
+
+err:
+	scsi_pr_store_free(store);
+	return rc;
+}
+
+void
+scsi_pr_store_detach(struct spdk_scsi_lun *lun)
+{
+	struct scsi_pr_store *store = lun->pr_store;
+
+	if (store == NULL) {
+		return;
+	}
+
+	lun->pr_store = NULL;
+	store->lun = NULL;
+	store->detached = true;
+
+	/* Records already queued are still written before the store is closed */
+	scsi_pr_store_process(store);
+}
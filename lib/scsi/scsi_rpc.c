@@ -7,6 +7,8 @@
 #include "scsi_internal.h"
 
 #include "spdk/rpc.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
 #include "spdk/util.h"
 
 static void
@@ -46,3 +48,108 @@ rpc_scsi_get_devices(struct spdk_jsonrpc_request *request,
 	spdk_jsonrpc_end_result(request, w);
 }
 SPDK_RPC_REGISTER("scsi_get_devices", rpc_scsi_get_devices, SPDK_RPC_RUNTIME)
+
+struct rpc_scsi_lun_attach_pr_store {
+	char *dev_name;
+	int32_t lun_id;
+	char *bdev_name;
+	struct spdk_jsonrpc_request *request;
+};
+
+static void
+free_rpc_scsi_lun_attach_pr_store(struct rpc_scsi_lun_attach_pr_store *req)
+{
+	free(req->dev_name);
+	free(req->bdev_name);
+	free(req);
+}
+
+static const struct spdk_json_object_decoder rpc_scsi_lun_attach_pr_store_decoders[] = {
+	{"dev_name", offsetof(struct rpc_scsi_lun_attach_pr_store, dev_name), spdk_json_decode_string},
+	{"lun_id", offsetof(struct rpc_scsi_lun_attach_pr_store, lun_id), spdk_json_decode_int32},
+	{"bdev_name", offsetof(struct rpc_scsi_lun_attach_pr_store, bdev_name), spdk_json_decode_string},
+};
+
+static struct spdk_scsi_lun *
+rpc_scsi_find_lun(const char *dev_name, int lun_id)
+{
+	struct spdk_scsi_dev *devs = scsi_dev_get_list();
+	int i;
+
+	for (i = 0; i < SPDK_SCSI_MAX_DEVS; i++) {
+		if (devs[i].is_allocated && strcmp(devs[i].name, dev_name) == 0) {
+			return spdk_scsi_dev_get_lun(&devs[i], lun_id);
+		}
+	}
+
+	return NULL;
+}
+
+static void
+rpc_scsi_lun_attach_pr_store_done(void *cb_arg, int rc)
+{
+	struct rpc_scsi_lun_attach_pr_store *req = cb_arg;
+
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(req->request, rc, spdk_strerror(-rc));
+	} else {
+		spdk_jsonrpc_send_bool_response(req->request, true);
+	}
+
+	free_rpc_scsi_lun_attach_pr_store(req);
+}
+
+static void
+_rpc_scsi_lun_attach_pr_store(void *arg)
+{
+	struct rpc_scsi_lun_attach_pr_store *req = arg;
+	struct spdk_scsi_lun *lun;
+	int rc;
+
+	lun = rpc_scsi_find_lun(req->dev_name, req->lun_id);
+	if (lun == NULL) {
+		rpc_scsi_lun_attach_pr_store_done(req, -ENODEV);
+		return;
+	}
+
+	rc = scsi_pr_store_attach(lun, req->bdev_name, rpc_scsi_lun_attach_pr_store_done, req);
+	if (rc != 0) {
+		rpc_scsi_lun_attach_pr_store_done(req, rc);
+	}
+}
+
+static void
+rpc_scsi_lun_attach_pr_store(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct rpc_scsi_lun_attach_pr_store *req;
+	struct spdk_scsi_lun *lun;
+
+	req = calloc(1, sizeof(*req));
+	if (req == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		return;
+	}
+
+	if (spdk_json_decode_object(params, rpc_scsi_lun_attach_pr_store_decoders,
+				    SPDK_COUNTOF(rpc_scsi_lun_attach_pr_store_decoders), req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		free_rpc_scsi_lun_attach_pr_store(req);
+		return;
+	}
+	req->request = request;
+
+	lun = rpc_scsi_find_lun(req->dev_name, req->lun_id);
+	if (lun == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENODEV, "LUN not found");
+		free_rpc_scsi_lun_attach_pr_store(req);
+		return;
+	}
+
+	/* The store is attached on the thread which opened the LUN, where the LUN
+	 * is looked up again as it may be removed meanwhile.
+	 */
+	spdk_thread_send_msg(lun->thread, _rpc_scsi_lun_attach_pr_store, req);
+}
+SPDK_RPC_REGISTER("scsi_lun_attach_pr_store", rpc_scsi_lun_attach_pr_store, SPDK_RPC_RUNTIME)
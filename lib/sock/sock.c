@@ -15,6 +15,7 @@
 #define SPDK_SOCK_DEFAULT_PRIORITY 0
 #define SPDK_SOCK_DEFAULT_ZCOPY true
 #define SPDK_SOCK_DEFAULT_ACK_TIMEOUT 0
+#define SPDK_SOCK_RECV_NEXT_BUF_SIZE 8192
 
 #define SPDK_SOCK_OPTS_FIELD_OK(opts, field) (offsetof(struct spdk_sock_opts, field) + sizeof(opts->field) <= (opts->opts_size))
 
@@ -458,6 +459,51 @@ spdk_sock_recv(struct spdk_sock *sock, void *buf, size_t len)
 	return sock->net_impl->recv(sock, buf, len);
 }
 
+ssize_t
+spdk_sock_recv_next(struct spdk_sock *sock, void **buf, void **ctx)
+{
+	ssize_t rc;
+	void *data;
+
+	if (sock == NULL || sock->flags.closed) {
+		errno = EBADF;
+		return -1;
+	}
+
+	if (sock->net_impl->recv_next != NULL) {
+		return sock->net_impl->recv_next(sock, buf, ctx);
+	}
+
+	/* Receive straight into a buffer handed over to the caller */
+	data = malloc(SPDK_SOCK_RECV_NEXT_BUF_SIZE);
+	if (data == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	rc = sock->net_impl->recv(sock, data, SPDK_SOCK_RECV_NEXT_BUF_SIZE);
+	if (rc <= 0) {
+		free(data);
+		return rc;
+	}
+
+	*buf = data;
+	*ctx = data;
+
+	return rc;
+}
+
+void
+spdk_sock_recv_buf_release(struct spdk_sock *sock, void *ctx)
+{
+	if (sock->net_impl->recv_buf_release != NULL) {
+		sock->net_impl->recv_buf_release(sock, ctx);
+		return;
+	}
+
+	free(ctx);
+}
+
 ssize_t
 spdk_sock_readv(struct spdk_sock *sock, struct iovec *iov, int iovcnt)
 {
@@ -488,6 +534,12 @@ spdk_sock_readv_async(struct spdk_sock *sock, struct spdk_sock_request *req)
 	sock->net_impl->readv_async(sock, req);
 }
 
+void
+spdk_sock_get_stats(struct spdk_sock *sock, struct spdk_sock_stats *stats)
+{
+	*stats = sock->stats;
+}
+
 ssize_t
 spdk_sock_writev(struct spdk_sock *sock, struct iovec *iov, int iovcnt)
 {
@@ -868,6 +920,9 @@ spdk_sock_write_config_json(struct spdk_json_write_ctx *w)
 			if (opts.psk_identity) {
 				spdk_json_write_named_string(w, "psk_identity", opts.psk_identity);
 			}
+			spdk_json_write_named_bool(w, "enable_recv_multishot", opts.enable_recv_multishot);
+			spdk_json_write_named_uint32(w, "busy_poll_usecs", opts.busy_poll_usecs);
+			spdk_json_write_named_bool(w, "enable_prefer_busy_poll", opts.enable_prefer_busy_poll);
 			spdk_json_write_object_end(w);
 			spdk_json_write_object_end(w);
 		} else {
@@ -61,6 +61,9 @@ rpc_sock_impl_get_options(struct spdk_jsonrpc_request *request,
 	if (sock_opts.psk_identity) {
 		spdk_json_write_named_string(w, "psk_identity", sock_opts.psk_identity);
 	}
+	spdk_json_write_named_bool(w, "enable_recv_multishot", sock_opts.enable_recv_multishot);
+	spdk_json_write_named_uint32(w, "busy_poll_usecs", sock_opts.busy_poll_usecs);
+	spdk_json_write_named_bool(w, "enable_prefer_busy_poll", sock_opts.enable_prefer_busy_poll);
 	spdk_json_write_object_end(w);
 	spdk_jsonrpc_end_result(request, w);
 	free(impl_name);
@@ -125,6 +128,18 @@ static const struct spdk_json_object_decoder rpc_sock_impl_set_opts_decoders[] =
 	{
 		"psk_identity", offsetof(struct spdk_rpc_sock_impl_set_opts, sock_opts.psk_identity),
 		spdk_json_decode_string, true
+	},
+	{
+		"enable_recv_multishot", offsetof(struct spdk_rpc_sock_impl_set_opts, sock_opts.enable_recv_multishot),
+		spdk_json_decode_bool, true
+	},
+	{
+		"busy_poll_usecs", offsetof(struct spdk_rpc_sock_impl_set_opts, sock_opts.busy_poll_usecs),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"enable_prefer_busy_poll", offsetof(struct spdk_rpc_sock_impl_set_opts, sock_opts.enable_prefer_busy_poll),
+		spdk_json_decode_bool, true
 	}
 };
 
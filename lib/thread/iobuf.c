@@ -9,6 +9,7 @@
 #include "spdk/log.h"
 #include "spdk/thread.h"
 #include "spdk/bdev.h"
+#include "spdk/histogram_data.h"
 
 #define IOBUF_MIN_SMALL_POOL_SIZE	8191
 #define IOBUF_MIN_LARGE_POOL_SIZE	1023
@@ -17,6 +18,8 @@
 					 IOBUF_ALIGNMENT)
 #define IOBUF_MIN_LARGE_BUFSIZE		(SPDK_BDEV_BUF_SIZE_WITH_MD(SPDK_BDEV_LARGE_BUF_MAX_SIZE) + \
 					 IOBUF_ALIGNMENT)
+#define IOBUF_DEFAULT_CACHE_REBALANCE_BUDGET	10
+#define IOBUF_MAX_NUM_POOLS		(SPDK_IOBUF_MAX_SIZE_CLASSES + 2)
 
 SPDK_STATIC_ASSERT(sizeof(struct spdk_iobuf_buffer) <= IOBUF_MIN_SMALL_BUFSIZE,
 		   "Invalid data offset");
@@ -24,6 +27,9 @@ SPDK_STATIC_ASSERT(sizeof(struct spdk_iobuf_buffer) <= IOBUF_MIN_SMALL_BUFSIZE,
 struct iobuf_channel {
 	spdk_iobuf_entry_stailq_t small_queue;
 	spdk_iobuf_entry_stailq_t large_queue;
+	spdk_iobuf_entry_stailq_t class_queues[SPDK_IOBUF_MAX_SIZE_CLASSES];
+	TAILQ_HEAD(, spdk_iobuf_channel) channels;
+	struct spdk_poller *rebalance_poller;
 };
 
 struct iobuf_module {
@@ -31,15 +37,27 @@ struct iobuf_module {
 	TAILQ_ENTRY(iobuf_module)	tailq;
 };
 
-struct iobuf {
+struct iobuf_node {
 	struct spdk_mempool		*small_pool;
 	struct spdk_mempool		*large_pool;
+	struct spdk_mempool		*class_pools[SPDK_IOBUF_MAX_SIZE_CLASSES];
+};
+
+struct iobuf {
+	/* Indexed by NUMA node, only nodes with cores have pools */
+	struct iobuf_node		nodes[SPDK_IOBUF_MAX_NUMA_NODES];
+	uint32_t			num_nodes;
 	struct spdk_iobuf_opts		opts;
 	TAILQ_HEAD(, iobuf_module)	modules;
 	spdk_iobuf_finish_cb		finish_cb;
 	void				*finish_arg;
+	/* Number of buffers the caches have grown by, for each pool index, shared by all threads */
+	int64_t				cache_growth[IOBUF_MAX_NUM_POOLS];
 };
 
+/* Serializes the creation of the pools of a node when they're created on first use */
+static pthread_mutex_t g_iobuf_node_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static struct iobuf g_iobuf = {
 	.modules = TAILQ_HEAD_INITIALIZER(g_iobuf.modules),
 	.opts = {
@@ -47,16 +65,201 @@ static struct iobuf g_iobuf = {
 		.large_pool_count = IOBUF_MIN_LARGE_POOL_SIZE,
 		.small_bufsize = IOBUF_MIN_SMALL_BUFSIZE,
 		.large_bufsize = IOBUF_MIN_LARGE_BUFSIZE,
+		.opts_size = sizeof(struct spdk_iobuf_opts),
+		.cache_rebalance_budget = IOBUF_DEFAULT_CACHE_REBALANCE_BUDGET,
 	},
 };
 
+/* Pools of a channel are indexed by increasing buffer size: small, the size classes, large. */
+static inline uint32_t
+iobuf_channel_num_pools(const struct spdk_iobuf_channel *ch)
+{
+	return ch->num_classes + 2;
+}
+
+static inline struct spdk_iobuf_pool *
+iobuf_channel_pool(struct spdk_iobuf_channel *ch, uint32_t idx)
+{
+	if (idx == 0) {
+		return &ch->small;
+	} else if (idx <= ch->num_classes) {
+		return &ch->classes[idx - 1];
+	}
+
+	assert(idx == ch->num_classes + 1);
+	return &ch->large;
+}
+
+static inline uint32_t
+iobuf_channel_pool_idx(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool *pool)
+{
+	if (pool == &ch->small) {
+		return 0;
+	} else if (pool == &ch->large) {
+		return ch->num_classes + 1;
+	}
+
+	return pool - ch->classes + 1;
+}
+
+/* Returns the mempool of a node, indexed like the pools of a channel. */
+static inline struct spdk_mempool *
+iobuf_node_pool(struct iobuf_node *node, uint32_t idx)
+{
+	if (idx == 0) {
+		return node->small_pool;
+	} else if (idx <= g_iobuf.opts.num_size_classes) {
+		return node->class_pools[idx - 1];
+	}
+
+	return node->large_pool;
+}
+
+/* Returns the number of buffers of a pool of each node, indexed like the pools of a channel. */
+static inline uint64_t
+iobuf_pool_count(uint32_t idx)
+{
+	if (idx == 0) {
+		return g_iobuf.opts.small_pool_count;
+	} else if (idx <= g_iobuf.opts.num_size_classes) {
+		return g_iobuf.opts.size_classes[idx - 1].pool_count;
+	}
+
+	return g_iobuf.opts.large_pool_count;
+}
+
+/* Returns the pool of the smallest buffers able to fit len bytes. */
+static inline struct spdk_iobuf_pool *
+iobuf_channel_get_pool(struct spdk_iobuf_channel *ch, uint64_t len)
+{
+	uint32_t i;
+
+	if (len <= ch->small.bufsize) {
+		return &ch->small;
+	}
+
+	for (i = 0; i < ch->num_classes; i++) {
+		if (len <= ch->classes[i].bufsize) {
+			return &ch->classes[i];
+		}
+	}
+
+	assert(len <= ch->large.bufsize);
+	return &ch->large;
+}
+
+static void
+iobuf_pool_release_cache(struct spdk_iobuf_pool *pool, uint32_t count)
+{
+	struct spdk_iobuf_buffer *buf;
+
+	while (pool->cache_count > count) {
+		buf = STAILQ_FIRST(&pool->cache);
+		STAILQ_REMOVE_HEAD(&pool->cache, stailq);
+		spdk_mempool_put(pool->pool, buf);
+		pool->cache_count--;
+	}
+}
+
+/* Grows the cache by as many buffers as were requested from the global pool, at most doubling
+ * it, as long as the budget allows.  The cache then fills up as the buffers are released. */
+static bool
+iobuf_pool_grow_cache(struct spdk_iobuf_pool *pool, uint32_t idx, uint64_t misses)
+{
+	int64_t limit, growth, excess;
+	uint32_t count;
+
+	limit = iobuf_pool_count(idx) * g_iobuf.opts.cache_rebalance_budget / 100;
+	count = spdk_min(misses, spdk_max(pool->cache_size, 1));
+
+	growth = __atomic_add_fetch(&g_iobuf.cache_growth[idx], count, __ATOMIC_RELAXED);
+	if (growth > limit) {
+		excess = spdk_min(growth - limit, (int64_t)count);
+		__atomic_sub_fetch(&g_iobuf.cache_growth[idx], excess, __ATOMIC_RELAXED);
+		count -= excess;
+	}
+
+	pool->cache_size += count;
+
+	return count > 0;
+}
+
+/* Halves the cache, handing its buffers over to the other channels. */
+static bool
+iobuf_pool_shrink_cache(struct spdk_iobuf_pool *pool, uint32_t idx)
+{
+	uint32_t cache_size = pool->cache_size / 2;
+
+	if (pool->cache_size == 0) {
+		return false;
+	}
+
+	__atomic_sub_fetch(&g_iobuf.cache_growth[idx], pool->cache_size - cache_size,
+			   __ATOMIC_RELAXED);
+	pool->cache_size = cache_size;
+	iobuf_pool_release_cache(pool, cache_size);
+
+	return true;
+}
+
+static bool
+iobuf_pool_rebalance(struct spdk_iobuf_pool *pool, uint32_t idx)
+{
+	struct spdk_iobuf_pool_stats *prev = &pool->rebalance_stats;
+	uint64_t hits, misses;
+
+	hits = pool->stats.cache - prev->cache;
+	misses = pool->stats.main - prev->main + pool->stats.retry - prev->retry +
+		 pool->stats.remote - prev->remote;
+	*prev = pool->stats;
+
+	if (misses > 0) {
+		return iobuf_pool_grow_cache(pool, idx, misses);
+	} else if (hits == 0) {
+		return iobuf_pool_shrink_cache(pool, idx);
+	}
+
+	return false;
+}
+
+static int
+iobuf_rebalance_poll(void *ctx)
+{
+	struct iobuf_channel *iobuf_ch = ctx;
+	struct spdk_iobuf_channel *ch;
+	bool busy = false;
+	uint32_t i;
+
+	TAILQ_FOREACH(ch, &iobuf_ch->channels, tailq) {
+		for (i = 0; i < iobuf_channel_num_pools(ch); i++) {
+			busy |= iobuf_pool_rebalance(iobuf_channel_pool(ch, i), i);
+		}
+	}
+
+	return busy ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
 static int
 iobuf_channel_create_cb(void *io_device, void *ctx)
 {
 	struct iobuf_channel *ch = ctx;
+	uint32_t i;
 
 	STAILQ_INIT(&ch->small_queue);
 	STAILQ_INIT(&ch->large_queue);
+	for (i = 0; i < SPDK_IOBUF_MAX_SIZE_CLASSES; i++) {
+		STAILQ_INIT(&ch->class_queues[i]);
+	}
+	TAILQ_INIT(&ch->channels);
+
+	if (g_iobuf.opts.cache_rebalance_period_us != 0) {
+		ch->rebalance_poller = SPDK_POLLER_REGISTER(iobuf_rebalance_poll, ch,
+				       g_iobuf.opts.cache_rebalance_period_us);
+		if (ch->rebalance_poller == NULL) {
+			SPDK_ERRLOG("Failed to register iobuf cache rebalancing poller\n");
+			return -ENOMEM;
+		}
+	}
 
 	return 0;
 }
@@ -65,39 +268,232 @@ static void
 iobuf_channel_destroy_cb(void *io_device, void *ctx)
 {
 	struct iobuf_channel *ch __attribute__((unused)) = ctx;
+	uint32_t i __attribute__((unused));
 
 	assert(STAILQ_EMPTY(&ch->small_queue));
 	assert(STAILQ_EMPTY(&ch->large_queue));
+	for (i = 0; i < SPDK_IOBUF_MAX_SIZE_CLASSES; i++) {
+		assert(STAILQ_EMPTY(&ch->class_queues[i]));
+	}
+	assert(TAILQ_EMPTY(&ch->channels));
+
+	spdk_poller_unregister(&ch->rebalance_poller);
 }
 
-int
-spdk_iobuf_initialize(void)
+static void
+iobuf_node_free_pools(struct iobuf_node *node)
 {
+	uint32_t i;
+
+	spdk_mempool_free(node->small_pool);
+	spdk_mempool_free(node->large_pool);
+	node->small_pool = NULL;
+	node->large_pool = NULL;
+
+	for (i = 0; i < SPDK_IOBUF_MAX_SIZE_CLASSES; i++) {
+		spdk_mempool_free(node->class_pools[i]);
+		node->class_pools[i] = NULL;
+	}
+}
+
+static void
+iobuf_free_pools(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < SPDK_IOBUF_MAX_NUMA_NODES; i++) {
+		iobuf_node_free_pools(&g_iobuf.nodes[i]);
+	}
+
+	g_iobuf.num_nodes = 0;
+}
+
+/* Longest base name of a pool, the one of a size class of UINT32_MAX bytes */
+#define IOBUF_POOL_BASE_NAME_LEN	sizeof("iobuf_4294967295_pool")
+/* Base name followed by the "_<socket id>" suffix */
+#define IOBUF_POOL_NAME_LEN		(IOBUF_POOL_BASE_NAME_LEN + sizeof("_-2147483648") - 1)
+
+static void
+iobuf_pool_name(char *name, size_t size, const char *base, int socket_id)
+{
+	if (socket_id == SPDK_ENV_SOCKET_ID_ANY) {
+		snprintf(name, size, "%s", base);
+	} else {
+		snprintf(name, size, "%s_%d", base, socket_id);
+	}
+}
+
+static int
+iobuf_node_init(uint32_t node_id, int socket_id)
+{
+	struct iobuf_node *node = &g_iobuf.nodes[node_id];
+	struct iobuf_node pools = {};
 	struct spdk_iobuf_opts *opts = &g_iobuf.opts;
-	int rc = 0;
+	struct spdk_iobuf_size_class_opts *class_opts;
+	char base[IOBUF_POOL_BASE_NAME_LEN];
+	char name[IOBUF_POOL_NAME_LEN];
+	uint64_t tsc = spdk_get_ticks();
+	uint32_t i;
 
-	g_iobuf.small_pool = spdk_mempool_create("iobuf_small_pool", opts->small_pool_count,
-			     opts->small_bufsize, 0, SPDK_ENV_SOCKET_ID_ANY);
-	if (!g_iobuf.small_pool) {
+	iobuf_pool_name(name, sizeof(name), "iobuf_small_pool", socket_id);
+	pools.small_pool = spdk_mempool_create(name, opts->small_pool_count,
+					       opts->small_bufsize, 0, socket_id);
+	if (!pools.small_pool) {
 		SPDK_ERRLOG("Failed to create small iobuf pool\n");
-		rc = -ENOMEM;
 		goto error;
 	}
 
-	g_iobuf.large_pool = spdk_mempool_create("iobuf_large_pool", opts->large_pool_count,
-			     opts->large_bufsize, 0, SPDK_ENV_SOCKET_ID_ANY);
-	if (!g_iobuf.large_pool) {
+	iobuf_pool_name(name, sizeof(name), "iobuf_large_pool", socket_id);
+	pools.large_pool = spdk_mempool_create(name, opts->large_pool_count,
+					       opts->large_bufsize, 0, socket_id);
+	if (!pools.large_pool) {
 		SPDK_ERRLOG("Failed to create large iobuf pool\n");
-		rc = -ENOMEM;
 		goto error;
 	}
 
+	for (i = 0; i < opts->num_size_classes; i++) {
+		class_opts = &opts->size_classes[i];
+		snprintf(base, sizeof(base), "iobuf_%" PRIu32 "_pool", class_opts->bufsize);
+		iobuf_pool_name(name, sizeof(name), base, socket_id);
+		pools.class_pools[i] = spdk_mempool_create(name, class_opts->pool_count,
+				       class_opts->bufsize, 0, socket_id);
+		if (!pools.class_pools[i]) {
+			SPDK_ERRLOG("Failed to create %" PRIu32 "B iobuf pool\n",
+				    class_opts->bufsize);
+			goto error;
+		}
+	}
+
+	/* Other threads look a node up through its small pool, so publish that one last */
+	node->large_pool = pools.large_pool;
+	memcpy(node->class_pools, pools.class_pools, sizeof(node->class_pools));
+	__atomic_store_n(&node->small_pool, pools.small_pool, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&g_iobuf.num_nodes, 1, __ATOMIC_RELEASE);
+
+	tsc = (spdk_get_ticks() - tsc) * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+	SPDK_INFOLOG(thread, "Created the iobuf pools of node %" PRIu32 " in %" PRIu64 " us\n",
+		     node_id, tsc);
+
+	return 0;
+error:
+	iobuf_node_free_pools(&pools);
+	return -ENOMEM;
+}
+
+/* With lazy_init, creates the pools of the current thread's node, unless they already exist. */
+static int
+iobuf_node_lazy_init(void)
+{
+	uint32_t core, socket_id, node_id = 0, i;
+	int socket = SPDK_ENV_SOCKET_ID_ANY;
+	int rc = 0;
+
+	if (!g_iobuf.opts.lazy_init) {
+		return 0;
+	}
+
+	core = spdk_env_get_current_core();
+	socket_id = core != SPDK_ENV_LCORE_ID_ANY ? spdk_env_get_socket_id(core) : UINT32_MAX;
+	if (g_iobuf.opts.enable_numa && socket_id < SPDK_IOBUF_MAX_NUMA_NODES) {
+		node_id = socket_id;
+		socket = socket_id;
+	} else {
+		/* Threads whose node is unknown use the pools of any node, so create a set of
+		 * pools only if there are none yet. */
+		for (i = 0; i < SPDK_IOBUF_MAX_NUMA_NODES; i++) {
+			if (__atomic_load_n(&g_iobuf.nodes[i].small_pool, __ATOMIC_ACQUIRE) != NULL) {
+				return 0;
+			}
+		}
+	}
+
+	if (__atomic_load_n(&g_iobuf.nodes[node_id].small_pool, __ATOMIC_ACQUIRE) != NULL) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&g_iobuf_node_mutex);
+	if (g_iobuf.nodes[node_id].small_pool == NULL) {
+		rc = iobuf_node_init(node_id, socket);
+	}
+	pthread_mutex_unlock(&g_iobuf_node_mutex);
+
+	return rc;
+}
+
+/* Returns the NUMA node whose pools should be used by the current thread. */
+static uint32_t
+iobuf_get_local_node(void)
+{
+	uint32_t core, socket_id, i;
+
+	core = spdk_env_get_current_core();
+	if (g_iobuf.opts.enable_numa && core != SPDK_ENV_LCORE_ID_ANY) {
+		socket_id = spdk_env_get_socket_id(core);
+		if (socket_id < SPDK_IOBUF_MAX_NUMA_NODES &&
+		    g_iobuf.nodes[socket_id].small_pool != NULL) {
+			return socket_id;
+		}
+	}
+
+	/* Fall back to the first node with pools */
+	for (i = 0; i < SPDK_IOBUF_MAX_NUMA_NODES; i++) {
+		if (g_iobuf.nodes[i].small_pool != NULL) {
+			break;
+		}
+	}
+
+	assert(i < SPDK_IOBUF_MAX_NUMA_NODES);
+	return i;
+}
+
+int
+spdk_iobuf_initialize(void)
+{
+	uint32_t core, socket_id;
+	int rc = 0;
+
+	memset(g_iobuf.cache_growth, 0, sizeof(g_iobuf.cache_growth));
+
+	if (g_iobuf.opts.lazy_init) {
+		/* The pools of each node are created by the first channel initialized on it */
+		goto out;
+	}
+
+	if (g_iobuf.opts.enable_numa) {
+		SPDK_ENV_FOREACH_CORE(core) {
+			socket_id = spdk_env_get_socket_id(core);
+			if (socket_id >= SPDK_IOBUF_MAX_NUMA_NODES) {
+				SPDK_WARNLOG("NUMA node %" PRIu32 " of core %" PRIu32 " is not "
+					     "supported, it will use the iobuf pools of another node\n",
+					     socket_id, core);
+				continue;
+			}
+			if (g_iobuf.nodes[socket_id].small_pool != NULL) {
+				continue;
+			}
+
+			rc = iobuf_node_init(socket_id, socket_id);
+			if (rc != 0) {
+				goto error;
+			}
+		}
+	}
+
+	/* Without NUMA, or if the node of none of the cores is known, use a single set of pools */
+	if (g_iobuf.num_nodes == 0) {
+		rc = iobuf_node_init(0, SPDK_ENV_SOCKET_ID_ANY);
+		if (rc != 0) {
+			goto error;
+		}
+	}
+
+out:
 	spdk_io_device_register(&g_iobuf, iobuf_channel_create_cb, iobuf_channel_destroy_cb,
 				sizeof(struct iobuf_channel), "iobuf");
 
 	return 0;
 error:
-	spdk_mempool_free(g_iobuf.small_pool);
+	iobuf_free_pools();
 	return rc;
 }
 
@@ -105,6 +501,10 @@ static void
 iobuf_unregister_cb(void *io_device)
 {
 	struct iobuf_module *module;
+	struct iobuf_node *node;
+	struct spdk_iobuf_size_class_opts *class_opts;
+	uint32_t i, j;
+	size_t count;
 
 	while (!TAILQ_EMPTY(&g_iobuf.modules)) {
 		module = TAILQ_FIRST(&g_iobuf.modules);
@@ -113,18 +513,35 @@ iobuf_unregister_cb(void *io_device)
 		free(module);
 	}
 
-	if (spdk_mempool_count(g_iobuf.small_pool) != g_iobuf.opts.small_pool_count) {
-		SPDK_ERRLOG("small iobuf pool count is %zu, expected %"PRIu64"\n",
-			    spdk_mempool_count(g_iobuf.small_pool), g_iobuf.opts.small_pool_count);
-	}
+	for (i = 0; i < SPDK_IOBUF_MAX_NUMA_NODES; i++) {
+		node = &g_iobuf.nodes[i];
+		if (node->small_pool == NULL) {
+			continue;
+		}
 
-	if (spdk_mempool_count(g_iobuf.large_pool) != g_iobuf.opts.large_pool_count) {
-		SPDK_ERRLOG("large iobuf pool count is %zu, expected %"PRIu64"\n",
-			    spdk_mempool_count(g_iobuf.large_pool), g_iobuf.opts.large_pool_count);
+		count = spdk_mempool_count(node->small_pool);
+		if (count != g_iobuf.opts.small_pool_count) {
+			SPDK_ERRLOG("small iobuf pool count is %zu, expected %"PRIu64"\n",
+				    count, g_iobuf.opts.small_pool_count);
+		}
+
+		count = spdk_mempool_count(node->large_pool);
+		if (count != g_iobuf.opts.large_pool_count) {
+			SPDK_ERRLOG("large iobuf pool count is %zu, expected %"PRIu64"\n",
+				    count, g_iobuf.opts.large_pool_count);
+		}
+
+		for (j = 0; j < g_iobuf.opts.num_size_classes; j++) {
+			class_opts = &g_iobuf.opts.size_classes[j];
+			count = spdk_mempool_count(node->class_pools[j]);
+			if (count != class_opts->pool_count) {
+				SPDK_ERRLOG("%" PRIu32 "B iobuf pool count is %zu, expected %" PRIu64 "\n",
+					    class_opts->bufsize, count, class_opts->pool_count);
+			}
+		}
 	}
 
-	spdk_mempool_free(g_iobuf.small_pool);
-	spdk_mempool_free(g_iobuf.large_pool);
+	iobuf_free_pools();
 
 	if (g_iobuf.finish_cb != NULL) {
 		g_iobuf.finish_cb(g_iobuf.finish_arg);
@@ -140,9 +557,55 @@ spdk_iobuf_finish(spdk_iobuf_finish_cb cb_fn, void *cb_arg)
 	spdk_io_device_unregister(&g_iobuf, iobuf_unregister_cb);
 }
 
+#define SET_FIELD(dst, src, field, size) \
+	if (offsetof(struct spdk_iobuf_opts, field) + sizeof((src)->field) <= (size)) { \
+		(dst)->field = (src)->field; \
+	} \
+
+static void
+iobuf_copy_opts(struct spdk_iobuf_opts *dst, const struct spdk_iobuf_opts *src, size_t size)
+{
+	SET_FIELD(dst, src, small_pool_count, size);
+	SET_FIELD(dst, src, large_pool_count, size);
+	SET_FIELD(dst, src, small_bufsize, size);
+	SET_FIELD(dst, src, large_bufsize, size);
+	SET_FIELD(dst, src, num_size_classes, size);
+	if (offsetof(struct spdk_iobuf_opts, size_classes) + sizeof(src->size_classes) <= size) {
+		memcpy(dst->size_classes, src->size_classes, sizeof(src->size_classes));
+	}
+	SET_FIELD(dst, src, enable_numa, size);
+	SET_FIELD(dst, src, cache_rebalance_period_us, size);
+	SET_FIELD(dst, src, cache_rebalance_budget, size);
+	SET_FIELD(dst, src, lazy_init, size);
+
+	/* Do not remove this statement, you should always update this statement when you adding a
+	 * new field, and do not forget to add the SET_FIELD statement for your added field. */
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_iobuf_opts) == 152, "Incorrect size");
+}
+
+#undef SET_FIELD
+
 int
-spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
+spdk_iobuf_set_opts(const struct spdk_iobuf_opts *_opts)
 {
+	const struct spdk_iobuf_size_class_opts *class_opts;
+	struct spdk_iobuf_opts opts_local, *opts = &opts_local;
+	uint32_t i, prev_bufsize;
+
+	if (_opts == NULL) {
+		SPDK_ERRLOG("opts cannot be NULL\n");
+		return -EINVAL;
+	}
+
+	if (_opts->opts_size == 0) {
+		SPDK_ERRLOG("opts_size inside opts cannot be zero value\n");
+		return -EINVAL;
+	}
+
+	/* Fields the caller doesn't know about keep their current values */
+	opts_local = g_iobuf.opts;
+	iobuf_copy_opts(opts, _opts, _opts->opts_size);
+
 	if (opts->small_pool_count < IOBUF_MIN_SMALL_POOL_SIZE) {
 		SPDK_ERRLOG("small_pool_count must be at least %" PRIu32 "\n",
 			    IOBUF_MIN_SMALL_POOL_SIZE);
@@ -163,16 +626,87 @@ spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
 			    IOBUF_MIN_LARGE_BUFSIZE);
 		return -EINVAL;
 	}
+	if (opts->num_size_classes > SPDK_IOBUF_MAX_SIZE_CLASSES) {
+		SPDK_ERRLOG("num_size_classes must be at most %d\n", SPDK_IOBUF_MAX_SIZE_CLASSES);
+		return -EINVAL;
+	}
+
+	prev_bufsize = opts->small_bufsize;
+	for (i = 0; i < opts->num_size_classes; i++) {
+		class_opts = &opts->size_classes[i];
+		if (class_opts->bufsize <= prev_bufsize ||
+		    class_opts->bufsize >= opts->large_bufsize) {
+			SPDK_ERRLOG("size class bufsizes must be increasing and between small_bufsize "
+				    "and large_bufsize\n");
+			return -EINVAL;
+		}
+		if (class_opts->pool_count == 0) {
+			SPDK_ERRLOG("pool_count of the %" PRIu32 "B size class must not be 0\n",
+				    class_opts->bufsize);
+			return -EINVAL;
+		}
+		prev_bufsize = class_opts->bufsize;
+	}
+	if (opts->cache_rebalance_budget > 100) {
+		SPDK_ERRLOG("cache_rebalance_budget must be at most 100\n");
+		return -EINVAL;
+	}
 
 	g_iobuf.opts = *opts;
+	g_iobuf.opts.opts_size = sizeof(g_iobuf.opts);
 
 	return 0;
 }
 
 void
-spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts)
+spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts, size_t opts_size)
 {
-	*opts = g_iobuf.opts;
+	if (opts == NULL) {
+		SPDK_ERRLOG("opts should not be NULL\n");
+		return;
+	}
+
+	if (opts_size == 0) {
+		SPDK_ERRLOG("opts_size should not be zero value\n");
+		return;
+	}
+
+	iobuf_copy_opts(opts, &g_iobuf.opts, opts_size);
+	opts->opts_size = opts_size;
+}
+
+static void
+iobuf_pool_init(struct spdk_iobuf_pool *pool, struct spdk_mempool *mempool,
+		spdk_iobuf_entry_stailq_t *queue, uint32_t bufsize, uint32_t cache_size)
+{
+	pool->pool = mempool;
+	pool->queue = queue;
+	pool->bufsize = bufsize;
+	pool->cache_size = cache_size;
+	pool->init_cache_size = cache_size;
+	pool->cache_count = 0;
+	memset(&pool->stats, 0, sizeof(pool->stats));
+	memset(&pool->rebalance_stats, 0, sizeof(pool->rebalance_stats));
+	pool->wait_histogram = NULL;
+	STAILQ_INIT(&pool->cache);
+}
+
+static int
+iobuf_pool_populate(struct spdk_iobuf_pool *pool)
+{
+	struct spdk_iobuf_buffer *buf;
+	uint32_t i;
+
+	for (i = 0; i < pool->cache_size; ++i) {
+		buf = spdk_mempool_get(pool->pool);
+		if (buf == NULL) {
+			return -ENOMEM;
+		}
+		STAILQ_INSERT_TAIL(&pool->cache, buf, stailq);
+		pool->cache_count++;
+	}
+
+	return 0;
 }
 
 int
@@ -182,7 +716,8 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 	struct spdk_io_channel *ioch;
 	struct iobuf_channel *iobuf_ch;
 	struct iobuf_module *module;
-	struct spdk_iobuf_buffer *buf;
+	struct iobuf_node *node;
+	struct spdk_iobuf_size_class_opts *class_opts;
 	uint32_t i;
 
 	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
@@ -196,6 +731,11 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 		return -ENODEV;
 	}
 
+	if (iobuf_node_lazy_init() != 0) {
+		SPDK_ERRLOG("Couldn't create iobuf pools\n");
+		return -ENOMEM;
+	}
+
 	ioch = spdk_get_io_channel(&g_iobuf);
 	if (ioch == NULL) {
 		SPDK_ERRLOG("Couldn't get iobuf IO channel\n");
@@ -204,41 +744,43 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 
 	iobuf_ch = spdk_io_channel_get_ctx(ioch);
 
-	ch->small.queue = &iobuf_ch->small_queue;
-	ch->large.queue = &iobuf_ch->large_queue;
-	ch->small.pool = g_iobuf.small_pool;
-	ch->large.pool = g_iobuf.large_pool;
-	ch->small.bufsize = g_iobuf.opts.small_bufsize;
-	ch->large.bufsize = g_iobuf.opts.large_bufsize;
 	ch->parent = ioch;
 	ch->module = module;
-	ch->small.cache_size = small_cache_size;
-	ch->large.cache_size = large_cache_size;
-	ch->small.cache_count = 0;
-	ch->large.cache_count = 0;
-
-	STAILQ_INIT(&ch->small.cache);
-	STAILQ_INIT(&ch->large.cache);
+	ch->node = iobuf_get_local_node();
+	node = &g_iobuf.nodes[ch->node];
+	TAILQ_INSERT_TAIL(&iobuf_ch->channels, ch, tailq);
+
+	iobuf_pool_init(&ch->small, node->small_pool, &iobuf_ch->small_queue,
+			g_iobuf.opts.small_bufsize, small_cache_size);
+	iobuf_pool_init(&ch->large, node->large_pool, &iobuf_ch->large_queue,
+			g_iobuf.opts.large_bufsize, large_cache_size);
+
+	/* The size classes serve requests which would otherwise take a large buffer, so
+	 * they're cached as much as the large ones. */
+	ch->num_classes = g_iobuf.opts.num_size_classes;
+	for (i = 0; i < ch->num_classes; i++) {
+		class_opts = &g_iobuf.opts.size_classes[i];
+		iobuf_pool_init(&ch->classes[i], node->class_pools[i], &iobuf_ch->class_queues[i],
+				class_opts->bufsize, large_cache_size);
+	}
 
-	for (i = 0; i < small_cache_size; ++i) {
-		buf = spdk_mempool_get(g_iobuf.small_pool);
-		if (buf == NULL) {
-			SPDK_ERRLOG("Failed to populate iobuf small buffer cache. "
-				    "You may need to increase spdk_iobuf_opts.small_pool_count\n");
-			goto error;
-		}
-		STAILQ_INSERT_TAIL(&ch->small.cache, buf, stailq);
-		ch->small.cache_count++;
+	if (iobuf_pool_populate(&ch->small) != 0) {
+		SPDK_ERRLOG("Failed to populate iobuf small buffer cache. "
+			    "You may need to increase spdk_iobuf_opts.small_pool_count\n");
+		goto error;
 	}
-	for (i = 0; i < large_cache_size; ++i) {
-		buf = spdk_mempool_get(g_iobuf.large_pool);
-		if (buf == NULL) {
-			SPDK_ERRLOG("Failed to populate iobuf large buffer cache. "
-				    "You may need to increase spdk_iobuf_opts.large_pool_count\n");
+	if (iobuf_pool_populate(&ch->large) != 0) {
+		SPDK_ERRLOG("Failed to populate iobuf large buffer cache. "
+			    "You may need to increase spdk_iobuf_opts.large_pool_count\n");
+		goto error;
+	}
+	for (i = 0; i < ch->num_classes; i++) {
+		if (iobuf_pool_populate(&ch->classes[i]) != 0) {
+			SPDK_ERRLOG("Failed to populate iobuf %" PRIu32 "B buffer cache. "
+				    "You may need to increase its pool_count in spdk_iobuf_opts.size_classes\n",
+				    ch->classes[i].bufsize);
 			goto error;
 		}
-		STAILQ_INSERT_TAIL(&ch->large.cache, buf, stailq);
-		ch->large.cache_count++;
 	}
 
 	return 0;
@@ -252,35 +794,86 @@ void
 spdk_iobuf_channel_fini(struct spdk_iobuf_channel *ch)
 {
 	struct spdk_iobuf_entry *entry __attribute__((unused));
-	struct spdk_iobuf_buffer *buf;
+	struct spdk_iobuf_pool *pool;
+	struct iobuf_channel *iobuf_ch;
+	int64_t growth;
+	uint32_t i;
 
-	/* Make sure none of the wait queue entries are coming from this module */
-	STAILQ_FOREACH(entry, ch->small.queue, stailq) {
-		assert(entry->module != ch->module);
-	}
-	STAILQ_FOREACH(entry, ch->large.queue, stailq) {
-		assert(entry->module != ch->module);
+	iobuf_ch = spdk_io_channel_get_ctx(ch->parent);
+	TAILQ_REMOVE(&iobuf_ch->channels, ch, tailq);
+
+	for (i = 0; i < iobuf_channel_num_pools(ch); i++) {
+		pool = iobuf_channel_pool(ch, i);
+
+		/* Make sure none of the wait queue entries are coming from this module */
+		STAILQ_FOREACH(entry, pool->queue, stailq) {
+			assert(entry->module != ch->module);
+		}
+
+		/* Release cached buffers back to the pool */
+		iobuf_pool_release_cache(pool, 0);
+		assert(STAILQ_EMPTY(&pool->cache));
+
+		/* Give back what the cache was rebalanced by */
+		growth = (int64_t)pool->cache_size - pool->init_cache_size;
+		__atomic_sub_fetch(&g_iobuf.cache_growth[i], growth, __ATOMIC_RELAXED);
+
+		spdk_histogram_data_free(pool->wait_histogram);
+		pool->wait_histogram = NULL;
 	}
 
-	/* Release cached buffers back to the pool */
-	while (!STAILQ_EMPTY(&ch->small.cache)) {
-		buf = STAILQ_FIRST(&ch->small.cache);
-		STAILQ_REMOVE_HEAD(&ch->small.cache, stailq);
-		spdk_mempool_put(ch->small.pool, buf);
-		ch->small.cache_count--;
+	spdk_put_io_channel(ch->parent);
+	ch->parent = NULL;
+}
+
+static void
+iobuf_pool_migrate(struct spdk_iobuf_pool *pool, struct spdk_mempool *mp)
+{
+	struct spdk_iobuf_buffer *buf, *old;
+	uint32_t i, count = pool->cache_count;
+
+	/* Get each new buffer before releasing an old one, so that the latter doesn't come
+	 * right back.  If the pool runs dry, the remaining old buffers are simply kept, unless
+	 * they belong to another node's pool, as the cache only holds buffers of its own pool. */
+	for (i = 0; i < count; i++) {
+		buf = spdk_mempool_get(mp);
+		if (buf == NULL && mp == pool->pool) {
+			break;
+		}
+
+		old = STAILQ_FIRST(&pool->cache);
+		STAILQ_REMOVE_HEAD(&pool->cache, stailq);
+		spdk_mempool_put(pool->pool, old);
+		if (buf != NULL) {
+			STAILQ_INSERT_TAIL(&pool->cache, buf, stailq);
+		} else {
+			pool->cache_count--;
+		}
 	}
-	while (!STAILQ_EMPTY(&ch->large.cache)) {
-		buf = STAILQ_FIRST(&ch->large.cache);
-		STAILQ_REMOVE_HEAD(&ch->large.cache, stailq);
-		spdk_mempool_put(ch->large.pool, buf);
-		ch->large.cache_count--;
+
+	pool->pool = mp;
+}
+
+void
+spdk_iobuf_channel_migrate(struct spdk_iobuf_channel *ch)
+{
+	struct iobuf_node *node;
+	uint32_t i;
+
+	assert(spdk_io_channel_get_thread(ch->parent) == spdk_get_thread());
+
+	if (iobuf_node_lazy_init() != 0) {
+		SPDK_WARNLOG("Couldn't create the iobuf pools of the local node, keeping the current "
+			     "ones\n");
+		return;
 	}
 
-	assert(ch->small.cache_count == 0);
-	assert(ch->large.cache_count == 0);
+	ch->node = iobuf_get_local_node();
+	node = &g_iobuf.nodes[ch->node];
 
-	spdk_put_io_channel(ch->parent);
-	ch->parent = NULL;
+	for (i = 0; i < iobuf_channel_num_pools(ch); i++) {
+		iobuf_pool_migrate(iobuf_channel_pool(ch, i), iobuf_node_pool(node, i));
+	}
 }
 
 int
@@ -315,8 +908,21 @@ spdk_iobuf_for_each_entry(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool
 			  spdk_iobuf_for_each_entry_fn cb_fn, void *cb_ctx)
 {
 	struct spdk_iobuf_entry *entry, *tmp;
+	uint32_t i;
 	int rc;
 
+	if (pool == NULL) {
+		for (i = 0; i < iobuf_channel_num_pools(ch); i++) {
+			rc = spdk_iobuf_for_each_entry(ch, iobuf_channel_pool(ch, i),
+						       cb_fn, cb_ctx);
+			if (rc != 0) {
+				return rc;
+			}
+		}
+
+		return 0;
+	}
+
 	STAILQ_FOREACH_SAFE(entry, pool->queue, stailq, tmp) {
 		/* We only want to iterate over the entries requested by the module which owns ch */
 		if (entry->module != ch->module) {
@@ -336,16 +942,59 @@ void
 spdk_iobuf_entry_abort(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *entry,
 		       uint64_t len)
 {
-	struct spdk_iobuf_pool *pool;
+	struct spdk_iobuf_pool *pool = iobuf_channel_get_pool(ch, len);
 
-	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		assert(len <= ch->large.bufsize);
-		pool = &ch->large;
+	STAILQ_REMOVE(pool->queue, entry, spdk_iobuf_entry, stailq);
+}
+
+static void
+iobuf_pool_alloc_wait_histogram(struct spdk_iobuf_pool *pool)
+{
+	pool->wait_histogram = spdk_histogram_data_alloc_sized(
+				       SPDK_IOBUF_WAIT_HISTOGRAM_BUCKET_SHIFT);
+}
+
+/* Once the local pool is exhausted, taking a buffer from another node is still cheaper than
+ * waiting for one to be released.  The other nodes are tried in order, starting after the
+ * local one. */
+static void *
+iobuf_get_remote(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool *pool)
+{
+	struct spdk_mempool *mp;
+	uint32_t i, node, idx;
+	void *buf;
+
+	if (spdk_likely(g_iobuf.num_nodes <= 1)) {
+		return NULL;
 	}
 
-	STAILQ_REMOVE(pool->queue, entry, spdk_iobuf_entry, stailq);
+	idx = iobuf_channel_pool_idx(ch, pool);
+	for (i = 1; i < SPDK_IOBUF_MAX_NUMA_NODES; i++) {
+		node = (ch->node + i) % SPDK_IOBUF_MAX_NUMA_NODES;
+		mp = iobuf_node_pool(&g_iobuf.nodes[node], idx);
+		if (mp == NULL) {
+			continue;
+		}
+
+		buf = spdk_mempool_get(mp);
+		if (buf != NULL) {
+			return buf;
+		}
+	}
+
+	return NULL;
+}
+
+/* Returns the mempool owning a buffer.  It's the channel's one, unless the buffer was taken from
+ * a remote node or the channel has been bound to another node since. */
+static inline struct spdk_mempool *
+iobuf_buffer_get_mempool(struct spdk_iobuf_pool *pool, void *buf)
+{
+	if (spdk_likely(g_iobuf.num_nodes <= 1)) {
+		return pool->pool;
+	}
+
+	return spdk_mempool_from_obj(buf);
 }
 
 void *
@@ -356,26 +1005,34 @@ spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len,
 	void *buf;
 
 	assert(spdk_io_channel_get_thread(ch->parent) == spdk_get_thread());
-	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		assert(len <= ch->large.bufsize);
-		pool = &ch->large;
-	}
+	pool = iobuf_channel_get_pool(ch, len);
 
 	buf = (void *)STAILQ_FIRST(&pool->cache);
 	if (buf) {
 		STAILQ_REMOVE_HEAD(&pool->cache, stailq);
 		assert(pool->cache_count > 0);
 		pool->cache_count--;
+		pool->stats.cache++;
 	} else {
 		buf = spdk_mempool_get(pool->pool);
-		if (!buf) {
-			STAILQ_INSERT_TAIL(pool->queue, entry, stailq);
-			entry->module = ch->module;
-			entry->cb_fn = cb_fn;
-
-			return NULL;
+		if (spdk_likely(buf != NULL)) {
+			pool->stats.main++;
+		} else {
+			buf = iobuf_get_remote(ch, pool);
+			if (!buf) {
+				STAILQ_INSERT_TAIL(pool->queue, entry, stailq);
+				entry->module = ch->module;
+				entry->cb_fn = cb_fn;
+				entry->pool = pool;
+				entry->wait_tsc = spdk_get_ticks();
+				pool->stats.retry++;
+				if (spdk_unlikely(pool->wait_histogram == NULL)) {
+					iobuf_pool_alloc_wait_histogram(pool);
+				}
+
+				return NULL;
+			}
+			pool->stats.remote++;
 		}
 	}
 
@@ -387,24 +1044,146 @@ spdk_iobuf_put(struct spdk_iobuf_channel *ch, void *buf, uint64_t len)
 {
 	struct spdk_iobuf_entry *entry;
 	struct spdk_iobuf_pool *pool;
+	struct spdk_mempool *mp;
 
 	assert(spdk_io_channel_get_thread(ch->parent) == spdk_get_thread());
-	if (len <= ch->small.bufsize) {
-		pool = &ch->small;
-	} else {
-		pool = &ch->large;
-	}
+	pool = iobuf_channel_get_pool(ch, len);
 
 	if (STAILQ_EMPTY(pool->queue)) {
-		if (pool->cache_count < pool->cache_size) {
+		/* Buffers of another node are never cached, they go right back to their pool */
+		mp = iobuf_buffer_get_mempool(pool, buf);
+		if (mp == pool->pool && pool->cache_count < pool->cache_size) {
 			STAILQ_INSERT_HEAD(&pool->cache, (struct spdk_iobuf_buffer *)buf, stailq);
 			pool->cache_count++;
 		} else {
-			spdk_mempool_put(pool->pool, buf);
+			spdk_mempool_put(mp, buf);
 		}
 	} else {
 		entry = STAILQ_FIRST(pool->queue);
 		STAILQ_REMOVE_HEAD(pool->queue, stailq);
+		/* The entry may be waiting on the channel of another module of this thread */
+		if (spdk_likely(entry->pool->wait_histogram != NULL)) {
+			spdk_histogram_data_tally(entry->pool->wait_histogram,
+						  spdk_get_ticks() - entry->wait_tsc);
+		}
 		entry->cb_fn(entry, buf);
 	}
 }
+
+struct iobuf_get_stats_ctx {
+	struct spdk_iobuf_module_stats	*modules;
+	uint32_t			num_modules;
+	spdk_iobuf_get_stats_cb		cb_fn;
+	void				*cb_arg;
+};
+
+static void
+iobuf_pool_stats_add(struct spdk_iobuf_module_stats *stats, struct spdk_iobuf_pool_stats *dst,
+		     struct spdk_iobuf_pool *pool)
+{
+	dst->cache += pool->stats.cache;
+	dst->main += pool->stats.main;
+	dst->retry += pool->stats.retry;
+	dst->remote += pool->stats.remote;
+
+	if (pool->wait_histogram == NULL) {
+		return;
+	}
+
+	if (stats->wait_histogram == NULL) {
+		stats->wait_histogram = spdk_histogram_data_alloc_sized(
+						SPDK_IOBUF_WAIT_HISTOGRAM_BUCKET_SHIFT);
+		if (stats->wait_histogram == NULL) {
+			return;
+		}
+	}
+
+	spdk_histogram_data_merge(stats->wait_histogram, pool->wait_histogram);
+}
+
+static void
+iobuf_get_channel_stats(struct spdk_io_channel_iter *iter)
+{
+	struct iobuf_get_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(iter);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(iter);
+	struct iobuf_channel *iobuf_ch = spdk_io_channel_get_ctx(ch);
+	struct spdk_iobuf_channel *channel;
+	const struct iobuf_module *module;
+	struct spdk_iobuf_module_stats *it;
+	uint32_t i, j;
+
+	TAILQ_FOREACH(channel, &iobuf_ch->channels, tailq) {
+		module = channel->module;
+		it = NULL;
+		for (i = 0; i < ctx->num_modules; i++) {
+			if (strcmp(ctx->modules[i].module, module->name) == 0) {
+				it = &ctx->modules[i];
+				break;
+			}
+		}
+
+		/* Skip the modules registered after the stats were requested */
+		if (it == NULL) {
+			continue;
+		}
+
+		iobuf_pool_stats_add(it, &it->small_pool, &channel->small);
+		iobuf_pool_stats_add(it, &it->large_pool, &channel->large);
+		for (j = 0; j < channel->num_classes; j++) {
+			iobuf_pool_stats_add(it, &it->class_pools[j], &channel->classes[j]);
+		}
+	}
+
+	spdk_for_each_channel_continue(iter, 0);
+}
+
+static void
+iobuf_get_channel_stats_done(struct spdk_io_channel_iter *iter, int status)
+{
+	struct iobuf_get_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(iter);
+	uint32_t i;
+
+	ctx->cb_fn(ctx->modules, ctx->num_modules, ctx->cb_arg);
+
+	for (i = 0; i < ctx->num_modules; i++) {
+		spdk_histogram_data_free(ctx->modules[i].wait_histogram);
+	}
+	free(ctx->modules);
+	free(ctx);
+}
+
+int
+spdk_iobuf_get_stats(spdk_iobuf_get_stats_cb cb_fn, void *cb_arg)
+{
+	struct iobuf_module *module;
+	struct iobuf_get_stats_ctx *ctx;
+	uint32_t i;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
+		ctx->num_modules++;
+	}
+
+	ctx->modules = calloc(ctx->num_modules, sizeof(struct spdk_iobuf_module_stats));
+	if (ctx->modules == NULL && ctx->num_modules > 0) {
+		free(ctx);
+		return -ENOMEM;
+	}
+
+	i = 0;
+	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
+		ctx->modules[i].module = module->name;
+		i++;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+
+	spdk_for_each_channel(&g_iobuf, iobuf_get_channel_stats, ctx,
+			      iobuf_get_channel_stats_done);
+	return 0;
+}
@@ -14,6 +14,7 @@
 #include "spdk/trace.h"
 #include "spdk/util.h"
 #include "spdk/fd_group.h"
+#include "spdk/histogram_data.h"
 
 #include "spdk/log.h"
 #include "spdk_internal/thread.h"
@@ -33,12 +34,37 @@
 #endif
 
 #define SPDK_MSG_BATCH_SIZE		8
+#define SPDK_STEALABLE_MSG_RING_SIZE	4096
 #define SPDK_MAX_DEVICE_NAME_LEN	256
 #define SPDK_THREAD_EXIT_TIMEOUT_SEC	5
 #define SPDK_MAX_POLLER_NAME_LEN	256
 #define SPDK_MAX_THREAD_NAME_LEN	256
+/* 16 buckets per power of two give a ~6% resolution at ~8KiB per poller. */
+#define SPDK_POLLER_HISTOGRAM_BUCKET_SHIFT	4
+
+/* 5 levels of 64 slots cover 2^30 units, i.e. ~18 minutes at a 1us resolution.
+ * Pollers with longer periods are requeued at the last level until they are due.
+ */
+#define TIMER_WHEEL_LEVEL_BITS	6
+#define TIMER_WHEEL_SLOTS	(1U << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_SLOT_MASK	(TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS	5
+#define TIMER_WHEEL_MAX_DELTA	((1ULL << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_LEVEL_BITS)) - 1)
+/* Slot of the timed pollers expiring in previous units, or in the current one. */
+#define TIMER_WHEEL_SLOT_EXPIRED	UINT16_MAX
+/* Slot of the expired pollers found not due yet in the current spdk_thread_poll(). */
+#define TIMER_WHEEL_SLOT_PENDING	(UINT16_MAX - 1)
 
 static struct spdk_thread *g_app_thread;
+static bool g_poller_histograms_enabled;
+static bool g_latency_histograms_enabled;
+/* Bumped on every enable, so that threads drop samples recorded before that. */
+static uint32_t g_latency_histograms_gen;
+static uint64_t g_adaptive_intr_idle_us;
+static uint64_t g_adaptive_intr_idle_ticks;
+static enum spdk_thread_timer_type g_timer_type;
+/* Resolution of the timer wheel as a power of two of ticks. */
+static uint32_t g_timer_wheel_shift;
 
 struct spdk_interrupt {
 	int			efd;
@@ -88,9 +114,29 @@ struct spdk_poller {
 	spdk_poller_set_interrupt_mode_cb set_intr_cb_fn;
 	void				*set_intr_cb_arg;
 
+	/* Distribution of the ticks spent in fn, only kept when enabled. */
+	struct spdk_histogram_data	*histogram;
+
+	/* Timer wheel slot of a timed poller, queued by tailq. */
+	uint16_t			timer_slot;
+
 	char				name[SPDK_MAX_POLLER_NAME_LEN + 1];
 };
 
+TAILQ_HEAD(timer_wheel_slot, spdk_poller);
+
+struct timer_wheel {
+	/* Next unit to be processed. All earlier units were already expired. */
+	uint64_t			next_unit;
+	/* Number of pollers queued, including the expired ones. */
+	uint64_t			count;
+	/* Non-empty slots of each level. */
+	uint64_t			bitmap[TIMER_WHEEL_LEVELS];
+	struct timer_wheel_slot		slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	struct timer_wheel_slot		expired;
+	struct timer_wheel_slot		pending;
+};
+
 enum spdk_thread_state {
 	/* The thread is processing poller and message by spdk_thread_poll(). */
 	SPDK_THREAD_STATE_RUNNING,
@@ -119,6 +165,8 @@ struct spdk_thread {
 	 */
 	RB_HEAD(timed_pollers_tree, spdk_poller)	timed_pollers;
 	struct spdk_poller				*first_timed_poller;
+	/* Replaces timed_pollers if the library was initialized with SPDK_THREAD_TIMER_WHEEL. */
+	struct timer_wheel				*timer_wheel;
 	/*
 	 * Contains paused pollers.  Pollers on this queue are waiting until
 	 * they are resumed (in which case they're put onto the active/timer
@@ -126,6 +174,11 @@ struct spdk_thread {
 	 */
 	TAILQ_HEAD(paused_pollers_head, spdk_poller)	paused_pollers;
 	struct spdk_ring		*messages;
+	/*
+	 * Messages which may be executed by any spdk_thread.  Idle threads sharing
+	 *  a reactor with this one can steal them via spdk_thread_steal_msgs().
+	 */
+	struct spdk_ring		*stealable_messages;
 	int				msg_fd;
 	SLIST_HEAD(, spdk_msg)		msg_cache;
 	size_t				msg_cache_count;
@@ -146,6 +199,14 @@ struct spdk_thread {
 
 	/* Indicates whether this spdk_thread currently runs in interrupt. */
 	bool				in_interrupt;
+	/* Indicates whether the thread switched itself into interrupt after idling. */
+	bool				adaptive_intr;
+	uint64_t			last_busy_tsc;
+	struct spdk_thread_intr_stats	intr_stats;
+	struct spdk_histogram_data	*latency_histogram;
+	uint32_t			latency_histogram_gen;
+	/* NUMA socket of the core the thread was last placed on. */
+	int32_t				run_socket_id;
 	bool				poller_unregistered;
 	struct spdk_fd_group		*fgrp;
 
@@ -240,9 +301,11 @@ struct io_device {
 	spdk_io_channel_create_cb	create_cb;
 	spdk_io_channel_destroy_cb	destroy_cb;
 	spdk_io_device_unregister_cb	unregister_cb;
+	spdk_io_channel_migrate_cb	migrate_cb;
 	struct spdk_thread		*unregister_thread;
 	uint32_t			ctx_size;
 	uint32_t			for_each_count;
+	int32_t				socket_id;
 	RB_ENTRY(io_device)		node;
 
 	uint32_t			refcnt;
@@ -319,6 +382,290 @@ timed_poller_compare(struct spdk_poller *poller1, struct spdk_poller *poller2)
 
 RB_GENERATE_STATIC(timed_pollers_tree, spdk_poller, node, timed_poller_compare);
 
+static struct timer_wheel *
+timer_wheel_alloc(void)
+{
+	struct timer_wheel *wheel;
+	uint32_t level, slot;
+
+	wheel = calloc(1, sizeof(*wheel));
+	if (wheel == NULL) {
+		return NULL;
+	}
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		for (slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+			TAILQ_INIT(&wheel->slots[level][slot]);
+		}
+	}
+	TAILQ_INIT(&wheel->expired);
+	TAILQ_INIT(&wheel->pending);
+	wheel->next_unit = spdk_get_ticks() >> g_timer_wheel_shift;
+
+	return wheel;
+}
+
+/*
+ * Slots of each level are indexed by the digits of the expiration unit, like in
+ * Linux's timer wheel. A poller is queued at the level matching its distance to
+ * the next unit, and moved to lower levels (cascaded) when the lower digits of
+ * the next unit wrap around to its slot.
+ */
+static void
+timer_wheel_insert(struct timer_wheel *wheel, struct spdk_poller *poller)
+{
+	uint64_t expire, delta;
+	uint32_t level, slot;
+
+	wheel->count++;
+
+	expire = poller->next_run_tick >> g_timer_wheel_shift;
+	if (expire < wheel->next_unit) {
+		TAILQ_INSERT_TAIL(&wheel->expired, poller, tailq);
+		poller->timer_slot = TIMER_WHEEL_SLOT_EXPIRED;
+		return;
+	}
+
+	delta = expire - wheel->next_unit;
+	if (spdk_unlikely(delta > TIMER_WHEEL_MAX_DELTA)) {
+		/* The poller is checked against its next_run_tick and requeued when it expires. */
+		delta = TIMER_WHEEL_MAX_DELTA;
+		expire = wheel->next_unit + delta;
+	}
+
+	level = delta == 0 ? 0 : (63 - __builtin_clzll(delta)) / TIMER_WHEEL_LEVEL_BITS;
+	slot = (expire >> (level * TIMER_WHEEL_LEVEL_BITS)) & TIMER_WHEEL_SLOT_MASK;
+
+	TAILQ_INSERT_TAIL(&wheel->slots[level][slot], poller, tailq);
+	wheel->bitmap[level] |= 1ULL << slot;
+	poller->timer_slot = level * TIMER_WHEEL_SLOTS + slot;
+}
+
+static void
+timer_wheel_remove(struct timer_wheel *wheel, struct spdk_poller *poller)
+{
+	struct timer_wheel_slot *head;
+	uint32_t level, slot;
+
+	assert(wheel->count > 0);
+	wheel->count--;
+
+	if (poller->timer_slot == TIMER_WHEEL_SLOT_EXPIRED) {
+		TAILQ_REMOVE(&wheel->expired, poller, tailq);
+		return;
+	} else if (poller->timer_slot == TIMER_WHEEL_SLOT_PENDING) {
+		TAILQ_REMOVE(&wheel->pending, poller, tailq);
+		return;
+	}
+
+	level = poller->timer_slot / TIMER_WHEEL_SLOTS;
+	slot = poller->timer_slot % TIMER_WHEEL_SLOTS;
+	head = &wheel->slots[level][slot];
+
+	TAILQ_REMOVE(head, poller, tailq);
+	if (TAILQ_EMPTY(head)) {
+		wheel->bitmap[level] &= ~(1ULL << slot);
+	}
+}
+
+/* Find the next non-empty slot of a level and the unit it is processed at. */
+static int
+timer_wheel_next_slot(struct timer_wheel *wheel, uint32_t level, uint64_t *unit)
+{
+	uint64_t bits = wheel->bitmap[level], base;
+	uint32_t shift = level * TIMER_WHEEL_LEVEL_BITS, index, slot;
+
+	if (bits == 0) {
+		return -1;
+	}
+
+	index = (wheel->next_unit >> shift) & TIMER_WHEEL_SLOT_MASK;
+	/* The current slot of an upper level was already cascaded, unless all the lower
+	 * digits of the next unit are 0.
+	 */
+	if (level > 0 && (wheel->next_unit & ((1ULL << shift) - 1)) != 0) {
+		index++;
+	}
+
+	base = wheel->next_unit & ~((1ULL << (shift + TIMER_WHEEL_LEVEL_BITS)) - 1);
+	if (index < TIMER_WHEEL_SLOTS && (bits >> index) != 0) {
+		slot = __builtin_ctzll(bits >> index) + index;
+	} else {
+		/* Only slots of the next lap are left. */
+		slot = __builtin_ctzll(bits);
+		base += 1ULL << (shift + TIMER_WHEEL_LEVEL_BITS);
+	}
+
+	*unit = base + ((uint64_t)slot << shift);
+
+	return slot;
+}
+
+static void
+timer_wheel_cascade(struct timer_wheel *wheel, uint32_t level, uint32_t slot)
+{
+	struct timer_wheel_slot *head = &wheel->slots[level][slot];
+	struct spdk_poller *poller;
+
+	while ((poller = TAILQ_FIRST(head)) != NULL) {
+		timer_wheel_remove(wheel, poller);
+		timer_wheel_insert(wheel, poller);
+	}
+}
+
+/* Move the pollers expiring up to now_unit to the expired list. */
+static void
+timer_wheel_advance(struct timer_wheel *wheel, uint64_t now_unit)
+{
+	struct spdk_poller *poller;
+	uint64_t unit, next, slot_unit;
+	uint32_t level, slot, shift;
+
+	while (wheel->next_unit <= now_unit) {
+		/* Jump over the units without anything to cascade or expire. */
+		next = UINT64_MAX;
+		for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+			if (timer_wheel_next_slot(wheel, level, &slot_unit) >= 0) {
+				next = spdk_min(next, slot_unit);
+			}
+		}
+		if (next > now_unit) {
+			wheel->next_unit = now_unit + 1;
+			break;
+		}
+
+		unit = wheel->next_unit = next;
+
+		for (level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+			shift = level * TIMER_WHEEL_LEVEL_BITS;
+			if ((unit & ((1ULL << shift) - 1)) == 0) {
+				slot = (unit >> shift) & TIMER_WHEEL_SLOT_MASK;
+				timer_wheel_cascade(wheel, level, slot);
+			}
+		}
+
+		slot = unit & TIMER_WHEEL_SLOT_MASK;
+		TAILQ_FOREACH(poller, &wheel->slots[0][slot], tailq) {
+			poller->timer_slot = TIMER_WHEEL_SLOT_EXPIRED;
+		}
+		TAILQ_CONCAT(&wheel->expired, &wheel->slots[0][slot], tailq);
+		wheel->bitmap[0] &= ~(1ULL << slot);
+
+		wheel->next_unit = unit + 1;
+	}
+}
+
+static uint64_t
+timer_wheel_next_expiration(struct timer_wheel *wheel)
+{
+	struct spdk_poller *poller;
+	uint64_t next = UINT64_MAX, unit;
+	uint32_t level;
+	int slot;
+
+	TAILQ_FOREACH(poller, &wheel->expired, tailq) {
+		next = spdk_min(next, poller->next_run_tick);
+	}
+	TAILQ_FOREACH(poller, &wheel->pending, tailq) {
+		next = spdk_min(next, poller->next_run_tick);
+	}
+
+	/* Slots of a level hold consecutive ranges of time, so the earliest poller of
+	 * each level is in its next non-empty slot.
+	 */
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		slot = timer_wheel_next_slot(wheel, level, &unit);
+		if (slot < 0) {
+			continue;
+		}
+		TAILQ_FOREACH(poller, &wheel->slots[level][slot], tailq) {
+			next = spdk_min(next, poller->next_run_tick);
+		}
+	}
+
+	return next == UINT64_MAX ? 0 : next;
+}
+
+/* Iterate over the expired and pending pollers first, then over the slots in storage order. */
+static struct spdk_poller *
+timer_wheel_first(struct timer_wheel *wheel, uint32_t slot)
+{
+	struct spdk_poller *poller;
+	uint32_t level;
+
+	for (; slot < TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; slot++) {
+		level = slot / TIMER_WHEEL_SLOTS;
+		poller = TAILQ_FIRST(&wheel->slots[level][slot % TIMER_WHEEL_SLOTS]);
+		if (poller != NULL) {
+			return poller;
+		}
+	}
+
+	return NULL;
+}
+
+static struct spdk_poller *
+thread_first_timed_poller(struct spdk_thread *thread)
+{
+	struct spdk_poller *poller;
+
+	if (thread->timer_wheel == NULL) {
+		return RB_MIN(timed_pollers_tree, &thread->timed_pollers);
+	}
+
+	poller = TAILQ_FIRST(&thread->timer_wheel->expired);
+	if (poller == NULL) {
+		poller = TAILQ_FIRST(&thread->timer_wheel->pending);
+	}
+	if (poller != NULL) {
+		return poller;
+	}
+
+	return timer_wheel_first(thread->timer_wheel, 0);
+}
+
+static struct spdk_poller *
+thread_next_timed_poller(struct spdk_thread *thread, struct spdk_poller *prev)
+{
+	struct spdk_poller *poller;
+
+	if (thread->timer_wheel == NULL) {
+		return RB_NEXT(timed_pollers_tree, &thread->timed_pollers, prev);
+	}
+
+	poller = TAILQ_NEXT(prev, tailq);
+	if (poller != NULL) {
+		return poller;
+	}
+
+	if (prev->timer_slot == TIMER_WHEEL_SLOT_EXPIRED) {
+		poller = TAILQ_FIRST(&thread->timer_wheel->pending);
+		if (poller != NULL) {
+			return poller;
+		}
+	}
+	if (prev->timer_slot >= TIMER_WHEEL_SLOT_PENDING) {
+		return timer_wheel_first(thread->timer_wheel, 0);
+	}
+
+	return timer_wheel_first(thread->timer_wheel, prev->timer_slot + 1);
+}
+
+#define THREAD_TIMED_POLLER_FOREACH_SAFE(poller, thread, tmp)			\
+	for ((poller) = thread_first_timed_poller(thread);			\
+	     (poller) != NULL && ((tmp) = thread_next_timed_poller(thread, poller), 1);	\
+	     (poller) = (tmp))
+
+static bool
+thread_has_timed_pollers(struct spdk_thread *thread)
+{
+	if (thread->timer_wheel != NULL) {
+		return thread->timer_wheel->count > 0;
+	}
+
+	return !RB_EMPTY(&thread->timed_pollers);
+}
+
 static inline struct spdk_thread *
 _get_thread(void)
 {
@@ -329,6 +676,15 @@ static int
 _thread_lib_init(size_t ctx_sz, size_t msg_mempool_sz)
 {
 	char mempool_name[SPDK_MAX_MEMZONE_NAME_LEN];
+	uint64_t ticks_per_us;
+
+	if (g_timer_type == SPDK_THREAD_TIMER_WHEEL) {
+		ticks_per_us = spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+		g_timer_wheel_shift = 0;
+		while ((1ULL << g_timer_wheel_shift) < ticks_per_us) {
+			g_timer_wheel_shift++;
+		}
+	}
 
 	g_ctx_sz = ctx_sz;
 
@@ -351,6 +707,14 @@ _thread_lib_init(size_t ctx_sz, size_t msg_mempool_sz)
 
 static void thread_interrupt_destroy(struct spdk_thread *thread);
 static int thread_interrupt_create(struct spdk_thread *thread);
+static void poller_remove_timer(struct spdk_thread *thread, struct spdk_poller *poller);
+
+static void
+poller_free(struct spdk_poller *poller)
+{
+	spdk_histogram_data_free(poller->histogram);
+	free(poller);
+}
 
 static void
 _free_thread(struct spdk_thread *thread)
@@ -370,22 +734,22 @@ _free_thread(struct spdk_thread *thread)
 				     poller->name);
 		}
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-		free(poller);
+		poller_free(poller);
 	}
 
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, ptmp) {
+	THREAD_TIMED_POLLER_FOREACH_SAFE(poller, thread, ptmp) {
 		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
 			SPDK_WARNLOG("timed_poller %s still registered at thread exit\n",
 				     poller->name);
 		}
-		RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
-		free(poller);
+		poller_remove_timer(thread, poller);
+		poller_free(poller);
 	}
 
 	TAILQ_FOREACH_SAFE(poller, &thread->paused_pollers, tailq, ptmp) {
 		SPDK_WARNLOG("paused_poller %s still registered at thread exit\n", poller->name);
 		TAILQ_REMOVE(&thread->paused_pollers, poller, tailq);
-		free(poller);
+		poller_free(poller);
 	}
 
 	pthread_mutex_lock(&g_devlist_mutex);
@@ -412,6 +776,9 @@ _free_thread(struct spdk_thread *thread)
 	}
 
 	spdk_ring_free(thread->messages);
+	spdk_ring_free(thread->stealable_messages);
+	free(thread->timer_wheel);
+	spdk_histogram_data_free(thread->latency_histogram);
 	free(thread);
 }
 
@@ -454,6 +821,25 @@ spdk_thread_lib_init_ext(spdk_thread_op_fn thread_op_fn,
 	return _thread_lib_init(ctx_sz, msg_mempool_sz);
 }
 
+int
+spdk_thread_lib_set_timer_type(enum spdk_thread_timer_type timer_type)
+{
+	if (g_spdk_msg_mempool != NULL) {
+		SPDK_ERRLOG("The timer type can't be changed once the library is initialized\n");
+		return -EBUSY;
+	}
+
+	switch (timer_type) {
+	case SPDK_THREAD_TIMER_RBTREE:
+	case SPDK_THREAD_TIMER_WHEEL:
+		g_timer_type = timer_type;
+		return 0;
+	default:
+		SPDK_ERRLOG("Unknown timer type %d\n", timer_type);
+		return -EINVAL;
+	}
+}
+
 void
 spdk_thread_lib_fini(void)
 {
@@ -467,6 +853,7 @@ spdk_thread_lib_fini(void)
 	g_thread_op_fn = NULL;
 	g_thread_op_supported_fn = NULL;
 	g_ctx_sz = 0;
+	g_timer_type = SPDK_THREAD_TIMER_RBTREE;
 	if (g_app_thread != NULL) {
 		_free_thread(g_app_thread);
 		g_app_thread = NULL;
@@ -505,6 +892,7 @@ spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 	thread->msg_cache_count = 0;
 
 	thread->tsc_last = spdk_get_ticks();
+	thread->run_socket_id = SPDK_ENV_SOCKET_ID_ANY;
 
 	/* Monotonic increasing ID is set to each created poller beginning at 1. Once the
 	 * ID exceeds UINT64_MAX a warning message is logged
@@ -518,6 +906,27 @@ spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 		return NULL;
 	}
 
+	thread->stealable_messages = spdk_ring_create(SPDK_RING_TYPE_MP_MC,
+				     SPDK_STEALABLE_MSG_RING_SIZE,
+				     SPDK_ENV_SOCKET_ID_ANY);
+	if (!thread->stealable_messages) {
+		SPDK_ERRLOG("Unable to allocate memory for stealable message ring\n");
+		spdk_ring_free(thread->messages);
+		free(thread);
+		return NULL;
+	}
+
+	if (g_timer_type == SPDK_THREAD_TIMER_WHEEL) {
+		thread->timer_wheel = timer_wheel_alloc();
+		if (!thread->timer_wheel) {
+			SPDK_ERRLOG("Unable to allocate memory for timer wheel\n");
+			spdk_ring_free(thread->stealable_messages);
+			spdk_ring_free(thread->messages);
+			free(thread);
+			return NULL;
+		}
+	}
+
 	/* Fill the local message pool cache. */
 	rc = spdk_mempool_get_bulk(g_spdk_msg_mempool, (void **)msgs, SPDK_MSG_MEMPOOL_CACHE_SIZE);
 	if (rc == 0) {
@@ -598,7 +1007,7 @@ spdk_set_thread(struct spdk_thread *thread)
 static void
 thread_exit(struct spdk_thread *thread, uint64_t now)
 {
-	struct spdk_poller *poller;
+	struct spdk_poller *poller, *ptmp;
 	struct spdk_io_channel *ch;
 
 	if (now >= thread->exit_timeout_tsc) {
@@ -607,7 +1016,8 @@ thread_exit(struct spdk_thread *thread, uint64_t now)
 		goto exited;
 	}
 
-	if (spdk_ring_count(thread->messages) > 0) {
+	if (spdk_ring_count(thread->messages) > 0 ||
+	    spdk_ring_count(thread->stealable_messages) > 0) {
 		SPDK_INFOLOG(thread, "thread %s still has messages\n", thread->name);
 		return;
 	}
@@ -621,7 +1031,7 @@ thread_exit(struct spdk_thread *thread, uint64_t now)
 		}
 	}
 
-	RB_FOREACH(poller, timed_pollers_tree, &thread->timed_pollers) {
+	THREAD_TIMED_POLLER_FOREACH_SAFE(poller, thread, ptmp) {
 		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
 			SPDK_INFOLOG(thread,
 				     "thread %s still has active timed poller %s\n",
@@ -731,6 +1141,80 @@ spdk_thread_get_cpumask(struct spdk_thread *thread)
 	return &thread->cpumask;
 }
 
+/* Only sockets below this ID are considered when picking a thread's home socket. */
+#define THREAD_MAX_SOCKETS	64
+
+int32_t
+spdk_thread_get_socket_id(struct spdk_thread *thread)
+{
+	struct spdk_io_channel *ch;
+	uint32_t counts[THREAD_MAX_SOCKETS] = {};
+	uint32_t max_count = 0;
+	int32_t socket_id, home_socket_id = SPDK_ENV_SOCKET_ID_ANY;
+
+	/* The home socket is the one most of the thread's I/O channels are local to. */
+	RB_FOREACH(ch, io_channel_tree, &thread->io_channels) {
+		socket_id = ch->dev->socket_id;
+		if (socket_id < 0 || socket_id >= THREAD_MAX_SOCKETS) {
+			continue;
+		}
+
+		counts[socket_id]++;
+		if (counts[socket_id] > max_count) {
+			max_count = counts[socket_id];
+			home_socket_id = socket_id;
+		}
+	}
+
+	return home_socket_id;
+}
+
+static void
+thread_migrate_channels(void *ctx)
+{
+	struct spdk_thread *thread = spdk_get_thread();
+	struct spdk_io_channel *ch, *tmp;
+	uint32_t core = spdk_env_get_current_core();
+	int32_t socket_id, prev_socket_id = thread->run_socket_id;
+
+	/* The thread may have moved again since it was notified, so look at where it runs now. */
+	if (core == SPDK_ENV_LCORE_ID_ANY) {
+		return;
+	}
+
+	socket_id = spdk_env_get_socket_id(core);
+	if (prev_socket_id == socket_id) {
+		return;
+	}
+	thread->run_socket_id = socket_id;
+
+	SPDK_DEBUGLOG(thread, "Thread %s moved from socket %d to %d\n", thread->name,
+		      prev_socket_id, socket_id);
+
+	RB_FOREACH_SAFE(ch, io_channel_tree, &thread->io_channels, tmp) {
+		if (ch->dev->migrate_cb != NULL && ch->destroy_ref == 0 && !ch->dev->unregistered) {
+			ch->dev->migrate_cb(ch->dev->io_device, spdk_io_channel_get_ctx(ch));
+		}
+	}
+}
+
+int
+spdk_thread_notify_migration(struct spdk_thread *thread, int32_t socket_id)
+{
+	if (thread->run_socket_id == SPDK_ENV_SOCKET_ID_ANY) {
+		/* First placement of the thread, its channels are already local. */
+		thread->run_socket_id = socket_id;
+		return 0;
+	}
+
+	if (thread->run_socket_id == socket_id) {
+		return 0;
+	}
+
+	/* The channels are re-homed by the thread itself, once it runs on the new core. */
+	return spdk_thread_send_msg(thread, thread_migrate_channels, NULL);
+}
+
 int
 spdk_thread_set_cpumask(struct spdk_cpuset *cpumask)
 {
@@ -773,10 +1257,37 @@ spdk_thread_get_from_ctx(void *ctx)
 	return SPDK_CONTAINEROF(ctx, struct spdk_thread, ctx);
 }
 
+static inline void
+msg_queue_exec(struct spdk_thread *thread, void **messages, unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		struct spdk_msg *msg = messages[i];
+
+		assert(msg != NULL);
+
+		SPDK_DTRACE_PROBE2(msg_exec, msg->fn, msg->arg);
+
+		msg->fn(msg->arg);
+
+		SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
+
+		if (thread->msg_cache_count < SPDK_MSG_MEMPOOL_CACHE_SIZE) {
+			/* Insert the messages at the head. We want to re-use the hot
+			 * ones. */
+			SLIST_INSERT_HEAD(&thread->msg_cache, msg, link);
+			thread->msg_cache_count++;
+		} else {
+			spdk_mempool_put(g_spdk_msg_mempool, msg);
+		}
+	}
+}
+
 static inline uint32_t
 msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 {
-	unsigned count, i;
+	unsigned count;
 	void *messages[SPDK_MSG_BATCH_SIZE];
 	uint64_t notify = 1;
 	int rc;
@@ -797,8 +1308,14 @@ msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 	}
 
 	count = spdk_ring_dequeue(thread->messages, messages, max_msgs);
+	/* Use whatever is left of the batch for messages nobody has stolen yet. */
+	if (count < max_msgs) {
+		count += spdk_ring_dequeue(thread->stealable_messages, &messages[count],
+					   max_msgs - count);
+	}
 	if (spdk_unlikely(thread->in_interrupt) &&
-	    spdk_ring_count(thread->messages) != 0) {
+	    (spdk_ring_count(thread->messages) != 0 ||
+	     spdk_ring_count(thread->stealable_messages) != 0)) {
 		rc = write(thread->msg_fd, &notify, sizeof(notify));
 		if (rc < 0) {
 			SPDK_ERRLOG("failed to notify msg_queue: %s.\n", spdk_strerror(errno));
@@ -808,26 +1325,7 @@ msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 		return 0;
 	}
 
-	for (i = 0; i < count; i++) {
-		struct spdk_msg *msg = messages[i];
-
-		assert(msg != NULL);
-
-		SPDK_DTRACE_PROBE2(msg_exec, msg->fn, msg->arg);
-
-		msg->fn(msg->arg);
-
-		SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
-
-		if (thread->msg_cache_count < SPDK_MSG_MEMPOOL_CACHE_SIZE) {
-			/* Insert the messages at the head. We want to re-use the hot
-			 * ones. */
-			SLIST_INSERT_HEAD(&thread->msg_cache, msg, link);
-			thread->msg_cache_count++;
-		} else {
-			spdk_mempool_put(g_spdk_msg_mempool, msg);
-		}
-	}
+	msg_queue_exec(thread, messages, count);
 
 	return count;
 }
@@ -839,6 +1337,11 @@ poller_insert_timer(struct spdk_thread *thread, struct spdk_poller *poller, uint
 
 	poller->next_run_tick = now + poller->period_ticks;
 
+	if (thread->timer_wheel != NULL) {
+		timer_wheel_insert(thread->timer_wheel, poller);
+		return;
+	}
+
 	/*
 	 * Insert poller in the thread's timed_pollers tree by next scheduled run time
 	 * as its key.
@@ -861,6 +1364,11 @@ poller_remove_timer(struct spdk_thread *thread, struct spdk_poller *poller)
 {
 	struct spdk_poller *tmp __attribute__((unused));
 
+	if (thread->timer_wheel != NULL) {
+		timer_wheel_remove(thread->timer_wheel, poller);
+		return;
+	}
+
 	tmp = RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
 	assert(tmp != NULL);
 
@@ -897,6 +1405,40 @@ thread_update_stats(struct spdk_thread *thread, uint64_t end,
 	thread->tsc_last = end;
 }
 
+static inline void
+poller_update_histogram(struct spdk_poller *poller)
+{
+	if (g_poller_histograms_enabled) {
+		/* If this fails, the poller just isn't accounted for until the next try. */
+		poller->histogram =
+			spdk_histogram_data_alloc_sized(SPDK_POLLER_HISTOGRAM_BUCKET_SHIFT);
+	} else {
+		spdk_histogram_data_free(poller->histogram);
+		poller->histogram = NULL;
+	}
+}
+
+static inline int
+poller_run(struct spdk_poller *poller)
+{
+	uint64_t start;
+	int rc;
+
+	if (spdk_unlikely(g_poller_histograms_enabled != (poller->histogram != NULL))) {
+		poller_update_histogram(poller);
+	}
+
+	if (spdk_likely(poller->histogram == NULL)) {
+		return poller->fn(poller->arg);
+	}
+
+	start = spdk_get_ticks();
+	rc = poller->fn(poller->arg);
+	spdk_histogram_data_tally(poller->histogram, spdk_get_ticks() - start);
+
+	return rc;
+}
+
 static inline int
 thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 {
@@ -905,7 +1447,7 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-		free(poller);
+		poller_free(poller);
 		return 0;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
@@ -920,7 +1462,7 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 	}
 
 	poller->state = SPDK_POLLER_STATE_RUNNING;
-	rc = poller->fn(poller->arg);
+	rc = poller_run(poller);
 
 	SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
 
@@ -938,7 +1480,7 @@ thread_execute_poller(struct spdk_thread *thread, struct spdk_poller *poller)
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-		free(poller);
+		poller_free(poller);
 		break;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
@@ -967,7 +1509,7 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
-		free(poller);
+		poller_free(poller);
 		return 0;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_INSERT_TAIL(&thread->paused_pollers, poller, tailq);
@@ -981,7 +1523,7 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 	}
 
 	poller->state = SPDK_POLLER_STATE_RUNNING;
-	rc = poller->fn(poller->arg);
+	rc = poller_run(poller);
 
 	SPIN_ASSERT(thread->lock_count == 0, SPIN_ERR_HOLD_DURING_SWITCH);
 
@@ -998,7 +1540,7 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 
 	switch (poller->state) {
 	case SPDK_POLLER_STATE_UNREGISTERED:
-		free(poller);
+		poller_free(poller);
 		break;
 	case SPDK_POLLER_STATE_PAUSING:
 		TAILQ_INSERT_TAIL(&thread->paused_pollers, poller, tailq);
@@ -1020,13 +1562,56 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 	return rc;
 }
 
+static int
+thread_run_timer_wheel(struct spdk_thread *thread, uint64_t now)
+{
+	struct timer_wheel *wheel = thread->timer_wheel;
+	struct spdk_poller *poller;
+	uint64_t now_unit = now >> g_timer_wheel_shift;
+	int rc = 0, timer_rc;
+
+	timer_wheel_advance(wheel, now_unit);
+
+	/* Pollers may be removed from the expired list while others are running, so
+	 * always take the first one.
+	 */
+	while ((poller = TAILQ_FIRST(&wheel->expired)) != NULL) {
+		if (now < poller->next_run_tick) {
+			TAILQ_REMOVE(&wheel->expired, poller, tailq);
+			if (spdk_likely(poller->next_run_tick >> g_timer_wheel_shift <= now_unit)) {
+				/* Due later in the current unit, check again at the next poll. */
+				TAILQ_INSERT_TAIL(&wheel->pending, poller, tailq);
+				poller->timer_slot = TIMER_WHEEL_SLOT_PENDING;
+			} else {
+				/* Too far to be queued at once, see TIMER_WHEEL_MAX_DELTA. */
+				wheel->count--;
+				timer_wheel_insert(wheel, poller);
+			}
+			continue;
+		}
+
+		timer_wheel_remove(wheel, poller);
+		timer_rc = thread_execute_timed_poller(thread, poller, now);
+		if (timer_rc > rc) {
+			rc = timer_rc;
+		}
+	}
+
+	TAILQ_FOREACH(poller, &wheel->pending, tailq) {
+		poller->timer_slot = TIMER_WHEEL_SLOT_EXPIRED;
+	}
+	TAILQ_CONCAT(&wheel->expired, &wheel->pending, tailq);
+
+	return rc;
+}
+
 static int
 thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 {
 	uint32_t msg_count;
 	struct spdk_poller *poller, *tmp;
 	spdk_msg_fn critical_msg;
-	int rc = 0;
+	int rc = 0, timer_rc;
 
 	thread->tsc_last = now;
 
@@ -1052,6 +1637,11 @@ thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 		}
 	}
 
+	if (thread->timer_wheel != NULL) {
+		timer_rc = thread_run_timer_wheel(thread, now);
+		return spdk_max(rc, timer_rc);
+	}
+
 	poller = thread->first_timed_poller;
 	while (poller != NULL) {
 		int timer_rc = 0;
@@ -1092,28 +1682,75 @@ _thread_remove_pollers(void *ctx)
 				   active_pollers_head, tailq, tmp) {
 		if (poller->state == SPDK_POLLER_STATE_UNREGISTERED) {
 			TAILQ_REMOVE(&thread->active_pollers, poller, tailq);
-			free(poller);
+			poller_free(poller);
 		}
 	}
 
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, tmp) {
+	THREAD_TIMED_POLLER_FOREACH_SAFE(poller, thread, tmp) {
 		if (poller->state == SPDK_POLLER_STATE_UNREGISTERED) {
 			poller_remove_timer(thread, poller);
-			free(poller);
+			poller_free(poller);
 		}
 	}
 
-	thread->poller_unregistered = false;
+	thread->poller_unregistered = false;
+}
+
+static void
+_thread_exit(void *ctx)
+{
+	struct spdk_thread *thread = ctx;
+
+	assert(thread->state == SPDK_THREAD_STATE_EXITING);
+
+	thread_exit(thread, spdk_get_ticks());
+}
+
+static void thread_set_interrupt_mode(struct spdk_thread *thread, bool enable_interrupt);
+
+static void
+thread_adaptive_intr_switch(struct spdk_thread *thread, bool enable_interrupt)
+{
+	struct spdk_thread_intr_stats *stats = &thread->intr_stats;
+	uint64_t start, ticks;
+
+	start = spdk_get_ticks();
+	thread_set_interrupt_mode(thread, enable_interrupt);
+	thread->adaptive_intr = enable_interrupt;
+	ticks = spdk_get_ticks() - start;
+
+	if (enable_interrupt) {
+		stats->to_intr_count++;
+	} else {
+		stats->to_poll_count++;
+	}
+	stats->transition_tsc += ticks;
+	stats->max_transition_tsc = spdk_max(stats->max_transition_tsc, ticks);
 }
 
-static void
-_thread_exit(void *ctx)
+static int
+thread_adaptive_intr_check(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now, int rc)
 {
-	struct spdk_thread *thread = ctx;
+	if (thread->in_interrupt) {
+		/* The thread was explicitly set into interrupt mode during the poll. */
+		return rc;
+	}
 
-	assert(thread->state == SPDK_THREAD_STATE_EXITING);
+	if (rc != 0 || thread->last_busy_tsc == 0) {
+		thread->last_busy_tsc = now;
+		return rc;
+	}
 
-	thread_exit(thread, spdk_get_ticks());
+	if (now - thread->last_busy_tsc < g_adaptive_intr_idle_ticks ||
+	    thread->state != SPDK_THREAD_STATE_RUNNING) {
+		return rc;
+	}
+
+	thread_adaptive_intr_switch(thread, true);
+
+	/* Poll one more time in case a msg was received without notification
+	 * during the transition. */
+	return thread_poll(thread, max_msgs, now);
 }
 
 int
@@ -1142,9 +1779,16 @@ spdk_thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 		if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITING)) {
 			thread_exit(thread, now);
 		}
+		if (spdk_unlikely(g_adaptive_intr_idle_ticks != 0)) {
+			rc = thread_adaptive_intr_check(thread, max_msgs, now, rc);
+		}
 	} else {
 		/* Non-block wait on thread's fd_group */
 		rc = spdk_fd_group_wait(thread->fgrp, 0);
+		if (spdk_unlikely(thread->adaptive_intr) && rc > 0) {
+			thread_adaptive_intr_switch(thread, false);
+			thread->last_busy_tsc = now;
+		}
 	}
 
 	thread_update_stats(thread, spdk_get_ticks(), now, rc);
@@ -1159,6 +1803,10 @@ spdk_thread_next_poller_expiration(struct spdk_thread *thread)
 {
 	struct spdk_poller *poller;
 
+	if (thread->timer_wheel != NULL) {
+		return timer_wheel_next_expiration(thread->timer_wheel);
+	}
+
 	poller = thread->first_timed_poller;
 	if (poller) {
 		return poller->next_run_tick;
@@ -1177,7 +1825,7 @@ static bool
 thread_has_unpaused_pollers(struct spdk_thread *thread)
 {
 	if (TAILQ_EMPTY(&thread->active_pollers) &&
-	    RB_EMPTY(&thread->timed_pollers)) {
+	    !thread_has_timed_pollers(thread)) {
 		return false;
 	}
 
@@ -1199,6 +1847,7 @@ bool
 spdk_thread_is_idle(struct spdk_thread *thread)
 {
 	if (spdk_ring_count(thread->messages) ||
+	    spdk_ring_count(thread->stealable_messages) ||
 	    thread_has_unpaused_pollers(thread) ||
 	    thread->critical_msg != NULL) {
 		return false;
@@ -1311,8 +1960,8 @@ thread_send_msg_notification(const struct spdk_thread *target_thread)
 	return 0;
 }
 
-int
-spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx)
+static int
+_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx, bool stealable)
 {
 	struct spdk_thread *local_thread;
 	struct spdk_msg *msg;
@@ -1348,7 +1997,15 @@ spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx
 	msg->fn = fn;
 	msg->arg = ctx;
 
-	rc = spdk_ring_enqueue(thread->messages, (void **)&msg, 1, NULL);
+	rc = 0;
+	if (stealable) {
+		/* The stealable ring is much smaller than the regular one. If it is
+		 * full, fall back to the regular ring and let the owner run the message. */
+		rc = spdk_ring_enqueue(thread->stealable_messages, (void **)&msg, 1, NULL);
+	}
+	if (rc != 1) {
+		rc = spdk_ring_enqueue(thread->messages, (void **)&msg, 1, NULL);
+	}
 	if (rc != 1) {
 		SPDK_ERRLOG("msg could not be enqueued\n");
 		spdk_mempool_put(g_spdk_msg_mempool, msg);
@@ -1358,6 +2015,199 @@ spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx
 	return thread_send_msg_notification(thread);
 }
 
+int
+spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx)
+{
+	return _thread_send_msg(thread, fn, ctx, false);
+}
+
+int
+spdk_thread_send_stealable_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx)
+{
+	return _thread_send_msg(thread, fn, ctx, true);
+}
+
+struct thread_msg_batch_entry {
+	const struct spdk_thread	*thread;
+	spdk_msg_fn			fn;
+	void				*arg;
+	struct spdk_msg			*msg;
+};
+
+struct spdk_thread_msg_batch {
+	uint32_t			size;
+	uint32_t			count;
+	/* Scratch space for the mempool and ring operations */
+	void				**msgs;
+	struct thread_msg_batch_entry	entries[];
+};
+
+struct spdk_thread_msg_batch *
+spdk_thread_msg_batch_alloc(uint32_t size)
+{
+	struct spdk_thread_msg_batch *batch;
+
+	if (size == 0) {
+		return NULL;
+	}
+
+	batch = calloc(1, sizeof(*batch) + size * sizeof(batch->entries[0]));
+	if (batch == NULL) {
+		return NULL;
+	}
+
+	batch->msgs = calloc(size, sizeof(*batch->msgs));
+	if (batch->msgs == NULL) {
+		free(batch);
+		return NULL;
+	}
+
+	batch->size = size;
+
+	return batch;
+}
+
+void
+spdk_thread_msg_batch_free(struct spdk_thread_msg_batch *batch)
+{
+	if (batch == NULL) {
+		return;
+	}
+
+	free(batch->msgs);
+	free(batch);
+}
+
+int
+spdk_thread_msg_batch_add(struct spdk_thread_msg_batch *batch, const struct spdk_thread *thread,
+			  spdk_msg_fn fn, void *ctx)
+{
+	struct thread_msg_batch_entry *entry;
+
+	assert(thread != NULL);
+
+	if (spdk_unlikely(thread->state == SPDK_THREAD_STATE_EXITED)) {
+		SPDK_ERRLOG("Thread %s is marked as exited.\n", thread->name);
+		return -EIO;
+	}
+
+	if (batch->count == batch->size) {
+		return -ENOSPC;
+	}
+
+	entry = &batch->entries[batch->count++];
+	entry->thread = thread;
+	entry->fn = fn;
+	entry->arg = ctx;
+
+	return 0;
+}
+
+int
+spdk_thread_msg_batch_submit(struct spdk_thread_msg_batch *batch)
+{
+	struct thread_msg_batch_entry *entry;
+	const struct spdk_thread *thread;
+	uint32_t i, j, count;
+	int rc = 0;
+
+	if (batch->count == 0) {
+		return 0;
+	}
+
+	/* Get all the messages at once, instead of one mempool operation per message. */
+	if (spdk_mempool_get_bulk(g_spdk_msg_mempool, batch->msgs, batch->count) != 0) {
+		SPDK_ERRLOG("msgs could not be allocated\n");
+		batch->count = 0;
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < batch->count; i++) {
+		entry = &batch->entries[i];
+		entry->msg = batch->msgs[i];
+		entry->msg->fn = entry->fn;
+		entry->msg->arg = entry->arg;
+	}
+
+	/* Group the messages by target thread, keeping their order, and enqueue each
+	 * group at once. Entries already enqueued are marked by clearing their thread. */
+	for (i = 0; i < batch->count; i++) {
+		thread = batch->entries[i].thread;
+		if (thread == NULL) {
+			continue;
+		}
+
+		count = 0;
+		for (j = i; j < batch->count; j++) {
+			entry = &batch->entries[j];
+			if (entry->thread == thread) {
+				batch->msgs[count++] = entry->msg;
+				entry->thread = NULL;
+			}
+		}
+
+		if (spdk_ring_enqueue(thread->messages, batch->msgs, count, NULL) != count) {
+			SPDK_ERRLOG("msgs could not be enqueued\n");
+			spdk_mempool_put_bulk(g_spdk_msg_mempool, batch->msgs, count);
+			rc = -EIO;
+			continue;
+		}
+
+		if (thread_send_msg_notification(thread) != 0) {
+			rc = -EIO;
+		}
+	}
+
+	batch->count = 0;
+
+	return rc;
+}
+
+uint32_t
+spdk_thread_get_stealable_msg_count(const struct spdk_thread *thread)
+{
+	return spdk_ring_count(thread->stealable_messages);
+}
+
+int
+spdk_thread_steal_msgs(struct spdk_thread *thread, struct spdk_thread *victim, uint32_t max_msgs)
+{
+	struct spdk_thread *orig_thread;
+	void *messages[SPDK_MSG_BATCH_SIZE];
+	unsigned count;
+
+	assert(thread != NULL);
+	assert(victim != NULL);
+
+	if (spdk_unlikely(thread == victim)) {
+		return -EINVAL;
+	}
+
+	if (spdk_unlikely(thread->state != SPDK_THREAD_STATE_RUNNING)) {
+		return 0;
+	}
+
+	if (max_msgs > 0) {
+		max_msgs = spdk_min(max_msgs, SPDK_MSG_BATCH_SIZE);
+	} else {
+		max_msgs = SPDK_MSG_BATCH_SIZE;
+	}
+
+	count = spdk_ring_dequeue(victim->stealable_messages, messages, max_msgs);
+	if (count == 0) {
+		return 0;
+	}
+
+	orig_thread = _get_thread();
+	tls_thread = thread;
+
+	msg_queue_exec(thread, messages, count);
+
+	tls_thread = orig_thread;
+
+	return count;
+}
+
 int
 spdk_thread_send_critical_msg(struct spdk_thread *thread, spdk_msg_fn fn)
 {
@@ -1888,6 +2738,31 @@ spdk_poller_get_stats(struct spdk_poller *poller, struct spdk_poller_stats *stat
 	stats->busy_count = poller->busy_count;
 }
 
+void
+spdk_poller_enable_histograms(bool enable)
+{
+	/* This global is read by all threads without synchronization. Each of them
+	 * allocates or frees its pollers' histograms the next time they run, so
+	 * seeing the update slightly late is harmless. */
+	g_poller_histograms_enabled = enable;
+}
+
+bool
+spdk_poller_histograms_enabled(void)
+{
+	return g_poller_histograms_enabled;
+}
+
+const struct spdk_histogram_data *
+spdk_poller_get_histogram(struct spdk_poller *poller)
+{
+	if (!g_poller_histograms_enabled) {
+		return NULL;
+	}
+
+	return poller->histogram;
+}
+
 struct spdk_poller *
 spdk_thread_get_first_active_poller(struct spdk_thread *thread)
 {
@@ -1903,13 +2778,13 @@ spdk_thread_get_next_active_poller(struct spdk_poller *prev)
 struct spdk_poller *
 spdk_thread_get_first_timed_poller(struct spdk_thread *thread)
 {
-	return RB_MIN(timed_pollers_tree, &thread->timed_pollers);
+	return thread_first_timed_poller(thread);
 }
 
 struct spdk_poller *
 spdk_thread_get_next_timed_poller(struct spdk_poller *prev)
 {
-	return RB_NEXT(timed_pollers_tree, &thread->timed_pollers, prev);
+	return thread_next_timed_poller(prev->thread, prev);
 }
 
 struct spdk_poller *
@@ -2030,25 +2905,17 @@ poller_set_interrupt_mode(struct spdk_poller *poller, bool interrupt_mode)
 	poller->set_intr_cb_fn(poller, poller->set_intr_cb_arg, interrupt_mode);
 }
 
-void
-spdk_thread_set_interrupt_mode(bool enable_interrupt)
+static void
+thread_set_interrupt_mode(struct spdk_thread *thread, bool enable_interrupt)
 {
-	struct spdk_thread *thread = _get_thread();
 	struct spdk_poller *poller, *tmp;
 
-	assert(thread);
-	assert(spdk_interrupt_mode_is_enabled());
-
-	SPDK_NOTICELOG("Set spdk_thread (%s) to %s mode from %s mode.\n",
-		       thread->name,  enable_interrupt ? "intr" : "poll",
-		       thread->in_interrupt ? "intr" : "poll");
-
 	if (thread->in_interrupt == enable_interrupt) {
 		return;
 	}
 
 	/* Set pollers to expected mode */
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, tmp) {
+	THREAD_TIMED_POLLER_FOREACH_SAFE(poller, thread, tmp) {
 		poller_set_interrupt_mode(poller, enable_interrupt);
 	}
 	TAILQ_FOREACH_SAFE(poller, &thread->active_pollers, tailq, tmp) {
@@ -2060,7 +2927,103 @@ spdk_thread_set_interrupt_mode(bool enable_interrupt)
 	}
 
 	thread->in_interrupt = enable_interrupt;
-	return;
+}
+
+void
+spdk_thread_set_interrupt_mode(bool enable_interrupt)
+{
+	struct spdk_thread *thread = _get_thread();
+
+	assert(thread);
+	assert(spdk_interrupt_mode_is_enabled());
+
+	SPDK_NOTICELOG("Set spdk_thread (%s) to %s mode from %s mode.\n",
+		       thread->name,  enable_interrupt ? "intr" : "poll",
+		       thread->in_interrupt ? "intr" : "poll");
+
+	/* An explicit request overrides the adaptive switching. */
+	thread->adaptive_intr = false;
+	thread->last_busy_tsc = 0;
+	thread_set_interrupt_mode(thread, enable_interrupt);
+}
+
+int
+spdk_thread_set_adaptive_interrupt(uint64_t idle_budget_us)
+{
+	if (!spdk_interrupt_mode_is_enabled()) {
+		return -ENOTSUP;
+	}
+
+	/* Like other globals read by all threads, a thread seeing the update
+	 * slightly late is harmless. */
+	g_adaptive_intr_idle_us = idle_budget_us;
+	g_adaptive_intr_idle_ticks = convert_us_to_ticks(idle_budget_us);
+
+	return 0;
+}
+
+uint64_t
+spdk_thread_get_adaptive_interrupt(void)
+{
+	return g_adaptive_intr_idle_us;
+}
+
+void
+spdk_thread_get_intr_stats(struct spdk_thread *thread, struct spdk_thread_intr_stats *stats)
+{
+	*stats = thread->intr_stats;
+}
+
+void
+spdk_thread_record_latency(uint64_t ticks)
+{
+	struct spdk_thread *thread = _get_thread();
+
+	if (spdk_likely(!g_latency_histograms_enabled) || spdk_unlikely(thread == NULL)) {
+		return;
+	}
+
+	if (spdk_unlikely(thread->latency_histogram == NULL)) {
+		/* If this fails, the sample is dropped and the allocation retried next time. */
+		thread->latency_histogram =
+			spdk_histogram_data_alloc_sized(SPDK_THREAD_LATENCY_HISTOGRAM_BUCKET_SHIFT);
+		if (thread->latency_histogram == NULL) {
+			return;
+		}
+		thread->latency_histogram_gen = g_latency_histograms_gen;
+	} else if (spdk_unlikely(thread->latency_histogram_gen != g_latency_histograms_gen)) {
+		spdk_histogram_data_reset(thread->latency_histogram);
+		thread->latency_histogram_gen = g_latency_histograms_gen;
+	}
+
+	spdk_histogram_data_tally(thread->latency_histogram, ticks);
+}
+
+void
+spdk_thread_enable_latency_histograms(bool enable)
+{
+	/* Read by all threads without synchronization, same as the poller histograms. */
+	if (enable && !g_latency_histograms_enabled) {
+		g_latency_histograms_gen++;
+	}
+	g_latency_histograms_enabled = enable;
+}
+
+bool
+spdk_thread_latency_histograms_enabled(void)
+{
+	return g_latency_histograms_enabled;
+}
+
+struct spdk_histogram_data *
+spdk_thread_get_latency_histogram(struct spdk_thread *thread)
+{
+	if (!g_latency_histograms_enabled || thread->latency_histogram == NULL ||
+	    thread->latency_histogram_gen != g_latency_histograms_gen) {
+		return NULL;
+	}
+
+	return thread->latency_histogram;
 }
 
 static struct io_device *
@@ -2106,8 +3069,10 @@ spdk_io_device_register(void *io_device, spdk_io_channel_create_cb create_cb,
 	dev->create_cb = create_cb;
 	dev->destroy_cb = destroy_cb;
 	dev->unregister_cb = NULL;
+	dev->migrate_cb = NULL;
 	dev->ctx_size = ctx_size;
 	dev->for_each_count = 0;
+	dev->socket_id = SPDK_ENV_SOCKET_ID_ANY;
 	dev->unregistered = false;
 	dev->refcnt = 0;
 
@@ -2125,6 +3090,42 @@ spdk_io_device_register(void *io_device, spdk_io_channel_create_cb create_cb,
 	pthread_mutex_unlock(&g_devlist_mutex);
 }
 
+int
+spdk_io_device_set_socket_id(void *io_device, int32_t socket_id)
+{
+	struct io_device *dev;
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	dev = io_device_get(io_device);
+	if (dev == NULL) {
+		pthread_mutex_unlock(&g_devlist_mutex);
+		return -ENODEV;
+	}
+
+	dev->socket_id = socket_id;
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	return 0;
+}
+
+int
+spdk_io_device_set_migrate_cb(void *io_device, spdk_io_channel_migrate_cb migrate_cb)
+{
+	struct io_device *dev;
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	dev = io_device_get(io_device);
+	if (dev == NULL) {
+		pthread_mutex_unlock(&g_devlist_mutex);
+		return -ENODEV;
+	}
+
+	dev->migrate_cb = migrate_cb;
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	return 0;
+}
+
 static void
 _finish_unregister(void *arg)
 {
@@ -20,12 +20,72 @@ static char g_shm_name[64];
 
 struct spdk_trace_histories *g_trace_histories;
 
+/*
+ * Sampling.  Objects of a group with a sample rate of N are selected for tracing when they're
+ * created (i.e. by the tracepoint with new_object set), one out of every N on each thread.  The IDs
+ * of the selected objects are kept in a table per object type, which is checked by all the other
+ * tracepoints of that object, so that the whole lifetime of each selected object is recorded.
+ * The table is indexed by a hash of the object ID, so if two selected objects collide, the older
+ * one stops being traced.  Tracepoints not bound to any object are always recorded.
+ */
+#define TRACE_SAMPLE_TABLE_SIZE		4096
+#define TRACE_SAMPLE_NONE		UINT64_MAX
+
+static uint32_t g_trace_sample_rate[SPDK_TRACE_MAX_GROUP_ID];
+static uint64_t *g_trace_sampled_objects[UCHAR_MAX + 1];
+static __thread uint32_t g_trace_sample_counter[SPDK_TRACE_MAX_GROUP_ID];
+
 static inline struct spdk_trace_entry *
 get_trace_entry(struct spdk_trace_history *history, uint64_t offset)
 {
 	return &history->entries[offset & (history->num_entries - 1)];
 }
 
+static inline uint64_t *
+get_sample_slot(uint64_t *table, uint64_t object_id)
+{
+	/* Object IDs are often pointers, so mix the bits before taking the upper ones */
+	return &table[((object_id ^ (object_id >> 17)) * 0x9e3779b97f4a7c15ULL) >>
+		      (64 - spdk_u32log2(TRACE_SAMPLE_TABLE_SIZE))];
+}
+
+static bool
+trace_sample(uint16_t tpoint_id, uint64_t object_id)
+{
+	struct spdk_trace_tpoint *tpoint = &g_trace_flags->tpoint[tpoint_id];
+	uint32_t group_id = tpoint_id >> 6;
+	uint64_t *table, *slot;
+	uint32_t rate;
+
+	rate = __atomic_load_n(&g_trace_sample_rate[group_id], __ATOMIC_ACQUIRE);
+	if (spdk_likely(rate <= 1)) {
+		return true;
+	}
+
+	table = g_trace_sampled_objects[tpoint->object_type];
+	if (tpoint->object_type == OBJECT_NONE || table == NULL) {
+		return true;
+	}
+
+	slot = get_sample_slot(table, object_id);
+	if (!tpoint->new_object) {
+		return __atomic_load_n(slot, __ATOMIC_RELAXED) == object_id;
+	}
+
+	if (++g_trace_sample_counter[group_id] >= rate) {
+		g_trace_sample_counter[group_id] = 0;
+		__atomic_store_n(slot, object_id, __ATOMIC_RELAXED);
+		return true;
+	}
+
+	/* The ID might be reused from an object that was selected */
+	if (__atomic_load_n(slot, __ATOMIC_RELAXED) == object_id) {
+		__atomic_store_n(slot, TRACE_SAMPLE_NONE, __ATOMIC_RELAXED);
+	}
+
+	return false;
+}
+
 void
 _spdk_trace_record(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id, uint32_t size,
 		   uint64_t object_id, int num_args, ...)
@@ -60,6 +120,10 @@ _spdk_trace_record(uint64_t tsc, uint16_t tpoint_id, uint16_t poller_id, uint32_
 		return;
 	}
 
+	if (!trace_sample(tpoint_id, object_id)) {
+		return;
+	}
+
 	/* Get next entry index in the circular buffer */
 	next_entry = get_trace_entry(lcore_history, lcore_history->next_entry);
 	next_entry->tsc = tsc;
@@ -268,11 +332,85 @@ spdk_trace_cleanup(void)
 	g_trace_histories = NULL;
 	close(g_trace_fd);
 
+	memset(g_trace_sample_rate, 0, sizeof(g_trace_sample_rate));
+	for (i = 0; i < (int)SPDK_COUNTOF(g_trace_sampled_objects); i++) {
+		free(g_trace_sampled_objects[i]);
+		g_trace_sampled_objects[i] = NULL;
+	}
+
 	if (unlink) {
 		shm_unlink(g_shm_name);
 	}
 }
 
+static int
+trace_set_group_sample_rate(uint32_t group_id, uint32_t rate)
+{
+	struct spdk_trace_tpoint *tpoint;
+	uint64_t *table;
+	uint32_t i;
+
+	/* Make sure that each object type in the group has a table before enabling sampling.  The
+	 * tables are only freed on cleanup, as they might still be accessed by other threads. */
+	for (i = group_id * 64; rate > 1 && i < (group_id + 1) * 64; i++) {
+		tpoint = &g_trace_flags->tpoint[i];
+		if (tpoint->object_type == OBJECT_NONE ||
+		    g_trace_sampled_objects[tpoint->object_type] != NULL) {
+			continue;
+		}
+
+		table = malloc(TRACE_SAMPLE_TABLE_SIZE * sizeof(*table));
+		if (table == NULL) {
+			return -ENOMEM;
+		}
+
+		memset(table, 0xff, TRACE_SAMPLE_TABLE_SIZE * sizeof(*table));
+		__atomic_store_n(&g_trace_sampled_objects[tpoint->object_type], table, __ATOMIC_RELEASE);
+	}
+
+	__atomic_store_n(&g_trace_sample_rate[group_id], rate, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+int
+spdk_trace_set_sample_rate(const char *group_name, uint32_t rate)
+{
+	uint64_t tpoint_group_mask;
+	uint32_t i;
+	int rc;
+
+	if (g_trace_histories == NULL) {
+		return -EINVAL;
+	}
+
+	tpoint_group_mask = spdk_trace_create_tpoint_group_mask(group_name);
+	if (tpoint_group_mask == 0) {
+		return -ENOENT;
+	}
+
+	for (i = 0; i < SPDK_TRACE_MAX_GROUP_ID; i++) {
+		if (tpoint_group_mask & (1ULL << i)) {
+			rc = trace_set_group_sample_rate(i, rate);
+			if (rc != 0) {
+				return rc;
+			}
+		}
+	}
+
+	return 0;
+}
+
+uint32_t
+spdk_trace_get_sample_rate(uint32_t group_id)
+{
+	if (group_id >= SPDK_TRACE_MAX_GROUP_ID) {
+		return 0;
+	}
+
+	return spdk_max(g_trace_sample_rate[group_id], 1);
+}
+
 const char *
 trace_get_shm_name(void)
 {
@@ -4,6 +4,7 @@
  */
 
 #include "spdk/rpc.h"
+#include "spdk/string.h"
 #include "spdk/util.h"
 #include "spdk/trace.h"
 #include "spdk/log.h"
@@ -169,6 +170,44 @@ invalid:
 SPDK_RPC_REGISTER("trace_disable_tpoint_group", rpc_trace_disable_tpoint_group,
 		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
 
+struct rpc_sample_rate {
+	char *name;
+	uint32_t rate;
+};
+
+static const struct spdk_json_object_decoder rpc_sample_rate_decoders[] = {
+	{"name", offsetof(struct rpc_sample_rate, name), spdk_json_decode_string},
+	{"rate", offsetof(struct rpc_sample_rate, rate), spdk_json_decode_uint32},
+};
+
+static void
+rpc_trace_set_sample_rate(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct rpc_sample_rate req = {};
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_sample_rate_decoders,
+				    SPDK_COUNTOF(rpc_sample_rate_decoders), &req)) {
+		SPDK_DEBUGLOG(trace, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "Invalid parameters");
+		goto cleanup;
+	}
+
+	rc = spdk_trace_set_sample_rate(req.name, req.rate);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+cleanup:
+	free(req.name);
+}
+SPDK_RPC_REGISTER("trace_set_sample_rate", rpc_trace_set_sample_rate,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
 static void
 rpc_trace_get_tpoint_group_mask(struct spdk_jsonrpc_request *request,
 				const struct spdk_json_val *params)
@@ -251,6 +290,8 @@ rpc_trace_get_info(struct spdk_jsonrpc_request *request,
 		spdk_json_write_named_string(w, "mask", mask_str);
 		snprintf(tpoint_mask_str, sizeof(tpoint_mask_str), "0x%lx", tpoint_mask);
 		spdk_json_write_named_string(w, "tpoint_mask", tpoint_mask_str);
+		spdk_json_write_named_uint32(w, "sample_rate",
+					     spdk_trace_get_sample_rate(register_fn->tgroup_id));
 		spdk_json_write_object_end(w);
 
 		register_fn = spdk_trace_get_next_register_fn(register_fn);
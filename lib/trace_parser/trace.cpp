@@ -12,27 +12,45 @@
 #include <exception>
 #include <map>
 #include <new>
+#include <queue>
+#include <vector>
+
+/* Entries of a single core, in the order they were recorded.  The history is a circular
+ * buffer, so the stream starts at its oldest entry and wraps around. */
+struct lcore_stream {
+	spdk_trace_history	*history;
+	uint64_t		first;
+	uint64_t		num_filled;
+	uint64_t		count;
+	uint64_t		pos;
+
+	spdk_trace_entry *entry(uint64_t p) const
+	{
+		return &history->entries[(first + p) % num_filled];
+	}
+};
 
-struct entry_key {
-	entry_key(uint16_t _lcore, uint64_t _tsc) : lcore(_lcore), tsc(_tsc) {}
-	uint16_t lcore;
+struct heap_key {
+	heap_key(uint64_t _tsc, uint16_t _lcore) : tsc(_tsc), lcore(_lcore) {}
 	uint64_t tsc;
+	uint16_t lcore;
 };
 
-class compare_entry_key
+/* Orders the heap so that the entry with the lowest tsc is on top */
+class compare_heap_key
 {
 public:
-	bool operator()(const entry_key &first, const entry_key &second) const
+	bool operator()(const heap_key &first, const heap_key &second) const
 	{
 		if (first.tsc == second.tsc) {
-			return first.lcore < second.lcore;
+			return first.lcore > second.lcore;
 		} else {
-			return first.tsc < second.tsc;
+			return first.tsc > second.tsc;
 		}
 	}
 };
 
-typedef std::map<entry_key, spdk_trace_entry *, compare_entry_key> entry_map;
+typedef std::priority_queue<heap_key, std::vector<heap_key>, compare_heap_key> entry_heap;
 
 struct argument_context {
 	spdk_trace_entry	*entry;
@@ -70,11 +88,14 @@ struct spdk_trace_parser {
 	uint64_t tsc_offset() const { return _tsc_offset; }
 	bool next_entry(spdk_trace_parser_entry *entry);
 	uint64_t entry_count(uint16_t lcore) const;
+	void seek(uint64_t tsc);
 private:
 	spdk_trace_entry_buffer *get_next_buffer(spdk_trace_entry_buffer *buf, uint16_t lcore);
 	bool build_arg(argument_context *argctx, const spdk_trace_argument *arg, int argid,
 		       spdk_trace_parser_entry *pe);
-	void populate_events(spdk_trace_history *history, int num_entries);
+	void populate_events(spdk_trace_history *history, uint64_t num_entries);
+	void stream_skip_buffers(lcore_stream *stream);
+	void stream_push(uint16_t lcore);
 	bool init(const spdk_trace_parser_opts *opts);
 	void cleanup();
 
@@ -82,8 +103,8 @@ private:
 	size_t			_map_size;
 	int			_fd;
 	uint64_t		_tsc_offset;
-	entry_map		_entries;
-	entry_map::iterator	_iter;
+	lcore_stream		_streams[SPDK_TRACE_MAX_LCORE];
+	entry_heap		_heap;
 	object_stats		_stats[SPDK_TRACE_MAX_OBJECT];
 };
 
@@ -163,12 +184,18 @@ spdk_trace_parser::next_entry(spdk_trace_parser_entry *pe)
 	object_stats *stats;
 	std::map<uint64_t, uint64_t>::iterator related_kv;
 
-	if (_iter == _entries.end()) {
+	if (_heap.empty()) {
 		return false;
 	}
 
-	pe->entry = entry = _iter->second;
-	pe->lcore = _iter->first.lcore;
+	pe->lcore = _heap.top().lcore;
+	_heap.pop();
+
+	lcore_stream *stream = &_streams[pe->lcore];
+	pe->entry = entry = stream->entry(stream->pos);
+	stream->pos++;
+	stream_push(pe->lcore);
+
 	/* Set related index to the max value to indicate "empty" state */
 	pe->related_index = UINT64_MAX;
 	pe->related_type = OBJECT_NONE;
@@ -216,18 +243,38 @@ spdk_trace_parser::next_entry(spdk_trace_parser_entry *pe)
 		}
 	}
 
-	_iter++;
 	return true;
 }
 
+/* Moves the stream past the buffers holding the arguments of a tracepoint */
+void
+spdk_trace_parser::stream_skip_buffers(lcore_stream *stream)
+{
+	while (stream->pos < stream->count &&
+	       stream->entry(stream->pos)->tpoint_id == SPDK_TRACE_MAX_TPOINT_ID) {
+		stream->pos++;
+	}
+}
+
+/* Adds the next entry of a core to the merge, if there's any left */
+void
+spdk_trace_parser::stream_push(uint16_t lcore)
+{
+	lcore_stream *stream = &_streams[lcore];
+
+	stream_skip_buffers(stream);
+	if (stream->pos < stream->count) {
+		_heap.push(heap_key(stream->entry(stream->pos)->tsc, lcore));
+	}
+}
+
 void
-spdk_trace_parser::populate_events(spdk_trace_history *history, int num_entries)
+spdk_trace_parser::populate_events(spdk_trace_history *history, uint64_t num_entries)
 {
-	int i, num_entries_filled;
+	lcore_stream *stream = &_streams[history->lcore];
+	uint64_t num_entries_filled, lo, hi, mid;
 	spdk_trace_entry *e;
-	int first, last, lcore;
 
-	lcore = history->lcore;
 	e = history->entries;
 
 	num_entries_filled = num_entries;
@@ -235,43 +282,79 @@ spdk_trace_parser::populate_events(spdk_trace_history *history, int num_entries)
 		num_entries_filled--;
 	}
 
+	/*
+	 * The entries of a core are recorded in tsc order, so the buffer is sorted, only rotated
+	 * once it has wrapped around.  The oldest entry is found with a binary search instead of
+	 * going through all of them, which would mean reading the whole file.  Entries equal to
+	 * the last one don't tell on which side of the rotation they are, so these are skipped
+	 * one by one.
+	 */
+	lo = 0;
+	hi = num_entries_filled - 1;
 	if (num_entries == num_entries_filled) {
-		first = last = 0;
-		for (i = 1; i < num_entries; i++) {
-			if (e[i].tsc < e[first].tsc) {
-				first = i;
-			}
-			if (e[i].tsc > e[last].tsc) {
-				last = i;
+		while (lo < hi) {
+			mid = lo + (hi - lo) / 2;
+			if (e[mid].tsc > e[hi].tsc) {
+				lo = mid + 1;
+			} else if (e[mid].tsc < e[hi].tsc) {
+				hi = mid;
+			} else if (e[hi - 1].tsc > e[hi].tsc) {
+				lo = hi;
+				break;
+			} else {
+				hi--;
 			}
 		}
-	} else {
-		first = 0;
-		last = num_entries_filled - 1;
 	}
 
+	stream->history = history;
+	stream->first = lo;
+	stream->num_filled = num_entries_filled;
+	stream->count = num_entries_filled;
+	stream->pos = 0;
+
 	/*
 	 * We keep track of the highest first TSC out of all reactors.
 	 *  We will ignore any events that occurred before this TSC on any
 	 *  other reactors.  This will ensure we only print data for the
 	 *  subset of time where we have data across all reactors.
 	 */
-	if (e[first].tsc > _tsc_offset) {
-		_tsc_offset = e[first].tsc;
+	if (e[stream->first].tsc > _tsc_offset) {
+		_tsc_offset = e[stream->first].tsc;
 	}
 
-	i = first;
-	while (1) {
-		if (e[i].tpoint_id != SPDK_TRACE_MAX_TPOINT_ID) {
-			_entries[entry_key(lcore, e[i].tsc)] = &e[i];
-		}
-		if (i == last) {
-			break;
+	stream_push(history->lcore);
+}
+
+void
+spdk_trace_parser::seek(uint64_t tsc)
+{
+	lcore_stream *stream;
+	uint64_t lo, hi, mid;
+	uint16_t lcore;
+
+	_heap = entry_heap();
+
+	for (lcore = 0; lcore < SPDK_TRACE_MAX_LCORE; lcore++) {
+		stream = &_streams[lcore];
+		if (stream->history == NULL) {
+			continue;
 		}
-		i++;
-		if (i == num_entries_filled) {
-			i = 0;
+
+		/* Find the first entry not older than tsc */
+		lo = 0;
+		hi = stream->count;
+		while (lo < hi) {
+			mid = lo + (hi - lo) / 2;
+			if (stream->entry(mid)->tsc < tsc) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
 		}
+
+		stream->pos = lo;
+		stream_push(lcore);
 	}
 }
 
@@ -357,7 +440,6 @@ spdk_trace_parser::init(const spdk_trace_parser_opts *opts)
 		}
 	}
 
-	_iter = _entries.begin();
 	return true;
 }
 
@@ -377,7 +459,8 @@ spdk_trace_parser::spdk_trace_parser(const spdk_trace_parser_opts *opts) :
 	_histories(NULL),
 	_map_size(0),
 	_fd(-1),
-	_tsc_offset(0)
+	_tsc_offset(0),
+	_streams()
 {
 	if (!init(opts)) {
 		cleanup();
@@ -430,3 +513,9 @@ spdk_trace_parser_get_entry_count(const struct spdk_trace_parser *parser, uint16
 {
 	return parser->entry_count(lcore);
 }
+
+void
+spdk_trace_parser_seek(struct spdk_trace_parser *parser, uint64_t tsc)
+{
+	parser->seek(tsc);
+}
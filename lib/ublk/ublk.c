@@ -28,9 +28,10 @@
 #define UBLK_CTRL_RING_DEPTH		32
 #define UBLK_THREAD_MAX			128
 #define UBLK_IO_MAX_BYTES		SPDK_BDEV_LARGE_BUF_MAX_SIZE
-#define UBLK_DEV_MAX_QUEUES		32
 #define UBLK_DEV_MAX_QUEUE_DEPTH	1024
 #define UBLK_QUEUE_REQUEST		32
+#define UBLK_THREAD_RING_DEPTH		4096
+#define UBLK_THREAD_MAX_QUEUES		64
 #define UBLK_STOP_BUSY_WAITING_MS	10000
 #define UBLK_BUSY_POLLING_INTERVAL_US	20000
 
@@ -48,6 +49,7 @@ static void ublk_dev_queue_fini(struct ublk_queue *q);
 static int ublk_poll(void *arg);
 static int ublk_ctrl_cmd(struct spdk_ublk_dev *ublk, uint32_t cmd_op);
 static void ublk_ios_fini(struct spdk_ublk_dev *ublk);
+static void ublk_dev_init_io_cmds(struct io_uring *r, uint32_t q_depth);
 
 typedef void (*ublk_next_state_fn)(struct spdk_ublk_dev *ublk);
 static void ublk_set_params(struct spdk_ublk_dev *ublk);
@@ -85,10 +87,12 @@ struct ublk_queue {
 	TAILQ_HEAD(, ublk_io)	inflight_io_list;
 	uint32_t		cmd_inflight;
 	struct ublksrv_io_desc	*io_cmd_buf;
-	/* ring depth == dev_info->queue_depth. */
-	struct io_uring		ring;
+	/* Index of the queue in its thread's queues[] and of cdev_fd in the thread's ring files */
+	uint16_t		slot;
+	bool			fixed_file;
 	struct spdk_ublk_dev	*dev;
 	struct ublk_thread_ctx	*thread_ctx;
+	struct spdk_io_channel	*bdev_ch;
 
 	TAILQ_ENTRY(ublk_queue)	tailq;
 };
@@ -96,7 +100,6 @@ struct ublk_queue {
 struct spdk_ublk_dev {
 	struct spdk_bdev	*bdev;
 	struct spdk_bdev_desc	*bdev_desc;
-	struct spdk_io_channel	*ch[UBLK_DEV_MAX_QUEUES];
 	struct spdk_thread	*app_thread;
 
 	int			cdev_fd;
@@ -108,7 +111,7 @@ struct spdk_ublk_dev {
 	uint32_t		queue_depth;
 
 	struct spdk_mempool	*io_buf_pool;
-	struct ublk_queue	queues[UBLK_DEV_MAX_QUEUES];
+	struct ublk_queue	*queues;
 
 	struct spdk_poller	*retry_poller;
 	int			retry_count;
@@ -128,6 +131,16 @@ struct spdk_ublk_dev {
 struct ublk_thread_ctx {
 	struct spdk_thread		*ublk_thread;
 	struct spdk_poller		*ublk_poller;
+	/*
+	 * All queues of the thread share this ring, so that the commands of every queue
+	 * are committed to the kernel with a single io_uring_submit() per poll.
+	 */
+	struct io_uring			ring;
+	uint32_t			sqes_pending;
+	struct ublk_queue		*queues[UBLK_THREAD_MAX_QUEUES];
+	uint32_t			num_active_queues;
+	/* Queues assigned to the thread, only accessed from the app thread */
+	uint32_t			num_queues;
 	TAILQ_HEAD(, ublk_queue)	queue_list;
 };
 
@@ -149,12 +162,12 @@ static struct ublk_tgt g_ublk_tgt;
 
 /* helpers for using io_uring */
 static inline int
-ublk_setup_ring(uint32_t depth, struct io_uring *r, unsigned flags)
+ublk_setup_ring(uint32_t depth, uint32_t cq_depth, struct io_uring *r, unsigned flags)
 {
 	struct io_uring_params p = {};
 
 	p.flags = flags | IORING_SETUP_CQSIZE;
-	p.cq_entries = depth;
+	p.cq_entries = cq_depth;
 
 	return io_uring_queue_init_params(depth, r, &p);
 }
@@ -179,11 +192,11 @@ ublk_set_sqe_cmd_op(struct io_uring_sqe *sqe, uint32_t cmd_op)
 }
 
 static inline uint64_t
-build_user_data(uint16_t tag, uint8_t op)
+build_user_data(uint16_t slot, uint16_t tag, uint8_t op)
 {
 	assert(!(tag >> 16) && !(op >> 8));
 
-	return tag | (op << 16);
+	return tag | (op << 16) | ((uint64_t)slot << 24);
 }
 
 static inline uint16_t
@@ -198,6 +211,12 @@ user_data_to_op(uint64_t user_data)
 	return (user_data >> 16) & 0xff;
 }
 
+static inline uint16_t
+user_data_to_slot(uint64_t user_data)
+{
+	return (user_data >> 24) & 0xffff;
+}
+
 void
 spdk_ublk_init(void)
 {
@@ -348,7 +367,7 @@ ublk_open(void)
 	/* We need to set SQPOLL for kernels 6.1 and earlier, since they would not defer ublk ctrl
 	 * ring processing to a workqueue.  Ctrl ring processing is minimal, so SQPOLL is fine.
 	 */
-	rc = ublk_setup_ring(UBLK_CTRL_RING_DEPTH, &g_ublk_tgt.ctrl_ring,
+	rc = ublk_setup_ring(UBLK_CTRL_RING_DEPTH, UBLK_CTRL_RING_DEPTH, &g_ublk_tgt.ctrl_ring,
 			     IORING_SETUP_SQE128 | IORING_SETUP_SQPOLL);
 	if (rc < 0) {
 		SPDK_ERRLOG("UBLK ctrl queue_init: %s\n", spdk_strerror(-rc));
@@ -398,13 +417,53 @@ ublk_parse_core_mask(const char *mask, struct spdk_cpuset *cpumask)
 	return 0;
 }
 
+static int
+ublk_thread_ring_init(struct ublk_thread_ctx *thread_ctx)
+{
+	int rc;
+
+	/* The CQ must hold a completion for every command the queues of the thread can have in flight */
+	rc = ublk_setup_ring(UBLK_THREAD_RING_DEPTH, UBLK_THREAD_MAX_QUEUES * UBLK_DEV_MAX_QUEUE_DEPTH,
+			     &thread_ctx->ring, IORING_SETUP_SQE128);
+	if (rc < 0) {
+		SPDK_ERRLOG("Failed at setup uring: %s\n", spdk_strerror(-rc));
+		thread_ctx->ring.ring_fd = -1;
+		return rc;
+	}
+
+	/* The cdev_fd of each queue is registered in its slot when the queue starts */
+	rc = io_uring_register_files_sparse(&thread_ctx->ring, UBLK_THREAD_MAX_QUEUES);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed at uring register files: %s\n", spdk_strerror(-rc));
+		io_uring_queue_exit(&thread_ctx->ring);
+		thread_ctx->ring.ring_fd = -1;
+		return rc;
+	}
+
+	ublk_dev_init_io_cmds(&thread_ctx->ring, UBLK_THREAD_RING_DEPTH);
+	thread_ctx->sqes_pending = 0;
+	thread_ctx->num_queues = 0;
+	thread_ctx->num_active_queues = 0;
+	memset(thread_ctx->queues, 0, sizeof(thread_ctx->queues));
+
+	return 0;
+}
+
 static void
 ublk_poller_register(void *args)
 {
 	struct ublk_thread_ctx *thread_ctx = args;
+	int rc;
 
 	assert(spdk_get_thread() == thread_ctx->ublk_thread);
 	TAILQ_INIT(&thread_ctx->queue_list);
+
+	/* Registered ring fds are per task, so this has to be done by the thread submitting to the ring */
+	rc = io_uring_register_ring_fd(&thread_ctx->ring);
+	if (rc != 1) {
+		SPDK_NOTICELOG("Couldn't register ring fd of %s: %s\n",
+			       spdk_thread_get_name(thread_ctx->ublk_thread), spdk_strerror(-rc));
+	}
 	thread_ctx->ublk_poller = SPDK_POLLER_REGISTER(ublk_poll, thread_ctx, 0);
 }
 
@@ -412,7 +471,7 @@ int
 ublk_create_target(const char *cpumask_str)
 {
 	int rc;
-	uint32_t i;
+	uint32_t i, num_threads = 0;
 	char thread_name[32];
 	struct spdk_cpuset cpuset = {};
 	struct spdk_cpuset thd_cpuset = {};
@@ -436,6 +495,23 @@ ublk_create_target(const char *cpumask_str)
 		return rc;
 	}
 
+	SPDK_ENV_FOREACH_CORE(i) {
+		if (spdk_cpuset_get_cpu(&cpuset, i)) {
+			rc = ublk_thread_ring_init(&g_ublk_tgt.thread_ctx[num_threads]);
+			if (rc != 0) {
+				while (num_threads > 0) {
+					io_uring_queue_exit(&g_ublk_tgt.thread_ctx[--num_threads].ring);
+				}
+				io_uring_queue_exit(&g_ublk_tgt.ctrl_ring);
+				g_ublk_tgt.ctrl_ring.ring_fd = -1;
+				close(g_ublk_tgt.ctrl_fd);
+				g_ublk_tgt.ctrl_fd = -1;
+				return rc;
+			}
+			num_threads++;
+		}
+	}
+
 	SPDK_ENV_FOREACH_CORE(i) {
 		if (spdk_cpuset_get_cpu(&cpuset, i)) {
 			spdk_cpuset_zero(&thd_cpuset);
@@ -477,6 +553,8 @@ ublk_thread_exit(void *args)
 	for (i = 0; i < g_num_ublk_threads; i++) {
 		if (g_ublk_tgt.thread_ctx[i].ublk_thread == ublk_thread) {
 			spdk_poller_unregister(&g_ublk_tgt.thread_ctx[i].ublk_poller);
+			io_uring_queue_exit(&g_ublk_tgt.thread_ctx[i].ring);
+			g_ublk_tgt.thread_ctx[i].ring.ring_fd = -1;
 			spdk_thread_exit(ublk_thread);
 		}
 	}
@@ -698,6 +776,7 @@ ublk_free_dev(struct spdk_ublk_dev *ublk)
 	}
 
 	ublk_ios_fini(ublk);
+	free(ublk->queues);
 	ublk_dev_list_unregister(ublk);
 
 	if (ublk->del_cb) {
@@ -744,6 +823,24 @@ ublk_try_close_dev(void *arg)
 	}
 }
 
+static void
+ublk_queue_put_slot(struct ublk_queue *q)
+{
+	struct ublk_thread_ctx *thread_ctx = q->thread_ctx;
+	int fd = -1, rc;
+
+	/* Drop the ring's reference on cdev_fd, so that the device can be deleted */
+	if (q->fixed_file) {
+		rc = io_uring_register_files_update(&thread_ctx->ring, q->slot, &fd, 1);
+		if (rc != 1) {
+			SPDK_ERRLOG("Failed at uring unregister file: %s\n", spdk_strerror(-rc));
+		}
+		q->fixed_file = false;
+	}
+	thread_ctx->queues[q->slot] = NULL;
+	thread_ctx->num_active_queues--;
+}
+
 static void
 ublk_try_close_queue(struct ublk_queue *q)
 {
@@ -758,8 +855,9 @@ ublk_try_close_queue(struct ublk_queue *q)
 	}
 
 	TAILQ_REMOVE(&q->thread_ctx->queue_list, q, tailq);
-	spdk_put_io_channel(ublk->ch[q->q_id]);
-	ublk->ch[q->q_id] = NULL;
+	ublk_queue_put_slot(q);
+	spdk_put_io_channel(q->bdev_ch);
+	q->bdev_ch = NULL;
 
 	spdk_thread_send_msg(ublk->app_thread, ublk_try_close_dev, ublk);
 }
@@ -848,7 +946,7 @@ ublk_queue_io(struct ublk_io *io)
 	io->bdev_io_wait.cb_fn = ublk_resubmit_io;
 	io->bdev_io_wait.cb_arg = io;
 
-	rc = spdk_bdev_queue_io_wait(bdev, q->dev->ch[q->q_id], &io->bdev_io_wait);
+	rc = spdk_bdev_queue_io_wait(bdev, q->bdev_ch, &io->bdev_io_wait);
 	if (rc != 0) {
 		SPDK_ERRLOG("Queue io failed in ublk_queue_io, rc=%d.\n", rc);
 		ublk_io_done(NULL, false, io);
@@ -861,7 +959,7 @@ ublk_submit_bdev_io(struct ublk_queue *q, uint16_t tag)
 	struct spdk_ublk_dev *ublk = q->dev;
 	struct ublk_io *io = &q->ios[tag];
 	struct spdk_bdev_desc *desc = ublk->bdev_desc;
-	struct spdk_io_channel *ch = ublk->ch[q->q_id];
+	struct spdk_io_channel *ch = q->bdev_ch;
 	uint64_t offset_blocks, num_blocks;
 	uint8_t ublk_op;
 	uint32_t sector_per_block, sector_per_block_shift;
@@ -908,6 +1006,47 @@ ublk_submit_bdev_io(struct ublk_queue *q, uint16_t tag)
 	}
 }
 
+static struct io_uring_sqe *
+ublk_thread_get_sqe(struct ublk_thread_ctx *thread_ctx)
+{
+	struct io_uring_sqe *sqe;
+	int rc;
+
+	sqe = io_uring_get_sqe(&thread_ctx->ring);
+	if (spdk_unlikely(sqe == NULL)) {
+		/* The SQ is full, commit the queued commands to make room */
+		rc = io_uring_submit(&thread_ctx->ring);
+		if (rc != (int)thread_ctx->sqes_pending) {
+			SPDK_ERRLOG("could not submit all commands\n");
+			assert(false);
+		}
+		thread_ctx->sqes_pending = 0;
+		sqe = io_uring_get_sqe(&thread_ctx->ring);
+	}
+
+	thread_ctx->sqes_pending++;
+	return sqe;
+}
+
+static int
+ublk_thread_submit(struct ublk_thread_ctx *thread_ctx)
+{
+	int rc;
+
+	if (thread_ctx->sqes_pending == 0) {
+		return 0;
+	}
+
+	rc = io_uring_submit(&thread_ctx->ring);
+	if (rc != (int)thread_ctx->sqes_pending) {
+		SPDK_ERRLOG("could not submit all commands\n");
+		assert(false);
+	}
+	thread_ctx->sqes_pending = 0;
+
+	return rc;
+}
+
 static inline void
 ublksrv_queue_io_cmd(struct ublk_queue *q,
 		     struct ublk_io *io, unsigned tag)
@@ -923,7 +1062,7 @@ ublksrv_queue_io_cmd(struct ublk_queue *q,
 	       (io->cmd_op == UBLK_IO_COMMIT_AND_FETCH_REQ));
 	cmd_op = io->cmd_op;
 
-	sqe = io_uring_get_sqe(&q->ring);
+	sqe = ublk_thread_get_sqe(q->thread_ctx);
 	assert(sqe);
 
 	cmd = (struct ublksrv_io_cmd *)ublk_get_sqe_cmd(sqe);
@@ -931,18 +1070,22 @@ ublksrv_queue_io_cmd(struct ublk_queue *q,
 		cmd->result = io->result;
 	}
 
-	/* These fields should be written once, never change */
 	ublk_set_sqe_cmd_op(sqe, cmd_op);
-	/* dev->cdev_fd */
-	sqe->fd		= 0;
+	if (spdk_likely(q->fixed_file)) {
+		/* dev->cdev_fd */
+		sqe->fd		= q->slot;
+		sqe->flags	= IOSQE_FIXED_FILE;
+	} else {
+		sqe->fd		= q->dev->cdev_fd;
+		sqe->flags	= 0;
+	}
 	sqe->opcode	= IORING_OP_URING_CMD;
-	sqe->flags	= IOSQE_FIXED_FILE;
 	sqe->rw_flags	= 0;
 	cmd->tag	= tag;
 	cmd->addr	= (__u64)(uintptr_t)(io->payload);
 	cmd->q_id	= q->q_id;
 
-	user_data = build_user_data(tag, cmd_op);
+	user_data = build_user_data(q->slot, tag, cmd_op);
 	io_uring_sqe_set_data64(sqe, user_data);
 
 	io->cmd_op = 0;
@@ -956,7 +1099,7 @@ ublksrv_queue_io_cmd(struct ublk_queue *q,
 static int
 ublk_io_xmit(struct ublk_queue *q)
 {
-	int rc = 0, count = 0, tag;
+	int count = 0, tag;
 	struct ublk_io *io;
 
 	if (TAILQ_EMPTY(&q->completed_io_list)) {
@@ -977,30 +1120,26 @@ ublk_io_xmit(struct ublk_queue *q)
 		count++;
 	}
 
-	rc = io_uring_submit(&q->ring);
-	if (rc != count) {
-		SPDK_ERRLOG("could not submit all commands\n");
-		assert(false);
-	}
-
-	return rc;
+	/* The commands are submitted along with those of the other queues in ublk_poll */
+	return count;
 }
 
 static int
-ublk_io_recv(struct ublk_queue *q)
+ublk_io_recv(struct ublk_thread_ctx *thread_ctx)
 {
 	struct io_uring_cqe *cqe;
 	unsigned head, tag;
-	int fetch, count = 0;
+	int fetch, count = 0, max;
 	struct ublk_io *io;
-	struct spdk_ublk_dev *dev = q->dev;
+	struct ublk_queue *q;
+	struct spdk_ublk_dev *dev;
 	unsigned __attribute__((unused)) cmd_op;
 
-	if (q->cmd_inflight == 0) {
-		return 0;
-	}
-
-	io_uring_for_each_cqe(&q->ring, head, cqe) {
+	max = UBLK_QUEUE_REQUEST * thread_ctx->num_active_queues;
+	io_uring_for_each_cqe(&thread_ctx->ring, head, cqe) {
+		q = thread_ctx->queues[user_data_to_slot(cqe->user_data)];
+		assert(q != NULL);
+		dev = q->dev;
 		tag = user_data_to_tag(cqe->user_data);
 		cmd_op = user_data_to_op(cqe->user_data);
 		fetch = (cqe->res != UBLK_IO_RES_ABORT) && !dev->is_closing;
@@ -1035,11 +1174,11 @@ ublk_io_recv(struct ublk_queue *q)
 			TAILQ_REMOVE(&q->inflight_io_list, io, tailq);
 		}
 		count += 1;
-		if (count == UBLK_QUEUE_REQUEST) {
+		if (count == max) {
 			break;
 		}
 	}
-	io_uring_cq_advance(&q->ring, count);
+	io_uring_cq_advance(&thread_ctx->ring, count);
 
 	return count;
 }
@@ -1049,17 +1188,18 @@ ublk_poll(void *arg)
 {
 	struct ublk_thread_ctx *thread_ctx = arg;
 	struct ublk_queue *q, *q_tmp;
-	struct spdk_ublk_dev *ublk;
-	int sent, received, count = 0;
+	int count = 0;
+
+	TAILQ_FOREACH(q, &thread_ctx->queue_list, tailq) {
+		count += ublk_io_xmit(q);
+	}
+	ublk_thread_submit(thread_ctx);
+	count += ublk_io_recv(thread_ctx);
 
 	TAILQ_FOREACH_SAFE(q, &thread_ctx->queue_list, tailq, q_tmp) {
-		sent = ublk_io_xmit(q);
-		received = ublk_io_recv(q);
-		ublk = q->dev;
-		if (spdk_unlikely(ublk->is_closing)) {
+		if (spdk_unlikely(q->dev->is_closing)) {
 			ublk_try_close_queue(q);
 		}
-		count += sent + received;
 	}
 	if (count > 0) {
 		return SPDK_POLLER_BUSY;
@@ -1130,26 +1270,6 @@ ublk_dev_queue_init(struct ublk_queue *q)
 		q->ios[j].io_free = true;
 	}
 
-	rc = ublk_setup_ring(q->q_depth, &q->ring, IORING_SETUP_SQE128);
-	if (rc < 0) {
-		SPDK_ERRLOG("Failed at setup uring: %s\n", spdk_strerror(-rc));
-		munmap(q->io_cmd_buf, ublk_queue_cmd_buf_sz(q->q_depth));
-		q->io_cmd_buf = NULL;
-		goto err;
-	}
-
-	rc = io_uring_register_files(&q->ring, &ublk->cdev_fd, 1);
-	if (rc != 0) {
-		SPDK_ERRLOG("Failed at uring register files: %s\n", spdk_strerror(-rc));
-		io_uring_queue_exit(&q->ring);
-		q->ring.ring_fd = -1;
-		munmap(q->io_cmd_buf, ublk_queue_cmd_buf_sz(q->q_depth));
-		q->io_cmd_buf = NULL;
-		goto err;
-	}
-
-	ublk_dev_init_io_cmds(&q->ring, q->q_depth);
-
 	return 0;
 err:
 	return rc;
@@ -1158,10 +1278,9 @@ err:
 static void
 ublk_dev_queue_fini(struct ublk_queue *q)
 {
-	if (q->ring.ring_fd >= 0) {
-		io_uring_unregister_files(&q->ring);
-		io_uring_queue_exit(&q->ring);
-		q->ring.ring_fd = -1;
+	if (q->thread_ctx) {
+		q->thread_ctx->num_queues--;
+		q->thread_ctx = NULL;
 	}
 	if (q->io_cmd_buf) {
 		munmap(q->io_cmd_buf, ublk_queue_cmd_buf_sz(q->q_depth));
@@ -1172,15 +1291,11 @@ static void
 ublk_dev_queue_io_init(struct ublk_queue *q)
 {
 	uint32_t i;
-	int rc __attribute__((unused));
 
-	/* submit all io commands to ublk driver */
+	/* queue all io commands to ublk driver, the poller submits them */
 	for (i = 0; i < q->q_depth; i++) {
 		ublksrv_queue_io_cmd(q, &q->ios[i], i);
 	}
-
-	rc = io_uring_submit(&q->ring);
-	assert(rc == (int)q->q_depth);
 }
 
 static void
@@ -1330,12 +1445,32 @@ ublk_queue_run(void *arg1)
 	struct ublk_queue	*q = arg1;
 	struct spdk_ublk_dev *ublk = q->dev;
 	struct ublk_thread_ctx *thread_ctx = q->thread_ctx;
+	uint16_t slot;
+	int rc;
 
 	assert(spdk_get_thread() == thread_ctx->ublk_thread);
+	for (slot = 0; slot < UBLK_THREAD_MAX_QUEUES; slot++) {
+		if (thread_ctx->queues[slot] == NULL) {
+			break;
+		}
+	}
+	/* ublk_finish_start() doesn't assign more queues to a thread than it has slots */
+	assert(slot < UBLK_THREAD_MAX_QUEUES);
+	q->slot = slot;
+	thread_ctx->queues[slot] = q;
+	thread_ctx->num_active_queues++;
+
+	rc = io_uring_register_files_update(&thread_ctx->ring, slot, &ublk->cdev_fd, 1);
+	q->fixed_file = (rc == 1);
+	if (!q->fixed_file) {
+		SPDK_WARNLOG("Failed at uring register file, ublk %d queue %d uses a plain fd: %s\n",
+			     ublk->ublk_id, q->q_id, spdk_strerror(-rc));
+	}
+
 	/* Queues must be filled with IO in the io pthread */
 	ublk_dev_queue_io_init(q);
 
-	ublk->ch[q->q_id] = spdk_bdev_get_io_channel(ublk->bdev_desc);
+	q->bdev_ch = spdk_bdev_get_io_channel(ublk->bdev_desc);
 	TAILQ_INSERT_TAIL(&thread_ctx->queue_list, q, tailq);
 }
 
@@ -1345,7 +1480,7 @@ ublk_start_disk(const char *bdev_name, uint32_t ublk_id,
 		ublk_start_cb start_cb, void *cb_arg)
 {
 	int			rc;
-	uint32_t		i;
+	uint32_t		max_queues;
 	struct spdk_bdev	*bdev;
 	struct spdk_ublk_dev	*ublk = NULL;
 
@@ -1389,19 +1524,26 @@ ublk_start_disk(const char *bdev_name, uint32_t ublk_id,
 			     ublk->queue_depth, ublk->ublk_id, UBLK_DEV_MAX_QUEUE_DEPTH);
 		ublk->queue_depth = UBLK_DEV_MAX_QUEUE_DEPTH;
 	}
-	if (ublk->num_queues > UBLK_DEV_MAX_QUEUES) {
+	/* The kernel doesn't create more hardware queues than there are CPUs */
+	max_queues = spdk_max(sysconf(_SC_NPROCESSORS_CONF), 1);
+	if (ublk->num_queues > max_queues) {
 		SPDK_WARNLOG("Set Queue num %d of UBLK %d to maximum %d\n",
-			     ublk->num_queues, ublk->ublk_id, UBLK_DEV_MAX_QUEUES);
-		ublk->num_queues = UBLK_DEV_MAX_QUEUES;
+			     ublk->num_queues, ublk->ublk_id, max_queues);
+		ublk->num_queues = max_queues;
 	}
-	for (i = 0; i < ublk->num_queues; i++) {
-		ublk->queues[i].ring.ring_fd = -1;
+
+	ublk->queues = calloc(ublk->num_queues, sizeof(*ublk->queues));
+	if (ublk->queues == NULL) {
+		spdk_bdev_close(ublk->bdev_desc);
+		free(ublk);
+		return -ENOMEM;
 	}
 
 	/* Add ublk_dev to the end of disk list */
 	rc = ublk_dev_list_register(ublk);
 	if (rc != 0) {
 		spdk_bdev_close(ublk->bdev_desc);
+		free(ublk->queues);
 		free(ublk);
 		return rc;
 	}
@@ -1424,12 +1566,34 @@ ublk_start_disk(const char *bdev_name, uint32_t ublk_id,
 	return rc;
 }
 
+static struct ublk_thread_ctx *
+ublk_get_queue_thread(void)
+{
+	struct ublk_thread_ctx *thread_ctx;
+	uint32_t i;
+
+	/* Send queues to different spdk_threads for load balance */
+	for (i = 0; i < g_num_ublk_threads; i++) {
+		thread_ctx = &g_ublk_tgt.thread_ctx[g_queue_thread_id];
+		g_queue_thread_id++;
+		if (g_queue_thread_id == g_num_ublk_threads) {
+			g_queue_thread_id = 0;
+		}
+		if (thread_ctx->num_queues < UBLK_THREAD_MAX_QUEUES) {
+			thread_ctx->num_queues++;
+			return thread_ctx;
+		}
+	}
+
+	return NULL;
+}
+
 static void
 ublk_finish_start(struct spdk_ublk_dev *ublk)
 {
 	int			rc;
 	uint32_t		q_id;
-	struct spdk_thread	*ublk_thread;
+	struct ublk_queue	*q;
 	char			buf[64];
 
 	snprintf(buf, 64, "%s%d", UBLK_BLK_CDEV, ublk->ublk_id);
@@ -1441,10 +1605,17 @@ ublk_finish_start(struct spdk_ublk_dev *ublk)
 	}
 
 	for (q_id = 0; q_id < ublk->num_queues; q_id++) {
-		rc = ublk_dev_queue_init(&ublk->queues[q_id]);
+		q = &ublk->queues[q_id];
+		rc = ublk_dev_queue_init(q);
 		if (rc) {
 			goto err;
 		}
+		q->thread_ctx = ublk_get_queue_thread();
+		if (q->thread_ctx == NULL) {
+			SPDK_ERRLOG("No ublk thread has room for queue %d of ublk %d\n", q_id, ublk->ublk_id);
+			rc = -ENOSPC;
+			goto err;
+		}
 	}
 
 	rc = ublk_ctrl_cmd(ublk, UBLK_CMD_START_DEV);
@@ -1454,15 +1625,9 @@ ublk_finish_start(struct spdk_ublk_dev *ublk)
 		goto err;
 	}
 
-	/* Send queue to different spdk_threads for load balance */
 	for (q_id = 0; q_id < ublk->num_queues; q_id++) {
-		ublk->queues[q_id].thread_ctx = &g_ublk_tgt.thread_ctx[g_queue_thread_id];
-		ublk_thread = g_ublk_tgt.thread_ctx[g_queue_thread_id].ublk_thread;
-		spdk_thread_send_msg(ublk_thread, ublk_queue_run, &ublk->queues[q_id]);
-		g_queue_thread_id++;
-		if (g_queue_thread_id == g_num_ublk_threads) {
-			g_queue_thread_id = 0;
-		}
+		q = &ublk->queues[q_id];
+		spdk_thread_send_msg(q->thread_ctx->ublk_thread, ublk_queue_run, q);
 	}
 
 	goto out;
@@ -7,22 +7,42 @@
 
 #include "spdk/bit_array.h"
 #include "spdk/bit_pool.h"
+#include "spdk/assert.h"
 #include "spdk/env.h"
 
 #include "spdk/likely.h"
 #include "spdk/util.h"
 
+#if defined(__x86_64__) && defined(__AVX2__)
+#define SPDK_BIT_ARRAY_HAVE_AVX2
+#include <x86intrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define SPDK_BIT_ARRAY_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
 typedef uint64_t spdk_bit_array_word;
 #define SPDK_BIT_ARRAY_WORD_TZCNT(x)	(__builtin_ctzll(x))
 #define SPDK_BIT_ARRAY_WORD_POPCNT(x)	(__builtin_popcountll(x))
 #define SPDK_BIT_ARRAY_WORD_C(x)	((spdk_bit_array_word)(x))
 #define SPDK_BIT_ARRAY_WORD_BYTES	sizeof(spdk_bit_array_word)
 #define SPDK_BIT_ARRAY_WORD_BITS	(SPDK_BIT_ARRAY_WORD_BYTES * 8)
-#define SPDK_BIT_ARRAY_WORD_INDEX_SHIFT	spdk_u32log2(SPDK_BIT_ARRAY_WORD_BITS)
+/* log2(SPDK_BIT_ARRAY_WORD_BITS), a constant so that it doesn't end up as a call */
+#define SPDK_BIT_ARRAY_WORD_INDEX_SHIFT	6
 #define SPDK_BIT_ARRAY_WORD_INDEX_MASK	((1u << SPDK_BIT_ARRAY_WORD_INDEX_SHIFT) - 1)
-
+SPDK_STATIC_ASSERT(SPDK_BIT_ARRAY_WORD_BITS == 1u << SPDK_BIT_ARRAY_WORD_INDEX_SHIFT,
+		   "Incorrect word index shift");
+
+/*
+ * Besides the words, two summary bitmaps are kept, with one bit per word (including the extra
+ * word, see spdk_bit_array_resize()): whether the word is full, i.e. has all bits set, and
+ * whether it is non-zero.  They let the find_first functions skip runs of full (or empty) words
+ * without reading them.  Both are stored after the words in the same allocation.
+ */
 struct spdk_bit_array {
 	uint32_t bit_count;
+	spdk_bit_array_word *full;
+	spdk_bit_array_word *nonzero;
 	spdk_bit_array_word words[];
 };
 
@@ -63,11 +83,46 @@ bit_array_word_mask(uint32_t num_bits)
 	return (SPDK_BIT_ARRAY_WORD_C(1) << num_bits) - 1;
 }
 
+static inline void
+bit_array_summary_set(spdk_bit_array_word *summary, uint32_t word_index)
+{
+	summary[word_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT] |=
+		SPDK_BIT_ARRAY_WORD_C(1) << (word_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK);
+}
+
+static inline void
+bit_array_summary_clear(spdk_bit_array_word *summary, uint32_t word_index)
+{
+	summary[word_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT] &=
+		~(SPDK_BIT_ARRAY_WORD_C(1) << (word_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK));
+}
+
+/* Rebuild the summaries after the words have been modified directly */
+static void
+bit_array_update_summary(struct spdk_bit_array *ba)
+{
+	uint32_t word_count = bit_array_word_count(ba->bit_count) + 1;
+	uint32_t summary_word_count = bit_array_word_count(word_count);
+	uint32_t i;
+
+	memset(ba->full, 0, summary_word_count * SPDK_BIT_ARRAY_WORD_BYTES);
+	memset(ba->nonzero, 0, summary_word_count * SPDK_BIT_ARRAY_WORD_BYTES);
+
+	for (i = 0; i < word_count; i++) {
+		if (ba->words[i] == SPDK_BIT_ARRAY_WORD_C(-1)) {
+			bit_array_summary_set(ba->full, i);
+		}
+		if (ba->words[i] != 0) {
+			bit_array_summary_set(ba->nonzero, i);
+		}
+	}
+}
+
 int
 spdk_bit_array_resize(struct spdk_bit_array **bap, uint32_t num_bits)
 {
 	struct spdk_bit_array *new_ba;
-	uint32_t old_word_count, new_word_count;
+	uint32_t old_word_count, new_word_count, summary_word_count;
 	size_t new_size;
 
 	/*
@@ -87,6 +142,10 @@ spdk_bit_array_resize(struct spdk_bit_array **bap, uint32_t num_bits)
 	 */
 	new_size += SPDK_BIT_ARRAY_WORD_BYTES;
 
+	/* Followed by the two summaries, covering the extra word too. */
+	summary_word_count = bit_array_word_count(new_word_count + 1);
+	new_size += 2 * summary_word_count * SPDK_BIT_ARRAY_WORD_BYTES;
+
 	new_ba = (struct spdk_bit_array *)spdk_realloc(*bap, new_size, 64);
 	if (!new_ba) {
 		return -ENOMEM;
@@ -123,6 +182,10 @@ spdk_bit_array_resize(struct spdk_bit_array **bap, uint32_t num_bits)
 	}
 
 	new_ba->bit_count = num_bits;
+	new_ba->full = &new_ba->words[new_word_count + 1];
+	new_ba->nonzero = &new_ba->full[summary_word_count];
+	bit_array_update_summary(new_ba);
+
 	*bap = new_ba;
 	return 0;
 }
@@ -169,6 +232,11 @@ spdk_bit_array_set(struct spdk_bit_array *ba, uint32_t bit_index)
 	}
 
 	ba->words[word_index] |= (SPDK_BIT_ARRAY_WORD_C(1) << word_bit_index);
+	if (ba->words[word_index] == SPDK_BIT_ARRAY_WORD_C(-1)) {
+		bit_array_summary_set(ba->full, word_index);
+	}
+	bit_array_summary_set(ba->nonzero, word_index);
+
 	return 0;
 }
 
@@ -186,6 +254,76 @@ spdk_bit_array_clear(struct spdk_bit_array *ba, uint32_t bit_index)
 	}
 
 	ba->words[word_index] &= ~(SPDK_BIT_ARRAY_WORD_C(1) << word_bit_index);
+	bit_array_summary_clear(ba->full, word_index);
+	if (ba->words[word_index] == 0) {
+		bit_array_summary_clear(ba->nonzero, word_index);
+	}
+}
+
+/*
+ * Return the index of the first of words[index..count) that isn't equal to xor_mask.  The caller
+ * guarantees there is one.
+ */
+static inline uint32_t
+bit_array_scan_words(const spdk_bit_array_word *words, uint32_t index, uint32_t count,
+		     spdk_bit_array_word xor_mask)
+{
+#if defined(SPDK_BIT_ARRAY_HAVE_AVX2)
+	const __m256i pattern = _mm256_set1_epi64x((long long)xor_mask);
+	__m256i v;
+
+	for (; index + 4 <= count; index += 4) {
+		v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&words[index]), pattern);
+		if (!_mm256_testz_si256(v, v)) {
+			break;
+		}
+	}
+#elif defined(SPDK_BIT_ARRAY_HAVE_NEON)
+	const uint64x2_t pattern = vdupq_n_u64(xor_mask);
+	uint64x2_t v;
+
+	for (; index + 4 <= count; index += 4) {
+		v = vorrq_u64(veorq_u64(vld1q_u64(&words[index]), pattern),
+			      veorq_u64(vld1q_u64(&words[index + 2]), pattern));
+		if ((vgetq_lane_u64(v, 0) | vgetq_lane_u64(v, 1)) != 0) {
+			break;
+		}
+	}
+#endif
+	while (words[index] == xor_mask) {
+		index++;
+	}
+
+	assert(index < count);
+
+	return index;
+}
+
+/*
+ * Find the first word at or after word_index that isn't all ones (xor_mask == -1) or zeros
+ * (xor_mask == 0), using the summary of the full, or the non-zero words respectively.
+ */
+static inline uint32_t
+bit_array_find_first_word(const struct spdk_bit_array *ba, uint32_t word_index,
+			  spdk_bit_array_word xor_mask)
+{
+	const spdk_bit_array_word *summary = xor_mask ? ba->full : ba->nonzero;
+	uint32_t summary_count = bit_array_word_count(bit_array_word_count(ba->bit_count) + 1);
+	uint32_t summary_index = word_index >> SPDK_BIT_ARRAY_WORD_INDEX_SHIFT;
+	spdk_bit_array_word word;
+
+	/*
+	 * The extra word is neither full nor zero, so its summary bits guarantee that a match is
+	 * found.
+	 */
+	word = (summary[summary_index] ^ xor_mask) &
+	       ~bit_array_word_mask(word_index & SPDK_BIT_ARRAY_WORD_INDEX_MASK);
+	if (word == 0) {
+		summary_index = bit_array_scan_words(summary, summary_index + 1, summary_count, xor_mask);
+		word = summary[summary_index] ^ xor_mask;
+	}
+
+	return (summary_index << SPDK_BIT_ARRAY_WORD_INDEX_SHIFT) + SPDK_BIT_ARRAY_WORD_TZCNT(word);
 }
 
 static inline uint32_t
@@ -215,10 +353,11 @@ bit_array_find_first(const struct spdk_bit_array *ba, uint32_t start_bit_index,
 
 	/*
 	 * spdk_bit_array_resize() guarantees that an extra word with a 1 and a 0 will always be
-	 * at the end of the words[] array, so just keep going until a word matches.
+	 * at the end of the words[] array, so the summary always points at a matching word.
 	 */
-	while (word == 0) {
-		word = *++cur_word ^ xor_mask;
+	if (word == 0) {
+		cur_word = &words[bit_array_find_first_word(ba, word_index + 1, xor_mask)];
+		word = *cur_word ^ xor_mask;
 	}
 
 	return ((uintptr_t)cur_word - (uintptr_t)words) * 8 + SPDK_BIT_ARRAY_WORD_TZCNT(word);
@@ -319,6 +458,8 @@ spdk_bit_array_load_mask(struct spdk_bit_array *ba, const void *mask)
 			spdk_bit_array_clear(ba, i + size * CHAR_BIT);
 		}
 	}
+
+	bit_array_update_summary(ba);
 }
 
 void
@@ -333,6 +474,8 @@ spdk_bit_array_clear_mask(struct spdk_bit_array *ba)
 	for (i = 0; i < num_bits % CHAR_BIT; i++) {
 		spdk_bit_array_clear(ba, i + size * CHAR_BIT);
 	}
+
+	bit_array_update_summary(ba);
 }
 
 struct spdk_bit_pool {
@@ -446,6 +589,25 @@ spdk_bit_pool_allocate_bit(struct spdk_bit_pool *pool)
 	return bit_index;
 }
 
+int
+spdk_bit_pool_allocate_bit_at(struct spdk_bit_pool *pool, uint32_t bit_index)
+{
+	if (bit_index >= spdk_bit_array_capacity(pool->array)) {
+		return -EINVAL;
+	}
+
+	if (spdk_bit_array_get(pool->array, bit_index)) {
+		return -EEXIST;
+	}
+
+	spdk_bit_array_set(pool->array, bit_index);
+	if (pool->lowest_free_bit == bit_index) {
+		pool->lowest_free_bit = spdk_bit_array_find_first_clear(pool->array, bit_index);
+	}
+	pool->free_count--;
+	return 0;
+}
+
 void
 spdk_bit_pool_free_bit(struct spdk_bit_pool *pool, uint32_t bit_index)
 {
@@ -6,6 +6,7 @@
 #include "util_internal.h"
 #include "crc_internal.h"
 #include "spdk/crc32.h"
+#include "spdk/util.h"
 
 #ifdef SPDK_HAVE_ISAL
 
@@ -17,6 +18,56 @@ spdk_crc32c_update(const void *buf, size_t len, uint32_t crc)
 
 #elif defined(SPDK_HAVE_SSE4_2)
 
+#ifdef __PCLMUL__
+/*
+ * The crc32 instruction has a latency of 3 cycles, but a throughput of one per cycle, so large
+ * buffers are processed as three interleaved streams of CRC32C_STREAM_LEN bytes.  The crc of
+ * the first two streams is then shifted over the data that follows them, by multiplying it by
+ * x^(8 * n - 33) mod P (bit-reflected constants below, n being the shift in bytes) and reducing
+ * the product with the crc32 instruction.
+ */
+#define CRC32C_STREAM_LEN	256
+#define CRC32C_SHIFT_1_STREAM	0xb9e02b86
+#define CRC32C_SHIFT_2_STREAMS	0xdd7e3b0c
+
+static inline uint64_t
+crc32c_shift(uint64_t crc, uint32_t constant)
+{
+	__m128i product;
+
+	product = _mm_clmulepi64_si128(_mm_cvtsi64_si128(crc), _mm_cvtsi32_si128(constant), 0);
+
+	return _mm_crc32_u64(0, _mm_cvtsi128_si64(product));
+}
+
+static inline const uint64_t *
+crc32c_update_streams(const uint64_t *dword_buf, size_t *count, uint64_t *crc)
+{
+	const size_t stream_count = CRC32C_STREAM_LEN / 8;
+	uint64_t crc0 = *crc, crc1, crc2;
+	size_t i;
+
+	while (*count >= 3 * stream_count) {
+		crc1 = 0;
+		crc2 = 0;
+		for (i = 0; i < stream_count; i++) {
+			crc0 = _mm_crc32_u64(crc0, dword_buf[i]);
+			crc1 = _mm_crc32_u64(crc1, dword_buf[i + stream_count]);
+			crc2 = _mm_crc32_u64(crc2, dword_buf[i + 2 * stream_count]);
+		}
+
+		crc0 = crc32c_shift(crc0, CRC32C_SHIFT_2_STREAMS) ^
+		       crc32c_shift(crc1, CRC32C_SHIFT_1_STREAM) ^ crc2;
+		dword_buf += 3 * stream_count;
+		*count -= 3 * stream_count;
+	}
+
+	*crc = crc0;
+
+	return dword_buf;
+}
+#endif
+
 uint32_t
 spdk_crc32c_update(const void *buf, size_t len, uint32_t crc)
 {
@@ -28,7 +79,8 @@ spdk_crc32c_update(const void *buf, size_t len, uint32_t crc)
 	 * passed to _mm_crc32_u64 is 8 byte aligned. This can avoid unaligned loads.
 	 */
 	count_pre = ((uint64_t)buf & 7) == 0 ? 0 : 8 - ((uint64_t)buf & 7);
-	count_post = (uint64_t)(buf + len) & 7;
+	count_pre = spdk_min(count_pre, len);
+	count_post = (len - count_pre) & 7;
 	count_mid = (len - count_pre - count_post) / 8;
 
 	while (count_pre--) {
@@ -40,6 +92,9 @@ spdk_crc32c_update(const void *buf, size_t len, uint32_t crc)
 	crc_tmp64 = crc;
 	dword_buf = (const uint64_t *)buf;
 
+#ifdef __PCLMUL__
+	dword_buf = crc32c_update_streams(dword_buf, &count_mid, &crc_tmp64);
+#endif
 	while (count_mid--) {
 		crc_tmp64 = _mm_crc32_u64(crc_tmp64, *dword_buf);
 		dword_buf++;
@@ -67,7 +122,8 @@ spdk_crc32c_update(const void *buf, size_t len, uint32_t crc)
 	 * passed to crc32_cd is 8 byte aligned. This can avoid unaligned loads.
 	 */
 	count_pre = ((uint64_t)buf & 7) == 0 ? 0 : 8 - ((uint64_t)buf & 7);
-	count_post = (uint64_t)(buf + len) & 7;
+	count_pre = spdk_min(count_pre, len);
+	count_post = (len - count_pre) & 7;
 	count_mid = (len - count_pre - count_post) / 8;
 
 	while (count_pre--) {
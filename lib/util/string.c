@@ -377,13 +377,13 @@ spdk_mem_all_zero(const void *data, size_t size)
 {
 	const uint8_t *buf = data;
 
-	while (size--) {
-		if (*buf++ != 0) {
-			return false;
-		}
+	if (size == 0) {
+		return true;
 	}
 
-	return true;
+	/* If the first byte is zero and each byte is equal to the next one, all of them are zero.
+	 * This lets memcmp() do the work, which is vectorized by the C library. */
+	return buf[0] == 0 && memcmp(buf, buf + 1, size - 1) == 0;
 }
 
 long int
@@ -141,5 +141,290 @@ spdk_xor_get_optimal_alignment(void)
 	return SPDK_XOR_BUF_ALIGN;
 }
 
+/* Multiply by the generator 2 in GF(2^8) with the polynomial 0x11d, byte-wise for a word */
+static inline uint64_t
+gf_mul2_u64(uint64_t v)
+{
+	uint64_t hi = (v >> 7) & 0x0101010101010101ULL;
+
+	return ((v << 1) & 0xfefefefefefefefeULL) ^ (hi * 0x1d);
+}
+
+static inline uint8_t
+gf_mul2(uint8_t v)
+{
+	return (v << 1) ^ (v & 0x80 ? 0x1d : 0);
+}
+
+static uint8_t
+gf_mul(uint8_t a, uint8_t b)
+{
+	uint8_t r = 0;
+
+	while (b) {
+		if (b & 1) {
+			r ^= a;
+		}
+		a = gf_mul2(a);
+		b >>= 1;
+	}
+
+	return r;
+}
+
+/* Returns g^e, e may be negative */
+static uint8_t
+gf_exp2(int e)
+{
+	uint8_t r = 1;
+
+	/* The multiplicative group has 255 elements */
+	e %= 255;
+	if (e < 0) {
+		e += 255;
+	}
+
+	while (e-- > 0) {
+		r = gf_mul2(r);
+	}
+
+	return r;
+}
+
+static uint8_t
+gf_inv(uint8_t a)
+{
+	uint8_t r = 1;
+	int i;
+
+	/* a^254 == a^-1 */
+	for (i = 0; i < 254; i++) {
+		r = gf_mul(r, a);
+	}
+
+	return r;
+}
+
+static void
+gf_mul_table(uint8_t table[256], uint8_t c)
+{
+	int i;
+
+	for (i = 0; i < 256; i++) {
+		table[i] = gf_mul(i, c);
+	}
+}
+
+/*
+ * Q is computed with Horner's method, Q = ((D[n-1] * g + D[n-2]) * g + ...) * g + D[0].
+ * P and Q may be one of the sources, each position is written after all sources were read.
+ */
+static void
+pq_gen_unaligned(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	uint32_t i, j;
+
+	for (i = 0; i < len; i++) {
+		uint8_t pb = 0, qb = 0;
+
+		for (j = n; j > 0; j--) {
+			uint8_t b = ((uint8_t *)sources[j - 1])[i];
+
+			pb ^= b;
+			qb = gf_mul2(qb) ^ b;
+		}
+
+		if (p != NULL) {
+			((uint8_t *)p)[i] = pb;
+		}
+		((uint8_t *)q)[i] = qb;
+	}
+}
+
+static void
+pq_gen_basic(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	uint32_t shift;
+	uint32_t len_div, len_rem;
+	uint32_t i, j;
+
+	if (!buffers_aligned(q, sources, n, sizeof(uint64_t)) ||
+	    (p != NULL && !is_aligned(p, sizeof(uint64_t)))) {
+		pq_gen_unaligned(p, q, sources, n, len);
+		return;
+	}
+
+	shift = spdk_u32log2(sizeof(uint64_t));
+	len_div = len >> shift;
+	len_rem = len_div << shift;
+
+	for (i = 0; i < len_div; i++) {
+		uint64_t pw = 0, qw = 0;
+
+		for (j = n; j > 0; j--) {
+			uint64_t w = ((uint64_t *)sources[j - 1])[i];
+
+			pw ^= w;
+			qw = gf_mul2_u64(qw) ^ w;
+		}
+
+		if (p != NULL) {
+			((uint64_t *)p)[i] = pw;
+		}
+		((uint64_t *)q)[i] = qw;
+	}
+
+	if (len_rem < len) {
+		void *sources2[SPDK_XOR_MAX_SRC];
+
+		for (j = 0; j < n; j++) {
+			sources2[j] = sources[j] + len_rem;
+		}
+
+		pq_gen_unaligned(p != NULL ? p + len_rem : NULL, q + len_rem, sources2, n,
+				 len - len_rem);
+	}
+}
+
+#ifdef SPDK_CONFIG_ISAL
+
+static void
+do_pq_gen(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	void *buffers[SPDK_XOR_MAX_SRC + 2];
+
+	if (p != NULL && len % SPDK_XOR_BUF_ALIGN == 0 &&
+	    buffers_aligned(p, sources, n, SPDK_XOR_BUF_ALIGN) &&
+	    is_aligned(q, SPDK_XOR_BUF_ALIGN)) {
+		memcpy(buffers, sources, n * sizeof(buffers[0]));
+		buffers[n] = p;
+		buffers[n + 1] = q;
+
+		if (pq_gen(n + 2, len, buffers) == 0) {
+			return;
+		}
+	}
+
+	pq_gen_basic(p, q, sources, n, len);
+}
+
+#else
+
+static inline void
+do_pq_gen(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	pq_gen_basic(p, q, sources, n, len);
+}
+
+#endif
+
+int
+spdk_pq_gen(void *p, void *q, void **sources, uint32_t n, uint32_t len)
+{
+	if (n < 2 || n > SPDK_XOR_MAX_SRC || q == NULL) {
+		return -EINVAL;
+	}
+
+	do_pq_gen(p, q, sources, n, len);
+
+	return 0;
+}
+
+/* Recovers a lost source from P */
+static void
+pq_recover_from_p(void **sources, void *p, uint32_t n, uint32_t len, uint32_t fail)
+{
+	void *buffers[SPDK_XOR_MAX_SRC];
+
+	memcpy(buffers, sources, n * sizeof(buffers[0]));
+	buffers[fail] = p;
+
+	do_xor_gen(sources[fail], buffers, n, len);
+}
+
+/* Recovers a lost source from Q */
+static void
+pq_recover_from_q(void **sources, void *q, uint32_t n, uint32_t len, uint32_t fail)
+{
+	uint8_t *dest = sources[fail];
+	uint8_t table[256];
+	uint32_t i;
+
+	/* Q of the other sources, then D = (Q + Qx) * g^-fail */
+	memset(dest, 0, len);
+	pq_gen_basic(NULL, dest, sources, n, len);
+
+	gf_mul_table(table, gf_exp2(-(int)fail));
+
+	for (i = 0; i < len; i++) {
+		dest[i] = table[dest[i] ^ ((uint8_t *)q)[i]];
+	}
+}
+
+/* Recovers two lost sources a < b from P and Q */
+static void
+pq_recover_two(void **sources, void *p, void *q, uint32_t n, uint32_t len, uint32_t a,
+	       uint32_t b)
+{
+	uint8_t *da = sources[a], *db = sources[b];
+	uint8_t table_a[256], table_b[256];
+	uint8_t gab, denom;
+	uint32_t i;
+
+	/* P and Q of the other sources */
+	memset(da, 0, len);
+	memset(db, 0, len);
+	pq_gen_basic(da, db, sources, n, len);
+
+	/*
+	 * With Pab = P + Pxy and Qab = Q + Qxy:
+	 * Da = g^(b-a) / (g^(b-a) + 1) * Pab + g^-a / (g^(b-a) + 1) * Qab, Db = Pab + Da
+	 */
+	gab = gf_exp2(b - a);
+	denom = gf_inv(gab ^ 1);
+	gf_mul_table(table_a, gf_mul(gab, denom));
+	gf_mul_table(table_b, gf_mul(gf_exp2(-(int)a), denom));
+
+	for (i = 0; i < len; i++) {
+		uint8_t pab = da[i] ^ ((uint8_t *)p)[i];
+		uint8_t qab = db[i] ^ ((uint8_t *)q)[i];
+
+		da[i] = table_a[pab] ^ table_b[qab];
+		db[i] = pab ^ da[i];
+	}
+}
+
+int
+spdk_pq_recover(void **sources, void *p, void *q, uint32_t n, uint32_t len, uint32_t fail_a,
+		uint32_t fail_b)
+{
+	uint32_t a = spdk_min(fail_a, fail_b);
+	uint32_t b = spdk_max(fail_a, fail_b);
+
+	if (n < 2 || n > SPDK_XOR_MAX_SRC || b > n + 1) {
+		return -EINVAL;
+	}
+
+	if (a == n + 1) {
+		do_pq_gen(NULL, q, sources, n, len);
+	} else if (a == n && b == n) {
+		do_xor_gen(p, sources, n, len);
+	} else if (a == n) {
+		do_pq_gen(p, q, sources, n, len);
+	} else if (b == a || b == n + 1) {
+		pq_recover_from_p(sources, p, n, len, a);
+		if (b == n + 1) {
+			do_pq_gen(NULL, q, sources, n, len);
+		}
+	} else if (b == n) {
+		pq_recover_from_q(sources, q, n, len, a);
+		do_xor_gen(p, sources, n, len);
+	} else {
+		pq_recover_two(sources, p, q, n, len, a, b);
+	}
+
+	return 0;
+}
+
 SPDK_STATIC_ASSERT(SPDK_XOR_BUF_ALIGN > 0 && !(SPDK_XOR_BUF_ALIGN & (SPDK_XOR_BUF_ALIGN - 1)),
 		   "Must be power of 2");
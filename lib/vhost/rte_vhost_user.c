@@ -73,6 +73,35 @@ _vhost_user_sem_destroy(void)
 	sem_destroy(&g_dpdk_sem);
 }
 
+static inline uint64_t
+vhost_session_gpa_to_vva(struct spdk_vhost_session *vsession, uint64_t gpa, uint64_t *len)
+{
+	struct vhost_mem_region_map *map = vsession->mem_map;
+	uint32_t lo = 0, hi = vsession->mem_map_cnt, mid;
+
+	if (spdk_unlikely(map == NULL)) {
+		return rte_vhost_va_from_guest_pa(vsession->mem, gpa, len);
+	}
+
+	/* Find the last region starting at or below gpa */
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		if (map[mid].gpa_start <= gpa) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (spdk_unlikely(hi == 0 || gpa < map[lo].gpa_start || gpa >= map[lo].gpa_end)) {
+		*len = 0;
+		return 0;
+	}
+
+	*len = spdk_min(*len, map[lo].gpa_end - gpa);
+	return gpa + map[lo].vva_offset;
+}
+
 void *
 vhost_gpa_to_vva(struct spdk_vhost_session *vsession, uint64_t addr, uint64_t len)
 {
@@ -80,7 +109,7 @@ vhost_gpa_to_vva(struct spdk_vhost_session *vsession, uint64_t addr, uint64_t le
 	uint64_t newlen;
 
 	newlen = len;
-	vva = (void *)rte_vhost_va_from_guest_pa(vsession->mem, addr, &newlen);
+	vva = (void *)vhost_session_gpa_to_vva(vsession, addr, &newlen);
 	if (newlen != len) {
 		return NULL;
 	}
@@ -362,6 +391,8 @@ vhost_vq_used_signal(struct spdk_vhost_session *vsession,
 		/* interrupt signalled */
 		virtqueue->req_cnt += virtqueue->used_req_cnt;
 		virtqueue->used_req_cnt = 0;
+		virtqueue->irq_cnt++;
+		virtqueue->irq_total++;
 		return 1;
 	} else {
 		/* interrupt not signalled */
@@ -373,20 +404,33 @@ static void
 session_vq_io_stats_update(struct spdk_vhost_session *vsession,
 			   struct spdk_vhost_virtqueue *virtqueue, uint64_t now)
 {
-	uint32_t irq_delay_base = vsession->coalescing_delay_time_base;
+	uint64_t irq_delay_base = vsession->coalescing_delay_time_base;
 	uint32_t io_threshold = vsession->coalescing_io_rate_threshold;
-	int32_t irq_delay;
-	uint32_t req_cnt;
+	uint64_t irq_delay = 0;
+	uint64_t req_rate;
 
-	req_cnt = virtqueue->req_cnt + virtqueue->used_req_cnt;
-	if (req_cnt <= io_threshold) {
-		return;
-	}
+	/* Average the rate, so that short bursts don't toggle coalescing back and forth */
+	req_rate = (uint64_t)virtqueue->req_rate * (SPDK_VHOST_COALESCING_RATE_WEIGHT - 1);
+	virtqueue->req_rate = (req_rate + virtqueue->req_cnt) / SPDK_VHOST_COALESCING_RATE_WEIGHT;
 
-	irq_delay = (irq_delay_base * (req_cnt - io_threshold)) / io_threshold;
-	virtqueue->irq_delay_time = (uint32_t) spdk_max(0, irq_delay);
+	/* Below the threshold, delaying interrupts would only add latency */
+	if (virtqueue->req_rate > io_threshold) {
+		irq_delay = irq_delay_base * (virtqueue->req_rate - io_threshold) / io_threshold;
+		irq_delay = spdk_min(irq_delay,
+				     irq_delay_base * SPDK_VHOST_COALESCING_MAX_DELAY_FACTOR);
 
+		/* If the current delay hardly batched any completions into a single interrupt, it
+		 * mostly added latency.  Back off instead of growing it further.
+		 */
+		if (virtqueue->irq_delay_time != 0 && virtqueue->irq_cnt != 0 &&
+		    virtqueue->req_cnt < virtqueue->irq_cnt * 2) {
+			irq_delay = spdk_min(irq_delay, virtqueue->irq_delay_time / 2);
+		}
+	}
+
+	virtqueue->irq_delay_time = (uint32_t)spdk_min(irq_delay, UINT32_MAX);
 	virtqueue->req_cnt = 0;
+	virtqueue->irq_cnt = 0;
 	virtqueue->next_event_time = now;
 }
 
@@ -394,11 +438,11 @@ static void
 check_session_vq_io_stats(struct spdk_vhost_session *vsession,
 			  struct spdk_vhost_virtqueue *virtqueue, uint64_t now)
 {
-	if (now < vsession->next_stats_check_time) {
+	if (now < virtqueue->next_stats_check_time) {
 		return;
 	}
 
-	vsession->next_stats_check_time = now + vsession->stats_check_interval;
+	virtqueue->next_stats_check_time = now + vsession->stats_check_interval;
 	session_vq_io_stats_update(vsession, virtqueue, now);
 }
 
@@ -642,7 +686,7 @@ vhost_vring_desc_payload_to_iov(struct spdk_vhost_session *vsession, struct iove
 			return -1;
 		}
 		len = remaining;
-		vva = (uintptr_t)rte_vhost_va_from_guest_pa(vsession->mem, payload, &len);
+		vva = (uintptr_t)vhost_session_gpa_to_vva(vsession, payload, &len);
 		if (vva == 0 || len == 0) {
 			SPDK_ERRLOG("gpa_to_vva(%p) == NULL\n", (void *)payload);
 			return -1;
@@ -824,6 +868,61 @@ vhost_memory_changed(struct rte_vhost_memory *new,
 	return false;
 }
 
+static int
+vhost_mem_region_map_cmp(const void *_a, const void *_b)
+{
+	const struct vhost_mem_region_map *a = _a, *b = _b;
+
+	if (a->gpa_start < b->gpa_start) {
+		return -1;
+	}
+
+	return a->gpa_start > b->gpa_start;
+}
+
+static void
+vhost_session_mem_set(struct spdk_vhost_session *vsession, struct rte_vhost_memory *mem)
+{
+	struct rte_vhost_mem_region *region;
+	uint32_t i;
+
+	vsession->mem = mem;
+	vhost_session_mem_register(mem);
+
+	/* Without the map, translations fall back to rte_vhost_va_from_guest_pa() */
+	vsession->mem_map = calloc(spdk_max(mem->nregions, 1), sizeof(*vsession->mem_map));
+	if (vsession->mem_map == NULL) {
+		SPDK_WARNLOG("%s: failed to allocate guest memory map\n", vsession->name);
+		return;
+	}
+
+	for (i = 0; i < mem->nregions; i++) {
+		region = &mem->regions[i];
+		vsession->mem_map[i].gpa_start = region->guest_phys_addr;
+		vsession->mem_map[i].gpa_end = region->guest_phys_addr + region->size;
+		vsession->mem_map[i].vva_offset = region->host_user_addr - region->guest_phys_addr;
+	}
+
+	qsort(vsession->mem_map, mem->nregions, sizeof(*vsession->mem_map),
+	      vhost_mem_region_map_cmp);
+	vsession->mem_map_cnt = mem->nregions;
+}
+
+static void
+vhost_session_mem_free(struct spdk_vhost_session *vsession)
+{
+	if (vsession->mem == NULL) {
+		return;
+	}
+
+	vhost_session_mem_unregister(vsession->mem);
+	free(vsession->mem);
+	vsession->mem = NULL;
+	free(vsession->mem_map);
+	vsession->mem_map = NULL;
+	vsession->mem_map_cnt = 0;
+}
+
 static int
 vhost_register_memtable_if_required(struct spdk_vhost_session *vsession, int vid)
 {
@@ -836,18 +935,14 @@ vhost_register_memtable_if_required(struct spdk_vhost_session *vsession, int vid
 
 	if (vsession->mem == NULL) {
 		SPDK_INFOLOG(vhost, "Start to set memtable\n");
-		vsession->mem = new_mem;
-		vhost_session_mem_register(vsession->mem);
+		vhost_session_mem_set(vsession, new_mem);
 		return 0;
 	}
 
 	if (vhost_memory_changed(new_mem, vsession->mem)) {
 		SPDK_INFOLOG(vhost, "Memtable is changed\n");
-		vhost_session_mem_unregister(vsession->mem);
-		free(vsession->mem);
-
-		vsession->mem = new_mem;
-		vhost_session_mem_register(vsession->mem);
+		vhost_session_mem_free(vsession);
+		vhost_session_mem_set(vsession, new_mem);
 		return 0;
 
 	}
@@ -966,7 +1061,6 @@ new_connection(int vid)
 		return -1;
 	}
 	vsession->started = false;
-	vsession->next_stats_check_time = 0;
 	vsession->stats_check_interval = SPDK_VHOST_STATS_CHECK_INTERVAL_MS *
 					 spdk_get_ticks_hz() / 1000UL;
 	TAILQ_INSERT_TAIL(&user_dev->vsessions, vsession, tailq);
@@ -1206,10 +1300,7 @@ destroy_connection(int vid)
 		}
 	}
 
-	if (vsession->mem) {
-		vhost_session_mem_unregister(vsession->mem);
-		free(vsession->mem);
-	}
+	vhost_session_mem_free(vsession);
 
 	TAILQ_REMOVE(&to_user_dev(vsession->vdev)->vsessions, vsession, tailq);
 	free(vsession->name);
@@ -1837,10 +1928,7 @@ vhost_user_dev_unregister(struct spdk_vhost_dev *vdev)
 		TAILQ_FOREACH_SAFE(vsession, &user_dev->vsessions, tailq, tmp_vsession) {
 			assert(vsession->started == false);
 			TAILQ_REMOVE(&user_dev->vsessions, vsession, tailq);
-			if (vsession->mem) {
-				vhost_session_mem_unregister(vsession->mem);
-				free(vsession->mem);
-			}
+			vhost_session_mem_free(vsession);
 			free(vsession->name);
 			free(vsession);
 		}
@@ -1951,6 +2039,32 @@ vhost_user_fini(spdk_vhost_fini_cb vhost_cb)
 	pthread_detach(tid);
 }
 
+static void
+vhost_session_vq_info_json(struct spdk_vhost_session *vsession, struct spdk_json_write_ctx *w)
+{
+	struct spdk_vhost_virtqueue *vq;
+	uint64_t ticks_hz = spdk_get_ticks_hz();
+	uint16_t i;
+
+	spdk_json_write_named_array_begin(w, "virtqueues");
+	for (i = 0; i < vsession->max_queues; i++) {
+		vq = &vsession->virtqueue[i];
+		if (vq->vring.desc == NULL) {
+			continue;
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "id", i);
+		spdk_json_write_named_uint64(w, "iops", (uint64_t)vq->req_rate * 1000 /
+					     SPDK_VHOST_STATS_CHECK_INTERVAL_MS);
+		spdk_json_write_named_uint64(w, "irq_delay_us", (uint64_t)vq->irq_delay_time *
+					     SPDK_SEC_TO_USEC / ticks_hz);
+		spdk_json_write_named_uint64(w, "irqs", vq->irq_total);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+}
+
 void
 vhost_session_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx *w)
 {
@@ -1967,6 +2081,9 @@ vhost_session_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx
 		spdk_json_write_named_bool(w, "started", vsession->started);
 		spdk_json_write_named_uint32(w, "max_queues", vsession->max_queues);
 		spdk_json_write_named_uint32(w, "inflight_task_cnt", vsession->task_cnt);
+		if (vsession->started) {
+			vhost_session_vq_info_json(vsession, w);
+		}
 		spdk_json_write_object_end(w);
 	}
 	pthread_mutex_unlock(&user_dev->lock);
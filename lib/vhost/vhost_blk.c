@@ -60,6 +60,22 @@ struct spdk_vhost_blk_dev {
 	/* dummy_io_channel is used to hold a bdev reference */
 	struct spdk_io_channel *dummy_io_channel;
 	bool readonly;
+
+	/* Number of threads polling the virtqueues of a session, virtqueue N is polled by
+	 * thread N % num_vq_threads. The first one is the thread of the device, vq_threads holds
+	 * the other ones, created along with the device.
+	 */
+	uint32_t num_vq_threads;
+	struct spdk_thread **vq_threads;
+};
+
+/* Polls a subset of the virtqueues of a session on one of the device's vq_threads */
+struct vhost_blk_vq_worker {
+	struct spdk_vhost_blk_session *bvsession;
+	struct spdk_thread *thread;
+	struct spdk_poller *poller;
+	struct spdk_io_channel *io_channel;
+	uint16_t first_vq;
 };
 
 struct spdk_vhost_blk_session {
@@ -69,6 +85,13 @@ struct spdk_vhost_blk_session {
 	struct spdk_poller *requestq_poller;
 	struct spdk_io_channel *io_channel;
 	struct spdk_poller *stop_poller;
+
+	/* Set if the virtqueues are polled by multiple threads */
+	struct vhost_blk_vq_worker *workers;
+	uint32_t num_workers;
+	/* Number of workers that haven't processed the request to stop yet */
+	uint32_t num_active_workers;
+	bool workers_stopping;
 };
 
 /* forward declaration */
@@ -77,13 +100,26 @@ static const struct spdk_vhost_dev_backend vhost_blk_device_backend;
 static void vhost_user_blk_request_finish(uint8_t status, struct spdk_vhost_blk_task *task,
 		void *cb_arg);
 
+static struct vhost_blk_vq_worker *
+vq_to_worker(struct spdk_vhost_blk_session *bvsession, struct spdk_vhost_virtqueue *vq)
+{
+	uint16_t qid = vq - bvsession->vsession.virtqueue;
+
+	return &bvsession->workers[qid % bvsession->num_workers];
+}
+
 static int
 vhost_user_process_blk_request(struct spdk_vhost_user_blk_task *user_task)
 {
 	struct spdk_vhost_blk_session *bvsession = user_task->bvsession;
 	struct spdk_vhost_dev *vdev = &bvsession->bvdev->vdev;
+	struct spdk_io_channel *ch = bvsession->io_channel;
+
+	if (bvsession->workers != NULL) {
+		ch = vq_to_worker(bvsession, user_task->vq)->io_channel;
+	}
 
-	return virtio_blk_process_request(vdev, bvsession->io_channel, &user_task->blk_task,
+	return virtio_blk_process_request(vdev, ch, &user_task->blk_task,
 					  vhost_user_blk_request_finish, NULL);
 }
 
@@ -119,11 +155,27 @@ to_blk_session(struct spdk_vhost_session *vsession)
 	return (struct spdk_vhost_blk_session *)vsession;
 }
 
+static void
+blk_task_get(struct spdk_vhost_user_blk_task *task)
+{
+	/* Tasks of a session are counted from multiple threads if its virtqueues are polled
+	 * by them */
+	if (task->bvsession->workers != NULL) {
+		__atomic_fetch_add(&task->bvsession->vsession.task_cnt, 1, __ATOMIC_RELAXED);
+	} else {
+		task->bvsession->vsession.task_cnt++;
+	}
+}
+
 static void
 blk_task_finish(struct spdk_vhost_user_blk_task *task)
 {
 	assert(task->bvsession->vsession.task_cnt > 0);
-	task->bvsession->vsession.task_cnt--;
+	if (task->bvsession->workers != NULL) {
+		__atomic_fetch_sub(&task->bvsession->vsession.task_cnt, 1, __ATOMIC_RELAXED);
+	} else {
+		task->bvsession->vsession.task_cnt--;
+	}
 	task->used = false;
 }
 
@@ -654,7 +706,7 @@ process_blk_task(struct spdk_vhost_virtqueue *vq, uint16_t req_idx)
 		return;
 	}
 
-	task->bvsession->vsession.task_cnt++;
+	blk_task_get(task);
 
 	blk_task_init(task);
 
@@ -719,7 +771,7 @@ process_packed_blk_task(struct spdk_vhost_virtqueue *vq, uint16_t req_idx)
 					   req_idx, (req_idx + num_descs - 1) % vq->vring.size,
 					   &task->inflight_head);
 
-	task->bvsession->vsession.task_cnt++;
+	blk_task_get(task);
 
 	blk_task_init(task);
 
@@ -780,7 +832,7 @@ process_packed_inflight_blk_task(struct spdk_vhost_virtqueue *vq,
 	/* It's for cleaning inflight entries */
 	task->inflight_head = req_idx;
 
-	task->bvsession->vsession.task_cnt++;
+	blk_task_get(task);
 
 	blk_task_init(task);
 
@@ -942,6 +994,128 @@ vdev_worker(void *arg)
 	return rc > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 }
 
+static int
+vq_worker_poll(void *arg)
+{
+	struct vhost_blk_vq_worker *worker = arg;
+	struct spdk_vhost_blk_session *bvsession = worker->bvsession;
+	struct spdk_vhost_session *vsession = &bvsession->vsession;
+	uint16_t q_idx;
+	int rc = 0;
+
+	for (q_idx = worker->first_vq; q_idx < vsession->max_queues;
+	     q_idx += bvsession->num_workers) {
+		rc += _vdev_vq_worker(&vsession->virtqueue[q_idx]);
+	}
+
+	return rc > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static void
+vq_worker_start(void *arg)
+{
+	struct vhost_blk_vq_worker *worker = arg;
+	struct spdk_vhost_blk_session *bvsession = worker->bvsession;
+
+	worker->io_channel = vhost_blk_get_io_channel(&bvsession->bvdev->vdev);
+	if (!worker->io_channel) {
+		SPDK_ERRLOG("%s: I/O channel allocation failed, virtqueues from %"PRIu16
+			    " won't be polled\n", bvsession->vsession.name, worker->first_vq);
+		return;
+	}
+
+	worker->poller = SPDK_POLLER_REGISTER(vq_worker_poll, worker, 0);
+	SPDK_INFOLOG(vhost, "%s: started poller for virtqueues from %"PRIu16" on lcore %d\n",
+		     bvsession->vsession.name, worker->first_vq, spdk_env_get_current_core());
+}
+
+static void
+vq_worker_stop(void *arg)
+{
+	struct vhost_blk_vq_worker *worker = arg;
+
+	spdk_poller_unregister(&worker->poller);
+	/* The worker might be freed as soon as the counter drops to zero */
+	__atomic_fetch_sub(&worker->bvsession->num_active_workers, 1, __ATOMIC_RELEASE);
+}
+
+static void
+vq_worker_put_io_channel(void *arg)
+{
+	vhost_blk_put_io_channel(arg);
+}
+
+static int
+vhost_blk_start_workers(struct spdk_vhost_blk_session *bvsession)
+{
+	struct spdk_vhost_blk_dev *bvdev = bvsession->bvdev;
+	struct vhost_blk_vq_worker *worker;
+	uint32_t i;
+
+	/* Virtqueues enabled after the session is started are picked up by their workers */
+	bvsession->num_workers = bvdev->num_vq_threads;
+	bvsession->workers = calloc(bvsession->num_workers, sizeof(*bvsession->workers));
+	if (!bvsession->workers) {
+		return -ENOMEM;
+	}
+
+	bvsession->num_active_workers = bvsession->num_workers;
+	for (i = 0; i < bvsession->num_workers; i++) {
+		worker = &bvsession->workers[i];
+		worker->bvsession = bvsession;
+		worker->thread = i == 0 ? bvdev->vdev.thread : bvdev->vq_threads[i - 1];
+		worker->first_vq = i;
+		spdk_thread_send_msg(worker->thread, vq_worker_start, worker);
+	}
+
+	return 0;
+}
+
+/* Called on the device thread, after the workers stopped polling and all tasks completed */
+static void
+vhost_blk_put_worker_channels(struct spdk_vhost_blk_session *bvsession)
+{
+	struct vhost_blk_vq_worker *worker;
+	uint32_t i;
+
+	for (i = 0; i < bvsession->num_workers; i++) {
+		worker = &bvsession->workers[i];
+		if (worker->io_channel) {
+			spdk_thread_send_msg(worker->thread, vq_worker_put_io_channel,
+					     worker->io_channel);
+			worker->io_channel = NULL;
+		}
+	}
+}
+
+static void
+vhost_blk_stop_workers(struct spdk_vhost_blk_session *bvsession)
+{
+	uint32_t i;
+
+	if (bvsession->workers_stopping) {
+		return;
+	}
+
+	bvsession->workers_stopping = true;
+	for (i = 0; i < bvsession->num_workers; i++) {
+		spdk_thread_send_msg(bvsession->workers[i].thread, vq_worker_stop,
+				     &bvsession->workers[i]);
+	}
+}
+
+static bool
+vhost_blk_workers_active(struct spdk_vhost_blk_session *bvsession)
+{
+	return __atomic_load_n(&bvsession->num_active_workers, __ATOMIC_ACQUIRE) != 0;
+}
+
+static int
+vhost_blk_task_cnt(struct spdk_vhost_blk_session *bvsession)
+{
+	return __atomic_load_n(&bvsession->vsession.task_cnt, __ATOMIC_RELAXED);
+}
+
 static void
 no_bdev_process_vq(struct spdk_vhost_blk_session *bvsession, struct spdk_vhost_virtqueue *vq)
 {
@@ -1022,9 +1196,12 @@ _no_bdev_vdev_vq_worker(struct spdk_vhost_virtqueue *vq)
 
 	vhost_session_vq_used_signal(vq);
 
-	if (vsession->task_cnt == 0 && bvsession->io_channel) {
-		vhost_blk_put_io_channel(bvsession->io_channel);
-		bvsession->io_channel = NULL;
+	if (vhost_blk_task_cnt(bvsession) == 0) {
+		if (bvsession->io_channel) {
+			vhost_blk_put_io_channel(bvsession->io_channel);
+			bvsession->io_channel = NULL;
+		}
+		vhost_blk_put_worker_channels(bvsession);
 	}
 
 	return SPDK_POLLER_BUSY;
@@ -1045,6 +1222,12 @@ no_bdev_vdev_worker(void *arg)
 	struct spdk_vhost_session *vsession = &bvsession->vsession;
 	uint16_t q_idx;
 
+	if (vhost_blk_workers_active(bvsession) ||
+	    (bvsession->workers && vhost_blk_task_cnt(bvsession) > 0)) {
+		/* The virtqueues are still used by the workers, or by the tasks they submitted */
+		return SPDK_POLLER_BUSY;
+	}
+
 	for (q_idx = 0; q_idx < vsession->max_queues; q_idx++) {
 		_no_bdev_vdev_vq_worker(&vsession->virtqueue[q_idx]);
 	}
@@ -1182,8 +1365,11 @@ vhost_user_session_bdev_remove_cb(struct spdk_vhost_dev *vdev,
 	int rc;
 
 	bvsession = to_blk_session(vsession);
-	if (bvsession->requestq_poller) {
+	if (bvsession->requestq_poller || (bvsession->workers && !bvsession->workers_stopping)) {
 		spdk_poller_unregister(&bvsession->requestq_poller);
+		if (bvsession->workers) {
+			vhost_blk_stop_workers(bvsession);
+		}
 		if (vsession->interrupt_mode) {
 			vhost_blk_session_unregister_interrupts(bvsession);
 			rc = vhost_blk_session_register_no_bdev_interrupts(bvsession);
@@ -1320,10 +1506,10 @@ vhost_blk_start(struct spdk_vhost_dev *vdev,
 {
 	struct spdk_vhost_blk_session *bvsession = to_blk_session(vsession);
 	struct spdk_vhost_blk_dev *bvdev;
-	int i;
+	int i, rc;
 
 	/* return if start is already in progress */
-	if (bvsession->requestq_poller) {
+	if (bvsession->requestq_poller || bvsession->workers) {
 		SPDK_INFOLOG(vhost, "%s: start in progress\n", vsession->name);
 		return -EINPROGRESS;
 	}
@@ -1343,6 +1529,18 @@ vhost_blk_start(struct spdk_vhost_dev *vdev,
 	assert(bvdev != NULL);
 	bvsession->bvdev = bvdev;
 
+	/* The virtqueues are spread over multiple threads only in polling mode */
+	if (bvdev->bdev && bvdev->num_vq_threads > 1 && !spdk_interrupt_mode_is_enabled()) {
+		rc = vhost_blk_start_workers(bvsession);
+		if (rc != 0) {
+			free_task_pool(bvsession);
+			SPDK_ERRLOG("%s: failed to start virtqueue workers\n", vsession->name);
+			return -1;
+		}
+
+		return 0;
+	}
+
 	if (bvdev->bdev) {
 		bvsession->io_channel = vhost_blk_get_io_channel(vdev);
 		if (!bvsession->io_channel) {
@@ -1374,7 +1572,8 @@ destroy_session_poller_cb(void *arg)
 	struct spdk_vhost_user_dev *user_dev = to_user_dev(vsession->vdev);
 	int i;
 
-	if (vsession->task_cnt > 0 || (pthread_mutex_trylock(&user_dev->lock) != 0)) {
+	if (vhost_blk_task_cnt(bvsession) > 0 || vhost_blk_workers_active(bvsession) ||
+	    (pthread_mutex_trylock(&user_dev->lock) != 0)) {
 		assert(vsession->stop_retry_count > 0);
 		vsession->stop_retry_count--;
 		if (vsession->stop_retry_count == 0) {
@@ -1400,6 +1599,14 @@ destroy_session_poller_cb(void *arg)
 		bvsession->io_channel = NULL;
 	}
 
+	if (bvsession->workers) {
+		vhost_blk_put_worker_channels(bvsession);
+		free(bvsession->workers);
+		bvsession->workers = NULL;
+		bvsession->num_workers = 0;
+		bvsession->workers_stopping = false;
+	}
+
 	free_task_pool(bvsession);
 	spdk_poller_unregister(&bvsession->stop_poller);
 	vhost_user_session_stop_done(vsession, 0);
@@ -1420,6 +1627,9 @@ vhost_blk_stop(struct spdk_vhost_dev *vdev,
 	}
 
 	spdk_poller_unregister(&bvsession->requestq_poller);
+	if (bvsession->workers) {
+		vhost_blk_stop_workers(bvsession);
+	}
 	vhost_blk_session_unregister_interrupts(bvsession);
 
 	/* vhost_user_session_send_event timeout is 3 seconds, here set retry within 4 seconds */
@@ -1448,6 +1658,7 @@ vhost_blk_dump_info_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_ctx
 		spdk_json_write_null(w);
 	}
 	spdk_json_write_named_string(w, "transport", bvdev->ops->name);
+	spdk_json_write_named_uint32(w, "vq_threads", spdk_max(bvdev->num_vq_threads, 1));
 
 	spdk_json_write_object_end(w);
 }
@@ -1474,6 +1685,9 @@ vhost_blk_write_config_json(struct spdk_vhost_dev *vdev, struct spdk_json_write_
 				     spdk_cpuset_fmt(spdk_thread_get_cpumask(vdev->thread)));
 	spdk_json_write_named_bool(w, "readonly", bvdev->readonly);
 	spdk_json_write_named_string(w, "transport", bvdev->ops->name);
+	if (bvdev->num_vq_threads > 1) {
+		spdk_json_write_named_uint32(w, "vq_threads", bvdev->num_vq_threads);
+	}
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
@@ -1763,20 +1977,82 @@ struct rpc_vhost_blk {
 	bool readonly;
 	bool packed_ring;
 	bool packed_ring_recovery;
+	uint32_t vq_threads;
 };
 
 static const struct spdk_json_object_decoder rpc_construct_vhost_blk[] = {
 	{"readonly", offsetof(struct rpc_vhost_blk, readonly), spdk_json_decode_bool, true},
 	{"packed_ring", offsetof(struct rpc_vhost_blk, packed_ring), spdk_json_decode_bool, true},
 	{"packed_ring_recovery", offsetof(struct rpc_vhost_blk, packed_ring_recovery), spdk_json_decode_bool, true},
+	{"vq_threads", offsetof(struct rpc_vhost_blk, vq_threads), spdk_json_decode_uint32, true},
 };
 
+static void
+vhost_blk_vq_thread_exit(void *arg)
+{
+	spdk_thread_exit(spdk_get_thread());
+}
+
+static void
+vhost_blk_destroy_vq_threads(struct spdk_vhost_blk_dev *bvdev)
+{
+	uint32_t i;
+
+	for (i = 0; i + 1 < bvdev->num_vq_threads; i++) {
+		spdk_thread_send_msg(bvdev->vq_threads[i], vhost_blk_vq_thread_exit, NULL);
+	}
+
+	free(bvdev->vq_threads);
+	bvdev->vq_threads = NULL;
+	bvdev->num_vq_threads = 1;
+}
+
+static int
+vhost_blk_create_vq_threads(struct spdk_vhost_blk_dev *bvdev, const char *name,
+			    struct spdk_cpuset *cpumask, uint32_t num_vq_threads)
+{
+	struct spdk_thread *thread;
+	char *thread_name;
+
+	bvdev->num_vq_threads = 1;
+	if (num_vq_threads <= 1) {
+		return 0;
+	}
+
+	bvdev->vq_threads = calloc(num_vq_threads - 1, sizeof(*bvdev->vq_threads));
+	if (!bvdev->vq_threads) {
+		return -ENOMEM;
+	}
+
+	for (; bvdev->num_vq_threads < num_vq_threads; bvdev->num_vq_threads++) {
+		thread_name = spdk_sprintf_alloc("%s.vq%"PRIu32, name, bvdev->num_vq_threads);
+		if (!thread_name) {
+			goto err;
+		}
+
+		/* Like the thread of the device, it's placed by the scheduler within the cpumask */
+		thread = spdk_thread_create(thread_name, cpumask);
+		free(thread_name);
+		bvdev->vq_threads[bvdev->num_vq_threads - 1] = thread;
+		if (!thread) {
+			goto err;
+		}
+	}
+
+	return 0;
+err:
+	SPDK_ERRLOG("%s: failed to create virtqueue threads\n", name);
+	vhost_blk_destroy_vq_threads(bvdev);
+	return -EIO;
+}
+
 static int
 vhost_user_blk_create_ctrlr(struct spdk_vhost_dev *vdev, struct spdk_cpuset *cpumask,
 			    const char *address, const struct spdk_json_val *params, void *custom_opts)
 {
 	struct rpc_vhost_blk req = {0};
 	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
+	int rc;
 
 	assert(bvdev != NULL);
 
@@ -1798,13 +2074,38 @@ vhost_user_blk_create_ctrlr(struct spdk_vhost_dev *vdev, struct spdk_cpuset *cpu
 		bvdev->readonly = req.readonly;
 	}
 
-	return vhost_user_dev_register(vdev, address, cpumask, custom_opts);
+	if (req.vq_threads > SPDK_VHOST_MAX_VQUEUES) {
+		SPDK_ERRLOG("%s: vq_threads can't exceed %u\n", address, SPDK_VHOST_MAX_VQUEUES);
+		return -EINVAL;
+	}
+
+	rc = vhost_blk_create_vq_threads(bvdev, address, cpumask, req.vq_threads);
+	if (rc != 0) {
+		return rc;
+	}
+
+	rc = vhost_user_dev_register(vdev, address, cpumask, custom_opts);
+	if (rc != 0) {
+		vhost_blk_destroy_vq_threads(bvdev);
+	}
+
+	return rc;
 }
 
 static int
 vhost_user_blk_destroy_ctrlr(struct spdk_vhost_dev *vdev)
 {
-	return vhost_user_dev_unregister(vdev);
+	struct spdk_vhost_blk_dev *bvdev = to_blk_dev(vdev);
+	int rc;
+
+	assert(bvdev != NULL);
+
+	rc = vhost_user_dev_unregister(vdev);
+	if (rc == 0) {
+		vhost_blk_destroy_vq_threads(bvdev);
+	}
+
+	return rc;
 }
 
 static void
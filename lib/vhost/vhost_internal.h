@@ -36,6 +36,17 @@
  */
 #define SPDK_VHOST_VQ_IOPS_COALESCING_THRESHOLD 60000
 
+/*
+ * Weight of the request rate history used for interrupt coalescing.
+ * The rate is averaged over roughly this many stats check intervals.
+ */
+#define SPDK_VHOST_COALESCING_RATE_WEIGHT 4
+
+/*
+ * Maximum interrupt delay, as a multiple of the coalescing delay base.
+ */
+#define SPDK_VHOST_COALESCING_MAX_DELAY_FACTOR 4
+
 /*
  * Currently coalescing is not used by default.
  * Setting this to value > 0 here or by RPC will enable coalescing.
@@ -89,12 +100,24 @@ struct spdk_vhost_virtqueue {
 	/* Request count from last event */
 	uint16_t used_req_cnt;
 
+	/* Interrupt count from last stats check */
+	uint32_t irq_cnt;
+
+	/* Averaged request count per stats check interval */
+	uint32_t req_rate;
+
 	/* How long interrupt is delayed */
 	uint32_t irq_delay_time;
 
 	/* Next time when we need to send event */
 	uint64_t next_event_time;
 
+	/* Next time when stats for event coalescing will be checked. */
+	uint64_t next_stats_check_time;
+
+	/* Total number of interrupts sent to the guest */
+	uint64_t irq_total;
+
 	/* Associated vhost_virtqueue in the virtio device's virtqueue list */
 	uint32_t vring_idx;
 
@@ -103,6 +126,14 @@ struct spdk_vhost_virtqueue {
 	struct spdk_interrupt *intr;
 } __attribute((aligned(SPDK_CACHE_LINE_SIZE)));
 
+/* Guest memory region, as laid out for address translations */
+struct vhost_mem_region_map {
+	uint64_t gpa_start;
+	uint64_t gpa_end;
+	/* Host virtual address of the region minus its guest physical address */
+	uint64_t vva_offset;
+};
+
 struct spdk_vhost_session {
 	struct spdk_vhost_dev *vdev;
 
@@ -119,6 +150,12 @@ struct spdk_vhost_session {
 
 	struct rte_vhost_memory *mem;
 
+	/* Regions of mem sorted by guest physical address. It's only rebuilt
+	 * while the session is stopped, so the pollers can look it up lock-free.
+	 */
+	struct vhost_mem_region_map *mem_map;
+	uint32_t mem_map_cnt;
+
 	int task_cnt;
 
 	uint16_t max_queues;
@@ -129,9 +166,6 @@ struct spdk_vhost_session {
 	uint32_t coalescing_delay_time_base;
 	uint32_t coalescing_io_rate_threshold;
 
-	/* Next time when stats for event coalescing will be checked. */
-	uint64_t next_stats_check_time;
-
 	/* Interval used for event coalescing checking. */
 	uint64_t stats_check_interval;
 
@@ -31,6 +31,48 @@ vring_desc_init(struct vring_desc *dp, uint16_t n)
 	dp[i].next = VQ_RING_DESC_CHAIN_END;
 }
 
+static inline uint16_t
+vring_packed_avail_used_flags(bool wrap_counter)
+{
+	return wrap_counter ? (1 << VRING_PACKED_DESC_F_AVAIL) : (1 << VRING_PACKED_DESC_F_USED);
+}
+
+static void
+virtio_init_vring_packed(struct virtqueue *vq)
+{
+	struct vring_packed *vr = &vq->vq_packed_ring;
+	uint8_t *ring_mem = vq->vq_ring_virt_mem;
+	uint16_t i;
+
+	vr->desc = (struct vring_packed_desc *)ring_mem;
+	vr->driver = (struct vring_packed_desc_event *)(vr->desc + vq->vq_nentries);
+	vr->device = vr->driver + 1;
+
+	vq->vq_used_cons_idx = 0;
+	vq->vq_avail_idx = 0;
+	vq->vq_free_cnt = vq->vq_nentries;
+	vq->avail_wrap_counter = true;
+	vq->used_wrap_counter = true;
+	vq->avail_used_flags = vring_packed_avail_used_flags(true);
+	vq->req_start = VQ_RING_DESC_CHAIN_END;
+	vq->req_end = VQ_RING_DESC_CHAIN_END;
+	vq->descs_finished = 0;
+	memset(vq->vq_descx, 0, sizeof(struct vq_desc_extra) * vq->vq_nentries);
+
+	/* Buffer ids are handed out from a free list kept in vq_descx */
+	for (i = 0; i < vq->vq_nentries - 1; i++) {
+		vq->vq_descx[i].next = i + 1;
+	}
+	vq->vq_descx[i].next = VQ_RING_DESC_CHAIN_END;
+	vq->vq_desc_head_idx = 0;
+	vq->vq_desc_tail_idx = VQ_RING_DESC_CHAIN_END;
+
+	/* Tell the backend not to interrupt us. This doesn't depend on
+	 * F_EVENT_IDX, as packed rings can always disable events entirely.
+	 */
+	vr->driver->flags = VRING_PACKED_EVENT_FLAG_DISABLE;
+}
+
 static void
 virtio_init_vring(struct virtqueue *vq)
 {
@@ -42,6 +84,11 @@ virtio_init_vring(struct virtqueue *vq)
 	 * Reinitialise since virtio port might have been stopped and restarted
 	 */
 	memset(ring_mem, 0, vq->vq_ring_size);
+	if (vq->vq_packed) {
+		virtio_init_vring_packed(vq);
+		return;
+	}
+
 	vring_init(vr, size, ring_mem, VIRTIO_PCI_VRING_ALIGN);
 	vq->vq_used_cons_idx = 0;
 	vq->vq_desc_head_idx = 0;
@@ -87,7 +134,8 @@ virtio_init_queue(struct virtio_dev *dev, uint16_t vtpci_queue_idx)
 		return -EINVAL;
 	}
 
-	if (!spdk_u32_is_pow2(vq_size)) {
+	/* Only split virtqueues are required to be a power of 2 in size */
+	if (!virtio_dev_has_feature(dev, VIRTIO_F_RING_PACKED) && !spdk_u32_is_pow2(vq_size)) {
 		SPDK_ERRLOG("virtqueue %"PRIu16" size (%u) is not powerof 2\n",
 			    vtpci_queue_idx, vq_size);
 		return -EINVAL;
@@ -105,11 +153,17 @@ virtio_init_queue(struct virtio_dev *dev, uint16_t vtpci_queue_idx)
 	vq->vdev = dev;
 	vq->vq_queue_index = vtpci_queue_idx;
 	vq->vq_nentries = vq_size;
+	vq->vq_packed = virtio_dev_has_feature(dev, VIRTIO_F_RING_PACKED);
 
 	/*
 	 * Reserve a memzone for vring elements
 	 */
-	size = vring_size(vq_size, VIRTIO_PCI_VRING_ALIGN);
+	if (vq->vq_packed) {
+		size = vq_size * sizeof(struct vring_packed_desc) +
+		       2 * sizeof(struct vring_packed_desc_event);
+	} else {
+		size = vring_size(vq_size, VIRTIO_PCI_VRING_ALIGN);
+	}
 	vq->vq_ring_size = SPDK_ALIGN_CEIL(size, VIRTIO_PCI_VRING_ALIGN);
 	SPDK_DEBUGLOG(virtio_dev, "vring_size: %u, rounded_vring_size: %u\n",
 		      size, vq->vq_ring_size);
@@ -365,6 +419,91 @@ virtqueue_dequeue_burst_rx(struct virtqueue *vq, void **rx_pkts,
 	return i;
 }
 
+static inline bool
+vring_packed_desc_is_used(struct vring_packed_desc *desc, bool wrap_counter)
+{
+	uint16_t flags = *(volatile uint16_t *)&desc->flags;
+	bool avail, used;
+
+	avail = !!(flags & (1 << VRING_PACKED_DESC_F_AVAIL));
+	used = !!(flags & (1 << VRING_PACKED_DESC_F_USED));
+
+	return avail == used && used == wrap_counter;
+}
+
+static uint16_t
+virtqueue_dequeue_burst_rx_packed(struct virtqueue *vq, void **rx_pkts,
+				  uint32_t *len, uint16_t num)
+{
+	struct vring_packed_desc *desc;
+	struct vq_desc_extra *dxp;
+	uint16_t i, id;
+
+	for (i = 0; i < num; i++) {
+		desc = &vq->vq_packed_ring.desc[vq->vq_used_cons_idx];
+		if (!vring_packed_desc_is_used(desc, vq->used_wrap_counter)) {
+			break;
+		}
+
+		/* Read the id and length only after seeing the used flags */
+		virtio_rmb();
+		id = desc->id;
+		len[i] = desc->len;
+		if (spdk_unlikely(id >= vq->vq_nentries || vq->vq_descx[id].cookie == NULL)) {
+			SPDK_WARNLOG("vring descriptor with no mbuf cookie at %"PRIu16"\n",
+				     vq->vq_used_cons_idx);
+			break;
+		}
+
+		dxp = &vq->vq_descx[id];
+		__builtin_prefetch(dxp->cookie);
+		rx_pkts[i] = dxp->cookie;
+
+		/* The device writes a single used descriptor per buffer, but
+		 * consumes the ring slots of the whole chain.
+		 */
+		vq->vq_used_cons_idx += dxp->ndescs;
+		if (vq->vq_used_cons_idx >= vq->vq_nentries) {
+			vq->vq_used_cons_idx -= vq->vq_nentries;
+			vq->used_wrap_counter = !vq->used_wrap_counter;
+		}
+
+		vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt + dxp->ndescs);
+		dxp->ndescs = 0;
+		dxp->cookie = NULL;
+		dxp->next = vq->vq_desc_head_idx;
+		vq->vq_desc_head_idx = id;
+	}
+
+	return i;
+}
+
+static void
+finish_req_packed(struct virtqueue *vq)
+{
+	struct vring_packed_desc *desc;
+	uint16_t head_flags = vq->req_head_flags;
+
+	if (vq->req_end == vq->req_head_pos) {
+		head_flags &= ~VRING_DESC_F_NEXT;
+	} else {
+		desc = &vq->vq_packed_ring.desc[vq->req_end];
+		desc->flags &= ~VRING_DESC_F_NEXT;
+	}
+
+	/*
+	 * The whole chain becomes available to the device as soon as the head
+	 * descriptor flags are written, so that has to happen last. Like with
+	 * split virtqueues, this is done now rather than deferred to
+	 * virtqueue_req_flush().
+	 */
+	virtio_wmb();
+	vq->vq_packed_ring.desc[vq->req_head_pos].flags = head_flags;
+	vq->descs_finished += vq->vq_descx[vq->req_start].ndescs;
+	vq->req_start = VQ_RING_DESC_CHAIN_END;
+	vq->req_end = VQ_RING_DESC_CHAIN_END;
+}
+
 static void
 finish_req(struct virtqueue *vq)
 {
@@ -399,6 +538,28 @@ virtqueue_req_start(struct virtqueue *vq, void *cookie, int iovcnt)
 		return iovcnt > vq->vq_nentries ? -EINVAL : -ENOMEM;
 	}
 
+	if (vq->vq_packed) {
+		if (vq->req_end != VQ_RING_DESC_CHAIN_END) {
+			finish_req_packed(vq);
+		} else if (vq->req_start != VQ_RING_DESC_CHAIN_END) {
+			/* The previous request was empty, reuse its buffer id */
+			assert(vq->vq_descx[vq->req_start].ndescs == 0);
+			vq->vq_descx[vq->req_start].cookie = cookie;
+			return 0;
+		}
+
+		/* There is always a free buffer id if there is a free descriptor */
+		assert(vq->vq_desc_head_idx != VQ_RING_DESC_CHAIN_END);
+		vq->req_start = vq->vq_desc_head_idx;
+		dxp = &vq->vq_descx[vq->req_start];
+		vq->vq_desc_head_idx = dxp->next;
+		dxp->cookie = cookie;
+		dxp->ndescs = 0;
+		vq->req_head_pos = vq->vq_avail_idx;
+		vq->req_head_wrap_counter = vq->avail_wrap_counter;
+		return 0;
+	}
+
 	if (vq->req_end != VQ_RING_DESC_CHAIN_END) {
 		finish_req(vq);
 	}
@@ -411,6 +572,48 @@ virtqueue_req_start(struct virtqueue *vq, void *cookie, int iovcnt)
 	return 0;
 }
 
+static bool
+vq_packed_need_notify(struct virtqueue *vq, uint16_t descs_finished)
+{
+	struct vring_packed_desc_event *event = vq->vq_packed_ring.device;
+	uint16_t flags, off_wrap, event_idx, old_idx, new_idx;
+
+	flags = *(volatile uint16_t *)&event->flags;
+	if (flags != VRING_PACKED_EVENT_FLAG_DESC) {
+		return flags != VRING_PACKED_EVENT_FLAG_DISABLE;
+	}
+
+	/* VRING_PACKED_EVENT_FLAG_DESC can only be set with F_EVENT_IDX */
+	off_wrap = *(volatile uint16_t *)&event->off_wrap;
+	event_idx = off_wrap & ~(1 << VRING_PACKED_EVENT_F_WRAP_CTR);
+	if ((bool)(off_wrap >> VRING_PACKED_EVENT_F_WRAP_CTR) != vq->avail_wrap_counter) {
+		event_idx -= vq->vq_nentries;
+	}
+
+	new_idx = vq->vq_avail_idx;
+	old_idx = new_idx - descs_finished;
+	return vring_need_event(event_idx, new_idx, old_idx);
+}
+
+static void
+virtqueue_req_flush_packed(struct virtqueue *vq)
+{
+	uint16_t descs_finished;
+
+	finish_req_packed(vq);
+	virtio_mb();
+
+	descs_finished = vq->descs_finished;
+	vq->descs_finished = 0;
+
+	if (!vq_packed_need_notify(vq, descs_finished)) {
+		return;
+	}
+
+	virtio_dev_backend_ops(vq->vdev)->notify_queue(vq->vdev, vq);
+	SPDK_DEBUGLOG(virtio_dev, "Notified backend after xmit\n");
+}
+
 void
 virtqueue_req_flush(struct virtqueue *vq)
 {
@@ -421,6 +624,11 @@ virtqueue_req_flush(struct virtqueue *vq)
 		return;
 	}
 
+	if (vq->vq_packed) {
+		virtqueue_req_flush_packed(vq);
+		return;
+	}
+
 	finish_req(vq);
 	virtio_mb();
 
@@ -450,12 +658,31 @@ void
 virtqueue_req_abort(struct virtqueue *vq)
 {
 	struct vring_desc *desc;
+	struct vq_desc_extra *dxp;
 
 	if (vq->req_start == VQ_RING_DESC_CHAIN_END) {
 		/* no requests have been started */
 		return;
 	}
 
+	if (vq->vq_packed) {
+		/* Nothing was made visible to the device yet, so just rewind
+		 * the ring to the head of the request and release its id.
+		 */
+		dxp = &vq->vq_descx[vq->req_start];
+		vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt + dxp->ndescs);
+		vq->vq_avail_idx = vq->req_head_pos;
+		vq->avail_wrap_counter = vq->req_head_wrap_counter;
+		vq->avail_used_flags = vring_packed_avail_used_flags(vq->avail_wrap_counter);
+		dxp->ndescs = 0;
+		dxp->cookie = NULL;
+		dxp->next = vq->vq_desc_head_idx;
+		vq->vq_desc_head_idx = vq->req_start;
+		vq->req_start = VQ_RING_DESC_CHAIN_END;
+		vq->req_end = VQ_RING_DESC_CHAIN_END;
+		return;
+	}
+
 	desc = &vq->vq_ring.desc[vq->req_end];
 	desc->flags &= ~VRING_DESC_F_NEXT;
 
@@ -463,6 +690,46 @@ virtqueue_req_abort(struct virtqueue *vq)
 	vq->req_start = VQ_RING_DESC_CHAIN_END;
 }
 
+static void
+virtqueue_req_add_iovs_packed(struct virtqueue *vq, struct iovec *iovs, uint16_t iovcnt,
+			      enum spdk_virtio_desc_type desc_type)
+{
+	struct vring_packed_desc *desc;
+	uint16_t i, flags;
+
+	for (i = 0; i < iovcnt; ++i) {
+		desc = &vq->vq_packed_ring.desc[vq->vq_avail_idx];
+
+		if (!vq->vdev->is_hw) {
+			desc->addr  = (uintptr_t)iovs[i].iov_base;
+		} else {
+			desc->addr = spdk_vtophys(iovs[i].iov_base, NULL);
+		}
+
+		desc->len = iovs[i].iov_len;
+		desc->id = vq->req_start;
+		/* always set NEXT flag. unset it on the last descriptor
+		 * in the request-ending function.
+		 */
+		flags = desc_type | VRING_DESC_F_NEXT | vq->avail_used_flags;
+		if (vq->vq_avail_idx == vq->req_head_pos) {
+			vq->req_head_flags = flags;
+		} else {
+			desc->flags = flags;
+		}
+
+		vq->req_end = vq->vq_avail_idx;
+		if (++vq->vq_avail_idx == vq->vq_nentries) {
+			vq->vq_avail_idx = 0;
+			vq->avail_wrap_counter = !vq->avail_wrap_counter;
+			vq->avail_used_flags = vring_packed_avail_used_flags(vq->avail_wrap_counter);
+		}
+	}
+
+	vq->vq_descx[vq->req_start].ndescs += iovcnt;
+	vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt - iovcnt);
+}
+
 void
 virtqueue_req_add_iovs(struct virtqueue *vq, struct iovec *iovs, uint16_t iovcnt,
 		       enum spdk_virtio_desc_type desc_type)
@@ -478,6 +745,11 @@ virtqueue_req_add_iovs(struct virtqueue *vq, struct iovec *iovs, uint16_t iovcnt
 	 * or the caller specifies SPDK_VIRTIO_DESC_F_INDIRECT
 	 */
 
+	if (vq->vq_packed) {
+		virtqueue_req_add_iovs_packed(vq, iovs, iovcnt, desc_type);
+		return;
+	}
+
 	prev_head = vq->req_end;
 	new_head = vq->vq_desc_head_idx;
 	for (i = 0; i < iovcnt; ++i) {
@@ -517,6 +789,10 @@ virtio_recv_pkts(struct virtqueue *vq, void **io, uint32_t *len, uint16_t nb_pkt
 {
 	uint16_t nb_used, num;
 
+	if (vq->vq_packed) {
+		return virtqueue_dequeue_burst_rx_packed(vq, io, len, nb_pkts);
+	}
+
 	nb_used = vq->vq_ring.used->idx - vq->vq_used_cons_idx;
 	virtio_rmb();
 
@@ -528,6 +804,23 @@ virtio_recv_pkts(struct virtqueue *vq, void **io, uint32_t *len, uint16_t nb_pkt
 	return virtqueue_dequeue_burst_rx(vq, io, len, num);
 }
 
+void
+virtqueue_get_ring_addrs(struct virtqueue *vq, uint64_t ring_addr, uint64_t *desc_addr,
+			 uint64_t *driver_addr, uint64_t *device_addr)
+{
+	*desc_addr = ring_addr;
+	if (vq->vq_packed) {
+		*driver_addr = *desc_addr + vq->vq_nentries * sizeof(struct vring_packed_desc);
+		*device_addr = *driver_addr + sizeof(struct vring_packed_desc_event);
+		return;
+	}
+
+	*driver_addr = *desc_addr + vq->vq_nentries * sizeof(struct vring_desc);
+	*device_addr = SPDK_ALIGN_CEIL(*driver_addr + offsetof(struct vring_avail,
+				       ring[vq->vq_nentries]) + sizeof(uint16_t),
+				       VIRTIO_PCI_VRING_ALIGN);
+}
+
 int
 virtio_dev_acquire_queue(struct virtio_dev *vdev, uint16_t index)
 {
@@ -437,10 +437,7 @@ modern_setup_queue(struct virtio_dev *dev, struct virtqueue *vq)
 		return -ENOMEM;
 	}
 
-	desc_addr = vq->vq_ring_mem;
-	avail_addr = desc_addr + vq->vq_nentries * sizeof(struct vring_desc);
-	used_addr = (avail_addr + offsetof(struct vring_avail, ring[vq->vq_nentries])
-		     + VIRTIO_PCI_VRING_ALIGN - 1) & ~(VIRTIO_PCI_VRING_ALIGN - 1);
+	virtqueue_get_ring_addrs(vq, vq->vq_ring_mem, &desc_addr, &avail_addr, &used_addr);
 
 	g_thread_virtio_hw = hw;
 	spdk_mmio_write_2(&hw->common_cfg->queue_select, vq->vq_queue_index);
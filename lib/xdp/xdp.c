@@ -0,0 +1,747 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/log.h"
+#include "spdk/queue.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+#include "spdk/xdp.h"
+
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+#define XDP_DEFAULT_NUM_FRAMES	4096
+#define XDP_DEFAULT_FRAME_SIZE	2048
+#define XDP_DEFAULT_RING_SIZE	2048
+#define XDP_MIN_FRAME_SIZE	2048
+/* Size of the map of sockets, the highest queue id of an interface that can have a port */
+#define XDP_MAX_QUEUES		256
+
+/* Program redirecting the frames of an interface to the sockets of its queues */
+struct xdp_prog {
+	int			ifindex;
+	bool			skb_mode;
+	int			map_fd;
+	int			prog_fd;
+	/* Closing the link detaches the program */
+	int			link_fd;
+	uint32_t		ref;
+	TAILQ_ENTRY(xdp_prog)	link;
+};
+
+/* Ring shared with the kernel. The cached indexes avoid reading the indexes written by the
+ * kernel for each entry. */
+struct xdp_ring {
+	uint32_t	cached_prod;
+	uint32_t	cached_cons;
+	uint32_t	mask;
+	uint32_t	size;
+	uint32_t	*producer;
+	uint32_t	*consumer;
+	uint32_t	*flags;
+	void		*entries;
+	void		*map;
+	size_t		map_size;
+};
+
+struct spdk_xdp_port {
+	int			fd;
+	uint32_t		queue_id;
+	struct xdp_prog		*prog;
+	/* Set once the program redirects the frames of the queue to the socket */
+	bool			redirected;
+
+	/* Memory of the frames, registered as the socket's UMEM */
+	uint8_t			*umem;
+	size_t			umem_size;
+	uint32_t		frame_size;
+
+	/* Frames given to the kernel to receive into */
+	struct xdp_ring		fill;
+	/* Frames transmitted by the kernel */
+	struct xdp_ring		comp;
+	struct xdp_ring		rx;
+	struct xdp_ring		tx;
+
+	/* Frames available for transmission */
+	uint64_t		*free_frames;
+	uint32_t		num_free_frames;
+	/* Frames queued for transmission that haven't completed yet */
+	uint32_t		tx_outstanding;
+};
+
+static TAILQ_HEAD(, xdp_prog) g_xdp_progs = TAILQ_HEAD_INITIALIZER(g_xdp_progs);
+static pthread_mutex_t g_xdp_progs_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline uint32_t
+xdp_ring_prod_reserve(struct xdp_ring *ring, uint32_t count)
+{
+	uint32_t free_entries = ring->size - (ring->cached_prod - ring->cached_cons);
+
+	if (free_entries < count) {
+		ring->cached_cons = __atomic_load_n(ring->consumer, __ATOMIC_ACQUIRE);
+		free_entries = ring->size - (ring->cached_prod - ring->cached_cons);
+	}
+
+	return spdk_min(free_entries, count);
+}
+
+static inline void
+xdp_ring_prod_submit(struct xdp_ring *ring, uint32_t count)
+{
+	ring->cached_prod += count;
+	__atomic_store_n(ring->producer, ring->cached_prod, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t
+xdp_ring_cons_peek(struct xdp_ring *ring, uint32_t count)
+{
+	uint32_t entries = ring->cached_prod - ring->cached_cons;
+
+	if (entries < count) {
+		ring->cached_prod = __atomic_load_n(ring->producer, __ATOMIC_ACQUIRE);
+		entries = ring->cached_prod - ring->cached_cons;
+	}
+
+	return spdk_min(entries, count);
+}
+
+static inline void
+xdp_ring_cons_release(struct xdp_ring *ring, uint32_t count)
+{
+	ring->cached_cons += count;
+	__atomic_store_n(ring->consumer, ring->cached_cons, __ATOMIC_RELEASE);
+}
+
+static inline uint64_t *
+xdp_ring_addr(struct xdp_ring *ring, uint32_t idx)
+{
+	return &((uint64_t *)ring->entries)[idx & ring->mask];
+}
+
+static inline struct xdp_desc *
+xdp_ring_desc(struct xdp_ring *ring, uint32_t idx)
+{
+	return &((struct xdp_desc *)ring->entries)[idx & ring->mask];
+}
+
+static inline bool
+xdp_ring_needs_wakeup(struct xdp_ring *ring)
+{
+	return __atomic_load_n(ring->flags, __ATOMIC_RELAXED) & XDP_RING_NEED_WAKEUP;
+}
+
+static int
+xdp_ring_map(struct xdp_ring *ring, int fd, uint32_t size, const struct xdp_ring_offset *off,
+	     size_t entry_size, off_t pgoff)
+{
+	uint8_t *map;
+
+	ring->map_size = off->desc + size * entry_size;
+	map = mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+		   pgoff);
+	if (map == MAP_FAILED) {
+		return -errno;
+	}
+
+	ring->map = map;
+	ring->producer = (uint32_t *)(map + off->producer);
+	ring->consumer = (uint32_t *)(map + off->consumer);
+	ring->flags = (uint32_t *)(map + off->flags);
+	ring->entries = map + off->desc;
+	ring->size = size;
+	ring->mask = size - 1;
+	ring->cached_prod = *ring->producer;
+	ring->cached_cons = *ring->consumer;
+
+	return 0;
+}
+
+static void
+xdp_ring_unmap(struct xdp_ring *ring)
+{
+	if (ring->map != NULL) {
+		munmap(ring->map, ring->map_size);
+		ring->map = NULL;
+	}
+}
+
+static int
+xdp_bpf(int cmd, union bpf_attr *attr)
+{
+	int rc;
+
+	rc = syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+
+	return rc < 0 ? -errno : rc;
+}
+
+static int
+xdp_prog_load(struct xdp_prog *prog)
+{
+	union bpf_attr attr;
+	int rc;
+
+	struct bpf_insn insns[] = {
+		/* r2 = ctx->rx_queue_index */
+		{
+			.code = BPF_LDX | BPF_MEM | BPF_W, .dst_reg = BPF_REG_2,
+			.src_reg = BPF_REG_1, .off = offsetof(struct xdp_md, rx_queue_index)
+		},
+		/* r1 = map of sockets, set once it is created */
+		{
+			.code = BPF_LD | BPF_DW | BPF_IMM, .dst_reg = BPF_REG_1,
+			.src_reg = BPF_PSEUDO_MAP_FD
+		},
+		{},
+		/* r3 = XDP_PASS, the action if the queue has no socket */
+		{ .code = BPF_ALU64 | BPF_MOV | BPF_K, .dst_reg = BPF_REG_3, .imm = XDP_PASS },
+		/* return bpf_redirect_map(r1, r2, r3) */
+		{ .code = BPF_JMP | BPF_CALL, .imm = BPF_FUNC_redirect_map },
+		{ .code = BPF_JMP | BPF_EXIT },
+	};
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_XSKMAP;
+	attr.key_size = sizeof(uint32_t);
+	attr.value_size = sizeof(uint32_t);
+	attr.max_entries = XDP_MAX_QUEUES;
+	rc = xdp_bpf(BPF_MAP_CREATE, &attr);
+	if (rc < 0) {
+		SPDK_ERRLOG("Failed to create the XDP socket map: %s\n", spdk_strerror(-rc));
+		return rc;
+	}
+	prog->map_fd = rc;
+	insns[1].imm = prog->map_fd;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.prog_type = BPF_PROG_TYPE_XDP;
+	attr.expected_attach_type = BPF_XDP;
+	attr.insns = (uint64_t)(uintptr_t)insns;
+	attr.insn_cnt = SPDK_COUNTOF(insns);
+	attr.license = (uint64_t)(uintptr_t)"Dual BSD/GPL";
+	rc = xdp_bpf(BPF_PROG_LOAD, &attr);
+	if (rc < 0) {
+		SPDK_ERRLOG("Failed to load the XDP program: %s\n", spdk_strerror(-rc));
+		return rc;
+	}
+	prog->prog_fd = rc;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.link_create.prog_fd = prog->prog_fd;
+	attr.link_create.target_ifindex = prog->ifindex;
+	attr.link_create.attach_type = BPF_XDP;
+	attr.link_create.flags = prog->skb_mode ? XDP_FLAGS_SKB_MODE : XDP_FLAGS_DRV_MODE;
+	rc = xdp_bpf(BPF_LINK_CREATE, &attr);
+	if (rc < 0) {
+		SPDK_ERRLOG("Failed to attach the XDP program to interface %d: %s\n", prog->ifindex,
+			    spdk_strerror(-rc));
+		return rc;
+	}
+	prog->link_fd = rc;
+
+	return 0;
+}
+
+static void
+xdp_prog_free(struct xdp_prog *prog)
+{
+	if (prog->link_fd >= 0) {
+		close(prog->link_fd);
+	}
+	if (prog->prog_fd >= 0) {
+		close(prog->prog_fd);
+	}
+	if (prog->map_fd >= 0) {
+		close(prog->map_fd);
+	}
+	free(prog);
+}
+
+static struct xdp_prog *
+xdp_prog_get(int ifindex, bool skb_mode, int *rc)
+{
+	struct xdp_prog *prog;
+
+	pthread_mutex_lock(&g_xdp_progs_mutex);
+	TAILQ_FOREACH(prog, &g_xdp_progs, link) {
+		if (prog->ifindex == ifindex) {
+			break;
+		}
+	}
+
+	if (prog != NULL) {
+		if (prog->skb_mode != skb_mode) {
+			SPDK_ERRLOG("XDP program of interface %d attached in %s mode\n", ifindex,
+				    prog->skb_mode ? "generic" : "native");
+			*rc = -EINVAL;
+			prog = NULL;
+		} else {
+			prog->ref++;
+		}
+		pthread_mutex_unlock(&g_xdp_progs_mutex);
+		return prog;
+	}
+
+	prog = calloc(1, sizeof(*prog));
+	if (prog == NULL) {
+		pthread_mutex_unlock(&g_xdp_progs_mutex);
+		*rc = -ENOMEM;
+		return NULL;
+	}
+	prog->ifindex = ifindex;
+	prog->skb_mode = skb_mode;
+	prog->map_fd = -1;
+	prog->prog_fd = -1;
+	prog->link_fd = -1;
+
+	*rc = xdp_prog_load(prog);
+	if (*rc != 0) {
+		pthread_mutex_unlock(&g_xdp_progs_mutex);
+		xdp_prog_free(prog);
+		return NULL;
+	}
+
+	prog->ref = 1;
+	TAILQ_INSERT_TAIL(&g_xdp_progs, prog, link);
+	pthread_mutex_unlock(&g_xdp_progs_mutex);
+
+	return prog;
+}
+
+static void
+xdp_prog_put(struct xdp_prog *prog)
+{
+	pthread_mutex_lock(&g_xdp_progs_mutex);
+	assert(prog->ref > 0);
+	if (--prog->ref > 0) {
+		pthread_mutex_unlock(&g_xdp_progs_mutex);
+		return;
+	}
+	TAILQ_REMOVE(&g_xdp_progs, prog, link);
+	pthread_mutex_unlock(&g_xdp_progs_mutex);
+
+	xdp_prog_free(prog);
+}
+
+static int
+xdp_prog_set_socket(struct xdp_prog *prog, uint32_t queue_id, int fd)
+{
+	union bpf_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_fd = prog->map_fd;
+	attr.key = (uint64_t)(uintptr_t)&queue_id;
+	if (fd >= 0) {
+		attr.value = (uint64_t)(uintptr_t)&fd;
+		attr.flags = BPF_ANY;
+		return xdp_bpf(BPF_MAP_UPDATE_ELEM, &attr);
+	}
+
+	return xdp_bpf(BPF_MAP_DELETE_ELEM, &attr);
+}
+
+void
+spdk_xdp_port_get_default_opts(struct spdk_xdp_port_opts *opts, size_t opts_size)
+{
+	if (opts == NULL) {
+		SPDK_ERRLOG("opts should not be NULL\n");
+		return;
+	}
+
+	if (opts_size == 0) {
+		SPDK_ERRLOG("opts_size should not be zero value\n");
+		return;
+	}
+
+	memset(opts, 0, opts_size);
+	opts->opts_size = opts_size;
+
+#define SET_FIELD(field, value) \
+	if (offsetof(struct spdk_xdp_port_opts, field) + sizeof(opts->field) <= opts_size) { \
+		opts->field = value; \
+	} \
+
+	SET_FIELD(num_frames, XDP_DEFAULT_NUM_FRAMES);
+	SET_FIELD(frame_size, XDP_DEFAULT_FRAME_SIZE);
+	SET_FIELD(ring_size, XDP_DEFAULT_RING_SIZE);
+	SET_FIELD(skb_mode, false);
+	SET_FIELD(zero_copy, false);
+
+#undef SET_FIELD
+}
+
+static void
+xdp_port_opts_copy(struct spdk_xdp_port_opts *opts, const struct spdk_xdp_port_opts *user_opts)
+{
+#define SET_FIELD(field) \
+	if (offsetof(struct spdk_xdp_port_opts, field) + sizeof(opts->field) <= \
+	    user_opts->opts_size) { \
+		opts->field = user_opts->field; \
+	} \
+
+	SET_FIELD(num_frames);
+	SET_FIELD(frame_size);
+	SET_FIELD(ring_size);
+	SET_FIELD(skb_mode);
+	SET_FIELD(zero_copy);
+
+#undef SET_FIELD
+}
+
+static void
+xdp_port_free(struct spdk_xdp_port *port)
+{
+	if (port->redirected) {
+		xdp_prog_set_socket(port->prog, port->queue_id, -1);
+	}
+	if (port->prog != NULL) {
+		xdp_prog_put(port->prog);
+	}
+	xdp_ring_unmap(&port->tx);
+	xdp_ring_unmap(&port->rx);
+	xdp_ring_unmap(&port->comp);
+	xdp_ring_unmap(&port->fill);
+	if (port->fd >= 0) {
+		close(port->fd);
+	}
+	if (port->umem != NULL) {
+		munmap(port->umem, port->umem_size);
+	}
+	free(port->free_frames);
+	free(port);
+}
+
+static int
+xdp_port_create_socket(struct spdk_xdp_port *port, int ifindex,
+		       const struct spdk_xdp_port_opts *opts)
+{
+	struct xdp_umem_reg umem_reg = {};
+	struct xdp_mmap_offsets off = {};
+	struct sockaddr_xdp sxdp = {};
+	socklen_t optlen = sizeof(off);
+	int rc;
+
+	port->fd = socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+	if (port->fd < 0) {
+		rc = -errno;
+		SPDK_ERRLOG("Failed to create an AF_XDP socket: %s\n", spdk_strerror(-rc));
+		return rc;
+	}
+
+	umem_reg.addr = (uint64_t)(uintptr_t)port->umem;
+	umem_reg.len = port->umem_size;
+	umem_reg.chunk_size = port->frame_size;
+	if (setsockopt(port->fd, SOL_XDP, XDP_UMEM_REG, &umem_reg, sizeof(umem_reg)) != 0 ||
+	    setsockopt(port->fd, SOL_XDP, XDP_UMEM_FILL_RING, &opts->ring_size,
+		       sizeof(opts->ring_size)) != 0 ||
+	    setsockopt(port->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &opts->ring_size,
+		       sizeof(opts->ring_size)) != 0 ||
+	    setsockopt(port->fd, SOL_XDP, XDP_RX_RING, &opts->ring_size,
+		       sizeof(opts->ring_size)) != 0 ||
+	    setsockopt(port->fd, SOL_XDP, XDP_TX_RING, &opts->ring_size,
+		       sizeof(opts->ring_size)) != 0 ||
+	    getsockopt(port->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) != 0) {
+		rc = -errno;
+		SPDK_ERRLOG("Failed to set up the AF_XDP socket: %s\n", spdk_strerror(-rc));
+		return rc;
+	}
+
+	rc = xdp_ring_map(&port->fill, port->fd, opts->ring_size, &off.fr, sizeof(uint64_t),
+			  XDP_UMEM_PGOFF_FILL_RING);
+	if (rc == 0) {
+		rc = xdp_ring_map(&port->comp, port->fd, opts->ring_size, &off.cr, sizeof(uint64_t),
+				  XDP_UMEM_PGOFF_COMPLETION_RING);
+	}
+	if (rc == 0) {
+		rc = xdp_ring_map(&port->rx, port->fd, opts->ring_size, &off.rx,
+				  sizeof(struct xdp_desc), XDP_PGOFF_RX_RING);
+	}
+	if (rc == 0) {
+		rc = xdp_ring_map(&port->tx, port->fd, opts->ring_size, &off.tx,
+				  sizeof(struct xdp_desc), XDP_PGOFF_TX_RING);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to map the AF_XDP rings: %s\n", spdk_strerror(-rc));
+		return rc;
+	}
+
+	sxdp.sxdp_family = AF_XDP;
+	sxdp.sxdp_ifindex = ifindex;
+	sxdp.sxdp_queue_id = port->queue_id;
+	sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP | (opts->zero_copy ? XDP_ZEROCOPY : 0);
+	if (bind(port->fd, (struct sockaddr *)&sxdp, sizeof(sxdp)) != 0) {
+		rc = -errno;
+		SPDK_ERRLOG("Failed to bind the AF_XDP socket to queue %u of interface %d: %s\n",
+			    port->queue_id, ifindex, spdk_strerror(-rc));
+		return rc;
+	}
+
+	return 0;
+}
+
+int
+spdk_xdp_port_open(const char *ifname, uint32_t queue_id,
+		   const struct spdk_xdp_port_opts *user_opts, struct spdk_xdp_port **_port)
+{
+	struct spdk_xdp_port_opts opts;
+	struct spdk_xdp_port *port;
+	uint32_t i, num_fill;
+	int ifindex, rc;
+
+	spdk_xdp_port_get_default_opts(&opts, sizeof(opts));
+	if (user_opts != NULL) {
+		xdp_port_opts_copy(&opts, user_opts);
+	}
+
+	if (!spdk_u32_is_pow2(opts.num_frames) || opts.num_frames < 2 ||
+	    !spdk_u32_is_pow2(opts.frame_size) || opts.frame_size < XDP_MIN_FRAME_SIZE ||
+	    opts.frame_size > (uint32_t)sysconf(_SC_PAGESIZE) ||
+	    !spdk_u32_is_pow2(opts.ring_size)) {
+		SPDK_ERRLOG("Invalid XDP port options\n");
+		return -EINVAL;
+	}
+
+	if (queue_id >= XDP_MAX_QUEUES) {
+		SPDK_ERRLOG("Queue %u is above the maximum of %u\n", queue_id, XDP_MAX_QUEUES - 1);
+		return -EINVAL;
+	}
+
+	ifindex = if_nametoindex(ifname);
+	if (ifindex == 0) {
+		SPDK_ERRLOG("Interface %s not found\n", ifname);
+		return -ENODEV;
+	}
+
+	port = calloc(1, sizeof(*port));
+	if (port == NULL) {
+		return -ENOMEM;
+	}
+	port->fd = -1;
+	port->queue_id = queue_id;
+	port->frame_size = opts.frame_size;
+	port->umem_size = (size_t)opts.num_frames * opts.frame_size;
+
+	port->free_frames = calloc(opts.num_frames, sizeof(*port->free_frames));
+	if (port->free_frames == NULL) {
+		xdp_port_free(port);
+		return -ENOMEM;
+	}
+
+	port->umem = mmap(NULL, port->umem_size, PROT_READ | PROT_WRITE,
+			  MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+	if (port->umem == MAP_FAILED) {
+		port->umem = NULL;
+		xdp_port_free(port);
+		return -ENOMEM;
+	}
+
+	port->prog = xdp_prog_get(ifindex, opts.skb_mode, &rc);
+	if (port->prog == NULL) {
+		xdp_port_free(port);
+		return rc;
+	}
+
+	rc = xdp_port_create_socket(port, ifindex, &opts);
+	if (rc != 0) {
+		xdp_port_free(port);
+		return rc;
+	}
+
+	/* Give half of the frames to the kernel to receive into, the rest is for transmission */
+	num_fill = spdk_min(opts.ring_size, opts.num_frames / 2);
+	rc = xdp_ring_prod_reserve(&port->fill, num_fill);
+	assert(rc == (int)num_fill);
+	for (i = 0; i < num_fill; i++) {
+		*xdp_ring_addr(&port->fill, port->fill.cached_prod + i) =
+			(uint64_t)i * port->frame_size;
+	}
+	xdp_ring_prod_submit(&port->fill, num_fill);
+	for (i = num_fill; i < opts.num_frames; i++) {
+		port->free_frames[port->num_free_frames++] = (uint64_t)i * port->frame_size;
+	}
+
+	rc = xdp_prog_set_socket(port->prog, queue_id, port->fd);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to redirect queue %u of %s to the AF_XDP socket: %s\n",
+			    queue_id, ifname, spdk_strerror(-rc));
+		xdp_port_free(port);
+		return rc;
+	}
+	port->redirected = true;
+
+	*_port = port;
+
+	return 0;
+}
+
+void
+spdk_xdp_port_close(struct spdk_xdp_port *port)
+{
+	xdp_port_free(port);
+}
+
+int
+spdk_xdp_port_get_fd(struct spdk_xdp_port *port)
+{
+	return port->fd;
+}
+
+int
+spdk_xdp_port_rx_burst(struct spdk_xdp_port *port, struct spdk_xdp_frame *frames,
+		       int max_frames)
+{
+	struct xdp_desc *desc;
+	uint32_t i, count;
+
+	count = xdp_ring_cons_peek(&port->rx, max_frames);
+	if (count == 0) {
+		/* The driver may need a syscall to receive into the fill ring frames */
+		if (xdp_ring_needs_wakeup(&port->fill)) {
+			recvfrom(port->fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+		}
+		return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		desc = xdp_ring_desc(&port->rx, port->rx.cached_cons + i);
+		frames[i].buf = port->umem + desc->addr;
+		frames[i].len = desc->len;
+	}
+	xdp_ring_cons_release(&port->rx, count);
+
+	return count;
+}
+
+static inline uint64_t
+xdp_port_frame_addr(struct spdk_xdp_port *port, void *buf)
+{
+	return ((uint8_t *)buf - port->umem) & ~((uint64_t)port->frame_size - 1);
+}
+
+void
+spdk_xdp_port_rx_release(struct spdk_xdp_port *port, struct spdk_xdp_frame *frames,
+			 int num_frames)
+{
+	uint32_t i, count;
+
+	/* The fill ring can hold all the receive frames, so it never runs out of space */
+	count = xdp_ring_prod_reserve(&port->fill, num_frames);
+	assert(count == (uint32_t)num_frames);
+
+	for (i = 0; i < count; i++) {
+		*xdp_ring_addr(&port->fill, port->fill.cached_prod + i) =
+			xdp_port_frame_addr(port, frames[i].buf);
+	}
+	xdp_ring_prod_submit(&port->fill, count);
+}
+
+static void
+xdp_port_kick_tx(struct spdk_xdp_port *port)
+{
+	int rc;
+
+	rc = sendto(port->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+	if (rc < 0 && errno != EAGAIN && errno != EBUSY && errno != ENOBUFS &&
+	    errno != ENETDOWN) {
+		SPDK_ERRLOG("Failed to kick the transmission of queue %u: %s\n", port->queue_id,
+			    spdk_strerror(errno));
+	}
+}
+
+static void
+xdp_port_reap_tx(struct spdk_xdp_port *port)
+{
+	uint32_t i, count;
+
+	if (port->tx_outstanding == 0) {
+		return;
+	}
+
+	count = xdp_ring_cons_peek(&port->comp, port->tx_outstanding);
+	for (i = 0; i < count; i++) {
+		port->free_frames[port->num_free_frames++] =
+			*xdp_ring_addr(&port->comp, port->comp.cached_cons + i) &
+			~((uint64_t)port->frame_size - 1);
+	}
+	xdp_ring_cons_release(&port->comp, count);
+	port->tx_outstanding -= count;
+
+	/* In copy mode, the frames are only transmitted from the send syscall */
+	if (count == 0 && xdp_ring_needs_wakeup(&port->tx)) {
+		xdp_port_kick_tx(port);
+	}
+}
+
+int
+spdk_xdp_port_tx_alloc(struct spdk_xdp_port *port, struct spdk_xdp_frame *frames,
+		       int num_frames)
+{
+	uint32_t i, count;
+
+	if (port->num_free_frames < (uint32_t)num_frames) {
+		xdp_port_reap_tx(port);
+	}
+
+	count = spdk_min(port->num_free_frames, (uint32_t)num_frames);
+	for (i = 0; i < count; i++) {
+		frames[i].buf = port->umem + port->free_frames[--port->num_free_frames];
+		frames[i].len = port->frame_size;
+	}
+
+	return count;
+}
+
+int
+spdk_xdp_port_tx_burst(struct spdk_xdp_port *port, struct spdk_xdp_frame *frames,
+		       int num_frames)
+{
+	struct xdp_desc *desc;
+	uint32_t i, count;
+
+	xdp_port_reap_tx(port);
+
+	count = xdp_ring_prod_reserve(&port->tx, num_frames);
+	if (count == 0) {
+		return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		desc = xdp_ring_desc(&port->tx, port->tx.cached_prod + i);
+		desc->addr = (uint8_t *)frames[i].buf - port->umem;
+		desc->len = frames[i].len;
+		desc->options = 0;
+	}
+	xdp_ring_prod_submit(&port->tx, count);
+	port->tx_outstanding += count;
+
+	if (xdp_ring_needs_wakeup(&port->tx)) {
+		xdp_port_kick_tx(port);
+	}
+
+	return count;
+}
+
+void
+spdk_xdp_port_tx_free(struct spdk_xdp_port *port, struct spdk_xdp_frame *frames,
+		      int num_frames)
+{
+	int i;
+
+	for (i = 0; i < num_frames; i++) {
+		port->free_frames[port->num_free_frames++] =
+			xdp_port_frame_addr(port, frames[i].buf);
+	}
+}
+
+SPDK_LOG_REGISTER_COMPONENT(xdp)
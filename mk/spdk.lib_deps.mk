@@ -29,6 +29,9 @@ DEPDIRS-trace_parser := log
 ifeq ($(OS),Linux)
 DEPDIRS-vfio_user := log
 endif
+ifeq ($(CONFIG_XDP),y)
+DEPDIRS-xdp := log util
+endif
 ifeq ($(CONFIG_VFIO_USER),y)
 DEPDIRS-vfu_tgt := log util thread $(JSON_LIBS)
 endif
@@ -58,8 +61,9 @@ DEPDIRS-rpc := log util json jsonrpc
 DEPDIRS-net := log util $(JSON_LIBS)
 DEPDIRS-notify := log util $(JSON_LIBS)
 DEPDIRS-trace := log util $(JSON_LIBS)
+DEPDIRS-metrics := log util thread $(JSON_LIBS)
 
-DEPDIRS-bdev := accel log util thread $(JSON_LIBS) notify trace dma
+DEPDIRS-bdev := accel log util thread $(JSON_LIBS) notify trace dma metrics
 DEPDIRS-blobfs := log thread blob trace util
 DEPDIRS-event := log util thread $(JSON_LIBS) trace init
 DEPDIRS-init := jsonrpc json log rpc thread util
@@ -78,7 +82,7 @@ DEPDIRS-mlx5 = log rdma util
 endif
 DEPDIRS-scsi := log util thread $(JSON_LIBS) trace bdev
 
-DEPDIRS-iscsi := log sock util conf thread $(JSON_LIBS) trace scsi
+DEPDIRS-iscsi := log sock util conf thread $(JSON_LIBS) trace scsi accel
 DEPDIRS-vhost = log util thread $(JSON_LIBS) bdev scsi
 
 # ------------------------------------------------------------------------
@@ -119,9 +123,10 @@ DEPDIRS-sock_uring := log sock util
 
 # module/scheduler
 DEPDIRS-scheduler_dynamic := event log thread util json
+DEPDIRS-scheduler_predictive := event log thread util $(JSON_LIBS)
 ifeq (y,$(DPDK_POWER))
 DEPDIRS-scheduler_dpdk_governor := event log
-DEPDIRS-scheduler_gscheduler := event log
+DEPDIRS-scheduler_gscheduler := event log thread json
 endif
 
 # module/bdev
@@ -172,7 +177,7 @@ endif
 DEPDIRS-event_nvmf := init nvmf event_bdev event_scheduler event_sock thread log bdev util $(JSON_LIBS)
 DEPDIRS-event_scsi := init scsi event_bdev
 
-DEPDIRS-event_iscsi := init iscsi event_scheduler event_scsi event_sock
+DEPDIRS-event_iscsi := init iscsi event_accel event_scheduler event_scsi event_sock
 DEPDIRS-event_vhost_blk := init vhost
 DEPDIRS-event_vhost_scsi := init vhost event_scheduler event_scsi
 DEPDIRS-event_sock := init sock
@@ -107,7 +107,7 @@ ifeq ($(CONFIG_RDMA_PROV)|$(CONFIG_CRYPTO),mlx5_dv|y)
 ACCEL_MODULES_LIST += accel_mlx5
 endif
 
-SCHEDULER_MODULES_LIST = scheduler_dynamic
+SCHEDULER_MODULES_LIST = scheduler_dynamic scheduler_predictive
 ifeq (y,$(DPDK_POWER))
 SCHEDULER_MODULES_LIST += env_dpdk scheduler_dpdk_governor scheduler_gscheduler
 endif
@@ -63,6 +63,10 @@ struct comp_device_qp {
 	struct compress_dev		*device;	/* ptr to compression device */
 	uint8_t				qp;		/* queue pair for this node */
 	struct compress_io_channel	*chan;
+	/* Only updated from the thread of the channel using the queue pair. */
+	uint32_t			num_inflight;
+	uint32_t			max_inflight;
+	uint64_t			num_completed;
 	TAILQ_ENTRY(comp_device_qp)	link;
 };
 static TAILQ_HEAD(, comp_device_qp) g_comp_device_qp = TAILQ_HEAD_INITIALIZER(g_comp_device_qp);
@@ -70,7 +74,10 @@ static pthread_mutex_t g_comp_device_qp_lock = PTHREAD_MUTEX_INITIALIZER;
 
 struct compress_io_channel {
 	char				*drv_name;	/* name of the compression device driver */
-	struct comp_device_qp		*device_qp;
+	/* A queue pair on each device of the driver, tasks go to the least loaded one. */
+	struct comp_device_qp		**device_qps;
+	uint32_t			num_device_qps;
+	uint32_t			next_device_qp;
 	struct spdk_poller		*poller;
 	struct rte_mbuf			**src_mbufs;
 	struct rte_mbuf			**dst_mbufs;
@@ -419,6 +426,24 @@ _setup_compress_mbuf(struct rte_mbuf **mbufs, int *mbuf_total, uint64_t *total_l
 	return 0;
 }
 
+/* Pick the queue pair with the fewest ops in flight, in turn among the equally loaded ones. */
+static struct comp_device_qp *
+_select_device_qp(struct compress_io_channel *chan)
+{
+	struct comp_device_qp *device_qp, *selected = NULL;
+	uint32_t i;
+
+	for (i = 0; i < chan->num_device_qps; i++) {
+		device_qp = chan->device_qps[(chan->next_device_qp + i) % chan->num_device_qps];
+		if (selected == NULL || device_qp->num_inflight < selected->num_inflight) {
+			selected = device_qp;
+		}
+	}
+	chan->next_device_qp = (chan->next_device_qp + 1) % chan->num_device_qps;
+
+	return selected;
+}
+
 static int
 _compress_operation(struct compress_io_channel *chan,  struct spdk_accel_task *task)
 {
@@ -434,9 +459,10 @@ _compress_operation(struct compress_io_channel *chan,  struct spdk_accel_task *t
 	int dst_mbuf_total = 0;
 	bool device_error = false;
 	bool compress = (task->op_code == ACCEL_OPC_COMPRESS);
+	struct comp_device_qp *device_qp = _select_device_qp(chan);
 
-	assert(chan->device_qp->device != NULL);
-	cdev_id = chan->device_qp->device->cdev_id;
+	assert(device_qp->device != NULL);
+	cdev_id = device_qp->device->cdev_id;
 
 	/* calc our mbuf totals based on max MBUF size allowed so we can pre-alloc mbufs in bulk */
 	for (i = 0 ; i < src_iovcnt; i++) {
@@ -476,7 +502,7 @@ _compress_operation(struct compress_io_channel *chan,  struct spdk_accel_task *t
 	if (rc < 0) {
 		goto error_src_dst;
 	}
-	if (!chan->device_qp->device->sgl_in && src_mbuf_total > 1) {
+	if (!device_qp->device->sgl_in && src_mbuf_total > 1) {
 		SPDK_ERRLOG("Src buffer uses chained mbufs but driver %s doesn't support SGL input\n",
 			    chan->drv_name);
 		rc = -EINVAL;
@@ -492,7 +518,7 @@ _compress_operation(struct compress_io_channel *chan,  struct spdk_accel_task *t
 	if (rc < 0) {
 		goto error_src_dst;
 	}
-	if (!chan->device_qp->device->sgl_out && dst_mbuf_total > 1) {
+	if (!device_qp->device->sgl_out && dst_mbuf_total > 1) {
 		SPDK_ERRLOG("Dst buffer uses chained mbufs but driver %s doesn't support SGL output\n",
 			    chan->drv_name);
 		rc = -EINVAL;
@@ -503,19 +529,21 @@ _compress_operation(struct compress_io_channel *chan,  struct spdk_accel_task *t
 	comp_op->dst.offset = 0;
 
 	if (compress == true) {
-		comp_op->private_xform = chan->device_qp->device->comp_xform;
+		comp_op->private_xform = device_qp->device->comp_xform;
 	} else {
-		comp_op->private_xform = chan->device_qp->device->decomp_xform;
+		comp_op->private_xform = device_qp->device->decomp_xform;
 	}
 
 	comp_op->op_type = RTE_COMP_OP_STATELESS;
 	comp_op->flush_flag = RTE_COMP_FLUSH_FINAL;
 
-	rc = rte_compressdev_enqueue_burst(cdev_id, chan->device_qp->qp, &comp_op, 1);
+	rc = rte_compressdev_enqueue_burst(cdev_id, device_qp->qp, &comp_op, 1);
 	assert(rc <= 1);
 
 	/* We always expect 1 got queued, if 0 then we need to queue it up. */
 	if (rc == 1) {
+		device_qp->num_inflight++;
+		device_qp->max_inflight = spdk_max(device_qp->max_inflight, device_qp->num_inflight);
 		return 0;
 	} else if (comp_op->status == RTE_COMP_OP_STATUS_NOT_PROCESSED) {
 		rc = -EAGAIN;
@@ -547,22 +575,23 @@ error_get_op:
 	return 0;
 }
 
-/* Poller for the DPDK compression driver. */
-static int
-comp_dev_poller(void *args)
+static uint16_t
+comp_dev_poll_qp(struct compress_io_channel *chan, struct comp_device_qp *device_qp)
 {
-	struct compress_io_channel *chan = args;
 	uint8_t cdev_id;
 	struct rte_comp_op *deq_ops[NUM_MAX_INFLIGHT_OPS];
 	uint16_t num_deq;
 	struct spdk_accel_task *task, *task_to_resubmit;
 	int rc, i, status;
 
-	assert(chan->device_qp->device != NULL);
-	cdev_id = chan->device_qp->device->cdev_id;
+	assert(device_qp->device != NULL);
+	cdev_id = device_qp->device->cdev_id;
 
-	num_deq = rte_compressdev_dequeue_burst(cdev_id, chan->device_qp->qp, deq_ops,
+	num_deq = rte_compressdev_dequeue_burst(cdev_id, device_qp->qp, deq_ops,
 						NUM_MAX_INFLIGHT_OPS);
+	assert(num_deq <= device_qp->num_inflight);
+	device_qp->num_inflight -= num_deq;
+	device_qp->num_completed += num_deq;
 	for (i = 0; i < num_deq; i++) {
 
 		/* We store this off regardless of success/error so we know how to contruct the
@@ -607,6 +636,20 @@ comp_dev_poller(void *args)
 		}
 	}
 
+	return num_deq;
+}
+
+/* Poller for the DPDK compression driver. */
+static int
+comp_dev_poller(void *args)
+{
+	struct compress_io_channel *chan = args;
+	uint32_t i, num_deq = 0;
+
+	for (i = 0; i < chan->num_device_qps; i++) {
+		num_deq += comp_dev_poll_qp(chan, chan->device_qps[i]);
+	}
+
 	return num_deq == 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
 }
 
@@ -723,7 +766,9 @@ compress_create_cb(void *io_device, void *ctx_buf)
 {
 	struct compress_io_channel *chan = ctx_buf;
 	const struct rte_compressdev_capabilities *capab;
+	struct compress_dev *device;
 	struct comp_device_qp *device_qp;
+	uint32_t i, num_devices = 0;
 	size_t length;
 
 	if (_set_pmd(chan) == false) {
@@ -731,48 +776,70 @@ compress_create_cb(void *io_device, void *ctx_buf)
 		return -ENODEV;
 	}
 
+	TAILQ_FOREACH(device, &g_compress_devs, link) {
+		num_devices++;
+	}
+	chan->device_qps = calloc(num_devices, sizeof(*chan->device_qps));
+	if (chan->device_qps == NULL) {
+		return -ENOMEM;
+	}
+
 	/* The following variable length arrays of mbuf pointers are required to submit to compressdev */
 	length = NUM_MBUFS * sizeof(void *);
 	chan->src_mbufs = spdk_zmalloc(length, 0x40, NULL,
 				       SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
 	if (chan->src_mbufs == NULL) {
+		free(chan->device_qps);
 		return -ENOMEM;
 	}
 	chan->dst_mbufs = spdk_zmalloc(length, 0x40, NULL,
 				       SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
 	if (chan->dst_mbufs == NULL) {
 		free(chan->src_mbufs);
+		free(chan->device_qps);
 		return -ENOMEM;
 	}
 
 	chan->poller = SPDK_POLLER_REGISTER(comp_dev_poller, chan, 0);
 	TAILQ_INIT(&chan->queued_tasks);
 
+	/* Take a free qpair on each device of the driver, to spread the tasks across them. */
 	pthread_mutex_lock(&g_comp_device_qp_lock);
 	TAILQ_FOREACH(device_qp, &g_comp_device_qp, link) {
-		if (strcmp(device_qp->device->cdev_info.driver_name, chan->drv_name) == 0) {
-			if (device_qp->chan == NULL) {
-				chan->device_qp = device_qp;
-				device_qp->chan = chan;
+		if (strcmp(device_qp->device->cdev_info.driver_name, chan->drv_name) != 0 ||
+		    device_qp->chan != NULL) {
+			continue;
+		}
+		for (i = 0; i < chan->num_device_qps; i++) {
+			if (chan->device_qps[i]->device == device_qp->device) {
 				break;
 			}
 		}
+		if (i == chan->num_device_qps) {
+			chan->device_qps[chan->num_device_qps++] = device_qp;
+			device_qp->chan = chan;
+		}
 	}
 	pthread_mutex_unlock(&g_comp_device_qp_lock);
 
-	if (chan->device_qp == NULL) {
+	if (chan->num_device_qps == 0) {
 		SPDK_ERRLOG("out of qpairs, cannot assign one\n");
 		assert(false);
 		return -ENOMEM;
 	} else {
 		capab = rte_compressdev_capability_get(0, RTE_COMP_ALGO_DEFLATE);
 
-		if (capab->comp_feature_flags & (RTE_COMP_FF_OOP_SGL_IN_SGL_OUT | RTE_COMP_FF_OOP_SGL_IN_LB_OUT)) {
-			chan->device_qp->device->sgl_in = true;
-		}
+		for (i = 0; i < chan->num_device_qps; i++) {
+			device = chan->device_qps[i]->device;
+			if (capab->comp_feature_flags & (RTE_COMP_FF_OOP_SGL_IN_SGL_OUT |
+							 RTE_COMP_FF_OOP_SGL_IN_LB_OUT)) {
+				device->sgl_in = true;
+			}
 
-		if (capab->comp_feature_flags & (RTE_COMP_FF_OOP_SGL_IN_SGL_OUT | RTE_COMP_FF_OOP_LB_IN_SGL_OUT)) {
-			chan->device_qp->device->sgl_out = true;
+			if (capab->comp_feature_flags & (RTE_COMP_FF_OOP_SGL_IN_SGL_OUT |
+							 RTE_COMP_FF_OOP_LB_IN_SGL_OUT)) {
+				device->sgl_out = true;
+			}
 		}
 	}
 
@@ -796,7 +863,7 @@ static void
 compress_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct compress_io_channel *chan = ctx_buf;
-	struct comp_device_qp *device_qp = chan->device_qp;
+	uint32_t i;
 
 	spdk_free(chan->src_mbufs);
 	spdk_free(chan->dst_mbufs);
@@ -804,9 +871,52 @@ compress_destroy_cb(void *io_device, void *ctx_buf)
 	spdk_poller_unregister(&chan->poller);
 
 	pthread_mutex_lock(&g_comp_device_qp_lock);
-	chan->device_qp = NULL;
-	device_qp->chan = NULL;
+	for (i = 0; i < chan->num_device_qps; i++) {
+		chan->device_qps[i]->chan = NULL;
+	}
+	pthread_mutex_unlock(&g_comp_device_qp_lock);
+
+	free(chan->device_qps);
+	chan->device_qps = NULL;
+	chan->num_device_qps = 0;
+}
+
+void
+accel_compressdev_write_stats(struct spdk_json_write_ctx *w)
+{
+	struct compress_dev *device;
+	struct comp_device_qp *device_qp;
+	uint32_t num_qpairs, num_channels, num_inflight, max_inflight;
+	uint64_t num_completed;
+
+	spdk_json_write_array_begin(w);
+	pthread_mutex_lock(&g_comp_device_qp_lock);
+	TAILQ_FOREACH(device, &g_compress_devs, link) {
+		num_qpairs = num_channels = num_inflight = max_inflight = 0;
+		num_completed = 0;
+		TAILQ_FOREACH(device_qp, &g_comp_device_qp, link) {
+			if (device_qp->device != device) {
+				continue;
+			}
+			num_qpairs++;
+			num_channels += device_qp->chan != NULL;
+			num_inflight += device_qp->num_inflight;
+			max_inflight = spdk_max(max_inflight, device_qp->max_inflight);
+			num_completed += device_qp->num_completed;
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "cdev_id", device->cdev_id);
+		spdk_json_write_named_string(w, "driver_name", device->cdev_info.driver_name);
+		spdk_json_write_named_uint32(w, "num_qpairs", num_qpairs);
+		spdk_json_write_named_uint32(w, "num_channels", num_channels);
+		spdk_json_write_named_uint32(w, "num_inflight", num_inflight);
+		spdk_json_write_named_uint32(w, "max_inflight", max_inflight);
+		spdk_json_write_named_uint64(w, "num_completed", num_completed);
+		spdk_json_write_object_end(w);
+	}
 	pthread_mutex_unlock(&g_comp_device_qp_lock);
+	spdk_json_write_array_end(w);
 }
 
 static size_t
@@ -4,6 +4,7 @@
  */
 
 #include "spdk/stdinc.h"
+#include "spdk/json.h"
 
 enum compress_pmd {
 	COMPRESS_PMD_AUTO = 0,
@@ -14,3 +15,4 @@ enum compress_pmd {
 
 void accel_dpdk_compressdev_enable(void);
 int accel_compressdev_enable_probe(enum compress_pmd *opts);
+void accel_compressdev_write_stats(struct spdk_json_write_ctx *w);
@@ -50,3 +50,21 @@ rpc_compressdev_scan_accel_module(struct spdk_jsonrpc_request *request,
 }
 SPDK_RPC_REGISTER("compressdev_scan_accel_module", rpc_compressdev_scan_accel_module,
 		  SPDK_RPC_STARTUP)
+
+static void
+rpc_compressdev_get_stats(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct spdk_json_write_ctx *w;
+
+	if (params) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "No parameters expected");
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	accel_compressdev_write_stats(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+SPDK_RPC_REGISTER("compressdev_get_stats", rpc_compressdev_get_stats, SPDK_RPC_RUNTIME)
@@ -67,6 +67,9 @@
                  sizeof(struct rte_crypto_sym_xform)))
 #define ACCEL_DPDK_CRYPTODEV_IV_LENGTH			16
 
+/* Number of key handles cached by each channel */
+#define ACCEL_DPDK_CRYPTODEV_KEY_CACHE_SIZE		64
+
 /* Driver names */
 #define ACCEL_DPDK_CRYPTODEV_AESNI_MB	"crypto_aesni_mb"
 #define ACCEL_DPDK_CRYPTODEV_QAT	"crypto_qat"
@@ -141,9 +144,18 @@ struct accel_dpdk_cryptodev_key_priv {
 	enum accel_dpdk_cryptodev_driver_type driver;
 	enum accel_dpdk_crypto_dev_cipher_type cipher;
 	char *xts_key;
+	/* Unique identifier of the key, used to look up its handle in the channels' caches */
+	uint64_t id;
+	/* Protects dev_keys, key handles of other devices may be added from any thread */
+	pthread_mutex_t lock;
 	TAILQ_HEAD(, accel_dpdk_cryptodev_key_handle) dev_keys;
 };
 
+struct accel_dpdk_cryptodev_key_cache_entry {
+	uint64_t key_id;
+	struct accel_dpdk_cryptodev_key_handle *key_handle;
+};
+
 /* The crypto channel struct. It is allocated and freed on my behalf by the io channel code.
  * We store things in here that are needed on per thread basis like the base_channel for this thread,
  * and the poller for this thread.
@@ -158,6 +170,8 @@ struct accel_dpdk_cryptodev_io_channel {
 	/* Used to queue tasks that were completed in submission path - to avoid calling cpl_cb and possibly overflow
 	 * call stack */
 	TAILQ_HEAD(, accel_dpdk_cryptodev_task) completed_tasks;
+	/* Key handles used by this channel, indexed by key id */
+	struct accel_dpdk_cryptodev_key_cache_entry key_cache[ACCEL_DPDK_CRYPTODEV_KEY_CACHE_SIZE];
 };
 
 struct accel_dpdk_cryptodev_task {
@@ -170,6 +184,9 @@ struct accel_dpdk_cryptodev_task {
 	TAILQ_ENTRY(accel_dpdk_cryptodev_task) link;
 };
 
+/* Source of unique key ids, 0 is never assigned */
+static uint64_t g_next_key_id = 1;
+
 /* Shared mempools between all devices on this system */
 static struct rte_mempool *g_session_mp = NULL;
 static struct rte_mempool *g_session_mp_priv = NULL;
@@ -457,6 +474,41 @@ accel_dpdk_find_key_handle_in_channel(struct accel_dpdk_cryptodev_io_channel *cr
 	}
 }
 
+static struct accel_dpdk_cryptodev_key_handle *accel_dpdk_cryptodev_key_handle_create(
+	struct spdk_accel_crypto_key *key, struct accel_dpdk_cryptodev_device *device);
+
+/* Key handles, and their sessions, for MLX5_PCI devices other than the first one are only
+ * created once a channel using that device needs them.  The handles are then cached in the
+ * channel, so that the key's list of handles doesn't need to be searched for every task. */
+static struct accel_dpdk_cryptodev_key_handle *
+accel_dpdk_get_key_handle(struct accel_dpdk_cryptodev_io_channel *crypto_ch,
+			  struct spdk_accel_crypto_key *key)
+{
+	struct accel_dpdk_cryptodev_key_priv *priv = key->priv;
+	struct accel_dpdk_cryptodev_key_cache_entry *entry;
+	struct accel_dpdk_cryptodev_key_handle *key_handle;
+
+	entry = &crypto_ch->key_cache[priv->id % ACCEL_DPDK_CRYPTODEV_KEY_CACHE_SIZE];
+	if (spdk_likely(entry->key_id == priv->id && entry->key_handle != NULL)) {
+		return entry->key_handle;
+	}
+
+	pthread_mutex_lock(&priv->lock);
+	key_handle = accel_dpdk_find_key_handle_in_channel(crypto_ch, priv);
+	if (!key_handle && priv->driver == ACCEL_DPDK_CRYPTODEV_DRIVER_MLX5_PCI) {
+		key_handle = accel_dpdk_cryptodev_key_handle_create(key,
+				crypto_ch->device_qp[ACCEL_DPDK_CRYPTODEV_DRIVER_MLX5_PCI]->device);
+	}
+	pthread_mutex_unlock(&priv->lock);
+
+	if (key_handle) {
+		entry->key_id = priv->id;
+		entry->key_handle = key_handle;
+	}
+
+	return key_handle;
+}
+
 static inline int
 accel_dpdk_cryptodev_task_alloc_resources(struct rte_mbuf **src_mbufs, struct rte_mbuf **dst_mbufs,
 		struct rte_crypto_op **crypto_ops, int count)
@@ -652,7 +704,7 @@ accel_dpdk_cryptodev_process_task(struct accel_dpdk_cryptodev_io_channel *crypto
 		return -ENOMEM;
 	}
 
-	key_handle = accel_dpdk_find_key_handle_in_channel(crypto_ch, priv);
+	key_handle = accel_dpdk_get_key_handle(crypto_ch, task->base.crypto_key);
 	if (spdk_unlikely(!key_handle)) {
 		SPDK_ERRLOG("Failed to find a key handle, driver %s, cipher %s\n", g_driver_names[priv->driver],
 			    g_cipher_names[priv->cipher]);
@@ -1380,6 +1432,29 @@ accel_dpdk_cryptodev_key_handle_configure(struct spdk_accel_crypto_key *key,
 	return 0;
 }
 
+static struct accel_dpdk_cryptodev_key_handle *
+accel_dpdk_cryptodev_key_handle_create(struct spdk_accel_crypto_key *key,
+				       struct accel_dpdk_cryptodev_device *device)
+{
+	struct accel_dpdk_cryptodev_key_priv *priv = key->priv;
+	struct accel_dpdk_cryptodev_key_handle *key_handle;
+
+	key_handle = calloc(1, sizeof(*key_handle));
+	if (!key_handle) {
+		SPDK_ERRLOG("Memory allocation failed\n");
+		return NULL;
+	}
+	key_handle->device = device;
+	if (accel_dpdk_cryptodev_key_handle_configure(key, key_handle)) {
+		spdk_memset_s(key_handle, sizeof(*key_handle), 0, sizeof(*key_handle));
+		free(key_handle);
+		return NULL;
+	}
+	TAILQ_INSERT_TAIL(&priv->dev_keys, key_handle, link);
+
+	return key_handle;
+}
+
 static int
 accel_dpdk_cryptodev_validate_parameters(enum accel_dpdk_cryptodev_driver_type driver,
 		enum accel_dpdk_crypto_dev_cipher_type cipher, struct spdk_accel_crypto_key *key)
@@ -1476,6 +1551,7 @@ accel_dpdk_cryptodev_key_deinit(struct spdk_accel_crypto_key *key)
 		spdk_memset_s(priv->xts_key, key->key_size + key->key2_size, 0, key->key_size + key->key2_size);
 	}
 	free(priv->xts_key);
+	pthread_mutex_destroy(&priv->lock);
 	free(priv);
 }
 
@@ -1487,7 +1563,6 @@ accel_dpdk_cryptodev_key_init(struct spdk_accel_crypto_key *key)
 	struct accel_dpdk_cryptodev_key_handle *key_handle;
 	enum accel_dpdk_cryptodev_driver_type driver;
 	enum accel_dpdk_crypto_dev_cipher_type cipher;
-	int rc;
 
 	if (!key->param.cipher) {
 		SPDK_ERRLOG("Cipher is missing\n");
@@ -1517,6 +1592,8 @@ accel_dpdk_cryptodev_key_init(struct spdk_accel_crypto_key *key)
 	key->priv = priv;
 	priv->driver = driver;
 	priv->cipher = cipher;
+	priv->id = __atomic_fetch_add(&g_next_key_id, 1, __ATOMIC_RELAXED);
+	pthread_mutex_init(&priv->lock, NULL);
 	TAILQ_INIT(&priv->dev_keys);
 
 	if (cipher == ACCEL_DPDK_CRYPTODEV_CIPHER_AES_XTS) {
@@ -1531,36 +1608,26 @@ accel_dpdk_cryptodev_key_init(struct spdk_accel_crypto_key *key)
 		memcpy(priv->xts_key + key->key_size, key->key2, key->key2_size);
 	}
 
+	/* Only the first device gets a key handle here, which also validates the key.  MLX5_PCI
+	 * keys are bound to the Protection Domain of a device, so the handles for other devices
+	 * are created on first use, see accel_dpdk_get_key_handle() */
 	pthread_mutex_lock(&g_device_lock);
 	TAILQ_FOREACH(device, &g_crypto_devices, link) {
 		if (device->type != driver) {
 			continue;
 		}
-		key_handle = calloc(1, sizeof(*key_handle));
+		key_handle = accel_dpdk_cryptodev_key_handle_create(key, device);
 		if (!key_handle) {
 			pthread_mutex_unlock(&g_device_lock);
 			accel_dpdk_cryptodev_key_deinit(key);
-			return -ENOMEM;
-		}
-		key_handle->device = device;
-		TAILQ_INSERT_TAIL(&priv->dev_keys, key_handle, link);
-		rc = accel_dpdk_cryptodev_key_handle_configure(key, key_handle);
-		if (rc) {
-			pthread_mutex_unlock(&g_device_lock);
-			accel_dpdk_cryptodev_key_deinit(key);
-			return rc;
-		}
-		if (driver != ACCEL_DPDK_CRYPTODEV_DRIVER_MLX5_PCI) {
-			/* For MLX5_PCI we need to register a key on each device since
-			 * the key is bound to a specific Protection Domain,
-			 * so don't break the loop */
-			break;
+			return -EINVAL;
 		}
+		break;
 	}
 	pthread_mutex_unlock(&g_device_lock);
 
 	if (TAILQ_EMPTY(&priv->dev_keys)) {
-		free(priv);
+		accel_dpdk_cryptodev_key_deinit(key);
 		return -ENODEV;
 	}
 
@@ -24,9 +24,12 @@
 #include <sys/eventfd.h>
 #include <libaio.h>
 
+#define SPDK_AIO_QUEUE_DEPTH 128
+#define SPDK_AIO_GROUP_QUEUE_DEPTH 1024
+#define MAX_EVENTS_PER_POLL 32
+
 struct bdev_aio_io_channel {
 	uint64_t				io_inflight;
-	io_context_t				io_ctx;
 	struct bdev_aio_group_channel		*group_ch;
 	TAILQ_ENTRY(bdev_aio_io_channel)	link;
 };
@@ -38,6 +41,12 @@ struct bdev_aio_group_channel {
 	int					efd;
 	struct spdk_interrupt			*intr;
 	struct spdk_poller			*poller;
+	/* The context is shared by all aio bdevs on a thread, so that the I/Os of all of them
+	 * can be submitted and reaped together. */
+	io_context_t				io_ctx;
+	/* In polling mode, the I/Os are batched and submitted once per poller iteration */
+	struct iocb				*pending_iocbs[SPDK_AIO_QUEUE_DEPTH];
+	int					num_pending_iocbs;
 	TAILQ_HEAD(, bdev_aio_io_channel)	io_ch_head;
 };
 
@@ -78,9 +87,6 @@ static void bdev_aio_fini(void);
 static void aio_free_disk(struct file_disk *fdisk);
 static TAILQ_HEAD(, file_disk) g_aio_disk_head = TAILQ_HEAD_INITIALIZER(g_aio_disk_head);
 
-#define SPDK_AIO_QUEUE_DEPTH 128
-#define MAX_EVENTS_PER_POLL 32
-
 static int
 bdev_aio_get_ctx_size(void)
 {
@@ -140,6 +146,81 @@ bdev_aio_close(struct file_disk *disk)
 	return 0;
 }
 
+static void
+bdev_aio_submit_failed(struct bdev_aio_task *aio_task, int rc)
+{
+	aio_task->ch->io_inflight--;
+	if (rc == -EAGAIN) {
+		spdk_bdev_io_complete(spdk_bdev_io_from_ctx(aio_task), SPDK_BDEV_IO_STATUS_NOMEM);
+	} else {
+		spdk_bdev_io_complete_aio_status(spdk_bdev_io_from_ctx(aio_task), rc);
+	}
+}
+
+static int
+bdev_aio_group_flush(struct bdev_aio_group_channel *group_ch)
+{
+	struct iocb *iocbs[SPDK_AIO_QUEUE_DEPTH];
+	int i, rc = 0, nr, num_submitted = 0;
+
+	nr = group_ch->num_pending_iocbs;
+	if (nr == 0) {
+		return 0;
+	}
+
+	/* The completions of the failed I/Os below may queue new ones */
+	memcpy(iocbs, group_ch->pending_iocbs, nr * sizeof(iocbs[0]));
+	group_ch->num_pending_iocbs = 0;
+
+	while (num_submitted < nr) {
+		rc = io_submit(group_ch->io_ctx, nr - num_submitted, &iocbs[num_submitted]);
+		if (rc <= 0) {
+			break;
+		}
+		num_submitted += rc;
+	}
+
+	if (spdk_unlikely(num_submitted < nr)) {
+		rc = rc == 0 ? -EAGAIN : rc;
+		if (rc != -EAGAIN) {
+			SPDK_ERRLOG("%s: io_submit returned %d\n", __func__, rc);
+		}
+		for (i = num_submitted; i < nr; i++) {
+			bdev_aio_submit_failed(iocbs[i]->data, rc);
+		}
+	}
+
+	return num_submitted;
+}
+
+static void
+bdev_aio_submit_iocb(struct bdev_aio_io_channel *aio_ch, struct bdev_aio_task *aio_task)
+{
+	struct bdev_aio_group_channel *group_ch = aio_ch->group_ch;
+	struct iocb *iocb = &aio_task->iocb;
+	int rc;
+
+	aio_ch->io_inflight++;
+
+	/* There's no poller to submit the batch in interrupt mode */
+	if (group_ch->efd >= 0) {
+		rc = io_submit(group_ch->io_ctx, 1, &iocb);
+		if (spdk_unlikely(rc <= 0)) {
+			rc = rc == 0 ? -EAGAIN : rc;
+			if (rc != -EAGAIN) {
+				SPDK_ERRLOG("%s: io_submit returned %d\n", __func__, rc);
+			}
+			bdev_aio_submit_failed(aio_task, rc);
+		}
+		return;
+	}
+
+	group_ch->pending_iocbs[group_ch->num_pending_iocbs++] = iocb;
+	if (group_ch->num_pending_iocbs == SPDK_AIO_QUEUE_DEPTH) {
+		bdev_aio_group_flush(group_ch);
+	}
+}
+
 static void
 bdev_aio_readv(struct file_disk *fdisk, struct spdk_io_channel *ch,
 	       struct bdev_aio_task *aio_task,
@@ -147,7 +228,6 @@ bdev_aio_readv(struct file_disk *fdisk, struct spdk_io_channel *ch,
 {
 	struct iocb *iocb = &aio_task->iocb;
 	struct bdev_aio_io_channel *aio_ch = spdk_io_channel_get_ctx(ch);
-	int rc;
 
 	io_prep_preadv(iocb, fdisk->fd, iov, iovcnt, offset);
 	if (aio_ch->group_ch->efd >= 0) {
@@ -160,17 +240,7 @@ bdev_aio_readv(struct file_disk *fdisk, struct spdk_io_channel *ch,
 	SPDK_DEBUGLOG(aio, "read %d iovs size %lu to off: %#lx\n",
 		      iovcnt, nbytes, offset);
 
-	rc = io_submit(aio_ch->io_ctx, 1, &iocb);
-	if (spdk_unlikely(rc < 0)) {
-		if (rc == -EAGAIN) {
-			spdk_bdev_io_complete(spdk_bdev_io_from_ctx(aio_task), SPDK_BDEV_IO_STATUS_NOMEM);
-		} else {
-			spdk_bdev_io_complete_aio_status(spdk_bdev_io_from_ctx(aio_task), rc);
-			SPDK_ERRLOG("%s: io_submit returned %d\n", __func__, rc);
-		}
-	} else {
-		aio_ch->io_inflight++;
-	}
+	bdev_aio_submit_iocb(aio_ch, aio_task);
 }
 
 static void
@@ -180,7 +250,6 @@ bdev_aio_writev(struct file_disk *fdisk, struct spdk_io_channel *ch,
 {
 	struct iocb *iocb = &aio_task->iocb;
 	struct bdev_aio_io_channel *aio_ch = spdk_io_channel_get_ctx(ch);
-	int rc;
 
 	io_prep_pwritev(iocb, fdisk->fd, iov, iovcnt, offset);
 	if (aio_ch->group_ch->efd >= 0) {
@@ -193,17 +262,7 @@ bdev_aio_writev(struct file_disk *fdisk, struct spdk_io_channel *ch,
 	SPDK_DEBUGLOG(aio, "write %d iovs size %lu from off: %#lx\n",
 		      iovcnt, len, offset);
 
-	rc = io_submit(aio_ch->io_ctx, 1, &iocb);
-	if (spdk_unlikely(rc < 0)) {
-		if (rc == -EAGAIN) {
-			spdk_bdev_io_complete(spdk_bdev_io_from_ctx(aio_task), SPDK_BDEV_IO_STATUS_NOMEM);
-		} else {
-			spdk_bdev_io_complete_aio_status(spdk_bdev_io_from_ctx(aio_task), rc);
-			SPDK_ERRLOG("%s: io_submit returned %d\n", __func__, rc);
-		}
-	} else {
-		aio_ch->io_inflight++;
-	}
+	bdev_aio_submit_iocb(aio_ch, aio_task);
 }
 
 static void
@@ -306,13 +365,13 @@ bdev_user_io_getevents(io_context_t io_ctx, unsigned int max, struct io_event *u
 }
 
 static int
-bdev_aio_io_channel_poll(struct bdev_aio_io_channel *io_ch)
+bdev_aio_group_reap(struct bdev_aio_group_channel *group_ch)
 {
 	int nr, i, res = 0;
 	struct bdev_aio_task *aio_task;
 	struct io_event events[SPDK_AIO_QUEUE_DEPTH];
 
-	nr = bdev_user_io_getevents(io_ch->io_ctx, SPDK_AIO_QUEUE_DEPTH, events);
+	nr = bdev_user_io_getevents(group_ch->io_ctx, SPDK_AIO_QUEUE_DEPTH, events);
 	if (nr < 0) {
 		return 0;
 	}
@@ -345,12 +404,10 @@ static int
 bdev_aio_group_poll(void *arg)
 {
 	struct bdev_aio_group_channel *group_ch = arg;
-	struct bdev_aio_io_channel *io_ch;
-	int nr = 0;
+	int nr;
 
-	TAILQ_FOREACH(io_ch, &group_ch->io_ch_head, link) {
-		nr += bdev_aio_io_channel_poll(io_ch);
-	}
+	nr = bdev_aio_group_flush(group_ch);
+	nr += bdev_aio_group_reap(group_ch);
 
 	return nr > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 }
@@ -536,11 +593,6 @@ bdev_aio_create_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_aio_io_channel *ch = ctx_buf;
 
-	if (io_setup(SPDK_AIO_QUEUE_DEPTH, &ch->io_ctx) < 0) {
-		SPDK_ERRLOG("async I/O context setup failure\n");
-		return -1;
-	}
-
 	ch->group_ch = spdk_io_channel_get_ctx(spdk_get_io_channel(&aio_if));
 	TAILQ_INSERT_TAIL(&ch->group_ch->io_ch_head, ch, link);
 
@@ -552,8 +604,6 @@ bdev_aio_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_aio_io_channel *ch = ctx_buf;
 
-	io_destroy(ch->io_ctx);
-
 	assert(ch->group_ch);
 	TAILQ_REMOVE(&ch->group_ch->io_ch_head, ch, link);
 
@@ -671,10 +721,16 @@ bdev_aio_group_create_cb(void *io_device, void *ctx_buf)
 	TAILQ_INIT(&ch->io_ch_head);
 	/* Initialize ch->efd to be invalid and unused. */
 	ch->efd = -1;
+	if (io_setup(SPDK_AIO_GROUP_QUEUE_DEPTH, &ch->io_ctx) < 0) {
+		SPDK_ERRLOG("async I/O context setup failure\n");
+		return -1;
+	}
+
 	if (spdk_interrupt_mode_is_enabled()) {
 		rc = bdev_aio_register_interrupt(ch);
 		if (rc < 0) {
 			SPDK_ERRLOG("Failed to prepare intr resource to bdev_aio\n");
+			io_destroy(ch->io_ctx);
 			return rc;
 		}
 	}
@@ -698,6 +754,8 @@ bdev_aio_group_destroy_cb(void *io_device, void *ctx_buf)
 	if (spdk_interrupt_mode_is_enabled()) {
 		bdev_aio_unregister_interrupt(ch);
 	}
+
+	io_destroy(ch->io_ctx);
 }
 
 int
@@ -25,6 +25,7 @@
 #define CHUNK_SIZE (1024 * 16)
 #define COMP_BDEV_NAME "compress"
 #define BACKING_IO_SZ (4 * 1024)
+#define WRITE_BUFFER_CHUNKS 32
 
 struct vbdev_comp_delete_ctx {
 	spdk_delete_compress_complete	cb_fn;
@@ -487,11 +488,26 @@ static int
 vbdev_compress_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
 {
 	struct vbdev_compress *comp_bdev = (struct vbdev_compress *)ctx;
+	struct spdk_reduce_vol_stats stats;
+	int i;
 
 	spdk_json_write_name(w, "compress");
 	spdk_json_write_object_begin(w);
 	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&comp_bdev->comp_bdev));
 	spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(comp_bdev->base_bdev));
+
+	if (comp_bdev->vol != NULL) {
+		spdk_reduce_vol_get_stats(comp_bdev->vol, &stats);
+		spdk_json_write_named_uint64(w, "compressed_chunks", stats.compressed_chunks);
+		spdk_json_write_named_uint64(w, "incompressible_chunks",
+					     stats.incompressible_chunks);
+		spdk_json_write_named_uint64(w, "bypassed_chunks", stats.bypassed_chunks);
+		spdk_json_write_named_array_begin(w, "ratio_histogram");
+		for (i = 0; i < SPDK_REDUCE_RATIO_BUCKETS; i++) {
+			spdk_json_write_uint64(w, stats.ratio_histogram[i]);
+		}
+		spdk_json_write_array_end(w);
+	}
 	spdk_json_write_object_end(w);
 
 	return 0;
@@ -751,6 +767,7 @@ _prepare_for_load_init(struct spdk_bdev_desc *bdev_desc, uint32_t lb_size)
 	}
 
 	meta_ctx->params.backing_io_unit_size = BACKING_IO_SZ;
+	meta_ctx->params.write_buffer_chunks = WRITE_BUFFER_CHUNKS;
 	return meta_ctx;
 }
 
@@ -775,6 +792,11 @@ vbdev_init_reduce(const char *bdev_name, const char *pm_path, uint32_t lb_size)
 		return -EINVAL;
 	}
 
+	/* The write buffer lives in the pm file. */
+	if (pm_path == NULL) {
+		meta_ctx->params.write_buffer_chunks = 0;
+	}
+
 	/* Save the thread where the base device is opened */
 	meta_ctx->thread = spdk_get_thread();
 
@@ -51,7 +51,7 @@ typedef void (*spdk_delete_compress_complete)(void *cb_arg, int bdeverrno);
  * Create new compression bdev.
  *
  * \param bdev_name Bdev on which compression bdev will be created.
- * \param pm_path Path to persistent memory.
+ * \param pm_path Path to persistent memory, or NULL to keep the metadata on the base bdev.
  * \param lb_size Logical block size for the compressed volume in bytes. Must be 4K or 512.
  * \return 0 on success, other on failure.
  */
@@ -99,16 +99,27 @@ crypto_write(struct crypto_io_channel *crypto_ch, struct spdk_bdev_io *bdev_io)
 					   crypto_bdev);
 	struct crypto_bdev_io *crypto_io = (struct crypto_bdev_io *)bdev_io->driver_ctx;
 	struct spdk_bdev_ext_io_opts opts = {};
-	int rc;
+	struct iovec *iovs;
+	int iovcnt, rc;
 
 	opts.size = sizeof(opts);
 	opts.accel_sequence = crypto_io->seq;
-	opts.memory_domain = crypto_io->aux_domain;
-	opts.memory_domain_ctx = crypto_io->aux_domain_ctx;
+	if (crypto_io->aux_buf_raw != NULL) {
+		iovs = &crypto_io->aux_buf_iov;
+		iovcnt = 1;
+		opts.memory_domain = crypto_io->aux_domain;
+		opts.memory_domain_ctx = crypto_io->aux_domain_ctx;
+	} else {
+		/* Encrypted in place */
+		iovs = bdev_io->u.bdev.iovs;
+		iovcnt = bdev_io->u.bdev.iovcnt;
+		opts.memory_domain = bdev_io->u.bdev.memory_domain;
+		opts.memory_domain_ctx = bdev_io->u.bdev.memory_domain_ctx;
+	}
 
 	/* Write the encrypted data. */
 	rc = spdk_bdev_writev_blocks_ext(crypto_bdev->base_desc, crypto_ch->base_ch,
-					 &crypto_io->aux_buf_iov, 1, crypto_io->aux_offset_blocks,
+					 iovs, iovcnt, crypto_io->aux_offset_blocks,
 					 crypto_io->aux_num_blocks, _complete_internal_io,
 					 bdev_io, &opts);
 	if (spdk_unlikely(rc != 0)) {
@@ -131,32 +142,45 @@ crypto_encrypt(struct crypto_io_channel *crypto_ch, struct spdk_bdev_io *bdev_io
 	uint64_t total_length;
 	uint64_t alignment;
 	void *aux_buf = crypto_io->aux_buf_raw;
+	struct iovec *dst_iovs = bdev_io->u.bdev.iovs;
+	uint32_t dst_iovcnt = bdev_io->u.bdev.iovcnt;
+	struct spdk_memory_domain *dst_domain = bdev_io->u.bdev.memory_domain;
+	void *dst_domain_ctx = bdev_io->u.bdev.memory_domain_ctx;
 	int rc;
 
 	/* For encryption, we need to prepare a single contiguous buffer as the encryption
 	 * destination, we'll then pass that along for the write after encryption is done.
 	 * This is done to avoiding encrypting the provided write buffer which may be
-	 * undesirable in some use cases.
+	 * undesirable in some use cases.  Without an aux buffer, the data is encrypted in place.
 	 */
-	total_length = bdev_io->u.bdev.num_blocks * crypto_len;
-	alignment = spdk_bdev_get_buf_align(&crypto_io->crypto_bdev->crypto_bdev);
-	crypto_io->aux_buf_iov.iov_len = total_length;
-	crypto_io->aux_buf_iov.iov_base  = (void *)(((uintptr_t)aux_buf + (alignment - 1)) & ~
-					   (alignment - 1));
+	if (aux_buf != NULL) {
+		total_length = bdev_io->u.bdev.num_blocks * crypto_len;
+		alignment = spdk_bdev_get_buf_align(&crypto_io->crypto_bdev->crypto_bdev);
+		crypto_io->aux_buf_iov.iov_len = total_length;
+		crypto_io->aux_buf_iov.iov_base = (void *)(((uintptr_t)aux_buf + (alignment - 1)) &
+						  ~(alignment - 1));
+		dst_iovs = &crypto_io->aux_buf_iov;
+		dst_iovcnt = 1;
+		dst_domain = crypto_io->aux_domain;
+		dst_domain_ctx = crypto_io->aux_domain_ctx;
+	}
 	crypto_io->aux_offset_blocks = bdev_io->u.bdev.offset_blocks;
 	crypto_io->aux_num_blocks = bdev_io->u.bdev.num_blocks;
 
 	rc = spdk_accel_append_encrypt(&crypto_io->seq, crypto_ch->accel_channel,
-				       crypto_ch->crypto_key, &crypto_io->aux_buf_iov, 1,
-				       crypto_io->aux_domain, crypto_io->aux_domain_ctx,
+				       crypto_ch->crypto_key, dst_iovs, dst_iovcnt,
+				       dst_domain, dst_domain_ctx,
 				       bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
 				       bdev_io->u.bdev.memory_domain,
 				       bdev_io->u.bdev.memory_domain_ctx,
 				       bdev_io->u.bdev.offset_blocks, crypto_len, 0,
 				       NULL, NULL);
 	if (spdk_unlikely(rc != 0)) {
-		spdk_accel_put_buf(crypto_ch->accel_channel, crypto_io->aux_buf_raw,
-				   crypto_io->aux_domain, crypto_io->aux_domain_ctx);
+		if (aux_buf != NULL) {
+			spdk_accel_put_buf(crypto_ch->accel_channel, aux_buf,
+					   crypto_io->aux_domain, crypto_io->aux_domain_ctx);
+			crypto_io->aux_buf_raw = NULL;
+		}
 		if (rc == -ENOMEM) {
 			SPDK_DEBUGLOG(vbdev_crypto, "No memory, queue the IO.\n");
 			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_NOMEM);
@@ -326,6 +350,13 @@ vbdev_crypto_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bde
 				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
+		/* Data in an accel buffer was produced by an earlier step of the sequence, nobody
+		 * else sees it, so it is encrypted in place.
+		 */
+		if (bdev_io->u.bdev.memory_domain == spdk_accel_get_memory_domain()) {
+			crypto_encrypt(crypto_ch, bdev_io);
+			break;
+		}
 		/* For encryption we don't want to encrypt the data in place as the host isn't
 		 * expecting us to mangle its data buffers so we need to encrypt into the aux accel
 		 * buffer, then we can use that as the source for the disk data transfer.
@@ -733,7 +764,7 @@ vbdev_crypto_claim(const char *bdev_name)
 
 	/* Limit the max IO size by some reasonable value. Since in write operation we use aux buffer,
 	 * let's set the limit to the large_bufsize value */
-	spdk_iobuf_get_opts(&iobuf_opts);
+	spdk_iobuf_get_opts(&iobuf_opts, sizeof(iobuf_opts));
 
 	/* Check our list of names from config versus this bdev and if
 	 * there's a match, create the crypto_bdev & bdev accordingly.
@@ -27,9 +27,26 @@
 #include "bdev_daos.h"
 
 #define BDEV_DAOS_IOVECS_MAX 32
+#define BDEV_DAOS_QUEUES_MAX 64
+/* Chunk size of DFS objects unless set otherwise for the bdev or its container */
+#define BDEV_DAOS_DEFAULT_CHUNK_SIZE (1024 * 1024)
 
-struct bdev_daos_task {
+struct bdev_daos_task;
+
+struct bdev_daos_event {
 	daos_event_t ev;
+	struct bdev_daos_task *task;
+};
+
+/* Part of a large I/O covering a single chunk of the DFS object */
+struct bdev_daos_chunk {
+	struct bdev_daos_event event;
+	daos_size_t read_size;
+	d_sg_list_t sgl;
+};
+
+struct bdev_daos_task {
+	struct bdev_daos_event event;
 	struct spdk_thread *submit_td;
 	struct spdk_bdev_io *bdev_io;
 
@@ -41,11 +58,17 @@ struct bdev_daos_task {
 	daos_size_t read_size;
 	d_iov_t diovs[BDEV_DAOS_IOVECS_MAX];
 	d_sg_list_t sgl;
+
+	/* Chunks the I/O was split into, NULL if it wasn't */
+	struct bdev_daos_chunk *chunks;
+	uint32_t chunks_outstanding;
 };
 
 struct bdev_daos {
 	struct spdk_bdev disk;
 	daos_oclass_id_t oclass;
+	uint32_t num_queues;
+	uint64_t chunk_size;
 
 	char pool_name[DAOS_PROP_MAX_LABEL_BUF_LEN];
 	char cont_name[DAOS_PROP_MAX_LABEL_BUF_LEN];
@@ -63,7 +86,11 @@ struct bdev_daos_io_channel {
 
 	dfs_t *dfs;
 	dfs_obj_t *obj;
-	daos_handle_t queue;
+
+	/* Each event queue has its own network context, I/Os are spread across them */
+	daos_handle_t *queues;
+	uint32_t num_queues;
+	uint32_t next_queue;
 };
 
 static uint32_t g_bdev_daos_init_count = 0;
@@ -154,6 +181,138 @@ bdev_daos_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status sta
 	}
 }
 
+static daos_handle_t
+bdev_daos_next_queue(struct bdev_daos_io_channel *ch)
+{
+	daos_handle_t queue = ch->queues[ch->next_queue];
+
+	ch->next_queue = (ch->next_queue + 1) % ch->num_queues;
+
+	return queue;
+}
+
+static uint64_t
+bdev_daos_chunk_size(struct bdev_daos *daos)
+{
+	return daos->chunk_size ? daos->chunk_size : BDEV_DAOS_DEFAULT_CHUNK_SIZE;
+}
+
+/*
+ * I/Os spanning multiple chunks of the object are split at the chunk boundaries and the parts
+ * are spread across the event queues of the channel, so that they're progressed by several
+ * network contexts in parallel.  With a single queue there's nothing to gain from that, since
+ * the DAOS client already sends the parts of an I/O to the targets holding them in parallel.
+ */
+static bool
+bdev_daos_io_is_chunked(struct bdev_daos *daos, struct bdev_daos_io_channel *ch,
+			uint64_t nbytes, uint64_t offset)
+{
+	uint64_t chunk_size = bdev_daos_chunk_size(daos);
+
+	return ch->num_queues > 1 && offset / chunk_size != (offset + nbytes - 1) / chunk_size;
+}
+
+static void
+bdev_daos_chunk_done(struct bdev_daos_task *task, int error)
+{
+	assert(task->chunks_outstanding > 0);
+
+	if (error != DER_SUCCESS) {
+		task->status = SPDK_BDEV_IO_STATUS_FAILED;
+	}
+
+	if (--task->chunks_outstanding > 0) {
+		return;
+	}
+
+	free(task->chunks);
+	task->chunks = NULL;
+	bdev_daos_io_complete(task->bdev_io, task->status);
+}
+
+static int64_t
+bdev_daos_rw_chunked(struct bdev_daos *daos, struct bdev_daos_io_channel *ch,
+		     struct bdev_daos_task *task, struct iovec *iov, int iovcnt,
+		     uint64_t nbytes, uint64_t offset, bool write)
+{
+	uint64_t chunk_size = bdev_daos_chunk_size(daos);
+	uint32_t num_chunks = (offset + nbytes - 1) / chunk_size - offset / chunk_size + 1;
+	struct bdev_daos_chunk *chunk;
+	uint64_t chunk_offset, chunk_len, len, iov_offset = 0;
+	d_iov_t *diovs;
+	uint32_t i;
+	int rc = 0;
+
+	SPDK_DEBUGLOG(bdev_daos, "%s %d iovs size %lu at off: %#lx in %u chunks\n",
+		      write ? "write" : "read", iovcnt, nbytes, offset, num_chunks);
+
+	/* Each chunk boundary can split an iovec in two */
+	task->chunks = calloc(1, num_chunks * sizeof(*task->chunks) +
+			      (iovcnt + num_chunks - 1) * sizeof(*diovs));
+	if (task->chunks == NULL) {
+		return -ENOMEM;
+	}
+
+	diovs = (d_iov_t *)&task->chunks[num_chunks];
+	task->status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	task->offset = offset;
+	task->chunks_outstanding = 0;
+
+	for (i = 0, chunk_offset = offset; i < num_chunks; i++, chunk_offset += chunk_len) {
+		chunk = &task->chunks[i];
+		chunk_len = spdk_min(chunk_size - chunk_offset % chunk_size,
+				     offset + nbytes - chunk_offset);
+
+		chunk->sgl.sg_iovs = diovs;
+		for (len = 0; len < chunk_len; len += diovs->iov_len, diovs++) {
+			d_iov_set(diovs, (char *)iov->iov_base + iov_offset,
+				  spdk_min(iov->iov_len - iov_offset, chunk_len - len));
+			chunk->sgl.sg_nr++;
+			iov_offset += diovs->iov_len;
+			if (iov_offset == iov->iov_len) {
+				iov++;
+				iov_offset = 0;
+			}
+		}
+
+		chunk->event.task = task;
+		if ((rc = daos_event_init(&chunk->event.ev, bdev_daos_next_queue(ch), NULL))) {
+			SPDK_ERRLOG("%s: could not initialize async event: " DF_RC "\n",
+				    daos->disk.name, DP_RC(rc));
+			break;
+		}
+
+		if (write) {
+			rc = dfs_write(ch->dfs, ch->obj, &chunk->sgl, chunk_offset,
+				       &chunk->event.ev);
+		} else {
+			rc = dfs_read(ch->dfs, ch->obj, &chunk->sgl, chunk_offset,
+				      &chunk->read_size, &chunk->event.ev);
+		}
+		if (rc) {
+			SPDK_ERRLOG("%s: could not start async %s: " DF_RC "\n",
+				    daos->disk.name, write ? "write" : "read", DP_RC(rc));
+			daos_event_fini(&chunk->event.ev);
+			break;
+		}
+
+		task->chunks_outstanding++;
+	}
+
+	if (task->chunks_outstanding == 0) {
+		free(task->chunks);
+		task->chunks = NULL;
+		return -EINVAL;
+	}
+
+	/* The chunks already submitted still need to complete before the I/O can be failed */
+	if (rc) {
+		task->status = SPDK_BDEV_IO_STATUS_FAILED;
+	}
+
+	return nbytes;
+}
+
 static int64_t
 bdev_daos_writev(struct bdev_daos *daos, struct bdev_daos_io_channel *ch,
 		 struct bdev_daos_task *task,
@@ -169,13 +328,18 @@ bdev_daos_writev(struct bdev_daos *daos, struct bdev_daos_io_channel *ch,
 	assert(task != NULL);
 	assert(iov != NULL);
 
+	if (bdev_daos_io_is_chunked(daos, ch, nbytes, offset)) {
+		return bdev_daos_rw_chunked(daos, ch, task, iov, iovcnt, nbytes, offset, true);
+	}
+
 	if (iovcnt > BDEV_DAOS_IOVECS_MAX) {
 		SPDK_ERRLOG("iovs number [%d] exceeds max allowed limit [%d]\n", iovcnt,
 			    BDEV_DAOS_IOVECS_MAX);
 		return -E2BIG;
 	}
 
-	if ((rc = daos_event_init(&task->ev, ch->queue, NULL))) {
+	task->event.task = task;
+	if ((rc = daos_event_init(&task->event.ev, bdev_daos_next_queue(ch), NULL))) {
 		SPDK_ERRLOG("%s: could not initialize async event: " DF_RC "\n",
 			    daos->disk.name, DP_RC(rc));
 		return -EINVAL;
@@ -190,10 +354,10 @@ bdev_daos_writev(struct bdev_daos *daos, struct bdev_daos_io_channel *ch,
 	task->sgl.sg_iovs = task->diovs;
 	task->offset = offset;
 
-	if ((rc = dfs_write(ch->dfs, ch->obj, &task->sgl, offset, &task->ev))) {
+	if ((rc = dfs_write(ch->dfs, ch->obj, &task->sgl, offset, &task->event.ev))) {
 		SPDK_ERRLOG("%s: could not start async write: " DF_RC "\n",
 			    daos->disk.name, DP_RC(rc));
-		daos_event_fini(&task->ev);
+		daos_event_fini(&task->event.ev);
 		return -EINVAL;
 	}
 
@@ -215,13 +379,18 @@ bdev_daos_readv(struct bdev_daos *daos, struct bdev_daos_io_channel *ch,
 	assert(task != NULL);
 	assert(iov != NULL);
 
+	if (bdev_daos_io_is_chunked(daos, ch, nbytes, offset)) {
+		return bdev_daos_rw_chunked(daos, ch, task, iov, iovcnt, nbytes, offset, false);
+	}
+
 	if (iovcnt > BDEV_DAOS_IOVECS_MAX) {
 		SPDK_ERRLOG("iovs number [%d] exceeds max allowed limit [%d]\n", iovcnt,
 			    BDEV_DAOS_IOVECS_MAX);
 		return -E2BIG;
 	}
 
-	if ((rc = daos_event_init(&task->ev, ch->queue, NULL))) {
+	task->event.task = task;
+	if ((rc = daos_event_init(&task->event.ev, bdev_daos_next_queue(ch), NULL))) {
 		SPDK_ERRLOG("%s: could not initialize async event: " DF_RC "\n",
 			    daos->disk.name, DP_RC(rc));
 		return -EINVAL;
@@ -236,10 +405,11 @@ bdev_daos_readv(struct bdev_daos *daos, struct bdev_daos_io_channel *ch,
 	task->sgl.sg_iovs = task->diovs;
 	task->offset = offset;
 
-	if ((rc = dfs_read(ch->dfs, ch->obj, &task->sgl, offset, &task->read_size, &task->ev))) {
+	if ((rc = dfs_read(ch->dfs, ch->obj, &task->sgl, offset, &task->read_size,
+			   &task->event.ev))) {
 		SPDK_ERRLOG("%s: could not start async read: " DF_RC "\n",
 			    daos->disk.name, DP_RC(rc));
-		daos_event_fini(&task->ev);
+		daos_event_fini(&task->event.ev);
 		return -EINVAL;
 	}
 
@@ -277,11 +447,13 @@ _bdev_daos_get_io_inflight(struct spdk_io_channel_iter *i)
 {
 	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
 	struct bdev_daos_io_channel *dch = spdk_io_channel_get_ctx(ch);
-	int io_inflight = daos_eq_query(dch->queue, DAOS_EQR_WAITING, 0, NULL);
+	uint32_t q;
 
-	if (io_inflight > 0) {
-		spdk_for_each_channel_continue(i, -1);
-		return;
+	for (q = 0; q < dch->num_queues; q++) {
+		if (daos_eq_query(dch->queues[q], DAOS_EQR_WAITING, 0, NULL) > 0) {
+			spdk_for_each_channel_continue(i, -1);
+			return;
+		}
 	}
 
 	spdk_for_each_channel_continue(i, 0);
@@ -411,46 +583,74 @@ bdev_daos_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 }
 
 #define POLLING_EVENTS_NUM 64
+/* Limits the number of events harvested from a single queue within one poll */
+#define POLLING_BATCHES_MAX 4
 
 static int
-bdev_daos_channel_poll(void *arg)
+bdev_daos_queue_poll(struct bdev_daos_io_channel *ch, daos_handle_t queue)
 {
 	daos_event_t *evp[POLLING_EVENTS_NUM];
-	struct bdev_daos_io_channel *ch = arg;
+	struct bdev_daos_event *event;
+	struct bdev_daos_task *task;
+	int rc, i, batch, error, count = 0;
 
-	assert(ch != NULL);
-	assert(ch->disk != NULL);
+	for (batch = 0; batch < POLLING_BATCHES_MAX; batch++) {
+		rc = daos_eq_poll(queue, 0, DAOS_EQ_NOWAIT, POLLING_EVENTS_NUM, evp);
+		if (rc < 0) {
+			SPDK_DEBUGLOG(bdev_daos, "%s: could not poll daos event queue: " DF_RC "\n",
+				      ch->disk->disk.name, DP_RC(rc));
+			/*
+			 * TODO: There are cases when this is self healing, e.g.
+			 * brief network issues, DAOS agent restarting etc.
+			 * However, if the issue persists over some time better would be
+			 * to remove a bdev or the whole controller
+			 */
+			return count;
+		}
+
+		for (i = 0; i < rc; ++i) {
+			event = SPDK_CONTAINEROF(evp[i], struct bdev_daos_event, ev);
+			task = event->task;
+
+			assert(task != NULL);
+
+			error = event->ev.ev_error;
+			daos_event_fini(&event->ev);
+			if (task->chunks != NULL) {
+				bdev_daos_chunk_done(task, error);
+			} else if (error != DER_SUCCESS) {
+				bdev_daos_io_complete(task->bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+			} else {
+				bdev_daos_io_complete(task->bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+			}
+		}
 
-	int rc = daos_eq_poll(ch->queue, 0, DAOS_EQ_NOWAIT,
-			      POLLING_EVENTS_NUM, evp);
+		count += rc;
 
-	if (rc < 0) {
-		SPDK_DEBUGLOG(bdev_daos, "%s: could not poll daos event queue: " DF_RC "\n",
-			      ch->disk->disk.name, DP_RC(rc));
-		/*
-		 * TODO: There are cases when this is self healing, e.g.
-		 * brief network issues, DAOS agent restarting etc.
-		 * However, if the issue persists over some time better would be
-		 * to remove a bdev or the whole controller
-		 */
-		return SPDK_POLLER_BUSY;
+		/* A partial batch means the queue is drained */
+		if (rc < POLLING_EVENTS_NUM) {
+			break;
+		}
 	}
 
-	for (int i = 0; i < rc; ++i) {
-		struct bdev_daos_task *task = SPDK_CONTAINEROF(evp[i], struct bdev_daos_task, ev);
-		enum spdk_bdev_io_status status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	return count;
+}
 
-		assert(task != NULL);
+static int
+bdev_daos_channel_poll(void *arg)
+{
+	struct bdev_daos_io_channel *ch = arg;
+	uint32_t q;
+	int count = 0;
 
-		if (task->ev.ev_error != DER_SUCCESS) {
-			status = SPDK_BDEV_IO_STATUS_FAILED;
-		}
+	assert(ch != NULL);
+	assert(ch->disk != NULL);
 
-		daos_event_fini(&task->ev);
-		bdev_daos_io_complete(task->bdev_io, status);
+	for (q = 0; q < ch->num_queues; q++) {
+		count += bdev_daos_queue_poll(ch, ch->queues[q]);
 	}
 
-	return rc > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 }
 
 static bool
@@ -491,6 +691,10 @@ bdev_daos_write_json_config(struct spdk_bdev *bdev, struct spdk_json_write_ctx *
 	spdk_json_write_named_string(w, "cont", daos->cont_name);
 	spdk_json_write_named_uint64(w, "num_blocks", bdev->blockcnt);
 	spdk_json_write_named_uint32(w, "block_size", bdev->blocklen);
+	spdk_json_write_named_uint32(w, "num_queues", daos->num_queues);
+	if (daos->chunk_size) {
+		spdk_json_write_named_uint64(w, "chunk_size", daos->chunk_size);
+	}
 	spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &bdev->uuid);
 	spdk_json_write_named_string(w, "uuid", uuid_str);
 
@@ -513,6 +717,7 @@ _bdev_daos_io_channel_create_cb(void *ctx)
 	int rc = 0 ;
 	struct bdev_daos_io_channel *ch = ctx;
 	struct bdev_daos *daos = ch->disk;
+	uint32_t q;
 
 	daos_pool_info_t pinfo;
 	daos_cont_info_t cinfo;
@@ -546,19 +751,33 @@ _bdev_daos_io_channel_create_cb(void *ctx)
 	}
 	SPDK_DEBUGLOG(bdev_daos, "opening dfs object\n");
 	if ((rc = dfs_open(ch->dfs, NULL, daos->disk.name, mode, fd_oflag, daos->oclass,
-			   0, NULL, &ch->obj))) {
+			   daos->chunk_size, NULL, &ch->obj))) {
 		SPDK_ERRLOG("%s: could not open dfs object: " DF_RC "\n",
 			    daos->disk.name, DP_RC(rc));
 		goto cleanup_mount;
 	}
-	if ((rc = daos_eq_create(&ch->queue))) {
-		SPDK_ERRLOG("%s: could not create daos event queue: " DF_RC "\n",
-			    daos->disk.name, DP_RC(rc));
+	ch->queues = calloc(daos->num_queues, sizeof(*ch->queues));
+	if (ch->queues == NULL) {
+		SPDK_ERRLOG("%s: could not allocate daos event queues\n", daos->disk.name);
 		goto cleanup_obj;
 	}
+	for (ch->num_queues = 0; ch->num_queues < daos->num_queues; ch->num_queues++) {
+		if ((rc = daos_eq_create(&ch->queues[ch->num_queues]))) {
+			SPDK_ERRLOG("%s: could not create daos event queue: " DF_RC "\n",
+				    daos->disk.name, DP_RC(rc));
+			goto cleanup_queues;
+		}
+	}
 
 	return ctx;
 
+cleanup_queues:
+	for (q = 0; q < ch->num_queues; q++) {
+		daos_eq_destroy(ch->queues[q], DAOS_EQ_DESTROY_FORCE);
+	}
+	free(ch->queues);
+	ch->queues = NULL;
+	ch->num_queues = 0;
 cleanup_obj:
 	dfs_release(ch->obj);
 cleanup_mount:
@@ -594,15 +813,19 @@ static void
 bdev_daos_io_channel_destroy_cb(void *io_device, void *ctx_buf)
 {
 	int rc;
+	uint32_t q;
 	struct bdev_daos_io_channel *ch = ctx_buf;
 
 	SPDK_DEBUGLOG(bdev_daos, "stopping daos event queue poller\n");
 
 	spdk_poller_unregister(&ch->poller);
 
-	if ((rc = daos_eq_destroy(ch->queue, DAOS_EQ_DESTROY_FORCE))) {
-		SPDK_ERRLOG("could not destroy daos event queue: " DF_RC "\n", DP_RC(rc));
+	for (q = 0; q < ch->num_queues; q++) {
+		if ((rc = daos_eq_destroy(ch->queues[q], DAOS_EQ_DESTROY_FORCE))) {
+			SPDK_ERRLOG("could not destroy daos event queue: " DF_RC "\n", DP_RC(rc));
+		}
 	}
+	free(ch->queues);
 	if ((rc = dfs_release(ch->obj))) {
 		SPDK_ERRLOG("could not release dfs object: " DF_RC "\n", DP_RC(rc));
 	}
@@ -625,7 +848,8 @@ int
 create_bdev_daos(struct spdk_bdev **bdev,
 		 const char *name, const struct spdk_uuid *uuid,
 		 const char *pool, const char *cont, const char *oclass,
-		 uint64_t num_blocks, uint32_t block_size)
+		 uint64_t num_blocks, uint32_t block_size,
+		 uint32_t num_queues, uint64_t chunk_size)
 {
 	int rc;
 	size_t len;
@@ -658,6 +882,14 @@ create_bdev_daos(struct spdk_bdev **bdev,
 		return -EINVAL;
 	}
 
+	if (num_queues == 0) {
+		num_queues = 1;
+	}
+	if (num_queues > BDEV_DAOS_QUEUES_MAX) {
+		SPDK_ERRLOG("number of event queues must not exceed %d\n", BDEV_DAOS_QUEUES_MAX);
+		return -EINVAL;
+	}
+
 	daos = calloc(1, sizeof(*daos));
 	if (!daos) {
 		SPDK_ERRLOG("calloc() failed\n");
@@ -673,6 +905,8 @@ create_bdev_daos(struct spdk_bdev **bdev,
 		free(daos);
 		return -EINVAL;
 	}
+	daos->num_queues = num_queues;
+	daos->chunk_size = chunk_size;
 
 	len = strlen(pool);
 	if (len > DAOS_PROP_LABEL_MAX_LEN) {
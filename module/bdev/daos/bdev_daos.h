@@ -12,7 +12,8 @@
 
 int create_bdev_daos(struct spdk_bdev **bdev, const char *name, const struct spdk_uuid *uuid,
 		     const char *pool, const char *cont, const char *oclass,
-		     uint64_t num_blocks, uint32_t block_size);
+		     uint64_t num_blocks, uint32_t block_size,
+		     uint32_t num_queues, uint64_t chunk_size);
 
 void delete_bdev_daos(const char *bdev_name, spdk_bdev_unregister_cb cb_fn, void *cb_arg);
 
@@ -19,6 +19,8 @@ struct rpc_construct_daos {
 	char *oclass;
 	uint64_t num_blocks;
 	uint32_t block_size;
+	uint32_t num_queues;
+	uint64_t chunk_size;
 };
 
 static void
@@ -39,6 +41,10 @@ static const struct spdk_json_object_decoder rpc_construct_daos_decoders[] = {
 	{"oclass", offsetof(struct rpc_construct_daos, oclass), spdk_json_decode_string, true},
 	{"num_blocks", offsetof(struct rpc_construct_daos, num_blocks), spdk_json_decode_uint64},
 	{"block_size", offsetof(struct rpc_construct_daos, block_size), spdk_json_decode_uint32},
+	{"num_queues", offsetof(struct rpc_construct_daos, num_queues), spdk_json_decode_uint32,
+		true},
+	{"chunk_size", offsetof(struct rpc_construct_daos, chunk_size), spdk_json_decode_uint64,
+		true},
 };
 
 static void
@@ -71,7 +77,7 @@ rpc_bdev_daos_create(struct spdk_jsonrpc_request *request,
 	}
 
 	rc = create_bdev_daos(&bdev, req.name, uuid, req.pool, req.cont, req.oclass,
-			      req.num_blocks, req.block_size);
+			      req.num_blocks, req.block_size, req.num_queues, req.chunk_size);
 	if (rc) {
 		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
 		goto cleanup;
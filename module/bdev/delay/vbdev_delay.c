@@ -8,6 +8,7 @@
 
 #include "vbdev_delay.h"
 #include "spdk/rpc.h"
+#include "spdk/accel.h"
 #include "spdk/env.h"
 #include "spdk/endian.h"
 #include "spdk/string.h"
@@ -44,6 +45,9 @@ struct bdev_association {
 	uint64_t		p99_read_latency;
 	uint64_t		avg_write_latency;
 	uint64_t		p99_write_latency;
+	enum delay_distribution	distribution;
+	uint64_t		stall_period_us;
+	uint64_t		stall_duration_us;
 	TAILQ_ENTRY(bdev_association)	link;
 };
 static TAILQ_HEAD(, bdev_association) g_bdev_associations = TAILQ_HEAD_INITIALIZER(
@@ -58,6 +62,14 @@ struct vbdev_delay {
 	uint64_t			p99_read_latency_ticks; /* the p99 read delay */
 	uint64_t			average_write_latency_ticks; /* the average write delay */
 	uint64_t			p99_write_latency_ticks; /* the p99 write delay */
+	enum delay_distribution		distribution;
+	/* Shape of the lognormal distributions, derived from the average and p99 latencies */
+	double				read_sigma;
+	double				write_sigma;
+	/* The device stalls for the last stall_duration_ticks of every stall_period_ticks */
+	uint64_t			stall_period_ticks;
+	uint64_t			stall_duration_ticks;
+	uint64_t			stall_base_tick;
 	TAILQ_ENTRY(vbdev_delay)	link;
 	struct spdk_thread		*thread;    /* thread where base device is opened */
 };
@@ -76,15 +88,37 @@ struct delay_bdev_io {
 
 	struct spdk_bdev_io *zcopy_bdev_io;
 
-	STAILQ_ENTRY(delay_bdev_io) link;
+	/* Slot of the timer wheel the I/O is queued in */
+	uint32_t slot;
+
+	TAILQ_ENTRY(delay_bdev_io) link;
 };
 
+/* The timer wheel covers DELAY_WHEEL_SLOTS * DELAY_WHEEL_SLOT_US (~41ms), I/O delayed further
+ * is kept on an overflow list until it gets within range. */
+#define DELAY_WHEEL_SLOTS	4096
+#define DELAY_WHEEL_SLOT_US	10
+#define DELAY_WHEEL_OVERFLOW	UINT32_MAX
+#define DELAY_WHEEL_NONE	(UINT32_MAX - 1)
+
+/* 99th percentile of the standard normal distribution */
+#define DELAY_NORMAL_P99	2.326348
+
+TAILQ_HEAD(delay_io_list, delay_bdev_io);
+
 struct delay_io_channel {
 	struct spdk_io_channel	*base_ch; /* IO channel of base device */
-	STAILQ_HEAD(, delay_bdev_io) avg_read_io;
-	STAILQ_HEAD(, delay_bdev_io) p99_read_io;
-	STAILQ_HEAD(, delay_bdev_io) avg_write_io;
-	STAILQ_HEAD(, delay_bdev_io) p99_write_io;
+	/* Delayed I/O, each slot holding the I/O completing within slot_ticks of each other */
+	struct delay_io_list	wheel[DELAY_WHEEL_SLOTS];
+	uint32_t		wheel_pos;
+	uint32_t		wheel_count;
+	/* First tick of the slot at wheel_pos */
+	uint64_t		wheel_tick;
+	uint64_t		slot_ticks;
+	struct delay_io_list	overflow;
+	uint64_t		overflow_min_tick;
+	/* Completion tick of the last I/O of each type, keeps the bimodal latencies in order */
+	uint64_t		last_tick[DELAY_NONE];
 	struct spdk_poller *io_poller;
 	unsigned int rand_seed;
 };
@@ -138,48 +172,156 @@ vbdev_delay_destruct(void *ctx)
 	return 0;
 }
 
-static int
-_process_io_stailq(void *arg, uint64_t ticks)
+static void
+delay_wheel_insert(struct delay_io_channel *delay_ch, struct delay_bdev_io *io_ctx)
 {
-	STAILQ_HEAD(, delay_bdev_io) *head = arg;
-	struct delay_bdev_io *io_ctx, *tmp;
-	int completions = 0;
+	uint64_t offset = 0;
 
-	STAILQ_FOREACH_SAFE(io_ctx, head, link, tmp) {
-		if (io_ctx->completion_tick <= ticks) {
-			STAILQ_REMOVE(head, io_ctx, delay_bdev_io, link);
-			spdk_bdev_io_complete(spdk_bdev_io_from_ctx(io_ctx), io_ctx->status);
-			completions++;
-		} else {
-			/* In the general case, I/O will become ready in an fifo order. When timeouts are dynamically
-			 * changed, this is not necessarily the case. However, the normal behavior will be restored
-			 * after the outstanding I/O at the time of the change have been completed.
-			 * This essentially means that moving from a high to low latency creates a dam for the new I/O
-			 * submitted after the latency change. This is considered desirable behavior for the use case where
-			 * we are trying to trigger a pre-defined timeout on an initiator.
-			 */
-			break;
-		}
+	if (io_ctx->completion_tick > delay_ch->wheel_tick) {
+		offset = (io_ctx->completion_tick - delay_ch->wheel_tick) / delay_ch->slot_ticks;
+	}
+
+	if (offset >= DELAY_WHEEL_SLOTS) {
+		io_ctx->slot = DELAY_WHEEL_OVERFLOW;
+		TAILQ_INSERT_TAIL(&delay_ch->overflow, io_ctx, link);
+		delay_ch->overflow_min_tick = spdk_min(delay_ch->overflow_min_tick,
+						       io_ctx->completion_tick);
+		return;
 	}
 
-	return completions;
+	io_ctx->slot = (delay_ch->wheel_pos + offset) % DELAY_WHEEL_SLOTS;
+	TAILQ_INSERT_TAIL(&delay_ch->wheel[io_ctx->slot], io_ctx, link);
+	delay_ch->wheel_count++;
+}
+
+static void
+delay_wheel_remove(struct delay_io_channel *delay_ch, struct delay_bdev_io *io_ctx)
+{
+	if (io_ctx->slot == DELAY_WHEEL_OVERFLOW) {
+		TAILQ_REMOVE(&delay_ch->overflow, io_ctx, link);
+	} else {
+		TAILQ_REMOVE(&delay_ch->wheel[io_ctx->slot], io_ctx, link);
+		delay_ch->wheel_count--;
+	}
+}
+
+static void
+delay_wheel_migrate_overflow(struct delay_io_channel *delay_ch)
+{
+	struct delay_io_list overflow = TAILQ_HEAD_INITIALIZER(overflow);
+	struct delay_bdev_io *io_ctx;
+
+	TAILQ_SWAP(&overflow, &delay_ch->overflow, delay_bdev_io, link);
+	delay_ch->overflow_min_tick = UINT64_MAX;
+
+	while ((io_ctx = TAILQ_FIRST(&overflow)) != NULL) {
+		TAILQ_REMOVE(&overflow, io_ctx, link);
+		delay_wheel_insert(delay_ch, io_ctx);
+	}
 }
 
 static int
 _delay_finish_io(void *arg)
 {
 	struct delay_io_channel *delay_ch = arg;
+	struct delay_bdev_io *io_ctx, *tmp;
+	struct delay_io_list *slot;
 	uint64_t ticks = spdk_get_ticks();
 	int completions = 0;
 
-	completions += _process_io_stailq(&delay_ch->avg_read_io, ticks);
-	completions += _process_io_stailq(&delay_ch->avg_write_io, ticks);
-	completions += _process_io_stailq(&delay_ch->p99_read_io, ticks);
-	completions += _process_io_stailq(&delay_ch->p99_write_io, ticks);
+	if (delay_ch->wheel_count == 0) {
+		/* Nothing to walk through, just move the wheel to the current time */
+		delay_ch->wheel_tick = ticks;
+	}
+
+	if (delay_ch->overflow_min_tick <
+	    delay_ch->wheel_tick + DELAY_WHEEL_SLOTS * delay_ch->slot_ticks) {
+		delay_wheel_migrate_overflow(delay_ch);
+	}
+
+	while (delay_ch->wheel_count > 0 && delay_ch->wheel_tick <= ticks) {
+		slot = &delay_ch->wheel[delay_ch->wheel_pos];
+		TAILQ_FOREACH_SAFE(io_ctx, slot, link, tmp) {
+			if (io_ctx->completion_tick <= ticks) {
+				delay_wheel_remove(delay_ch, io_ctx);
+				spdk_bdev_io_complete(spdk_bdev_io_from_ctx(io_ctx), io_ctx->status);
+				completions++;
+			}
+		}
+
+		if (!TAILQ_EMPTY(slot)) {
+			/* The rest of the current slot isn't due yet */
+			break;
+		}
+
+		delay_ch->wheel_pos = (delay_ch->wheel_pos + 1) % DELAY_WHEEL_SLOTS;
+		delay_ch->wheel_tick += delay_ch->slot_ticks;
+	}
 
 	return completions == 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
 }
 
+static uint64_t
+delay_sample_lognormal(uint64_t median_ticks, double sigma, unsigned int *seed)
+{
+	double u1, u2, z;
+
+	/* Box-Muller transform of two uniform samples from (0, 1] */
+	u1 = (rand_r(seed) + 1.0) / ((double)RAND_MAX + 1.0);
+	u2 = (rand_r(seed) + 1.0) / ((double)RAND_MAX + 1.0);
+	z = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+
+	return (uint64_t)(median_ticks * exp(sigma * z));
+}
+
+static uint64_t
+delay_get_latency_ticks(struct vbdev_delay *delay_node, struct delay_io_channel *delay_ch,
+			enum delay_io_type type)
+{
+	switch (delay_node->distribution) {
+	case DELAY_DISTRIBUTION_LOGNORMAL:
+		/* The average latency is the median and p99 the 99th percentile */
+		if (type == DELAY_AVG_READ || type == DELAY_P99_READ) {
+			return delay_sample_lognormal(delay_node->average_read_latency_ticks,
+						      delay_node->read_sigma, &delay_ch->rand_seed);
+		}
+		return delay_sample_lognormal(delay_node->average_write_latency_ticks,
+					      delay_node->write_sigma, &delay_ch->rand_seed);
+	case DELAY_DISTRIBUTION_BIMODAL:
+	default:
+		switch (type) {
+		case DELAY_AVG_READ:
+			return delay_node->average_read_latency_ticks;
+		case DELAY_P99_READ:
+			return delay_node->p99_read_latency_ticks;
+		case DELAY_AVG_WRITE:
+			return delay_node->average_write_latency_ticks;
+		case DELAY_P99_WRITE:
+			return delay_node->p99_write_latency_ticks;
+		default:
+			return 0;
+		}
+	}
+}
+
+static uint64_t
+delay_apply_stall(struct vbdev_delay *delay_node, uint64_t tick)
+{
+	uint64_t phase;
+
+	if (delay_node->stall_duration_ticks == 0) {
+		return tick;
+	}
+
+	/* Hold the I/O completing during a stall until its end */
+	phase = (tick - delay_node->stall_base_tick) % delay_node->stall_period_ticks;
+	if (phase >= delay_node->stall_period_ticks - delay_node->stall_duration_ticks) {
+		tick += delay_node->stall_period_ticks - phase;
+	}
+
+	return tick;
+}
+
 /* Completion callback for IO that were issued from this bdev. The original bdev_io
  * is passed in as an arg so we'll complete that one with the appropriate status
  * and then free the one that this module issued.
@@ -202,29 +344,28 @@ _delay_complete_io(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 		spdk_bdev_free_io(bdev_io);
 	}
 
-	/* Put the I/O into the proper list for processing by the channel poller. */
-	switch (io_ctx->type) {
-	case DELAY_AVG_READ:
-		io_ctx->completion_tick = spdk_get_ticks() + delay_node->average_read_latency_ticks;
-		STAILQ_INSERT_TAIL(&delay_ch->avg_read_io, io_ctx, link);
-		break;
-	case DELAY_AVG_WRITE:
-		io_ctx->completion_tick = spdk_get_ticks() + delay_node->average_write_latency_ticks;
-		STAILQ_INSERT_TAIL(&delay_ch->avg_write_io, io_ctx, link);
-		break;
-	case DELAY_P99_READ:
-		io_ctx->completion_tick = spdk_get_ticks() + delay_node->p99_read_latency_ticks;
-		STAILQ_INSERT_TAIL(&delay_ch->p99_read_io, io_ctx, link);
-		break;
-	case DELAY_P99_WRITE:
-		io_ctx->completion_tick = spdk_get_ticks() + delay_node->p99_write_latency_ticks;
-		STAILQ_INSERT_TAIL(&delay_ch->p99_write_io, io_ctx, link);
-		break;
-	case DELAY_NONE:
-	default:
+	if (io_ctx->type == DELAY_NONE) {
 		spdk_bdev_io_complete(orig_io, io_ctx->status);
-		break;
+		return;
+	}
+
+	io_ctx->completion_tick = spdk_get_ticks() + delay_get_latency_ticks(delay_node, delay_ch,
+				  io_ctx->type);
+	if (delay_node->distribution == DELAY_DISTRIBUTION_BIMODAL) {
+		/* I/O of a given type completes in order.  When the latencies are dynamically
+		 * changed, this means that moving from a high to low latency creates a dam for the
+		 * new I/O submitted after the latency change, until the outstanding I/O at the time
+		 * of the change have been completed.  This is considered desirable behavior for the
+		 * use case where we are trying to trigger a pre-defined timeout on an initiator.
+		 */
+		io_ctx->completion_tick = spdk_max(io_ctx->completion_tick,
+						   delay_ch->last_tick[io_ctx->type]);
+		delay_ch->last_tick[io_ctx->type] = io_ctx->completion_tick;
 	}
+	io_ctx->completion_tick = delay_apply_stall(delay_node, io_ctx->completion_tick);
+
+	/* Put the I/O into the timer wheel for processing by the channel poller. */
+	delay_wheel_insert(delay_ch, io_ctx);
 }
 
 static void
@@ -236,6 +377,18 @@ vbdev_delay_resubmit_io(void *arg)
 	vbdev_delay_submit_request(io_ctx->ch, bdev_io);
 }
 
+static void
+vbdev_delay_fail_io(struct spdk_bdev_io *bdev_io)
+{
+	/* The accel sequence is owned by us until it is sent to the base bdev */
+	if ((bdev_io->type == SPDK_BDEV_IO_TYPE_READ || bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE) &&
+	    bdev_io->u.bdev.accel_sequence != NULL) {
+		spdk_accel_sequence_abort(bdev_io->u.bdev.accel_sequence);
+	}
+
+	spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+}
+
 static void
 vbdev_delay_queue_io(struct spdk_bdev_io *bdev_io)
 {
@@ -250,7 +403,7 @@ vbdev_delay_queue_io(struct spdk_bdev_io *bdev_io)
 	rc = spdk_bdev_queue_io_wait(bdev_io->bdev, delay_ch->base_ch, &io_ctx->bdev_io_wait);
 	if (rc != 0) {
 		SPDK_ERRLOG("Queue io failed in vbdev_delay_queue_io, rc=%d.\n", rc);
-		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		vbdev_delay_fail_io(bdev_io);
 	}
 }
 
@@ -262,6 +415,7 @@ delay_init_ext_io_opts(struct spdk_bdev_io *bdev_io, struct spdk_bdev_ext_io_opt
 	opts->memory_domain = bdev_io->u.bdev.memory_domain;
 	opts->memory_domain_ctx = bdev_io->u.bdev.memory_domain_ctx;
 	opts->metadata = bdev_io->u.bdev.md_buf;
+	opts->accel_sequence = bdev_io->u.bdev.accel_sequence;
 }
 
 static void
@@ -274,7 +428,7 @@ delay_read_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
 	int rc;
 
 	if (!success) {
-		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		vbdev_delay_fail_io(bdev_io);
 		return;
 	}
 
@@ -289,7 +443,7 @@ delay_read_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
 		vbdev_delay_queue_io(bdev_io);
 	} else if (rc != 0) {
 		SPDK_ERRLOG("ERROR on bdev_io submission!\n");
-		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		vbdev_delay_fail_io(bdev_io);
 	}
 }
 
@@ -321,13 +475,12 @@ abort_zcopy_io(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 }
 
 static void
-_abort_all_delayed_io(void *arg)
+_abort_all_delayed_io(struct delay_io_channel *delay_ch, struct delay_io_list *head)
 {
-	STAILQ_HEAD(, delay_bdev_io) *head = arg;
 	struct delay_bdev_io *io_ctx, *tmp;
 
-	STAILQ_FOREACH_SAFE(io_ctx, head, link, tmp) {
-		STAILQ_REMOVE(head, io_ctx, delay_bdev_io, link);
+	TAILQ_FOREACH_SAFE(io_ctx, head, link, tmp) {
+		delay_wheel_remove(delay_ch, io_ctx);
 		if (io_ctx->zcopy_bdev_io != NULL) {
 			spdk_bdev_zcopy_end(io_ctx->zcopy_bdev_io, false, abort_zcopy_io, NULL);
 		}
@@ -340,25 +493,35 @@ vbdev_delay_reset_channel(struct spdk_io_channel_iter *i)
 {
 	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
 	struct delay_io_channel *delay_ch = spdk_io_channel_get_ctx(ch);
+	uint32_t slot;
 
-	_abort_all_delayed_io(&delay_ch->avg_read_io);
-	_abort_all_delayed_io(&delay_ch->avg_write_io);
-	_abort_all_delayed_io(&delay_ch->p99_read_io);
-	_abort_all_delayed_io(&delay_ch->p99_write_io);
+	for (slot = 0; slot < DELAY_WHEEL_SLOTS && delay_ch->wheel_count > 0; slot++) {
+		_abort_all_delayed_io(delay_ch, &delay_ch->wheel[slot]);
+	}
+	_abort_all_delayed_io(delay_ch, &delay_ch->overflow);
 
 	spdk_for_each_channel_continue(i, 0);
 }
 
 static bool
-abort_delayed_io(void *_head, struct spdk_bdev_io *bio_to_abort)
+abort_delayed_io(struct delay_io_channel *delay_ch, struct spdk_bdev_io *bio_to_abort)
 {
-	STAILQ_HEAD(, delay_bdev_io) *head = _head;
 	struct delay_bdev_io *io_ctx_to_abort = (struct delay_bdev_io *)bio_to_abort->driver_ctx;
+	struct delay_io_list *head;
 	struct delay_bdev_io *io_ctx;
 
-	STAILQ_FOREACH(io_ctx, head, link) {
+	/* The I/O may not be delayed at all, make sure it's really in the slot it points to */
+	if (io_ctx_to_abort->slot == DELAY_WHEEL_OVERFLOW) {
+		head = &delay_ch->overflow;
+	} else if (io_ctx_to_abort->slot < DELAY_WHEEL_SLOTS) {
+		head = &delay_ch->wheel[io_ctx_to_abort->slot];
+	} else {
+		return false;
+	}
+
+	TAILQ_FOREACH(io_ctx, head, link) {
 		if (io_ctx == io_ctx_to_abort) {
-			STAILQ_REMOVE(head, io_ctx_to_abort, delay_bdev_io, link);
+			delay_wheel_remove(delay_ch, io_ctx_to_abort);
 			if (io_ctx->zcopy_bdev_io != NULL) {
 				spdk_bdev_zcopy_end(io_ctx->zcopy_bdev_io, false, abort_zcopy_io, NULL);
 			}
@@ -376,10 +539,7 @@ vbdev_delay_abort(struct vbdev_delay *delay_node, struct delay_io_channel *delay
 {
 	struct spdk_bdev_io *bio_to_abort = bdev_io->u.abort.bio_to_abort;
 
-	if (abort_delayed_io(&delay_ch->avg_read_io, bio_to_abort) ||
-	    abort_delayed_io(&delay_ch->avg_write_io, bio_to_abort) ||
-	    abort_delayed_io(&delay_ch->p99_read_io, bio_to_abort) ||
-	    abort_delayed_io(&delay_ch->p99_write_io, bio_to_abort)) {
+	if (abort_delayed_io(delay_ch, bio_to_abort)) {
 		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
 		return 0;
 	}
@@ -402,6 +562,7 @@ vbdev_delay_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev
 
 	io_ctx->ch = ch;
 	io_ctx->type = DELAY_NONE;
+	io_ctx->slot = DELAY_WHEEL_NONE;
 	if (bdev_io->type != SPDK_BDEV_IO_TYPE_ZCOPY || bdev_io->u.bdev.zcopy.start) {
 		io_ctx->zcopy_bdev_io = NULL;
 	}
@@ -477,7 +638,7 @@ vbdev_delay_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev
 		vbdev_delay_queue_io(bdev_io);
 	} else if (rc != 0) {
 		SPDK_ERRLOG("ERROR on bdev_io submission!\n");
-		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		vbdev_delay_fail_io(bdev_io);
 	}
 }
 
@@ -500,6 +661,18 @@ vbdev_delay_get_io_channel(void *ctx)
 	return delay_ch;
 }
 
+static const char *
+delay_distribution_str(enum delay_distribution distribution)
+{
+	switch (distribution) {
+	case DELAY_DISTRIBUTION_LOGNORMAL:
+		return "lognormal";
+	case DELAY_DISTRIBUTION_BIMODAL:
+	default:
+		return "bimodal";
+	}
+}
+
 static void
 _delay_write_conf_values(struct vbdev_delay *delay_node, struct spdk_json_write_ctx *w)
 {
@@ -520,6 +693,12 @@ _delay_write_conf_values(struct vbdev_delay *delay_node, struct spdk_json_write_
 				    delay_node->average_write_latency_ticks * SPDK_SEC_TO_USEC / spdk_get_ticks_hz());
 	spdk_json_write_named_int64(w, "p99_write_latency",
 				    delay_node->p99_write_latency_ticks * SPDK_SEC_TO_USEC / spdk_get_ticks_hz());
+	spdk_json_write_named_string(w, "latency_distribution",
+				     delay_distribution_str(delay_node->distribution));
+	spdk_json_write_named_uint64(w, "stall_period_us",
+				     delay_node->stall_period_ticks * SPDK_SEC_TO_USEC / spdk_get_ticks_hz());
+	spdk_json_write_named_uint64(w, "stall_duration_us",
+				     delay_node->stall_duration_ticks * SPDK_SEC_TO_USEC / spdk_get_ticks_hz());
 }
 
 static int
@@ -563,11 +742,16 @@ delay_bdev_ch_create_cb(void *io_device, void *ctx_buf)
 {
 	struct delay_io_channel *delay_ch = ctx_buf;
 	struct vbdev_delay *delay_node = io_device;
+	uint32_t i;
 
-	STAILQ_INIT(&delay_ch->avg_read_io);
-	STAILQ_INIT(&delay_ch->p99_read_io);
-	STAILQ_INIT(&delay_ch->avg_write_io);
-	STAILQ_INIT(&delay_ch->p99_write_io);
+	for (i = 0; i < DELAY_WHEEL_SLOTS; i++) {
+		TAILQ_INIT(&delay_ch->wheel[i]);
+	}
+	TAILQ_INIT(&delay_ch->overflow);
+	delay_ch->overflow_min_tick = UINT64_MAX;
+	delay_ch->wheel_tick = spdk_get_ticks();
+	delay_ch->slot_ticks = spdk_get_ticks_hz() * DELAY_WHEEL_SLOT_US / SPDK_SEC_TO_USEC;
+	delay_ch->slot_ticks = spdk_max(delay_ch->slot_ticks, 1);
 
 	delay_ch->io_poller = SPDK_POLLER_REGISTER(_delay_finish_io, delay_ch, 0);
 	delay_ch->base_ch = spdk_bdev_get_io_channel(delay_node->base_desc);
@@ -595,7 +779,9 @@ static int
 vbdev_delay_insert_association(const char *bdev_name, const char *vbdev_name,
 			       struct spdk_uuid *uuid,
 			       uint64_t avg_read_latency, uint64_t p99_read_latency,
-			       uint64_t avg_write_latency, uint64_t p99_write_latency)
+			       uint64_t avg_write_latency, uint64_t p99_write_latency,
+			       enum delay_distribution distribution,
+			       uint64_t stall_period_us, uint64_t stall_duration_us)
 {
 	struct bdev_association *assoc;
 
@@ -631,6 +817,9 @@ vbdev_delay_insert_association(const char *bdev_name, const char *vbdev_name,
 	assoc->p99_read_latency = p99_read_latency;
 	assoc->avg_write_latency = avg_write_latency;
 	assoc->p99_write_latency = p99_write_latency;
+	assoc->distribution = distribution;
+	assoc->stall_period_us = stall_period_us;
+	assoc->stall_duration_us = stall_duration_us;
 
 	if (uuid) {
 		spdk_uuid_copy(&assoc->uuid, uuid);
@@ -641,6 +830,25 @@ vbdev_delay_insert_association(const char *bdev_name, const char *vbdev_name,
 	return 0;
 }
 
+static double
+delay_get_sigma(uint64_t avg_latency_ticks, uint64_t p99_latency_ticks)
+{
+	if (avg_latency_ticks == 0 || p99_latency_ticks <= avg_latency_ticks) {
+		return 0;
+	}
+
+	return log((double)p99_latency_ticks / avg_latency_ticks) / DELAY_NORMAL_P99;
+}
+
+static void
+delay_update_sigma(struct vbdev_delay *delay_node)
+{
+	delay_node->read_sigma = delay_get_sigma(delay_node->average_read_latency_ticks,
+				 delay_node->p99_read_latency_ticks);
+	delay_node->write_sigma = delay_get_sigma(delay_node->average_write_latency_ticks,
+				  delay_node->p99_write_latency_ticks);
+}
+
 int
 vbdev_delay_update_latency_value(char *delay_name, uint64_t latency_us, enum delay_io_type type)
 {
@@ -674,6 +882,8 @@ vbdev_delay_update_latency_value(char *delay_name, uint64_t latency_us, enum del
 		return -EINVAL;
 	}
 
+	delay_update_sigma(delay_node);
+
 	return 0;
 }
 
@@ -718,15 +928,36 @@ vbdev_delay_get_memory_domains(void *ctx, struct spdk_memory_domain **domains, i
 	return spdk_bdev_get_memory_domains(delay_node->base_bdev, domains, array_size);
 }
 
+static bool
+vbdev_delay_sequence_supported(void *ctx, enum spdk_bdev_io_type type)
+{
+	struct vbdev_delay *delay_node = (struct vbdev_delay *)ctx;
+
+	/* The sequence is passed to the base bdev, which executes it if it can't handle it.
+	 * A separate metadata buffer can't be allocated along with a sequence though. */
+	if (spdk_bdev_is_md_separate(&delay_node->delay_bdev)) {
+		return false;
+	}
+
+	switch (type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /* When we register our bdev this is how we specify our entry points. */
 static const struct spdk_bdev_fn_table vbdev_delay_fn_table = {
-	.destruct		= vbdev_delay_destruct,
-	.submit_request		= vbdev_delay_submit_request,
-	.io_type_supported	= vbdev_delay_io_type_supported,
-	.get_io_channel		= vbdev_delay_get_io_channel,
-	.dump_info_json		= vbdev_delay_dump_info_json,
-	.write_config_json	= vbdev_delay_write_config_json,
-	.get_memory_domains	= vbdev_delay_get_memory_domains,
+	.destruct			= vbdev_delay_destruct,
+	.submit_request			= vbdev_delay_submit_request,
+	.io_type_supported		= vbdev_delay_io_type_supported,
+	.get_io_channel			= vbdev_delay_get_io_channel,
+	.dump_info_json			= vbdev_delay_dump_info_json,
+	.write_config_json		= vbdev_delay_write_config_json,
+	.get_memory_domains		= vbdev_delay_get_memory_domains,
+	.accel_sequence_supported	= vbdev_delay_sequence_supported,
 };
 
 static void
@@ -823,6 +1054,11 @@ vbdev_delay_register(const char *bdev_name)
 		delay_node->p99_read_latency_ticks = ticks_mhz * assoc->p99_read_latency;
 		delay_node->average_write_latency_ticks = ticks_mhz * assoc->avg_write_latency;
 		delay_node->p99_write_latency_ticks = ticks_mhz * assoc->p99_write_latency;
+		delay_node->distribution = assoc->distribution;
+		delay_update_sigma(delay_node);
+		delay_node->stall_period_ticks = ticks_mhz * assoc->stall_period_us;
+		delay_node->stall_duration_ticks = ticks_mhz * assoc->stall_duration_us;
+		delay_node->stall_base_tick = spdk_get_ticks();
 
 		spdk_io_device_register(delay_node, delay_bdev_ch_create_cb, delay_bdev_ch_destroy_cb,
 					sizeof(struct delay_io_channel),
@@ -860,7 +1096,9 @@ error_close:
 int
 create_delay_disk(const char *bdev_name, const char *vbdev_name, struct spdk_uuid *uuid,
 		  uint64_t avg_read_latency,
-		  uint64_t p99_read_latency, uint64_t avg_write_latency, uint64_t p99_write_latency)
+		  uint64_t p99_read_latency, uint64_t avg_write_latency, uint64_t p99_write_latency,
+		  enum delay_distribution distribution, uint64_t stall_period_us,
+		  uint64_t stall_duration_us)
 {
 	int rc = 0;
 
@@ -869,8 +1107,14 @@ create_delay_disk(const char *bdev_name, const char *vbdev_name, struct spdk_uui
 		return -EINVAL;
 	}
 
+	if (stall_duration_us != 0 && stall_duration_us >= stall_period_us) {
+		SPDK_ERRLOG("Stall duration needs to be shorter than the stall period.\n");
+		return -EINVAL;
+	}
+
 	rc = vbdev_delay_insert_association(bdev_name, vbdev_name, uuid, avg_read_latency, p99_read_latency,
-					    avg_write_latency, p99_write_latency);
+					    avg_write_latency, p99_write_latency, distribution,
+					    stall_period_us, stall_duration_us);
 	if (rc) {
 		return rc;
 	}
@@ -19,6 +19,13 @@ enum delay_io_type {
 	DELAY_NONE
 };
 
+enum delay_distribution {
+	/* The average latency for 99% of I/O, the p99 latency for the rest */
+	DELAY_DISTRIBUTION_BIMODAL,
+	/* Lognormal distribution with the average latency as median and the given p99 */
+	DELAY_DISTRIBUTION_LOGNORMAL,
+};
+
 /**
  * Create new delay bdev.
  *
@@ -29,11 +36,16 @@ enum delay_io_type {
  * \param p99_read_latency Desired p99 read latency
  * \param avg_write_latency Desired typical write latency.
  * \param p99_write_latency Desired p99 write latency
+ * \param distribution Distribution the latencies are drawn from.
+ * \param stall_period_us Period of the injected stalls, in microseconds.
+ * \param stall_duration_us Duration of the injected stalls, in microseconds, 0 to disable them.
  * \return 0 on success, other on failure.
  */
 int create_delay_disk(const char *bdev_name, const char *vbdev_name, struct spdk_uuid *uuid,
 		      uint64_t avg_read_latency,
-		      uint64_t p99_read_latency, uint64_t avg_write_latency, uint64_t p99_write_latency);
+		      uint64_t p99_read_latency, uint64_t avg_write_latency, uint64_t p99_write_latency,
+		      enum delay_distribution distribution, uint64_t stall_period_us,
+		      uint64_t stall_duration_us);
 
 /**
  * Delete delay bdev.
@@ -89,6 +89,9 @@ struct rpc_construct_delay {
 	uint64_t p99_read_latency;
 	uint64_t avg_write_latency;
 	uint64_t p99_write_latency;
+	enum delay_distribution latency_distribution;
+	uint64_t stall_period_us;
+	uint64_t stall_duration_us;
 };
 
 static void
@@ -99,6 +102,23 @@ free_rpc_construct_delay(struct rpc_construct_delay *r)
 	free(r->uuid);
 }
 
+static int
+decode_latency_distribution(const struct spdk_json_val *val, void *out)
+{
+	enum delay_distribution *distribution = out;
+
+	if (spdk_json_strequal(val, "bimodal")) {
+		*distribution = DELAY_DISTRIBUTION_BIMODAL;
+	} else if (spdk_json_strequal(val, "lognormal")) {
+		*distribution = DELAY_DISTRIBUTION_LOGNORMAL;
+	} else {
+		SPDK_NOTICELOG("Invalid parameter value: latency_distribution\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static const struct spdk_json_object_decoder rpc_construct_delay_decoders[] = {
 	{"base_bdev_name", offsetof(struct rpc_construct_delay, base_bdev_name), spdk_json_decode_string},
 	{"name", offsetof(struct rpc_construct_delay, name), spdk_json_decode_string},
@@ -107,6 +127,12 @@ static const struct spdk_json_object_decoder rpc_construct_delay_decoders[] = {
 	{"p99_read_latency", offsetof(struct rpc_construct_delay, p99_read_latency), spdk_json_decode_uint64},
 	{"avg_write_latency", offsetof(struct rpc_construct_delay, avg_write_latency), spdk_json_decode_uint64},
 	{"p99_write_latency", offsetof(struct rpc_construct_delay, p99_write_latency), spdk_json_decode_uint64},
+	{
+		"latency_distribution", offsetof(struct rpc_construct_delay, latency_distribution),
+		decode_latency_distribution, true
+	},
+	{"stall_period_us", offsetof(struct rpc_construct_delay, stall_period_us), spdk_json_decode_uint64, true},
+	{"stall_duration_us", offsetof(struct rpc_construct_delay, stall_duration_us), spdk_json_decode_uint64, true},
 };
 
 static void
@@ -139,7 +165,8 @@ rpc_bdev_delay_create(struct spdk_jsonrpc_request *request,
 
 	rc = create_delay_disk(req.base_bdev_name, req.name, uuid, req.avg_read_latency,
 			       req.p99_read_latency,
-			       req.avg_write_latency, req.p99_write_latency);
+			       req.avg_write_latency, req.p99_write_latency, req.latency_distribution,
+			       req.stall_period_us, req.stall_duration_us);
 	if (rc != 0) {
 		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
 		goto cleanup;
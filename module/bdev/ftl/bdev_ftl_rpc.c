@@ -50,6 +50,10 @@ static const struct spdk_json_object_decoder rpc_bdev_ftl_create_decoders[] = {
 		"fast_shutdown", offsetof(struct spdk_ftl_conf, fast_shutdown),
 		spdk_json_decode_bool, true
 	},
+	{
+		"nv_cache_compactors", offsetof(struct spdk_ftl_conf, nv_cache.compactors),
+		spdk_json_decode_uint32, true
+	},
 };
 
 static void
@@ -287,6 +291,23 @@ _rpc_bdev_ftl_get_stats(void *cntx)
 		spdk_json_write_object_end(w);
 	}
 
+	spdk_json_write_named_object_begin(w, "gc_bands");
+	spdk_json_write_named_uint64(w, "count", stats->gc_bands);
+	spdk_json_write_named_uint64(w, "valid_blocks", stats->gc_valid_blocks);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_named_object_begin(w, "l2p_cache");
+	spdk_json_write_named_uint64(w, "hits", stats->l2p_cache_hits);
+	spdk_json_write_named_uint64(w, "misses", stats->l2p_cache_misses);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_named_object_begin(w, "nv_cache");
+	spdk_json_write_named_uint64(w, "chunks", stats->nv_cache_chunks);
+	spdk_json_write_named_uint64(w, "free_chunks", stats->nv_cache_chunks_free);
+	spdk_json_write_named_uint64(w, "full_chunks", stats->nv_cache_chunks_full);
+	spdk_json_write_named_uint64(w, "compacted_chunks", stats->nv_cache_chunks_compacted);
+	spdk_json_write_object_end(w);
+
 	spdk_json_write_object_end(w);
 	spdk_jsonrpc_end_result(request, w);
 
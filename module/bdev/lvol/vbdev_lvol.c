@@ -1847,6 +1847,94 @@ vbdev_lvs_grow(struct spdk_lvol_store *lvs,
 	}
 }
 
+struct vbdev_lvs_read_cache_req {
+	struct spdk_bs_dev	*bs_dev;
+	spdk_lvs_op_complete	cb_fn;
+	void			*cb_arg;
+};
+
+static void
+vbdev_lvs_read_cache_removed_cb(void *cb_arg, int bserrno)
+{
+	struct spdk_lvol_store *lvs = cb_arg;
+
+	if (bserrno != 0) {
+		SPDK_ERRLOG("Cannot remove read cache of lvstore %s: %s\n", lvs->name,
+			    spdk_strerror(-bserrno));
+	}
+}
+
+static void
+vbdev_lvs_read_cache_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+			      void *event_ctx)
+{
+	struct spdk_lvol_store *lvs = event_ctx;
+
+	switch (type) {
+	case SPDK_BDEV_EVENT_REMOVE:
+		SPDK_NOTICELOG("bdev %s being removed: removing read cache of lvstore %s\n",
+			       spdk_bdev_get_name(bdev), lvs->name);
+		spdk_bs_set_read_cache(lvs->blobstore, NULL, vbdev_lvs_read_cache_removed_cb, lvs);
+		break;
+	default:
+		SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
+		break;
+	}
+}
+
+static void
+vbdev_lvs_set_read_cache_cb(void *cb_arg, int bserrno)
+{
+	struct vbdev_lvs_read_cache_req *req = cb_arg;
+
+	if (bserrno != 0) {
+		req->bs_dev->destroy(req->bs_dev);
+	}
+
+	req->cb_fn(req->cb_arg, bserrno);
+	free(req);
+}
+
+void
+vbdev_lvs_set_read_cache(struct spdk_lvol_store *lvs, const char *bdev_name,
+			 spdk_lvs_op_complete cb_fn, void *cb_arg)
+{
+	struct vbdev_lvs_read_cache_req *req;
+	int rc;
+
+	if (bdev_name == NULL) {
+		spdk_bs_set_read_cache(lvs->blobstore, NULL, cb_fn, cb_arg);
+		return;
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (req == NULL) {
+		SPDK_ERRLOG("Cannot alloc memory for vbdev lvol store request pointer\n");
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+
+	rc = spdk_bdev_create_bs_dev_ext(bdev_name, vbdev_lvs_read_cache_event_cb, lvs,
+					 &req->bs_dev);
+	if (rc != 0) {
+		SPDK_ERRLOG("Cannot create blobstore device for bdev %s\n", bdev_name);
+		free(req);
+		cb_fn(cb_arg, rc);
+		return;
+	}
+
+	rc = spdk_bs_bdev_claim(req->bs_dev, &g_lvol_if);
+	if (rc != 0) {
+		SPDK_ERRLOG("Read cache bdev %s already claimed by another bdev\n", bdev_name);
+		vbdev_lvs_set_read_cache_cb(req, rc);
+		return;
+	}
+
+	spdk_bs_set_read_cache(lvs->blobstore, req->bs_dev, vbdev_lvs_set_read_cache_cb, req);
+}
+
 /* Begin degraded blobstore device */
 
 /*
@@ -121,6 +121,20 @@ struct spdk_lvol *vbdev_lvol_get_from_bdev(struct spdk_bdev *bdev);
 void vbdev_lvs_grow(struct spdk_lvol_store *lvs,
 		    spdk_lvs_op_complete cb_fn, void *cb_arg);
 
+/**
+ * \brief Set or remove the read cache of given lvolstore.
+ *
+ * The data of snapshots is cached on the bdev, shared by all the clones reading it. The
+ * cache is not persistent and has to be set again after the lvolstore is loaded.
+ *
+ * \param lvs Pointer to lvolstore
+ * \param bdev_name Name of the bdev to cache on, NULL to remove the read cache
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ */
+void vbdev_lvs_set_read_cache(struct spdk_lvol_store *lvs, const char *bdev_name,
+			      spdk_lvs_op_complete cb_fn, void *cb_arg);
+
 int vbdev_lvol_esnap_dev_create(void *bs_ctx, void *blob_ctx, struct spdk_blob *blob,
 				const void *esnap_id, uint32_t id_len,
 				struct spdk_bs_dev **_bs_dev);
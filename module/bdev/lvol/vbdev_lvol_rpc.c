@@ -812,6 +812,104 @@ cleanup:
 
 SPDK_RPC_REGISTER("bdev_lvol_decouple_parent", rpc_bdev_lvol_decouple_parent, SPDK_RPC_RUNTIME)
 
+struct rpc_bdev_lvol_defragment {
+	char *name;
+	uint32_t clusters_per_sec;
+};
+
+static void
+free_rpc_bdev_lvol_defragment(struct rpc_bdev_lvol_defragment *req)
+{
+	free(req->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_defragment_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_lvol_defragment, name), spdk_json_decode_string},
+	{"clusters_per_sec", offsetof(struct rpc_bdev_lvol_defragment, clusters_per_sec), spdk_json_decode_uint32, true},
+};
+
+static void
+rpc_bdev_lvol_defragment(struct spdk_jsonrpc_request *request,
+			 const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_defragment req = {};
+	struct spdk_bdev *bdev;
+	struct spdk_lvol *lvol;
+
+	SPDK_INFOLOG(lvol_rpc, "Defragmenting lvol\n");
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_defragment_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_defragment_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev = spdk_bdev_get_by_name(req.name);
+	if (bdev == NULL) {
+		SPDK_ERRLOG("bdev '%s' does not exist\n", req.name);
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	lvol = vbdev_lvol_get_from_bdev(bdev);
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol does not exist\n");
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	spdk_lvol_defragment(lvol, req.clusters_per_sec, rpc_bdev_lvol_inflate_cb, request);
+
+cleanup:
+	free_rpc_bdev_lvol_defragment(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_defragment", rpc_bdev_lvol_defragment, SPDK_RPC_RUNTIME)
+
+static void
+rpc_bdev_lvol_prefill(struct spdk_jsonrpc_request *request,
+		      const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_defragment req = {};
+	struct spdk_bdev *bdev;
+	struct spdk_lvol *lvol;
+
+	SPDK_INFOLOG(lvol_rpc, "Prefilling lvol\n");
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_defragment_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_defragment_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev = spdk_bdev_get_by_name(req.name);
+	if (bdev == NULL) {
+		SPDK_ERRLOG("bdev '%s' does not exist\n", req.name);
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	lvol = vbdev_lvol_get_from_bdev(bdev);
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol does not exist\n");
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	spdk_lvol_prefill(lvol, req.clusters_per_sec, rpc_bdev_lvol_inflate_cb, request);
+
+cleanup:
+	free_rpc_bdev_lvol_defragment(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_prefill", rpc_bdev_lvol_prefill, SPDK_RPC_RUNTIME)
+
 struct rpc_bdev_lvol_resize {
 	char *name;
 	uint64_t size;
@@ -1172,25 +1270,75 @@ cleanup:
 SPDK_RPC_REGISTER("bdev_lvol_get_lvstores", rpc_bdev_lvol_get_lvstores, SPDK_RPC_RUNTIME)
 SPDK_RPC_REGISTER_ALIAS_DEPRECATED(bdev_lvol_get_lvstores, get_lvol_stores)
 
+#define RPC_BDEV_LVOL_GET_LVOLS_MAX_FIELDS 16
+
 struct rpc_bdev_lvol_get_lvols {
 	char *lvs_uuid;
 	char *lvs_name;
+	char *start_after;
+	uint64_t max_count;
+	size_t num_fields;
+	char *fields[RPC_BDEV_LVOL_GET_LVOLS_MAX_FIELDS];
 };
 
 static void
 free_rpc_bdev_lvol_get_lvols(struct rpc_bdev_lvol_get_lvols *req)
 {
+	size_t i;
+
 	free(req->lvs_uuid);
 	free(req->lvs_name);
+	free(req->start_after);
+	for (i = 0; i < req->num_fields; i++) {
+		free(req->fields[i]);
+	}
+}
+
+static int
+decode_rpc_bdev_lvol_get_lvols_field(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_string(val, out);
+}
+
+static int
+decode_rpc_bdev_lvol_get_lvols_fields(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_bdev_lvol_get_lvols *req = SPDK_CONTAINEROF(out, struct rpc_bdev_lvol_get_lvols,
+					      fields);
+
+	return spdk_json_decode_array(val, decode_rpc_bdev_lvol_get_lvols_field, req->fields,
+				      RPC_BDEV_LVOL_GET_LVOLS_MAX_FIELDS, &req->num_fields, sizeof(char *));
 }
 
 static const struct spdk_json_object_decoder rpc_bdev_lvol_get_lvols_decoders[] = {
 	{"lvs_uuid", offsetof(struct rpc_bdev_lvol_get_lvols, lvs_uuid), spdk_json_decode_string, true},
 	{"lvs_name", offsetof(struct rpc_bdev_lvol_get_lvols, lvs_name), spdk_json_decode_string, true},
+	{"start_after", offsetof(struct rpc_bdev_lvol_get_lvols, start_after), spdk_json_decode_string, true},
+	{"max_count", offsetof(struct rpc_bdev_lvol_get_lvols, max_count), spdk_json_decode_uint64, true},
+	{"fields", offsetof(struct rpc_bdev_lvol_get_lvols, fields), decode_rpc_bdev_lvol_get_lvols_fields, true},
 };
 
+static bool
+rpc_lvol_field(const struct rpc_bdev_lvol_get_lvols *req, const char *key)
+{
+	size_t i;
+
+	if (req->num_fields == 0) {
+		return true;
+	}
+
+	for (i = 0; i < req->num_fields; i++) {
+		if (strcmp(req->fields[i], key) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 static void
-rpc_dump_lvol(struct spdk_json_write_ctx *w, struct spdk_lvol *lvol)
+rpc_dump_lvol(struct spdk_json_write_ctx *w, struct spdk_lvol *lvol,
+	      const struct rpc_bdev_lvol_get_lvols *req)
 {
 	struct spdk_lvol_store *lvs = lvol->lvol_store;
 	char uuid[SPDK_UUID_STRING_LEN];
@@ -1199,31 +1347,83 @@ rpc_dump_lvol(struct spdk_json_write_ctx *w, struct spdk_lvol *lvol)
 
 	spdk_json_write_named_string_fmt(w, "alias", "%s/%s", lvs->name, lvol->name);
 	spdk_json_write_named_string(w, "uuid", lvol->uuid_str);
-	spdk_json_write_named_string(w, "name", lvol->name);
-	spdk_json_write_named_bool(w, "is_thin_provisioned", spdk_blob_is_thin_provisioned(lvol->blob));
-	spdk_json_write_named_bool(w, "is_snapshot", spdk_blob_is_snapshot(lvol->blob));
-	spdk_json_write_named_bool(w, "is_clone", spdk_blob_is_clone(lvol->blob));
-	spdk_json_write_named_bool(w, "is_esnap_clone", spdk_blob_is_esnap_clone(lvol->blob));
-	spdk_json_write_named_bool(w, "is_degraded", spdk_blob_is_degraded(lvol->blob));
-
-	spdk_json_write_named_object_begin(w, "lvs");
-	spdk_json_write_named_string(w, "name", lvs->name);
-	spdk_uuid_fmt_lower(uuid, sizeof(uuid), &lvs->uuid);
-	spdk_json_write_named_string(w, "uuid", uuid);
-	spdk_json_write_object_end(w);
+	if (rpc_lvol_field(req, "name")) {
+		spdk_json_write_named_string(w, "name", lvol->name);
+	}
+	if (rpc_lvol_field(req, "is_thin_provisioned")) {
+		spdk_json_write_named_bool(w, "is_thin_provisioned", spdk_blob_is_thin_provisioned(lvol->blob));
+	}
+	if (rpc_lvol_field(req, "is_snapshot")) {
+		spdk_json_write_named_bool(w, "is_snapshot", spdk_blob_is_snapshot(lvol->blob));
+	}
+	if (rpc_lvol_field(req, "is_clone")) {
+		spdk_json_write_named_bool(w, "is_clone", spdk_blob_is_clone(lvol->blob));
+	}
+	if (rpc_lvol_field(req, "is_esnap_clone")) {
+		spdk_json_write_named_bool(w, "is_esnap_clone", spdk_blob_is_esnap_clone(lvol->blob));
+	}
+	if (rpc_lvol_field(req, "is_degraded")) {
+		spdk_json_write_named_bool(w, "is_degraded", spdk_blob_is_degraded(lvol->blob));
+	}
+
+	if (rpc_lvol_field(req, "lvs")) {
+		spdk_json_write_named_object_begin(w, "lvs");
+		spdk_json_write_named_string(w, "name", lvs->name);
+		spdk_uuid_fmt_lower(uuid, sizeof(uuid), &lvs->uuid);
+		spdk_json_write_named_string(w, "uuid", uuid);
+		spdk_json_write_object_end(w);
+	}
 
 	spdk_json_write_object_end(w);
 }
 
-static void
-rpc_dump_lvols(struct spdk_json_write_ctx *w, struct lvol_store_bdev *lvs_bdev)
+/* Returns the first lvol of lvs_bdev's store or, if it's NULL, of the first store having one */
+static struct spdk_lvol *
+rpc_lvol_first(struct lvol_store_bdev *lvs_bdev)
 {
-	struct spdk_lvol_store *lvs = lvs_bdev->lvs;
 	struct spdk_lvol *lvol;
 
-	TAILQ_FOREACH(lvol, &lvs->lvols, link) {
-		rpc_dump_lvol(w, lvol);
+	if (lvs_bdev != NULL) {
+		return TAILQ_FIRST(&lvs_bdev->lvs->lvols);
+	}
+
+	for (lvs_bdev = vbdev_lvol_store_first(); lvs_bdev != NULL;
+	     lvs_bdev = vbdev_lvol_store_next(lvs_bdev)) {
+		lvol = TAILQ_FIRST(&lvs_bdev->lvs->lvols);
+		if (lvol != NULL) {
+			return lvol;
+		}
+	}
+
+	return NULL;
+}
+
+/* Returns the lvol following the given one, continuing with the next stores if all_stores is set */
+static struct spdk_lvol *
+rpc_lvol_next(struct spdk_lvol *lvol, bool all_stores)
+{
+	struct lvol_store_bdev *lvs_bdev;
+	struct spdk_lvol *next;
+
+	next = TAILQ_NEXT(lvol, link);
+	if (next != NULL || !all_stores) {
+		return next;
+	}
+
+	lvs_bdev = vbdev_get_lvs_bdev_by_lvs(lvol->lvol_store);
+	if (lvs_bdev == NULL) {
+		return NULL;
 	}
+
+	for (lvs_bdev = vbdev_lvol_store_next(lvs_bdev); lvs_bdev != NULL;
+	     lvs_bdev = vbdev_lvol_store_next(lvs_bdev)) {
+		next = TAILQ_FIRST(&lvs_bdev->lvs->lvols);
+		if (next != NULL) {
+			return next;
+		}
+	}
+
+	return NULL;
 }
 
 static void
@@ -1233,6 +1433,9 @@ rpc_bdev_lvol_get_lvols(struct spdk_jsonrpc_request *request, const struct spdk_
 	struct spdk_json_write_ctx *w;
 	struct lvol_store_bdev *lvs_bdev = NULL;
 	struct spdk_lvol_store *lvs = NULL;
+	struct spdk_lvol *lvol;
+	struct spdk_uuid uuid;
+	uint64_t count = 0;
 	int rc;
 
 	if (params != NULL) {
@@ -1244,7 +1447,9 @@ rpc_bdev_lvol_get_lvols(struct spdk_jsonrpc_request *request, const struct spdk_
 							 "spdk_json_decode_object failed");
 			goto cleanup;
 		}
+	}
 
+	if (req.lvs_uuid != NULL || req.lvs_name != NULL) {
 		rc = vbdev_get_lvol_store_by_uuid_xor_name(req.lvs_uuid, req.lvs_name, &lvs);
 		if (rc != 0) {
 			spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
@@ -1258,16 +1463,28 @@ rpc_bdev_lvol_get_lvols(struct spdk_jsonrpc_request *request, const struct spdk_
 		}
 	}
 
+	if (req.start_after != NULL) {
+		/* The listing resumes right after the lvol with the given UUID */
+		lvol = NULL;
+		if (spdk_uuid_parse(&uuid, req.start_after) == 0) {
+			lvol = spdk_lvol_get_by_uuid(&uuid);
+		}
+		if (lvol == NULL || (lvs != NULL && lvol->lvol_store != lvs)) {
+			SPDK_INFOLOG(lvol_rpc, "lvol with UUID '%s' not found\n", req.start_after);
+			spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+			goto cleanup;
+		}
+		lvol = rpc_lvol_next(lvol, lvs == NULL);
+	} else {
+		lvol = rpc_lvol_first(lvs_bdev);
+	}
+
 	w = spdk_jsonrpc_begin_result(request);
 	spdk_json_write_array_begin(w);
 
-	if (lvs_bdev != NULL) {
-		rpc_dump_lvols(w, lvs_bdev);
-	} else {
-		for (lvs_bdev = vbdev_lvol_store_first(); lvs_bdev != NULL;
-		     lvs_bdev = vbdev_lvol_store_next(lvs_bdev)) {
-			rpc_dump_lvols(w, lvs_bdev);
-		}
+	for (; lvol != NULL && (req.max_count == 0 || count < req.max_count);
+	     lvol = rpc_lvol_next(lvol, lvs == NULL), count++) {
+		rpc_dump_lvol(w, lvol, &req);
 	}
 	spdk_json_write_array_end(w);
 
@@ -1341,3 +1558,52 @@ cleanup:
 	free_rpc_bdev_lvol_grow_lvstore(&req);
 }
 SPDK_RPC_REGISTER("bdev_lvol_grow_lvstore", rpc_bdev_lvol_grow_lvstore, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_lvol_set_read_cache {
+	char *uuid;
+	char *lvs_name;
+	char *bdev_name;
+};
+
+static void
+free_rpc_bdev_lvol_set_read_cache(struct rpc_bdev_lvol_set_read_cache *req)
+{
+	free(req->uuid);
+	free(req->lvs_name);
+	free(req->bdev_name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_set_read_cache_decoders[] = {
+	{"uuid", offsetof(struct rpc_bdev_lvol_set_read_cache, uuid), spdk_json_decode_string, true},
+	{"lvs_name", offsetof(struct rpc_bdev_lvol_set_read_cache, lvs_name), spdk_json_decode_string, true},
+	{"bdev_name", offsetof(struct rpc_bdev_lvol_set_read_cache, bdev_name), spdk_json_decode_string, true},
+};
+
+static void
+rpc_bdev_lvol_set_read_cache(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_set_read_cache req = {};
+	struct spdk_lvol_store *lvs = NULL;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_set_read_cache_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_set_read_cache_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = vbdev_get_lvol_store_by_uuid_xor_name(req.uuid, req.lvs_name, &lvs);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+	vbdev_lvs_set_read_cache(lvs, req.bdev_name, rpc_bdev_lvol_grow_lvstore_cb, request);
+
+cleanup:
+	free_rpc_bdev_lvol_set_read_cache(&req);
+}
+SPDK_RPC_REGISTER("bdev_lvol_set_read_cache", rpc_bdev_lvol_set_read_cache, SPDK_RPC_RUNTIME)
@@ -16,10 +16,23 @@
 
 #include "spdk/log.h"
 
+#define MALLOC_BUF_ALIGNMENT	(2 * 1024 * 1024)
+#define MALLOC_MAX_NUMA_NODES	64
+
+struct malloc_region {
+	void				*buf;
+	void				*md_buf;
+};
+
 struct malloc_disk {
 	struct spdk_bdev		disk;
-	void				*malloc_buf;
-	void				*malloc_md_buf;
+	/* The disk is split into regions of region_blocks blocks, which are spread across the
+	 * NUMA nodes if it's striped.  Otherwise, there's a single region covering the whole disk. */
+	struct malloc_region		*regions;
+	uint32_t			num_regions;
+	uint64_t			region_blocks;
+	int32_t				numa_id;
+	uint32_t			numa_stripe_blocks;
 	TAILQ_ENTRY(malloc_disk)	link;
 };
 
@@ -27,6 +40,8 @@ struct malloc_task {
 	struct iovec			iov;
 	int				num_outstanding;
 	enum spdk_bdev_io_status	status;
+	struct spdk_dif_ctx		dif_ctx;
+	struct spdk_dif_error		dif_err;
 	TAILQ_ENTRY(malloc_task)	tailq;
 };
 
@@ -37,15 +52,12 @@ struct malloc_channel {
 };
 
 static int
-malloc_verify_pi(struct spdk_bdev_io *bdev_io)
+malloc_init_dif_ctx(struct spdk_bdev_io *bdev_io, struct spdk_dif_ctx *dif_ctx)
 {
 	struct spdk_bdev *bdev = bdev_io->bdev;
-	struct spdk_dif_ctx dif_ctx;
-	struct spdk_dif_error err_blk;
 	int rc;
 
-	assert(bdev_io->u.bdev.memory_domain == NULL);
-	rc = spdk_dif_ctx_init(&dif_ctx,
+	rc = spdk_dif_ctx_init(dif_ctx,
 			       bdev->blocklen,
 			       bdev->md_len,
 			       bdev->md_interleave,
@@ -56,6 +68,35 @@ malloc_verify_pi(struct spdk_bdev_io *bdev_io)
 			       0xFFFF, 0, 0, 0);
 	if (rc != 0) {
 		SPDK_ERRLOG("Failed to initialize DIF/DIX context\n");
+	}
+
+	return rc;
+}
+
+static void
+malloc_log_pi_error(struct spdk_bdev_io *bdev_io, struct spdk_dif_error *err_blk)
+{
+	SPDK_ERRLOG("DIF/DIX verify failed: lba %" PRIu64 ", num_blocks %" PRIu64 ", "
+		    "err_type %u, expected %u, actual %u, err_offset %u\n",
+		    bdev_io->u.bdev.offset_blocks,
+		    bdev_io->u.bdev.num_blocks,
+		    err_blk->err_type,
+		    err_blk->expected,
+		    err_blk->actual,
+		    err_blk->err_offset);
+}
+
+static int
+malloc_verify_pi(struct spdk_bdev_io *bdev_io)
+{
+	struct spdk_bdev *bdev = bdev_io->bdev;
+	struct spdk_dif_ctx dif_ctx;
+	struct spdk_dif_error err_blk;
+	int rc;
+
+	assert(bdev_io->u.bdev.memory_domain == NULL);
+	rc = malloc_init_dif_ctx(bdev_io, &dif_ctx);
+	if (rc != 0) {
 		return rc;
 	}
 
@@ -80,24 +121,57 @@ malloc_verify_pi(struct spdk_bdev_io *bdev_io)
 	}
 
 	if (rc != 0) {
-		SPDK_ERRLOG("DIF/DIX verify failed: lba %" PRIu64 ", num_blocks %" PRIu64 ", "
-			    "err_type %u, expected %u, actual %u, err_offset %u\n",
-			    bdev_io->u.bdev.offset_blocks,
-			    bdev_io->u.bdev.num_blocks,
-			    err_blk.err_type,
-			    err_blk.expected,
-			    err_blk.actual,
-			    err_blk.err_offset);
+		malloc_log_pi_error(bdev_io, &err_blk);
 	}
 
 	return rc;
 }
 
+/* Interleaved protection information is verified through accel, so that it can be offloaded.
+ * Returns 0 if the verification was submitted, in which case cb_fn is executed once it's done. */
+static int
+malloc_verify_pi_accel(struct spdk_io_channel *ch, struct malloc_task *task,
+		       struct spdk_bdev_io *bdev_io, spdk_accel_completion_cb cb_fn)
+{
+	int rc;
+
+	assert(bdev_io->u.bdev.memory_domain == NULL);
+	if (!spdk_bdev_is_md_interleaved(bdev_io->bdev)) {
+		return -ENOTSUP;
+	}
+
+	rc = malloc_init_dif_ctx(bdev_io, &task->dif_ctx);
+	if (rc != 0) {
+		return rc;
+	}
+
+	return spdk_accel_submit_dif_verify(ch, bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+					    bdev_io->u.bdev.num_blocks, &task->dif_ctx,
+					    &task->dif_err, cb_fn, task);
+}
+
+static void
+malloc_read_verify_pi_done(void *ref, int status)
+{
+	struct malloc_task *task = ref;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(task);
+
+	if (status != 0) {
+		if (status == -EIO) {
+			malloc_log_pi_error(bdev_io, &task->dif_err);
+		}
+		task->status = SPDK_BDEV_IO_STATUS_FAILED;
+	}
+
+	spdk_bdev_io_complete(bdev_io, task->status);
+}
+
 static void
 malloc_done(void *ref, int status)
 {
 	struct malloc_task *task = (struct malloc_task *)ref;
 	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(task);
+	struct malloc_channel *mch;
 	int rc;
 
 	if (status != 0) {
@@ -117,6 +191,12 @@ malloc_done(void *ref, int status)
 	if (bdev_io->bdev->dif_type != SPDK_DIF_DISABLE &&
 	    bdev_io->type == SPDK_BDEV_IO_TYPE_READ &&
 	    task->status == SPDK_BDEV_IO_STATUS_SUCCESS) {
+		mch = spdk_io_channel_get_ctx(spdk_bdev_io_get_io_channel(bdev_io));
+		rc = malloc_verify_pi_accel(mch->accel_channel, task, bdev_io,
+					    malloc_read_verify_pi_done);
+		if (rc == 0) {
+			return;
+		}
 		rc = malloc_verify_pi(bdev_io);
 		if (rc != 0) {
 			task->status = SPDK_BDEV_IO_STATUS_FAILED;
@@ -161,16 +241,54 @@ SPDK_BDEV_MODULE_REGISTER(malloc, &malloc_if)
 static void
 malloc_disk_free(struct malloc_disk *malloc_disk)
 {
+	uint32_t i;
+
 	if (!malloc_disk) {
 		return;
 	}
 
 	free(malloc_disk->disk.name);
-	spdk_free(malloc_disk->malloc_buf);
-	spdk_free(malloc_disk->malloc_md_buf);
+	for (i = 0; i < malloc_disk->num_regions; i++) {
+		spdk_free(malloc_disk->regions[i].buf);
+		spdk_free(malloc_disk->regions[i].md_buf);
+	}
+	free(malloc_disk->regions);
 	free(malloc_disk);
 }
 
+/* Returns the region holding offset_blocks and limits num_blocks to the end of that region */
+static struct malloc_region *
+malloc_disk_get_region(struct malloc_disk *mdisk, uint64_t offset_blocks, uint64_t *num_blocks,
+		       uint64_t *region_offset)
+{
+	*region_offset = offset_blocks % mdisk->region_blocks;
+	*num_blocks = spdk_min(*num_blocks, mdisk->region_blocks - *region_offset);
+
+	return &mdisk->regions[offset_blocks / mdisk->region_blocks];
+}
+
+static void *
+malloc_disk_get_buf(struct malloc_disk *mdisk, uint64_t offset_blocks, uint64_t *num_blocks)
+{
+	struct malloc_region *region;
+	uint64_t region_offset;
+
+	region = malloc_disk_get_region(mdisk, offset_blocks, num_blocks, &region_offset);
+
+	return (uint8_t *)region->buf + region_offset * mdisk->disk.blocklen;
+}
+
+static void *
+malloc_disk_get_md_buf(struct malloc_disk *mdisk, uint64_t offset_blocks, uint64_t *num_blocks)
+{
+	struct malloc_region *region;
+	uint64_t region_offset;
+
+	region = malloc_disk_get_region(mdisk, offset_blocks, num_blocks, &region_offset);
+
+	return (uint8_t *)region->md_buf + region_offset * mdisk->disk.md_len;
+}
+
 static int
 bdev_malloc_destruct(void *ctx)
 {
@@ -226,12 +344,16 @@ static void
 bdev_malloc_readv(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 		  struct malloc_task *task, struct spdk_bdev_io *bdev_io)
 {
-	uint64_t len, offset, md_offset;
+	uint64_t len, num_blocks;
 	int res = 0;
 	size_t md_len;
+	void *buf, *md_buf;
 
 	len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
-	offset = bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen;
+	num_blocks = bdev_io->u.bdev.num_blocks;
+	buf = malloc_disk_get_buf(mdisk, bdev_io->u.bdev.offset_blocks, &num_blocks);
+	/* Reads and writes are split on the region boundaries by the bdev layer */
+	assert(num_blocks == bdev_io->u.bdev.num_blocks);
 
 	if (bdev_malloc_check_iov_len(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, len)) {
 		spdk_bdev_io_complete(spdk_bdev_io_from_ctx(task),
@@ -241,11 +363,11 @@ bdev_malloc_readv(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 
 	task->status = SPDK_BDEV_IO_STATUS_SUCCESS;
 	task->num_outstanding = 0;
-	task->iov.iov_base = mdisk->malloc_buf + offset;
+	task->iov.iov_base = buf;
 	task->iov.iov_len = len;
 
 	SPDK_DEBUGLOG(bdev_malloc, "read %zu bytes from offset %#" PRIx64 ", iovcnt=%d\n",
-		      len, offset, bdev_io->u.bdev.iovcnt);
+		      len, bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen, bdev_io->u.bdev.iovcnt);
 
 	task->num_outstanding++;
 	res = spdk_accel_append_copy(&bdev_io->u.bdev.accel_sequence, ch,
@@ -266,14 +388,13 @@ bdev_malloc_readv(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 	}
 
 	md_len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->md_len;
-	md_offset = bdev_io->u.bdev.offset_blocks * bdev_io->bdev->md_len;
+	md_buf = malloc_disk_get_md_buf(mdisk, bdev_io->u.bdev.offset_blocks, &num_blocks);
 
 	SPDK_DEBUGLOG(bdev_malloc, "read metadata %zu bytes from offset%#" PRIx64 "\n",
-		      md_len, md_offset);
+		      md_len, bdev_io->u.bdev.offset_blocks * bdev_io->bdev->md_len);
 
 	task->num_outstanding++;
-	res = spdk_accel_submit_copy(ch, bdev_io->u.bdev.md_buf, mdisk->malloc_md_buf + md_offset,
-				     md_len, 0, malloc_done, task);
+	res = spdk_accel_submit_copy(ch, bdev_io->u.bdev.md_buf, md_buf, md_len, 0, malloc_done, task);
 	if (res != 0) {
 		malloc_done(task, res);
 	}
@@ -283,12 +404,15 @@ static void
 bdev_malloc_writev(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 		   struct malloc_task *task, struct spdk_bdev_io *bdev_io)
 {
-	uint64_t len, offset, md_offset;
+	uint64_t len, num_blocks;
 	int res = 0;
 	size_t md_len;
+	void *buf, *md_buf;
 
 	len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen;
-	offset = bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen;
+	num_blocks = bdev_io->u.bdev.num_blocks;
+	buf = malloc_disk_get_buf(mdisk, bdev_io->u.bdev.offset_blocks, &num_blocks);
+	assert(num_blocks == bdev_io->u.bdev.num_blocks);
 
 	if (bdev_malloc_check_iov_len(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, len)) {
 		spdk_bdev_io_complete(spdk_bdev_io_from_ctx(task),
@@ -298,11 +422,11 @@ bdev_malloc_writev(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 
 	task->status = SPDK_BDEV_IO_STATUS_SUCCESS;
 	task->num_outstanding = 0;
-	task->iov.iov_base = mdisk->malloc_buf + offset;
+	task->iov.iov_base = buf;
 	task->iov.iov_len = len;
 
 	SPDK_DEBUGLOG(bdev_malloc, "wrote %zu bytes to offset %#" PRIx64 ", iovcnt=%d\n",
-		      len, offset, bdev_io->u.bdev.iovcnt);
+		      len, bdev_io->u.bdev.offset_blocks * bdev_io->bdev->blocklen, bdev_io->u.bdev.iovcnt);
 
 	task->num_outstanding++;
 	res = spdk_accel_append_copy(&bdev_io->u.bdev.accel_sequence, ch, &task->iov, 1, NULL, NULL,
@@ -321,52 +445,105 @@ bdev_malloc_writev(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 	}
 
 	md_len = bdev_io->u.bdev.num_blocks * bdev_io->bdev->md_len;
-	md_offset = bdev_io->u.bdev.offset_blocks * bdev_io->bdev->md_len;
+	md_buf = malloc_disk_get_md_buf(mdisk, bdev_io->u.bdev.offset_blocks, &num_blocks);
 
 	SPDK_DEBUGLOG(bdev_malloc, "wrote metadata %zu bytes to offset %#" PRIx64 "\n",
-		      md_len, md_offset);
+		      md_len, bdev_io->u.bdev.offset_blocks * bdev_io->bdev->md_len);
 
 	task->num_outstanding++;
-	res = spdk_accel_submit_copy(ch, mdisk->malloc_md_buf + md_offset, bdev_io->u.bdev.md_buf,
-				     md_len, 0, malloc_done, task);
+	res = spdk_accel_submit_copy(ch, md_buf, bdev_io->u.bdev.md_buf, md_len, 0, malloc_done, task);
 	if (res != 0) {
 		malloc_done(task, res);
 	}
 }
 
-static int
+static void
 bdev_malloc_unmap(struct malloc_disk *mdisk,
 		  struct spdk_io_channel *ch,
 		  struct malloc_task *task,
-		  uint64_t offset,
-		  uint64_t byte_count)
+		  uint64_t offset_blocks,
+		  uint64_t num_blocks)
 {
+	uint64_t len;
+	void *buf;
+	int res;
+
 	task->status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	/* Hold an extra reference, so that the task isn't completed before each region is filled */
 	task->num_outstanding = 1;
 
-	return spdk_accel_submit_fill(ch, mdisk->malloc_buf + offset, 0,
-				      byte_count, 0, malloc_done, task);
+	while (num_blocks > 0) {
+		len = num_blocks;
+		buf = malloc_disk_get_buf(mdisk, offset_blocks, &len);
+
+		task->num_outstanding++;
+		res = spdk_accel_submit_fill(ch, buf, 0, len * mdisk->disk.blocklen, 0,
+					     malloc_done, task);
+		if (res != 0) {
+			malloc_done(task, res);
+			break;
+		}
+
+		offset_blocks += len;
+		num_blocks -= len;
+	}
+
+	malloc_done(task, 0);
 }
 
 static void
 bdev_malloc_copy(struct malloc_disk *mdisk, struct spdk_io_channel *ch,
 		 struct malloc_task *task,
-		 uint64_t dst_offset, uint64_t src_offset, size_t len)
+		 uint64_t dst_offset_blocks, uint64_t src_offset_blocks, uint64_t num_blocks)
 {
-	int64_t res = 0;
-	void *dst = mdisk->malloc_buf + dst_offset;
-	void *src = mdisk->malloc_buf + src_offset;
+	uint64_t len;
+	void *dst, *src;
+	int res;
 
-	SPDK_DEBUGLOG(bdev_malloc, "Copy %zu bytes from offset %#" PRIx64 " to offset %#" PRIx64 "\n",
-		      len, src_offset, dst_offset);
+	SPDK_DEBUGLOG(bdev_malloc, "Copy %" PRIu64 " blocks from offset %#" PRIx64 " to offset %#"
+		      PRIx64 "\n", num_blocks, src_offset_blocks, dst_offset_blocks);
 
 	task->status = SPDK_BDEV_IO_STATUS_SUCCESS;
 	task->num_outstanding = 1;
 
-	res = spdk_accel_submit_copy(ch, dst, src, len, 0, malloc_done, task);
-	if (res != 0) {
-		malloc_done(task, res);
+	while (num_blocks > 0) {
+		/* Neither of the buffers may cross the boundary of its region */
+		len = num_blocks;
+		dst = malloc_disk_get_buf(mdisk, dst_offset_blocks, &len);
+		src = malloc_disk_get_buf(mdisk, src_offset_blocks, &len);
+
+		task->num_outstanding++;
+		res = spdk_accel_submit_copy(ch, dst, src, len * mdisk->disk.blocklen, 0,
+					     malloc_done, task);
+		if (res != 0) {
+			malloc_done(task, res);
+			break;
+		}
+
+		dst_offset_blocks += len;
+		src_offset_blocks += len;
+		num_blocks -= len;
 	}
+
+	malloc_done(task, 0);
+}
+
+static void
+malloc_write_verify_pi_done(void *ref, int status)
+{
+	struct malloc_task *task = ref;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(task);
+	struct malloc_channel *mch = spdk_io_channel_get_ctx(spdk_bdev_io_get_io_channel(bdev_io));
+
+	if (status != 0) {
+		if (status == -EIO) {
+			malloc_log_pi_error(bdev_io, &task->dif_err);
+		}
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	bdev_malloc_writev(bdev_io->bdev->ctxt, mch->accel_channel, task, bdev_io);
 }
 
 static int
@@ -375,6 +552,8 @@ _bdev_malloc_submit_request(struct malloc_channel *mch, struct spdk_bdev_io *bde
 	struct malloc_task *task = (struct malloc_task *)bdev_io->driver_ctx;
 	struct malloc_disk *disk = bdev_io->bdev->ctxt;
 	uint32_t block_size = bdev_io->bdev->blocklen;
+	uint64_t num_blocks;
+	void *buf;
 	int rc;
 
 	switch (bdev_io->type) {
@@ -382,8 +561,10 @@ _bdev_malloc_submit_request(struct malloc_channel *mch, struct spdk_bdev_io *bde
 		if (bdev_io->u.bdev.iovs[0].iov_base == NULL) {
 			assert(bdev_io->u.bdev.iovcnt == 1);
 			assert(bdev_io->u.bdev.memory_domain == NULL);
-			bdev_io->u.bdev.iovs[0].iov_base =
-				disk->malloc_buf + bdev_io->u.bdev.offset_blocks * block_size;
+			num_blocks = bdev_io->u.bdev.num_blocks;
+			buf = malloc_disk_get_buf(disk, bdev_io->u.bdev.offset_blocks, &num_blocks);
+			assert(num_blocks == bdev_io->u.bdev.num_blocks);
+			bdev_io->u.bdev.iovs[0].iov_base = buf;
 			bdev_io->u.bdev.iovs[0].iov_len = bdev_io->u.bdev.num_blocks * block_size;
 			malloc_complete_task(task, mch, SPDK_BDEV_IO_STATUS_SUCCESS);
 			return 0;
@@ -394,6 +575,12 @@ _bdev_malloc_submit_request(struct malloc_channel *mch, struct spdk_bdev_io *bde
 
 	case SPDK_BDEV_IO_TYPE_WRITE:
 		if (bdev_io->bdev->dif_type != SPDK_DIF_DISABLE) {
+			rc = malloc_verify_pi_accel(mch->accel_channel, task, bdev_io,
+						    malloc_write_verify_pi_done);
+			if (rc == 0) {
+				/* The data is written once it's verified */
+				return 0;
+			}
 			rc = malloc_verify_pi(bdev_io);
 			if (rc != 0) {
 				malloc_complete_task(task, mch, SPDK_BDEV_IO_STATUS_FAILED);
@@ -413,25 +600,31 @@ _bdev_malloc_submit_request(struct malloc_channel *mch, struct spdk_bdev_io *bde
 		return 0;
 
 	case SPDK_BDEV_IO_TYPE_UNMAP:
-		return bdev_malloc_unmap(disk, mch->accel_channel, task,
-					 bdev_io->u.bdev.offset_blocks * block_size,
-					 bdev_io->u.bdev.num_blocks * block_size);
+		bdev_malloc_unmap(disk, mch->accel_channel, task,
+				  bdev_io->u.bdev.offset_blocks,
+				  bdev_io->u.bdev.num_blocks);
+		return 0;
 
 	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
 		/* bdev_malloc_unmap is implemented with a call to mem_cpy_fill which zeroes out all of the requested bytes. */
-		return bdev_malloc_unmap(disk, mch->accel_channel, task,
-					 bdev_io->u.bdev.offset_blocks * block_size,
-					 bdev_io->u.bdev.num_blocks * block_size);
+		bdev_malloc_unmap(disk, mch->accel_channel, task,
+				  bdev_io->u.bdev.offset_blocks,
+				  bdev_io->u.bdev.num_blocks);
+		return 0;
 
 	case SPDK_BDEV_IO_TYPE_ZCOPY:
 		if (bdev_io->u.bdev.zcopy.start) {
-			void *buf;
-			size_t len;
-
-			buf = disk->malloc_buf + bdev_io->u.bdev.offset_blocks * block_size;
-			len = bdev_io->u.bdev.num_blocks * block_size;
-			spdk_bdev_io_set_buf(bdev_io, buf, len);
-
+			num_blocks = bdev_io->u.bdev.num_blocks;
+			buf = malloc_disk_get_buf(disk, bdev_io->u.bdev.offset_blocks, &num_blocks);
+			if (num_blocks != bdev_io->u.bdev.num_blocks) {
+				/* The buffer can only be lent out if it's contiguous */
+				SPDK_DEBUGLOG(bdev_malloc, "zcopy of %" PRIu64 " blocks at offset %#" PRIx64
+					      " crosses a stripe boundary\n", bdev_io->u.bdev.num_blocks,
+					      bdev_io->u.bdev.offset_blocks);
+				malloc_complete_task(task, mch, SPDK_BDEV_IO_STATUS_FAILED);
+				return 0;
+			}
+			spdk_bdev_io_set_buf(bdev_io, buf, num_blocks * block_size);
 		}
 		malloc_complete_task(task, mch, SPDK_BDEV_IO_STATUS_SUCCESS);
 		return 0;
@@ -440,9 +633,9 @@ _bdev_malloc_submit_request(struct malloc_channel *mch, struct spdk_bdev_io *bde
 		return 0;
 	case SPDK_BDEV_IO_TYPE_COPY:
 		bdev_malloc_copy(disk, mch->accel_channel, task,
-				 bdev_io->u.bdev.offset_blocks * block_size,
-				 bdev_io->u.bdev.copy.src_offset_blocks * block_size,
-				 bdev_io->u.bdev.num_blocks * block_size);
+				 bdev_io->u.bdev.offset_blocks,
+				 bdev_io->u.bdev.copy.src_offset_blocks,
+				 bdev_io->u.bdev.num_blocks);
 		return 0;
 
 	default:
@@ -491,6 +684,7 @@ bdev_malloc_get_io_channel(void *ctx)
 static void
 bdev_malloc_write_json_config(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
 {
+	struct malloc_disk *malloc_disk = bdev->ctxt;
 	char uuid_str[SPDK_UUID_STRING_LEN];
 
 	spdk_json_write_object_begin(w);
@@ -505,6 +699,12 @@ bdev_malloc_write_json_config(struct spdk_bdev *bdev, struct spdk_json_write_ctx
 	spdk_uuid_fmt_lower(uuid_str, sizeof(uuid_str), &bdev->uuid);
 	spdk_json_write_named_string(w, "uuid", uuid_str);
 	spdk_json_write_named_uint32(w, "optimal_io_boundary", bdev->optimal_io_boundary);
+	if (malloc_disk->numa_id != SPDK_ENV_SOCKET_ID_ANY) {
+		spdk_json_write_named_int32(w, "numa_id", malloc_disk->numa_id);
+	}
+	if (malloc_disk->numa_stripe_blocks != 0) {
+		spdk_json_write_named_uint32(w, "numa_stripe_blocks", malloc_disk->numa_stripe_blocks);
+	}
 
 	spdk_json_write_object_end(w);
 
@@ -568,39 +768,116 @@ malloc_disk_setup_pi(struct malloc_disk *mdisk)
 	struct spdk_bdev *bdev = &mdisk->disk;
 	struct spdk_dif_ctx dif_ctx;
 	struct iovec iov, md_iov;
+	uint64_t offset_blocks, num_blocks;
 	int rc;
 
-	rc = spdk_dif_ctx_init(&dif_ctx,
-			       bdev->blocklen,
-			       bdev->md_len,
-			       bdev->md_interleave,
-			       bdev->dif_is_head_of_md,
-			       bdev->dif_type,
-			       bdev->dif_check_flags,
-			       0,	/* configure the whole buffers */
-			       0, 0, 0, 0);
-	if (rc != 0) {
-		SPDK_ERRLOG("Initialization of DIF/DIX context failed\n");
-		return rc;
+	for (offset_blocks = 0; offset_blocks < bdev->blockcnt; offset_blocks += num_blocks) {
+		num_blocks = bdev->blockcnt - offset_blocks;
+		iov.iov_base = malloc_disk_get_buf(mdisk, offset_blocks, &num_blocks);
+		iov.iov_len = num_blocks * bdev->blocklen;
+
+		rc = spdk_dif_ctx_init(&dif_ctx,
+				       bdev->blocklen,
+				       bdev->md_len,
+				       bdev->md_interleave,
+				       bdev->dif_is_head_of_md,
+				       bdev->dif_type,
+				       bdev->dif_check_flags,
+				       offset_blocks & 0xFFFFFFFF,	/* configure the whole region */
+				       0, 0, 0, 0);
+		if (rc != 0) {
+			SPDK_ERRLOG("Initialization of DIF/DIX context failed\n");
+			return rc;
+		}
+
+		if (mdisk->disk.md_interleave) {
+			rc = spdk_dif_generate(&iov, 1, num_blocks, &dif_ctx);
+		} else {
+			md_iov.iov_base = malloc_disk_get_md_buf(mdisk, offset_blocks, &num_blocks);
+			md_iov.iov_len = num_blocks * bdev->md_len;
+
+			rc = spdk_dix_generate(&iov, 1, &md_iov, num_blocks, &dif_ctx);
+		}
+
+		if (rc != 0) {
+			SPDK_ERRLOG("Formatting by DIF/DIX failed\n");
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+/* Returns the NUMA nodes of the cores the application is running on */
+static int
+malloc_get_numa_nodes(int32_t *numa_nodes, int max_numa_nodes)
+{
+	int32_t numa_id;
+	uint32_t core;
+	int i, num_numa_nodes = 0;
+
+	SPDK_ENV_FOREACH_CORE(core) {
+		numa_id = spdk_env_get_socket_id(core);
+		for (i = 0; i < num_numa_nodes; i++) {
+			if (numa_nodes[i] == numa_id) {
+				break;
+			}
+		}
+		if (i == num_numa_nodes && num_numa_nodes < max_numa_nodes) {
+			numa_nodes[num_numa_nodes++] = numa_id;
+		}
 	}
 
-	iov.iov_base = mdisk->malloc_buf;
-	iov.iov_len = bdev->blockcnt * bdev->blocklen;
+	return num_numa_nodes;
+}
 
-	if (mdisk->disk.md_interleave) {
-		rc = spdk_dif_generate(&iov, 1, bdev->blockcnt, &dif_ctx);
+static int
+malloc_disk_alloc_regions(struct malloc_disk *mdisk, const struct malloc_bdev_opts *opts,
+			  uint32_t block_size)
+{
+	int32_t numa_nodes[MALLOC_MAX_NUMA_NODES] = { opts->numa_id };
+	int num_numa_nodes = 1;
+	struct malloc_region *region;
+	uint64_t num_blocks;
+	uint32_t i;
+
+	if (opts->numa_stripe_blocks != 0) {
+		mdisk->region_blocks = opts->numa_stripe_blocks;
+		num_numa_nodes = malloc_get_numa_nodes(numa_nodes, SPDK_COUNTOF(numa_nodes));
 	} else {
-		md_iov.iov_base = mdisk->malloc_md_buf;
-		md_iov.iov_len = bdev->blockcnt * bdev->md_len;
+		mdisk->region_blocks = opts->num_blocks;
+	}
 
-		rc = spdk_dix_generate(&iov, 1, &md_iov, bdev->blockcnt, &dif_ctx);
+	mdisk->num_regions = spdk_divide_round_up(opts->num_blocks, mdisk->region_blocks);
+	mdisk->regions = calloc(mdisk->num_regions, sizeof(*mdisk->regions));
+	if (!mdisk->regions) {
+		mdisk->num_regions = 0;
+		return -ENOMEM;
 	}
 
-	if (rc != 0) {
-		SPDK_ERRLOG("Formatting by DIF/DIX failed\n");
+	/* Allocate the backend memory from pinned memory, striping it across the NUMA nodes */
+	for (i = 0; i < mdisk->num_regions; i++) {
+		region = &mdisk->regions[i];
+		num_blocks = spdk_min(mdisk->region_blocks, opts->num_blocks - i * mdisk->region_blocks);
+
+		region->buf = spdk_zmalloc(num_blocks * block_size, MALLOC_BUF_ALIGNMENT, NULL,
+					   numa_nodes[i % num_numa_nodes], SPDK_MALLOC_DMA);
+		if (!region->buf) {
+			SPDK_ERRLOG("malloc_buf spdk_zmalloc() failed\n");
+			return -ENOMEM;
+		}
+
+		if (!opts->md_interleave && opts->md_size != 0) {
+			region->md_buf = spdk_zmalloc(num_blocks * opts->md_size, MALLOC_BUF_ALIGNMENT, NULL,
+						      numa_nodes[i % num_numa_nodes], SPDK_MALLOC_DMA);
+			if (!region->md_buf) {
+				SPDK_ERRLOG("malloc_md_buf spdk_zmalloc() failed\n");
+				return -ENOMEM;
+			}
+		}
 	}
 
-	return rc;
+	return 0;
 }
 
 int
@@ -656,34 +933,36 @@ create_malloc_disk(struct spdk_bdev **bdev, const struct malloc_bdev_opts *opts)
 		return -EINVAL;
 	}
 
+	if (opts->numa_stripe_blocks != 0) {
+		if (opts->numa_id != SPDK_ENV_SOCKET_ID_ANY) {
+			SPDK_ERRLOG("NUMA node cannot be specified for a striped disk\n");
+			return -EINVAL;
+		}
+
+		if (((uint64_t)opts->numa_stripe_blocks * block_size) % MALLOC_BUF_ALIGNMENT) {
+			SPDK_ERRLOG("Stripe size must be a multiple of %u bytes\n", MALLOC_BUF_ALIGNMENT);
+			return -EINVAL;
+		}
+
+		if (opts->optimal_io_boundary != 0 &&
+		    opts->numa_stripe_blocks % opts->optimal_io_boundary != 0) {
+			SPDK_ERRLOG("Stripe size must be a multiple of the optimal I/O boundary\n");
+			return -EINVAL;
+		}
+	}
+
 	mdisk = calloc(1, sizeof(*mdisk));
 	if (!mdisk) {
 		SPDK_ERRLOG("mdisk calloc() failed\n");
 		return -ENOMEM;
 	}
 
-	/*
-	 * Allocate the large backend memory buffer from pinned memory.
-	 *
-	 * TODO: need to pass a hint so we know which socket to allocate
-	 *  from on multi-socket systems.
-	 */
-	mdisk->malloc_buf = spdk_zmalloc(opts->num_blocks * block_size, 2 * 1024 * 1024, NULL,
-					 SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
-	if (!mdisk->malloc_buf) {
-		SPDK_ERRLOG("malloc_buf spdk_zmalloc() failed\n");
+	mdisk->numa_id = opts->numa_id;
+	mdisk->numa_stripe_blocks = opts->numa_stripe_blocks;
+	rc = malloc_disk_alloc_regions(mdisk, opts, block_size);
+	if (rc != 0) {
 		malloc_disk_free(mdisk);
-		return -ENOMEM;
-	}
-
-	if (!opts->md_interleave && opts->md_size != 0) {
-		mdisk->malloc_md_buf = spdk_zmalloc(opts->num_blocks * opts->md_size, 2 * 1024 * 1024, NULL,
-						    SPDK_ENV_LCORE_ID_ANY, SPDK_MALLOC_DMA);
-		if (!mdisk->malloc_md_buf) {
-			SPDK_ERRLOG("malloc_md_buf spdk_zmalloc() failed\n");
-			malloc_disk_free(mdisk);
-			return -ENOMEM;
-		}
+		return rc;
 	}
 
 	if (opts->name) {
@@ -736,6 +1015,10 @@ create_malloc_disk(struct spdk_bdev **bdev, const struct malloc_bdev_opts *opts)
 	if (opts->optimal_io_boundary) {
 		mdisk->disk.optimal_io_boundary = opts->optimal_io_boundary;
 		mdisk->disk.split_on_optimal_io_boundary = true;
+	} else if (opts->numa_stripe_blocks) {
+		/* Make sure that reads and writes never cross a stripe */
+		mdisk->disk.optimal_io_boundary = opts->numa_stripe_blocks;
+		mdisk->disk.split_on_optimal_io_boundary = true;
 	}
 	if (!spdk_uuid_is_null(&opts->uuid)) {
 		spdk_uuid_copy(&mdisk->disk.uuid, &opts->uuid);
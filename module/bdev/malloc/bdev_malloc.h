@@ -24,6 +24,11 @@ struct malloc_bdev_opts {
 	bool md_interleave;
 	enum spdk_dif_type dif_type;
 	bool dif_is_head_of_md;
+	/* NUMA node to allocate the memory on, SPDK_ENV_SOCKET_ID_ANY for no preference */
+	int32_t numa_id;
+	/* If non-zero, the memory is striped in chunks of this many blocks across the NUMA nodes
+	 * of the application's cores */
+	uint32_t numa_stripe_blocks;
 };
 
 int create_malloc_disk(struct spdk_bdev **bdev, const struct malloc_bdev_opts *opts);
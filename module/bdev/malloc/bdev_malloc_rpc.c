@@ -5,6 +5,7 @@
  */
 
 #include "bdev_malloc.h"
+#include "spdk/env.h"
 #include "spdk/rpc.h"
 #include "spdk/string.h"
 #include "spdk/log.h"
@@ -41,6 +42,8 @@ static const struct spdk_json_object_decoder rpc_construct_malloc_decoders[] = {
 	{"md_interleave", offsetof(struct malloc_bdev_opts, md_interleave), spdk_json_decode_bool, true},
 	{"dif_type", offsetof(struct malloc_bdev_opts, dif_type), spdk_json_decode_int32, true},
 	{"dif_is_head_of_md", offsetof(struct malloc_bdev_opts, dif_is_head_of_md), spdk_json_decode_bool, true},
+	{"numa_id", offsetof(struct malloc_bdev_opts, numa_id), spdk_json_decode_int32, true},
+	{"numa_stripe_blocks", offsetof(struct malloc_bdev_opts, numa_stripe_blocks), spdk_json_decode_uint32, true},
 };
 
 static void
@@ -52,6 +55,7 @@ rpc_bdev_malloc_create(struct spdk_jsonrpc_request *request,
 	struct spdk_bdev *bdev;
 	int rc = 0;
 
+	req.numa_id = SPDK_ENV_SOCKET_ID_ANY;
 	if (spdk_json_decode_object(params, rpc_construct_malloc_decoders,
 				    SPDK_COUNTOF(rpc_construct_malloc_decoders),
 				    &req)) {
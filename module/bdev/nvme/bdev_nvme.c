@@ -36,6 +36,27 @@
 
 #define NSID_STR_LEN 10
 
+/* Weight of a new sample in the path latency average, as a power of 2 */
+#define BDEV_NVME_LATENCY_EWMA_SHIFT		3
+/* Every that many I/O, the latency selector picks the next path round-robin */
+#define BDEV_NVME_LATENCY_PROBE_INTERVAL	64
+
+/* A retry costs 100 tokens, a successful I/O earns bdev_retry_budget_percent tokens. */
+#define BDEV_NVME_RETRY_TOKEN_COST		100
+#define BDEV_NVME_RETRY_TOKENS_MAX		(10 * BDEV_NVME_RETRY_TOKEN_COST)
+
+#define BDEV_NVME_ADAPTIVE_TIMEOUT_PERIOD_US	1000000
+#define BDEV_NVME_ADAPTIVE_TIMEOUT_MIN_SAMPLES	100
+#define BDEV_NVME_ADAPTIVE_TIMEOUT_MIN_US	10000
+
+/* Reads are hedged only if they are small enough to be copied from the bounce buffer. */
+#define BDEV_NVME_HEDGE_MAX_SIZE		(128 * 1024)
+#define BDEV_NVME_HEDGE_POLL_PERIOD_US		10
+/* Every that many reads, the hedge threshold is updated and the read histogram decays. */
+#define BDEV_NVME_HEDGE_UPDATE_INTERVAL		1024
+
+#define BDEV_NVME_IO_QPAIRS_PER_CTRLR_MAX	64
+
 static int bdev_nvme_config_json(struct spdk_json_write_ctx *w);
 
 struct nvme_bdev_io {
@@ -97,6 +118,21 @@ struct nvme_bdev_io {
 
 	/* Current tsc at submit time. */
 	uint64_t submit_tsc;
+
+	/* Outstanding reads of a hedged read, each on its own path and bounce buffer. */
+	struct nvme_hedged_read *hedged_reads[2];
+	uint8_t num_hedged_reads;
+	bool hedge_queued;
+	uint64_t hedge_deadline_tsc;
+	TAILQ_ENTRY(nvme_bdev_io) hedge_link;
+};
+
+struct nvme_hedged_read {
+	/* NULL once the hedged read was completed by another read. */
+	struct nvme_bdev_io	*bio;
+	struct nvme_io_path	*io_path;
+	void			*buf;
+	size_t			len;
 };
 
 struct nvme_probe_skip_entry {
@@ -121,6 +157,7 @@ static struct spdk_bdev_nvme_opts g_opts = {
 	.nvme_ioq_poll_period_us = 0,
 	.io_queue_requests = 0,
 	.delay_cmd_submit = SPDK_BDEV_NVME_DEFAULT_DELAY_CMD_SUBMIT,
+	.delay_cmd_submit_batch_size = 0,
 	.bdev_retry_count = 3,
 	.transport_ack_timeout = 0,
 	.ctrlr_loss_timeout_sec = 0,
@@ -131,6 +168,13 @@ static struct spdk_bdev_nvme_opts g_opts = {
 	.transport_tos = 0,
 	.nvme_error_stat = false,
 	.io_path_stat = false,
+	.bdev_retry_budget_percent = 0,
+	.adaptive_timeout_multiplier = 0,
+	.hedged_read_percentile = 0,
+	.nvme_ioq_adaptive_poll_max_us = 0,
+	.nvme_ioq_adaptive_poll_batch = 8,
+	.align_write_splits = false,
+	.io_qpairs_per_ctrlr = 1,
 };
 
 #define NVME_HOTPLUG_POLL_PERIOD_MAX			10000000ULL
@@ -472,6 +516,7 @@ nvme_ctrlr_delete(struct nvme_ctrlr *nvme_ctrlr)
 	int rc;
 
 	spdk_poller_unregister(&nvme_ctrlr->reconnect_delay_timer);
+	spdk_poller_unregister(&nvme_ctrlr->adaptive_timeout_poller);
 
 	/* First, unregister the adminq poller, as the driver will poll adminq if necessary */
 	spdk_poller_unregister(&nvme_ctrlr->adminq_timer_poller);
@@ -539,6 +584,10 @@ nvme_ctrlr_can_be_unregistered(struct nvme_ctrlr *nvme_ctrlr)
 		return false;
 	}
 
+	if (nvme_ctrlr->timeout_updating) {
+		return false;
+	}
+
 	return true;
 }
 
@@ -613,6 +662,27 @@ nvme_io_path_free(struct nvme_io_path *io_path)
 	free(io_path);
 }
 
+static bool
+nvme_ctrlr_is_numa_local(struct nvme_ctrlr *nvme_ctrlr)
+{
+	int32_t ctrlr_socket_id, socket_id;
+	uint32_t core;
+
+	ctrlr_socket_id = spdk_nvme_ctrlr_get_socket_id(nvme_ctrlr->ctrlr);
+	if (ctrlr_socket_id == SPDK_ENV_SOCKET_ID_ANY) {
+		return true;
+	}
+
+	core = spdk_env_get_current_core();
+	if (core == SPDK_ENV_LCORE_ID_ANY) {
+		return true;
+	}
+
+	socket_id = spdk_env_get_socket_id(core);
+
+	return socket_id == SPDK_ENV_SOCKET_ID_ANY || socket_id == ctrlr_socket_id;
+}
+
 static int
 _bdev_nvme_add_io_path(struct nvme_bdev_channel *nbdev_ch, struct nvme_ns *nvme_ns)
 {
@@ -643,6 +713,8 @@ _bdev_nvme_add_io_path(struct nvme_bdev_channel *nbdev_ch, struct nvme_ns *nvme_
 	io_path->qpair = nvme_qpair;
 	TAILQ_INSERT_TAIL(&nvme_qpair->io_path_list, io_path, tailq);
 
+	io_path->numa_local = nvme_ctrlr_is_numa_local(nvme_ns->ctrlr);
+
 	io_path->nbdev_ch = nbdev_ch;
 	STAILQ_INSERT_TAIL(&nbdev_ch->io_path_list, io_path, stailq);
 
@@ -699,6 +771,8 @@ _bdev_nvme_delete_io_paths(struct nvme_bdev_channel *nbdev_ch)
 	}
 }
 
+static int bdev_nvme_hedge_poll(void *arg);
+
 static int
 bdev_nvme_create_bdev_channel_cb(void *io_device, void *ctx_buf)
 {
@@ -709,6 +783,15 @@ bdev_nvme_create_bdev_channel_cb(void *io_device, void *ctx_buf)
 
 	STAILQ_INIT(&nbdev_ch->io_path_list);
 	TAILQ_INIT(&nbdev_ch->retry_io_list);
+	TAILQ_INIT(&nbdev_ch->hedge_list);
+
+	if (g_opts.hedged_read_percentile != 0) {
+		nbdev_ch->hedge_poller = SPDK_POLLER_REGISTER(bdev_nvme_hedge_poll, nbdev_ch,
+					 BDEV_NVME_HEDGE_POLL_PERIOD_US);
+		if (nbdev_ch->hedge_poller == NULL) {
+			return -ENOMEM;
+		}
+	}
 
 	pthread_mutex_lock(&nbdev->mutex);
 
@@ -722,6 +805,7 @@ bdev_nvme_create_bdev_channel_cb(void *io_device, void *ctx_buf)
 			pthread_mutex_unlock(&nbdev->mutex);
 
 			_bdev_nvme_delete_io_paths(nbdev_ch);
+			spdk_poller_unregister(&nbdev_ch->hedge_poller);
 			return rc;
 		}
 	}
@@ -755,6 +839,9 @@ bdev_nvme_destroy_bdev_channel_cb(void *io_device, void *ctx_buf)
 
 	bdev_nvme_abort_retry_ios(nbdev_ch);
 	_bdev_nvme_delete_io_paths(nbdev_ch);
+
+	assert(TAILQ_EMPTY(&nbdev_ch->hedge_list));
+	spdk_poller_unregister(&nbdev_ch->hedge_poller);
 }
 
 static inline bool
@@ -790,6 +877,55 @@ nvme_ns_is_accessible(struct nvme_ns *nvme_ns)
 	return false;
 }
 
+static inline uint32_t
+nvme_qpair_get_num_outstanding_reqs(struct nvme_qpair *nvme_qpair)
+{
+	uint32_t i, num_outstanding_reqs;
+
+	num_outstanding_reqs = spdk_nvme_qpair_get_num_outstanding_reqs(nvme_qpair->qpair);
+	for (i = 0; i < nvme_qpair->num_secondary_qpairs; i++) {
+		if (nvme_qpair->secondary_qpairs[i] != NULL) {
+			num_outstanding_reqs += spdk_nvme_qpair_get_num_outstanding_reqs(
+							nvme_qpair->secondary_qpairs[i]);
+		}
+	}
+
+	return num_outstanding_reqs;
+}
+
+/* Pick the qpair with the fewest outstanding requests for an I/O. Commands which have to be
+ * submitted to the same qpair, like fused or zone commands, always use the primary qpair.
+ */
+static inline struct spdk_nvme_qpair *
+nvme_qpair_get_io_qpair(struct nvme_qpair *nvme_qpair)
+{
+	struct spdk_nvme_qpair *qpair, *secondary_qpair;
+	uint32_t i, num_outstanding_reqs, min_outstanding_reqs;
+
+	qpair = nvme_qpair->qpair;
+	if (spdk_likely(nvme_qpair->num_secondary_qpairs == 0)) {
+		return qpair;
+	}
+
+	min_outstanding_reqs = spdk_nvme_qpair_get_num_outstanding_reqs(qpair);
+	for (i = 0; i < nvme_qpair->num_secondary_qpairs && min_outstanding_reqs > 0; i++) {
+		secondary_qpair = nvme_qpair->secondary_qpairs[i];
+		if (secondary_qpair == NULL ||
+		    spdk_nvme_qpair_get_failure_reason(secondary_qpair) !=
+		    SPDK_NVME_QPAIR_FAILURE_NONE) {
+			continue;
+		}
+
+		num_outstanding_reqs = spdk_nvme_qpair_get_num_outstanding_reqs(secondary_qpair);
+		if (num_outstanding_reqs < min_outstanding_reqs) {
+			min_outstanding_reqs = num_outstanding_reqs;
+			qpair = secondary_qpair;
+		}
+	}
+
+	return qpair;
+}
+
 static inline bool
 nvme_io_path_is_connected(struct nvme_io_path *io_path)
 {
@@ -896,10 +1032,29 @@ nvme_io_path_get_next(struct nvme_bdev_channel *nbdev_ch, struct nvme_io_path *p
 	return STAILQ_FIRST(&nbdev_ch->io_path_list);
 }
 
+/* Return true if io_path should be selected over best, comparing first their NUMA locality
+ * and then the metric of the selector, lower being better.
+ */
+static inline bool
+nvme_io_path_is_preferred(struct nvme_io_path *io_path, uint64_t value,
+			  struct nvme_io_path *best, uint64_t best_value)
+{
+	if (best == NULL) {
+		return true;
+	}
+
+	if (io_path->numa_local != best->numa_local) {
+		return io_path->numa_local;
+	}
+
+	return value < best_value;
+}
+
 static struct nvme_io_path *
 _bdev_nvme_find_io_path(struct nvme_bdev_channel *nbdev_ch)
 {
-	struct nvme_io_path *io_path, *start, *non_optimized = NULL;
+	struct nvme_io_path *io_path, *start, *optimized = NULL, *non_optimized = NULL;
+	bool any_numa = nbdev_ch->mp_policy == BDEV_NVME_MP_POLICY_ACTIVE_PASSIVE;
 
 	start = nvme_io_path_get_next(nbdev_ch, nbdev_ch->current_io_path);
 
@@ -909,10 +1064,18 @@ _bdev_nvme_find_io_path(struct nvme_bdev_channel *nbdev_ch)
 				!io_path->nvme_ns->ana_state_updating)) {
 			switch (io_path->nvme_ns->ana_state) {
 			case SPDK_NVME_ANA_OPTIMIZED_STATE:
-				nbdev_ch->current_io_path = io_path;
-				return io_path;
+				if (any_numa || io_path->numa_local) {
+					nbdev_ch->current_io_path = io_path;
+					return io_path;
+				}
+				if (optimized == NULL) {
+					optimized = io_path;
+				}
+				break;
 			case SPDK_NVME_ANA_NON_OPTIMIZED_STATE:
-				if (non_optimized == NULL) {
+				if (non_optimized == NULL ||
+				    (!any_numa && io_path->numa_local &&
+				     !non_optimized->numa_local)) {
 					non_optimized = io_path;
 				}
 				break;
@@ -923,6 +1086,12 @@ _bdev_nvme_find_io_path(struct nvme_bdev_channel *nbdev_ch)
 		io_path = nvme_io_path_get_next(nbdev_ch, io_path);
 	} while (io_path != start);
 
+	if (optimized != NULL) {
+		/* There is no optimized path on the local NUMA node. */
+		nbdev_ch->current_io_path = optimized;
+		return optimized;
+	}
+
 	if (nbdev_ch->mp_policy == BDEV_NVME_MP_POLICY_ACTIVE_ACTIVE) {
 		/* We come here only if there is no optimized path. Cache even non_optimized
 		 * path for load balance across multiple non_optimized paths.
@@ -951,16 +1120,18 @@ _bdev_nvme_find_io_path_min_qd(struct nvme_bdev_channel *nbdev_ch)
 			continue;
 		}
 
-		num_outstanding_reqs = spdk_nvme_qpair_get_num_outstanding_reqs(io_path->qpair->qpair);
+		num_outstanding_reqs = nvme_qpair_get_num_outstanding_reqs(io_path->qpair);
 		switch (io_path->nvme_ns->ana_state) {
 		case SPDK_NVME_ANA_OPTIMIZED_STATE:
-			if (num_outstanding_reqs < opt_min_qd) {
+			if (nvme_io_path_is_preferred(io_path, num_outstanding_reqs,
+						      optimized, opt_min_qd)) {
 				opt_min_qd = num_outstanding_reqs;
 				optimized = io_path;
 			}
 			break;
 		case SPDK_NVME_ANA_NON_OPTIMIZED_STATE:
-			if (num_outstanding_reqs < non_opt_min_qd) {
+			if (nvme_io_path_is_preferred(io_path, num_outstanding_reqs,
+						      non_optimized, non_opt_min_qd)) {
 				non_opt_min_qd = num_outstanding_reqs;
 				non_optimized = io_path;
 			}
@@ -978,6 +1149,59 @@ _bdev_nvme_find_io_path_min_qd(struct nvme_bdev_channel *nbdev_ch)
 	return non_optimized;
 }
 
+static struct nvme_io_path *
+_bdev_nvme_find_io_path_min_latency(struct nvme_bdev_channel *nbdev_ch)
+{
+	struct nvme_io_path *io_path;
+	struct nvme_io_path *optimized = NULL, *non_optimized = NULL;
+	uint64_t opt_min_latency = UINT64_MAX, non_opt_min_latency = UINT64_MAX;
+
+	/* Send some I/O round-robin so that the latency of the slower paths is kept
+	 * up to date.
+	 */
+	if (++nbdev_ch->latency_probe_counter >= BDEV_NVME_LATENCY_PROBE_INTERVAL) {
+		nbdev_ch->latency_probe_counter = 0;
+		return _bdev_nvme_find_io_path(nbdev_ch);
+	}
+
+	STAILQ_FOREACH(io_path, &nbdev_ch->io_path_list, stailq) {
+		if (spdk_unlikely(!nvme_io_path_is_connected(io_path))) {
+			/* The device is currently resetting. */
+			continue;
+		}
+
+		if (spdk_unlikely(io_path->nvme_ns->ana_state_updating)) {
+			continue;
+		}
+
+		/* A path without any completion yet has a latency of 0, so it is tried first. */
+		switch (io_path->nvme_ns->ana_state) {
+		case SPDK_NVME_ANA_OPTIMIZED_STATE:
+			if (nvme_io_path_is_preferred(io_path, io_path->latency_ewma_ticks,
+						      optimized, opt_min_latency)) {
+				opt_min_latency = io_path->latency_ewma_ticks;
+				optimized = io_path;
+			}
+			break;
+		case SPDK_NVME_ANA_NON_OPTIMIZED_STATE:
+			if (nvme_io_path_is_preferred(io_path, io_path->latency_ewma_ticks,
+						      non_optimized, non_opt_min_latency)) {
+				non_opt_min_latency = io_path->latency_ewma_ticks;
+				non_optimized = io_path;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (optimized != NULL) {
+		return optimized;
+	}
+
+	return non_optimized;
+}
+
 static inline struct nvme_io_path *
 bdev_nvme_find_io_path(struct nvme_bdev_channel *nbdev_ch)
 {
@@ -995,6 +1219,8 @@ bdev_nvme_find_io_path(struct nvme_bdev_channel *nbdev_ch)
 	if (nbdev_ch->mp_policy == BDEV_NVME_MP_POLICY_ACTIVE_PASSIVE ||
 	    nbdev_ch->mp_selector == BDEV_NVME_MP_SELECTOR_ROUND_ROBIN) {
 		return _bdev_nvme_find_io_path(nbdev_ch);
+	} else if (nbdev_ch->mp_selector == BDEV_NVME_MP_SELECTOR_LATENCY) {
+		return _bdev_nvme_find_io_path_min_latency(nbdev_ch);
 	} else {
 		return _bdev_nvme_find_io_path_min_qd(nbdev_ch);
 	}
@@ -1109,6 +1335,44 @@ bdev_nvme_queue_retry_io(struct nvme_bdev_channel *nbdev_ch,
 				    delay_ms * 1000ULL);
 }
 
+/* I/Os which found no available path wait for a fixed delay. Retry them right away
+ * once a path becomes available again. I/Os delayed by the controller (CRD) keep
+ * their io_path and are left as is.
+ */
+static void
+bdev_nvme_kick_retry_ios(struct nvme_bdev_channel *nbdev_ch)
+{
+	struct spdk_bdev_io *bdev_io, *tmp_bdev_io;
+	struct nvme_bdev_io *bio;
+	uint64_t now;
+
+	now = spdk_get_ticks();
+
+	TAILQ_FOREACH_SAFE(bdev_io, &nbdev_ch->retry_io_list, module_link, tmp_bdev_io) {
+		bio = (struct nvme_bdev_io *)bdev_io->driver_ctx;
+		if (bio->io_path != NULL || bio->retry_ticks <= now) {
+			continue;
+		}
+
+		TAILQ_REMOVE(&nbdev_ch->retry_io_list, bdev_io, module_link);
+
+		bdev_nvme_queue_retry_io(nbdev_ch, bio, 0);
+	}
+}
+
+static void
+_bdev_nvme_kick_retry_ios(struct nvme_qpair *nvme_qpair)
+{
+	struct nvme_io_path *io_path;
+
+	TAILQ_FOREACH(io_path, &nvme_qpair->io_path_list, tailq) {
+		if (io_path->nbdev_ch == NULL || !nvme_io_path_is_available(io_path)) {
+			continue;
+		}
+		bdev_nvme_kick_retry_ios(io_path->nbdev_ch);
+	}
+}
+
 static void
 bdev_nvme_abort_retry_ios(struct nvme_bdev_channel *nbdev_ch)
 {
@@ -1266,6 +1530,117 @@ bdev_nvme_update_io_path_stat(struct nvme_bdev_io *bio)
 	}
 }
 
+static inline void
+bdev_nvme_update_io_path_latency(struct nvme_bdev_io *bio)
+{
+	struct nvme_io_path *io_path = bio->io_path;
+	uint64_t tsc_diff, ewma;
+
+	if (spdk_likely(io_path->nbdev_ch == NULL ||
+			io_path->nbdev_ch->mp_selector != BDEV_NVME_MP_SELECTOR_LATENCY)) {
+		return;
+	}
+
+	tsc_diff = spdk_get_ticks() - bio->submit_tsc;
+	ewma = io_path->latency_ewma_ticks;
+	if (ewma == 0) {
+		ewma = tsc_diff;
+	} else {
+		ewma = ewma - (ewma >> BDEV_NVME_LATENCY_EWMA_SHIFT) +
+		       (tsc_diff >> BDEV_NVME_LATENCY_EWMA_SHIFT);
+	}
+	io_path->latency_ewma_ticks = ewma;
+}
+
+/* Return the upper bound, in ticks, of the bucket which holds the given percentile. */
+static uint64_t
+bdev_nvme_get_latency_percentile(const uint64_t *buckets, uint64_t total, uint32_t percentile)
+{
+	uint64_t count = 0;
+	int i;
+
+	for (i = 0; i < NVME_LATENCY_BUCKETS - 1; i++) {
+		count += buckets[i];
+		if (count * 100 >= total * percentile) {
+			break;
+		}
+	}
+
+	return 2ULL << i;
+}
+
+static inline void
+bdev_nvme_update_hedge_threshold(struct nvme_bdev_io *bio)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+	struct nvme_bdev_channel *nbdev_ch;
+	uint64_t tsc_diff, total = 0;
+	int i;
+
+	if (spdk_likely(g_opts.hedged_read_percentile == 0 ||
+			bdev_io->type != SPDK_BDEV_IO_TYPE_READ)) {
+		return;
+	}
+
+	nbdev_ch = spdk_io_channel_get_ctx(spdk_bdev_io_get_io_channel(bdev_io));
+
+	tsc_diff = spdk_get_ticks() - bio->submit_tsc;
+	nbdev_ch->read_latency_buckets[spdk_u64log2(tsc_diff)]++;
+
+	if (++nbdev_ch->hedge_sample_count < BDEV_NVME_HEDGE_UPDATE_INTERVAL) {
+		return;
+	}
+	nbdev_ch->hedge_sample_count = 0;
+
+	for (i = 0; i < NVME_LATENCY_BUCKETS; i++) {
+		total += nbdev_ch->read_latency_buckets[i];
+	}
+
+	nbdev_ch->hedge_threshold_ticks = bdev_nvme_get_latency_percentile(
+			nbdev_ch->read_latency_buckets, total, g_opts.hedged_read_percentile);
+
+	/* Halve the history so that the threshold follows the recent reads. */
+	for (i = 0; i < NVME_LATENCY_BUCKETS; i++) {
+		nbdev_ch->read_latency_buckets[i] >>= 1;
+	}
+}
+
+static inline void
+bdev_nvme_update_qpair_stat(struct nvme_bdev_io *bio)
+{
+	struct nvme_qpair *nvme_qpair = bio->io_path->qpair;
+	uint64_t tsc_diff;
+
+	if (g_opts.bdev_retry_budget_percent != 0) {
+		nvme_qpair->retry_tokens = spdk_min(nvme_qpair->retry_tokens +
+						    g_opts.bdev_retry_budget_percent,
+						    BDEV_NVME_RETRY_TOKENS_MAX);
+	}
+
+	if (g_opts.adaptive_timeout_multiplier != 0) {
+		tsc_diff = spdk_get_ticks() - bio->submit_tsc;
+		nvme_qpair->latency_buckets[spdk_u64log2(tsc_diff)]++;
+	}
+}
+
+/* Limit the retries on a path to a fraction of its successful I/Os, so that a
+ * degrading device is not flooded by retries.
+ */
+static inline bool
+bdev_nvme_retry_budget_take(struct nvme_qpair *nvme_qpair)
+{
+	if (g_opts.bdev_retry_budget_percent == 0) {
+		return true;
+	}
+
+	if (nvme_qpair->retry_tokens < BDEV_NVME_RETRY_TOKEN_COST) {
+		return false;
+	}
+
+	nvme_qpair->retry_tokens -= BDEV_NVME_RETRY_TOKEN_COST;
+	return true;
+}
+
 static inline void
 bdev_nvme_io_complete_nvme_status(struct nvme_bdev_io *bio,
 				  const struct spdk_nvme_cpl *cpl)
@@ -1281,6 +1656,9 @@ bdev_nvme_io_complete_nvme_status(struct nvme_bdev_io *bio,
 
 	if (spdk_likely(spdk_nvme_cpl_is_success(cpl))) {
 		bdev_nvme_update_io_path_stat(bio);
+		bdev_nvme_update_io_path_latency(bio);
+		bdev_nvme_update_qpair_stat(bio);
+		bdev_nvme_update_hedge_threshold(bio);
 		goto complete;
 	}
 
@@ -1317,6 +1695,10 @@ bdev_nvme_io_complete_nvme_status(struct nvme_bdev_io *bio,
 		}
 		delay_ms = 0;
 	} else {
+		if (!bdev_nvme_retry_budget_take(io_path->qpair)) {
+			goto complete;
+		}
+
 		bio->retry_count++;
 
 		cdata = spdk_nvme_ctrlr_get_data(nvme_ctrlr->ctrlr);
@@ -1438,6 +1820,7 @@ bdev_nvme_clear_io_path_cache(struct spdk_io_channel_iter *i)
 	assert(ctrlr_ch->qpair != NULL);
 
 	_bdev_nvme_clear_io_path_cache(ctrlr_ch->qpair);
+	_bdev_nvme_kick_retry_ios(ctrlr_ch->qpair);
 
 	spdk_for_each_channel_continue(i, 0);
 }
@@ -1461,13 +1844,31 @@ bdev_nvme_clear_io_path_caches(struct nvme_ctrlr *nvme_ctrlr)
 			      bdev_nvme_clear_io_path_caches_done);
 }
 
+static struct spdk_nvme_qpair **
+nvme_qpair_find_qpair(struct nvme_qpair *nvme_qpair, struct spdk_nvme_qpair *qpair)
+{
+	uint32_t i;
+
+	if (nvme_qpair->qpair == qpair) {
+		return &nvme_qpair->qpair;
+	}
+
+	for (i = 0; i < nvme_qpair->num_secondary_qpairs; i++) {
+		if (nvme_qpair->secondary_qpairs[i] == qpair) {
+			return &nvme_qpair->secondary_qpairs[i];
+		}
+	}
+
+	return NULL;
+}
+
 static struct nvme_qpair *
 nvme_poll_group_get_qpair(struct nvme_poll_group *group, struct spdk_nvme_qpair *qpair)
 {
 	struct nvme_qpair *nvme_qpair;
 
 	TAILQ_FOREACH(nvme_qpair, &group->qpair_list, tailq) {
-		if (nvme_qpair->qpair == qpair) {
+		if (nvme_qpair_find_qpair(nvme_qpair, qpair) != NULL) {
 			break;
 		}
 	}
@@ -1475,6 +1876,32 @@ nvme_poll_group_get_qpair(struct nvme_poll_group *group, struct spdk_nvme_qpair
 	return nvme_qpair;
 }
 
+/* Start disconnecting all qpairs of the nvme_qpair. Return false if none of them is left, i.e.
+ * the nvme_qpair is already disconnected.
+ */
+static bool
+nvme_qpair_disconnect(struct nvme_qpair *nvme_qpair, bool abort_dnr)
+{
+	struct spdk_nvme_qpair *qpair;
+	bool connected = false;
+	uint32_t i;
+
+	for (i = 0; i <= nvme_qpair->num_secondary_qpairs; i++) {
+		qpair = i == 0 ? nvme_qpair->qpair : nvme_qpair->secondary_qpairs[i - 1];
+		if (qpair == NULL) {
+			continue;
+		}
+
+		if (abort_dnr) {
+			spdk_nvme_qpair_set_abort_dnr(qpair, true);
+		}
+		spdk_nvme_ctrlr_disconnect_io_qpair(qpair);
+		connected = true;
+	}
+
+	return connected;
+}
+
 static void nvme_qpair_delete(struct nvme_qpair *nvme_qpair);
 
 static void
@@ -1483,20 +1910,37 @@ bdev_nvme_disconnected_qpair_cb(struct spdk_nvme_qpair *qpair, void *poll_group_
 	struct nvme_poll_group *group = poll_group_ctx;
 	struct nvme_qpair *nvme_qpair;
 	struct nvme_ctrlr_channel *ctrlr_ch;
+	struct spdk_nvme_qpair **slot;
 
 	nvme_qpair = nvme_poll_group_get_qpair(group, qpair);
 	if (nvme_qpair == NULL) {
 		return;
 	}
 
-	if (nvme_qpair->qpair != NULL) {
-		spdk_nvme_ctrlr_free_io_qpair(nvme_qpair->qpair);
-		nvme_qpair->qpair = NULL;
+	slot = nvme_qpair_find_qpair(nvme_qpair, qpair);
+	assert(slot != NULL);
+	spdk_nvme_ctrlr_free_io_qpair(*slot);
+	*slot = NULL;
+
+	ctrlr_ch = nvme_qpair->ctrlr_ch;
+
+	/* A secondary qpair which got disconnected on its own is just dropped. I/Os are spread
+	 * across the remaining qpairs until the next reset creates it again.
+	 */
+	if (slot != &nvme_qpair->qpair && nvme_qpair->qpair != NULL && ctrlr_ch != NULL &&
+	    ctrlr_ch->reset_iter == NULL) {
+		SPDK_NOTICELOG("secondary qpair %p was disconnected and freed.\n", qpair);
+		return;
 	}
 
-	_bdev_nvme_clear_io_path_cache(nvme_qpair);
+	/* Otherwise, disconnect the others too, and recover or delete the nvme_qpair as a whole
+	 * once the last one is freed.
+	 */
+	if (nvme_qpair_disconnect(nvme_qpair, false)) {
+		return;
+	}
 
-	ctrlr_ch = nvme_qpair->ctrlr_ch;
+	_bdev_nvme_clear_io_path_cache(nvme_qpair);
 
 	if (ctrlr_ch != NULL) {
 		if (ctrlr_ch->reset_iter != NULL) {
@@ -1536,6 +1980,74 @@ bdev_nvme_check_io_qpairs(struct nvme_poll_group *group)
 	}
 }
 
+#define NVME_ADAPTIVE_POLL_WINDOW_US	10000ULL
+
+static int bdev_nvme_poll(void *arg);
+
+static void
+bdev_nvme_poll_group_set_period(struct nvme_poll_group *group, uint64_t period_us)
+{
+	struct spdk_poller *poller;
+
+	poller = SPDK_POLLER_REGISTER(bdev_nvme_poll, group, period_us);
+	if (poller == NULL) {
+		SPDK_ERRLOG("Failed to change the I/O poll period to %" PRIu64 " us\n", period_us);
+		return;
+	}
+
+	spdk_poller_unregister(&group->poller);
+	group->poller = poller;
+	group->poll_period_us = period_us;
+}
+
+/* Stretch the poll period while the load is low so that each poll reaps about
+ * nvme_ioq_adaptive_poll_batch completions, and go back to the base period as soon as
+ * a single poll reaps a full batch.
+ */
+static void
+bdev_nvme_poll_group_adapt_period(struct nvme_poll_group *group, int64_t num_completions)
+{
+	uint64_t now, elapsed_us, period_us;
+	uint64_t base_us = g_opts.nvme_ioq_poll_period_us;
+	uint64_t max_us = g_opts.nvme_ioq_adaptive_poll_max_us;
+	uint32_t batch = g_opts.nvme_ioq_adaptive_poll_batch;
+
+	now = spdk_get_ticks();
+	if (group->window_start_tsc == 0) {
+		group->window_start_tsc = now;
+	}
+
+	if (num_completions > 0) {
+		group->window_completions += num_completions;
+		if (num_completions >= batch && group->poll_period_us != base_us) {
+			group->window_start_tsc = now;
+			group->window_completions = 0;
+			bdev_nvme_poll_group_set_period(group, base_us);
+			return;
+		}
+	}
+
+	elapsed_us = (now - group->window_start_tsc) * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+	if (elapsed_us < NVME_ADAPTIVE_POLL_WINDOW_US) {
+		return;
+	}
+
+	if (group->window_completions == 0) {
+		period_us = max_us;
+	} else {
+		period_us = elapsed_us * batch / group->window_completions;
+		period_us = spdk_max(period_us, base_us);
+		period_us = spdk_min(period_us, max_us);
+	}
+
+	group->window_start_tsc = now;
+	group->window_completions = 0;
+
+	if (period_us != group->poll_period_us) {
+		bdev_nvme_poll_group_set_period(group, period_us);
+	}
+}
+
 static int
 bdev_nvme_poll(void *arg)
 {
@@ -1546,8 +2058,11 @@ bdev_nvme_poll(void *arg)
 		group->start_ticks = spdk_get_ticks();
 	}
 
+	/* Hand the completions up grouped by bdev channel rather than one by one. */
+	spdk_bdev_io_complete_batch_begin();
 	num_completions = spdk_nvme_poll_group_process_completions(group->group, 0,
 			  bdev_nvme_disconnected_qpair_cb);
+	spdk_bdev_io_complete_batch_end();
 	if (group->collect_spin_stat) {
 		if (num_completions > 0) {
 			if (group->end_ticks != 0) {
@@ -1564,6 +2079,10 @@ bdev_nvme_poll(void *arg)
 		bdev_nvme_check_io_qpairs(group);
 	}
 
+	if (spdk_unlikely(g_opts.nvme_ioq_adaptive_poll_max_us != 0)) {
+		bdev_nvme_poll_group_adapt_period(group, num_completions);
+	}
+
 	return num_completions > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
 }
 
@@ -1652,23 +2171,14 @@ bdev_nvme_destruct(void *ctx)
 }
 
 static int
-bdev_nvme_create_qpair(struct nvme_qpair *nvme_qpair)
+bdev_nvme_connect_io_qpair(struct nvme_qpair *nvme_qpair, struct spdk_nvme_io_qpair_opts *opts,
+			   struct spdk_nvme_qpair **_qpair)
 {
-	struct nvme_ctrlr *nvme_ctrlr;
-	struct spdk_nvme_io_qpair_opts opts;
+	struct nvme_ctrlr *nvme_ctrlr = nvme_qpair->ctrlr;
 	struct spdk_nvme_qpair *qpair;
 	int rc;
 
-	nvme_ctrlr = nvme_qpair->ctrlr;
-
-	spdk_nvme_ctrlr_get_default_io_qpair_opts(nvme_ctrlr->ctrlr, &opts, sizeof(opts));
-	opts.delay_cmd_submit = g_opts.delay_cmd_submit;
-	opts.create_only = true;
-	opts.async_mode = true;
-	opts.io_queue_requests = spdk_max(g_opts.io_queue_requests, opts.io_queue_requests);
-	g_opts.io_queue_requests = opts.io_queue_requests;
-
-	qpair = spdk_nvme_ctrlr_alloc_io_qpair(nvme_ctrlr->ctrlr, &opts, sizeof(opts));
+	qpair = spdk_nvme_ctrlr_alloc_io_qpair(nvme_ctrlr->ctrlr, opts, sizeof(*opts));
 	if (qpair == NULL) {
 		return -1;
 	}
@@ -1690,11 +2200,7 @@ bdev_nvme_create_qpair(struct nvme_qpair *nvme_qpair)
 		goto err;
 	}
 
-	nvme_qpair->qpair = qpair;
-
-	if (!g_opts.disable_auto_failback) {
-		_bdev_nvme_clear_io_path_cache(nvme_qpair);
-	}
+	*_qpair = qpair;
 
 	return 0;
 
@@ -1704,6 +2210,46 @@ err:
 	return rc;
 }
 
+static int
+bdev_nvme_create_qpair(struct nvme_qpair *nvme_qpair)
+{
+	struct nvme_ctrlr *nvme_ctrlr;
+	struct spdk_nvme_io_qpair_opts opts;
+	uint32_t i;
+	int rc;
+
+	nvme_ctrlr = nvme_qpair->ctrlr;
+
+	spdk_nvme_ctrlr_get_default_io_qpair_opts(nvme_ctrlr->ctrlr, &opts, sizeof(opts));
+	opts.delay_cmd_submit = g_opts.delay_cmd_submit;
+	opts.delay_cmd_submit_batch_size = g_opts.delay_cmd_submit_batch_size;
+	opts.create_only = true;
+	opts.async_mode = true;
+	opts.io_queue_requests = spdk_max(g_opts.io_queue_requests, opts.io_queue_requests);
+	g_opts.io_queue_requests = opts.io_queue_requests;
+
+	rc = bdev_nvme_connect_io_qpair(nvme_qpair, &opts, &nvme_qpair->qpair);
+	if (rc != 0) {
+		return rc;
+	}
+
+	/* The channel can do without the secondary qpairs, I/Os are spread across those created. */
+	for (i = 0; i < nvme_qpair->num_secondary_qpairs; i++) {
+		assert(nvme_qpair->secondary_qpairs[i] == NULL);
+		rc = bdev_nvme_connect_io_qpair(nvme_qpair, &opts, &nvme_qpair->secondary_qpairs[i]);
+		if (rc != 0) {
+			SPDK_WARNLOG("Unable to create secondary I/O qpair %" PRIu32 " of %s.\n", i,
+				     nvme_ctrlr->nbdev_ctrlr->name);
+		}
+	}
+
+	if (!g_opts.disable_auto_failback) {
+		_bdev_nvme_clear_io_path_cache(nvme_qpair);
+	}
+
+	return 0;
+}
+
 static void
 bdev_nvme_complete_pending_resets(struct spdk_io_channel_iter *i)
 {
@@ -1722,6 +2268,10 @@ bdev_nvme_complete_pending_resets(struct spdk_io_channel_iter *i)
 		__bdev_nvme_io_complete(bdev_io, status, NULL);
 	}
 
+	if (status == SPDK_BDEV_IO_STATUS_SUCCESS) {
+		_bdev_nvme_kick_retry_ios(ctrlr_ch->qpair);
+	}
+
 	spdk_for_each_channel_continue(i, 0);
 }
 
@@ -1986,14 +2536,9 @@ bdev_nvme_reset_destroy_qpair(struct spdk_io_channel_iter *i)
 
 	_bdev_nvme_clear_io_path_cache(nvme_qpair);
 
-	if (nvme_qpair->qpair != NULL) {
-		if (nvme_qpair->ctrlr->dont_retry) {
-			spdk_nvme_qpair_set_abort_dnr(nvme_qpair->qpair, true);
-		}
-		spdk_nvme_ctrlr_disconnect_io_qpair(nvme_qpair->qpair);
-
+	if (nvme_qpair_disconnect(nvme_qpair, nvme_qpair->ctrlr->dont_retry)) {
 		/* The current full reset sequence will move to the next
-		 * ctrlr_channel after the qpair is actually disconnected.
+		 * ctrlr_channel after the qpairs are actually disconnected.
 		 */
 		assert(ctrlr_ch->reset_iter == NULL);
 		ctrlr_ch->reset_iter = i;
@@ -2563,8 +3108,23 @@ bdev_nvme_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 		 * Simply fall through even if it is not found.
 		 */
 	}
-
-	_bdev_nvme_submit_request(nbdev_ch, bdev_io);
+
+	_bdev_nvme_submit_request(nbdev_ch, bdev_io);
+}
+
+static void
+bdev_nvme_submit_request_batch(struct spdk_io_channel *ch, struct spdk_bdev_io **bdev_ios,
+			       uint32_t count)
+{
+	uint32_t i;
+
+	/* The commands are only queued to the qpairs here. With delay_cmd_submit, which is
+	 * the default, the controller is notified of all of them at once when the qpairs
+	 * are polled.
+	 */
+	for (i = 0; i < count; i++) {
+		bdev_nvme_submit_request(ch, bdev_ios[i]);
+	}
 }
 
 static bool
@@ -2646,9 +3206,22 @@ nvme_qpair_create(struct nvme_ctrlr *nvme_ctrlr, struct nvme_ctrlr_channel *ctrl
 
 	nvme_qpair->ctrlr = nvme_ctrlr;
 	nvme_qpair->ctrlr_ch = ctrlr_ch;
+	nvme_qpair->retry_tokens = BDEV_NVME_RETRY_TOKENS_MAX;
+
+	if (g_opts.io_qpairs_per_ctrlr > 1) {
+		nvme_qpair->num_secondary_qpairs = g_opts.io_qpairs_per_ctrlr - 1;
+		nvme_qpair->secondary_qpairs = calloc(nvme_qpair->num_secondary_qpairs,
+						      sizeof(*nvme_qpair->secondary_qpairs));
+		if (!nvme_qpair->secondary_qpairs) {
+			SPDK_ERRLOG("Failed to alloc secondary qpairs.\n");
+			free(nvme_qpair);
+			return -1;
+		}
+	}
 
 	pg_ch = spdk_get_io_channel(&g_nvme_bdev_ctrlrs);
 	if (!pg_ch) {
+		free(nvme_qpair->secondary_qpairs);
 		free(nvme_qpair);
 		return -1;
 	}
@@ -2673,6 +3246,7 @@ nvme_qpair_create(struct nvme_ctrlr *nvme_ctrlr, struct nvme_ctrlr_channel *ctrl
 		 */
 		if (nvme_ctrlr->opts.reconnect_delay_sec == 0 || g_opts.bdev_retry_count == 0) {
 			spdk_put_io_channel(pg_ch);
+			free(nvme_qpair->secondary_qpairs);
 			free(nvme_qpair);
 			return rc;
 		}
@@ -2718,6 +3292,7 @@ nvme_qpair_delete(struct nvme_qpair *nvme_qpair)
 
 	nvme_ctrlr_release(nvme_qpair->ctrlr);
 
+	free(nvme_qpair->secondary_qpairs);
 	free(nvme_qpair);
 }
 
@@ -2732,13 +3307,10 @@ bdev_nvme_destroy_ctrlr_channel_cb(void *io_device, void *ctx_buf)
 
 	_bdev_nvme_clear_io_path_cache(nvme_qpair);
 
-	if (nvme_qpair->qpair != NULL) {
-		if (ctrlr_ch->reset_iter == NULL) {
-			spdk_nvme_ctrlr_disconnect_io_qpair(nvme_qpair->qpair);
-		} else {
+	if (nvme_qpair_disconnect(nvme_qpair, false)) {
+		if (ctrlr_ch->reset_iter != NULL) {
 			/* Skip current ctrlr_channel in a full reset sequence because
-			 * it is being deleted now. The qpair is already being disconnected.
-			 * We do not have to restart disconnecting it.
+			 * it is being deleted now. The qpairs were already being disconnected.
 			 */
 			spdk_for_each_channel_continue(ctrlr_ch->reset_iter, 0);
 		}
@@ -2804,6 +3376,7 @@ bdev_nvme_create_poll_group_cb(void *io_device, void *ctx_buf)
 	}
 
 	group->poller = SPDK_POLLER_REGISTER(bdev_nvme_poll, group, g_opts.nvme_ioq_poll_period_us);
+	group->poll_period_us = g_opts.nvme_ioq_poll_period_us;
 
 	if (group->poller == NULL) {
 		spdk_nvme_poll_group_destroy(group->group);
@@ -3227,6 +3800,7 @@ static const struct spdk_bdev_fn_table nvmelib_fn_table = {
 	.get_memory_domains	= bdev_nvme_get_memory_domains,
 	.reset_device_stat	= bdev_nvme_reset_device_stat,
 	.dump_device_stat_json	= bdev_nvme_dump_device_stat_json,
+	.submit_request_batch	= bdev_nvme_submit_request_batch,
 };
 
 typedef int (*bdev_nvme_parse_ana_log_page_cb)(
@@ -3364,7 +3938,9 @@ nvme_disk_create(struct spdk_bdev *disk, const char *base_name,
 	const struct spdk_nvme_ns_data	*nsdata;
 	const struct spdk_nvme_ctrlr_opts *opts;
 	enum spdk_nvme_csi		csi;
+	struct spdk_pci_device		*pci_dev;
 	uint32_t atomic_bs, phys_bs, bs;
+	int socket_id;
 	char sn_tmp[SPDK_NVME_CTRLR_SN_LEN + 1] = {'\0'};
 
 	cdata = spdk_nvme_ctrlr_get_data(ctrlr);
@@ -3416,6 +3992,15 @@ nvme_disk_create(struct spdk_bdev *disk, const char *base_name,
 	}
 	disk->optimal_io_boundary = spdk_nvme_ns_get_optimal_io_boundary(ns);
 
+	pci_dev = spdk_nvme_ctrlr_get_pci_device(ctrlr);
+	if (pci_dev != NULL) {
+		socket_id = spdk_pci_device_get_socket_id(pci_dev);
+		if (socket_id >= 0) {
+			disk->numa.id = socket_id;
+			disk->numa.id_valid = 1;
+		}
+	}
+
 	nguid = spdk_nvme_ns_get_nguid(ns);
 	if (!nguid) {
 		uuid = spdk_nvme_ns_get_uuid(ns);
@@ -3440,8 +4025,8 @@ nvme_disk_create(struct spdk_bdev *disk, const char *base_name,
 			atomic_bs = bs * (1 + cdata->awupf);
 		}
 	}
-	if (nsdata->nsfeat.optperf) {
-		phys_bs = bs * (1 + nsdata->npwg);
+	if (spdk_nvme_ns_get_preferred_write_granularity(ns) != 0) {
+		phys_bs = bs * spdk_nvme_ns_get_preferred_write_granularity(ns);
 	}
 	disk->phys_blocklen = spdk_min(phys_bs, atomic_bs);
 
@@ -3465,8 +4050,13 @@ nvme_disk_create(struct spdk_bdev *disk, const char *base_name,
 	}
 
 	if (cdata->oncs.copy) {
-		/* For now bdev interface allows only single segment copy */
+		/* For now bdev interface allows only single segment copy, so a copy is bounded
+		 * by both the maximum single source range length and the maximum copy length.
+		 */
 		disk->max_copy = nsdata->mssrl;
+		if (nsdata->mcl != 0) {
+			disk->max_copy = spdk_min(disk->max_copy, nsdata->mcl);
+		}
 	}
 
 	disk->ctxt = ctx;
@@ -3583,6 +4173,7 @@ hotplug_probe_cb(void *cb_ctx, const struct spdk_nvme_transport_id *trid,
 	opts->medium_priority_weight = (uint8_t)g_opts.medium_priority_weight;
 	opts->high_priority_weight = (uint8_t)g_opts.high_priority_weight;
 	opts->disable_read_ana_log_page = true;
+	opts->align_write_splits = g_opts.align_write_splits;
 
 	SPDK_DEBUGLOG(bdev_nvme, "Attaching to %s\n", trid->traddr);
 
@@ -3664,6 +4255,132 @@ timeout_cb(void *cb_arg, struct spdk_nvme_ctrlr *ctrlr,
 	}
 }
 
+static void
+bdev_nvme_register_timeout_callback(struct nvme_ctrlr *nvme_ctrlr, uint64_t timeout_io_us)
+{
+	/* Timeout values for IO vs. admin reqs can be different. */
+	/* If timeout_admin_us is 0 (not specified), admin uses same timeout as IO. */
+	uint64_t adm_timeout_us = (g_opts.timeout_admin_us == 0) ?
+				  g_opts.timeout_us : g_opts.timeout_admin_us;
+
+	nvme_ctrlr->timeout_io_us = timeout_io_us;
+	spdk_nvme_ctrlr_register_timeout_callback(nvme_ctrlr->ctrlr, timeout_io_us,
+			adm_timeout_us, timeout_cb, nvme_ctrlr);
+}
+
+/* Return the I/O timeout derived from the p99 latency of the histogram, or 0 if there are
+ * not enough samples.
+ */
+static uint64_t
+bdev_nvme_get_adaptive_timeout_us(const uint64_t *buckets)
+{
+	uint64_t total = 0, ticks_hz, p99_ticks, p99_us;
+	int i;
+
+	for (i = 0; i < NVME_LATENCY_BUCKETS; i++) {
+		total += buckets[i];
+	}
+
+	if (total < BDEV_NVME_ADAPTIVE_TIMEOUT_MIN_SAMPLES) {
+		return 0;
+	}
+
+	p99_ticks = bdev_nvme_get_latency_percentile(buckets, total, 99);
+	ticks_hz = spdk_get_ticks_hz();
+	p99_us = p99_ticks / ticks_hz * SPDK_SEC_TO_USEC +
+		 p99_ticks % ticks_hz * SPDK_SEC_TO_USEC / ticks_hz;
+
+	if (p99_us >= g_opts.timeout_us / g_opts.adaptive_timeout_multiplier) {
+		return g_opts.timeout_us;
+	}
+
+	return spdk_min(spdk_max(p99_us * g_opts.adaptive_timeout_multiplier,
+				 BDEV_NVME_ADAPTIVE_TIMEOUT_MIN_US), g_opts.timeout_us);
+}
+
+static void
+bdev_nvme_update_adaptive_timeout_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct nvme_ctrlr *nvme_ctrlr = spdk_io_channel_iter_get_io_device(i);
+	uint64_t *buckets = spdk_io_channel_iter_get_ctx(i);
+	uint64_t timeout_us;
+	bool available;
+
+	timeout_us = bdev_nvme_get_adaptive_timeout_us(buckets);
+	free(buckets);
+
+	pthread_mutex_lock(&nvme_ctrlr->mutex);
+
+	assert(nvme_ctrlr->timeout_updating == true);
+	nvme_ctrlr->timeout_updating = false;
+
+	if (nvme_ctrlr_can_be_unregistered(nvme_ctrlr)) {
+		pthread_mutex_unlock(&nvme_ctrlr->mutex);
+
+		nvme_ctrlr_unregister(nvme_ctrlr);
+		return;
+	}
+
+	available = nvme_ctrlr_is_available(nvme_ctrlr);
+	pthread_mutex_unlock(&nvme_ctrlr->mutex);
+
+	if (available && timeout_us != 0 && timeout_us != nvme_ctrlr->timeout_io_us) {
+		SPDK_DEBUGLOG(bdev_nvme, "I/O timeout of %s changed from %" PRIu64 " to %" PRIu64
+			      " us\n", nvme_ctrlr->nbdev_ctrlr->name, nvme_ctrlr->timeout_io_us,
+			      timeout_us);
+		bdev_nvme_register_timeout_callback(nvme_ctrlr, timeout_us);
+	}
+}
+
+static void
+bdev_nvme_gather_qpair_latency(struct spdk_io_channel_iter *i)
+{
+	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i);
+	struct nvme_ctrlr_channel *ctrlr_ch = spdk_io_channel_get_ctx(_ch);
+	uint64_t *buckets = spdk_io_channel_iter_get_ctx(i);
+	struct nvme_qpair *nvme_qpair = ctrlr_ch->qpair;
+	int j;
+
+	assert(nvme_qpair != NULL);
+
+	for (j = 0; j < NVME_LATENCY_BUCKETS; j++) {
+		buckets[j] += nvme_qpair->latency_buckets[j];
+	}
+	memset(nvme_qpair->latency_buckets, 0, sizeof(nvme_qpair->latency_buckets));
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static int
+bdev_nvme_adaptive_timeout_poll(void *arg)
+{
+	struct nvme_ctrlr *nvme_ctrlr = arg;
+	uint64_t *buckets;
+
+	pthread_mutex_lock(&nvme_ctrlr->mutex);
+	if (!nvme_ctrlr_is_available(nvme_ctrlr) ||
+	    nvme_ctrlr->timeout_updating) {
+		pthread_mutex_unlock(&nvme_ctrlr->mutex);
+		return SPDK_POLLER_IDLE;
+	}
+
+	buckets = calloc(NVME_LATENCY_BUCKETS, sizeof(*buckets));
+	if (buckets == NULL) {
+		pthread_mutex_unlock(&nvme_ctrlr->mutex);
+		return SPDK_POLLER_IDLE;
+	}
+
+	nvme_ctrlr->timeout_updating = true;
+	pthread_mutex_unlock(&nvme_ctrlr->mutex);
+
+	spdk_for_each_channel(nvme_ctrlr,
+			      bdev_nvme_gather_qpair_latency,
+			      buckets,
+			      bdev_nvme_update_adaptive_timeout_done);
+
+	return SPDK_POLLER_BUSY;
+}
+
 static struct nvme_ns *
 nvme_ns_alloc(void)
 {
@@ -4344,12 +5061,19 @@ _bdev_nvme_set_multipath_policy(struct spdk_io_channel_iter *i)
 	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i);
 	struct nvme_bdev_channel *nbdev_ch = spdk_io_channel_get_ctx(_ch);
 	struct nvme_bdev *nbdev = spdk_io_channel_get_io_device(_ch);
+	struct nvme_io_path *io_path;
 
 	nbdev_ch->mp_policy = nbdev->mp_policy;
 	nbdev_ch->mp_selector = nbdev->mp_selector;
 	nbdev_ch->rr_min_io = nbdev->rr_min_io;
 	bdev_nvme_clear_current_io_path(nbdev_ch);
 
+	/* Latencies are only measured while the latency selector is used. */
+	STAILQ_FOREACH(io_path, &nbdev_ch->io_path_list, stailq) {
+		io_path->latency_ewma_ticks = 0;
+	}
+	nbdev_ch->latency_probe_counter = 0;
+
 	spdk_for_each_channel_continue(i, 0);
 }
 
@@ -4464,12 +5188,20 @@ static void
 nvme_ctrlr_create_done(struct nvme_ctrlr *nvme_ctrlr,
 		       struct nvme_async_probe_ctx *ctx)
 {
+	struct spdk_pci_device *pci_dev;
+
 	spdk_io_device_register(nvme_ctrlr,
 				bdev_nvme_create_ctrlr_channel_cb,
 				bdev_nvme_destroy_ctrlr_channel_cb,
 				sizeof(struct nvme_ctrlr_channel),
 				nvme_ctrlr->nbdev_ctrlr->name);
 
+	/* Let the schedulers keep threads doing I/O to local PCIe SSDs on the same socket. */
+	pci_dev = spdk_nvme_ctrlr_get_pci_device(nvme_ctrlr->ctrlr);
+	if (pci_dev != NULL) {
+		spdk_io_device_set_socket_id(nvme_ctrlr, spdk_pci_device_get_socket_id(pci_dev));
+	}
+
 	nvme_ctrlr_populate_namespaces(nvme_ctrlr, ctx);
 }
 
@@ -4682,12 +5414,13 @@ nvme_ctrlr_create(struct spdk_nvme_ctrlr *ctrlr,
 					  g_opts.nvme_adminq_poll_period_us);
 
 	if (g_opts.timeout_us > 0) {
-		/* Register timeout callback. Timeout values for IO vs. admin reqs can be different. */
-		/* If timeout_admin_us is 0 (not specified), admin uses same timeout as IO. */
-		uint64_t adm_timeout_us = (g_opts.timeout_admin_us == 0) ?
-					  g_opts.timeout_us : g_opts.timeout_admin_us;
-		spdk_nvme_ctrlr_register_timeout_callback(ctrlr, g_opts.timeout_us,
-				adm_timeout_us, timeout_cb, nvme_ctrlr);
+		bdev_nvme_register_timeout_callback(nvme_ctrlr, g_opts.timeout_us);
+
+		if (g_opts.adaptive_timeout_multiplier != 0) {
+			nvme_ctrlr->adaptive_timeout_poller = SPDK_POLLER_REGISTER(
+					bdev_nvme_adaptive_timeout_poll, nvme_ctrlr,
+					BDEV_NVME_ADAPTIVE_TIMEOUT_PERIOD_US);
+		}
 	}
 
 	spdk_nvme_ctrlr_register_aer_callback(ctrlr, aer_cb, nvme_ctrlr);
@@ -4872,6 +5605,53 @@ bdev_nvme_validate_opts(const struct spdk_bdev_nvme_opts *opts)
 		return -EINVAL;
 	}
 
+	if (opts->delay_cmd_submit_batch_size > UINT16_MAX) {
+		SPDK_WARNLOG("Invalid option: delay_cmd_submit_batch_size can't be more than %u.\n",
+			     UINT16_MAX);
+		return -EINVAL;
+	}
+
+	if (!opts->delay_cmd_submit && (opts->delay_cmd_submit_batch_size != 0)) {
+		SPDK_WARNLOG("Invalid options: Can't have (delay_cmd_submit == false) with "
+			     "(delay_cmd_submit_batch_size > 0)\n");
+		return -EINVAL;
+	}
+
+	if (opts->bdev_retry_budget_percent > 100) {
+		SPDK_WARNLOG("Invalid option: bdev_retry_budget_percent can't be more than 100.\n");
+		return -EINVAL;
+	}
+
+	if (opts->hedged_read_percentile >= 100) {
+		SPDK_WARNLOG("Invalid option: hedged_read_percentile has to be less than 100.\n");
+		return -EINVAL;
+	}
+
+	if (opts->nvme_ioq_adaptive_poll_max_us != 0) {
+		if (opts->nvme_ioq_adaptive_poll_max_us <= opts->nvme_ioq_poll_period_us) {
+			SPDK_WARNLOG("Invalid option: nvme_ioq_adaptive_poll_max_us has to be more than "
+				     "nvme_ioq_poll_period_us.\n");
+			return -EINVAL;
+		}
+		if (opts->nvme_ioq_adaptive_poll_batch == 0) {
+			SPDK_WARNLOG("Invalid option: nvme_ioq_adaptive_poll_batch can't be 0.\n");
+			return -EINVAL;
+		}
+	}
+
+	if (opts->io_qpairs_per_ctrlr == 0 ||
+	    opts->io_qpairs_per_ctrlr > BDEV_NVME_IO_QPAIRS_PER_CTRLR_MAX) {
+		SPDK_WARNLOG("Invalid option: io_qpairs_per_ctrlr has to be between 1 and %d.\n",
+			     BDEV_NVME_IO_QPAIRS_PER_CTRLR_MAX);
+		return -EINVAL;
+	}
+
+	if ((opts->timeout_us == 0) && (opts->adaptive_timeout_multiplier != 0)) {
+		SPDK_WARNLOG("Invalid options: Can't have (timeout_us == 0) with "
+			     "(adaptive_timeout_multiplier > 0)\n");
+		return -EINVAL;
+	}
+
 	if (!bdev_nvme_check_io_error_resiliency_params(opts->ctrlr_loss_timeout_sec,
 			opts->reconnect_delay_sec,
 			opts->fast_io_fail_timeout_sec)) {
@@ -4898,11 +5678,12 @@ bdev_nvme_set_opts(const struct spdk_bdev_nvme_opts *opts)
 		}
 	}
 
-	if (opts->rdma_srq_size != 0) {
+	if (opts->rdma_srq_size != 0 || opts->rdma_send_signal_interval != 0) {
 		struct spdk_nvme_transport_opts drv_opts;
 
 		spdk_nvme_transport_get_opts(&drv_opts, sizeof(drv_opts));
 		drv_opts.rdma_srq_size = opts->rdma_srq_size;
+		drv_opts.rdma_send_signal_interval = opts->rdma_send_signal_interval;
 
 		ret = spdk_nvme_transport_set_opts(&drv_opts, sizeof(drv_opts));
 		if (ret) {
@@ -5304,6 +6085,7 @@ bdev_nvme_create(struct spdk_nvme_transport_id *trid,
 	ctx->drv_opts.keep_alive_timeout_ms = g_opts.keep_alive_timeout_ms;
 	ctx->drv_opts.disable_read_ana_log_page = true;
 	ctx->drv_opts.transport_tos = g_opts.transport_tos;
+	ctx->drv_opts.align_write_splits = g_opts.align_write_splits;
 
 	if (nvme_bdev_ctrlr_get_by_name(base_name) == NULL || multipath) {
 		attach_cb = connect_attach_cb;
@@ -6262,6 +7044,214 @@ bdev_nvme_readv_done(void *ref, const struct spdk_nvme_cpl *cpl)
 	bdev_nvme_io_complete_nvme_status(bio, cpl);
 }
 
+static void
+bdev_nvme_hedged_read_abort_done(void *ref, const struct spdk_nvme_cpl *cpl)
+{
+	/* The aborted read completes on its own, nothing to do if it could not be aborted. */
+}
+
+static void
+bdev_nvme_hedged_read_complete(struct nvme_bdev_io *bio, struct nvme_hedged_read *hedged_read,
+			       const struct spdk_nvme_cpl *cpl)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+	struct nvme_bdev_channel *nbdev_ch;
+	struct nvme_hedged_read *other;
+	struct nvme_qpair *nvme_qpair;
+	uint8_t i;
+
+	if (bio->hedge_queued) {
+		nbdev_ch = spdk_io_channel_get_ctx(spdk_bdev_io_get_io_channel(bdev_io));
+		TAILQ_REMOVE(&nbdev_ch->hedge_list, bio, hedge_link);
+		bio->hedge_queued = false;
+	}
+
+	/* The other reads only own their bounce buffers, they are freed when they complete. */
+	for (i = 0; i < bio->num_hedged_reads; i++) {
+		other = bio->hedged_reads[i];
+		other->bio = NULL;
+
+		nvme_qpair = other->io_path->qpair;
+		if (nvme_qpair->qpair != NULL) {
+			spdk_nvme_ctrlr_cmd_abort_ext(nvme_qpair->ctrlr->ctrlr,
+						      nvme_qpair->qpair, other,
+						      bdev_nvme_hedged_read_abort_done, NULL);
+		}
+	}
+	bio->num_hedged_reads = 0;
+
+	bio->io_path = hedged_read->io_path;
+
+	if (spdk_nvme_cpl_is_success(cpl)) {
+		spdk_copy_buf_to_iovs(bio->iovs, bio->iovcnt, hedged_read->buf, hedged_read->len);
+	}
+
+	bdev_nvme_readv_done(bio, cpl);
+}
+
+static void
+bdev_nvme_hedged_read_done(void *ref, const struct spdk_nvme_cpl *cpl)
+{
+	struct nvme_hedged_read *hedged_read = ref;
+	struct nvme_bdev_io *bio = hedged_read->bio;
+	uint8_t i;
+
+	if (bio != NULL) {
+		for (i = 0; i < bio->num_hedged_reads; i++) {
+			if (bio->hedged_reads[i] == hedged_read) {
+				bio->hedged_reads[i] = bio->hedged_reads[--bio->num_hedged_reads];
+				break;
+			}
+		}
+
+		/* A failed read waits for the other one, if any. */
+		if (spdk_nvme_cpl_is_success(cpl) || bio->num_hedged_reads == 0) {
+			bdev_nvme_hedged_read_complete(bio, hedged_read, cpl);
+		}
+	}
+
+	spdk_dma_free(hedged_read->buf);
+	free(hedged_read);
+}
+
+static int
+bdev_nvme_hedged_read_submit(struct nvme_bdev_io *bio, struct nvme_io_path *io_path)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+	struct spdk_bdev *bdev = bdev_io->bdev;
+	struct nvme_hedged_read *hedged_read;
+	int rc;
+
+	hedged_read = calloc(1, sizeof(*hedged_read));
+	if (hedged_read == NULL) {
+		return -ENOMEM;
+	}
+
+	hedged_read->len = bdev_io->u.bdev.num_blocks * bdev->blocklen;
+	hedged_read->buf = spdk_dma_malloc(hedged_read->len, spdk_bdev_get_buf_align(bdev), NULL);
+	if (hedged_read->buf == NULL) {
+		free(hedged_read);
+		return -ENOMEM;
+	}
+
+	hedged_read->bio = bio;
+	hedged_read->io_path = io_path;
+
+	rc = spdk_nvme_ns_cmd_read_with_md(io_path->nvme_ns->ns, io_path->qpair->qpair,
+					   hedged_read->buf, NULL,
+					   bdev_io->u.bdev.offset_blocks,
+					   bdev_io->u.bdev.num_blocks,
+					   bdev_nvme_hedged_read_done, hedged_read,
+					   bdev->dif_check_flags, 0, 0);
+	if (rc != 0) {
+		spdk_dma_free(hedged_read->buf);
+		free(hedged_read);
+		return rc;
+	}
+
+	bio->hedged_reads[bio->num_hedged_reads++] = hedged_read;
+
+	return 0;
+}
+
+/* Reads are hedged only in active-active mode with more than one path, once enough reads
+ * completed to know the threshold. Hedged reads go through bounce buffers, so that the
+ * read which loses the race cannot write into the buffer of a completed I/O.
+ */
+static bool
+bdev_nvme_read_is_hedged(struct nvme_bdev_io *bio, void *md, struct spdk_memory_domain *domain)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+	struct nvme_bdev_channel *nbdev_ch;
+
+	if (spdk_likely(g_opts.hedged_read_percentile == 0)) {
+		return false;
+	}
+
+	if (bdev_io->type != SPDK_BDEV_IO_TYPE_READ || md != NULL || domain != NULL ||
+	    bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen > BDEV_NVME_HEDGE_MAX_SIZE) {
+		return false;
+	}
+
+	nbdev_ch = spdk_io_channel_get_ctx(spdk_bdev_io_get_io_channel(bdev_io));
+
+	return nbdev_ch->hedge_threshold_ticks != 0 &&
+	       nbdev_ch->mp_policy == BDEV_NVME_MP_POLICY_ACTIVE_ACTIVE &&
+	       STAILQ_NEXT(STAILQ_FIRST(&nbdev_ch->io_path_list), stailq) != NULL;
+}
+
+static int
+bdev_nvme_hedged_readv(struct nvme_bdev_io *bio)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(bio);
+	struct nvme_bdev_channel *nbdev_ch;
+	int rc;
+
+	rc = bdev_nvme_hedged_read_submit(bio, bio->io_path);
+	if (rc != 0) {
+		return rc;
+	}
+
+	nbdev_ch = spdk_io_channel_get_ctx(spdk_bdev_io_get_io_channel(bdev_io));
+
+	bio->hedge_deadline_tsc = spdk_get_ticks() + nbdev_ch->hedge_threshold_ticks;
+	bio->hedge_queued = true;
+	TAILQ_INSERT_TAIL(&nbdev_ch->hedge_list, bio, hedge_link);
+
+	return 0;
+}
+
+static struct nvme_io_path *
+bdev_nvme_find_hedge_io_path(struct nvme_bdev_channel *nbdev_ch, struct nvme_io_path *busy)
+{
+	struct nvme_io_path *io_path, *non_optimized = NULL;
+
+	STAILQ_FOREACH(io_path, &nbdev_ch->io_path_list, stailq) {
+		if (io_path == busy || !nvme_io_path_is_available(io_path)) {
+			continue;
+		}
+
+		if (io_path->nvme_ns->ana_state == SPDK_NVME_ANA_OPTIMIZED_STATE) {
+			return io_path;
+		}
+
+		if (non_optimized == NULL) {
+			non_optimized = io_path;
+		}
+	}
+
+	return non_optimized;
+}
+
+static int
+bdev_nvme_hedge_poll(void *arg)
+{
+	struct nvme_bdev_channel *nbdev_ch = arg;
+	struct nvme_bdev_io *bio, *tmp;
+	struct nvme_io_path *io_path;
+	uint64_t now;
+	int count = 0;
+
+	now = spdk_get_ticks();
+
+	TAILQ_FOREACH_SAFE(bio, &nbdev_ch->hedge_list, hedge_link, tmp) {
+		if (bio->hedge_deadline_tsc > now) {
+			break;
+		}
+
+		TAILQ_REMOVE(&nbdev_ch->hedge_list, bio, hedge_link);
+		bio->hedge_queued = false;
+
+		assert(bio->num_hedged_reads == 1);
+		io_path = bdev_nvme_find_hedge_io_path(nbdev_ch, bio->hedged_reads[0]->io_path);
+		if (io_path != NULL && bdev_nvme_hedged_read_submit(bio, io_path) == 0) {
+			count++;
+		}
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
 static void
 bdev_nvme_writev_done(void *ref, const struct spdk_nvme_cpl *cpl)
 {
@@ -6629,7 +7619,7 @@ bdev_nvme_no_pi_readv(struct nvme_bdev_io *bio, struct iovec *iov, int iovcnt,
 	bio->iov_offset = 0;
 
 	rc = spdk_nvme_ns_cmd_readv_with_md(bio->io_path->nvme_ns->ns,
-					    bio->io_path->qpair->qpair,
+					    nvme_qpair_get_io_qpair(bio->io_path->qpair),
 					    lba, lba_count,
 					    bdev_nvme_no_pi_readv_done, bio, 0,
 					    bdev_nvme_queued_reset_sgl, bdev_nvme_queued_next_sge,
@@ -6647,7 +7637,7 @@ bdev_nvme_readv(struct nvme_bdev_io *bio, struct iovec *iov, int iovcnt,
 		struct spdk_memory_domain *domain, void *domain_ctx)
 {
 	struct spdk_nvme_ns *ns = bio->io_path->nvme_ns->ns;
-	struct spdk_nvme_qpair *qpair = bio->io_path->qpair->qpair;
+	struct spdk_nvme_qpair *qpair = nvme_qpair_get_io_qpair(bio->io_path->qpair);
 	int rc;
 
 	SPDK_DEBUGLOG(bdev_nvme, "read %" PRIu64 " blocks with offset %#" PRIx64 "\n",
@@ -6658,7 +7648,9 @@ bdev_nvme_readv(struct nvme_bdev_io *bio, struct iovec *iov, int iovcnt,
 	bio->iovpos = 0;
 	bio->iov_offset = 0;
 
-	if (domain != NULL) {
+	if (bdev_nvme_read_is_hedged(bio, md, domain)) {
+		rc = bdev_nvme_hedged_readv(bio);
+	} else if (domain != NULL) {
 		bio->ext_opts.size = sizeof(struct spdk_nvme_ns_cmd_ext_io_opts);
 		bio->ext_opts.memory_domain = domain;
 		bio->ext_opts.memory_domain_ctx = domain_ctx;
@@ -6693,7 +7685,7 @@ bdev_nvme_writev(struct nvme_bdev_io *bio, struct iovec *iov, int iovcnt,
 		 struct spdk_memory_domain *domain, void *domain_ctx)
 {
 	struct spdk_nvme_ns *ns = bio->io_path->nvme_ns->ns;
-	struct spdk_nvme_qpair *qpair = bio->io_path->qpair->qpair;
+	struct spdk_nvme_qpair *qpair = nvme_qpair_get_io_qpair(bio->io_path->qpair);
 	int rc;
 
 	SPDK_DEBUGLOG(bdev_nvme, "write %" PRIu64 " blocks with offset %#" PRIx64 "\n",
@@ -6785,7 +7777,7 @@ bdev_nvme_comparev(struct nvme_bdev_io *bio, struct iovec *iov, int iovcnt,
 	bio->iov_offset = 0;
 
 	rc = spdk_nvme_ns_cmd_comparev_with_md(bio->io_path->nvme_ns->ns,
-					       bio->io_path->qpair->qpair,
+					       nvme_qpair_get_io_qpair(bio->io_path->qpair),
 					       lba, lba_count,
 					       bdev_nvme_comparev_done, bio, flags,
 					       bdev_nvme_queued_reset_sgl, bdev_nvme_queued_next_sge,
@@ -6894,7 +7886,7 @@ bdev_nvme_unmap(struct nvme_bdev_io *bio, uint64_t offset_blocks, uint64_t num_b
 	range->starting_lba = offset;
 
 	rc = spdk_nvme_ns_cmd_dataset_management(bio->io_path->nvme_ns->ns,
-			bio->io_path->qpair->qpair,
+			nvme_qpair_get_io_qpair(bio->io_path->qpair),
 			SPDK_NVME_DSM_ATTR_DEALLOCATE,
 			dsm_ranges, num_ranges,
 			bdev_nvme_queued_done, bio);
@@ -6911,7 +7903,7 @@ bdev_nvme_write_zeroes(struct nvme_bdev_io *bio, uint64_t offset_blocks, uint64_
 	}
 
 	return spdk_nvme_ns_cmd_write_zeroes(bio->io_path->nvme_ns->ns,
-					     bio->io_path->qpair->qpair,
+					     nvme_qpair_get_io_qpair(bio->io_path->qpair),
 					     offset_blocks, num_blocks,
 					     bdev_nvme_queued_done, bio,
 					     0);
@@ -7023,7 +8015,7 @@ bdev_nvme_io_passthru(struct nvme_bdev_io *bio, struct spdk_nvme_cmd *cmd,
 		      void *buf, size_t nbytes)
 {
 	struct spdk_nvme_ns *ns = bio->io_path->nvme_ns->ns;
-	struct spdk_nvme_qpair *qpair = bio->io_path->qpair->qpair;
+	struct spdk_nvme_qpair *qpair = nvme_qpair_get_io_qpair(bio->io_path->qpair);
 	uint32_t max_xfer_size = spdk_nvme_ns_get_max_io_xfer_size(ns);
 	struct spdk_nvme_ctrlr *ctrlr = spdk_nvme_ns_get_ctrlr(ns);
 
@@ -7047,7 +8039,7 @@ bdev_nvme_io_passthru_md(struct nvme_bdev_io *bio, struct spdk_nvme_cmd *cmd,
 			 void *buf, size_t nbytes, void *md_buf, size_t md_len)
 {
 	struct spdk_nvme_ns *ns = bio->io_path->nvme_ns->ns;
-	struct spdk_nvme_qpair *qpair = bio->io_path->qpair->qpair;
+	struct spdk_nvme_qpair *qpair = nvme_qpair_get_io_qpair(bio->io_path->qpair);
 	size_t nr_sectors = nbytes / spdk_nvme_ns_get_extended_sector_size(ns);
 	uint32_t max_xfer_size = spdk_nvme_ns_get_max_io_xfer_size(ns);
 	struct spdk_nvme_ctrlr *ctrlr = spdk_nvme_ns_get_ctrlr(ns);
@@ -7072,6 +8064,29 @@ bdev_nvme_io_passthru_md(struct nvme_bdev_io *bio, struct spdk_nvme_cmd *cmd,
 			(uint32_t)nbytes, md_buf, bdev_nvme_queued_done, bio);
 }
 
+/* The command may have been submitted to any of the qpairs of the nvme_qpair. */
+static int
+nvme_qpair_abort_cmd(struct nvme_qpair *nvme_qpair, void *cmd_cb_arg,
+		     spdk_nvme_cmd_cb cb_fn, void *cb_arg)
+{
+	struct spdk_nvme_qpair *qpair;
+	uint32_t i;
+	int rc;
+
+	rc = spdk_nvme_ctrlr_cmd_abort_ext(nvme_qpair->ctrlr->ctrlr, nvme_qpair->qpair,
+					   cmd_cb_arg, cb_fn, cb_arg);
+
+	for (i = 0; rc == -ENOENT && i < nvme_qpair->num_secondary_qpairs; i++) {
+		qpair = nvme_qpair->secondary_qpairs[i];
+		if (qpair != NULL) {
+			rc = spdk_nvme_ctrlr_cmd_abort_ext(nvme_qpair->ctrlr->ctrlr, qpair,
+							   cmd_cb_arg, cb_fn, cb_arg);
+		}
+	}
+
+	return rc;
+}
+
 static void
 bdev_nvme_abort(struct nvme_bdev_channel *nbdev_ch, struct nvme_bdev_io *bio,
 		struct nvme_bdev_io *bio_to_abort)
@@ -7098,10 +8113,7 @@ bdev_nvme_abort(struct nvme_bdev_channel *nbdev_ch, struct nvme_bdev_io *bio,
 	STAILQ_FOREACH(io_path, &nbdev_ch->io_path_list, stailq) {
 		nvme_ctrlr = io_path->qpair->ctrlr;
 
-		rc = spdk_nvme_ctrlr_cmd_abort_ext(nvme_ctrlr->ctrlr,
-						   io_path->qpair->qpair,
-						   bio_to_abort,
-						   bdev_nvme_abort_done, bio);
+		rc = nvme_qpair_abort_cmd(io_path->qpair, bio_to_abort, bdev_nvme_abort_done, bio);
 		if (rc == -ENOENT) {
 			/* If no command was found in I/O qpair, the target command may be
 			 * admin command.
@@ -7135,7 +8147,7 @@ bdev_nvme_copy(struct nvme_bdev_io *bio, uint64_t dst_offset_blocks, uint64_t sr
 	};
 
 	return spdk_nvme_ns_cmd_copy(bio->io_path->nvme_ns->ns,
-				     bio->io_path->qpair->qpair,
+				     nvme_qpair_get_io_qpair(bio->io_path->qpair),
 				     &range, 1, dst_offset_blocks,
 				     bdev_nvme_queued_done, bio);
 }
@@ -7171,6 +8183,8 @@ bdev_nvme_opts_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_named_uint64(w, "nvme_ioq_poll_period_us", g_opts.nvme_ioq_poll_period_us);
 	spdk_json_write_named_uint32(w, "io_queue_requests", g_opts.io_queue_requests);
 	spdk_json_write_named_bool(w, "delay_cmd_submit", g_opts.delay_cmd_submit);
+	spdk_json_write_named_uint32(w, "delay_cmd_submit_batch_size",
+				     g_opts.delay_cmd_submit_batch_size);
 	spdk_json_write_named_int32(w, "bdev_retry_count", g_opts.bdev_retry_count);
 	spdk_json_write_named_uint8(w, "transport_ack_timeout", g_opts.transport_ack_timeout);
 	spdk_json_write_named_int32(w, "ctrlr_loss_timeout_sec", g_opts.ctrlr_loss_timeout_sec);
@@ -7179,6 +8193,19 @@ bdev_nvme_opts_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_named_bool(w, "generate_uuids", g_opts.generate_uuids);
 	spdk_json_write_named_uint8(w, "transport_tos", g_opts.transport_tos);
 	spdk_json_write_named_bool(w, "io_path_stat", g_opts.io_path_stat);
+	spdk_json_write_named_uint32(w, "bdev_retry_budget_percent",
+				     g_opts.bdev_retry_budget_percent);
+	spdk_json_write_named_uint32(w, "adaptive_timeout_multiplier",
+				     g_opts.adaptive_timeout_multiplier);
+	spdk_json_write_named_uint32(w, "hedged_read_percentile", g_opts.hedged_read_percentile);
+	spdk_json_write_named_uint64(w, "nvme_ioq_adaptive_poll_max_us",
+				     g_opts.nvme_ioq_adaptive_poll_max_us);
+	spdk_json_write_named_uint32(w, "nvme_ioq_adaptive_poll_batch",
+				     g_opts.nvme_ioq_adaptive_poll_batch);
+	spdk_json_write_named_uint32(w, "rdma_send_signal_interval",
+				     g_opts.rdma_send_signal_interval);
+	spdk_json_write_named_bool(w, "align_write_splits", g_opts.align_write_splits);
+	spdk_json_write_named_uint32(w, "io_qpairs_per_ctrlr", g_opts.io_qpairs_per_ctrlr);
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
@@ -7247,6 +8274,9 @@ nvme_ctrlr_config_json(struct spdk_json_write_ctx *w,
 	opts = spdk_nvme_ctrlr_get_opts(nvme_ctrlr->ctrlr);
 	spdk_json_write_named_bool(w, "hdgst", opts->header_digest);
 	spdk_json_write_named_bool(w, "ddgst", opts->data_digest);
+	if (trid->trtype == SPDK_NVME_TRANSPORT_PCIE) {
+		spdk_json_write_named_bool(w, "use_cmb_sqs", opts->use_cmb_sqs);
+	}
 
 	spdk_json_write_object_end(w);
 
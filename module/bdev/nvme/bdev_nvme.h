@@ -31,6 +31,7 @@ enum bdev_nvme_multipath_policy {
 enum bdev_nvme_multipath_selector {
 	BDEV_NVME_MP_SELECTOR_ROUND_ROBIN = 1,
 	BDEV_NVME_MP_SELECTOR_QUEUE_DEPTH,
+	BDEV_NVME_MP_SELECTOR_LATENCY,
 };
 
 typedef void (*spdk_bdev_create_nvme_fn)(void *ctx, size_t bdev_count, int rc);
@@ -116,6 +117,7 @@ struct nvme_ctrlr {
 	uint32_t				ana_log_page_updating : 1;
 	uint32_t				io_path_cache_clearing : 1;
 	uint32_t				dont_retry : 1;
+	uint32_t				timeout_updating : 1;
 
 	struct nvme_ctrlr_opts			opts;
 
@@ -135,6 +137,12 @@ struct nvme_ctrlr {
 	uint64_t				reset_start_tsc;
 	struct spdk_poller			*reconnect_delay_timer;
 
+	/* I/O timeout currently used, adjusted to the observed latency if
+	 * adaptive_timeout_multiplier is set.
+	 */
+	uint64_t				timeout_io_us;
+	struct spdk_poller			*adaptive_timeout_poller;
+
 	nvme_ctrlr_disconnected_cb		disconnected_cb;
 
 	/** linked list pointer for device list */
@@ -179,15 +187,33 @@ struct nvme_bdev {
 	struct nvme_error_stat		*err_stat;
 };
 
+/* Latency histograms count the samples per power of two of ticks. */
+#define NVME_LATENCY_BUCKETS	64
+
 struct nvme_qpair {
 	struct nvme_ctrlr		*ctrlr;
 	struct spdk_nvme_qpair		*qpair;
 	struct nvme_poll_group		*group;
 	struct nvme_ctrlr_channel	*ctrlr_ch;
 
+	/* Additional qpairs I/Os are spread across, see io_qpairs_per_ctrlr. They are connected
+	 * and disconnected along with qpair, and the nvme_qpair is disconnected only once all of
+	 * them are.
+	 */
+	struct spdk_nvme_qpair		**secondary_qpairs;
+	uint32_t			num_secondary_qpairs;
+
 	/* The following is used to update io_path cache of nvme_bdev_channels. */
 	TAILQ_HEAD(, nvme_io_path)	io_path_list;
 
+	/* Retries allowed on this qpair, in hundredths. Refilled by successful I/Os
+	 * if bdev_retry_budget_percent is set.
+	 */
+	uint32_t			retry_tokens;
+
+	/* Completion latencies since the last adaptive timeout update. */
+	uint64_t			latency_buckets[NVME_LATENCY_BUCKETS];
+
 	TAILQ_ENTRY(nvme_qpair)		tailq;
 };
 
@@ -209,6 +235,14 @@ struct nvme_io_path {
 
 	/* allocation of stat is decided by option io_path_stat of RPC bdev_nvme_set_options */
 	struct spdk_bdev_io_stat	*stat;
+
+	/* Moving average of the completion latency, used by the latency selector. */
+	uint64_t			latency_ewma_ticks;
+
+	/* The local device used by this path is on the NUMA node of the channel's thread,
+	 * or either of them is unknown. Active-active selectors prefer such paths.
+	 */
+	bool				numa_local;
 };
 
 struct nvme_bdev_channel {
@@ -217,9 +251,17 @@ struct nvme_bdev_channel {
 	enum bdev_nvme_multipath_selector	mp_selector;
 	uint32_t				rr_min_io;
 	uint32_t				rr_counter;
+	uint32_t				latency_probe_counter;
 	STAILQ_HEAD(, nvme_io_path)		io_path_list;
 	TAILQ_HEAD(retry_io_head, spdk_bdev_io)	retry_io_list;
 	struct spdk_poller			*retry_io_poller;
+
+	/* Reads which get a duplicate on another path if they don't complete in time. */
+	TAILQ_HEAD(, nvme_bdev_io)		hedge_list;
+	struct spdk_poller			*hedge_poller;
+	uint64_t				hedge_threshold_ticks;
+	uint32_t				hedge_sample_count;
+	uint64_t				read_latency_buckets[NVME_LATENCY_BUCKETS];
 };
 
 struct nvme_poll_group {
@@ -230,6 +272,12 @@ struct nvme_poll_group {
 	uint64_t				spin_ticks;
 	uint64_t				start_ticks;
 	uint64_t				end_ticks;
+	/* Current period of the poller and the completions seen in the current window,
+	 * for the adaptive I/O poll period.
+	 */
+	uint64_t				poll_period_us;
+	uint64_t				window_start_tsc;
+	uint64_t				window_completions;
 	TAILQ_HEAD(, nvme_qpair)		qpair_list;
 };
 
@@ -273,6 +321,8 @@ struct spdk_bdev_nvme_opts {
 	uint64_t nvme_ioq_poll_period_us;
 	uint32_t io_queue_requests;
 	bool delay_cmd_submit;
+	/* The number of delayed commands after which the doorbell is rung, 0 for no limit. */
+	uint32_t delay_cmd_submit_batch_size;
 	/* The number of attempts per I/O in the bdev layer before an I/O fails. */
 	int32_t bdev_retry_count;
 	uint8_t transport_ack_timeout;
@@ -286,6 +336,27 @@ struct spdk_bdev_nvme_opts {
 	bool nvme_error_stat;
 	uint32_t rdma_srq_size;
 	bool io_path_stat;
+	/* Percentage of successful I/Os that may be retried on the same path, 0 for no limit. */
+	uint32_t bdev_retry_budget_percent;
+	/* If non-zero, the I/O timeout of each controller is its p99 latency times this value,
+	 * and timeout_us is the upper bound.
+	 */
+	uint32_t adaptive_timeout_multiplier;
+	/* If non-zero, a read which is slower than this percentile of the reads on the
+	 * channel is duplicated on another path, in active-active mode.
+	 */
+	uint32_t hedged_read_percentile;
+	/* If non-zero, the I/O poll period of each poll group is stretched up to this value
+	 * under low load, to reap about nvme_ioq_adaptive_poll_batch completions per poll.
+	 */
+	uint64_t nvme_ioq_adaptive_poll_max_us;
+	uint32_t nvme_ioq_adaptive_poll_batch;
+	/* RDMA only: signal one out of this many sends of a qpair, 0 or 1 to signal all of them */
+	uint32_t rdma_send_signal_interval;
+	/* Align the splits of writes to the optimal write size or write granularity of namespaces */
+	bool align_write_splits;
+	/* Number of I/O qpairs each I/O channel creates for each controller */
+	uint32_t io_qpairs_per_ctrlr;
 };
 
 struct spdk_nvme_qpair *bdev_nvme_get_io_qpair(struct spdk_io_channel *ctrlr_io_ch);
@@ -367,7 +438,7 @@ typedef void (*bdev_nvme_set_multipath_policy_cb)(void *cb_arg, int rc);
  *
  * \param name NVMe bdev name
  * \param policy Multipath policy (active-passive or active-active)
- * \param selector Multipath selector (round_robin, queue_depth)
+ * \param selector Multipath selector (round_robin, queue_depth, latency)
  * \param rr_min_io Number of IO to route to a path before switching to another for round-robin
  * \param cb_fn Function to be called back after completion.
  */
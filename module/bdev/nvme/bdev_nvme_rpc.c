@@ -54,6 +54,7 @@ static const struct spdk_json_object_decoder rpc_bdev_nvme_options_decoders[] =
 	{"nvme_ioq_poll_period_us", offsetof(struct spdk_bdev_nvme_opts, nvme_ioq_poll_period_us), spdk_json_decode_uint64, true},
 	{"io_queue_requests", offsetof(struct spdk_bdev_nvme_opts, io_queue_requests), spdk_json_decode_uint32, true},
 	{"delay_cmd_submit", offsetof(struct spdk_bdev_nvme_opts, delay_cmd_submit), spdk_json_decode_bool, true},
+	{"delay_cmd_submit_batch_size", offsetof(struct spdk_bdev_nvme_opts, delay_cmd_submit_batch_size), spdk_json_decode_uint32, true},
 	{"transport_retry_count", offsetof(struct spdk_bdev_nvme_opts, transport_retry_count), spdk_json_decode_uint32, true},
 	{"bdev_retry_count", offsetof(struct spdk_bdev_nvme_opts, bdev_retry_count), spdk_json_decode_int32, true},
 	{"transport_ack_timeout", offsetof(struct spdk_bdev_nvme_opts, transport_ack_timeout), spdk_json_decode_uint8, true},
@@ -66,6 +67,14 @@ static const struct spdk_json_object_decoder rpc_bdev_nvme_options_decoders[] =
 	{"nvme_error_stat", offsetof(struct spdk_bdev_nvme_opts, nvme_error_stat), spdk_json_decode_bool, true},
 	{"rdma_srq_size", offsetof(struct spdk_bdev_nvme_opts, rdma_srq_size), spdk_json_decode_uint32, true},
 	{"io_path_stat", offsetof(struct spdk_bdev_nvme_opts, io_path_stat), spdk_json_decode_bool, true},
+	{"bdev_retry_budget_percent", offsetof(struct spdk_bdev_nvme_opts, bdev_retry_budget_percent), spdk_json_decode_uint32, true},
+	{"adaptive_timeout_multiplier", offsetof(struct spdk_bdev_nvme_opts, adaptive_timeout_multiplier), spdk_json_decode_uint32, true},
+	{"hedged_read_percentile", offsetof(struct spdk_bdev_nvme_opts, hedged_read_percentile), spdk_json_decode_uint32, true},
+	{"nvme_ioq_adaptive_poll_max_us", offsetof(struct spdk_bdev_nvme_opts, nvme_ioq_adaptive_poll_max_us), spdk_json_decode_uint64, true},
+	{"nvme_ioq_adaptive_poll_batch", offsetof(struct spdk_bdev_nvme_opts, nvme_ioq_adaptive_poll_batch), spdk_json_decode_uint32, true},
+	{"rdma_send_signal_interval", offsetof(struct spdk_bdev_nvme_opts, rdma_send_signal_interval), spdk_json_decode_uint32, true},
+	{"align_write_splits", offsetof(struct spdk_bdev_nvme_opts, align_write_splits), spdk_json_decode_bool, true},
+	{"io_qpairs_per_ctrlr", offsetof(struct spdk_bdev_nvme_opts, io_qpairs_per_ctrlr), spdk_json_decode_uint32, true},
 };
 
 static void
@@ -259,6 +268,7 @@ static const struct spdk_json_object_decoder rpc_bdev_nvme_attach_controller_dec
 	{"fast_io_fail_timeout_sec", offsetof(struct rpc_bdev_nvme_attach_controller, bdev_opts.fast_io_fail_timeout_sec), spdk_json_decode_uint32, true},
 	{"psk", offsetof(struct rpc_bdev_nvme_attach_controller, psk), spdk_json_decode_string, true},
 	{"max_bdevs", offsetof(struct rpc_bdev_nvme_attach_controller, max_bdevs), spdk_json_decode_uint32, true},
+	{"use_cmb_sqs", offsetof(struct rpc_bdev_nvme_attach_controller, drv_opts.use_cmb_sqs), spdk_json_decode_bool, true},
 };
 
 #define DEFAULT_MAX_BDEVS_PER_RPC 128
@@ -1103,6 +1113,10 @@ rpc_bdev_nvme_pcie_stats(struct spdk_json_write_ctx *w,
 	spdk_json_write_named_uint64(w, "sq_mmio_doorbell_updates", stat->pcie.sq_mmio_doorbell_updates);
 	spdk_json_write_named_uint64(w, "sq_shadow_doorbell_updates",
 				     stat->pcie.sq_shadow_doorbell_updates);
+	spdk_json_write_named_double(w, "sq_cmds_per_mmio_doorbell",
+				     stat->pcie.sq_mmio_doorbell_updates == 0 ? 0.0 :
+				     (double)stat->pcie.submitted_requests /
+				     stat->pcie.sq_mmio_doorbell_updates);
 }
 
 static void
@@ -1115,6 +1129,9 @@ rpc_bdev_nvme_tcp_stats(struct spdk_json_write_ctx *w,
 	spdk_json_write_named_uint64(w, "nvme_completions", stat->tcp.nvme_completions);
 	spdk_json_write_named_uint64(w, "queued_requests", stat->tcp.queued_requests);
 	spdk_json_write_named_uint64(w, "submitted_requests", stat->tcp.submitted_requests);
+	spdk_json_write_named_uint64(w, "data_digests", stat->tcp.data_digests);
+	spdk_json_write_named_uint64(w, "data_digest_batches", stat->tcp.data_digest_batches);
+	spdk_json_write_named_uint64(w, "recv_lookaheads", stat->tcp.recv_lookaheads);
 }
 
 static void
@@ -2225,6 +2242,8 @@ rpc_decode_mp_selector(const struct spdk_json_val *val, void *out)
 		*selector = BDEV_NVME_MP_SELECTOR_ROUND_ROBIN;
 	} else if (spdk_json_strequal(val, "queue_depth") == true) {
 		*selector = BDEV_NVME_MP_SELECTOR_QUEUE_DEPTH;
+	} else if (spdk_json_strequal(val, "latency") == true) {
+		*selector = BDEV_NVME_MP_SELECTOR_LATENCY;
 	} else {
 		SPDK_NOTICELOG("Invalid parameter value: selector\n");
 		return -EINVAL;
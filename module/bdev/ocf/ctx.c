@@ -6,8 +6,10 @@
 #include <ocf/ocf.h>
 #include <execinfo.h>
 
+#include "spdk/bdev.h"
 #include "spdk/env.h"
 #include "spdk/log.h"
+#include "spdk/string.h"
 
 #include "ctx.h"
 #include "data.h"
@@ -302,9 +304,199 @@ vbdev_ocf_cache_ctx_get(struct vbdev_ocf_cache_ctx *ctx)
 	env_atomic_inc(&ctx->refcnt);
 }
 
+/* Poller function for the cleaner queue */
+static int
+cleaner_queue_poll(void *opaque)
+{
+	ocf_queue_t q = opaque;
+	uint32_t iono = ocf_queue_pending_io(q);
+	int i, max = spdk_min(32, iono);
+
+	for (i = 0; i < max; i++) {
+		ocf_queue_run_single(q);
+	}
+
+	if (iono > 0) {
+		return SPDK_POLLER_BUSY;
+	} else {
+		return SPDK_POLLER_IDLE;
+	}
+}
+
+static void
+cleaner_queue_kick(ocf_queue_t q)
+{
+}
+
+/* The queue is put on the cleaner thread, after its poller is unregistered */
+static void
+cleaner_queue_stop(ocf_queue_t q)
+{
+}
+
+static const struct ocf_queue_ops cleaner_queue_ops = {
+	.kick_sync = cleaner_queue_kick,
+	.kick = cleaner_queue_kick,
+	.stop = cleaner_queue_stop,
+};
+
+static void
+_cleaner_queue_start(void *arg)
+{
+	struct vbdev_ocf_cache_ctx *ctx = arg;
+
+	ctx->cleaner_poller = SPDK_POLLER_REGISTER(cleaner_queue_poll, ctx->cleaner_queue, 0);
+	if (ctx->cleaner_poller == NULL) {
+		SPDK_ERRLOG("Unable to register the cleaner queue poller\n");
+	}
+}
+
+static void
+_cleaner_thread_exit(void *arg)
+{
+	spdk_thread_exit(spdk_get_thread());
+}
+
+int
+vbdev_ocf_cleaner_queue_create(ocf_cache_t cache, const char *name,
+			       const struct spdk_cpuset *cpumask)
+{
+	struct vbdev_ocf_cache_ctx *ctx = ocf_cache_get_priv(cache);
+	int rc;
+
+	TAILQ_INIT(&ctx->cleaner_channels);
+
+	ctx->cleaner_thread = spdk_thread_create(name, cpumask);
+	if (ctx->cleaner_thread == NULL) {
+		SPDK_ERRLOG("Unable to create the cleaner thread %s\n", name);
+		return -ENOMEM;
+	}
+
+	rc = vbdev_ocf_queue_create(cache, &ctx->cleaner_queue, &cleaner_queue_ops);
+	if (rc) {
+		spdk_thread_send_msg(ctx->cleaner_thread, _cleaner_thread_exit, NULL);
+		ctx->cleaner_thread = NULL;
+		return rc;
+	}
+
+	spdk_thread_send_msg(ctx->cleaner_thread, _cleaner_queue_start, ctx);
+
+	return 0;
+}
+
+static void
+_cleaner_queue_destroy(void *arg)
+{
+	struct vbdev_ocf_cache_ctx *ctx = arg;
+	struct vbdev_ocf_cleaner_channel *cch, *tmp;
+
+	spdk_poller_unregister(&ctx->cleaner_poller);
+
+	TAILQ_FOREACH_SAFE(cch, &ctx->cleaner_channels, tailq, tmp) {
+		TAILQ_REMOVE(&ctx->cleaner_channels, cch, tailq);
+		spdk_put_io_channel(cch->ch);
+		free(cch);
+	}
+
+	vbdev_ocf_queue_put(ctx->cleaner_queue);
+	ctx->cleaner_queue = NULL;
+
+	spdk_thread_exit(spdk_get_thread());
+	vbdev_ocf_cache_ctx_put(ctx);
+}
+
+void
+vbdev_ocf_cleaner_queue_destroy(struct vbdev_ocf_cache_ctx *ctx)
+{
+	if (ctx->cleaner_thread == NULL) {
+		return;
+	}
+
+	vbdev_ocf_cache_ctx_get(ctx);
+	spdk_thread_send_msg(ctx->cleaner_thread, _cleaner_queue_destroy, ctx);
+	ctx->cleaner_thread = NULL;
+}
+
+struct spdk_io_channel *
+vbdev_ocf_cleaner_get_channel(struct vbdev_ocf_cache_ctx *ctx, struct spdk_bdev_desc *desc)
+{
+	struct vbdev_ocf_cleaner_channel *cch;
+
+	TAILQ_FOREACH(cch, &ctx->cleaner_channels, tailq) {
+		if (cch->desc == desc) {
+			return cch->ch;
+		}
+	}
+
+	cch = calloc(1, sizeof(*cch));
+	if (cch == NULL) {
+		return NULL;
+	}
+
+	cch->ch = spdk_bdev_get_io_channel(desc);
+	if (cch->ch == NULL) {
+		free(cch);
+		return NULL;
+	}
+
+	cch->desc = desc;
+	TAILQ_INSERT_TAIL(&ctx->cleaner_channels, cch, tailq);
+
+	return cch->ch;
+}
+
+struct cleaner_put_channel_ctx {
+	struct vbdev_ocf_cache_ctx *ctx;
+	struct spdk_bdev_desc      *desc;
+};
+
+static void
+_cleaner_put_channel(void *arg)
+{
+	struct cleaner_put_channel_ctx *put_ctx = arg;
+	struct vbdev_ocf_cache_ctx *ctx = put_ctx->ctx;
+	struct vbdev_ocf_cleaner_channel *cch;
+
+	TAILQ_FOREACH(cch, &ctx->cleaner_channels, tailq) {
+		if (cch->desc == put_ctx->desc) {
+			TAILQ_REMOVE(&ctx->cleaner_channels, cch, tailq);
+			spdk_put_io_channel(cch->ch);
+			free(cch);
+			break;
+		}
+	}
+
+	vbdev_ocf_cache_ctx_put(ctx);
+	free(put_ctx);
+}
+
+void
+vbdev_ocf_cleaner_put_channel(struct vbdev_ocf_cache_ctx *ctx, struct spdk_bdev_desc *desc)
+{
+	struct cleaner_put_channel_ctx *put_ctx;
+
+	if (ctx->cleaner_thread == NULL) {
+		return;
+	}
+
+	put_ctx = calloc(1, sizeof(*put_ctx));
+	if (put_ctx == NULL) {
+		SPDK_ERRLOG("Unable to release the cleaner channel: %s\n", spdk_strerror(ENOMEM));
+		return;
+	}
+
+	vbdev_ocf_cache_ctx_get(ctx);
+	put_ctx->ctx = ctx;
+	put_ctx->desc = desc;
+	spdk_thread_send_msg(ctx->cleaner_thread, _cleaner_put_channel, put_ctx);
+}
+
 struct cleaner_priv {
 	struct spdk_poller *poller;
-	ocf_queue_t         mngt_queue;
+	ocf_queue_t         queue;
+	/* Thread of the cleaner queue, NULL if the cleaner runs on the management queue */
+	struct spdk_thread *thread;
+	bool                kicked;
 	uint64_t            next_run;
 };
 
@@ -315,7 +507,7 @@ cleaner_poll(void *arg)
 	struct cleaner_priv *priv = ocf_cleaner_get_priv(cleaner);
 
 	if (spdk_get_ticks() >= priv->next_run) {
-		ocf_cleaner_run(cleaner, priv->mngt_queue);
+		ocf_cleaner_run(cleaner, priv->queue);
 		return SPDK_POLLER_BUSY;
 	}
 
@@ -341,7 +533,12 @@ vbdev_ocf_ctx_cleaner_init(ocf_cleaner_t c)
 		return -ENOMEM;
 	}
 
-	priv->mngt_queue = cctx->mngt_queue;
+	if (cctx->cleaner_queue != NULL) {
+		priv->queue = cctx->cleaner_queue;
+		priv->thread = cctx->cleaner_thread;
+	} else {
+		priv->queue = cctx->mngt_queue;
+	}
 
 	ocf_cleaner_set_cmpl(c, cleaner_cmpl);
 	ocf_cleaner_set_priv(c, priv);
@@ -349,29 +546,59 @@ vbdev_ocf_ctx_cleaner_init(ocf_cleaner_t c)
 	return 0;
 }
 
+static void
+_cleaner_stop(void *arg)
+{
+	struct cleaner_priv *priv = arg;
+
+	spdk_poller_unregister(&priv->poller);
+	free(priv);
+}
+
 static void
 vbdev_ocf_ctx_cleaner_stop(ocf_cleaner_t c)
 {
 	struct cleaner_priv *priv = ocf_cleaner_get_priv(c);
 
-	if (priv) {
-		spdk_poller_unregister(&priv->poller);
-		free(priv);
+	if (priv == NULL) {
+		return;
+	}
+
+	/* The poller has to be unregistered on its own thread */
+	if (priv->thread) {
+		spdk_thread_send_msg(priv->thread, _cleaner_stop, priv);
+	} else {
+		_cleaner_stop(priv);
 	}
 }
 
+static void
+_cleaner_start(void *arg)
+{
+	ocf_cleaner_t cleaner = arg;
+	struct cleaner_priv *priv = ocf_cleaner_get_priv(cleaner);
+
+	priv->poller = SPDK_POLLER_REGISTER(cleaner_poll, cleaner, 0);
+}
+
 static void
 vbdev_ocf_ctx_cleaner_kick(ocf_cleaner_t cleaner)
 {
 	struct cleaner_priv *priv  = ocf_cleaner_get_priv(cleaner);
 
-	if (priv->poller) {
+	if (priv->kicked) {
 		return;
 	}
 
-	/* We start cleaner poller at the same thread where cache was created
-	 * TODO: allow user to specify core at which cleaner should run */
-	priv->poller = SPDK_POLLER_REGISTER(cleaner_poll, cleaner, 0);
+	priv->kicked = true;
+
+	/* Unless it has its own thread, we start cleaner poller at the same thread
+	 * where cache was created */
+	if (priv->thread) {
+		spdk_thread_send_msg(priv->thread, _cleaner_start, cleaner);
+	} else {
+		_cleaner_start(cleaner);
+	}
 }
 
 /* This function is main way by which OCF communicates with user
@@ -9,6 +9,7 @@
 #include <ocf/ocf.h>
 #include "ocf_env.h"
 #include "spdk/thread.h"
+#include "spdk/queue.h"
 
 extern ocf_ctx_t vbdev_ocf_ctx;
 
@@ -16,9 +17,25 @@ extern ocf_ctx_t vbdev_ocf_ctx;
 
 #define SPDK_OBJECT 1
 
+struct spdk_bdev_desc;
+
+/* Base bdev channel of the cleaner thread */
+struct vbdev_ocf_cleaner_channel {
+	struct spdk_bdev_desc                  *desc;
+	struct spdk_io_channel                 *ch;
+	TAILQ_ENTRY(vbdev_ocf_cleaner_channel)  tailq;
+};
+
 /* Context of cache instance */
 struct vbdev_ocf_cache_ctx {
 	ocf_queue_t                  mngt_queue;
+	/* Queue of the cleaner and the thread polling it
+	 * NULL if the cleaner runs on the management queue */
+	ocf_queue_t                  cleaner_queue;
+	struct spdk_thread          *cleaner_thread;
+	struct spdk_poller          *cleaner_poller;
+	/* Only accessed on the cleaner thread */
+	TAILQ_HEAD(, vbdev_ocf_cleaner_channel) cleaner_channels;
 	pthread_mutex_t              lock;
 	env_atomic                   refcnt;
 };
@@ -26,6 +43,19 @@ struct vbdev_ocf_cache_ctx {
 void vbdev_ocf_cache_ctx_put(struct vbdev_ocf_cache_ctx *ctx);
 void vbdev_ocf_cache_ctx_get(struct vbdev_ocf_cache_ctx *ctx);
 
+/* Run the cleaner of the cache on its own queue, polled by a new SPDK thread
+ * The cleaner I/O is then submitted through that thread's base bdev channels
+ * instead of the management ones */
+int vbdev_ocf_cleaner_queue_create(ocf_cache_t cache, const char *name,
+				   const struct spdk_cpuset *cpumask);
+/* Stop the cleaner thread, called once the cache is stopped */
+void vbdev_ocf_cleaner_queue_destroy(struct vbdev_ocf_cache_ctx *ctx);
+/* Get the channel of a base bdev, only to be called on the cleaner thread */
+struct spdk_io_channel *vbdev_ocf_cleaner_get_channel(struct vbdev_ocf_cache_ctx *ctx,
+		struct spdk_bdev_desc *desc);
+/* Release the cleaner's channel of a base bdev detached from the cache */
+void vbdev_ocf_cleaner_put_channel(struct vbdev_ocf_cache_ctx *ctx, struct spdk_bdev_desc *desc);
+
 int vbdev_ocf_ctx_init(void);
 void vbdev_ocf_ctx_cleanup(void);
 
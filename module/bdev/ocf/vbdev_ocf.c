@@ -84,6 +84,7 @@ free_vbdev(struct vbdev_ocf *vbdev)
 	free(vbdev->name);
 	free(vbdev->cache.name);
 	free(vbdev->core.name);
+	free(vbdev->cfg.cleaner_cpumask);
 	free(vbdev);
 }
 
@@ -163,6 +164,12 @@ remove_base_bdev(struct vbdev_ocf_base *base)
 			spdk_put_io_channel(base->management_channel);
 		}
 
+		/* Cleaner thread may hold a channel of the core,
+		 * the cache one is released when the cache stops */
+		if (!base->is_cache && base->parent->cache_ctx) {
+			vbdev_ocf_cleaner_put_channel(base->parent->cache_ctx, base->desc);
+		}
+
 		spdk_bdev_module_release_bdev(base->bdev);
 		/* Close the underlying bdev on its same opened thread. */
 		if (base->thread && base->thread != spdk_get_thread()) {
@@ -260,6 +267,7 @@ stop_vbdev_cmpl(ocf_cache_t cache, void *priv, int error)
 {
 	struct vbdev_ocf *vbdev = priv;
 
+	vbdev_ocf_cleaner_queue_destroy(vbdev->cache_ctx);
 	vbdev_ocf_queue_put(vbdev->cache_ctx->mngt_queue);
 	ocf_mngt_cache_unlock(cache);
 
@@ -752,6 +760,9 @@ vbdev_ocf_write_json_config(struct spdk_bdev *bdev, struct spdk_json_write_ctx *
 				     ocf_get_cache_line_size(vbdev->ocf_cache));
 	spdk_json_write_named_string(w, "cache_bdev_name", vbdev->cache.name);
 	spdk_json_write_named_string(w, "core_bdev_name", vbdev->core.name);
+	if (vbdev->cfg.cleaner_cpumask) {
+		spdk_json_write_named_string(w, "cleaner_cpumask", vbdev->cfg.cleaner_cpumask);
+	}
 	spdk_json_write_object_end(w);
 
 	spdk_json_write_object_end(w);
@@ -1045,6 +1056,30 @@ create_management_queue(struct vbdev_ocf *vbdev)
 	return 0;
 }
 
+static int
+create_cleaner_queue(struct vbdev_ocf *vbdev)
+{
+	struct spdk_cpuset cpumask;
+	char *name;
+	int rc;
+
+	rc = spdk_cpuset_parse(&cpumask, vbdev->cfg.cleaner_cpumask);
+	if (rc) {
+		SPDK_ERRLOG("Invalid cleaner cpumask %s\n", vbdev->cfg.cleaner_cpumask);
+		return -EINVAL;
+	}
+
+	name = spdk_sprintf_alloc("ocf_cleaner_%s", vbdev->cache.name);
+	if (name == NULL) {
+		return -ENOMEM;
+	}
+
+	rc = vbdev_ocf_cleaner_queue_create(vbdev->ocf_cache, name, &cpumask);
+	free(name);
+
+	return rc;
+}
+
 /* Start OCF cache, attach caching device */
 static void
 start_cache(struct vbdev_ocf *vbdev)
@@ -1104,6 +1139,15 @@ start_cache(struct vbdev_ocf *vbdev)
 		return;
 	}
 
+	if (vbdev->cfg.cleaner_cpumask) {
+		rc = create_cleaner_queue(vbdev);
+		if (rc) {
+			SPDK_ERRLOG("Unable to create cleaner queue: %d\n", rc);
+			vbdev_ocf_mngt_exit(vbdev, unregister_path_dirty, rc);
+			return;
+		}
+	}
+
 	if (vbdev->cfg.loadq) {
 		ocf_mngt_cache_load(vbdev->ocf_cache, &vbdev->cfg.attach, start_cache_cmpl, vbdev);
 	} else {
@@ -1208,7 +1252,8 @@ init_vbdev(const char *vbdev_name,
 	   const uint64_t cache_line_size,
 	   const char *cache_name,
 	   const char *core_name,
-	   bool loadq)
+	   bool loadq,
+	   const char *cleaner_cpumask)
 {
 	struct vbdev_ocf *vbdev;
 	int rc = 0;
@@ -1244,6 +1289,21 @@ init_vbdev(const char *vbdev_name,
 	vbdev->core.is_cache = false;
 	vbdev->cfg.loadq = loadq;
 
+	if (cleaner_cpumask) {
+		struct spdk_cpuset cpumask;
+
+		if (spdk_cpuset_parse(&cpumask, cleaner_cpumask)) {
+			SPDK_ERRLOG("Invalid cleaner cpumask '%s'\n", cleaner_cpumask);
+			rc = -EINVAL;
+			goto error_free;
+		}
+
+		vbdev->cfg.cleaner_cpumask = strdup(cleaner_cpumask);
+		if (!vbdev->cfg.cleaner_cpumask) {
+			goto error_mem;
+		}
+	}
+
 	rc = init_vbdev_config(vbdev);
 	if (rc) {
 		SPDK_ERRLOG("Fail to init vbdev config\n");
@@ -1453,6 +1513,7 @@ vbdev_ocf_construct(const char *vbdev_name,
 		    const char *cache_name,
 		    const char *core_name,
 		    bool loadq,
+		    const char *cleaner_cpumask,
 		    void (*cb)(int, struct vbdev_ocf *, void *),
 		    void *cb_arg)
 {
@@ -1461,7 +1522,8 @@ vbdev_ocf_construct(const char *vbdev_name,
 	struct spdk_bdev *core_bdev = spdk_bdev_get_by_name(core_name);
 	struct vbdev_ocf *vbdev;
 
-	rc = init_vbdev(vbdev_name, cache_mode_name, cache_line_size, cache_name, core_name, loadq);
+	rc = init_vbdev(vbdev_name, cache_mode_name, cache_line_size, cache_name, core_name, loadq,
+			cleaner_cpumask);
 	if (rc) {
 		cb(rc, NULL, cb_arg);
 		return;
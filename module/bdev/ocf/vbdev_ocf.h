@@ -65,6 +65,10 @@ struct vbdev_ocf_config {
 	/* Load flag, if set to true, then we will try load cache instance from disk,
 	 * otherwise we will create new cache on that disk */
 	bool                                loadq;
+
+	/* Cpumask of the thread running the cleaner, if NULL the cleaner
+	 * runs on the management thread */
+	char                               *cleaner_cpumask;
 };
 
 /* Types for management operations */
@@ -168,6 +172,7 @@ void vbdev_ocf_construct(
 	const char *cache_name,
 	const char *core_name,
 	bool loadq,
+	const char *cleaner_cpumask,
 	void (*cb)(int, struct vbdev_ocf *, void *),
 	void *cb_arg);
 
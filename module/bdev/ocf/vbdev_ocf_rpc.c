@@ -35,6 +35,7 @@ struct rpc_bdev_ocf_create {
 	uint64_t cache_line_size;	/* OCF cache line size */
 	char *cache_bdev_name;		/* sub bdev */
 	char *core_bdev_name;		/* sub bdev */
+	char *cleaner_cpumask;		/* cpumask of the cleaner thread */
 };
 
 static void
@@ -44,6 +45,7 @@ free_rpc_bdev_ocf_create(struct rpc_bdev_ocf_create *r)
 	free(r->core_bdev_name);
 	free(r->cache_bdev_name);
 	free(r->mode);
+	free(r->cleaner_cpumask);
 }
 
 /* Structure to decode the input parameters for this RPC method. */
@@ -53,6 +55,7 @@ static const struct spdk_json_object_decoder rpc_bdev_ocf_create_decoders[] = {
 	{"cache_line_size", offsetof(struct rpc_bdev_ocf_create, cache_line_size), spdk_json_decode_uint64, true},
 	{"cache_bdev_name", offsetof(struct rpc_bdev_ocf_create, cache_bdev_name), spdk_json_decode_string},
 	{"core_bdev_name", offsetof(struct rpc_bdev_ocf_create, core_bdev_name), spdk_json_decode_string},
+	{"cleaner_cpumask", offsetof(struct rpc_bdev_ocf_create, cleaner_cpumask), spdk_json_decode_string, true},
 };
 
 static void
@@ -90,7 +93,7 @@ rpc_bdev_ocf_create(struct spdk_jsonrpc_request *request,
 	}
 
 	vbdev_ocf_construct(req.name, req.mode, req.cache_line_size, req.cache_bdev_name,
-			    req.core_bdev_name, false, construct_cb, request);
+			    req.core_bdev_name, false, req.cleaner_cpumask, construct_cb, request);
 	free_rpc_bdev_ocf_create(&req);
 }
 SPDK_RPC_REGISTER("bdev_ocf_create", rpc_bdev_ocf_create, SPDK_RPC_RUNTIME)
@@ -213,6 +213,14 @@ prepare_submit(struct ocf_io *io)
 		return 0;
 	}
 
+	if (q == cctx->cleaner_queue) {
+		io_ctx->ch = vbdev_ocf_cleaner_get_channel(cctx, base->desc);
+		if (io_ctx->ch == NULL) {
+			return -ENOMEM;
+		}
+		return 0;
+	}
+
 	qctx = ocf_queue_get_priv(q);
 	if (qctx == NULL) {
 		return -EFAULT;
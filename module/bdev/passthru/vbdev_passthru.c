@@ -163,29 +163,6 @@ _pt_complete_io(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 	spdk_bdev_free_io(bdev_io);
 }
 
-static void
-_pt_complete_zcopy_io(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
-{
-	struct spdk_bdev_io *orig_io = cb_arg;
-	int status = success ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED;
-	struct passthru_bdev_io *io_ctx = (struct passthru_bdev_io *)orig_io->driver_ctx;
-
-	/* We setup this value in the submission routine, just showing here that it is
-	 * passed back to us.
-	 */
-	if (io_ctx->test != 0x5a) {
-		SPDK_ERRLOG("Error, original IO device_ctx is wrong! 0x%x\n",
-			    io_ctx->test);
-	}
-
-	/* Complete the original IO and then free the one that we created here
-	 * as a result of issuing an IO via submit_request.
-	 */
-	spdk_bdev_io_set_buf(orig_io, bdev_io->u.bdev.iovs[0].iov_base, bdev_io->u.bdev.iovs[0].iov_len);
-	spdk_bdev_io_complete(orig_io, status);
-	spdk_bdev_free_io(bdev_io);
-}
-
 static void
 vbdev_passthru_resubmit_io(void *arg)
 {
@@ -315,10 +292,11 @@ vbdev_passthru_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *b
 				     _pt_complete_io, bdev_io);
 		break;
 	case SPDK_BDEV_IO_TYPE_ZCOPY:
-		rc = spdk_bdev_zcopy_start(pt_node->base_desc, pt_ch->base_ch, NULL, 0,
-					   bdev_io->u.bdev.offset_blocks,
-					   bdev_io->u.bdev.num_blocks, bdev_io->u.bdev.zcopy.populate,
-					   _pt_complete_zcopy_io, bdev_io);
+		/* The base bdev's buffers are lent to the original IO, which keeps its IO until
+		 * the end phase.
+		 */
+		rc = spdk_bdev_io_zcopy_forward(bdev_io, pt_node->base_desc, pt_ch->base_ch,
+						bdev_io->u.bdev.offset_blocks);
 		break;
 	case SPDK_BDEV_IO_TYPE_ABORT:
 		rc = spdk_bdev_abort(pt_node->base_desc, pt_ch->base_ch, bdev_io->u.abort.bio_to_abort,
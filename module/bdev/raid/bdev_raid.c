@@ -11,9 +11,58 @@
 #include "spdk/string.h"
 #include "spdk/util.h"
 #include "spdk/json.h"
+#include "spdk/likely.h"
+
+#define RAID_BDEV_PROCESS_POLL_PERIOD_US	100
+#define RAID_BDEV_PROCESS_MIN_BACKOFF_US	1000
+#define RAID_BDEV_PROCESS_MAX_BACKOFF_US	(1000 * 1000)
 
 static bool g_shutdown_started = false;
 
+static struct raid_bdev_opts g_opts = {
+	.process_window_size_kb = 1024,
+	.process_max_bandwidth_mb_sec = 0,
+	.process_latency_threshold_us = 0,
+	.raid1_read_policy = RAID1_READ_POLICY_BANDWIDTH,
+	.raid5f_stripe_cache_size = 0,
+	.raid5f_stripe_cache_flush_us = 100,
+	.numa_affinity = false,
+};
+
+enum raid_bdev_process_state {
+	RAID_PROCESS_STATE_INIT,
+	RAID_PROCESS_STATE_RUNNING,
+	RAID_PROCESS_STATE_STOPPING,
+};
+
+struct raid_bdev_process {
+	struct raid_bdev		*raid_bdev;
+	struct raid_base_bdev_info	*target;
+	enum raid_bdev_process_state	state;
+	int				status;
+	struct spdk_io_channel		*raid_ch;
+	struct spdk_poller		*poller;
+
+	/* Number of blocks processed at a time */
+	uint64_t			window_size;
+
+	/* Offset up to which the target is up to date and the end of the current window */
+	uint64_t			offset;
+	uint64_t			window_end;
+	bool				window_busy;
+
+	/* Rate limiting */
+	uint64_t			window_start_tsc;
+	uint64_t			next_tsc;
+	uint64_t			backoff_us;
+
+	/* Foreground IO statistics collected from the channels */
+	uint64_t			fg_ios;
+	uint64_t			fg_ticks;
+
+	struct raid_bdev_process_request req;
+};
+
 /* List of all raid bdevs */
 struct raid_all_tailq g_raid_bdev_list = TAILQ_HEAD_INITIALIZER(g_raid_bdev_list);
 
@@ -52,6 +101,162 @@ static void	raid_bdev_deconfigure(struct raid_bdev *raid_bdev,
 				      raid_bdev_destruct_cb cb_fn, void *cb_arg);
 
 static void raid_bdev_channel_on_suspended(struct raid_bdev_io_channel *raid_ch);
+static void raid_bdev_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io);
+static void raid_bdev_process_stop(struct raid_bdev_process *process, int status);
+
+static inline uint8_t
+raid_bdev_process_target_idx(struct raid_bdev_process *process)
+{
+	return process->target - process->raid_bdev->base_bdev_info;
+}
+
+static int
+raid_bdev_channel_process_setup(struct raid_bdev_io_channel *raid_ch,
+				struct raid_bdev_process *process)
+{
+	struct raid_bdev_io_channel *ch_processed;
+	uint8_t idx = raid_bdev_process_target_idx(process);
+	uint8_t i;
+
+	if (raid_ch->process.ch_processed != NULL) {
+		return 0;
+	}
+
+	ch_processed = calloc(1, sizeof(*ch_processed));
+	if (ch_processed == NULL) {
+		return -ENOMEM;
+	}
+
+	ch_processed->base_channel = calloc(raid_ch->num_channels,
+					    sizeof(struct spdk_io_channel *));
+	if (ch_processed->base_channel == NULL) {
+		free(ch_processed);
+		return -ENOMEM;
+	}
+
+	ch_processed->base_channel[idx] = spdk_bdev_get_io_channel(process->target->desc);
+	if (ch_processed->base_channel[idx] == NULL) {
+		free(ch_processed->base_channel);
+		free(ch_processed);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < raid_ch->num_channels; i++) {
+		if (i != idx) {
+			ch_processed->base_channel[i] = raid_ch->base_channel[i];
+		}
+	}
+	ch_processed->num_channels = raid_ch->num_channels;
+	ch_processed->module_channel = raid_ch->module_channel;
+	ch_processed->process.parent = raid_ch;
+	TAILQ_INIT(&ch_processed->suspended_ios);
+	TAILQ_INIT(&ch_processed->process.held_ios);
+
+	raid_ch->process.offset = process->offset;
+	raid_ch->process.window_end = process->offset;
+	raid_ch->process.num_ios[0] = 0;
+	raid_ch->process.num_ios[1] = 0;
+	raid_ch->process.fg_ios = 0;
+	raid_ch->process.fg_ticks = 0;
+	raid_ch->process.ch_processed = ch_processed;
+
+	return 0;
+}
+
+static void
+raid_bdev_channel_process_free(struct raid_bdev_io_channel *ch_processed)
+{
+	struct raid_bdev_io_channel *raid_ch = ch_processed->process.parent;
+	uint8_t i;
+
+	assert(ch_processed->num_ios == 0);
+
+	/* Put only the channels not shared with the parent channel */
+	for (i = 0; i < ch_processed->num_channels; i++) {
+		if (ch_processed->base_channel[i] != NULL &&
+		    ch_processed->base_channel[i] != raid_ch->base_channel[i]) {
+			spdk_put_io_channel(ch_processed->base_channel[i]);
+		}
+	}
+	free(ch_processed->base_channel);
+	free(ch_processed);
+}
+
+static void
+raid_bdev_channel_process_resubmit_held(struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid_bdev_io *raid_io;
+
+	while ((raid_io = TAILQ_FIRST(&raid_ch->process.held_ios))) {
+		TAILQ_REMOVE(&raid_ch->process.held_ios, raid_io, link);
+		raid_bdev_submit_request(spdk_io_channel_from_ctx(raid_ch),
+					 spdk_bdev_io_from_ctx(raid_io));
+	}
+}
+
+static int32_t
+raid_bdev_current_socket_id(void)
+{
+	uint32_t core = spdk_env_get_current_core();
+
+	return core != SPDK_ENV_LCORE_ID_ANY ? (int32_t)spdk_env_get_socket_id(core) :
+	       SPDK_ENV_SOCKET_ID_ANY;
+}
+
+static inline bool
+raid_bdev_channel_numa_tracked(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	return raid_bdev->numa.enabled && raid_ch->socket_id >= 0 &&
+	       raid_ch->socket_id < RAID_BDEV_MAX_SOCKETS;
+}
+
+/* Called with the raid bdev mutex held */
+static void
+raid_bdev_channel_numa_add(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	int32_t socket_id = raid_ch->socket_id;
+
+	if (!raid_bdev_channel_numa_tracked(raid_bdev, raid_ch)) {
+		return;
+	}
+
+	TAILQ_INSERT_TAIL(&raid_bdev->numa.channels[socket_id], raid_ch, numa_link);
+	if (raid_bdev->numa.threads[socket_id] == NULL) {
+		raid_bdev->numa.threads[socket_id] = raid_ch->thread;
+	}
+}
+
+/* Called with the raid bdev mutex held */
+static void
+raid_bdev_channel_numa_remove(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	int32_t socket_id = raid_ch->socket_id;
+	struct raid_bdev_io_channel *first;
+
+	if (!raid_bdev_channel_numa_tracked(raid_bdev, raid_ch)) {
+		return;
+	}
+
+	TAILQ_REMOVE(&raid_bdev->numa.channels[socket_id], raid_ch, numa_link);
+	if (raid_bdev->numa.threads[socket_id] == raid_ch->thread) {
+		first = TAILQ_FIRST(&raid_bdev->numa.channels[socket_id]);
+		raid_bdev->numa.threads[socket_id] = first ? first->thread : NULL;
+	}
+}
+
+/* The thread of the channel was moved to another socket */
+static void
+raid_bdev_channel_migrate(void *io_device, void *ctx_buf)
+{
+	struct raid_bdev *raid_bdev = io_device;
+	struct raid_bdev_io_channel *raid_ch = ctx_buf;
+
+	pthread_mutex_lock(&raid_bdev->mutex);
+	raid_bdev_channel_numa_remove(raid_bdev, raid_ch);
+	raid_ch->socket_id = raid_bdev_current_socket_id();
+	raid_bdev_channel_numa_add(raid_bdev, raid_ch);
+	pthread_mutex_unlock(&raid_bdev->mutex);
+}
 
 /*
  * brief:
@@ -78,6 +283,8 @@ raid_bdev_create_cb(void *io_device, void *ctx_buf)
 	assert(raid_bdev->state == RAID_BDEV_STATE_ONLINE);
 
 	raid_ch->num_channels = raid_bdev->num_base_bdevs;
+	raid_ch->thread = spdk_get_thread();
+	raid_ch->socket_id = raid_bdev_current_socket_id();
 	TAILQ_INIT(&raid_ch->suspended_ios);
 
 	raid_ch->base_channel = calloc(raid_ch->num_channels,
@@ -94,9 +301,13 @@ raid_bdev_create_cb(void *io_device, void *ctx_buf)
 		/*
 		 * Get the spdk_io_channel for all the base bdevs. This is used during
 		 * split logic to send the respective child bdev ios to respective base
-		 * bdev io channel.
+		 * bdev io channel. Base bdevs not yet rebuilt are used only through
+		 * the processed channel.
 		 */
-		if (raid_bdev->base_bdev_info[i].desc == NULL) {
+		if (raid_bdev->base_bdev_info[i].desc == NULL ||
+		    !raid_bdev->base_bdev_info[i].is_configured ||
+		    (raid_bdev->process != NULL &&
+		     raid_bdev->process->target == &raid_bdev->base_bdev_info[i])) {
 			continue;
 		}
 		raid_ch->base_channel[i] = spdk_bdev_get_io_channel(
@@ -117,7 +328,26 @@ raid_bdev_create_cb(void *io_device, void *ctx_buf)
 		}
 	}
 
+	TAILQ_INIT(&raid_ch->process.held_ios);
+	if (!ret) {
+		pthread_mutex_lock(&raid_bdev->mutex);
+		if (raid_bdev->process != NULL) {
+			ret = raid_bdev_channel_process_setup(raid_ch, raid_bdev->process);
+			if (ret) {
+				SPDK_ERRLOG("Unable to set up raid bdev process on io channel\n");
+			}
+		}
+		if (!ret) {
+			raid_bdev_channel_numa_add(raid_bdev, raid_ch);
+		}
+		pthread_mutex_unlock(&raid_bdev->mutex);
+	}
+
 	if (ret) {
+		if (raid_ch->process.ch_processed != NULL) {
+			raid_bdev_channel_process_free(raid_ch->process.ch_processed);
+			raid_ch->process.ch_processed = NULL;
+		}
 		for (i = 0; i < raid_ch->num_channels; i++) {
 			if (raid_ch->base_channel[i] != NULL) {
 				spdk_put_io_channel(raid_ch->base_channel[i]);
@@ -142,6 +372,7 @@ raid_bdev_create_cb(void *io_device, void *ctx_buf)
 static void
 raid_bdev_destroy_cb(void *io_device, void *ctx_buf)
 {
+	struct raid_bdev *raid_bdev = io_device;
 	struct raid_bdev_io_channel *raid_ch = ctx_buf;
 	uint8_t i;
 
@@ -150,6 +381,16 @@ raid_bdev_destroy_cb(void *io_device, void *ctx_buf)
 	assert(raid_ch != NULL);
 	assert(raid_ch->base_channel);
 	assert(TAILQ_EMPTY(&raid_ch->suspended_ios));
+	assert(TAILQ_EMPTY(&raid_ch->process.held_ios));
+
+	pthread_mutex_lock(&raid_bdev->mutex);
+	raid_bdev_channel_numa_remove(raid_bdev, raid_ch);
+	pthread_mutex_unlock(&raid_bdev->mutex);
+
+	if (raid_ch->process.ch_processed != NULL) {
+		raid_bdev_channel_process_free(raid_ch->process.ch_processed);
+		raid_ch->process.ch_processed = NULL;
+	}
 
 	if (raid_ch->module_channel) {
 		spdk_put_io_channel(raid_ch->module_channel);
@@ -284,6 +525,10 @@ _raid_bdev_destruct(void *ctxt)
 
 	SPDK_DEBUGLOG(bdev_raid, "raid_bdev_destruct\n");
 
+	if (raid_bdev->process != NULL) {
+		raid_bdev_process_stop(raid_bdev->process, -ECANCELED);
+	}
+
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
 		/*
 		 * Close all base bdev descriptors for which call has come from below
@@ -315,12 +560,162 @@ raid_bdev_destruct(void *ctx)
 	return 1;
 }
 
+static inline bool
+raid_bdev_channel_process_window_unlocked(struct raid_bdev_io_channel *raid_ch)
+{
+	return raid_ch->process.num_ios[raid_ch->process.gen ^ 1] == 0;
+}
+
+static struct raid_bdev_io_channel *
+raid_bdev_io_process_complete(struct raid_bdev_io *raid_io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
+	struct raid_bdev_io_channel *ch_processed = NULL;
+	struct spdk_io_channel_iter *iter;
+
+	if (raid_ch->process.parent != NULL) {
+		ch_processed = raid_ch;
+		raid_ch = ch_processed->process.parent;
+	}
+
+	if (raid_ch->process.ch_processed != NULL) {
+		raid_ch->process.fg_ios++;
+		raid_ch->process.fg_ticks += spdk_get_ticks() -
+					     spdk_bdev_io_get_submit_tsc(bdev_io);
+
+		if (raid_io->process_gen >= 0 && raid_ch->process.ch_processed == ch_processed) {
+			assert(raid_ch->process.num_ios[raid_io->process_gen] > 0);
+			raid_ch->process.num_ios[raid_io->process_gen]--;
+
+			iter = raid_ch->process.iter;
+			if (iter != NULL && raid_bdev_channel_process_window_unlocked(raid_ch)) {
+				raid_ch->process.iter = NULL;
+				spdk_for_each_channel_continue(iter, 0);
+			}
+		}
+	}
+
+	if (ch_processed != NULL && --ch_processed->num_ios == 0 &&
+	    raid_ch->process.ch_processed != ch_processed) {
+		/* The process has finished, release the channel detached from the parent */
+		iter = ch_processed->process.iter;
+		raid_bdev_channel_process_free(ch_processed);
+		if (iter != NULL) {
+			spdk_for_each_channel_continue(iter, 0);
+		}
+	}
+
+	return raid_ch;
+}
+
+static void
+_raid_bdev_io_numa_complete(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid_bdev_io_complete(raid_io, raid_io->numa.status);
+}
+
+/* Passes the completion of a forwarded IO back to the thread it was submitted on */
+static void
+raid_bdev_io_numa_complete(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
+{
+	int rc;
+
+	spdk_put_io_channel(raid_io->numa.ch);
+	raid_io->numa.ch = NULL;
+	raid_io->numa.status = status;
+
+	rc = spdk_thread_send_msg(raid_io->numa.thread, _raid_bdev_io_numa_complete, raid_io);
+	assert(rc == 0);
+}
+
+static void
+raid_bdev_io_numa_submit(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+	int rc;
+
+	raid_io->numa.ch = spdk_get_io_channel(raid_io->raid_bdev);
+	if (spdk_unlikely(raid_io->numa.ch == NULL)) {
+		/* Submit the IO on its own thread then */
+		rc = spdk_thread_send_msg(raid_io->numa.thread, raid_io->numa.submit_fn, raid_io);
+		assert(rc == 0);
+		return;
+	}
+
+	raid_io->numa.submit_fn(raid_io);
+}
+
+/*
+ * Forwards the raid_io to a thread on the NUMA socket of the base bdev it goes to, if NUMA affinity
+ * is enabled and the base bdev is on another socket than the current thread. The module's
+ * submit_fn is then called on that thread, where raid_bdev_io_base_channel() must be used to get
+ * the base bdev channels. The completion is passed back to the submitting thread. Returns false if
+ * the raid_io was not forwarded and should be submitted from the current thread.
+ */
+bool
+raid_bdev_io_numa_forward(struct raid_bdev_io *raid_io, struct raid_base_bdev_info *base_info,
+			  spdk_msg_fn submit_fn)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	int32_t socket_id, local_socket_id = raid_io->raid_ch->socket_id;
+	struct spdk_thread *thread;
+	int rc;
+
+	/* Already forwarded or returned after a failed attempt */
+	if (spdk_likely(!raid_bdev->numa.enabled) || raid_io->numa.thread != NULL) {
+		return false;
+	}
+
+	socket_id = spdk_bdev_get_socket_id(base_info->bdev);
+	if (socket_id < 0 || socket_id >= RAID_BDEV_MAX_SOCKETS || local_socket_id < 0 ||
+	    socket_id == local_socket_id) {
+		return false;
+	}
+
+	raid_io->numa.thread = spdk_get_thread();
+	raid_io->numa.submit_fn = submit_fn;
+
+	/*
+	 * The thread is removed from the array under the mutex before its channel is released, so
+	 * it can't exit while the message is sent. raid_bdev_io_numa_submit() handles a thread that
+	 * released its channel in the meantime.
+	 */
+	pthread_mutex_lock(&raid_bdev->mutex);
+	thread = raid_bdev->numa.threads[socket_id];
+	rc = -ENODEV;
+	if (thread != NULL) {
+		rc = spdk_thread_send_msg(thread, raid_bdev_io_numa_submit, raid_io);
+	}
+	pthread_mutex_unlock(&raid_bdev->mutex);
+	if (rc != 0) {
+		__atomic_fetch_add(&raid_bdev->numa.remote_ios, 1, __ATOMIC_RELAXED);
+		return false;
+	}
+
+	__atomic_fetch_add(&raid_bdev->numa.forwarded_ios, 1, __ATOMIC_RELAXED);
+
+	return true;
+}
+
 void
 raid_bdev_io_complete(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
 {
 	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
 	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
 
+	if (spdk_unlikely(raid_io->numa.ch != NULL)) {
+		raid_bdev_io_numa_complete(raid_io, status);
+		return;
+	}
+
+	if (spdk_unlikely(raid_ch->process.ch_processed != NULL ||
+			  raid_ch->process.parent != NULL)) {
+		raid_ch = raid_bdev_io_process_complete(raid_io);
+	}
+
 	spdk_bdev_io_complete(bdev_io, status);
 
 	raid_ch->num_ios--;
@@ -494,6 +889,58 @@ raid_bdev_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io,
  * returns:
  * none
  */
+static bool
+raid_bdev_channel_process_hold(struct raid_bdev_io_channel *raid_ch, struct spdk_bdev_io *bdev_io)
+{
+	uint64_t start = bdev_io->u.bdev.offset_blocks;
+	uint64_t end = start + bdev_io->u.bdev.num_blocks;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+		/* Writes to the window being processed wait until it is done */
+		return raid_ch->process.window_end > raid_ch->process.offset &&
+		       start < raid_ch->process.window_end && end > raid_ch->process.offset;
+	default:
+		return false;
+	}
+}
+
+static void
+raid_bdev_io_process_route(struct raid_bdev_io *raid_io, struct spdk_bdev_io *bdev_io)
+{
+	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
+	struct raid_bdev_io_channel *ch_processed = raid_ch->process.ch_processed;
+	uint64_t end = bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		/* Only the processed range can be read from the target */
+		if (end > raid_ch->process.offset) {
+			return;
+		}
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+		/*
+		 * Writes always go to the target as well. The ones beyond the processed range
+		 * are tracked so that the next windows can wait for them to complete.
+		 */
+		if (end > raid_ch->process.offset) {
+			raid_io->process_gen = raid_ch->process.gen;
+			raid_ch->process.num_ios[raid_io->process_gen]++;
+		}
+		break;
+	default:
+		return;
+	}
+
+	raid_io->raid_ch = ch_processed;
+	ch_processed->num_ios++;
+}
+
 static void
 raid_bdev_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
 {
@@ -503,12 +950,22 @@ raid_bdev_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 	if (raid_ch->is_suspended) {
 		TAILQ_INSERT_TAIL(&raid_ch->suspended_ios, raid_io, link);
 		return;
+	} else if (spdk_unlikely(raid_ch->process.ch_processed != NULL) &&
+		   raid_bdev_channel_process_hold(raid_ch, bdev_io)) {
+		TAILQ_INSERT_TAIL(&raid_ch->process.held_ios, raid_io, link);
+		return;
 	} else {
 		raid_ch->num_ios++;
 	}
 
 	raid_io->raid_bdev = bdev_io->bdev->ctxt;
 	raid_io->raid_ch = raid_ch;
+	raid_io->process_gen = -1;
+	raid_io->numa.thread = NULL;
+	raid_io->numa.ch = NULL;
+	if (spdk_unlikely(raid_ch->process.ch_processed != NULL)) {
+		raid_bdev_io_process_route(raid_io, bdev_io);
+	}
 	raid_io->base_bdev_io_remaining = 0;
 	raid_io->base_bdev_io_submitted = 0;
 	raid_io->base_bdev_io_status = SPDK_BDEV_IO_STATUS_SUCCESS;
@@ -638,10 +1095,35 @@ raid_bdev_write_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ct
 	spdk_json_write_named_string(w, "state", raid_bdev_state_to_str(raid_bdev->state));
 	spdk_json_write_named_string(w, "raid_level", raid_bdev_level_to_str(raid_bdev->level));
 	spdk_json_write_named_bool(w, "superblock", raid_bdev->sb != NULL);
+	if (raid_bdev->write_intent_region_size != 0) {
+		spdk_json_write_named_uint64(w, "write_intent_region_size_kb",
+					     (uint64_t)raid_bdev->write_intent_region_size *
+					     raid_bdev->bdev.blocklen / 1024);
+	}
 	spdk_json_write_named_uint32(w, "num_base_bdevs", raid_bdev->num_base_bdevs);
 	spdk_json_write_named_uint32(w, "num_base_bdevs_discovered", raid_bdev->num_base_bdevs_discovered);
 	spdk_json_write_named_uint32(w, "num_base_bdevs_operational",
 				     raid_bdev->num_base_bdevs_operational);
+	if (raid_bdev->process != NULL) {
+		struct raid_bdev_process *process = raid_bdev->process;
+
+		spdk_json_write_named_object_begin(w, "process");
+		spdk_json_write_named_string(w, "type", "rebuild");
+		spdk_json_write_named_string(w, "target", process->target->name);
+		spdk_json_write_named_object_begin(w, "progress");
+		spdk_json_write_named_uint64(w, "blocks", process->offset);
+		spdk_json_write_named_uint32(w, "percent", process->offset * 100 /
+					     raid_bdev->bdev.blockcnt);
+		spdk_json_write_named_uint64(w, "backoff_us", process->backoff_us);
+		spdk_json_write_object_end(w);
+		spdk_json_write_object_end(w);
+	}
+	if (raid_bdev->numa.enabled) {
+		spdk_json_write_named_object_begin(w, "numa");
+		spdk_json_write_named_uint64(w, "forwarded_ios", raid_bdev->numa.forwarded_ios);
+		spdk_json_write_named_uint64(w, "remote_ios", raid_bdev->numa.remote_ios);
+		spdk_json_write_object_end(w);
+	}
 	spdk_json_write_name(w, "base_bdevs_list");
 	spdk_json_write_array_begin(w);
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
@@ -713,6 +1195,11 @@ raid_bdev_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *
 	spdk_json_write_named_uint32(w, "strip_size_kb", raid_bdev->strip_size_kb);
 	spdk_json_write_named_string(w, "raid_level", raid_bdev_level_to_str(raid_bdev->level));
 	spdk_json_write_named_bool(w, "superblock", raid_bdev->sb != NULL);
+	if (raid_bdev->write_intent_region_size != 0) {
+		spdk_json_write_named_uint64(w, "write_intent_region_size_kb",
+					     (uint64_t)raid_bdev->write_intent_region_size *
+					     raid_bdev->bdev.blocklen / 1024);
+	}
 
 	spdk_json_write_named_array_begin(w, "base_bdevs");
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
@@ -814,6 +1301,8 @@ static struct {
 	{ "1", RAID1 },
 	{ "raid5f", RAID5F },
 	{ "5f", RAID5F },
+	{ "raid6f", RAID6F },
+	{ "6f", RAID6F },
 	{ "concat", CONCAT },
 	{ }
 };
@@ -828,9 +1317,49 @@ static struct {
 	{ }
 };
 
+static struct {
+	const char *name;
+	enum raid1_read_policy value;
+} g_raid1_read_policy_names[] = {
+	{ "bandwidth", RAID1_READ_POLICY_BANDWIDTH },
+	{ "latency", RAID1_READ_POLICY_LATENCY },
+	{ }
+};
+
 /* We have to use the typedef in the function declaration to appease astyle. */
 typedef enum raid_level raid_level_t;
 typedef enum raid_bdev_state raid_bdev_state_t;
+typedef enum raid1_read_policy raid1_read_policy_t;
+
+raid1_read_policy_t
+raid_bdev_str_to_read_policy(const char *str)
+{
+	unsigned int i;
+
+	assert(str != NULL);
+
+	for (i = 0; g_raid1_read_policy_names[i].name != NULL; i++) {
+		if (strcasecmp(g_raid1_read_policy_names[i].name, str) == 0) {
+			return g_raid1_read_policy_names[i].value;
+		}
+	}
+
+	return RAID1_READ_POLICY_INVALID;
+}
+
+const char *
+raid_bdev_read_policy_to_str(enum raid1_read_policy policy)
+{
+	unsigned int i;
+
+	for (i = 0; g_raid1_read_policy_names[i].name != NULL; i++) {
+		if (g_raid1_read_policy_names[i].value == policy) {
+			return g_raid1_read_policy_names[i].name;
+		}
+	}
+
+	return "";
+}
 
 raid_level_t
 raid_bdev_str_to_level(const char *str)
@@ -945,17 +1474,64 @@ raid_bdev_get_ctx_size(void)
 	return sizeof(struct raid_bdev_io);
 }
 
-static struct spdk_bdev_module g_raid_if = {
-	.name = "raid",
-	.module_init = raid_bdev_init,
-	.fini_start = raid_bdev_fini_start,
-	.module_fini = raid_bdev_exit,
-	.get_ctx_size = raid_bdev_get_ctx_size,
-	.examine_disk = raid_bdev_examine,
-	.async_init = false,
-	.async_fini = false,
-};
-SPDK_BDEV_MODULE_REGISTER(raid, &g_raid_if)
+void
+raid_bdev_get_opts(struct raid_bdev_opts *opts)
+{
+	*opts = g_opts;
+}
+
+int
+raid_bdev_set_opts(const struct raid_bdev_opts *opts)
+{
+	if (opts->process_window_size_kb == 0 ||
+	    opts->raid1_read_policy >= RAID1_READ_POLICY_INVALID) {
+		return -EINVAL;
+	}
+
+	g_opts = *opts;
+
+	return 0;
+}
+
+static int
+raid_bdev_config_json(struct spdk_json_write_ctx *w)
+{
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_string(w, "method", "bdev_raid_set_options");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_uint32(w, "process_window_size_kb", g_opts.process_window_size_kb);
+	spdk_json_write_named_uint32(w, "process_max_bandwidth_mb_sec",
+				     g_opts.process_max_bandwidth_mb_sec);
+	spdk_json_write_named_uint32(w, "process_latency_threshold_us",
+				     g_opts.process_latency_threshold_us);
+	spdk_json_write_named_string(w, "raid1_read_policy",
+				     raid_bdev_read_policy_to_str(g_opts.raid1_read_policy));
+	spdk_json_write_named_uint32(w, "raid5f_stripe_cache_size",
+				     g_opts.raid5f_stripe_cache_size);
+	spdk_json_write_named_uint32(w, "raid5f_stripe_cache_flush_us",
+				     g_opts.raid5f_stripe_cache_flush_us);
+	spdk_json_write_named_bool(w, "numa_affinity", g_opts.numa_affinity);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
+static struct spdk_bdev_module g_raid_if = {
+	.name = "raid",
+	.module_init = raid_bdev_init,
+	.fini_start = raid_bdev_fini_start,
+	.module_fini = raid_bdev_exit,
+	.config_json = raid_bdev_config_json,
+	.get_ctx_size = raid_bdev_get_ctx_size,
+	.examine_disk = raid_bdev_examine,
+	.async_init = false,
+	.async_fini = false,
+};
+SPDK_BDEV_MODULE_REGISTER(raid, &g_raid_if)
 
 /*
  * brief:
@@ -1286,6 +1862,7 @@ raid_bdev_init_superblock(struct raid_bdev *raid_bdev)
 	sb->block_size = raid_bdev->bdev.blocklen;
 	sb->level = raid_bdev->level;
 	sb->strip_size = raid_bdev->strip_size;
+	sb->write_intent_region_size = raid_bdev->write_intent_region_size;
 	/* TODO: sb->state */
 	sb->num_base_bdevs = sb->base_bdevs_size = raid_bdev->num_base_bdevs;
 	sb->length = sizeof(*sb) + sizeof(*sb_base_bdev) * sb->base_bdevs_size;
@@ -1314,6 +1891,9 @@ raid_bdev_configure_cont(struct raid_bdev *raid_bdev)
 	spdk_io_device_register(raid_bdev, raid_bdev_create_cb, raid_bdev_destroy_cb,
 				sizeof(struct raid_bdev_io_channel),
 				raid_bdev->bdev.name);
+	if (raid_bdev->numa.enabled) {
+		spdk_io_device_set_migrate_cb(raid_bdev, raid_bdev_channel_migrate);
+	}
 	rc = spdk_bdev_register(raid_bdev_gen);
 	if (rc != 0) {
 		SPDK_ERRLOG("Unable to register raid bdev and stay at configuring state\n");
@@ -1339,6 +1919,20 @@ raid_bdev_configure_write_sb_cb(bool success, struct raid_bdev *raid_bdev)
 	}
 }
 
+static void
+raid_bdev_numa_init(struct raid_bdev *raid_bdev)
+{
+	int i;
+
+	raid_bdev->numa.enabled = g_opts.numa_affinity;
+	for (i = 0; i < RAID_BDEV_MAX_SOCKETS; i++) {
+		TAILQ_INIT(&raid_bdev->numa.channels[i]);
+		raid_bdev->numa.threads[i] = NULL;
+	}
+	raid_bdev->numa.forwarded_ios = 0;
+	raid_bdev->numa.remote_ios = 0;
+}
+
 /*
  * brief:
  * If raid bdev config is complete, then only register the raid bdev to
@@ -1390,6 +1984,8 @@ raid_bdev_configure(struct raid_bdev *raid_bdev)
 	raid_bdev->blocklen_shift = spdk_u32log2(blocklen);
 	raid_bdev->bdev.blocklen = blocklen;
 
+	raid_bdev_numa_init(raid_bdev);
+
 	rc = raid_bdev_configure_md(raid_bdev);
 	if (rc != 0) {
 		SPDK_ERRLOG("raid metadata configuration failed\n");
@@ -1451,6 +2047,10 @@ raid_bdev_deconfigure(struct raid_bdev *raid_bdev, raid_bdev_destruct_cb cb_fn,
 	assert(raid_bdev->num_base_bdevs_discovered);
 	SPDK_DEBUGLOG(bdev_raid, "raid bdev state changing from online to offline\n");
 
+	if (raid_bdev->process != NULL) {
+		raid_bdev_process_stop(raid_bdev->process, -ECANCELED);
+	}
+
 	spdk_bdev_unregister(&raid_bdev->bdev, cb_fn, cb_arg);
 }
 
@@ -1640,6 +2240,10 @@ raid_bdev_channel_remove_base_bdev(struct spdk_io_channel_iter *i)
 		raid_ch->base_channel[idx] = NULL;
 	}
 
+	if (raid_ch->process.ch_processed != NULL) {
+		raid_ch->process.ch_processed->base_channel[idx] = NULL;
+	}
+
 	spdk_for_each_channel_continue(i, 0);
 }
 
@@ -1739,6 +2343,12 @@ raid_bdev_remove_base_bdev(struct spdk_bdev *base_bdev)
 	assert(base_info->desc);
 	base_info->remove_scheduled = true;
 
+	if (raid_bdev->process != NULL && raid_bdev->process->target == base_info) {
+		/* The base bdev is released when the process stops */
+		raid_bdev_process_stop(raid_bdev->process, -ENODEV);
+		return 0;
+	}
+
 	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
 		/*
 		 * As raid bdev is not registered yet or already unregistered,
@@ -1878,12 +2488,520 @@ raid_bdev_delete(struct raid_bdev *raid_bdev, raid_bdev_destruct_cb cb_fn, void
 	}
 }
 
+static void
+raid_bdev_channel_process_lock_window(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+
+	if (raid_ch->process.ch_processed == NULL) {
+		spdk_for_each_channel_continue(i, 0);
+		return;
+	}
+
+	__atomic_fetch_add(&process->fg_ios, raid_ch->process.fg_ios, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&process->fg_ticks, raid_ch->process.fg_ticks, __ATOMIC_RELAXED);
+	raid_ch->process.fg_ios = 0;
+	raid_ch->process.fg_ticks = 0;
+
+	/*
+	 * New writes to the window are held from now on. Writes submitted before may still
+	 * overlap it, so wait for the ones counted in the previous generation.
+	 */
+	raid_ch->process.window_end = process->window_end;
+	raid_ch->process.gen ^= 1;
+
+	if (raid_bdev_channel_process_window_unlocked(raid_ch)) {
+		spdk_for_each_channel_continue(i, 0);
+	} else {
+		raid_ch->process.iter = i;
+	}
+}
+
+static void
+raid_bdev_channel_process_unlock_window(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+
+	if (raid_ch->process.ch_processed != NULL) {
+		raid_ch->process.offset = process->offset;
+		raid_ch->process.window_end = process->window_end;
+		raid_bdev_channel_process_resubmit_held(raid_ch);
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+raid_bdev_process_window_unlocked(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+
+	process->window_busy = false;
+}
+
+static void
+raid_bdev_process_update_rate(struct raid_bdev_process *process, uint64_t num_blocks)
+{
+	uint64_t ticks_hz = spdk_get_ticks_hz();
+	uint64_t now = spdk_get_ticks();
+	uint64_t next_tsc = now;
+	uint64_t fg_ios, fg_ticks;
+
+	if (g_opts.process_max_bandwidth_mb_sec != 0) {
+		uint64_t bytes = num_blocks * process->raid_bdev->bdev.blocklen;
+
+		next_tsc = process->window_start_tsc + bytes * ticks_hz /
+			   ((uint64_t)g_opts.process_max_bandwidth_mb_sec * 1024 * 1024);
+	}
+
+	fg_ios = __atomic_exchange_n(&process->fg_ios, 0, __ATOMIC_RELAXED);
+	fg_ticks = __atomic_exchange_n(&process->fg_ticks, 0, __ATOMIC_RELAXED);
+
+	if (g_opts.process_latency_threshold_us != 0) {
+		/*
+		 * Back off exponentially while the foreground latency is above the threshold
+		 * and recover gradually once it drops.
+		 */
+		if (fg_ios != 0 && fg_ticks / fg_ios * SPDK_SEC_TO_USEC / ticks_hz >
+		    g_opts.process_latency_threshold_us) {
+			process->backoff_us = spdk_min(spdk_max(process->backoff_us * 2,
+							RAID_BDEV_PROCESS_MIN_BACKOFF_US),
+						       RAID_BDEV_PROCESS_MAX_BACKOFF_US);
+		} else if (process->backoff_us / 2 >= RAID_BDEV_PROCESS_MIN_BACKOFF_US) {
+			process->backoff_us /= 2;
+		} else {
+			process->backoff_us = 0;
+		}
+	} else {
+		process->backoff_us = 0;
+	}
+
+	process->next_tsc = spdk_max(next_tsc,
+				     now + process->backoff_us * ticks_hz / SPDK_SEC_TO_USEC);
+}
+
+void
+raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	struct raid_bdev_process *process = process_req->process;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_bdev_io_channel *raid_ch = process_req->raid_ch;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	raid_ch->num_ios--;
+	if (raid_ch->is_suspended && raid_ch->num_ios == 0) {
+		raid_bdev_channel_on_suspended(raid_ch);
+	}
+
+	if (status == 0) {
+		pthread_mutex_lock(&raid_bdev->mutex);
+		process->offset = process->window_end;
+		pthread_mutex_unlock(&raid_bdev->mutex);
+		raid_bdev_process_update_rate(process, process_req->num_blocks);
+	} else if (status == -ENOMEM) {
+		/* Retry the same window later */
+		process->next_tsc = spdk_get_ticks() + spdk_get_ticks_hz() *
+				    RAID_BDEV_PROCESS_MIN_BACKOFF_US / SPDK_SEC_TO_USEC;
+	} else {
+		SPDK_ERRLOG("Failed to process blocks %" PRIu64 "-%" PRIu64 " of raid bdev %s: %s\n",
+			    process_req->offset_blocks,
+			    process_req->offset_blocks + process_req->num_blocks - 1,
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+		if (process->state != RAID_PROCESS_STATE_STOPPING) {
+			process->state = RAID_PROCESS_STATE_STOPPING;
+			process->status = status;
+		}
+	}
+
+	pthread_mutex_lock(&raid_bdev->mutex);
+	process->window_end = process->offset;
+	pthread_mutex_unlock(&raid_bdev->mutex);
+
+	spdk_for_each_channel(raid_bdev, raid_bdev_channel_process_unlock_window, process,
+			      raid_bdev_process_window_unlocked);
+}
+
+static void
+raid_bdev_process_window_locked(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev_process_request *process_req = &process->req;
+	int rc;
+
+	process_req->process = process;
+	process_req->raid_ch = spdk_io_channel_get_ctx(process->raid_ch);
+	process_req->target = process->target;
+	process_req->target_ch = process->target->app_thread_ch;
+	process_req->offset_blocks = process->offset;
+	process_req->num_blocks = process->window_end - process->offset;
+	process_req->num_ios = 0;
+	process_req->status = 0;
+
+	process_req->raid_ch->num_ios++;
+
+	rc = process->raid_bdev->module->submit_process_request(process_req);
+	if (rc != 0) {
+		raid_bdev_process_request_complete(process_req, rc);
+	}
+}
+
+static void raid_bdev_process_finish(struct raid_bdev_process *process);
+
+static int
+raid_bdev_process_poll(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(process->raid_ch);
+	uint64_t now;
+
+	if (process->window_busy) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	if (process->state == RAID_PROCESS_STATE_RUNNING &&
+	    process->offset == raid_bdev->bdev.blockcnt) {
+		process->state = RAID_PROCESS_STATE_STOPPING;
+	}
+
+	if (process->state == RAID_PROCESS_STATE_STOPPING) {
+		raid_bdev_process_finish(process);
+		return SPDK_POLLER_BUSY;
+	}
+
+	now = spdk_get_ticks();
+	if (now < process->next_tsc || raid_ch->is_suspended) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	process->window_busy = true;
+	process->window_start_tsc = now;
+
+	pthread_mutex_lock(&raid_bdev->mutex);
+	process->window_end = spdk_min(process->offset + process->window_size,
+				       raid_bdev->bdev.blockcnt);
+	pthread_mutex_unlock(&raid_bdev->mutex);
+
+	spdk_for_each_channel(raid_bdev, raid_bdev_channel_process_lock_window, process,
+			      raid_bdev_process_window_locked);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+raid_bdev_process_free(struct raid_bdev_process *process)
+{
+	spdk_dma_free(process->req.buf);
+	spdk_dma_free(process->req.md_buf);
+	free(process);
+}
+
+static void
+raid_bdev_process_finish_write_sb_cb(bool success, struct raid_bdev *raid_bdev)
+{
+	if (!success) {
+		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock\n", raid_bdev->bdev.name);
+	}
+}
+
+static void
+raid_bdev_process_finish_update_sb(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_base_bdev_info *target = process->target;
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	struct raid_bdev_sb_base_bdev *sb_base_bdev = NULL;
+	uint8_t slot = raid_bdev_process_target_idx(process);
+	uint8_t i;
+	int rc;
+
+	for (i = 0; i < sb->base_bdevs_size; i++) {
+		if (sb->base_bdevs[i].slot == slot) {
+			sb_base_bdev = &sb->base_bdevs[i];
+			break;
+		}
+	}
+
+	if (sb_base_bdev == NULL) {
+		sb_base_bdev = &sb->base_bdevs[sb->base_bdevs_size++];
+		sb->length += sizeof(*sb_base_bdev);
+		sb_base_bdev->slot = slot;
+	}
+
+	spdk_uuid_copy(&sb_base_bdev->uuid, &target->uuid);
+	sb_base_bdev->data_offset = target->data_offset;
+	sb_base_bdev->data_size = target->data_size;
+	sb_base_bdev->state = RAID_SB_BASE_BDEV_CONFIGURED;
+
+	rc = raid_bdev_write_superblock(raid_bdev, raid_bdev_process_finish_write_sb_cb);
+	if (rc != 0) {
+		raid_bdev_process_finish_write_sb_cb(false, raid_bdev);
+	}
+}
+
+static void
+raid_bdev_process_finish_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_base_bdev_info *target = process->target;
+
+	if (process->status == 0) {
+		SPDK_NOTICELOG("Finished rebuild of base bdev %s on raid bdev %s\n",
+			       target->name, raid_bdev->bdev.name);
+		raid_bdev->num_base_bdevs_operational++;
+		if (raid_bdev->sb != NULL) {
+			raid_bdev_process_finish_update_sb(process);
+		}
+		if (target->remove_scheduled) {
+			/* Removed while finishing the process */
+			target->remove_scheduled = false;
+			raid_bdev_remove_base_bdev(target->bdev);
+		}
+	} else {
+		SPDK_ERRLOG("Rebuild of base bdev %s on raid bdev %s failed: %s\n",
+			    target->name, raid_bdev->bdev.name, spdk_strerror(-process->status));
+		pthread_mutex_lock(&raid_bdev->mutex);
+		target->remove_scheduled = false;
+		raid_bdev_free_base_bdev_resource(target);
+		pthread_mutex_unlock(&raid_bdev->mutex);
+	}
+
+	spdk_put_io_channel(process->raid_ch);
+	raid_bdev_process_free(process);
+}
+
+static void
+raid_bdev_channel_process_finish(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	struct raid_bdev_io_channel *ch_processed = raid_ch->process.ch_processed;
+	uint8_t idx = raid_bdev_process_target_idx(process);
+
+	if (ch_processed == NULL) {
+		spdk_for_each_channel_continue(i, 0);
+		return;
+	}
+
+	/* From now on the target is either a regular member of the channel or not used at all */
+	raid_ch->process.ch_processed = NULL;
+	raid_ch->process.iter = NULL;
+	if (process->status == 0) {
+		raid_ch->base_channel[idx] = ch_processed->base_channel[idx];
+	}
+
+	raid_bdev_channel_process_resubmit_held(raid_ch);
+
+	if (ch_processed->num_ios == 0) {
+		raid_bdev_channel_process_free(ch_processed);
+	} else if (process->status != 0) {
+		/* Wait for the IOs still using the target's channel */
+		ch_processed->process.iter = i;
+		return;
+	}
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+raid_bdev_process_finish(struct raid_bdev_process *process)
+{
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(!process->window_busy);
+
+	spdk_poller_unregister(&process->poller);
+
+	pthread_mutex_lock(&raid_bdev->mutex);
+	raid_bdev->process = NULL;
+	pthread_mutex_unlock(&raid_bdev->mutex);
+
+	spdk_for_each_channel(raid_bdev, raid_bdev_channel_process_finish, process,
+			      raid_bdev_process_finish_done);
+}
+
+static void
+raid_bdev_process_stop(struct raid_bdev_process *process, int status)
+{
+	if (process->state != RAID_PROCESS_STATE_STOPPING) {
+		process->state = RAID_PROCESS_STATE_STOPPING;
+		process->status = status;
+	}
+}
+
+static void
+raid_bdev_channel_process_start(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	int rc;
+
+	pthread_mutex_lock(&process->raid_bdev->mutex);
+	rc = raid_bdev_channel_process_setup(raid_ch, process);
+	pthread_mutex_unlock(&process->raid_bdev->mutex);
+
+	spdk_for_each_channel_continue(i, rc);
+}
+
+static void
+raid_bdev_process_start_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
+
+	if (status != 0) {
+		raid_bdev_process_stop(process, status);
+	} else if (process->state == RAID_PROCESS_STATE_INIT) {
+		process->state = RAID_PROCESS_STATE_RUNNING;
+		SPDK_NOTICELOG("Started rebuild of base bdev %s on raid bdev %s\n",
+			       process->target->name, process->raid_bdev->bdev.name);
+	}
+
+	process->poller = SPDK_POLLER_REGISTER(raid_bdev_process_poll, process,
+					       RAID_BDEV_PROCESS_POLL_PERIOD_US);
+	if (process->poller == NULL) {
+		raid_bdev_process_stop(process, -ENOMEM);
+		raid_bdev_process_finish(process);
+	}
+}
+
+static int
+raid_bdev_start_rebuild(struct raid_base_bdev_info *target)
+{
+	struct raid_bdev *raid_bdev = target->raid_bdev;
+	struct raid_bdev_process *process;
+	uint32_t write_unit_size = spdk_max(raid_bdev->bdev.write_unit_size, 1);
+	size_t buf_align = spdk_bdev_get_buf_align(&raid_bdev->bdev);
+	size_t buf_size;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(raid_bdev->process == NULL);
+
+	process = calloc(1, sizeof(*process));
+	if (process == NULL) {
+		return -ENOMEM;
+	}
+
+	process->raid_bdev = raid_bdev;
+	process->target = target;
+	process->state = RAID_PROCESS_STATE_INIT;
+	process->window_size = (uint64_t)g_opts.process_window_size_kb * 1024 /
+			       raid_bdev->bdev.blocklen;
+	process->window_size = spdk_max(process->window_size / write_unit_size, 1) *
+			       write_unit_size;
+
+	buf_size = process->window_size * 2 * raid_bdev->bdev.blocklen;
+	process->req.buf = spdk_dma_malloc(buf_size, buf_align, NULL);
+	if (process->req.buf == NULL) {
+		raid_bdev_process_free(process);
+		return -ENOMEM;
+	}
+
+	if (raid_bdev->bdev.md_len != 0 && !raid_bdev->bdev.md_interleave) {
+		buf_size = process->window_size * 2 * raid_bdev->bdev.md_len;
+		process->req.md_buf = spdk_dma_malloc(buf_size, buf_align, NULL);
+		if (process->req.md_buf == NULL) {
+			raid_bdev_process_free(process);
+			return -ENOMEM;
+		}
+	}
+
+	pthread_mutex_lock(&raid_bdev->mutex);
+	raid_bdev->process = process;
+	target->is_configured = true;
+	raid_bdev->num_base_bdevs_discovered++;
+	pthread_mutex_unlock(&raid_bdev->mutex);
+
+	process->raid_ch = spdk_get_io_channel(raid_bdev);
+	if (process->raid_ch == NULL) {
+		pthread_mutex_lock(&raid_bdev->mutex);
+		raid_bdev->process = NULL;
+		pthread_mutex_unlock(&raid_bdev->mutex);
+		raid_bdev_process_free(process);
+		return -ENOMEM;
+	}
+
+	spdk_for_each_channel(raid_bdev, raid_bdev_channel_process_start, process,
+			      raid_bdev_process_start_done);
+
+	return 0;
+}
+
+static int
+raid_bdev_configure_base_bdev_online(struct raid_base_bdev_info *base_info)
+{
+	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+	struct raid_base_bdev_info *iter;
+	uint64_t data_size = 0;
+
+	if (raid_bdev->module->submit_process_request == NULL) {
+		SPDK_ERRLOG("Adding base bdevs to online raid bdev %s is not supported\n",
+			    raid_bdev->bdev.name);
+		return -EPERM;
+	}
+
+	if (raid_bdev->process != NULL) {
+		SPDK_ERRLOG("A process is already running on raid bdev %s\n", raid_bdev->bdev.name);
+		return -EBUSY;
+	}
+
+	if (base_info->bdev->blocklen != raid_bdev->bdev.blocklen) {
+		SPDK_ERRLOG("Blocklen of bdev %s does not match raid bdev %s\n",
+			    base_info->name, raid_bdev->bdev.name);
+		return -EINVAL;
+	}
+
+	if (raid_bdev->bdev.md_len != spdk_bdev_get_md_size(base_info->bdev) ||
+	    raid_bdev->bdev.md_interleave != spdk_bdev_is_md_interleaved(base_info->bdev) ||
+	    raid_bdev->bdev.dif_type != spdk_bdev_get_dif_type(base_info->bdev) ||
+	    raid_bdev->bdev.dif_is_head_of_md != spdk_bdev_is_dif_head_of_md(base_info->bdev) ||
+	    raid_bdev->bdev.dif_check_flags != base_info->bdev->dif_check_flags) {
+		SPDK_ERRLOG("Metadata format of bdev %s does not match raid bdev %s\n",
+			    base_info->name, raid_bdev->bdev.name);
+		return -EINVAL;
+	}
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, iter) {
+		if (iter != base_info && iter->is_configured) {
+			data_size = iter->data_size;
+			break;
+		}
+	}
+
+	if (base_info->data_size < data_size) {
+		SPDK_ERRLOG("Bdev %s is too small to be added to raid bdev %s\n",
+			    base_info->name, raid_bdev->bdev.name);
+		return -EINVAL;
+	}
+	base_info->data_size = data_size;
+
+	return raid_bdev_start_rebuild(base_info);
+}
+
 static void
 raid_bdev_configure_base_bdev_cont(struct raid_base_bdev_info *base_info)
 {
 	struct raid_bdev *raid_bdev = base_info->raid_bdev;
 	int rc;
 
+	if (raid_bdev->state == RAID_BDEV_STATE_ONLINE) {
+		rc = raid_bdev_configure_base_bdev_online(base_info);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to add base bdev %s to raid bdev %s: %s\n",
+				    base_info->name, raid_bdev->bdev.name, spdk_strerror(-rc));
+			raid_bdev_free_base_bdev_resource(base_info);
+		}
+		return;
+	}
+
 	base_info->is_configured = true;
 
 	raid_bdev->num_base_bdevs_discovered++;
@@ -1997,8 +3115,6 @@ raid_bdev_configure_base_bdev(struct raid_base_bdev_info *base_info)
 
 	SPDK_DEBUGLOG(bdev_raid, "bdev %s is claimed\n", bdev->name);
 
-	assert(raid_bdev->state != RAID_BDEV_STATE_ONLINE);
-
 	base_info->app_thread_ch = spdk_bdev_get_io_channel(desc);
 	if (base_info->app_thread_ch == NULL) {
 		SPDK_ERRLOG("Failed to get io channel\n");
@@ -2130,6 +3246,49 @@ raid_bdev_add_base_device(struct raid_bdev *raid_bdev, const char *name, uint8_t
 	return _raid_bdev_add_base_device(raid_bdev, name, NULL, slot, 0, 0);
 }
 
+/*
+ * brief:
+ * raid_bdev_attach_base_bdev adds the base bdev to the first free slot of the raid bdev.
+ * If the raid bdev is online, the base bdev is rebuilt in the background.
+ * params:
+ * raid_bdev - pointer to raid bdev
+ * name - name of the base bdev
+ * returns:
+ * 0 - success
+ * non zero - failure
+ */
+int
+raid_bdev_attach_base_bdev(struct raid_bdev *raid_bdev, const char *name)
+{
+	struct raid_base_bdev_info *base_info;
+
+	assert(name != NULL);
+
+	if (raid_bdev->state == RAID_BDEV_STATE_ONLINE) {
+		if (raid_bdev->module->submit_process_request == NULL) {
+			SPDK_ERRLOG("Adding base bdevs to online raid bdev %s is not supported\n",
+				    raid_bdev->bdev.name);
+			return -EPERM;
+		}
+
+		if (raid_bdev->process != NULL) {
+			SPDK_ERRLOG("A process is already running on raid bdev %s\n",
+				    raid_bdev->bdev.name);
+			return -EBUSY;
+		}
+	}
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (base_info->name == NULL && spdk_uuid_is_null(&base_info->uuid)) {
+			return raid_bdev_add_base_device(raid_bdev, name,
+							 base_info - raid_bdev->base_bdev_info);
+		}
+	}
+
+	SPDK_ERRLOG("No free slot for base bdev %s on raid bdev %s\n", name, raid_bdev->bdev.name);
+	return -ENOSPC;
+}
+
 static int
 raid_bdev_add_base_device_from_sb(struct raid_bdev *raid_bdev,
 				  const struct raid_bdev_sb_base_bdev *sb_base_bdev)
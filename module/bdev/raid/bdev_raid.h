@@ -7,12 +7,16 @@
 #define SPDK_BDEV_RAID_INTERNAL_H
 
 #include "spdk/bdev_module.h"
+#include "spdk/likely.h"
 #include "spdk/uuid.h"
 
 #include "bdev_raid_sb.h"
 
 #define RAID_BDEV_MIN_DATA_OFFSET_SIZE	(1024*1024) /* 1 MiB */
 
+/* Maximum number of NUMA sockets the IOs can be forwarded to */
+#define RAID_BDEV_MAX_SOCKETS		8
+
 SPDK_STATIC_ASSERT(RAID_BDEV_SB_MAX_LENGTH < RAID_BDEV_MIN_DATA_OFFSET_SIZE,
 		   "Incorrect min data offset");
 
@@ -21,6 +25,7 @@ enum raid_level {
 	RAID0			= 0,
 	RAID1			= 1,
 	RAID5F			= 95, /* 0x5f */
+	RAID6F			= 111, /* 0x6f */
 	CONCAT			= 99,
 };
 
@@ -114,6 +119,24 @@ struct raid_bdev_io {
 	/* Private data for the raid module */
 	void				*module_private;
 
+	/* Generation of the process window this IO is counted in, -1 if not counted */
+	int8_t				process_gen;
+
+	/* State of an IO forwarded to a thread on the NUMA socket of its base bdev */
+	struct {
+		/* Thread the IO was submitted on, NULL if forwarding wasn't attempted */
+		struct spdk_thread		*thread;
+
+		/* Raid bdev IO channel of the thread the IO was forwarded to */
+		struct spdk_io_channel		*ch;
+
+		/* Function submitting the IO on the thread it was forwarded to */
+		spdk_msg_fn			submit_fn;
+
+		/* Status of the forwarded IO, passed back to the submitting thread */
+		enum spdk_bdev_io_status	status;
+	} numa;
+
 	TAILQ_ENTRY(raid_bdev_io)	link;
 };
 
@@ -188,6 +211,34 @@ struct raid_bdev {
 
 	/* Superblock write context */
 	void				*sb_write_ctx;
+
+	/* Requested write-intent bitmap region size in KB, 0 to not use the bitmap */
+	uint32_t			write_intent_region_size_kb;
+
+	/* Write-intent bitmap region size [blocks] set by the module, 0 if not used */
+	uint32_t			write_intent_region_size;
+
+	/* Background process (rebuild) running on this raid bdev, NULL if none */
+	struct raid_bdev_process	*process;
+
+	/* NUMA affinity of the IOs to the base bdevs, see raid_bdev_io_numa_forward() */
+	struct {
+		/* Set from the numa_affinity option when the raid bdev is configured */
+		bool				enabled;
+
+		/*
+		 * Channels on each socket, the thread of the first one forwards the IOs. Protected by
+		 * the raid bdev mutex.
+		 */
+		TAILQ_HEAD(, raid_bdev_io_channel) channels[RAID_BDEV_MAX_SOCKETS];
+		struct spdk_thread		*threads[RAID_BDEV_MAX_SOCKETS];
+
+		/* IOs forwarded to another socket */
+		uint64_t			forwarded_ios;
+
+		/* IOs submitted to a base bdev on another socket without a thread to forward to */
+		uint64_t			remote_ios;
+	} numa;
 };
 
 #define RAID_FOR_EACH_BASE_BDEV(r, i) \
@@ -215,6 +266,115 @@ struct raid_bdev_io_channel {
 
 	/* List of suspended IOs */
 	TAILQ_HEAD(, raid_bdev_io) suspended_ios;
+
+	/* State of the background process, used only while a process is running */
+	struct {
+		/* Offset up to which the target base bdev is up to date [blocks] */
+		uint64_t		offset;
+
+		/* End of the window currently being processed [blocks] */
+		uint64_t		window_end;
+
+		/* Copy of this channel including the target base bdev */
+		struct raid_bdev_io_channel *ch_processed;
+
+		/* For ch_processed only, the channel it belongs to */
+		struct raid_bdev_io_channel *parent;
+
+		/* Current generation of the written IOs that may overlap the next windows */
+		uint8_t			gen;
+
+		/* Number of such IOs in flight for each generation */
+		uint32_t		num_ios[2];
+
+		/* Iterator waiting for the IOs of the previous generation or ch_processed */
+		struct spdk_io_channel_iter *iter;
+
+		/* Foreground IO completion statistics */
+		uint64_t		fg_ios;
+		uint64_t		fg_ticks;
+
+		/* Writes held until the current window is processed */
+		TAILQ_HEAD(, raid_bdev_io) held_ios;
+	} process;
+
+	/* NUMA socket of the thread, SPDK_ENV_SOCKET_ID_ANY if unknown */
+	int32_t			socket_id;
+
+	/* Thread of the channel */
+	struct spdk_thread	*thread;
+
+	/* Link in the raid bdev's list of channels on the socket, used with NUMA affinity */
+	TAILQ_ENTRY(raid_bdev_io_channel) numa_link;
+};
+
+/*
+ * Request of a background process, e.g. a rebuild, submitted to the raid module. The module
+ * must bring the range of the target base bdev up to date and then call
+ * raid_bdev_process_request_complete().
+ */
+struct raid_bdev_process_request {
+	/* The process this request belongs to */
+	struct raid_bdev_process	*process;
+
+	/* Raid bdev IO channel of the process, without the target base bdev */
+	struct raid_bdev_io_channel	*raid_ch;
+
+	/* Base bdev being processed and its IO channel */
+	struct raid_base_bdev_info	*target;
+	struct spdk_io_channel		*target_ch;
+
+	/* Range of the raid bdev to process [blocks] */
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+
+	/* Data and metadata buffers, large enough for twice num_blocks */
+	void				*buf;
+	void				*md_buf;
+
+	/* Used by the raid module to track its IOs */
+	uint8_t				num_ios;
+	int				status;
+	void				*module_private;
+};
+
+enum raid1_read_policy {
+	/* Spread the read blocks evenly across the mirrors */
+	RAID1_READ_POLICY_BANDWIDTH,
+
+	/* Prefer the mirrors with the lowest read latency and queue depth */
+	RAID1_READ_POLICY_LATENCY,
+
+	RAID1_READ_POLICY_INVALID,
+};
+
+struct raid_bdev_opts {
+	/* Size of the range of the raid bdev processed at a time [KiB] */
+	uint32_t process_window_size_kb;
+
+	/* Maximum bandwidth of a background process [MiB/s], 0 for unlimited */
+	uint32_t process_max_bandwidth_mb_sec;
+
+	/* Foreground latency above which a background process slows down [us], 0 to disable */
+	uint32_t process_latency_threshold_us;
+
+	/* Read balancing policy of raid1 bdevs, applied when a raid1 bdev is started */
+	enum raid1_read_policy raid1_read_policy;
+
+	/*
+	 * Number of stripes per channel in which raid5f bdevs collect partial stripe writes,
+	 * 0 to accept only full stripe writes. Applied when a raid5f bdev is started.
+	 */
+	uint32_t raid5f_stripe_cache_size;
+
+	/* Time a partially written stripe waits for more writes before it is flushed [us] */
+	uint32_t raid5f_stripe_cache_flush_us;
+
+	/*
+	 * Forward the IOs of raid0 and concat bdevs to a thread on the NUMA socket of the base
+	 * bdev they go to. Applied when a raid bdev is configured.
+	 */
+	bool numa_affinity;
 };
 
 /* TAIL head for raid bdev list */
@@ -229,6 +389,7 @@ int raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bde
 		     const struct spdk_uuid *uuid, bool superblock);
 void raid_bdev_delete(struct raid_bdev *raid_bdev, raid_bdev_destruct_cb cb_fn, void *cb_ctx);
 int raid_bdev_add_base_device(struct raid_bdev *raid_bdev, const char *name, uint8_t slot);
+int raid_bdev_attach_base_bdev(struct raid_bdev *raid_bdev, const char *name);
 struct raid_bdev *raid_bdev_find_by_name(const char *name);
 enum raid_level raid_bdev_str_to_level(const char *str);
 const char *raid_bdev_level_to_str(enum raid_level level);
@@ -236,6 +397,10 @@ enum raid_bdev_state raid_bdev_str_to_state(const char *str);
 const char *raid_bdev_state_to_str(enum raid_bdev_state state);
 void raid_bdev_write_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ctx *w);
 int raid_bdev_remove_base_bdev(struct spdk_bdev *base_bdev);
+void raid_bdev_get_opts(struct raid_bdev_opts *opts);
+int raid_bdev_set_opts(const struct raid_bdev_opts *opts);
+enum raid1_read_policy raid_bdev_str_to_read_policy(const char *str);
+const char *raid_bdev_read_policy_to_str(enum raid1_read_policy policy);
 
 /*
  * RAID module descriptor
@@ -300,6 +465,12 @@ struct raid_bdev_module {
 	 */
 	void (*resize)(struct raid_bdev *raid_bdev);
 
+	/*
+	 * Handler for background process requests. Required to add base bdevs to an online
+	 * raid. The range of the request is aligned to the raid bdev's write unit size.
+	 */
+	int (*submit_process_request)(struct raid_bdev_process_request *process_req);
+
 	TAILQ_ENTRY(raid_bdev_module) link;
 };
 
@@ -321,6 +492,25 @@ void raid_bdev_queue_io_wait(struct raid_bdev_io *raid_io, struct spdk_bdev *bde
 			     struct spdk_io_channel *ch, spdk_bdev_io_wait_cb cb_fn);
 void raid_bdev_io_complete(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status);
 void raid_bdev_module_stop_done(struct raid_bdev *raid_bdev);
+void raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status);
+bool raid_bdev_io_numa_forward(struct raid_bdev_io *raid_io, struct raid_base_bdev_info *base_info,
+			       spdk_msg_fn submit_fn);
+
+/*
+ * Returns the IO channel of a base bdev to submit the raid_io to, on the thread it was
+ * forwarded to if raid_bdev_io_numa_forward() forwarded it.
+ */
+static inline struct spdk_io_channel *
+raid_bdev_io_base_channel(struct raid_bdev_io *raid_io, uint8_t idx)
+{
+	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
+
+	if (spdk_unlikely(raid_io->numa.ch != NULL)) {
+		raid_ch = spdk_io_channel_get_ctx(raid_io->numa.ch);
+	}
+
+	return raid_ch->base_channel[idx];
+}
 
 /**
  * Raid bdev I/O read/write wrapper for spdk_bdev_readv_blocks_ext function.
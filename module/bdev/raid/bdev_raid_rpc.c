@@ -137,6 +137,9 @@ struct rpc_bdev_raid_create {
 
 	/* superblock support */
 	bool superblock;
+
+	/* write-intent bitmap region size in KB */
+	uint32_t write_intent_region_size_kb;
 };
 
 /*
@@ -204,6 +207,7 @@ static const struct spdk_json_object_decoder rpc_bdev_raid_create_decoders[] = {
 	{"base_bdevs", offsetof(struct rpc_bdev_raid_create, base_bdevs), decode_base_bdevs},
 	{"uuid", offsetof(struct rpc_bdev_raid_create, uuid), spdk_json_decode_string, true},
 	{"superblock", offsetof(struct rpc_bdev_raid_create, superblock), spdk_json_decode_bool, true},
+	{"write_intent_region_size_kb", offsetof(struct rpc_bdev_raid_create, write_intent_region_size_kb), spdk_json_decode_uint32, true},
 };
 
 /*
@@ -244,6 +248,12 @@ rpc_bdev_raid_create(struct spdk_jsonrpc_request *request,
 		uuid = &decoded_uuid;
 	}
 
+	if (req.write_intent_region_size_kb != 0 && (req.level != RAID1 || !req.superblock)) {
+		spdk_jsonrpc_send_error_response(request, -EINVAL,
+						 "Write-intent bitmap requires raid1 with superblock");
+		goto cleanup;
+	}
+
 	rc = raid_bdev_create(req.name, req.strip_size_kb, req.base_bdevs.num_base_bdevs,
 			      req.level, &raid_bdev, uuid, req.superblock);
 	if (rc != 0) {
@@ -252,6 +262,7 @@ rpc_bdev_raid_create(struct spdk_jsonrpc_request *request,
 						     req.name, spdk_strerror(-rc));
 		goto cleanup;
 	}
+	raid_bdev->write_intent_region_size_kb = req.write_intent_region_size_kb;
 
 	for (i = 0; i < req.base_bdevs.num_base_bdevs; i++) {
 		const char *base_bdev_name = req.base_bdevs.base_bdevs[i];
@@ -442,3 +453,146 @@ cleanup:
 	free(name);
 }
 SPDK_RPC_REGISTER("bdev_raid_remove_base_bdev", rpc_bdev_raid_remove_base_bdev, SPDK_RPC_RUNTIME)
+
+/*
+ * Input structure for RPC bdev_raid_add_base_bdev
+ */
+struct rpc_bdev_raid_add_base_bdev {
+	/* Base bdev name */
+	char *base_bdev;
+
+	/* Raid bdev name */
+	char *raid_bdev;
+};
+
+static void
+free_rpc_bdev_raid_add_base_bdev(struct rpc_bdev_raid_add_base_bdev *req)
+{
+	free(req->base_bdev);
+	free(req->raid_bdev);
+}
+
+/*
+ * Decoder object for RPC bdev_raid_add_base_bdev
+ */
+static const struct spdk_json_object_decoder rpc_bdev_raid_add_base_bdev_decoders[] = {
+	{"base_bdev", offsetof(struct rpc_bdev_raid_add_base_bdev, base_bdev), spdk_json_decode_string},
+	{"raid_bdev", offsetof(struct rpc_bdev_raid_add_base_bdev, raid_bdev), spdk_json_decode_string},
+};
+
+/*
+ * brief:
+ * rpc_bdev_raid_add_base_bdev function is the RPC for adding a base bdev to a raid bdev.
+ * If the raid bdev is online, the base bdev is rebuilt in the background.
+ * params:
+ * request - pointer to json rpc request
+ * params - pointer to request parameters
+ * returns:
+ * none
+ */
+static void
+rpc_bdev_raid_add_base_bdev(struct spdk_jsonrpc_request *request,
+			    const struct spdk_json_val *params)
+{
+	struct rpc_bdev_raid_add_base_bdev req = {};
+	struct raid_bdev *raid_bdev;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_raid_add_base_bdev_decoders,
+				    SPDK_COUNTOF(rpc_bdev_raid_add_base_bdev_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_PARSE_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	raid_bdev = raid_bdev_find_by_name(req.raid_bdev);
+	if (raid_bdev == NULL) {
+		spdk_jsonrpc_send_error_response_fmt(request, -ENODEV, "raid bdev %s not found",
+						     req.raid_bdev);
+		goto cleanup;
+	}
+
+	rc = raid_bdev_attach_base_bdev(raid_bdev, req.base_bdev);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response_fmt(request, rc, "Failed to add base bdev %s to raid bdev %s",
+						     req.base_bdev, req.raid_bdev);
+		goto cleanup;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+
+cleanup:
+	free_rpc_bdev_raid_add_base_bdev(&req);
+}
+SPDK_RPC_REGISTER("bdev_raid_add_base_bdev", rpc_bdev_raid_add_base_bdev, SPDK_RPC_RUNTIME)
+
+static int
+decode_raid1_read_policy(const struct spdk_json_val *val, void *out)
+{
+	int ret;
+	char *str = NULL;
+	enum raid1_read_policy policy;
+
+	ret = spdk_json_decode_string(val, &str);
+	if (ret == 0 && str != NULL) {
+		policy = raid_bdev_str_to_read_policy(str);
+		if (policy == RAID1_READ_POLICY_INVALID) {
+			ret = -EINVAL;
+		} else {
+			*(enum raid1_read_policy *)out = policy;
+		}
+	}
+
+	free(str);
+	return ret;
+}
+
+/*
+ * Decoder object for RPC bdev_raid_set_options
+ */
+static const struct spdk_json_object_decoder rpc_bdev_raid_set_options_decoders[] = {
+	{"process_window_size_kb", offsetof(struct raid_bdev_opts, process_window_size_kb), spdk_json_decode_uint32, true},
+	{"process_max_bandwidth_mb_sec", offsetof(struct raid_bdev_opts, process_max_bandwidth_mb_sec), spdk_json_decode_uint32, true},
+	{"process_latency_threshold_us", offsetof(struct raid_bdev_opts, process_latency_threshold_us), spdk_json_decode_uint32, true},
+	{"raid1_read_policy", offsetof(struct raid_bdev_opts, raid1_read_policy), decode_raid1_read_policy, true},
+	{"raid5f_stripe_cache_size", offsetof(struct raid_bdev_opts, raid5f_stripe_cache_size), spdk_json_decode_uint32, true},
+	{"raid5f_stripe_cache_flush_us", offsetof(struct raid_bdev_opts, raid5f_stripe_cache_flush_us), spdk_json_decode_uint32, true},
+	{"numa_affinity", offsetof(struct raid_bdev_opts, numa_affinity), spdk_json_decode_bool, true},
+};
+
+/*
+ * brief:
+ * rpc_bdev_raid_set_options function is the RPC for setting the options of the raid module.
+ * params:
+ * request - pointer to json rpc request
+ * params - pointer to request parameters
+ * returns:
+ * none
+ */
+static void
+rpc_bdev_raid_set_options(struct spdk_jsonrpc_request *request,
+			  const struct spdk_json_val *params)
+{
+	struct raid_bdev_opts opts;
+	int rc;
+
+	raid_bdev_get_opts(&opts);
+	if (params && spdk_json_decode_object(params, rpc_bdev_raid_set_options_decoders,
+					      SPDK_COUNTOF(rpc_bdev_raid_set_options_decoders),
+					      &opts)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_PARSE_ERROR,
+						 "spdk_json_decode_object failed");
+		return;
+	}
+
+	rc = raid_bdev_set_opts(&opts);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+SPDK_RPC_REGISTER("bdev_raid_set_options", rpc_bdev_raid_set_options,
+		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
@@ -11,7 +11,7 @@
 #include "spdk/uuid.h"
 
 #define RAID_BDEV_SB_VERSION_MAJOR	1
-#define RAID_BDEV_SB_VERSION_MINOR	0
+#define RAID_BDEV_SB_VERSION_MINOR	1
 
 #define RAID_BDEV_SB_NAME_SIZE		64
 
@@ -77,7 +77,12 @@ struct raid_bdev_superblock {
 	/* number of raid base devices */
 	uint8_t			num_base_bdevs;
 
-	uint8_t			reserved[86];
+	uint8_t			reserved0[3];
+
+	/* size of the write-intent bitmap regions [blocks], 0 if not used */
+	uint32_t		write_intent_region_size;
+
+	uint8_t			reserved[79];
 
 	/* size of the base bdevs array */
 	uint8_t			base_bdevs_size;
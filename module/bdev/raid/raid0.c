@@ -101,9 +101,13 @@ raid0_submit_rw_request(struct raid_bdev_io *raid_io)
 	 * bdev lba, base bdev child io length in blocks, buffer, completion
 	 * function and function callback context
 	 */
+	if (raid_bdev_io_numa_forward(raid_io, base_info, _raid0_submit_rw_request)) {
+		return;
+	}
+
 	assert(raid_ch != NULL);
 	assert(raid_ch->base_channel);
-	base_ch = raid_ch->base_channel[pd_idx];
+	base_ch = raid_bdev_io_base_channel(raid_io, pd_idx);
 
 	io_opts.size = sizeof(io_opts);
 	io_opts.memory_domain = bdev_io->u.bdev.memory_domain;
@@ -5,14 +5,34 @@
 
 #include "bdev_raid.h"
 
+#include "spdk/env.h"
 #include "spdk/likely.h"
 #include "spdk/log.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+struct raid1_wib;
 
 struct raid1_info {
 	/* The parent raid bdev */
 	struct raid_bdev *raid_bdev;
+
+	/* Write-intent bitmap, NULL if not used */
+	struct raid1_wib *wib;
+
+	/* Policy for selecting the base bdev to read from */
+	enum raid1_read_policy read_policy;
 };
 
+/*
+ * With the latency read policy, every this many reads go to the next base bdev regardless of
+ * its latency, so that the latency of the base bdevs that are not preferred stays up to date.
+ */
+#define RAID1_READ_LATENCY_PROBE_INTERVAL	256
+
+/* Weight of a new sample in the moving average of the read latency, as a shift */
+#define RAID1_READ_LATENCY_EWMA_SHIFT		3
+
 struct raid1_io_channel {
 	/* Index of last base bdev used for reads */
 	uint8_t			base_bdev_read_idx;
@@ -22,28 +42,934 @@ struct raid1_io_channel {
 
 	/* Maximum read bandwidth from all base_bdevs */
 	uint64_t		base_bdev_max_read_bw;
+
+	/* Reads in flight and moving average of the read latency [ticks] for base_bdevs */
+	uint32_t		*base_bdev_reads_outstanding;
+	uint64_t		*base_bdev_read_latency;
+
+	/* Reads since the last one sent to a base bdev to refresh its latency */
+	uint32_t		reads_since_probe;
 };
 
+static void raid1_submit_rw_request(struct raid_bdev_io *raid_io);
+
 static void
-raid1_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+_raid1_submit_rw_request(void *_raid_io)
 {
-	struct raid_bdev_io *raid_io = cb_arg;
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid1_submit_rw_request(raid_io);
+}
+
+TAILQ_HEAD(raid1_io_tailq, raid_bdev_io);
+
+/*
+ * Write-intent bitmap
+ *
+ * When the raid has a superblock, the data area of the raid is divided into regions and a
+ * bitmap marking the regions that might have writes in flight is stored right after the
+ * superblock on each base bdev.  A region's bit is persisted before the first write to it is
+ * submitted and is cleared lazily, after the region hasn't been written to for a while.  When
+ * the raid is assembled again after an unclean shutdown, only the regions marked in the
+ * bitmap need to be resynchronized.
+ *
+ * The bitmaps that are accessed from the IO threads (dirty, active, unsynced and the inflight
+ * counters) are only modified using atomic operations.  Everything else is owned by the
+ * thread that started the raid.
+ */
+#define RAID1_WIB_MAX_REGIONS		(1 << 20)
+#define RAID1_WIB_CLEAN_PERIOD_US	(5 * 1000 * 1000)
+#define RAID1_RESYNC_CHUNK_SIZE		(1024 * 1024)
+#define RAID1_RESYNC_POLL_PERIOD_US	1000
+#define RAID1_WIB_NO_REGION		UINT64_MAX
+
+struct raid1_wib {
+	struct raid1_info		*r1info;
+	struct spdk_thread		*thread;
+
+	/* Region size in blocks */
+	uint64_t			region_size;
+	uint32_t			region_shift;
+	uint64_t			num_regions;
+	uint64_t			num_words;
+
+	/* Location of the bitmap on each base bdev, in blocks */
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+
+	/* Regions that are marked in the bitmap on disk */
+	uint64_t			*dirty;
+	/* Regions that were written to since the last cleaning pass */
+	uint64_t			*active;
+	/* Regions that may differ between the base bdevs */
+	uint64_t			*unsynced;
+	/* Number of writes in flight for each region */
+	uint32_t			*inflight;
+	/* Region that is currently being resynchronized */
+	uint64_t			resync_region;
+
+	/* Contents of the bitmap that should be on disk */
+	uint64_t			*target;
+	/* DMA buffer used to write and load the bitmap */
+	uint64_t			*buf;
+
+	/* Writes waiting for the next bitmap write */
+	struct raid1_io_tailq		pending;
+	/* Writes waiting for the bitmap write in progress */
+	struct raid1_io_tailq		flushing;
+	/* Writes waiting for the bitmap to be loaded or a region to be resynchronized */
+	struct raid1_io_tailq		waiting;
+
+	bool				loading;
+	bool				flush_in_progress;
+	bool				flush_needed;
+	bool				stopping;
+	uint8_t				io_remaining;
+	uint8_t				io_succeeded;
+	uint8_t				load_idx;
+	struct spdk_poller		*clean_poller;
+
+	/* Resync state */
+	struct spdk_poller		*resync_poller;
+	uint8_t				resync_source;
+	uint64_t			resync_next;
+	uint64_t			resync_offset;
+	uint64_t			resync_blocks;
+	uint64_t			resync_chunk_blocks;
+	void				*resync_buf;
+	void				*resync_md_buf;
+	uint8_t				resync_io_remaining;
+	bool				resync_failed;
+};
+
+static inline bool
+raid1_wib_test(uint64_t *map, uint64_t region)
+{
+	return __atomic_load_n(&map[region / 64], __ATOMIC_SEQ_CST) & (1ULL << (region % 64));
+}
+
+static inline void
+raid1_wib_set(uint64_t *map, uint64_t region)
+{
+	__atomic_fetch_or(&map[region / 64], 1ULL << (region % 64), __ATOMIC_SEQ_CST);
+}
+
+static inline void
+raid1_wib_clear(uint64_t *map, uint64_t region)
+{
+	__atomic_fetch_and(&map[region / 64], ~(1ULL << (region % 64)), __ATOMIC_SEQ_CST);
+}
+
+static void
+raid1_wib_io_range(struct raid1_wib *wib, struct raid_bdev_io *raid_io, uint64_t *first,
+		   uint64_t *last)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+
+	*first = bdev_io->u.bdev.offset_blocks >> wib->region_shift;
+	*last = (bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks - 1) >>
+		wib->region_shift;
+}
+
+static bool
+raid1_wib_busy(struct raid1_wib *wib)
+{
+	return wib->flush_in_progress || wib->io_remaining > 0 || wib->resync_io_remaining > 0;
+}
+
+static void raid1_stop_cont(struct raid1_info *r1info);
+
+static void
+raid1_wib_check_stopped(struct raid1_wib *wib)
+{
+	if (spdk_unlikely(wib->stopping) && !raid1_wib_busy(wib)) {
+		raid1_stop_cont(wib->r1info);
+	}
+}
+
+static void
+_raid1_fail_write(void *_raid_io)
+{
+	raid_bdev_io_complete(_raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void
+raid1_wib_resubmit(struct raid_bdev_io *raid_io, bool success)
+{
+	/* The thread the write was submitted on is kept in module_private while it's waiting */
+	struct spdk_thread *thread = raid_io->module_private;
+
+	spdk_thread_send_msg(thread, success ? _raid1_submit_rw_request : _raid1_fail_write,
+			     raid_io);
+}
+
+static void
+raid1_wib_resubmit_all(struct raid1_wib *wib, struct raid1_io_tailq *ios, bool success)
+{
+	struct raid_bdev_io *raid_io;
+
+	while ((raid_io = TAILQ_FIRST(ios)) != NULL) {
+		TAILQ_REMOVE(ios, raid_io, link);
+		raid1_wib_resubmit(raid_io, success);
+	}
+}
+
+static void raid1_wib_flush(struct raid1_wib *wib);
+
+static void
+raid1_wib_flush_done(struct raid1_wib *wib)
+{
+	bool success = wib->io_succeeded > 0;
+	uint64_t i;
+
+	assert(wib->flush_in_progress);
+	wib->flush_in_progress = false;
+
+	if (success) {
+		/* Regions cleared after the write was started are not marked as dirty */
+		for (i = 0; i < wib->num_words; i++) {
+			__atomic_fetch_or(&wib->dirty[i], wib->buf[i] & wib->target[i],
+					  __ATOMIC_SEQ_CST);
+		}
+	} else {
+		SPDK_ERRLOG("Failed to write the write-intent bitmap of raid bdev %s\n",
+			    wib->r1info->raid_bdev->bdev.name);
+	}
+
+	raid1_wib_resubmit_all(wib, &wib->flushing, success);
+
+	if (!wib->stopping && (!TAILQ_EMPTY(&wib->pending) || wib->flush_needed)) {
+		raid1_wib_flush(wib);
+	}
+
+	raid1_wib_check_stopped(wib);
+}
+
+static void
+raid1_wib_flush_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid1_wib *wib = cb_arg;
 
 	spdk_bdev_free_io(bdev_io);
 
-	raid_bdev_io_complete_part(raid_io, 1, success ?
-				   SPDK_BDEV_IO_STATUS_SUCCESS :
-				   SPDK_BDEV_IO_STATUS_FAILED);
+	if (success) {
+		wib->io_succeeded++;
+	}
+
+	assert(wib->io_remaining > 0);
+	if (--wib->io_remaining == 0) {
+		raid1_wib_flush_done(wib);
+	}
 }
 
-static void raid1_submit_rw_request(struct raid_bdev_io *raid_io);
+static void
+raid1_wib_flush(struct raid1_wib *wib)
+{
+	struct raid_bdev *raid_bdev = wib->r1info->raid_bdev;
+	struct raid_base_bdev_info *base_info;
+	int rc;
+
+	if (wib->flush_in_progress) {
+		/* The writes will be picked up once the current bitmap write completes */
+		return;
+	}
+
+	wib->flush_in_progress = true;
+	wib->flush_needed = false;
+	TAILQ_CONCAT(&wib->flushing, &wib->pending, link);
+	memcpy(wib->buf, wib->target, wib->num_words * sizeof(uint64_t));
+
+	/* Hold an extra reference to complete the flush even if nothing could be submitted */
+	wib->io_remaining = 1;
+	wib->io_succeeded = 0;
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (base_info->desc == NULL || base_info->app_thread_ch == NULL) {
+			continue;
+		}
+
+		rc = spdk_bdev_write_blocks(base_info->desc, base_info->app_thread_ch, wib->buf,
+					    wib->offset_blocks, wib->num_blocks, raid1_wib_flush_cb,
+					    wib);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to write the write-intent bitmap on bdev %s: %s\n",
+				    base_info->name, spdk_strerror(-rc));
+			continue;
+		}
+		wib->io_remaining++;
+	}
+
+	if (--wib->io_remaining == 0) {
+		raid1_wib_flush_done(wib);
+	}
+}
 
 static void
-_raid1_submit_rw_request(void *_raid_io)
+_raid1_wib_mark_dirty(void *_raid_io)
 {
 	struct raid_bdev_io *raid_io = _raid_io;
+	struct raid1_info *r1info = raid_io->raid_bdev->module_private;
+	struct raid1_wib *wib = r1info->wib;
+	uint64_t first, last, region;
+	bool dirty = true;
 
-	raid1_submit_rw_request(raid_io);
+	raid1_wib_io_range(wib, raid_io, &first, &last);
+
+	if (wib->loading || (wib->resync_region >= first && wib->resync_region <= last)) {
+		TAILQ_INSERT_TAIL(&wib->waiting, raid_io, link);
+		return;
+	}
+
+	for (region = first; region <= last; region++) {
+		wib->target[region / 64] |= 1ULL << (region % 64);
+		if (!raid1_wib_test(wib->dirty, region)) {
+			dirty = false;
+		}
+	}
+
+	if (dirty) {
+		/* The bitmap has been written in the meantime */
+		raid1_wib_resubmit(raid_io, true);
+		return;
+	}
+
+	TAILQ_INSERT_TAIL(&wib->pending, raid_io, link);
+	raid1_wib_flush(wib);
+}
+
+/*
+ * Called on the IO thread before a write is submitted to the base bdevs.  Returns false if the
+ * bitmap has to be updated first, in which case the write will be resubmitted once it's done.
+ */
+static bool
+raid1_wib_start_write(struct raid1_wib *wib, struct raid_bdev_io *raid_io)
+{
+	uint64_t first, last, region;
+	bool ready = true;
+
+	raid1_wib_io_range(wib, raid_io, &first, &last);
+
+	/* The inflight counters have to be incremented before checking the bitmap, the cleaning
+	 * and resync code do the same in reverse order. */
+	for (region = first; region <= last; region++) {
+		__atomic_fetch_add(&wib->inflight[region], 1, __ATOMIC_SEQ_CST);
+		if (!raid1_wib_test(wib->dirty, region) ||
+		    __atomic_load_n(&wib->resync_region, __ATOMIC_SEQ_CST) == region) {
+			ready = false;
+		}
+	}
+
+	if (spdk_likely(ready)) {
+		return true;
+	}
+
+	for (region = first; region <= last; region++) {
+		__atomic_fetch_sub(&wib->inflight[region], 1, __ATOMIC_SEQ_CST);
+	}
+
+	raid_io->module_private = spdk_get_thread();
+	spdk_thread_send_msg(wib->thread, _raid1_wib_mark_dirty, raid_io);
+
+	return false;
+}
+
+static void
+raid1_wib_end_write(struct raid1_wib *wib, struct raid_bdev_io *raid_io)
+{
+	uint64_t first, last, region;
+
+	raid1_wib_io_range(wib, raid_io, &first, &last);
+
+	for (region = first; region <= last; region++) {
+		if (!raid1_wib_test(wib->active, region)) {
+			raid1_wib_set(wib->active, region);
+		}
+		__atomic_fetch_sub(&wib->inflight[region], 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+static bool
+raid1_wib_is_unsynced(struct raid1_wib *wib, struct raid_bdev_io *raid_io)
+{
+	uint64_t first, last, region;
+
+	if (__atomic_load_n(&wib->loading, __ATOMIC_SEQ_CST)) {
+		return true;
+	}
+
+	raid1_wib_io_range(wib, raid_io, &first, &last);
+
+	for (region = first; region <= last; region++) {
+		if (raid1_wib_test(wib->unsynced, region)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int
+raid1_wib_clean(void *ctx)
+{
+	struct raid1_wib *wib = ctx;
+	uint64_t i, region, mask, bits;
+	bool changed = false;
+
+	if (wib->loading || wib->resync_poller != NULL) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	for (i = 0; i < wib->num_words; i++) {
+		bits = __atomic_load_n(&wib->dirty[i], __ATOMIC_SEQ_CST);
+		while (bits != 0) {
+			region = i * 64 + __builtin_ctzll(bits);
+			mask = 1ULL << (region % 64);
+			bits &= ~mask;
+
+			if (raid1_wib_test(wib->active, region)) {
+				raid1_wib_clear(wib->active, region);
+				continue;
+			}
+
+			raid1_wib_clear(wib->dirty, region);
+			if (__atomic_load_n(&wib->inflight[region], __ATOMIC_SEQ_CST) != 0) {
+				raid1_wib_set(wib->dirty, region);
+				continue;
+			}
+
+			wib->target[i] &= ~mask;
+			changed = true;
+		}
+	}
+
+	if (changed) {
+		wib->flush_needed = true;
+		raid1_wib_flush(wib);
+	}
+
+	return changed ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static void
+raid1_resync_release(struct raid1_wib *wib)
+{
+	__atomic_store_n(&wib->resync_region, RAID1_WIB_NO_REGION, __ATOMIC_SEQ_CST);
+	raid1_wib_resubmit_all(wib, &wib->waiting, true);
+}
+
+static void
+raid1_resync_finish(struct raid1_wib *wib)
+{
+	struct raid_bdev *raid_bdev = wib->r1info->raid_bdev;
+
+	spdk_poller_unregister(&wib->resync_poller);
+	raid1_resync_release(wib);
+	spdk_dma_free(wib->resync_buf);
+	spdk_dma_free(wib->resync_md_buf);
+	wib->resync_buf = wib->resync_md_buf = NULL;
+
+	if (wib->resync_failed) {
+		SPDK_ERRLOG("Resync of raid bdev %s failed\n", raid_bdev->bdev.name);
+	} else if (!wib->stopping) {
+		SPDK_NOTICELOG("Resync of raid bdev %s completed\n", raid_bdev->bdev.name);
+	}
+}
+
+static void
+raid1_resync_chunk_done(struct raid1_wib *wib)
+{
+	struct raid_bdev *raid_bdev = wib->r1info->raid_bdev;
+	uint64_t region = wib->resync_region;
+
+	if (wib->resync_failed || wib->stopping) {
+		raid1_resync_finish(wib);
+		raid1_wib_check_stopped(wib);
+		return;
+	}
+
+	wib->resync_offset += wib->resync_blocks;
+	if (wib->resync_offset < wib->region_size &&
+	    (region << wib->region_shift) + wib->resync_offset < raid_bdev->bdev.blockcnt) {
+		return;
+	}
+
+	raid1_wib_clear(wib->unsynced, region);
+	wib->resync_next = region + 1;
+	raid1_resync_release(wib);
+}
+
+static void
+raid1_resync_write_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid1_wib *wib = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		wib->resync_failed = true;
+	}
+
+	assert(wib->resync_io_remaining > 0);
+	if (--wib->resync_io_remaining == 0) {
+		raid1_resync_chunk_done(wib);
+	}
+}
+
+static int
+raid1_resync_submit(struct raid1_wib *wib, struct raid_base_bdev_info *base_info, bool read,
+		    spdk_bdev_io_completion_cb cb)
+{
+	uint64_t offset = base_info->data_offset + (wib->resync_region << wib->region_shift) +
+			  wib->resync_offset;
+
+	if (wib->resync_md_buf != NULL) {
+		return read ?
+		       spdk_bdev_read_blocks_with_md(base_info->desc, base_info->app_thread_ch,
+						     wib->resync_buf, wib->resync_md_buf, offset,
+						     wib->resync_blocks, cb, wib) :
+		       spdk_bdev_write_blocks_with_md(base_info->desc, base_info->app_thread_ch,
+						      wib->resync_buf, wib->resync_md_buf, offset,
+						      wib->resync_blocks, cb, wib);
+	}
+
+	return read ?
+	       spdk_bdev_read_blocks(base_info->desc, base_info->app_thread_ch, wib->resync_buf,
+				     offset, wib->resync_blocks, cb, wib) :
+	       spdk_bdev_write_blocks(base_info->desc, base_info->app_thread_ch, wib->resync_buf,
+				      offset, wib->resync_blocks, cb, wib);
+}
+
+static void
+raid1_resync_read_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid1_wib *wib = cb_arg;
+	struct raid_bdev *raid_bdev = wib->r1info->raid_bdev;
+	struct raid_base_bdev_info *base_info;
+	uint8_t idx;
+	int rc;
+
+	spdk_bdev_free_io(bdev_io);
+
+	assert(wib->resync_io_remaining == 1);
+	if (!success || wib->stopping) {
+		wib->resync_failed = !success;
+		wib->resync_io_remaining = 0;
+		raid1_resync_chunk_done(wib);
+		return;
+	}
+
+	for (idx = 0; idx < raid_bdev->num_base_bdevs; idx++) {
+		base_info = &raid_bdev->base_bdev_info[idx];
+		if (idx == wib->resync_source || base_info->desc == NULL ||
+		    base_info->app_thread_ch == NULL) {
+			continue;
+		}
+
+		rc = raid1_resync_submit(wib, base_info, false, raid1_resync_write_cb);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to submit resync write to bdev %s: %s\n",
+				    base_info->name, spdk_strerror(-rc));
+			wib->resync_failed = true;
+			break;
+		}
+		wib->resync_io_remaining++;
+	}
+
+	if (--wib->resync_io_remaining == 0) {
+		raid1_resync_chunk_done(wib);
+	}
+}
+
+static uint64_t
+raid1_wib_find_next(uint64_t *map, uint64_t num_regions, uint64_t start)
+{
+	uint64_t region, bits;
+
+	for (region = start; region < num_regions; region = (region / 64 + 1) * 64) {
+		bits = __atomic_load_n(&map[region / 64], __ATOMIC_SEQ_CST) >> (region % 64);
+		if (bits != 0) {
+			region += __builtin_ctzll(bits);
+			return region < num_regions ? region : RAID1_WIB_NO_REGION;
+		}
+	}
+
+	return RAID1_WIB_NO_REGION;
+}
+
+static int
+raid1_resync_poll(void *ctx)
+{
+	struct raid1_wib *wib = ctx;
+	struct raid_bdev *raid_bdev = wib->r1info->raid_bdev;
+	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[wib->resync_source];
+	uint64_t region, offset;
+	int rc;
+
+	if (wib->resync_io_remaining > 0) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	if (base_info->desc == NULL || base_info->app_thread_ch == NULL) {
+		SPDK_ERRLOG("Resync source bdev of raid bdev %s was removed\n",
+			    raid_bdev->bdev.name);
+		wib->resync_failed = true;
+		raid1_resync_finish(wib);
+		return SPDK_POLLER_BUSY;
+	}
+
+	if (wib->resync_region == RAID1_WIB_NO_REGION) {
+		region = raid1_wib_find_next(wib->unsynced, wib->num_regions, wib->resync_next);
+		if (region == RAID1_WIB_NO_REGION) {
+			raid1_resync_finish(wib);
+			return SPDK_POLLER_BUSY;
+		}
+
+		/* Block new writes to the region first, then wait for the ones in flight */
+		__atomic_store_n(&wib->resync_region, region, __ATOMIC_SEQ_CST);
+		wib->resync_offset = 0;
+	}
+
+	if (__atomic_load_n(&wib->inflight[wib->resync_region], __ATOMIC_SEQ_CST) != 0) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	offset = (wib->resync_region << wib->region_shift) + wib->resync_offset;
+	wib->resync_blocks = spdk_min(wib->resync_chunk_blocks, raid_bdev->bdev.blockcnt - offset);
+
+	rc = raid1_resync_submit(wib, base_info, true, raid1_resync_read_cb);
+	if (rc == -ENOMEM) {
+		return SPDK_POLLER_IDLE;
+	} else if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit resync read to bdev %s: %s\n",
+			    base_info->name, spdk_strerror(-rc));
+		wib->resync_failed = true;
+		raid1_resync_finish(wib);
+		return SPDK_POLLER_BUSY;
+	}
+	wib->resync_io_remaining = 1;
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+raid1_resync_start(struct raid1_wib *wib)
+{
+	struct raid_bdev *raid_bdev = wib->r1info->raid_bdev;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_bdev *bdev = &raid_bdev->bdev;
+	uint8_t num_bases = 0;
+	uint64_t i, count = 0;
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (base_info->desc != NULL && base_info->app_thread_ch != NULL) {
+			if (num_bases++ == 0) {
+				wib->resync_source = base_info - raid_bdev->base_bdev_info;
+			}
+		}
+	}
+
+	for (i = 0; i < wib->num_words; i++) {
+		count += __builtin_popcountll(wib->unsynced[i]);
+	}
+
+	if (count == 0 || num_bases < 2) {
+		memset(wib->unsynced, 0, wib->num_words * sizeof(uint64_t));
+		return;
+	}
+
+	wib->resync_chunk_blocks = spdk_min(wib->region_size,
+					    RAID1_RESYNC_CHUNK_SIZE / bdev->blocklen);
+	wib->resync_buf = spdk_dma_malloc(wib->resync_chunk_blocks * bdev->blocklen,
+					  spdk_bdev_get_buf_align(bdev), NULL);
+	if (bdev->md_len != 0 && !bdev->md_interleave) {
+		wib->resync_md_buf = spdk_dma_malloc(wib->resync_chunk_blocks * bdev->md_len,
+						     spdk_bdev_get_buf_align(bdev), NULL);
+	}
+	if (wib->resync_buf == NULL || (bdev->md_len != 0 && !bdev->md_interleave &&
+					wib->resync_md_buf == NULL)) {
+		SPDK_ERRLOG("Failed to allocate resync buffers, raid bdev %s is not resynchronized\n",
+			    bdev->name);
+		wib->resync_failed = true;
+		raid1_resync_finish(wib);
+		return;
+	}
+
+	SPDK_NOTICELOG("Resynchronizing %" PRIu64 " regions of raid bdev %s\n", count, bdev->name);
+	wib->resync_next = 0;
+	wib->resync_poller = SPDK_POLLER_REGISTER(raid1_resync_poll, wib,
+			     RAID1_RESYNC_POLL_PERIOD_US);
+}
+
+static void raid1_wib_load_next(struct raid1_wib *wib);
+
+static void
+raid1_wib_load_done(struct raid1_wib *wib)
+{
+	uint64_t i, last_bits;
+
+	/* Ignore whatever is past the last region */
+	last_bits = wib->num_regions % 64;
+	if (last_bits != 0) {
+		wib->target[wib->num_words - 1] &= (1ULL << last_bits) - 1;
+	}
+
+	for (i = 0; i < wib->num_words; i++) {
+		__atomic_store_n(&wib->dirty[i], wib->target[i], __ATOMIC_SEQ_CST);
+		__atomic_store_n(&wib->unsynced[i], wib->target[i], __ATOMIC_SEQ_CST);
+	}
+	__atomic_store_n(&wib->loading, false, __ATOMIC_SEQ_CST);
+
+	if (!wib->stopping) {
+		raid1_resync_start(wib);
+	}
+	raid1_wib_resubmit_all(wib, &wib->waiting, true);
+	raid1_wib_check_stopped(wib);
+}
+
+static void
+raid1_wib_load_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid1_wib *wib = cb_arg;
+	uint64_t i;
+
+	spdk_bdev_free_io(bdev_io);
+
+	wib->io_remaining = 0;
+	if (success) {
+		for (i = 0; i < wib->num_words; i++) {
+			wib->target[i] |= wib->buf[i];
+		}
+		wib->io_succeeded++;
+	}
+
+	wib->load_idx++;
+	raid1_wib_load_next(wib);
+}
+
+static void
+raid1_wib_load_next(struct raid1_wib *wib)
+{
+	struct raid_bdev *raid_bdev = wib->r1info->raid_bdev;
+	struct raid_base_bdev_info *base_info;
+	int rc;
+
+	for (; !wib->stopping && wib->load_idx < raid_bdev->num_base_bdevs; wib->load_idx++) {
+		base_info = &raid_bdev->base_bdev_info[wib->load_idx];
+		if (base_info->desc == NULL || base_info->app_thread_ch == NULL) {
+			continue;
+		}
+
+		rc = spdk_bdev_read_blocks(base_info->desc, base_info->app_thread_ch, wib->buf,
+					   wib->offset_blocks, wib->num_blocks, raid1_wib_load_cb,
+					   wib);
+		if (rc == 0) {
+			wib->io_remaining = 1;
+			return;
+		}
+
+		SPDK_ERRLOG("Failed to read the write-intent bitmap from bdev %s: %s\n",
+			    base_info->name, spdk_strerror(-rc));
+	}
+
+	if (wib->io_succeeded == 0) {
+		SPDK_ERRLOG("Couldn't load the write-intent bitmap of raid bdev %s, "
+			    "all regions will be resynchronized\n", raid_bdev->bdev.name);
+		memset(wib->target, 0xff, wib->num_words * sizeof(uint64_t));
+	}
+
+	raid1_wib_load_done(wib);
+}
+
+static void
+raid1_wib_free(struct raid1_wib *wib)
+{
+	if (wib == NULL) {
+		return;
+	}
+
+	free(wib->dirty);
+	free(wib->active);
+	free(wib->unsynced);
+	free(wib->inflight);
+	free(wib->target);
+	spdk_dma_free(wib->buf);
+	free(wib);
+}
+
+static uint64_t
+raid1_wib_get_region_size(struct raid_bdev *raid_bdev)
+{
+	if (!spdk_uuid_is_null(&raid_bdev->sb->uuid)) {
+		/* An existing raid, use what's in the superblock */
+		return raid_bdev->sb->write_intent_region_size;
+	}
+
+	return (uint64_t)raid_bdev->write_intent_region_size_kb * 1024 / raid_bdev->bdev.blocklen;
+}
+
+static int
+raid1_wib_init(struct raid1_info *r1info)
+{
+	struct raid_bdev *raid_bdev = r1info->raid_bdev;
+	struct raid_base_bdev_info *base_info;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	struct raid1_wib *wib;
+	uint64_t region_size;
+	bool existing;
+
+	raid_bdev->write_intent_region_size = 0;
+	if (raid_bdev->sb == NULL) {
+		return 0;
+	}
+
+	existing = !spdk_uuid_is_null(&raid_bdev->sb->uuid);
+	region_size = raid1_wib_get_region_size(raid_bdev);
+	if (region_size == 0) {
+		/* A raid created without a write-intent bitmap */
+		return 0;
+	}
+
+	if (!existing &&
+	    ((uint64_t)raid_bdev->write_intent_region_size_kb * 1024) % blocklen != 0) {
+		SPDK_ERRLOG("Write-intent bitmap region size must be a multiple of the block size\n");
+		return -EINVAL;
+	}
+
+	if (RAID_BDEV_SB_MAX_LENGTH % blocklen != 0) {
+		SPDK_NOTICELOG("Write-intent bitmap not supported by raid bdev %s with block size %u\n",
+			       raid_bdev->bdev.name, blocklen);
+		return 0;
+	}
+
+	if (!spdk_u64_is_pow2(region_size) || region_size > UINT32_MAX) {
+		SPDK_ERRLOG("Invalid write-intent bitmap region size: %" PRIu64 " blocks\n",
+			    region_size);
+		return -EINVAL;
+	}
+
+	wib = calloc(1, sizeof(*wib));
+	if (wib == NULL) {
+		return -ENOMEM;
+	}
+
+	wib->r1info = r1info;
+	wib->thread = spdk_get_thread();
+	wib->region_size = region_size;
+	wib->region_shift = spdk_u64log2(region_size);
+	wib->num_regions = spdk_divide_round_up(raid_bdev->bdev.blockcnt, region_size);
+	wib->num_words = spdk_divide_round_up(wib->num_regions, 64);
+	wib->offset_blocks = RAID_BDEV_SB_MAX_LENGTH / blocklen;
+	wib->num_blocks = spdk_divide_round_up(wib->num_words * sizeof(uint64_t), blocklen);
+	wib->resync_region = RAID1_WIB_NO_REGION;
+	TAILQ_INIT(&wib->pending);
+	TAILQ_INIT(&wib->flushing);
+	TAILQ_INIT(&wib->waiting);
+
+	if (wib->num_regions > RAID1_WIB_MAX_REGIONS) {
+		SPDK_ERRLOG("Write-intent bitmap region size %" PRIu64 " blocks too small for raid "
+			    "bdev %s\n", region_size, raid_bdev->bdev.name);
+		raid1_wib_free(wib);
+		return -EINVAL;
+	}
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (base_info->desc != NULL &&
+		    wib->offset_blocks + wib->num_blocks > base_info->data_offset) {
+			SPDK_NOTICELOG("No space for the write-intent bitmap on bdev %s\n",
+				       base_info->name);
+			raid1_wib_free(wib);
+			return 0;
+		}
+	}
+
+	wib->dirty = calloc(wib->num_words, sizeof(uint64_t));
+	wib->active = calloc(wib->num_words, sizeof(uint64_t));
+	wib->unsynced = calloc(wib->num_words, sizeof(uint64_t));
+	wib->target = calloc(wib->num_words, sizeof(uint64_t));
+	wib->inflight = calloc(wib->num_regions, sizeof(uint32_t));
+	wib->buf = spdk_dma_zmalloc(wib->num_blocks * blocklen,
+				    spdk_bdev_get_buf_align(&raid_bdev->bdev), NULL);
+	if (wib->dirty == NULL || wib->active == NULL || wib->unsynced == NULL ||
+	    wib->target == NULL || wib->inflight == NULL || wib->buf == NULL) {
+		raid1_wib_free(wib);
+		return -ENOMEM;
+	}
+
+	wib->clean_poller = SPDK_POLLER_REGISTER(raid1_wib_clean, wib, RAID1_WIB_CLEAN_PERIOD_US);
+	raid_bdev->write_intent_region_size = region_size;
+	r1info->wib = wib;
+
+	if (existing) {
+		wib->loading = true;
+		raid1_wib_load_next(wib);
+	} else {
+		/* Initialize the bitmap on disk */
+		wib->flush_needed = true;
+		raid1_wib_flush(wib);
+	}
+
+	return 0;
+}
+
+static void
+raid1_io_complete_part(struct raid_bdev_io *raid_io, uint64_t completed,
+		       enum spdk_bdev_io_status status)
+{
+	struct raid1_info *r1info = raid_io->raid_bdev->module_private;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+
+	if (r1info->wib != NULL && bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE &&
+	    raid_io->base_bdev_io_remaining == completed) {
+		raid1_wib_end_write(r1info->wib, raid_io);
+	}
+
+	raid_bdev_io_complete_part(raid_io, completed, status);
+}
+
+static void
+raid1_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid1_io_complete_part(raid_io, 1, success ?
+			       SPDK_BDEV_IO_STATUS_SUCCESS :
+			       SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void
+raid1_read_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
+	struct raid1_io_channel *raid1_ch = spdk_io_channel_get_ctx(raid_ch->module_channel);
+	uint64_t latency, *avg;
+	uint8_t idx;
+
+	for (idx = 0; idx < raid_bdev->num_base_bdevs; idx++) {
+		if (raid_bdev->base_bdev_info[idx].bdev == bdev_io->bdev) {
+			break;
+		}
+	}
+
+	if (spdk_likely(idx < raid_bdev->num_base_bdevs)) {
+		assert(raid1_ch->base_bdev_reads_outstanding[idx] > 0);
+		raid1_ch->base_bdev_reads_outstanding[idx]--;
+
+		if (success) {
+			latency = spdk_get_ticks() - spdk_bdev_io_get_submit_tsc(bdev_io);
+			avg = &raid1_ch->base_bdev_read_latency[idx];
+			if (*avg == 0) {
+				*avg = latency;
+			} else {
+				*avg = *avg - (*avg >> RAID1_READ_LATENCY_EWMA_SHIFT) +
+				       (latency >> RAID1_READ_LATENCY_EWMA_SHIFT);
+			}
+		}
+	}
+
+	raid1_bdev_io_completion(bdev_io, success, cb_arg);
 }
 
 static void
@@ -80,6 +1006,54 @@ raid1_channel_next_read_base_bdev(struct raid_bdev_io_channel *raid_ch)
 	return raid1_ch->base_bdev_read_idx;
 }
 
+/*
+ * Select the base bdev with the lowest expected completion time, estimated from its average read
+ * latency and the number of reads waiting on it.
+ */
+static uint8_t
+raid1_channel_next_read_base_bdev_latency(struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid1_io_channel *raid1_ch = spdk_io_channel_get_ctx(raid_ch->module_channel);
+	uint8_t idx = raid1_ch->base_bdev_read_idx;
+	uint8_t best_idx = UINT8_MAX;
+	uint64_t score, best_score = UINT64_MAX;
+	bool probe = false;
+	uint8_t i;
+
+	if (++raid1_ch->reads_since_probe == RAID1_READ_LATENCY_PROBE_INTERVAL) {
+		raid1_ch->reads_since_probe = 0;
+		probe = true;
+	}
+
+	for (i = 0; i < raid_ch->num_channels; i++) {
+		if (++idx == raid_ch->num_channels) {
+			idx = 0;
+		}
+
+		if (raid_ch->base_channel[idx] == NULL) {
+			continue;
+		}
+
+		if (probe) {
+			best_idx = idx;
+			break;
+		}
+
+		score = (raid1_ch->base_bdev_read_latency[idx] + 1) *
+			(raid1_ch->base_bdev_reads_outstanding[idx] + 1);
+		if (score < best_score) {
+			best_score = score;
+			best_idx = idx;
+		}
+	}
+
+	if (best_idx != UINT8_MAX) {
+		raid1_ch->base_bdev_read_idx = best_idx;
+	}
+
+	return raid1_ch->base_bdev_read_idx;
+}
+
 static void
 raid1_channel_update_read_bw_counters(struct raid_bdev_io_channel *raid_ch, uint64_t pd_blocks)
 {
@@ -103,11 +1077,14 @@ static int
 raid1_submit_read_request(struct raid_bdev_io *raid_io)
 {
 	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid1_info *r1info = raid_bdev->module_private;
 	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
 	struct spdk_bdev_ext_io_opts io_opts;
 	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
+	struct raid1_io_channel *raid1_ch = spdk_io_channel_get_ctx(raid_ch->module_channel);
 	struct raid_base_bdev_info *base_info;
 	struct spdk_io_channel *base_ch = NULL;
+	spdk_bdev_io_completion_cb cb = raid1_bdev_io_completion;
 	uint64_t pd_lba, pd_blocks;
 	uint8_t idx;
 	int ret;
@@ -115,15 +1092,28 @@ raid1_submit_read_request(struct raid_bdev_io *raid_io)
 	pd_lba = bdev_io->u.bdev.offset_blocks;
 	pd_blocks = bdev_io->u.bdev.num_blocks;
 
-	idx = raid1_channel_next_read_base_bdev(raid_ch);
+	if (spdk_unlikely(r1info->wib != NULL && raid1_wib_is_unsynced(r1info->wib, raid_io))) {
+		/* The mirrors may differ here, read from the one used as the resync source */
+		for (idx = 0; idx < raid_ch->num_channels - 1; idx++) {
+			if (raid_ch->base_channel[idx] != NULL) {
+				break;
+			}
+		}
+	} else if (r1info->read_policy == RAID1_READ_POLICY_LATENCY) {
+		idx = raid1_channel_next_read_base_bdev_latency(raid_ch);
+		cb = raid1_read_bdev_io_completion;
+	} else {
+		idx = raid1_channel_next_read_base_bdev(raid_ch);
+		if (spdk_likely(raid_ch->base_channel[idx] != NULL)) {
+			raid1_channel_update_read_bw_counters(raid_ch, pd_blocks);
+		}
+	}
 
 	if (spdk_unlikely(raid_ch->base_channel[idx] == NULL)) {
 		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
 		return 0;
 	}
 
-	raid1_channel_update_read_bw_counters(raid_ch, pd_blocks);
-
 	base_info = &raid_bdev->base_bdev_info[idx];
 	base_ch = raid_io->raid_ch->base_channel[idx];
 
@@ -132,10 +1122,12 @@ raid1_submit_read_request(struct raid_bdev_io *raid_io)
 	raid1_init_ext_io_opts(bdev_io, &io_opts);
 	ret = raid_bdev_readv_blocks_ext(base_info, base_ch,
 					 bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
-					 pd_lba, pd_blocks, raid1_bdev_io_completion,
-					 raid_io, &io_opts);
+					 pd_lba, pd_blocks, cb, raid_io, &io_opts);
 
 	if (spdk_likely(ret == 0)) {
+		if (cb == raid1_read_bdev_io_completion) {
+			raid1_ch->base_bdev_reads_outstanding[idx]++;
+		}
 		raid_io->base_bdev_io_submitted++;
 	} else if (spdk_unlikely(ret == -ENOMEM)) {
 		raid_bdev_queue_io_wait(raid_io, base_info->bdev, base_ch,
@@ -150,6 +1142,7 @@ static int
 raid1_submit_write_request(struct raid_bdev_io *raid_io)
 {
 	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid1_info *r1info = raid_bdev->module_private;
 	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
 	struct spdk_bdev_ext_io_opts io_opts;
 	struct raid_base_bdev_info *base_info;
@@ -162,7 +1155,11 @@ raid1_submit_write_request(struct raid_bdev_io *raid_io)
 	pd_lba = bdev_io->u.bdev.offset_blocks;
 	pd_blocks = bdev_io->u.bdev.num_blocks;
 
-	if (raid_io->base_bdev_io_submitted == 0) {
+	if (raid_io->base_bdev_io_remaining == 0) {
+		if (r1info->wib != NULL && !raid1_wib_start_write(r1info->wib, raid_io)) {
+			/* Resubmitted once the write-intent bitmap is updated */
+			return 0;
+		}
 		raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
 	}
 
@@ -173,7 +1170,7 @@ raid1_submit_write_request(struct raid_bdev_io *raid_io)
 
 		if (base_ch == NULL) {
 			raid_io->base_bdev_io_submitted++;
-			raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+			raid1_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
 			continue;
 		}
 
@@ -190,8 +1187,8 @@ raid1_submit_write_request(struct raid_bdev_io *raid_io)
 
 			base_bdev_io_not_submitted = raid_bdev->num_base_bdevs -
 						     raid_io->base_bdev_io_submitted;
-			raid_bdev_io_complete_part(raid_io, base_bdev_io_not_submitted,
-						   SPDK_BDEV_IO_STATUS_FAILED);
+			raid1_io_complete_part(raid_io, base_bdev_io_not_submitted,
+					       SPDK_BDEV_IO_STATUS_FAILED);
 			return 0;
 		}
 
@@ -228,12 +1225,76 @@ raid1_submit_rw_request(struct raid_bdev_io *raid_io)
 	}
 }
 
+static void
+raid1_process_write_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_process_request_complete(process_req, success ? 0 : -EIO);
+}
+
+static void
+raid1_process_read_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+	struct raid_base_bdev_info *target = process_req->target;
+	int ret;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		raid_bdev_process_request_complete(process_req, -EIO);
+		return;
+	}
+
+	ret = spdk_bdev_write_blocks_with_md(target->desc, process_req->target_ch,
+					     process_req->buf, process_req->md_buf,
+					     target->data_offset + process_req->offset_blocks,
+					     process_req->num_blocks, raid1_process_write_cb,
+					     process_req);
+	if (ret != 0) {
+		raid_bdev_process_request_complete(process_req, ret);
+	}
+}
+
+static int
+raid1_submit_process_request(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev_io_channel *raid_ch = process_req->raid_ch;
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+	struct raid_base_bdev_info *base_info;
+	uint8_t idx;
+
+	/* Copy the data from any other mirror */
+	for (idx = 0; idx < raid_ch->num_channels; idx++) {
+		if (raid_ch->base_channel[idx] != NULL) {
+			break;
+		}
+	}
+
+	if (idx == raid_ch->num_channels) {
+		return -ENODEV;
+	}
+
+	base_info = &raid_bdev->base_bdev_info[idx];
+
+	return spdk_bdev_read_blocks_with_md(base_info->desc, raid_ch->base_channel[idx],
+					     process_req->buf, process_req->md_buf,
+					     base_info->data_offset + process_req->offset_blocks,
+					     process_req->num_blocks, raid1_process_read_cb,
+					     process_req);
+}
+
 static void
 raid1_ioch_destroy(void *io_device, void *ctx_buf)
 {
 	struct raid1_io_channel *r1ch = ctx_buf;
 
 	free(r1ch->base_bdev_read_bw);
+	free(r1ch->base_bdev_reads_outstanding);
+	free(r1ch->base_bdev_read_latency);
 }
 
 static int
@@ -248,8 +1309,14 @@ raid1_ioch_create(void *io_device, void *ctx_buf)
 	r1ch->base_bdev_max_read_bw = 0;
 	r1ch->base_bdev_read_bw = calloc(raid_bdev->num_base_bdevs,
 					 sizeof(*r1ch->base_bdev_read_bw));
-	if (!r1ch->base_bdev_read_bw) {
+	r1ch->base_bdev_reads_outstanding = calloc(raid_bdev->num_base_bdevs,
+					    sizeof(*r1ch->base_bdev_reads_outstanding));
+	r1ch->base_bdev_read_latency = calloc(raid_bdev->num_base_bdevs,
+					      sizeof(*r1ch->base_bdev_read_latency));
+	if (!r1ch->base_bdev_read_bw || !r1ch->base_bdev_reads_outstanding ||
+	    !r1ch->base_bdev_read_latency) {
 		SPDK_ERRLOG("Failed to initialize io channel\n");
+		raid1_ioch_destroy(io_device, ctx_buf);
 		status = -ENOMEM;
 	}
 
@@ -263,6 +1330,7 @@ raid1_io_device_unregister_done(void *io_device)
 
 	raid_bdev_module_stop_done(r1info->raid_bdev);
 
+	raid1_wib_free(r1info->wib);
 	free(r1info);
 }
 
@@ -272,6 +1340,8 @@ raid1_start(struct raid_bdev *raid_bdev)
 	uint64_t min_blockcnt = UINT64_MAX;
 	struct raid_base_bdev_info *base_info;
 	struct raid1_info *r1info;
+	struct raid_bdev_opts opts;
+	int rc;
 
 	r1info = calloc(1, sizeof(*r1info));
 	if (!r1info) {
@@ -280,6 +1350,9 @@ raid1_start(struct raid_bdev *raid_bdev)
 	}
 	r1info->raid_bdev = raid_bdev;
 
+	raid_bdev_get_opts(&opts);
+	r1info->read_policy = opts.raid1_read_policy;
+
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
 		min_blockcnt = spdk_min(min_blockcnt, base_info->data_size);
 	}
@@ -291,18 +1364,47 @@ raid1_start(struct raid_bdev *raid_bdev)
 	raid_bdev->bdev.blockcnt = min_blockcnt;
 	raid_bdev->module_private = r1info;
 
+	rc = raid1_wib_init(r1info);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to initialize the write-intent bitmap: %s\n",
+			    spdk_strerror(-rc));
+		raid_bdev->module_private = NULL;
+		free(r1info);
+		return rc;
+	}
+
 	spdk_io_device_register(r1info, raid1_ioch_create, raid1_ioch_destroy,
 				sizeof(struct raid1_io_channel), NULL);
 
 	return 0;
 }
 
+static void
+raid1_stop_cont(struct raid1_info *r1info)
+{
+	spdk_io_device_unregister(r1info, raid1_io_device_unregister_done);
+}
+
 static bool
 raid1_stop(struct raid_bdev *raid_bdev)
 {
 	struct raid1_info *r1info = raid_bdev->module_private;
+	struct raid1_wib *wib = r1info->wib;
 
-	spdk_io_device_unregister(r1info, raid1_io_device_unregister_done);
+	if (wib != NULL) {
+		wib->stopping = true;
+		spdk_poller_unregister(&wib->clean_poller);
+		if (wib->resync_poller != NULL && wib->resync_io_remaining == 0) {
+			raid1_resync_finish(wib);
+		}
+
+		if (raid1_wib_busy(wib)) {
+			/* Continued once the bitmap and resync IOs complete */
+			return false;
+		}
+	}
+
+	raid1_stop_cont(r1info);
 
 	return false;
 }
@@ -324,6 +1426,7 @@ static struct raid_bdev_module g_raid1_module = {
 	.stop = raid1_stop,
 	.submit_rw_request = raid1_submit_rw_request,
 	.get_io_channel = raid1_get_io_channel,
+	.submit_process_request = raid1_submit_process_request,
 };
 RAID_MODULE_REGISTER(&g_raid1_module)
 
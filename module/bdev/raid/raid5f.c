@@ -16,6 +16,15 @@
 /* Maximum concurrent full stripe writes per io channel */
 #define RAID5F_MAX_STRIPES 32
 
+/* Number of hash buckets for the stripes locked by stripe cache flushes */
+#define RAID5F_STRIPE_LOCK_BUCKETS 64
+
+/* Number of reconstructed chunks kept per io channel for degraded reads */
+#define RAID5F_RECONSTRUCT_CACHE_SIZE 4
+
+/* Number of stripe write generation counters, shared by stripes with the same remainder */
+#define RAID5F_STRIPE_WRITE_GEN_SIZE 1024
+
 struct chunk {
 	/* Corresponds to base_bdev index */
 	uint8_t index;
@@ -39,10 +48,35 @@ struct chunk {
 struct stripe_request;
 typedef void (*stripe_req_xor_cb)(struct stripe_request *stripe_req, int status);
 
+/* Data chunk of a missing base bdev reconstructed for degraded reads */
+struct raid5f_reconstruct_cache_entry {
+	/* Stripe and chunk the data was reconstructed for */
+	uint64_t stripe_index;
+	uint8_t chunk_idx;
+
+	/* Write generation of the stripe when the reconstruction started */
+	uint64_t write_gen;
+
+	/* Set when buf holds the chunk data */
+	bool valid;
+
+	/* Set while the chunk is being reconstructed */
+	bool filling;
+
+	/* Buffer for the whole chunk */
+	void *buf;
+
+	/* Reads waiting for the reconstruction to finish */
+	TAILQ_HEAD(, spdk_bdev_io) waiting_ios;
+
+	TAILQ_ENTRY(raid5f_reconstruct_cache_entry) link;
+};
+
 struct stripe_request {
 	enum stripe_request_type {
 		STRIPE_REQ_WRITE,
 		STRIPE_REQ_RECONSTRUCT,
+		STRIPE_REQ_CACHE,
 	} type;
 
 	struct raid5f_io_channel *r5ch;
@@ -77,7 +111,52 @@ struct stripe_request {
 
 			/* Offset from chunk start */
 			uint64_t chunk_offset;
+
+			/* Number of blocks to reconstruct */
+			uint64_t num_blocks;
+
+			/* Cache entry to fill with the whole chunk, NULL if reading for raid_io */
+			struct raid5f_reconstruct_cache_entry *cache_entry;
 		} reconstruct;
+
+		struct {
+			enum stripe_cache_state {
+				STRIPE_CACHE_COLLECTING,
+				STRIPE_CACHE_LOCKING,
+				STRIPE_CACHE_READING,
+				STRIPE_CACHE_WRITING,
+			} state;
+
+			/* Buffer for stripe parity */
+			void *parity_buf;
+
+			/* Array of buffers for the chunk data not covered by the writes */
+			void **chunk_buffers;
+
+			/* Writes collected for this stripe, sorted by offset */
+			TAILQ_HEAD(, spdk_bdev_io) ios;
+
+			/* Writes that overlap the collected ones and wait for the flush */
+			TAILQ_HEAD(, spdk_bdev_io) waiting_ios;
+
+			/* Number of stripe blocks covered by the collected writes */
+			uint64_t blocks_covered;
+
+			/* When the first write was collected */
+			uint64_t start_ticks;
+
+			/* Data chunk on a missing base bdev that has to be rebuilt from parity */
+			struct chunk *missing_chunk;
+
+			/* Destination chunk of the xor */
+			struct chunk *xor_dest;
+
+			/* Flushes of the same stripe waiting for this one to finish */
+			TAILQ_HEAD(, stripe_request) lock_waiters;
+
+			TAILQ_ENTRY(stripe_request) lock_link;
+			TAILQ_ENTRY(stripe_request) link;
+		} cache;
 	};
 
 	/* Array of iovec iterators for each data chunk */
@@ -121,6 +200,23 @@ struct raid5f_info {
 
 	/* Alignment for buffer allocation */
 	size_t buf_alignment;
+
+	/* Number of stripe cache entries per channel, 0 to accept only full stripe writes */
+	uint32_t stripe_cache_size;
+
+	/* Time after which a partially written stripe is flushed */
+	uint32_t stripe_cache_flush_us;
+	uint64_t stripe_cache_flush_ticks;
+
+	/* Stripes locked by stripe cache flushes, shared by all channels */
+	struct spdk_spinlock stripe_lock;
+	TAILQ_HEAD(, stripe_request) locked_stripes[RAID5F_STRIPE_LOCK_BUCKETS];
+
+	/*
+	 * Counters incremented when a write to a stripe starts and when it completes, used to
+	 * detect stale reconstructed chunks. NULL if degraded reads are not cached.
+	 */
+	uint64_t *stripe_write_gen;
 };
 
 struct raid5f_io_channel {
@@ -128,8 +224,22 @@ struct raid5f_io_channel {
 	struct {
 		TAILQ_HEAD(, stripe_request) write;
 		TAILQ_HEAD(, stripe_request) reconstruct;
+		TAILQ_HEAD(, stripe_request) cache;
 	} free_stripe_requests;
 
+	/* Stripes collecting partial writes or being flushed, oldest first */
+	TAILQ_HEAD(, stripe_request) cached_stripes;
+
+	/* Flushes stripes that waited too long for more writes */
+	struct spdk_poller *stripe_cache_poller;
+
+	/* Chunks reconstructed for degraded reads, most recently used first */
+	TAILQ_HEAD(raid5f_reconstruct_cache_head, raid5f_reconstruct_cache_entry) reconstruct_cache;
+	struct raid5f_reconstruct_cache_entry *reconstruct_cache_entries;
+
+	/* Stripe of the last degraded read, to detect reads of the same missing chunk */
+	uint64_t last_reconstruct_stripe;
+
 	/* accel_fw channel */
 	struct spdk_io_channel *accel_ch;
 
@@ -177,13 +287,36 @@ raid5f_stripe_parity_chunk_index(const struct raid_bdev *raid_bdev, uint64_t str
 	return raid5f_stripe_data_chunks_num(raid_bdev) - stripe_index % raid_bdev->num_base_bdevs;
 }
 
+static inline uint64_t *
+raid5f_stripe_write_gen(struct raid5f_info *r5f_info, uint64_t stripe_index)
+{
+	return &r5f_info->stripe_write_gen[stripe_index % RAID5F_STRIPE_WRITE_GEN_SIZE];
+}
+
+static inline uint64_t
+raid5f_stripe_write_gen_get(struct raid5f_info *r5f_info, uint64_t stripe_index)
+{
+	return __atomic_load_n(raid5f_stripe_write_gen(r5f_info, stripe_index), __ATOMIC_SEQ_CST);
+}
+
+static inline void
+raid5f_stripe_write_gen_inc(struct raid5f_info *r5f_info, uint64_t stripe_index)
+{
+	if (r5f_info->stripe_write_gen != NULL) {
+		__atomic_fetch_add(raid5f_stripe_write_gen(r5f_info, stripe_index), 1,
+				   __ATOMIC_SEQ_CST);
+	}
+}
+
 static inline void
 raid5f_stripe_request_release(struct stripe_request *stripe_req)
 {
 	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
 		TAILQ_INSERT_HEAD(&stripe_req->r5ch->free_stripe_requests.write, stripe_req, link);
-	} else {
+	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
 		TAILQ_INSERT_HEAD(&stripe_req->r5ch->free_stripe_requests.reconstruct, stripe_req, link);
+	} else {
+		TAILQ_INSERT_HEAD(&stripe_req->r5ch->free_stripe_requests.cache, stripe_req, link);
 	}
 }
 
@@ -325,8 +458,11 @@ raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 	if (stripe_req->type == STRIPE_REQ_WRITE) {
 		num_blocks = raid_bdev->strip_size;
 		dest_chunk = stripe_req->parity_chunk;
+	} else if (stripe_req->type == STRIPE_REQ_CACHE) {
+		num_blocks = raid_bdev->strip_size;
+		dest_chunk = stripe_req->cache.xor_dest;
 	} else {
-		num_blocks = bdev_io->u.bdev.num_blocks;
+		num_blocks = stripe_req->reconstruct.num_blocks;
 		dest_chunk = stripe_req->reconstruct.chunk;
 	}
 
@@ -397,11 +533,114 @@ raid5f_xor_stripe_retry(struct stripe_request *stripe_req)
 	}
 }
 
+static void raid5f_stripe_cache_io_done(struct stripe_request *stripe_req,
+					enum spdk_bdev_io_status status);
+static void raid5f_reconstruct_cache_fill_done(struct raid5f_reconstruct_cache_entry *entry,
+		enum spdk_bdev_io_status status);
+
+/*
+ * Like raid_bdev_io_complete_part() but a stripe cache request doesn't complete its raid_io,
+ * which is only one of the writes collected for the stripe. It moves on to its next step
+ * instead and releases itself when done, so false is always returned for it. A reconstruct
+ * request filling a cache entry completes all the reads waiting for the entry instead.
+ */
+static bool
+raid5f_stripe_request_complete_part(struct stripe_request *stripe_req, uint64_t completed,
+				    enum spdk_bdev_io_status status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid5f_reconstruct_cache_entry *entry = NULL;
+
+	if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+		entry = stripe_req->reconstruct.cache_entry;
+	} else if (stripe_req->type == STRIPE_REQ_WRITE &&
+		   raid_io->base_bdev_io_remaining == completed) {
+		/* Invalidate the stripe's reconstructed chunks before the write completes */
+		raid5f_stripe_write_gen_inc(raid5f_ch_to_r5f_info(stripe_req->r5ch),
+					    stripe_req->stripe_index);
+	}
+
+	if (spdk_likely(stripe_req->type != STRIPE_REQ_CACHE && entry == NULL)) {
+		return raid_bdev_io_complete_part(raid_io, completed, status);
+	}
+
+	assert(raid_io->base_bdev_io_remaining >= completed);
+	raid_io->base_bdev_io_remaining -= completed;
+
+	if (status != SPDK_BDEV_IO_STATUS_SUCCESS) {
+		raid_io->base_bdev_io_status = status;
+	}
+
+	if (raid_io->base_bdev_io_remaining != 0) {
+		return false;
+	}
+
+	if (entry != NULL) {
+		raid5f_reconstruct_cache_fill_done(entry, raid_io->base_bdev_io_status);
+		return true;
+	}
+
+	raid5f_stripe_cache_io_done(stripe_req, raid_io->base_bdev_io_status);
+
+	return false;
+}
+
+static inline uint8_t
+raid5f_stripe_request_data_chunk_index(struct stripe_request *stripe_req, struct chunk *chunk)
+{
+	return chunk < stripe_req->parity_chunk ? chunk->index : chunk->index - 1;
+}
+
+/* Returns the number of blocks of a data chunk covered by the writes collected for the stripe */
+static uint64_t
+raid5f_stripe_cache_chunk_blocks_covered(struct stripe_request *stripe_req, struct chunk *chunk)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	uint8_t data_idx = raid5f_stripe_request_data_chunk_index(stripe_req, chunk);
+	uint64_t chunk_start = stripe_req->stripe_index * r5f_info->stripe_blocks +
+			       data_idx * raid_bdev->strip_size;
+	uint64_t chunk_end = chunk_start + raid_bdev->strip_size;
+	uint64_t covered = 0;
+	struct spdk_bdev_io *bdev_io;
+
+	TAILQ_FOREACH(bdev_io, &stripe_req->cache.ios, module_link) {
+		uint64_t start = spdk_max(bdev_io->u.bdev.offset_blocks, chunk_start);
+		uint64_t end = spdk_min(bdev_io->u.bdev.offset_blocks + bdev_io->u.bdev.num_blocks,
+					chunk_end);
+
+		if (start < end) {
+			covered += end - start;
+		}
+	}
+
+	return covered;
+}
+
+static bool
+raid5f_stripe_cache_chunk_needs_io(struct stripe_request *stripe_req, struct chunk *chunk)
+{
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+
+	if (chunk == stripe_req->parity_chunk) {
+		/* Parity is always written, but read only to rebuild a missing chunk */
+		return stripe_req->cache.state == STRIPE_CACHE_WRITING ||
+		       stripe_req->cache.missing_chunk != NULL;
+	}
+
+	if (stripe_req->cache.state == STRIPE_CACHE_WRITING) {
+		return raid5f_stripe_cache_chunk_blocks_covered(stripe_req, chunk) > 0;
+	}
+
+	return stripe_req->cache.missing_chunk != NULL ||
+	       raid5f_stripe_cache_chunk_blocks_covered(stripe_req, chunk) < raid_bdev->strip_size;
+}
+
 static void
 raid5f_stripe_request_chunk_write_complete(struct stripe_request *stripe_req,
 		enum spdk_bdev_io_status status)
 {
-	if (raid_bdev_io_complete_part(stripe_req->raid_io, 1, status)) {
+	if (raid5f_stripe_request_complete_part(stripe_req, 1, status)) {
 		raid5f_stripe_request_release(stripe_req);
 	}
 }
@@ -409,12 +648,10 @@ raid5f_stripe_request_chunk_write_complete(struct stripe_request *stripe_req,
 static void
 raid5f_stripe_request_reconstruct_xor_done(struct stripe_request *stripe_req, int status)
 {
-	struct raid_bdev_io *raid_io = stripe_req->raid_io;
-
 	raid5f_stripe_request_release(stripe_req);
 
-	raid_bdev_io_complete_part(raid_io, 1,
-				   status ? SPDK_BDEV_IO_STATUS_FAILED : SPDK_BDEV_IO_STATUS_SUCCESS);
+	raid5f_stripe_request_complete_part(stripe_req, 1, status ? SPDK_BDEV_IO_STATUS_FAILED :
+					    SPDK_BDEV_IO_STATUS_SUCCESS);
 }
 
 static void
@@ -432,7 +669,7 @@ raid5f_stripe_request_chunk_read_complete(struct stripe_request *stripe_req,
 		raid5f_stripe_request_release(stripe_req);
 	}
 
-	raid_bdev_io_complete_part(raid_io, 1, status);
+	raid5f_stripe_request_complete_part(stripe_req, 1, status);
 }
 
 static void
@@ -445,7 +682,7 @@ raid5f_chunk_complete_bdev_io(struct spdk_bdev_io *bdev_io, bool success, void *
 
 	spdk_bdev_free_io(bdev_io);
 
-	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
+	if (spdk_likely(stripe_req->type != STRIPE_REQ_RECONSTRUCT)) {
 		raid5f_stripe_request_chunk_write_complete(stripe_req, status);
 	} else {
 		raid5f_stripe_request_chunk_read_complete(stripe_req, status);
@@ -492,7 +729,8 @@ raid5f_chunk_submit(struct chunk *chunk)
 	case STRIPE_REQ_WRITE:
 		if (base_ch == NULL) {
 			raid_io->base_bdev_io_submitted++;
-			raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+			raid5f_stripe_request_complete_part(stripe_req, 1,
+							    SPDK_BDEV_IO_STATUS_SUCCESS);
 			return 0;
 		}
 
@@ -501,6 +739,28 @@ raid5f_chunk_submit(struct chunk *chunk)
 						  raid5f_chunk_complete_bdev_io, chunk,
 						  &chunk->ext_opts);
 		break;
+	case STRIPE_REQ_CACHE:
+		if (base_ch == NULL || !raid5f_stripe_cache_chunk_needs_io(stripe_req, chunk)) {
+			raid_io->base_bdev_io_submitted++;
+			raid5f_stripe_request_complete_part(stripe_req, 1,
+							    SPDK_BDEV_IO_STATUS_SUCCESS);
+			return 0;
+		}
+
+		if (stripe_req->cache.state == STRIPE_CACHE_READING) {
+			ret = raid_bdev_readv_blocks_ext(base_info, base_ch, chunk->iovs,
+							 chunk->iovcnt, base_offset_blocks,
+							 raid_bdev->strip_size,
+							 raid5f_chunk_complete_bdev_io, chunk,
+							 &chunk->ext_opts);
+		} else {
+			ret = raid_bdev_writev_blocks_ext(base_info, base_ch, chunk->iovs,
+							  chunk->iovcnt, base_offset_blocks,
+							  raid_bdev->strip_size,
+							  raid5f_chunk_complete_bdev_io, chunk,
+							  &chunk->ext_opts);
+		}
+		break;
 	case STRIPE_REQ_RECONSTRUCT:
 		if (chunk == stripe_req->reconstruct.chunk) {
 			return 0;
@@ -509,7 +769,8 @@ raid5f_chunk_submit(struct chunk *chunk)
 		base_offset_blocks += stripe_req->reconstruct.chunk_offset;
 
 		ret = raid_bdev_readv_blocks_ext(base_info, base_ch, chunk->iovs, chunk->iovcnt,
-						 base_offset_blocks, bdev_io->u.bdev.num_blocks,
+						 base_offset_blocks,
+						 stripe_req->reconstruct.num_blocks,
 						 raid5f_chunk_complete_bdev_io, chunk,
 						 &chunk->ext_opts);
 		break;
@@ -531,7 +792,7 @@ raid5f_chunk_submit(struct chunk *chunk)
 			 */
 			uint64_t base_bdev_io_not_submitted;
 
-			if (stripe_req->type == STRIPE_REQ_WRITE) {
+			if (stripe_req->type != STRIPE_REQ_RECONSTRUCT) {
 				base_bdev_io_not_submitted = raid_bdev->num_base_bdevs -
 							     raid_io->base_bdev_io_submitted;
 			} else {
@@ -539,8 +800,9 @@ raid5f_chunk_submit(struct chunk *chunk)
 							     raid_io->base_bdev_io_submitted;
 			}
 
-			if (raid_bdev_io_complete_part(raid_io, base_bdev_io_not_submitted,
-						       SPDK_BDEV_IO_STATUS_FAILED)) {
+			if (raid5f_stripe_request_complete_part(stripe_req,
+								base_bdev_io_not_submitted,
+								SPDK_BDEV_IO_STATUS_FAILED)) {
 				raid5f_stripe_request_release(stripe_req);
 			}
 		}
@@ -728,9 +990,14 @@ _raid5f_submit_rw_request(void *_raid_io)
 	raid5f_submit_rw_request(raid_io);
 }
 
+/*
+ * Reconstructs the data of a missing chunk from the other chunks of the stripe. Reads the range
+ * of raid_io into its buffers, or the whole chunk into the cache entry if one is passed.
+ */
 static int
 raid5f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_index,
-			       uint8_t chunk_idx, uint64_t chunk_offset)
+			       uint8_t chunk_idx, uint64_t chunk_offset,
+			       struct raid5f_reconstruct_cache_entry *entry)
 {
 	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
 	struct raid5f_io_channel *r5ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
@@ -749,10 +1016,23 @@ raid5f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_ind
 
 	stripe_req->reconstruct.chunk = &stripe_req->chunks[chunk_idx];
 	stripe_req->reconstruct.chunk_offset = chunk_offset;
+	stripe_req->reconstruct.cache_entry = entry;
+	if (entry != NULL) {
+		assert(chunk_offset == 0);
+		assert(bdev_io_md == NULL);
+		stripe_req->reconstruct.num_blocks = raid_bdev->strip_size;
+	} else {
+		stripe_req->reconstruct.num_blocks = bdev_io->u.bdev.num_blocks;
+	}
 	buf_idx = 0;
 
 	FOR_EACH_CHUNK(stripe_req, chunk) {
-		if (chunk == stripe_req->reconstruct.chunk) {
+		if (chunk == stripe_req->reconstruct.chunk && entry != NULL) {
+			chunk->iovs[0].iov_base = entry->buf;
+			chunk->iovs[0].iov_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+			chunk->iovcnt = 1;
+			chunk->md_buf = NULL;
+		} else if (chunk == stripe_req->reconstruct.chunk) {
 			int i;
 			int ret;
 
@@ -770,7 +1050,8 @@ raid5f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_ind
 			struct iovec *iov = &chunk->iovs[0];
 
 			iov->iov_base = stripe_req->reconstruct.chunk_buffers[buf_idx];
-			iov->iov_len = bdev_io->u.bdev.num_blocks << raid_bdev->blocklen_shift;
+			iov->iov_len = stripe_req->reconstruct.num_blocks <<
+				       raid_bdev->blocklen_shift;
 			chunk->iovcnt = 1;
 
 			if (bdev_io_md) {
@@ -791,6 +1072,134 @@ raid5f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_ind
 	return 0;
 }
 
+/* Copies the range of a degraded read from the reconstructed chunk */
+static void
+raid5f_reconstruct_cache_read(struct raid5f_reconstruct_cache_entry *entry,
+			      struct raid_bdev_io *raid_io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	uint64_t chunk_offset = (bdev_io->u.bdev.offset_blocks % r5f_info->stripe_blocks) &
+				(raid_bdev->strip_size - 1);
+
+	assert(entry->valid);
+
+	spdk_copy_buf_to_iovs(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+			      entry->buf + (chunk_offset << raid_bdev->blocklen_shift),
+			      bdev_io->u.bdev.num_blocks << raid_bdev->blocklen_shift);
+
+	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+static void
+raid5f_reconstruct_cache_fill_done(struct raid5f_reconstruct_cache_entry *entry,
+				   enum spdk_bdev_io_status status)
+{
+	TAILQ_HEAD(, spdk_bdev_io) waiting_ios;
+	struct spdk_bdev_io *bdev_io;
+
+	entry->filling = false;
+	entry->valid = status == SPDK_BDEV_IO_STATUS_SUCCESS;
+
+	TAILQ_INIT(&waiting_ios);
+	TAILQ_SWAP(&waiting_ios, &entry->waiting_ios, spdk_bdev_io, module_link);
+
+	while ((bdev_io = TAILQ_FIRST(&waiting_ios))) {
+		struct raid_bdev_io *raid_io = (struct raid_bdev_io *)bdev_io->driver_ctx;
+
+		TAILQ_REMOVE(&waiting_ios, bdev_io, module_link);
+
+		if (entry->valid) {
+			raid5f_reconstruct_cache_read(entry, raid_io);
+		} else {
+			raid_bdev_io_complete(raid_io, status);
+		}
+	}
+}
+
+/*
+ * Reads from a missing chunk are served from the chunks reconstructed in the channel's cache.
+ * The first read of a stripe is reconstructed for its own range only, because random reads
+ * rarely come back to the same chunk. When the next degraded read targets the same stripe,
+ * the whole chunk is reconstructed once and the following reads are copied from it. Reads of
+ * a chunk that is still being reconstructed wait for it, so they share one xor.
+ */
+static int
+raid5f_submit_degraded_read(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+			    uint8_t chunk_idx, uint64_t chunk_offset)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid5f_info *r5f_info = raid_io->raid_bdev->module_private;
+	struct raid5f_io_channel *r5ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
+	struct raid5f_reconstruct_cache_entry *entry;
+	uint64_t write_gen;
+	bool repeated;
+	int ret;
+
+	if (r5f_info->stripe_write_gen == NULL) {
+		return raid5f_submit_reconstruct_read(raid_io, stripe_index, chunk_idx,
+						      chunk_offset, NULL);
+	}
+
+	write_gen = raid5f_stripe_write_gen_get(r5f_info, stripe_index);
+	repeated = r5ch->last_reconstruct_stripe == stripe_index;
+	r5ch->last_reconstruct_stripe = stripe_index;
+
+	TAILQ_FOREACH(entry, &r5ch->reconstruct_cache, link) {
+		if (entry->stripe_index == stripe_index && entry->chunk_idx == chunk_idx &&
+		    entry->write_gen == write_gen && (entry->valid || entry->filling)) {
+			break;
+		}
+	}
+
+	if (entry != NULL) {
+		TAILQ_REMOVE(&r5ch->reconstruct_cache, entry, link);
+		TAILQ_INSERT_HEAD(&r5ch->reconstruct_cache, entry, link);
+
+		if (entry->valid) {
+			raid5f_reconstruct_cache_read(entry, raid_io);
+		} else {
+			TAILQ_INSERT_TAIL(&entry->waiting_ios, bdev_io, module_link);
+		}
+		return 0;
+	}
+
+	if (repeated) {
+		/* Reuse the least recently used entry not being filled */
+		TAILQ_FOREACH_REVERSE(entry, &r5ch->reconstruct_cache,
+				      raid5f_reconstruct_cache_head, link) {
+			if (!entry->filling) {
+				break;
+			}
+		}
+	}
+
+	if (entry == NULL) {
+		return raid5f_submit_reconstruct_read(raid_io, stripe_index, chunk_idx,
+						      chunk_offset, NULL);
+	}
+
+	entry->stripe_index = stripe_index;
+	entry->chunk_idx = chunk_idx;
+	entry->write_gen = write_gen;
+	entry->valid = false;
+	entry->filling = true;
+	TAILQ_INSERT_TAIL(&entry->waiting_ios, bdev_io, module_link);
+
+	ret = raid5f_submit_reconstruct_read(raid_io, stripe_index, chunk_idx, 0, entry);
+	if (spdk_unlikely(ret != 0)) {
+		TAILQ_REMOVE(&entry->waiting_ios, bdev_io, module_link);
+		entry->filling = false;
+		return ret;
+	}
+
+	TAILQ_REMOVE(&r5ch->reconstruct_cache, entry, link);
+	TAILQ_INSERT_HEAD(&r5ch->reconstruct_cache, entry, link);
+
+	return 0;
+}
+
 static int
 raid5f_submit_read_request(struct raid_bdev_io *raid_io, uint64_t stripe_index,
 			   uint64_t stripe_offset)
@@ -809,7 +1218,7 @@ raid5f_submit_read_request(struct raid_bdev_io *raid_io, uint64_t stripe_index,
 
 	raid5f_init_ext_io_opts(bdev_io, &io_opts);
 	if (base_ch == NULL) {
-		return raid5f_submit_reconstruct_read(raid_io, stripe_index, chunk_idx, chunk_offset);
+		return raid5f_submit_degraded_read(raid_io, stripe_index, chunk_idx, chunk_offset);
 	}
 
 	ret = raid_bdev_readv_blocks_ext(base_info, base_ch, bdev_io->u.bdev.iovs,
@@ -826,102 +1235,550 @@ raid5f_submit_read_request(struct raid_bdev_io *raid_io, uint64_t stripe_index,
 	return ret;
 }
 
-static void
-raid5f_submit_rw_request(struct raid_bdev_io *raid_io)
+static bool
+raid5f_stripe_lock(struct stripe_request *stripe_req)
 {
-	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
-	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
-	struct raid5f_info *r5f_info = raid_bdev->module_private;
-	uint64_t offset_blocks = bdev_io->u.bdev.offset_blocks;
-	uint64_t stripe_index = offset_blocks / r5f_info->stripe_blocks;
-	uint64_t stripe_offset = offset_blocks % r5f_info->stripe_blocks;
-	int ret;
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
+	uint64_t bucket = stripe_req->stripe_index % RAID5F_STRIPE_LOCK_BUCKETS;
+	struct stripe_request *owner;
+	bool locked = true;
 
-	switch (bdev_io->type) {
-	case SPDK_BDEV_IO_TYPE_READ:
-		assert(bdev_io->u.bdev.num_blocks <= raid_bdev->strip_size);
-		ret = raid5f_submit_read_request(raid_io, stripe_index, stripe_offset);
-		break;
-	case SPDK_BDEV_IO_TYPE_WRITE:
-		assert(stripe_offset == 0);
-		assert(bdev_io->u.bdev.num_blocks == r5f_info->stripe_blocks);
-		ret = raid5f_submit_write_request(raid_io, stripe_index);
-		break;
-	default:
-		ret = -EINVAL;
-		break;
+	spdk_spin_lock(&r5f_info->stripe_lock);
+
+	TAILQ_FOREACH(owner, &r5f_info->locked_stripes[bucket], cache.lock_link) {
+		if (owner->stripe_index == stripe_req->stripe_index) {
+			TAILQ_INSERT_TAIL(&owner->cache.lock_waiters, stripe_req, cache.lock_link);
+			locked = false;
+			break;
+		}
 	}
 
-	if (spdk_unlikely(ret)) {
-		raid_bdev_io_complete(raid_io, ret == -ENOMEM ? SPDK_BDEV_IO_STATUS_NOMEM :
-				      SPDK_BDEV_IO_STATUS_FAILED);
+	if (locked) {
+		TAILQ_INSERT_TAIL(&r5f_info->locked_stripes[bucket], stripe_req, cache.lock_link);
 	}
+
+	spdk_spin_unlock(&r5f_info->stripe_lock);
+
+	return locked;
 }
 
+static void _raid5f_stripe_cache_locked(void *_stripe_req);
+
 static void
-raid5f_stripe_request_free(struct stripe_request *stripe_req)
+raid5f_stripe_unlock(struct stripe_request *stripe_req)
 {
-	struct chunk *chunk;
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
+	uint64_t bucket = stripe_req->stripe_index % RAID5F_STRIPE_LOCK_BUCKETS;
+	struct stripe_request *next;
+	struct spdk_thread *thread;
+
+	spdk_spin_lock(&r5f_info->stripe_lock);
+
+	TAILQ_REMOVE(&r5f_info->locked_stripes[bucket], stripe_req, cache.lock_link);
+
+	/* Pass the lock and the remaining waiters to the first waiter */
+	next = TAILQ_FIRST(&stripe_req->cache.lock_waiters);
+	if (next != NULL) {
+		TAILQ_REMOVE(&stripe_req->cache.lock_waiters, next, cache.lock_link);
+		assert(TAILQ_EMPTY(&next->cache.lock_waiters));
+		TAILQ_CONCAT(&next->cache.lock_waiters, &stripe_req->cache.lock_waiters,
+			     cache.lock_link);
+		TAILQ_INSERT_TAIL(&r5f_info->locked_stripes[bucket], next, cache.lock_link);
+	}
 
-	FOR_EACH_CHUNK(stripe_req, chunk) {
-		free(chunk->iovs);
+	spdk_spin_unlock(&r5f_info->stripe_lock);
+
+	if (next != NULL) {
+		thread = spdk_io_channel_get_thread(spdk_io_channel_from_ctx(next->r5ch));
+		spdk_thread_send_msg(thread, _raid5f_stripe_cache_locked, next);
 	}
+}
 
-	if (stripe_req->type == STRIPE_REQ_WRITE) {
-		spdk_dma_free(stripe_req->write.parity_buf);
-		spdk_dma_free(stripe_req->write.parity_md_buf);
-	} else {
-		struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
-		struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
-		uint8_t i;
+static void
+raid5f_stripe_cache_finish(struct stripe_request *stripe_req, enum spdk_bdev_io_status status)
+{
+	struct raid5f_io_channel *r5ch = stripe_req->r5ch;
+	TAILQ_HEAD(, spdk_bdev_io) waiting_ios;
+	struct spdk_bdev_io *bdev_io;
 
-		if (stripe_req->reconstruct.chunk_buffers) {
-			for (i = 0; i < raid5f_stripe_data_chunks_num(raid_bdev); i++) {
-				spdk_dma_free(stripe_req->reconstruct.chunk_buffers[i]);
-			}
-			free(stripe_req->reconstruct.chunk_buffers);
-		}
+	raid5f_stripe_unlock(stripe_req);
 
-		if (stripe_req->reconstruct.chunk_md_buffers) {
-			for (i = 0; i < raid5f_stripe_data_chunks_num(raid_bdev); i++) {
-				spdk_dma_free(stripe_req->reconstruct.chunk_md_buffers[i]);
-			}
-			free(stripe_req->reconstruct.chunk_md_buffers);
-		}
+	TAILQ_REMOVE(&r5ch->cached_stripes, stripe_req, cache.link);
+
+	TAILQ_INIT(&waiting_ios);
+	TAILQ_SWAP(&waiting_ios, &stripe_req->cache.waiting_ios, spdk_bdev_io, module_link);
+
+	raid5f_stripe_write_gen_inc(raid5f_ch_to_r5f_info(r5ch), stripe_req->stripe_index);
+
+	while ((bdev_io = TAILQ_FIRST(&stripe_req->cache.ios))) {
+		TAILQ_REMOVE(&stripe_req->cache.ios, bdev_io, module_link);
+		raid_bdev_io_complete((struct raid_bdev_io *)bdev_io->driver_ctx, status);
 	}
 
-	free(stripe_req->chunk_xor_buffers);
-	free(stripe_req->chunk_xor_md_buffers);
-	free(stripe_req->chunk_iov_iters);
+	raid5f_stripe_request_release(stripe_req);
 
-	free(stripe_req);
+	while ((bdev_io = TAILQ_FIRST(&waiting_ios))) {
+		TAILQ_REMOVE(&waiting_ios, bdev_io, module_link);
+		raid5f_submit_rw_request((struct raid_bdev_io *)bdev_io->driver_ctx);
+	}
 }
 
-static struct stripe_request *
-raid5f_stripe_request_alloc(struct raid5f_io_channel *r5ch, enum stripe_request_type type)
+static void
+raid5f_stripe_cache_submit_chunks(struct stripe_request *stripe_req,
+				  enum stripe_cache_state state)
 {
-	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(r5ch);
-	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
-	uint32_t raid_io_md_size = spdk_bdev_get_md_size(&raid_bdev->bdev);
-	struct stripe_request *stripe_req;
-	struct chunk *chunk;
-	size_t chunk_len;
-	void *buf;
-	uint8_t i;
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
 
-	stripe_req = calloc(1, sizeof(*stripe_req) + sizeof(*chunk) * raid_bdev->num_base_bdevs);
-	if (!stripe_req) {
-		return NULL;
-	}
+	stripe_req->cache.state = state;
 
-	stripe_req->r5ch = r5ch;
-	stripe_req->type = type;
+	raid_io->base_bdev_io_submitted = 0;
+	raid_io->base_bdev_io_remaining = raid_io->raid_bdev->num_base_bdevs;
+	raid_io->base_bdev_io_status = SPDK_BDEV_IO_STATUS_SUCCESS;
 
-	FOR_EACH_CHUNK(stripe_req, chunk) {
-		chunk->index = chunk - stripe_req->chunks;
-		chunk->iovcnt_max = 4;
-		chunk->iovs = calloc(chunk->iovcnt_max, sizeof(chunk->iovs[0]));
-		if (!chunk->iovs) {
+	raid5f_stripe_request_submit_chunks(stripe_req);
+}
+
+/* Appends to the chunk's iovecs the range of len bytes at offset in the iovs array */
+static int
+raid5f_chunk_append_iovs(struct chunk *chunk, const struct iovec *iovs, int iovcnt,
+			 size_t offset, size_t len)
+{
+	int start = chunk->iovcnt;
+	size_t remaining = len;
+	size_t off;
+	int n = 0;
+	int i, ret;
+
+	for (i = 0; i < iovcnt && offset >= iovs[i].iov_len; i++) {
+		offset -= iovs[i].iov_len;
+	}
+
+	for (off = offset; i + n < iovcnt && remaining > 0; n++) {
+		remaining -= spdk_min(remaining, iovs[i + n].iov_len - off);
+		off = 0;
+	}
+
+	if (spdk_unlikely(remaining > 0)) {
+		return -EINVAL;
+	}
+
+	ret = raid5f_chunk_set_iovcnt(chunk, start + n);
+	if (ret) {
+		return ret;
+	}
+
+	for (n = start; n < chunk->iovcnt; n++, i++) {
+		chunk->iovs[n].iov_base = iovs[i].iov_base + offset;
+		chunk->iovs[n].iov_len = spdk_min(len, iovs[i].iov_len - offset);
+		len -= chunk->iovs[n].iov_len;
+		offset = 0;
+	}
+
+	return 0;
+}
+
+/*
+ * Maps a data chunk to the collected writes, filling the gaps between them with the chunk
+ * data read from the base bdev.
+ */
+static int
+raid5f_stripe_cache_map_chunk(struct stripe_request *stripe_req, struct chunk *chunk)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	uint32_t blocklen_shift = raid_bdev->blocklen_shift;
+	struct iovec buf_iov = {
+		.iov_base = stripe_req->cache.chunk_buffers[chunk->index],
+		.iov_len = raid_bdev->strip_size << blocklen_shift,
+	};
+	uint8_t data_idx = raid5f_stripe_request_data_chunk_index(stripe_req, chunk);
+	uint64_t chunk_start = stripe_req->stripe_index * r5f_info->stripe_blocks +
+			       data_idx * raid_bdev->strip_size;
+	uint64_t chunk_end = chunk_start + raid_bdev->strip_size;
+	uint64_t pos = chunk_start;
+	struct spdk_bdev_io *bdev_io;
+	size_t buf_offset;
+	int ret;
+
+	chunk->iovcnt = 0;
+
+	TAILQ_FOREACH(bdev_io, &stripe_req->cache.ios, module_link) {
+		uint64_t io_start = bdev_io->u.bdev.offset_blocks;
+		uint64_t start = spdk_max(io_start, chunk_start);
+		uint64_t end = spdk_min(io_start + bdev_io->u.bdev.num_blocks, chunk_end);
+
+		if (start >= end) {
+			continue;
+		}
+
+		if (start > pos) {
+			buf_offset = (pos - chunk_start) << blocklen_shift;
+			ret = raid5f_chunk_append_iovs(chunk, &buf_iov, 1, buf_offset,
+						       (start - pos) << blocklen_shift);
+			if (ret) {
+				return ret;
+			}
+		}
+
+		ret = raid5f_chunk_append_iovs(chunk, bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+					       (start - io_start) << blocklen_shift,
+					       (end - start) << blocklen_shift);
+		if (ret) {
+			return ret;
+		}
+
+		pos = end;
+	}
+
+	if (pos < chunk_end) {
+		buf_offset = (pos - chunk_start) << blocklen_shift;
+		return raid5f_chunk_append_iovs(chunk, &buf_iov, 1, buf_offset,
+						(chunk_end - pos) << blocklen_shift);
+	}
+
+	return 0;
+}
+
+static void
+raid5f_stripe_cache_parity_done(struct stripe_request *stripe_req, int status)
+{
+	if (status != 0) {
+		raid5f_stripe_cache_finish(stripe_req, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	raid5f_stripe_cache_submit_chunks(stripe_req, STRIPE_CACHE_WRITING);
+}
+
+static void
+raid5f_stripe_cache_write(struct stripe_request *stripe_req)
+{
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	struct chunk *chunk;
+	int ret;
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		ret = raid5f_stripe_cache_map_chunk(stripe_req, chunk);
+		if (spdk_unlikely(ret)) {
+			raid5f_stripe_cache_finish(stripe_req, SPDK_BDEV_IO_STATUS_FAILED);
+			return;
+		}
+	}
+
+	chunk = stripe_req->parity_chunk;
+	chunk->iovs[0].iov_base = stripe_req->cache.parity_buf;
+	chunk->iovs[0].iov_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+	chunk->iovcnt = 1;
+
+	stripe_req->cache.xor_dest = chunk;
+	raid5f_xor_stripe(stripe_req, raid5f_stripe_cache_parity_done);
+}
+
+static void
+raid5f_stripe_cache_reconstruct_done(struct stripe_request *stripe_req, int status)
+{
+	if (status != 0) {
+		raid5f_stripe_cache_finish(stripe_req, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	raid5f_stripe_cache_write(stripe_req);
+}
+
+static void
+raid5f_stripe_cache_io_done(struct stripe_request *stripe_req, enum spdk_bdev_io_status status)
+{
+	if (status != SPDK_BDEV_IO_STATUS_SUCCESS ||
+	    stripe_req->cache.state == STRIPE_CACHE_WRITING) {
+		raid5f_stripe_cache_finish(stripe_req, status);
+		return;
+	}
+
+	assert(stripe_req->cache.state == STRIPE_CACHE_READING);
+
+	if (stripe_req->cache.missing_chunk != NULL) {
+		stripe_req->cache.xor_dest = stripe_req->cache.missing_chunk;
+		raid5f_xor_stripe(stripe_req, raid5f_stripe_cache_reconstruct_done);
+	} else {
+		raid5f_stripe_cache_write(stripe_req);
+	}
+}
+
+/*
+ * With the stripe locked, read the chunk data that is not overwritten, or all the chunks if
+ * a missing one has to be rebuilt, then calculate the parity and write the stripe.
+ */
+static void
+raid5f_stripe_cache_locked(struct stripe_request *stripe_req)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint64_t strip_size = raid_bdev->strip_size;
+	struct chunk *chunk;
+
+	stripe_req->cache.missing_chunk = NULL;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		chunk->iovs[0].iov_base = stripe_req->cache.chunk_buffers[chunk->index];
+		chunk->iovs[0].iov_len = strip_size << raid_bdev->blocklen_shift;
+		chunk->iovcnt = 1;
+
+		if (raid_io->raid_ch->base_channel[chunk->index] == NULL &&
+		    chunk != stripe_req->parity_chunk &&
+		    raid5f_stripe_cache_chunk_blocks_covered(stripe_req, chunk) < strip_size) {
+			stripe_req->cache.missing_chunk = chunk;
+		}
+	}
+
+	raid5f_stripe_cache_submit_chunks(stripe_req, STRIPE_CACHE_READING);
+}
+
+static void
+_raid5f_stripe_cache_locked(void *_stripe_req)
+{
+	raid5f_stripe_cache_locked(_stripe_req);
+}
+
+static void
+raid5f_stripe_cache_flush(struct stripe_request *stripe_req)
+{
+	assert(stripe_req->cache.state == STRIPE_CACHE_COLLECTING);
+
+	stripe_req->cache.state = STRIPE_CACHE_LOCKING;
+	TAILQ_INIT(&stripe_req->cache.lock_waiters);
+
+	if (raid5f_stripe_lock(stripe_req)) {
+		raid5f_stripe_cache_locked(stripe_req);
+	}
+}
+
+/* Adds a write to the stripe unless it overlaps the writes collected so far */
+static bool
+raid5f_stripe_cache_add(struct stripe_request *stripe_req, struct spdk_bdev_io *bdev_io)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
+	uint64_t start = bdev_io->u.bdev.offset_blocks;
+	uint64_t end = start + bdev_io->u.bdev.num_blocks;
+	struct spdk_bdev_io *next;
+
+	TAILQ_FOREACH(next, &stripe_req->cache.ios, module_link) {
+		if (next->u.bdev.offset_blocks >= end) {
+			break;
+		}
+
+		if (next->u.bdev.offset_blocks + next->u.bdev.num_blocks > start) {
+			return false;
+		}
+	}
+
+	if (next != NULL) {
+		TAILQ_INSERT_BEFORE(next, bdev_io, module_link);
+	} else {
+		TAILQ_INSERT_TAIL(&stripe_req->cache.ios, bdev_io, module_link);
+	}
+
+	stripe_req->cache.blocks_covered += bdev_io->u.bdev.num_blocks;
+	if (stripe_req->cache.blocks_covered == r5f_info->stripe_blocks) {
+		/* The whole stripe is written, no need to wait or read anything */
+		raid5f_stripe_cache_flush(stripe_req);
+	}
+
+	return true;
+}
+
+static int
+raid5f_submit_cached_write(struct raid_bdev_io *raid_io, uint64_t stripe_index)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid5f_io_channel *r5ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
+	struct stripe_request *stripe_req;
+
+	TAILQ_FOREACH(stripe_req, &r5ch->cached_stripes, cache.link) {
+		if (stripe_req->stripe_index == stripe_index) {
+			break;
+		}
+	}
+
+	if (stripe_req != NULL) {
+		if (stripe_req->cache.state != STRIPE_CACHE_COLLECTING ||
+		    stripe_req->raid_io->raid_ch != raid_io->raid_ch ||
+		    !raid5f_stripe_cache_add(stripe_req, bdev_io)) {
+			TAILQ_INSERT_TAIL(&stripe_req->cache.waiting_ios, bdev_io, module_link);
+			if (stripe_req->cache.state == STRIPE_CACHE_COLLECTING) {
+				raid5f_stripe_cache_flush(stripe_req);
+			}
+		}
+		return 0;
+	}
+
+	stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.cache);
+	if (!stripe_req) {
+		/* Make room by flushing the oldest stripe still collecting writes */
+		TAILQ_FOREACH(stripe_req, &r5ch->cached_stripes, cache.link) {
+			if (stripe_req->cache.state == STRIPE_CACHE_COLLECTING) {
+				raid5f_stripe_cache_flush(stripe_req);
+				break;
+			}
+		}
+		return -ENOMEM;
+	}
+
+	TAILQ_REMOVE(&r5ch->free_stripe_requests.cache, stripe_req, link);
+
+	raid5f_stripe_request_init(stripe_req, raid_io, stripe_index);
+	stripe_req->cache.state = STRIPE_CACHE_COLLECTING;
+	stripe_req->cache.blocks_covered = 0;
+	stripe_req->cache.start_ticks = spdk_get_ticks();
+	TAILQ_INIT(&stripe_req->cache.ios);
+	TAILQ_INIT(&stripe_req->cache.waiting_ios);
+
+	raid_io->module_private = stripe_req;
+
+	TAILQ_INSERT_TAIL(&r5ch->cached_stripes, stripe_req, cache.link);
+
+	raid5f_stripe_cache_add(stripe_req, bdev_io);
+
+	return 0;
+}
+
+static int
+raid5f_stripe_cache_poll(void *arg)
+{
+	struct raid5f_io_channel *r5ch = arg;
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(r5ch);
+	struct stripe_request *stripe_req, *tmp;
+	uint64_t now = spdk_get_ticks();
+	int busy = SPDK_POLLER_IDLE;
+
+	TAILQ_FOREACH_SAFE(stripe_req, &r5ch->cached_stripes, cache.link, tmp) {
+		if (stripe_req->cache.state != STRIPE_CACHE_COLLECTING) {
+			continue;
+		}
+
+		if (now - stripe_req->cache.start_ticks < r5f_info->stripe_cache_flush_ticks) {
+			break;
+		}
+
+		raid5f_stripe_cache_flush(stripe_req);
+		busy = SPDK_POLLER_BUSY;
+	}
+
+	return busy;
+}
+
+static void
+raid5f_submit_rw_request(struct raid_bdev_io *raid_io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	uint64_t offset_blocks = bdev_io->u.bdev.offset_blocks;
+	uint64_t stripe_index = offset_blocks / r5f_info->stripe_blocks;
+	uint64_t stripe_offset = offset_blocks % r5f_info->stripe_blocks;
+	int ret;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		assert(bdev_io->u.bdev.num_blocks <= raid_bdev->strip_size);
+		ret = raid5f_submit_read_request(raid_io, stripe_index, stripe_offset);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		raid5f_stripe_write_gen_inc(r5f_info, stripe_index);
+		if (r5f_info->stripe_cache_size != 0) {
+			ret = raid5f_submit_cached_write(raid_io, stripe_index);
+			break;
+		}
+		assert(stripe_offset == 0);
+		assert(bdev_io->u.bdev.num_blocks == r5f_info->stripe_blocks);
+		ret = raid5f_submit_write_request(raid_io, stripe_index);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	if (spdk_unlikely(ret)) {
+		raid_bdev_io_complete(raid_io, ret == -ENOMEM ? SPDK_BDEV_IO_STATUS_NOMEM :
+				      SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+raid5f_stripe_request_free(struct stripe_request *stripe_req)
+{
+	struct chunk *chunk;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		free(chunk->iovs);
+	}
+
+	if (stripe_req->type == STRIPE_REQ_WRITE) {
+		spdk_dma_free(stripe_req->write.parity_buf);
+		spdk_dma_free(stripe_req->write.parity_md_buf);
+	} else if (stripe_req->type == STRIPE_REQ_CACHE) {
+		struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
+		uint8_t i;
+
+		spdk_dma_free(stripe_req->cache.parity_buf);
+
+		if (stripe_req->cache.chunk_buffers) {
+			for (i = 0; i < r5f_info->raid_bdev->num_base_bdevs; i++) {
+				spdk_dma_free(stripe_req->cache.chunk_buffers[i]);
+			}
+			free(stripe_req->cache.chunk_buffers);
+		}
+	} else {
+		struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
+		struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+		uint8_t i;
+
+		if (stripe_req->reconstruct.chunk_buffers) {
+			for (i = 0; i < raid5f_stripe_data_chunks_num(raid_bdev); i++) {
+				spdk_dma_free(stripe_req->reconstruct.chunk_buffers[i]);
+			}
+			free(stripe_req->reconstruct.chunk_buffers);
+		}
+
+		if (stripe_req->reconstruct.chunk_md_buffers) {
+			for (i = 0; i < raid5f_stripe_data_chunks_num(raid_bdev); i++) {
+				spdk_dma_free(stripe_req->reconstruct.chunk_md_buffers[i]);
+			}
+			free(stripe_req->reconstruct.chunk_md_buffers);
+		}
+	}
+
+	free(stripe_req->chunk_xor_buffers);
+	free(stripe_req->chunk_xor_md_buffers);
+	free(stripe_req->chunk_iov_iters);
+
+	free(stripe_req);
+}
+
+static struct stripe_request *
+raid5f_stripe_request_alloc(struct raid5f_io_channel *r5ch, enum stripe_request_type type)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(r5ch);
+	struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+	uint32_t raid_io_md_size = spdk_bdev_get_md_size(&raid_bdev->bdev);
+	struct stripe_request *stripe_req;
+	struct chunk *chunk;
+	size_t chunk_len;
+	void *buf;
+	uint8_t i;
+
+	stripe_req = calloc(1, sizeof(*stripe_req) + sizeof(*chunk) * raid_bdev->num_base_bdevs);
+	if (!stripe_req) {
+		return NULL;
+	}
+
+	stripe_req->r5ch = r5ch;
+	stripe_req->type = type;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		chunk->index = chunk - stripe_req->chunks;
+		chunk->iovcnt_max = 4;
+		chunk->iovs = calloc(chunk->iovcnt_max, sizeof(chunk->iovs[0]));
+		if (!chunk->iovs) {
 			goto err;
 		}
 	}
@@ -942,7 +1799,7 @@ raid5f_stripe_request_alloc(struct raid5f_io_channel *r5ch, enum stripe_request_
 			}
 			stripe_req->write.parity_md_buf = buf;
 		}
-	} else if (STRIPE_REQ_RECONSTRUCT) {
+	} else if (type == STRIPE_REQ_RECONSTRUCT) {
 		uint8_t n = raid5f_stripe_data_chunks_num(raid_bdev);
 
 		stripe_req->reconstruct.chunk_buffers = calloc(n, sizeof(void *));
@@ -972,6 +1829,25 @@ raid5f_stripe_request_alloc(struct raid5f_io_channel *r5ch, enum stripe_request_
 				stripe_req->reconstruct.chunk_md_buffers[i] = buf;
 			}
 		}
+	} else if (type == STRIPE_REQ_CACHE) {
+		buf = spdk_dma_malloc(chunk_len, r5f_info->buf_alignment, NULL);
+		if (!buf) {
+			goto err;
+		}
+		stripe_req->cache.parity_buf = buf;
+
+		stripe_req->cache.chunk_buffers = calloc(raid_bdev->num_base_bdevs, sizeof(void *));
+		if (!stripe_req->cache.chunk_buffers) {
+			goto err;
+		}
+
+		for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+			buf = spdk_dma_malloc(chunk_len, r5f_info->buf_alignment, NULL);
+			if (!buf) {
+				goto err;
+			}
+			stripe_req->cache.chunk_buffers[i] = buf;
+		}
 	} else {
 		assert(false);
 		return NULL;
@@ -1001,13 +1877,235 @@ err:
 	return NULL;
 }
 
+struct raid5f_process_ctx {
+	/* Range of the base bdevs covered by the request */
+	uint64_t base_offset_blocks;
+	uint64_t base_num_blocks;
+
+	/* Destination and source buffers for reconstructing the target's data */
+	void *dest_buf;
+	void *dest_md_buf;
+	void **xor_buffers;
+	void **xor_md_buffers;
+};
+
+static void
+raid5f_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	free(process_req->module_private);
+	process_req->module_private = NULL;
+
+	raid_bdev_process_request_complete(process_req, status);
+}
+
+static void
+raid5f_process_write_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid5f_process_request_complete(process_req, success ? 0 : -EIO);
+}
+
+static void
+raid5f_process_xor_cb(void *cb_arg, int status)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+	struct raid5f_process_ctx *ctx = process_req->module_private;
+	struct raid_base_bdev_info *target = process_req->target;
+	int ret;
+
+	if (status != 0) {
+		process_req->status = status;
+	}
+
+	if (--process_req->num_ios > 0) {
+		return;
+	}
+
+	if (process_req->status != 0) {
+		raid5f_process_request_complete(process_req, process_req->status);
+		return;
+	}
+
+	ret = spdk_bdev_write_blocks_with_md(target->desc, process_req->target_ch,
+					     ctx->dest_buf, ctx->dest_md_buf,
+					     target->data_offset + ctx->base_offset_blocks,
+					     ctx->base_num_blocks, raid5f_process_write_cb,
+					     process_req);
+	if (ret != 0) {
+		raid5f_process_request_complete(process_req, ret);
+	}
+}
+
+static void
+raid5f_process_xor(struct raid_bdev_process_request *process_req)
+{
+	struct raid5f_process_ctx *ctx = process_req->module_private;
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+	struct spdk_io_channel *module_ch = process_req->raid_ch->module_channel;
+	struct raid5f_io_channel *r5ch = spdk_io_channel_get_ctx(module_ch);
+	uint8_t n_src = raid5f_stripe_data_chunks_num(raid_bdev);
+	int ret;
+
+	process_req->num_ios = ctx->dest_md_buf != NULL ? 2 : 1;
+
+	if (ctx->dest_md_buf != NULL) {
+		ret = spdk_accel_submit_xor(r5ch->accel_ch, ctx->dest_md_buf, ctx->xor_md_buffers,
+					    n_src, ctx->base_num_blocks * raid_bdev->bdev.md_len,
+					    raid5f_process_xor_cb, process_req);
+		if (ret != 0) {
+			raid5f_process_xor_cb(process_req, ret);
+		}
+	}
+
+	ret = spdk_accel_submit_xor(r5ch->accel_ch, ctx->dest_buf, ctx->xor_buffers, n_src,
+				    ctx->base_num_blocks << raid_bdev->blocklen_shift,
+				    raid5f_process_xor_cb, process_req);
+	if (ret != 0) {
+		raid5f_process_xor_cb(process_req, ret);
+	}
+}
+
+static void
+raid5f_process_read_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		process_req->status = -EIO;
+	}
+
+	if (--process_req->num_ios > 0) {
+		return;
+	}
+
+	if (process_req->status != 0) {
+		raid5f_process_request_complete(process_req, process_req->status);
+	} else {
+		raid5f_process_xor(process_req);
+	}
+}
+
+static int
+raid5f_process_read_base(struct raid_bdev_process_request *process_req,
+			 struct raid_base_bdev_info *base_info, struct spdk_io_channel *base_ch,
+			 void *buf, void *md_buf)
+{
+	struct raid5f_process_ctx *ctx = process_req->module_private;
+
+	return spdk_bdev_read_blocks_with_md(base_info->desc, base_ch, buf, md_buf,
+					     base_info->data_offset + ctx->base_offset_blocks,
+					     ctx->base_num_blocks, raid5f_process_read_cb,
+					     process_req);
+}
+
+static int
+raid5f_submit_process_request(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	struct raid_bdev_io_channel *raid_ch = process_req->raid_ch;
+	uint8_t n_src = raid5f_stripe_data_chunks_num(raid_bdev);
+	uint8_t target_idx = process_req->target - raid_bdev->base_bdev_info;
+	struct raid5f_process_ctx *ctx;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	size_t buf_len, md_len;
+	uint8_t idx, c;
+	int ret;
+
+	assert(process_req->offset_blocks % r5f_info->stripe_blocks == 0);
+	assert(process_req->num_blocks % r5f_info->stripe_blocks == 0);
+
+	ctx = calloc(1, sizeof(*ctx) + 2 * n_src * sizeof(void *));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	/* Each base bdev contributes one strip per stripe */
+	ctx->base_offset_blocks = (process_req->offset_blocks / r5f_info->stripe_blocks) <<
+				  raid_bdev->strip_size_shift;
+	ctx->base_num_blocks = (process_req->num_blocks / r5f_info->stripe_blocks) <<
+			       raid_bdev->strip_size_shift;
+	ctx->xor_buffers = (void **)(ctx + 1);
+	ctx->xor_md_buffers = ctx->xor_buffers + n_src;
+
+	/* The buffers fit all the strips of the sources and the target */
+	buf_len = ctx->base_num_blocks << raid_bdev->blocklen_shift;
+	md_len = ctx->base_num_blocks * raid_bdev->bdev.md_len;
+	ctx->dest_buf = process_req->buf + n_src * buf_len;
+	if (process_req->md_buf != NULL) {
+		ctx->dest_md_buf = process_req->md_buf + n_src * md_len;
+	}
+
+	process_req->module_private = ctx;
+	process_req->num_ios = 0;
+	process_req->status = 0;
+
+	c = 0;
+	for (idx = 0; idx < raid_bdev->num_base_bdevs; idx++) {
+		if (idx == target_idx) {
+			continue;
+		}
+
+		base_info = &raid_bdev->base_bdev_info[idx];
+		base_ch = raid_ch->base_channel[idx];
+		ctx->xor_buffers[c] = process_req->buf + c * buf_len;
+		if (process_req->md_buf != NULL) {
+			ctx->xor_md_buffers[c] = process_req->md_buf + c * md_len;
+		}
+
+		if (base_ch == NULL) {
+			ret = -ENODEV;
+		} else {
+			ret = raid5f_process_read_base(process_req, base_info, base_ch,
+						       ctx->xor_buffers[c], ctx->xor_md_buffers[c]);
+		}
+		if (ret != 0) {
+			if (process_req->num_ios == 0) {
+				free(ctx);
+				process_req->module_private = NULL;
+				return ret;
+			}
+			process_req->status = ret;
+			break;
+		}
+
+		process_req->num_ios++;
+		c++;
+	}
+
+	return 0;
+}
+
 static void
 raid5f_ioch_destroy(void *io_device, void *ctx_buf)
 {
 	struct raid5f_io_channel *r5ch = ctx_buf;
 	struct stripe_request *stripe_req;
+	int i;
 
 	assert(TAILQ_EMPTY(&r5ch->xor_retry_queue));
+	assert(TAILQ_EMPTY(&r5ch->cached_stripes));
+
+	spdk_poller_unregister(&r5ch->stripe_cache_poller);
+
+	if (r5ch->reconstruct_cache_entries != NULL) {
+		for (i = 0; i < RAID5F_RECONSTRUCT_CACHE_SIZE; i++) {
+			assert(!r5ch->reconstruct_cache_entries[i].filling);
+			spdk_dma_free(r5ch->reconstruct_cache_entries[i].buf);
+		}
+		free(r5ch->reconstruct_cache_entries);
+	}
+
+	while ((stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.cache))) {
+		TAILQ_REMOVE(&r5ch->free_stripe_requests.cache, stripe_req, link);
+		raid5f_stripe_request_free(stripe_req);
+	}
 
 	while ((stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.write))) {
 		TAILQ_REMOVE(&r5ch->free_stripe_requests.write, stripe_req, link);
@@ -1035,6 +2133,10 @@ raid5f_ioch_create(void *io_device, void *ctx_buf)
 
 	TAILQ_INIT(&r5ch->free_stripe_requests.write);
 	TAILQ_INIT(&r5ch->free_stripe_requests.reconstruct);
+	TAILQ_INIT(&r5ch->free_stripe_requests.cache);
+	TAILQ_INIT(&r5ch->cached_stripes);
+	TAILQ_INIT(&r5ch->reconstruct_cache);
+	r5ch->last_reconstruct_stripe = UINT64_MAX;
 
 	for (i = 0; i < RAID5F_MAX_STRIPES; i++) {
 		stripe_req = raid5f_stripe_request_alloc(r5ch, STRIPE_REQ_WRITE);
@@ -1056,6 +2158,49 @@ raid5f_ioch_create(void *io_device, void *ctx_buf)
 		TAILQ_INSERT_HEAD(&r5ch->free_stripe_requests.reconstruct, stripe_req, link);
 	}
 
+	for (i = 0; i < (int)r5f_info->stripe_cache_size; i++) {
+		stripe_req = raid5f_stripe_request_alloc(r5ch, STRIPE_REQ_CACHE);
+		if (!stripe_req) {
+			status = -ENOMEM;
+			goto out;
+		}
+
+		TAILQ_INSERT_HEAD(&r5ch->free_stripe_requests.cache, stripe_req, link);
+	}
+
+	if (r5f_info->stripe_write_gen != NULL) {
+		struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+		size_t chunk_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+		struct raid5f_reconstruct_cache_entry *entry;
+
+		r5ch->reconstruct_cache_entries = calloc(RAID5F_RECONSTRUCT_CACHE_SIZE,
+						  sizeof(*r5ch->reconstruct_cache_entries));
+		if (!r5ch->reconstruct_cache_entries) {
+			status = -ENOMEM;
+			goto out;
+		}
+
+		for (i = 0; i < RAID5F_RECONSTRUCT_CACHE_SIZE; i++) {
+			entry = &r5ch->reconstruct_cache_entries[i];
+			entry->buf = spdk_dma_malloc(chunk_len, r5f_info->buf_alignment, NULL);
+			if (!entry->buf) {
+				status = -ENOMEM;
+				goto out;
+			}
+			TAILQ_INIT(&entry->waiting_ios);
+			TAILQ_INSERT_TAIL(&r5ch->reconstruct_cache, entry, link);
+		}
+	}
+
+	if (r5f_info->stripe_cache_size != 0) {
+		r5ch->stripe_cache_poller = SPDK_POLLER_REGISTER(raid5f_stripe_cache_poll, r5ch,
+					    r5f_info->stripe_cache_flush_us);
+		if (!r5ch->stripe_cache_poller) {
+			status = -ENOMEM;
+			goto out;
+		}
+	}
+
 	r5ch->accel_ch = spdk_accel_get_io_channel();
 	if (!r5ch->accel_ch) {
 		SPDK_ERRLOG("Failed to get accel framework's IO channel\n");
@@ -1078,7 +2223,9 @@ raid5f_start(struct raid_bdev *raid_bdev)
 	uint64_t base_bdev_data_size;
 	struct raid_base_bdev_info *base_info;
 	struct raid5f_info *r5f_info;
+	struct raid_bdev_opts opts;
 	size_t alignment = 0;
+	int i;
 
 	r5f_info = calloc(1, sizeof(*r5f_info));
 	if (!r5f_info) {
@@ -1107,8 +2254,45 @@ raid5f_start(struct raid_bdev *raid_bdev)
 	raid_bdev->bdev.blockcnt = r5f_info->stripe_blocks * r5f_info->total_stripes;
 	raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
 	raid_bdev->bdev.split_on_optimal_io_boundary = true;
-	raid_bdev->bdev.write_unit_size = r5f_info->stripe_blocks;
-	raid_bdev->bdev.split_on_write_unit = true;
+
+	if (raid_bdev->bdev.md_len == 0 || raid_bdev->bdev.md_interleave) {
+		/* Degraded reads with separate metadata are always reconstructed per request */
+		r5f_info->stripe_write_gen = calloc(RAID5F_STRIPE_WRITE_GEN_SIZE,
+						    sizeof(*r5f_info->stripe_write_gen));
+		if (!r5f_info->stripe_write_gen) {
+			SPDK_ERRLOG("Failed to allocate stripe write generations\n");
+			free(r5f_info);
+			return -ENOMEM;
+		}
+	}
+
+	raid_bdev_get_opts(&opts);
+	if (opts.raid5f_stripe_cache_size != 0 && raid_bdev->bdev.md_len != 0 &&
+	    !raid_bdev->bdev.md_interleave) {
+		SPDK_NOTICELOG("Stripe cache not supported with separate metadata, raid bdev %s "
+			       "accepts only full stripe writes\n", raid_bdev->bdev.name);
+	} else {
+		r5f_info->stripe_cache_size = opts.raid5f_stripe_cache_size;
+		r5f_info->stripe_cache_flush_us = opts.raid5f_stripe_cache_flush_us;
+		r5f_info->stripe_cache_flush_ticks = (uint64_t)opts.raid5f_stripe_cache_flush_us *
+						     spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+	}
+
+	if (r5f_info->stripe_cache_size != 0) {
+		/*
+		 * Writes are split on strip boundaries like reads and collected in the stripe
+		 * cache, which writes a stripe when it is complete or the flush time expires.
+		 */
+		raid_bdev->bdev.write_unit_size = 1;
+		raid_bdev->bdev.split_on_write_unit = false;
+		spdk_spin_init(&r5f_info->stripe_lock);
+		for (i = 0; i < RAID5F_STRIPE_LOCK_BUCKETS; i++) {
+			TAILQ_INIT(&r5f_info->locked_stripes[i]);
+		}
+	} else {
+		raid_bdev->bdev.write_unit_size = r5f_info->stripe_blocks;
+		raid_bdev->bdev.split_on_write_unit = true;
+	}
 
 	raid_bdev->module_private = r5f_info;
 
@@ -1125,6 +2309,11 @@ raid5f_io_device_unregister_done(void *io_device)
 
 	raid_bdev_module_stop_done(r5f_info->raid_bdev);
 
+	if (r5f_info->stripe_cache_size != 0) {
+		spdk_spin_destroy(&r5f_info->stripe_lock);
+	}
+
+	free(r5f_info->stripe_write_gen);
 	free(r5f_info);
 }
 
@@ -1154,6 +2343,7 @@ static struct raid_bdev_module g_raid5f_module = {
 	.stop = raid5f_stop,
 	.submit_rw_request = raid5f_submit_rw_request,
 	.get_io_channel = raid5f_get_io_channel,
+	.submit_process_request = raid5f_submit_process_request,
 };
 RAID_MODULE_REGISTER(&g_raid5f_module)
 
@@ -0,0 +1,1283 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "bdev_raid.h"
+
+#include "spdk/env.h"
+#include "spdk/thread.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+#include "spdk/likely.h"
+#include "spdk/log.h"
+#include "spdk/accel.h"
+#include "spdk/xor.h"
+
+/* Maximum concurrent full stripe writes and degraded reads per io channel */
+#define RAID6F_MAX_STRIPES 32
+
+struct chunk {
+	/* Corresponds to base_bdev index */
+	uint8_t index;
+
+	/* Array of iovecs */
+	struct iovec *iovs;
+
+	/* Number of used iovecs */
+	int iovcnt;
+
+	/* Total number of available iovecs in the array */
+	int iovcnt_max;
+
+	/* Shallow copy of IO request parameters */
+	struct spdk_bdev_ext_io_opts ext_opts;
+};
+
+struct stripe_request {
+	enum stripe_request_type {
+		STRIPE_REQ_WRITE,
+		STRIPE_REQ_RECONSTRUCT,
+	} type;
+
+	struct raid6f_io_channel *r6ch;
+
+	/* The associated raid_bdev_io */
+	struct raid_bdev_io *raid_io;
+
+	/* The stripe's index in the raid array. */
+	uint64_t stripe_index;
+
+	/* The stripe's P and Q parity chunks */
+	struct chunk *p_chunk;
+	struct chunk *q_chunk;
+
+	union {
+		struct {
+			/* Buffers for stripe parity */
+			void *p_buf;
+			void *q_buf;
+		} write;
+
+		struct {
+			/* Array of buffers for reading chunk data, one per base bdev */
+			void **chunk_buffers;
+
+			/* Chunk to reconstruct */
+			struct chunk *chunk;
+
+			/* Another missing chunk of the stripe, NULL if there is none */
+			struct chunk *missing_chunk;
+
+			/* Offset from chunk start */
+			uint64_t chunk_offset;
+		} reconstruct;
+	};
+
+	/* Array of iovec iterators for each data chunk */
+	struct iov_iter {
+		struct iovec *iovs;
+		int iovcnt;
+		int index;
+		size_t offset;
+	} *chunk_iov_iters;
+
+	/* Array of source buffer pointers for parity calculation */
+	void **chunk_xor_buffers;
+
+	struct {
+		size_t len;
+		size_t offset;
+		size_t remaining;
+	} parity;
+
+	TAILQ_ENTRY(stripe_request) link;
+
+	/* Array of chunks corresponding to base_bdevs */
+	struct chunk chunks[0];
+};
+
+struct raid6f_info {
+	/* The parent raid bdev */
+	struct raid_bdev *raid_bdev;
+
+	/* Number of data blocks in a stripe (without parity) */
+	uint64_t stripe_blocks;
+
+	/* Number of stripes on this array */
+	uint64_t total_stripes;
+
+	/* Alignment for buffer allocation */
+	size_t buf_alignment;
+};
+
+struct raid6f_io_channel {
+	/* All available stripe requests on this channel */
+	struct {
+		TAILQ_HEAD(, stripe_request) write;
+		TAILQ_HEAD(, stripe_request) reconstruct;
+	} free_stripe_requests;
+
+	/* accel_fw channel */
+	struct spdk_io_channel *accel_ch;
+
+	/* For retrying xor if accel_ch runs out of resources */
+	TAILQ_HEAD(, stripe_request) xor_retry_queue;
+};
+
+#define __CHUNK_IN_RANGE(req, c) \
+	c < req->chunks + raid6f_ch_to_r6f_info(req->r6ch)->raid_bdev->num_base_bdevs
+
+#define FOR_EACH_CHUNK_FROM(req, c, from) \
+	for (c = from; __CHUNK_IN_RANGE(req, c); c++)
+
+#define FOR_EACH_CHUNK(req, c) \
+	FOR_EACH_CHUNK_FROM(req, c, req->chunks)
+
+#define FOR_EACH_DATA_CHUNK(req, c) \
+	FOR_EACH_CHUNK(req, c) \
+		if (c != req->p_chunk && c != req->q_chunk)
+
+static inline struct raid6f_info *
+raid6f_ch_to_r6f_info(struct raid6f_io_channel *r6ch)
+{
+	return spdk_io_channel_get_io_device(spdk_io_channel_from_ctx(r6ch));
+}
+
+static inline struct stripe_request *
+raid6f_chunk_stripe_req(struct chunk *chunk)
+{
+	return SPDK_CONTAINEROF((chunk - chunk->index), struct stripe_request, chunks);
+}
+
+static inline uint8_t
+raid6f_stripe_data_chunks_num(const struct raid_bdev *raid_bdev)
+{
+	return raid_bdev->min_base_bdevs_operational;
+}
+
+/* P rotates backwards like the parity of raid5f and Q is on the next base bdev */
+static inline uint8_t
+raid6f_stripe_p_chunk_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index)
+{
+	return raid_bdev->num_base_bdevs - 1 - stripe_index % raid_bdev->num_base_bdevs;
+}
+
+static inline uint8_t
+raid6f_stripe_q_chunk_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index)
+{
+	return (raid6f_stripe_p_chunk_index(raid_bdev, stripe_index) + 1) % raid_bdev->num_base_bdevs;
+}
+
+/* Returns the base bdev index of a data chunk, data chunks skip the P and Q chunks */
+static inline uint8_t
+raid6f_stripe_data_chunk_base_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index,
+				    uint8_t data_idx)
+{
+	uint8_t p_idx = raid6f_stripe_p_chunk_index(raid_bdev, stripe_index);
+	uint8_t q_idx = raid6f_stripe_q_chunk_index(raid_bdev, stripe_index);
+	uint8_t idx = data_idx;
+
+	if (idx >= spdk_min(p_idx, q_idx)) {
+		idx++;
+	}
+	if (idx >= spdk_max(p_idx, q_idx)) {
+		idx++;
+	}
+
+	return idx;
+}
+
+/*
+ * Returns the index of a base bdev's chunk in the arrays passed to spdk_pq_recover(): the data
+ * chunk index, or the number of data chunks for P and one more for Q.
+ */
+static uint8_t
+raid6f_stripe_chunk_pq_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index,
+			     uint8_t idx)
+{
+	uint8_t p_idx = raid6f_stripe_p_chunk_index(raid_bdev, stripe_index);
+	uint8_t q_idx = raid6f_stripe_q_chunk_index(raid_bdev, stripe_index);
+	uint8_t n = raid6f_stripe_data_chunks_num(raid_bdev);
+
+	if (idx == p_idx) {
+		return n;
+	} else if (idx == q_idx) {
+		return n + 1;
+	}
+
+	return idx - (p_idx < idx) - (q_idx < idx);
+}
+
+static inline void
+raid6f_stripe_request_release(struct stripe_request *stripe_req)
+{
+	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
+		TAILQ_INSERT_HEAD(&stripe_req->r6ch->free_stripe_requests.write, stripe_req, link);
+	} else {
+		TAILQ_INSERT_HEAD(&stripe_req->r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+	}
+}
+
+static inline void
+raid6f_iov_iter_advance(struct iov_iter *iov_iter, size_t len)
+{
+	struct iovec *iov = &iov_iter->iovs[iov_iter->index];
+
+	iov_iter->offset += len;
+	if (iov_iter->offset == iov->iov_len) {
+		iov_iter->offset = 0;
+		iov_iter->index++;
+	}
+
+	assert(!(iov_iter->offset > iov->iov_len));
+}
+
+static void raid6f_stripe_request_submit_chunks(struct stripe_request *stripe_req);
+
+static void
+raid6f_stripe_parity_done(struct stripe_request *stripe_req, int status)
+{
+	if (status != 0) {
+		SPDK_ERRLOG("stripe parity calculation failed: %s\n", spdk_strerror(-status));
+		raid6f_stripe_request_release(stripe_req);
+		raid_bdev_io_complete(stripe_req->raid_io, SPDK_BDEV_IO_STATUS_FAILED);
+	} else {
+		raid6f_stripe_request_submit_chunks(stripe_req);
+	}
+}
+
+static void raid6f_stripe_parity_continue(struct stripe_request *stripe_req);
+
+static void
+raid6f_stripe_parity_cb(void *_stripe_req, int status)
+{
+	struct stripe_request *stripe_req = _stripe_req;
+	struct raid6f_io_channel *r6ch = stripe_req->r6ch;
+	size_t len = stripe_req->parity.len;
+	uint8_t n_src = raid6f_stripe_data_chunks_num(stripe_req->raid_io->raid_bdev);
+	uint8_t i;
+
+	if (status != 0) {
+		raid6f_stripe_parity_done(stripe_req, status);
+	} else {
+		stripe_req->parity.remaining -= len;
+		stripe_req->parity.offset += len;
+
+		if (stripe_req->parity.remaining > 0) {
+			for (i = 0; i < n_src; i++) {
+				raid6f_iov_iter_advance(&stripe_req->chunk_iov_iters[i], len);
+			}
+			raid6f_stripe_parity_continue(stripe_req);
+		} else {
+			raid6f_stripe_parity_done(stripe_req, 0);
+		}
+	}
+
+	if (!TAILQ_EMPTY(&r6ch->xor_retry_queue)) {
+		stripe_req = TAILQ_FIRST(&r6ch->xor_retry_queue);
+		TAILQ_REMOVE(&r6ch->xor_retry_queue, stripe_req, link);
+		raid6f_stripe_parity_continue(stripe_req);
+	}
+}
+
+/*
+ * The accel framework has no operation for the Q syndrome, so Q is generated on the CPU for
+ * each segment while P is calculated with an accel xor.
+ */
+static void
+raid6f_stripe_parity_continue(struct stripe_request *stripe_req)
+{
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	uint8_t n_src = raid6f_stripe_data_chunks_num(raid_bdev);
+	size_t len = stripe_req->parity.remaining;
+	size_t offset = stripe_req->parity.offset;
+	uint8_t i;
+	int ret;
+
+	for (i = 0; i < n_src; i++) {
+		struct iov_iter *iov_iter = &stripe_req->chunk_iov_iters[i];
+		struct iovec *iov = &iov_iter->iovs[iov_iter->index];
+
+		len = spdk_min(len, iov->iov_len - iov_iter->offset);
+		stripe_req->chunk_xor_buffers[i] = iov->iov_base + iov_iter->offset;
+	}
+
+	assert(len > 0);
+	stripe_req->parity.len = len;
+
+	ret = spdk_pq_gen(NULL, stripe_req->write.q_buf + offset, stripe_req->chunk_xor_buffers,
+			  n_src, len);
+	if (spdk_unlikely(ret)) {
+		raid6f_stripe_parity_done(stripe_req, ret);
+		return;
+	}
+
+	ret = spdk_accel_submit_xor(stripe_req->r6ch->accel_ch, stripe_req->write.p_buf + offset,
+				    stripe_req->chunk_xor_buffers, n_src, len,
+				    raid6f_stripe_parity_cb, stripe_req);
+	if (spdk_unlikely(ret)) {
+		if (ret == -ENOMEM) {
+			TAILQ_INSERT_HEAD(&stripe_req->r6ch->xor_retry_queue, stripe_req, link);
+		} else {
+			raid6f_stripe_parity_done(stripe_req, ret);
+		}
+	}
+}
+
+static void
+raid6f_stripe_parity(struct stripe_request *stripe_req)
+{
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	struct chunk *chunk;
+	uint8_t c = 0;
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		struct iov_iter *iov_iter = &stripe_req->chunk_iov_iters[c++];
+
+		iov_iter->iovs = chunk->iovs;
+		iov_iter->iovcnt = chunk->iovcnt;
+		iov_iter->index = 0;
+		iov_iter->offset = 0;
+	}
+
+	stripe_req->parity.offset = 0;
+	stripe_req->parity.remaining = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+
+	raid6f_stripe_parity_continue(stripe_req);
+}
+
+/* Reconstructs the read range of the chunk from the other chunks read into the buffers */
+static int
+raid6f_stripe_request_reconstruct(struct stripe_request *stripe_req)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	uint8_t n_src = raid6f_stripe_data_chunks_num(raid_bdev);
+	void **buffers = stripe_req->reconstruct.chunk_buffers;
+	struct chunk *chunk = stripe_req->reconstruct.chunk;
+	struct chunk *missing = stripe_req->reconstruct.missing_chunk;
+	uint32_t len = bdev_io->u.bdev.num_blocks << raid_bdev->blocklen_shift;
+	uint8_t fail_a, fail_b;
+	uint8_t c = 0;
+	int ret;
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		stripe_req->chunk_xor_buffers[c++] = buffers[chunk->index];
+	}
+
+	chunk = stripe_req->reconstruct.chunk;
+	fail_a = raid6f_stripe_chunk_pq_index(raid_bdev, stripe_req->stripe_index, chunk->index);
+	fail_b = fail_a;
+
+	/* A missing Q doesn't matter, the chunk is reconstructed from P then */
+	if (missing != NULL && missing != stripe_req->q_chunk) {
+		fail_b = raid6f_stripe_chunk_pq_index(raid_bdev, stripe_req->stripe_index,
+						      missing->index);
+	}
+
+	ret = spdk_pq_recover(stripe_req->chunk_xor_buffers, buffers[stripe_req->p_chunk->index],
+			      buffers[stripe_req->q_chunk->index], n_src, len, fail_a, fail_b);
+	if (ret) {
+		return ret;
+	}
+
+	spdk_copy_buf_to_iovs(bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt, buffers[chunk->index],
+			      len);
+
+	return 0;
+}
+
+static void
+raid6f_stripe_request_chunk_write_complete(struct stripe_request *stripe_req,
+		enum spdk_bdev_io_status status)
+{
+	if (raid_bdev_io_complete_part(stripe_req->raid_io, 1, status)) {
+		raid6f_stripe_request_release(stripe_req);
+	}
+}
+
+static void
+raid6f_stripe_request_chunk_read_complete(struct stripe_request *stripe_req,
+		enum spdk_bdev_io_status status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	if (raid_io->base_bdev_io_remaining == 1) {
+		if (raid_io->base_bdev_io_status == SPDK_BDEV_IO_STATUS_SUCCESS &&
+		    status == SPDK_BDEV_IO_STATUS_SUCCESS &&
+		    raid6f_stripe_request_reconstruct(stripe_req) != 0) {
+			status = SPDK_BDEV_IO_STATUS_FAILED;
+		}
+		raid6f_stripe_request_release(stripe_req);
+	}
+
+	raid_bdev_io_complete_part(raid_io, 1, status);
+}
+
+static void
+raid6f_chunk_complete_bdev_io(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct chunk *chunk = cb_arg;
+	struct stripe_request *stripe_req = raid6f_chunk_stripe_req(chunk);
+	enum spdk_bdev_io_status status = success ? SPDK_BDEV_IO_STATUS_SUCCESS :
+					  SPDK_BDEV_IO_STATUS_FAILED;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
+		raid6f_stripe_request_chunk_write_complete(stripe_req, status);
+	} else {
+		raid6f_stripe_request_chunk_read_complete(stripe_req, status);
+	}
+}
+
+static void
+raid6f_chunk_submit_retry(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+	struct stripe_request *stripe_req = raid_io->module_private;
+
+	raid6f_stripe_request_submit_chunks(stripe_req);
+}
+
+static inline void
+raid6f_init_ext_io_opts(struct spdk_bdev_io *bdev_io, struct spdk_bdev_ext_io_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->size = sizeof(*opts);
+	opts->memory_domain = bdev_io->u.bdev.memory_domain;
+	opts->memory_domain_ctx = bdev_io->u.bdev.memory_domain_ctx;
+}
+
+/*
+ * Every chunk of a write is completed, the missing ones right away. A degraded read reads all
+ * the chunks it needs except Q, which is only needed when another chunk is missing too.
+ */
+static bool
+raid6f_chunk_needs_io(struct stripe_request *stripe_req, struct chunk *chunk)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	if (stripe_req->type == STRIPE_REQ_WRITE) {
+		return true;
+	}
+
+	if (chunk == stripe_req->reconstruct.chunk ||
+	    raid_io->raid_ch->base_channel[chunk->index] == NULL) {
+		return false;
+	}
+
+	return chunk != stripe_req->q_chunk || (stripe_req->reconstruct.missing_chunk != NULL &&
+						stripe_req->reconstruct.missing_chunk != chunk);
+}
+
+static int
+raid6f_chunk_submit(struct chunk *chunk)
+{
+	struct stripe_request *stripe_req = raid6f_chunk_stripe_req(chunk);
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[chunk->index];
+	struct spdk_io_channel *base_ch = raid_io->raid_ch->base_channel[chunk->index];
+	uint64_t base_offset_blocks = (stripe_req->stripe_index << raid_bdev->strip_size_shift);
+	int ret;
+
+	raid6f_init_ext_io_opts(bdev_io, &chunk->ext_opts);
+
+	switch (stripe_req->type) {
+	case STRIPE_REQ_WRITE:
+		if (base_ch == NULL) {
+			raid_io->base_bdev_io_submitted++;
+			raid6f_stripe_request_chunk_write_complete(stripe_req,
+					SPDK_BDEV_IO_STATUS_SUCCESS);
+			return 0;
+		}
+
+		ret = raid_bdev_writev_blocks_ext(base_info, base_ch, chunk->iovs, chunk->iovcnt,
+						  base_offset_blocks, raid_bdev->strip_size,
+						  raid6f_chunk_complete_bdev_io, chunk,
+						  &chunk->ext_opts);
+		break;
+	case STRIPE_REQ_RECONSTRUCT:
+		if (!raid6f_chunk_needs_io(stripe_req, chunk)) {
+			raid_io->base_bdev_io_submitted++;
+			return 0;
+		}
+
+		base_offset_blocks += stripe_req->reconstruct.chunk_offset;
+
+		ret = raid_bdev_readv_blocks_ext(base_info, base_ch, chunk->iovs, chunk->iovcnt,
+						 base_offset_blocks, bdev_io->u.bdev.num_blocks,
+						 raid6f_chunk_complete_bdev_io, chunk,
+						 &chunk->ext_opts);
+		break;
+	default:
+		assert(false);
+		ret = -EINVAL;
+		break;
+	}
+
+	if (spdk_unlikely(ret)) {
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, base_info->bdev, base_ch,
+						raid6f_chunk_submit_retry);
+		} else {
+			/*
+			 * Implicitly complete any I/Os not yet submitted as FAILED. If completing
+			 * these means there are no more to complete for the stripe request, we can
+			 * release the stripe request as well.
+			 */
+			uint64_t base_bdev_io_not_submitted = 0;
+			struct chunk *c;
+
+			FOR_EACH_CHUNK_FROM(stripe_req, c, chunk) {
+				if (raid6f_chunk_needs_io(stripe_req, c)) {
+					base_bdev_io_not_submitted++;
+				}
+			}
+
+			if (raid_bdev_io_complete_part(raid_io, base_bdev_io_not_submitted,
+						       SPDK_BDEV_IO_STATUS_FAILED)) {
+				raid6f_stripe_request_release(stripe_req);
+			}
+		}
+	} else {
+		raid_io->base_bdev_io_submitted++;
+	}
+
+	return ret;
+}
+
+static int
+raid6f_chunk_set_iovcnt(struct chunk *chunk, int iovcnt)
+{
+	if (iovcnt > chunk->iovcnt_max) {
+		struct iovec *iovs = chunk->iovs;
+
+		iovs = realloc(iovs, iovcnt * sizeof(*iovs));
+		if (!iovs) {
+			return -ENOMEM;
+		}
+		chunk->iovs = iovs;
+		chunk->iovcnt_max = iovcnt;
+	}
+	chunk->iovcnt = iovcnt;
+
+	return 0;
+}
+
+static int
+raid6f_stripe_request_map_iovecs(struct stripe_request *stripe_req)
+{
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(stripe_req->raid_io);
+	const struct iovec *raid_io_iovs = bdev_io->u.bdev.iovs;
+	int raid_io_iovcnt = bdev_io->u.bdev.iovcnt;
+	size_t strip_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+	struct chunk *chunk;
+	int raid_io_iov_idx = 0;
+	size_t raid_io_offset = 0;
+	size_t raid_io_iov_offset = 0;
+	int i;
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		int chunk_iovcnt = 0;
+		uint64_t len = strip_len;
+		size_t off = raid_io_iov_offset;
+		int ret;
+
+		for (i = raid_io_iov_idx; i < raid_io_iovcnt; i++) {
+			chunk_iovcnt++;
+			off += raid_io_iovs[i].iov_len;
+			if (off >= raid_io_offset + len) {
+				break;
+			}
+		}
+
+		assert(raid_io_iov_idx + chunk_iovcnt <= raid_io_iovcnt);
+
+		ret = raid6f_chunk_set_iovcnt(chunk, chunk_iovcnt);
+		if (ret) {
+			return ret;
+		}
+
+		for (i = 0; i < chunk_iovcnt; i++) {
+			struct iovec *chunk_iov = &chunk->iovs[i];
+			const struct iovec *raid_io_iov = &raid_io_iovs[raid_io_iov_idx];
+			size_t chunk_iov_offset = raid_io_offset - raid_io_iov_offset;
+
+			chunk_iov->iov_base = raid_io_iov->iov_base + chunk_iov_offset;
+			chunk_iov->iov_len = spdk_min(len, raid_io_iov->iov_len - chunk_iov_offset);
+			raid_io_offset += chunk_iov->iov_len;
+			len -= chunk_iov->iov_len;
+
+			if (raid_io_offset >= raid_io_iov_offset + raid_io_iov->iov_len) {
+				raid_io_iov_idx++;
+				raid_io_iov_offset += raid_io_iov->iov_len;
+			}
+		}
+
+		if (spdk_unlikely(len > 0)) {
+			return -EINVAL;
+		}
+	}
+
+	stripe_req->p_chunk->iovs[0].iov_base = stripe_req->write.p_buf;
+	stripe_req->p_chunk->iovs[0].iov_len = strip_len;
+	stripe_req->p_chunk->iovcnt = 1;
+
+	stripe_req->q_chunk->iovs[0].iov_base = stripe_req->write.q_buf;
+	stripe_req->q_chunk->iovs[0].iov_len = strip_len;
+	stripe_req->q_chunk->iovcnt = 1;
+
+	return 0;
+}
+
+static void
+raid6f_stripe_request_submit_chunks(struct stripe_request *stripe_req)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct chunk *start = &stripe_req->chunks[raid_io->base_bdev_io_submitted];
+	struct chunk *chunk;
+
+	FOR_EACH_CHUNK_FROM(stripe_req, chunk, start) {
+		if (spdk_unlikely(raid6f_chunk_submit(chunk) != 0)) {
+			break;
+		}
+	}
+}
+
+static inline void
+raid6f_stripe_request_init(struct stripe_request *stripe_req, struct raid_bdev_io *raid_io,
+			   uint64_t stripe_index)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+
+	stripe_req->raid_io = raid_io;
+	stripe_req->stripe_index = stripe_index;
+	stripe_req->p_chunk = &stripe_req->chunks[raid6f_stripe_p_chunk_index(raid_bdev,
+							    stripe_index)];
+	stripe_req->q_chunk = &stripe_req->chunks[raid6f_stripe_q_chunk_index(raid_bdev,
+							    stripe_index)];
+}
+
+static int
+raid6f_submit_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6f_io_channel *r6ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
+	struct stripe_request *stripe_req;
+	int ret;
+
+	stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.write);
+	if (!stripe_req) {
+		return -ENOMEM;
+	}
+
+	raid6f_stripe_request_init(stripe_req, raid_io, stripe_index);
+
+	ret = raid6f_stripe_request_map_iovecs(stripe_req);
+	if (spdk_unlikely(ret)) {
+		return ret;
+	}
+
+	TAILQ_REMOVE(&r6ch->free_stripe_requests.write, stripe_req, link);
+
+	raid_io->module_private = stripe_req;
+	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
+
+	raid6f_stripe_parity(stripe_req);
+
+	return 0;
+}
+
+static void
+raid6f_chunk_read_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_io_complete(raid_io, success ? SPDK_BDEV_IO_STATUS_SUCCESS :
+			      SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void raid6f_submit_rw_request(struct raid_bdev_io *raid_io);
+
+static void
+_raid6f_submit_rw_request(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid6f_submit_rw_request(raid_io);
+}
+
+static int
+raid6f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+			       uint8_t chunk_idx, uint64_t chunk_offset)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6f_io_channel *r6ch = spdk_io_channel_get_ctx(raid_io->raid_ch->module_channel);
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct stripe_request *stripe_req;
+	struct chunk *chunk;
+
+	stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.reconstruct);
+	if (!stripe_req) {
+		return -ENOMEM;
+	}
+
+	raid6f_stripe_request_init(stripe_req, raid_io, stripe_index);
+
+	stripe_req->reconstruct.chunk = &stripe_req->chunks[chunk_idx];
+	stripe_req->reconstruct.chunk_offset = chunk_offset;
+	stripe_req->reconstruct.missing_chunk = NULL;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		chunk->iovs[0].iov_base = stripe_req->reconstruct.chunk_buffers[chunk->index];
+		chunk->iovs[0].iov_len = bdev_io->u.bdev.num_blocks << raid_bdev->blocklen_shift;
+		chunk->iovcnt = 1;
+
+		if (chunk != stripe_req->reconstruct.chunk &&
+		    raid_io->raid_ch->base_channel[chunk->index] == NULL) {
+			stripe_req->reconstruct.missing_chunk = chunk;
+		}
+	}
+
+	raid_io->module_private = stripe_req;
+	raid_io->base_bdev_io_remaining = 0;
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		if (raid6f_chunk_needs_io(stripe_req, chunk)) {
+			raid_io->base_bdev_io_remaining++;
+		}
+	}
+
+	TAILQ_REMOVE(&r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+
+	raid6f_stripe_request_submit_chunks(stripe_req);
+
+	return 0;
+}
+
+static int
+raid6f_submit_read_request(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+			   uint64_t stripe_offset)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint8_t chunk_data_idx = stripe_offset >> raid_bdev->strip_size_shift;
+	uint8_t chunk_idx = raid6f_stripe_data_chunk_base_index(raid_bdev, stripe_index,
+			    chunk_data_idx);
+	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[chunk_idx];
+	struct spdk_io_channel *base_ch = raid_io->raid_ch->base_channel[chunk_idx];
+	uint64_t chunk_offset = stripe_offset - (chunk_data_idx << raid_bdev->strip_size_shift);
+	uint64_t base_offset_blocks = (stripe_index << raid_bdev->strip_size_shift) + chunk_offset;
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	raid6f_init_ext_io_opts(bdev_io, &io_opts);
+	if (base_ch == NULL) {
+		return raid6f_submit_reconstruct_read(raid_io, stripe_index, chunk_idx, chunk_offset);
+	}
+
+	ret = raid_bdev_readv_blocks_ext(base_info, base_ch, bdev_io->u.bdev.iovs,
+					 bdev_io->u.bdev.iovcnt,
+					 base_offset_blocks, bdev_io->u.bdev.num_blocks,
+					 raid6f_chunk_read_complete, raid_io, &io_opts);
+
+	if (spdk_unlikely(ret == -ENOMEM)) {
+		raid_bdev_queue_io_wait(raid_io, base_info->bdev, base_ch,
+					_raid6f_submit_rw_request);
+		return 0;
+	}
+
+	return ret;
+}
+
+static void
+raid6f_submit_rw_request(struct raid_bdev_io *raid_io)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+	uint64_t offset_blocks = bdev_io->u.bdev.offset_blocks;
+	uint64_t stripe_index = offset_blocks / r6f_info->stripe_blocks;
+	uint64_t stripe_offset = offset_blocks % r6f_info->stripe_blocks;
+	int ret;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		assert(bdev_io->u.bdev.num_blocks <= raid_bdev->strip_size);
+		ret = raid6f_submit_read_request(raid_io, stripe_index, stripe_offset);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		assert(stripe_offset == 0);
+		assert(bdev_io->u.bdev.num_blocks == r6f_info->stripe_blocks);
+		ret = raid6f_submit_write_request(raid_io, stripe_index);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	if (spdk_unlikely(ret)) {
+		raid_bdev_io_complete(raid_io, ret == -ENOMEM ? SPDK_BDEV_IO_STATUS_NOMEM :
+				      SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+raid6f_stripe_request_free(struct stripe_request *stripe_req)
+{
+	struct chunk *chunk;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		free(chunk->iovs);
+	}
+
+	if (stripe_req->type == STRIPE_REQ_WRITE) {
+		spdk_dma_free(stripe_req->write.p_buf);
+		spdk_dma_free(stripe_req->write.q_buf);
+	} else {
+		struct raid6f_info *r6f_info = raid6f_ch_to_r6f_info(stripe_req->r6ch);
+		uint8_t i;
+
+		if (stripe_req->reconstruct.chunk_buffers) {
+			for (i = 0; i < r6f_info->raid_bdev->num_base_bdevs; i++) {
+				spdk_dma_free(stripe_req->reconstruct.chunk_buffers[i]);
+			}
+			free(stripe_req->reconstruct.chunk_buffers);
+		}
+	}
+
+	free(stripe_req->chunk_xor_buffers);
+	free(stripe_req->chunk_iov_iters);
+
+	free(stripe_req);
+}
+
+static struct stripe_request *
+raid6f_stripe_request_alloc(struct raid6f_io_channel *r6ch, enum stripe_request_type type)
+{
+	struct raid6f_info *r6f_info = raid6f_ch_to_r6f_info(r6ch);
+	struct raid_bdev *raid_bdev = r6f_info->raid_bdev;
+	struct stripe_request *stripe_req;
+	struct chunk *chunk;
+	size_t chunk_len;
+	void *buf;
+	uint8_t i;
+
+	stripe_req = calloc(1, sizeof(*stripe_req) + sizeof(*chunk) * raid_bdev->num_base_bdevs);
+	if (!stripe_req) {
+		return NULL;
+	}
+
+	stripe_req->r6ch = r6ch;
+	stripe_req->type = type;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		chunk->index = chunk - stripe_req->chunks;
+		chunk->iovcnt_max = 4;
+		chunk->iovs = calloc(chunk->iovcnt_max, sizeof(chunk->iovs[0]));
+		if (!chunk->iovs) {
+			goto err;
+		}
+	}
+
+	chunk_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+
+	if (type == STRIPE_REQ_WRITE) {
+		buf = spdk_dma_malloc(chunk_len, r6f_info->buf_alignment, NULL);
+		if (!buf) {
+			goto err;
+		}
+		stripe_req->write.p_buf = buf;
+
+		buf = spdk_dma_malloc(chunk_len, r6f_info->buf_alignment, NULL);
+		if (!buf) {
+			goto err;
+		}
+		stripe_req->write.q_buf = buf;
+	} else {
+		stripe_req->reconstruct.chunk_buffers = calloc(raid_bdev->num_base_bdevs,
+							sizeof(void *));
+		if (!stripe_req->reconstruct.chunk_buffers) {
+			goto err;
+		}
+
+		for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+			buf = spdk_dma_malloc(chunk_len, r6f_info->buf_alignment, NULL);
+			if (!buf) {
+				goto err;
+			}
+			stripe_req->reconstruct.chunk_buffers[i] = buf;
+		}
+	}
+
+	stripe_req->chunk_iov_iters = calloc(raid6f_stripe_data_chunks_num(raid_bdev),
+					     sizeof(stripe_req->chunk_iov_iters[0]));
+	if (!stripe_req->chunk_iov_iters) {
+		goto err;
+	}
+
+	stripe_req->chunk_xor_buffers = calloc(raid6f_stripe_data_chunks_num(raid_bdev),
+					       sizeof(stripe_req->chunk_xor_buffers[0]));
+	if (!stripe_req->chunk_xor_buffers) {
+		goto err;
+	}
+
+	return stripe_req;
+err:
+	raid6f_stripe_request_free(stripe_req);
+	return NULL;
+}
+
+struct raid6f_process_ctx {
+	/* Range of the base bdevs covered by the request */
+	uint64_t base_offset_blocks;
+	uint64_t base_num_blocks;
+
+	/* Source buffer pointers for the recovery of a stripe */
+	void **sources;
+};
+
+static void
+raid6f_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	free(process_req->module_private);
+	process_req->module_private = NULL;
+
+	raid_bdev_process_request_complete(process_req, status);
+}
+
+static void
+raid6f_process_write_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid6f_process_request_complete(process_req, success ? 0 : -EIO);
+}
+
+/* The process buffer holds a region for each base bdev, the target's is the destination */
+static inline void *
+raid6f_process_base_buf(struct raid_bdev_process_request *process_req, uint8_t idx)
+{
+	struct raid6f_process_ctx *ctx = process_req->module_private;
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+
+	return process_req->buf + idx * (ctx->base_num_blocks << raid_bdev->blocklen_shift);
+}
+
+/*
+ * Recovers the target's strip of each stripe from the others. If another base bdev is missing,
+ * its strip is recovered too, into its unused region of the buffer.
+ */
+static int
+raid6f_process_recover(struct raid_bdev_process_request *process_req)
+{
+	struct raid6f_process_ctx *ctx = process_req->module_private;
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+	uint8_t target_idx = process_req->target - raid_bdev->base_bdev_info;
+	uint8_t n = raid6f_stripe_data_chunks_num(raid_bdev);
+	size_t strip_len = raid_bdev->strip_size << raid_bdev->blocklen_shift;
+	uint64_t first_stripe = ctx->base_offset_blocks >> raid_bdev->strip_size_shift;
+	uint64_t num_stripes = ctx->base_num_blocks >> raid_bdev->strip_size_shift;
+	uint64_t s, stripe_index;
+	uint8_t idx, i, fail_a, fail_b;
+	void *p, *q;
+	int ret;
+
+	for (s = 0; s < num_stripes; s++) {
+		stripe_index = first_stripe + s;
+		fail_a = raid6f_stripe_chunk_pq_index(raid_bdev, stripe_index, target_idx);
+		fail_b = fail_a;
+
+		for (idx = 0; idx < raid_bdev->num_base_bdevs; idx++) {
+			if (idx != target_idx && process_req->raid_ch->base_channel[idx] == NULL) {
+				fail_b = raid6f_stripe_chunk_pq_index(raid_bdev, stripe_index, idx);
+			}
+		}
+
+		for (i = 0; i < n; i++) {
+			idx = raid6f_stripe_data_chunk_base_index(raid_bdev, stripe_index, i);
+			ctx->sources[i] = raid6f_process_base_buf(process_req, idx) + s * strip_len;
+		}
+		p = raid6f_process_base_buf(process_req,
+					    raid6f_stripe_p_chunk_index(raid_bdev, stripe_index)) + s * strip_len;
+		q = raid6f_process_base_buf(process_req,
+					    raid6f_stripe_q_chunk_index(raid_bdev, stripe_index)) + s * strip_len;
+
+		ret = spdk_pq_recover(ctx->sources, p, q, n, strip_len, fail_a, fail_b);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static void
+raid6f_process_read_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+	struct raid6f_process_ctx *ctx = process_req->module_private;
+	struct raid_base_bdev_info *target = process_req->target;
+	uint8_t target_idx = target - target->raid_bdev->base_bdev_info;
+	int ret;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		process_req->status = -EIO;
+	}
+
+	if (--process_req->num_ios > 0) {
+		return;
+	}
+
+	if (process_req->status != 0) {
+		raid6f_process_request_complete(process_req, process_req->status);
+		return;
+	}
+
+	ret = raid6f_process_recover(process_req);
+	if (ret == 0) {
+		ret = spdk_bdev_write_blocks(target->desc, process_req->target_ch,
+					     raid6f_process_base_buf(process_req, target_idx),
+					     target->data_offset + ctx->base_offset_blocks,
+					     ctx->base_num_blocks, raid6f_process_write_cb,
+					     process_req);
+	}
+	if (ret != 0) {
+		raid6f_process_request_complete(process_req, ret);
+	}
+}
+
+static int
+raid6f_submit_process_request(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev *raid_bdev = process_req->target->raid_bdev;
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+	struct raid_bdev_io_channel *raid_ch = process_req->raid_ch;
+	uint8_t target_idx = process_req->target - raid_bdev->base_bdev_info;
+	struct raid6f_process_ctx *ctx;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	uint8_t idx;
+	int ret;
+
+	assert(process_req->offset_blocks % r6f_info->stripe_blocks == 0);
+	assert(process_req->num_blocks % r6f_info->stripe_blocks == 0);
+
+	ctx = calloc(1, sizeof(*ctx) + raid6f_stripe_data_chunks_num(raid_bdev) * sizeof(void *));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	/* Each base bdev contributes one strip per stripe */
+	ctx->base_offset_blocks = (process_req->offset_blocks / r6f_info->stripe_blocks) <<
+				  raid_bdev->strip_size_shift;
+	ctx->base_num_blocks = (process_req->num_blocks / r6f_info->stripe_blocks) <<
+			       raid_bdev->strip_size_shift;
+	ctx->sources = (void **)(ctx + 1);
+
+	process_req->module_private = ctx;
+	process_req->num_ios = 0;
+	process_req->status = 0;
+
+	for (idx = 0; idx < raid_bdev->num_base_bdevs; idx++) {
+		base_ch = raid_ch->base_channel[idx];
+		if (idx == target_idx || base_ch == NULL) {
+			continue;
+		}
+
+		base_info = &raid_bdev->base_bdev_info[idx];
+		ret = spdk_bdev_read_blocks(base_info->desc, base_ch,
+					    raid6f_process_base_buf(process_req, idx),
+					    base_info->data_offset + ctx->base_offset_blocks,
+					    ctx->base_num_blocks, raid6f_process_read_cb, process_req);
+		if (ret != 0) {
+			if (process_req->num_ios == 0) {
+				free(ctx);
+				process_req->module_private = NULL;
+				return ret;
+			}
+			process_req->status = ret;
+			break;
+		}
+
+		process_req->num_ios++;
+	}
+
+	return 0;
+}
+
+static void
+raid6f_ioch_destroy(void *io_device, void *ctx_buf)
+{
+	struct raid6f_io_channel *r6ch = ctx_buf;
+	struct stripe_request *stripe_req;
+
+	assert(TAILQ_EMPTY(&r6ch->xor_retry_queue));
+
+	while ((stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.write))) {
+		TAILQ_REMOVE(&r6ch->free_stripe_requests.write, stripe_req, link);
+		raid6f_stripe_request_free(stripe_req);
+	}
+
+	while ((stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.reconstruct))) {
+		TAILQ_REMOVE(&r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+		raid6f_stripe_request_free(stripe_req);
+	}
+
+	if (r6ch->accel_ch) {
+		spdk_put_io_channel(r6ch->accel_ch);
+	}
+}
+
+static int
+raid6f_ioch_create(void *io_device, void *ctx_buf)
+{
+	struct raid6f_io_channel *r6ch = ctx_buf;
+	struct raid6f_info *r6f_info = io_device;
+	struct stripe_request *stripe_req;
+	int status = 0;
+	int i;
+
+	TAILQ_INIT(&r6ch->free_stripe_requests.write);
+	TAILQ_INIT(&r6ch->free_stripe_requests.reconstruct);
+	TAILQ_INIT(&r6ch->xor_retry_queue);
+
+	for (i = 0; i < RAID6F_MAX_STRIPES; i++) {
+		stripe_req = raid6f_stripe_request_alloc(r6ch, STRIPE_REQ_WRITE);
+		if (!stripe_req) {
+			status = -ENOMEM;
+			goto out;
+		}
+
+		TAILQ_INSERT_HEAD(&r6ch->free_stripe_requests.write, stripe_req, link);
+	}
+
+	for (i = 0; i < RAID6F_MAX_STRIPES; i++) {
+		stripe_req = raid6f_stripe_request_alloc(r6ch, STRIPE_REQ_RECONSTRUCT);
+		if (!stripe_req) {
+			status = -ENOMEM;
+			goto out;
+		}
+
+		TAILQ_INSERT_HEAD(&r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+	}
+
+	r6ch->accel_ch = spdk_accel_get_io_channel();
+	if (!r6ch->accel_ch) {
+		SPDK_ERRLOG("Failed to get accel framework's IO channel\n");
+		status = -ENOMEM;
+		goto out;
+	}
+out:
+	if (status) {
+		SPDK_ERRLOG("Failed to initialize io channel\n");
+		raid6f_ioch_destroy(r6f_info, r6ch);
+	}
+	return status;
+}
+
+static int
+raid6f_start(struct raid_bdev *raid_bdev)
+{
+	uint64_t min_blockcnt = UINT64_MAX;
+	uint64_t base_bdev_data_size;
+	struct raid_base_bdev_info *base_info;
+	struct raid6f_info *r6f_info;
+	size_t alignment = spdk_xor_get_optimal_alignment();
+
+	if (raid_bdev->bdev.md_len != 0 && !raid_bdev->bdev.md_interleave) {
+		SPDK_ERRLOG("raid6f does not support separate metadata, raid bdev %s\n",
+			    raid_bdev->bdev.name);
+		return -EINVAL;
+	}
+
+	r6f_info = calloc(1, sizeof(*r6f_info));
+	if (!r6f_info) {
+		SPDK_ERRLOG("Failed to allocate r6f_info\n");
+		return -ENOMEM;
+	}
+	r6f_info->raid_bdev = raid_bdev;
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		min_blockcnt = spdk_min(min_blockcnt, base_info->data_size);
+		if (base_info->bdev) {
+			alignment = spdk_max(alignment, spdk_bdev_get_buf_align(base_info->bdev));
+		}
+	}
+
+	base_bdev_data_size = (min_blockcnt / raid_bdev->strip_size) * raid_bdev->strip_size;
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		base_info->data_size = base_bdev_data_size;
+	}
+
+	r6f_info->total_stripes = base_bdev_data_size / raid_bdev->strip_size;
+	r6f_info->stripe_blocks = raid_bdev->strip_size * raid6f_stripe_data_chunks_num(raid_bdev);
+	r6f_info->buf_alignment = alignment;
+
+	raid_bdev->bdev.blockcnt = r6f_info->stripe_blocks * r6f_info->total_stripes;
+	raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
+	raid_bdev->bdev.split_on_optimal_io_boundary = true;
+	raid_bdev->bdev.write_unit_size = r6f_info->stripe_blocks;
+	raid_bdev->bdev.split_on_write_unit = true;
+
+	raid_bdev->module_private = r6f_info;
+
+	spdk_io_device_register(r6f_info, raid6f_ioch_create, raid6f_ioch_destroy,
+				sizeof(struct raid6f_io_channel), NULL);
+
+	return 0;
+}
+
+static void
+raid6f_io_device_unregister_done(void *io_device)
+{
+	struct raid6f_info *r6f_info = io_device;
+
+	raid_bdev_module_stop_done(r6f_info->raid_bdev);
+
+	free(r6f_info);
+}
+
+static bool
+raid6f_stop(struct raid_bdev *raid_bdev)
+{
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+
+	spdk_io_device_unregister(r6f_info, raid6f_io_device_unregister_done);
+
+	return false;
+}
+
+static struct spdk_io_channel *
+raid6f_get_io_channel(struct raid_bdev *raid_bdev)
+{
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+
+	return spdk_get_io_channel(r6f_info);
+}
+
+static struct raid_bdev_module g_raid6f_module = {
+	.level = RAID6F,
+	.base_bdevs_min = 4,
+	.base_bdevs_constraint = {CONSTRAINT_MAX_BASE_BDEVS_REMOVED, 2},
+	.start = raid6f_start,
+	.stop = raid6f_stop,
+	.submit_rw_request = raid6f_submit_rw_request,
+	.get_io_channel = raid6f_get_io_channel,
+	.submit_process_request = raid6f_submit_process_request,
+};
+RAID_MODULE_REGISTER(&g_raid6f_module)
+
+SPDK_LOG_REGISTER_COMPONENT(bdev_raid6f)
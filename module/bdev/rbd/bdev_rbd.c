@@ -21,8 +21,21 @@
 #include "spdk/bdev_module.h"
 #include "spdk/log.h"
 
+#define BDEV_RBD_MAX_CONTEXTS		64
+#define BDEV_RBD_COMPLETION_RING_SIZE	4096
+#define BDEV_RBD_MAX_COMPLETIONS	64
+
 static int bdev_rbd_count = 0;
 
+/* Image handle the I/O channels of a bdev are spread across */
+struct bdev_rbd_context {
+	/* Only set if the context has its own connection, i.e. the bdev doesn't use a
+	 * registered cluster */
+	rados_t cluster;
+	rados_ioctx_t io_ctx;
+	rbd_image_t image;
+};
+
 struct bdev_rbd {
 	struct spdk_bdev disk;
 	char *rbd_name;
@@ -37,6 +50,11 @@ struct bdev_rbd {
 	rados_ioctx_t io_ctx;
 	rbd_image_t image;
 
+	/* The first context refers to the io_ctx and image above */
+	struct bdev_rbd_context *contexts;
+	uint32_t num_contexts;
+	uint32_t next_context;
+
 	rbd_image_info_t info;
 	struct spdk_thread *main_td;
 	struct spdk_thread *destruct_td;
@@ -48,11 +66,20 @@ struct bdev_rbd {
 
 struct bdev_rbd_io_channel {
 	struct bdev_rbd *disk;
+	rbd_image_t image;
 	struct spdk_io_channel *group_ch;
 };
 
+struct bdev_rbd_group_channel {
+	/* Completions posted by librbd's threads, reaped in batches by the poller. Not used
+	 * in interrupt mode, where each completion is sent as a message instead. */
+	struct spdk_ring *completions;
+	struct spdk_poller *poller;
+};
+
 struct bdev_rbd_io {
 	struct			spdk_thread *submit_td;
+	struct			bdev_rbd_group_channel *group_ch;
 	enum			spdk_bdev_io_status status;
 	rbd_completion_t	comp;
 	size_t			total_len;
@@ -115,13 +142,39 @@ bdev_rbd_put_cluster(rados_t **cluster)
 	SPDK_ERRLOG("Cannot find the entry for cluster=%p\n", cluster);
 }
 
+static void
+bdev_rbd_context_free(struct bdev_rbd_context *ctx)
+{
+	if (ctx->image) {
+		rbd_flush(ctx->image);
+		rbd_close(ctx->image);
+	}
+
+	if (ctx->io_ctx) {
+		rados_ioctx_destroy(ctx->io_ctx);
+	}
+
+	if (ctx->cluster) {
+		rados_shutdown(ctx->cluster);
+	}
+}
+
 static void
 bdev_rbd_free(struct bdev_rbd *rbd)
 {
+	uint32_t i;
+
 	if (!rbd) {
 		return;
 	}
 
+	if (rbd->contexts) {
+		for (i = 1; i < rbd->num_contexts; i++) {
+			bdev_rbd_context_free(&rbd->contexts[i]);
+		}
+		free(rbd->contexts);
+	}
+
 	if (rbd->image) {
 		rbd_flush(rbd->image);
 		rbd_close(rbd->image);
@@ -310,6 +363,55 @@ bdev_rbd_init_context(void *arg)
 	return arg;
 }
 
+static void *
+bdev_rbd_init_contexts(void *arg)
+{
+	struct bdev_rbd *rbd = arg;
+	struct bdev_rbd_context *ctx;
+	rados_t cluster;
+	uint64_t features;
+	uint32_t i;
+	int rc;
+
+	rc = rbd_get_features(rbd->image, &features);
+	if (rc == 0 && (features & RBD_FEATURE_EXCLUSIVE_LOCK)) {
+		SPDK_WARNLOG("Image %s has the exclusive-lock feature enabled, its %u handles will "
+			     "contend for the lock\n", rbd->rbd_name, rbd->num_contexts);
+	}
+
+	for (i = 1; i < rbd->num_contexts; i++) {
+		ctx = &rbd->contexts[i];
+
+		/* Give each context its own connection (and thus its own set of librados
+		 * threads), unless the bdev has been told to use a registered cluster */
+		if (!rbd->cluster_name) {
+			rc = bdev_rados_cluster_init(rbd->user_id, (const char *const *)rbd->config,
+						     &ctx->cluster);
+			if (rc < 0) {
+				SPDK_ERRLOG("Failed to create rados cluster for context %u of rbd=%p\n",
+					    i, rbd);
+				return NULL;
+			}
+			cluster = ctx->cluster;
+		} else {
+			cluster = *(rbd->cluster_p);
+		}
+
+		if (rados_ioctx_create(cluster, rbd->pool_name, &ctx->io_ctx) < 0) {
+			SPDK_ERRLOG("Failed to create ioctx for context %u of rbd=%p\n", i, rbd);
+			return NULL;
+		}
+
+		rc = rbd_open(ctx->io_ctx, rbd->rbd_name, &ctx->image, NULL);
+		if (rc < 0) {
+			SPDK_ERRLOG("Failed to open context %u of specified rbd device\n", i);
+			return NULL;
+		}
+	}
+
+	return arg;
+}
+
 static int
 bdev_rbd_init(struct bdev_rbd *rbd)
 {
@@ -337,6 +439,21 @@ bdev_rbd_init(struct bdev_rbd *rbd)
 		return -1;
 	}
 
+	rbd->contexts = calloc(rbd->num_contexts, sizeof(*rbd->contexts));
+	if (rbd->contexts == NULL) {
+		SPDK_ERRLOG("Cannot allocate rbd contexts for rbd=%p\n", rbd);
+		return -1;
+	}
+
+	rbd->contexts[0].io_ctx = rbd->io_ctx;
+	rbd->contexts[0].image = rbd->image;
+
+	if (rbd->num_contexts > 1 &&
+	    spdk_call_unaffinitized(bdev_rbd_init_contexts, rbd) == NULL) {
+		SPDK_ERRLOG("Cannot init additional rbd contexts for rbd=%p\n", rbd);
+		return -1;
+	}
+
 	rbd->main_td = spdk_get_thread();
 
 	return ret;
@@ -358,10 +475,15 @@ bdev_rbd_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status stat
 
 	rbd_io->status = status;
 	assert(rbd_io->submit_td != NULL);
-	if (rbd_io->submit_td != current_thread) {
-		spdk_thread_send_msg(rbd_io->submit_td, _bdev_rbd_io_complete, rbd_io);
-	} else {
+	if (rbd_io->submit_td == current_thread) {
 		_bdev_rbd_io_complete(rbd_io);
+		return;
+	}
+
+	/* Fall back to a message if the ring is full (or not used) */
+	if (rbd_io->group_ch->completions == NULL ||
+	    spdk_ring_enqueue(rbd_io->group_ch->completions, (void **)&rbd_io, 1, NULL) != 1) {
+		spdk_thread_send_msg(rbd_io->submit_td, _bdev_rbd_io_complete, rbd_io);
 	}
 }
 
@@ -395,12 +517,11 @@ bdev_rbd_finish_aiocb(rbd_completion_t cb, void *arg)
 }
 
 static void
-_bdev_rbd_start_aio(struct bdev_rbd *disk, struct spdk_bdev_io *bdev_io,
+_bdev_rbd_start_aio(rbd_image_t image, struct spdk_bdev_io *bdev_io,
 		    struct iovec *iov, int iovcnt, uint64_t offset, size_t len)
 {
 	int ret;
 	struct bdev_rbd_io *rbd_io = (struct bdev_rbd_io *)bdev_io->driver_ctx;
-	rbd_image_t image = disk->image;
 
 	ret = rbd_aio_create_completion(bdev_io, bdev_rbd_finish_aiocb,
 					&rbd_io->comp);
@@ -444,9 +565,10 @@ static void
 bdev_rbd_start_aio(void *ctx)
 {
 	struct spdk_bdev_io *bdev_io = ctx;
-	struct bdev_rbd *disk = (struct bdev_rbd *)bdev_io->bdev->ctxt;
+	struct spdk_io_channel *_ch = spdk_bdev_io_get_io_channel(bdev_io);
+	struct bdev_rbd_io_channel *ch = spdk_io_channel_get_ctx(_ch);
 
-	_bdev_rbd_start_aio(disk,
+	_bdev_rbd_start_aio(ch->image,
 			    bdev_io,
 			    bdev_io->u.bdev.iovs,
 			    bdev_io->u.bdev.iovcnt,
@@ -600,10 +722,12 @@ static void
 bdev_rbd_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
 {
 	struct spdk_thread *submit_td = spdk_io_channel_get_thread(ch);
+	struct bdev_rbd_io_channel *rbd_ch = spdk_io_channel_get_ctx(ch);
 	struct bdev_rbd_io *rbd_io = (struct bdev_rbd_io *)bdev_io->driver_ctx;
 	struct bdev_rbd *disk = (struct bdev_rbd *)bdev_io->bdev->ctxt;
 
 	rbd_io->submit_td = submit_td;
+	rbd_io->group_ch = spdk_io_channel_get_ctx(rbd_ch->group_ch);
 	switch (bdev_io->type) {
 	case SPDK_BDEV_IO_TYPE_READ:
 		spdk_bdev_io_get_buf(bdev_io, bdev_rbd_get_buf_cb,
@@ -650,8 +774,13 @@ bdev_rbd_create_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_rbd_io_channel *ch = ctx_buf;
 	struct bdev_rbd *disk = io_device;
+	uint32_t idx;
+
+	/* Spread the channels (and thus the threads) across the image handles */
+	idx = __atomic_fetch_add(&disk->next_context, 1, __ATOMIC_RELAXED) % disk->num_contexts;
 
 	ch->disk = disk;
+	ch->image = disk->contexts[idx].image;
 	ch->group_ch = spdk_get_io_channel(&rbd_if);
 	assert(ch->group_ch != NULL);
 
@@ -723,6 +852,8 @@ bdev_rbd_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
 
 	spdk_json_write_named_string(w, "rbd_name", rbd_bdev->rbd_name);
 
+	spdk_json_write_named_uint32(w, "num_contexts", rbd_bdev->num_contexts);
+
 	if (rbd_bdev->cluster_name) {
 		bdev_rbd_cluster_dump_entry(rbd_bdev->cluster_name, w);
 		goto end;
@@ -764,6 +895,9 @@ bdev_rbd_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w
 	spdk_json_write_named_string(w, "pool_name", rbd->pool_name);
 	spdk_json_write_named_string(w, "rbd_name", rbd->rbd_name);
 	spdk_json_write_named_uint32(w, "block_size", bdev->blocklen);
+	if (rbd->num_contexts > 1) {
+		spdk_json_write_named_uint32(w, "num_contexts", rbd->num_contexts);
+	}
 	if (rbd->user_id) {
 		spdk_json_write_named_string(w, "user_id", rbd->user_id);
 	}
@@ -1059,7 +1193,8 @@ bdev_rbd_create(struct spdk_bdev **bdev, const char *name, const char *user_id,
 		const char *rbd_name,
 		uint32_t block_size,
 		const char *cluster_name,
-		const struct spdk_uuid *uuid)
+		const struct spdk_uuid *uuid,
+		uint32_t num_contexts)
 {
 	struct bdev_rbd *rbd;
 	int ret;
@@ -1068,6 +1203,11 @@ bdev_rbd_create(struct spdk_bdev **bdev, const char *name, const char *user_id,
 		return -EINVAL;
 	}
 
+	if (num_contexts > BDEV_RBD_MAX_CONTEXTS) {
+		SPDK_ERRLOG("Number of contexts must not exceed %u\n", BDEV_RBD_MAX_CONTEXTS);
+		return -EINVAL;
+	}
+
 	rbd = calloc(1, sizeof(struct bdev_rbd));
 	if (rbd == NULL) {
 		SPDK_ERRLOG("Failed to allocate bdev_rbd struct\n");
@@ -1106,6 +1246,8 @@ bdev_rbd_create(struct spdk_bdev **bdev, const char *name, const char *user_id,
 		return -ENOMEM;
 	}
 
+	rbd->num_contexts = spdk_max(num_contexts, 1);
+
 	ret = bdev_rbd_init(rbd);
 	if (ret < 0) {
 		bdev_rbd_free(rbd);
@@ -1221,22 +1363,63 @@ exit:
 	return rc;
 }
 
+static int
+bdev_rbd_group_poll(void *arg)
+{
+	struct bdev_rbd_group_channel *group_ch = arg;
+	void *rbd_ios[BDEV_RBD_MAX_COMPLETIONS];
+	size_t i, count;
+
+	count = spdk_ring_dequeue(group_ch->completions, rbd_ios, SPDK_COUNTOF(rbd_ios));
+	for (i = 0; i < count; i++) {
+		_bdev_rbd_io_complete(rbd_ios[i]);
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
 static int
 bdev_rbd_group_create_cb(void *io_device, void *ctx_buf)
 {
+	struct bdev_rbd_group_channel *group_ch = ctx_buf;
+
+	if (spdk_interrupt_mode_is_enabled()) {
+		return 0;
+	}
+
+	group_ch->completions = spdk_ring_create(SPDK_RING_TYPE_MP_SC, BDEV_RBD_COMPLETION_RING_SIZE,
+				SPDK_ENV_SOCKET_ID_ANY);
+	if (group_ch->completions == NULL) {
+		SPDK_ERRLOG("Failed to allocate the completion ring\n");
+		return -ENOMEM;
+	}
+
+	group_ch->poller = SPDK_POLLER_REGISTER(bdev_rbd_group_poll, group_ch, 0);
+	if (group_ch->poller == NULL) {
+		spdk_ring_free(group_ch->completions);
+		return -ENOMEM;
+	}
+
 	return 0;
 }
 
 static void
 bdev_rbd_group_destroy_cb(void *io_device, void *ctx_buf)
 {
+	struct bdev_rbd_group_channel *group_ch = ctx_buf;
+
+	spdk_poller_unregister(&group_ch->poller);
+	if (group_ch->completions != NULL) {
+		assert(spdk_ring_count(group_ch->completions) == 0);
+		spdk_ring_free(group_ch->completions);
+	}
 }
 
 static int
 bdev_rbd_library_init(void)
 {
 	spdk_io_device_register(&rbd_if, bdev_rbd_group_create_cb, bdev_rbd_group_destroy_cb,
-				0, "bdev_rbd_poll_groups");
+				sizeof(struct bdev_rbd_group_channel), "bdev_rbd_poll_groups");
 	return 0;
 }
 
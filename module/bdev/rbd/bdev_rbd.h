@@ -24,10 +24,26 @@ char **bdev_rbd_dup_config(const char *const *config);
 
 typedef void (*spdk_delete_rbd_complete)(void *cb_arg, int bdeverrno);
 
+/**
+ * Create rbd bdev.
+ *
+ * \param bdev Pointer to the created bdev.
+ * \param name Name of the bdev, generated if NULL.
+ * \param user_id Ceph user ID, or NULL to use the default one.
+ * \param pool_name Name of the pool the image is in.
+ * \param config Ceph configuration key/value pairs, or NULL.
+ * \param rbd_name Name of the image.
+ * \param block_size Block size of the bdev.
+ * \param cluster_name Name of a registered cluster to use, or NULL.
+ * \param uuid UUID of the bdev, or NULL to generate one.
+ * \param num_contexts Number of image handles the bdev's I/O channels are spread across.
+ * Unless cluster_name is given, each handle has its own rados connection. 0 means 1.
+ */
 int bdev_rbd_create(struct spdk_bdev **bdev, const char *name, const char *user_id,
 		    const char *pool_name,
 		    const char *const *config,
-		    const char *rbd_name, uint32_t block_size, const char *cluster_name, const struct spdk_uuid *uuid);
+		    const char *rbd_name, uint32_t block_size, const char *cluster_name,
+		    const struct spdk_uuid *uuid, uint32_t num_contexts);
 /**
  * Delete rbd bdev.
  *
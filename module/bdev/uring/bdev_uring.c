@@ -31,8 +31,14 @@ struct bdev_uring_zoned_dev {
 	uint32_t		lba_shift;
 };
 
+#define SPDK_URING_QUEUE_DEPTH 512
+#define SPDK_URING_MAX_FIXED_FILES 128
+#define MAX_EVENTS_PER_POLL 32
+
 struct bdev_uring_io_channel {
 	struct bdev_uring_group_channel		*group_ch;
+	/* Index of the bdev's file in the ring's registered files, -1 if it isn't registered */
+	int					fixed_file;
 };
 
 struct bdev_uring_group_channel {
@@ -40,6 +46,8 @@ struct bdev_uring_group_channel {
 	uint64_t				io_pending;
 	struct spdk_poller			*poller;
 	struct io_uring				uring;
+	bool					fixed_files;
+	bool					fixed_file_used[SPDK_URING_MAX_FIXED_FILES];
 };
 
 struct bdev_uring_task {
@@ -61,8 +69,13 @@ static void bdev_uring_fini(void);
 static void uring_free_bdev(struct bdev_uring *uring);
 static TAILQ_HEAD(, bdev_uring) g_uring_bdev_head = TAILQ_HEAD_INITIALIZER(g_uring_bdev_head);
 
-#define SPDK_URING_QUEUE_DEPTH 512
-#define MAX_EVENTS_PER_POLL 32
+static struct bdev_uring_opts g_opts = {
+	.sqpoll_idle_ms = 1000,
+};
+
+/* Ring owning the kernel submission thread that the other rings attach to */
+static pthread_mutex_t g_sqpoll_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int g_sqpoll_ring_fd = -1;
 
 static int
 bdev_uring_get_ctx_size(void)
@@ -70,22 +83,61 @@ bdev_uring_get_ctx_size(void)
 	return sizeof(struct bdev_uring_task);
 }
 
+static int
+bdev_uring_config_json(struct spdk_json_write_ctx *w)
+{
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_string(w, "method", "bdev_uring_set_options");
+
+	spdk_json_write_named_object_begin(w, "params");
+	spdk_json_write_named_bool(w, "sqpoll", g_opts.sqpoll);
+	spdk_json_write_named_uint32(w, "sqpoll_idle_ms", g_opts.sqpoll_idle_ms);
+	spdk_json_write_named_bool(w, "iopoll", g_opts.iopoll);
+	spdk_json_write_named_bool(w, "fixed_files", g_opts.fixed_files);
+	spdk_json_write_object_end(w);
+
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
 static struct spdk_bdev_module uring_if = {
 	.name		= "uring",
 	.module_init	= bdev_uring_init,
 	.module_fini	= bdev_uring_fini,
+	.config_json	= bdev_uring_config_json,
 	.get_ctx_size	= bdev_uring_get_ctx_size,
 };
 
 SPDK_BDEV_MODULE_REGISTER(uring, &uring_if)
 
+void
+bdev_uring_get_opts(struct bdev_uring_opts *opts)
+{
+	*opts = g_opts;
+}
+
+int
+bdev_uring_set_opts(const struct bdev_uring_opts *opts)
+{
+	/* The options are applied when the rings are created */
+	if (!TAILQ_EMPTY(&g_uring_bdev_head)) {
+		return -EBUSY;
+	}
+
+	g_opts = *opts;
+
+	return 0;
+}
+
 static int
 bdev_uring_open(struct bdev_uring *bdev)
 {
 	int fd;
 
 	fd = open(bdev->filename, O_RDWR | O_DIRECT | O_NOATIME);
-	if (fd < 0) {
+	if (fd < 0 && !g_opts.iopoll) {
 		/* Try without O_DIRECT for non-disk files */
 		fd = open(bdev->filename, O_RDWR | O_NOATIME);
 		if (fd < 0) {
@@ -137,7 +189,12 @@ bdev_uring_readv(struct bdev_uring *uring, struct spdk_io_channel *ch,
 		return -ENOMEM;
 	}
 
-	io_uring_prep_readv(sqe, uring->fd, iov, iovcnt, offset);
+	if (uring_ch->fixed_file >= 0) {
+		io_uring_prep_readv(sqe, uring_ch->fixed_file, iov, iovcnt, offset);
+		io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+	} else {
+		io_uring_prep_readv(sqe, uring->fd, iov, iovcnt, offset);
+	}
 	io_uring_sqe_set_data(sqe, uring_task);
 	uring_task->len = nbytes;
 	uring_task->ch = uring_ch;
@@ -164,7 +221,12 @@ bdev_uring_writev(struct bdev_uring *uring, struct spdk_io_channel *ch,
 		return -ENOMEM;
 	}
 
-	io_uring_prep_writev(sqe, uring->fd, iov, iovcnt, offset);
+	if (uring_ch->fixed_file >= 0) {
+		io_uring_prep_writev(sqe, uring_ch->fixed_file, iov, iovcnt, offset);
+		io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+	} else {
+		io_uring_prep_writev(sqe, uring->fd, iov, iovcnt, offset);
+	}
 	io_uring_sqe_set_data(sqe, uring_task);
 	uring_task->len = nbytes;
 	uring_task->ch = uring_ch;
@@ -633,12 +695,60 @@ bdev_uring_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
 	}
 }
 
+static void
+bdev_uring_register_file(struct bdev_uring_io_channel *ch, struct bdev_uring *uring)
+{
+	struct bdev_uring_group_channel *group_ch = ch->group_ch;
+	int i, rc;
+
+	ch->fixed_file = -1;
+	if (!group_ch->fixed_files) {
+		return;
+	}
+
+	for (i = 0; i < SPDK_URING_MAX_FIXED_FILES; i++) {
+		if (!group_ch->fixed_file_used[i]) {
+			break;
+		}
+	}
+
+	if (i == SPDK_URING_MAX_FIXED_FILES) {
+		SPDK_DEBUGLOG(uring, "No free registered file slot for %s\n", uring->bdev.name);
+		return;
+	}
+
+	rc = io_uring_register_files_update(&group_ch->uring, i, &uring->fd, 1);
+	if (rc != 1) {
+		SPDK_DEBUGLOG(uring, "Failed to register the file of %s: %d\n", uring->bdev.name, rc);
+		return;
+	}
+
+	group_ch->fixed_file_used[i] = true;
+	ch->fixed_file = i;
+}
+
+static void
+bdev_uring_unregister_file(struct bdev_uring_io_channel *ch)
+{
+	struct bdev_uring_group_channel *group_ch = ch->group_ch;
+	int fd = -1;
+
+	if (ch->fixed_file < 0) {
+		return;
+	}
+
+	io_uring_register_files_update(&group_ch->uring, ch->fixed_file, &fd, 1);
+	group_ch->fixed_file_used[ch->fixed_file] = false;
+	ch->fixed_file = -1;
+}
+
 static int
 bdev_uring_create_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_uring_io_channel *ch = ctx_buf;
 
 	ch->group_ch = spdk_io_channel_get_ctx(spdk_get_io_channel(&uring_if));
+	bdev_uring_register_file(ch, io_device);
 
 	return 0;
 }
@@ -648,6 +758,7 @@ bdev_uring_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_uring_io_channel *ch = ctx_buf;
 
+	bdev_uring_unregister_file(ch);
 	spdk_put_io_channel(spdk_io_channel_from_ctx(ch->group_ch));
 }
 
@@ -715,14 +826,53 @@ static int
 bdev_uring_group_create_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_uring_group_channel *ch = ctx_buf;
+	struct io_uring_params params = {};
+	int fds[SPDK_URING_MAX_FIXED_FILES];
+	int i, rc;
+
+	/* IORING_SETUP_IOPOLL is opt-in, as the Linux kernel only supports it for local
+	 * devices and not for devices attached from remote target */
+	if (g_opts.iopoll) {
+		params.flags |= IORING_SETUP_IOPOLL;
+	}
+
+	if (g_opts.sqpoll) {
+		params.flags |= IORING_SETUP_SQPOLL;
+		params.sq_thread_idle = g_opts.sqpoll_idle_ms;
 
-	/* Do not use IORING_SETUP_IOPOLL until the Linux kernel can support not only
-	 * local devices but also devices attached from remote target */
-	if (io_uring_queue_init(SPDK_URING_QUEUE_DEPTH, &ch->uring, 0) < 0) {
-		SPDK_ERRLOG("uring I/O context setup failure\n");
+		pthread_mutex_lock(&g_sqpoll_mutex);
+		if (g_sqpoll_ring_fd >= 0) {
+			params.flags |= IORING_SETUP_ATTACH_WQ;
+			params.wq_fd = g_sqpoll_ring_fd;
+		}
+
+		rc = io_uring_queue_init_params(SPDK_URING_QUEUE_DEPTH, &ch->uring, &params);
+		if (rc == 0 && g_sqpoll_ring_fd < 0) {
+			g_sqpoll_ring_fd = ch->uring.ring_fd;
+		}
+		pthread_mutex_unlock(&g_sqpoll_mutex);
+	} else {
+		rc = io_uring_queue_init_params(SPDK_URING_QUEUE_DEPTH, &ch->uring, &params);
+	}
+
+	if (rc < 0) {
+		SPDK_ERRLOG("uring I/O context setup failure: %s\n", spdk_strerror(-rc));
 		return -1;
 	}
 
+	if (g_opts.fixed_files) {
+		/* Start with an empty table, the files are added as the bdevs' channels get created */
+		for (i = 0; i < SPDK_URING_MAX_FIXED_FILES; i++) {
+			fds[i] = -1;
+		}
+
+		rc = io_uring_register_files(&ch->uring, fds, SPDK_URING_MAX_FIXED_FILES);
+		if (rc != 0) {
+			SPDK_WARNLOG("Failed to register files with the ring: %s\n", spdk_strerror(-rc));
+		}
+		ch->fixed_files = rc == 0;
+	}
+
 	ch->poller = SPDK_POLLER_REGISTER(bdev_uring_group_poll, ch, 0);
 	return 0;
 }
@@ -732,6 +882,13 @@ bdev_uring_group_destroy_cb(void *io_device, void *ctx_buf)
 {
 	struct bdev_uring_group_channel *ch = ctx_buf;
 
+	pthread_mutex_lock(&g_sqpoll_mutex);
+	if (g_sqpoll_ring_fd == ch->uring.ring_fd) {
+		/* The next ring will start a new submission thread */
+		g_sqpoll_ring_fd = -1;
+	}
+	pthread_mutex_unlock(&g_sqpoll_mutex);
+
 	io_uring_queue_exit(&ch->uring);
 
 	spdk_poller_unregister(&ch->poller);
@@ -15,6 +15,20 @@
 
 typedef void (*spdk_delete_uring_complete)(void *cb_arg, int bdeverrno);
 
+struct bdev_uring_opts {
+	/* Use a kernel thread polling the submission queues, shared by all of the rings */
+	bool		sqpoll;
+	/* Time after which an idle kernel submission thread goes to sleep */
+	uint32_t	sqpoll_idle_ms;
+	/* Poll for completions instead of relying on interrupts, requires O_DIRECT */
+	bool		iopoll;
+	/* Register the files of the bdevs with the rings */
+	bool		fixed_files;
+};
+
+void bdev_uring_get_opts(struct bdev_uring_opts *opts);
+int bdev_uring_set_opts(const struct bdev_uring_opts *opts);
+
 struct spdk_bdev *create_uring_bdev(const char *name, const char *filename, uint32_t block_size);
 
 void delete_uring_bdev(const char *name, spdk_delete_uring_complete cb_fn, void *cb_arg);
@@ -23,6 +23,8 @@
 
 #include "spdk/log.h"
 
+#define BDEV_XNVME_DEFAULT_QUEUE_DEPTH	512
+
 struct bdev_xnvme_io_channel {
 	struct xnvme_queue	*queue;
 	struct spdk_poller	*poller;
@@ -40,6 +42,8 @@ struct bdev_xnvme {
 	struct xnvme_dev	*dev;
 	uint32_t		nsid;
 	bool			conserve_cpu;
+	bool			io_poll;
+	uint32_t		queue_depth;
 
 	TAILQ_ENTRY(bdev_xnvme) link;
 };
@@ -70,6 +74,8 @@ bdev_xnvme_config_json(struct spdk_json_write_ctx *w)
 		spdk_json_write_named_string(w, "filename", xnvme->filename);
 		spdk_json_write_named_string(w, "io_mechanism", xnvme->io_mechanism);
 		spdk_json_write_named_bool(w, "conserve_cpu", xnvme->conserve_cpu);
+		spdk_json_write_named_bool(w, "io_poll", xnvme->io_poll);
+		spdk_json_write_named_uint32(w, "queue_depth", xnvme->queue_depth);
 		spdk_json_write_object_end(w);
 
 		spdk_json_write_object_end(w);
@@ -280,9 +286,8 @@ bdev_xnvme_queue_create_cb(void *io_device, void *ctx_buf)
 	struct bdev_xnvme *xnvme = io_device;
 	struct bdev_xnvme_io_channel *ch = ctx_buf;
 	int rc;
-	int qd = 512;
 
-	rc = xnvme_queue_init(xnvme->dev, qd, 0, &ch->queue);
+	rc = xnvme_queue_init(xnvme->dev, xnvme->queue_depth, 0, &ch->queue);
 	if (rc) {
 		SPDK_ERRLOG("xnvme_queue_init failure: %d\n", rc);
 		return 1;
@@ -307,7 +312,7 @@ bdev_xnvme_queue_destroy_cb(void *io_device, void *ctx_buf)
 
 struct spdk_bdev *
 create_xnvme_bdev(const char *name, const char *filename, const char *io_mechanism,
-		  bool conserve_cpu)
+		  bool conserve_cpu, bool io_poll, uint32_t queue_depth)
 {
 	struct bdev_xnvme *xnvme;
 	uint32_t block_size;
@@ -321,6 +326,18 @@ create_xnvme_bdev(const char *name, const char *filename, const char *io_mechani
 		return NULL;
 	}
 
+	if (queue_depth == 0) {
+		queue_depth = BDEV_XNVME_DEFAULT_QUEUE_DEPTH;
+	}
+	if (!spdk_u32_is_pow2(queue_depth) || queue_depth > UINT16_MAX) {
+		SPDK_ERRLOG("Invalid queue depth %" PRIu32 " (must be a power of 2 up to 32768)\n",
+			    queue_depth);
+		goto error_return;
+	}
+	xnvme->queue_depth = queue_depth;
+	xnvme->conserve_cpu = conserve_cpu;
+	xnvme->io_poll = io_poll;
+
 	opts.direct = 1;
 	opts.async = io_mechanism;
 	if (!opts.async) {
@@ -341,6 +358,15 @@ create_xnvme_bdev(const char *name, const char *filename, const char *io_mechani
 		}
 	}
 
+	/*
+	 * Polled completions of NVMe passthrough commands (io_uring_cmd) need Linux 6.1 or newer and
+	 * poll queues configured in the nvme driver (nvme.poll_queues), so they're only used on
+	 * request.
+	 */
+	if (io_poll) {
+		opts.poll_io = 1;
+	}
+
 	xnvme->filename = strdup(filename);
 	if (!xnvme->filename) {
 		goto error_return;
@@ -14,7 +14,8 @@
 #include "spdk/bdev_module.h"
 
 struct spdk_bdev *create_xnvme_bdev(const char *name, const char *filename,
-				    const char *io_mechanism, bool conserve_cpu);
+				    const char *io_mechanism, bool conserve_cpu, bool io_poll,
+				    uint32_t queue_depth);
 
 void delete_xnvme_bdev(const char *name, spdk_bdev_unregister_cb cb_fn, void *cb_arg);
 
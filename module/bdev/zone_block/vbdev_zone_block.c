@@ -68,6 +68,13 @@ struct zone_block_io_channel {
 struct zone_block_io {
 	/* vbdev to which IO was issued */
 	struct bdev_zone_block *bdev_zone_block;
+
+	/* Channel and offset the write was assigned, kept for resubmission */
+	struct zone_block_io_channel *ch;
+	uint64_t lba;
+
+	/* for bdev_io_wait */
+	struct spdk_bdev_io_wait_entry bdev_io_wait;
 };
 
 static int
@@ -355,10 +362,43 @@ _zone_block_complete_write(struct spdk_bdev_io *bdev_io, bool success, void *cb_
 	spdk_bdev_free_io(bdev_io);
 }
 
+static void
+zone_block_submit_write(void *arg)
+{
+	struct spdk_bdev_io *bdev_io = arg;
+	struct zone_block_io *io_ctx = (struct zone_block_io *)bdev_io->driver_ctx;
+	struct bdev_zone_block *bdev_node = SPDK_CONTAINEROF(bdev_io->bdev, struct bdev_zone_block, bdev);
+	int rc;
+
+	rc = spdk_bdev_writev_blocks_with_md(bdev_node->base_desc, io_ctx->ch->base_ch,
+					     bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+					     bdev_io->u.bdev.md_buf,
+					     io_ctx->lba, bdev_io->u.bdev.num_blocks,
+					     _zone_block_complete_write, bdev_io);
+	if (rc == -ENOMEM) {
+		/* The write pointer has already been moved past this write and other writes may have
+		 * been assigned offsets after it, so it can't be completed with NOMEM and resubmitted.
+		 * Wait for the base bdev to have a free spdk_bdev_io instead.
+		 */
+		io_ctx->bdev_io_wait.bdev = spdk_bdev_desc_get_bdev(bdev_node->base_desc);
+		io_ctx->bdev_io_wait.cb_fn = zone_block_submit_write;
+		io_ctx->bdev_io_wait.cb_arg = bdev_io;
+
+		rc = spdk_bdev_queue_io_wait(io_ctx->bdev_io_wait.bdev, io_ctx->ch->base_ch,
+					     &io_ctx->bdev_io_wait);
+	}
+
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to submit write to the base bdev, rc=%d\n", rc);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
 static int
 zone_block_write(struct bdev_zone_block *bdev_node, struct zone_block_io_channel *ch,
 		 struct spdk_bdev_io *bdev_io)
 {
+	struct zone_block_io *io_ctx = (struct zone_block_io *)bdev_io->driver_ctx;
 	struct block_zone *zone;
 	uint64_t len = bdev_io->u.bdev.num_blocks;
 	uint64_t lba = bdev_io->u.bdev.offset_blocks;
@@ -417,13 +457,14 @@ zone_block_write(struct bdev_zone_block *bdev_node, struct zone_block_io_channel
 	}
 	pthread_spin_unlock(&zone->lock);
 
-	rc = spdk_bdev_writev_blocks_with_md(bdev_node->base_desc, ch->base_ch,
-					     bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
-					     bdev_io->u.bdev.md_buf,
-					     lba, bdev_io->u.bdev.num_blocks,
-					     _zone_block_complete_write, bdev_io);
+	/* Writes to the same zone from other channels are assigned the following offsets and can be
+	 * submitted to the base bdev in parallel.
+	 */
+	io_ctx->ch = ch;
+	io_ctx->lba = lba;
+	zone_block_submit_write(bdev_io);
 
-	return rc;
+	return 0;
 
 write_fail:
 	pthread_spin_unlock(&zone->lock);
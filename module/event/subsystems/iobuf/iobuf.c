@@ -73,8 +73,9 @@ static void
 iobuf_write_config_json(struct spdk_json_write_ctx *w)
 {
 	struct spdk_iobuf_opts opts;
+	uint32_t i;
 
-	spdk_iobuf_get_opts(&opts);
+	spdk_iobuf_get_opts(&opts, sizeof(opts));
 
 	spdk_json_write_array_begin(w);
 	/* Make sure we don't override the options from spdk_bdev_opts, unless iobuf_set_options
@@ -89,6 +90,24 @@ iobuf_write_config_json(struct spdk_json_write_ctx *w)
 		spdk_json_write_named_uint64(w, "large_pool_count", opts.large_pool_count);
 		spdk_json_write_named_uint32(w, "small_bufsize", opts.small_bufsize);
 		spdk_json_write_named_uint32(w, "large_bufsize", opts.large_bufsize);
+		spdk_json_write_named_bool(w, "enable_numa", opts.enable_numa);
+		spdk_json_write_named_uint32(w, "cache_rebalance_period_us",
+					     opts.cache_rebalance_period_us);
+		spdk_json_write_named_uint32(w, "cache_rebalance_budget",
+					     opts.cache_rebalance_budget);
+		spdk_json_write_named_bool(w, "lazy_init", opts.lazy_init);
+		if (opts.num_size_classes > 0) {
+			spdk_json_write_named_array_begin(w, "size_classes");
+			for (i = 0; i < opts.num_size_classes; i++) {
+				spdk_json_write_object_begin(w);
+				spdk_json_write_named_uint32(w, "bufsize",
+							     opts.size_classes[i].bufsize);
+				spdk_json_write_named_uint64(w, "pool_count",
+							     opts.size_classes[i].pool_count);
+				spdk_json_write_object_end(w);
+			}
+			spdk_json_write_array_end(w);
+		}
 		spdk_json_write_object_end(w);
 
 		spdk_json_write_object_end(w);
@@ -4,18 +4,58 @@
  */
 
 #include "spdk/stdinc.h"
+#include "spdk/base64.h"
+#include "spdk/histogram_data.h"
+#include "spdk/log.h"
 #include "spdk/thread.h"
 #include "spdk/rpc.h"
 #include "spdk/string.h"
+#include "spdk/util.h"
 #include "spdk_internal/init.h"
 
 int iobuf_set_opts(struct spdk_iobuf_opts *opts);
 
+static const struct spdk_json_object_decoder rpc_iobuf_size_class_decoders[] = {
+	{"bufsize", offsetof(struct spdk_iobuf_size_class_opts, bufsize), spdk_json_decode_uint32},
+	{"pool_count", offsetof(struct spdk_iobuf_size_class_opts, pool_count), spdk_json_decode_uint64},
+};
+
+static int
+rpc_decode_iobuf_size_class(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object(val, rpc_iobuf_size_class_decoders,
+				       SPDK_COUNTOF(rpc_iobuf_size_class_decoders), out);
+}
+
+static int
+rpc_decode_iobuf_size_classes(const struct spdk_json_val *val, void *out)
+{
+	struct spdk_iobuf_opts *opts = SPDK_CONTAINEROF(out, struct spdk_iobuf_opts, size_classes);
+	size_t count;
+	int rc;
+
+	rc = spdk_json_decode_array(val, rpc_decode_iobuf_size_class, opts->size_classes,
+				    SPDK_IOBUF_MAX_SIZE_CLASSES, &count,
+				    sizeof(opts->size_classes[0]));
+	if (rc != 0) {
+		return rc;
+	}
+
+	opts->num_size_classes = count;
+
+	return 0;
+}
+
 static const struct spdk_json_object_decoder rpc_iobuf_set_options_decoders[] = {
 	{"small_pool_count", offsetof(struct spdk_iobuf_opts, small_pool_count), spdk_json_decode_uint64, true},
 	{"large_pool_count", offsetof(struct spdk_iobuf_opts, large_pool_count), spdk_json_decode_uint64, true},
 	{"small_bufsize", offsetof(struct spdk_iobuf_opts, small_bufsize), spdk_json_decode_uint32, true},
 	{"large_bufsize", offsetof(struct spdk_iobuf_opts, large_bufsize), spdk_json_decode_uint32, true},
+	{"size_classes", offsetof(struct spdk_iobuf_opts, size_classes), rpc_decode_iobuf_size_classes, true},
+	{"enable_numa", offsetof(struct spdk_iobuf_opts, enable_numa), spdk_json_decode_bool, true},
+	{"cache_rebalance_period_us", offsetof(struct spdk_iobuf_opts, cache_rebalance_period_us), spdk_json_decode_uint32, true},
+	{"cache_rebalance_budget", offsetof(struct spdk_iobuf_opts, cache_rebalance_budget), spdk_json_decode_uint32, true},
+	{"lazy_init", offsetof(struct spdk_iobuf_opts, lazy_init), spdk_json_decode_bool, true},
 };
 
 static void
@@ -24,7 +64,7 @@ rpc_iobuf_set_options(struct spdk_jsonrpc_request *request, const struct spdk_js
 	struct spdk_iobuf_opts opts;
 	int rc;
 
-	spdk_iobuf_get_opts(&opts);
+	spdk_iobuf_get_opts(&opts, sizeof(opts));
 	rc = spdk_json_decode_object(params, rpc_iobuf_set_options_decoders,
 				     SPDK_COUNTOF(rpc_iobuf_set_options_decoders), &opts);
 	if (rc != 0) {
@@ -42,3 +82,120 @@ rpc_iobuf_set_options(struct spdk_jsonrpc_request *request, const struct spdk_js
 	spdk_jsonrpc_send_bool_response(request, true);
 }
 SPDK_RPC_REGISTER("iobuf_set_options", rpc_iobuf_set_options, SPDK_RPC_STARTUP)
+
+static void
+rpc_iobuf_write_pool_stats(struct spdk_json_write_ctx *w, struct spdk_iobuf_pool_stats *stats)
+{
+	spdk_json_write_named_uint64(w, "cache", stats->cache);
+	spdk_json_write_named_uint64(w, "main", stats->main);
+	spdk_json_write_named_uint64(w, "retry", stats->retry);
+	spdk_json_write_named_uint64(w, "remote", stats->remote);
+}
+
+static int
+rpc_iobuf_write_histogram(struct spdk_json_write_ctx *w, struct spdk_histogram_data *histogram)
+{
+	char *encoded_histogram;
+	size_t src_len, dst_len;
+	int rc;
+
+	src_len = SPDK_HISTOGRAM_NUM_BUCKETS(histogram) * sizeof(uint64_t);
+	dst_len = spdk_base64_get_encoded_strlen(src_len) + 1;
+
+	encoded_histogram = malloc(dst_len);
+	if (encoded_histogram == NULL) {
+		return -ENOMEM;
+	}
+
+	rc = spdk_base64_encode(encoded_histogram, histogram->bucket, src_len);
+	if (rc != 0) {
+		free(encoded_histogram);
+		return rc;
+	}
+
+	spdk_json_write_named_object_begin(w, "wait_histogram");
+	spdk_json_write_named_string(w, "histogram", encoded_histogram);
+	spdk_json_write_named_int64(w, "bucket_shift", histogram->bucket_shift);
+	spdk_json_write_named_int64(w, "tsc_rate", spdk_get_ticks_hz());
+	spdk_json_write_object_end(w);
+
+	free(encoded_histogram);
+
+	return 0;
+}
+
+static void
+rpc_iobuf_get_stats_done(struct spdk_iobuf_module_stats *modules, uint32_t num_modules,
+			 void *cb_arg)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+	struct spdk_json_write_ctx *w;
+	struct spdk_iobuf_module_stats *it;
+	struct spdk_iobuf_opts opts;
+	uint32_t i, j;
+	int rc;
+
+	spdk_iobuf_get_opts(&opts, sizeof(opts));
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_array_begin(w);
+
+	for (i = 0; i < num_modules; i++) {
+		it = &modules[i];
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "module", it->module);
+
+		spdk_json_write_named_object_begin(w, "small_pool");
+		rpc_iobuf_write_pool_stats(w, &it->small_pool);
+		spdk_json_write_object_end(w);
+
+		spdk_json_write_named_object_begin(w, "large_pool");
+		rpc_iobuf_write_pool_stats(w, &it->large_pool);
+		spdk_json_write_object_end(w);
+
+		if (opts.num_size_classes > 0) {
+			spdk_json_write_named_array_begin(w, "size_classes");
+			for (j = 0; j < opts.num_size_classes; j++) {
+				spdk_json_write_object_begin(w);
+				spdk_json_write_named_uint32(w, "bufsize",
+							     opts.size_classes[j].bufsize);
+				rpc_iobuf_write_pool_stats(w, &it->class_pools[j]);
+				spdk_json_write_object_end(w);
+			}
+			spdk_json_write_array_end(w);
+		}
+
+		if (it->wait_histogram != NULL) {
+			rc = rpc_iobuf_write_histogram(w, it->wait_histogram);
+			if (rc != 0) {
+				SPDK_ERRLOG("Failed to encode %s iobuf wait histogram: %s\n",
+					    it->module, spdk_strerror(-rc));
+			}
+		}
+
+		spdk_json_write_object_end(w);
+	}
+
+	spdk_json_write_array_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+static void
+rpc_iobuf_get_stats(struct spdk_jsonrpc_request *request, const struct spdk_json_val *params)
+{
+	int rc;
+
+	if (params != NULL) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "iobuf_get_stats requires no parameters");
+		return;
+	}
+
+	rc = spdk_iobuf_get_stats(rpc_iobuf_get_stats_done, request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 spdk_strerror(-rc));
+	}
+}
+SPDK_RPC_REGISTER("iobuf_get_stats", rpc_iobuf_get_stats, SPDK_RPC_RUNTIME)
@@ -27,6 +27,7 @@ static struct core_stats *g_cores;
 uint8_t g_scheduler_load_limit = 20;
 uint8_t g_scheduler_core_limit = 80;
 uint8_t g_scheduler_core_busy = 95;
+uint8_t g_scheduler_numa_penalty = 20;
 
 static uint8_t
 _busy_pct(uint64_t busy, uint64_t idle)
@@ -140,11 +141,36 @@ _is_core_at_limit(uint32_t core_id)
 	return true;
 }
 
+static bool
+_is_core_local(struct spdk_scheduler_thread_info *thread_info, uint32_t core_id)
+{
+	/* Threads without a home socket are local to every core. */
+	if (thread_info->socket_id == SPDK_ENV_SOCKET_ID_ANY) {
+		return true;
+	}
+
+	return spdk_env_get_socket_id(core_id) == (uint32_t)thread_info->socket_id;
+}
+
+static uint64_t
+_get_thread_busy_tsc(struct spdk_scheduler_thread_info *thread_info, uint32_t dst_core)
+{
+	uint64_t busy_tsc = thread_info->current_stats.busy_tsc;
+
+	/* Running away from its home socket makes the thread more expensive,
+	 * as all of its I/O has to cross the socket interconnect. */
+	if (!_is_core_local(thread_info, dst_core)) {
+		busy_tsc += busy_tsc * g_scheduler_numa_penalty / 100;
+	}
+
+	return busy_tsc;
+}
+
 static bool
 _can_core_fit_thread(struct spdk_scheduler_thread_info *thread_info, uint32_t dst_core)
 {
 	struct core_stats *dst = &g_cores[dst_core];
-	uint64_t new_busy_tsc, new_idle_tsc;
+	uint64_t new_busy_tsc, new_idle_tsc, busy_tsc;
 
 	/* Thread can always fit on the core it's currently on. */
 	if (thread_info->lcore == dst_core) {
@@ -162,13 +188,15 @@ _can_core_fit_thread(struct spdk_scheduler_thread_info *thread_info, uint32_t ds
 		return true;
 	}
 
+	busy_tsc = _get_thread_busy_tsc(thread_info, dst_core);
+
 	/* Core doesn't have enough idle_tsc to take this thread. */
-	if (dst->idle < thread_info->current_stats.busy_tsc) {
+	if (dst->idle < busy_tsc) {
 		return false;
 	}
 
-	new_busy_tsc = dst->busy + thread_info->current_stats.busy_tsc;
-	new_idle_tsc = dst->idle - thread_info->current_stats.busy_tsc;
+	new_busy_tsc = dst->busy + busy_tsc;
+	new_idle_tsc = dst->idle - busy_tsc;
 
 	/* Core cannot fit this thread if it would put it over the
 	 * g_scheduler_core_limit. */
@@ -181,9 +209,13 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 	uint32_t i;
 	uint32_t current_lcore = thread_info->lcore;
 	uint32_t least_busy_lcore = thread_info->lcore;
+	uint32_t least_busy_local_lcore = UINT32_MAX;
+	uint32_t remote_lcore = UINT32_MAX;
 	struct spdk_thread *thread;
 	struct spdk_cpuset *cpumask;
 	bool core_at_limit = _is_core_at_limit(current_lcore);
+	bool misplaced = !_is_core_local(thread_info, current_lcore);
+	bool local;
 
 	thread = spdk_thread_get_by_id(thread_info->thread_id);
 	if (thread == NULL) {
@@ -191,6 +223,10 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 	}
 	cpumask = spdk_thread_get_cpumask(thread);
 
+	if (!misplaced) {
+		least_busy_local_lcore = current_lcore;
+	}
+
 	/* Find a core that can fit the thread. */
 	SPDK_ENV_FOREACH_CORE(i) {
 		/* Ignore cores outside cpumask. */
@@ -198,16 +234,33 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 			continue;
 		}
 
-		/* Search for least busy core. */
+		local = _is_core_local(thread_info, i);
+
+		/* Search for least busy core, separately among cores local to the thread. */
 		if (g_cores[i].busy < g_cores[least_busy_lcore].busy) {
 			least_busy_lcore = i;
 		}
+		if (local && (least_busy_local_lcore == UINT32_MAX ||
+			      g_cores[i].busy < g_cores[least_busy_local_lcore].busy)) {
+			least_busy_local_lcore = i;
+		}
 
 		/* Skip cores that cannot fit the thread and current one. */
 		if (!_can_core_fit_thread(thread_info, i) || i == current_lcore) {
 			continue;
 		}
-		if (i == g_main_lcore) {
+		if (!local) {
+			/* Never consolidate threads across sockets. A remote core is only
+			 * used to offload a core over the limit, when no local core fits. */
+			if (remote_lcore == UINT32_MAX) {
+				remote_lcore = i;
+			}
+			continue;
+		}
+		if (misplaced) {
+			/* Thread runs away from its home socket, any local core is better. */
+			return i;
+		} else if (i == g_main_lcore) {
 			/* First consider g_main_lcore, consolidate threads on main lcore if possible. */
 			return i;
 		} else if (i < current_lcore && current_lcore != g_main_lcore) {
@@ -220,8 +273,15 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 	}
 
 	/* For cores over the limit, place the thread on least busy core
-	 * to balance threads. */
+	 * to balance threads. Prefer cores local to the thread, unless
+	 * a remote one can take it even with the cross-socket penalty. */
 	if (core_at_limit) {
+		if (remote_lcore != UINT32_MAX) {
+			return remote_lcore;
+		}
+		if (least_busy_local_lcore != UINT32_MAX) {
+			return least_busy_local_lcore;
+		}
 		return least_busy_lcore;
 	}
 
@@ -357,12 +417,14 @@ struct json_scheduler_opts {
 	uint8_t load_limit;
 	uint8_t core_limit;
 	uint8_t core_busy;
+	uint8_t numa_penalty;
 };
 
 static const struct spdk_json_object_decoder sched_decoders[] = {
 	{"load_limit", offsetof(struct json_scheduler_opts, load_limit), spdk_json_decode_uint8, true},
 	{"core_limit", offsetof(struct json_scheduler_opts, core_limit), spdk_json_decode_uint8, true},
 	{"core_busy", offsetof(struct json_scheduler_opts, core_busy), spdk_json_decode_uint8, true},
+	{"numa_penalty", offsetof(struct json_scheduler_opts, numa_penalty), spdk_json_decode_uint8, true},
 };
 
 static int
@@ -373,6 +435,7 @@ set_opts(const struct spdk_json_val *opts)
 	scheduler_opts.load_limit = g_scheduler_load_limit;
 	scheduler_opts.core_limit = g_scheduler_core_limit;
 	scheduler_opts.core_busy = g_scheduler_core_busy;
+	scheduler_opts.numa_penalty = g_scheduler_numa_penalty;
 
 	if (opts != NULL) {
 		if (spdk_json_decode_object_relaxed(opts, sched_decoders,
@@ -388,6 +451,8 @@ set_opts(const struct spdk_json_val *opts)
 	g_scheduler_core_limit = scheduler_opts.core_limit;
 	SPDK_NOTICELOG("Setting scheduler core busy to %d\n", scheduler_opts.core_busy);
 	g_scheduler_core_busy = scheduler_opts.core_busy;
+	SPDK_NOTICELOG("Setting scheduler NUMA penalty to %d\n", scheduler_opts.numa_penalty);
+	g_scheduler_numa_penalty = scheduler_opts.numa_penalty;
 
 	return 0;
 }
@@ -398,6 +463,7 @@ get_opts(struct spdk_json_write_ctx *ctx)
 	spdk_json_write_named_uint8(ctx, "load_limit", g_scheduler_load_limit);
 	spdk_json_write_named_uint8(ctx, "core_limit", g_scheduler_core_limit);
 	spdk_json_write_named_uint8(ctx, "core_busy", g_scheduler_core_busy);
+	spdk_json_write_named_uint8(ctx, "numa_penalty", g_scheduler_numa_penalty);
 }
 
 static struct spdk_scheduler scheduler_dynamic = {
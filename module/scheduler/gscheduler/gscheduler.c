@@ -7,30 +7,140 @@
 #include "spdk/likely.h"
 
 #include "spdk_internal/event.h"
+#include "spdk_internal/thread.h"
 #include "spdk/thread.h"
 
 #include "spdk/log.h"
 #include "spdk/env.h"
+#include "spdk/histogram_data.h"
 #include "spdk/scheduler.h"
 
+/* Latency target in microseconds, 0 to scale the frequency on the core load only. */
+static uint64_t g_latency_target_us;
+/* Percentile of the latencies recorded on a core compared to the target. */
+static uint8_t g_latency_percentile = 99;
+/* In % of the target, above which the frequency is raised ... */
+static uint8_t g_latency_high = 80;
+/* ... and below which it is lowered. */
+static uint8_t g_latency_low = 50;
+
 static int
 init(void)
 {
+	spdk_thread_enable_latency_histograms(g_latency_target_us != 0);
+
 	return spdk_governor_set("dpdk_governor");
 }
 
 static void
 deinit(void)
 {
+	spdk_thread_enable_latency_histograms(false);
 	spdk_governor_set(NULL);
 }
 
+struct latency_percentile_ctx {
+	uint64_t	percentile;
+	uint64_t	ticks;
+	bool		found;
+};
+
+static void
+check_percentile(void *_ctx, uint64_t start, uint64_t end, uint64_t count,
+		 uint64_t total, uint64_t so_far)
+{
+	struct latency_percentile_ctx *ctx = _ctx;
+
+	if (count == 0 || ctx->found) {
+		return;
+	}
+
+	if (so_far * 100 >= total * ctx->percentile) {
+		ctx->ticks = end;
+		ctx->found = true;
+	}
+}
+
+/* Returns the latency percentile of the core in microseconds, or UINT64_MAX if nothing was
+ * recorded on the core during the last period. */
+static uint64_t
+core_latency_us(struct spdk_scheduler_core_info *core)
+{
+	struct latency_percentile_ctx ctx = { .percentile = g_latency_percentile };
+
+	if (core->current_latency_histogram == NULL) {
+		return UINT64_MAX;
+	}
+
+	spdk_histogram_data_iterate(core->current_latency_histogram, check_percentile, &ctx);
+	if (!ctx.found) {
+		return UINT64_MAX;
+	}
+
+	return ctx.ticks * SPDK_SEC_TO_USEC / spdk_get_ticks_hz();
+}
+
+static int
+balance_latency(struct spdk_governor *governor, struct spdk_scheduler_core_info *core,
+		uint64_t latency_us)
+{
+	int rc = 0;
+
+	if (latency_us >= g_latency_target_us) {
+		rc = governor->set_core_freq_max(core->lcore);
+		if (rc < 0) {
+			SPDK_ERRLOG("setting to maximal frequency for core %u failed\n", core->lcore);
+		}
+	} else if (latency_us * 100 >= g_latency_target_us * g_latency_high) {
+		rc = governor->core_freq_up(core->lcore);
+		if (rc < 0) {
+			SPDK_ERRLOG("increasing frequency for core %u failed\n", core->lcore);
+		}
+	} else if (latency_us * 100 < g_latency_target_us * g_latency_low) {
+		rc = governor->core_freq_down(core->lcore);
+		if (rc < 0) {
+			SPDK_ERRLOG("lowering frequency for core %u failed\n", core->lcore);
+		}
+	}
+
+	return rc;
+}
+
+static void
+balance_load(struct spdk_governor *governor, struct spdk_scheduler_core_info *core)
+{
+	int rc;
+
+	if (core->current_busy_tsc < (core->current_idle_tsc / 1000)) {
+		rc = governor->set_core_freq_min(core->lcore);
+		if (rc < 0) {
+			SPDK_ERRLOG("setting to minimal frequency for core %u failed\n", core->lcore);
+		}
+	} else if (core->current_idle_tsc > core->current_busy_tsc) {
+		rc = governor->core_freq_down(core->lcore);
+		if (rc < 0) {
+			SPDK_ERRLOG("lowering frequency for core %u failed\n", core->lcore);
+		}
+	} else if (core->current_idle_tsc < (core->current_busy_tsc / 1000)) {
+		rc = governor->set_core_freq_max(core->lcore);
+		if (rc < 0) {
+			SPDK_ERRLOG("setting to maximal frequency for core %u failed\n", core->lcore);
+		}
+	} else {
+		rc = governor->core_freq_up(core->lcore);
+		if (rc < 0) {
+			SPDK_ERRLOG("increasing frequency for core %u failed\n", core->lcore);
+		}
+	}
+}
+
 static void
 balance(struct spdk_scheduler_core_info *cores, uint32_t core_count)
 {
 	struct spdk_governor *governor;
 	struct spdk_scheduler_core_info *core;
 	struct spdk_governor_capabilities capabilities;
+	uint64_t latency_us;
 	uint32_t i;
 	int rc;
 
@@ -47,35 +157,92 @@ balance(struct spdk_scheduler_core_info *cores, uint32_t core_count)
 			return;
 		}
 
-		if (core->current_busy_tsc < (core->current_idle_tsc / 1000)) {
-			rc = governor->set_core_freq_min(core->lcore);
-			if (rc < 0) {
-				SPDK_ERRLOG("setting to minimal frequency for core %u failed\n", core->lcore);
-			}
-		} else if (core->current_idle_tsc > core->current_busy_tsc) {
-			rc = governor->core_freq_down(core->lcore);
-			if (rc < 0) {
-				SPDK_ERRLOG("lowering frequency for core %u failed\n", core->lcore);
-			}
-		} else if (core->current_idle_tsc < (core->current_busy_tsc / 1000)) {
-			rc = governor->set_core_freq_max(core->lcore);
-			if (rc < 0) {
-				SPDK_ERRLOG("setting to maximal frequency for core %u failed\n", core->lcore);
-			}
+		/* Cores that didn't complete any I/O during the last period have nothing
+		 * to be measured against the target, so they follow their load. */
+		latency_us = g_latency_target_us != 0 ? core_latency_us(core) : UINT64_MAX;
+		if (latency_us != UINT64_MAX) {
+			balance_latency(governor, core, latency_us);
 		} else {
-			rc = governor->core_freq_up(core->lcore);
-			if (rc < 0) {
-				SPDK_ERRLOG("increasing frequency for core %u failed\n", core->lcore);
-			}
+			balance_load(governor, core);
 		}
 	}
 }
 
+struct json_scheduler_opts {
+	uint64_t latency_target_us;
+	uint8_t latency_percentile;
+	uint8_t latency_high;
+	uint8_t latency_low;
+};
+
+static const struct spdk_json_object_decoder sched_decoders[] = {
+	{"latency_target_us", offsetof(struct json_scheduler_opts, latency_target_us), spdk_json_decode_uint64, true},
+	{"latency_percentile", offsetof(struct json_scheduler_opts, latency_percentile), spdk_json_decode_uint8, true},
+	{"latency_high", offsetof(struct json_scheduler_opts, latency_high), spdk_json_decode_uint8, true},
+	{"latency_low", offsetof(struct json_scheduler_opts, latency_low), spdk_json_decode_uint8, true},
+};
+
+static int
+set_opts(const struct spdk_json_val *opts)
+{
+	struct json_scheduler_opts scheduler_opts;
+
+	scheduler_opts.latency_target_us = g_latency_target_us;
+	scheduler_opts.latency_percentile = g_latency_percentile;
+	scheduler_opts.latency_high = g_latency_high;
+	scheduler_opts.latency_low = g_latency_low;
+
+	if (opts != NULL) {
+		if (spdk_json_decode_object_relaxed(opts, sched_decoders,
+						    SPDK_COUNTOF(sched_decoders), &scheduler_opts)) {
+			SPDK_ERRLOG("Decoding scheduler opts JSON failed\n");
+			return -1;
+		}
+	}
+
+	if (scheduler_opts.latency_percentile == 0 || scheduler_opts.latency_percentile > 100) {
+		SPDK_ERRLOG("Latency percentile must be within 1 and 100\n");
+		return -EINVAL;
+	}
+
+	if (scheduler_opts.latency_low > scheduler_opts.latency_high ||
+	    scheduler_opts.latency_high > 100) {
+		SPDK_ERRLOG("Latency thresholds must satisfy low <= high <= 100\n");
+		return -EINVAL;
+	}
+
+	SPDK_NOTICELOG("Setting scheduler latency target to %" PRIu64 "us\n",
+		       scheduler_opts.latency_target_us);
+	g_latency_target_us = scheduler_opts.latency_target_us;
+	SPDK_NOTICELOG("Setting scheduler latency percentile to %d\n",
+		       scheduler_opts.latency_percentile);
+	g_latency_percentile = scheduler_opts.latency_percentile;
+	SPDK_NOTICELOG("Setting scheduler latency thresholds to %d-%d%%\n",
+		       scheduler_opts.latency_low, scheduler_opts.latency_high);
+	g_latency_high = scheduler_opts.latency_high;
+	g_latency_low = scheduler_opts.latency_low;
+
+	spdk_thread_enable_latency_histograms(g_latency_target_us != 0);
+
+	return 0;
+}
+
+static void
+get_opts(struct spdk_json_write_ctx *ctx)
+{
+	spdk_json_write_named_uint64(ctx, "latency_target_us", g_latency_target_us);
+	spdk_json_write_named_uint8(ctx, "latency_percentile", g_latency_percentile);
+	spdk_json_write_named_uint8(ctx, "latency_high", g_latency_high);
+	spdk_json_write_named_uint8(ctx, "latency_low", g_latency_low);
+}
+
 static struct spdk_scheduler gscheduler = {
 	.name = "gscheduler",
 	.init = init,
 	.deinit = deinit,
 	.balance = balance,
+	.set_opts = set_opts,
+	.get_opts = get_opts,
 };
 
 SPDK_SCHEDULER_REGISTER(gscheduler);
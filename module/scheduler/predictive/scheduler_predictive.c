@@ -0,0 +1,505 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/likely.h"
+#include "spdk/event.h"
+#include "spdk/log.h"
+#include "spdk/env.h"
+#include "spdk/json.h"
+#include "spdk/queue.h"
+
+#include "spdk/thread.h"
+#include "spdk_internal/event.h"
+#include "spdk/scheduler.h"
+
+#include "scheduler_predictive.h"
+
+/* Loads are expressed in hundredths of a percent of a core. */
+#define LOAD_SCALE		10000
+#define PCT_TO_LOAD(pct)	((int64_t)(pct) * LOAD_SCALE / 100)
+#define LOAD_TO_PCT(load)	((double)(load) * 100 / LOAD_SCALE)
+
+/* Number of the most recent decisions kept for the RPC. */
+#define MAX_DECISIONS		64
+
+struct predictive_thread {
+	uint64_t				id;
+	/* Load during the last scheduling period */
+	int64_t					sample;
+	/* Exponentially weighted load history and its trend */
+	int64_t					level;
+	int64_t					trend;
+	/* Load expected over the forecast horizon */
+	int64_t					forecast;
+	uint64_t				generation;
+	TAILQ_ENTRY(predictive_thread)		link;
+};
+
+struct predictive_decision {
+	uint64_t	period;
+	uint64_t	thread_id;
+	uint32_t	src_lcore;
+	uint32_t	dst_lcore;
+	int64_t		forecast;
+	int64_t		gain;
+};
+
+struct core_load {
+	int64_t		load;
+	uint32_t	thread_count;
+};
+
+static TAILQ_HEAD(, predictive_thread) g_threads = TAILQ_HEAD_INITIALIZER(g_threads);
+static struct core_load *g_cores;
+static uint32_t g_main_lcore;
+static uint64_t g_generation;
+
+static struct predictive_decision g_decisions[MAX_DECISIONS];
+static uint64_t g_decision_count;
+
+static uint8_t g_load_limit = 20;
+static uint8_t g_core_limit = 80;
+static uint8_t g_smoothing = 50;
+static uint8_t g_trend_smoothing = 20;
+static uint8_t g_horizon = 1;
+static uint8_t g_migration_cost = 5;
+
+static struct predictive_thread *
+predictive_thread_get(uint64_t id)
+{
+	struct predictive_thread *pthread;
+
+	TAILQ_FOREACH(pthread, &g_threads, link) {
+		if (pthread->id == id) {
+			return pthread;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+predictive_thread_update(struct predictive_thread *pthread, struct spdk_thread_stats *stats)
+{
+	uint64_t total = stats->busy_tsc + stats->idle_tsc;
+	int64_t level;
+
+	pthread->sample = total == 0 ? 0 : (int64_t)(stats->busy_tsc * LOAD_SCALE / total);
+
+	if (pthread->generation == 0) {
+		/* First sample, there is no history yet. */
+		pthread->level = pthread->sample;
+		pthread->trend = 0;
+	} else {
+		/* Holt's linear smoothing: damp single period spikes, but follow a
+		 * sustained increase or decrease of the load. */
+		level = (g_smoothing * pthread->sample +
+			 (100 - g_smoothing) * (pthread->level + pthread->trend)) / 100;
+		pthread->trend = (g_trend_smoothing * (level - pthread->level) +
+				  (100 - g_trend_smoothing) * pthread->trend) / 100;
+		pthread->level = level;
+	}
+
+	pthread->forecast = pthread->level + g_horizon * pthread->trend;
+	pthread->forecast = spdk_max(pthread->forecast, 0);
+	pthread->forecast = spdk_min(pthread->forecast, LOAD_SCALE);
+}
+
+static int
+predictive_threads_update(struct spdk_scheduler_core_info *cores_info)
+{
+	struct spdk_scheduler_core_info *core;
+	struct spdk_scheduler_thread_info *thread_info;
+	struct predictive_thread *pthread, *tmp;
+	uint32_t i, j;
+
+	g_generation++;
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		core = &cores_info[i];
+		g_cores[i].load = 0;
+		g_cores[i].thread_count = core->threads_count;
+
+		for (j = 0; j < core->threads_count; j++) {
+			thread_info = &core->thread_infos[j];
+			pthread = predictive_thread_get(thread_info->thread_id);
+			if (pthread == NULL) {
+				pthread = calloc(1, sizeof(*pthread));
+				if (pthread == NULL) {
+					SPDK_ERRLOG("Failed to allocate predictive scheduler thread\n");
+					return -ENOMEM;
+				}
+				pthread->id = thread_info->thread_id;
+				TAILQ_INSERT_TAIL(&g_threads, pthread, link);
+			}
+
+			predictive_thread_update(pthread, &thread_info->current_stats);
+			pthread->generation = g_generation;
+			g_cores[i].load += pthread->forecast;
+		}
+	}
+
+	/* Forget the threads that no longer exist. */
+	TAILQ_FOREACH_SAFE(pthread, &g_threads, link, tmp) {
+		if (pthread->generation != g_generation) {
+			TAILQ_REMOVE(&g_threads, pthread, link);
+			free(pthread);
+		}
+	}
+
+	return 0;
+}
+
+static void
+record_decision(struct spdk_scheduler_thread_info *thread_info, struct predictive_thread *pthread,
+		uint32_t dst_lcore, int64_t gain)
+{
+	struct predictive_decision *decision;
+
+	decision = &g_decisions[g_decision_count % MAX_DECISIONS];
+	decision->period = g_generation;
+	decision->thread_id = pthread->id;
+	decision->src_lcore = thread_info->lcore;
+	decision->dst_lcore = dst_lcore;
+	decision->forecast = pthread->forecast;
+	decision->gain = gain;
+	g_decision_count++;
+}
+
+static void
+move_thread(struct spdk_scheduler_thread_info *thread_info, struct predictive_thread *pthread,
+	    uint32_t dst_lcore, int64_t gain)
+{
+	struct core_load *src = &g_cores[thread_info->lcore];
+	struct core_load *dst = &g_cores[dst_lcore];
+
+	if (src == dst) {
+		return;
+	}
+
+	record_decision(thread_info, pthread, dst_lcore, gain);
+
+	src->load -= pthread->forecast;
+	assert(src->thread_count > 0);
+	src->thread_count--;
+	dst->load += pthread->forecast;
+	dst->thread_count++;
+
+	thread_info->lcore = dst_lcore;
+}
+
+static bool
+can_core_fit_load(uint32_t lcore, int64_t load)
+{
+	/* Core has no threads, e.g. its reactor is in interrupt mode. */
+	if (g_cores[lcore].thread_count == 0) {
+		return true;
+	}
+
+	return g_cores[lcore].load + load < PCT_TO_LOAD(g_core_limit);
+}
+
+static uint32_t
+find_core(struct spdk_scheduler_thread_info *thread_info, struct predictive_thread *pthread,
+	  int64_t *gain)
+{
+	struct spdk_thread *thread;
+	struct spdk_cpuset *cpumask;
+	uint32_t i, src_lcore = thread_info->lcore, dst_lcore = src_lcore;
+	int64_t load = pthread->forecast, src_load = g_cores[src_lcore].load;
+	int64_t core_gain, best_gain = PCT_TO_LOAD(g_migration_cost);
+	bool src_over_limit;
+
+	*gain = 0;
+
+	thread = spdk_thread_get_by_id(thread_info->thread_id);
+	if (thread == NULL) {
+		return src_lcore;
+	}
+	cpumask = spdk_thread_get_cpumask(thread);
+
+	src_over_limit = g_cores[src_lcore].thread_count > 1 &&
+			 src_load >= PCT_TO_LOAD(g_core_limit);
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		if (i == src_lcore || !spdk_cpuset_get_cpu(cpumask, i) ||
+		    !can_core_fit_load(i, load)) {
+			continue;
+		}
+
+		if (src_over_limit) {
+			/* Gain is the predicted load reduction on the busier of the two cores. */
+			core_gain = spdk_max(src_load, g_cores[i].load) -
+				    spdk_max(src_load - load, g_cores[i].load + load);
+			if (core_gain > best_gain) {
+				best_gain = core_gain;
+				dst_lcore = i;
+			}
+			continue;
+		}
+
+		/* Consolidate threads on the main core first, then on the lowest core ids.
+		 * Gain is the headroom left on the destination core. Requiring it to exceed
+		 * the migration cost keeps bursty threads from bouncing back next period. */
+		if (i != g_main_lcore && (i > src_lcore || src_lcore == g_main_lcore)) {
+			continue;
+		}
+
+		core_gain = PCT_TO_LOAD(g_core_limit) - (g_cores[i].load + load);
+		if (core_gain <= PCT_TO_LOAD(g_migration_cost)) {
+			continue;
+		}
+
+		*gain = core_gain;
+		return i;
+	}
+
+	if (dst_lcore != src_lcore) {
+		*gain = best_gain;
+	}
+
+	return dst_lcore;
+}
+
+typedef void (*_foreach_fn)(struct spdk_scheduler_thread_info *thread_info,
+			    struct predictive_thread *pthread);
+
+static void
+_foreach_thread(struct spdk_scheduler_core_info *cores_info, _foreach_fn fn)
+{
+	struct spdk_scheduler_core_info *core;
+	struct predictive_thread *pthread;
+	uint32_t i, j;
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		core = &cores_info[i];
+		for (j = 0; j < core->threads_count; j++) {
+			pthread = predictive_thread_get(core->thread_infos[j].thread_id);
+			assert(pthread != NULL);
+			fn(&core->thread_infos[j], pthread);
+		}
+	}
+}
+
+static void
+_balance_idle(struct spdk_scheduler_thread_info *thread_info, struct predictive_thread *pthread)
+{
+	if (pthread->forecast >= PCT_TO_LOAD(g_load_limit)) {
+		return;
+	}
+
+	/* This thread is expected to stay idle, move it to the main core. */
+	move_thread(thread_info, pthread, g_main_lcore, 0);
+}
+
+static void
+_balance_active(struct spdk_scheduler_thread_info *thread_info, struct predictive_thread *pthread)
+{
+	uint32_t dst_lcore;
+	int64_t gain;
+
+	if (pthread->forecast < PCT_TO_LOAD(g_load_limit)) {
+		return;
+	}
+
+	dst_lcore = find_core(thread_info, pthread, &gain);
+	move_thread(thread_info, pthread, dst_lcore, gain);
+}
+
+static void
+balance(struct spdk_scheduler_core_info *cores_info, uint32_t cores_count)
+{
+	struct spdk_reactor *reactor;
+	struct spdk_scheduler_core_info *core;
+	uint32_t i;
+
+	if (predictive_threads_update(cores_info) != 0) {
+		/* Keep all threads where they are. */
+		return;
+	}
+
+	/* 1) Move threads expected to be idle to main core. */
+	_foreach_thread(cores_info, _balance_idle);
+	/* 2) Distribute threads expected to be active across all cores. */
+	_foreach_thread(cores_info, _balance_active);
+
+	/* Switch unused cores to interrupt mode and switch cores to polled mode
+	 * if they will be used after rebalancing */
+	SPDK_ENV_FOREACH_CORE(i) {
+		reactor = spdk_reactor_get(i);
+		core = &cores_info[i];
+		/* We can switch mode only if reactor already does not have any threads */
+		if (g_cores[i].thread_count == 0 && TAILQ_EMPTY(&reactor->threads)) {
+			core->interrupt_mode = true;
+		} else if (g_cores[i].thread_count != 0) {
+			core->interrupt_mode = false;
+		}
+	}
+}
+
+static int
+init(void)
+{
+	g_main_lcore = spdk_env_get_current_core();
+
+	g_cores = calloc(spdk_env_get_last_core() + 1, sizeof(struct core_load));
+	if (g_cores == NULL) {
+		SPDK_ERRLOG("Failed to allocate memory for predictive scheduler core stats.\n");
+		return -ENOMEM;
+	}
+
+	if (spdk_scheduler_get_period() == 0) {
+		/* set default scheduling period to one second */
+		spdk_scheduler_set_period(SPDK_SEC_TO_USEC);
+	}
+
+	return 0;
+}
+
+static void
+deinit(void)
+{
+	struct predictive_thread *pthread, *tmp;
+
+	TAILQ_FOREACH_SAFE(pthread, &g_threads, link, tmp) {
+		TAILQ_REMOVE(&g_threads, pthread, link);
+		free(pthread);
+	}
+
+	free(g_cores);
+	g_cores = NULL;
+	g_generation = 0;
+	g_decision_count = 0;
+}
+
+void
+scheduler_predictive_write_decisions(struct spdk_json_write_ctx *w)
+{
+	struct predictive_thread *pthread;
+	struct predictive_decision *decision;
+	uint64_t i;
+
+	spdk_json_write_object_begin(w);
+
+	spdk_json_write_named_uint64(w, "period", g_generation);
+
+	spdk_json_write_named_array_begin(w, "threads");
+	TAILQ_FOREACH(pthread, &g_threads, link) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint64(w, "id", pthread->id);
+		spdk_json_write_named_double(w, "load", LOAD_TO_PCT(pthread->sample));
+		spdk_json_write_named_double(w, "average_load", LOAD_TO_PCT(pthread->level));
+		spdk_json_write_named_double(w, "trend", LOAD_TO_PCT(pthread->trend));
+		spdk_json_write_named_double(w, "forecast", LOAD_TO_PCT(pthread->forecast));
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_named_array_begin(w, "decisions");
+	i = g_decision_count > MAX_DECISIONS ? g_decision_count - MAX_DECISIONS : 0;
+	for (; i < g_decision_count; i++) {
+		decision = &g_decisions[i % MAX_DECISIONS];
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint64(w, "period", decision->period);
+		spdk_json_write_named_uint64(w, "thread_id", decision->thread_id);
+		spdk_json_write_named_uint32(w, "src_lcore", decision->src_lcore);
+		spdk_json_write_named_uint32(w, "dst_lcore", decision->dst_lcore);
+		spdk_json_write_named_double(w, "forecast", LOAD_TO_PCT(decision->forecast));
+		spdk_json_write_named_double(w, "gain", LOAD_TO_PCT(decision->gain));
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_object_end(w);
+}
+
+struct json_scheduler_opts {
+	uint8_t load_limit;
+	uint8_t core_limit;
+	uint8_t smoothing;
+	uint8_t trend_smoothing;
+	uint8_t horizon;
+	uint8_t migration_cost;
+};
+
+static const struct spdk_json_object_decoder sched_decoders[] = {
+	{"load_limit", offsetof(struct json_scheduler_opts, load_limit), spdk_json_decode_uint8, true},
+	{"core_limit", offsetof(struct json_scheduler_opts, core_limit), spdk_json_decode_uint8, true},
+	{"smoothing", offsetof(struct json_scheduler_opts, smoothing), spdk_json_decode_uint8, true},
+	{"trend_smoothing", offsetof(struct json_scheduler_opts, trend_smoothing), spdk_json_decode_uint8, true},
+	{"horizon", offsetof(struct json_scheduler_opts, horizon), spdk_json_decode_uint8, true},
+	{"migration_cost", offsetof(struct json_scheduler_opts, migration_cost), spdk_json_decode_uint8, true},
+};
+
+static int
+set_opts(const struct spdk_json_val *opts)
+{
+	struct json_scheduler_opts scheduler_opts;
+
+	scheduler_opts.load_limit = g_load_limit;
+	scheduler_opts.core_limit = g_core_limit;
+	scheduler_opts.smoothing = g_smoothing;
+	scheduler_opts.trend_smoothing = g_trend_smoothing;
+	scheduler_opts.horizon = g_horizon;
+	scheduler_opts.migration_cost = g_migration_cost;
+
+	if (opts != NULL) {
+		if (spdk_json_decode_object_relaxed(opts, sched_decoders,
+						    SPDK_COUNTOF(sched_decoders), &scheduler_opts)) {
+			SPDK_ERRLOG("Decoding scheduler opts JSON failed\n");
+			return -1;
+		}
+	}
+
+	if (scheduler_opts.load_limit > 100 || scheduler_opts.core_limit > 100 ||
+	    scheduler_opts.smoothing > 100 || scheduler_opts.trend_smoothing > 100 ||
+	    scheduler_opts.migration_cost > 100) {
+		SPDK_ERRLOG("Scheduler percentage options cannot exceed 100\n");
+		return -EINVAL;
+	}
+
+	if (scheduler_opts.smoothing == 0) {
+		SPDK_ERRLOG("Scheduler smoothing cannot be 0\n");
+		return -EINVAL;
+	}
+
+	SPDK_NOTICELOG("Setting scheduler load limit to %d\n", scheduler_opts.load_limit);
+	g_load_limit = scheduler_opts.load_limit;
+	SPDK_NOTICELOG("Setting scheduler core limit to %d\n", scheduler_opts.core_limit);
+	g_core_limit = scheduler_opts.core_limit;
+	SPDK_NOTICELOG("Setting scheduler smoothing to %d\n", scheduler_opts.smoothing);
+	g_smoothing = scheduler_opts.smoothing;
+	SPDK_NOTICELOG("Setting scheduler trend smoothing to %d\n", scheduler_opts.trend_smoothing);
+	g_trend_smoothing = scheduler_opts.trend_smoothing;
+	SPDK_NOTICELOG("Setting scheduler horizon to %d\n", scheduler_opts.horizon);
+	g_horizon = scheduler_opts.horizon;
+	SPDK_NOTICELOG("Setting scheduler migration cost to %d\n", scheduler_opts.migration_cost);
+	g_migration_cost = scheduler_opts.migration_cost;
+
+	return 0;
+}
+
+static void
+get_opts(struct spdk_json_write_ctx *ctx)
+{
+	spdk_json_write_named_uint8(ctx, "load_limit", g_load_limit);
+	spdk_json_write_named_uint8(ctx, "core_limit", g_core_limit);
+	spdk_json_write_named_uint8(ctx, "smoothing", g_smoothing);
+	spdk_json_write_named_uint8(ctx, "trend_smoothing", g_trend_smoothing);
+	spdk_json_write_named_uint8(ctx, "horizon", g_horizon);
+	spdk_json_write_named_uint8(ctx, "migration_cost", g_migration_cost);
+}
+
+static struct spdk_scheduler scheduler_predictive = {
+	.name = "predictive",
+	.init = init,
+	.deinit = deinit,
+	.balance = balance,
+	.set_opts = set_opts,
+	.get_opts = get_opts,
+};
+
+SPDK_SCHEDULER_REGISTER(scheduler_predictive);
@@ -0,0 +1,15 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#ifndef SPDK_SCHEDULER_PREDICTIVE_H
+#define SPDK_SCHEDULER_PREDICTIVE_H
+
+#include "spdk/stdinc.h"
+#include "spdk/json.h"
+
+/* Write the threads tracked by the predictive scheduler and its most recent decisions. */
+void scheduler_predictive_write_decisions(struct spdk_json_write_ctx *w);
+
+#endif /* SPDK_SCHEDULER_PREDICTIVE_H */
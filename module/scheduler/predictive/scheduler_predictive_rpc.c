@@ -0,0 +1,38 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "scheduler_predictive.h"
+
+#include "spdk/rpc.h"
+#include "spdk/util.h"
+#include "spdk/scheduler.h"
+#include "spdk/string.h"
+
+static void
+rpc_scheduler_predictive_get_decisions(struct spdk_jsonrpc_request *request,
+				       const struct spdk_json_val *params)
+{
+	struct spdk_scheduler *scheduler = spdk_scheduler_get();
+	struct spdk_json_write_ctx *w;
+
+	if (params) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 "'scheduler_predictive_get_decisions' requires no arguments");
+		return;
+	}
+
+	/* Balancing and this RPC both run on the main core, so no locking is needed. */
+	if (scheduler == NULL || strcmp(scheduler->name, "predictive") != 0) {
+		spdk_jsonrpc_send_error_response(request, -ENODEV,
+						 "Predictive scheduler is not active");
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	scheduler_predictive_write_decisions(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+SPDK_RPC_REGISTER("scheduler_predictive_get_decisions", rpc_scheduler_predictive_get_decisions,
+		  SPDK_RPC_RUNTIME)
@@ -50,11 +50,14 @@ struct spdk_posix_sock {
 	bool			pipe_has_data;
 	bool			socket_has_data;
 	bool			zcopy;
+	int			zcopy_send_flags;
 
 	int			placement_id;
 
 	SSL_CTX			*ctx;
 	SSL			*ssl;
+	/* The kernel encrypts the data sent, so it can be written to the socket directly */
+	bool			ktls_send;
 
 	TAILQ_ENTRY(spdk_posix_sock)	link;
 };
@@ -80,7 +83,10 @@ static struct spdk_sock_impl_opts g_spdk_posix_sock_impl_opts = {
 	.tls_version = 0,
 	.enable_ktls = false,
 	.psk_key = NULL,
-	.psk_identity = NULL
+	.psk_identity = NULL,
+	.enable_recv_multishot = false,
+	.busy_poll_usecs = 0,
+	.enable_prefer_busy_poll = false
 };
 
 static struct spdk_sock_map g_map = {
@@ -122,6 +128,9 @@ posix_sock_copy_impl_opts(struct spdk_sock_impl_opts *dest, const struct spdk_so
 	SET_FIELD(enable_ktls);
 	SET_FIELD(psk_key);
 	SET_FIELD(psk_identity);
+	SET_FIELD(enable_recv_multishot);
+	SET_FIELD(busy_poll_usecs);
+	SET_FIELD(enable_prefer_busy_poll);
 
 #undef SET_FIELD
 #undef FIELD_OK
@@ -383,6 +392,9 @@ posix_sock_init(struct spdk_posix_sock *sock, bool enable_zero_copy)
 	int flag;
 	int rc;
 #endif
+#if defined(__linux__) && defined(SO_BUSY_POLL)
+	int val;
+#endif
 
 #if defined(SPDK_ZEROCOPY)
 	flag = 1;
@@ -392,6 +404,7 @@ posix_sock_init(struct spdk_posix_sock *sock, bool enable_zero_copy)
 		rc = setsockopt(sock->fd, SOL_SOCKET, SO_ZEROCOPY, &flag, sizeof(flag));
 		if (rc == 0) {
 			sock->zcopy = true;
+			sock->zcopy_send_flags = MSG_ZEROCOPY;
 		}
 	}
 #endif
@@ -406,6 +419,26 @@ posix_sock_init(struct spdk_posix_sock *sock, bool enable_zero_copy)
 		}
 	}
 
+#if defined(SO_BUSY_POLL)
+	/* Let each receive run the device queue's NAPI on this core */
+	if (sock->base.impl_opts.busy_poll_usecs > 0) {
+		val = sock->base.impl_opts.busy_poll_usecs;
+		rc = setsockopt(sock->fd, SOL_SOCKET, SO_BUSY_POLL, &val, sizeof(val));
+		if (rc != 0) {
+			SPDK_ERRLOG("busy poll was failed to set, errno %d\n", errno);
+		}
+	}
+#endif
+
+#if defined(SO_PREFER_BUSY_POLL)
+	if (sock->base.impl_opts.enable_prefer_busy_poll) {
+		rc = setsockopt(sock->fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &flag, sizeof(flag));
+		if (rc != 0) {
+			SPDK_ERRLOG("prefer busy poll was failed to set, errno %d\n", errno);
+		}
+	}
+#endif
+
 	spdk_sock_get_placement_id(sock->fd, sock->base.impl_opts.enable_placement_id,
 				   &sock->placement_id);
 
@@ -757,6 +790,21 @@ ssl_sock_accept_loop(SSL_CTX *ctx, int fd, struct spdk_sock_impl_opts *impl_opts
 	return ssl;
 }
 
+static void
+posix_sock_set_ssl(struct spdk_posix_sock *sock, SSL *ssl)
+{
+	sock->ssl = ssl;
+	/* Once the handshake is done, OpenSSL may have handed the send path over to the
+	 * kernel. Skip SSL_write() then, which issues a syscall per iovec. */
+#ifdef SSL_OP_ENABLE_KTLS
+	sock->ktls_send = BIO_get_ktls_send(SSL_get_wbio(ssl));
+#else
+	sock->ktls_send = false;
+#endif
+	SPDK_DEBUGLOG(sock_posix, "kTLS send %s on sock %p\n",
+		      sock->ktls_send ? "enabled" : "disabled", sock);
+}
+
 static ssize_t
 SSL_readv(SSL *ssl, const struct iovec *iov, int iovcnt)
 {
@@ -994,7 +1042,7 @@ retry:
 	}
 
 	if (ssl) {
-		sock->ssl = ssl;
+		posix_sock_set_ssl(sock, ssl);
 	}
 
 	return &sock->base;
@@ -1086,7 +1134,7 @@ _posix_sock_accept(struct spdk_sock *_sock, bool enable_ssl)
 	}
 
 	if (ssl) {
-		new_sock->ssl = ssl;
+		posix_sock_set_ssl(new_sock, ssl);
 	}
 
 	return &new_sock->base;
@@ -1171,6 +1219,12 @@ _sock_check_zcopy(struct spdk_sock *sock)
 			return 0;
 		}
 
+		if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+			/* The kernel copied the data anyway, stop paying for the notifications */
+			sock->stats.zcopy_copied += serr->ee_data - serr->ee_info + 1;
+			psock->zcopy_send_flags = 0;
+		}
+
 		/* Most of the time, the pending_reqs array is in the exact
 		 * order we need such that all of the requests to complete are
 		 * in order, in the front. It is guaranteed that all requests
@@ -1239,7 +1293,7 @@ _sock_flush(struct spdk_sock *sock)
 
 #ifdef SPDK_ZEROCOPY
 	if (psock->zcopy) {
-		flags = MSG_ZEROCOPY | MSG_NOSIGNAL;
+		flags = psock->zcopy_send_flags | MSG_NOSIGNAL;
 	} else
 #endif
 	{
@@ -1259,7 +1313,7 @@ _sock_flush(struct spdk_sock *sock)
 	msg.msg_iov = iovs;
 	msg.msg_iovlen = iovcnt;
 
-	if (psock->ssl) {
+	if (psock->ssl && !psock->ktls_send) {
 		rc = SSL_writev(psock->ssl, iovs, iovcnt);
 	} else {
 		rc = sendmsg(psock->fd, &msg, flags);
@@ -1274,6 +1328,7 @@ _sock_flush(struct spdk_sock *sock)
 	sent = rc;
 
 	if (is_zcopy) {
+		sock->stats.zcopy_sends++;
 		/* Handling overflow case, because we use psock->sendmsg_idx - 1 for the
 		 * req->internal.offset, so sendmsg_idx should not be zero  */
 		if (spdk_unlikely(psock->sendmsg_idx == UINT32_MAX)) {
@@ -1281,6 +1336,8 @@ _sock_flush(struct spdk_sock *sock)
 		} else {
 			psock->sendmsg_idx++;
 		}
+	} else {
+		sock->stats.copy_sends++;
 	}
 
 	/* Consume the requests that were actually written */
@@ -1345,7 +1402,8 @@ posix_sock_flush(struct spdk_sock *sock)
 #ifdef SPDK_ZEROCOPY
 	struct spdk_posix_sock *psock = __posix_sock(sock);
 
-	if (psock->zcopy && !TAILQ_EMPTY(&sock->pending_reqs)) {
+	/* The error queue of socks in a group is reaped once per poll, on EPOLLERR */
+	if (psock->zcopy && sock->group_impl == NULL && !TAILQ_EMPTY(&sock->pending_reqs)) {
 		_sock_check_zcopy(sock);
 	}
 #endif
@@ -1531,7 +1589,7 @@ posix_sock_writev(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 		return -1;
 	}
 
-	if (sock->ssl) {
+	if (sock->ssl && !sock->ktls_send) {
 		return SSL_writev(sock->ssl, iov, iovcnt);
 	} else {
 		return writev(sock->fd, iov, iovcnt);
@@ -1676,6 +1734,20 @@ posix_sock_group_impl_create(void)
 	TAILQ_INIT(&group_impl->socks_with_data);
 	group_impl->placement_id = -1;
 
+#if defined(SPDK_EPOLL) && defined(EPIOCSPARAMS)
+	/* Also busy poll from epoll_wait(), on the NAPI ID of the group's sockets */
+	if (g_spdk_posix_sock_impl_opts.busy_poll_usecs > 0) {
+		struct epoll_params params = {
+			.busy_poll_usecs = g_spdk_posix_sock_impl_opts.busy_poll_usecs,
+			.prefer_busy_poll = g_spdk_posix_sock_impl_opts.enable_prefer_busy_poll,
+		};
+
+		if (ioctl(fd, EPIOCSPARAMS, &params) != 0) {
+			SPDK_NOTICELOG("Failed to set epoll busy poll params, errno %d\n", errno);
+		}
+	}
+#endif
+
 	if (g_spdk_posix_sock_impl_opts.enable_placement_id == PLACEMENT_CPU) {
 		spdk_sock_map_insert(&g_map, spdk_env_get_current_core(), &group_impl->base);
 		group_impl->placement_id = spdk_env_get_current_core();
@@ -32,12 +32,23 @@ enum spdk_sock_task_type {
 	SPDK_SOCK_TASK_ERRQUEUE,
 	SPDK_SOCK_TASK_WRITE,
 	SPDK_SOCK_TASK_CANCEL,
+	SPDK_SOCK_TASK_RECV,
 };
 
 #if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
 #define SPDK_ZEROCOPY
 #endif
 
+/* Multishot recv with provided buffer rings requires liburing 2.3 and kernel 6.0 */
+#ifdef IORING_RECV_MULTISHOT
+#define SPDK_URING_RECV_MULTISHOT
+#endif
+
+#define SPDK_URING_RECV_BUF_COUNT 1024
+#define SPDK_URING_RECV_BUF_SIZE 8192
+#define SPDK_URING_RECV_BUF_GROUP_ID 0
+#define SPDK_URING_FIXED_FILES 1024
+
 enum spdk_uring_sock_task_status {
 	SPDK_URING_SOCK_TASK_NOT_IN_USE = 0,
 	SPDK_URING_SOCK_TASK_IN_PROCESS,
@@ -55,6 +66,29 @@ struct spdk_uring_task {
 	STAILQ_ENTRY(spdk_uring_task)		link;
 };
 
+struct spdk_uring_buf_ring;
+
+/* Data received by the multishot recv task. It is either one of the sock group's
+ * provided buffers or, once the sock is removed from the group, a copy of them on
+ * the heap (ring == NULL). */
+struct spdk_uring_recv_buf {
+	struct spdk_uring_buf_ring		*ring;
+	uint8_t					*base;
+	uint32_t				len;
+	uint32_t				offset;
+	uint16_t				bid;
+	STAILQ_ENTRY(spdk_uring_recv_buf)	link;
+};
+
+#ifdef SPDK_URING_RECV_MULTISHOT
+struct spdk_uring_buf_ring {
+	struct io_uring_buf_ring		*br;
+	uint8_t					*data;
+	uint32_t				avail;
+	struct spdk_uring_recv_buf		bufs[SPDK_URING_RECV_BUF_COUNT];
+};
+#endif
+
 struct spdk_uring_sock {
 	struct spdk_sock			base;
 	int					fd;
@@ -64,6 +98,10 @@ struct spdk_uring_sock {
 	struct spdk_uring_task			errqueue_task;
 	struct spdk_uring_task			pollin_task;
 	struct spdk_uring_task			cancel_task;
+	struct spdk_uring_task			recv_task;
+	STAILQ_HEAD(, spdk_uring_recv_buf)	recv_bufs;
+	bool					recv_multishot;
+	int					fixed_idx;
 	struct spdk_pipe			*recv_pipe;
 	void					*recv_buf;
 	int					recv_buf_sz;
@@ -85,6 +123,10 @@ struct spdk_uring_sock_group_impl {
 	uint32_t				io_queued;
 	uint32_t				io_avail;
 	struct pending_recv_list		pending_recv;
+	struct spdk_uring_buf_ring		*buf_ring;
+	bool					fixed_files;
+	uint32_t				fixed_free_cnt;
+	int					fixed_free[SPDK_URING_FIXED_FILES];
 };
 
 static struct spdk_sock_impl_opts g_spdk_uring_sock_impl_opts = {
@@ -99,7 +141,10 @@ static struct spdk_sock_impl_opts g_spdk_uring_sock_impl_opts = {
 	.tls_version = 0,
 	.enable_ktls = false,
 	.psk_key = NULL,
-	.psk_identity = NULL
+	.psk_identity = NULL,
+	.enable_recv_multishot = false,
+	.busy_poll_usecs = 0,
+	.enable_prefer_busy_poll = false
 };
 
 static struct spdk_sock_map g_map = {
@@ -142,6 +187,9 @@ uring_sock_copy_impl_opts(struct spdk_sock_impl_opts *dest, const struct spdk_so
 	SET_FIELD(enable_ktls);
 	SET_FIELD(psk_key);
 	SET_FIELD(psk_identity);
+	SET_FIELD(enable_recv_multishot);
+	SET_FIELD(busy_poll_usecs);
+	SET_FIELD(enable_prefer_busy_poll);
 
 #undef SET_FIELD
 #undef FIELD_OK
@@ -413,7 +461,9 @@ uring_sock_alloc(int fd, struct spdk_sock_impl_opts *impl_opts, bool enable_zero
 	}
 
 	sock->fd = fd;
+	sock->fixed_idx = -1;
 	memcpy(&sock->base.impl_opts, impl_opts, sizeof(*impl_opts));
+	STAILQ_INIT(&sock->recv_bufs);
 
 #if defined(__linux__)
 	flag = 1;
@@ -705,14 +755,39 @@ uring_sock_accept(struct spdk_sock *_sock)
 	return &new_sock->base;
 }
 
+static void
+uring_sock_recv_buf_put(struct spdk_uring_recv_buf *buf)
+{
+#ifdef SPDK_URING_RECV_MULTISHOT
+	struct spdk_uring_buf_ring *ring = buf->ring;
+
+	if (ring != NULL) {
+		/* Hand the buffer back to the kernel */
+		io_uring_buf_ring_add(ring->br, buf->base, SPDK_URING_RECV_BUF_SIZE, buf->bid,
+				      io_uring_buf_ring_mask(SPDK_URING_RECV_BUF_COUNT), 0);
+		io_uring_buf_ring_advance(ring->br, 1);
+		ring->avail++;
+		return;
+	}
+#endif
+	assert(buf->ring == NULL);
+	free(buf);
+}
+
 static int
 uring_sock_close(struct spdk_sock *_sock)
 {
 	struct spdk_uring_sock *sock = __uring_sock(_sock);
+	struct spdk_uring_recv_buf *buf;
 
 	assert(TAILQ_EMPTY(&_sock->pending_reqs));
 	assert(sock->group == NULL);
 
+	while ((buf = STAILQ_FIRST(&sock->recv_bufs)) != NULL) {
+		STAILQ_REMOVE_HEAD(&sock->recv_bufs, link);
+		uring_sock_recv_buf_put(buf);
+	}
+
 	/* If the socket fails to close, the best choice is to
 	 * leak the fd but continue to free the rest of the sock
 	 * memory. */
@@ -753,11 +828,68 @@ uring_sock_recv_from_pipe(struct spdk_uring_sock *sock, struct iovec *diov, int
 	spdk_pipe_reader_advance(sock->recv_pipe, bytes);
 
 	/* If we drained the pipe, take it off the level-triggered list */
-	if (sock->base.group_impl && spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0) {
+	if (sock->base.group_impl && spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0 &&
+	    STAILQ_EMPTY(&sock->recv_bufs)) {
+		group = __uring_group_impl(sock->base.group_impl);
+		TAILQ_REMOVE(&group->pending_recv, sock, link);
+		sock->pending_recv = false;
+	}
+
+	return bytes;
+}
+
+static void
+uring_sock_recv_bufs_check_drained(struct spdk_uring_sock *sock)
+{
+	struct spdk_uring_sock_group_impl *group;
+
+	/* If we drained the buffers, take it off the level-triggered list */
+	if (sock->base.group_impl && sock->pending_recv && STAILQ_EMPTY(&sock->recv_bufs)) {
 		group = __uring_group_impl(sock->base.group_impl);
 		TAILQ_REMOVE(&group->pending_recv, sock, link);
 		sock->pending_recv = false;
 	}
+}
+
+static ssize_t
+uring_sock_recv_from_bufs(struct spdk_uring_sock *sock, struct iovec *diov, int diovcnt)
+{
+	struct iovec siov[IOV_BATCH_SIZE];
+	struct spdk_uring_recv_buf *buf;
+	size_t bytes, remaining, len;
+	int siovcnt = 0;
+
+	STAILQ_FOREACH(buf, &sock->recv_bufs, link) {
+		if (siovcnt == IOV_BATCH_SIZE) {
+			break;
+		}
+		siov[siovcnt].iov_base = buf->base + buf->offset;
+		siov[siovcnt].iov_len = buf->len - buf->offset;
+		siovcnt++;
+	}
+
+	bytes = spdk_iovcpy(siov, siovcnt, diov, diovcnt);
+	if (bytes == 0) {
+		/* The only way this happens is if diov is 0 length */
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Return the fully consumed buffers */
+	remaining = bytes;
+	while (remaining > 0) {
+		buf = STAILQ_FIRST(&sock->recv_bufs);
+		assert(buf != NULL);
+		len = spdk_min(remaining, buf->len - buf->offset);
+		buf->offset += len;
+		remaining -= len;
+		if (buf->offset == buf->len) {
+			STAILQ_REMOVE_HEAD(&sock->recv_bufs, link);
+			uring_sock_recv_buf_put(buf);
+		}
+	}
+
+	uring_sock_recv_bufs_check_drained(sock);
 
 	return bytes;
 }
@@ -804,6 +936,19 @@ uring_sock_readv(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 	int rc, i;
 	size_t len;
 
+	/* Anything in the pipe was received before the multishot recv was armed */
+	if (sock->recv_pipe == NULL || spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0) {
+		if (!STAILQ_EMPTY(&sock->recv_bufs)) {
+			return uring_sock_recv_from_bufs(sock, iov, iovcnt);
+		}
+
+		/* The data is delivered by the multishot recv, do not race with it */
+		if (sock->recv_multishot) {
+			errno = EAGAIN;
+			return -1;
+		}
+	}
+
 	if (sock->recv_pipe == NULL) {
 		return sock_readv(sock->fd, iov, iovcnt);
 	}
@@ -841,6 +986,58 @@ uring_sock_recv(struct spdk_sock *sock, void *buf, size_t len)
 	return uring_sock_readv(sock, iov, 1);
 }
 
+static ssize_t
+uring_sock_recv_next(struct spdk_sock *_sock, void **_buf, void **ctx)
+{
+	struct spdk_uring_sock *sock = __uring_sock(_sock);
+	struct spdk_uring_recv_buf *buf;
+	struct iovec iov;
+	ssize_t rc;
+
+	if (sock->recv_pipe == NULL || spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0) {
+		if (STAILQ_EMPTY(&sock->recv_bufs) && sock->recv_multishot) {
+			errno = EAGAIN;
+			return -1;
+		}
+	}
+
+	if (!STAILQ_EMPTY(&sock->recv_bufs) &&
+	    (sock->recv_pipe == NULL || spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0)) {
+		/* Hand over the buffer the data was received to */
+		buf = STAILQ_FIRST(&sock->recv_bufs);
+		STAILQ_REMOVE_HEAD(&sock->recv_bufs, link);
+		uring_sock_recv_bufs_check_drained(sock);
+	} else {
+		/* No multishot recv or data still in the pipe, receive to a new buffer */
+		buf = calloc(1, sizeof(*buf) + SPDK_URING_RECV_BUF_SIZE);
+		if (buf == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		buf->base = (uint8_t *)(buf + 1);
+
+		iov.iov_base = buf->base;
+		iov.iov_len = SPDK_URING_RECV_BUF_SIZE;
+		rc = uring_sock_readv(_sock, &iov, 1);
+		if (rc <= 0) {
+			free(buf);
+			return rc;
+		}
+		buf->len = rc;
+	}
+
+	*_buf = buf->base + buf->offset;
+	*ctx = buf;
+
+	return buf->len - buf->offset;
+}
+
+static void
+uring_sock_recv_buf_release(struct spdk_sock *_sock, void *ctx)
+{
+	uring_sock_recv_buf_put(ctx);
+}
+
 static ssize_t
 uring_sock_writev(struct spdk_sock *_sock, struct iovec *iov, int iovcnt)
 {
@@ -897,6 +1094,7 @@ sock_complete_write_reqs(struct spdk_sock *_sock, ssize_t rc, bool is_zcopy)
 	int retval;
 
 	if (is_zcopy) {
+		_sock->stats.zcopy_sends++;
 		/* Handling overflow case, because we use psock->sendmsg_idx - 1 for the
 		 * req->internal.offset, so sendmsg_idx should not be zero */
 		if (spdk_unlikely(sock->sendmsg_idx == UINT32_MAX)) {
@@ -904,6 +1102,8 @@ sock_complete_write_reqs(struct spdk_sock *_sock, ssize_t rc, bool is_zcopy)
 		} else {
 			sock->sendmsg_idx++;
 		}
+	} else {
+		_sock->stats.copy_sends++;
 	}
 
 	/* Consume the requests that were actually written */
@@ -979,6 +1179,12 @@ _sock_check_zcopy(struct spdk_sock *_sock, int status)
 		return 0;
 	}
 
+	if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+		/* The kernel copied the data anyway, stop paying for the notifications */
+		_sock->stats.zcopy_copied += serr->ee_data - serr->ee_info + 1;
+		sock->zcopy_send_flags = 0;
+	}
+
 	/* Most of the time, the pending_reqs array is in the exact
 	 * order we need such that all of the requests to complete are
 	 * in order, in the front. It is guaranteed that all requests
@@ -1010,6 +1216,17 @@ _sock_check_zcopy(struct spdk_sock *_sock, int status)
 	return 0;
 }
 
+/* Refer to the socket through its slot in the group's registered files, if it got one,
+ * so that the kernel doesn't need to look up and reference the file for each SQE. */
+static inline void
+_sock_sqe_set_file(struct spdk_uring_sock *sock, struct io_uring_sqe *sqe)
+{
+	if (sock->fixed_idx >= 0) {
+		sqe->fd = sock->fixed_idx;
+		sqe->flags |= IOSQE_FIXED_FILE;
+	}
+}
+
 static void
 _sock_prep_errqueue(struct spdk_sock *_sock)
 {
@@ -1026,6 +1243,7 @@ _sock_prep_errqueue(struct spdk_sock *_sock)
 
 	sqe = io_uring_get_sqe(&sock->group->uring);
 	io_uring_prep_recvmsg(sqe, sock->fd, &task->msg, MSG_ERRQUEUE);
+	_sock_sqe_set_file(sock, sqe);
 	io_uring_sqe_set_data(sqe, task);
 	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
 }
@@ -1070,6 +1288,7 @@ _sock_flush(struct spdk_sock *_sock)
 
 	sqe = io_uring_get_sqe(&sock->group->uring);
 	io_uring_prep_sendmsg(sqe, sock->fd, &sock->write_task.msg, flags);
+	_sock_sqe_set_file(sock, sqe);
 	io_uring_sqe_set_data(sqe, task);
 	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
 }
@@ -1091,10 +1310,177 @@ _sock_prep_pollin(struct spdk_sock *_sock)
 
 	sqe = io_uring_get_sqe(&sock->group->uring);
 	io_uring_prep_poll_add(sqe, sock->fd, POLLIN | POLLERR);
+	_sock_sqe_set_file(sock, sqe);
+	io_uring_sqe_set_data(sqe, task);
+	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
+}
+
+#ifdef SPDK_URING_RECV_MULTISHOT
+static void
+_sock_prep_recv(struct spdk_sock *_sock)
+{
+	struct spdk_uring_sock *sock = __uring_sock(_sock);
+	struct spdk_uring_task *task = &sock->recv_task;
+	struct io_uring_sqe *sqe;
+
+	/* The multishot recv stays armed until it fails or runs out of buffers */
+	if (task->status == SPDK_URING_SOCK_TASK_IN_PROCESS || sock->group->buf_ring->avail == 0) {
+		return;
+	}
+
+	sock->group->io_queued++;
+
+	sqe = io_uring_get_sqe(&sock->group->uring);
+	io_uring_prep_recv_multishot(sqe, sock->fd, NULL, 0, 0);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = SPDK_URING_RECV_BUF_GROUP_ID;
+	_sock_sqe_set_file(sock, sqe);
 	io_uring_sqe_set_data(sqe, task);
 	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
 }
 
+static void
+_sock_recv_complete(struct spdk_uring_sock *sock, int status, uint32_t flags)
+{
+	struct spdk_uring_sock_group_impl *group = sock->group;
+	struct spdk_uring_buf_ring *ring = group->buf_ring;
+	struct spdk_uring_recv_buf *buf;
+
+	if (status > 0) {
+		assert(flags & IORING_CQE_F_BUFFER);
+		buf = &ring->bufs[flags >> IORING_CQE_BUFFER_SHIFT];
+		buf->len = status;
+		buf->offset = 0;
+		ring->avail--;
+		STAILQ_INSERT_TAIL(&sock->recv_bufs, buf, link);
+	} else if (status == -ENOBUFS || status == -ECANCELED) {
+		/* Out of buffers, the task is re-armed once some of them are returned */
+		return;
+	} else {
+		/* EOF, an error or multishot recv not supported on this socket. Switch back to
+		 * the regular recv path, which reports it once the received data is consumed. */
+		sock->recv_multishot = false;
+	}
+
+	if (sock->base.cb_fn != NULL && sock->pending_recv == false) {
+		sock->pending_recv = true;
+		TAILQ_INSERT_TAIL(&group->pending_recv, sock, link);
+	}
+}
+
+static int
+uring_sock_group_buf_ring_init(struct spdk_uring_sock_group_impl *group)
+{
+	struct spdk_uring_buf_ring *ring;
+	struct io_uring_buf_reg reg = {};
+	struct spdk_uring_recv_buf *buf;
+	int mask = io_uring_buf_ring_mask(SPDK_URING_RECV_BUF_COUNT);
+	int i, rc;
+
+	ring = calloc(1, sizeof(*ring));
+	if (ring == NULL) {
+		return -ENOMEM;
+	}
+
+	rc = posix_memalign((void **)&ring->br, sysconf(_SC_PAGESIZE),
+			    SPDK_URING_RECV_BUF_COUNT * sizeof(struct io_uring_buf));
+	if (rc != 0) {
+		free(ring);
+		return -rc;
+	}
+
+	ring->data = malloc(SPDK_URING_RECV_BUF_COUNT * SPDK_URING_RECV_BUF_SIZE);
+	if (ring->data == NULL) {
+		free(ring->br);
+		free(ring);
+		return -ENOMEM;
+	}
+
+	/* Zeroes the ring tail, io_uring_buf_ring_init() is only provided by newer liburing */
+	memset(ring->br, 0, SPDK_URING_RECV_BUF_COUNT * sizeof(struct io_uring_buf));
+	reg.ring_addr = (uint64_t)(uintptr_t)ring->br;
+	reg.ring_entries = SPDK_URING_RECV_BUF_COUNT;
+	reg.bgid = SPDK_URING_RECV_BUF_GROUP_ID;
+	rc = io_uring_register_buf_ring(&group->uring, &reg, 0);
+	if (rc != 0) {
+		free(ring->data);
+		free(ring->br);
+		free(ring);
+		return rc;
+	}
+
+	for (i = 0; i < SPDK_URING_RECV_BUF_COUNT; i++) {
+		buf = &ring->bufs[i];
+		buf->ring = ring;
+		buf->base = ring->data + (size_t)i * SPDK_URING_RECV_BUF_SIZE;
+		buf->bid = i;
+		io_uring_buf_ring_add(ring->br, buf->base, SPDK_URING_RECV_BUF_SIZE, i, mask, i);
+	}
+	io_uring_buf_ring_advance(ring->br, SPDK_URING_RECV_BUF_COUNT);
+	ring->avail = SPDK_URING_RECV_BUF_COUNT;
+
+	group->buf_ring = ring;
+
+	return 0;
+}
+
+static void
+uring_sock_group_buf_ring_fini(struct spdk_uring_sock_group_impl *group)
+{
+	struct spdk_uring_buf_ring *ring = group->buf_ring;
+
+	if (ring == NULL) {
+		return;
+	}
+
+	assert(ring->avail == SPDK_URING_RECV_BUF_COUNT);
+	io_uring_unregister_buf_ring(&group->uring, SPDK_URING_RECV_BUF_GROUP_ID);
+	free(ring->data);
+	free(ring->br);
+	free(ring);
+	group->buf_ring = NULL;
+}
+#endif
+
+/* Copy the data still held in the group's provided buffers, so that they can be returned
+ * before the sock leaves the group. */
+static int
+uring_sock_recv_bufs_detach(struct spdk_uring_sock *sock)
+{
+	struct spdk_uring_recv_buf *buf, *tmp, *copy;
+	size_t len = 0;
+
+	STAILQ_FOREACH(buf, &sock->recv_bufs, link) {
+		if (buf->ring != NULL) {
+			len += buf->len - buf->offset;
+		}
+	}
+
+	if (len == 0) {
+		return 0;
+	}
+
+	copy = calloc(1, sizeof(*copy) + len);
+	if (copy == NULL) {
+		return -ENOMEM;
+	}
+	copy->base = (uint8_t *)(copy + 1);
+
+	/* Copies made by a previous removal always precede the provided buffers */
+	STAILQ_FOREACH_SAFE(buf, &sock->recv_bufs, link, tmp) {
+		if (buf->ring == NULL) {
+			continue;
+		}
+		STAILQ_REMOVE(&sock->recv_bufs, buf, spdk_uring_recv_buf, link);
+		memcpy(copy->base + copy->len, buf->base + buf->offset, buf->len - buf->offset);
+		copy->len += buf->len - buf->offset;
+		uring_sock_recv_buf_put(buf);
+	}
+	STAILQ_INSERT_TAIL(&sock->recv_bufs, copy, link);
+
+	return 0;
+}
+
 static void
 _sock_prep_cancel_task(struct spdk_sock *_sock, void *user_data)
 {
@@ -1124,7 +1510,10 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 	struct spdk_uring_sock *sock, *tmp;
 	struct spdk_uring_task *task;
 	int status;
-	bool is_zcopy;
+#ifdef SPDK_URING_RECV_MULTISHOT
+	uint32_t flags;
+#endif
+	bool is_zcopy, more;
 
 	for (i = 0; i < max; i++) {
 		ret = io_uring_peek_cqe(&group->uring, &cqe);
@@ -1142,12 +1531,23 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 		assert(sock != NULL);
 		assert(sock->group != NULL);
 		assert(sock->group == group);
-		sock->group->io_inflight--;
-		sock->group->io_avail++;
 		status = cqe->res;
+		more = false;
+#ifdef SPDK_URING_RECV_MULTISHOT
+		flags = cqe->flags;
+		more = flags & IORING_CQE_F_MORE;
+#endif
 		io_uring_cqe_seen(&group->uring, cqe);
 
-		task->status = SPDK_URING_SOCK_TASK_NOT_IN_USE;
+		if (more) {
+			/* The multishot recv is still armed, so it doesn't count against max */
+			assert(task->type == SPDK_SOCK_TASK_RECV);
+			i--;
+		} else {
+			sock->group->io_inflight--;
+			sock->group->io_avail++;
+			task->status = SPDK_URING_SOCK_TASK_NOT_IN_USE;
+		}
 
 		if (spdk_unlikely(status <= 0)) {
 			if (status == -EAGAIN || status == -EWOULDBLOCK || (status == -ENOBUFS && sock->zcopy)) {
@@ -1195,6 +1595,11 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 		case SPDK_SOCK_TASK_CANCEL:
 			/* Do nothing */
 			break;
+#ifdef SPDK_URING_RECV_MULTISHOT
+		case SPDK_SOCK_TASK_RECV:
+			_sock_recv_complete(sock, status, flags);
+			break;
+#endif
 		default:
 			SPDK_UNREACHABLE();
 		}
@@ -1210,7 +1615,9 @@ sock_uring_group_reap(struct spdk_uring_sock_group_impl *group, int max, int max
 		}
 
 		if (spdk_unlikely(sock->base.cb_fn == NULL) ||
-		    (sock->recv_pipe == NULL || spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0)) {
+		    ((sock->recv_pipe == NULL ||
+		      spdk_pipe_reader_bytes_available(sock->recv_pipe) == 0) &&
+		     STAILQ_EMPTY(&sock->recv_bufs))) {
 			sock->pending_recv = false;
 			TAILQ_REMOVE(&group->pending_recv, sock, link);
 			if (spdk_unlikely(sock->base.cb_fn == NULL)) {
@@ -1400,10 +1807,35 @@ uring_sock_group_impl_get_optimal(struct spdk_sock *_sock, struct spdk_sock_grou
 	return NULL;
 }
 
+static void
+uring_sock_group_fixed_files_init(struct spdk_uring_sock_group_impl *group)
+{
+	int fds[SPDK_URING_FIXED_FILES];
+	int i, rc;
+
+	/* Register an empty table, the slots are filled in as socks are added to the group */
+	for (i = 0; i < SPDK_URING_FIXED_FILES; i++) {
+		fds[i] = -1;
+		group->fixed_free[i] = SPDK_URING_FIXED_FILES - 1 - i;
+	}
+
+	rc = io_uring_register_files(&group->uring, fds, SPDK_URING_FIXED_FILES);
+	if (rc != 0) {
+		SPDK_NOTICELOG("Failed to register files (%d), using regular file descriptors\n", rc);
+		return;
+	}
+
+	group->fixed_files = true;
+	group->fixed_free_cnt = SPDK_URING_FIXED_FILES;
+}
+
 static struct spdk_sock_group_impl *
 uring_sock_group_impl_create(void)
 {
 	struct spdk_uring_sock_group_impl *group_impl;
+#ifdef SPDK_URING_RECV_MULTISHOT
+	int rc;
+#endif
 
 	group_impl = calloc(1, sizeof(*group_impl));
 	if (group_impl == NULL) {
@@ -1421,6 +1853,17 @@ uring_sock_group_impl_create(void)
 
 	TAILQ_INIT(&group_impl->pending_recv);
 
+	uring_sock_group_fixed_files_init(group_impl);
+
+#ifdef SPDK_URING_RECV_MULTISHOT
+	if (g_spdk_uring_sock_impl_opts.enable_recv_multishot) {
+		rc = uring_sock_group_buf_ring_init(group_impl);
+		if (rc != 0) {
+			SPDK_NOTICELOG("Failed to register buffer ring (%d), multishot recv disabled\n", rc);
+		}
+	}
+#endif
+
 	if (g_spdk_uring_sock_impl_opts.enable_placement_id == PLACEMENT_CPU) {
 		spdk_sock_map_insert(&g_map, spdk_env_get_current_core(), &group_impl->base);
 	}
@@ -1434,7 +1877,7 @@ uring_sock_group_impl_add_sock(struct spdk_sock_group_impl *_group,
 {
 	struct spdk_uring_sock *sock = __uring_sock(_sock);
 	struct spdk_uring_sock_group_impl *group = __uring_group_impl(_group);
-	int rc;
+	int rc, idx;
 
 	sock->group = group;
 	sock->write_task.sock = sock;
@@ -1451,9 +1894,28 @@ uring_sock_group_impl_add_sock(struct spdk_sock_group_impl *_group,
 	sock->cancel_task.sock = sock;
 	sock->cancel_task.type = SPDK_SOCK_TASK_CANCEL;
 
+	sock->recv_task.sock = sock;
+	sock->recv_task.type = SPDK_SOCK_TASK_RECV;
+
+	/* Socks beyond the size of the table keep using their file descriptor */
+	if (group->fixed_files && group->fixed_free_cnt > 0) {
+		idx = group->fixed_free[--group->fixed_free_cnt];
+		rc = io_uring_register_files_update(&group->uring, idx, &sock->fd, 1);
+		if (rc == 1) {
+			sock->fixed_idx = idx;
+		} else {
+			group->fixed_free_cnt++;
+		}
+	}
+
+	/* Zero copy socks keep the pollin task, it also reports the send completions */
+	sock->recv_multishot = group->buf_ring != NULL && !sock->zcopy &&
+			       sock->base.impl_opts.enable_recv_multishot;
+
 	/* switched from another polling group due to scheduling */
-	if (spdk_unlikely(sock->recv_pipe != NULL &&
-			  (spdk_pipe_reader_bytes_available(sock->recv_pipe) > 0))) {
+	if (spdk_unlikely((sock->recv_pipe != NULL &&
+			   (spdk_pipe_reader_bytes_available(sock->recv_pipe) > 0)) ||
+			  !STAILQ_EMPTY(&sock->recv_bufs))) {
 		assert(sock->pending_recv == false);
 		sock->pending_recv = true;
 		TAILQ_INSERT_TAIL(&group->pending_recv, sock, link);
@@ -1487,6 +1949,12 @@ uring_sock_group_impl_poll(struct spdk_sock_group_impl *_group, int max_events,
 				continue;
 			}
 			_sock_flush(_sock);
+#ifdef SPDK_URING_RECV_MULTISHOT
+			if (sock->recv_multishot) {
+				_sock_prep_recv(_sock);
+				continue;
+			}
+#endif
 			_sock_prep_pollin(_sock);
 		}
 	}
@@ -1521,6 +1989,7 @@ uring_sock_group_impl_remove_sock(struct spdk_sock_group_impl *_group,
 {
 	struct spdk_uring_sock *sock = __uring_sock(_sock);
 	struct spdk_uring_sock_group_impl *group = __uring_group_impl(_group);
+	int rc, fd;
 
 	if (sock->write_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE) {
 		_sock_prep_cancel_task(_sock, &sock->write_task);
@@ -1552,10 +2021,36 @@ uring_sock_group_impl_remove_sock(struct spdk_sock_group_impl *_group,
 		}
 	}
 
+	if (sock->recv_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE) {
+		_sock_prep_cancel_task(_sock, &sock->recv_task);
+		/* Since spdk_sock_group_remove_sock is not asynchronous interface, so
+		 * currently can use a while loop here. */
+		while ((sock->recv_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE) ||
+		       (sock->cancel_task.status != SPDK_URING_SOCK_TASK_NOT_IN_USE)) {
+			uring_sock_group_impl_poll(_group, 32, NULL);
+		}
+	}
+
 	/* Make sure the cancelling the tasks above didn't cause sending new requests */
 	assert(sock->write_task.status == SPDK_URING_SOCK_TASK_NOT_IN_USE);
 	assert(sock->pollin_task.status == SPDK_URING_SOCK_TASK_NOT_IN_USE);
 	assert(sock->errqueue_task.status == SPDK_URING_SOCK_TASK_NOT_IN_USE);
+	assert(sock->recv_task.status == SPDK_URING_SOCK_TASK_NOT_IN_USE);
+
+	rc = uring_sock_recv_bufs_detach(sock);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to save the received data of the sock: %d\n", rc);
+		errno = -rc;
+		return -1;
+	}
+	sock->recv_multishot = false;
+
+	if (sock->fixed_idx >= 0) {
+		fd = -1;
+		io_uring_register_files_update(&group->uring, sock->fixed_idx, &fd, 1);
+		group->fixed_free[group->fixed_free_cnt++] = sock->fixed_idx;
+		sock->fixed_idx = -1;
+	}
 
 	if (sock->pending_recv) {
 		TAILQ_REMOVE(&group->pending_recv, sock, link);
@@ -1583,6 +2078,9 @@ uring_sock_group_impl_close(struct spdk_sock_group_impl *_group)
 	assert(group->io_inflight == 0);
 	assert(group->io_avail == SPDK_SOCK_GROUP_QUEUE_DEPTH);
 
+#ifdef SPDK_URING_RECV_MULTISHOT
+	uring_sock_group_buf_ring_fini(group);
+#endif
 	io_uring_queue_exit(&group->uring);
 
 	if (g_spdk_uring_sock_impl_opts.enable_placement_id == PLACEMENT_CPU) {
@@ -1663,6 +2161,8 @@ static struct spdk_net_impl g_uring_net_impl = {
 	.close		= uring_sock_close,
 	.recv		= uring_sock_recv,
 	.readv		= uring_sock_readv,
+	.recv_next	= uring_sock_recv_next,
+	.recv_buf_release = uring_sock_recv_buf_release,
 	.readv_async	= uring_sock_readv_async,
 	.writev		= uring_sock_writev,
 	.writev_async	= uring_sock_writev_async,
@@ -19,6 +19,7 @@ from . import iaa
 from . import ioat
 from . import iscsi
 from . import log
+from . import metrics
 from . import lvol
 from . import nbd
 from . import ublk
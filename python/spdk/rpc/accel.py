@@ -34,6 +34,26 @@ def accel_assign_opc(client, opname, module):
     return client.call('accel_assign_opc', params)
 
 
+def accel_set_opc_dispatch(client, opname, sw_max_bytes=None, max_queue_depth=None):
+    """Execute some operations of an opcode with the software module.
+
+    Args:
+        opname: name of operation
+        sw_max_bytes: operations of up to this many bytes are executed in software (optional)
+        max_queue_depth: operations above this queue depth of the assigned module are executed
+        in software (optional)
+    """
+    params = {
+        'opname': opname,
+    }
+    if sw_max_bytes is not None:
+        params['sw_max_bytes'] = sw_max_bytes
+    if max_queue_depth is not None:
+        params['max_queue_depth'] = max_queue_depth
+
+    return client.call('accel_set_opc_dispatch', params)
+
+
 def accel_crypto_key_create(client, cipher, key, key2, name):
     """Create Data Encryption Key Identifier.
 
@@ -37,8 +37,31 @@ def framework_get_reactors(client):
     return client.call('framework_get_reactors')
 
 
+def framework_set_reactor_event_opts(client, lcore=None, batch_size=None, policy=None):
+    """Set how reactors execute their events.
+
+    Args:
+        lcore: core of the reactor to update, all reactors if omitted (optional)
+        batch_size: maximum number of events executed at once (optional)
+        policy: 'batch' for one batch per reactor iteration, 'drain' for all queued events (optional)
+
+    Returns:
+        True or False
+    """
+    params = {}
+    if lcore is not None:
+        params['lcore'] = lcore
+    if batch_size is not None:
+        params['batch_size'] = batch_size
+    if policy is not None:
+        params['policy'] = policy
+    return client.call('framework_set_reactor_event_opts', params)
+
+
 def framework_set_scheduler(client, name, period=None, load_limit=None, core_limit=None,
-                            core_busy=None):
+                            core_busy=None, numa_penalty=None, smoothing=None, trend_smoothing=None,
+                            horizon=None, migration_cost=None, latency_target_us=None,
+                            latency_percentile=None, latency_high=None, latency_low=None):
     """Select threads scheduler that will be activated and its period.
 
     Args:
@@ -56,6 +79,24 @@ def framework_set_scheduler(client, name, period=None, load_limit=None, core_lim
         params['core_limit'] = core_limit
     if core_busy is not None:
         params['core_busy'] = core_busy
+    if numa_penalty is not None:
+        params['numa_penalty'] = numa_penalty
+    if smoothing is not None:
+        params['smoothing'] = smoothing
+    if trend_smoothing is not None:
+        params['trend_smoothing'] = trend_smoothing
+    if horizon is not None:
+        params['horizon'] = horizon
+    if migration_cost is not None:
+        params['migration_cost'] = migration_cost
+    if latency_target_us is not None:
+        params['latency_target_us'] = latency_target_us
+    if latency_percentile is not None:
+        params['latency_percentile'] = latency_percentile
+    if latency_high is not None:
+        params['latency_high'] = latency_high
+    if latency_low is not None:
+        params['latency_low'] = latency_low
     return client.call('framework_set_scheduler', params)
 
 
@@ -68,6 +109,15 @@ def framework_get_scheduler(client):
     return client.call('framework_get_scheduler')
 
 
+def scheduler_predictive_get_decisions(client):
+    """Query load forecasts and recent decisions of the predictive scheduler.
+
+    Returns:
+        Per-thread load forecasts and the most recent thread migrations.
+    """
+    return client.call('scheduler_predictive_get_decisions')
+
+
 def thread_get_stats(client):
     """Query threads statistics.
 
@@ -113,6 +163,34 @@ def thread_get_pollers(client):
     return client.call('thread_get_pollers')
 
 
+def thread_set_adaptive_interrupt(client, idle_budget_us):
+    """Let threads switch between poll and interrupt mode after idling.
+
+    Args:
+        idle_budget_us: idle time in microseconds before a thread switches to interrupt mode, 0 to disable
+
+    Returns:
+        True or False
+    """
+    params = {'idle_budget_us': idle_budget_us}
+    return client.call('thread_set_adaptive_interrupt', params)
+
+
+def thread_monitor_poller_histograms(client, enabled=None):
+    """Query or set state of per-poller run time histograms.
+
+    Args:
+        enabled: True to enable histograms; False to disable and reset them; None to query (optional)
+
+    Returns:
+        Current poller histograms state (after applying enabled flag).
+    """
+    params = {}
+    if enabled is not None:
+        params['enabled'] = enabled
+    return client.call('thread_monitor_poller_histograms', params)
+
+
 def thread_get_io_channels(client):
     """Query current IO channels.
 
@@ -5,7 +5,8 @@
 
 
 def bdev_set_options(client, bdev_io_pool_size=None, bdev_io_cache_size=None, bdev_auto_examine=None,
-                     small_buf_pool_size=None, large_buf_pool_size=None):
+                     small_buf_pool_size=None, large_buf_pool_size=None, accel_copy_threshold=None,
+                     examine_queue_depth=None):
     """Set parameters for the bdev subsystem.
 
     Args:
@@ -14,6 +15,8 @@ def bdev_set_options(client, bdev_io_pool_size=None, bdev_io_cache_size=None, bd
         bdev_auto_examine: if set to false, the bdev layer will not examine every disks automatically (optional)
         small_buf_pool_size: maximum number of small buffer (8KB buffer) pool size (optional)
         large_buf_pool_size: maximum number of large buffer (64KB buffer) pool size (optional)
+        accel_copy_threshold: minimum size of a bounce buffer copy offloaded to accel, 0 to disable (optional)
+        examine_queue_depth: maximum number of bdevs examined at a time, 0 for no limit (optional)
     """
     params = {}
 
@@ -27,6 +30,10 @@ def bdev_set_options(client, bdev_io_pool_size=None, bdev_io_cache_size=None, bd
         params['small_buf_pool_size'] = small_buf_pool_size
     if large_buf_pool_size:
         params['large_buf_pool_size'] = large_buf_pool_size
+    if accel_copy_threshold is not None:
+        params['accel_copy_threshold'] = accel_copy_threshold
+    if examine_queue_depth is not None:
+        params['examine_queue_depth'] = examine_queue_depth
     return client.call('bdev_set_options', params)
 
 
@@ -49,19 +56,21 @@ def bdev_wait_for_examine(client):
     return client.call('bdev_wait_for_examine')
 
 
-def bdev_compress_create(client, base_bdev_name, pm_path, lb_size):
+def bdev_compress_create(client, base_bdev_name, pm_path=None, lb_size=None):
     """Construct a compress virtual block device.
 
     Args:
         base_bdev_name: name of the underlying base bdev
-        pm_path: path to persistent memory
+        pm_path: path to persistent memory (optional, keep the metadata on the base bdev if omitted)
         lb_size: logical block size for the compressed vol in bytes.  Must be 4K or 512.
 
     Returns:
         Name of created virtual block device.
     """
-    params = {'base_bdev_name': base_bdev_name, 'pm_path': pm_path}
+    params = {'base_bdev_name': base_bdev_name}
 
+    if pm_path:
+        params['pm_path'] = pm_path
     if lb_size:
         params['lb_size'] = lb_size
 
@@ -133,7 +142,7 @@ def bdev_crypto_delete(client, name):
     return client.call('bdev_crypto_delete', params)
 
 
-def bdev_ocf_create(client, name, mode, cache_line_size, cache_bdev_name, core_bdev_name):
+def bdev_ocf_create(client, name, mode, cache_line_size, cache_bdev_name, core_bdev_name, cleaner_cpumask=None):
     """Add an OCF block device
 
     Args:
@@ -142,6 +151,7 @@ def bdev_ocf_create(client, name, mode, cache_line_size, cache_bdev_name, core_b
         cache_line_size: OCF cache line size. The unit is KiB: {4, 8, 16, 32, 64}
         cache_bdev_name: name of underlying cache bdev
         core_bdev_name: name of underlying core bdev
+        cleaner_cpumask: cpumask of the thread running the cache cleaner (optional)
 
     Returns:
         Name of created block device
@@ -155,6 +165,8 @@ def bdev_ocf_create(client, name, mode, cache_line_size, cache_bdev_name, core_b
 
     if cache_line_size:
         params['cache_line_size'] = cache_line_size
+    if cleaner_cpumask:
+        params['cleaner_cpumask'] = cleaner_cpumask
 
     return client.call('bdev_ocf_create', params)
 
@@ -283,7 +295,8 @@ def bdev_ocf_flush_status(client, name):
 
 
 def bdev_malloc_create(client, num_blocks, block_size, physical_block_size=None, name=None, uuid=None, optimal_io_boundary=None,
-                       md_size=None, md_interleave=None, dif_type=None, dif_is_head_of_md=None):
+                       md_size=None, md_interleave=None, dif_type=None, dif_is_head_of_md=None, numa_id=None,
+                       numa_stripe_blocks=None):
     """Construct a malloc block device.
 
     Args:
@@ -297,6 +310,8 @@ def bdev_malloc_create(client, num_blocks, block_size, physical_block_size=None,
         md_interleave: metadata location, interleaved if set, and separated if omitted (optional)
         dif_type: protection information type (optional)
         dif_is_head_of_md: protection information is in the first 8 bytes of metadata (optional)
+        numa_id: NUMA node to allocate the memory on, default -1 (any, optional)
+        numa_stripe_blocks: stripe the memory across NUMA nodes in chunks of this many blocks (optional)
 
     Returns:
         Name of created block device.
@@ -318,6 +333,10 @@ def bdev_malloc_create(client, num_blocks, block_size, physical_block_size=None,
         params['dif_type'] = dif_type
     if dif_is_head_of_md:
         params['dif_is_head_of_md'] = dif_is_head_of_md
+    if numa_id is not None:
+        params['numa_id'] = numa_id
+    if numa_stripe_blocks:
+        params['numa_stripe_blocks'] = numa_stripe_blocks
 
     return client.call('bdev_malloc_create', params)
 
@@ -401,7 +420,8 @@ def bdev_raid_get_bdevs(client, category):
     return client.call('bdev_raid_get_bdevs', params)
 
 
-def bdev_raid_create(client, name, raid_level, base_bdevs, strip_size=None, strip_size_kb=None, uuid=None, superblock=False):
+def bdev_raid_create(client, name, raid_level, base_bdevs, strip_size=None, strip_size_kb=None, uuid=None, superblock=False,
+                     write_intent_region_size_kb=None):
     """Create raid bdev. Either strip size arg will work but one is required.
 
     Args:
@@ -413,6 +433,8 @@ def bdev_raid_create(client, name, raid_level, base_bdevs, strip_size=None, stri
         uuid: UUID for this raid bdev (optional)
         superblock: information about raid bdev will be stored in superblock on each base bdev,
                     disabled by default due to backward compatibility
+        write_intent_region_size_kb: size of the regions tracked by the write-intent bitmap in KB,
+                    raid1 with superblock only (optional)
 
     Returns:
         None
@@ -428,6 +450,9 @@ def bdev_raid_create(client, name, raid_level, base_bdevs, strip_size=None, stri
     if uuid:
         params['uuid'] = uuid
 
+    if write_intent_region_size_kb:
+        params['write_intent_region_size_kb'] = write_intent_region_size_kb
+
     return client.call('bdev_raid_create', params)
 
 
@@ -457,6 +482,60 @@ def bdev_raid_remove_base_bdev(client, name):
     return client.call('bdev_raid_remove_base_bdev', params)
 
 
+def bdev_raid_add_base_bdev(client, base_bdev, raid_bdev):
+    """Add base bdev to existing raid bdev
+
+    Args:
+        base_bdev: base bdev name
+        raid_bdev: raid bdev name
+
+    Returns:
+        None
+    """
+    params = {'base_bdev': base_bdev, 'raid_bdev': raid_bdev}
+    return client.call('bdev_raid_add_base_bdev', params)
+
+
+def bdev_raid_set_options(client, process_window_size_kb=None, process_max_bandwidth_mb_sec=None,
+                          process_latency_threshold_us=None, raid1_read_policy=None,
+                          raid5f_stripe_cache_size=None, raid5f_stripe_cache_flush_us=None,
+                          numa_affinity=None):
+    """Set options for bdev raid.
+
+    Args:
+        process_window_size_kb: size of the range processed at a time by background processes (optional)
+        process_max_bandwidth_mb_sec: maximum bandwidth of background processes, 0 for unlimited (optional)
+        process_latency_threshold_us: foreground latency above which background processes slow down,
+        0 to disable (optional)
+        raid1_read_policy: read balancing policy of raid1 bdevs: bandwidth or latency (optional)
+        raid5f_stripe_cache_size: number of stripes per channel collecting partial stripe writes of raid5f bdevs,
+        0 to accept only full stripe writes (optional)
+        raid5f_stripe_cache_flush_us: time a partially written stripe waits for more writes (optional)
+        numa_affinity: submit raid0 and concat I/O to base bdevs from threads on their NUMA socket (optional)
+
+    Returns:
+        None
+    """
+    params = {}
+
+    if process_window_size_kb is not None:
+        params['process_window_size_kb'] = process_window_size_kb
+    if process_max_bandwidth_mb_sec is not None:
+        params['process_max_bandwidth_mb_sec'] = process_max_bandwidth_mb_sec
+    if process_latency_threshold_us is not None:
+        params['process_latency_threshold_us'] = process_latency_threshold_us
+    if raid1_read_policy is not None:
+        params['raid1_read_policy'] = raid1_read_policy
+    if raid5f_stripe_cache_size is not None:
+        params['raid5f_stripe_cache_size'] = raid5f_stripe_cache_size
+    if raid5f_stripe_cache_flush_us is not None:
+        params['raid5f_stripe_cache_flush_us'] = raid5f_stripe_cache_flush_us
+    if numa_affinity is not None:
+        params['numa_affinity'] = numa_affinity
+
+    return client.call('bdev_raid_set_options', params)
+
+
 def bdev_aio_create(client, filename, name, block_size=None, readonly=False):
     """Construct a Linux AIO block device.
 
@@ -501,6 +580,29 @@ def bdev_aio_delete(client, name):
     return client.call('bdev_aio_delete', params)
 
 
+def bdev_uring_set_options(client, sqpoll=None, sqpoll_idle_ms=None, iopoll=None, fixed_files=None):
+    """Set options for the uring bdev module. Only allowed before any uring bdev is created.
+
+    Args:
+        sqpoll: use a kernel thread shared by all rings to poll the submission queues (optional)
+        sqpoll_idle_ms: time after which an idle kernel submission thread goes to sleep (optional)
+        iopoll: poll for completions instead of using interrupts, requires O_DIRECT (optional)
+        fixed_files: register the files of the bdevs with the rings (optional)
+    """
+    params = {}
+
+    if sqpoll is not None:
+        params['sqpoll'] = sqpoll
+    if sqpoll_idle_ms is not None:
+        params['sqpoll_idle_ms'] = sqpoll_idle_ms
+    if iopoll is not None:
+        params['iopoll'] = iopoll
+    if fixed_files is not None:
+        params['fixed_files'] = fixed_files
+
+    return client.call('bdev_uring_set_options', params)
+
+
 def bdev_uring_create(client, filename, name, block_size=None):
     """Create a bdev with Linux io_uring backend.
 
@@ -531,7 +633,8 @@ def bdev_uring_delete(client, name):
     return client.call('bdev_uring_delete', params)
 
 
-def bdev_xnvme_create(client, filename, name, io_mechanism, conserve_cpu=None):
+def bdev_xnvme_create(client, filename, name, io_mechanism, conserve_cpu=None, io_poll=None,
+                      queue_depth=None):
     """Create a bdev with xNVMe backend.
 
     Args:
@@ -539,6 +642,8 @@ def bdev_xnvme_create(client, filename, name, io_mechanism, conserve_cpu=None):
         name: name of xNVMe bdev to create
         io_mechanism: I/O mechanism to use (ex: io_uring, io_uring_cmd, etc.)
         conserve_cpu: Whether or not to conserve CPU when polling (default: False)
+        io_poll: Whether or not to poll for completions, also with io_uring_cmd (default: False)
+        queue_depth: Depth of the queue of each I/O channel, a power of 2 (default: 512)
 
     Returns:
         Name of created bdev.
@@ -550,6 +655,10 @@ def bdev_xnvme_create(client, filename, name, io_mechanism, conserve_cpu=None):
     }
     if conserve_cpu:
         params['conserve_cpu'] = conserve_cpu
+    if io_poll:
+        params['io_poll'] = io_poll
+    if queue_depth is not None:
+        params['queue_depth'] = queue_depth
 
     return client.call('bdev_xnvme_create', params)
 
@@ -571,7 +680,12 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, timeo
                           delay_cmd_submit=None, transport_retry_count=None, bdev_retry_count=None,
                           transport_ack_timeout=None, ctrlr_loss_timeout_sec=None, reconnect_delay_sec=None,
                           fast_io_fail_timeout_sec=None, disable_auto_failback=None, generate_uuids=None,
-                          transport_tos=None, nvme_error_stat=None, rdma_srq_size=None, io_path_stat=None):
+                          transport_tos=None, nvme_error_stat=None, rdma_srq_size=None, io_path_stat=None,
+                          bdev_retry_budget_percent=None, adaptive_timeout_multiplier=None,
+                          hedged_read_percentile=None, delay_cmd_submit_batch_size=None,
+                          nvme_ioq_adaptive_poll_max_us=None, nvme_ioq_adaptive_poll_batch=None,
+                          rdma_send_signal_interval=None, align_write_splits=None,
+                          io_qpairs_per_ctrlr=None):
     """Set options for the bdev nvme. This is startup command.
 
     Args:
@@ -588,6 +702,8 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, timeo
         nvme_ioq_poll_period_us: How often to poll I/O queues for completions in microseconds (optional)
         io_queue_requests: The number of requests allocated for each NVMe I/O queue. Default: 512 (optional)
         delay_cmd_submit: Enable delayed NVMe command submission to allow batching of multiple commands (optional)
+        delay_cmd_submit_batch_size: With delayed command submission, ring the doorbell as soon as this many commands
+        are delayed. 0 means no limit (optional)
         transport_retry_count: The number of attempts per I/O in the transport layer when an I/O fails (optional)
         bdev_retry_count: The number of attempts per I/O in the bdev layer when an I/O fails. -1 means infinite retries. (optional)
         transport_ack_timeout: Time to wait ack until packet retransmission for RDMA or until closes connection for TCP.
@@ -616,6 +732,22 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, timeo
         nvme_error_stat: Enable collecting NVMe error counts. (optional)
         rdma_srq_size: Set the size of a shared rdma receive queue. Default: 0 (disabled) (optional)
         io_path_stat: Enable collection I/O path stat of each io path. (optional)
+        bdev_retry_budget_percent: Limit the retries on a path to this percentage of its successful I/Os.
+        0 means no limit. (optional)
+        adaptive_timeout_multiplier: Set the I/O timeout of each controller to its p99 latency times this value,
+        with timeout_us as the upper bound. 0 means disabled. (optional)
+        hedged_read_percentile: In active-active mode, duplicate a read on another path if it is slower than
+        this percentile of the recent reads. 0 means disabled. (optional)
+        nvme_ioq_adaptive_poll_max_us: Under low load, stretch the I/O poll period up to this value in microseconds.
+        0 means disabled. (optional)
+        nvme_ioq_adaptive_poll_batch: With the adaptive I/O poll period, the number of completions to reap
+        per poll. Default: 8 (optional)
+        rdma_send_signal_interval: Only request a completion for one out of this many sends of an RDMA qpair.
+        Default: 0 (all sends are signaled) (optional)
+        align_write_splits: Align the splits of writes to the optimal write size or write granularity
+        of the namespace. (optional)
+        io_qpairs_per_ctrlr: Number of I/O qpairs each I/O channel creates for each controller. I/Os
+        are spread across them by queue depth. Default: 1 (optional)
 
     """
     params = {}
@@ -696,6 +828,33 @@ def bdev_nvme_set_options(client, action_on_timeout=None, timeout_us=None, timeo
     if io_path_stat is not None:
         params['io_path_stat'] = io_path_stat
 
+    if bdev_retry_budget_percent is not None:
+        params['bdev_retry_budget_percent'] = bdev_retry_budget_percent
+
+    if adaptive_timeout_multiplier is not None:
+        params['adaptive_timeout_multiplier'] = adaptive_timeout_multiplier
+
+    if hedged_read_percentile is not None:
+        params['hedged_read_percentile'] = hedged_read_percentile
+
+    if delay_cmd_submit_batch_size is not None:
+        params['delay_cmd_submit_batch_size'] = delay_cmd_submit_batch_size
+
+    if nvme_ioq_adaptive_poll_max_us is not None:
+        params['nvme_ioq_adaptive_poll_max_us'] = nvme_ioq_adaptive_poll_max_us
+
+    if nvme_ioq_adaptive_poll_batch is not None:
+        params['nvme_ioq_adaptive_poll_batch'] = nvme_ioq_adaptive_poll_batch
+
+    if rdma_send_signal_interval is not None:
+        params['rdma_send_signal_interval'] = rdma_send_signal_interval
+
+    if align_write_splits is not None:
+        params['align_write_splits'] = align_write_splits
+
+    if io_qpairs_per_ctrlr is not None:
+        params['io_qpairs_per_ctrlr'] = io_qpairs_per_ctrlr
+
     return client.call('bdev_nvme_set_options', params)
 
 
@@ -719,7 +878,7 @@ def bdev_nvme_attach_controller(client, name, trtype, traddr, adrfam=None, trsvc
                                 hostsvcid=None, prchk_reftag=None, prchk_guard=None,
                                 hdgst=None, ddgst=None, fabrics_timeout=None, multipath=None, num_io_queues=None,
                                 ctrlr_loss_timeout_sec=None, reconnect_delay_sec=None,
-                                fast_io_fail_timeout_sec=None, psk=None, max_bdevs=None):
+                                fast_io_fail_timeout_sec=None, psk=None, max_bdevs=None, use_cmb_sqs=None):
     """Construct block device for each NVMe namespace in the attached controller.
 
     Args:
@@ -756,6 +915,7 @@ def bdev_nvme_attach_controller(client, name, trtype, traddr, adrfam=None, trsvc
         ctrlr_loss_timeout_sec if ctrlr_loss_timeout_sec is not -1. (optional)
         psk: Set PSK and enable TCP SSL socket implementation (optional)
         max_bdevs: Size of the name array for newly created bdevs. Default is 128. (optional)
+        use_cmb_sqs: Place the submission queues in the controller memory buffer. PCIe only. (optional)
 
     Returns:
         Names of created block devices.
@@ -821,6 +981,9 @@ def bdev_nvme_attach_controller(client, name, trtype, traddr, adrfam=None, trsvc
     if max_bdevs is not None:
         params['max_bdevs'] = max_bdevs
 
+    if use_cmb_sqs:
+        params['use_cmb_sqs'] = use_cmb_sqs
+
     return client.call('bdev_nvme_attach_controller', params)
 
 
@@ -995,7 +1158,7 @@ def bdev_nvme_set_multipath_policy(client, name, policy, selector, rr_min_io):
     Args:
         name: NVMe bdev name
         policy: Multipath policy (active_passive or active_active)
-        selector: Multipath selector (round_robin, queue_depth)
+        selector: Multipath selector (round_robin, queue_depth, latency)
         rr_min_io: Number of IO to route to a path before switching to another one (optional)
     """
 
@@ -1127,7 +1290,8 @@ def bdev_rbd_get_clusters_info(client, name):
     return client.call('bdev_rbd_get_clusters_info', params)
 
 
-def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=None, config=None, cluster_name=None, uuid=None):
+def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=None, config=None, cluster_name=None, uuid=None,
+                    num_contexts=None):
     """Create a Ceph RBD block device.
 
     Args:
@@ -1139,6 +1303,7 @@ def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=Non
         config: map of config keys to values (optional)
         cluster_name: Name to identify Rados cluster (optional)
         uuid: UUID of block device (optional)
+        num_contexts: number of image handles the I/O channels are spread across (optional)
 
     Returns:
         Name of created block device.
@@ -1161,6 +1326,8 @@ def bdev_rbd_create(client, pool_name, rbd_name, block_size, name=None, user=Non
         print("WARNING:bdev_rbd_create should be used with specifying -c to have a cluster name after bdev_rbd_register_cluster.")
     if uuid is not None:
         params['uuid'] = uuid
+    if num_contexts is not None:
+        params['num_contexts'] = num_contexts
 
     return client.call('bdev_rbd_create', params)
 
@@ -1202,7 +1369,8 @@ def bdev_error_create(client, base_name, uuid=None):
     return client.call('bdev_error_create', params)
 
 
-def bdev_delay_create(client, base_bdev_name, name, avg_read_latency, p99_read_latency, avg_write_latency, p99_write_latency, uuid=None):
+def bdev_delay_create(client, base_bdev_name, name, avg_read_latency, p99_read_latency, avg_write_latency, p99_write_latency, uuid=None,
+                      latency_distribution=None, stall_period_us=None, stall_duration_us=None):
     """Construct a delay block device.
 
     Args:
@@ -1213,6 +1381,9 @@ def bdev_delay_create(client, base_bdev_name, name, avg_read_latency, p99_read_l
         avg_write_latency: complete 99% of write ops with this delay
         p99_write_latency: complete 1% of write ops with this delay
         uuid: UUID of block device (optional)
+        latency_distribution: bimodal (default) or lognormal, where the average latency is the median (optional)
+        stall_period_us: period of the injected stalls in microseconds (optional)
+        stall_duration_us: duration of the injected stalls in microseconds, 0 to disable (optional)
 
     Returns:
         Name of created block device.
@@ -1227,6 +1398,12 @@ def bdev_delay_create(client, base_bdev_name, name, avg_read_latency, p99_read_l
     }
     if uuid:
         params['uuid'] = uuid
+    if latency_distribution is not None:
+        params['latency_distribution'] = latency_distribution
+    if stall_period_us is not None:
+        params['stall_period_us'] = stall_period_us
+    if stall_duration_us is not None:
+        params['stall_duration_us'] = stall_duration_us
     return client.call('bdev_delay_create', params)
 
 
@@ -1557,12 +1734,15 @@ def bdev_ftl_get_stats(client, name):
     return client.call('bdev_ftl_get_stats', params)
 
 
-def bdev_get_bdevs(client, name=None, timeout=None):
+def bdev_get_bdevs(client, name=None, timeout=None, start_after=None, max_count=None, fields=None):
     """Get information about block devices.
 
     Args:
         name: bdev name to query (optional; if omitted, query all bdevs)
         timeout: time in ms to wait for the bdev with specified name to appear
+        start_after: only list the bdevs registered after the bdev with this name (optional)
+        max_count: maximum number of bdevs to list (optional)
+        fields: list of keys to include in each bdev object, "name" is always included (optional)
 
     Returns:
         List of bdev information objects.
@@ -1572,6 +1752,12 @@ def bdev_get_bdevs(client, name=None, timeout=None):
         params['name'] = name
     if timeout:
         params['timeout'] = timeout
+    if start_after:
+        params['start_after'] = start_after
+    if max_count:
+        params['max_count'] = max_count
+    if fields:
+        params['fields'] = fields
     return client.call('bdev_get_bdevs', params)
 
 
@@ -1629,6 +1815,33 @@ def bdev_get_histogram(client, name):
     return client.call('bdev_get_histogram', params)
 
 
+def bdev_enable_type_histograms(client, name, enable):
+    """Control whether histograms per I/O type and size are enabled for specified bdev.
+
+    Args:
+        name: name of bdev
+        enable: enable or disable the histograms
+    """
+    params = {'name': name, 'enable': enable}
+    return client.call('bdev_enable_type_histograms', params)
+
+
+def bdev_get_type_histograms(client, name, per_channel=None, reset=None):
+    """Get histograms per I/O type and size for specified bdev.
+
+    Args:
+        name: name of bdev
+        per_channel: display the histograms of each channel (optional)
+        reset: reset the histograms once they are read (optional)
+    """
+    params = {'name': name}
+    if per_channel is not None:
+        params['per_channel'] = per_channel
+    if reset is not None:
+        params['reset'] = reset
+    return client.call('bdev_get_type_histograms', params)
+
+
 def bdev_error_inject_error(client, name, io_type, error_type, num,
                             corrupt_offset, corrupt_value):
     """Inject an error via an error bdev.
@@ -1677,7 +1890,8 @@ def bdev_set_qos_limit(
         rw_ios_per_sec=None,
         rw_mbytes_per_sec=None,
         r_mbytes_per_sec=None,
-        w_mbytes_per_sec=None):
+        w_mbytes_per_sec=None,
+        sharded=None):
     """Set QoS rate limit on a block device.
 
     Args:
@@ -1686,6 +1900,7 @@ def bdev_set_qos_limit(
         rw_mbytes_per_sec: R/W megabytes per second limit (>=10, example: 100). 0 means unlimited.
         r_mbytes_per_sec: Read megabytes per second limit (>=10, example: 100). 0 means unlimited.
         w_mbytes_per_sec: Write megabytes per second limit (>=10, example: 100). 0 means unlimited.
+        sharded: enforce the rate limits on each channel instead of a single QoS thread
     """
     params = {}
     params['name'] = name
@@ -1697,9 +1912,45 @@ def bdev_set_qos_limit(
         params['r_mbytes_per_sec'] = r_mbytes_per_sec
     if w_mbytes_per_sec is not None:
         params['w_mbytes_per_sec'] = w_mbytes_per_sec
+    if sharded is not None:
+        params['sharded'] = sharded
     return client.call('bdev_set_qos_limit', params)
 
 
+def bdev_set_qos_latency_target(client, name, group=None, latency_target_us=None):
+    """Set latency QoS on a block device.
+
+    Args:
+        name: name of block device
+        group: name of the latency group, omit to remove the block device from its group
+        latency_target_us: p99 latency target in microseconds, 0 to throttle the block device
+        on behalf of the others in the group (optional)
+    """
+    params = {}
+    params['name'] = name
+    if group is not None:
+        params['group'] = group
+    if latency_target_us is not None:
+        params['latency_target_us'] = latency_target_us
+    return client.call('bdev_set_qos_latency_target', params)
+
+
+def bdev_set_io_coalescing(client, name, window_us, max_blocks=None):
+    """Set up the coalescing of adjacent I/O on a block device.
+
+    Args:
+        name: name of block device
+        window_us: time window in microseconds to coalesce I/O, 0 to disable
+        max_blocks: maximum size in blocks of a coalesced I/O (optional)
+    """
+    params = {}
+    params['name'] = name
+    params['window_us'] = window_us
+    if max_blocks is not None:
+        params['max_blocks'] = max_blocks
+    return client.call('bdev_set_io_coalescing', params)
+
+
 def bdev_nvme_apply_firmware(client, bdev_name, filename):
     """Download and commit firmware to NVMe device.
 
@@ -1733,7 +1984,8 @@ def bdev_nvme_get_controller_health_info(client, name):
     return client.call('bdev_nvme_get_controller_health_info', params)
 
 
-def bdev_daos_create(client, num_blocks, block_size, pool, cont, name, oclass=None, uuid=None):
+def bdev_daos_create(client, num_blocks, block_size, pool, cont, name, oclass=None, uuid=None,
+                     num_queues=None, chunk_size=None):
     """Construct DAOS block device.
 
     Args:
@@ -1744,6 +1996,8 @@ def bdev_daos_create(client, num_blocks, block_size, pool, cont, name, oclass=No
         cont: UUID of DAOS container
         uuid: UUID of block device (optional)
         oclass: DAOS object class (optional)
+        num_queues: number of DAOS event queues per I/O channel (optional)
+        chunk_size: DFS chunk size of the backend file in bytes (optional)
 
     Returns:
         Name of created block device.
@@ -1753,6 +2007,10 @@ def bdev_daos_create(client, num_blocks, block_size, pool, cont, name, oclass=No
         params['uuid'] = uuid
     if oclass:
         params['oclass'] = oclass
+    if num_queues is not None:
+        params['num_queues'] = num_queues
+    if chunk_size is not None:
+        params['chunk_size'] = chunk_size
     return client.call('bdev_daos_create', params)
 
 
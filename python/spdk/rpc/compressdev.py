@@ -13,3 +13,12 @@ def compressdev_scan_accel_module(client, pmd):
     params = {'pmd': pmd}
 
     return client.call('compressdev_scan_accel_module', params)
+
+
+def compressdev_get_stats(client):
+    """Get the statistics of the devices used by the compressdev module.
+
+    Returns:
+        List of device statistics.
+    """
+    return client.call('compressdev_get_stats')
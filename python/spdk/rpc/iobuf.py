@@ -3,7 +3,10 @@
 #  All rights reserved.
 
 
-def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize, large_bufsize):
+def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize, large_bufsize,
+                      size_classes=None, enable_numa=None,
+                      cache_rebalance_period_us=None, cache_rebalance_budget=None,
+                      lazy_init=None):
     """Set iobuf pool options.
 
     Args:
@@ -11,6 +14,12 @@ def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize,
         large_pool_count: number of large buffers in the global pool
         small_bufsize: size of a small buffer
         large_bufsize: size of a large buffer
+        size_classes: list of {'bufsize': size of a buffer, 'pool_count': number of buffers} size
+                      classes between small and large, by increasing size (optional)
+        enable_numa: allocate separate pools on each NUMA node (optional)
+        cache_rebalance_period_us: period of the channel cache rebalancing, 0 to disable it (optional)
+        cache_rebalance_budget: percentage of each pool the caches may grow by in total (optional)
+        lazy_init: create the pools of each NUMA node on first use (optional)
     """
     params = {}
 
@@ -22,5 +31,21 @@ def iobuf_set_options(client, small_pool_count, large_pool_count, small_bufsize,
         params['small_bufsize'] = small_bufsize
     if large_bufsize is not None:
         params['large_bufsize'] = large_bufsize
+    if size_classes is not None:
+        params['size_classes'] = size_classes
+    if enable_numa is not None:
+        params['enable_numa'] = enable_numa
+    if cache_rebalance_period_us is not None:
+        params['cache_rebalance_period_us'] = cache_rebalance_period_us
+    if cache_rebalance_budget is not None:
+        params['cache_rebalance_budget'] = cache_rebalance_budget
+    if lazy_init is not None:
+        params['lazy_init'] = lazy_init
 
     return client.call('iobuf_set_options', params)
+
+
+def iobuf_get_stats(client):
+    """Get iobuf statistics of each module."""
+
+    return client.call('iobuf_get_stats')
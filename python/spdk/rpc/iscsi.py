@@ -26,7 +26,9 @@ def iscsi_set_options(
         max_r2t_per_connection=None,
         pdu_pool_size=None,
         immediate_data_pool_size=None,
-        data_out_pool_size=None):
+        data_out_pool_size=None,
+        conn_rebalance_interval=None,
+        max_lun_tasks_per_initiator=None):
     """Set iSCSI target options.
 
     Args:
@@ -52,6 +54,10 @@ def iscsi_set_options(
         pdu_pool_size: Number of PDUs in the pool (optional)
         immediate_data_pool_size: Number of immediate data buffers in the pool (optional)
         data_out_pool_size: Number of data out buffers in the pool (optional)
+        conn_rebalance_interval: Interval in seconds to move target nodes between poll groups
+        based on their load, 0 to disable (optional)
+        max_lun_tasks_per_initiator: Max number of outstanding tasks per initiator on each LUN,
+        0 for no limit (optional)
 
     Returns:
         True or False
@@ -102,6 +108,10 @@ def iscsi_set_options(
         params['immediate_data_pool_size'] = immediate_data_pool_size
     if data_out_pool_size:
         params['data_out_pool_size'] = data_out_pool_size
+    if conn_rebalance_interval:
+        params['conn_rebalance_interval'] = conn_rebalance_interval
+    if max_lun_tasks_per_initiator:
+        params['max_lun_tasks_per_initiator'] = max_lun_tasks_per_initiator
 
     return client.call('iscsi_set_options', params)
 
@@ -616,3 +626,22 @@ def scsi_get_devices(client):
         List of SCSI device.
     """
     return client.call('scsi_get_devices')
+
+
+def scsi_lun_attach_pr_store(client, dev_name, lun_id, bdev_name):
+    """Keep persistent reservations of a SCSI LUN on a bdev.
+
+    Args:
+        dev_name: SCSI device name
+        lun_id: LUN ID
+        bdev_name: name of the bdev storing the reservation state
+
+    Returns:
+        True or False
+    """
+    params = {
+        'dev_name': dev_name,
+        'lun_id': lun_id,
+        'bdev_name': bdev_name,
+    }
+    return client.call('scsi_lun_attach_pr_store', params)
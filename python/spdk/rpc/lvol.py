@@ -59,6 +59,26 @@ def bdev_lvol_grow_lvstore(client, uuid=None, lvs_name=None):
     return client.call('bdev_lvol_grow_lvstore', params)
 
 
+def bdev_lvol_set_read_cache(client, uuid=None, lvs_name=None, bdev_name=None):
+    """Set or remove the read cache of a logical volume store
+
+    Args:
+        uuid: UUID of logical volume store (optional)
+        lvs_name: name of logical volume store (optional)
+        bdev_name: bdev to cache the data of snapshots on, remove the read cache if not specified (optional)
+    """
+    if (uuid and lvs_name):
+        raise ValueError("Exactly one of uuid or lvs_name may be specified")
+    params = {}
+    if uuid:
+        params['uuid'] = uuid
+    if lvs_name:
+        params['lvs_name'] = lvs_name
+    if bdev_name:
+        params['bdev_name'] = bdev_name
+    return client.call('bdev_lvol_set_read_cache', params)
+
+
 def bdev_lvol_create(client, lvol_name, size_in_mib, thin_provision=False, uuid=None, lvs_name=None, clear_method=None):
     """Create a logical volume on a logical volume store.
 
@@ -223,6 +243,36 @@ def bdev_lvol_decouple_parent(client, name):
     return client.call('bdev_lvol_decouple_parent', params)
 
 
+def bdev_lvol_defragment(client, name, clusters_per_sec=None):
+    """Move the clusters of a logical volume next to each other.
+
+    Args:
+        name: name of logical volume to defragment
+        clusters_per_sec: maximum number of clusters moved per second (optional)
+    """
+    params = {
+        'name': name,
+    }
+    if clusters_per_sec is not None:
+        params['clusters_per_sec'] = clusters_per_sec
+    return client.call('bdev_lvol_defragment', params)
+
+
+def bdev_lvol_prefill(client, name, clusters_per_sec=None):
+    """Copy the clusters of a clone logical volume from its parent in the background.
+
+    Args:
+        name: name of logical volume to prefill
+        clusters_per_sec: maximum number of clusters copied per second (optional)
+    """
+    params = {
+        'name': name,
+    }
+    if clusters_per_sec is not None:
+        params['clusters_per_sec'] = clusters_per_sec
+    return client.call('bdev_lvol_prefill', params)
+
+
 def bdev_lvol_delete_lvstore(client, uuid=None, lvs_name=None):
     """Destroy a logical volume store.
 
@@ -263,12 +313,17 @@ def bdev_lvol_get_lvstores(client, uuid=None, lvs_name=None):
     return client.call('bdev_lvol_get_lvstores', params)
 
 
-def bdev_lvol_get_lvols(client, lvs_uuid=None, lvs_name=None):
+def bdev_lvol_get_lvols(client, lvs_uuid=None, lvs_name=None, start_after=None, max_count=None,
+                        fields=None):
     """List logical volumes
 
     Args:
         lvs_uuid: Only show volumes in the logical volume store with this UUID (optional)
         lvs_name: Only show volumes in the logical volume store with this name (optional)
+        start_after: Only show volumes following the volume with this UUID (optional)
+        max_count: Maximum number of volumes to show (optional)
+        fields: List of keys to include in each volume object, "alias" and "uuid" are always
+                included (optional)
 
     Either lvs_uuid or lvs_name may be specified, but not both.
     If both lvs_uuid and lvs_name are omitted, information about volumes in all
@@ -281,4 +336,10 @@ def bdev_lvol_get_lvols(client, lvs_uuid=None, lvs_name=None):
         params['lvs_uuid'] = lvs_uuid
     if lvs_name:
         params['lvs_name'] = lvs_name
+    if start_after:
+        params['start_after'] = start_after
+    if max_count:
+        params['max_count'] = max_count
+    if fields:
+        params['fields'] = fields
     return client.call('bdev_lvol_get_lvols', params)
@@ -0,0 +1,21 @@
+#  SPDX-License-Identifier: BSD-3-Clause
+#  Copyright (C) 2026 SPDK contributors.
+#  All rights reserved.
+
+
+def metrics_server_start(client, port, address=None):
+    """Start serving the metrics in the OpenMetrics format over HTTP.
+
+    Args:
+        port: port to listen on.
+        address: address to listen on (default: 127.0.0.1).
+    """
+    params = {'port': port}
+    if address:
+        params['address'] = address
+    return client.call('metrics_server_start', params)
+
+
+def metrics_server_stop(client):
+    """Stop serving the metrics."""
+    return client.call('metrics_server_stop')
@@ -119,10 +119,14 @@ def nvmf_create_transport(client, **params):
         acceptor_backlog: Pending connections allowed at one time - RDMA specific (optional)
         abort_timeout_sec: Abort execution timeout value, in seconds (optional)
         no_wr_batching: Boolean flag to disable work requests batching - RDMA specific (optional)
+        numa_aware_placement: Place I/O qpairs on poll groups local to their device - RDMA specific (optional)
         control_msg_num: The number of control messages per poll group - TCP specific (optional)
+        in_capsule_buf_num: The number of in-capsule data buffers per queue pair - TCP specific (optional)
+        pdu_coalesce_size: Max size of the PDUs coalesced into a single send - TCP specific (optional)
         disable_mappable_bar0: disable client mmap() of BAR0 - VFIO-USER specific (optional)
         disable_adaptive_irq: Disable adaptive interrupt feature - VFIO-USER specific (optional)
         disable_shadow_doorbells: disable shadow doorbell support - VFIO-USER specific (optional)
+        enable_adaptive_sq_polling: Stop polling idle SQs until their BAR0 doorbell is written - VFIO-USER specific (optional)
         acceptor_poll_rate: Acceptor poll period in microseconds (optional)
     Returns:
         True or False
@@ -156,11 +160,14 @@ def nvmf_get_transports(client, trtype=None, tgt_name=None):
     return client.call('nvmf_get_transports', params)
 
 
-def nvmf_get_subsystems(client, nqn=None, tgt_name=None):
+def nvmf_get_subsystems(client, nqn=None, tgt_name=None, start_after=None, max_count=None, fields=None):
     """Get list of NVMe-oF subsystems.
     Args:
         nqn: Subsystem NQN (optional; if omitted, query all subsystems).
         tgt_name: name of the parent NVMe-oF target (optional).
+        start_after: only list the subsystems following the subsystem with this NQN (optional).
+        max_count: maximum number of subsystems to list (optional).
+        fields: list of keys to include in each subsystem object, "nqn" is always included (optional).
 
     Returns:
         List of NVMe-oF subsystem objects.
@@ -174,6 +181,15 @@ def nvmf_get_subsystems(client, nqn=None, tgt_name=None):
     if nqn:
         params['nqn'] = nqn
 
+    if start_after:
+        params['start_after'] = start_after
+
+    if max_count:
+        params['max_count'] = max_count
+
+    if fields:
+        params['fields'] = fields
+
     return client.call('nvmf_get_subsystems', params)
 
 
@@ -246,6 +262,7 @@ def nvmf_subsystem_add_listener(client, **params):
         trsvcid: Transport service ID (required for RDMA or TCP).
         tgt_name: name of the parent NVMe-oF target (optional).
         adrfam: Address family ("IPv4", "IPv6", "IB", or "FC").
+        in_capsule_data_size: In-capsule data size of the connections of the listener, RDMA only (optional).
 
     Returns:
         True or False
@@ -423,6 +440,40 @@ def nvmf_subsystem_remove_ns(client, nqn, nsid, tgt_name=None):
     return client.call('nvmf_subsystem_remove_ns', params)
 
 
+def nvmf_subsystem_ns_set_qos_limit(client, nqn, nsid, tgt_name=None, rw_ios_per_sec=None,
+                                    rw_mbytes_per_sec=None, r_mbytes_per_sec=None,
+                                    w_mbytes_per_sec=None):
+    """Set QoS rate limits on a namespace, shared by all the hosts.
+
+    Args:
+        nqn: Subsystem NQN.
+        nsid: Namespace ID.
+        tgt_name: name of the parent NVMe-oF target (optional).
+        rw_ios_per_sec: R/W IOs per second limit. 0 means unlimited.
+        rw_mbytes_per_sec: R/W megabytes per second limit. 0 means unlimited.
+        r_mbytes_per_sec: Read megabytes per second limit. 0 means unlimited.
+        w_mbytes_per_sec: Write megabytes per second limit. 0 means unlimited.
+
+    Returns:
+        True or False
+    """
+    params = {'nqn': nqn,
+              'nsid': nsid}
+
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+    if rw_ios_per_sec is not None:
+        params['rw_ios_per_sec'] = rw_ios_per_sec
+    if rw_mbytes_per_sec is not None:
+        params['rw_mbytes_per_sec'] = rw_mbytes_per_sec
+    if r_mbytes_per_sec is not None:
+        params['r_mbytes_per_sec'] = r_mbytes_per_sec
+    if w_mbytes_per_sec is not None:
+        params['w_mbytes_per_sec'] = w_mbytes_per_sec
+
+    return client.call('nvmf_subsystem_ns_set_qos_limit', params)
+
+
 def nvmf_subsystem_add_host(client, nqn, host, tgt_name=None):
     """Add a host NQN to the list of allowed hosts.
 
@@ -554,6 +605,24 @@ def nvmf_subsystem_get_listeners(client, nqn, tgt_name=None):
     return client.call('nvmf_subsystem_get_listeners', params)
 
 
+def nvmf_subsystem_get_io_stats(client, nqn, tgt_name=None):
+    """Get the IO accounting of an NVMe-oF subsystem, per namespace and per host.
+
+    Args:
+        nqn: Subsystem NQN.
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        IO statistics of the namespaces and the hosts of an NVMe-oF subsystem.
+    """
+    params = {'nqn': nqn}
+
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_subsystem_get_io_stats', params)
+
+
 def nvmf_get_stats(client, tgt_name=None):
     """Query NVMf statistics.
 
@@ -574,6 +643,24 @@ def nvmf_get_stats(client, tgt_name=None):
     return client.call('nvmf_get_stats', params)
 
 
+def nvmf_rebalance_qpairs(client, tgt_name=None):
+    """Move an I/O qpair from the most to the least loaded poll group.
+
+    Args:
+        tgt_name: name of the parent NVMe-oF target (optional).
+
+    Returns:
+        The number of moved qpairs.
+    """
+
+    params = {}
+
+    if tgt_name:
+        params['tgt_name'] = tgt_name
+
+    return client.call('nvmf_rebalance_qpairs', params)
+
+
 def nvmf_set_crdt(client, crdt1=None, crdt2=None, crdt3=None):
     """Set the 3 crdt (Command Retry Delay Time) values
 
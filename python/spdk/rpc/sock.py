@@ -29,7 +29,10 @@ def sock_impl_set_options(client,
                           tls_version=None,
                           enable_ktls=None,
                           psk_key=None,
-                          psk_identity=None):
+                          psk_identity=None,
+                          enable_recv_multishot=None,
+                          busy_poll_usecs=None,
+                          enable_prefer_busy_poll=None):
     """Set parameters for the socket layer implementation.
 
     Args:
@@ -46,6 +49,9 @@ def sock_impl_set_options(client,
         enable_ktls: enable or disable Kernel TLS (optional)
         psk_key: set psk_key (optional)
         psk_identity: set psk_identity (optional)
+        enable_recv_multishot: enable or disable multishot receive (optional)
+        busy_poll_usecs: time to busy poll the device queues on receive in microseconds, 0 to disable (optional)
+        enable_prefer_busy_poll: enable or disable preferred busy polling (optional)
     """
     params = {}
 
@@ -74,6 +80,12 @@ def sock_impl_set_options(client,
         params['psk_key'] = psk_key
     if psk_identity is not None:
         params['psk_identity'] = psk_identity
+    if enable_recv_multishot is not None:
+        params['enable_recv_multishot'] = enable_recv_multishot
+    if busy_poll_usecs is not None:
+        params['busy_poll_usecs'] = busy_poll_usecs
+    if enable_prefer_busy_poll is not None:
+        params['enable_prefer_busy_poll'] = enable_prefer_busy_poll
 
     return client.call('sock_impl_set_options', params)
 
@@ -47,6 +47,17 @@ def trace_clear_tpoint_mask(client, name, tpoint_mask):
     return client.call('trace_clear_tpoint_mask', params)
 
 
+def trace_set_sample_rate(client, name, rate):
+    """Set the sample rate of a specific tpoint group.
+
+    Args:
+        name: trace group name (for example "bdev") or "all".
+        rate: trace one out of every rate objects (0 or 1 traces all objects).
+    """
+    params = {'name': name, 'rate': rate}
+    return client.call('trace_set_sample_rate', params)
+
+
 def trace_get_tpoint_group_mask(client):
     """Get trace point group mask
 
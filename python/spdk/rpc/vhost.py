@@ -100,6 +100,7 @@ def vhost_create_blk_controller(client, **params):
         readonly: set controller as read-only
         packed_ring: support controller packed_ring
         packed_ring_recovery: enable packed ring live recovery
+        vq_threads: number of threads polling the virtqueues of a session (default: 1)
     """
     strip_globals(params)
     remove_null(params)
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+#  SPDX-License-Identifier: BSD-3-Clause
+#  Copyright (C) 2026 SPDK contributors.
+#  All rights reserved.
+#
+
+# Converts the bdev I/O recorded by SPDK tracepoints (JSON output of `spdk_trace -j`) into a trace
+# that can be replayed by bdevperf's replay workload (-w replay -I <trace>).
+
+from argparse import ArgumentParser
+import json
+import sys
+
+# enum spdk_bdev_io_type
+IO_TYPES = {1: 'read', 2: 'write', 3: 'unmap', 4: 'flush', 9: 'write_zeroes'}
+
+
+def convert(trace, bdev, block_size, output):
+    tpoint = next((t for t in trace['tpoints'] if t['name'] == 'BDEV_IO_START'), None)
+    if tpoint is None:
+        raise ValueError('Trace doesn\'t contain the BDEV_IO_START tracepoint')
+
+    names = [a['name'] for a in tpoint['args']]
+    tsc_rate, start_tsc = trace['tsc_rate'], None
+    count = 0
+
+    output.write('# time(us) type offset length\n')
+    for entry in trace['entries']:
+        if entry['tpoint'] != tpoint['id']:
+            continue
+        args = dict(zip(names, entry['args']))
+        if bdev is not None and args['name'] != bdev:
+            continue
+        io_type = IO_TYPES.get(args['type'])
+        if io_type is None:
+            continue
+        if start_tsc is None:
+            start_tsc = entry['tsc']
+        time = (entry['tsc'] - start_tsc) * 1000 * 1000 / tsc_rate
+        output.write(f'{time:.3f} {io_type} {args["offset"] * block_size} {args["len"] * block_size}\n')
+        count += 1
+
+    return count
+
+
+def main(argv):
+    parser = ArgumentParser(description='Convert SPDK bdev traces into bdevperf replay traces')
+    parser.add_argument('-i', '--input', help='JSON trace generated by spdk_trace -j (default: stdin)')
+    parser.add_argument('-o', '--output', help='Output file (default: stdout)')
+    parser.add_argument('-b', '--bdev', help='Only convert the I/O submitted to this bdev. Recommended '
+                        'with stacked bdevs, as their I/O is traced at each layer')
+    parser.add_argument('-s', '--block-size', help='Block size of the traced bdev', type=int, default=512)
+    args = parser.parse_args(argv)
+
+    with open(args.input, 'r') if args.input is not None else sys.stdin as input:
+        trace = json.load(input)
+    with open(args.output, 'w') if args.output is not None else sys.stdout as output:
+        count = convert(trace, args.bdev, args.block_size, output)
+
+    print(f'Converted {count} I/Os', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    try:
+        main(sys.argv[1:])
+    except (KeyboardInterrupt, BrokenPipeError):
+        pass
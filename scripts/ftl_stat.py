@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+#  SPDX-License-Identifier: BSD-3-Clause
+#  Copyright (C) 2026 SPDK contributors.
+#  All rights reserved.
+#
+
+import argparse
+import logging
+import os
+import sys
+import time
+
+sys.path.append(os.path.dirname(__file__) + '/../python')
+
+import spdk.rpc as rpc  # noqa
+
+
+# Statistics groups of bdev_ftl_get_stats counting the writes done by FTL itself, on top of the
+# user writes, to the NV cache and to the base device
+FTL_NV_CACHE_WRITE_GROUPS = ['user', 'md_nv_cache']
+FTL_BASE_WRITE_GROUPS = ['cmp', 'gc', 'md_base', 'l2p']
+
+FTL_STAT_HEAD = ['time', 'user_MB/s', 'media_MB/s', 'WAF', 'base_WAF', 'cmp_MB/s', 'gc_MB/s',
+                 'gc_bands', 'valid/band', 'l2p_hit', 'cmp_chunks/s', 'free_chunks']
+
+
+def check_positive(value):
+    v = int(value)
+    if v <= 0:
+        raise argparse.ArgumentTypeError("%s should be positive int value" % v)
+    return v
+
+
+def written(stats, groups):
+    return sum(stats[group]['write']['blocks'] for group in groups)
+
+
+def ratio(num, den):
+    return "{:.3f}".format(num / den) if den else "N/A"
+
+
+def ftl_stat_format(stats, last, seconds, block_size):
+    def delta(get):
+        return get(stats) - get(last)
+
+    def mbps(blocks):
+        return "{:.2f}".format(blocks * block_size / seconds / (1024 * 1024))
+
+    user = delta(lambda s: s['user']['write']['blocks'])
+    cmp = delta(lambda s: s['cmp']['write']['blocks'])
+    gc = delta(lambda s: s['gc']['write']['blocks'])
+    media = delta(lambda s: written(s, FTL_NV_CACHE_WRITE_GROUPS + FTL_BASE_WRITE_GROUPS))
+    base = delta(lambda s: written(s, FTL_BASE_WRITE_GROUPS))
+    gc_bands = delta(lambda s: s['gc_bands']['count'])
+    gc_valid = delta(lambda s: s['gc_bands']['valid_blocks'])
+    hits = delta(lambda s: s['l2p_cache']['hits'])
+    misses = delta(lambda s: s['l2p_cache']['misses'])
+    compacted = delta(lambda s: s['nv_cache']['compacted_chunks'])
+
+    return [
+        time.strftime("%H:%M:%S"),
+        mbps(user),
+        mbps(media),
+        ratio(media, user),
+        ratio(base, cmp),
+        mbps(cmp),
+        mbps(gc),
+        str(gc_bands),
+        # Blocks GC had to move to reclaim a band, on average
+        "{:.0f}".format(gc_valid / gc_bands) if gc_bands else "N/A",
+        "{:.2%}".format(hits / (hits + misses)) if hits + misses else "N/A",
+        "{:.2f}".format(compacted / seconds),
+        "{}/{}".format(stats['nv_cache']['free_chunks'], stats['nv_cache']['chunks']),
+    ]
+
+
+def ftl_stat_print(rows, head, print_head):
+    widths = [max(len(row[i]) for row in rows + [head]) for i in range(len(head))]
+    if print_head:
+        print(" ".join(h.rjust(w) for h, w in zip(head, widths)))
+    for row in rows:
+        print(" ".join(v.rjust(w) for v, w in zip(row, widths)))
+    sys.stdout.flush()
+
+
+def ftl_stat_loop(args):
+    client = rpc.client.JSONRPCClient(
+        args.server_addr, args.port, args.timeout, log_level=getattr(logging, args.verbose.upper()))
+
+    block_size = rpc.bdev.bdev_get_bdevs(client, name=args.name)[0]['block_size']
+    last = rpc.bdev.bdev_ftl_get_stats(client, name=args.name)
+    last_time = time.monotonic()
+    count = 0
+
+    while args.count == 0 or count < args.count:
+        time.sleep(args.interval)
+        stats = rpc.bdev.bdev_ftl_get_stats(client, name=args.name)
+        now = time.monotonic()
+
+        row = ftl_stat_format(stats, last, now - last_time, block_size)
+        ftl_stat_print([row], FTL_STAT_HEAD, count % args.header_interval == 0)
+
+        last, last_time = stats, now
+        count += 1
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description='Periodically report the write amplification, GC, L2P cache and NV cache '
+                    'compaction statistics of an FTL bdev. Meant to be run alongside a workload, '
+                    'e.g. bdevperf, in order to size the overprovisioning and the NV cache.')
+
+    parser.add_argument('-b', '--name', dest='name', required=True,
+                        help="Name of the FTL bdev. Example: ftl0")
+
+    parser.add_argument('-i', '--interval', dest='interval',
+                        type=check_positive, default=1,
+                        help='Time interval (in seconds) between two samples')
+
+    parser.add_argument('-c', '--count', dest='count',
+                        type=check_positive, default=0,
+                        help='Number of samples to report before returning. Default: unlimited')
+
+    parser.add_argument('-H', '--header-interval', dest='header_interval',
+                        type=check_positive, default=20,
+                        help='Number of samples between two headers')
+
+    parser.add_argument('-s', "--server", dest='server_addr',
+                        help='RPC domain socket path or IP address',
+                        default='/var/tmp/spdk.sock')
+
+    parser.add_argument('-p', "--port", dest='port',
+                        help='RPC port number (if server_addr is IP address)',
+                        default=4420, type=int)
+
+    parser.add_argument('-o', '--timeout', dest='timeout',
+                        help='Timeout as a floating point number expressed in seconds \
+                        waiting for response. Default: 60.0',
+                        default=60.0, type=float)
+
+    parser.add_argument('-v', dest='verbose', action='store_const', const="INFO",
+                        help='Set verbose mode to INFO', default="ERROR")
+
+    args = parser.parse_args()
+
+    try:
+        ftl_stat_loop(args)
+    except KeyboardInterrupt:
+        pass
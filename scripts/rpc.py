@@ -161,13 +161,36 @@ if __name__ == "__main__":
         'framework_get_reactors', help='Display list of all reactors')
     p.set_defaults(func=framework_get_reactors)
 
+    def framework_set_reactor_event_opts(args):
+        print_json(rpc.app.framework_set_reactor_event_opts(args.client,
+                                                            lcore=args.lcore,
+                                                            batch_size=args.batch_size,
+                                                            policy=args.policy))
+
+    p = subparsers.add_parser(
+        'framework_set_reactor_event_opts', help='Set how reactors execute their events')
+    p.add_argument('-c', '--lcore', help='Core of the reactor to update, all reactors if omitted', type=int)
+    p.add_argument('-b', '--batch-size', help='Maximum number of events executed at once', type=int)
+    p.add_argument('-p', '--policy', help='Execute one batch per reactor iteration or drain all queued events',
+                   choices=['batch', 'drain'])
+    p.set_defaults(func=framework_set_reactor_event_opts)
+
     def framework_set_scheduler(args):
         rpc.app.framework_set_scheduler(args.client,
                                         name=args.name,
                                         period=args.period,
                                         load_limit=args.load_limit,
                                         core_limit=args.core_limit,
-                                        core_busy=args.core_busy)
+                                        core_busy=args.core_busy,
+                                        numa_penalty=args.numa_penalty,
+                                        smoothing=args.smoothing,
+                                        trend_smoothing=args.trend_smoothing,
+                                        horizon=args.horizon,
+                                        migration_cost=args.migration_cost,
+                                        latency_target_us=args.latency_target_us,
+                                        latency_percentile=args.latency_percentile,
+                                        latency_high=args.latency_high,
+                                        latency_low=args.latency_low)
 
     p = subparsers.add_parser(
         'framework_set_scheduler', help='Select thread scheduler that will be activated and its period (experimental)')
@@ -176,6 +199,24 @@ if __name__ == "__main__":
     p.add_argument('--load-limit', help="Scheduler load limit. Reserved for dynamic scheduler", type=int, required=False)
     p.add_argument('--core-limit', help="Scheduler core limit. Reserved for dynamic scheduler", type=int, required=False)
     p.add_argument('--core-busy', help="Scheduler core busy limit. Reserved for dynamic schedler", type=int, required=False)
+    p.add_argument('--numa-penalty', help="Scheduler cross-socket migration penalty in %%. Reserved for dynamic scheduler",
+                   type=int, required=False)
+    p.add_argument('--smoothing', help="Weight in %% of the last period in the load average. Reserved for predictive scheduler",
+                   type=int, required=False)
+    p.add_argument('--trend-smoothing', help="Weight in %% of the last period in the load trend. Reserved for predictive scheduler",
+                   type=int, required=False)
+    p.add_argument('--horizon', help="Number of periods to forecast the load for. Reserved for predictive scheduler",
+                   type=int, required=False)
+    p.add_argument('--migration-cost', help="Minimal gain in %% required to move a thread. Reserved for predictive scheduler",
+                   type=int, required=False)
+    p.add_argument('--latency-target-us', help="I/O latency target of each core in microseconds. Reserved for gscheduler",
+                   type=int, required=False)
+    p.add_argument('--latency-percentile', help="Percentile of the I/O latency compared to the target. Reserved for gscheduler",
+                   type=int, required=False)
+    p.add_argument('--latency-high', help="Latency in %% of the target above which frequency is raised. Reserved for gscheduler",
+                   type=int, required=False)
+    p.add_argument('--latency-low', help="Latency in %% of the target below which frequency is lowered. Reserved for gscheduler",
+                   type=int, required=False)
     p.set_defaults(func=framework_set_scheduler)
 
     def framework_get_scheduler(args):
@@ -185,6 +226,13 @@ if __name__ == "__main__":
         'framework_get_scheduler', help='Display currently set scheduler and its properties.')
     p.set_defaults(func=framework_get_scheduler)
 
+    def scheduler_predictive_get_decisions(args):
+        print_dict(rpc.app.scheduler_predictive_get_decisions(args.client))
+
+    p = subparsers.add_parser(
+        'scheduler_predictive_get_decisions', help='Display load forecasts and recent decisions of the predictive scheduler.')
+    p.set_defaults(func=scheduler_predictive_get_decisions)
+
     def framework_disable_cpumask_locks(args):
         rpc.framework_disable_cpumask_locks(args.client)
 
@@ -206,7 +254,9 @@ if __name__ == "__main__":
                                   bdev_io_cache_size=args.bdev_io_cache_size,
                                   bdev_auto_examine=args.bdev_auto_examine,
                                   small_buf_pool_size=args.small_buf_pool_size,
-                                  large_buf_pool_size=args.large_buf_pool_size)
+                                  large_buf_pool_size=args.large_buf_pool_size,
+                                  accel_copy_threshold=args.accel_copy_threshold,
+                                  examine_queue_depth=args.examine_queue_depth)
 
     p = subparsers.add_parser('bdev_set_options',
                               help="""Set options of bdev subsystem""")
@@ -214,6 +264,10 @@ if __name__ == "__main__":
     p.add_argument('-c', '--bdev-io-cache-size', help='Maximum number of bdev_io structures cached per thread', type=int)
     p.add_argument('-s', '--small-buf-pool-size', help='Maximum number of small buf (i.e., 8KB) pool size', type=int)
     p.add_argument('-l', '--large-buf-pool-size', help='Maximum number of large buf (i.e., 64KB) pool size', type=int)
+    p.add_argument('-a', '--accel-copy-threshold', help="""Minimum size in bytes of a bounce buffer copy
+    offloaded to the accel framework, 0 to disable""", type=int)
+    p.add_argument('-q', '--examine-queue-depth', help="""Maximum number of bdevs examined at a time,
+    0 for no limit""", type=int)
     group = p.add_mutually_exclusive_group()
     group.add_argument('-e', '--enable-auto-examine', dest='bdev_auto_examine', help='Allow to auto examine', action='store_true')
     group.add_argument('-d', '--disable-auto-examine', dest='bdev_auto_examine', help='Not allow to auto examine', action='store_false')
@@ -244,7 +298,7 @@ if __name__ == "__main__":
 
     p = subparsers.add_parser('bdev_compress_create', help='Add a compress vbdev')
     p.add_argument('-b', '--base-bdev-name', help="Name of the base bdev")
-    p.add_argument('-p', '--pm-path', help="Path to persistent memory")
+    p.add_argument('-p', '--pm-path', help="Path to persistent memory (optional, keep the metadata on the base bdev if omitted)")
     p.add_argument('-l', '--lb-size', help="Compressed vol logical block size (optional, if used must be 512 or 4096)", type=int)
     p.set_defaults(func=bdev_compress_create)
 
@@ -297,7 +351,8 @@ if __name__ == "__main__":
                                             mode=args.mode,
                                             cache_line_size=args.cache_line_size,
                                             cache_bdev_name=args.cache_bdev_name,
-                                            core_bdev_name=args.core_bdev_name))
+                                            core_bdev_name=args.core_bdev_name,
+                                            cleaner_cpumask=args.cleaner_cpumask))
     p = subparsers.add_parser('bdev_ocf_create', help='Add an OCF block device')
     p.add_argument('name', help='Name of resulting OCF bdev')
     p.add_argument('mode', help='OCF cache mode', choices=['wb', 'wt', 'pt', 'wa', 'wi', 'wo'])
@@ -310,6 +365,8 @@ if __name__ == "__main__":
     )
     p.add_argument('cache_bdev_name', help='Name of underlying cache bdev')
     p.add_argument('core_bdev_name', help='Name of underlying core bdev')
+    p.add_argument('--cleaner-cpumask', help="""Cpumask of the thread running the cache cleaner
+    (default: the cleaner runs on the management thread)""", required=False)
     p.set_defaults(func=bdev_ocf_create)
 
     def bdev_ocf_delete(args):
@@ -394,7 +451,9 @@ if __name__ == "__main__":
                                                md_size=args.md_size,
                                                md_interleave=args.md_interleave,
                                                dif_type=args.dif_type,
-                                               dif_is_head_of_md=args.dif_is_head_of_md))
+                                               dif_is_head_of_md=args.dif_is_head_of_md,
+                                               numa_id=args.numa_id,
+                                               numa_stripe_blocks=args.numa_stripe_blocks))
     p = subparsers.add_parser('bdev_malloc_create', help='Create a bdev with malloc backend')
     p.add_argument('-b', '--name', help="Name of the bdev")
     p.add_argument('-u', '--uuid', help="UUID of the bdev")
@@ -413,6 +472,11 @@ if __name__ == "__main__":
                         'to be set along --dif-type. Default=0 - no protection.')
     p.add_argument('-d', '--dif-is-head-of-md', action='store_true',
                    help='Protection information is in the first 8 bytes of metadata. Default=false.')
+    p.add_argument('-n', '--numa-id', type=int,
+                   help='NUMA node to allocate the memory on. Default=-1 - any node.')
+    p.add_argument('-s', '--numa-stripe-blocks', type=int,
+                   help="""Stripe the memory across the NUMA nodes of the application's cores in chunks
+                   of this many blocks (must be a multiple of 2MiB). Default=0 - no striping.""")
     p.set_defaults(func=bdev_malloc_create)
 
     def bdev_malloc_delete(args):
@@ -503,6 +567,24 @@ if __name__ == "__main__":
     p.add_argument('name', help='aio bdev name')
     p.set_defaults(func=bdev_aio_delete)
 
+    def bdev_uring_set_options(args):
+        rpc.bdev.bdev_uring_set_options(args.client,
+                                        sqpoll=args.sqpoll,
+                                        sqpoll_idle_ms=args.sqpoll_idle_ms,
+                                        iopoll=args.iopoll,
+                                        fixed_files=args.fixed_files)
+
+    p = subparsers.add_parser('bdev_uring_set_options', help='Set options for the bdev uring type.')
+    p.add_argument('--sqpoll', action='store_true', default=None,
+                   help='Use a kernel thread shared by all rings to poll the submission queues')
+    p.add_argument('--sqpoll-idle-ms', type=int,
+                   help='Time after which an idle kernel submission thread goes to sleep')
+    p.add_argument('--iopoll', action='store_true', default=None,
+                   help='Poll for completions instead of using interrupts (requires O_DIRECT)')
+    p.add_argument('--fixed-files', action='store_true', default=None,
+                   help='Register the files of the bdevs with the rings')
+    p.set_defaults(func=bdev_uring_set_options)
+
     def bdev_uring_create(args):
         print_json(rpc.bdev.bdev_uring_create(args.client,
                                               filename=args.filename,
@@ -527,13 +609,19 @@ if __name__ == "__main__":
         print_json(rpc.bdev.bdev_xnvme_create(args.client,
                                               filename=args.filename,
                                               name=args.name,
-                                              io_mechanism=args.io_mechanism))
+                                              io_mechanism=args.io_mechanism,
+                                              conserve_cpu=args.conserve_cpu,
+                                              io_poll=args.io_poll,
+                                              queue_depth=args.queue_depth))
 
     p = subparsers.add_parser('bdev_xnvme_create', help='Create a bdev with xNVMe backend')
     p.add_argument('filename', help='Path to device or file (ex: /dev/nvme0n1)')
     p.add_argument('name', help='name of xNVMe bdev to create')
     p.add_argument('io_mechanism', help='IO mechanism to use (ex: libaio, io_uring, io_uring_cmd, etc.)')
-    p.add_argument('conserve_cpu', action='store_true', help='Whether or not to conserve CPU when polling')
+    p.add_argument('-c', '--conserve-cpu', action='store_true', help='Whether or not to conserve CPU when polling')
+    p.add_argument('-p', '--io-poll', action='store_true',
+                   help='Poll for completions, also with io_uring_cmd (needs nvme poll queues)')
+    p.add_argument('-q', '--queue-depth', type=int, help='Depth of the queue of each I/O channel (default: 512)')
     p.set_defaults(func=bdev_xnvme_create)
 
     def bdev_xnvme_delete(args):
@@ -570,7 +658,16 @@ if __name__ == "__main__":
                                        transport_tos=args.transport_tos,
                                        nvme_error_stat=args.nvme_error_stat,
                                        rdma_srq_size=args.rdma_srq_size,
-                                       io_path_stat=args.io_path_stat)
+                                       io_path_stat=args.io_path_stat,
+                                       bdev_retry_budget_percent=args.bdev_retry_budget_percent,
+                                       adaptive_timeout_multiplier=args.adaptive_timeout_multiplier,
+                                       hedged_read_percentile=args.hedged_read_percentile,
+                                       delay_cmd_submit_batch_size=args.delay_cmd_submit_batch_size,
+                                       nvme_ioq_adaptive_poll_max_us=args.nvme_ioq_adaptive_poll_max_us,
+                                       nvme_ioq_adaptive_poll_batch=args.nvme_ioq_adaptive_poll_batch,
+                                       rdma_send_signal_interval=args.rdma_send_signal_interval,
+                                       align_write_splits=args.align_write_splits,
+                                       io_qpairs_per_ctrlr=args.io_qpairs_per_ctrlr)
 
     p = subparsers.add_parser('bdev_nvme_set_options',
                               help='Set options for the bdev nvme type. This is startup command.')
@@ -601,6 +698,9 @@ if __name__ == "__main__":
     p.add_argument('-d', '--disable-delay-cmd-submit',
                    help='Disable delaying NVMe command submission, i.e. no batching of multiple commands',
                    action='store_false', dest='delay_cmd_submit')
+    p.add_argument('--delay-cmd-submit-batch-size',
+                   help='With delayed command submission, ring the doorbell as soon as this many commands are delayed. 0 means no limit.',
+                   type=int)
     p.add_argument('-c', '--transport-retry-count',
                    help='the number of attempts per I/O in the transport layer when an I/O fails.', type=int)
     p.add_argument('-r', '--bdev-retry-count',
@@ -648,6 +748,30 @@ if __name__ == "__main__":
     p.add_argument('--io-path-stat',
                    help="""Enable collecting I/O path stat of each io path.""",
                    action='store_true')
+    p.add_argument('--bdev-retry-budget-percent',
+                   help="""Limit the retries on a path to this percentage of its successful I/Os.
+                   0 means no limit.""", type=int)
+    p.add_argument('--adaptive-timeout-multiplier',
+                   help="""Set the I/O timeout of each controller to its p99 latency times this value,
+                   with timeout_us as the upper bound. 0 means disabled.""", type=int)
+    p.add_argument('--hedged-read-percentile',
+                   help="""In active-active mode, duplicate a read on another path if it is slower than
+                   this percentile of the recent reads. 0 means disabled.""", type=int)
+    p.add_argument('--nvme-ioq-adaptive-poll-max-us',
+                   help="""Under low load, stretch the I/O poll period up to this value in microseconds.
+                   0 means disabled.""", type=int)
+    p.add_argument('--nvme-ioq-adaptive-poll-batch',
+                   help='The number of completions to reap per poll with the adaptive I/O poll period.',
+                   type=int)
+    p.add_argument('--rdma-send-signal-interval',
+                   help="""Only request a completion for one out of this many sends of an RDMA qpair.
+                   Default: 0 (all sends are signaled)""", type=int)
+    p.add_argument('--align-write-splits',
+                   help="""Align the splits of writes to the optimal write size or write granularity
+                   of the namespace.""", action='store_true')
+    p.add_argument('--io-qpairs-per-ctrlr',
+                   help="""Number of I/O qpairs each I/O channel creates for each controller. I/Os are
+                   spread across them by queue depth. Default: 1""", type=int)
 
     p.set_defaults(func=bdev_nvme_set_options)
 
@@ -684,7 +808,8 @@ if __name__ == "__main__":
                                                          reconnect_delay_sec=args.reconnect_delay_sec,
                                                          fast_io_fail_timeout_sec=args.fast_io_fail_timeout_sec,
                                                          psk=args.psk,
-                                                         max_bdevs=args.max_bdevs))
+                                                         max_bdevs=args.max_bdevs,
+                                                         use_cmb_sqs=args.use_cmb_sqs))
 
     p = subparsers.add_parser('bdev_nvme_attach_controller', help='Add bdevs with nvme backend')
     p.add_argument('-b', '--name', help="Name of the NVMe controller, prefix for each bdev name", required=True)
@@ -739,6 +864,8 @@ if __name__ == "__main__":
                    help='Set PSK and enable TCP SSL socket implementation: e.g., 1234567890ABCDEF')
     p.add_argument('-m', '--max-bdevs', type=int,
                    help='The size of the name array for newly created bdevs. Default is 128',)
+    p.add_argument('--use-cmb-sqs', action='store_true',
+                   help='Place the submission queues in the controller memory buffer. PCIe only.')
 
     p.set_defaults(func=bdev_nvme_attach_controller)
 
@@ -883,7 +1010,7 @@ if __name__ == "__main__":
                               help="""Set multipath policy of the NVMe bdev""")
     p.add_argument('-b', '--name', help='Name of the NVMe bdev', required=True)
     p.add_argument('-p', '--policy', help='Multipath policy (active_passive or active_active)', required=True)
-    p.add_argument('-s', '--selector', help='Multipath selector (round_robin, queue_depth)', required=False)
+    p.add_argument('-s', '--selector', help='Multipath selector (round_robin, queue_depth, latency)', required=False)
     p.add_argument('-r', '--rr-min-io',
                    help='Number of IO to route to a path before switching to another for round-robin',
                    type=int, required=False)
@@ -1001,7 +1128,8 @@ if __name__ == "__main__":
                                             rbd_name=args.rbd_name,
                                             block_size=args.block_size,
                                             cluster_name=args.cluster_name,
-                                            uuid=args.uuid))
+                                            uuid=args.uuid,
+                                            num_contexts=args.num_contexts))
 
     p = subparsers.add_parser('bdev_rbd_create', help='Add a bdev with ceph rbd backend')
     p.add_argument('-b', '--name', help="Name of the bdev", required=False)
@@ -1013,6 +1141,8 @@ if __name__ == "__main__":
     p.add_argument('block_size', help='rbd block size', type=int)
     p.add_argument('-c', '--cluster-name', help="cluster name to identify the Rados cluster", required=False)
     p.add_argument('-u', '--uuid', help="UUID of the bdev")
+    p.add_argument('-n', '--num-contexts', help="""Number of image handles the I/O channels of the bdev are
+    spread across (default: 1)""", type=int)
     p.set_defaults(func=bdev_rbd_create)
 
     def bdev_rbd_delete(args):
@@ -1042,7 +1172,10 @@ if __name__ == "__main__":
                                               avg_read_latency=args.avg_read_latency,
                                               p99_read_latency=args.nine_nine_read_latency,
                                               avg_write_latency=args.avg_write_latency,
-                                              p99_write_latency=args.nine_nine_write_latency))
+                                              p99_write_latency=args.nine_nine_write_latency,
+                                              latency_distribution=args.latency_distribution,
+                                              stall_period_us=args.stall_period_us,
+                                              stall_duration_us=args.stall_duration_us))
 
     p = subparsers.add_parser('bdev_delay_create',
                               help='Add a delay bdev on existing bdev')
@@ -1057,6 +1190,11 @@ if __name__ == "__main__":
                    help="Average latency to apply before completing write ops (in microseconds)", required=True, type=int)
     p.add_argument('-n', '--nine-nine-write-latency',
                    help="latency to apply to 1 in 100 write ops (in microseconds)", required=True, type=int)
+    p.add_argument('-D', '--latency-distribution', help="""Distribution of the latencies: bimodal (default)
+    or lognormal, with the average latency as median""", choices=['bimodal', 'lognormal'])
+    p.add_argument('-P', '--stall-period-us', help="Period of the injected stalls (in microseconds)", type=int)
+    p.add_argument('-S', '--stall-duration-us',
+                   help="Duration of the stalls injected every period (in microseconds), 0 to disable", type=int)
     p.set_defaults(func=bdev_delay_create)
 
     def bdev_delay_delete(args):
@@ -1148,7 +1286,10 @@ if __name__ == "__main__":
 
     def bdev_get_bdevs(args):
         print_dict(rpc.bdev.bdev_get_bdevs(args.client,
-                                           name=args.name, timeout=args.timeout_ms))
+                                           name=args.name, timeout=args.timeout_ms,
+                                           start_after=args.start_after,
+                                           max_count=args.max_count,
+                                           fields=args.fields))
 
     p = subparsers.add_parser('bdev_get_bdevs',
                               help='Display current blockdev list or required blockdev')
@@ -1157,6 +1298,11 @@ if __name__ == "__main__":
     with the -b|--name option). The default timeout is 0, meaning the RPC returns immediately
     whether the bdev exists or not.""",
                    type=int, required=False)
+    p.add_argument('-a', '--start-after', help="""Only list the bdevs registered after this bdev, i.e.
+    the last bdev of the previous page""", required=False)
+    p.add_argument('-c', '--max-count', help='Maximum number of bdevs to list', type=int, required=False)
+    p.add_argument('-f', '--fields', help="""Keys to include in each bdev object, e.g.
+    -f num_blocks -f claimed. The name is always included.""", action='append', required=False)
     p.set_defaults(func=bdev_get_bdevs)
 
     def bdev_get_iostat(args):
@@ -1198,6 +1344,30 @@ if __name__ == "__main__":
     p.add_argument('name', help='bdev name')
     p.set_defaults(func=bdev_get_histogram)
 
+    def bdev_enable_type_histograms(args):
+        rpc.bdev.bdev_enable_type_histograms(args.client, name=args.name, enable=args.enable)
+
+    p = subparsers.add_parser('bdev_enable_type_histograms',
+                              help='Enable or disable histograms per I/O type and size for specified bdev')
+    p.add_argument('-e', '--enable', default=True, dest='enable', action='store_true', help='Enable histograms on specified device')
+    p.add_argument('-d', '--disable', dest='enable', action='store_false', help='Disable histograms on specified device')
+    p.add_argument('name', help='bdev name')
+    p.set_defaults(func=bdev_enable_type_histograms)
+
+    def bdev_get_type_histograms(args):
+        print_dict(rpc.bdev.bdev_get_type_histograms(args.client, name=args.name,
+                                                     per_channel=args.per_channel,
+                                                     reset=args.reset))
+
+    p = subparsers.add_parser('bdev_get_type_histograms',
+                              help='Get histograms per I/O type and size for specified bdev')
+    p.add_argument('name', help='bdev name')
+    p.add_argument('-c', '--per-channel', help='Display the histograms of each channel',
+                   action='store_true', default=None)
+    p.add_argument('-r', '--reset', help='Reset the histograms once they are read',
+                   action='store_true', default=None)
+    p.set_defaults(func=bdev_get_type_histograms)
+
     def bdev_set_qd_sampling_period(args):
         rpc.bdev.bdev_set_qd_sampling_period(args.client,
                                              name=args.name,
@@ -1217,7 +1387,8 @@ if __name__ == "__main__":
                                     rw_ios_per_sec=args.rw_ios_per_sec,
                                     rw_mbytes_per_sec=args.rw_mbytes_per_sec,
                                     r_mbytes_per_sec=args.r_mbytes_per_sec,
-                                    w_mbytes_per_sec=args.w_mbytes_per_sec)
+                                    w_mbytes_per_sec=args.w_mbytes_per_sec,
+                                    sharded=args.sharded)
 
     p = subparsers.add_parser('bdev_set_qos_limit',
                               help='Set QoS rate limit on a blockdev')
@@ -1234,8 +1405,40 @@ if __name__ == "__main__":
     p.add_argument('--w-mbytes-per-sec',
                    help="Write megabytes per second limit (>=10, example: 100). 0 means unlimited.",
                    type=int, required=False)
+    p.add_argument('--sharded', help='Enforce the rate limits on each channel instead of a single QoS thread',
+                   action='store_true', default=None)
     p.set_defaults(func=bdev_set_qos_limit)
 
+    def bdev_set_qos_latency_target(args):
+        rpc.bdev.bdev_set_qos_latency_target(args.client,
+                                             name=args.name,
+                                             group=args.group,
+                                             latency_target_us=args.latency_target_us)
+
+    p = subparsers.add_parser('bdev_set_qos_latency_target',
+                              help='Set latency QoS on a blockdev')
+    p.add_argument('name', help='Blockdev name. Example: Malloc0')
+    p.add_argument('-g', '--group', help='Latency group, omit to remove the blockdev from its group')
+    p.add_argument('-t', '--latency-target-us',
+                   help='p99 latency target in microseconds, 0 to throttle the blockdev on behalf of the others in the group',
+                   type=int, required=False)
+    p.set_defaults(func=bdev_set_qos_latency_target)
+
+    def bdev_set_io_coalescing(args):
+        rpc.bdev.bdev_set_io_coalescing(args.client,
+                                        name=args.name,
+                                        window_us=args.window_us,
+                                        max_blocks=args.max_blocks)
+
+    p = subparsers.add_parser('bdev_set_io_coalescing',
+                              help='Coalesce LBA-adjacent reads and writes on a blockdev')
+    p.add_argument('name', help='Blockdev name. Example: Malloc0')
+    p.add_argument('-w', '--window-us', help='Time window in microseconds, 0 to disable',
+                   type=int, required=True)
+    p.add_argument('-m', '--max-blocks', help='Maximum size in blocks of a coalesced I/O',
+                   type=int, required=False)
+    p.set_defaults(func=bdev_set_io_coalescing)
+
     def bdev_error_inject_error(args):
         rpc.bdev.bdev_error_inject_error(args.client,
                                          name=args.name,
@@ -1308,7 +1511,9 @@ if __name__ == "__main__":
             max_r2t_per_connection=args.max_r2t_per_connection,
             pdu_pool_size=args.pdu_pool_size,
             immediate_data_pool_size=args.immediate_data_pool_size,
-            data_out_pool_size=args.data_out_pool_size)
+            data_out_pool_size=args.data_out_pool_size,
+            conn_rebalance_interval=args.conn_rebalance_interval,
+            max_lun_tasks_per_initiator=args.max_lun_tasks_per_initiator)
 
     p = subparsers.add_parser('iscsi_set_options',
                               help="""Set options of iSCSI subsystem""")
@@ -1337,6 +1542,10 @@ if __name__ == "__main__":
     p.add_argument('-u', '--pdu-pool-size', help='Number of PDUs in the pool', type=int)
     p.add_argument('-j', '--immediate-data-pool-size', help='Number of immediate data buffers in the pool', type=int)
     p.add_argument('-z', '--data-out-pool-size', help='Number of data out buffers in the pool', type=int)
+    p.add_argument('--conn-rebalance-interval', help='Interval in seconds to move target nodes between poll groups based on their load, 0 to disable',
+                   type=int)
+    p.add_argument('--max-lun-tasks-per-initiator', help='Max number of outstanding tasks per initiator on each LUN, 0 for no limit',
+                   type=int)
     p.set_defaults(func=iscsi_set_options)
 
     def iscsi_set_discovery_auth(args):
@@ -1787,6 +1996,20 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p = subparsers.add_parser('scsi_get_devices', help='Display SCSI devices')
     p.set_defaults(func=scsi_get_devices)
 
+    def scsi_lun_attach_pr_store(args):
+        print_json(rpc.iscsi.scsi_lun_attach_pr_store(
+            args.client,
+            dev_name=args.dev_name,
+            lun_id=args.lun_id,
+            bdev_name=args.bdev_name))
+
+    p = subparsers.add_parser('scsi_lun_attach_pr_store',
+                              help='Keep persistent reservations of a SCSI LUN on a bdev')
+    p.add_argument('dev_name', help='SCSI device name')
+    p.add_argument('lun_id', help='LUN ID', type=int)
+    p.add_argument('bdev_name', help='Name of the bdev storing the reservation state')
+    p.set_defaults(func=scsi_lun_attach_pr_store)
+
     # trace
     def trace_enable_tpoint_group(args):
         rpc.trace.trace_enable_tpoint_group(args.client, name=args.name)
@@ -1836,6 +2059,18 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
         type=lambda m: int(m, 16))
     p.set_defaults(func=trace_clear_tpoint_mask)
 
+    def trace_set_sample_rate(args):
+        rpc.trace.trace_set_sample_rate(args.client, name=args.name, rate=args.rate)
+
+    p = subparsers.add_parser('trace_set_sample_rate',
+                              help='trace only one out of every N objects of a specific tpoint group')
+    p.add_argument(
+        'name', help="""trace group name (for example "bdev" for bdev trace group,
+        "all" for all trace groups).""")
+    p.add_argument('rate', help='trace one out of every RATE objects (0 or 1 traces all objects)',
+                   type=int)
+    p.set_defaults(func=trace_set_sample_rate)
+
     def trace_get_tpoint_group_mask(args):
         print_dict(rpc.trace.trace_get_tpoint_group_mask(args.client))
 
@@ -1849,6 +2084,22 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                               help='get name of shared memory file and list of the available trace point groups')
     p.set_defaults(func=trace_get_info)
 
+    # metrics
+    def metrics_server_start(args):
+        rpc.metrics.metrics_server_start(args.client, port=args.port, address=args.address)
+
+    p = subparsers.add_parser('metrics_server_start',
+                              help='start serving the metrics in the OpenMetrics format over HTTP')
+    p.add_argument('port', help='port to listen on', type=int)
+    p.add_argument('-a', '--address', help='address to listen on (default: 127.0.0.1)')
+    p.set_defaults(func=metrics_server_start)
+
+    def metrics_server_stop(args):
+        rpc.metrics.metrics_server_stop(args.client)
+
+    p = subparsers.add_parser('metrics_server_stop', help='stop serving the metrics')
+    p.set_defaults(func=metrics_server_stop)
+
     # log
     def log_set_flag(args):
         rpc.log.log_set_flag(args.client, flag=args.flag)
@@ -1937,6 +2188,19 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-l', '--lvs-name', help='lvol store name', required=False)
     p.set_defaults(func=bdev_lvol_grow_lvstore)
 
+    def bdev_lvol_set_read_cache(args):
+        print_dict(rpc.lvol.bdev_lvol_set_read_cache(args.client,
+                                                     uuid=args.uuid,
+                                                     lvs_name=args.lvs_name,
+                                                     bdev_name=args.bdev_name))
+
+    p = subparsers.add_parser('bdev_lvol_set_read_cache',
+                              help='Set or remove the bdev caching the data of snapshots of an lvstore')
+    p.add_argument('-u', '--uuid', help='lvol store UUID', required=False)
+    p.add_argument('-l', '--lvs-name', help='lvol store name', required=False)
+    p.add_argument('-b', '--bdev-name', help='bdev to cache on, remove the read cache if omitted', required=False)
+    p.set_defaults(func=bdev_lvol_set_read_cache)
+
     def bdev_lvol_create(args):
         print_json(rpc.lvol.bdev_lvol_create(args.client,
                                              lvol_name=args.lvol_name,
@@ -2015,6 +2279,26 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('name', help='lvol bdev name')
     p.set_defaults(func=bdev_lvol_decouple_parent)
 
+    def bdev_lvol_defragment(args):
+        rpc.lvol.bdev_lvol_defragment(args.client,
+                                      name=args.name,
+                                      clusters_per_sec=args.clusters_per_sec)
+
+    p = subparsers.add_parser('bdev_lvol_defragment', help='Move clusters of lvol next to each other')
+    p.add_argument('name', help='lvol bdev name')
+    p.add_argument('-r', '--clusters-per-sec', help='maximum number of clusters moved per second', type=int)
+    p.set_defaults(func=bdev_lvol_defragment)
+
+    def bdev_lvol_prefill(args):
+        rpc.lvol.bdev_lvol_prefill(args.client,
+                                   name=args.name,
+                                   clusters_per_sec=args.clusters_per_sec)
+
+    p = subparsers.add_parser('bdev_lvol_prefill', help='Copy clusters of clone lvol from its parent')
+    p.add_argument('name', help='lvol bdev name')
+    p.add_argument('-r', '--clusters-per-sec', help='maximum number of clusters copied per second', type=int)
+    p.set_defaults(func=bdev_lvol_prefill)
+
     def bdev_lvol_resize(args):
         rpc.lvol.bdev_lvol_resize(args.client,
                                   name=args.name,
@@ -2064,11 +2348,18 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     def bdev_lvol_get_lvols(args):
         print_dict(rpc.lvol.bdev_lvol_get_lvols(args.client,
                                                 lvs_uuid=args.lvs_uuid,
-                                                lvs_name=args.lvs_name))
+                                                lvs_name=args.lvs_name,
+                                                start_after=args.start_after,
+                                                max_count=args.max_count,
+                                                fields=args.fields))
 
     p = subparsers.add_parser('bdev_lvol_get_lvols', help='Display current logical volume list')
     p.add_argument('-u', '--lvs-uuid', help='only lvols in  lvol store UUID', required=False)
     p.add_argument('-l', '--lvs-name', help='only lvols in lvol store name', required=False)
+    p.add_argument('-a', '--start-after', help='only lvols following the lvol with this UUID', required=False)
+    p.add_argument('-c', '--max-count', help='maximum number of lvols to list', type=int, required=False)
+    p.add_argument('-f', '--fields', help="""keys to include in each lvol object, e.g. -f is_snapshot.
+    The alias and UUID are always included.""", action='append', required=False)
     p.set_defaults(func=bdev_lvol_get_lvols)
 
     def bdev_raid_get_bdevs(args):
@@ -2095,15 +2386,18 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                   raid_level=args.raid_level,
                                   base_bdevs=base_bdevs,
                                   uuid=args.uuid,
-                                  superblock=args.superblock)
+                                  superblock=args.superblock,
+                                  write_intent_region_size_kb=args.write_intent_region_size_kb)
     p = subparsers.add_parser('bdev_raid_create', help='Create new raid bdev')
     p.add_argument('-n', '--name', help='raid bdev name', required=True)
     p.add_argument('-z', '--strip-size-kb', help='strip size in KB', type=int)
-    p.add_argument('-r', '--raid-level', help='raid level, raid0, raid1 and a special level concat are supported', required=True)
+    p.add_argument('-r', '--raid-level', help='raid level, raid0, raid1, raid5f, raid6f and a special level concat are supported', required=True)
     p.add_argument('-b', '--base-bdevs', help='base bdevs name, whitespace separated list in quotes', required=True)
     p.add_argument('--uuid', help='UUID for this raid bdev', required=False)
     p.add_argument('-s', '--superblock', help='information about raid bdev will be stored in superblock on each base bdev, '
                                               'disabled by default due to backward compatibility', action='store_true')
+    p.add_argument('-w', '--write-intent-region-size-kb', help='size of the regions tracked by the write-intent '
+                   'bitmap in KB, raid1 with superblock only', type=int)
     p.set_defaults(func=bdev_raid_create)
 
     def bdev_raid_delete(args):
@@ -2120,6 +2414,45 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('name', help='base bdev name')
     p.set_defaults(func=bdev_raid_remove_base_bdev)
 
+    def bdev_raid_add_base_bdev(args):
+        rpc.bdev.bdev_raid_add_base_bdev(args.client,
+                                         base_bdev=args.base_bdev,
+                                         raid_bdev=args.raid_bdev)
+    p = subparsers.add_parser('bdev_raid_add_base_bdev', help='Add base bdev to existing raid bdev')
+    p.add_argument('raid_bdev', help='raid bdev name')
+    p.add_argument('base_bdev', help='base bdev name')
+    p.set_defaults(func=bdev_raid_add_base_bdev)
+
+    def bdev_raid_set_options(args):
+        rpc.bdev.bdev_raid_set_options(args.client,
+                                       process_window_size_kb=args.process_window_size_kb,
+                                       process_max_bandwidth_mb_sec=args.process_max_bandwidth_mb_sec,
+                                       process_latency_threshold_us=args.process_latency_threshold_us,
+                                       raid1_read_policy=args.raid1_read_policy,
+                                       raid5f_stripe_cache_size=args.raid5f_stripe_cache_size,
+                                       raid5f_stripe_cache_flush_us=args.raid5f_stripe_cache_flush_us,
+                                       numa_affinity=args.numa_affinity)
+    p = subparsers.add_parser('bdev_raid_set_options', help='Set options for bdev raid.')
+    p.add_argument('-w', '--process-window-size-kb', type=int,
+                   help="Size of the range processed at a time by background processes in KiB")
+    p.add_argument('-b', '--process-max-bandwidth-mb-sec', type=int,
+                   help="Maximum bandwidth of background processes in MiB/s, 0 for unlimited")
+    p.add_argument('-l', '--process-latency-threshold-us', type=int,
+                   help="Foreground latency above which background processes slow down, 0 to disable")
+    p.add_argument('-r', '--raid1-read-policy', choices=['bandwidth', 'latency'],
+                   help="Read balancing policy of raid1 bdevs")
+    p.add_argument('-c', '--raid5f-stripe-cache-size', type=int,
+                   help="Number of stripes per channel collecting partial stripe writes of raid5f bdevs, 0 to disable")
+    p.add_argument('-f', '--raid5f-stripe-cache-flush-us', type=int,
+                   help="Time a partially written raid5f stripe waits for more writes in microseconds")
+    group = p.add_mutually_exclusive_group()
+    group.add_argument('-n', '--enable-numa-affinity', dest='numa_affinity', action='store_true',
+                       help="Submit raid0 and concat I/O to base bdevs from threads on their NUMA socket")
+    group.add_argument('-N', '--disable-numa-affinity', dest='numa_affinity', action='store_false',
+                       help="Submit raid0 and concat I/O to base bdevs from the submitting thread")
+    p.set_defaults(numa_affinity=None)
+    p.set_defaults(func=bdev_raid_set_options)
+
     # split
     def bdev_split_create(args):
         print_array(rpc.bdev.bdev_split_create(args.client,
@@ -2155,7 +2488,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                             overprovisioning=args.overprovisioning,
                                             l2p_dram_limit=args.l2p_dram_limit,
                                             core_mask=args.core_mask,
-                                            fast_shutdown=args.fast_shutdown))
+                                            fast_shutdown=args.fast_shutdown,
+                                            nv_cache_compactors=args.nv_cache_compactors))
 
     p = subparsers.add_parser('bdev_ftl_create', help='Add FTL bdev')
     p.add_argument('-b', '--name', help="Name of the bdev", required=True)
@@ -2172,6 +2506,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('--core-mask', help='CPU core mask - which cores will be used for ftl core thread, '
                    'by default core thread will be set to the main application core (optional)')
     p.add_argument('-f', '--fast-shutdown', help="Enable fast shutdown", action='store_true')
+    p.add_argument('--nv-cache-compactors', help='Number of processes compacting the NV cache in parallel '
+                   '(optional); default 8', type=int)
     p.set_defaults(func=bdev_ftl_create)
 
     def bdev_ftl_load(args):
@@ -2183,7 +2519,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                           overprovisioning=args.overprovisioning,
                                           l2p_dram_limit=args.l2p_dram_limit,
                                           core_mask=args.core_mask,
-                                          fast_shutdown=args.fast_shutdown))
+                                          fast_shutdown=args.fast_shutdown,
+                                          nv_cache_compactors=args.nv_cache_compactors))
 
     p = subparsers.add_parser('bdev_ftl_load', help='Load FTL bdev')
     p.add_argument('-b', '--name', help="Name of the bdev", required=True)
@@ -2199,6 +2536,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('--core-mask', help='CPU core mask - which cores will be used for ftl core thread, '
                    'by default core thread will be set to the main application core (optional)')
     p.add_argument('-f', '--fast-shutdown', help="Enable fast shutdown", action='store_true')
+    p.add_argument('--nv-cache-compactors', help='Number of processes compacting the NV cache in parallel '
+                   '(optional); default 8', type=int)
     p.set_defaults(func=bdev_ftl_load)
 
     def bdev_ftl_unload(args):
@@ -2307,12 +2646,15 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     def nbd_start_disk(args):
         print(rpc.nbd.nbd_start_disk(args.client,
                                      bdev_name=args.bdev_name,
-                                     nbd_device=args.nbd_device))
+                                     nbd_device=args.nbd_device,
+                                     num_connections=args.num_connections))
 
     p = subparsers.add_parser('nbd_start_disk',
                               help='Export a bdev as an nbd disk')
     p.add_argument('bdev_name', help='Blockdev name to be exported. Example: Malloc0.')
     p.add_argument('nbd_device', help='Nbd device name to be assigned. Example: /dev/nbd0.', nargs='?')
+    p.add_argument('-c', '--num-connections', help='Number of connections, each polled by its own thread (default: 1)',
+                   type=int, required=False)
     p.set_defaults(func=nbd_start_disk)
 
     def nbd_stop_disk(args):
@@ -2383,14 +2725,22 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-l', '--acceptor-backlog', help='Pending connections allowed at one time. Relevant only for RDMA transport', type=int)
     p.add_argument('-x', '--abort-timeout-sec', help='Abort execution timeout value, in seconds', type=int)
     p.add_argument('-w', '--no-wr-batching', action='store_true', help='Disable work requests batching. Relevant only for RDMA transport')
+    p.add_argument('--numa-aware-placement', action='store_true', help="""Place I/O qpairs on the poll groups
+    running on the NUMA node of their device. Relevant only for RDMA transport""")
     p.add_argument('-e', '--control-msg-num', help="""The number of control messages per poll group.
     Relevant only for TCP transport""", type=int)
+    p.add_argument('--in-capsule-buf-num', help="""The number of in-capsule data buffers per queue pair,
+    shared by its requests. 0 allocates one buffer per request. Relevant only for TCP transport""", type=int)
+    p.add_argument('--pdu-coalesce-size', help="""Max size of the PDUs copied into a per queue pair buffer
+    to be sent together. 0 disables coalescing. Relevant only for TCP transport""", type=int)
     p.add_argument('-M', '--disable-mappable-bar0', action='store_true', help="""Disable mmap() of BAR0.
     Relevant only for VFIO-USER transport""")
     p.add_argument('-I', '--disable-adaptive-irq', action='store_true', help="""Disable adaptive interrupt feature.
     Relevant only for VFIO-USER transport""")
     p.add_argument('-S', '--disable-shadow-doorbells', action='store_true', help="""Disable shadow doorbell support.
     Relevant only for VFIO-USER transport""")
+    p.add_argument('--enable-adaptive-sq-polling', action='store_true', help="""Stop polling idle SQs until the host
+    writes their BAR0 doorbell. Relevant only for VFIO-USER transport""")
     p.add_argument('--acceptor-poll-rate', help='Polling interval of the acceptor for incoming connections (usec)', type=int)
     p.set_defaults(func=nvmf_create_transport)
 
@@ -2403,11 +2753,18 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.set_defaults(func=nvmf_get_transports)
 
     def nvmf_get_subsystems(args):
-        print_dict(rpc.nvmf.nvmf_get_subsystems(args.client, nqn=args.nqn, tgt_name=args.tgt_name))
+        print_dict(rpc.nvmf.nvmf_get_subsystems(args.client, nqn=args.nqn, tgt_name=args.tgt_name,
+                                                start_after=args.start_after,
+                                                max_count=args.max_count,
+                                                fields=args.fields))
 
     p = subparsers.add_parser('nvmf_get_subsystems', help='Display nvmf subsystems or required subsystem')
     p.add_argument('nqn', help='Subsystem NQN (optional)', nargs="?")
     p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.add_argument('-a', '--start-after', help='Only list the subsystems following the subsystem with this NQN')
+    p.add_argument('-c', '--max-count', help='Maximum number of subsystems to list', type=int)
+    p.add_argument('-f', '--fields', help="""Keys to include in each subsystem object, e.g.
+    -f hosts -f namespaces. The NQN is always included.""", action='append')
     p.set_defaults(func=nvmf_get_subsystems)
 
     def nvmf_create_subsystem(args):
@@ -2460,6 +2817,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-p', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
     p.add_argument('-f', '--adrfam', help='NVMe-oF transport adrfam: e.g., ipv4, ipv6, ib, fc, intra_host')
     p.add_argument('-s', '--trsvcid', help='NVMe-oF transport service id: e.g., a port number (required for RDMA or TCP)')
+    p.add_argument('--in-capsule-data-size', help='''In-capsule data size of the connections of the listener,
+    smaller than the transport one. Relevant only for RDMA transport''', type=int)
     p.set_defaults(func=nvmf_subsystem_add_listener)
 
     def nvmf_subsystem_remove_listener(args):
@@ -2538,6 +2897,31 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
     p.set_defaults(func=nvmf_subsystem_remove_ns)
 
+    def nvmf_subsystem_ns_set_qos_limit(args):
+        rpc.nvmf.nvmf_subsystem_ns_set_qos_limit(args.client,
+                                                 nqn=args.nqn,
+                                                 nsid=args.nsid,
+                                                 tgt_name=args.tgt_name,
+                                                 rw_ios_per_sec=args.rw_ios_per_sec,
+                                                 rw_mbytes_per_sec=args.rw_mbytes_per_sec,
+                                                 r_mbytes_per_sec=args.r_mbytes_per_sec,
+                                                 w_mbytes_per_sec=args.w_mbytes_per_sec)
+
+    p = subparsers.add_parser('nvmf_subsystem_ns_set_qos_limit',
+                              help='Set QoS rate limits on a namespace, shared by all the hosts')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('nsid', help='The requested NSID', type=int)
+    p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.add_argument('--rw-ios-per-sec', help='R/W IOs per second limit. 0 means unlimited.',
+                   type=int, required=False)
+    p.add_argument('--rw-mbytes-per-sec', help='R/W megabytes per second limit. 0 means unlimited.',
+                   type=int, required=False)
+    p.add_argument('--r-mbytes-per-sec', help='Read megabytes per second limit. 0 means unlimited.',
+                   type=int, required=False)
+    p.add_argument('--w-mbytes-per-sec', help='Write megabytes per second limit. 0 means unlimited.',
+                   type=int, required=False)
+    p.set_defaults(func=nvmf_subsystem_ns_set_qos_limit)
+
     def nvmf_subsystem_add_host(args):
         rpc.nvmf.nvmf_subsystem_add_host(args.client,
                                          nqn=args.nqn,
@@ -2608,6 +2992,17 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
     p.set_defaults(func=nvmf_subsystem_get_listeners)
 
+    def nvmf_subsystem_get_io_stats(args):
+        print_dict(rpc.nvmf.nvmf_subsystem_get_io_stats(args.client,
+                                                        nqn=args.nqn,
+                                                        tgt_name=args.tgt_name))
+
+    p = subparsers.add_parser('nvmf_subsystem_get_io_stats',
+                              help='Display IO statistics of an NVMe-oF subsystem per namespace and host.')
+    p.add_argument('nqn', help='NVMe-oF subsystem NQN')
+    p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_subsystem_get_io_stats)
+
     def nvmf_get_stats(args):
         print_dict(rpc.nvmf.nvmf_get_stats(args.client, tgt_name=args.tgt_name))
 
@@ -2616,6 +3011,14 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
     p.set_defaults(func=nvmf_get_stats)
 
+    def nvmf_rebalance_qpairs(args):
+        print_json(rpc.nvmf.nvmf_rebalance_qpairs(args.client, tgt_name=args.tgt_name))
+
+    p = subparsers.add_parser('nvmf_rebalance_qpairs',
+                              help='Move an I/O qpair from the most to the least loaded poll group')
+    p.add_argument('-t', '--tgt-name', help='The name of the parent NVMe-oF target (optional)', type=str)
+    p.set_defaults(func=nvmf_rebalance_qpairs)
+
     def nvmf_set_crdt(args):
         print_dict(rpc.nvmf.nvmf_set_crdt(args.client, args.crdt1, args.crdt2, args.crdt3))
 
@@ -2716,6 +3119,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument("-r", "--readonly", action='store_true', help='Set controller as read-only')
     p.add_argument("-p", "--packed_ring", action='store_true', help='Set controller as packed ring supported')
     p.add_argument("-l", "--packed_ring_recovery", action='store_true', help='Enable packed ring live recovery')
+    p.add_argument('--vq-threads', dest='vq_threads', type=int,
+                   help='Number of threads polling the virtqueues of a session (default: 1)')
     p.set_defaults(func=vhost_create_blk_controller)
 
     def vhost_get_controllers(args):
@@ -2875,6 +3280,20 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-m', '--module', help='name of module')
     p.set_defaults(func=accel_assign_opc)
 
+    def accel_set_opc_dispatch(args):
+        rpc.accel.accel_set_opc_dispatch(args.client, opname=args.opname,
+                                         sw_max_bytes=args.sw_max_bytes,
+                                         max_queue_depth=args.max_queue_depth)
+
+    p = subparsers.add_parser('accel_set_opc_dispatch',
+                              help='Execute small operations or operations exceeding a queue depth in software.')
+    p.add_argument('-o', '--opname', help='opname', required=True)
+    p.add_argument('-b', '--sw-max-bytes', help='operations of up to this many bytes are executed in software',
+                   type=int)
+    p.add_argument('-q', '--max-queue-depth', help='operations above this number of outstanding operations '
+                   'on the assigned module are executed in software', type=int)
+    p.set_defaults(func=accel_set_opc_dispatch)
+
     def accel_crypto_key_create(args):
         print_dict(rpc.accel.accel_crypto_key_create(args.client,
                                                      cipher=args.cipher,
@@ -2946,6 +3365,12 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('-p', '--pmd', type=int, help='0 = auto-select, 1= QAT only, 2 = mlx5_pci only')
     p.set_defaults(func=compressdev_scan_accel_module)
 
+    def compressdev_get_stats(args):
+        print_json(rpc.compressdev.compressdev_get_stats(args.client))
+
+    p = subparsers.add_parser('compressdev_get_stats', help='Get the statistics of the devices used by the compressdev module.')
+    p.set_defaults(func=compressdev_get_stats)
+
     # dsa
     def dsa_scan_accel_module(args):
         rpc.dsa.dsa_scan_accel_module(args.client, config_kernel_mode=args.config_kernel_mode)
@@ -3162,6 +3587,31 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
         'thread_get_pollers', help='Display current pollers of all the threads')
     p.set_defaults(func=thread_get_pollers)
 
+    def thread_set_adaptive_interrupt(args):
+        print_json(rpc.app.thread_set_adaptive_interrupt(args.client,
+                                                         idle_budget_us=args.idle_budget_us))
+
+    p = subparsers.add_parser('thread_set_adaptive_interrupt',
+                              help='Let threads switch to interrupt mode after idling and back on events')
+    p.add_argument('idle_budget_us', help='Idle time in microseconds before switching to interrupt mode, 0 to disable',
+                   type=int)
+    p.set_defaults(func=thread_set_adaptive_interrupt)
+
+    def thread_monitor_poller_histograms(args):
+        enabled = None
+        if args.enable:
+            enabled = True
+        if args.disable:
+            enabled = False
+        print_dict(rpc.app.thread_monitor_poller_histograms(args.client,
+                                                            enabled=enabled))
+
+    p = subparsers.add_parser('thread_monitor_poller_histograms',
+                              help='Control whether histograms of poller run times are collected')
+    p.add_argument('-e', '--enable', action='store_true', help='Enable poller histograms')
+    p.add_argument('-d', '--disable', action='store_true', help='Disable and reset poller histograms')
+    p.set_defaults(func=thread_monitor_poller_histograms)
+
     def thread_get_io_channels(args):
         print_dict(rpc.app.thread_get_io_channels(args.client))
 
@@ -3237,7 +3687,10 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                        tls_version=args.tls_version,
                                        enable_ktls=args.enable_ktls,
                                        psk_key=args.psk_key,
-                                       psk_identity=args.psk_identity)
+                                       psk_identity=args.psk_identity,
+                                       enable_recv_multishot=args.enable_recv_multishot,
+                                       busy_poll_usecs=args.busy_poll_usecs,
+                                       enable_prefer_busy_poll=args.enable_prefer_busy_poll)
 
     p = subparsers.add_parser('sock_impl_set_options', help="""Set options of socket layer implementation""")
     p.add_argument('-i', '--impl', help='Socket implementation name, e.g. posix', required=True)
@@ -3268,9 +3721,20 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                    action='store_false', dest='enable_ktls')
     p.add_argument('--psk-key', help='Set default PSK KEY', dest='psk_key')
     p.add_argument('--psk-identity', help='Set default PSK ID', dest='psk_identity')
+    p.add_argument('--enable-recv-multishot', help='Enable multishot receive (uring only)',
+                   action='store_true', dest='enable_recv_multishot')
+    p.add_argument('--disable-recv-multishot', help='Disable multishot receive (uring only)',
+                   action='store_false', dest='enable_recv_multishot')
+    p.add_argument('--busy-poll-usecs', help='Time to busy poll the device queues on receive in microseconds (posix only)',
+                   type=int)
+    p.add_argument('--enable-prefer-busy-poll', help='Enable preferred busy polling (posix only)',
+                   action='store_true', dest='enable_prefer_busy_poll')
+    p.add_argument('--disable-prefer-busy-poll', help='Disable preferred busy polling (posix only)',
+                   action='store_false', dest='enable_prefer_busy_poll')
     p.set_defaults(func=sock_impl_set_options, enable_recv_pipe=None, enable_quickack=None,
                    enable_placement_id=None, enable_zerocopy_send_server=None, enable_zerocopy_send_client=None,
-                   zerocopy_threshold=None, tls_version=None, enable_ktls=None, psk_key=None, psk_identity=None)
+                   zerocopy_threshold=None, tls_version=None, enable_ktls=None, psk_key=None, psk_identity=None,
+                   enable_recv_multishot=None, busy_poll_usecs=None, enable_prefer_busy_poll=None)
 
     def sock_set_default_impl(args):
         print_json(rpc.sock.sock_set_default_impl(args.client,
@@ -3346,7 +3810,9 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                              uuid=args.uuid,
                                              pool=args.pool,
                                              cont=args.cont,
-                                             oclass=args.oclass))
+                                             oclass=args.oclass,
+                                             num_queues=args.num_queues,
+                                             chunk_size=args.chunk_size))
     p = subparsers.add_parser('bdev_daos_create',
                               help='Create a bdev with DAOS backend')
     p.add_argument('name', help="Name of the bdev")
@@ -3357,6 +3823,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('block_size', help='Block size for this bdev', type=int)
     p.add_argument('-u', '--uuid', help="UUID of the bdev")
     p.add_argument('-o', '--oclass', help="DAOS object class")
+    p.add_argument('-q', '--num-queues', help="Number of DAOS event queues per I/O channel", type=int)
+    p.add_argument('-c', '--chunk-size', help="DFS chunk size of the backend file in bytes", type=int)
     p.set_defaults(func=bdev_daos_create)
 
     def bdev_daos_delete(args):
@@ -3380,18 +3848,45 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.set_defaults(func=bdev_daos_resize)
 
     def iobuf_set_options(args):
+        size_classes = None
+        if args.size_class:
+            size_classes = []
+            for size_class in args.size_class:
+                bufsize, pool_count = size_class.split(':')
+                size_classes.append({'bufsize': int(bufsize), 'pool_count': int(pool_count)})
         rpc.iobuf.iobuf_set_options(args.client,
                                     small_pool_count=args.small_pool_count,
                                     large_pool_count=args.large_pool_count,
                                     small_bufsize=args.small_bufsize,
-                                    large_bufsize=args.large_bufsize)
+                                    large_bufsize=args.large_bufsize,
+                                    size_classes=size_classes,
+                                    enable_numa=args.enable_numa,
+                                    cache_rebalance_period_us=args.cache_rebalance_period_us,
+                                    cache_rebalance_budget=args.cache_rebalance_budget,
+                                    lazy_init=args.lazy_init)
     p = subparsers.add_parser('iobuf_set_options', help='Set iobuf pool options')
     p.add_argument('--small-pool-count', help='number of small buffers in the global pool', type=int)
     p.add_argument('--large-pool-count', help='number of large buffers in the global pool', type=int)
     p.add_argument('--small-bufsize', help='size of a small buffer', type=int)
     p.add_argument('--large-bufsize', help='size of a large buffer', type=int)
+    p.add_argument('--size-class', action='append', metavar='bufsize:pool_count',
+                   help='adds a size class between the small and large ones, may be repeated by increasing bufsize')
+    p.add_argument('--enable-numa', action='store_true', default=None,
+                   help='allocate separate pools on each NUMA node, pool counts then apply to each node')
+    p.add_argument('--cache-rebalance-period-us', type=int,
+                   help='period of the channel cache rebalancing in microseconds, 0 to disable it')
+    p.add_argument('--cache-rebalance-budget', type=int,
+                   help='percentage of each pool the channel caches may grow by in total')
+    p.add_argument('--lazy-init', action='store_true', default=None,
+                   help='create the pools of each NUMA node when the first channel on it is initialized')
     p.set_defaults(func=iobuf_set_options)
 
+    def iobuf_get_stats(args):
+        print_dict(rpc.iobuf.iobuf_get_stats(args.client))
+
+    p = subparsers.add_parser('iobuf_get_stats', help='Display iobuf statistics of each module')
+    p.set_defaults(func=iobuf_get_stats)
+
     def bdev_nvme_start_mdns_discovery(args):
         rpc.bdev.bdev_nvme_start_mdns_discovery(args.client,
                                                 name=args.name,
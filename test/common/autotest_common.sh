@@ -486,7 +486,7 @@ function get_config_params() {
 	fi
 
 	if [ $SPDK_TEST_RAID5 -eq 1 ]; then
-		config_params+=' --with-raid5f'
+		config_params+=' --with-raid5f --with-raid6f'
 	fi
 
 	if [ $SPDK_TEST_VFIOUSER -eq 1 ] || [ $SPDK_TEST_VFIOUSER_QEMU -eq 1 ] || [ $SPDK_TEST_SMA -eq 1 ]; then
@@ -267,6 +267,21 @@ spdk_vtophys(const void *buf, uint64_t *size)
 
 	return (uintptr_t)buf;
 }
+
+int
+spdk_vtophys_iovs(const struct iovec *iovs, int iovcnt, uint64_t *phys_addrs)
+{
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		phys_addrs[i] = spdk_vtophys(iovs[i].iov_base, NULL);
+		if (phys_addrs[i] == SPDK_VTOPHYS_ERROR) {
+			return -EFAULT;
+		}
+	}
+
+	return 0;
+}
 #endif
 
 void
@@ -397,6 +412,16 @@ spdk_mempool_count(const struct spdk_mempool *_mp)
 	}
 }
 
+/* Test mempools don't keep track of their elements, so the pool needs to be mocked. */
+DEFINE_RETURN_MOCK(spdk_mempool_from_obj, struct spdk_mempool *);
+struct spdk_mempool *
+spdk_mempool_from_obj(void *ele)
+{
+	HANDLE_RETURN_MOCK(spdk_mempool_from_obj);
+
+	return NULL;
+}
+
 struct spdk_ring_ele {
 	void *ele;
 	TAILQ_ENTRY(spdk_ring_ele) link;
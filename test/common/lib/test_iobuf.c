@@ -12,6 +12,7 @@ DEFINE_STUB(spdk_iobuf_initialize, int, (void), 0);
 DEFINE_STUB(spdk_iobuf_register_module, int, (const char *name), 0);
 DEFINE_STUB(spdk_iobuf_unregister_module, int, (const char *name), 0);
 DEFINE_STUB_V(spdk_iobuf_channel_fini, (struct spdk_iobuf_channel *ch));
+DEFINE_STUB_V(spdk_iobuf_channel_migrate, (struct spdk_iobuf_channel *ch));
 DEFINE_STUB(spdk_iobuf_for_each_entry, int, (struct spdk_iobuf_channel *ch,
 		struct spdk_iobuf_pool *pool, spdk_iobuf_for_each_entry_fn cb_fn, void *cb_ctx), 0);
 DEFINE_STUB_V(spdk_iobuf_entry_abort, (struct spdk_iobuf_channel *ch,
@@ -39,9 +40,10 @@ spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
 }
 
 void
-spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts)
+spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts, size_t opts_size)
 {
 	*opts = g_iobuf.opts;
+	opts->opts_size = opts_size;
 }
 
 void
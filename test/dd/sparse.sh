@@ -12,6 +12,7 @@ cleanup() {
 	rm $file1
 	rm $file2
 	rm $file3
+	rm -f $file4 $file5 $file6 $manifest
 }
 
 prepare() {
@@ -105,11 +106,53 @@ bdev_to_file() {
 	[[ $stat2_b == "$stat3_b" ]]
 }
 
+file_to_file_skip_zeroes() {
+	local stat1_s stat4_s stat4_b
+
+	"${DD_APP[@]}" \
+		--if="$file1" \
+		--of="$file4" \
+		--bs=4194304 \
+		--skip-zeroes
+
+	stat1_s=$(stat --printf='%s' $file1)
+	stat4_s=$(stat --printf='%s' $file4)
+
+	[[ $stat1_s == "$stat4_s" ]]
+
+	# file1 only contains zeroes, so nothing should have been written
+	stat4_b=$(stat --printf='%b' $file4)
+
+	[[ $stat4_b == 0 ]]
+	cmp $file1 $file4
+}
+
+manifest_copy() {
+	local out
+
+	dd if=/dev/urandom of=$file5 bs=1M count=8
+
+	out=$("${DD_APP[@]}" --if="$file5" --of="$file6" --bs=1048576 --manifest="$manifest")
+	[[ $out != *"Skipped writing"* ]]
+	cmp $file5 $file6
+
+	# Change a single I/O unit, only that one should be written
+	dd if=/dev/urandom of=$file5 bs=1M count=1 seek=2 conv=notrunc
+
+	out=$("${DD_APP[@]}" --if="$file5" --of="$file6" --bs=1048576 --manifest="$manifest")
+	[[ $out == *"Skipped writing 7340032 of 8388608 bytes"* ]]
+	cmp $file5 $file6
+}
+
 aio_disk="dd_sparse_aio_disk"
 aio_bdev="dd_aio"
 file1="file_zero1"
 file2="file_zero2"
 file3="file_zero3"
+file4="file_zero4"
+file5="file_manifest_in"
+file6="file_manifest_out"
+manifest="dd_manifest"
 lvstore="dd_lvstore"
 lvol="dd_lvol"
 
@@ -120,3 +163,5 @@ prepare
 run_test "dd_sparse_file_to_file" file_to_file
 run_test "dd_sparse_file_to_bdev" file_to_bdev
 run_test "dd_sparse_bdev_to_file" bdev_to_file
+run_test "dd_sparse_file_to_file_skip_zeroes" file_to_file_skip_zeroes
+run_test "dd_sparse_manifest" manifest_copy
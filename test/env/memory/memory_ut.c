@@ -326,6 +326,16 @@ test_mem_map_translation(void)
 	rc = spdk_mem_map_set_translation(map, 0xffffffe00000ULL, VALUE_2MB * 2, 0x123123);
 	CU_ASSERT(rc != 0);
 
+	/* Set an incrementing translation for a region crossing a 1GB boundary */
+	addr = (1ULL << SHIFT_1GB) - VALUE_2MB;
+	rc = mem_map_set_translation(map, addr, VALUE_2MB * 2, 0x80000000, VALUE_2MB);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(spdk_mem_map_translate(map, addr, NULL) == 0x80000000);
+	CU_ASSERT(spdk_mem_map_translate(map, addr + VALUE_2MB, NULL) == 0x80000000 + VALUE_2MB);
+	rc = spdk_mem_map_clear_translation(map, addr, VALUE_2MB * 2);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(spdk_mem_map_translate(map, addr + VALUE_2MB, NULL) == default_translation);
+
 	spdk_mem_map_free(&map);
 	CU_ASSERT(map == NULL);
 
@@ -465,6 +475,72 @@ test_mem_map_registration_adjacent(void)
 	CU_ASSERT(map == NULL);
 }
 
+static void
+test_vtophys_cache(void)
+{
+	const struct spdk_mem_map_ops ops = {
+		.are_contiguous = vtophys_check_contiguous_entries
+	};
+	struct iovec iovs[2];
+	uint64_t paddr, size, phys_addrs[2];
+	int rc;
+
+	/* No vtophys_init() here, so use a map without any notify callback */
+	g_vtophys_map = spdk_mem_map_alloc(SPDK_VTOPHYS_ERROR, &ops, NULL);
+	SPDK_CU_ASSERT_FATAL(g_vtophys_map != NULL);
+
+	rc = spdk_mem_map_set_translation(g_vtophys_map, VALUE_2MB, VALUE_2MB, 0x40000000);
+	CU_ASSERT(rc == 0);
+
+	/* The first lookup fills the cache, the second one is served from it */
+	paddr = spdk_vtophys((void *)(VALUE_2MB + VALUE_4KB), NULL);
+	CU_ASSERT(paddr == 0x40000000 + VALUE_4KB);
+	size = VALUE_4KB;
+	paddr = spdk_vtophys((void *)(VALUE_2MB + 2 * VALUE_4KB), &size);
+	CU_ASSERT(paddr == 0x40000000 + 2 * VALUE_4KB);
+	CU_ASSERT(size == VALUE_4KB);
+
+	/* Changing the translation invalidates the cached one */
+	rc = spdk_mem_map_set_translation(g_vtophys_map, VALUE_2MB, VALUE_2MB, 0x80000000);
+	CU_ASSERT(rc == 0);
+	paddr = spdk_vtophys((void *)(VALUE_2MB + VALUE_4KB), NULL);
+	CU_ASSERT(paddr == 0x80000000 + VALUE_4KB);
+
+	iovs[0].iov_base = (void *)(VALUE_2MB + VALUE_4KB);
+	iovs[0].iov_len = VALUE_4KB;
+	iovs[1].iov_base = (void *)(VALUE_2MB + 4 * VALUE_4KB);
+	iovs[1].iov_len = 2 * VALUE_4KB;
+	rc = spdk_vtophys_iovs(iovs, 2, phys_addrs);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(phys_addrs[0] == 0x80000000 + VALUE_4KB);
+	CU_ASSERT(phys_addrs[1] == 0x80000000 + 4 * VALUE_4KB);
+
+	/* So does clearing it */
+	rc = spdk_mem_map_clear_translation(g_vtophys_map, VALUE_2MB, VALUE_2MB);
+	CU_ASSERT(rc == 0);
+	paddr = spdk_vtophys((void *)(VALUE_2MB + VALUE_4KB), NULL);
+	CU_ASSERT(paddr == SPDK_VTOPHYS_ERROR);
+	rc = spdk_vtophys_iovs(iovs, 2, phys_addrs);
+	CU_ASSERT(rc == -EFAULT);
+
+	/* A buffer crossing a 2MB boundary is translated only if it's physically contiguous */
+	rc = mem_map_set_translation(g_vtophys_map, 0, 2 * VALUE_2MB, 0x40000000, VALUE_2MB);
+	CU_ASSERT(rc == 0);
+	iovs[0].iov_base = (void *)(VALUE_2MB - VALUE_4KB);
+	iovs[0].iov_len = 2 * VALUE_4KB;
+	rc = spdk_vtophys_iovs(iovs, 1, phys_addrs);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(phys_addrs[0] == 0x40000000 + VALUE_2MB - VALUE_4KB);
+
+	rc = spdk_mem_map_set_translation(g_vtophys_map, VALUE_2MB, VALUE_2MB, 0x80000000);
+	CU_ASSERT(rc == 0);
+	rc = spdk_vtophys_iovs(iovs, 1, phys_addrs);
+	CU_ASSERT(rc == -EFAULT);
+
+	spdk_mem_map_free(&g_vtophys_map);
+	CU_ASSERT(g_vtophys_map == NULL);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -497,7 +573,8 @@ main(int argc, char **argv)
 		CU_add_test(suite, "alloc and free memory map", test_mem_map_alloc_free) == NULL ||
 		CU_add_test(suite, "mem map translation", test_mem_map_translation) == NULL ||
 		CU_add_test(suite, "mem map registration", test_mem_map_registration) == NULL ||
-		CU_add_test(suite, "mem map adjacent registrations", test_mem_map_registration_adjacent) == NULL
+		CU_add_test(suite, "mem map adjacent registrations", test_mem_map_registration_adjacent) == NULL ||
+		CU_add_test(suite, "vtophys cache", test_vtophys_cache) == NULL
 	) {
 		CU_cleanup_registry();
 		return CU_get_error();
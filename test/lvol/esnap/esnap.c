@@ -248,6 +248,7 @@ esnap_clone_io(void)
 	/* Create device for lvstore */
 	spdk_uuid_parse(&malloc_opts.uuid, bs_malloc_uuid);
 	malloc_opts.name = "bs_malloc";
+	malloc_opts.numa_id = SPDK_ENV_SOCKET_ID_ANY;
 	malloc_opts.num_blocks = bs_size_bytes / bs_block_size;
 	malloc_opts.block_size = bs_block_size;
 	rc = create_malloc_disk(&bs_bdev, &malloc_opts);
@@ -266,6 +267,7 @@ esnap_clone_io(void)
 	memset(&malloc_opts, 0, sizeof(malloc_opts));
 	spdk_uuid_parse(&malloc_opts.uuid, esnap_uuid);
 	malloc_opts.name = "esnap_malloc";
+	malloc_opts.numa_id = SPDK_ENV_SOCKET_ID_ANY;
 	malloc_opts.num_blocks = esnap_size_bytes / bs_block_size;
 	malloc_opts.block_size = bs_block_size;
 	rc = create_malloc_disk(&esnap_bdev, &malloc_opts);
@@ -390,6 +392,7 @@ esnap_hotplug(void)
 	/* Create esnap device */
 	spdk_uuid_parse(&malloc_opts.uuid, uuid_esnap);
 	malloc_opts.name = "esnap_malloc";
+	malloc_opts.numa_id = SPDK_ENV_SOCKET_ID_ANY;
 	malloc_opts.num_blocks = esnap_size_bytes / bs_block_size;
 	malloc_opts.block_size = bs_block_size;
 	rc = create_malloc_disk(&malloc_bdev, &malloc_opts);
@@ -490,6 +493,7 @@ esnap_remove_degraded(void)
 	/* Create esnap device */
 	spdk_uuid_parse(&malloc_opts.uuid, uuid_esnap);
 	malloc_opts.name = "esnap";
+	malloc_opts.numa_id = SPDK_ENV_SOCKET_ID_ANY;
 	malloc_opts.num_blocks = esnap_size_bytes / bs_block_size;
 	malloc_opts.block_size = bs_block_size;
 	rc = create_malloc_disk(&malloc_bdev, &malloc_opts);
@@ -10,6 +10,7 @@ source $rootdir/test/common/autotest_common.sh
 
 run_test "thread_poller_perf" $testdir/poller_perf/poller_perf -b 1000 -l 1 -t 1
 run_test "thread_poller_perf" $testdir/poller_perf/poller_perf -b 1000 -l 0 -t 1
+run_test "thread_timer_perf" $testdir/timer_perf/timer_perf -b 10000 -t 1
 
 # spdk_lock.c includes thread.c, which causes problems when registering the same
 # tracepoint for "thread" in the program and shared library. It is sufficient
@@ -0,0 +1,170 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+/*
+ * Micro-benchmark of the data structures keeping track of timed pollers.
+ *
+ * A thread registers a number of timed pollers with random periods and is
+ * polled for a given time, once with each enum spdk_thread_timer_type. The
+ * cost of registering the pollers and the busy time of the thread per expired
+ * poller, i.e. taking it off the timer, running it and putting it back on the
+ * timer, are reported in cycles.
+ */
+
+static int g_num_pollers = 10000;
+static int g_max_period_in_usec = 1000000;
+static int g_time_in_sec = 1;
+
+static uint64_t g_run_count;
+
+static int
+timer_perf_poller(void *arg)
+{
+	g_run_count++;
+
+	return SPDK_POLLER_BUSY;
+}
+
+static int
+timer_perf_run(enum spdk_thread_timer_type timer_type, const char *name)
+{
+	struct spdk_thread *thread;
+	struct spdk_poller **pollers;
+	struct spdk_thread_stats start_stats, end_stats;
+	uint64_t tsc_hz, seed = 1, period, start_tsc, register_tsc, busy_tsc, end_tsc;
+	uint64_t poll_count = 0;
+	int i, rc;
+
+	rc = spdk_thread_lib_set_timer_type(timer_type);
+	if (rc == 0) {
+		rc = spdk_thread_lib_init_ext(NULL, NULL, 0, SPDK_DEFAULT_MSG_MEMPOOL_SIZE);
+	}
+	if (rc != 0) {
+		fprintf(stderr, "Unable to initialize thread library: %s\n", spdk_strerror(-rc));
+		return rc;
+	}
+
+	pollers = calloc(g_num_pollers, sizeof(*pollers));
+	thread = spdk_thread_create(name, NULL);
+	if (pollers == NULL || thread == NULL) {
+		fprintf(stderr, "Unable to allocate thread\n");
+		free(pollers);
+		spdk_thread_lib_fini();
+		return -ENOMEM;
+	}
+	spdk_set_thread(thread);
+
+	g_run_count = 0;
+	tsc_hz = spdk_get_ticks_hz();
+
+	start_tsc = spdk_get_ticks();
+	for (i = 0; i < g_num_pollers; i++) {
+		/* Same sequence of periods for all timer types. */
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		period = 1 + (seed >> 33) % g_max_period_in_usec;
+		pollers[i] = spdk_poller_register(timer_perf_poller, NULL, period);
+	}
+	register_tsc = spdk_get_ticks() - start_tsc;
+
+	spdk_thread_get_stats(&start_stats);
+	end_tsc = spdk_get_ticks() + g_time_in_sec * tsc_hz;
+	do {
+		spdk_thread_poll(thread, 0, 0);
+		poll_count++;
+	} while (spdk_get_ticks() < end_tsc);
+	spdk_thread_get_stats(&end_stats);
+	busy_tsc = end_stats.busy_tsc - start_stats.busy_tsc;
+
+	printf("%-8s register: %" PRIu64 " (cyc/poller), expire: %" PRIu64 " (cyc/run), "
+	       "runs: %" PRIu64 ", polls: %" PRIu64 "\n", name,
+	       register_tsc / g_num_pollers, g_run_count ? busy_tsc / g_run_count : 0,
+	       g_run_count, poll_count);
+
+	for (i = 0; i < g_num_pollers; i++) {
+		spdk_poller_unregister(&pollers[i]);
+	}
+	free(pollers);
+
+	spdk_thread_exit(thread);
+	while (!spdk_thread_is_exited(thread)) {
+		spdk_thread_poll(thread, 0, 0);
+	}
+	spdk_thread_destroy(thread);
+	spdk_set_thread(NULL);
+
+	spdk_thread_lib_fini();
+
+	return 0;
+}
+
+static void
+usage(const char *prog)
+{
+	printf("usage: %s [options]\n", prog);
+	printf("Options:\n");
+	printf(" -b <number>            number of timed pollers (default: %d)\n", g_num_pollers);
+	printf(" -l <period>            maximum poller period in usec (default: %d)\n",
+	       g_max_period_in_usec);
+	printf(" -t <time>              run time in seconds per timer type (default: %d)\n",
+	       g_time_in_sec);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_env_opts opts;
+	long int tmp;
+	int ch, rc;
+
+	while ((ch = getopt(argc, argv, "b:l:t:")) != -1) {
+		tmp = spdk_strtol(optarg, 10);
+		if (tmp <= 0) {
+			fprintf(stderr, "Parse failed for the option %c.\n", ch);
+			usage(argv[0]);
+			return 1;
+		}
+
+		switch (ch) {
+		case 'b':
+			g_num_pollers = tmp;
+			break;
+		case 'l':
+			g_max_period_in_usec = tmp;
+			break;
+		case 't':
+			g_time_in_sec = tmp;
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	spdk_env_opts_init(&opts);
+	opts.name = "timer_perf";
+	if (spdk_env_init(&opts) < 0) {
+		fprintf(stderr, "Unable to initialize SPDK env\n");
+		return 1;
+	}
+
+	printf("Running %d timed pollers with periods up to %d microseconds for %d seconds.\n",
+	       g_num_pollers, g_max_period_in_usec, g_time_in_sec);
+
+	rc = timer_perf_run(SPDK_THREAD_TIMER_RBTREE, "rbtree");
+	if (rc == 0) {
+		rc = timer_perf_run(SPDK_THREAD_TIMER_WHEEL, "wheel");
+	}
+
+	spdk_env_fini();
+
+	return rc == 0 ? 0 : 1;
+}
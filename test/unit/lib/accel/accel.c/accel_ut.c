@@ -537,6 +537,153 @@ test_spdk_accel_submit_xor(void)
 	CU_ASSERT(expected_accel_task == &task);
 }
 
+static void
+test_spdk_accel_submit_dif(void)
+{
+	const uint32_t block_size = 512 + 8, num_blocks = 2;
+	uint8_t buf[(512 + 8) * 2];
+	struct iovec iov = { .iov_base = buf, .iov_len = sizeof(buf) };
+	struct spdk_dif_ctx dif_ctx;
+	struct spdk_dif_error err_blk = {};
+	struct spdk_accel_task task;
+	struct spdk_accel_task *expected_accel_task = NULL;
+	int rc;
+
+	memset(buf, 0xa5, sizeof(buf));
+	rc = spdk_dif_ctx_init(&dif_ctx, block_size, 8, true, false, SPDK_DIF_TYPE1,
+			       SPDK_DIF_FLAGS_GUARD_CHECK | SPDK_DIF_FLAGS_REFTAG_CHECK,
+			       16, 0xFFFF, 0, 0, 0);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+
+	/* Fail with no tasks on _get_task() */
+	rc = spdk_accel_submit_dif_generate(g_ch, &iov, 1, num_blocks, &dif_ctx, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+	rc = spdk_accel_submit_dif_verify(g_ch, &iov, 1, num_blocks, &dif_ctx, &err_blk, NULL, NULL);
+	CU_ASSERT(rc == -ENOMEM);
+
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+
+	/* Generate the protection information */
+	rc = spdk_accel_submit_dif_generate(g_ch, &iov, 1, num_blocks, &dif_ctx, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.op_code == ACCEL_OPC_DIF_GENERATE);
+	CU_ASSERT(task.s.iovs == &iov);
+	CU_ASSERT(task.s.iovcnt == 1);
+	CU_ASSERT(task.num_blocks == num_blocks);
+	CU_ASSERT(task.dif.ctx == &dif_ctx);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+
+	/* Verify it */
+	rc = spdk_accel_submit_dif_verify(g_ch, &iov, 1, num_blocks, &dif_ctx, &err_blk, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(task.op_code == ACCEL_OPC_DIF_VERIFY);
+	CU_ASSERT(task.dif.err == &err_blk);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == 0);
+	TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &task, link);
+
+	/* Corrupt the data of the second block and check that the verification fails */
+	buf[block_size + 1] ^= 0xff;
+	rc = spdk_accel_submit_dif_verify(g_ch, &iov, 1, num_blocks, &dif_ctx, &err_blk, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	expected_accel_task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, expected_accel_task, link);
+	CU_ASSERT(expected_accel_task == &task);
+	CU_ASSERT(task.status == -EIO);
+	CU_ASSERT(err_blk.err_type == SPDK_DIF_GUARD_ERROR);
+}
+
+static TAILQ_HEAD(ut_hw_tasks, spdk_accel_task) g_ut_hw_tasks =
+	TAILQ_HEAD_INITIALIZER(g_ut_hw_tasks);
+
+static int
+ut_hw_submit_tasks(struct spdk_io_channel *ch, struct spdk_accel_task *task)
+{
+	TAILQ_INSERT_TAIL(&g_ut_hw_tasks, task, link);
+
+	return 0;
+}
+
+static void
+test_opc_dispatch(void)
+{
+	struct spdk_accel_module_if hw_module_if = { .submit_tasks = ut_hw_submit_tasks };
+	struct accel_module module = g_modules_opc[ACCEL_OPC_COPY];
+	uint8_t dst[TEST_SUBMIT_SIZE], src[TEST_SUBMIT_SIZE];
+	struct spdk_accel_task tasks[5] = {}, *task;
+	uint32_t cb_arg = DUMMY_ARG;
+	int i, rc;
+
+	TAILQ_INIT(&g_accel_ch->task_pool);
+	for (i = 0; i < 5; i++) {
+		tasks[i].accel_ch = g_accel_ch;
+		TAILQ_INSERT_TAIL(&g_accel_ch->task_pool, &tasks[i], link);
+	}
+
+	g_modules_opc[ACCEL_OPC_COPY].module = &hw_module_if;
+	g_modules_opc[ACCEL_OPC_COPY].sw_module = &g_module_if;
+	g_accel_ch->sw_ch[ACCEL_OPC_COPY] = g_module_ch;
+	g_opc_dispatch[ACCEL_OPC_COPY].sw_max_bytes = 32;
+	g_opc_dispatch[ACCEL_OPC_COPY].max_queue_depth = 2;
+
+	/* Small operations are executed in software */
+	rc = spdk_accel_submit_copy(g_ch, dst, src, 32, 0, dummy_cb_fn, &cb_arg);
+	CU_ASSERT(rc == 0);
+	task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	SPDK_CU_ASSERT_FATAL(task == &tasks[0]);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, task, link);
+	CU_ASSERT(!task->inflight);
+	CU_ASSERT(TAILQ_EMPTY(&g_ut_hw_tasks));
+
+	/* Larger ones go to the assigned module, up to its queue depth */
+	for (i = 1; i < 3; i++) {
+		rc = spdk_accel_submit_copy(g_ch, dst, src, TEST_SUBMIT_SIZE, 0, dummy_cb_fn,
+					    &cb_arg);
+		CU_ASSERT(rc == 0);
+		CU_ASSERT(TAILQ_LAST(&g_ut_hw_tasks, ut_hw_tasks) == &tasks[i]);
+		CU_ASSERT(tasks[i].inflight);
+	}
+	CU_ASSERT(g_accel_ch->queue_depth[ACCEL_OPC_COPY] == 2);
+	CU_ASSERT(TAILQ_EMPTY(&g_sw_ch->tasks_to_complete));
+
+	/* The next one overflows to software */
+	rc = spdk_accel_submit_copy(g_ch, dst, src, TEST_SUBMIT_SIZE, 0, dummy_cb_fn, &cb_arg);
+	CU_ASSERT(rc == 0);
+	task = TAILQ_FIRST(&g_sw_ch->tasks_to_complete);
+	SPDK_CU_ASSERT_FATAL(task == &tasks[3]);
+	TAILQ_REMOVE(&g_sw_ch->tasks_to_complete, task, link);
+	CU_ASSERT(g_accel_ch->queue_depth[ACCEL_OPC_COPY] == 2);
+
+	/* Once a task completes, the assigned module is used again */
+	task = TAILQ_FIRST(&g_ut_hw_tasks);
+	TAILQ_REMOVE(&g_ut_hw_tasks, task, link);
+	g_dummy_cb_called = false;
+	spdk_accel_task_complete(task, 0);
+	CU_ASSERT(g_dummy_cb_called);
+	CU_ASSERT(!task->inflight);
+	CU_ASSERT(g_accel_ch->queue_depth[ACCEL_OPC_COPY] == 1);
+
+	rc = spdk_accel_submit_copy(g_ch, dst, src, TEST_SUBMIT_SIZE, 0, dummy_cb_fn, &cb_arg);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(TAILQ_LAST(&g_ut_hw_tasks, ut_hw_tasks) == task);
+	CU_ASSERT(g_accel_ch->queue_depth[ACCEL_OPC_COPY] == 2);
+	CU_ASSERT(TAILQ_EMPTY(&g_sw_ch->tasks_to_complete));
+
+	TAILQ_INIT(&g_ut_hw_tasks);
+	g_accel_ch->queue_depth[ACCEL_OPC_COPY] = 0;
+	g_accel_ch->sw_ch[ACCEL_OPC_COPY] = NULL;
+	memset(&g_opc_dispatch[ACCEL_OPC_COPY], 0, sizeof(g_opc_dispatch[ACCEL_OPC_COPY]));
+	g_modules_opc[ACCEL_OPC_COPY] = module;
+}
+
 static void
 test_spdk_accel_module_find_by_name(void)
 {
@@ -1980,6 +2127,7 @@ test_sequence_accel_buffers(void)
 	struct spdk_iobuf_opts opts_iobuf = {};
 
 	/* Set up the iobuf to always use the "small" pool */
+	opts_iobuf.opts_size = sizeof(opts_iobuf);
 	opts_iobuf.large_bufsize = 0x20000;
 	opts_iobuf.large_pool_count = 0;
 	opts_iobuf.small_bufsize = 0x10000;
@@ -2777,6 +2925,62 @@ test_sequence_memory_domain(void)
 	CU_ASSERT(ut_seq.complete);
 	CU_ASSERT_EQUAL(ut_seq.status, -EADDRNOTAVAIL);
 
+	/* Check that copying data between a remote memory domain and local memory is done by
+	 * pulling/pushing the data directly, without executing the copy operation */
+	memset(expected, 0x5a, sizeof(expected));
+	memset(srcbuf, 0x5a, sizeof(srcbuf));
+	memset(tmp, 0x0, sizeof(tmp));
+	memset(dstbuf, 0x0, sizeof(dstbuf));
+	g_seq_operations[ACCEL_OPC_COPY].count = 0;
+	completed = 0;
+	seq = NULL;
+
+	src_iovs[0].iov_base = (void *)0xdeadbeef;
+	src_iovs[0].iov_len = sizeof(srcbuf);
+	dst_iovs[0].iov_base = tmp;
+	dst_iovs[0].iov_len = sizeof(tmp);
+	ut_domain_ctx_init(&domctx[0], srcbuf, sizeof(srcbuf), &src_iovs[0]);
+
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+				    &src_iovs[0], 1, g_ut_domain, &domctx[0], 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 1);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(memcmp(expected, tmp, sizeof(tmp)), 0);
+
+	/* Do the same in the other direction */
+	completed = 0;
+	seq = NULL;
+
+	src_iovs[1].iov_base = tmp;
+	src_iovs[1].iov_len = sizeof(tmp);
+	dst_iovs[1].iov_base = (void *)0xfeedbeef;
+	dst_iovs[1].iov_len = sizeof(dstbuf);
+	ut_domain_ctx_init(&domctx[1], dstbuf, sizeof(dstbuf), &dst_iovs[1]);
+
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[1], 1, g_ut_domain, &domctx[1],
+				    &src_iovs[1], 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 1);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(memcmp(expected, dstbuf, sizeof(dstbuf)), 0);
+
 	for (i = 0; i < ACCEL_OPC_LAST; ++i) {
 		g_modules_opc[i] = modules[i];
 	}
@@ -3851,7 +4055,7 @@ test_sequence_crc32(void)
 	g_seq_operations[ACCEL_OPC_CRC32C].count = 0;
 
 	/* Check crc+copy - this time the copy cannot be removed, because there's no operation
-	 * before crc to change the buffer */
+	 * before crc to change the buffer, so both operations should be fused into copy_crc32c */
 	seq = NULL;
 	completed = 0;
 	crc = 0;
@@ -3880,12 +4084,49 @@ test_sequence_crc32(void)
 	CU_ASSERT_EQUAL(completed, 2);
 	CU_ASSERT(ut_seq.complete);
 	CU_ASSERT_EQUAL(ut_seq.status, 0);
-	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_CRC32C].count, 1);
-	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 1);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_CRC32C].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY_CRC32C].count, 1);
 	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(tmp[0], sizeof(tmp[0]), ~0u));
 	CU_ASSERT_EQUAL(memcmp(buf, tmp[0], sizeof(buf)), 0);
-	g_seq_operations[ACCEL_OPC_CRC32C].count = 0;
-	g_seq_operations[ACCEL_OPC_COPY].count = 0;
+	g_seq_operations[ACCEL_OPC_COPY_CRC32C].count = 0;
+
+	/* Check copy+crc of the copy's source - the copy cannot be removed either, so it should be
+	 * fused with the crc */
+	seq = NULL;
+	completed = 0;
+	crc = 0;
+	memset(buf, 0, sizeof(buf));
+	memset(&tmp[0], 0x5a, sizeof(tmp[0]));
+
+	dst_iovs[0].iov_base = buf;
+	dst_iovs[0].iov_len = sizeof(buf);
+	src_iovs[0].iov_base = tmp[0];
+	src_iovs[0].iov_len = sizeof(tmp[0]);
+	rc = spdk_accel_append_copy(&seq, ioch, &dst_iovs[0], 1, NULL, NULL,
+				    &src_iovs[0], 1, NULL, NULL, 0,
+				    ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	src_iovs[1].iov_base = tmp[0];
+	src_iovs[1].iov_len = sizeof(tmp[0]);
+	rc = spdk_accel_append_crc32c(&seq, ioch, &crc, &src_iovs[1], 1, NULL, NULL, 0,
+				      ut_sequence_step_cb, &completed);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	ut_seq.complete = false;
+	spdk_accel_sequence_finish(seq, ut_sequence_complete_cb, &ut_seq);
+
+	poll_threads();
+	CU_ASSERT_EQUAL(completed, 2);
+	CU_ASSERT(ut_seq.complete);
+	CU_ASSERT_EQUAL(ut_seq.status, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_CRC32C].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY].count, 0);
+	CU_ASSERT_EQUAL(g_seq_operations[ACCEL_OPC_COPY_CRC32C].count, 1);
+	CU_ASSERT_EQUAL(crc, spdk_crc32c_update(tmp[0], sizeof(tmp[0]), ~0u));
+	CU_ASSERT_EQUAL(memcmp(buf, tmp[0], sizeof(buf)), 0);
+	g_seq_operations[ACCEL_OPC_COPY_CRC32C].count = 0;
 
 	/* Check a sequence with an operation at the beginning that can have its buffer changed, two
 	 * crc operations and a copy at the end.  The copy should be removed and the dst buffer of
@@ -4099,6 +4340,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_spdk_accel_submit_crc32cv);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_copy_crc32c);
 	CU_ADD_TEST(suite, test_spdk_accel_submit_xor);
+	CU_ADD_TEST(suite, test_spdk_accel_submit_dif);
+	CU_ADD_TEST(suite, test_opc_dispatch);
 	CU_ADD_TEST(suite, test_spdk_accel_module_find_by_name);
 	CU_ADD_TEST(suite, test_spdk_accel_module_register);
 
@@ -441,8 +441,11 @@ test_setup(void)
 	g_io_ch = calloc(1, sizeof(struct spdk_io_channel) + sizeof(struct compress_io_channel));
 	g_io_ch->thread = thread;
 	g_comp_ch = (struct compress_io_channel *)spdk_io_channel_get_ctx(g_io_ch);
-	g_comp_ch->device_qp = &g_device_qp;
-	g_comp_ch->device_qp->device = &g_device;
+	g_comp_ch->device_qps = calloc(1, sizeof(*g_comp_ch->device_qps));
+	SPDK_CU_ASSERT_FATAL(g_comp_ch->device_qps != NULL);
+	g_comp_ch->device_qps[0] = &g_device_qp;
+	g_comp_ch->num_device_qps = 1;
+	g_device_qp.device = &g_device;
 	g_device_qp.device->sgl_in = true;
 	g_device_qp.device->sgl_out = true;
 	g_comp_ch->src_mbufs = calloc(UT_MBUFS_PER_OP_BOUND_TEST, sizeof(void *));
@@ -479,6 +482,7 @@ test_cleanup(void)
 	}
 	free(g_comp_ch->src_mbufs);
 	free(g_comp_ch->dst_mbufs);
+	free(g_comp_ch->device_qps);
 	free(g_io_ch);
 
 	thread = spdk_get_thread();
@@ -897,6 +901,7 @@ test_poller(void)
 	g_done_count = 0;
 	g_comp_op[0].status = RTE_COMP_OP_STATUS_NOT_PROCESSED;
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
+	g_device_qp.num_inflight = 1;
 	rc = comp_dev_poller((void *)g_comp_ch);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	CU_ASSERT(rc == SPDK_POLLER_BUSY);
@@ -915,6 +920,7 @@ test_poller(void)
 	g_done_count = 0;
 	ut_enqueue_value = FAKE_ENQUEUE_SUCCESS;
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
+	g_device_qp.num_inflight = 2;
 	rc = comp_dev_poller((void *)g_comp_ch);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	CU_ASSERT(rc == SPDK_POLLER_BUSY);
@@ -967,6 +973,7 @@ test_poller(void)
 			  task_to_resubmit,
 			  link);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == false);
+	g_device_qp.num_inflight = 1;
 	rc = comp_dev_poller((void *)g_comp_ch);
 	CU_ASSERT(TAILQ_EMPTY(&g_comp_ch->queued_tasks) == true);
 	CU_ASSERT(rc == SPDK_POLLER_BUSY);
@@ -975,6 +982,32 @@ test_poller(void)
 	free(args);
 }
 
+static void
+test_select_device_qp(void)
+{
+	struct compress_io_channel chan = {};
+	struct comp_device_qp device_qp[3] = {};
+	struct comp_device_qp *device_qps[3] = { &device_qp[0], &device_qp[1], &device_qp[2] };
+
+	chan.device_qps = device_qps;
+	chan.num_device_qps = 3;
+
+	/* Equally loaded qpairs are used in turn */
+	CU_ASSERT(_select_device_qp(&chan) == &device_qp[0]);
+	CU_ASSERT(_select_device_qp(&chan) == &device_qp[1]);
+	CU_ASSERT(_select_device_qp(&chan) == &device_qp[2]);
+	CU_ASSERT(_select_device_qp(&chan) == &device_qp[0]);
+
+	/* Otherwise the one with the fewest ops in flight is used */
+	device_qp[0].num_inflight = 4;
+	device_qp[1].num_inflight = 2;
+	device_qp[2].num_inflight = 3;
+	CU_ASSERT(_select_device_qp(&chan) == &device_qp[1]);
+	CU_ASSERT(_select_device_qp(&chan) == &device_qp[1]);
+	device_qp[1].num_inflight = 5;
+	CU_ASSERT(_select_device_qp(&chan) == &device_qp[2]);
+}
+
 static void
 test_initdrivers(void)
 {
@@ -1048,6 +1081,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_setup_compress_mbuf);
 	CU_ADD_TEST(suite, test_initdrivers);
 	CU_ADD_TEST(suite, test_poller);
+	CU_ADD_TEST(suite, test_select_device_qp);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
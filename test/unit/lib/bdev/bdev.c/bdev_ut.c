@@ -17,6 +17,11 @@
 
 DEFINE_STUB(spdk_notify_send, uint64_t, (const char *type, const char *ctx), 0);
 DEFINE_STUB(spdk_notify_type_register, struct spdk_notify_type *, (const char *type), NULL);
+DEFINE_STUB_V(spdk_metrics_source_register, (struct spdk_metrics_source *source));
+DEFINE_STUB_V(spdk_metrics_write_family, (struct spdk_metrics_writer *w, const char *name,
+		enum spdk_metrics_type type, const char *help));
+DEFINE_STUB_V(spdk_metrics_write_value, (struct spdk_metrics_writer *w, const char *label,
+		const char *label_value, uint64_t value));
 DEFINE_STUB(spdk_memory_domain_get_dma_device_id, const char *, (struct spdk_memory_domain *domain),
 	    "test_domain");
 DEFINE_STUB(spdk_memory_domain_get_dma_device_type, enum spdk_dma_device_type,
@@ -504,6 +509,8 @@ struct ut_examine_ctx {
 	void (*examine_disk)(struct spdk_bdev *bdev);
 	uint32_t examine_config_count;
 	uint32_t examine_disk_count;
+	/* Don't complete examine_disk, the test calls spdk_bdev_module_examine_done() itself */
+	bool examine_disk_deferred;
 };
 
 static void
@@ -531,6 +538,9 @@ vbdev_ut_examine_disk(struct spdk_bdev *bdev)
 		if (ctx->examine_disk != NULL) {
 			ctx->examine_disk(bdev);
 		}
+		if (ctx->examine_disk_deferred) {
+			return;
+		}
 	}
 
 	spdk_bdev_module_examine_done(&vbdev_ut_if);
@@ -3309,6 +3319,88 @@ bdev_io_alignment(void)
 	free(buf);
 }
 
+static void
+bdev_io_bounce_accel_copy(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_channel *bdev_ch;
+	struct spdk_bdev_io *bdev_io;
+	struct spdk_bdev_opts bdev_opts = {};
+	int rc;
+	void *buf = NULL;
+
+	spdk_bdev_get_opts(&bdev_opts, sizeof(bdev_opts));
+	bdev_opts.bdev_io_pool_size = 20;
+	bdev_opts.bdev_io_cache_size = 2;
+	bdev_opts.accel_copy_threshold = 1024;
+	ut_init_bdev(&bdev_opts);
+
+	fn_table.submit_request = stub_submit_request_get_buf;
+	bdev = allocate_bdev("bdev0");
+
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+	bdev_ch = spdk_io_channel_get_ctx(io_ch);
+
+	rc = posix_memalign(&buf, 4096, 8192);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	bdev->required_alignment = spdk_u32log2(512);
+
+	/* Bounce buffer copy of the write data is offloaded to accel */
+	g_bdev_io = NULL;
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf + 4, 0, 2, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_io == NULL);
+	bdev_io = TAILQ_FIRST(&bdev_ch->io_memory_domain);
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	CU_ASSERT(bdev_io->internal.orig_iovcnt == 1);
+
+	bdev_io_pull_data_done_and_track(bdev_io, 0);
+	CU_ASSERT(TAILQ_EMPTY(&bdev_ch->io_memory_domain));
+	CU_ASSERT(g_bdev_io == bdev_io);
+	CU_ASSERT(g_bdev_io->u.bdev.iovs == &g_bdev_io->internal.bounce_iov);
+	stub_complete_io(1);
+	CU_ASSERT(g_io_done == true);
+
+	/* Bounce buffer copy of the read data is offloaded to accel */
+	g_io_done = false;
+	rc = spdk_bdev_read_blocks(desc, io_ch, buf + 4, 0, 2, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_io->u.bdev.iovs == &g_bdev_io->internal.bounce_iov);
+	stub_complete_io(1);
+	CU_ASSERT(g_io_done == false);
+	bdev_io = TAILQ_FIRST(&bdev_ch->io_memory_domain);
+	SPDK_CU_ASSERT_FATAL(bdev_io == g_bdev_io);
+
+	bdev_io_push_bounce_data_done_and_track(bdev_io, 0);
+	CU_ASSERT(TAILQ_EMPTY(&bdev_ch->io_memory_domain));
+	CU_ASSERT(g_io_done == true);
+	CU_ASSERT(bdev_io->internal.orig_iovcnt == 0);
+
+	/* Copies below the threshold are done on the CPU */
+	g_io_done = false;
+	rc = spdk_bdev_write_blocks(desc, io_ch, buf + 4, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(TAILQ_EMPTY(&bdev_ch->io_memory_domain));
+	CU_ASSERT(g_bdev_io->u.bdev.iovs == &g_bdev_io->internal.bounce_iov);
+	stub_complete_io(1);
+	CU_ASSERT(g_io_done == true);
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	fn_table.submit_request = stub_submit_request;
+	ut_fini_bdev();
+	g_bdev_opts.accel_copy_threshold = 0;
+
+	free(buf);
+}
+
 static void
 bdev_io_alignment_with_boundary(void)
 {
@@ -3574,6 +3666,113 @@ bdev_histograms(void)
 	ut_fini_bdev();
 }
 
+static void
+type_histograms_cb(void *cb_arg, int status, struct spdk_bdev_type_histograms *histograms)
+{
+	uint64_t (*counts)[SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS] = cb_arg;
+	int type, bucket;
+
+	g_status = status;
+	if (status != 0) {
+		return;
+	}
+
+	for (type = 0; type < SPDK_BDEV_NUM_IO_TYPES; type++) {
+		for (bucket = 0; bucket < SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS; bucket++) {
+			g_count = 0;
+			if (histograms->histogram[type][bucket] != NULL) {
+				spdk_histogram_data_iterate(histograms->histogram[type][bucket],
+							    histogram_io_count, NULL);
+			}
+			counts[type][bucket] = g_count;
+		}
+	}
+}
+
+static void
+bdev_type_histograms(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *ch;
+	uint64_t counts[SPDK_BDEV_NUM_IO_TYPES][SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS];
+	uint64_t total;
+	int type, bucket;
+	int rc;
+
+	ut_init_bdev(NULL);
+
+	bdev = allocate_bdev("bdev");
+
+	rc = spdk_bdev_open_ext("bdev", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+
+	ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(ch != NULL);
+
+	/* Not enabled yet */
+	spdk_bdev_channel_get_type_histograms(ch, false, type_histograms_cb, counts);
+	CU_ASSERT(g_status == -EFAULT);
+
+	g_status = -1;
+	spdk_bdev_type_histograms_enable(bdev, histogram_status_cb, NULL, true);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(bdev->internal.type_histograms_enabled == true);
+
+	/* 512B write, 8KiB read and 512KiB read go to buckets 0, 1 and the last one */
+	rc = spdk_bdev_write_blocks(desc, ch, (void *)0xF000, 0, 1, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc, ch, (void *)0xF000, 0, 16, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc, ch, (void *)0xF000, 0, 1024, io_done, NULL);
+	CU_ASSERT(rc == 0);
+	spdk_delay_us(10);
+	stub_complete_io(3);
+	poll_threads();
+
+	memset(counts, 0, sizeof(counts));
+	spdk_bdev_type_histograms_get(bdev, false, type_histograms_cb, counts);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(counts[SPDK_BDEV_IO_TYPE_WRITE][0] == 1);
+	CU_ASSERT(counts[SPDK_BDEV_IO_TYPE_READ][1] == 1);
+	CU_ASSERT(counts[SPDK_BDEV_IO_TYPE_READ][SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS - 1] == 1);
+	total = 0;
+	for (type = 0; type < SPDK_BDEV_NUM_IO_TYPES; type++) {
+		for (bucket = 0; bucket < SPDK_BDEV_HISTOGRAM_NUM_SIZE_BUCKETS; bucket++) {
+			total += counts[type][bucket];
+		}
+	}
+	CU_ASSERT(total == 3);
+
+	/* Reading the channel histograms can reset them */
+	memset(counts, 0, sizeof(counts));
+	spdk_bdev_channel_get_type_histograms(ch, true, type_histograms_cb, counts);
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(counts[SPDK_BDEV_IO_TYPE_WRITE][0] == 1);
+
+	spdk_bdev_channel_get_type_histograms(ch, false, type_histograms_cb, counts);
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(counts[SPDK_BDEV_IO_TYPE_WRITE][0] == 0);
+	CU_ASSERT(counts[SPDK_BDEV_IO_TYPE_READ][1] == 0);
+
+	spdk_bdev_type_histograms_enable(bdev, histogram_status_cb, NULL, false);
+	poll_threads();
+	CU_ASSERT(g_status == 0);
+	CU_ASSERT(bdev->internal.type_histograms_enabled == false);
+
+	spdk_bdev_type_histograms_get(bdev, false, type_histograms_cb, counts);
+	poll_threads();
+	CU_ASSERT(g_status == -EFAULT);
+
+	spdk_put_io_channel(ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
 static void
 _bdev_compare(bool emulated)
 {
@@ -4236,6 +4435,118 @@ bdev_zcopy_read(void)
 	ut_fini_bdev();
 }
 
+static struct spdk_bdev_desc *g_zcopy_base_desc;
+static struct spdk_io_channel *g_zcopy_base_ch;
+
+static void
+zcopy_vbdev_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	int rc;
+
+	rc = spdk_bdev_io_zcopy_forward(bdev_io, g_zcopy_base_desc, g_zcopy_base_ch,
+					bdev_io->u.bdev.offset_blocks + 10);
+	CU_ASSERT_EQUAL(rc, 0);
+}
+
+static struct spdk_bdev_fn_table zcopy_vbdev_fn_table = {
+	.destruct = stub_destruct,
+	.submit_request = zcopy_vbdev_submit_request,
+	.get_io_channel = bdev_ut_get_io_channel,
+	.io_type_supported = stub_io_type_supported,
+};
+
+static void
+bdev_zcopy_forward(void)
+{
+	struct spdk_bdev *bdev, *vbdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *ioch;
+	struct spdk_bdev_io *base_io;
+	struct ut_expected_io *expected_io;
+	uint32_t num_completed;
+	char aa_buf[512];
+	struct iovec iov;
+	int rc;
+
+	memset(aa_buf, 0xaa, sizeof(aa_buf));
+
+	ut_init_bdev(NULL);
+	bdev = allocate_bdev("bdev");
+
+	/* A vbdev forwarding zero-copy requests 10 blocks further on the base bdev */
+	vbdev = calloc(1, sizeof(*vbdev));
+	SPDK_CU_ASSERT_FATAL(vbdev != NULL);
+	vbdev->name = "vbdev";
+	vbdev->fn_table = &zcopy_vbdev_fn_table;
+	vbdev->module = &vbdev_ut_if;
+	vbdev->blockcnt = 1024;
+	vbdev->blocklen = 512;
+	rc = spdk_bdev_register(vbdev);
+	poll_threads();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_bdev_open_ext("bdev", true, bdev_ut_event_cb, NULL, &g_zcopy_base_desc);
+	CU_ASSERT_EQUAL(rc, 0);
+	g_zcopy_base_ch = spdk_bdev_get_io_channel(g_zcopy_base_desc);
+	SPDK_CU_ASSERT_FATAL(g_zcopy_base_ch != NULL);
+
+	rc = spdk_bdev_open_ext("vbdev", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT_EQUAL(rc, 0);
+	ioch = spdk_bdev_get_io_channel(desc);
+	SPDK_CU_ASSERT_FATAL(ioch != NULL);
+
+	g_io_exp_status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	iov.iov_base = NULL;
+	iov.iov_len = 0;
+
+	/* The start phase lends the base bdev's buffer to the caller */
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_ZCOPY, 60, 1, 0);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	g_io_done = false;
+	g_zcopy_write_buf = aa_buf;
+	g_zcopy_write_buf_len = sizeof(aa_buf);
+	g_zcopy_bdev_io = NULL;
+	rc = spdk_bdev_zcopy_start(desc, ioch, &iov, 1, 50, 1, false, io_done, NULL);
+	CU_ASSERT_EQUAL(rc, 0);
+	num_completed = stub_complete_io(1);
+	CU_ASSERT_EQUAL(num_completed, 1);
+	poll_threads();
+	CU_ASSERT(g_io_done == true);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(iov.iov_base == aa_buf);
+	CU_ASSERT(iov.iov_len == sizeof(aa_buf));
+	SPDK_CU_ASSERT_FATAL(g_zcopy_bdev_io != NULL);
+	CU_ASSERT(g_zcopy_bdev_io->bdev == vbdev);
+
+	/* The base bdev's I/O is kept until the end phase */
+	base_io = g_zcopy_bdev_io->internal.zcopy_base_io;
+	SPDK_CU_ASSERT_FATAL(base_io != NULL);
+	CU_ASSERT(base_io->bdev == bdev);
+	CU_ASSERT(base_io->u.bdev.offset_blocks == 60);
+
+	/* The end phase is forwarded to the same base I/O */
+	g_io_done = false;
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_ZCOPY, 60, 1, 0);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	rc = spdk_bdev_zcopy_end(g_zcopy_bdev_io, true, io_done, NULL);
+	CU_ASSERT_EQUAL(rc, 0);
+	num_completed = stub_complete_io(1);
+	CU_ASSERT_EQUAL(num_completed, 1);
+	poll_threads();
+	CU_ASSERT(g_io_done == true);
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_zcopy_write_buf == NULL);
+	CU_ASSERT(g_zcopy_bdev_io == NULL);
+
+	spdk_put_io_channel(ioch);
+	spdk_bdev_close(desc);
+	spdk_put_io_channel(g_zcopy_base_ch);
+	spdk_bdev_close(g_zcopy_base_desc);
+	free_vbdev(vbdev);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
 static void
 bdev_open_while_hotremove(void)
 {
@@ -6449,6 +6760,59 @@ examine_locks(void)
 	free_bdev(bdev);
 }
 
+static void
+examine_queue_depth(void)
+{
+	struct spdk_bdev *bdev0, *bdev1;
+	struct ut_examine_ctx ctx0 = { 0 }, ctx1 = { 0 };
+
+	g_bdev_opts.examine_queue_depth = 1;
+
+	/* The first bdev's examine_disk stays in progress... */
+	ctx0.examine_disk_deferred = true;
+	bdev0 = allocate_bdev_ctx("bdev0", &ctx0);
+	CU_ASSERT(ctx0.examine_config_count == 1);
+	CU_ASSERT(ctx0.examine_disk_count == 1);
+
+	/* ...so the second one is only examined by examine_config */
+	bdev1 = allocate_bdev_ctx("bdev1", &ctx1);
+	CU_ASSERT(ctx1.examine_config_count == 1);
+	CU_ASSERT(ctx1.examine_disk_count == 0);
+	CU_ASSERT(g_bdev_mgr.examine_pending_count == 1);
+	CU_ASSERT(!bdev_module_all_actions_completed());
+
+	/* Completing the first examine_disk starts the deferred one */
+	spdk_bdev_module_examine_done(&vbdev_ut_if);
+	poll_threads();
+	CU_ASSERT(ctx1.examine_disk_count == 1);
+	CU_ASSERT(g_bdev_mgr.examine_pending_count == 0);
+	CU_ASSERT(g_bdev_mgr.examine_disk_in_progress == 0);
+	free_bdev(bdev1);
+	free_bdev(bdev0);
+
+	/*
+	 * The descriptor opened by spdk_bdev_register() keeps a bdev unregistered while its
+	 * examine is queued around until the examine is done, but examine_disk is skipped.
+	 */
+	memset(&ctx1, 0, sizeof(ctx1));
+	bdev0 = allocate_bdev_ctx("bdev0", &ctx0);
+	bdev1 = allocate_bdev_ctx("bdev1", &ctx1);
+	CU_ASSERT(g_bdev_mgr.examine_pending_count == 1);
+	spdk_bdev_unregister(bdev1, NULL, NULL);
+	poll_threads();
+	CU_ASSERT(spdk_bdev_get_by_name("bdev1") == bdev1);
+	spdk_bdev_module_examine_done(&vbdev_ut_if);
+	poll_threads();
+	CU_ASSERT(ctx1.examine_disk_count == 0);
+	CU_ASSERT(g_bdev_mgr.examine_pending_count == 0);
+	CU_ASSERT(g_bdev_mgr.examine_disk_in_progress == 0);
+	CU_ASSERT(spdk_bdev_get_by_name("bdev1") == NULL);
+	free(bdev1);
+	free_bdev(bdev0);
+
+	g_bdev_opts.examine_queue_depth = 0;
+}
+
 #define UT_ASSERT_CLAIM_V2_COUNT(bdev, expect) \
 	do { \
 		uint32_t len = 0; \
@@ -7188,6 +7552,493 @@ examine_claimed(void)
 	ut_testing_examine_claimed = false;
 }
 
+static void
+coalesce_io_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	int *count = cb_arg;
+
+	CU_ASSERT(success == true);
+	(*count)++;
+	spdk_bdev_free_io(bdev_io);
+}
+
+static void
+coalesce_status_cb(void *cb_arg, int status)
+{
+	*(int *)cb_arg = status;
+}
+
+static void
+bdev_io_coalesce_test(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_opts bdev_opts = {};
+	struct ut_expected_io *expected_io;
+	int count = 0, status = -1;
+	int rc;
+
+	spdk_bdev_get_opts(&bdev_opts, sizeof(bdev_opts));
+	ut_init_bdev(&bdev_opts);
+
+	bdev = allocate_bdev("bdev0");
+
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+
+	/* A coalesced I/O needs at least two blocks */
+	spdk_bdev_set_io_coalescing(bdev, 10, 1, coalesce_status_cb, &status);
+	CU_ASSERT(status == -EINVAL);
+
+	spdk_bdev_set_io_coalescing(bdev, 10, 8, coalesce_status_cb, &status);
+	poll_threads();
+	CU_ASSERT(status == 0);
+
+	/* Two adjacent writes are held until the window expires and merged */
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xA000, 0, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xB000, 1, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 0, 2, 2);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xA000, 512);
+	ut_expected_io_set_iov(expected_io, 1, (void *)0xB000, 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	spdk_delay_us(10);
+	poll_threads();
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	CU_ASSERT(stub_complete_io(1) == 1);
+	CU_ASSERT(count == 2);
+
+	/* Non-adjacent I/O or I/O of another type flush the pending one */
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 4, 1, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xA000, 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 8, 1, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xB000, 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_READ, 9, 1, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xC000, 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	count = 0;
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xA000, 4, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xB000, 8, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	rc = spdk_bdev_read_blocks(desc, io_ch, (void *)0xC000, 9, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+
+	spdk_delay_us(10);
+	poll_threads();
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 3);
+	CU_ASSERT(stub_complete_io(3) == 3);
+	CU_ASSERT(count == 3);
+
+	/* A full batch is submitted right away */
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_READ, 0, 8, 2);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xA000, 4 * 512);
+	ut_expected_io_set_iov(expected_io, 1, (void *)0xB000, 4 * 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	count = 0;
+	rc = spdk_bdev_read_blocks(desc, io_ch, (void *)0xA000, 0, 4, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc, io_ch, (void *)0xB000, 4, 4, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	CU_ASSERT(stub_complete_io(1) == 1);
+	CU_ASSERT(count == 2);
+
+	/* Once disabled, the I/O is submitted as is */
+	spdk_bdev_set_io_coalescing(bdev, 0, 0, coalesce_status_cb, &status);
+	poll_threads();
+	CU_ASSERT(status == 0);
+
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 0, 1, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xA000, 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	count = 0;
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xA000, 0, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	CU_ASSERT(stub_complete_io(1) == 1);
+	CU_ASSERT(count == 1);
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_ut_channel->expected_io));
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
+static void
+bdev_io_coalesce_limits_test(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_opts bdev_opts = {};
+	struct ut_expected_io *expected_io;
+	int count = 0, status = -1;
+	int rc;
+
+	spdk_bdev_get_opts(&bdev_opts, sizeof(bdev_opts));
+	ut_init_bdev(&bdev_opts);
+
+	bdev = allocate_bdev("bdev0");
+	bdev->split_on_optimal_io_boundary = true;
+	bdev->optimal_io_boundary = 4;
+
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+
+	spdk_bdev_set_io_coalescing(bdev, 10, 8, coalesce_status_cb, &status);
+	poll_threads();
+	CU_ASSERT(status == 0);
+
+	/* The merged I/O doesn't cross the optimal I/O boundary */
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 2, 2, 2);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xA000, 512);
+	ut_expected_io_set_iov(expected_io, 1, (void *)0xB000, 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 4, 1, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xC000, 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xA000, 2, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xB000, 3, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xC000, 4, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+
+	spdk_delay_us(10);
+	poll_threads();
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+	CU_ASSERT(stub_complete_io(2) == 2);
+	CU_ASSERT(count == 3);
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_ut_channel->expected_io));
+
+	/* The children of a split I/O are submitted right away */
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_READ, 2, 2, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xA000, 2 * 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_READ, 4, 2, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)(0xA000 + 2 * 512), 2 * 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	count = 0;
+	rc = spdk_bdev_read_blocks(desc, io_ch, (void *)0xA000, 2, 4, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+	CU_ASSERT(stub_complete_io(2) == 2);
+	CU_ASSERT(count == 1);
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_ut_channel->expected_io));
+
+	/* A failed merged I/O is retried one I/O at a time, so each gets its own status */
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 0, 2, 2);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xA000, 512);
+	ut_expected_io_set_iov(expected_io, 1, (void *)0xB000, 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 0, 1, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xA000, 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+	expected_io = ut_alloc_expected_io(SPDK_BDEV_IO_TYPE_WRITE, 1, 1, 1);
+	ut_expected_io_set_iov(expected_io, 0, (void *)0xB000, 512);
+	TAILQ_INSERT_TAIL(&g_bdev_ut_channel->expected_io, expected_io, link);
+
+	count = 0;
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xA000, 0, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_write_blocks(desc, io_ch, (void *)0xB000, 1, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+
+	spdk_delay_us(10);
+	poll_threads();
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 1);
+	g_io_exp_status = SPDK_BDEV_IO_STATUS_FAILED;
+	CU_ASSERT(stub_complete_io(1) == 1);
+	g_io_exp_status = SPDK_BDEV_IO_STATUS_SUCCESS;
+	CU_ASSERT(count == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 2);
+	CU_ASSERT(stub_complete_io(2) == 2);
+	CU_ASSERT(count == 2);
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_ut_channel->expected_io));
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
+static uint32_t g_batch_calls;
+static uint32_t g_batch_last_count;
+
+static void
+stub_submit_request_batch(struct spdk_io_channel *ch, struct spdk_bdev_io **bdev_ios,
+			  uint32_t count)
+{
+	uint32_t i;
+
+	g_batch_calls++;
+	g_batch_last_count = count;
+	for (i = 0; i < count; i++) {
+		CU_ASSERT(bdev_ios[i]->internal.in_submit_request);
+		stub_submit_request(ch, bdev_ios[i]);
+	}
+}
+
+static void
+bdev_submit_batch_test(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_opts bdev_opts = {};
+	struct spdk_bdev_batch_request reqs[40] = {};
+	struct iovec iovs[40];
+	uint32_t i, num_submitted;
+	int count = 0;
+	int rc;
+
+	spdk_bdev_get_opts(&bdev_opts, sizeof(bdev_opts));
+	ut_init_bdev(&bdev_opts);
+
+	bdev = allocate_bdev("bdev0");
+
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+
+	for (i = 0; i < SPDK_COUNTOF(reqs); i++) {
+		iovs[i].iov_base = (void *)(uintptr_t)(0xA000 + i * 0x1000);
+		iovs[i].iov_len = 512;
+		reqs[i].type = i % 2 ? SPDK_BDEV_IO_TYPE_WRITE : SPDK_BDEV_IO_TYPE_READ;
+		reqs[i].iovs = &iovs[i];
+		reqs[i].iovcnt = 1;
+		reqs[i].offset_blocks = i;
+		reqs[i].num_blocks = 1;
+		reqs[i].cb = coalesce_io_done;
+		reqs[i].cb_arg = &count;
+	}
+
+	/* Without a batch callback, the I/O is submitted one by one */
+	g_batch_calls = 0;
+	rc = spdk_bdev_submit_batch(desc, io_ch, reqs, 3, &num_submitted);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(num_submitted == 3);
+	CU_ASSERT(g_batch_calls == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 3);
+	CU_ASSERT(stub_complete_io(3) == 3);
+	CU_ASSERT(count == 3);
+
+	fn_table.submit_request_batch = stub_submit_request_batch;
+
+	/* The requests are handed to the module in a single call */
+	count = 0;
+	rc = spdk_bdev_submit_batch(desc, io_ch, reqs, 3, &num_submitted);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(num_submitted == 3);
+	CU_ASSERT(g_batch_calls == 1);
+	CU_ASSERT(g_batch_last_count == 3);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 3);
+	CU_ASSERT(stub_complete_io(3) == 3);
+	CU_ASSERT(count == 3);
+
+	/* Larger batches are split */
+	count = 0;
+	g_batch_calls = 0;
+	rc = spdk_bdev_submit_batch(desc, io_ch, reqs, 40, &num_submitted);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(num_submitted == 40);
+	CU_ASSERT(g_batch_calls == 2);
+	CU_ASSERT(g_batch_last_count == 40 - BDEV_SUBMIT_BATCH_SIZE);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 40);
+	CU_ASSERT(stub_complete_io(40) == 40);
+	CU_ASSERT(count == 40);
+
+	/* The requests preceding the invalid one are still submitted */
+	count = 0;
+	g_batch_calls = 0;
+	reqs[2].type = SPDK_BDEV_IO_TYPE_FLUSH;
+	rc = spdk_bdev_submit_batch(desc, io_ch, reqs, 3, &num_submitted);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(num_submitted == 2);
+	CU_ASSERT(g_batch_calls == 1);
+	CU_ASSERT(g_batch_last_count == 2);
+	CU_ASSERT(stub_complete_io(2) == 2);
+	poll_threads();
+	CU_ASSERT(count == 2);
+
+	fn_table.submit_request_batch = NULL;
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
+static uint32_t g_completion_batch_calls;
+static int g_completion_batch_count;
+
+static void
+completion_batch_cb(void *cb_arg)
+{
+	int *count = cb_arg;
+
+	g_completion_batch_calls++;
+	g_completion_batch_count = *count;
+}
+
+static void
+bdev_complete_batch_test(void)
+{
+	struct spdk_bdev *bdev;
+	struct spdk_bdev_desc *desc = NULL, *desc2 = NULL;
+	struct spdk_io_channel *io_ch;
+	struct spdk_bdev_opts bdev_opts = {};
+	char buf[512];
+	int count = 0;
+	int rc;
+
+	spdk_bdev_get_opts(&bdev_opts, sizeof(bdev_opts));
+	ut_init_bdev(&bdev_opts);
+
+	bdev = allocate_bdev("bdev0");
+
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc != NULL);
+	rc = spdk_bdev_open_ext("bdev0", true, bdev_ut_event_cb, NULL, &desc2);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(desc2 != NULL);
+	io_ch = spdk_bdev_get_io_channel(desc);
+	CU_ASSERT(io_ch != NULL);
+
+	spdk_bdev_set_completion_batch_cb(desc, completion_batch_cb, &count);
+
+	/* Without a batch, the I/O is completed right away */
+	rc = spdk_bdev_read_blocks(desc, io_ch, buf, 0, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(stub_complete_io(1) == 1);
+	CU_ASSERT(count == 1);
+	CU_ASSERT(g_completion_batch_calls == 0);
+
+	/* The completions are held until the outermost batch ends */
+	count = 0;
+	rc = spdk_bdev_read_blocks(desc, io_ch, buf, 0, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc, io_ch, buf, 1, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc, io_ch, buf, 2, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+
+	spdk_bdev_io_complete_batch_begin();
+	spdk_bdev_io_complete_batch_begin();
+	CU_ASSERT(stub_complete_io(3) == 3);
+	spdk_bdev_io_complete_batch_end();
+	CU_ASSERT(count == 0);
+	CU_ASSERT(g_bdev_ut_channel->outstanding_io_count == 0);
+	spdk_bdev_io_complete_batch_end();
+	CU_ASSERT(count == 3);
+	CU_ASSERT(g_completion_batch_calls == 1);
+	CU_ASSERT(g_completion_batch_count == 3);
+
+	/* The descriptor is notified once per run of consecutive completions */
+	count = 0;
+	g_completion_batch_calls = 0;
+	rc = spdk_bdev_read_blocks(desc, io_ch, buf, 0, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc2, io_ch, buf, 1, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	rc = spdk_bdev_read_blocks(desc, io_ch, buf, 2, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+
+	spdk_bdev_io_complete_batch_begin();
+	CU_ASSERT(stub_complete_io(3) == 3);
+	CU_ASSERT(count == 0);
+	spdk_bdev_io_complete_batch_end();
+	CU_ASSERT(count == 3);
+	CU_ASSERT(g_completion_batch_calls == 2);
+	CU_ASSERT(g_completion_batch_count == 3);
+
+	/* No more notifications once the callback is cleared */
+	count = 0;
+	g_completion_batch_calls = 0;
+	spdk_bdev_set_completion_batch_cb(desc, NULL, NULL);
+	rc = spdk_bdev_read_blocks(desc, io_ch, buf, 0, 1, coalesce_io_done, &count);
+	CU_ASSERT(rc == 0);
+	spdk_bdev_io_complete_batch_begin();
+	CU_ASSERT(stub_complete_io(1) == 1);
+	spdk_bdev_io_complete_batch_end();
+	CU_ASSERT(count == 1);
+	CU_ASSERT(g_completion_batch_calls == 0);
+
+	spdk_put_io_channel(io_ch);
+	spdk_bdev_close(desc2);
+	spdk_bdev_close(desc);
+	free_bdev(bdev);
+	ut_fini_bdev();
+}
+
+static void
+bdev_metrics_poller_test(void)
+{
+	struct spdk_bdev_mgmt_channel *mgmt_ch;
+	struct spdk_io_channel *ch;
+
+	ut_init_bdev(NULL);
+
+	/* The metrics aren't aggregated until the metrics server is started */
+	ch = spdk_get_io_channel(&g_bdev_mgr);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	mgmt_ch = __io_ch_to_bdev_mgmt_ch(ch);
+	CU_ASSERT(mgmt_ch->metrics_poller == NULL);
+
+	bdev_metrics_start();
+	poll_threads();
+	CU_ASSERT(mgmt_ch->metrics_poller != NULL);
+
+	bdev_metrics_stop();
+	poll_threads();
+	CU_ASSERT(mgmt_ch->metrics_poller == NULL);
+
+	spdk_put_io_channel(ch);
+	poll_threads();
+
+	/* Channels created while the server is running start aggregating right away */
+	bdev_metrics_start();
+	ch = spdk_get_io_channel(&g_bdev_mgr);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	mgmt_ch = __io_ch_to_bdev_mgmt_ch(ch);
+	CU_ASSERT(mgmt_ch->metrics_poller != NULL);
+
+	bdev_metrics_stop();
+	poll_threads();
+	CU_ASSERT(mgmt_ch->metrics_poller == NULL);
+
+	spdk_put_io_channel(ch);
+	poll_threads();
+	ut_fini_bdev();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -7216,13 +8067,16 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, bdev_io_write_unit_split_test);
 	CU_ADD_TEST(suite, bdev_io_alignment_with_boundary);
 	CU_ADD_TEST(suite, bdev_io_alignment);
+	CU_ADD_TEST(suite, bdev_io_bounce_accel_copy);
 	CU_ADD_TEST(suite, bdev_histograms);
+	CU_ADD_TEST(suite, bdev_type_histograms);
 	CU_ADD_TEST(suite, bdev_write_zeroes);
 	CU_ADD_TEST(suite, bdev_compare_and_write);
 	CU_ADD_TEST(suite, bdev_compare);
 	CU_ADD_TEST(suite, bdev_compare_emulated);
 	CU_ADD_TEST(suite, bdev_zcopy_write);
 	CU_ADD_TEST(suite, bdev_zcopy_read);
+	CU_ADD_TEST(suite, bdev_zcopy_forward);
 	CU_ADD_TEST(suite, bdev_open_while_hotremove);
 	CU_ADD_TEST(suite, bdev_close_while_hotremove);
 	CU_ADD_TEST(suite, bdev_open_ext);
@@ -7251,6 +8105,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, bdev_copy);
 	CU_ADD_TEST(suite, bdev_copy_split_test);
 	CU_ADD_TEST(suite, examine_locks);
+	CU_ADD_TEST(suite, examine_queue_depth);
 	CU_ADD_TEST(suite, claim_v2_rwo);
 	CU_ADD_TEST(suite, claim_v2_rom);
 	CU_ADD_TEST(suite, claim_v2_rwm);
@@ -7258,6 +8113,11 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, claim_v2_existing_v1);
 	CU_ADD_TEST(suite, claim_v1_existing_v2);
 	CU_ADD_TEST(suite, examine_claimed);
+	CU_ADD_TEST(suite, bdev_io_coalesce_test);
+	CU_ADD_TEST(suite, bdev_io_coalesce_limits_test);
+	CU_ADD_TEST(suite, bdev_submit_batch_test);
+	CU_ADD_TEST(suite, bdev_complete_batch_test);
+	CU_ADD_TEST(suite, bdev_metrics_poller_test);
 
 	allocate_cores(1);
 	allocate_threads(1);
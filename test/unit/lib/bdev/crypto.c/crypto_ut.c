@@ -357,6 +357,32 @@ test_simple_write(void)
 	CU_ASSERT(g_io_ctx->aux_num_blocks == 1);
 }
 
+static void
+test_inplace_write(void)
+{
+	/* Data in an accel buffer is encrypted in place, without an aux buffer */
+	g_bdev_io->internal.status = SPDK_BDEV_IO_STATUS_PENDING;
+	g_bdev_io->u.bdev.iovcnt = 1;
+	g_bdev_io->u.bdev.num_blocks = 1;
+	g_bdev_io->u.bdev.offset_blocks = 0;
+	g_bdev_io->u.bdev.iovs[0].iov_len = 512;
+	g_bdev_io->u.bdev.iovs[0].iov_base = &test_inplace_write;
+	g_bdev_io->u.bdev.memory_domain = spdk_accel_get_memory_domain();
+	g_crypto_bdev.crypto_bdev.blocklen = 512;
+	g_bdev_io->type = SPDK_BDEV_IO_TYPE_WRITE;
+
+	vbdev_crypto_submit_request(g_io_ch, g_bdev_io);
+	poll_threads();
+	poll_threads();
+	CU_ASSERT(g_bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_io_ctx->aux_buf_raw == NULL);
+	CU_ASSERT(g_io_ctx->aux_buf_iov.iov_base == NULL);
+	CU_ASSERT(g_io_ctx->aux_offset_blocks == 0);
+	CU_ASSERT(g_io_ctx->aux_num_blocks == 1);
+
+	g_bdev_io->u.bdev.memory_domain = NULL;
+}
+
 static void
 test_simple_read(void)
 {
@@ -472,6 +498,7 @@ main(int argc, char **argv)
 	suite = CU_add_suite("crypto", test_setup, test_cleanup);
 	CU_ADD_TEST(suite, test_error_paths);
 	CU_ADD_TEST(suite, test_simple_write);
+	CU_ADD_TEST(suite, test_inplace_write);
 	CU_ADD_TEST(suite, test_simple_read);
 	CU_ADD_TEST(suite, test_passthru);
 	CU_ADD_TEST(suite, test_crypto_op_complete);
@@ -19,6 +19,11 @@
 
 DEFINE_STUB(spdk_notify_send, uint64_t, (const char *type, const char *ctx), 0);
 DEFINE_STUB(spdk_notify_type_register, struct spdk_notify_type *, (const char *type), NULL);
+DEFINE_STUB_V(spdk_metrics_source_register, (struct spdk_metrics_source *source));
+DEFINE_STUB_V(spdk_metrics_write_family, (struct spdk_metrics_writer *w, const char *name,
+		enum spdk_metrics_type type, const char *help));
+DEFINE_STUB_V(spdk_metrics_write_value, (struct spdk_metrics_writer *w, const char *label,
+		const char *label_value, uint64_t value));
 DEFINE_STUB_V(spdk_scsi_nvme_translate, (const struct spdk_bdev_io *bdev_io, int *sc, int *sk,
 		int *asc, int *ascq));
 DEFINE_STUB(spdk_memory_domain_get_dma_device_id, const char *, (struct spdk_memory_domain *domain),
@@ -1818,6 +1823,248 @@ qos_dynamic_enable(void)
 	teardown_test();
 }
 
+static void
+qos_sharded(void)
+{
+	struct spdk_io_channel *io_ch[2];
+	struct spdk_bdev_channel *bdev_ch[2];
+	struct spdk_bdev *bdev;
+	enum spdk_bdev_io_status bdev_io_status[2];
+	uint64_t limits[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES] = {};
+	int status, rc, i;
+
+	setup_test();
+
+	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
+		limits[i] = UINT64_MAX;
+	}
+
+	bdev = &g_bdev.bdev;
+
+	g_get_io_channel = true;
+
+	set_thread(0);
+	io_ch[0] = spdk_bdev_get_io_channel(g_desc);
+	bdev_ch[0] = spdk_io_channel_get_ctx(io_ch[0]);
+
+	set_thread(1);
+	io_ch[1] = spdk_bdev_get_io_channel(g_desc);
+	bdev_ch[1] = spdk_io_channel_get_ctx(io_ch[1]);
+
+	set_thread(0);
+
+	/* Enable sharded QoS, 10 I/O allowed per timeslice. */
+	rc = spdk_bdev_set_qos_sharded(bdev, true);
+	CU_ASSERT(rc == 0);
+	status = -1;
+	limits[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT] = 10000;
+	spdk_bdev_set_qos_rate_limits(bdev, limits, qos_dynamic_enable_done, &status);
+	poll_threads();
+	CU_ASSERT(status == 0);
+	CU_ASSERT((bdev_ch[0]->flags & BDEV_CH_QOS_ENABLED) != 0);
+	CU_ASSERT((bdev_ch[1]->flags & BDEV_CH_QOS_ENABLED) != 0);
+	CU_ASSERT(bdev_ch[0]->qos_shard != NULL);
+	CU_ASSERT(bdev_ch[1]->qos_shard != NULL);
+	CU_ASSERT(bdev->internal.qos->ch == bdev_ch[0]);
+
+	/* The mode can't be changed while QoS is enabled. */
+	rc = spdk_bdev_set_qos_sharded(bdev, false);
+	CU_ASSERT(rc == -EBUSY);
+
+	/*
+	 * Both threads share the quota of the timeslice. The I/O are submitted on
+	 * their own thread without going through the QoS thread.
+	 */
+	for (i = 0; i < 10; i++) {
+		set_thread(i % 2);
+		bdev_io_status[0] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(g_desc, io_ch[i % 2], NULL, 0, 1, io_during_io_done,
+					   &bdev_io_status[0]);
+		CU_ASSERT(rc == 0);
+		CU_ASSERT(stub_complete_io(g_bdev.io_target, 0) == 1);
+		CU_ASSERT(bdev_io_status[0] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+
+	/* The quota is used up, so the next I/O is queued on its channel. */
+	set_thread(1);
+	bdev_io_status[1] = SPDK_BDEV_IO_STATUS_PENDING;
+	rc = spdk_bdev_read_blocks(g_desc, io_ch[1], NULL, 0, 1, io_during_io_done, &bdev_io_status[1]);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(stub_complete_io(g_bdev.io_target, 0) == 0);
+	CU_ASSERT(!TAILQ_EMPTY(&bdev_ch[1]->qos_shard->queued));
+	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.qos->queued));
+
+	/* It's submitted once the next timeslice has started. */
+	spdk_delay_us(SPDK_BDEV_QOS_TIMESLICE_IN_USEC);
+	poll_threads();
+	CU_ASSERT(TAILQ_EMPTY(&bdev_ch[1]->qos_shard->queued));
+	CU_ASSERT(stub_complete_io(g_bdev.io_target, 0) == 1);
+	CU_ASSERT(bdev_io_status[1] == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* Use up the quota again and queue an I/O on thread 1. */
+	for (i = 0; i < 9; i++) {
+		bdev_io_status[0] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(g_desc, io_ch[1], NULL, 0, 1, io_during_io_done,
+					   &bdev_io_status[0]);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(stub_complete_io(g_bdev.io_target, 0) == 9);
+	bdev_io_status[1] = SPDK_BDEV_IO_STATUS_PENDING;
+	rc = spdk_bdev_read_blocks(g_desc, io_ch[1], NULL, 0, 1, io_during_io_done, &bdev_io_status[1]);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(stub_complete_io(g_bdev.io_target, 0) == 0);
+
+	/* Disabling QoS resubmits the queued I/O and frees the shards. */
+	set_thread(0);
+	status = -1;
+	limits[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT] = 0;
+	spdk_bdev_set_qos_rate_limits(bdev, limits, qos_dynamic_enable_done, &status);
+	poll_threads();
+	CU_ASSERT(status == 0);
+	CU_ASSERT((bdev_ch[0]->flags & BDEV_CH_QOS_ENABLED) == 0);
+	CU_ASSERT((bdev_ch[1]->flags & BDEV_CH_QOS_ENABLED) == 0);
+	CU_ASSERT(bdev_ch[0]->qos_shard == NULL);
+	CU_ASSERT(bdev_ch[1]->qos_shard == NULL);
+
+	set_thread(1);
+	CU_ASSERT(stub_complete_io(g_bdev.io_target, 0) == 1);
+	CU_ASSERT(bdev_io_status[1] == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	rc = spdk_bdev_set_qos_sharded(bdev, false);
+	CU_ASSERT(rc == 0);
+
+	/* Tear down the channels */
+	set_thread(0);
+	spdk_put_io_channel(io_ch[0]);
+	set_thread(1);
+	spdk_put_io_channel(io_ch[1]);
+	poll_threads();
+
+	set_thread(0);
+	teardown_test();
+}
+
+static void
+qos_latency_target(void)
+{
+	struct spdk_io_channel *io_ch, *second_io_ch;
+	struct spdk_bdev_channel *bdev_ch, *second_bdev_ch;
+	struct ut_bdev *second_bdev;
+	struct spdk_bdev_desc *second_desc = NULL;
+	enum spdk_bdev_io_status status[6];
+	int rc, i;
+
+	setup_test();
+
+	/* The second bdev shares the io_target and is throttled on behalf of the first one. */
+	second_bdev = calloc(1, sizeof(*second_bdev));
+	SPDK_CU_ASSERT_FATAL(second_bdev != NULL);
+	register_bdev(second_bdev, "ut_bdev2", g_bdev.io_target);
+	spdk_bdev_open_ext("ut_bdev2", true, _bdev_event_cb, NULL, &second_desc);
+	SPDK_CU_ASSERT_FATAL(second_desc != NULL);
+
+	set_thread(0);
+	io_ch = spdk_bdev_get_io_channel(g_desc);
+	bdev_ch = spdk_io_channel_get_ctx(io_ch);
+	second_io_ch = spdk_bdev_get_io_channel(second_desc);
+	second_bdev_ch = spdk_io_channel_get_ctx(second_io_ch);
+
+	rc = -1;
+	spdk_bdev_set_qos_latency_target(&g_bdev.bdev, "ut_group", 100, qos_dynamic_enable_done,
+					 &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	rc = -1;
+	spdk_bdev_set_qos_latency_target(&second_bdev->bdev, "ut_group", 0, qos_dynamic_enable_done,
+					 &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(bdev_ch->latency_qos.group != NULL);
+	CU_ASSERT(bdev_ch->latency_qos.group == second_bdev_ch->latency_qos.group);
+
+	/* Four I/O outstanding on the second bdev. */
+	for (i = 0; i < 4; i++) {
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(second_desc, second_io_ch, NULL, 0, 1, io_during_io_done,
+					   &status[i]);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(second_bdev_ch->latency_qos.peak_outstanding == 4);
+
+	/* The first bdev misses its target. */
+	status[4] = SPDK_BDEV_IO_STATUS_PENDING;
+	rc = spdk_bdev_read_blocks(g_desc, io_ch, NULL, 0, 1, io_during_io_done, &status[4]);
+	CU_ASSERT(rc == 0);
+	spdk_delay_us(200);
+	poll_threads();
+	CU_ASSERT(stub_complete_io(g_bdev.io_target, 5) == 5);
+	CU_ASSERT(status[4] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(bdev_ch->latency_qos.over_target == 1);
+
+	/* At the end of the window, the second bdev is throttled to half its queue depth. */
+	spdk_delay_us(BDEV_LATENCY_QOS_WINDOW_IN_USEC);
+	poll_threads();
+	CU_ASSERT(second_bdev_ch->latency_qos.max_outstanding == 2);
+	CU_ASSERT(bdev_ch->latency_qos.completed == 0);
+
+	/* Only two I/O get submitted, the third one waits. */
+	for (i = 0; i < 3; i++) {
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(second_desc, second_io_ch, NULL, 0, 1, io_during_io_done,
+					   &status[i]);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(second_bdev_ch->io_outstanding == 2);
+	CU_ASSERT(!TAILQ_EMPTY(&second_bdev_ch->latency_qos.queued));
+
+	/* The high priority bdev isn't throttled. */
+	status[5] = SPDK_BDEV_IO_STATUS_PENDING;
+	rc = spdk_bdev_read_blocks(g_desc, io_ch, NULL, 0, 1, io_during_io_done, &status[5]);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(bdev_ch->io_outstanding == 1);
+
+	/* A completion makes room for the queued I/O. */
+	CU_ASSERT(stub_complete_io(g_bdev.io_target, 1) == 1);
+	CU_ASSERT(status[0] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(TAILQ_EMPTY(&second_bdev_ch->latency_qos.queued));
+	CU_ASSERT(second_bdev_ch->io_outstanding == 2);
+	CU_ASSERT(stub_complete_io(g_bdev.io_target, 0) == 3);
+	CU_ASSERT(status[1] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(status[2] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(status[5] == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* The limit was reached during this window, so it's only raised. */
+	spdk_delay_us(BDEV_LATENCY_QOS_WINDOW_IN_USEC);
+	poll_threads();
+	CU_ASSERT(second_bdev_ch->latency_qos.max_outstanding == 3);
+
+	/* Once the target is met and the limit not reached, throttling stops. */
+	spdk_delay_us(BDEV_LATENCY_QOS_WINDOW_IN_USEC);
+	poll_threads();
+	CU_ASSERT(second_bdev_ch->latency_qos.max_outstanding == 0);
+
+	/* Remove both bdevs from the group. */
+	rc = -1;
+	spdk_bdev_set_qos_latency_target(&g_bdev.bdev, NULL, 0, qos_dynamic_enable_done, &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(bdev_ch->latency_qos.group == NULL);
+	rc = -1;
+	spdk_bdev_set_qos_latency_target(&second_bdev->bdev, NULL, 0, qos_dynamic_enable_done, &rc);
+	poll_threads();
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(second_bdev_ch->latency_qos.group == NULL);
+	CU_ASSERT(TAILQ_EMPTY(&g_bdev_mgr.latency_groups));
+
+	spdk_put_io_channel(io_ch);
+	spdk_put_io_channel(second_io_ch);
+	spdk_bdev_close(second_desc);
+	unregister_bdev(second_bdev);
+	free(second_bdev);
+
+	teardown_test();
+}
+
 static void
 histogram_status_cb(void *cb_arg, int status)
 {
@@ -2633,6 +2880,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, enomem_multi_bdev_unregister);
 	CU_ADD_TEST(suite, enomem_multi_io_target);
 	CU_ADD_TEST(suite, qos_dynamic_enable);
+	CU_ADD_TEST(suite, qos_sharded);
+	CU_ADD_TEST(suite, qos_latency_target);
 	CU_ADD_TEST(suite, bdev_histograms_mt);
 	CU_ADD_TEST(suite, bdev_set_io_timeout_mt);
 	CU_ADD_TEST(suite, lock_lba_range_then_submit_io);
@@ -20,6 +20,11 @@
 
 static void *g_accel_p = (void *)0xdeadbeaf;
 
+DEFINE_STUB(spdk_nvme_ctrlr_get_pci_device, struct spdk_pci_device *,
+	    (struct spdk_nvme_ctrlr *ctrlr), NULL);
+
+DEFINE_STUB(spdk_pci_device_get_socket_id, int, (struct spdk_pci_device *dev), SPDK_ENV_SOCKET_ID_ANY);
+
 DEFINE_STUB(spdk_nvme_probe_async, struct spdk_nvme_probe_ctx *,
 	    (const struct spdk_nvme_transport_id *trid, void *cb_ctx,
 	     spdk_nvme_probe_cb probe_cb, spdk_nvme_attach_cb attach_cb,
@@ -63,6 +68,7 @@ DEFINE_STUB(spdk_nvme_transport_set_opts, int, (const struct spdk_nvme_transport
 		size_t opts_size), 0);
 
 DEFINE_STUB(spdk_bdev_io_get_submit_tsc, uint64_t, (struct spdk_bdev_io *bdev_io), 0);
+DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
 
 DEFINE_STUB_V(spdk_bdev_reset_io_stat, (struct spdk_bdev_io_stat *stat,
 					enum spdk_bdev_reset_stat_mode mode));
@@ -71,6 +77,9 @@ DEFINE_STUB_V(spdk_bdev_add_io_stat, (struct spdk_bdev_io_stat *total,
 
 DEFINE_STUB_V(spdk_nvme_qpair_set_abort_dnr, (struct spdk_nvme_qpair *qpair, bool dnr));
 
+DEFINE_STUB(spdk_nvme_ctrlr_get_socket_id, int32_t, (struct spdk_nvme_ctrlr *ctrlr),
+	    SPDK_ENV_SOCKET_ID_ANY);
+
 int
 spdk_nvme_ctrlr_get_memory_domains(const struct spdk_nvme_ctrlr *ctrlr,
 				   struct spdk_memory_domain **domains, int array_size)
@@ -152,6 +161,8 @@ DEFINE_STUB(spdk_nvme_ns_get_dealloc_logical_block_read_value,
 
 DEFINE_STUB(spdk_nvme_ns_get_optimal_io_boundary, uint32_t, (struct spdk_nvme_ns *ns), 0);
 
+DEFINE_STUB(spdk_nvme_ns_get_preferred_write_granularity, uint32_t, (struct spdk_nvme_ns *ns), 0);
+
 DEFINE_STUB(spdk_nvme_cuse_get_ns_name, int, (struct spdk_nvme_ctrlr *ctrlr, uint32_t nsid,
 		char *name, size_t *size), 0);
 
@@ -217,6 +228,10 @@ DEFINE_STUB(spdk_nvme_cpl_get_status_string, const char *,
 
 DEFINE_STUB_V(spdk_bdev_module_fini_done, (void));
 
+DEFINE_STUB_V(spdk_bdev_io_complete_batch_begin, (void));
+
+DEFINE_STUB_V(spdk_bdev_io_complete_batch_end, (void));
+
 DEFINE_STUB_V(spdk_bdev_module_list_add, (struct spdk_bdev_module *bdev_module));
 
 DEFINE_STUB_V(spdk_bdev_close, (struct spdk_bdev_desc *desc));
@@ -2844,6 +2859,135 @@ test_get_io_qpair(void)
 	CU_ASSERT(nvme_ctrlr_get_by_name("nvme0") == NULL);
 }
 
+static void
+test_io_qpairs_per_ctrlr(void)
+{
+	struct spdk_nvme_transport_id trid = {};
+	struct spdk_nvme_ctrlr ctrlr = {};
+	struct nvme_ctrlr *nvme_ctrlr = NULL;
+	struct spdk_io_channel *ch;
+	struct nvme_ctrlr_channel *ctrlr_ch;
+	struct nvme_qpair *nvme_qpair;
+	struct spdk_nvme_qpair *qpair, *secondary_qpair;
+	int rc;
+
+	ut_init_trid(&trid);
+	TAILQ_INIT(&ctrlr.active_io_qpairs);
+
+	set_thread(0);
+
+	g_opts.io_qpairs_per_ctrlr = 2;
+
+	rc = nvme_ctrlr_create(&ctrlr, "nvme0", &trid, NULL);
+	CU_ASSERT(rc == 0);
+
+	nvme_ctrlr = nvme_ctrlr_get_by_name("nvme0");
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr != NULL);
+
+	ch = spdk_get_io_channel(nvme_ctrlr);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	ctrlr_ch = spdk_io_channel_get_ctx(ch);
+	nvme_qpair = ctrlr_ch->qpair;
+	SPDK_CU_ASSERT_FATAL(nvme_qpair != NULL);
+	CU_ASSERT(nvme_qpair->qpair != NULL);
+	CU_ASSERT(nvme_qpair->num_secondary_qpairs == 1);
+	SPDK_CU_ASSERT_FATAL(nvme_qpair->secondary_qpairs[0] != NULL);
+	CU_ASSERT(nvme_qpair->secondary_qpairs[0]->is_connected == true);
+
+	qpair = nvme_qpair->qpair;
+	secondary_qpair = nvme_qpair->secondary_qpairs[0];
+
+	/* The primary qpair is preferred while it is idle. */
+	CU_ASSERT(nvme_qpair_get_io_qpair(nvme_qpair) == qpair);
+
+	/* I/Os go to the qpair with the fewest outstanding requests. */
+	qpair->num_outstanding_reqs = 1;
+	CU_ASSERT(nvme_qpair_get_io_qpair(nvme_qpair) == secondary_qpair);
+	CU_ASSERT(nvme_qpair_get_num_outstanding_reqs(nvme_qpair) == 1);
+
+	secondary_qpair->num_outstanding_reqs = 2;
+	CU_ASSERT(nvme_qpair_get_io_qpair(nvme_qpair) == qpair);
+	CU_ASSERT(nvme_qpair_get_num_outstanding_reqs(nvme_qpair) == 3);
+
+	/* A failed secondary qpair is skipped. */
+	secondary_qpair->num_outstanding_reqs = 0;
+	secondary_qpair->failure_reason = SPDK_NVME_QPAIR_FAILURE_REMOTE;
+	CU_ASSERT(nvme_qpair_get_io_qpair(nvme_qpair) == qpair);
+
+	qpair->num_outstanding_reqs = 0;
+	secondary_qpair->failure_reason = SPDK_NVME_QPAIR_FAILURE_NONE;
+
+	/* Reset disconnects and recreates all qpairs of the channel. */
+	rc = bdev_nvme_reset(nvme_ctrlr);
+	CU_ASSERT(rc == 0);
+
+	poll_threads();
+	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+	poll_threads();
+
+	CU_ASSERT(nvme_ctrlr->resetting == false);
+	CU_ASSERT(nvme_qpair->qpair != NULL);
+	CU_ASSERT(nvme_qpair->secondary_qpairs[0] != NULL);
+
+	/* A failed secondary qpair is dropped alone, the primary qpair keeps running. */
+	qpair = nvme_qpair->qpair;
+	nvme_qpair->secondary_qpairs[0]->failure_reason = SPDK_NVME_QPAIR_FAILURE_REMOTE;
+
+	poll_threads();
+	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+	poll_threads();
+
+	CU_ASSERT(nvme_qpair->secondary_qpairs[0] == NULL);
+	CU_ASSERT(nvme_qpair->qpair == qpair);
+	CU_ASSERT(qpair->is_connected == true);
+	CU_ASSERT(nvme_ctrlr->resetting == false);
+	CU_ASSERT(nvme_qpair_get_io_qpair(nvme_qpair) == qpair);
+
+	/* The next reset creates it again. */
+	rc = bdev_nvme_reset(nvme_ctrlr);
+	CU_ASSERT(rc == 0);
+
+	poll_threads();
+	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+	poll_threads();
+
+	CU_ASSERT(nvme_ctrlr->resetting == false);
+	CU_ASSERT(nvme_qpair->qpair != NULL);
+	CU_ASSERT(nvme_qpair->secondary_qpairs[0] != NULL);
+
+	/* A failed primary qpair takes the others down with it, and then all are recreated. */
+	secondary_qpair = nvme_qpair->secondary_qpairs[0];
+	nvme_qpair->qpair->failure_reason = SPDK_NVME_QPAIR_FAILURE_REMOTE;
+
+	poll_thread_times(0, 2);
+
+	CU_ASSERT(nvme_qpair->qpair == NULL);
+	CU_ASSERT(secondary_qpair->is_connected == false);
+
+	poll_threads();
+	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+	poll_threads();
+
+	CU_ASSERT(nvme_ctrlr->resetting == false);
+	CU_ASSERT(nvme_qpair->qpair != NULL);
+	CU_ASSERT(nvme_qpair->secondary_qpairs[0] != NULL);
+
+	spdk_put_io_channel(ch);
+
+	poll_threads();
+
+	g_opts.io_qpairs_per_ctrlr = 1;
+
+	rc = bdev_nvme_delete("nvme0", &g_any_path);
+	CU_ASSERT(rc == 0);
+
+	poll_threads();
+	spdk_delay_us(1000);
+	poll_threads();
+
+	CU_ASSERT(nvme_ctrlr_get_by_name("nvme0") == NULL);
+}
+
 /* Test a scenario that the bdev subsystem starts shutdown when there still exists
  * any NVMe bdev. In this scenario, spdk_bdev_unregister() is called first. Add a
  * test case to avoid regression for this scenario. spdk_bdev_unregister() calls
@@ -4344,6 +4488,30 @@ test_retry_io_if_ana_state_is_updating(void)
 	CU_ASSERT(bdev_io1->internal.in_submit_request == false);
 	CU_ASSERT(bdev_io1->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
 
+	/* If the ANA log page update makes the namespace accessible again, the queued
+	 * I/O should be retried without waiting for its retry delay.
+	 */
+	nvme_ns->ana_state = SPDK_NVME_ANA_INACCESSIBLE_STATE;
+	nbdev_ch->current_io_path = NULL;
+
+	bdev_io1->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io1);
+
+	CU_ASSERT(nvme_qpair->qpair->num_outstanding_reqs == 0);
+	CU_ASSERT(bdev_io1 == TAILQ_FIRST(&nbdev_ch->retry_io_list));
+
+	nvme_ns->ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+
+	bdev_nvme_clear_io_path_caches(nvme_ctrlr);
+
+	poll_threads();
+
+	CU_ASSERT(TAILQ_EMPTY(&nbdev_ch->retry_io_list));
+	CU_ASSERT(nvme_qpair->qpair->num_outstanding_reqs == 0);
+	CU_ASSERT(bdev_io1->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io1->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
 	free(bdev_io1);
 
 	spdk_put_io_channel(ch);
@@ -4763,83 +4931,145 @@ test_retry_io_count(void)
 }
 
 static void
-test_concurrent_read_ana_log_page(void)
+test_retry_io_budget(void)
 {
-	struct spdk_nvme_transport_id trid = {};
+	struct nvme_path_id path = {};
 	struct spdk_nvme_ctrlr *ctrlr;
+	struct nvme_bdev_ctrlr *nbdev_ctrlr;
 	struct nvme_ctrlr *nvme_ctrlr;
 	const int STRING_SIZE = 32;
 	const char *attached_names[STRING_SIZE];
+	struct nvme_bdev *bdev;
+	struct spdk_bdev_io *bdev_io;
+	struct nvme_bdev_io *bio;
+	struct spdk_io_channel *ch;
+	struct nvme_bdev_channel *nbdev_ch;
+	struct nvme_io_path *io_path;
+	struct nvme_qpair *nvme_qpair;
+	struct ut_nvme_req *req;
 	int rc;
 
 	memset(attached_names, 0, sizeof(char *) * STRING_SIZE);
-	ut_init_trid(&trid);
+	ut_init_trid(&path.trid);
 
 	set_thread(0);
 
-	ctrlr = ut_attach_ctrlr(&trid, 1, true, false);
+	ctrlr = ut_attach_ctrlr(&path.trid, 1, false, false);
 	SPDK_CU_ASSERT_FATAL(ctrlr != NULL);
 
-	ctrlr->ns[0].ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
-
 	g_ut_attach_ctrlr_status = 0;
 	g_ut_attach_bdev_count = 1;
 
-	rc = bdev_nvme_create(&trid, "nvme0", attached_names, STRING_SIZE,
+	rc = bdev_nvme_create(&path.trid, "nvme0", attached_names, STRING_SIZE,
 			      attach_ctrlr_done, NULL, NULL, NULL, false);
 	CU_ASSERT(rc == 0);
 
 	spdk_delay_us(1000);
 	poll_threads();
 
-	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
-	poll_threads();
+	nbdev_ctrlr = nvme_bdev_ctrlr_get_by_name("nvme0");
+	SPDK_CU_ASSERT_FATAL(nbdev_ctrlr != NULL);
 
-	nvme_ctrlr = nvme_ctrlr_get_by_name("nvme0");
-	SPDK_CU_ASSERT_FATAL(nvme_ctrlr != NULL);
+	nvme_ctrlr = nvme_bdev_ctrlr_get_ctrlr(nbdev_ctrlr, &path.trid);
+	CU_ASSERT(nvme_ctrlr != NULL);
 
-	nvme_ctrlr_read_ana_log_page(nvme_ctrlr);
+	bdev = nvme_bdev_ctrlr_get_bdev(nbdev_ctrlr, 1);
+	CU_ASSERT(bdev != NULL);
 
-	CU_ASSERT(nvme_ctrlr->ana_log_page_updating == true);
-	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 1);
+	bdev_io = ut_alloc_bdev_io(SPDK_BDEV_IO_TYPE_WRITE, bdev, NULL);
+	ut_bdev_io_set_buf(bdev_io);
 
-	/* Following read request should be rejected. */
-	nvme_ctrlr_read_ana_log_page(nvme_ctrlr);
+	bio = (struct nvme_bdev_io *)bdev_io->driver_ctx;
 
-	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 1);
+	ch = spdk_get_io_channel(bdev);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
 
-	set_thread(1);
+	nbdev_ch = spdk_io_channel_get_ctx(ch);
 
-	nvme_ctrlr_read_ana_log_page(nvme_ctrlr);
+	io_path = ut_get_io_path_by_ctrlr(nbdev_ch, nvme_ctrlr);
+	SPDK_CU_ASSERT_FATAL(io_path != NULL);
 
-	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 1);
+	nvme_qpair = io_path->qpair;
+	SPDK_CU_ASSERT_FATAL(nvme_qpair != NULL);
+	SPDK_CU_ASSERT_FATAL(nvme_qpair->qpair != NULL);
+	CU_ASSERT(nvme_qpair->retry_tokens == BDEV_NVME_RETRY_TOKENS_MAX);
 
-	/* Reset request while reading ANA log page should not be rejected. */
-	rc = bdev_nvme_reset(nvme_ctrlr);
-	CU_ASSERT(rc == 0);
+	bdev_io->internal.ch = (struct spdk_bdev_channel *)ch;
 
-	poll_threads();
-	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
-	poll_threads();
-	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
-	poll_threads();
+	g_opts.bdev_retry_count = -1;
+	g_opts.bdev_retry_budget_percent = 50;
 
-	CU_ASSERT(nvme_ctrlr->ana_log_page_updating == false);
-	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 0);
+	/* Enough tokens are left for one retry. The retry succeeds and earns half a retry. */
+	nvme_qpair->retry_tokens = BDEV_NVME_RETRY_TOKEN_COST;
 
-	/* Read ANA log page while resetting ctrlr should be rejected. */
-	rc = bdev_nvme_reset(nvme_ctrlr);
-	CU_ASSERT(rc == 0);
+	bdev_io->internal.in_submit_request = true;
 
-	nvme_ctrlr_read_ana_log_page(nvme_ctrlr);
+	bdev_nvme_submit_request(ch, bdev_io);
 
-	CU_ASSERT(nvme_ctrlr->ana_log_page_updating == false);
+	req = ut_get_outstanding_nvme_request(nvme_qpair->qpair, bio);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+
+	req->cpl.status.sc = SPDK_NVME_SC_NAMESPACE_NOT_READY;
+	req->cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+
+	poll_thread_times(0, 1);
+
+	CU_ASSERT(bdev_io->internal.in_submit_request == true);
+	CU_ASSERT(bdev_io == TAILQ_FIRST(&nbdev_ch->retry_io_list));
+	CU_ASSERT(nvme_qpair->retry_tokens == 0);
 
 	poll_threads();
-	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+
+	CU_ASSERT(bdev_io->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(nvme_qpair->retry_tokens == 50);
+
+	/* The budget is exhausted, the failed I/O should not be retried. */
+	bdev_io->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io);
+
+	req = ut_get_outstanding_nvme_request(nvme_qpair->qpair, bio);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+
+	req->cpl.status.sc = SPDK_NVME_SC_NAMESPACE_NOT_READY;
+	req->cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+
+	poll_thread_times(0, 1);
+
+	CU_ASSERT(nvme_qpair->qpair->num_outstanding_reqs == 0);
+	CU_ASSERT(bdev_io->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_NVME_ERROR);
+	CU_ASSERT(nvme_qpair->retry_tokens == 50);
+
+	/* Without a budget, the failed I/O should be retried. */
+	g_opts.bdev_retry_budget_percent = 0;
+
+	bdev_io->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io);
+
+	req = ut_get_outstanding_nvme_request(nvme_qpair->qpair, bio);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+
+	req->cpl.status.sc = SPDK_NVME_SC_NAMESPACE_NOT_READY;
+	req->cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+
+	poll_thread_times(0, 1);
+
+	CU_ASSERT(bdev_io->internal.in_submit_request == true);
+	CU_ASSERT(bdev_io == TAILQ_FIRST(&nbdev_ch->retry_io_list));
+
 	poll_threads();
 
-	set_thread(0);
+	CU_ASSERT(bdev_io->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	free(bdev_io);
+
+	spdk_put_io_channel(ch);
+
+	poll_threads();
 
 	rc = bdev_nvme_delete("nvme0", &g_any_path);
 	CU_ASSERT(rc == 0);
@@ -4848,11 +5078,13 @@ test_concurrent_read_ana_log_page(void)
 	spdk_delay_us(1000);
 	poll_threads();
 
-	CU_ASSERT(nvme_ctrlr_get_by_name("nvme0") == NULL);
+	CU_ASSERT(nvme_bdev_ctrlr_get_by_name("nvme0") == NULL);
+
+	g_opts.bdev_retry_count = 0;
 }
 
 static void
-test_retry_io_for_ana_error(void)
+test_adaptive_timeout(void)
 {
 	struct nvme_path_id path = {};
 	struct spdk_nvme_ctrlr *ctrlr;
@@ -4861,25 +5093,495 @@ test_retry_io_for_ana_error(void)
 	const int STRING_SIZE = 32;
 	const char *attached_names[STRING_SIZE];
 	struct nvme_bdev *bdev;
-	struct nvme_ns *nvme_ns;
-	struct spdk_bdev_io *bdev_io;
-	struct nvme_bdev_io *bio;
 	struct spdk_io_channel *ch;
 	struct nvme_bdev_channel *nbdev_ch;
 	struct nvme_io_path *io_path;
 	struct nvme_qpair *nvme_qpair;
-	struct ut_nvme_req *req;
-	uint64_t now;
 	int rc;
 
 	memset(attached_names, 0, sizeof(char *) * STRING_SIZE);
 	ut_init_trid(&path.trid);
 
-	g_opts.bdev_retry_count = 1;
-
 	set_thread(0);
 
-	ctrlr = ut_attach_ctrlr(&path.trid, 1, true, false);
+	g_opts.timeout_us = 1000000;
+	g_opts.adaptive_timeout_multiplier = 4;
+
+	ctrlr = ut_attach_ctrlr(&path.trid, 1, false, false);
+	SPDK_CU_ASSERT_FATAL(ctrlr != NULL);
+
+	g_ut_attach_ctrlr_status = 0;
+	g_ut_attach_bdev_count = 1;
+
+	rc = bdev_nvme_create(&path.trid, "nvme0", attached_names, STRING_SIZE,
+			      attach_ctrlr_done, NULL, NULL, NULL, false);
+	CU_ASSERT(rc == 0);
+
+	spdk_delay_us(1000);
+	poll_threads();
+
+	nbdev_ctrlr = nvme_bdev_ctrlr_get_by_name("nvme0");
+	SPDK_CU_ASSERT_FATAL(nbdev_ctrlr != NULL);
+
+	nvme_ctrlr = nvme_bdev_ctrlr_get_ctrlr(nbdev_ctrlr, &path.trid);
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr != NULL);
+	CU_ASSERT(nvme_ctrlr->timeout_io_us == 1000000);
+	CU_ASSERT(nvme_ctrlr->adaptive_timeout_poller != NULL);
+
+	bdev = nvme_bdev_ctrlr_get_bdev(nbdev_ctrlr, 1);
+	CU_ASSERT(bdev != NULL);
+
+	ch = spdk_get_io_channel(bdev);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	nbdev_ch = spdk_io_channel_get_ctx(ch);
+
+	io_path = ut_get_io_path_by_ctrlr(nbdev_ch, nvme_ctrlr);
+	SPDK_CU_ASSERT_FATAL(io_path != NULL);
+
+	nvme_qpair = io_path->qpair;
+	SPDK_CU_ASSERT_FATAL(nvme_qpair != NULL);
+
+	/* p99 latency is less than 8192 us, the timeout is 4 times that. 1 tick is 1 us here. */
+	nvme_qpair->latency_buckets[11] = 90;
+	nvme_qpair->latency_buckets[12] = 9;
+	nvme_qpair->latency_buckets[18] = 1;
+
+	spdk_delay_us(BDEV_NVME_ADAPTIVE_TIMEOUT_PERIOD_US);
+	poll_threads();
+
+	CU_ASSERT(nvme_ctrlr->timeout_io_us == 4 * 8192);
+	CU_ASSERT(nvme_qpair->latency_buckets[12] == 0);
+	CU_ASSERT(nvme_ctrlr->timeout_updating == false);
+
+	/* Too few samples, the timeout is kept. */
+	nvme_qpair->latency_buckets[18] = 99;
+
+	spdk_delay_us(BDEV_NVME_ADAPTIVE_TIMEOUT_PERIOD_US);
+	poll_threads();
+
+	CU_ASSERT(nvme_ctrlr->timeout_io_us == 4 * 8192);
+
+	/* The timeout doesn't go below the minimum. */
+	nvme_qpair->latency_buckets[2] = 100;
+
+	spdk_delay_us(BDEV_NVME_ADAPTIVE_TIMEOUT_PERIOD_US);
+	poll_threads();
+
+	CU_ASSERT(nvme_ctrlr->timeout_io_us == BDEV_NVME_ADAPTIVE_TIMEOUT_MIN_US);
+
+	/* timeout_us is the upper bound. */
+	nvme_qpair->latency_buckets[20] = 100;
+
+	spdk_delay_us(BDEV_NVME_ADAPTIVE_TIMEOUT_PERIOD_US);
+	poll_threads();
+
+	CU_ASSERT(nvme_ctrlr->timeout_io_us == 1000000);
+
+	spdk_put_io_channel(ch);
+
+	poll_threads();
+
+	rc = bdev_nvme_delete("nvme0", &g_any_path);
+	CU_ASSERT(rc == 0);
+
+	poll_threads();
+	spdk_delay_us(1000);
+	poll_threads();
+
+	CU_ASSERT(nvme_bdev_ctrlr_get_by_name("nvme0") == NULL);
+
+	g_opts.timeout_us = 0;
+	g_opts.adaptive_timeout_multiplier = 0;
+}
+
+/* Take a request out of its qpair, as if the device were slow to complete it. */
+static struct ut_nvme_req *
+ut_hold_nvme_request(struct spdk_nvme_qpair *qpair, void *cb_arg)
+{
+	struct ut_nvme_req *req;
+
+	req = ut_get_outstanding_nvme_request(qpair, cb_arg);
+	SPDK_CU_ASSERT_FATAL(req != NULL);
+
+	TAILQ_REMOVE(&qpair->outstanding_reqs, req, tailq);
+	qpair->num_outstanding_reqs--;
+
+	return req;
+}
+
+static void
+ut_release_nvme_request(struct ut_nvme_req *req)
+{
+	req->cb_fn(req->cb_arg, &req->cpl);
+	free(req);
+}
+
+static void
+test_hedged_read(void)
+{
+	struct nvme_path_id path1 = {}, path2 = {};
+	struct spdk_nvme_ctrlr *ctrlr1, *ctrlr2;
+	struct nvme_bdev_ctrlr *nbdev_ctrlr;
+	struct nvme_ctrlr *nvme_ctrlr1, *nvme_ctrlr2;
+	const int STRING_SIZE = 32;
+	const char *attached_names[STRING_SIZE];
+	struct nvme_bdev *bdev;
+	struct spdk_bdev_io *bdev_io;
+	struct nvme_bdev_io *bio;
+	struct spdk_io_channel *ch;
+	struct nvme_bdev_channel *nbdev_ch;
+	struct nvme_io_path *io_path1, *io_path2;
+	struct spdk_nvme_qpair *qpair1, *qpair2;
+	struct nvme_hedged_read *hedged_read;
+	struct ut_nvme_req *req1, *req2;
+	struct spdk_uuid uuid1 = { .u.raw = { 0x1 } };
+	char buf[4096];
+	int rc;
+
+	memset(attached_names, 0, sizeof(char *) * STRING_SIZE);
+	ut_init_trid(&path1.trid);
+	ut_init_trid2(&path2.trid);
+
+	g_opts.hedged_read_percentile = 90;
+
+	set_thread(0);
+
+	g_ut_attach_ctrlr_status = 0;
+	g_ut_attach_bdev_count = 1;
+
+	ctrlr1 = ut_attach_ctrlr(&path1.trid, 1, true, true);
+	SPDK_CU_ASSERT_FATAL(ctrlr1 != NULL);
+
+	ctrlr1->ns[0].uuid = &uuid1;
+
+	rc = bdev_nvme_create(&path1.trid, "nvme0", attached_names, STRING_SIZE,
+			      attach_ctrlr_done, NULL, NULL, NULL, true);
+	CU_ASSERT(rc == 0);
+
+	spdk_delay_us(1000);
+	poll_threads();
+
+	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+	poll_threads();
+
+	ctrlr2 = ut_attach_ctrlr(&path2.trid, 1, true, true);
+	SPDK_CU_ASSERT_FATAL(ctrlr2 != NULL);
+
+	ctrlr2->ns[0].uuid = &uuid1;
+
+	rc = bdev_nvme_create(&path2.trid, "nvme0", attached_names, STRING_SIZE,
+			      attach_ctrlr_done, NULL, NULL, NULL, true);
+	CU_ASSERT(rc == 0);
+
+	spdk_delay_us(1000);
+	poll_threads();
+
+	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+	poll_threads();
+
+	nbdev_ctrlr = nvme_bdev_ctrlr_get_by_name("nvme0");
+	SPDK_CU_ASSERT_FATAL(nbdev_ctrlr != NULL);
+
+	nvme_ctrlr1 = nvme_bdev_ctrlr_get_ctrlr(nbdev_ctrlr, &path1.trid);
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr1 != NULL);
+
+	nvme_ctrlr2 = nvme_bdev_ctrlr_get_ctrlr(nbdev_ctrlr, &path2.trid);
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr2 != NULL);
+
+	bdev = nvme_bdev_ctrlr_get_bdev(nbdev_ctrlr, 1);
+	SPDK_CU_ASSERT_FATAL(bdev != NULL);
+
+	ch = spdk_get_io_channel(bdev);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	nbdev_ch = spdk_io_channel_get_ctx(ch);
+	CU_ASSERT(nbdev_ch->hedge_poller != NULL);
+
+	io_path1 = ut_get_io_path_by_ctrlr(nbdev_ch, nvme_ctrlr1);
+	SPDK_CU_ASSERT_FATAL(io_path1 != NULL);
+	qpair1 = io_path1->qpair->qpair;
+	SPDK_CU_ASSERT_FATAL(qpair1 != NULL);
+
+	io_path2 = ut_get_io_path_by_ctrlr(nbdev_ch, nvme_ctrlr2);
+	SPDK_CU_ASSERT_FATAL(io_path2 != NULL);
+	qpair2 = io_path2->qpair->qpair;
+	SPDK_CU_ASSERT_FATAL(qpair2 != NULL);
+
+	bdev->disk.blocklen = 512;
+
+	bdev_io = ut_alloc_bdev_io(SPDK_BDEV_IO_TYPE_READ, bdev, ch);
+	ut_bdev_io_set_buf(bdev_io);
+	bdev_io->iov.iov_base = buf;
+	bdev_io->u.bdev.num_blocks = 1;
+
+	bio = (struct nvme_bdev_io *)bdev_io->driver_ctx;
+
+	/* Reads are not hedged until the threshold is known. */
+	bdev_io->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io);
+
+	CU_ASSERT(bio->num_hedged_reads == 0);
+	CU_ASSERT(TAILQ_EMPTY(&nbdev_ch->hedge_list));
+	CU_ASSERT(ut_get_outstanding_nvme_request(bio->io_path->qpair->qpair, bio) != NULL);
+
+	poll_threads();
+
+	CU_ASSERT(bdev_io->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(nbdev_ch->hedge_sample_count == 1);
+
+	/* Nor in active-passive mode. */
+	nbdev_ch->hedge_threshold_ticks = 100;
+
+	bdev_io->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io);
+
+	CU_ASSERT(bio->num_hedged_reads == 0);
+
+	poll_threads();
+
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	nbdev_ch->mp_policy = BDEV_NVME_MP_POLICY_ACTIVE_ACTIVE;
+	nbdev_ch->current_io_path = io_path1;
+
+	/* The first read completes in time, no duplicate is sent. */
+	bdev_io->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io);
+
+	CU_ASSERT(bio->num_hedged_reads == 1);
+	CU_ASSERT(bio == TAILQ_FIRST(&nbdev_ch->hedge_list));
+	CU_ASSERT(qpair1->num_outstanding_reqs + qpair2->num_outstanding_reqs == 1);
+
+	poll_threads();
+
+	CU_ASSERT(bdev_io->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(bio->num_hedged_reads == 0);
+	CU_ASSERT(TAILQ_EMPTY(&nbdev_ch->hedge_list));
+
+	/* The first read is slow, the duplicate on the other path completes the I/O.
+	 * The first read is aborted and freed once it completes.
+	 */
+	nbdev_ch->current_io_path = io_path1;
+
+	bdev_io->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io);
+
+	CU_ASSERT(bio->num_hedged_reads == 1);
+	hedged_read = bio->hedged_reads[0];
+	CU_ASSERT(hedged_read->io_path == io_path1);
+	req1 = ut_hold_nvme_request(qpair1, hedged_read);
+
+	spdk_delay_us(100);
+	poll_threads();
+
+	CU_ASSERT(bdev_io->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(bio->io_path == io_path2);
+	CU_ASSERT(bio->num_hedged_reads == 0);
+	CU_ASSERT(TAILQ_EMPTY(&nbdev_ch->hedge_list));
+	CU_ASSERT(hedged_read->bio == NULL);
+
+	ut_release_nvme_request(req1);
+
+	/* The first read completes after the duplicate was sent, the duplicate is aborted. */
+	nbdev_ch->current_io_path = io_path1;
+
+	bdev_io->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io);
+
+	req1 = ut_hold_nvme_request(qpair1, bio->hedged_reads[0]);
+
+	spdk_delay_us(100);
+	poll_thread_times(0, 1);
+
+	CU_ASSERT(bio->num_hedged_reads == 2);
+	CU_ASSERT(bdev_io->internal.in_submit_request == true);
+	hedged_read = bio->hedged_reads[1];
+	CU_ASSERT(hedged_read->io_path == io_path2);
+	req2 = ut_hold_nvme_request(qpair2, hedged_read);
+
+	ut_release_nvme_request(req1);
+
+	CU_ASSERT(bdev_io->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(bio->io_path == io_path1);
+	CU_ASSERT(hedged_read->bio == NULL);
+
+	ut_release_nvme_request(req2);
+
+	/* If the first read fails, the I/O waits for the duplicate. */
+	nbdev_ch->current_io_path = io_path1;
+
+	bdev_io->internal.in_submit_request = true;
+
+	bdev_nvme_submit_request(ch, bdev_io);
+
+	req1 = ut_hold_nvme_request(qpair1, bio->hedged_reads[0]);
+
+	spdk_delay_us(100);
+	poll_thread_times(0, 1);
+
+	CU_ASSERT(bio->num_hedged_reads == 2);
+	req2 = ut_hold_nvme_request(qpair2, bio->hedged_reads[1]);
+
+	req1->cpl.status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+	ut_release_nvme_request(req1);
+
+	CU_ASSERT(bdev_io->internal.in_submit_request == true);
+	CU_ASSERT(bio->num_hedged_reads == 1);
+
+	ut_release_nvme_request(req2);
+
+	CU_ASSERT(bdev_io->internal.in_submit_request == false);
+	CU_ASSERT(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(bio->io_path == io_path2);
+
+	poll_threads();
+
+	free(bdev_io);
+
+	spdk_put_io_channel(ch);
+
+	poll_threads();
+
+	rc = bdev_nvme_delete("nvme0", &g_any_path);
+	CU_ASSERT(rc == 0);
+
+	poll_threads();
+	spdk_delay_us(1000);
+	poll_threads();
+
+	CU_ASSERT(nvme_bdev_ctrlr_get_by_name("nvme0") == NULL);
+
+	g_opts.hedged_read_percentile = 0;
+}
+
+static void
+test_concurrent_read_ana_log_page(void)
+{
+	struct spdk_nvme_transport_id trid = {};
+	struct spdk_nvme_ctrlr *ctrlr;
+	struct nvme_ctrlr *nvme_ctrlr;
+	const int STRING_SIZE = 32;
+	const char *attached_names[STRING_SIZE];
+	int rc;
+
+	memset(attached_names, 0, sizeof(char *) * STRING_SIZE);
+	ut_init_trid(&trid);
+
+	set_thread(0);
+
+	ctrlr = ut_attach_ctrlr(&trid, 1, true, false);
+	SPDK_CU_ASSERT_FATAL(ctrlr != NULL);
+
+	ctrlr->ns[0].ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+
+	g_ut_attach_ctrlr_status = 0;
+	g_ut_attach_bdev_count = 1;
+
+	rc = bdev_nvme_create(&trid, "nvme0", attached_names, STRING_SIZE,
+			      attach_ctrlr_done, NULL, NULL, NULL, false);
+	CU_ASSERT(rc == 0);
+
+	spdk_delay_us(1000);
+	poll_threads();
+
+	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+	poll_threads();
+
+	nvme_ctrlr = nvme_ctrlr_get_by_name("nvme0");
+	SPDK_CU_ASSERT_FATAL(nvme_ctrlr != NULL);
+
+	nvme_ctrlr_read_ana_log_page(nvme_ctrlr);
+
+	CU_ASSERT(nvme_ctrlr->ana_log_page_updating == true);
+	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 1);
+
+	/* Following read request should be rejected. */
+	nvme_ctrlr_read_ana_log_page(nvme_ctrlr);
+
+	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 1);
+
+	set_thread(1);
+
+	nvme_ctrlr_read_ana_log_page(nvme_ctrlr);
+
+	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 1);
+
+	/* Reset request while reading ANA log page should not be rejected. */
+	rc = bdev_nvme_reset(nvme_ctrlr);
+	CU_ASSERT(rc == 0);
+
+	poll_threads();
+	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+	poll_threads();
+	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+	poll_threads();
+
+	CU_ASSERT(nvme_ctrlr->ana_log_page_updating == false);
+	CU_ASSERT(ctrlr->adminq.num_outstanding_reqs == 0);
+
+	/* Read ANA log page while resetting ctrlr should be rejected. */
+	rc = bdev_nvme_reset(nvme_ctrlr);
+	CU_ASSERT(rc == 0);
+
+	nvme_ctrlr_read_ana_log_page(nvme_ctrlr);
+
+	CU_ASSERT(nvme_ctrlr->ana_log_page_updating == false);
+
+	poll_threads();
+	spdk_delay_us(g_opts.nvme_adminq_poll_period_us);
+	poll_threads();
+
+	set_thread(0);
+
+	rc = bdev_nvme_delete("nvme0", &g_any_path);
+	CU_ASSERT(rc == 0);
+
+	poll_threads();
+	spdk_delay_us(1000);
+	poll_threads();
+
+	CU_ASSERT(nvme_ctrlr_get_by_name("nvme0") == NULL);
+}
+
+static void
+test_retry_io_for_ana_error(void)
+{
+	struct nvme_path_id path = {};
+	struct spdk_nvme_ctrlr *ctrlr;
+	struct nvme_bdev_ctrlr *nbdev_ctrlr;
+	struct nvme_ctrlr *nvme_ctrlr;
+	const int STRING_SIZE = 32;
+	const char *attached_names[STRING_SIZE];
+	struct nvme_bdev *bdev;
+	struct nvme_ns *nvme_ns;
+	struct spdk_bdev_io *bdev_io;
+	struct nvme_bdev_io *bio;
+	struct spdk_io_channel *ch;
+	struct nvme_bdev_channel *nbdev_ch;
+	struct nvme_io_path *io_path;
+	struct nvme_qpair *nvme_qpair;
+	struct ut_nvme_req *req;
+	uint64_t now;
+	int rc;
+
+	memset(attached_names, 0, sizeof(char *) * STRING_SIZE);
+	ut_init_trid(&path.trid);
+
+	g_opts.bdev_retry_count = 1;
+
+	set_thread(0);
+
+	ctrlr = ut_attach_ctrlr(&path.trid, 1, true, false);
 	SPDK_CU_ASSERT_FATAL(ctrlr != NULL);
 
 	g_ut_attach_ctrlr_status = 0;
@@ -5145,34 +5847,13 @@ test_retry_io_if_ctrlr_is_resetting(void)
 	CU_ASSERT(nvme_qpair->qpair != NULL);
 	CU_ASSERT(nvme_ctrlr->resetting == false);
 
-	spdk_delay_us(999999 - g_opts.nvme_adminq_poll_period_us);
-
-	poll_thread_times(0, 1);
-
-	CU_ASSERT(nvme_qpair->qpair->num_outstanding_reqs == 1);
-	CU_ASSERT(bdev_io1->internal.in_submit_request == true);
-	CU_ASSERT(bdev_io2->internal.in_submit_request == true);
-	CU_ASSERT(bdev_io2 == TAILQ_FIRST(&nbdev_ch->retry_io_list));
-
-	poll_threads();
-
+	/* The queued I/Os are retried as soon as the reset completes, without
+	 * waiting for their retry delay to expire.
+	 */
+	CU_ASSERT(TAILQ_EMPTY(&nbdev_ch->retry_io_list));
 	CU_ASSERT(nvme_qpair->qpair->num_outstanding_reqs == 0);
 	CU_ASSERT(bdev_io1->internal.in_submit_request == false);
 	CU_ASSERT(bdev_io1->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
-	CU_ASSERT(bdev_io2->internal.in_submit_request == true);
-	CU_ASSERT(bdev_io2 == TAILQ_FIRST(&nbdev_ch->retry_io_list));
-
-	spdk_delay_us(1);
-
-	poll_thread_times(0, 1);
-
-	CU_ASSERT(nvme_qpair->qpair->num_outstanding_reqs == 1);
-	CU_ASSERT(bdev_io2->internal.in_submit_request == true);
-	CU_ASSERT(TAILQ_EMPTY(&nbdev_ch->retry_io_list));
-
-	poll_threads();
-
-	CU_ASSERT(nvme_qpair->qpair->num_outstanding_reqs == 0);
 	CU_ASSERT(bdev_io2->internal.in_submit_request == false);
 	CU_ASSERT(bdev_io2->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
 
@@ -5995,6 +6676,166 @@ test_find_io_path_min_qd(void)
 	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
 }
 
+static void
+test_find_io_path_min_latency(void)
+{
+	struct nvme_bdev_channel nbdev_ch = {
+		.io_path_list = STAILQ_HEAD_INITIALIZER(nbdev_ch.io_path_list),
+		.mp_policy = BDEV_NVME_MP_POLICY_ACTIVE_ACTIVE,
+		.mp_selector = BDEV_NVME_MP_SELECTOR_LATENCY,
+	};
+	struct spdk_nvme_qpair qpair1 = {}, qpair2 = {}, qpair3 = {};
+	struct spdk_nvme_ctrlr ctrlr1 = {}, ctrlr2 = {}, ctrlr3 = {};
+	struct nvme_ctrlr nvme_ctrlr1 = { .ctrlr = &ctrlr1, };
+	struct nvme_ctrlr nvme_ctrlr2 = { .ctrlr = &ctrlr2, };
+	struct nvme_ctrlr nvme_ctrlr3 = { .ctrlr = &ctrlr3, };
+	struct nvme_ctrlr_channel ctrlr_ch1 = {};
+	struct nvme_ctrlr_channel ctrlr_ch2 = {};
+	struct nvme_ctrlr_channel ctrlr_ch3 = {};
+	struct nvme_qpair nvme_qpair1 = { .ctrlr_ch = &ctrlr_ch1, .ctrlr = &nvme_ctrlr1, .qpair = &qpair1, };
+	struct nvme_qpair nvme_qpair2 = { .ctrlr_ch = &ctrlr_ch2, .ctrlr = &nvme_ctrlr2, .qpair = &qpair2, };
+	struct nvme_qpair nvme_qpair3 = { .ctrlr_ch = &ctrlr_ch3, .ctrlr = &nvme_ctrlr3, .qpair = &qpair3, };
+	struct nvme_ns nvme_ns1 = {}, nvme_ns2 = {}, nvme_ns3 = {};
+	struct nvme_io_path io_path1 = { .qpair = &nvme_qpair1, .nvme_ns = &nvme_ns1, };
+	struct nvme_io_path io_path2 = { .qpair = &nvme_qpair2, .nvme_ns = &nvme_ns2, };
+	struct nvme_io_path io_path3 = { .qpair = &nvme_qpair3, .nvme_ns = &nvme_ns3, };
+	struct nvme_bdev_io bio = {};
+	uint32_t i;
+
+	STAILQ_INSERT_TAIL(&nbdev_ch.io_path_list, &io_path1, stailq);
+	STAILQ_INSERT_TAIL(&nbdev_ch.io_path_list, &io_path2, stailq);
+	STAILQ_INSERT_TAIL(&nbdev_ch.io_path_list, &io_path3, stailq);
+	io_path1.nbdev_ch = &nbdev_ch;
+	io_path2.nbdev_ch = &nbdev_ch;
+	io_path3.nbdev_ch = &nbdev_ch;
+
+	/* The lowest latency or the ANA optimized state is prioritized */
+	io_path1.latency_ewma_ticks = 80;
+	io_path2.latency_ewma_ticks = 50;
+	io_path3.latency_ewma_ticks = 10;
+	nvme_ns1.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nvme_ns2.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nvme_ns3.ana_state = SPDK_NVME_ANA_NON_OPTIMIZED_STATE;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
+
+	nvme_ns1.ana_state = SPDK_NVME_ANA_NON_OPTIMIZED_STATE;
+	nvme_ns2.ana_state = SPDK_NVME_ANA_NON_OPTIMIZED_STATE;
+	nvme_ns3.ana_state = SPDK_NVME_ANA_INACCESSIBLE_STATE;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
+
+	nvme_ns1.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nvme_ns2.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
+
+	/* Completions update the average latency of the path */
+	bio.io_path = &io_path2;
+	bio.submit_tsc = spdk_get_ticks() - 850;
+	bdev_nvme_update_io_path_latency(&bio);
+	CU_ASSERT(io_path2.latency_ewma_ticks == 50 - 50 / 8 + 850 / 8);
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+
+	/* A path without any sample is tried first */
+	io_path2.latency_ewma_ticks = 0;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
+	bio.submit_tsc = spdk_get_ticks() - 100;
+	bdev_nvme_update_io_path_latency(&bio);
+	CU_ASSERT(io_path2.latency_ewma_ticks == 100);
+
+	/* The slower path is periodically probed */
+	nbdev_ch.latency_probe_counter = 0;
+	nbdev_ch.current_io_path = &io_path1;
+	for (i = 1; i < BDEV_NVME_LATENCY_PROBE_INTERVAL; i++) {
+		CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+	}
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+}
+
+static void
+test_find_io_path_numa(void)
+{
+	struct nvme_bdev_channel nbdev_ch = {
+		.io_path_list = STAILQ_HEAD_INITIALIZER(nbdev_ch.io_path_list),
+		.mp_policy = BDEV_NVME_MP_POLICY_ACTIVE_ACTIVE,
+		.mp_selector = BDEV_NVME_MP_SELECTOR_ROUND_ROBIN,
+	};
+	struct spdk_nvme_qpair qpair1 = {}, qpair2 = {}, qpair3 = {};
+	struct spdk_nvme_ctrlr ctrlr1 = {}, ctrlr2 = {}, ctrlr3 = {};
+	struct nvme_ctrlr nvme_ctrlr1 = { .ctrlr = &ctrlr1, };
+	struct nvme_ctrlr nvme_ctrlr2 = { .ctrlr = &ctrlr2, };
+	struct nvme_ctrlr nvme_ctrlr3 = { .ctrlr = &ctrlr3, };
+	struct nvme_ctrlr_channel ctrlr_ch1 = {};
+	struct nvme_ctrlr_channel ctrlr_ch2 = {};
+	struct nvme_ctrlr_channel ctrlr_ch3 = {};
+	struct nvme_qpair nvme_qpair1 = { .ctrlr_ch = &ctrlr_ch1, .ctrlr = &nvme_ctrlr1, .qpair = &qpair1, };
+	struct nvme_qpair nvme_qpair2 = { .ctrlr_ch = &ctrlr_ch2, .ctrlr = &nvme_ctrlr2, .qpair = &qpair2, };
+	struct nvme_qpair nvme_qpair3 = { .ctrlr_ch = &ctrlr_ch3, .ctrlr = &nvme_ctrlr3, .qpair = &qpair3, };
+	struct nvme_ns nvme_ns1 = {}, nvme_ns2 = {}, nvme_ns3 = {};
+	struct nvme_io_path io_path1 = { .qpair = &nvme_qpair1, .nvme_ns = &nvme_ns1, };
+	struct nvme_io_path io_path2 = { .qpair = &nvme_qpair2, .nvme_ns = &nvme_ns2, };
+	struct nvme_io_path io_path3 = { .qpair = &nvme_qpair3, .nvme_ns = &nvme_ns3, };
+
+	/* Unknown NUMA nodes don't restrict the choice */
+	MOCK_SET(spdk_env_get_current_core, 0);
+	MOCK_SET(spdk_env_get_socket_id, 1);
+	CU_ASSERT(nvme_ctrlr_is_numa_local(&nvme_ctrlr1) == true);
+	MOCK_SET(spdk_nvme_ctrlr_get_socket_id, 1);
+	CU_ASSERT(nvme_ctrlr_is_numa_local(&nvme_ctrlr1) == true);
+	MOCK_SET(spdk_nvme_ctrlr_get_socket_id, 0);
+	CU_ASSERT(nvme_ctrlr_is_numa_local(&nvme_ctrlr1) == false);
+	MOCK_SET(spdk_env_get_current_core, SPDK_ENV_LCORE_ID_ANY);
+	CU_ASSERT(nvme_ctrlr_is_numa_local(&nvme_ctrlr1) == true);
+	MOCK_CLEAR(spdk_nvme_ctrlr_get_socket_id);
+	MOCK_CLEAR(spdk_env_get_socket_id);
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	STAILQ_INSERT_TAIL(&nbdev_ch.io_path_list, &io_path1, stailq);
+	STAILQ_INSERT_TAIL(&nbdev_ch.io_path_list, &io_path2, stailq);
+	STAILQ_INSERT_TAIL(&nbdev_ch.io_path_list, &io_path3, stailq);
+
+	nvme_ns1.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nvme_ns2.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nvme_ns3.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	io_path2.numa_local = true;
+	io_path3.numa_local = true;
+
+	/* Round-robin only goes through the local optimized paths */
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path3);
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
+
+	/* A remote optimized path is preferred over a local non-optimized one */
+	nvme_ns2.ana_state = SPDK_NVME_ANA_NON_OPTIMIZED_STATE;
+	nvme_ns3.ana_state = SPDK_NVME_ANA_INACCESSIBLE_STATE;
+	bdev_nvme_clear_current_io_path(&nbdev_ch);
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+
+	/* The local path is preferred among the non-optimized ones */
+	nvme_ns1.ana_state = SPDK_NVME_ANA_NON_OPTIMIZED_STATE;
+	bdev_nvme_clear_current_io_path(&nbdev_ch);
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path2);
+
+	/* Active-passive ignores the NUMA locality */
+	nvme_ns1.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nvme_ns2.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	nbdev_ch.mp_policy = BDEV_NVME_MP_POLICY_ACTIVE_PASSIVE;
+	bdev_nvme_clear_current_io_path(&nbdev_ch);
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+
+	/* The queue depth selector compares the queue depth of the local paths only */
+	nbdev_ch.mp_policy = BDEV_NVME_MP_POLICY_ACTIVE_ACTIVE;
+	nbdev_ch.mp_selector = BDEV_NVME_MP_SELECTOR_QUEUE_DEPTH;
+	nvme_ns3.ana_state = SPDK_NVME_ANA_OPTIMIZED_STATE;
+	qpair1.num_outstanding_reqs = 0;
+	qpair2.num_outstanding_reqs = 4;
+	qpair3.num_outstanding_reqs = 2;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path3);
+
+	io_path2.numa_local = false;
+	io_path3.numa_local = false;
+	CU_ASSERT(bdev_nvme_find_io_path(&nbdev_ch) == &io_path1);
+}
+
 static void
 test_disable_auto_failback(void)
 {
@@ -6267,6 +7108,63 @@ test_set_multipath_policy(void)
 	CU_ASSERT(nvme_ctrlr_get_by_name("nvme0") == NULL);
 }
 
+static void
+test_adaptive_poll_period(void)
+{
+	struct nvme_poll_group group = {};
+	int i;
+
+	g_opts.nvme_ioq_poll_period_us = 100;
+	g_opts.nvme_ioq_adaptive_poll_max_us = 1000;
+	g_opts.nvme_ioq_adaptive_poll_batch = 8;
+
+	set_thread(0);
+
+	group.poller = SPDK_POLLER_REGISTER(bdev_nvme_poll, &group, g_opts.nvme_ioq_poll_period_us);
+	SPDK_CU_ASSERT_FATAL(group.poller != NULL);
+	group.poll_period_us = g_opts.nvme_ioq_poll_period_us;
+
+	/* The period is kept until the end of the window. */
+	spdk_delay_us(1);
+	bdev_nvme_poll_group_adapt_period(&group, 0);
+	spdk_delay_us(NVME_ADAPTIVE_POLL_WINDOW_US - 1);
+	bdev_nvme_poll_group_adapt_period(&group, 0);
+	CU_ASSERT(group.poll_period_us == 100);
+
+	/* No completion in a whole window, go to the maximum. */
+	spdk_delay_us(1);
+	bdev_nvme_poll_group_adapt_period(&group, 0);
+	CU_ASSERT(group.poll_period_us == 1000);
+	CU_ASSERT(group.window_completions == 0);
+
+	/* 100 completions in 10ms, poll every 800us to reap 8 of them each time. */
+	for (i = 0; i < 25; i++) {
+		spdk_delay_us(NVME_ADAPTIVE_POLL_WINDOW_US / 25);
+		bdev_nvme_poll_group_adapt_period(&group, 4);
+	}
+	CU_ASSERT(group.poll_period_us == 800);
+	CU_ASSERT(group.window_completions == 0);
+
+	/* A full batch in a single poll goes back to the base period right away. */
+	spdk_delay_us(1);
+	bdev_nvme_poll_group_adapt_period(&group, 8);
+	CU_ASSERT(group.poll_period_us == 100);
+	CU_ASSERT(group.window_completions == 0);
+
+	/* High load never goes below the base period. */
+	for (i = 0; i < 1000; i++) {
+		spdk_delay_us(NVME_ADAPTIVE_POLL_WINDOW_US / 1000);
+		bdev_nvme_poll_group_adapt_period(&group, 7);
+	}
+	CU_ASSERT(group.poll_period_us == 100);
+
+	spdk_poller_unregister(&group.poller);
+	poll_threads();
+
+	g_opts.nvme_ioq_poll_period_us = 0;
+	g_opts.nvme_ioq_adaptive_poll_max_us = 0;
+}
+
 static void
 test_uuid_generation(void)
 {
@@ -6501,6 +7399,7 @@ main(int argc, const char **argv)
 	CU_ADD_TEST(suite, test_add_remove_trid);
 	CU_ADD_TEST(suite, test_abort);
 	CU_ADD_TEST(suite, test_get_io_qpair);
+	CU_ADD_TEST(suite, test_io_qpairs_per_ctrlr);
 	CU_ADD_TEST(suite, test_bdev_unregister);
 	CU_ADD_TEST(suite, test_compare_ns);
 	CU_ADD_TEST(suite, test_init_ana_log_page);
@@ -6515,6 +7414,10 @@ main(int argc, const char **argv)
 	CU_ADD_TEST(suite, test_retry_io_if_ana_state_is_updating);
 	CU_ADD_TEST(suite, test_retry_io_for_io_path_error);
 	CU_ADD_TEST(suite, test_retry_io_count);
+	CU_ADD_TEST(suite, test_retry_io_budget);
+	CU_ADD_TEST(suite, test_adaptive_timeout);
+	CU_ADD_TEST(suite, test_hedged_read);
+	CU_ADD_TEST(suite, test_adaptive_poll_period);
 	CU_ADD_TEST(suite, test_concurrent_read_ana_log_page);
 	CU_ADD_TEST(suite, test_retry_io_for_ana_error);
 	CU_ADD_TEST(suite, test_check_io_error_resiliency_params);
@@ -6527,6 +7430,8 @@ main(int argc, const char **argv)
 	CU_ADD_TEST(suite, test_set_preferred_path);
 	CU_ADD_TEST(suite, test_find_next_io_path);
 	CU_ADD_TEST(suite, test_find_io_path_min_qd);
+	CU_ADD_TEST(suite, test_find_io_path_min_latency);
+	CU_ADD_TEST(suite, test_find_io_path_numa);
 	CU_ADD_TEST(suite, test_disable_auto_failback);
 	CU_ADD_TEST(suite, test_set_multipath_policy);
 	CU_ADD_TEST(suite, test_uuid_generation);
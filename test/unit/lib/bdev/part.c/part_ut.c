@@ -31,6 +31,11 @@ static int g_accel_io_device;
 
 DEFINE_STUB(spdk_notify_send, uint64_t, (const char *type, const char *ctx), 0);
 DEFINE_STUB(spdk_notify_type_register, struct spdk_notify_type *, (const char *type), NULL);
+DEFINE_STUB_V(spdk_metrics_source_register, (struct spdk_metrics_source *source));
+DEFINE_STUB_V(spdk_metrics_write_family, (struct spdk_metrics_writer *w, const char *name,
+		enum spdk_metrics_type type, const char *help));
+DEFINE_STUB_V(spdk_metrics_write_value, (struct spdk_metrics_writer *w, const char *label,
+		const char *label_value, uint64_t value));
 DEFINE_STUB(spdk_memory_domain_get_dma_device_id, const char *, (struct spdk_memory_domain *domain),
 	    "test_domain");
 DEFINE_STUB(spdk_memory_domain_get_dma_device_type, enum spdk_dma_device_type,
@@ -126,9 +126,13 @@ DEFINE_STUB(spdk_bdev_is_md_interleaved, bool, (const struct spdk_bdev *bdev), f
 DEFINE_STUB(spdk_bdev_get_dif_type, enum spdk_dif_type, (const struct spdk_bdev *bdev),
 	    SPDK_DIF_DISABLE);
 DEFINE_STUB(spdk_bdev_is_dif_head_of_md, bool, (const struct spdk_bdev *bdev), false);
+DEFINE_STUB(spdk_bdev_get_socket_id, int32_t, (const struct spdk_bdev *bdev),
+	    SPDK_ENV_SOCKET_ID_ANY);
 DEFINE_STUB(spdk_bdev_notify_blockcnt_change, int, (struct spdk_bdev *bdev, uint64_t size), 0);
 DEFINE_STUB(spdk_bdev_first, struct spdk_bdev *, (void), NULL);
 DEFINE_STUB(spdk_bdev_next, struct spdk_bdev *, (struct spdk_bdev *prev), NULL);
+DEFINE_STUB(spdk_bdev_io_get_submit_tsc, uint64_t, (struct spdk_bdev_io *bdev_io), 0);
+DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
 DEFINE_STUB_V(raid_bdev_sb_update_crc, (struct raid_bdev_superblock *sb));
 
 int
@@ -2170,6 +2174,7 @@ test_raid_suspend_resume(void)
 	raid_bdev_resume(pbdev);
 	poll_threads();
 	CU_ASSERT(raid_ch->is_suspended == false);
+	complete_deferred_ios();
 	verify_io(bdev_io, req.base_bdevs.num_base_bdevs, raid_ch, pbdev, g_child_io_status_flag);
 
 	bdev_io_cleanup(bdev_io);
@@ -2187,6 +2192,120 @@ test_raid_suspend_resume(void)
 	reset_globals();
 }
 
+static void
+test_raid_process_window(void)
+{
+	struct rpc_bdev_raid_create req;
+	struct rpc_bdev_raid_delete destroy_req;
+	struct raid_bdev *pbdev;
+	struct spdk_io_channel *ch;
+	struct raid_bdev_io_channel *raid_ch, *ch_processed;
+	struct raid_bdev_io *raid_io;
+	struct spdk_bdev_io *bdev_io_read, *bdev_io_write, *bdev_io_held;
+
+	set_globals();
+	CU_ASSERT(raid_bdev_init() == 0);
+
+	verify_raid_bdev_present("raid1", false);
+	create_raid_bdev_create_req(&req, "raid1", 0, true, 0, false);
+	rpc_bdev_raid_create(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev(&req, true, RAID_BDEV_STATE_ONLINE);
+
+	TAILQ_FOREACH(pbdev, &g_raid_bdev_list, global_link) {
+		if (strcmp(pbdev->bdev.name, "raid1") == 0) {
+			break;
+		}
+	}
+	SPDK_CU_ASSERT_FATAL(pbdev != NULL);
+
+	ch = spdk_get_io_channel(pbdev);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	raid_ch = spdk_io_channel_get_ctx(ch);
+
+	/* Emulate a process with the first 64 blocks done and the next 64 being processed */
+	ch_processed = calloc(1, sizeof(*ch_processed));
+	SPDK_CU_ASSERT_FATAL(ch_processed != NULL);
+	ch_processed->num_channels = raid_ch->num_channels;
+	ch_processed->base_channel = calloc(raid_ch->num_channels,
+					    sizeof(struct spdk_io_channel *));
+	SPDK_CU_ASSERT_FATAL(ch_processed->base_channel != NULL);
+	memcpy(ch_processed->base_channel, raid_ch->base_channel,
+	       raid_ch->num_channels * sizeof(struct spdk_io_channel *));
+	ch_processed->process.parent = raid_ch;
+	TAILQ_INIT(&ch_processed->process.held_ios);
+	raid_ch->process.ch_processed = ch_processed;
+	raid_ch->process.offset = 64;
+	raid_ch->process.window_end = 128;
+
+	bdev_io_read = calloc(1, sizeof(struct spdk_bdev_io) + sizeof(struct raid_bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io_read != NULL);
+	bdev_io_write = calloc(1, sizeof(struct spdk_bdev_io) + sizeof(struct raid_bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io_write != NULL);
+	bdev_io_held = calloc(1, sizeof(struct spdk_bdev_io) + sizeof(struct raid_bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io_held != NULL);
+
+	memset(g_io_output, 0, ((g_max_io_size / g_strip_size) + 1) * sizeof(struct io_output));
+	g_io_output_index = 0;
+	g_bdev_io_defer_completion = true;
+
+	/* A read of the processed range goes through the processed channel */
+	bdev_io_initialize(bdev_io_read, ch, &pbdev->bdev, 0, 1, SPDK_BDEV_IO_TYPE_READ);
+	raid_bdev_submit_request(ch, bdev_io_read);
+	raid_io = (struct raid_bdev_io *)bdev_io_read->driver_ctx;
+	CU_ASSERT(raid_io->raid_ch == ch_processed);
+	CU_ASSERT(raid_io->process_gen == -1);
+
+	/* A write beyond the window is counted in the current generation */
+	bdev_io_initialize(bdev_io_write, ch, &pbdev->bdev, 256, 1, SPDK_BDEV_IO_TYPE_WRITE);
+	raid_bdev_submit_request(ch, bdev_io_write);
+	raid_io = (struct raid_bdev_io *)bdev_io_write->driver_ctx;
+	CU_ASSERT(raid_io->raid_ch == ch_processed);
+	CU_ASSERT(raid_io->process_gen == 0);
+	CU_ASSERT(raid_ch->process.num_ios[0] == 1);
+
+	/* A write to the window is held */
+	bdev_io_initialize(bdev_io_held, ch, &pbdev->bdev, 100, 1, SPDK_BDEV_IO_TYPE_WRITE);
+	raid_bdev_submit_request(ch, bdev_io_held);
+	CU_ASSERT(TAILQ_FIRST(&raid_ch->process.held_ios) ==
+		  (struct raid_bdev_io *)bdev_io_held->driver_ctx);
+	CU_ASSERT(raid_ch->num_ios == 2);
+	CU_ASSERT(ch_processed->num_ios == 2);
+
+	complete_deferred_ios();
+	CU_ASSERT(raid_ch->num_ios == 0);
+	CU_ASSERT(ch_processed->num_ios == 0);
+	CU_ASSERT(raid_ch->process.num_ios[0] == 0);
+
+	/* Once the window is done the held write is submitted to the processed range */
+	raid_ch->process.offset = 128;
+	raid_bdev_channel_process_resubmit_held(raid_ch);
+	CU_ASSERT(TAILQ_EMPTY(&raid_ch->process.held_ios));
+	raid_io = (struct raid_bdev_io *)bdev_io_held->driver_ctx;
+	CU_ASSERT(raid_io->raid_ch == ch_processed);
+	CU_ASSERT(raid_io->process_gen == -1);
+	complete_deferred_ios();
+	CU_ASSERT(raid_ch->num_ios == 0);
+	CU_ASSERT(ch_processed->num_ios == 0);
+
+	bdev_io_cleanup(bdev_io_read);
+	bdev_io_cleanup(bdev_io_write);
+	bdev_io_cleanup(bdev_io_held);
+	spdk_put_io_channel(ch);
+	poll_threads();
+
+	free_test_req(&req);
+
+	create_raid_bdev_delete_req(&destroy_req, "raid1", 0);
+	rpc_bdev_raid_delete(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev_present("raid1", false);
+
+	raid_bdev_exit();
+	base_bdevs_cleanup();
+	reset_globals();
+}
+
 static void
 test_raid_suspend_resume_create_ch(void)
 {
@@ -2298,6 +2417,134 @@ test_raid_suspend_resume_create_ch(void)
 	set_thread(0);
 }
 
+static void
+test_raid_numa_affinity(void)
+{
+	struct rpc_bdev_raid_create req;
+	struct rpc_bdev_raid_delete destroy_req;
+	struct raid_bdev_opts opts, saved_opts;
+	struct raid_bdev *pbdev;
+	struct spdk_io_channel *ch0, *ch1;
+	struct raid_bdev_io_channel *raid_ch0, *raid_ch1;
+	struct spdk_bdev_io *bdev_io;
+
+	free_threads();
+	allocate_threads(2);
+	set_thread(0);
+
+	set_globals();
+	CU_ASSERT(raid_bdev_init() == 0);
+
+	raid_bdev_get_opts(&saved_opts);
+	opts = saved_opts;
+	opts.numa_affinity = true;
+	CU_ASSERT(raid_bdev_set_opts(&opts) == 0);
+
+	g_per_thread_base_bdev_channels = calloc(2, sizeof(struct spdk_io_channel));
+	SPDK_CU_ASSERT_FATAL(g_per_thread_base_bdev_channels != NULL);
+
+	verify_raid_bdev_present("raid1", false);
+	create_raid_bdev_create_req(&req, "raid1", 0, true, 0, false);
+	rpc_bdev_raid_create(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev(&req, true, RAID_BDEV_STATE_ONLINE);
+
+	TAILQ_FOREACH(pbdev, &g_raid_bdev_list, global_link) {
+		if (strcmp(pbdev->bdev.name, "raid1") == 0) {
+			break;
+		}
+	}
+	SPDK_CU_ASSERT_FATAL(pbdev != NULL);
+	CU_ASSERT(pbdev->numa.enabled == true);
+
+	/* Thread 0 runs on socket 0 and thread 1 on socket 1 */
+	MOCK_SET(spdk_env_get_current_core, 0);
+	MOCK_SET(spdk_env_get_socket_id, 0);
+	ch0 = spdk_get_io_channel(pbdev);
+	SPDK_CU_ASSERT_FATAL(ch0 != NULL);
+	raid_ch0 = spdk_io_channel_get_ctx(ch0);
+	CU_ASSERT(raid_ch0->socket_id == 0);
+	CU_ASSERT(pbdev->numa.threads[0] == spdk_get_thread());
+
+	set_thread(1);
+	MOCK_SET(spdk_env_get_socket_id, 1);
+	ch1 = spdk_get_io_channel(pbdev);
+	SPDK_CU_ASSERT_FATAL(ch1 != NULL);
+	raid_ch1 = spdk_io_channel_get_ctx(ch1);
+	CU_ASSERT(raid_ch1->socket_id == 1);
+	CU_ASSERT(pbdev->numa.threads[1] == spdk_get_thread());
+
+	/* The base bdevs are on socket 1, so the I/O is submitted from thread 1 */
+	MOCK_SET(spdk_bdev_get_socket_id, 1);
+	set_thread(0);
+	bdev_io = calloc(1, sizeof(struct spdk_bdev_io) + sizeof(struct raid_bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io_initialize(bdev_io, ch0, &pbdev->bdev, 0, 1, SPDK_BDEV_IO_TYPE_READ);
+	memset(g_io_output, 0, ((g_max_io_size / g_strip_size) + 1) * sizeof(struct io_output));
+	g_io_output_index = 0;
+	g_io_comp_status = false;
+	raid_bdev_submit_request(ch0, bdev_io);
+	CU_ASSERT(g_io_output_index == 0);
+	poll_thread(1);
+	CU_ASSERT(g_io_output_index == 1);
+	CU_ASSERT(g_io_output[0].ch == &g_per_thread_base_bdev_channels[1]);
+	CU_ASSERT(g_io_comp_status == false);
+	poll_thread(0);
+	CU_ASSERT(g_io_comp_status == true);
+	CU_ASSERT(raid_ch0->num_ios == 0);
+	CU_ASSERT(pbdev->numa.forwarded_ios == 1);
+	CU_ASSERT(pbdev->numa.remote_ios == 0);
+
+	/* Without a channel on socket 1 the I/O is submitted from thread 0 */
+	set_thread(1);
+	spdk_put_io_channel(ch1);
+	poll_threads();
+	CU_ASSERT(pbdev->numa.threads[1] == NULL);
+
+	set_thread(0);
+	g_io_output_index = 0;
+	g_io_comp_status = false;
+	raid_bdev_submit_request(ch0, bdev_io);
+	CU_ASSERT(g_io_output_index == 1);
+	CU_ASSERT(g_io_output[0].ch == &g_per_thread_base_bdev_channels[0]);
+	CU_ASSERT(g_io_comp_status == true);
+	CU_ASSERT(pbdev->numa.forwarded_ios == 1);
+	CU_ASSERT(pbdev->numa.remote_ios == 1);
+
+	/* The base bdevs on the local socket are not counted */
+	MOCK_SET(spdk_bdev_get_socket_id, 0);
+	g_io_output_index = 0;
+	raid_bdev_submit_request(ch0, bdev_io);
+	CU_ASSERT(g_io_output_index == 1);
+	CU_ASSERT(pbdev->numa.forwarded_ios == 1);
+	CU_ASSERT(pbdev->numa.remote_ios == 1);
+
+	bdev_io_cleanup(bdev_io);
+	spdk_put_io_channel(ch0);
+	poll_threads();
+	CU_ASSERT(pbdev->numa.threads[0] == NULL);
+
+	MOCK_CLEAR(spdk_bdev_get_socket_id);
+	MOCK_CLEAR(spdk_env_get_socket_id);
+	MOCK_CLEAR(spdk_env_get_current_core);
+	CU_ASSERT(raid_bdev_set_opts(&saved_opts) == 0);
+
+	free_test_req(&req);
+
+	create_raid_bdev_delete_req(&destroy_req, "raid1", 0);
+	rpc_bdev_raid_delete(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev_present("raid1", false);
+
+	raid_bdev_exit();
+	base_bdevs_cleanup();
+	reset_globals();
+
+	free_threads();
+	allocate_threads(1);
+	set_thread(0);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -2328,6 +2575,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_raid_level_conversions);
 	CU_ADD_TEST(suite, test_raid_suspend_resume);
 	CU_ADD_TEST(suite, test_raid_suspend_resume_create_ch);
+	CU_ADD_TEST(suite, test_raid_numa_affinity);
+	CU_ADD_TEST(suite, test_raid_process_window);
 
 	allocate_threads(1);
 	set_thread(0);
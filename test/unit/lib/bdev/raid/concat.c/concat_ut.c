@@ -68,6 +68,10 @@ DEFINE_STUB(raid_bdev_io_complete_part, bool,
 	    (struct raid_bdev_io *raid_io, uint64_t completed,
 	     enum spdk_bdev_io_status status),
 	    true);
+DEFINE_STUB(raid_bdev_io_numa_forward, bool,
+	    (struct raid_bdev_io *raid_io, struct raid_base_bdev_info *base_info,
+	     spdk_msg_fn submit_fn),
+	    false);
 
 int
 spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
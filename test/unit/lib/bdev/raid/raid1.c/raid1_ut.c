@@ -36,6 +36,85 @@ DEFINE_STUB(spdk_bdev_writev_blocks_ext, int, (struct spdk_bdev_desc *desc,
 		struct spdk_io_channel *ch,
 		struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
 		spdk_bdev_io_completion_cb cb, void *cb_arg, struct spdk_bdev_ext_io_opts *opts), 0);
+DEFINE_STUB(spdk_bdev_read_blocks_with_md, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, void *buf, void *md, uint64_t offset_blocks,
+		uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_write_blocks_with_md, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, void *buf, void *md, uint64_t offset_blocks,
+		uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB_V(raid_bdev_process_request_complete, (struct raid_bdev_process_request *process_req,
+		int status));
+DEFINE_STUB(spdk_bdev_io_get_submit_tsc, uint64_t, (struct spdk_bdev_io *bdev_io), 0);
+
+void
+raid_bdev_get_opts(struct raid_bdev_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->raid1_read_policy = RAID1_READ_POLICY_BANDWIDTH;
+}
+
+uint64_t g_wib_on_disk;
+uint64_t g_wib_writes;
+uint64_t g_resync_reads;
+uint64_t g_resync_writes;
+uint64_t g_resync_offset;
+
+static void
+ut_bdev_io_complete(void *_bdev_io)
+{
+	struct spdk_bdev_io *bdev_io = _bdev_io;
+
+	bdev_io->internal.cb(bdev_io, true, bdev_io->internal.caller_ctx);
+}
+
+static int
+ut_submit_bdev_io(spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct spdk_bdev_io *bdev_io;
+
+	bdev_io = calloc(1, sizeof(*bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->internal.cb = cb;
+	bdev_io->internal.caller_ctx = cb_arg;
+
+	spdk_thread_send_msg(spdk_get_thread(), ut_bdev_io_complete, bdev_io);
+
+	return 0;
+}
+
+int
+spdk_bdev_read_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		      void *buf, uint64_t offset_blocks, uint64_t num_blocks,
+		      spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	if (offset_blocks < RAID_BDEV_MIN_DATA_OFFSET_SIZE / desc->bdev->blocklen) {
+		/* Bitmap load */
+		memcpy(buf, &g_wib_on_disk, sizeof(g_wib_on_disk));
+	} else {
+		g_resync_reads++;
+		g_resync_offset = offset_blocks;
+	}
+
+	return ut_submit_bdev_io(cb, cb_arg);
+}
+
+int
+spdk_bdev_write_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       void *buf, uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	if (offset_blocks < RAID_BDEV_MIN_DATA_OFFSET_SIZE / desc->bdev->blocklen) {
+		CU_ASSERT_EQUAL(offset_blocks, RAID_BDEV_SB_MAX_LENGTH / desc->bdev->blocklen);
+		memcpy(&g_wib_on_disk, buf, sizeof(g_wib_on_disk));
+		g_wib_writes++;
+	} else {
+		CU_ASSERT_EQUAL(offset_blocks, g_resync_offset);
+		g_resync_writes++;
+	}
+
+	return ut_submit_bdev_io(cb, cb_arg);
+}
 
 static int
 test_setup(void)
@@ -272,6 +351,219 @@ test_raid1_read_balancing_limit_reset(void)
 	run_for_each_raid1_config(__test_raid1_read_balancing_limit_reset);
 }
 
+static void
+__test_raid1_read_balancing_latency(struct raid_bdev *raid_bdev,
+				    struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid1_info *r1info = raid_bdev->module_private;
+	struct raid_bdev_io *raid_io;
+	struct raid1_io_channel *raid1_ch = spdk_io_channel_get_ctx(raid_ch->module_channel);
+	uint8_t fast_idx = raid_ch->num_channels - 1;
+	uint8_t i;
+	int n;
+
+	r1info->read_policy = RAID1_READ_POLICY_LATENCY;
+	for (i = 0; i < raid_ch->num_channels; i++) {
+		raid1_ch->base_bdev_read_latency[i] = 104;
+	}
+	raid1_ch->base_bdev_read_latency[fast_idx] = 9;
+
+	/* The fast base bdev is preferred until enough reads are queued on it */
+	for (n = 0; n < 10; n++) {
+		raid_io = get_raid_io(r1info, raid_ch, SPDK_BDEV_IO_TYPE_READ, 1);
+		raid1_submit_rw_request(raid_io);
+		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+		CU_ASSERT_EQUAL(raid1_ch->base_bdev_read_idx, fast_idx);
+	}
+	CU_ASSERT_EQUAL(raid1_ch->base_bdev_reads_outstanding[fast_idx], 10);
+
+	raid_io = get_raid_io(r1info, raid_ch, SPDK_BDEV_IO_TYPE_READ, 1);
+	raid1_submit_rw_request(raid_io);
+	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT_NOT_EQUAL(raid1_ch->base_bdev_read_idx, fast_idx);
+	CU_ASSERT_EQUAL(raid1_ch->base_bdev_reads_outstanding[raid1_ch->base_bdev_read_idx], 1);
+
+	/* Periodically a read goes to the next base bdev to refresh its latency */
+	for (i = 0; i < raid_ch->num_channels; i++) {
+		raid1_ch->base_bdev_reads_outstanding[i] = 0;
+	}
+	raid1_ch->base_bdev_read_idx = fast_idx;
+	raid1_ch->reads_since_probe = RAID1_READ_LATENCY_PROBE_INTERVAL - 1;
+
+	raid_io = get_raid_io(r1info, raid_ch, SPDK_BDEV_IO_TYPE_READ, 1);
+	raid1_submit_rw_request(raid_io);
+	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT_EQUAL(raid1_ch->base_bdev_read_idx, 0);
+	CU_ASSERT_EQUAL(raid1_ch->reads_since_probe, 0);
+}
+
+static void
+test_raid1_read_balancing_latency(void)
+{
+	run_for_each_raid1_config(__test_raid1_read_balancing_latency);
+}
+
+static struct raid1_info *
+create_raid1_wib(struct raid_params *params, uint32_t region_size_kb,
+		 struct raid_bdev_superblock *sb)
+{
+	struct raid_bdev *raid_bdev = raid_test_create_raid_bdev(params, &g_raid1_module);
+	struct raid_base_bdev_info *base_info;
+
+	raid_bdev->sb = sb;
+	raid_bdev->write_intent_region_size_kb = region_size_kb;
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		base_info->data_offset = RAID_BDEV_MIN_DATA_OFFSET_SIZE /
+					 params->base_bdev_blocklen;
+		base_info->data_size -= base_info->data_offset;
+		base_info->app_thread_ch = (struct spdk_io_channel *)0xDEADBEEF;
+	}
+
+	SPDK_CU_ASSERT_FATAL(raid1_start(raid_bdev) == 0);
+
+	return raid_bdev->module_private;
+}
+
+static void
+delete_raid1_wib(struct raid1_info *r1info)
+{
+	struct raid_bdev *raid_bdev = r1info->raid_bdev;
+
+	raid1_stop(raid_bdev);
+	poll_threads();
+
+	raid_test_delete_raid_bdev(raid_bdev);
+}
+
+static void
+test_raid1_write_intent_bitmap(void)
+{
+	struct raid_params params = {
+		.num_base_bdevs = 2,
+		.base_bdev_blockcnt = 1024 * 1024,
+		.base_bdev_blocklen = 512,
+	};
+	struct raid_bdev_superblock *sb;
+	struct raid_bdev_io_channel raid_ch = { 0 };
+	struct raid_bdev_io *raid_io;
+	struct raid1_info *r1info;
+	struct raid1_wib *wib;
+	int i;
+
+	sb = calloc(1, RAID_BDEV_SB_MAX_LENGTH);
+	SPDK_CU_ASSERT_FATAL(sb != NULL);
+
+	/* A new raid, the bitmap is cleared on disk */
+	g_wib_on_disk = UINT64_MAX;
+	g_wib_writes = 0;
+	r1info = create_raid1_wib(&params, 64, sb);
+	wib = r1info->wib;
+	SPDK_CU_ASSERT_FATAL(wib != NULL);
+	CU_ASSERT_EQUAL(wib->region_size, 128);
+	CU_ASSERT_EQUAL(r1info->raid_bdev->write_intent_region_size, 128);
+	poll_threads();
+	CU_ASSERT_EQUAL(g_wib_writes, 2);
+	CU_ASSERT_EQUAL(g_wib_on_disk, 0);
+
+	raid_ch.num_channels = params.num_base_bdevs;
+	raid_ch.base_channel = calloc(params.num_base_bdevs, sizeof(struct spdk_io_channel *));
+	SPDK_CU_ASSERT_FATAL(raid_ch.base_channel != NULL);
+	for (i = 0; i < raid_ch.num_channels; i++) {
+		raid_ch.base_channel[i] = calloc(1, sizeof(*raid_ch.base_channel));
+	}
+	raid_ch.module_channel = raid1_get_io_channel(r1info->raid_bdev);
+	SPDK_CU_ASSERT_FATAL(raid_ch.module_channel);
+
+	/* The first write to a region is held until the bitmap is written */
+	raid_io = get_raid_io(r1info, &raid_ch, SPDK_BDEV_IO_TYPE_WRITE, 4);
+	raid1_submit_rw_request(raid_io);
+	CU_ASSERT_EQUAL(raid_io->base_bdev_io_remaining, 0);
+	CU_ASSERT_EQUAL(wib->inflight[0], 0);
+	poll_threads();
+	CU_ASSERT_EQUAL(g_wib_writes, 4);
+	CU_ASSERT_EQUAL(g_wib_on_disk, 1);
+	CU_ASSERT_EQUAL(wib->dirty[0], 1);
+	CU_ASSERT_EQUAL(wib->inflight[0], 1);
+	CU_ASSERT_EQUAL(raid_io->base_bdev_io_remaining, params.num_base_bdevs);
+	CU_ASSERT_EQUAL(raid_io->base_bdev_io_submitted, params.num_base_bdevs);
+
+	raid1_io_complete_part(raid_io, params.num_base_bdevs, SPDK_BDEV_IO_STATUS_SUCCESS);
+	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT_EQUAL(wib->inflight[0], 0);
+	CU_ASSERT_EQUAL(wib->active[0], 1);
+
+	/* Subsequent writes don't touch the bitmap */
+	raid_io = get_raid_io(r1info, &raid_ch, SPDK_BDEV_IO_TYPE_WRITE, 4);
+	raid1_submit_rw_request(raid_io);
+	CU_ASSERT_EQUAL(wib->inflight[0], 1);
+	CU_ASSERT_EQUAL(raid_io->base_bdev_io_submitted, params.num_base_bdevs);
+
+	/* A region with writes in flight is not cleaned */
+	raid1_wib_clean(wib);
+	raid1_wib_clean(wib);
+	CU_ASSERT_EQUAL(wib->dirty[0], 1);
+	CU_ASSERT_EQUAL(wib->target[0], 1);
+
+	raid1_io_complete_part(raid_io, params.num_base_bdevs, SPDK_BDEV_IO_STATUS_SUCCESS);
+	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	/* An idle region is cleared after two cleaning passes */
+	raid1_wib_clean(wib);
+	CU_ASSERT_EQUAL(wib->dirty[0], 1);
+	raid1_wib_clean(wib);
+	CU_ASSERT_EQUAL(wib->dirty[0], 0);
+	poll_threads();
+	CU_ASSERT_EQUAL(g_wib_writes, 6);
+	CU_ASSERT_EQUAL(g_wib_on_disk, 0);
+
+	spdk_put_io_channel(raid_ch.module_channel);
+	poll_threads();
+	delete_raid1_wib(r1info);
+
+	/* Assemble the raid again with a dirty region, only that region is resynchronized */
+	memset(sb, 0, RAID_BDEV_SB_MAX_LENGTH);
+	sb->uuid.u.raw[0] = 1;
+	sb->write_intent_region_size = 128;
+	g_wib_on_disk = 1 << 5;
+	g_resync_reads = g_resync_writes = 0;
+	r1info = create_raid1_wib(&params, 0, sb);
+	wib = r1info->wib;
+	SPDK_CU_ASSERT_FATAL(wib != NULL);
+	CU_ASSERT_TRUE(wib->loading);
+
+	raid_ch.module_channel = raid1_get_io_channel(r1info->raid_bdev);
+	SPDK_CU_ASSERT_FATAL(raid_ch.module_channel);
+
+	/* Reads go to the first base bdev until the bitmap is loaded */
+	raid_io = get_raid_io(r1info, &raid_ch, SPDK_BDEV_IO_TYPE_READ, 4);
+	CU_ASSERT_TRUE(raid1_wib_is_unsynced(wib, raid_io));
+	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	poll_threads();
+	CU_ASSERT_FALSE(wib->loading);
+	CU_ASSERT_EQUAL(wib->dirty[0], 1 << 5);
+	CU_ASSERT_PTR_NOT_NULL(wib->resync_poller);
+
+	while (wib->resync_poller != NULL) {
+		spdk_delay_us(RAID1_RESYNC_POLL_PERIOD_US);
+		poll_threads();
+	}
+	CU_ASSERT_EQUAL(wib->unsynced[0], 0);
+	CU_ASSERT_FALSE(wib->resync_failed);
+	CU_ASSERT_EQUAL(g_resync_reads, 1);
+	CU_ASSERT_EQUAL(g_resync_writes, g_resync_reads);
+	CU_ASSERT_EQUAL(g_resync_offset, RAID_BDEV_MIN_DATA_OFFSET_SIZE / 512 + 5 * 128);
+
+	spdk_put_io_channel(raid_ch.module_channel);
+	poll_threads();
+	for (i = 0; i < raid_ch.num_channels; i++) {
+		free(raid_ch.base_channel[i]);
+	}
+	free(raid_ch.base_channel);
+	delete_raid1_wib(r1info);
+	free(sb);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -285,6 +577,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_raid1_start);
 	CU_ADD_TEST(suite, test_raid1_read_balancing);
 	CU_ADD_TEST(suite, test_raid1_read_balancing_limit_reset);
+	CU_ADD_TEST(suite, test_raid1_read_balancing_latency);
+	CU_ADD_TEST(suite, test_raid1_write_intent_bitmap);
 
 	allocate_threads(1);
 	set_thread(0);
@@ -15,12 +15,29 @@
 
 static void *g_accel_p = (void *)0xdeadbeaf;
 static bool g_test_degraded;
+static uint32_t g_test_stripe_cache_size;
 
 DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
 DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
 DEFINE_STUB_V(raid_bdev_module_stop_done, (struct raid_bdev *raid_bdev));
 DEFINE_STUB(accel_channel_create, int, (void *io_device, void *ctx_buf), 0);
 DEFINE_STUB_V(accel_channel_destroy, (void *io_device, void *ctx_buf));
+DEFINE_STUB(spdk_bdev_read_blocks_with_md, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, void *buf, void *md, uint64_t offset_blocks,
+		uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_write_blocks_with_md, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, void *buf, void *md, uint64_t offset_blocks,
+		uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB_V(raid_bdev_process_request_complete, (struct raid_bdev_process_request *process_req,
+		int status));
+
+void
+raid_bdev_get_opts(struct raid_bdev_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->raid5f_stripe_cache_size = g_test_stripe_cache_size;
+	opts->raid5f_stripe_cache_flush_us = 10;
+}
 
 struct spdk_io_channel *
 spdk_accel_get_io_channel(void)
@@ -424,6 +441,60 @@ process_io_completions(struct raid_io_info *io_info)
 
 #define DATA_OFFSET_TO_MD_OFFSET(raid_bdev, data_offset) ((data_offset >> raid_bdev->blocklen_shift) * raid_bdev->bdev.md_len)
 
+/* Base bdevs backed by memory, used by the stripe cache tests */
+struct test_disk {
+	struct spdk_bdev *bdev;
+	void *buf;
+	size_t size;
+} *g_test_disks;
+uint8_t g_test_disks_num;
+uint64_t g_test_disk_reads;
+
+static void
+test_disk_io_complete(void *_bdev_io)
+{
+	struct spdk_bdev_io *bdev_io = _bdev_io;
+
+	bdev_io->internal.cb(bdev_io, true, bdev_io->internal.caller_ctx);
+}
+
+static int
+test_disk_io(struct spdk_bdev_desc *desc, struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+	     uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg, bool write)
+{
+	struct spdk_bdev *bdev = desc->bdev;
+	struct spdk_bdev_io *bdev_io;
+	struct test_disk *disk = NULL;
+	uint8_t i;
+
+	for (i = 0; i < g_test_disks_num; i++) {
+		if (g_test_disks[i].bdev == bdev) {
+			disk = &g_test_disks[i];
+		}
+	}
+	SPDK_CU_ASSERT_FATAL(disk != NULL);
+	SPDK_CU_ASSERT_FATAL((offset_blocks + num_blocks) * bdev->blocklen <= disk->size);
+
+	if (write) {
+		spdk_copy_iovs_to_buf(disk->buf + offset_blocks * bdev->blocklen,
+				      num_blocks * bdev->blocklen, iov, iovcnt);
+	} else {
+		spdk_copy_buf_to_iovs(iov, iovcnt, disk->buf + offset_blocks * bdev->blocklen,
+				      num_blocks * bdev->blocklen);
+		g_test_disk_reads++;
+	}
+
+	bdev_io = calloc(1, sizeof(*bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->bdev = bdev;
+	bdev_io->internal.cb = cb;
+	bdev_io->internal.caller_ctx = cb_arg;
+
+	spdk_thread_send_msg(spdk_get_thread(), test_disk_io_complete, bdev_io);
+
+	return 0;
+}
+
 int
 spdk_bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 				struct iovec *iov, int iovcnt, void *md_buf,
@@ -439,6 +510,10 @@ spdk_bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_chan
 	uint64_t data_offset;
 	void *dest_buf, *dest_md_buf;
 
+	if (g_test_disks != NULL) {
+		return test_disk_io(desc, iov, iovcnt, offset_blocks, num_blocks, cb, cb_arg, true);
+	}
+
 	SPDK_CU_ASSERT_FATAL(cb == raid5f_chunk_complete_bdev_io);
 	SPDK_CU_ASSERT_FATAL(iovcnt == 1);
 
@@ -544,6 +619,11 @@ spdk_bdev_readv_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_chann
 	struct raid_bdev_io *raid_io = cb_arg;
 	struct test_raid_bdev_io *test_raid_bdev_io;
 
+	if (g_test_disks != NULL) {
+		return test_disk_io(desc, iov, iovcnt, offset_blocks, num_blocks, cb, cb_arg,
+				    false);
+	}
+
 	if (cb == raid5f_chunk_complete_bdev_io) {
 		return spdk_bdev_readv_blocks_degraded(desc, ch, iov, iovcnt, offset_blocks, num_blocks, cb,
 						       cb_arg);
@@ -824,6 +904,9 @@ io_info_setup_degraded(struct raid_io_info *io_info)
 		memset(io_info->degraded_md_buf + io_info->stripe_offset_blocks * md_len,
 		       0xcd, io_info->num_blocks * md_len);
 	}
+
+	/* The base bdev data is different for each request, drop the reconstructed chunks */
+	raid5f_stripe_write_gen_inc(r5f_info, io_info->stripe_index);
 }
 
 static void
@@ -1137,6 +1220,330 @@ test_raid5f_submit_read_request_degraded(void)
 	run_for_each_raid5f_config(__test_raid5f_submit_read_request);
 }
 
+static void
+test_disks_init(struct raid_bdev *raid_bdev, uint64_t num_stripes)
+{
+	size_t size = num_stripes * raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	uint8_t i;
+	size_t j;
+
+	g_test_disks_num = raid_bdev->num_base_bdevs;
+	g_test_disks = calloc(g_test_disks_num, sizeof(*g_test_disks));
+	SPDK_CU_ASSERT_FATAL(g_test_disks != NULL);
+
+	/* Fill with random data, the parity doesn't matter until a stripe is written */
+	for (i = 0; i < g_test_disks_num; i++) {
+		g_test_disks[i].bdev = raid_bdev->base_bdev_info[i].bdev;
+		g_test_disks[i].size = size;
+		g_test_disks[i].buf = malloc(size);
+		SPDK_CU_ASSERT_FATAL(g_test_disks[i].buf != NULL);
+		for (j = 0; j < size; j++) {
+			((uint8_t *)g_test_disks[i].buf)[j] = rand();
+		}
+	}
+
+	g_test_disk_reads = 0;
+}
+
+static void
+test_disks_fini(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < g_test_disks_num; i++) {
+		free(g_test_disks[i].buf);
+	}
+	free(g_test_disks);
+	g_test_disks = NULL;
+	g_test_disks_num = 0;
+}
+
+/* Checks the data chunks against the expected stripe data and that the parity matches */
+static void
+test_disks_check_stripe(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+			uint64_t stripe_index, void *stripe_data)
+{
+	size_t strip_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, stripe_index);
+	void *parity;
+	uint8_t i, d;
+
+	parity = calloc(1, strip_len);
+	SPDK_CU_ASSERT_FATAL(parity != NULL);
+
+	for (i = 0, d = 0; i < raid_bdev->num_base_bdevs; i++) {
+		if (i == p_idx) {
+			continue;
+		}
+
+		xor_block(parity, stripe_data + d * strip_len, strip_len);
+		if (raid_ch->base_channel[i] != NULL) {
+			CU_ASSERT(memcmp(g_test_disks[i].buf + stripe_index * strip_len,
+					 stripe_data + d * strip_len, strip_len) == 0);
+		}
+		d++;
+	}
+
+	if (raid_ch->base_channel[p_idx] != NULL) {
+		CU_ASSERT(memcmp(g_test_disks[p_idx].buf + stripe_index * strip_len, parity,
+				 strip_len) == 0);
+	}
+
+	free(parity);
+}
+
+/* Reads the stripe data, rebuilding the chunk of a missing base bdev from the parity */
+static void
+test_disks_get_stripe(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+		      uint64_t stripe_index, void *stripe_data)
+{
+	size_t strip_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, stripe_index);
+	void *missing = NULL;
+	uint8_t i, d;
+
+	for (i = 0, d = 0; i < raid_bdev->num_base_bdevs; i++) {
+		if (i == p_idx) {
+			continue;
+		}
+
+		memcpy(stripe_data + d * strip_len, g_test_disks[i].buf + stripe_index * strip_len,
+		       strip_len);
+		if (raid_ch->base_channel[i] == NULL) {
+			missing = stripe_data + d * strip_len;
+		}
+		d++;
+	}
+
+	/* Make the stripe consistent, the missing chunk is defined by the parity */
+	if (missing != NULL) {
+		memcpy(missing, g_test_disks[p_idx].buf + stripe_index * strip_len, strip_len);
+		for (d = 0; d < raid5f_stripe_data_chunks_num(raid_bdev); d++) {
+			if (stripe_data + d * strip_len != missing) {
+				xor_block(missing, stripe_data + d * strip_len, strip_len);
+			}
+		}
+	} else {
+		memset(g_test_disks[p_idx].buf + stripe_index * strip_len, 0, strip_len);
+		for (d = 0; d < raid5f_stripe_data_chunks_num(raid_bdev); d++) {
+			xor_block(g_test_disks[p_idx].buf + stripe_index * strip_len,
+				  stripe_data + d * strip_len, strip_len);
+		}
+	}
+}
+
+static void
+test_raid5f_cached_write(struct raid_io_info *io_info, struct raid5f_info *r5f_info,
+			 struct raid_bdev_io_channel *raid_ch, uint64_t stripe_index,
+			 uint64_t stripe_offset_blocks, uint64_t num_blocks, void *stripe_data)
+{
+	uint32_t blocklen = r5f_info->raid_bdev->bdev.blocklen;
+	size_t i;
+
+	init_io_info(io_info, r5f_info, raid_ch, SPDK_BDEV_IO_TYPE_WRITE, stripe_index,
+		     stripe_offset_blocks, num_blocks);
+
+	for (i = 0; i < io_info->buf_size; i++) {
+		((uint8_t *)io_info->src_buf)[i] = rand();
+	}
+	memcpy(stripe_data + stripe_offset_blocks * blocklen, io_info->src_buf, io_info->buf_size);
+
+	raid5f_submit_rw_request(get_raid_io(io_info));
+}
+
+static void
+__test_raid5f_stripe_cache(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	uint32_t strip_size = raid_bdev->strip_size;
+	uint64_t num_stripes = spdk_min(r5f_info->total_stripes, 2);
+	struct raid_io_info io_info[2];
+	struct raid_io_info *full_io_info;
+	void *stripe_data;
+	uint64_t reads;
+	uint8_t d, n;
+
+	if (raid_bdev->bdev.md_len != 0) {
+		CU_ASSERT_EQUAL(r5f_info->stripe_cache_size, 0);
+		CU_ASSERT_EQUAL(raid_bdev->bdev.write_unit_size, r5f_info->stripe_blocks);
+		return;
+	}
+
+	CU_ASSERT_EQUAL(r5f_info->stripe_cache_size, g_test_stripe_cache_size);
+	CU_ASSERT_EQUAL(raid_bdev->bdev.write_unit_size, 1);
+
+	stripe_data = malloc(r5f_info->stripe_blocks * raid_bdev->bdev.blocklen);
+	SPDK_CU_ASSERT_FATAL(stripe_data != NULL);
+
+	test_disks_init(raid_bdev, num_stripes);
+	test_disks_get_stripe(raid_bdev, raid_ch, 0, stripe_data);
+
+	/* A partial write waits for the flush time and then updates the stripe */
+	test_raid5f_cached_write(&io_info[0], r5f_info, raid_ch, 0, strip_size / 2, 1, stripe_data);
+	poll_threads();
+	CU_ASSERT_EQUAL(io_info[0].status, SPDK_BDEV_IO_STATUS_PENDING);
+
+	spdk_delay_us(10);
+	poll_threads();
+	CU_ASSERT_EQUAL(io_info[0].status, SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(g_test_disk_reads > 0);
+	test_disks_check_stripe(raid_bdev, raid_ch, 0, stripe_data);
+	deinit_io_info(&io_info[0]);
+
+	/* An overlapping write is applied after the first one */
+	test_raid5f_cached_write(&io_info[0], r5f_info, raid_ch, 0, 0, strip_size, stripe_data);
+	test_raid5f_cached_write(&io_info[1], r5f_info, raid_ch, 0, 0, 1, stripe_data);
+	spdk_delay_us(10);
+	poll_threads();
+	spdk_delay_us(10);
+	poll_threads();
+	CU_ASSERT_EQUAL(io_info[0].status, SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT_EQUAL(io_info[1].status, SPDK_BDEV_IO_STATUS_SUCCESS);
+	test_disks_check_stripe(raid_bdev, raid_ch, 0, stripe_data);
+	deinit_io_info(&io_info[0]);
+	deinit_io_info(&io_info[1]);
+
+	/* A stripe written in strip sized pieces is flushed right away without reading */
+	if (num_stripes > 1) {
+		n = raid5f_stripe_data_chunks_num(raid_bdev);
+		full_io_info = calloc(n, sizeof(*full_io_info));
+		SPDK_CU_ASSERT_FATAL(full_io_info != NULL);
+
+		reads = g_test_disk_reads;
+		for (d = 0; d < n; d++) {
+			test_raid5f_cached_write(&full_io_info[d], r5f_info, raid_ch, 1,
+						 d * strip_size, strip_size, stripe_data);
+		}
+		poll_threads();
+
+		for (d = 0; d < n; d++) {
+			CU_ASSERT_EQUAL(full_io_info[d].status, SPDK_BDEV_IO_STATUS_SUCCESS);
+			deinit_io_info(&full_io_info[d]);
+		}
+		CU_ASSERT_EQUAL(g_test_disk_reads, reads);
+		test_disks_check_stripe(raid_bdev, raid_ch, 1, stripe_data);
+		free(full_io_info);
+	}
+
+	test_disks_fini();
+	free(stripe_data);
+}
+
+static void
+test_raid5f_stripe_cache(void)
+{
+	g_test_stripe_cache_size = 4;
+	run_for_each_raid5f_config(__test_raid5f_stripe_cache);
+	g_test_stripe_cache_size = 0;
+}
+
+static void
+test_raid5f_stripe_cache_degraded(void)
+{
+	g_test_degraded = true;
+	test_raid5f_stripe_cache();
+}
+
+static void
+test_raid5f_degraded_read(struct raid_io_info *io_info, struct raid5f_info *r5f_info,
+			  struct raid_bdev_io_channel *raid_ch, uint64_t stripe_index,
+			  uint64_t stripe_offset_blocks, uint64_t num_blocks, void *stripe_data)
+{
+	uint32_t blocklen = r5f_info->raid_bdev->bdev.blocklen;
+
+	init_io_info(io_info, r5f_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, stripe_index,
+		     stripe_offset_blocks, num_blocks);
+
+	raid5f_submit_rw_request(get_raid_io(io_info));
+	poll_threads();
+
+	CU_ASSERT_EQUAL(io_info->status, SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(memcmp(io_info->dest_buf, stripe_data + stripe_offset_blocks * blocklen,
+			 io_info->buf_size) == 0);
+
+	deinit_io_info(io_info);
+}
+
+static void
+__test_raid5f_reconstruct_cache(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	uint32_t strip_size = raid_bdev->strip_size;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	uint8_t n = raid5f_stripe_data_chunks_num(raid_bdev);
+	struct raid_io_info io_info[2];
+	void *stripe_data;
+	uint64_t reads;
+	uint8_t d;
+
+	/* Base bdev 0 is missing and holds the first data chunk of stripe 0 */
+	if (raid_bdev->bdev.md_len != 0 || strip_size < 4) {
+		return;
+	}
+
+	stripe_data = malloc(r5f_info->stripe_blocks * raid_bdev->bdev.blocklen);
+	SPDK_CU_ASSERT_FATAL(stripe_data != NULL);
+
+	test_disks_init(raid_bdev, 1);
+	test_disks_get_stripe(raid_bdev, raid_ch, 0, stripe_data);
+
+	/* The first degraded read of the stripe reads only its own range */
+	test_raid5f_degraded_read(&io_info[0], r5f_info, raid_ch, 0, 0, 1, stripe_data);
+	CU_ASSERT_EQUAL(g_test_disk_reads, n);
+
+	/* The next one reconstructs the whole chunk, then reads are copied from it */
+	test_raid5f_degraded_read(&io_info[0], r5f_info, raid_ch, 0, 1, 1, stripe_data);
+	CU_ASSERT_EQUAL(g_test_disk_reads, 2 * n);
+
+	reads = g_test_disk_reads;
+	test_raid5f_degraded_read(&io_info[0], r5f_info, raid_ch, 0, 2, 1, stripe_data);
+	test_raid5f_degraded_read(&io_info[0], r5f_info, raid_ch, 0, 0, strip_size, stripe_data);
+	CU_ASSERT_EQUAL(g_test_disk_reads, reads);
+
+	/* Concurrent reads share the reconstruction */
+	r5f_info->stripe_write_gen[0]++;
+	init_io_info(&io_info[0], r5f_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, 0, 1, 1);
+	init_io_info(&io_info[1], r5f_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, 0, 3, 1);
+	raid5f_submit_rw_request(get_raid_io(&io_info[0]));
+	raid5f_submit_rw_request(get_raid_io(&io_info[1]));
+	poll_threads();
+	for (d = 0; d < 2; d++) {
+		CU_ASSERT_EQUAL(io_info[d].status, SPDK_BDEV_IO_STATUS_SUCCESS);
+		CU_ASSERT(memcmp(io_info[d].dest_buf,
+				 stripe_data + io_info[d].stripe_offset_blocks * blocklen,
+				 io_info[d].buf_size) == 0);
+		deinit_io_info(&io_info[d]);
+	}
+	CU_ASSERT_EQUAL(g_test_disk_reads, reads + n);
+
+	/* A write to the stripe invalidates the reconstructed chunk */
+	init_io_info(&io_info[0], r5f_info, raid_ch, SPDK_BDEV_IO_TYPE_WRITE, 0, 0,
+		     r5f_info->stripe_blocks);
+	for (d = 0; d < n; d++) {
+		memset(io_info[0].src_buf + d * strip_size * blocklen, d + 1,
+		       strip_size * blocklen);
+	}
+	memcpy(stripe_data, io_info[0].src_buf, io_info[0].buf_size);
+	raid5f_submit_rw_request(get_raid_io(&io_info[0]));
+	poll_threads();
+	CU_ASSERT_EQUAL(io_info[0].status, SPDK_BDEV_IO_STATUS_SUCCESS);
+	deinit_io_info(&io_info[0]);
+
+	reads = g_test_disk_reads;
+	test_raid5f_degraded_read(&io_info[0], r5f_info, raid_ch, 0, 2, 1, stripe_data);
+	CU_ASSERT_EQUAL(g_test_disk_reads, reads + n);
+
+	test_disks_fini();
+	free(stripe_data);
+}
+
+static void
+test_raid5f_reconstruct_cache(void)
+{
+	g_test_degraded = true;
+	run_for_each_raid5f_config(__test_raid5f_reconstruct_cache);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1156,6 +1563,9 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_raid5f_chunk_write_error_with_enomem);
 	CU_ADD_TEST(suite, test_raid5f_submit_full_stripe_write_request_degraded);
 	CU_ADD_TEST(suite, test_raid5f_submit_read_request_degraded);
+	CU_ADD_TEST(suite, test_raid5f_stripe_cache);
+	CU_ADD_TEST(suite, test_raid5f_stripe_cache_degraded);
+	CU_ADD_TEST(suite, test_raid5f_reconstruct_cache);
 
 	allocate_threads(1);
 	set_thread(0);
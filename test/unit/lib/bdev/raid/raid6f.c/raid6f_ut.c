@@ -0,0 +1,774 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_cunit.h"
+#include "spdk/env.h"
+#include "spdk/xor.h"
+
+#include "common/lib/ut_multithread.c"
+
+#include "bdev/raid/raid6f.c"
+#include "../common.c"
+
+static void *g_accel_p = (void *)0xdeadbeaf;
+static int g_process_status;
+static bool g_process_done;
+
+DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
+DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB_V(raid_bdev_module_stop_done, (struct raid_bdev *raid_bdev));
+DEFINE_STUB(accel_channel_create, int, (void *io_device, void *ctx_buf), 0);
+DEFINE_STUB_V(accel_channel_destroy, (void *io_device, void *ctx_buf));
+DEFINE_STUB_V(raid_bdev_queue_io_wait, (struct raid_bdev_io *raid_io, struct spdk_bdev *bdev,
+					struct spdk_io_channel *ch, spdk_bdev_io_wait_cb cb_fn));
+
+struct spdk_io_channel *
+spdk_accel_get_io_channel(void)
+{
+	return spdk_get_io_channel(g_accel_p);
+}
+
+struct xor_ctx {
+	spdk_accel_completion_cb cb_fn;
+	void *cb_arg;
+};
+
+static void
+finish_xor(void *_ctx)
+{
+	struct xor_ctx *ctx = _ctx;
+
+	ctx->cb_fn(ctx->cb_arg, 0);
+
+	free(ctx);
+}
+
+int
+spdk_accel_submit_xor(struct spdk_io_channel *ch, void *dst, void **sources, uint32_t nsrcs,
+		      uint64_t nbytes, spdk_accel_completion_cb cb_fn, void *cb_arg)
+{
+	struct xor_ctx *ctx;
+
+	ctx = malloc(sizeof(*ctx));
+	SPDK_CU_ASSERT_FATAL(ctx != NULL);
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	SPDK_CU_ASSERT_FATAL(spdk_xor_gen(dst, sources, nsrcs, nbytes) == 0);
+
+	spdk_thread_send_msg(spdk_get_thread(), finish_xor, ctx);
+
+	return 0;
+}
+
+void
+raid_bdev_io_complete(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
+{
+	struct spdk_bdev_io *bdev_io = spdk_bdev_io_from_ctx(raid_io);
+
+	bdev_io->internal.status = status;
+}
+
+bool
+raid_bdev_io_complete_part(struct raid_bdev_io *raid_io, uint64_t completed,
+			   enum spdk_bdev_io_status status)
+{
+	assert(raid_io->base_bdev_io_remaining >= completed);
+	raid_io->base_bdev_io_remaining -= completed;
+
+	if (status != SPDK_BDEV_IO_STATUS_SUCCESS) {
+		raid_io->base_bdev_io_status = status;
+	}
+
+	if (raid_io->base_bdev_io_remaining == 0) {
+		raid_bdev_io_complete(raid_io, raid_io->base_bdev_io_status);
+		return true;
+	} else {
+		return false;
+	}
+}
+
+void
+raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	g_process_status = status;
+	g_process_done = true;
+}
+
+void
+spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
+{
+	free(bdev_io);
+}
+
+/* Base bdevs backed by memory */
+struct test_disk {
+	struct spdk_bdev *bdev;
+	void *buf;
+	size_t size;
+} *g_test_disks;
+uint8_t g_test_disks_num;
+uint64_t g_test_disk_reads;
+
+static void
+test_disk_io_complete(void *_bdev_io)
+{
+	struct spdk_bdev_io *bdev_io = _bdev_io;
+
+	bdev_io->internal.cb(bdev_io, true, bdev_io->internal.caller_ctx);
+}
+
+static int
+test_disk_io(struct spdk_bdev_desc *desc, struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+	     uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg, bool write)
+{
+	struct spdk_bdev *bdev = desc->bdev;
+	struct spdk_bdev_io *bdev_io;
+	struct test_disk *disk = NULL;
+	uint8_t i;
+
+	for (i = 0; i < g_test_disks_num; i++) {
+		if (g_test_disks[i].bdev == bdev) {
+			disk = &g_test_disks[i];
+		}
+	}
+	SPDK_CU_ASSERT_FATAL(disk != NULL);
+	SPDK_CU_ASSERT_FATAL((offset_blocks + num_blocks) * bdev->blocklen <= disk->size);
+
+	if (write) {
+		spdk_copy_iovs_to_buf(disk->buf + offset_blocks * bdev->blocklen,
+				      num_blocks * bdev->blocklen, iov, iovcnt);
+	} else {
+		spdk_copy_buf_to_iovs(iov, iovcnt, disk->buf + offset_blocks * bdev->blocklen,
+				      num_blocks * bdev->blocklen);
+		g_test_disk_reads++;
+	}
+
+	bdev_io = calloc(1, sizeof(*bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->bdev = bdev;
+	bdev_io->internal.cb = cb;
+	bdev_io->internal.caller_ctx = cb_arg;
+
+	spdk_thread_send_msg(spdk_get_thread(), test_disk_io_complete, bdev_io);
+
+	return 0;
+}
+
+int
+spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			    struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+			    uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
+			    struct spdk_bdev_ext_io_opts *opts)
+{
+	CU_ASSERT_PTR_NULL(opts->memory_domain);
+	CU_ASSERT_PTR_NULL(opts->memory_domain_ctx);
+
+	return test_disk_io(desc, iov, iovcnt, offset_blocks, num_blocks, cb, cb_arg, true);
+}
+
+int
+spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			   struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+			   uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
+			   struct spdk_bdev_ext_io_opts *opts)
+{
+	CU_ASSERT_PTR_NULL(opts->memory_domain);
+	CU_ASSERT_PTR_NULL(opts->memory_domain_ctx);
+
+	return test_disk_io(desc, iov, iovcnt, offset_blocks, num_blocks, cb, cb_arg, false);
+}
+
+int
+spdk_bdev_write_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
+		       uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct iovec iov = {
+		.iov_base = buf,
+		.iov_len = num_blocks * desc->bdev->blocklen,
+	};
+
+	return test_disk_io(desc, &iov, 1, offset_blocks, num_blocks, cb, cb_arg, true);
+}
+
+int
+spdk_bdev_read_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch, void *buf,
+		      uint64_t offset_blocks, uint64_t num_blocks,
+		      spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct iovec iov = {
+		.iov_base = buf,
+		.iov_len = num_blocks * desc->bdev->blocklen,
+	};
+
+	return test_disk_io(desc, &iov, 1, offset_blocks, num_blocks, cb, cb_arg, false);
+}
+
+static void
+init_accel(void)
+{
+	spdk_io_device_register(g_accel_p, accel_channel_create, accel_channel_destroy,
+				sizeof(int), "accel_p");
+}
+
+static void
+fini_accel(void)
+{
+	spdk_io_device_unregister(g_accel_p, NULL);
+}
+
+static int
+test_suite_init(void)
+{
+	uint8_t num_base_bdevs_values[] = { 4, 5, 6 };
+	uint64_t base_bdev_blockcnt_values[] = { 1, 1024 };
+	uint32_t base_bdev_blocklen_values[] = { 512, 4096 };
+	uint32_t strip_size_kb_values[] = { 1, 4, 64 };
+	uint8_t *num_base_bdevs;
+	uint64_t *base_bdev_blockcnt;
+	uint32_t *base_bdev_blocklen;
+	uint32_t *strip_size_kb;
+	struct raid_params params;
+	uint64_t params_count;
+	int rc;
+
+	params_count = SPDK_COUNTOF(num_base_bdevs_values) *
+		       SPDK_COUNTOF(base_bdev_blockcnt_values) *
+		       SPDK_COUNTOF(base_bdev_blocklen_values) *
+		       SPDK_COUNTOF(strip_size_kb_values);
+	rc = raid_test_params_alloc(params_count);
+	if (rc) {
+		return rc;
+	}
+
+	ARRAY_FOR_EACH(num_base_bdevs_values, num_base_bdevs) {
+		ARRAY_FOR_EACH(base_bdev_blockcnt_values, base_bdev_blockcnt) {
+			ARRAY_FOR_EACH(base_bdev_blocklen_values, base_bdev_blocklen) {
+				ARRAY_FOR_EACH(strip_size_kb_values, strip_size_kb) {
+					params.num_base_bdevs = *num_base_bdevs;
+					params.base_bdev_blockcnt = *base_bdev_blockcnt;
+					params.base_bdev_blocklen = *base_bdev_blocklen;
+					params.strip_size = *strip_size_kb * 1024 / *base_bdev_blocklen;
+					params.md_len = 0;
+					if (params.strip_size == 0 ||
+					    params.strip_size > *base_bdev_blockcnt) {
+						continue;
+					}
+					raid_test_params_add(&params);
+				}
+			}
+		}
+	}
+
+	init_accel();
+
+	return 0;
+}
+
+static int
+test_suite_cleanup(void)
+{
+	fini_accel();
+	raid_test_params_free();
+	return 0;
+}
+
+static struct raid6f_info *
+create_raid6f(struct raid_params *params)
+{
+	struct raid_bdev *raid_bdev = raid_test_create_raid_bdev(params, &g_raid6f_module);
+
+	SPDK_CU_ASSERT_FATAL(raid6f_start(raid_bdev) == 0);
+
+	return raid_bdev->module_private;
+}
+
+static void
+delete_raid6f(struct raid6f_info *r6f_info)
+{
+	struct raid_bdev *raid_bdev = r6f_info->raid_bdev;
+
+	raid6f_stop(raid_bdev);
+
+	raid_test_delete_raid_bdev(raid_bdev);
+}
+
+static void
+test_raid6f_start(void)
+{
+	struct raid_params *params;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		struct raid6f_info *r6f_info;
+
+		r6f_info = create_raid6f(params);
+
+		SPDK_CU_ASSERT_FATAL(r6f_info != NULL);
+
+		CU_ASSERT_EQUAL(r6f_info->stripe_blocks, params->strip_size * (params->num_base_bdevs - 2));
+		CU_ASSERT_EQUAL(r6f_info->total_stripes, params->base_bdev_blockcnt / params->strip_size);
+		CU_ASSERT_EQUAL(r6f_info->raid_bdev->bdev.blockcnt,
+				(params->base_bdev_blockcnt - params->base_bdev_blockcnt % params->strip_size) *
+				(params->num_base_bdevs - 2));
+		CU_ASSERT_EQUAL(r6f_info->raid_bdev->bdev.optimal_io_boundary, params->strip_size);
+		CU_ASSERT_TRUE(r6f_info->raid_bdev->bdev.split_on_optimal_io_boundary);
+		CU_ASSERT_EQUAL(r6f_info->raid_bdev->bdev.write_unit_size, r6f_info->stripe_blocks);
+
+		delete_raid6f(r6f_info);
+	}
+}
+
+static void
+test_raid6f_chunk_index(void)
+{
+	struct raid_params *params;
+	uint64_t stripe_index;
+	uint8_t i, d;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		struct raid6f_info *r6f_info = create_raid6f(params);
+		struct raid_bdev *raid_bdev = r6f_info->raid_bdev;
+		uint8_t n = raid6f_stripe_data_chunks_num(raid_bdev);
+
+		for (stripe_index = 0; stripe_index < 2 * raid_bdev->num_base_bdevs; stripe_index++) {
+			uint8_t p_idx = raid6f_stripe_p_chunk_index(raid_bdev, stripe_index);
+			uint8_t q_idx = raid6f_stripe_q_chunk_index(raid_bdev, stripe_index);
+
+			CU_ASSERT(p_idx != q_idx);
+			CU_ASSERT_EQUAL(raid6f_stripe_chunk_pq_index(raid_bdev, stripe_index, p_idx), n);
+			CU_ASSERT_EQUAL(raid6f_stripe_chunk_pq_index(raid_bdev, stripe_index, q_idx), n + 1);
+
+			for (i = 0, d = 0; i < raid_bdev->num_base_bdevs; i++) {
+				if (i == p_idx || i == q_idx) {
+					continue;
+				}
+				CU_ASSERT_EQUAL(raid6f_stripe_data_chunk_base_index(raid_bdev, stripe_index, d), i);
+				CU_ASSERT_EQUAL(raid6f_stripe_chunk_pq_index(raid_bdev, stripe_index, i), d);
+				d++;
+			}
+		}
+
+		delete_raid6f(r6f_info);
+	}
+}
+
+static void
+test_disks_init(struct raid_bdev *raid_bdev, uint64_t num_stripes)
+{
+	size_t size = num_stripes * raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	uint8_t i;
+	size_t j;
+
+	g_test_disks_num = raid_bdev->num_base_bdevs;
+	g_test_disks = calloc(g_test_disks_num, sizeof(*g_test_disks));
+	SPDK_CU_ASSERT_FATAL(g_test_disks != NULL);
+
+	for (i = 0; i < g_test_disks_num; i++) {
+		g_test_disks[i].bdev = raid_bdev->base_bdev_info[i].bdev;
+		g_test_disks[i].size = size;
+		g_test_disks[i].buf = malloc(size);
+		SPDK_CU_ASSERT_FATAL(g_test_disks[i].buf != NULL);
+		for (j = 0; j < size; j++) {
+			((uint8_t *)g_test_disks[i].buf)[j] = rand();
+		}
+	}
+
+	g_test_disk_reads = 0;
+}
+
+static void
+test_disks_fini(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < g_test_disks_num; i++) {
+		free(g_test_disks[i].buf);
+	}
+	free(g_test_disks);
+	g_test_disks = NULL;
+	g_test_disks_num = 0;
+}
+
+static void
+xor_block(uint8_t *a, uint8_t *b, size_t size)
+{
+	while (size-- > 0) {
+		a[size] ^= b[size];
+	}
+}
+
+/* Reference Q, the sum of 2^d * data[d] in GF(2^8) */
+static void
+ref_q_block(uint8_t *q, uint8_t *data, uint8_t d, size_t size)
+{
+	size_t j;
+	uint8_t k;
+
+	for (j = 0; j < size; j++) {
+		uint8_t b = data[j];
+
+		for (k = 0; k < d; k++) {
+			b = (b << 1) ^ (b & 0x80 ? 0x1d : 0);
+		}
+		q[j] ^= b;
+	}
+}
+
+/* Checks the data chunks of the present base bdevs against the expected data and P and Q */
+static void
+test_disks_check_stripe(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+			uint64_t stripe_index, uint8_t *stripe_data)
+{
+	size_t strip_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	uint8_t p_idx = raid6f_stripe_p_chunk_index(raid_bdev, stripe_index);
+	uint8_t q_idx = raid6f_stripe_q_chunk_index(raid_bdev, stripe_index);
+	uint8_t *p, *q;
+	uint8_t d, i;
+
+	p = calloc(1, strip_len);
+	SPDK_CU_ASSERT_FATAL(p != NULL);
+	q = calloc(1, strip_len);
+	SPDK_CU_ASSERT_FATAL(q != NULL);
+
+	for (d = 0; d < raid6f_stripe_data_chunks_num(raid_bdev); d++) {
+		i = raid6f_stripe_data_chunk_base_index(raid_bdev, stripe_index, d);
+
+		xor_block(p, stripe_data + d * strip_len, strip_len);
+		ref_q_block(q, stripe_data + d * strip_len, d, strip_len);
+		if (raid_ch->base_channel[i] != NULL) {
+			CU_ASSERT(memcmp(g_test_disks[i].buf + stripe_index * strip_len,
+					 stripe_data + d * strip_len, strip_len) == 0);
+		}
+	}
+
+	if (raid_ch->base_channel[p_idx] != NULL) {
+		CU_ASSERT(memcmp(g_test_disks[p_idx].buf + stripe_index * strip_len, p, strip_len) == 0);
+	}
+	if (raid_ch->base_channel[q_idx] != NULL) {
+		CU_ASSERT(memcmp(g_test_disks[q_idx].buf + stripe_index * strip_len, q, strip_len) == 0);
+	}
+
+	free(p);
+	free(q);
+}
+
+static struct raid_bdev_io *
+get_raid_io(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+	    enum spdk_bdev_io_type io_type, uint64_t offset_blocks, uint64_t num_blocks, void *buf)
+{
+	struct spdk_bdev_io *bdev_io;
+	struct raid_bdev_io *raid_io;
+
+	bdev_io = calloc(1, sizeof(*bdev_io) + sizeof(*raid_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->bdev = &raid_bdev->bdev;
+	bdev_io->type = io_type;
+	bdev_io->u.bdev.offset_blocks = offset_blocks;
+	bdev_io->u.bdev.num_blocks = num_blocks;
+	bdev_io->iov.iov_base = buf;
+	bdev_io->iov.iov_len = num_blocks * raid_bdev->bdev.blocklen;
+	bdev_io->u.bdev.iovs = &bdev_io->iov;
+	bdev_io->u.bdev.iovcnt = 1;
+	bdev_io->internal.status = SPDK_BDEV_IO_STATUS_PENDING;
+
+	raid_io = (void *)bdev_io->driver_ctx;
+	raid_io->raid_bdev = raid_bdev;
+	raid_io->raid_ch = raid_ch;
+	raid_io->base_bdev_io_status = SPDK_BDEV_IO_STATUS_SUCCESS;
+
+	return raid_io;
+}
+
+static void
+test_raid6f_rw(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+	       enum spdk_bdev_io_type io_type, uint64_t offset_blocks, uint64_t num_blocks,
+	       void *buf)
+{
+	struct raid_bdev_io *raid_io;
+	struct spdk_bdev_io *bdev_io;
+
+	raid_io = get_raid_io(raid_bdev, raid_ch, io_type, offset_blocks, num_blocks, buf);
+	bdev_io = spdk_bdev_io_from_ctx(raid_io);
+
+	raid6f_submit_rw_request(raid_io);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(bdev_io->internal.status, SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	free(bdev_io);
+}
+
+static void
+run_for_each_raid6f_config(void (*test_fn)(struct raid_bdev *raid_bdev,
+			   struct raid_bdev_io_channel *raid_ch, uint8_t missing_a, uint8_t missing_b))
+{
+	struct raid_params *params;
+	uint8_t a, b, i;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		/* No base bdevs missing is tested with a == b == num_base_bdevs */
+		for (a = 0; a <= params->num_base_bdevs; a++) {
+			for (b = a; b <= params->num_base_bdevs; b++) {
+				struct raid6f_info *r6f_info;
+				struct raid_bdev_io_channel raid_ch = { 0 };
+
+				r6f_info = create_raid6f(params);
+
+				raid_ch.num_channels = params->num_base_bdevs;
+				raid_ch.base_channel = calloc(params->num_base_bdevs,
+							      sizeof(struct spdk_io_channel *));
+				SPDK_CU_ASSERT_FATAL(raid_ch.base_channel != NULL);
+
+				for (i = 0; i < params->num_base_bdevs; i++) {
+					if (i != a && i != b) {
+						raid_ch.base_channel[i] = (void *)1;
+					}
+				}
+
+				raid_ch.module_channel = raid6f_get_io_channel(r6f_info->raid_bdev);
+				SPDK_CU_ASSERT_FATAL(raid_ch.module_channel);
+
+				test_fn(r6f_info->raid_bdev, &raid_ch, a, b);
+
+				spdk_put_io_channel(raid_ch.module_channel);
+				poll_threads();
+
+				free(raid_ch.base_channel);
+
+				delete_raid6f(r6f_info);
+			}
+		}
+	}
+}
+
+static void
+__test_raid6f_write_read(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+			 uint8_t missing_a, uint8_t missing_b)
+{
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	uint64_t num_stripes = spdk_min(r6f_info->total_stripes, raid_bdev->num_base_bdevs);
+	size_t stripe_len = r6f_info->stripe_blocks * blocklen;
+	uint64_t stripe_index, offset, len;
+	uint8_t *stripe_data, *buf;
+	size_t j;
+
+	stripe_data = spdk_dma_malloc(stripe_len, 4096, NULL);
+	SPDK_CU_ASSERT_FATAL(stripe_data != NULL);
+	buf = spdk_dma_malloc(raid_bdev->strip_size * blocklen, 4096, NULL);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+
+	test_disks_init(raid_bdev, num_stripes);
+
+	for (stripe_index = 0; stripe_index < num_stripes; stripe_index++) {
+		for (j = 0; j < stripe_len; j++) {
+			stripe_data[j] = rand();
+		}
+
+		test_raid6f_rw(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_WRITE,
+			       stripe_index * r6f_info->stripe_blocks, r6f_info->stripe_blocks,
+			       stripe_data);
+		test_disks_check_stripe(raid_bdev, raid_ch, stripe_index, stripe_data);
+
+		/* Read each strip, then a range from the middle of it */
+		for (offset = 0; offset < r6f_info->stripe_blocks; offset += raid_bdev->strip_size) {
+			len = raid_bdev->strip_size;
+			test_raid6f_rw(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+				       stripe_index * r6f_info->stripe_blocks + offset, len, buf);
+			CU_ASSERT(memcmp(buf, stripe_data + offset * blocklen, len * blocklen) == 0);
+
+			if (raid_bdev->strip_size > 2) {
+				len = raid_bdev->strip_size - 2;
+				test_raid6f_rw(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+					       stripe_index * r6f_info->stripe_blocks + offset + 1, len,
+					       buf);
+				CU_ASSERT(memcmp(buf, stripe_data + (offset + 1) * blocklen,
+						 len * blocklen) == 0);
+			}
+		}
+	}
+
+	test_disks_fini();
+	spdk_dma_free(buf);
+	spdk_dma_free(stripe_data);
+}
+
+static void
+test_raid6f_write_read(void)
+{
+	run_for_each_raid6f_config(__test_raid6f_write_read);
+}
+
+static void
+__test_raid6f_degraded_read_q(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+			      uint8_t missing_a, uint8_t missing_b)
+{
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	uint64_t stripe_index = 0;
+	uint8_t n = raid6f_stripe_data_chunks_num(raid_bdev);
+	uint8_t *stripe_data, *buf;
+	uint64_t reads;
+	size_t j;
+
+	/* Only a single data chunk missing, its reads don't need Q */
+	if (missing_a != missing_b || missing_a == raid_bdev->num_base_bdevs ||
+	    missing_a == raid6f_stripe_p_chunk_index(raid_bdev, stripe_index) ||
+	    missing_a == raid6f_stripe_q_chunk_index(raid_bdev, stripe_index)) {
+		return;
+	}
+
+	stripe_data = spdk_dma_malloc(r6f_info->stripe_blocks * blocklen, 4096, NULL);
+	SPDK_CU_ASSERT_FATAL(stripe_data != NULL);
+	buf = spdk_dma_malloc(blocklen, 4096, NULL);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+
+	test_disks_init(raid_bdev, 1);
+
+	for (j = 0; j < r6f_info->stripe_blocks * blocklen; j++) {
+		stripe_data[j] = rand();
+	}
+	test_raid6f_rw(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_WRITE, 0, r6f_info->stripe_blocks,
+		       stripe_data);
+
+	j = raid6f_stripe_chunk_pq_index(raid_bdev, stripe_index, missing_a) * raid_bdev->strip_size;
+	reads = g_test_disk_reads;
+	test_raid6f_rw(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ, j, 1, buf);
+	CU_ASSERT(memcmp(buf, stripe_data + j * blocklen, blocklen) == 0);
+	CU_ASSERT_EQUAL(g_test_disk_reads - reads, n);
+
+	test_disks_fini();
+	spdk_dma_free(buf);
+	spdk_dma_free(stripe_data);
+}
+
+static void
+test_raid6f_degraded_read_q(void)
+{
+	run_for_each_raid6f_config(__test_raid6f_degraded_read_q);
+}
+
+static void
+raid6f_process_request_run(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+			   uint8_t target_idx, uint64_t offset_blocks, uint64_t num_blocks)
+{
+	struct raid_bdev_process_request process_req = { 0 };
+
+	process_req.raid_ch = raid_ch;
+	process_req.target = &raid_bdev->base_bdev_info[target_idx];
+	process_req.target->raid_bdev = raid_bdev;
+	process_req.target_ch = (void *)1;
+	process_req.offset_blocks = offset_blocks;
+	process_req.num_blocks = num_blocks;
+	process_req.buf = spdk_dma_malloc(2 * num_blocks * raid_bdev->bdev.blocklen, 4096, NULL);
+	SPDK_CU_ASSERT_FATAL(process_req.buf != NULL);
+
+	g_process_done = false;
+	g_process_status = -1;
+
+	CU_ASSERT(raid6f_submit_process_request(&process_req) == 0);
+	poll_threads();
+
+	CU_ASSERT(g_process_done);
+	CU_ASSERT_EQUAL(g_process_status, 0);
+	CU_ASSERT_PTR_NULL(process_req.module_private);
+
+	spdk_dma_free(process_req.buf);
+}
+
+static void
+__test_raid6f_rebuild(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+		      uint8_t missing_a, uint8_t missing_b)
+{
+	struct raid6f_info *r6f_info = raid_bdev->module_private;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	uint64_t num_stripes = spdk_min(r6f_info->total_stripes, 2 * raid_bdev->num_base_bdevs);
+	size_t disk_size;
+	uint8_t *stripe_data, *expected;
+	uint64_t stripe_index;
+	size_t j;
+
+	/* missing_a is the target, it's not in the process channel like another missing one */
+	if (missing_a == raid_bdev->num_base_bdevs || num_stripes < 2) {
+		return;
+	}
+
+	stripe_data = spdk_dma_malloc(r6f_info->stripe_blocks * blocklen, 4096, NULL);
+	SPDK_CU_ASSERT_FATAL(stripe_data != NULL);
+
+	test_disks_init(raid_bdev, num_stripes);
+	disk_size = g_test_disks[missing_a].size;
+
+	/* Write the stripes with all base bdevs present */
+	raid_ch->base_channel[missing_a] = (void *)1;
+	if (missing_b != raid_bdev->num_base_bdevs) {
+		raid_ch->base_channel[missing_b] = (void *)1;
+	}
+	for (stripe_index = 0; stripe_index < num_stripes; stripe_index++) {
+		for (j = 0; j < r6f_info->stripe_blocks * blocklen; j++) {
+			stripe_data[j] = rand();
+		}
+		test_raid6f_rw(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_WRITE,
+			       stripe_index * r6f_info->stripe_blocks, r6f_info->stripe_blocks,
+			       stripe_data);
+	}
+	raid_ch->base_channel[missing_a] = NULL;
+	if (missing_b != raid_bdev->num_base_bdevs) {
+		raid_ch->base_channel[missing_b] = NULL;
+	}
+
+	expected = malloc(disk_size);
+	SPDK_CU_ASSERT_FATAL(expected != NULL);
+	memcpy(expected, g_test_disks[missing_a].buf, disk_size);
+	memset(g_test_disks[missing_a].buf, 0, disk_size);
+
+	/* Rebuild all but the first stripe */
+	raid6f_process_request_run(raid_bdev, raid_ch, missing_a, r6f_info->stripe_blocks,
+				   (num_stripes - 1) * r6f_info->stripe_blocks);
+
+	j = raid_bdev->strip_size * blocklen;
+	CU_ASSERT(spdk_mem_all_zero(g_test_disks[missing_a].buf, j));
+	CU_ASSERT(memcmp(g_test_disks[missing_a].buf + j, expected + j, disk_size - j) == 0);
+
+	free(expected);
+	test_disks_fini();
+	spdk_dma_free(stripe_data);
+}
+
+static void
+test_raid6f_rebuild(void)
+{
+	run_for_each_raid6f_config(__test_raid6f_rebuild);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("raid6f", test_suite_init, test_suite_cleanup);
+	CU_ADD_TEST(suite, test_raid6f_start);
+	CU_ADD_TEST(suite, test_raid6f_chunk_index);
+	CU_ADD_TEST(suite, test_raid6f_write_read);
+	CU_ADD_TEST(suite, test_raid6f_degraded_read_q);
+	CU_ADD_TEST(suite, test_raid6f_rebuild);
+
+	allocate_threads(1);
+	set_thread(0);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	free_threads();
+
+	return num_failures;
+}
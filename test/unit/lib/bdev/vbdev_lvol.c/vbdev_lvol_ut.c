@@ -51,6 +51,8 @@ DEFINE_STUB(spdk_lvs_esnap_missing_add, int,
 	     uint32_t id_len), -ENOTSUP);
 DEFINE_STUB(spdk_blob_get_esnap_bs_dev, struct spdk_bs_dev *, (const struct spdk_blob *blob), NULL);
 DEFINE_STUB(spdk_lvol_is_degraded, bool, (const struct spdk_lvol *lvol), false);
+DEFINE_STUB_V(spdk_bs_set_read_cache, (struct spdk_blob_store *bs, struct spdk_bs_dev *cache_dev,
+				       spdk_bs_op_complete cb_fn, void *cb_arg));
 
 struct spdk_blob {
 	uint64_t	id;
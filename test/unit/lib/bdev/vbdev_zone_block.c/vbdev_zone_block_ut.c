@@ -22,6 +22,8 @@ struct io_output *g_io_output = NULL;
 uint32_t g_max_io_size;
 uint32_t g_io_output_index;
 uint32_t g_io_comp_status;
+uint32_t g_io_enomem;
+struct spdk_bdev_io_wait_entry *g_io_wait_entry;
 uint8_t g_rpc_err;
 uint8_t g_json_decode_obj_construct;
 static TAILQ_HEAD(, spdk_bdev) g_bdev_list = TAILQ_HEAD_INITIALIZER(g_bdev_list);
@@ -353,6 +355,11 @@ spdk_bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_chan
 
 	SPDK_CU_ASSERT_FATAL(g_io_output_index < g_max_io_size);
 
+	if (g_io_enomem) {
+		g_io_enomem--;
+		return -ENOMEM;
+	}
+
 	set_io_output(output, desc, ch, offset_blocks, num_blocks, cb, cb_arg,
 		      SPDK_BDEV_IO_TYPE_WRITE);
 	g_io_output_index++;
@@ -383,6 +390,17 @@ spdk_bdev_writev_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 					       cb, cb_arg);
 }
 
+int
+spdk_bdev_queue_io_wait(struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+			struct spdk_bdev_io_wait_entry *entry)
+{
+	CU_ASSERT(bdev == entry->bdev);
+	CU_ASSERT(g_io_wait_entry == NULL);
+	g_io_wait_entry = entry;
+
+	return 0;
+}
+
 int
 spdk_bdev_readv_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 			       struct iovec *iov, int iovcnt, void *md,
@@ -1465,6 +1483,69 @@ test_append_zone(void)
 	test_cleanup();
 }
 
+static void
+test_append_zone_nomem(void)
+{
+	struct spdk_io_channel *ch;
+	struct bdev_zone_block *bdev;
+	struct spdk_bdev_io *bdev_io;
+	struct spdk_bdev_io_wait_entry *entry;
+	char *name = "Nvme0n1";
+	uint32_t num_zones = 20;
+	uint64_t zone_id = 0;
+	uint32_t output_index = 0;
+
+	init_test_globals(20 * 1024ul);
+	CU_ASSERT(zone_block_init() == 0);
+
+	/* Create zone dev */
+	bdev = create_and_get_vbdev("zone_dev1", name, num_zones, 1, true);
+
+	ch = calloc(1, sizeof(struct spdk_io_channel) + sizeof(struct zone_block_io_channel));
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	send_reset_zone(bdev, ch, zone_id, output_index, true);
+
+	/* Base bdev out of bdev_ios - the append keeps its offset and waits */
+	bdev_io = calloc(1, sizeof(struct spdk_bdev_io) + sizeof(struct zone_block_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io_initialize(bdev_io, &bdev->bdev, zone_id, 4, SPDK_BDEV_IO_TYPE_ZONE_APPEND);
+	memset(g_io_output, 0, (g_max_io_size * sizeof(struct io_output)));
+	g_io_output_index = output_index;
+
+	g_io_enomem = 1;
+	g_io_comp_status = 0xff;
+	zone_block_submit_request(ch, bdev_io);
+	CU_ASSERT(g_io_comp_status == 0xff);
+	SPDK_CU_ASSERT_FATAL(g_io_wait_entry != NULL);
+	CU_ASSERT(g_io_output_index == output_index);
+
+	/* Following append is assigned the offset after it */
+	send_append_zone(bdev, ch, zone_id, 8, output_index, true, zone_id + 4);
+	send_zone_info(bdev, ch, zone_id, zone_id + 12, SPDK_BDEV_ZONE_STATE_OPEN, output_index, true);
+
+	/* Resubmit the waiting append */
+	entry = g_io_wait_entry;
+	g_io_wait_entry = NULL;
+	g_io_output_index = output_index;
+	entry->cb_fn(entry->cb_arg);
+	CU_ASSERT(g_io_comp_status == true);
+	CU_ASSERT(g_io_output_index == output_index + 1);
+	CU_ASSERT(g_io_output[output_index].offset_blocks == zone_id);
+	CU_ASSERT(bdev_io->u.bdev.offset_blocks == zone_id);
+	bdev_io_cleanup(bdev_io);
+
+	send_zone_info(bdev, ch, zone_id, zone_id + 12, SPDK_BDEV_ZONE_STATE_OPEN, output_index, true);
+
+	/* Delete zone dev */
+	send_delete_vbdev("zone_dev1", true);
+
+	while (spdk_thread_poll(g_thread, 0, 0) > 0) {}
+	free(ch);
+
+	test_cleanup();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1487,6 +1568,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_close_zone);
 	CU_ADD_TEST(suite, test_finish_zone);
 	CU_ADD_TEST(suite, test_append_zone);
+	CU_ADD_TEST(suite, test_append_zone_nomem);
 
 	g_thread = spdk_thread_create("test", NULL);
 	spdk_set_thread(g_thread);
@@ -17,6 +17,8 @@
 #include "blob/request.c"
 #include "blob/zeroes.c"
 #include "blob/blob_bs_dev.c"
+#include "blob/esnap_cache.c"
+#include "blob/read_cache.c"
 #include "esnap_dev.c"
 
 struct spdk_blob_store *g_bs;
@@ -2083,6 +2085,76 @@ blob_iter(void)
 	CU_ASSERT(g_bserrno == -ENOENT);
 }
 
+static void
+blob_iter_prefetch(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	spdk_blob_id blobids[4];
+	struct spdk_blob_opts blob_opts;
+	const void *value;
+	size_t value_len;
+	int i, rc;
+
+	ut_spdk_blob_opts_init(&blob_opts);
+	for (i = 0; i < 4; i++) {
+		spdk_bs_create_blob_ext(bs, &blob_opts, blob_op_with_id_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		blobids[i] = g_blobid;
+	}
+
+	/* Opening the first blob reads ahead the md of the next ones */
+	spdk_bs_iter_first(bs, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	CU_ASSERT(spdk_blob_get_id(g_blob) == blobids[0]);
+	CU_ASSERT(bs->num_md_prefetches == 3);
+	blob = g_blob;
+
+	/* Modify a blob whose md was read ahead, the iteration must not see the old md */
+	spdk_bs_open_blob(bs, blobids[2], blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	CU_ASSERT(bs->num_md_prefetches == 2);
+	rc = spdk_blob_set_xattr(g_blob, "name", "blob2", strlen("blob2") + 1);
+	CU_ASSERT(rc == 0);
+	spdk_blob_close(g_blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	for (i = 1; i < 4; i++) {
+		spdk_bs_iter_next(bs, blob, blob_op_with_handle_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+		CU_ASSERT(spdk_blob_get_id(g_blob) == blobids[i]);
+		blob = g_blob;
+
+		rc = spdk_blob_get_xattr_value(blob, "name", &value, &value_len);
+		if (i == 2) {
+			CU_ASSERT(rc == 0);
+			CU_ASSERT(value_len == strlen("blob2") + 1);
+		} else {
+			CU_ASSERT(rc == -ENOENT);
+		}
+	}
+
+	spdk_bs_iter_next(bs, blob, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_blob == NULL);
+	CU_ASSERT(g_bserrno == -ENOENT);
+	CU_ASSERT(bs->num_md_prefetches == 0);
+
+	for (i = 0; i < 4; i++) {
+		spdk_bs_delete_blob(bs, blobids[i], blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+}
+
 static void
 blob_xattr(void)
 {
@@ -4199,6 +4271,236 @@ blob_thin_prov_rw(void)
 	g_blobid = 0;
 }
 
+static void
+blob_thin_prov_cluster_slab(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	uint64_t free_clusters;
+	uint64_t pages_per_cluster;
+	uint8_t payload_write[4096];
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	pages_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_page_size(bs);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+
+	/* Use a thread without other channels, so that freeing this one destroys it */
+	set_thread(1);
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	/* With the extent table, the first write allocates an extent page and bypasses the
+	 * slab. The second one, in the same extent page, is served from the channel's slab. */
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster, 1, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* The clusters left in the slab are still reported as free */
+	CU_ASSERT(free_clusters - 2 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(bs->num_slab_clusters > 0);
+	CU_ASSERT(bs->num_free_clusters + bs->num_slab_clusters == free_clusters - 2);
+
+	/* Destroying the channel returns them to the blobstore */
+	spdk_bs_free_io_channel(channel);
+	set_thread(0);
+	poll_threads();
+	CU_ASSERT(bs->num_slab_clusters == 0);
+	CU_ASSERT(bs->num_free_clusters == free_clusters - 2);
+	CU_ASSERT(blob->active.clusters[0] != 0);
+	CU_ASSERT(blob->active.clusters[1] != 0);
+
+	ut_blob_close_and_delete(bs, blob);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_thin_prov_cluster_slab_reclaim(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *thick;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	struct spdk_bs_dev *dev;
+	spdk_blob_id blobid, thickid;
+	uint64_t free_clusters;
+	uint64_t pages_per_cluster;
+	uint8_t payload_write[4096];
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	pages_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_page_size(bs);
+	memset(payload_write, 0xE5, sizeof(payload_write));
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	set_thread(1);
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	/* The second write fills the slab of the channel */
+	spdk_blob_io_write(blob, channel, payload_write, 0, 1, blob_op_complete, NULL);
+	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster, 1, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->num_slab_clusters > 0);
+
+	/* A thick provisioned blob can be created with all the clusters reported as free */
+	set_thread(0);
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = spdk_bs_free_cluster_count(bs);
+	spdk_bs_create_blob_ext(bs, &opts, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->num_slab_clusters == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 0);
+	spdk_bs_delete_blob(bs, g_blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 2);
+
+	/* Same for resizing a thick provisioned blob */
+	ut_spdk_blob_opts_init(&opts);
+	thick = ut_blob_create_and_open(bs, &opts);
+	thickid = spdk_blob_get_id(thick);
+
+	set_thread(1);
+	spdk_blob_io_write(blob, channel, payload_write, 2 * pages_per_cluster, 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->num_slab_clusters > 0);
+
+	set_thread(0);
+	spdk_blob_resize(thick, spdk_bs_free_cluster_count(bs), blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->num_slab_clusters == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 0);
+	ut_blob_close_and_delete(bs, thick);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 3);
+
+	/* The slab of a channel still allocated at unload isn't persisted as used */
+	set_thread(1);
+	spdk_blob_io_write(blob, channel, payload_write, 3 * pages_per_cluster, 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->num_slab_clusters > 0);
+
+	set_thread(0);
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	g_bserrno = -1;
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	set_thread(1);
+	spdk_bs_free_io_channel(channel);
+	set_thread(0);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	dev = init_dev();
+	spdk_bs_load(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 4);
+
+	spdk_bs_delete_blob(bs, blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_thin_prov_insert_batch(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel, *channel_thread1;
+	struct spdk_blob_opts opts;
+	uint64_t free_clusters;
+	uint64_t page_size;
+	uint64_t pages_per_cluster;
+	uint64_t write_bytes;
+	uint8_t payload_write[4096];
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	page_size = spdk_bs_get_page_size(bs);
+	pages_per_cluster = spdk_bs_get_cluster_size(bs) / page_size;
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+	set_thread(1);
+	channel_thread1 = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel_thread1 != NULL);
+	set_thread(0);
+
+	/* Allocate the first cluster, which also allocates the extent page if it's used */
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Two first writes into the same blob from different threads are persisted with a
+	 * single md write: 2 pages of data and 1 page of md (or of the extent page). */
+	write_bytes = g_dev_write_bytes;
+	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster, 1, blob_op_complete,
+			   NULL);
+	set_thread(1);
+	spdk_blob_io_write(blob, channel_thread1, payload_write, 2 * pages_per_cluster, 1,
+			   blob_op_complete, NULL);
+	set_thread(0);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_write_bytes - write_bytes == page_size * 3);
+	CU_ASSERT(free_clusters - 3 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.clusters[1] != 0);
+	CU_ASSERT(blob->active.clusters[2] != 0);
+
+	ut_blob_close_and_delete(bs, blob);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+
+	set_thread(1);
+	spdk_bs_free_io_channel(channel_thread1);
+	set_thread(0);
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
 static void
 blob_thin_prov_write_count_io(void)
 {
@@ -4725,21 +5027,21 @@ blob_snapshot_rw(void)
 }
 
 static void
-blob_snapshot_rw_iov(void)
+blob_snapshot_rw_copy_fallback(void)
 {
-	static const uint8_t zero[10 * 4096] = { 0 };
 	struct spdk_blob_store *bs = g_bs;
 	struct spdk_blob *blob, *snapshot;
 	struct spdk_io_channel *channel;
 	struct spdk_blob_opts opts;
 	spdk_blob_id blobid, snapshotid;
-	uint64_t free_clusters;
+	uint64_t cluster_size;
 	uint8_t payload_read[10 * 4096];
 	uint8_t payload_write[10 * 4096];
-	struct iovec iov_read[3];
-	struct iovec iov_write[3];
+	uint8_t payload_expected[10 * 4096];
+	uint64_t read_bytes_start;
+	uint64_t copy_bytes_start;
 
-	free_clusters = spdk_bs_free_cluster_count(bs);
+	cluster_size = spdk_bs_get_cluster_size(bs);
 
 	channel = spdk_bs_alloc_io_channel(bs);
 	CU_ASSERT(channel != NULL);
@@ -4750,11 +5052,12 @@ blob_snapshot_rw_iov(void)
 
 	blob = ut_blob_create_and_open(bs, &opts);
 	blobid = spdk_blob_get_id(blob);
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
 
-	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 5);
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
 
-	/* Create snapshot from blob */
 	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
@@ -4766,17 +5069,217 @@ blob_snapshot_rw_iov(void)
 	CU_ASSERT(g_bserrno == 0);
 	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
 	snapshot = g_blob;
-	CU_ASSERT(snapshot->data_ro == true);
-	CU_ASSERT(snapshot->md_ro == true);
-	CU_ASSERT(spdk_blob_get_num_clusters(snapshot) == 5);
 
-	/* Payload should be all zeros from unallocated clusters */
-	memset(payload_read, 0xAA, sizeof(payload_read));
-	iov_read[0].iov_base = payload_read;
-	iov_read[0].iov_len = 3 * 4096;
-	iov_read[1].iov_base = payload_read + 3 * 4096;
-	iov_read[1].iov_len = 4 * 4096;
-	iov_read[2].iov_base = payload_read + 7 * 4096;
+	/* A failed copy of the cluster falls back to reading and writing it */
+	read_bytes_start = g_dev_read_bytes;
+	copy_bytes_start = g_dev_copy_bytes;
+	g_dev_copy_status = -EIO;
+
+	memset(payload_write, 0xAA, 4096);
+	spdk_blob_io_write(blob, channel, payload_write, 4, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_copy_bytes == copy_bytes_start);
+	CU_ASSERT(g_dev_read_bytes - read_bytes_start == cluster_size);
+
+	g_dev_copy_status = 0;
+
+	/* The rest of the cluster was copied from the snapshot */
+	memset(payload_expected, 0xE5, sizeof(payload_expected));
+	memset(payload_expected, 0xAA, 4096);
+	spdk_blob_io_read(blob, channel, payload_read, 4, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_expected, payload_read, 10 * 4096) == 0);
+
+	ut_blob_close_and_delete(bs, blob);
+	ut_blob_close_and_delete(bs, snapshot);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_snapshot_overwrite_cluster(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *snapshot;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid;
+	struct iovec iov[2];
+	uint64_t cluster_size;
+	uint64_t page_size;
+	uint64_t pages_per_cluster;
+	uint64_t write_bytes_start;
+	uint64_t read_bytes_start;
+	uint64_t copy_bytes_start;
+	uint64_t md_bytes;
+	uint8_t *payload_read;
+	uint8_t *payload_write;
+
+	cluster_size = spdk_bs_get_cluster_size(bs);
+	page_size = spdk_bs_get_page_size(bs);
+	pages_per_cluster = cluster_size / page_size;
+	/* One page of md, plus the EXTENT_PAGE if it's used */
+	md_bytes = g_use_extent_table ? page_size * 2 : page_size;
+
+	payload_read = calloc(1, cluster_size);
+	payload_write = calloc(1, cluster_size);
+	SPDK_CU_ASSERT_FATAL(payload_read != NULL && payload_write != NULL);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	/* Allocate clusters 1 and 2, so that the snapshot has data for them */
+	memset(payload_write, 0xE5, cluster_size);
+	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster, 2, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_io_write(blob, channel, payload_write, 2 * pages_per_cluster, 2, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+
+	/* Overwriting a whole cluster neither reads nor copies it from the snapshot */
+	write_bytes_start = g_dev_write_bytes;
+	read_bytes_start = g_dev_read_bytes;
+	copy_bytes_start = g_dev_copy_bytes;
+
+	memset(payload_write, 0xAA, cluster_size);
+	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster, pages_per_cluster,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_read_bytes == read_bytes_start);
+	CU_ASSERT(g_dev_copy_bytes == copy_bytes_start);
+	CU_ASSERT(g_dev_write_bytes - write_bytes_start == cluster_size + md_bytes);
+
+	spdk_blob_io_read(blob, channel, payload_read, pages_per_cluster, pages_per_cluster,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, cluster_size) == 0);
+
+	/* Same with writev */
+	write_bytes_start = g_dev_write_bytes;
+	read_bytes_start = g_dev_read_bytes;
+	copy_bytes_start = g_dev_copy_bytes;
+
+	memset(payload_write, 0xBB, cluster_size);
+	iov[0].iov_base = payload_write;
+	iov[0].iov_len = cluster_size / 2;
+	iov[1].iov_base = payload_write + cluster_size / 2;
+	iov[1].iov_len = cluster_size / 2;
+	spdk_blob_io_writev(blob, channel, iov, 2, 2 * pages_per_cluster, pages_per_cluster,
+			    blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_dev_read_bytes == read_bytes_start);
+	CU_ASSERT(g_dev_copy_bytes == copy_bytes_start);
+	/* The EXTENT_PAGE is already allocated, so only it is updated */
+	CU_ASSERT(g_dev_write_bytes - write_bytes_start == cluster_size + page_size);
+
+	spdk_blob_io_read(blob, channel, payload_read, 2 * pages_per_cluster, pages_per_cluster,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, cluster_size) == 0);
+
+	/* The snapshot keeps its data */
+	memset(payload_write, 0xE5, 2 * page_size);
+	spdk_blob_io_read(snapshot, channel, payload_read, pages_per_cluster, 2, blob_op_complete,
+			  NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 2 * page_size) == 0);
+
+	ut_blob_close_and_delete(bs, blob);
+	ut_blob_close_and_delete(bs, snapshot);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	free(payload_read);
+	free(payload_write);
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_snapshot_rw_iov(void)
+{
+	static const uint8_t zero[10 * 4096] = { 0 };
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *snapshot;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid;
+	uint64_t free_clusters;
+	uint8_t payload_read[10 * 4096];
+	uint8_t payload_write[10 * 4096];
+	struct iovec iov_read[3];
+	struct iovec iov_write[3];
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+
+	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 5);
+
+	/* Create snapshot from blob */
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+	CU_ASSERT(snapshot->data_ro == true);
+	CU_ASSERT(snapshot->md_ro == true);
+	CU_ASSERT(spdk_blob_get_num_clusters(snapshot) == 5);
+
+	/* Payload should be all zeros from unallocated clusters */
+	memset(payload_read, 0xAA, sizeof(payload_read));
+	iov_read[0].iov_base = payload_read;
+	iov_read[0].iov_len = 3 * 4096;
+	iov_read[1].iov_base = payload_read + 3 * 4096;
+	iov_read[1].iov_len = 4 * 4096;
+	iov_read[2].iov_base = payload_read + 7 * 4096;
 	iov_read[2].iov_len = 3 * 4096;
 	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
 	poll_threads();
@@ -4960,174 +5463,763 @@ _blob_inflate_rw(bool decouple_parent)
 	}
 	CU_ASSERT(free_clusters != spdk_bs_free_cluster_count(bs));
 
-	/* Check data consistency on clone */
-	memset(payload_read, 0xFF, payload_size);
-	spdk_blob_io_read(blob, channel, payload_read, 0, pages_per_payload,
-			  blob_op_complete, NULL);
+	/* Check data consistency on clone */
+	memset(payload_read, 0xFF, payload_size);
+	spdk_blob_io_read(blob, channel, payload_read, 0, pages_per_payload,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_clone, payload_read, payload_size) == 0);
+
+	/* 3) Create second levels snapshot from blob */
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshot2id = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshot2id, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot2 = g_blob;
+	CU_ASSERT(snapshot2->data_ro == true);
+	CU_ASSERT(snapshot2->md_ro == true);
+
+	CU_ASSERT(spdk_blob_get_num_clusters(snapshot2) == 5);
+
+	CU_ASSERT(snapshot2->parent_id == snapshotid);
+
+	/* Write one cluster on the top level blob. This cluster (1) covers
+	 * already allocated cluster in the snapshot2, so shouldn't be inflated
+	 * at all */
+	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster,
+			   pages_per_cluster, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Update expected result */
+	memcpy(payload_clone + cluster_size, payload_write, cluster_size);
+
+	/* Check data consistency on clone */
+	memset(payload_read, 0xFF, payload_size);
+	spdk_blob_io_read(blob, channel, payload_read, 0, pages_per_payload,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_clone, payload_read, payload_size) == 0);
+
+
+	/* Close all blobs */
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_blob_close(snapshot2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_blob_close(snapshot, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Check snapshot-clone relations */
+	count = 2;
+	CU_ASSERT(spdk_blob_get_clones(bs, snapshotid, ids, &count) == 0);
+	CU_ASSERT(count == 1);
+	CU_ASSERT(ids[0] == snapshot2id);
+
+	count = 2;
+	CU_ASSERT(spdk_blob_get_clones(bs, snapshot2id, ids, &count) == 0);
+	CU_ASSERT(count == 1);
+	CU_ASSERT(ids[0] == blobid);
+
+	CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid) == snapshot2id);
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	if (!decouple_parent) {
+		/* Do full blob inflation */
+		spdk_bs_inflate_blob(bs, channel, blobid, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+
+		/* All clusters should be inflated (except one already allocated
+		 * in a top level blob) */
+		CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 4);
+
+		/* Check if relation tree updated correctly */
+		count = 2;
+		CU_ASSERT(spdk_blob_get_clones(bs, snapshotid, ids, &count) == 0);
+
+		/* snapshotid have one clone */
+		CU_ASSERT(count == 1);
+		CU_ASSERT(ids[0] == snapshot2id);
+
+		/* snapshot2id have no clones */
+		count = 2;
+		CU_ASSERT(spdk_blob_get_clones(bs, snapshot2id, ids, &count) == 0);
+		CU_ASSERT(count == 0);
+
+		CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid) == SPDK_BLOBID_INVALID);
+	} else {
+		/* Decouple parent of blob */
+		spdk_bs_blob_decouple_parent(bs, channel, blobid, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+
+		/* Only one cluster from a parent should be inflated (second one
+		 * is covered by a cluster written on a top level blob, and
+		 * already allocated) */
+		CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 1);
+
+		/* Check if relation tree updated correctly */
+		count = 2;
+		CU_ASSERT(spdk_blob_get_clones(bs, snapshotid, ids, &count) == 0);
+
+		/* snapshotid have two clones now */
+		CU_ASSERT(count == 2);
+		CU_ASSERT(ids[0] == blobid || ids[1] == blobid);
+		CU_ASSERT(ids[0] == snapshot2id || ids[1] == snapshot2id);
+
+		/* snapshot2id have no clones */
+		count = 2;
+		CU_ASSERT(spdk_blob_get_clones(bs, snapshot2id, ids, &count) == 0);
+		CU_ASSERT(count == 0);
+
+		CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid) == snapshotid);
+	}
+
+	/* Try to delete snapshot2 (should pass) */
+	spdk_bs_delete_blob(bs, snapshot2id, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Try to delete base snapshot */
+	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	/* Reopen blob after snapshot deletion */
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+
+	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 5);
+
+	/* Check data consistency on inflated blob */
+	memset(payload_read, 0xFF, payload_size);
+	spdk_blob_io_read(blob, channel, payload_read, 0, pages_per_payload,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_clone, payload_read, payload_size) == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	free(payload_read);
+	free(payload_write);
+	free(payload_clone);
+
+	ut_blob_close_and_delete(bs, blob);
+}
+
+static void
+blob_inflate_rw(void)
+{
+	_blob_inflate_rw(false);
+	_blob_inflate_rw(true);
+}
+
+static void
+blob_prefill_clusters(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *snapshot;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid, snapshotid;
+	uint64_t clusters[] = { 3, 1, 4 };
+	uint64_t pages_per_cluster;
+	uint64_t free_clusters;
+	uint64_t page_size;
+	uint8_t payload_read[2 * 4096];
+	uint8_t payload_write[2 * 4096];
+
+	page_size = spdk_bs_get_page_size(bs);
+	pages_per_cluster = spdk_bs_get_cluster_size(bs) / page_size;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 5;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	/* A blob without a parent has nothing to prefill */
+	spdk_blob_prefill_clusters(blob, channel, NULL, 0, 0, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EINVAL);
+
+	/* Write to clusters 0, 1 and 3 */
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 0, 2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster, 2, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_io_write(blob, channel, payload_write, 3 * pages_per_cluster, 2, blob_op_complete,
+			   NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+	CU_ASSERT(blob->active.clusters[3] == 0);
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	/* Prefill clusters 3, 1 and 4 at 10 clusters per second */
+	g_bserrno = -1;
+	spdk_blob_prefill_clusters(blob, channel, clusters, SPDK_COUNTOF(clusters), 10,
+				   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -1);
+	CU_ASSERT(blob->active.clusters[3] != 0);
+	CU_ASSERT(blob->active.clusters[1] == 0);
+	CU_ASSERT(blob->locked_operation_in_progress == true);
+
+	/* The blob is locked while the prefill runs */
+	spdk_blob_resize(blob, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EBUSY);
+	g_bserrno = -1;
+
+	/* The next cluster is copied after 100ms */
+	spdk_delay_us(50000);
+	poll_threads();
+	CU_ASSERT(blob->active.clusters[1] == 0);
+	spdk_delay_us(50000);
+	poll_threads();
+	CU_ASSERT(blob->active.clusters[1] != 0);
+
+	/* Cluster 4 is not allocated in the snapshot, so it's skipped */
+	spdk_delay_us(100000);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob->locked_operation_in_progress == false);
+	CU_ASSERT(blob->active.clusters[0] == 0);
+	CU_ASSERT(blob->active.clusters[4] == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 2);
+
+	spdk_blob_io_read(blob, channel, payload_read, 3 * pages_per_cluster, 2, blob_op_complete,
+			  NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, sizeof(payload_read)) == 0);
+
+	/* Prefill all the remaining clusters back to back */
+	spdk_blob_prefill_clusters(blob, channel, NULL, 0, 0, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob->active.clusters[0] != 0);
+	CU_ASSERT(blob->active.clusters[2] == 0);
+	CU_ASSERT(blob->active.clusters[4] == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 3);
+
+	spdk_blob_io_read(blob, channel, payload_read, 0, 2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, sizeof(payload_read)) == 0);
+
+	ut_blob_close_and_delete(bs, blob);
+	ut_blob_close_and_delete(bs, snapshot);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_defragment(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *other;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid;
+	uint64_t pages_per_cluster;
+	uint64_t free_clusters;
+	uint64_t first_lba;
+	uint64_t cluster_lbas;
+	uint8_t payload_read[4096];
+	uint8_t payload_write[4096];
+	uint64_t i;
+
+	pages_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_page_size(bs);
+	cluster_lbas = bs_cluster_to_lba(bs, 1);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 4;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+	other = ut_blob_create_and_open(bs, &opts);
+
+	/* Interleave the allocations of both blobs, then free the clusters of the other one */
+	for (i = 0; i < 3; i++) {
+		memset(payload_write, 0xA0 + i, sizeof(payload_write));
+		spdk_blob_io_write(blob, channel, payload_write, i * pages_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		spdk_blob_io_write(other, channel, payload_write, i * pages_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	ut_blob_close_and_delete(bs, other);
+
+	first_lba = blob->active.clusters[0];
+	CU_ASSERT(blob->active.clusters[1] == first_lba + 2 * cluster_lbas);
+	CU_ASSERT(blob->active.clusters[2] == first_lba + 4 * cluster_lbas);
+	free_clusters = spdk_bs_free_cluster_count(bs);
+
+	/* Move one cluster every 100ms */
+	g_bserrno = -1;
+	spdk_blob_defragment(blob, channel, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -1);
+	CU_ASSERT(blob->active.clusters[1] == first_lba + cluster_lbas);
+	CU_ASSERT(blob->active.clusters[2] == first_lba + 4 * cluster_lbas);
+	CU_ASSERT(blob->locked_operation_in_progress == true);
+
+	/* The blob is locked while the defragmentation runs */
+	spdk_blob_resize(blob, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EBUSY);
+	g_bserrno = -1;
+
+	spdk_delay_us(100000);
+	poll_threads();
+	CU_ASSERT(blob->active.clusters[2] == first_lba + 2 * cluster_lbas);
+	spdk_delay_us(100000);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob->locked_operation_in_progress == false);
+	CU_ASSERT(blob->active.clusters[0] == first_lba);
+	CU_ASSERT(blob->active.clusters[3] == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
+
+	/* The new cluster map is persisted */
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_bs_reload(&bs, NULL);
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
+
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(blob->active.clusters[i] == first_lba + i * cluster_lbas);
+		memset(payload_write, 0xA0 + i, sizeof(payload_write));
+		spdk_blob_io_read(blob, channel, payload_read, i * pages_per_cluster, 1,
+				  blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(memcmp(payload_write, payload_read, sizeof(payload_read)) == 0);
+	}
+
+	/* Nothing left to move */
+	spdk_blob_defragment(blob, channel, 0, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
+
+	ut_blob_close_and_delete(bs, blob);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+static void
+blob_defragment_inflight_io(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *other, *snapshot;
+	struct spdk_io_channel *channel;
+	struct spdk_bs_channel *bs_channel;
+	struct spdk_bs_request_set *set;
+	struct spdk_blob_opts opts;
+	spdk_blob_id blobid;
+	uint64_t pages_per_cluster;
+	uint64_t first_lba;
+	uint64_t cluster_lbas;
+	uint8_t payload_read[4096];
+	uint8_t payload_write[4096];
+	int write_rc;
+	uint64_t i;
+
+	pages_per_cluster = spdk_bs_get_cluster_size(bs) / spdk_bs_get_page_size(bs);
+	cluster_lbas = bs_cluster_to_lba(bs, 1);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
+	bs_channel = spdk_io_channel_get_ctx(channel);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = 2;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+	other = ut_blob_create_and_open(bs, &opts);
+
+	for (i = 0; i < 2; i++) {
+		memset(payload_write, 0xA0 + i, sizeof(payload_write));
+		spdk_blob_io_write(blob, channel, payload_write, i * pages_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		spdk_blob_io_write(other, channel, payload_write, i * pages_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	ut_blob_close_and_delete(bs, other);
+
+	first_lba = blob->active.clusters[0];
+	CU_ASSERT(blob->active.clusters[1] == first_lba + 2 * cluster_lbas);
+
+	/* Pretend that an I/O to the blob issued before the freeze is still in flight */
+	set = TAILQ_FIRST(&bs_channel->reqs);
+	SPDK_CU_ASSERT_FATAL(set != NULL);
+	TAILQ_REMOVE(&bs_channel->reqs, set, link);
+	set->io_blob = blob;
+
+	g_bserrno = -1;
+	spdk_blob_defragment(blob, channel, 0, blob_op_complete, NULL);
+	poll_threads();
+	spdk_delay_us(BLOB_DEFRAG_DRAIN_POLL_US);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -1);
+	CU_ASSERT(blob->frozen_refcnt == 1);
+	CU_ASSERT(blob->active.clusters[1] == first_lba + 2 * cluster_lbas);
+
+	/* New I/O is held until the cluster is moved */
+	write_rc = 1;
+	memset(payload_write, 0xB1, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster, 1, blob_op_complete,
+			   &write_rc);
+	poll_threads();
+	CU_ASSERT(write_rc == 1);
+
+	/* Once it completes, the cluster is copied */
+	set->io_blob = NULL;
+	TAILQ_INSERT_TAIL(&bs_channel->reqs, set, link);
+	spdk_delay_us(BLOB_DEFRAG_DRAIN_POLL_US);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_clone, payload_read, payload_size) == 0);
+	CU_ASSERT(write_rc == 0);
+	CU_ASSERT(blob->frozen_refcnt == 0);
+	CU_ASSERT(blob->active.clusters[1] == first_lba + cluster_lbas);
 
-	/* 3) Create second levels snapshot from blob */
+	spdk_blob_io_read(blob, channel, payload_read, pages_per_cluster, 1, blob_op_complete,
+			  NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, sizeof(payload_read)) == 0);
+
+	/* The clones of a snapshot read its clusters without going through its frozen I/O */
 	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
-	snapshot2id = g_blobid;
-
-	spdk_bs_open_blob(bs, snapshot2id, blob_op_with_handle_complete, NULL);
+	spdk_bs_open_blob(bs, g_blobid, blob_op_with_handle_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
-	snapshot2 = g_blob;
-	CU_ASSERT(snapshot2->data_ro == true);
-	CU_ASSERT(snapshot2->md_ro == true);
+	snapshot = g_blob;
 
-	CU_ASSERT(spdk_blob_get_num_clusters(snapshot2) == 5);
+	spdk_blob_defragment(snapshot, channel, 0, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EBUSY);
+	CU_ASSERT(snapshot->locked_operation_in_progress == false);
 
-	CU_ASSERT(snapshot2->parent_id == snapshotid);
+	ut_blob_close_and_delete(bs, blob);
+	ut_blob_close_and_delete(bs, snapshot);
 
-	/* Write one cluster on the top level blob. This cluster (1) covers
-	 * already allocated cluster in the snapshot2, so shouldn't be inflated
-	 * at all */
-	spdk_blob_io_write(blob, channel, payload_write, pages_per_cluster,
-			   pages_per_cluster, blob_op_complete, NULL);
+	spdk_bs_free_io_channel(channel);
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+	g_blob = NULL;
+	g_blobid = 0;
+}
 
-	/* Update expected result */
-	memcpy(payload_clone + cluster_size, payload_write, cluster_size);
+struct ut_read_cache_dev {
+	struct spdk_bs_dev	bs_dev;
+	uint8_t			*buf;
+	uint64_t		blocks_read;
+	uint64_t		blocks_written;
+	bool			*destroyed;
+};
 
-	/* Check data consistency on clone */
-	memset(payload_read, 0xFF, payload_size);
-	spdk_blob_io_read(blob, channel, payload_read, 0, pages_per_payload,
-			  blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_clone, payload_read, payload_size) == 0);
+static void
+ut_read_cache_dev_read(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, void *payload,
+		       uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	struct ut_read_cache_dev *ut_dev = SPDK_CONTAINEROF(dev, struct ut_read_cache_dev, bs_dev);
 
+	SPDK_CU_ASSERT_FATAL(lba + lba_count <= dev->blockcnt);
+	memcpy(payload, ut_dev->buf + lba * dev->blocklen, lba_count * dev->blocklen);
+	ut_dev->blocks_read += lba_count;
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, 0);
+}
 
-	/* Close all blobs */
-	spdk_blob_close(blob, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+static void
+ut_read_cache_dev_readv(struct spdk_bs_dev *dev, struct spdk_io_channel *channel,
+			struct iovec *iov, int iovcnt, uint64_t lba, uint32_t lba_count,
+			struct spdk_bs_dev_cb_args *cb_args)
+{
+	struct ut_read_cache_dev *ut_dev = SPDK_CONTAINEROF(dev, struct ut_read_cache_dev, bs_dev);
 
-	spdk_blob_close(snapshot2, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(lba + lba_count <= dev->blockcnt);
+	spdk_copy_buf_to_iovs(iov, iovcnt, ut_dev->buf + lba * dev->blocklen,
+			      lba_count * dev->blocklen);
+	ut_dev->blocks_read += lba_count;
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, 0);
+}
 
-	spdk_blob_close(snapshot, blob_op_complete, NULL);
-	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
+static void
+ut_read_cache_dev_write(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, void *payload,
+			uint64_t lba, uint32_t lba_count, struct spdk_bs_dev_cb_args *cb_args)
+{
+	struct ut_read_cache_dev *ut_dev = SPDK_CONTAINEROF(dev, struct ut_read_cache_dev, bs_dev);
 
-	/* Check snapshot-clone relations */
-	count = 2;
-	CU_ASSERT(spdk_blob_get_clones(bs, snapshotid, ids, &count) == 0);
-	CU_ASSERT(count == 1);
-	CU_ASSERT(ids[0] == snapshot2id);
+	SPDK_CU_ASSERT_FATAL(lba + lba_count <= dev->blockcnt);
+	memcpy(ut_dev->buf + lba * dev->blocklen, payload, lba_count * dev->blocklen);
+	ut_dev->blocks_written += lba_count;
+	cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, 0);
+}
 
-	count = 2;
-	CU_ASSERT(spdk_blob_get_clones(bs, snapshot2id, ids, &count) == 0);
-	CU_ASSERT(count == 1);
-	CU_ASSERT(ids[0] == blobid);
+static void
+ut_read_cache_dev_destroy(struct spdk_bs_dev *dev)
+{
+	struct ut_read_cache_dev *ut_dev = SPDK_CONTAINEROF(dev, struct ut_read_cache_dev, bs_dev);
 
-	CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid) == snapshot2id);
+	*ut_dev->destroyed = true;
+	free(ut_dev->buf);
+	free(ut_dev);
+}
 
-	free_clusters = spdk_bs_free_cluster_count(bs);
-	if (!decouple_parent) {
-		/* Do full blob inflation */
-		spdk_bs_inflate_blob(bs, channel, blobid, blob_op_complete, NULL);
-		poll_threads();
-		CU_ASSERT(g_bserrno == 0);
+static struct ut_read_cache_dev *
+ut_read_cache_dev_alloc(uint64_t blockcnt, bool *destroyed)
+{
+	struct ut_read_cache_dev *ut_dev = calloc(1, sizeof(*ut_dev));
 
-		/* All clusters should be inflated (except one already allocated
-		 * in a top level blob) */
-		CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 4);
+	SPDK_CU_ASSERT_FATAL(ut_dev != NULL);
+	ut_dev->bs_dev.blocklen = 512;
+	ut_dev->bs_dev.blockcnt = blockcnt;
+	ut_dev->buf = calloc(blockcnt, ut_dev->bs_dev.blocklen);
+	SPDK_CU_ASSERT_FATAL(ut_dev->buf != NULL);
+	ut_dev->bs_dev.create_channel = dev_create_channel;
+	ut_dev->bs_dev.destroy_channel = dev_destroy_channel;
+	ut_dev->bs_dev.destroy = ut_read_cache_dev_destroy;
+	ut_dev->bs_dev.read = ut_read_cache_dev_read;
+	ut_dev->bs_dev.readv = ut_read_cache_dev_readv;
+	ut_dev->bs_dev.write = ut_read_cache_dev_write;
+	ut_dev->destroyed = destroyed;
+	*destroyed = false;
 
-		/* Check if relation tree updated correctly */
-		count = 2;
-		CU_ASSERT(spdk_blob_get_clones(bs, snapshotid, ids, &count) == 0);
+	return ut_dev;
+}
 
-		/* snapshotid have one clone */
-		CU_ASSERT(count == 1);
-		CU_ASSERT(ids[0] == snapshot2id);
+static void
+blob_read_cache(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob, *snapshot, *clone1, *clone2;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	struct ut_read_cache_dev *cache_dev, *other_dev;
+	spdk_blob_id blobid, snapshotid, cloneid;
+	uint64_t io_unit_size = spdk_bs_get_io_unit_size(bs);
+	uint64_t line_units = (64 * 1024) / io_unit_size;
+	uint64_t dev_read_bytes, cache_read;
+	bool destroyed, other_destroyed;
+	struct iovec iov[2];
+	uint8_t payload_read[8 * 4096];
+	uint8_t payload_write[4096];
 
-		/* snapshot2id have no clones */
-		count = 2;
-		CU_ASSERT(spdk_blob_get_clones(bs, snapshot2id, ids, &count) == 0);
-		CU_ASSERT(count == 0);
+	SPDK_CU_ASSERT_FATAL(io_unit_size <= 4096);
 
-		CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid) == SPDK_BLOBID_INVALID);
-	} else {
-		/* Decouple parent of blob */
-		spdk_bs_blob_decouple_parent(bs, channel, blobid, blob_op_complete, NULL);
-		poll_threads();
-		CU_ASSERT(g_bserrno == 0);
+	channel = spdk_bs_alloc_io_channel(bs);
+	CU_ASSERT(channel != NULL);
 
-		/* Only one cluster from a parent should be inflated (second one
-		 * is covered by a cluster written on a top level blob, and
-		 * already allocated) */
-		CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 1);
+	/* Snapshot of a blob with a pattern, and two clones of it */
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = 1;
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+	memset(payload_write, 0xA5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 1, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
 
-		/* Check if relation tree updated correctly */
-		count = 2;
-		CU_ASSERT(spdk_blob_get_clones(bs, snapshotid, ids, &count) == 0);
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid = g_blobid;
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+	clone1 = blob;
 
-		/* snapshotid have two clones now */
-		CU_ASSERT(count == 2);
-		CU_ASSERT(ids[0] == blobid || ids[1] == blobid);
-		CU_ASSERT(ids[0] == snapshot2id || ids[1] == snapshot2id);
+	spdk_bs_create_clone(bs, snapshotid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	cloneid = g_blobid;
+	spdk_bs_open_blob(bs, cloneid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	clone2 = g_blob;
 
-		/* snapshot2id have no clones */
-		count = 2;
-		CU_ASSERT(spdk_blob_get_clones(bs, snapshot2id, ids, &count) == 0);
-		CU_ASSERT(count == 0);
+	/* A device that isn't a multiple of the cache line is rejected */
+	other_dev = ut_read_cache_dev_alloc(64, &other_destroyed);
+	spdk_bs_set_read_cache(bs, &other_dev->bs_dev, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EINVAL);
+	CU_ASSERT(!other_destroyed);
 
-		CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid) == snapshotid);
-	}
+	/* The cache is set on the existing channels too */
+	cache_dev = ut_read_cache_dev_alloc(16 * (64 * 1024) / 512, &destroyed);
+	spdk_bs_set_read_cache(bs, &cache_dev->bs_dev, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->read_cache != NULL);
 
-	/* Try to delete snapshot2 (should pass) */
-	spdk_bs_delete_blob(bs, snapshot2id, blob_op_complete, NULL);
+	spdk_bs_set_read_cache(bs, &other_dev->bs_dev, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EBUSY);
+	other_dev->bs_dev.destroy(&other_dev->bs_dev);
+
+	/* A miss fills the whole line from the snapshot */
+	dev_read_bytes = g_dev_read_bytes;
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(clone1, channel, payload_read, 1, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, payload_write, io_unit_size) == 0);
+	CU_ASSERT(cache_dev->blocks_written == (64 * 1024) / 512);
+	CU_ASSERT(g_dev_read_bytes - dev_read_bytes == 64 * 1024);
 
-	/* Try to delete base snapshot */
-	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	/* The other clone and the snapshot itself read the same line from the cache */
+	dev_read_bytes = g_dev_read_bytes;
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(clone2, channel, payload_read, 1, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, payload_write, io_unit_size) == 0);
+	CU_ASSERT(cache_dev->blocks_read == io_unit_size / 512);
 
-	/* Reopen blob after snapshot deletion */
-	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	iov[0].iov_base = payload_read;
+	iov[0].iov_len = io_unit_size;
+	iov[1].iov_base = payload_read + io_unit_size;
+	iov[1].iov_len = io_unit_size;
+	memset(payload_read, 0xFF, sizeof(payload_read));
+	spdk_blob_io_readv(snapshot, channel, iov, 2, 0, 2, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
-	blob = g_blob;
+	CU_ASSERT(spdk_mem_all_zero(payload_read, io_unit_size));
+	CU_ASSERT(memcmp(payload_read + io_unit_size, payload_write, io_unit_size) == 0);
+	CU_ASSERT(cache_dev->blocks_read == 3 * io_unit_size / 512);
+	CU_ASSERT(g_dev_read_bytes == dev_read_bytes);
 
-	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 5);
+	/* Reads crossing a line go to the blob */
+	cache_read = cache_dev->blocks_read;
+	spdk_blob_io_read(clone2, channel, payload_read, line_units - 1, 2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(cache_dev->blocks_read == cache_read);
+	CU_ASSERT(g_dev_read_bytes - dev_read_bytes == 2 * io_unit_size);
 
-	/* Check data consistency on inflated blob */
-	memset(payload_read, 0xFF, payload_size);
-	spdk_blob_io_read(blob, channel, payload_read, 0, pages_per_payload,
-			  blob_op_complete, NULL);
+	/* Once a clone has its own cluster its reads don't use the snapshot's lines */
+	memset(payload_write, 0x5A, sizeof(payload_write));
+	spdk_blob_io_write(clone1, channel, payload_write, 0, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_clone, payload_read, payload_size) == 0);
+	spdk_blob_io_read(clone1, channel, payload_read, 0, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, payload_write, io_unit_size) == 0);
+	CU_ASSERT(cache_dev->blocks_read == cache_read);
 
-	spdk_bs_free_io_channel(channel);
+	/* Deleting the snapshot drops its lines, the remaining clone now owns the data */
+	ut_blob_close_and_delete(bs, clone1);
+	spdk_blob_close(snapshot, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(cache_dev->blocks_written == (64 * 1024) / 512);
+	memset(payload_write, 0xA5, sizeof(payload_write));
+	spdk_blob_io_read(clone2, channel, payload_read, 1, 1, blob_op_complete, NULL);
 	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, payload_write, io_unit_size) == 0);
+	CU_ASSERT(cache_dev->blocks_read == cache_read);
 
-	free(payload_read);
-	free(payload_write);
-	free(payload_clone);
+	/* Removing the cache destroys the device */
+	spdk_bs_set_read_cache(bs, NULL, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(destroyed);
+	CU_ASSERT(bs->read_cache == NULL);
 
-	ut_blob_close_and_delete(bs, blob);
-}
+	spdk_bs_set_read_cache(bs, NULL, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -ENOENT);
 
-static void
-blob_inflate_rw(void)
-{
-	_blob_inflate_rw(false);
-	_blob_inflate_rw(true);
+	ut_blob_close_and_delete(bs, clone2);
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	g_blob = NULL;
+	g_blobid = 0;
 }
 
 /**
@@ -7960,6 +9052,111 @@ blob_esnap_io_512_4096(void)
 	memset(g_dev_buffer, 0, DEV_BUFFER_SIZE);
 }
 
+static void
+blob_esnap_cache(void)
+{
+	struct spdk_bs_dev	*dev;
+	struct spdk_blob_store	*bs;
+	struct spdk_bs_opts	bs_opts;
+	struct spdk_blob_opts	blob_opts;
+	struct ut_esnap_opts	esnap_opts;
+	struct spdk_blob	*blob1, *blob2;
+	struct spdk_io_channel	*ch;
+	struct ut_esnap_channel	*ut_ch1, *ut_ch2;
+	struct iovec		iov[2];
+	const uint32_t		esnap_blksz = 512;
+	const uint64_t		line_blocks = BLOB_ESNAP_CACHE_LINE_SIZE / esnap_blksz;
+	char			buf[8 * 512];
+
+	dev = init_dev();
+	dev->blocklen = esnap_blksz;
+	dev->blockcnt = DEV_BUFFER_SIZE / dev->blocklen;
+	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+	bs_opts.cluster_sz = 16 * 1024;
+	bs_opts.esnap_bs_dev_create = ut_esnap_create;
+	bs_opts.esnap_cache_size_mb = 1;
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	SPDK_CU_ASSERT_FATAL(bs->io_unit_size == esnap_blksz);
+
+	/* Two esnap clones of the same esnap share one cache */
+	ut_spdk_blob_opts_init(&blob_opts);
+	ut_esnap_opts_init(esnap_blksz, 4 * line_blocks, __func__, NULL, &esnap_opts);
+	blob_opts.esnap_id = &esnap_opts;
+	blob_opts.esnap_id_len = sizeof(esnap_opts);
+	blob_opts.num_clusters = 4 * BLOB_ESNAP_CACHE_LINE_SIZE / bs_opts.cluster_sz;
+	blob1 = ut_blob_create_and_open(bs, &blob_opts);
+	blob2 = ut_blob_create_and_open(bs, &blob_opts);
+	SPDK_CU_ASSERT_FATAL(TAILQ_FIRST(&bs->esnap_caches) != NULL);
+	CU_ASSERT(TAILQ_NEXT(TAILQ_FIRST(&bs->esnap_caches), link) == NULL);
+
+	ch = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	/* A miss reads the whole line from the esnap device */
+	spdk_blob_io_read(blob1, ch, buf, line_blocks + 2, 8, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(ut_esnap_content_is_correct(buf, sizeof(buf), 0,
+					      (line_blocks + 2) * esnap_blksz, esnap_blksz));
+	ut_ch1 = ut_esnap_get_io_channel(ch, spdk_blob_get_id(blob1));
+	SPDK_CU_ASSERT_FATAL(ut_ch1 != NULL);
+	CU_ASSERT(ut_ch1->blocks_read == line_blocks);
+
+	/* The other clone reads the same line from the cache */
+	spdk_blob_io_read(blob2, ch, buf, 2 * line_blocks - 8, 8, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(ut_esnap_content_is_correct(buf, sizeof(buf), 0,
+					      (2 * line_blocks - 8) * esnap_blksz, esnap_blksz));
+	ut_ch2 = ut_esnap_get_io_channel(ch, spdk_blob_get_id(blob2));
+	SPDK_CU_ASSERT_FATAL(ut_ch2 != NULL);
+	CU_ASSERT(ut_ch2->blocks_read == 0);
+
+	iov[0].iov_base = buf;
+	iov[0].iov_len = 3 * esnap_blksz;
+	iov[1].iov_base = buf + 3 * esnap_blksz;
+	iov[1].iov_len = 5 * esnap_blksz;
+	memset(buf, 0, sizeof(buf));
+	spdk_blob_io_readv(blob2, ch, iov, 2, line_blocks, 8, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(ut_esnap_content_is_correct(buf, sizeof(buf), 0, line_blocks * esnap_blksz,
+					      esnap_blksz));
+	CU_ASSERT(ut_ch2->blocks_read == 0);
+
+	/* The read is split at the cluster boundary, only the first line is missing */
+	spdk_blob_io_read(blob2, ch, buf, line_blocks - 4, 8, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(ut_esnap_content_is_correct(buf, sizeof(buf), 0,
+					      (line_blocks - 4) * esnap_blksz, esnap_blksz));
+	CU_ASSERT(ut_ch2->blocks_read == line_blocks);
+
+	spdk_blob_io_read(blob1, ch, buf, 0, 8, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(ut_esnap_content_is_correct(buf, sizeof(buf), 0, 0, esnap_blksz));
+	CU_ASSERT(ut_ch1->blocks_read == line_blocks);
+
+	/* The cache goes away with the last clone using it */
+	spdk_bs_free_io_channel(ch);
+	poll_threads();
+	ut_blob_close_and_delete(bs, blob1);
+	CU_ASSERT(!TAILQ_EMPTY(&bs->esnap_caches));
+	ut_blob_close_and_delete(bs, blob2);
+	CU_ASSERT(TAILQ_EMPTY(&bs->esnap_caches));
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	memset(g_dev_buffer, 0, DEV_BUFFER_SIZE);
+}
+
 static void
 blob_esnap_thread_add_remove(void)
 {
@@ -8728,6 +9925,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite_blob, blob_rw_iov_read_only);
 	CU_ADD_TEST(suite_bs, blob_unmap);
 	CU_ADD_TEST(suite_bs, blob_iter);
+	CU_ADD_TEST(suite_bs, blob_iter_prefetch);
 	CU_ADD_TEST(suite_blob, blob_xattr);
 	CU_ADD_TEST(suite_bs, blob_parse_md);
 	CU_ADD_TEST(suite, bs_load);
@@ -8753,11 +9951,16 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite_bs, blob_thin_prov_alloc);
 	CU_ADD_TEST(suite_bs, blob_insert_cluster_msg_test);
 	CU_ADD_TEST(suite_bs, blob_thin_prov_rw);
+	CU_ADD_TEST(suite_bs, blob_thin_prov_cluster_slab);
+	CU_ADD_TEST(suite_bs, blob_thin_prov_cluster_slab_reclaim);
+	CU_ADD_TEST(suite_bs, blob_thin_prov_insert_batch);
 	CU_ADD_TEST(suite, blob_thin_prov_write_count_io);
 	CU_ADD_TEST(suite_bs, blob_thin_prov_rle);
 	CU_ADD_TEST(suite_bs, blob_thin_prov_rw_iov);
 	CU_ADD_TEST(suite, bs_load_iter_test);
 	CU_ADD_TEST(suite_bs, blob_snapshot_rw);
+	CU_ADD_TEST(suite_bs, blob_snapshot_rw_copy_fallback);
+	CU_ADD_TEST(suite_bs, blob_snapshot_overwrite_cluster);
 	CU_ADD_TEST(suite_bs, blob_snapshot_rw_iov);
 	CU_ADD_TEST(suite, blob_relations);
 	CU_ADD_TEST(suite, blob_relations2);
@@ -8766,6 +9969,10 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, blob_delete_snapshot_power_failure);
 	CU_ADD_TEST(suite, blob_create_snapshot_power_failure);
 	CU_ADD_TEST(suite_bs, blob_inflate_rw);
+	CU_ADD_TEST(suite_bs, blob_prefill_clusters);
+	CU_ADD_TEST(suite_bs, blob_defragment);
+	CU_ADD_TEST(suite_bs, blob_defragment_inflight_io);
+	CU_ADD_TEST(suite_bs, blob_read_cache);
 	CU_ADD_TEST(suite_bs, blob_snapshot_freeze_io);
 	CU_ADD_TEST(suite_bs, blob_operation_split_rw);
 	CU_ADD_TEST(suite_bs, blob_operation_split_rw_iov);
@@ -8782,6 +9989,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, blob_esnap_io_512_512);
 	CU_ADD_TEST(suite, blob_esnap_io_4096_512);
 	CU_ADD_TEST(suite, blob_esnap_io_512_4096);
+	CU_ADD_TEST(suite, blob_esnap_cache);
 	CU_ADD_TEST(suite_esnap_bs, blob_esnap_thread_add_remove);
 	CU_ADD_TEST(suite_esnap_bs, blob_esnap_clone_snapshot);
 	CU_ADD_TEST(suite_esnap_bs, blob_esnap_clone_inflate);
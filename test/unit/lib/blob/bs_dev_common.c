@@ -18,6 +18,7 @@ uint64_t g_dev_copy_bytes;
 bool g_dev_writev_ext_called;
 bool g_dev_readv_ext_called;
 bool g_dev_copy_enabled;
+int g_dev_copy_status;
 struct spdk_blob_ext_io_opts g_blob_ext_io_opts;
 
 struct spdk_power_failure_counters {
@@ -390,6 +391,11 @@ dev_copy(struct spdk_bs_dev *dev, struct spdk_io_channel *channel, uint64_t dst_
 	const void *src = &g_dev_buffer[src_lba * dev->blocklen];
 	uint64_t size = lba_count * dev->blocklen;
 
+	if (g_dev_copy_status != 0) {
+		cb_args->cb_fn(cb_args->channel, cb_args->cb_arg, g_dev_copy_status);
+		return;
+	}
+
 	memcpy(dst, src, size);
 	g_dev_copy_bytes += size;
 
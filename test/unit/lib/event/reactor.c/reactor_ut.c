@@ -323,6 +323,69 @@ poller_run_busy(void *ctx)
 	return 1;
 }
 
+static void
+ut_count_event_fn(void *arg1, void *arg2)
+{
+	uint32_t *count = arg1;
+
+	(*count)++;
+	spdk_delay_us(10);
+}
+
+static void
+test_event_batching(void)
+{
+	struct spdk_reactor *reactor;
+	struct spdk_event *evt;
+	uint32_t count = 0, i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(1);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	reactor = spdk_reactor_get(0);
+	SPDK_CU_ASSERT_FATAL(reactor != NULL);
+	CU_ASSERT(reactor->event_batch_size == SPDK_EVENT_BATCH_SIZE);
+	CU_ASSERT(reactor->event_policy == SPDK_REACTOR_EVENT_POLICY_BATCH);
+
+	reactor->event_batch_size = 2;
+
+	for (i = 0; i < 7; i++) {
+		evt = spdk_event_allocate(0, ut_count_event_fn, &count, NULL);
+		SPDK_CU_ASSERT_FATAL(evt != NULL);
+		spdk_event_call(evt);
+	}
+
+	/* A single batch per iteration by default. */
+	_reactor_run(reactor);
+	CU_ASSERT(count == 2);
+	CU_ASSERT(reactor->event_stats.batch_count == 1);
+	CU_ASSERT(reactor->event_stats.event_count == 2);
+	CU_ASSERT(reactor->event_stats.max_queue_depth == 7);
+	CU_ASSERT(reactor->event_stats.event_tsc == 20);
+
+	/* Drain everything queued, batch after batch. */
+	reactor->event_policy = SPDK_REACTOR_EVENT_POLICY_DRAIN;
+	_reactor_run(reactor);
+	CU_ASSERT(count == 7);
+	CU_ASSERT(reactor->event_stats.batch_count == 4);
+	CU_ASSERT(reactor->event_stats.event_count == 7);
+	CU_ASSERT(reactor->event_stats.max_queue_depth == 7);
+	CU_ASSERT(reactor->event_stats.event_tsc == 70);
+
+	/* Nothing left to run. */
+	_reactor_run(reactor);
+	CU_ASSERT(reactor->event_stats.batch_count == 4);
+
+	spdk_reactors_fini();
+
+	free_cores();
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+}
+
 static void
 test_reactor_stats(void)
 {
@@ -710,6 +773,93 @@ test_scheduler(void)
 	free_cores();
 }
 
+static void
+test_scheduler_numa(void)
+{
+	struct spdk_scheduler_thread_info thread_info = {};
+	struct core_stats *orig_cores = g_cores;
+	struct spdk_cpuset cpuset = {};
+	struct spdk_thread *thread;
+	int i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(3);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	for (i = 0; i < 3; i++) {
+		spdk_cpuset_set_cpu(&cpuset, i, true);
+	}
+	thread = spdk_thread_create(NULL, &cpuset);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+	_run_events_till_completion(3);
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	g_main_lcore = 0;
+	g_cores = calloc(3, sizeof(*g_cores));
+	SPDK_CU_ASSERT_FATAL(g_cores != NULL);
+
+	/* Busy thread on core 2, with plenty of room on core 0. */
+	thread_info.thread_id = spdk_thread_get_id(thread);
+	thread_info.lcore = 2;
+	thread_info.current_stats.busy_tsc = 40;
+	thread_info.current_stats.idle_tsc = 60;
+	g_cores[0].busy = 35;
+	g_cores[0].idle = 65;
+	g_cores[0].thread_count = 1;
+	g_cores[1].busy = 35;
+	g_cores[1].idle = 65;
+	g_cores[1].thread_count = 1;
+	g_cores[2].busy = 40;
+	g_cores[2].idle = 60;
+	g_cores[2].thread_count = 1;
+
+	/* Thread without a home socket gets consolidated on the main core. */
+	thread_info.socket_id = SPDK_ENV_SOCKET_ID_ANY;
+	CU_ASSERT(_find_optimal_core(&thread_info) == 0);
+
+	/* All cores are on socket 0. Thread local to socket 0 is consolidated as usual. */
+	MOCK_SET(spdk_env_get_socket_id, 0);
+	thread_info.socket_id = 0;
+	CU_ASSERT(_find_optimal_core(&thread_info) == 0);
+
+	/* Thread local to socket 1 is never consolidated onto a remote core. */
+	g_scheduler_numa_penalty = 0;
+	thread_info.socket_id = 1;
+	CU_ASSERT(_find_optimal_core(&thread_info) == 2);
+
+	/* Remote cores account for the cross-socket penalty. */
+	CU_ASSERT(_can_core_fit_thread(&thread_info, 1) == true);
+	g_scheduler_numa_penalty = 20;
+	CU_ASSERT(_can_core_fit_thread(&thread_info, 1) == false);
+
+	/* Core 2 over the limit. Remote core 0 can take the thread even with the penalty. */
+	g_cores[0].busy = 10;
+	g_cores[0].idle = 90;
+	g_cores[2].busy = 90;
+	g_cores[2].idle = 10;
+	g_cores[2].thread_count = 2;
+	CU_ASSERT(_find_optimal_core(&thread_info) == 0);
+
+	MOCK_CLEAR(spdk_env_get_socket_id);
+	free(g_cores);
+	g_cores = orig_cores;
+
+	spdk_set_thread(thread);
+	spdk_thread_exit(thread);
+	for (i = 0; i < 3; i++) {
+		reactor_run(spdk_reactor_get(i));
+	}
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
 uint8_t g_curr_freq;
 
 static int
@@ -944,8 +1094,10 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_schedule_thread);
 	CU_ADD_TEST(suite, test_reschedule_thread);
 	CU_ADD_TEST(suite, test_for_each_reactor);
+	CU_ADD_TEST(suite, test_event_batching);
 	CU_ADD_TEST(suite, test_reactor_stats);
 	CU_ADD_TEST(suite, test_scheduler);
+	CU_ADD_TEST(suite, test_scheduler_numa);
 	CU_ADD_TEST(suite, test_governor);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
@@ -0,0 +1,230 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk_cunit.h"
+#include "common/lib/test_env.c"
+#include "event/reactor.c"
+#include "spdk/thread.h"
+#include "spdk_internal/thread.h"
+#include "../module/scheduler/gscheduler/gscheduler.c"
+
+enum ut_freq_action {
+	UT_FREQ_NONE,
+	UT_FREQ_UP,
+	UT_FREQ_DOWN,
+	UT_FREQ_MAX,
+	UT_FREQ_MIN,
+};
+
+static enum ut_freq_action g_freq_action;
+
+static int
+ut_core_freq_up(uint32_t lcore_id)
+{
+	g_freq_action = UT_FREQ_UP;
+	return 1;
+}
+
+static int
+ut_core_freq_down(uint32_t lcore_id)
+{
+	g_freq_action = UT_FREQ_DOWN;
+	return 1;
+}
+
+static int
+ut_set_core_freq_max(uint32_t lcore_id)
+{
+	g_freq_action = UT_FREQ_MAX;
+	return 1;
+}
+
+static int
+ut_set_core_freq_min(uint32_t lcore_id)
+{
+	g_freq_action = UT_FREQ_MIN;
+	return 1;
+}
+
+static int
+ut_get_core_capabilities(uint32_t lcore_id, struct spdk_governor_capabilities *capabilities)
+{
+	capabilities->priority = false;
+	return 0;
+}
+
+static int
+ut_governor_init(void)
+{
+	return 0;
+}
+
+static void
+ut_governor_deinit(void)
+{
+}
+
+static struct spdk_governor ut_governor = {
+	.name = "dpdk_governor",
+	.core_freq_up = ut_core_freq_up,
+	.core_freq_down = ut_core_freq_down,
+	.set_core_freq_max = ut_set_core_freq_max,
+	.set_core_freq_min = ut_set_core_freq_min,
+	.get_core_capabilities = ut_get_core_capabilities,
+	.init = ut_governor_init,
+	.deinit = ut_governor_deinit,
+};
+
+SPDK_GOVERNOR_REGISTER(ut_governor);
+
+static struct spdk_thread *g_ut_thread;
+
+static void
+setup_thread(void)
+{
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(1);
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	g_ut_thread = spdk_thread_create(NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(g_ut_thread != NULL);
+	event_queue_run_batch(spdk_reactor_get(0));
+
+	CU_ASSERT(init() == 0);
+}
+
+static void
+cleanup_thread(void)
+{
+	deinit();
+
+	spdk_set_thread(g_ut_thread);
+	spdk_thread_exit(g_ut_thread);
+	reactor_run(spdk_reactor_get(0));
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
+/* Record the latencies on the thread and run the balance over them. 1 tick is 1us here. */
+static enum ut_freq_action
+run_balance(uint64_t busy, uint64_t idle, const uint64_t *latencies, uint32_t count)
+{
+	struct spdk_scheduler_core_info *core = &g_core_infos[0];
+	struct spdk_reactor *reactor = spdk_reactor_get(0);
+	uint32_t i;
+
+	spdk_set_thread(g_ut_thread);
+	for (i = 0; i < count; i++) {
+		spdk_thread_record_latency(latencies[i]);
+	}
+	spdk_set_thread(NULL);
+
+	_reactor_gather_latency(reactor, core);
+	core->lcore = 0;
+	core->current_busy_tsc = busy;
+	core->current_idle_tsc = idle;
+
+	g_freq_action = UT_FREQ_NONE;
+	balance(g_core_infos, 1);
+
+	return g_freq_action;
+}
+
+static void
+test_balance_load(void)
+{
+	setup_thread();
+
+	/* Without a latency target the frequency follows the load. */
+	CU_ASSERT(!spdk_thread_latency_histograms_enabled());
+	CU_ASSERT(run_balance(0, 100000, NULL, 0) == UT_FREQ_MIN);
+	CU_ASSERT(g_core_infos[0].current_latency_histogram == NULL);
+	CU_ASSERT(run_balance(40, 60, NULL, 0) == UT_FREQ_DOWN);
+	CU_ASSERT(run_balance(60, 40, NULL, 0) == UT_FREQ_UP);
+	CU_ASSERT(run_balance(100000, 0, NULL, 0) == UT_FREQ_MAX);
+
+	cleanup_thread();
+}
+
+static void
+test_balance_latency(void)
+{
+	uint64_t latencies[100];
+	uint32_t i;
+
+	setup_thread();
+
+	g_latency_target_us = 100;
+	spdk_thread_enable_latency_histograms(true);
+
+	/* No I/O completed, fall back to the load. */
+	CU_ASSERT(run_balance(0, 100000, NULL, 0) == UT_FREQ_MIN);
+
+	/* p99 over the target, whatever the load is. */
+	for (i = 0; i < 100; i++) {
+		latencies[i] = i < 98 ? 10 : 200;
+	}
+	CU_ASSERT(run_balance(0, 100000, latencies, 100) == UT_FREQ_MAX);
+
+	/* A single slow I/O out of 100 doesn't count against p99. */
+	latencies[98] = 10;
+	CU_ASSERT(run_balance(100000, 0, latencies, 100) == UT_FREQ_DOWN);
+
+	/* Approaching the target. */
+	for (i = 0; i < 100; i++) {
+		latencies[i] = 90;
+	}
+	CU_ASSERT(run_balance(0, 100000, latencies, 100) == UT_FREQ_UP);
+
+	/* Between the thresholds, the frequency is kept. */
+	for (i = 0; i < 100; i++) {
+		latencies[i] = 70;
+	}
+	CU_ASSERT(run_balance(0, 100000, latencies, 100) == UT_FREQ_NONE);
+
+	/* Each period only accounts for the latencies recorded during it. */
+	CU_ASSERT(run_balance(0, 100000, NULL, 0) == UT_FREQ_MIN);
+
+	/* Samples recorded while disabled are dropped. */
+	spdk_thread_enable_latency_histograms(false);
+	CU_ASSERT(run_balance(0, 100000, latencies, 100) == UT_FREQ_MIN);
+	CU_ASSERT(g_core_infos[0].current_latency_histogram == NULL);
+	spdk_thread_enable_latency_histograms(true);
+	CU_ASSERT(run_balance(0, 100000, NULL, 0) == UT_FREQ_MIN);
+
+	g_latency_target_us = 0;
+
+	cleanup_thread();
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("scheduler_gscheduler", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_balance_load);
+	CU_ADD_TEST(suite, test_balance_latency);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	return num_failures;
+}
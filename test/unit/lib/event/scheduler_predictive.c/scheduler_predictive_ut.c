@@ -0,0 +1,256 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "spdk_cunit.h"
+#include "common/lib/test_env.c"
+#include "event/reactor.c"
+#include "spdk/thread.h"
+#include "spdk_internal/thread.h"
+#include "../module/scheduler/predictive/scheduler_predictive.c"
+
+#define NUM_CORES 3
+
+static struct spdk_thread *g_ut_threads[NUM_CORES];
+static struct spdk_scheduler_core_info g_ut_cores_info[NUM_CORES];
+static struct spdk_scheduler_thread_info g_ut_thread_infos[NUM_CORES];
+
+static void
+setup_threads(void)
+{
+	struct spdk_cpuset cpuset = {};
+	uint32_t i;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(NUM_CORES);
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	for (i = 0; i < NUM_CORES; i++) {
+		spdk_cpuset_zero(&cpuset);
+		spdk_cpuset_set_cpu(&cpuset, i, true);
+		g_ut_threads[i] = spdk_thread_create(NULL, &cpuset);
+		SPDK_CU_ASSERT_FATAL(g_ut_threads[i] != NULL);
+	}
+
+	for (i = 0; i < NUM_CORES; i++) {
+		MOCK_SET(spdk_env_get_current_core, i);
+		event_queue_run_batch(spdk_reactor_get(i));
+	}
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	CU_ASSERT(init() == 0);
+}
+
+static void
+cleanup_threads(void)
+{
+	uint32_t i;
+
+	deinit();
+
+	for (i = 0; i < NUM_CORES; i++) {
+		spdk_set_thread(g_ut_threads[i]);
+		spdk_thread_exit(g_ut_threads[i]);
+	}
+	for (i = 0; i < NUM_CORES; i++) {
+		MOCK_SET(spdk_env_get_current_core, i);
+		reactor_run(spdk_reactor_get(i));
+	}
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
+/* Place thread `idx` on the given core, with load in % for the last period. */
+static void
+set_thread_load(uint32_t idx, uint32_t lcore, uint64_t load)
+{
+	struct spdk_scheduler_thread_info *thread_info = &g_ut_thread_infos[idx];
+
+	thread_info->lcore = lcore;
+	thread_info->thread_id = spdk_thread_get_id(g_ut_threads[idx]);
+	thread_info->socket_id = SPDK_ENV_SOCKET_ID_ANY;
+	thread_info->current_stats.busy_tsc = load;
+	thread_info->current_stats.idle_tsc = 100 - load;
+}
+
+/* Build core info out of the threads placed by set_thread_load(). */
+static void
+run_balance(uint32_t thread_count)
+{
+	struct spdk_scheduler_core_info *core;
+	struct spdk_scheduler_thread_info *info;
+	uint32_t i, j, idx;
+
+	for (i = 0; i < NUM_CORES; i++) {
+		core = &g_ut_cores_info[i];
+		core->thread_infos = calloc(thread_count, sizeof(*core->thread_infos));
+		SPDK_CU_ASSERT_FATAL(core->thread_infos != NULL);
+		core->lcore = i;
+		core->threads_count = 0;
+		for (j = 0; j < thread_count; j++) {
+			if (g_ut_thread_infos[j].lcore == i) {
+				core->thread_infos[core->threads_count++] = g_ut_thread_infos[j];
+			}
+		}
+	}
+
+	balance(g_ut_cores_info, NUM_CORES);
+
+	/* Report back where the threads were moved. */
+	for (i = 0; i < NUM_CORES; i++) {
+		for (j = 0; j < g_ut_cores_info[i].threads_count; j++) {
+			info = &g_ut_cores_info[i].thread_infos[j];
+			for (idx = 0; idx < thread_count; idx++) {
+				if (g_ut_thread_infos[idx].thread_id == info->thread_id) {
+					g_ut_thread_infos[idx].lcore = info->lcore;
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < NUM_CORES; i++) {
+		free(g_ut_cores_info[i].thread_infos);
+		g_ut_cores_info[i].thread_infos = NULL;
+	}
+}
+
+static void
+test_forecast(void)
+{
+	struct predictive_thread pthread = {};
+	struct spdk_thread_stats stats = {};
+
+	g_smoothing = 50;
+	g_trend_smoothing = 20;
+	g_horizon = 1;
+
+	/* First sample initializes the history. */
+	stats.busy_tsc = 50;
+	stats.idle_tsc = 50;
+	predictive_thread_update(&pthread, &stats);
+	pthread.generation = 1;
+	CU_ASSERT(pthread.sample == PCT_TO_LOAD(50));
+	CU_ASSERT(pthread.level == PCT_TO_LOAD(50));
+	CU_ASSERT(pthread.trend == 0);
+	CU_ASSERT(pthread.forecast == PCT_TO_LOAD(50));
+
+	/* A single quiet period only dampens the load. */
+	stats.busy_tsc = 10;
+	stats.idle_tsc = 90;
+	predictive_thread_update(&pthread, &stats);
+	CU_ASSERT(pthread.sample == PCT_TO_LOAD(10));
+	CU_ASSERT(pthread.level == PCT_TO_LOAD(30));
+	CU_ASSERT(pthread.trend == -PCT_TO_LOAD(4));
+	CU_ASSERT(pthread.forecast == PCT_TO_LOAD(26));
+
+	/* Forecast never goes below 0. */
+	g_horizon = 100;
+	predictive_thread_update(&pthread, &stats);
+	CU_ASSERT(pthread.forecast == 0);
+
+	/* No ticks at all counts as no load. */
+	g_horizon = 1;
+	stats.busy_tsc = 0;
+	stats.idle_tsc = 0;
+	predictive_thread_update(&pthread, &stats);
+	CU_ASSERT(pthread.sample == 0);
+}
+
+static void
+test_balance_bursty(void)
+{
+	setup_threads();
+
+	/* Thread 0 stays idle on the main core. Thread 1 may only run on core 1,
+	 * so it won't be consolidated while active. */
+	set_thread_load(0, 0, 0);
+	set_thread_load(1, 1, 50);
+	run_balance(2);
+	CU_ASSERT(g_ut_thread_infos[1].lcore == 1);
+	CU_ASSERT(g_decision_count == 0);
+
+	/* A single quiet period doesn't make the thread idle. */
+	set_thread_load(1, 1, 10);
+	run_balance(2);
+	CU_ASSERT(g_ut_thread_infos[1].lcore == 1);
+	CU_ASSERT(g_decision_count == 0);
+
+	/* Once it stays quiet for long enough, it is moved to the main core. */
+	set_thread_load(1, 1, 10);
+	run_balance(2);
+	CU_ASSERT(g_ut_thread_infos[1].lcore == 0);
+	CU_ASSERT(g_decision_count == 1);
+	CU_ASSERT(g_decisions[0].src_lcore == 1);
+	CU_ASSERT(g_decisions[0].dst_lcore == 0);
+
+	cleanup_threads();
+}
+
+static void
+test_balance_over_limit(void)
+{
+	struct spdk_cpuset cpuset = {};
+	uint32_t i;
+
+	setup_threads();
+
+	/* Allow all threads to run anywhere. */
+	for (i = 0; i < NUM_CORES; i++) {
+		spdk_cpuset_set_cpu(&cpuset, i, true);
+	}
+	for (i = 0; i < NUM_CORES; i++) {
+		spdk_cpuset_copy(spdk_thread_get_cpumask(g_ut_threads[i]), &cpuset);
+	}
+
+	/* Two active threads on core 1 put it over the limit, one of them is moved
+	 * to the main core, the other one doesn't fit there anymore and stays. */
+	set_thread_load(0, 1, 45);
+	set_thread_load(1, 1, 45);
+	run_balance(2);
+	CU_ASSERT(g_ut_thread_infos[0].lcore == 0);
+	CU_ASSERT(g_ut_thread_infos[1].lcore == 1);
+	CU_ASSERT(g_decision_count == 1);
+	CU_ASSERT(g_decisions[0].gain == PCT_TO_LOAD(45));
+
+	/* Small fluctuations don't cause any move. */
+	set_thread_load(0, 0, 50);
+	set_thread_load(1, 1, 40);
+	run_balance(2);
+	CU_ASSERT(g_ut_thread_infos[0].lcore == 0);
+	CU_ASSERT(g_ut_thread_infos[1].lcore == 1);
+	CU_ASSERT(g_decision_count == 1);
+
+	cleanup_threads();
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("scheduler_predictive", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_forecast);
+	CU_ADD_TEST(suite, test_balance_bursty);
+	CU_ADD_TEST(suite, test_balance_over_limit);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	return num_failures;
+}
@@ -154,6 +154,9 @@ DEFINE_STUB(spdk_scsi_dev_construct, struct spdk_scsi_dev *,
 DEFINE_STUB_V(spdk_scsi_dev_destruct,
 	      (struct spdk_scsi_dev *dev, spdk_scsi_dev_destruct_cb_t cb_fn, void *cb_arg));
 
+DEFINE_STUB_V(spdk_scsi_dev_set_max_tasks_per_initiator,
+	      (struct spdk_scsi_dev *dev, uint32_t max_tasks));
+
 DEFINE_STUB(spdk_scsi_dev_add_port, int,
 	    (struct spdk_scsi_dev *dev, uint64_t id, const char *name), 0);
 
@@ -236,6 +239,10 @@ iscsi_conn_write_pdu(struct spdk_iscsi_conn *conn, struct spdk_iscsi_pdu *pdu,
 	TAILQ_INSERT_TAIL(&g_write_pdu_list, pdu, tailq);
 }
 
+DEFINE_STUB_V(iscsi_conn_cork_write_pdus, (struct spdk_iscsi_conn *conn));
+
+DEFINE_STUB_V(iscsi_conn_uncork_write_pdus, (struct spdk_iscsi_conn *conn));
+
 DEFINE_STUB_V(iscsi_conn_logout, (struct spdk_iscsi_conn *conn));
 
 DEFINE_STUB_V(spdk_scsi_task_set_status,
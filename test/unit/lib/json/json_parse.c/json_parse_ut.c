@@ -872,6 +872,109 @@ test_parse_comment(void)
 	PARSE_FAIL_FLAGS("[0/", SPDK_JSON_PARSE_INCOMPLETE, SPDK_JSON_PARSE_FLAG_ALLOW_COMMENTS);
 }
 
+struct stream_data {
+	const char	*json;
+	size_t		offset;
+	size_t		chunk_size;
+};
+
+static ssize_t
+stream_read(void *cb_ctx, void *buf, size_t size)
+{
+	struct stream_data *data = cb_ctx;
+	size_t len = strlen(data->json) - data->offset;
+
+	len = spdk_min(len, spdk_min(size, data->chunk_size));
+	memcpy(buf, data->json + data->offset, len);
+	data->offset += len;
+
+	return len;
+}
+
+#define STREAM_NEXT(stream, val, val_type, str) \
+	CU_ASSERT(spdk_json_stream_next(stream, &val) == 1); \
+	CU_ASSERT(val.type == val_type); \
+	CU_ASSERT(val.len == sizeof(str) - 1); \
+	CU_ASSERT(memcmp(val.start, str, val.len) == 0)
+
+static void
+test_parse_stream(void)
+{
+	const char *json = "/* config */ {\"name\": \"a\\nb\", \"size\": 12345, "
+			   "\"list\": [{\"x\": [1, 2]}, {\"y\": null}], \"end\": true}";
+	struct stream_data data = { .json = json };
+	struct spdk_json_stream *stream;
+	struct spdk_json_val val, *values;
+	size_t chunk_size;
+
+	/* Exercise tokens split across reads */
+	for (chunk_size = 1; chunk_size <= strlen(json); chunk_size++) {
+		data.offset = 0;
+		data.chunk_size = chunk_size;
+		stream = spdk_json_stream_create(stream_read, &data,
+						 SPDK_JSON_PARSE_FLAG_DECODE_IN_PLACE |
+						 SPDK_JSON_PARSE_FLAG_ALLOW_COMMENTS);
+		SPDK_CU_ASSERT_FATAL(stream != NULL);
+
+		STREAM_NEXT(stream, val, SPDK_JSON_VAL_OBJECT_BEGIN, "");
+		STREAM_NEXT(stream, val, SPDK_JSON_VAL_NAME, "name");
+		STREAM_NEXT(stream, val, SPDK_JSON_VAL_STRING, "a\nb");
+		STREAM_NEXT(stream, val, SPDK_JSON_VAL_NAME, "size");
+		STREAM_NEXT(stream, val, SPDK_JSON_VAL_NUMBER, "12345");
+		STREAM_NEXT(stream, val, SPDK_JSON_VAL_NAME, "list");
+		STREAM_NEXT(stream, val, SPDK_JSON_VAL_ARRAY_BEGIN, "");
+
+		/* Elements of the array are parsed one at a time */
+		CU_ASSERT(spdk_json_stream_next_value(stream, &values) == 7);
+		CU_ASSERT(values[0].type == SPDK_JSON_VAL_OBJECT_BEGIN);
+		CU_ASSERT(values[0].len == 5);
+		CU_ASSERT(values[4].type == SPDK_JSON_VAL_NUMBER);
+		CU_ASSERT(memcmp(values[4].start, "2", 1) == 0);
+		CU_ASSERT(spdk_json_stream_next_value(stream, &values) == 4);
+		CU_ASSERT(values[2].type == SPDK_JSON_VAL_NULL);
+		CU_ASSERT(spdk_json_stream_next_value(stream, &values) == 0);
+
+		STREAM_NEXT(stream, val, SPDK_JSON_VAL_NAME, "end");
+		STREAM_NEXT(stream, val, SPDK_JSON_VAL_TRUE, "true");
+		STREAM_NEXT(stream, val, SPDK_JSON_VAL_OBJECT_END, "");
+		CU_ASSERT(spdk_json_stream_next(stream, &val) == 0);
+
+		spdk_json_stream_free(stream);
+	}
+
+	/* Invalid and truncated data */
+	data.chunk_size = 4;
+	data.json = "[1, }";
+	data.offset = 0;
+	stream = spdk_json_stream_create(stream_read, &data, 0);
+	SPDK_CU_ASSERT_FATAL(stream != NULL);
+	STREAM_NEXT(stream, val, SPDK_JSON_VAL_ARRAY_BEGIN, "");
+	STREAM_NEXT(stream, val, SPDK_JSON_VAL_NUMBER, "1");
+	CU_ASSERT(spdk_json_stream_next(stream, &val) == SPDK_JSON_PARSE_INVALID);
+	spdk_json_stream_free(stream);
+
+	data.json = "{\"a\": [1";
+	data.offset = 0;
+	stream = spdk_json_stream_create(stream_read, &data, 0);
+	SPDK_CU_ASSERT_FATAL(stream != NULL);
+	STREAM_NEXT(stream, val, SPDK_JSON_VAL_OBJECT_BEGIN, "");
+	STREAM_NEXT(stream, val, SPDK_JSON_VAL_NAME, "a");
+	STREAM_NEXT(stream, val, SPDK_JSON_VAL_ARRAY_BEGIN, "");
+	CU_ASSERT(spdk_json_stream_next_value(stream, &values) == 1);
+	CU_ASSERT(spdk_json_stream_next(stream, &val) == SPDK_JSON_PARSE_INCOMPLETE);
+	spdk_json_stream_free(stream);
+
+	/* Only whitespace may follow the complete value */
+	data.json = "{} {}";
+	data.offset = 0;
+	stream = spdk_json_stream_create(stream_read, &data, 0);
+	SPDK_CU_ASSERT_FATAL(stream != NULL);
+	STREAM_NEXT(stream, val, SPDK_JSON_VAL_OBJECT_BEGIN, "");
+	STREAM_NEXT(stream, val, SPDK_JSON_VAL_OBJECT_END, "");
+	CU_ASSERT(spdk_json_stream_next(stream, &val) == SPDK_JSON_PARSE_INVALID);
+	spdk_json_stream_free(stream);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -894,6 +997,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_parse_object);
 	CU_ADD_TEST(suite, test_parse_nesting);
 	CU_ADD_TEST(suite, test_parse_comment);
+	CU_ADD_TEST(suite, test_parse_stream);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 
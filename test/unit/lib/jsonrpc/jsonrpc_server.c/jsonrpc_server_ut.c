@@ -160,6 +160,9 @@ jsonrpc_server_handle_request(struct spdk_jsonrpc_request *request,
 void
 jsonrpc_server_send_response(struct spdk_jsonrpc_request *request)
 {
+	if (request->conn == NULL) {
+		jsonrpc_complete_local_request(request);
+	}
 }
 
 static void
@@ -356,6 +359,75 @@ test_parse_request_streaming(void)
 	free(server);
 }
 
+static void
+ut_local_handle(struct spdk_jsonrpc_request *request, const struct spdk_json_val *method,
+		const struct spdk_json_val *params)
+{
+	struct spdk_json_write_ctx *w;
+
+	CU_ASSERT(spdk_jsonrpc_get_conn(request) == NULL);
+	if (spdk_json_strequal(method, "ok")) {
+		CU_ASSERT(params != NULL);
+		w = spdk_jsonrpc_begin_result(request);
+		spdk_json_write_val(w, params);
+		spdk_jsonrpc_end_result(request, w);
+	} else {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_METHOD_NOT_FOUND,
+						 "Method not found");
+	}
+}
+
+static void
+ut_local_response(void *cb_arg, struct spdk_jsonrpc_client_response *resp)
+{
+	struct spdk_jsonrpc_client_response *out = cb_arg;
+
+	out->result = resp->result;
+	out->error = resp->error;
+	if (resp->result != NULL) {
+		CU_ASSERT(resp->result->type == SPDK_JSON_VAL_ARRAY_BEGIN);
+		CU_ASSERT(resp->result[1].type == SPDK_JSON_VAL_NUMBER);
+		CU_ASSERT(memcmp(resp->result[1].start, "42", 2) == 0);
+	}
+	if (resp->error != NULL) {
+		CU_ASSERT(resp->error->type == SPDK_JSON_VAL_OBJECT_BEGIN);
+	}
+}
+
+static void
+test_local_request(void)
+{
+	struct spdk_jsonrpc_client_response resp;
+	char method_ok[] = "ok", method_err[] = "unknown", param[] = "42";
+	struct spdk_json_val method = { .type = SPDK_JSON_VAL_STRING };
+	struct spdk_json_val params[] = {
+		{ .type = SPDK_JSON_VAL_ARRAY_BEGIN, .len = 1 },
+		{ .start = param, .len = 2, .type = SPDK_JSON_VAL_NUMBER },
+		{ .type = SPDK_JSON_VAL_ARRAY_END },
+	};
+	int rc;
+
+	/* The response is passed to the callback */
+	memset(&resp, 0, sizeof(resp));
+	method.start = method_ok;
+	method.len = strlen(method_ok);
+	rc = spdk_jsonrpc_handle_local_request(ut_local_handle, &method, params,
+					       ut_local_response, &resp);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(resp.result != NULL);
+	CU_ASSERT(resp.error == NULL);
+
+	/* So are errors */
+	memset(&resp, 0, sizeof(resp));
+	method.start = method_err;
+	method.len = strlen(method_err);
+	rc = spdk_jsonrpc_handle_local_request(ut_local_handle, &method, NULL,
+					       ut_local_response, &resp);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(resp.result == NULL);
+	CU_ASSERT(resp.error != NULL);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -369,6 +441,7 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, test_parse_request);
 	CU_ADD_TEST(suite, test_parse_request_streaming);
+	CU_ADD_TEST(suite, test_local_request);
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 
 	CU_basic_run_tests();
@@ -57,6 +57,10 @@ int g_lvserrno;
 int g_close_super_status;
 int g_resize_rc;
 int g_inflate_rc;
+int g_defragment_rc;
+int g_prefill_rc;
+const uint64_t *g_prefill_clusters;
+uint32_t g_prefill_clusters_per_sec;
 int g_remove_rc;
 bool g_lvs_rename_blob_open_error = false;
 struct spdk_lvol_store *g_lvol_store;
@@ -99,6 +103,23 @@ spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel
 	cb_fn(cb_arg, g_inflate_rc);
 }
 
+void
+spdk_blob_defragment(struct spdk_blob *blob, struct spdk_io_channel *channel,
+		     uint32_t clusters_per_sec, spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	cb_fn(cb_arg, g_defragment_rc);
+}
+
+void
+spdk_blob_prefill_clusters(struct spdk_blob *blob, struct spdk_io_channel *channel,
+			   const uint64_t *clusters, uint64_t num_clusters,
+			   uint32_t clusters_per_sec, spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	g_prefill_clusters = clusters;
+	g_prefill_clusters_per_sec = clusters_per_sec;
+	cb_fn(cb_arg, g_prefill_rc);
+}
+
 void
 spdk_bs_iter_next(struct spdk_blob_store *bs, struct spdk_blob *b,
 		  spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
@@ -2233,6 +2254,114 @@ lvol_inflate(void)
 	CU_ASSERT(g_io_channel == NULL);
 }
 
+static void
+lvol_defragment(void)
+{
+	struct lvol_ut_bs_dev dev;
+	struct spdk_lvs_opts opts;
+	int rc = 0;
+
+	init_dev(&dev);
+
+	spdk_lvs_opts_init(&opts);
+	snprintf(opts.name, sizeof(opts.name), "lvs");
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_init(&dev.bs_dev, &opts, lvol_store_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+
+	spdk_lvol_create(g_lvol_store, "lvol", 10, false, LVOL_CLEAR_WITH_DEFAULT,
+			 lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+
+	g_defragment_rc = -EBUSY;
+	spdk_lvol_defragment(g_lvol, 0, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == -EBUSY);
+
+	g_defragment_rc = 0;
+	spdk_lvol_defragment(g_lvol, 100, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+
+	spdk_lvol_close(g_lvol, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	spdk_lvol_destroy(g_lvol, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_unload(g_lvol_store, op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	g_lvol_store = NULL;
+
+	free_dev(&dev);
+
+	/* Make sure that all references to the io_channel was closed after
+	 * defragment call
+	 */
+	CU_ASSERT(g_io_channel == NULL);
+}
+
+static void
+lvol_prefill(void)
+{
+	struct lvol_ut_bs_dev dev;
+	struct spdk_lvs_opts opts;
+	uint64_t cluster = 0;
+	int rc = 0;
+
+	init_dev(&dev);
+
+	spdk_lvs_opts_init(&opts);
+	snprintf(opts.name, sizeof(opts.name), "lvs");
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_init(&dev.bs_dev, &opts, lvol_store_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+
+	spdk_lvol_create(g_lvol_store, "lvol", 10, false, LVOL_CLEAR_WITH_DEFAULT,
+			 lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+
+	spdk_lvol_prefill(NULL, 0, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == -ENODEV);
+
+	g_prefill_rc = -EINVAL;
+	spdk_lvol_prefill(g_lvol, 0, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == -EINVAL);
+
+	/* All clusters of the lvol are prefilled, at the requested rate */
+	g_prefill_rc = 0;
+	g_prefill_clusters = &cluster;
+	spdk_lvol_prefill(g_lvol, 100, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(g_prefill_clusters == NULL);
+	CU_ASSERT(g_prefill_clusters_per_sec == 100);
+
+	spdk_lvol_close(g_lvol, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	spdk_lvol_destroy(g_lvol, op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_unload(g_lvol_store, op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	g_lvol_store = NULL;
+
+	free_dev(&dev);
+
+	/* Make sure that all references to the io_channel was closed after
+	 * prefill call
+	 */
+	CU_ASSERT(g_io_channel == NULL);
+}
+
 static void
 lvol_decouple_parent(void)
 {
@@ -3336,6 +3465,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, lvs_rename);
 	CU_ADD_TEST(suite, lvol_inflate);
 	CU_ADD_TEST(suite, lvol_decouple_parent);
+	CU_ADD_TEST(suite, lvol_defragment);
+	CU_ADD_TEST(suite, lvol_prefill);
 	CU_ADD_TEST(suite, lvol_get_xattr);
 	CU_ADD_TEST(suite, lvol_esnap_reload);
 	CU_ADD_TEST(suite, lvol_esnap_create_bad_args);
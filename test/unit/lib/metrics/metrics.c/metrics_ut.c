@@ -0,0 +1,179 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_cunit.h"
+#include "common/lib/test_env.c"
+#include "metrics/metrics.c"
+
+DEFINE_STUB_V(spdk_unaffinitize_thread, (void));
+
+static void
+collect_counter(struct spdk_metrics_writer *w)
+{
+	spdk_metrics_write_family(w, "test_ops", SPDK_METRICS_COUNTER, "Test operations");
+	spdk_metrics_write_value(w, "name", "simple", 1);
+	spdk_metrics_write_value(w, "name", "a\"b\\c\nd", UINT64_MAX);
+}
+
+static void
+collect_gauge(struct spdk_metrics_writer *w)
+{
+	spdk_metrics_write_family(w, "test_depth", SPDK_METRICS_GAUGE, "Test depth");
+	spdk_metrics_write_value(w, NULL, NULL, 42);
+}
+
+static struct spdk_metrics_source g_counter_source = {
+	.name = "counter",
+	.collect = collect_counter,
+};
+
+static struct spdk_metrics_source g_gauge_source = {
+	.name = "gauge",
+	.collect = collect_gauge,
+};
+
+static int g_start_count;
+static int g_stop_count;
+
+static void
+source_start(void)
+{
+	g_start_count++;
+}
+
+static void
+source_stop(void)
+{
+	g_stop_count++;
+}
+
+static struct spdk_metrics_source g_notified_source = {
+	.name = "notified",
+	.collect = collect_gauge,
+	.start = source_start,
+	.stop = source_stop,
+};
+
+static void
+metrics_format(void)
+{
+	const char *expected =
+		"# TYPE spdk_test_ops counter\n"
+		"# HELP spdk_test_ops Test operations\n"
+		"spdk_test_ops_total{name=\"simple\"} 1\n"
+		"spdk_test_ops_total{name=\"a\\\"b\\\\c\\nd\"} 18446744073709551615\n"
+		"# TYPE spdk_test_depth gauge\n"
+		"# HELP spdk_test_depth Test depth\n"
+		"spdk_test_depth 42\n"
+		"# EOF\n";
+	size_t len = 0;
+	char *buf;
+
+	/* Drop the sources registered by the libraries linked to the test */
+	TAILQ_INIT(&g_metrics_sources);
+
+	buf = metrics_collect(&len);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+	CU_ASSERT(len == strlen("# EOF\n"));
+	CU_ASSERT(memcmp(buf, "# EOF\n", len) == 0);
+	free(buf);
+
+	spdk_metrics_source_register(&g_counter_source);
+	spdk_metrics_source_register(&g_gauge_source);
+
+	buf = metrics_collect(&len);
+	SPDK_CU_ASSERT_FATAL(buf != NULL);
+	CU_ASSERT(len == strlen(expected));
+	CU_ASSERT(memcmp(buf, expected, len) == 0);
+	free(buf);
+
+	TAILQ_INIT(&g_metrics_sources);
+}
+
+static void
+metrics_writer_grow(void)
+{
+	struct spdk_metrics_writer w = {};
+	char expected[32];
+	size_t offset = 0;
+	int i;
+
+	/* Start with a buffer that is too small to hold a single line */
+	w.size = 4;
+	w.buf = malloc(w.size);
+	SPDK_CU_ASSERT_FATAL(w.buf != NULL);
+
+	spdk_metrics_write_family(&w, "grow", SPDK_METRICS_GAUGE, "Grow");
+	for (i = 0; i < 1000; i++) {
+		spdk_metrics_write_value(&w, NULL, NULL, i);
+	}
+
+	CU_ASSERT(!w.failed);
+	CU_ASSERT(w.len < w.size);
+	offset = strlen("# TYPE spdk_grow gauge\n# HELP spdk_grow Grow\n");
+	CU_ASSERT(memcmp(w.buf, "# TYPE spdk_grow gauge\n# HELP spdk_grow Grow\n", offset) == 0);
+	for (i = 0; i < 1000; i++) {
+		snprintf(expected, sizeof(expected), "spdk_grow %d\n", i);
+		CU_ASSERT(memcmp(w.buf + offset, expected, strlen(expected)) == 0);
+		offset += strlen(expected);
+	}
+	CU_ASSERT(offset == w.len);
+
+	free(w.buf);
+}
+
+static void
+metrics_server_notify(void)
+{
+	int rc;
+
+	TAILQ_INIT(&g_metrics_sources);
+	spdk_metrics_source_register(&g_counter_source);
+	spdk_metrics_source_register(&g_notified_source);
+
+	/* Sources without callbacks are skipped */
+	rc = spdk_metrics_server_start("127.0.0.1", 0);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_start_count == 1);
+	CU_ASSERT(g_stop_count == 0);
+
+	/* Starting the server again fails without calling the sources */
+	rc = spdk_metrics_server_start("127.0.0.1", 0);
+	CU_ASSERT(rc == -EEXIST);
+	CU_ASSERT(g_start_count == 1);
+
+	spdk_metrics_server_stop();
+	CU_ASSERT(g_start_count == 1);
+	CU_ASSERT(g_stop_count == 1);
+
+	/* Stopping a stopped server is a no-op */
+	spdk_metrics_server_stop();
+	CU_ASSERT(g_stop_count == 1);
+
+	TAILQ_INIT(&g_metrics_sources);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("metrics", NULL, NULL);
+	CU_ADD_TEST(suite, metrics_format);
+	CU_ADD_TEST(suite, metrics_writer_grow);
+	CU_ADD_TEST(suite, metrics_server_notify);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	return num_failures;
+}
@@ -62,6 +62,99 @@ notify(void)
 	SPDK_CU_ASSERT_FATAL(event == NULL);
 }
 
+struct listener_ctx {
+	uint64_t idx[4];
+	char ctx[4][SPDK_NOTIFY_MAX_CTX_SIZE];
+	uint32_t count;
+	uint32_t stop_at;
+};
+
+static int
+listener_cb(uint64_t idx, const struct spdk_notify_event *event, void *ctx)
+{
+	struct listener_ctx *lctx = ctx;
+
+	SPDK_CU_ASSERT_FATAL(lctx->count < SPDK_COUNTOF(lctx->idx));
+	lctx->idx[lctx->count] = idx;
+	snprintf(lctx->ctx[lctx->count], sizeof(lctx->ctx[0]), "%s", event->ctx);
+	lctx->count++;
+
+	return lctx->count == lctx->stop_at;
+}
+
+static void
+listener(void)
+{
+	struct spdk_notify_listener *all, *one;
+	struct listener_ctx all_ctx = {}, one_ctx = {};
+	const struct spdk_notify_event *event = NULL;
+	const char *types[] = { "one" };
+	uint64_t idx;
+	uint32_t cnt;
+
+	/* Ring size must be a power of 2 */
+	all = spdk_notify_listen(NULL, 0, 3, listener_cb, &all_ctx);
+	CU_ASSERT(all == NULL);
+
+	all = spdk_notify_listen(NULL, 0, 2, listener_cb, &all_ctx);
+	SPDK_CU_ASSERT_FATAL(all != NULL);
+	one = spdk_notify_listen(types, SPDK_COUNTOF(types), 4, listener_cb, &one_ctx);
+	SPDK_CU_ASSERT_FATAL(one != NULL);
+
+	/* Nothing sent yet */
+	cnt = spdk_notify_listener_poll(all, 8);
+	CU_ASSERT(cnt == 0);
+
+	idx = spdk_notify_send("one", "first");
+	spdk_notify_send("two", "second");
+	spdk_notify_send("one", "third");
+
+	/* The ring of the first listener only holds two events */
+	CU_ASSERT(spdk_notify_listener_get_dropped(all) == 1);
+	CU_ASSERT(spdk_notify_listener_get_dropped(one) == 0);
+
+	cnt = spdk_notify_listener_poll(all, 8);
+	CU_ASSERT(cnt == 2);
+	CU_ASSERT(all_ctx.count == 2);
+	CU_ASSERT(all_ctx.idx[0] == idx);
+	CU_ASSERT(strcmp(all_ctx.ctx[0], "first") == 0);
+	CU_ASSERT(all_ctx.idx[1] == idx + 1);
+	CU_ASSERT(strcmp(all_ctx.ctx[1], "second") == 0);
+
+	/* The second listener gets events of type "one" only and stops when the callback says so */
+	one_ctx.stop_at = 1;
+	cnt = spdk_notify_listener_poll(one, 8);
+	CU_ASSERT(cnt == 1);
+	CU_ASSERT(one_ctx.idx[0] == idx);
+	CU_ASSERT(strcmp(one_ctx.ctx[0], "first") == 0);
+
+	cnt = spdk_notify_listener_poll(one, 8);
+	CU_ASSERT(cnt == 1);
+	CU_ASSERT(one_ctx.idx[1] == idx + 2);
+	CU_ASSERT(strcmp(one_ctx.ctx[1], "third") == 0);
+
+	/* There's room in the ring again */
+	spdk_notify_send("two", "fourth");
+	cnt = spdk_notify_listener_poll(all, 8);
+	CU_ASSERT(cnt == 1);
+	CU_ASSERT(all_ctx.idx[2] == idx + 3);
+	CU_ASSERT(strcmp(all_ctx.ctx[2], "fourth") == 0);
+	CU_ASSERT(spdk_notify_listener_get_dropped(all) == 1);
+
+	cnt = spdk_notify_listener_poll(one, 8);
+	CU_ASSERT(cnt == 0);
+
+	spdk_notify_unlisten(all);
+	spdk_notify_unlisten(one);
+
+	/* The history of events is still kept after the listeners are gone */
+	spdk_notify_send("one", "fifth");
+	cnt = spdk_notify_foreach_event(idx, 8, event_cb, &event);
+	CU_ASSERT(cnt == 5);
+	SPDK_CU_ASSERT_FATAL(event != NULL);
+	CU_ASSERT(strcmp(event->ctx, "fifth") == 0);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -73,6 +166,7 @@ main(int argc, char **argv)
 
 	suite = CU_add_suite("app_suite", NULL, NULL);
 	CU_ADD_TEST(suite, notify);
+	CU_ADD_TEST(suite, listener);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
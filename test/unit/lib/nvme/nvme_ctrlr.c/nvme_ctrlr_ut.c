@@ -3068,6 +3068,68 @@ test_nvme_ctrlr_identify_namespaces_iocs_specific_next(void)
 	CU_ASSERT(pthread_mutex_destroy(&ctrlr.ctrlr_lock) == 0);
 }
 
+static void
+test_nvme_ctrlr_identify_namespaces_batch(void)
+{
+	struct spdk_nvme_ctrlr ctrlr = {};
+	struct spdk_nvme_ns ns[40] = {};
+	int rc;
+	int i;
+
+	RB_INIT(&ctrlr.ns);
+	for (i = 0; i < 40; i++) {
+		ns[i].id = i + 1;
+		ns[i].active = true;
+		RB_INSERT(nvme_ns_tree, &ctrlr.ns, &ns[i]);
+	}
+
+	CU_ASSERT(pthread_mutex_init(&ctrlr.ctrlr_lock, NULL) == 0);
+
+	ctrlr.cdata.nn = 40;
+	ctrlr.active_ns_count = 40;
+	ctrlr.vs.raw = SPDK_NVME_VERSION(1, 3, 0);
+	ctrlr.opts.admin_queue_size = 32;
+	ctrlr.opts.admin_timeout_ms = NVME_TIMEOUT_INFINITE;
+
+	/* All the namespaces are identified, move on to the next state */
+	rc = nvme_ctrlr_identify_namespaces(&ctrlr);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_ID_DESCS);
+	CU_ASSERT(ctrlr.identify_ns_batch.outstanding == 0);
+	CU_ASSERT(ctrlr.identify_ns_batch.nsid == 0);
+	for (i = 0; i < 40; i++) {
+		CU_ASSERT(ns[i].ctrlr == &ctrlr);
+	}
+
+	/* Identify NS failing to be submitted fails the controller */
+	g_fail_next_identify = true;
+	rc = nvme_ctrlr_identify_namespaces(&ctrlr);
+	CU_ASSERT(rc != 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ERROR);
+	CU_ASSERT(ctrlr.identify_ns_batch.outstanding == 0);
+
+	/* Identify NS completing with an error fails the controller */
+	set_status_code = SPDK_NVME_SC_INVALID_FIELD;
+	rc = nvme_ctrlr_identify_namespaces(&ctrlr);
+	CU_ASSERT(rc != 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_ERROR);
+	CU_ASSERT(ctrlr.identify_ns_batch.outstanding == 0);
+
+	/* NS ID descriptor list errors are ignored */
+	rc = nvme_ctrlr_identify_id_desc_namespaces(&ctrlr);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC);
+	CU_ASSERT(ctrlr.identify_ns_batch.outstanding == 0);
+	set_status_code = SPDK_NVME_SC_SUCCESS;
+
+	rc = nvme_ctrlr_identify_id_desc_namespaces(&ctrlr);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ctrlr.state == NVME_CTRLR_STATE_IDENTIFY_NS_IOCS_SPECIFIC);
+	CU_ASSERT(ctrlr.identify_ns_batch.nsid == 0);
+
+	CU_ASSERT(pthread_mutex_destroy(&ctrlr.ctrlr_lock) == 0);
+}
+
 static void
 test_nvme_ctrlr_set_supported_log_pages(void)
 {
@@ -3410,6 +3472,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_ctrlr_aer_callback);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_ns_attr_changed);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_identify_namespaces_iocs_specific_next);
+	CU_ADD_TEST(suite, test_nvme_ctrlr_identify_namespaces_batch);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_set_supported_log_pages);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_set_intel_supported_log_pages);
 	CU_ADD_TEST(suite, test_nvme_ctrlr_parse_ana_log_page);
@@ -284,6 +284,19 @@ test_nvme_ns_set_identify_data(void)
 	nvme_ns_set_identify_data(&ns);
 	CU_ASSERT(ns.sectors_per_max_io == 256);
 	CU_ASSERT(ns.sectors_per_max_io_no_md == 256);
+
+	/* case 3: write sizes are only reported with nsfeat.optperf */
+	CU_ASSERT(spdk_nvme_ns_get_preferred_write_granularity(&ns) == 0);
+	CU_ASSERT(spdk_nvme_ns_get_optimal_write_size(&ns) == 0);
+	ns.nsdata.npwg = 7;
+	ns.nsdata.nows = 31;
+	nvme_ns_set_identify_data(&ns);
+	CU_ASSERT(spdk_nvme_ns_get_preferred_write_granularity(&ns) == 0);
+	CU_ASSERT(spdk_nvme_ns_get_optimal_write_size(&ns) == 0);
+	ns.nsdata.nsfeat.optperf = 1;
+	nvme_ns_set_identify_data(&ns);
+	CU_ASSERT(spdk_nvme_ns_get_preferred_write_granularity(&ns) == 8);
+	CU_ASSERT(spdk_nvme_ns_get_optimal_write_size(&ns) == 32);
 }
 
 static void
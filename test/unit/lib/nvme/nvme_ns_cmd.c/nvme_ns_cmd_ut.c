@@ -482,6 +482,82 @@ split_test4(void)
 	cleanup_after_test(&qpair);
 }
 
+static void
+check_child_rw(struct nvme_request *parent, uint64_t lba, uint32_t lba_count)
+{
+	struct nvme_request	*child;
+	uint64_t		cmd_lba;
+	uint32_t		cmd_lba_count;
+
+	child = TAILQ_FIRST(&parent->children);
+	SPDK_CU_ASSERT_FATAL(child != NULL);
+	nvme_request_remove_child(parent, child);
+	nvme_cmd_interpret_rw(&child->cmd, &cmd_lba, &cmd_lba_count);
+	CU_ASSERT(cmd_lba == lba);
+	CU_ASSERT(cmd_lba_count == lba_count);
+	nvme_free_request(child);
+}
+
+static void
+split_test_aligned_writes(void)
+{
+	struct spdk_nvme_ns	ns;
+	struct spdk_nvme_ctrlr	ctrlr;
+	struct spdk_nvme_qpair	qpair;
+	void			*payload;
+	int			rc;
+
+	/*
+	 * Controller has max xfer of 96 KB (192 blocks). Submit writes of 256 blocks
+	 * starting at LBA 10.
+	 */
+	prepare_for_test(&ns, &ctrlr, &qpair, 512, 0, 96 * 1024, 0, false);
+	payload = malloc(256 * 512);
+	ns.sectors_per_write_granularity = 8;
+	ns.sectors_per_optimal_write = 64;
+
+	/* Without the option, the write is only split on the max xfer size. */
+	rc = spdk_nvme_ns_cmd_write(&ns, &qpair, payload, 10, 256, NULL, NULL, 0);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->num_children == 2);
+	check_child_rw(g_request, 10, 192);
+	check_child_rw(g_request, 202, 64);
+	nvme_free_request(g_request);
+
+	/* The first child ends on an optimal write size boundary. */
+	ctrlr.opts.align_write_splits = true;
+	rc = spdk_nvme_ns_cmd_write(&ns, &qpair, payload, 10, 256, NULL, NULL, 0);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->num_children == 2);
+	check_child_rw(g_request, 10, 182);
+	check_child_rw(g_request, 192, 74);
+	nvme_free_request(g_request);
+
+	/* Not a power of 2, fall back to the write granularity. */
+	ns.sectors_per_optimal_write = 48;
+	rc = spdk_nvme_ns_cmd_write(&ns, &qpair, payload, 10, 256, NULL, NULL, 0);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->num_children == 2);
+	check_child_rw(g_request, 10, 190);
+	check_child_rw(g_request, 200, 66);
+	nvme_free_request(g_request);
+
+	/* Reads are not affected. */
+	rc = spdk_nvme_ns_cmd_read(&ns, &qpair, payload, 10, 256, NULL, NULL, 0);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->num_children == 2);
+	check_child_rw(g_request, 10, 192);
+	check_child_rw(g_request, 202, 64);
+	nvme_free_request(g_request);
+
+	free(payload);
+	cleanup_after_test(&qpair);
+}
+
 static void
 test_cmd_child_request(void)
 {
@@ -829,6 +905,148 @@ test_nvme_ns_cmd_writev(void)
 	cleanup_after_test(&qpair);
 }
 
+struct ut_sgl_ctx {
+	struct iovec iovs[NVME_REQUEST_INLINE_IOVS + 1];
+	uint32_t iovcnt;
+	uint32_t iovpos;
+	uint32_t iov_offset;
+	uint32_t next_sge_count;
+};
+
+static void
+ut_sgl_reset(void *cb_arg, uint32_t offset)
+{
+	struct ut_sgl_ctx *ctx = cb_arg;
+
+	for (ctx->iovpos = 0; ctx->iovpos < ctx->iovcnt; ctx->iovpos++) {
+		if (offset < ctx->iovs[ctx->iovpos].iov_len) {
+			break;
+		}
+		offset -= ctx->iovs[ctx->iovpos].iov_len;
+	}
+	ctx->iov_offset = offset;
+}
+
+static int
+ut_sgl_next_sge(void *cb_arg, void **address, uint32_t *length)
+{
+	struct ut_sgl_ctx *ctx = cb_arg;
+
+	ctx->next_sge_count++;
+	if (ctx->iovpos >= ctx->iovcnt) {
+		return -1;
+	}
+
+	*address = (uint8_t *)ctx->iovs[ctx->iovpos].iov_base + ctx->iov_offset;
+	*length = ctx->iovs[ctx->iovpos].iov_len - ctx->iov_offset;
+	ctx->iovpos++;
+	ctx->iov_offset = 0;
+	return 0;
+}
+
+static void
+test_nvme_ns_cmd_copy_sgl(void)
+{
+	struct spdk_nvme_ns		ns;
+	struct spdk_nvme_ctrlr		ctrlr;
+	struct spdk_nvme_qpair		qpair;
+	struct ut_sgl_ctx		ctx = {};
+	struct nvme_request		*child;
+	struct nvme_sgl_iter		iter;
+	void				*address;
+	uint32_t			length;
+	int				rc;
+
+	prepare_for_test(&ns, &ctrlr, &qpair, 512, 0, 128 * 1024, 0, false);
+	qpair.trtype = SPDK_NVME_TRANSPORT_PCIE;
+
+	/* The SGL is copied once, and not walked again to check split. */
+	ctx.iovs[0].iov_base = (void *)0x100000;
+	ctx.iovs[0].iov_len = 0x1000;
+	ctx.iovs[1].iov_base = (void *)0x200000;
+	ctx.iovs[1].iov_len = 0x1000;
+	ctx.iovs[2].iov_base = (void *)0x300000;
+	ctx.iovs[2].iov_len = 0x2000;
+	ctx.iovcnt = 3;
+	rc = spdk_nvme_ns_cmd_readv(&ns, &qpair, 0, 32, NULL, &ctx, 0, ut_sgl_reset, ut_sgl_next_sge);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->num_children == 0);
+	CU_ASSERT(g_request->payload.iovs == g_request->iovs);
+	CU_ASSERT(g_request->payload.iovcnt == 3);
+	CU_ASSERT(memcmp(g_request->iovs, ctx.iovs, 3 * sizeof(struct iovec)) == 0);
+	CU_ASSERT(ctx.next_sge_count == 3);
+
+	/* The iterator seeks into the copy. */
+	nvme_sgl_iter_init(&iter, &g_request->payload, 0x1800);
+	CU_ASSERT(nvme_sgl_iter_next(&iter, &address, &length) == 0);
+	CU_ASSERT(address == (void *)0x200800);
+	CU_ASSERT(length == 0x800);
+	CU_ASSERT(nvme_sgl_iter_next(&iter, &address, &length) == 0);
+	CU_ASSERT(address == (void *)0x300000);
+	CU_ASSERT(length == 0x2000);
+	CU_ASSERT(nvme_sgl_iter_next(&iter, &address, &length) != 0);
+	CU_ASSERT(ctx.next_sge_count == 3);
+	nvme_free_request(g_request);
+
+	/* An unaligned element splits the request, the children share the copy of the parent. */
+	ctx.iovs[1].iov_base = (void *)0x200200;
+	ctx.iovs[1].iov_len = 0xE00;
+	ctx.next_sge_count = 0;
+	g_request = NULL;
+	rc = spdk_nvme_ns_cmd_readv(&ns, &qpair, 0, 31, NULL, &ctx, 0, ut_sgl_reset, ut_sgl_next_sge);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->num_children == 2);
+	CU_ASSERT(ctx.next_sge_count == 3);
+
+	child = TAILQ_FIRST(&g_request->children);
+	nvme_request_remove_child(g_request, child);
+	CU_ASSERT(child->payload_offset == 0);
+	CU_ASSERT(child->payload_size == 0x1000);
+	CU_ASSERT(child->payload.iovs == g_request->iovs);
+	CU_ASSERT(child->payload.iovcnt == 3);
+	nvme_free_request(child);
+
+	child = TAILQ_FIRST(&g_request->children);
+	nvme_request_remove_child(g_request, child);
+	CU_ASSERT(child->payload_offset == 0x1000);
+	CU_ASSERT(child->payload_size == 0x2E00);
+	CU_ASSERT(child->payload.iovs == g_request->iovs);
+	nvme_free_request(child);
+	nvme_free_request(g_request);
+
+	/* Too many elements, fall back to the callbacks. */
+	ctx.iovs[1].iov_base = (void *)0x200000;
+	ctx.iovs[1].iov_len = 0x1000;
+	ctx.iovs[2].iov_len = 0x1000;
+	ctx.iovs[3].iov_base = (void *)0x400000;
+	ctx.iovs[3].iov_len = 0x1000;
+	ctx.iovs[4].iov_base = (void *)0x500000;
+	ctx.iovs[4].iov_len = 0x1000;
+	ctx.iovcnt = 5;
+	g_request = NULL;
+	rc = spdk_nvme_ns_cmd_readv(&ns, &qpair, 0, 40, NULL, &ctx, 0, ut_sgl_reset, ut_sgl_next_sge);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->payload.iovcnt == 0);
+	nvme_free_request(g_request);
+
+	/* Only PCIe uses the copy. */
+	ctx.iovcnt = 1;
+	qpair.trtype = SPDK_NVME_TRANSPORT_TCP;
+	ctx.next_sge_count = 0;
+	g_request = NULL;
+	rc = spdk_nvme_ns_cmd_readv(&ns, &qpair, 0, 8, NULL, &ctx, 0, ut_sgl_reset, ut_sgl_next_sge);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_request != NULL);
+	CU_ASSERT(g_request->payload.iovcnt == 0);
+	CU_ASSERT(ctx.next_sge_count == 1);
+	nvme_free_request(g_request);
+
+	cleanup_after_test(&qpair);
+}
+
 static void
 test_nvme_ns_cmd_comparev(void)
 {
@@ -2330,6 +2548,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, split_test2);
 	CU_ADD_TEST(suite, split_test3);
 	CU_ADD_TEST(suite, split_test4);
+	CU_ADD_TEST(suite, split_test_aligned_writes);
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_flush);
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_dataset_management);
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_copy);
@@ -2344,6 +2563,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_readv);
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_read_with_md);
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_writev);
+	CU_ADD_TEST(suite, test_nvme_ns_cmd_copy_sgl);
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_write_with_md);
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_zone_append_with_md);
 	CU_ADD_TEST(suite, test_nvme_ns_cmd_zone_appendv_with_md);
@@ -107,10 +107,26 @@ spdk_vtophys(const void *buf, uint64_t *size)
 	return (uintptr_t)buf;
 }
 
+int
+spdk_vtophys_iovs(const struct iovec *iovs, int iovcnt, uint64_t *phys_addrs)
+{
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		phys_addrs[i] = spdk_vtophys(iovs[i].iov_base, NULL);
+		if (phys_addrs[i] == SPDK_VTOPHYS_ERROR) {
+			return -EFAULT;
+		}
+	}
+
+	return 0;
+}
+
 DEFINE_STUB(spdk_pci_device_get_addr, struct spdk_pci_addr, (struct spdk_pci_device *dev), {});
 DEFINE_STUB(nvme_ctrlr_probe, int, (const struct spdk_nvme_transport_id *trid,
 				    struct spdk_nvme_probe_ctx *probe_ctx, void *devhandle), 0);
 DEFINE_STUB(spdk_pci_device_is_removed, bool, (struct spdk_pci_device *dev), false);
+DEFINE_STUB(spdk_pci_device_get_socket_id, int, (struct spdk_pci_device *dev), 0);
 DEFINE_STUB(nvme_get_ctrlr_by_trid_unsafe, struct spdk_nvme_ctrlr *,
 	    (const struct spdk_nvme_transport_id *trid), NULL);
 DEFINE_STUB(spdk_nvme_ctrlr_get_regs_csts, union spdk_nvme_csts_register,
@@ -124,6 +140,9 @@ DEFINE_STUB_V(spdk_nvme_qpair_print_command, (struct spdk_nvme_qpair *qpair,
 		struct spdk_nvme_cmd *cmd));
 DEFINE_STUB_V(spdk_nvme_qpair_print_completion, (struct spdk_nvme_qpair *qpair,
 		struct spdk_nvme_cpl *cpl));
+DEFINE_STUB_V(spdk_nvme_print_completion, (uint16_t qid, struct spdk_nvme_cpl *cpl));
+DEFINE_STUB(spdk_nvme_ctrlr_alloc_qid, int32_t, (struct spdk_nvme_ctrlr *ctrlr), 1);
+DEFINE_STUB_V(spdk_nvme_ctrlr_free_qid, (struct spdk_nvme_ctrlr *ctrlr, uint16_t qid));
 
 static void
 prp_list_prep(struct nvme_tracker *tr, struct nvme_request *req, uint32_t *prp_index)
@@ -53,6 +53,12 @@ DEFINE_STUB(nvme_ctrlr_disable_poll, int, (struct spdk_nvme_ctrlr *ctrlr), 0);
 
 DEFINE_STUB_V(nvme_transport_ctrlr_disconnect_qpair_done, (struct spdk_nvme_qpair *qpair));
 
+DEFINE_STUB(spdk_nvme_ctrlr_alloc_qid, int32_t, (struct spdk_nvme_ctrlr *ctrlr), 5);
+
+DEFINE_STUB_V(spdk_nvme_ctrlr_free_qid, (struct spdk_nvme_ctrlr *ctrlr, uint16_t qid));
+
+DEFINE_STUB_V(spdk_nvme_print_completion, (uint16_t qid, struct spdk_nvme_cpl *cpl));
+
 int
 nvme_qpair_init(struct spdk_nvme_qpair *qpair, uint16_t id,
 		struct spdk_nvme_ctrlr *ctrlr,
@@ -91,6 +97,21 @@ test_nvme_pcie_ctrlr_alloc_cmb(void)
 	CU_ASSERT(phys_addr_var == 0xF8001000);
 	CU_ASSERT(pctrlr.cmb.current_offset == 4160);
 
+	/* A released region is allocated again */
+	nvme_pcie_ctrlr_free_cmb(&pctrlr.ctrlr, vaddr, phys_addr_var, size);
+	CU_ASSERT(!STAILQ_EMPTY(&pctrlr.cmb.free_regions));
+
+	vaddr = nvme_pcie_ctrlr_alloc_cmb(&pctrlr.ctrlr, size * 2, alignment, &phys_addr_var);
+	CU_ASSERT(vaddr == (void *)0xF9002000);
+	CU_ASSERT(phys_addr_var == 0xF8002000);
+	CU_ASSERT(pctrlr.cmb.current_offset == 8320);
+
+	vaddr = nvme_pcie_ctrlr_alloc_cmb(&pctrlr.ctrlr, size, alignment, &phys_addr_var);
+	CU_ASSERT(vaddr == (void *)0xF9001000);
+	CU_ASSERT(phys_addr_var == 0xF8001000);
+	CU_ASSERT(pctrlr.cmb.current_offset == 8320);
+	CU_ASSERT(STAILQ_EMPTY(&pctrlr.cmb.free_regions));
+
 	/* CMB size overload */
 	size = 0x1000000;
 
@@ -111,6 +132,7 @@ test_nvme_pcie_qpair_construct_destroy(void)
 	struct nvme_pcie_ctrlr pctrlr = {};
 	struct spdk_nvme_cpl cpl[2] = {};
 	struct nvme_pcie_qpair *pqpair = NULL;
+	struct nvme_pcie_cmb_region *region;
 	size_t page_align = sysconf(_SC_PAGESIZE);
 	uint64_t cmb_offset;
 	int rc;
@@ -164,6 +186,15 @@ test_nvme_pcie_qpair_construct_destroy(void)
 	cmb_offset = pctrlr.cmb.current_offset;
 	nvme_pcie_qpair_destroy(&pqpair->qpair);
 
+	/* The submission queue is released to the CMB. */
+	region = STAILQ_FIRST(&pctrlr.cmb.free_regions);
+	SPDK_CU_ASSERT_FATAL(region != NULL);
+	CU_ASSERT(region->size == 2 * sizeof(struct spdk_nvme_cmd));
+	CU_ASSERT(region->phys_addr == (((pctrlr.cmb.bar_pa + cmb_offset - region->size) + page_align - 1) &
+					~(page_align - 1)));
+	STAILQ_REMOVE_HEAD(&pctrlr.cmb.free_regions, link);
+	spdk_free(region);
+
 	/* Disable submission queue in controller memory buffer. */
 	pctrlr.ctrlr.opts.use_cmb_sqs = false;
 	pqpair = spdk_zmalloc(sizeof(*pqpair), 64, NULL,
@@ -579,6 +610,186 @@ test_nvme_pcie_poll_group_get_stats(void)
 	CU_ASSERT(rc == 0);
 }
 
+static void
+test_nvme_pcie_qpair_submit_tracker_delayed(void)
+{
+	struct nvme_pcie_ctrlr pctrlr = {};
+	struct nvme_pcie_qpair pqpair = {};
+	struct spdk_nvme_pcie_stat stat = {};
+	struct spdk_nvme_cmd cmd[8] = {};
+	struct nvme_request req = {};
+	struct nvme_tracker tr = {};
+	uint32_t sq_tdbl = 0;
+
+	pqpair.qpair.ctrlr = &pctrlr.ctrlr;
+	pqpair.cmd = cmd;
+	pqpair.num_entries = 8;
+	pqpair.sq_head = pqpair.sq_tail = pqpair.last_sq_tail = 5;
+	pqpair.sq_tdbl = &sq_tdbl;
+	pqpair.stat = &stat;
+	pqpair.flags.delay_cmd_submit = 1;
+	pqpair.delay_cmd_submit_batch_size = 2;
+	tr.req = &req;
+
+	/* The doorbell is rung once enough commands are pending */
+	nvme_pcie_qpair_submit_tracker(&pqpair.qpair, &tr);
+	CU_ASSERT(stat.sq_mmio_doorbell_updates == 0);
+	nvme_pcie_qpair_submit_tracker(&pqpair.qpair, &tr);
+	CU_ASSERT(stat.sq_mmio_doorbell_updates == 1);
+	CU_ASSERT(sq_tdbl == 7);
+	CU_ASSERT(pqpair.last_sq_tail == 7);
+
+	/* Even across the end of the queue */
+	nvme_pcie_qpair_submit_tracker(&pqpair.qpair, &tr);
+	CU_ASSERT(stat.sq_mmio_doorbell_updates == 1);
+	nvme_pcie_qpair_submit_tracker(&pqpair.qpair, &tr);
+	CU_ASSERT(stat.sq_mmio_doorbell_updates == 2);
+	CU_ASSERT(sq_tdbl == 1);
+	CU_ASSERT(pqpair.last_sq_tail == 1);
+
+	/* Without a limit, the doorbell is only rung when processing completions */
+	pqpair.delay_cmd_submit_batch_size = 0;
+	nvme_pcie_qpair_submit_tracker(&pqpair.qpair, &tr);
+	nvme_pcie_qpair_submit_tracker(&pqpair.qpair, &tr);
+	nvme_pcie_qpair_submit_tracker(&pqpair.qpair, &tr);
+	CU_ASSERT(stat.sq_mmio_doorbell_updates == 2);
+	CU_ASSERT(pqpair.last_sq_tail == 1);
+}
+
+static void
+test_nvme_pcie_shared_cq(void)
+{
+	struct nvme_pcie_ctrlr pctrlr = {};
+	struct nvme_pcie_qpair pqpair[3] = {};
+	struct spdk_nvme_cpl qpair_cpl[3][8] = {};
+	struct spdk_nvme_transport_poll_group *tgroup;
+	struct nvme_pcie_poll_group *group;
+	struct spdk_nvme_qpair adminq = {};
+	struct nvme_request req[8] = {};
+	struct spdk_nvme_cpl cpl = {};
+	uint32_t doorbells[32] = {};
+	struct nvme_pcie_cq *cq;
+	int i, rc;
+
+	pctrlr.ctrlr.trid.trtype = SPDK_NVME_TRANSPORT_PCIE;
+	pctrlr.ctrlr.cap.bits.mqes = 15;
+	pctrlr.doorbell_base = doorbells;
+	pctrlr.doorbell_stride_u32 = 1;
+	pctrlr.ctrlr.adminq = &adminq;
+	STAILQ_INIT(&adminq.free_req);
+	for (i = 0; i < 8; i++) {
+		STAILQ_INSERT_TAIL(&adminq.free_req, &req[i], stailq);
+	}
+
+	tgroup = nvme_pcie_poll_group_create();
+	SPDK_CU_ASSERT_FATAL(tgroup != NULL);
+	group = SPDK_CONTAINEROF(tgroup, struct nvme_pcie_poll_group, group);
+
+	/* 6 trackers each, so two of them fit in a 16 entries completion queue. */
+	for (i = 0; i < 3; i++) {
+		pqpair[i].qpair.ctrlr = &pctrlr.ctrlr;
+		pqpair[i].qpair.id = i + 1;
+		pqpair[i].qpair.poll_group = tgroup;
+		pqpair[i].cpl = qpair_cpl[i];
+		pqpair[i].num_entries = 8;
+		pqpair[i].max_completions_cap = 2;
+		pqpair[i].use_shared_cq = true;
+	}
+
+	/* The first qpair creates the completion queue. */
+	rc = nvme_pcie_ctrlr_connect_qpair(&pctrlr.ctrlr, &pqpair[0].qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(req[0].cmd.opc == SPDK_NVME_OPC_CREATE_IO_CQ);
+	CU_ASSERT(req[0].cmd.cdw10_bits.create_io_q.qid == 5);
+	CU_ASSERT(req[0].cmd.cdw10_bits.create_io_q.qsize == 15);
+	CU_ASSERT(pqpair[0].pcie_state == NVME_PCIE_QPAIR_WAIT_FOR_CQ);
+	CU_ASSERT(pqpair[0].flags.shared_cq == 1);
+	cq = pqpair[0].cq;
+	SPDK_CU_ASSERT_FATAL(cq != NULL);
+	CU_ASSERT(cq->state == NVME_PCIE_CQ_WAIT);
+	CU_ASSERT(TAILQ_FIRST(&group->cqs) == cq);
+
+	/* The second one waits for it. */
+	rc = nvme_pcie_ctrlr_connect_qpair(&pctrlr.ctrlr, &pqpair[1].qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(req[1].cmd.opc == 0);
+	CU_ASSERT(pqpair[1].pcie_state == NVME_PCIE_QPAIR_WAIT_FOR_CQ);
+	CU_ASSERT(pqpair[1].cq == cq);
+	CU_ASSERT(cq->refs == 2);
+	CU_ASSERT(cq->num_trackers == 12);
+
+	/* Both submission queues are created on it. */
+	req[0].cb_fn(req[0].cb_arg, &cpl);
+	CU_ASSERT(cq->state == NVME_PCIE_CQ_READY);
+	for (i = 0; i < 2; i++) {
+		CU_ASSERT(req[i + 1].cmd.opc == SPDK_NVME_OPC_CREATE_IO_SQ);
+		CU_ASSERT(req[i + 1].cmd.cdw10_bits.create_io_q.qid == i + 1);
+		CU_ASSERT(req[i + 1].cmd.cdw11_bits.create_io_sq.cqid == 5);
+		CU_ASSERT(pqpair[i].pcie_state == NVME_PCIE_QPAIR_WAIT_FOR_SQ);
+		req[i + 1].cb_fn(req[i + 1].cb_arg, &cpl);
+		CU_ASSERT(pqpair[i].pcie_state == NVME_PCIE_QPAIR_READY);
+	}
+
+	/* The third one doesn't fit anymore and gets another completion queue. */
+	MOCK_SET(spdk_nvme_ctrlr_alloc_qid, 6);
+	rc = nvme_pcie_ctrlr_connect_qpair(&pctrlr.ctrlr, &pqpair[2].qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(req[3].cmd.opc == SPDK_NVME_OPC_CREATE_IO_CQ);
+	CU_ASSERT(req[3].cmd.cdw10_bits.create_io_q.qid == 6);
+	CU_ASSERT(pqpair[2].cq != NULL && pqpair[2].cq != cq);
+	nvme_pcie_qpair_detach_cq(&pqpair[2]);
+	CU_ASSERT(TAILQ_FIRST(&group->cqs) == cq && TAILQ_NEXT(cq, link) == NULL);
+	MOCK_SET(spdk_nvme_ctrlr_alloc_qid, 5);
+
+	/* Completions are moved to the qpair their submission queue belongs to. */
+	cq->cpl[0].sqid = 2;
+	cq->cpl[0].cid = 3;
+	cq->cpl[0].sqhd = 4;
+	cq->cpl[0].status.p = 1;
+	cq->cpl[1].sqid = 1;
+	cq->cpl[1].cid = 1;
+	cq->cpl[1].status.p = 1;
+	rc = nvme_pcie_poll_group_process_completions(tgroup, 0, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(cq->cq_head == 2);
+	CU_ASSERT(doorbells[2 * 5 + 1] == 2);
+	CU_ASSERT(group->stats.cq_mmio_doorbell_updates == 1);
+	CU_ASSERT(pqpair[1].cpl_tail == 1);
+	CU_ASSERT(pqpair[1].cpl[0].cid == 3);
+	CU_ASSERT(pqpair[1].cpl[0].sqhd == 4);
+	CU_ASSERT(pqpair[1].cpl[0].status.p == pqpair[1].flags.phase);
+	CU_ASSERT(pqpair[0].cpl_tail == 1);
+	CU_ASSERT(pqpair[0].cpl[0].cid == 1);
+	CU_ASSERT(pqpair[0].cpl[1].status.p != pqpair[0].flags.phase);
+
+	/* After a controller reset, the completion queue isn't polled until it's created again. */
+	pctrlr.queue_generation++;
+	cq->cpl[2].sqid = 1;
+	cq->cpl[2].status.p = 1;
+	nvme_pcie_poll_group_process_completions(tgroup, 0, NULL);
+	CU_ASSERT(cq->cq_head == 2);
+
+	rc = nvme_pcie_ctrlr_connect_qpair(&pctrlr.ctrlr, &pqpair[0].qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(req[4].cmd.opc == SPDK_NVME_OPC_CREATE_IO_CQ);
+	CU_ASSERT(req[4].cmd.cdw10_bits.create_io_q.qid == 5);
+	CU_ASSERT(cq->generation == pctrlr.queue_generation);
+	CU_ASSERT(cq->cq_head == 0);
+	CU_ASSERT(cq->cpl[2].status.p == 0);
+	req[4].cb_fn(req[4].cb_arg, &cpl);
+	CU_ASSERT(req[5].cmd.opc == SPDK_NVME_OPC_CREATE_IO_SQ);
+	CU_ASSERT(req[5].cmd.cdw11_bits.create_io_sq.cqid == 5);
+
+	/* The completion queue is freed along with the last qpair attached to it. */
+	nvme_pcie_qpair_detach_cq(&pqpair[0]);
+	CU_ASSERT(TAILQ_FIRST(&group->cqs) == cq);
+	nvme_pcie_qpair_detach_cq(&pqpair[1]);
+	CU_ASSERT(TAILQ_EMPTY(&group->cqs));
+
+	rc = nvme_pcie_poll_group_destroy(tgroup);
+	CU_ASSERT(rc == 0);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -595,6 +806,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_pcie_ctrlr_connect_qpair);
 	CU_ADD_TEST(suite, test_nvme_pcie_ctrlr_construct_admin_qpair);
 	CU_ADD_TEST(suite, test_nvme_pcie_poll_group_get_stats);
+	CU_ADD_TEST(suite, test_nvme_pcie_qpair_submit_tracker_delayed);
+	CU_ADD_TEST(suite, test_nvme_pcie_shared_cq);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
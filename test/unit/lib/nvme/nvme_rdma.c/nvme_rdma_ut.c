@@ -1054,6 +1054,81 @@ test_nvme_rdma_qpair_submit_request(void)
 	nvme_rdma_free_reqs(&rqpair);
 }
 
+static void
+test_nvme_rdma_send_signal_interval(void)
+{
+	struct nvme_rdma_qpair		rqpair = {};
+	struct spdk_nvme_rdma_req	rdma_reqs[4] = {};
+	uint32_t			i;
+
+	/* Only the last send of each interval is signaled and retires the others. */
+	rqpair.send_signal_interval = 4;
+
+	for (i = 0; i < 4; i++) {
+		nvme_rdma_req_set_send_flags(&rqpair, &rdma_reqs[i]);
+	}
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(rdma_reqs[i].unsignaled == 1);
+		CU_ASSERT(rdma_reqs[i].send_wr.send_flags == 0);
+	}
+	CU_ASSERT(rdma_reqs[3].unsignaled == 0);
+	CU_ASSERT(rdma_reqs[3].send_wr.send_flags == IBV_SEND_SIGNALED);
+	CU_ASSERT(rdma_reqs[3].retired_sends == 4);
+	CU_ASSERT(rqpair.num_unsignaled_sends == 0);
+	CU_ASSERT(rqpair.num_sq_entries == 4);
+
+	/* Without an interval, all sends are signaled. */
+	rqpair.send_signal_interval = 1;
+	rqpair.num_sq_entries = 0;
+
+	nvme_rdma_req_set_send_flags(&rqpair, &rdma_reqs[0]);
+	CU_ASSERT(rdma_reqs[0].unsignaled == 0);
+	CU_ASSERT(rdma_reqs[0].send_wr.send_flags == IBV_SEND_SIGNALED);
+	CU_ASSERT(rdma_reqs[0].retired_sends == 1);
+	CU_ASSERT(rqpair.num_sq_entries == 1);
+}
+
+static void
+test_nvme_rdma_unsignaled_send_flush(void)
+{
+	struct nvme_rdma_qpair		rqpair = {};
+	struct spdk_nvme_rdma_req	rdma_reqs[2] = {};
+	struct nvme_request		req = {};
+	struct ibv_wc			wc = { .status = IBV_WC_WR_FLUSH_ERR };
+	struct nvme_rdma_wr		*rdma_wr;
+	int				rc;
+
+	rqpair.qpair.trtype = SPDK_NVME_TRANSPORT_RDMA;
+	rqpair.send_signal_interval = 2;
+	rqpair.current_num_sends = 1;
+	req.qpair = &rqpair.qpair;
+
+	nvme_rdma_req_set_send_flags(&rqpair, &rdma_reqs[0]);
+	nvme_rdma_req_set_send_flags(&rqpair, &rdma_reqs[1]);
+	CU_ASSERT(rdma_reqs[0].send_wr.wr_id == (uint64_t)&rdma_reqs[0].unsignaled_rdma_wr);
+	CU_ASSERT(rdma_reqs[1].send_wr.wr_id == (uint64_t)&rdma_reqs[1].rdma_wr);
+
+	/* The request got its response and was completed, the flushed send is not accounted for */
+	rdma_reqs[0].unsignaled_rdma_wr.type = RDMA_WR_TYPE_UNSIGNALED_SEND;
+	wc.wr_id = rdma_reqs[0].send_wr.wr_id;
+	rdma_wr = (struct nvme_rdma_wr *)wc.wr_id;
+	rc = nvme_rdma_process_unsignaled_send_completion(NULL, &rqpair, &wc, rdma_wr);
+	CU_ASSERT(rc == -ENXIO);
+	CU_ASSERT(rqpair.current_num_sends == 1);
+	CU_ASSERT(rqpair.qpair.transport_failure_reason == SPDK_NVME_QPAIR_FAILURE_UNKNOWN);
+
+	/* The request still waits for its send, account for it once */
+	rdma_reqs[0].req = &req;
+	rc = nvme_rdma_process_unsignaled_send_completion(NULL, &rqpair, &wc, rdma_wr);
+	CU_ASSERT(rc == -ENXIO);
+	CU_ASSERT(rqpair.current_num_sends == 0);
+	CU_ASSERT(rdma_reqs[0].completion_flags & NVME_RDMA_SEND_COMPLETED);
+
+	rc = nvme_rdma_process_unsignaled_send_completion(NULL, &rqpair, &wc, rdma_wr);
+	CU_ASSERT(rc == -ENXIO);
+	CU_ASSERT(rqpair.current_num_sends == 0);
+}
+
 static void
 test_nvme_rdma_memory_domain(void)
 {
@@ -1361,7 +1436,8 @@ test_nvme_rdma_qpair_set_poller(void)
 	struct nvme_rdma_poll_group *group;
 	struct spdk_nvme_transport_poll_group *tgroup;
 	struct nvme_rdma_poller *poller;
-	struct nvme_rdma_qpair rqpair = {};
+	struct nvme_rdma_poller srq_poller = {};
+	struct nvme_rdma_qpair rqpair = {}, rqpair2 = {};
 	struct rdma_cm_id cm_id = {};
 
 	/* Case1: Test function nvme_rdma_poll_group_create */
@@ -1447,6 +1523,26 @@ test_nvme_rdma_qpair_set_poller(void)
 	CU_ASSERT(rqpair.cq == poller->cq);
 	CU_ASSERT(rqpair.poller == poller);
 
+	/* Test6: The entries of a removed qpair are given back to the poller */
+	rqpair2.qpair.poll_group = tgroup;
+	rqpair2.qpair.trtype = SPDK_NVME_TRANSPORT_RDMA;
+	rqpair2.cm_id = &cm_id;
+	rqpair2.num_entries = 1;
+
+	rc = nvme_rdma_qpair_set_poller(&rqpair2.qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(rqpair2.poller == poller);
+	CU_ASSERT(poller->required_num_wc == (DEFAULT_NVME_RDMA_CQ_SIZE - 1) * 2 + 2);
+
+	rqpair2.qpair.poll_group_tailq_head = &tgroup->disconnected_qpairs;
+
+	rc = nvme_rdma_poll_group_remove(tgroup, &rqpair2.qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(rqpair2.poller == NULL);
+	CU_ASSERT(STAILQ_FIRST(&group->pollers) == poller);
+	CU_ASSERT(poller->current_num_wc == DEFAULT_NVME_RDMA_CQ_SIZE * 2);
+	CU_ASSERT(poller->required_num_wc == (DEFAULT_NVME_RDMA_CQ_SIZE - 1) * 2);
+
 	rqpair.qpair.poll_group_tailq_head = &tgroup->disconnected_qpairs;
 
 	rc = nvme_rdma_poll_group_remove(tgroup, &rqpair.qpair);
@@ -1454,6 +1550,24 @@ test_nvme_rdma_qpair_set_poller(void)
 
 	rc = nvme_rdma_poll_group_destroy(tgroup);
 	CU_ASSERT(rc == 0);
+
+	/* Case3: With an SRQ, the CQ only grows for the send WRs of the qpairs */
+	srq_poller.srq = (struct spdk_rdma_srq *)0xFEEDBEEF;
+	srq_poller.current_num_wc = 128;
+	srq_poller.required_num_wc = 64;
+	rqpair.num_entries = 32;
+
+	rc = nvme_rdma_resize_cq(&rqpair, &srq_poller);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(srq_poller.current_num_wc == 128);
+	CU_ASSERT(srq_poller.required_num_wc == 96);
+
+	rqpair.num_entries = 64;
+
+	rc = nvme_rdma_resize_cq(&rqpair, &srq_poller);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(srq_poller.current_num_wc == 256);
+	CU_ASSERT(srq_poller.required_num_wc == 160);
 }
 
 int
@@ -1482,6 +1596,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_rdma_parse_addr);
 	CU_ADD_TEST(suite, test_nvme_rdma_qpair_init);
 	CU_ADD_TEST(suite, test_nvme_rdma_qpair_submit_request);
+	CU_ADD_TEST(suite, test_nvme_rdma_send_signal_interval);
+	CU_ADD_TEST(suite, test_nvme_rdma_unsignaled_send_flush);
 	CU_ADD_TEST(suite, test_nvme_rdma_memory_domain);
 	CU_ADD_TEST(suite, test_rdma_ctrlr_get_memory_domains);
 	CU_ADD_TEST(suite, test_rdma_get_memory_translation);
@@ -1325,6 +1325,168 @@ test_nvme_tcp_pdu_payload_handle(void)
 	CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_QUIESCING);
 }
 
+static uint32_t g_ut_accel_crc32c_count;
+
+static void
+ut_submit_accel_crc32c(void *ctx, uint32_t *dst, struct iovec *iov, uint32_t iov_cnt,
+		       uint32_t seed, spdk_nvme_accel_completion_cb cb_fn, void *cb_arg)
+{
+	g_ut_accel_crc32c_count++;
+}
+
+static void
+test_nvme_tcp_ddgst_batch(void)
+{
+	struct spdk_nvme_poll_group group = {};
+	struct nvme_tcp_poll_group tgroup = {};
+	struct nvme_tcp_qpair tqpair = {};
+	struct spdk_nvme_tcp_stat stats = {};
+	struct nvme_tcp_pdu recv_pdu = {}, req_pdu = {};
+	struct nvme_tcp_req tcp_req = {};
+	struct nvme_request req = {};
+	uint8_t buf[4096];
+	uint32_t reaped = 0;
+
+	group.accel_fn_table.submit_accel_crc32c = ut_submit_accel_crc32c;
+	tgroup.group.group = &group;
+	TAILQ_INIT(&tgroup.needs_poll);
+	TAILQ_INIT(&tgroup.ddgst_reqs);
+
+	tqpair.qpair.poll_group = &tgroup.group;
+	tqpair.recv_pdu = &recv_pdu;
+	tqpair.stats = &stats;
+	nvme_qpair_set_state(&tqpair.qpair, NVME_QPAIR_CONNECTED);
+
+	tcp_req.tqpair = &tqpair;
+	tcp_req.req = &req;
+	tcp_req.pdu = &req_pdu;
+	req.payload_size = sizeof(buf);
+
+	recv_pdu.req = &tcp_req;
+	recv_pdu.ddgst_enable = true;
+	recv_pdu.hdr.common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_C2H_DATA;
+	recv_pdu.hdr.c2h_data.common.flags = SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS |
+					     SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU;
+	recv_pdu.data_len = sizeof(buf);
+	recv_pdu.data_iov[0].iov_base = buf;
+	recv_pdu.data_iov[0].iov_len = sizeof(buf);
+	recv_pdu.data_iovcnt = 1;
+
+	/* While completions are processed, the digest is held until the end of the pass. */
+	g_ut_accel_crc32c_count = 0;
+	tgroup.in_completions = true;
+	tqpair.recv_state = NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD;
+	nvme_tcp_pdu_payload_handle(&tqpair, &reaped);
+	CU_ASSERT(tqpair.recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
+	CU_ASSERT(TAILQ_FIRST(&tgroup.ddgst_reqs) == &tcp_req);
+	CU_ASSERT(g_ut_accel_crc32c_count == 0);
+	CU_ASSERT(req_pdu.data_iov[0].iov_base == buf);
+
+	nvme_tcp_poll_group_submit_ddgsts(&tgroup);
+	CU_ASSERT(TAILQ_EMPTY(&tgroup.ddgst_reqs));
+	CU_ASSERT(g_ut_accel_crc32c_count == 1);
+	CU_ASSERT(tgroup.stats.data_digests == 1);
+
+	/* The digests of a disconnected qpair are dropped. */
+	tqpair.recv_state = NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD;
+	nvme_tcp_pdu_payload_handle(&tqpair, &reaped);
+	CU_ASSERT(TAILQ_FIRST(&tgroup.ddgst_reqs) == &tcp_req);
+	nvme_tcp_poll_group_drop_ddgsts(&tgroup, &tqpair);
+	CU_ASSERT(TAILQ_EMPTY(&tgroup.ddgst_reqs));
+	CU_ASSERT(g_ut_accel_crc32c_count == 1);
+
+	/* Without the success flag, the digest is submitted right away. */
+	recv_pdu.hdr.c2h_data.common.flags = SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU;
+	tqpair.recv_state = NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD;
+	nvme_tcp_pdu_payload_handle(&tqpair, &reaped);
+	CU_ASSERT(TAILQ_EMPTY(&tgroup.ddgst_reqs));
+	CU_ASSERT(g_ut_accel_crc32c_count == 2);
+
+	/* Outside of a pass too. */
+	recv_pdu.hdr.c2h_data.common.flags = SPDK_NVME_TCP_C2H_DATA_FLAGS_SUCCESS |
+					     SPDK_NVME_TCP_C2H_DATA_FLAGS_LAST_PDU;
+	tgroup.in_completions = false;
+	tqpair.recv_state = NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PAYLOAD;
+	nvme_tcp_pdu_payload_handle(&tqpair, &reaped);
+	CU_ASSERT(TAILQ_EMPTY(&tgroup.ddgst_reqs));
+	CU_ASSERT(g_ut_accel_crc32c_count == 3);
+	CU_ASSERT(tgroup.stats.data_digests == 3);
+}
+
+static void
+test_nvme_tcp_recv_lookahead(void)
+{
+	struct nvme_tcp_qpair tqpair = {};
+	struct spdk_nvme_tcp_stat stats = {};
+	struct nvme_tcp_pdu pdu = {};
+	uint8_t buf[4096], hdr[32];
+	uint32_t i;
+	int rc;
+
+	tqpair.sock = (struct spdk_sock *)0xDEADBEEF;
+	tqpair.stats = &stats;
+
+	pdu.hdr.common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_C2H_DATA;
+	pdu.data_len = sizeof(buf);
+	pdu.data_iov[0].iov_base = buf;
+	pdu.data_iov[0].iov_len = sizeof(buf);
+	pdu.data_iovcnt = 1;
+
+	/* The payload readv() also returns the start of the next PDU. */
+	MOCK_SET(spdk_sock_readv, sizeof(buf) + NVME_TCP_RECV_LOOKAHEAD_SIZE);
+	rc = nvme_tcp_qpair_read_payload(&tqpair, &pdu, sizeof(buf));
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pdu.rw_offset == sizeof(buf));
+	CU_ASSERT(tqpair.recv_lookahead_len == NVME_TCP_RECV_LOOKAHEAD_SIZE);
+	CU_ASSERT(tqpair.recv_lookahead_off == 0);
+	CU_ASSERT(stats.recv_lookaheads == 1);
+
+	for (i = 0; i < NVME_TCP_RECV_LOOKAHEAD_SIZE; i++) {
+		tqpair.recv_lookahead[i] = i;
+	}
+
+	/* The header comes from the lookahead buffer without reading the socket. */
+	MOCK_SET(spdk_sock_recv, -1);
+	rc = nvme_tcp_qpair_read_hdr(&tqpair, sizeof(struct spdk_nvme_tcp_common_pdu_hdr), hdr);
+	CU_ASSERT(rc == sizeof(struct spdk_nvme_tcp_common_pdu_hdr));
+	CU_ASSERT(hdr[0] == 0 && hdr[7] == 7);
+	CU_ASSERT(tqpair.recv_lookahead_off == sizeof(struct spdk_nvme_tcp_common_pdu_hdr));
+
+	/* What is missing is read from the socket. */
+	MOCK_SET(spdk_sock_recv, sizeof(struct spdk_nvme_tcp_common_pdu_hdr));
+	rc = nvme_tcp_qpair_read_hdr(&tqpair, NVME_TCP_RECV_LOOKAHEAD_SIZE, hdr);
+	CU_ASSERT(rc == NVME_TCP_RECV_LOOKAHEAD_SIZE);
+	CU_ASSERT(hdr[0] == 8);
+	CU_ASSERT(!nvme_tcp_qpair_has_lookahead(&tqpair));
+
+	/* A short payload can be entirely in the lookahead buffer. */
+	tqpair.recv_lookahead_len = NVME_TCP_RECV_LOOKAHEAD_SIZE;
+	tqpair.recv_lookahead_off = 0;
+	pdu.hdr.common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_C2H_TERM_REQ;
+	pdu.data_len = 16;
+	pdu.rw_offset = 0;
+	MOCK_SET(spdk_sock_recv, -1);
+	rc = nvme_tcp_qpair_read_payload(&tqpair, &pdu, 16);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pdu.rw_offset == 16);
+	CU_ASSERT(buf[0] == 0 && buf[15] == 15);
+	CU_ASSERT(tqpair.recv_lookahead_off == 16);
+
+	/* Only C2H data payloads read ahead. */
+	pdu.data_len = 32;
+	pdu.rw_offset = 0;
+	MOCK_SET(spdk_sock_recv, 32 - (NVME_TCP_RECV_LOOKAHEAD_SIZE - 16));
+	rc = nvme_tcp_qpair_read_payload(&tqpair, &pdu, 32);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(pdu.rw_offset == 32);
+	CU_ASSERT(buf[0] == 16);
+	CU_ASSERT(!nvme_tcp_qpair_has_lookahead(&tqpair));
+	CU_ASSERT(stats.recv_lookaheads == 1);
+
+	MOCK_CLEAR(spdk_sock_readv);
+	MOCK_SET(spdk_sock_recv, 1);
+}
+
 static void
 test_nvme_tcp_capsule_resp_hdr_handle(void)
 {
@@ -1803,6 +1965,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_tcp_c2h_payload_handle);
 	CU_ADD_TEST(suite, test_nvme_tcp_icresp_handle);
 	CU_ADD_TEST(suite, test_nvme_tcp_pdu_payload_handle);
+	CU_ADD_TEST(suite, test_nvme_tcp_ddgst_batch);
+	CU_ADD_TEST(suite, test_nvme_tcp_recv_lookahead);
 	CU_ADD_TEST(suite, test_nvme_tcp_capsule_resp_hdr_handle);
 	CU_ADD_TEST(suite, test_nvme_tcp_ctrlr_connect_qpair);
 	CU_ADD_TEST(suite, test_nvme_tcp_ctrlr_disconnect_qpair);
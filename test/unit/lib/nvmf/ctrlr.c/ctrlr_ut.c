@@ -178,6 +178,9 @@ DEFINE_STUB(nvmf_bdev_ctrlr_get_dif_ctx, bool,
 DEFINE_STUB_V(nvmf_transport_qpair_abort_request,
 	      (struct spdk_nvmf_qpair *qpair, struct spdk_nvmf_request *req));
 
+DEFINE_STUB(nvmf_transport_qpair_get_in_capsule_data_size, uint32_t,
+	    (struct spdk_nvmf_qpair *qpair), UINT32_MAX);
+
 DEFINE_STUB_V(spdk_nvme_print_command, (uint16_t qid, struct spdk_nvme_cmd *cmd));
 DEFINE_STUB_V(spdk_nvme_print_completion, (uint16_t qid, struct spdk_nvme_cpl *cpl));
 
@@ -208,6 +211,7 @@ DEFINE_STUB(spdk_bdev_get_max_active_zones, uint32_t, (const struct spdk_bdev *b
 	    MAX_ACTIVE_ZONES);
 DEFINE_STUB(spdk_bdev_get_max_open_zones, uint32_t, (const struct spdk_bdev *bdev), MAX_OPEN_ZONES);
 DEFINE_STUB(spdk_bdev_get_zone_size, uint64_t, (const struct spdk_bdev *bdev), ZONE_SIZE);
+DEFINE_STUB(spdk_bdev_get_block_size, uint32_t, (const struct spdk_bdev *bdev), 512);
 DEFINE_STUB(spdk_bdev_is_zoned, bool, (const struct spdk_bdev *bdev), false);
 
 DEFINE_STUB(spdk_nvme_ns_get_format_index, uint32_t,
@@ -424,6 +428,7 @@ test_connect(void)
 	};
 	const char subnqn[] = "nqn.2016-06.io.spdk:subsystem1";
 	const char hostnqn[] = "nqn.2016-06.io.spdk:host1";
+	uint64_t connects, failed_connects;
 	int rc;
 
 	memset(&group, 0, sizeof(group));
@@ -658,12 +663,20 @@ test_connect(void)
 	cmd.connect_cmd.sqsize = 63;
 	sgroups[subsystem.id].mgmt_io_outstanding++;
 	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
+	connects = group.stat.connects;
 	rc = nvmf_ctrlr_cmd_connect(&req);
-	poll_threads();
 	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	/* I/O connects are passed to the subsystem thread in a batch */
+	SPDK_CU_ASSERT_FATAL(group.io_connect_batch != NULL);
+	CU_ASSERT(group.io_connect_batch->num_reqs == 1);
+	CU_ASSERT(group.io_connect_batch->reqs[0] == &req);
+	CU_ASSERT(qpair.ctrlr == NULL);
+	poll_threads();
+	CU_ASSERT(group.io_connect_batch == NULL);
 	CU_ASSERT(nvme_status_success(&rsp.nvme_cpl.status));
 	CU_ASSERT(qpair.ctrlr == &ctrlr);
 	CU_ASSERT(sgroups[subsystem.id].mgmt_io_outstanding == 0);
+	CU_ASSERT(group.stat.connects == connects + 1);
 	qpair.ctrlr = NULL;
 	cmd.connect_cmd.sqsize = 31;
 
@@ -672,8 +685,10 @@ test_connect(void)
 	MOCK_SET(nvmf_subsystem_get_ctrlr, NULL);
 	sgroups[subsystem.id].mgmt_io_outstanding++;
 	TAILQ_INSERT_TAIL(&qpair.outstanding, &req, link);
+	failed_connects = group.stat.failed_connects;
 	rc = nvmf_ctrlr_cmd_connect(&req);
 	poll_threads();
+	CU_ASSERT(group.stat.failed_connects == failed_connects + 1);
 	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
 	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_COMMAND_SPECIFIC);
 	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVMF_FABRIC_SC_INVALID_PARAM);
@@ -1168,6 +1183,8 @@ test_set_get_features(void)
 	union nvmf_c2h_msg rsp = {};
 	struct spdk_nvmf_ns ns[3];
 	struct spdk_nvmf_ns *ns_arr[3] = {&ns[0], NULL, &ns[2]};
+	struct spdk_nvmf_transport_ops ops = {};
+	struct spdk_nvmf_transport transport = { .ops = &ops };
 	struct spdk_nvmf_request req;
 	int rc;
 
@@ -1277,6 +1294,41 @@ test_set_get_features(void)
 
 	rc = nvmf_ctrlr_set_features(&req);
 	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+
+	/* Set SPDK_NVME_FEAT_INTERRUPT_COALESCING - not changeable on fabrics */
+	admin_qpair.transport = &transport;
+	ops.type = SPDK_NVME_TRANSPORT_TCP;
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_SET_FEATURES;
+	cmd.nvme_cmd.cdw11 = 0;
+	cmd.nvme_cmd.cdw11_bits.feat_interrupt_coalescing.bits.thr = 7;
+	cmd.nvme_cmd.cdw11_bits.feat_interrupt_coalescing.bits.time = 2;
+	cmd.nvme_cmd.cdw10_bits.set_features.fid = SPDK_NVME_FEAT_INTERRUPT_COALESCING;
+
+	rc = nvmf_ctrlr_set_features(&req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_COMMAND_SPECIFIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_FEATURE_NOT_CHANGEABLE);
+	CU_ASSERT(ctrlr.feat.interrupt_coalescing.raw == 0);
+
+	/* Set SPDK_NVME_FEAT_INTERRUPT_COALESCING - vfio-user */
+	ops.type = SPDK_NVME_TRANSPORT_VFIOUSER;
+	memset(&rsp, 0, sizeof(rsp));
+
+	rc = nvmf_ctrlr_set_features(&req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_SUCCESS);
+	CU_ASSERT(ctrlr.feat.interrupt_coalescing.bits.thr == 7);
+	CU_ASSERT(ctrlr.feat.interrupt_coalescing.bits.time == 2);
+
+	/* Get SPDK_NVME_FEAT_INTERRUPT_COALESCING */
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_GET_FEATURES;
+	cmd.nvme_cmd.cdw11 = 0;
+	cmd.nvme_cmd.cdw10_bits.get_features.fid = SPDK_NVME_FEAT_INTERRUPT_COALESCING;
+
+	rc = nvmf_ctrlr_get_features(&req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.cdw0 == ctrlr.feat.interrupt_coalescing.raw);
 }
 
 /*
@@ -2765,6 +2817,7 @@ test_zcopy_read(void)
 	req.qpair = &qpair;
 	req.cmd = (union nvmf_h2c_msg *)&cmd;
 	req.rsp = &rsp;
+	req.length = 4096;
 	cmd.opc = SPDK_NVME_OPC_READ;
 
 	/* Prepare for zcopy */
@@ -2788,6 +2841,12 @@ test_zcopy_read(void)
 	CU_ASSERT(qpair.outstanding.tqh_first == NULL);
 	CU_ASSERT(ns_info.io_outstanding == 0);
 	CU_ASSERT(nvme_status_success(&rsp.nvme_cpl.status));
+
+	/* The IO is accounted to both the namespace and the qpair once it's done */
+	CU_ASSERT(ns_info.io_stat.num_read_ops == 1);
+	CU_ASSERT(ns_info.io_stat.bytes_read == 4096);
+	CU_ASSERT(ns_info.io_stat.num_errors == 0);
+	CU_ASSERT(memcmp(&qpair.io_stat, &ns_info.io_stat, sizeof(qpair.io_stat)) == 0);
 }
 
 static void
@@ -2851,6 +2910,7 @@ test_zcopy_write(void)
 	req.qpair = &qpair;
 	req.cmd = (union nvmf_h2c_msg *)&cmd;
 	req.rsp = &rsp;
+	req.length = 4096;
 	cmd.opc = SPDK_NVME_OPC_WRITE;
 
 	/* Prepare for zcopy */
@@ -2874,6 +2934,12 @@ test_zcopy_write(void)
 	CU_ASSERT(qpair.outstanding.tqh_first == NULL);
 	CU_ASSERT(ns_info.io_outstanding == 0);
 	CU_ASSERT(nvme_status_success(&rsp.nvme_cpl.status));
+
+	/* The IO is accounted to both the namespace and the qpair once it's done */
+	CU_ASSERT(ns_info.io_stat.num_write_ops == 1);
+	CU_ASSERT(ns_info.io_stat.bytes_written == 4096);
+	CU_ASSERT(ns_info.io_stat.num_errors == 0);
+	CU_ASSERT(memcmp(&qpair.io_stat, &ns_info.io_stat, sizeof(qpair.io_stat)) == 0);
 }
 
 static void
@@ -3066,6 +3132,107 @@ test_nvmf_ctrlr_set_features_host_behavior_support(void)
 	CU_ASSERT(req.rsp->nvme_cpl.status.sc == SPDK_NVME_SC_INVALID_FIELD);
 }
 
+static void
+test_nvmf_request_qos_admit(void)
+{
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_request req = {};
+	struct spdk_nvmf_qpair qpair = {};
+	struct spdk_nvmf_ctrlr ctrlr = {};
+	union nvmf_h2c_msg cmd = {};
+	struct spdk_nvmf_ns ns = {};
+	struct spdk_nvmf_ns *subsys_ns[1] = {};
+	struct spdk_nvmf_ns_qos qos = {};
+	struct spdk_bdev bdev = {};
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_subsystem_poll_group sgroups = {};
+	struct spdk_nvmf_subsystem_pg_ns_info ns_info = {};
+
+	subsystem.id = 0;
+	subsystem.max_nsid = 1;
+	subsys_ns[0] = &ns;
+	subsystem.ns = (struct spdk_nvmf_ns **)&subsys_ns;
+	ns.bdev = &bdev;
+	ctrlr.subsys = &subsystem;
+
+	qpair.ctrlr = &ctrlr;
+	qpair.group = &group;
+	qpair.qid = 1;
+
+	group.num_sgroups = 1;
+	sgroups.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	sgroups.num_ns = 1;
+	ns_info.state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+	sgroups.ns_info = &ns_info;
+	group.sgroups = &sgroups;
+
+	req.qpair = &qpair;
+	req.cmd = &cmd;
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
+	cmd.nvme_cmd.nsid = 1;
+	/* 8 blocks of 512 bytes */
+	cmd.nvme_cmd.cdw12 = 7;
+
+	/* No QoS on the namespace */
+	CU_ASSERT(nvmf_request_qos_admit(&req, false));
+
+	/* 2000 IO/s, that's 2 IOs per 1ms timeslice */
+	qos.limits[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT] = 2000;
+	qos.max_per_timeslice[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT] = 2;
+	qos.remaining_this_timeslice[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT] = 2;
+	qos.timeslice_size = 1000;
+	qos.last_timeslice = spdk_get_ticks();
+	ns.qos = &qos;
+
+	CU_ASSERT(nvmf_request_qos_admit(&req, false));
+	CU_ASSERT(nvmf_request_qos_admit(&req, false));
+	CU_ASSERT(!nvmf_request_qos_admit(&req, false));
+
+	/* Admin commands and other I/O commands aren't limited */
+	qpair.qid = 0;
+	CU_ASSERT(nvmf_request_qos_admit(&req, false));
+	qpair.qid = 1;
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_FLUSH;
+	CU_ASSERT(nvmf_request_qos_admit(&req, false));
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_READ;
+
+	/* Forced requests are admitted, but they're charged for */
+	CU_ASSERT(nvmf_request_qos_admit(&req, true));
+	CU_ASSERT(qos.remaining_this_timeslice[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT] == -1);
+
+	/* The overrun is carried over to the next timeslice */
+	spdk_delay_us(1000);
+	CU_ASSERT(nvmf_request_qos_admit(&req, false));
+	CU_ASSERT(!nvmf_request_qos_admit(&req, false));
+
+	/* Unused budget doesn't accumulate */
+	spdk_delay_us(5000);
+	CU_ASSERT(qos.remaining_this_timeslice[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT] == 0);
+	CU_ASSERT(nvmf_request_qos_admit(&req, false));
+	CU_ASSERT(qos.remaining_this_timeslice[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT] == 1);
+
+	/* Write bandwidth only, 4KiB per timeslice */
+	qos.max_per_timeslice[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT] = 0;
+	qos.max_per_timeslice[SPDK_NVMF_NS_QOS_W_BPS_RATE_LIMIT] = 4096;
+	qos.remaining_this_timeslice[SPDK_NVMF_NS_QOS_W_BPS_RATE_LIMIT] = 4096;
+
+	CU_ASSERT(nvmf_request_qos_admit(&req, false));
+	CU_ASSERT(qos.remaining_this_timeslice[SPDK_NVMF_NS_QOS_W_BPS_RATE_LIMIT] == 4096);
+	cmd.nvme_cmd.opc = SPDK_NVME_OPC_WRITE;
+	CU_ASSERT(nvmf_request_qos_admit(&req, false));
+	CU_ASSERT(qos.remaining_this_timeslice[SPDK_NVMF_NS_QOS_W_BPS_RATE_LIMIT] == 0);
+	CU_ASSERT(!nvmf_request_qos_admit(&req, false));
+
+	/* Fused commands can't be separated */
+	cmd.nvme_cmd.fuse = SPDK_NVME_CMD_FUSE_SECOND;
+	CU_ASSERT(nvmf_request_qos_admit(&req, false));
+	cmd.nvme_cmd.fuse = SPDK_NVME_CMD_FUSE_NONE;
+
+	/* Requests to an inactive namespace are left to nvmf_check_subsystem_active() */
+	ns_info.state = SPDK_NVMF_SUBSYSTEM_PAUSED;
+	CU_ASSERT(nvmf_request_qos_admit(&req, false));
+}
+
 int
 main(int argc, char **argv)
 {
@@ -3106,6 +3273,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_property_set);
 	CU_ADD_TEST(suite, test_nvmf_ctrlr_get_features_host_behavior_support);
 	CU_ADD_TEST(suite, test_nvmf_ctrlr_set_features_host_behavior_support);
+	CU_ADD_TEST(suite, test_nvmf_request_qos_admit);
 
 	allocate_threads(1);
 	set_thread(0);
@@ -80,6 +80,7 @@ DEFINE_STUB(spdk_bdev_is_zoned, bool, (const struct spdk_bdev *bdev), false);
 
 DEFINE_STUB(spdk_bdev_get_max_zone_append_size, uint32_t,
 	    (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB_V(spdk_unaffinitize_thread, (void));
 
 const char *
 spdk_bdev_get_name(const struct spdk_bdev *bdev)
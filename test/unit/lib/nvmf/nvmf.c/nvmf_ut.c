@@ -11,9 +11,6 @@
 
 DEFINE_STUB_V(nvmf_transport_poll_group_destroy, (struct spdk_nvmf_transport_poll_group *group));
 DEFINE_STUB_V(nvmf_ctrlr_destruct, (struct spdk_nvmf_ctrlr *ctrlr));
-DEFINE_STUB_V(nvmf_transport_qpair_fini, (struct spdk_nvmf_qpair *qpair,
-		spdk_nvmf_transport_qpair_fini_cb cb_fn,
-		void *cb_arg));
 DEFINE_STUB_V(nvmf_qpair_free_aer, (struct spdk_nvmf_qpair *qpair));
 DEFINE_STUB_V(nvmf_qpair_abort_pending_zcopy_reqs, (struct spdk_nvmf_qpair *qpair));
 DEFINE_STUB(nvmf_transport_poll_group_create, struct spdk_nvmf_transport_poll_group *,
@@ -33,6 +30,7 @@ DEFINE_STUB_V(nvmf_subsystem_remove_all_listeners, (struct spdk_nvmf_subsystem *
 		bool stop));
 DEFINE_STUB(spdk_nvmf_subsystem_destroy, int, (struct spdk_nvmf_subsystem *subsystem,
 		nvmf_subsystem_destroy_cb cpl_cb, void *cpl_cb_arg), 0);
+DEFINE_STUB_V(nvmf_ptpl_worker_stop, (void));
 DEFINE_STUB(spdk_nvmf_subsystem_get_first_listener, struct spdk_nvmf_subsystem_listener *,
 	    (struct spdk_nvmf_subsystem *subsystem), NULL);
 DEFINE_STUB(spdk_nvmf_subsystem_get_next_listener, struct spdk_nvmf_subsystem_listener *,
@@ -108,6 +106,30 @@ DEFINE_STUB_V(nvmf_transport_dump_opts, (struct spdk_nvmf_transport *transport,
 		struct spdk_json_write_ctx *w, bool named));
 DEFINE_STUB_V(nvmf_transport_listen_dump_opts, (struct spdk_nvmf_transport *transport,
 		const struct spdk_nvme_transport_id *trid, struct spdk_json_write_ctx *w));
+DEFINE_STUB(nvmf_transport_qpair_can_migrate, bool, (struct spdk_nvmf_qpair *qpair), true);
+DEFINE_STUB(nvmf_transport_poll_group_migrate, int,
+	    (struct spdk_nvmf_transport_poll_group *group,
+	     struct spdk_nvmf_qpair *qpair), 0);
+
+void
+nvmf_transport_qpair_fini(struct spdk_nvmf_qpair *qpair,
+			  spdk_nvmf_transport_qpair_fini_cb cb_fn, void *cb_arg)
+{
+	if (cb_fn) {
+		cb_fn(cb_arg);
+	}
+}
+
+static spdk_nvmf_transport_qpair_quiesce_cb g_quiesce_cb_fn;
+static void *g_quiesce_cb_arg;
+
+void
+nvmf_transport_qpair_quiesce(struct spdk_nvmf_qpair *qpair,
+			     spdk_nvmf_transport_qpair_quiesce_cb cb_fn, void *cb_arg)
+{
+	g_quiesce_cb_fn = cb_fn;
+	g_quiesce_cb_arg = cb_arg;
+}
 
 struct spdk_io_channel {
 	struct spdk_thread		*thread;
@@ -212,6 +234,167 @@ test_nvmf_tgt_create_poll_group(void)
 	MOCK_CLEAR(spdk_bdev_get_io_channel);
 }
 
+static int g_migrate_status;
+static bool g_migrate_done;
+
+static void
+migrate_done(void *cb_arg, int status)
+{
+	g_migrate_done = true;
+	g_migrate_status = status;
+}
+
+static void
+test_nvmf_poll_group_migrate_qpair(void)
+{
+	struct spdk_thread		*thread;
+	struct spdk_nvmf_poll_group	group[2] = {};
+	struct spdk_nvmf_transport_poll_group tgroup[2] = {};
+	struct spdk_nvmf_subsystem_poll_group sgroup[2] = {};
+	struct spdk_nvmf_transport	transport = {};
+	struct spdk_nvmf_subsystem	subsystem = {};
+	struct spdk_nvmf_ctrlr		ctrlr = {};
+	struct spdk_nvmf_qpair		qpair = {};
+	int i, rc;
+
+	thread = spdk_thread_create(NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+	spdk_set_thread(thread);
+
+	for (i = 0; i < 2; i++) {
+		group[i].thread = thread;
+		TAILQ_INIT(&group[i].tgroups);
+		TAILQ_INIT(&group[i].qpairs);
+		tgroup[i].transport = &transport;
+		tgroup[i].group = &group[i];
+		TAILQ_INSERT_TAIL(&group[i].tgroups, &tgroup[i], link);
+		sgroup[i].state = SPDK_NVMF_SUBSYSTEM_ACTIVE;
+		group[i].sgroups = &sgroup[i];
+		group[i].num_sgroups = 1;
+	}
+
+	subsystem.thread = thread;
+	ctrlr.subsys = &subsystem;
+	ctrlr.qpair_mask = spdk_bit_array_create(2);
+	SPDK_CU_ASSERT_FATAL(ctrlr.qpair_mask != NULL);
+	spdk_bit_array_set(ctrlr.qpair_mask, 1);
+	qpair.transport = &transport;
+	qpair.ctrlr = &ctrlr;
+	qpair.qid = 1;
+	qpair.group = &group[0];
+	qpair.state = SPDK_NVMF_QPAIR_ACTIVE;
+	qpair.connect_received = true;
+	TAILQ_INIT(&qpair.outstanding);
+	TAILQ_INSERT_TAIL(&group[0].qpairs, &qpair, link);
+	group[0].stat.current_io_qpairs = 1;
+
+	/* Admin qpairs stay on the controller thread */
+	qpair.qid = 0;
+	rc = spdk_nvmf_poll_group_migrate_qpair(&qpair, &group[1], migrate_done, NULL);
+	CU_ASSERT(rc == -EINVAL);
+	qpair.qid = 1;
+
+	rc = spdk_nvmf_poll_group_migrate_qpair(&qpair, &group[0], migrate_done, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
+	MOCK_SET(nvmf_transport_qpair_can_migrate, false);
+	rc = spdk_nvmf_poll_group_migrate_qpair(&qpair, &group[1], migrate_done, NULL);
+	CU_ASSERT(rc == -ENOTSUP);
+	MOCK_SET(nvmf_transport_qpair_can_migrate, true);
+
+	/* Move the qpair once the transport is done with its requests */
+	rc = spdk_nvmf_poll_group_migrate_qpair(&qpair, &group[1], migrate_done, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(qpair.migrating);
+	SPDK_CU_ASSERT_FATAL(g_quiesce_cb_fn != NULL);
+	rc = spdk_nvmf_poll_group_migrate_qpair(&qpair, &group[1], migrate_done, NULL);
+	CU_ASSERT(rc == -EBUSY);
+
+	g_quiesce_cb_fn(g_quiesce_cb_arg, 0);
+	CU_ASSERT(TAILQ_EMPTY(&group[0].qpairs));
+	CU_ASSERT(group[0].stat.current_io_qpairs == 0);
+	CU_ASSERT(qpair.group == &group[1]);
+	CU_ASSERT(qpair.migrate_detached);
+
+	/* Disconnects are held until the qpair is added to the new poll group */
+	rc = spdk_nvmf_qpair_disconnect(&qpair, NULL, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(qpair.state == SPDK_NVMF_QPAIR_ACTIVE);
+	CU_ASSERT(!qpair.disconnect_started);
+
+	/* Run only the message adding the qpair to the new poll group */
+	spdk_thread_poll(thread, 1, 0);
+	CU_ASSERT(TAILQ_FIRST(&group[1].qpairs) == &qpair);
+	CU_ASSERT(group[1].stat.current_io_qpairs == 1);
+	CU_ASSERT(!qpair.migrate_detached);
+	CU_ASSERT(!qpair.migrating);
+
+	while (spdk_thread_poll(thread, 0, 0) > 0) {}
+	CU_ASSERT(g_migrate_done);
+	CU_ASSERT(g_migrate_status == 0);
+	/* Then disconnected from the new poll group */
+	CU_ASSERT(qpair.state == SPDK_NVMF_QPAIR_ERROR);
+	CU_ASSERT(qpair.group == NULL);
+	CU_ASSERT(TAILQ_EMPTY(&group[1].qpairs));
+
+	/* A qpair disconnected while quiescing isn't moved */
+	qpair.state = SPDK_NVMF_QPAIR_ACTIVE;
+	qpair.disconnect_started = false;
+	qpair.group = &group[1];
+	TAILQ_INSERT_TAIL(&group[1].qpairs, &qpair, link);
+	g_migrate_done = false;
+	g_quiesce_cb_fn = NULL;
+	rc = spdk_nvmf_poll_group_migrate_qpair(&qpair, &group[0], migrate_done, NULL);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_quiesce_cb_fn != NULL);
+	qpair.state = SPDK_NVMF_QPAIR_DEACTIVATING;
+	g_quiesce_cb_fn(g_quiesce_cb_arg, 0);
+	CU_ASSERT(g_migrate_done);
+	CU_ASSERT(g_migrate_status == -ECANCELED);
+	CU_ASSERT(!qpair.migrating);
+	CU_ASSERT(qpair.group == &group[1]);
+	CU_ASSERT(TAILQ_FIRST(&group[1].qpairs) == &qpair);
+
+	spdk_bit_array_free(&ctrlr.qpair_mask);
+	spdk_thread_exit(thread);
+	while (!spdk_thread_is_exited(thread)) {
+		spdk_thread_poll(thread, 0, 0);
+	}
+	spdk_thread_destroy(thread);
+}
+
+static void
+test_nvmf_tgt_rebalance_pick_qpair(void)
+{
+	struct spdk_nvmf_poll_group	group = {};
+	struct spdk_nvmf_ctrlr		ctrlr = {};
+	struct spdk_nvmf_qpair		qpair[4] = {};
+	uint64_t loads[4] = { 1000, 100, 450, 600 };
+	int i;
+
+	TAILQ_INIT(&group.qpairs);
+	for (i = 0; i < 4; i++) {
+		qpair[i].qid = i + 1;
+		qpair[i].ctrlr = &ctrlr;
+		qpair[i].state = SPDK_NVMF_QPAIR_ACTIVE;
+		qpair[i].rebalance_nvme_io = 50;
+		qpair[i].completed_nvme_io = 50 + loads[i];
+		TAILQ_INSERT_TAIL(&group.qpairs, &qpair[i], link);
+	}
+
+	/* The closest to half the gap */
+	CU_ASSERT(nvmf_tgt_rebalance_pick_qpair(&group, 1000) == &qpair[2]);
+	CU_ASSERT(nvmf_tgt_rebalance_pick_qpair(&group, 1300) == &qpair[3]);
+	/* Moving any of these would only move the imbalance */
+	CU_ASSERT(nvmf_tgt_rebalance_pick_qpair(&group, 100) == NULL);
+
+	/* Admin qpairs and qpairs being moved are skipped */
+	qpair[2].migrating = true;
+	CU_ASSERT(nvmf_tgt_rebalance_pick_qpair(&group, 1000) == &qpair[3]);
+	qpair[3].qid = 0;
+	CU_ASSERT(nvmf_tgt_rebalance_pick_qpair(&group, 1000) == &qpair[1]);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -224,6 +407,8 @@ main(int argc, char **argv)
 	suite = CU_add_suite("nvmf", NULL, NULL);
 
 	CU_ADD_TEST(suite, test_nvmf_tgt_create_poll_group);
+	CU_ADD_TEST(suite, test_nvmf_poll_group_migrate_qpair);
+	CU_ADD_TEST(suite, test_nvmf_tgt_rebalance_pick_qpair);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -48,11 +48,44 @@ DEFINE_STUB_V(spdk_nvme_trid_populate_transport, (struct spdk_nvme_transport_id
 		enum spdk_nvme_transport_type trtype));
 DEFINE_STUB_V(spdk_nvmf_tgt_new_qpair, (struct spdk_nvmf_tgt *tgt, struct spdk_nvmf_qpair *qpair));
 DEFINE_STUB(nvmf_ctrlr_abort_request, int, (struct spdk_nvmf_request *req), 0);
+DEFINE_STUB(nvmf_request_qos_admit, bool, (struct spdk_nvmf_request *req, bool force), true);
 DEFINE_STUB(spdk_nvme_transport_id_adrfam_str, const char *, (enum spdk_nvmf_adrfam adrfam), NULL);
 DEFINE_STUB(ibv_dereg_mr, int, (struct ibv_mr *mr), 0);
 DEFINE_STUB(ibv_resize_cq, int, (struct ibv_cq *cq, int cqe), 0);
 DEFINE_STUB(spdk_mempool_lookup, struct spdk_mempool *, (const char *name), NULL);
 
+static bool g_zcopy_enabled;
+static bool g_zcopy_start_called;
+static bool g_zcopy_end_called;
+
+bool
+nvmf_ctrlr_use_zcopy(struct spdk_nvmf_request *req)
+{
+	if (!g_zcopy_enabled) {
+		return false;
+	}
+
+	req->zcopy_phase = NVMF_ZCOPY_PHASE_INIT;
+	return true;
+}
+
+void
+spdk_nvmf_request_zcopy_start(struct spdk_nvmf_request *req)
+{
+	CU_ASSERT(req->zcopy_phase == NVMF_ZCOPY_PHASE_INIT);
+	g_zcopy_start_called = true;
+}
+
+void
+spdk_nvmf_request_zcopy_end(struct spdk_nvmf_request *req, bool commit)
+{
+	CU_ASSERT(req->zcopy_phase == NVMF_ZCOPY_PHASE_EXECUTE);
+	CU_ASSERT(!commit);
+	req->zcopy_phase = NVMF_ZCOPY_PHASE_COMPLETE;
+	req->zcopy_bdev_io = NULL;
+	g_zcopy_end_called = true;
+}
+
 /* ibv_reg_mr can be a macro, need to undefine it */
 #ifdef ibv_reg_mr
 #undef ibv_reg_mr
@@ -193,6 +226,7 @@ test_spdk_nvmf_rdma_request_parse_sgl(void)
 	rtransport.transport.opts = g_rdma_ut_transport_opts;
 	rtransport.data_wr_pool = NULL;
 	rtransport.transport.data_buf_pool = NULL;
+	rqpair.in_capsule_data_size = rtransport.transport.opts.in_capsule_data_size;
 
 	device.attr.device_cap_flags = 0;
 	sgl->keyed.key = 0xEEEE;
@@ -296,6 +330,17 @@ test_spdk_nvmf_rdma_request_parse_sgl(void)
 
 	CU_ASSERT(rc == -1);
 
+	/* Part 4: I/O fits in the transport in capsule data size, but not in the qpair's one */
+	reset_nvmf_rdma_request(&rdma_req);
+	rqpair.in_capsule_data_size = 1024;
+	sgl->address = 0;
+	sgl->unkeyed.length = 2048;
+	rc = nvmf_rdma_request_parse_sgl(&rtransport, &device, &rdma_req);
+
+	CU_ASSERT(rc == -1);
+	CU_ASSERT(cpl.nvme_cpl.status.sc == SPDK_NVME_SC_DATA_SGL_LENGTH_INVALID);
+	rqpair.in_capsule_data_size = rtransport.transport.opts.in_capsule_data_size;
+
 	/* Test 3: Multi SGL */
 	sgl->generic.type = SPDK_NVME_SGL_TYPE_LAST_SEGMENT;
 	sgl->unkeyed.subtype = SPDK_NVME_SGL_SUBTYPE_OFFSET;
@@ -618,6 +663,7 @@ test_spdk_nvmf_rdma_request_process(void)
 
 	STAILQ_INIT(&group.group.buf_cache);
 	STAILQ_INIT(&group.group.pending_buf_queue);
+	STAILQ_INIT(&group.group.pending_qos_queue);
 	group.group.buf_cache_size = 0;
 	group.group.buf_cache_count = 0;
 	poller_reset(&poller, &group);
@@ -784,6 +830,151 @@ test_spdk_nvmf_rdma_request_process(void)
 	spdk_mempool_free(rtransport.data_wr_pool);
 }
 
+static void
+test_nvmf_rdma_request_process_zcopy(void)
+{
+	struct spdk_nvmf_rdma_transport rtransport = {};
+	struct spdk_nvmf_rdma_poll_group group = {};
+	struct spdk_nvmf_rdma_poller poller = {};
+	struct spdk_nvmf_rdma_device device = {};
+	struct spdk_nvmf_rdma_resources resources = {};
+	struct spdk_nvmf_rdma_qpair rqpair = {};
+	struct spdk_nvmf_rdma_recv *rdma_recv;
+	struct spdk_nvmf_rdma_request *rdma_req;
+	union nvmf_h2c_msg *cmd;
+	char bdev_buf[4096];
+
+	STAILQ_INIT(&group.group.buf_cache);
+	STAILQ_INIT(&group.group.pending_buf_queue);
+	STAILQ_INIT(&group.group.pending_qos_queue);
+	poller_reset(&poller, &group);
+	qpair_reset(&rqpair, &poller, &device, &resources, &rtransport.transport);
+
+	rtransport.transport.opts = g_rdma_ut_transport_opts;
+	g_zcopy_enabled = true;
+	rtransport.data_wr_pool = spdk_mempool_create("test_wr_pool", 128,
+				  sizeof(struct spdk_nvmf_rdma_request_data),
+				  0, 0);
+	MOCK_CLEAR(spdk_mempool_get);
+
+	/* Test 1: READ is written to the host straight from the bdev's buffer */
+	rdma_recv = create_recv(&rqpair, SPDK_NVME_OPC_READ);
+	cmd = (union nvmf_h2c_msg *)rdma_recv->sgl[0].addr;
+	cmd->nvme_cmd.dptr.sgl1.keyed.length = sizeof(bdev_buf);
+	rdma_req = create_req(&rqpair, rdma_recv);
+	rqpair.current_recv_depth = 1;
+	g_zcopy_start_called = false;
+	g_zcopy_end_called = false;
+	/* NEW -> AWAITING_ZCOPY_START */
+	nvmf_rdma_request_process(&rtransport, rdma_req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_AWAITING_ZCOPY_START);
+	CU_ASSERT(g_zcopy_start_called);
+	CU_ASSERT(!rdma_req->req.data_from_pool);
+	CU_ASSERT(STAILQ_EMPTY(&group.group.pending_buf_queue));
+	/* The bdev lends its buffer: AWAITING_ZCOPY_START -> TRANSFERRING_C2H */
+	rdma_req->req.zcopy_phase = NVMF_ZCOPY_PHASE_EXECUTE;
+	rdma_req->req.zcopy_bdev_io = (struct spdk_bdev_io *)0xDEADBEEF;
+	rdma_req->req.iov[0].iov_base = bdev_buf;
+	rdma_req->req.iov[0].iov_len = sizeof(bdev_buf);
+	rdma_req->req.iovcnt = 1;
+	nvmf_rdma_request_complete(&rdma_req->req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_TRANSFERRING_CONTROLLER_TO_HOST);
+	CU_ASSERT(rdma_req->data.wr.opcode == IBV_WR_RDMA_WRITE);
+	CU_ASSERT(rdma_req->data.wr.num_sge == 1);
+	CU_ASSERT(rdma_req->data.wr.sg_list[0].addr == (uintptr_t)bdev_buf);
+	CU_ASSERT(rdma_req->data.wr.sg_list[0].length == sizeof(bdev_buf));
+	CU_ASSERT(rdma_req->data.wr.sg_list[0].lkey == RDMA_UT_LKEY);
+	CU_ASSERT(rdma_req->data.wr.wr.rdma.rkey == 0xEEEE);
+	CU_ASSERT(rdma_req->num_outstanding_data_wr == 1);
+	CU_ASSERT(rdma_req->recv == NULL);
+	/* The buffer is only released once the data is written:
+	 * COMPLETED -> AWAITING_ZCOPY_RELEASE */
+	rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
+	nvmf_rdma_request_process(&rtransport, rdma_req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE);
+	CU_ASSERT(g_zcopy_end_called);
+	/* AWAITING_ZCOPY_RELEASE -> FREE */
+	nvmf_rdma_request_complete(&rdma_req->req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_FREE);
+	CU_ASSERT(rdma_req->req.zcopy_phase == NVMF_ZCOPY_PHASE_NONE);
+
+	free_recv(rdma_recv);
+	free_req(rdma_req);
+	poller_reset(&poller, &group);
+	qpair_reset(&rqpair, &poller, &device, &resources, &rtransport.transport);
+
+	/* Test 2: zcopy_start fails, only the response is sent */
+	rdma_recv = create_recv(&rqpair, SPDK_NVME_OPC_READ);
+	rdma_req = create_req(&rqpair, rdma_recv);
+	rqpair.current_recv_depth = 1;
+	g_zcopy_end_called = false;
+	nvmf_rdma_request_process(&rtransport, rdma_req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_AWAITING_ZCOPY_START);
+	rdma_req->req.zcopy_phase = NVMF_ZCOPY_PHASE_INIT_FAILED;
+	rdma_req->req.rsp->nvme_cpl.status.sc = SPDK_NVME_SC_LBA_OUT_OF_RANGE;
+	nvmf_rdma_request_complete(&rdma_req->req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_COMPLETING);
+	rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
+	nvmf_rdma_request_process(&rtransport, rdma_req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_FREE);
+	CU_ASSERT(!g_zcopy_end_called);
+
+	free_recv(rdma_recv);
+	free_req(rdma_req);
+	poller_reset(&poller, &group);
+	qpair_reset(&rqpair, &poller, &device, &resources, &rtransport.transport);
+
+	/* Test 3: the bdev's buffer has no memory translation, fail the request and release it */
+	rdma_recv = create_recv(&rqpair, SPDK_NVME_OPC_READ);
+	rdma_req = create_req(&rqpair, rdma_recv);
+	rqpair.current_recv_depth = 1;
+	g_zcopy_end_called = false;
+	nvmf_rdma_request_process(&rtransport, rdma_req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_AWAITING_ZCOPY_START);
+	rdma_req->req.zcopy_phase = NVMF_ZCOPY_PHASE_EXECUTE;
+	rdma_req->req.zcopy_bdev_io = (struct spdk_bdev_io *)0xDEADBEEF;
+	rdma_req->req.iov[0].iov_base = bdev_buf;
+	rdma_req->req.iov[0].iov_len = sizeof(bdev_buf);
+	rdma_req->req.iovcnt = 1;
+	MOCK_SET(spdk_rdma_get_translation, -EINVAL);
+	nvmf_rdma_request_complete(&rdma_req->req);
+	MOCK_CLEAR(spdk_rdma_get_translation);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_COMPLETING);
+	CU_ASSERT(rdma_req->req.rsp->nvme_cpl.status.sc == SPDK_NVME_SC_INTERNAL_DEVICE_ERROR);
+	rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
+	nvmf_rdma_request_process(&rtransport, rdma_req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_AWAITING_ZCOPY_RELEASE);
+	CU_ASSERT(g_zcopy_end_called);
+	nvmf_rdma_request_complete(&rdma_req->req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_FREE);
+
+	free_recv(rdma_recv);
+	free_req(rdma_req);
+	poller_reset(&poller, &group);
+	qpair_reset(&rqpair, &poller, &device, &resources, &rtransport.transport);
+
+	/* Test 4: WRITE doesn't use zero-copy */
+	rtransport.transport.data_buf_pool = spdk_mempool_create("test_data_pool", 16, 128, 0, 0);
+	rdma_recv = create_recv(&rqpair, SPDK_NVME_OPC_WRITE);
+	rdma_req = create_req(&rqpair, rdma_recv);
+	rqpair.current_recv_depth = 1;
+	g_zcopy_start_called = false;
+	nvmf_rdma_request_process(&rtransport, rdma_req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_TRANSFERRING_HOST_TO_CONTROLLER);
+	CU_ASSERT(!spdk_nvmf_request_using_zcopy(&rdma_req->req));
+	CU_ASSERT(!g_zcopy_start_called);
+	rdma_req->state = RDMA_REQUEST_STATE_COMPLETED;
+	nvmf_rdma_request_process(&rtransport, rdma_req);
+	CU_ASSERT(rdma_req->state == RDMA_REQUEST_STATE_FREE);
+
+	free_recv(rdma_recv);
+	free_req(rdma_req);
+
+	g_zcopy_enabled = false;
+	spdk_mempool_free(rtransport.transport.data_buf_pool);
+	spdk_mempool_free(rtransport.data_wr_pool);
+}
+
 #define TEST_GROUPS_COUNT 5
 static void
 test_nvmf_rdma_get_optimal_poll_group(void)
@@ -864,6 +1055,73 @@ test_nvmf_rdma_get_optimal_poll_group(void)
 }
 #undef TEST_GROUPS_COUNT
 
+#define TEST_GROUPS_COUNT 4
+static void
+test_nvmf_rdma_get_optimal_poll_group_numa(void)
+{
+	struct spdk_nvmf_rdma_transport rtransport = {};
+	struct spdk_nvmf_transport *transport = &rtransport.transport;
+	struct spdk_nvmf_rdma_qpair rqpair = {};
+	struct spdk_nvmf_rdma_device device = {};
+	struct spdk_nvmf_transport_poll_group *groups[TEST_GROUPS_COUNT];
+	struct spdk_nvmf_poll_group group[TEST_GROUPS_COUNT] = {};
+	struct spdk_nvmf_transport_poll_group *result;
+	uint32_t i;
+
+	rqpair.qpair.transport = transport;
+	rqpair.qpair.qid = 1;
+	rqpair.device = &device;
+	rtransport.rdma_opts.numa_aware_placement = true;
+	TAILQ_INIT(&rtransport.poll_groups);
+
+	/* Poll groups 0 and 2 run on NUMA node 0, 1 and 3 on node 1 */
+	for (i = 0; i < TEST_GROUPS_COUNT; i++) {
+		MOCK_SET(spdk_env_get_socket_id, i % 2);
+		groups[i] = nvmf_rdma_poll_group_create(transport, NULL);
+		SPDK_CU_ASSERT_FATAL(groups[i] != NULL);
+		pthread_mutex_init(&group[i].mutex, NULL);
+		groups[i]->group = &group[i];
+		groups[i]->transport = transport;
+	}
+	MOCK_CLEAR(spdk_env_get_socket_id);
+
+	/* I/O qpairs of a device on node 1 only go to the poll groups on node 1 */
+	device.numa_id = 1;
+	result = nvmf_rdma_get_optimal_poll_group(&rqpair.qpair);
+	CU_ASSERT(result == groups[1]);
+	result = nvmf_rdma_get_optimal_poll_group(&rqpair.qpair);
+	CU_ASSERT(result == groups[3]);
+	result = nvmf_rdma_get_optimal_poll_group(&rqpair.qpair);
+	CU_ASSERT(result == groups[1]);
+
+	/* The least loaded one is picked */
+	group[1].stat.current_io_qpairs = 2;
+	group[3].stat.current_io_qpairs = 1;
+	result = nvmf_rdma_get_optimal_poll_group(&rqpair.qpair);
+	CU_ASSERT(result == groups[3]);
+	group[1].stat.current_io_qpairs = 0;
+	group[3].stat.current_io_qpairs = 0;
+
+	/* No poll group local to the device, fall back to all of them */
+	device.numa_id = 2;
+	result = nvmf_rdma_get_optimal_poll_group(&rqpair.qpair);
+	CU_ASSERT(result == groups[0]);
+
+	/* Admin qpairs are still distributed over all the poll groups */
+	device.numa_id = 1;
+	rqpair.qpair.qid = 0;
+	for (i = 0; i < TEST_GROUPS_COUNT; i++) {
+		result = nvmf_rdma_get_optimal_poll_group(&rqpair.qpair);
+		CU_ASSERT(result == groups[i]);
+	}
+
+	for (i = 0; i < TEST_GROUPS_COUNT; i++) {
+		nvmf_rdma_poll_group_destroy(groups[i]);
+		pthread_mutex_destroy(&group[i].mutex);
+	}
+}
+#undef TEST_GROUPS_COUNT
+
 static void
 test_spdk_nvmf_rdma_request_parse_sgl_with_md(void)
 {
@@ -1507,6 +1765,131 @@ test_nvmf_rdma_resize_cq(void)
 	CU_ASSERT(rpoller.num_cqe > tnum_cqe);
 }
 
+static int
+ut_parse_listen_opts(struct spdk_nvmf_transport *transport, const char *str,
+		     struct rdma_listen_opts *opts)
+{
+	struct spdk_nvmf_listen_opts listen_opts = {};
+	struct spdk_json_val values[16];
+	char json[64];
+	ssize_t rc;
+
+	snprintf(json, sizeof(json), "%s", str);
+	rc = spdk_json_parse(json, strlen(json), values, SPDK_COUNTOF(values), NULL, 0);
+	SPDK_CU_ASSERT_FATAL(rc > 0);
+	listen_opts.transport_specific = values;
+
+	return nvmf_rdma_parse_listen_opts(transport, &listen_opts, opts);
+}
+
+static void
+test_nvmf_rdma_parse_listen_opts(void)
+{
+	struct spdk_nvmf_transport transport = {};
+	struct spdk_nvmf_listen_opts listen_opts = {};
+	struct rdma_listen_opts opts;
+
+	transport.opts = g_rdma_ut_transport_opts;
+
+	/* Without listen opts, the transport in-capsule data size is used */
+	CU_ASSERT(nvmf_rdma_parse_listen_opts(&transport, NULL, &opts) == 0);
+	CU_ASSERT(opts.in_capsule_data_size == transport.opts.in_capsule_data_size);
+	CU_ASSERT(nvmf_rdma_parse_listen_opts(&transport, &listen_opts, &opts) == 0);
+	CU_ASSERT(opts.in_capsule_data_size == transport.opts.in_capsule_data_size);
+
+	/* Other params of the RPC are ignored */
+	CU_ASSERT(ut_parse_listen_opts(&transport, "{\"nqn\": \"nqn.ut\"}",
+				       &opts) == 0);
+	CU_ASSERT(opts.in_capsule_data_size == transport.opts.in_capsule_data_size);
+
+	CU_ASSERT(ut_parse_listen_opts(&transport,
+				       "{\"nqn\": \"nqn.ut\", \"in_capsule_data_size\": 1024}",
+				       &opts) == 0);
+	CU_ASSERT(opts.in_capsule_data_size == 1024);
+
+	/* Below the size of the SGL descriptors */
+	CU_ASSERT(ut_parse_listen_opts(&transport, "{\"in_capsule_data_size\": 128}",
+				       &opts) == -EINVAL);
+
+	/* Above the transport in-capsule data size */
+	CU_ASSERT(ut_parse_listen_opts(&transport, "{\"in_capsule_data_size\": 8192}",
+				       &opts) == -EINVAL);
+
+	/* Not a multiple of 16 */
+	CU_ASSERT(ut_parse_listen_opts(&transport, "{\"in_capsule_data_size\": 1000}",
+				       &opts) == -EINVAL);
+
+	CU_ASSERT(ut_parse_listen_opts(&transport, "{\"in_capsule_data_size\": \"big\"}",
+				       &opts) == -EINVAL);
+}
+
+static void
+test_nvmf_rdma_poller_get_srq(void)
+{
+	struct spdk_nvmf_rdma_transport rtransport = {};
+	struct spdk_nvmf_rdma_poller poller = {};
+	struct spdk_nvmf_rdma_device device = {};
+	struct ibv_context context = {};
+	struct ibv_device idevice = {};
+	struct spdk_nvmf_rdma_qpair rqpair1 = {}, rqpair2 = {};
+	struct spdk_nvmf_rdma_resources resources = {};
+	struct spdk_rdma_srq srq = {};
+	struct spdk_nvmf_rdma_poller_srq *psrq;
+
+	rtransport.transport.opts = g_rdma_ut_transport_opts;
+	context.device = &idevice;
+	idevice.transport_type = IBV_TRANSPORT_IB;
+	device.context = &context;
+	device.attr.max_srq = 2;
+	device.attr.max_cqe = 1024;
+	device.num_srq = 1;
+	poller.device = &device;
+	poller.srq = &srq;
+	poller.resources = &resources;
+	poller.max_srq_depth = 16;
+	poller.num_cqe = 48;
+	poller.required_num_wr = 48;
+	STAILQ_INIT(&poller.srqs);
+
+	/* The transport in-capsule data size uses the default SRQ */
+	rqpair1.in_capsule_data_size = rtransport.transport.opts.in_capsule_data_size;
+	nvmf_rdma_poller_get_srq(&rtransport, &poller, &rqpair1);
+	CU_ASSERT(rqpair1.srq == &srq);
+	CU_ASSERT(rqpair1.resources == &resources);
+	CU_ASSERT(STAILQ_EMPTY(&poller.srqs));
+
+	/* A smaller one gets an SRQ of its own, the CQ is enlarged for it */
+	rqpair1.in_capsule_data_size = 1024;
+	nvmf_rdma_poller_get_srq(&rtransport, &poller, &rqpair1);
+	psrq = STAILQ_FIRST(&poller.srqs);
+	SPDK_CU_ASSERT_FATAL(psrq != NULL);
+	CU_ASSERT(psrq->in_capsule_data_size == 1024);
+	CU_ASSERT(rqpair1.srq == psrq->srq);
+	CU_ASSERT(rqpair1.resources == psrq->resources);
+	CU_ASSERT(psrq->resources->recvs[0].sgl[1].length == 1024);
+	CU_ASSERT(psrq->resources->recvs[0].srq == psrq->srq);
+	CU_ASSERT(poller.required_num_wr == 96);
+	CU_ASSERT(poller.num_cqe == 96);
+	CU_ASSERT(device.num_srq == 2);
+
+	/* Another qpair of the same size shares it */
+	rqpair2.in_capsule_data_size = 1024;
+	nvmf_rdma_poller_get_srq(&rtransport, &poller, &rqpair2);
+	CU_ASSERT(rqpair2.srq == psrq->srq);
+	CU_ASSERT(rqpair2.resources == psrq->resources);
+	CU_ASSERT(STAILQ_NEXT(psrq, link) == NULL);
+
+	/* Out of SRQs on the device, the default SRQ is used */
+	rqpair2.in_capsule_data_size = 512;
+	nvmf_rdma_poller_get_srq(&rtransport, &poller, &rqpair2);
+	CU_ASSERT(rqpair2.srq == &srq);
+	CU_ASSERT(rqpair2.resources == &resources);
+	CU_ASSERT(STAILQ_NEXT(psrq, link) == NULL);
+
+	STAILQ_REMOVE_HEAD(&poller.srqs, link);
+	nvmf_rdma_poller_srq_destroy(psrq);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1520,7 +1903,9 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, test_spdk_nvmf_rdma_request_parse_sgl);
 	CU_ADD_TEST(suite, test_spdk_nvmf_rdma_request_process);
+	CU_ADD_TEST(suite, test_nvmf_rdma_request_process_zcopy);
 	CU_ADD_TEST(suite, test_nvmf_rdma_get_optimal_poll_group);
+	CU_ADD_TEST(suite, test_nvmf_rdma_get_optimal_poll_group_numa);
 	CU_ADD_TEST(suite, test_spdk_nvmf_rdma_request_parse_sgl_with_md);
 	CU_ADD_TEST(suite, test_nvmf_rdma_opts_init);
 	CU_ADD_TEST(suite, test_nvmf_rdma_request_free_data);
@@ -1528,6 +1913,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_rdma_resources_create);
 	CU_ADD_TEST(suite, test_nvmf_rdma_qpair_compare);
 	CU_ADD_TEST(suite, test_nvmf_rdma_resize_cq);
+	CU_ADD_TEST(suite, test_nvmf_rdma_parse_listen_opts);
+	CU_ADD_TEST(suite, test_nvmf_rdma_poller_get_srq);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -78,6 +78,7 @@ DEFINE_STUB(spdk_bdev_is_zoned, bool,
 
 DEFINE_STUB(spdk_bdev_get_max_zone_append_size, uint32_t,
 	    (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB_V(spdk_unaffinitize_thread, (void));
 
 int
 spdk_nvmf_transport_listen(struct spdk_nvmf_transport *transport,
@@ -514,6 +515,7 @@ ut_reservation_init(void)
 
 	memset(&g_ns, 0, sizeof(g_ns));
 	TAILQ_INIT(&g_ns.registrants);
+	TAILQ_INIT(&g_ns.ptpl_waiters);
 	g_ns.subsystem = &g_subsystem;
 	g_ns.ptpl_file = NULL;
 	g_ns.ptpl_activated = false;
@@ -547,6 +549,16 @@ ut_reservation_init(void)
 	TAILQ_INSERT_TAIL(&g_subsystem.ctrlrs, &g_ctrlr_C, link);
 }
 
+/* Write the reservation changes to the PTPL file and wait for it */
+static void
+ut_reservation_flush_ptpl(void)
+{
+	nvmf_ns_ptpl_flush(&g_ns);
+	while (g_ns.ptpl_write != NULL) {
+		poll_threads();
+	}
+}
+
 static void
 ut_reservation_deinit(void)
 {
@@ -582,6 +594,8 @@ ut_reservation_deinit(void)
 	TAILQ_FOREACH_SAFE(ctrlr, &g_subsystem.ctrlrs, link, ctrlr_tmp) {
 		TAILQ_REMOVE(&g_subsystem.ctrlrs, ctrlr, link);
 	}
+
+	nvmf_ptpl_worker_stop();
 }
 
 static struct spdk_nvmf_request *
@@ -857,6 +871,7 @@ test_reservation_register_with_ptpl(void)
 	SPDK_CU_ASSERT_FATAL(reg != NULL);
 	SPDK_CU_ASSERT_FATAL(!spdk_uuid_compare(&g_ctrlr1_A.hostid, &reg->hostid));
 	/* Load reservation information from configuration file */
+	ut_reservation_flush_ptpl();
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
@@ -870,6 +885,7 @@ test_reservation_register_with_ptpl(void)
 	SPDK_CU_ASSERT_FATAL(update_sgroup == true);
 	SPDK_CU_ASSERT_FATAL(rsp->status.sc == SPDK_NVME_SC_SUCCESS);
 	SPDK_CU_ASSERT_FATAL(g_ns.ptpl_activated == false);
+	ut_reservation_flush_ptpl();
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc < 0);
 	unlink(g_ns.ptpl_file);
@@ -978,6 +994,7 @@ test_reservation_acquire_release_with_ptpl(void)
 	SPDK_CU_ASSERT_FATAL(reg != NULL);
 	SPDK_CU_ASSERT_FATAL(!spdk_uuid_compare(&g_ctrlr1_A.hostid, &reg->hostid));
 	/* Load reservation information from configuration file */
+	ut_reservation_flush_ptpl();
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
@@ -990,6 +1007,7 @@ test_reservation_acquire_release_with_ptpl(void)
 	update_sgroup = nvmf_ns_reservation_acquire(&g_ns, &g_ctrlr1_A, req);
 	SPDK_CU_ASSERT_FATAL(update_sgroup == true);
 	SPDK_CU_ASSERT_FATAL(rsp->status.sc == SPDK_NVME_SC_SUCCESS);
+	ut_reservation_flush_ptpl();
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
@@ -1006,6 +1024,7 @@ test_reservation_acquire_release_with_ptpl(void)
 	update_sgroup = nvmf_ns_reservation_release(&g_ns, &g_ctrlr1_A, req);
 	SPDK_CU_ASSERT_FATAL(update_sgroup == true);
 	SPDK_CU_ASSERT_FATAL(rsp->status.sc == SPDK_NVME_SC_SUCCESS);
+	ut_reservation_flush_ptpl();
 	memset(&info, 0, sizeof(info));
 	rc = nvmf_ns_load_reservation(g_ns.ptpl_file, &info);
 	SPDK_CU_ASSERT_FATAL(rc == 0);
@@ -1439,6 +1458,7 @@ test_nvmf_subsystem_add_ctrlr(void)
 {
 	int rc;
 	struct spdk_nvmf_ctrlr ctrlr = {};
+	struct spdk_nvmf_ctrlr ctrlr2 = {};
 	struct spdk_nvmf_tgt tgt = {};
 	char nqn[256] = "nqn.2016-06.io.spdk:subsystem1";
 	struct spdk_nvmf_subsystem *subsystem = NULL;
@@ -1458,7 +1478,23 @@ test_nvmf_subsystem_add_ctrlr(void)
 	CU_ASSERT(ctrlr.cntlid == 1);
 	CU_ASSERT(nvmf_subsystem_get_ctrlr(subsystem, 1) == &ctrlr);
 
+	/* Both controllers land in the same hash bucket */
+	ctrlr2.subsys = subsystem;
+	ctrlr2.cntlid = 1 + NVMF_SUBSYSTEM_CTRLR_HASH_SIZE;
+	rc = nvmf_subsystem_add_ctrlr(subsystem, &ctrlr2);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(nvmf_subsystem_get_ctrlr(subsystem, 1) == &ctrlr);
+	CU_ASSERT(nvmf_subsystem_get_ctrlr(subsystem, ctrlr2.cntlid) == &ctrlr2);
+	CU_ASSERT(nvmf_subsystem_get_ctrlr(subsystem, 2) == NULL);
+
+	/* Static cntlid already in use */
+	rc = nvmf_subsystem_add_ctrlr(subsystem, &ctrlr2);
+	CU_ASSERT(rc == -EEXIST);
+
 	nvmf_subsystem_remove_ctrlr(subsystem, &ctrlr);
+	CU_ASSERT(nvmf_subsystem_get_ctrlr(subsystem, 1) == NULL);
+	CU_ASSERT(nvmf_subsystem_get_ctrlr(subsystem, ctrlr2.cntlid) == &ctrlr2);
+	nvmf_subsystem_remove_ctrlr(subsystem, &ctrlr2);
 	CU_ASSERT(TAILQ_EMPTY(&subsystem->ctrlrs));
 	rc = spdk_nvmf_subsystem_destroy(subsystem, test_nvmf_subsystem_destroy_cb, NULL);
 	CU_ASSERT(rc == 0);
@@ -1763,6 +1799,54 @@ test_nvmf_subsystem_state_change(void)
 	free(tgt.subsystems);
 }
 
+static void
+test_nvmf_ns_qos_rate_limits(void)
+{
+	struct spdk_nvmf_ns ns = {};
+	uint64_t limits[SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES] = {};
+	uint64_t tmp[SPDK_NVMF_NS_QOS_NUM_RATE_LIMIT_TYPES];
+	int rc;
+
+	/* Disabling QoS that was never enabled */
+	rc = spdk_nvmf_ns_set_qos_rate_limits(&ns, limits);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ns.qos == NULL);
+	spdk_nvmf_ns_get_qos_rate_limits(&ns, tmp);
+	CU_ASSERT(memcmp(tmp, limits, sizeof(limits)) == 0);
+
+	/* Out of range bandwidth */
+	limits[SPDK_NVMF_NS_QOS_R_BPS_RATE_LIMIT] = UINT64_MAX;
+	rc = spdk_nvmf_ns_set_qos_rate_limits(&ns, limits);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(ns.qos == NULL);
+
+	limits[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT] = 500;
+	limits[SPDK_NVMF_NS_QOS_R_BPS_RATE_LIMIT] = 10;
+	rc = spdk_nvmf_ns_set_qos_rate_limits(&ns, limits);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(ns.qos != NULL);
+	spdk_nvmf_ns_get_qos_rate_limits(&ns, tmp);
+	CU_ASSERT(memcmp(tmp, limits, sizeof(limits)) == 0);
+	/* At least an IO is allowed in each 1ms timeslice */
+	CU_ASSERT(ns.qos->max_per_timeslice[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT] == 1);
+	CU_ASSERT(ns.qos->max_per_timeslice[SPDK_NVMF_NS_QOS_R_BPS_RATE_LIMIT] ==
+		  10 * 1024 * 1024 / 1000);
+	CU_ASSERT(ns.qos->remaining_this_timeslice[SPDK_NVMF_NS_QOS_R_BPS_RATE_LIMIT] ==
+		  10 * 1024 * 1024 / 1000);
+	CU_ASSERT(ns.qos->max_per_timeslice[SPDK_NVMF_NS_QOS_W_BPS_RATE_LIMIT] == 0);
+
+	/* Disabled QoS keeps its context, the poll groups may still be looking at it */
+	memset(limits, 0, sizeof(limits));
+	rc = spdk_nvmf_ns_set_qos_rate_limits(&ns, limits);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(ns.qos != NULL);
+	CU_ASSERT(ns.qos->max_per_timeslice[SPDK_NVMF_NS_QOS_RW_IOPS_RATE_LIMIT] == 0);
+	spdk_nvmf_ns_get_qos_rate_limits(&ns, tmp);
+	CU_ASSERT(memcmp(tmp, limits, sizeof(limits)) == 0);
+
+	free(ns.qos);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1795,6 +1879,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_valid_nqn);
 	CU_ADD_TEST(suite, test_nvmf_ns_reservation_restore);
 	CU_ADD_TEST(suite, test_nvmf_subsystem_state_change);
+	CU_ADD_TEST(suite, test_nvmf_ns_qos_rate_limits);
 
 	allocate_threads(1);
 	set_thread(0);
@@ -214,6 +214,9 @@ DEFINE_STUB_V(spdk_nvmf_tgt_new_qpair, (struct spdk_nvmf_tgt *tgt, struct spdk_n
 DEFINE_STUB_V(nvmf_transport_qpair_abort_request,
 	      (struct spdk_nvmf_qpair *qpair, struct spdk_nvmf_request *req));
 
+DEFINE_STUB(nvmf_transport_qpair_get_in_capsule_data_size, uint32_t,
+	    (struct spdk_nvmf_qpair *qpair), UINT32_MAX);
+
 DEFINE_STUB_V(spdk_nvme_print_command, (uint16_t qid, struct spdk_nvme_cmd *cmd));
 DEFINE_STUB_V(spdk_nvme_print_completion, (uint16_t qid, struct spdk_nvme_cpl *cpl));
 
@@ -234,6 +237,7 @@ DEFINE_STUB(spdk_bdev_get_max_open_zones, uint32_t,
 	    (const struct spdk_bdev *bdev), 0);
 DEFINE_STUB(spdk_bdev_is_zoned, bool, (const struct spdk_bdev *bdev), false);
 DEFINE_STUB(spdk_bdev_get_zone_size, uint64_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB(spdk_bdev_get_block_size, uint32_t, (const struct spdk_bdev *bdev), 512);
 
 DEFINE_STUB(spdk_nvme_ns_get_format_index, uint32_t,
 	    (const struct spdk_nvme_ns_data *nsdata), 0);
@@ -685,6 +689,7 @@ test_nvmf_tcp_in_capsule_data_handle(void)
 	group = &tcp_group.group;
 	group->transport = &ttransport.transport;
 	STAILQ_INIT(&group->pending_buf_queue);
+	STAILQ_INIT(&group->pending_qos_queue);
 	tqpair.group = &tcp_group;
 
 	TAILQ_INIT(&tqpair.tcp_req_free_queue);
@@ -752,7 +757,12 @@ test_nvmf_tcp_qpair_init_mem_resource(void)
 {
 	int rc;
 	struct spdk_nvmf_tcp_qpair *tqpair = NULL;
-	struct spdk_nvmf_transport transport = {};
+	struct spdk_nvmf_tcp_transport ttransport = {};
+	struct spdk_nvmf_transport *transport = &ttransport.transport;
+	struct spdk_nvmf_tcp_poll_group tgroup = {};
+	struct spdk_nvmf_tcp_req *tcp_req;
+	void *buf;
+	uint32_t i;
 	struct spdk_thread *thread;
 
 	thread = spdk_thread_create(NULL, NULL);
@@ -760,20 +770,20 @@ test_nvmf_tcp_qpair_init_mem_resource(void)
 	spdk_set_thread(thread);
 
 	tqpair = calloc(1, sizeof(*tqpair));
-	tqpair->qpair.transport = &transport;
-
-	nvmf_tcp_opts_init(&transport.opts);
-	CU_ASSERT(transport.opts.max_queue_depth == SPDK_NVMF_TCP_DEFAULT_MAX_IO_QUEUE_DEPTH);
-	CU_ASSERT(transport.opts.max_qpairs_per_ctrlr == SPDK_NVMF_TCP_DEFAULT_MAX_QPAIRS_PER_CTRLR);
-	CU_ASSERT(transport.opts.in_capsule_data_size == SPDK_NVMF_TCP_DEFAULT_IN_CAPSULE_DATA_SIZE);
-	CU_ASSERT(transport.opts.max_io_size ==	SPDK_NVMF_TCP_DEFAULT_MAX_IO_SIZE);
-	CU_ASSERT(transport.opts.io_unit_size == SPDK_NVMF_TCP_DEFAULT_IO_UNIT_SIZE);
-	CU_ASSERT(transport.opts.max_aq_depth == SPDK_NVMF_TCP_DEFAULT_MAX_ADMIN_QUEUE_DEPTH);
-	CU_ASSERT(transport.opts.num_shared_buffers == SPDK_NVMF_TCP_DEFAULT_NUM_SHARED_BUFFERS);
-	CU_ASSERT(transport.opts.buf_cache_size == SPDK_NVMF_TCP_DEFAULT_BUFFER_CACHE_SIZE);
-	CU_ASSERT(transport.opts.dif_insert_or_strip ==	SPDK_NVMF_TCP_DEFAULT_DIF_INSERT_OR_STRIP);
-	CU_ASSERT(transport.opts.abort_timeout_sec == SPDK_NVMF_TCP_DEFAULT_ABORT_TIMEOUT_SEC);
-	CU_ASSERT(transport.opts.transport_specific == NULL);
+	tqpair->qpair.transport = transport;
+
+	nvmf_tcp_opts_init(&transport->opts);
+	CU_ASSERT(transport->opts.max_queue_depth == SPDK_NVMF_TCP_DEFAULT_MAX_IO_QUEUE_DEPTH);
+	CU_ASSERT(transport->opts.max_qpairs_per_ctrlr == SPDK_NVMF_TCP_DEFAULT_MAX_QPAIRS_PER_CTRLR);
+	CU_ASSERT(transport->opts.in_capsule_data_size == SPDK_NVMF_TCP_DEFAULT_IN_CAPSULE_DATA_SIZE);
+	CU_ASSERT(transport->opts.max_io_size ==	SPDK_NVMF_TCP_DEFAULT_MAX_IO_SIZE);
+	CU_ASSERT(transport->opts.io_unit_size == SPDK_NVMF_TCP_DEFAULT_IO_UNIT_SIZE);
+	CU_ASSERT(transport->opts.max_aq_depth == SPDK_NVMF_TCP_DEFAULT_MAX_ADMIN_QUEUE_DEPTH);
+	CU_ASSERT(transport->opts.num_shared_buffers == SPDK_NVMF_TCP_DEFAULT_NUM_SHARED_BUFFERS);
+	CU_ASSERT(transport->opts.buf_cache_size == SPDK_NVMF_TCP_DEFAULT_BUFFER_CACHE_SIZE);
+	CU_ASSERT(transport->opts.dif_insert_or_strip ==	SPDK_NVMF_TCP_DEFAULT_DIF_INSERT_OR_STRIP);
+	CU_ASSERT(transport->opts.abort_timeout_sec == SPDK_NVMF_TCP_DEFAULT_ABORT_TIMEOUT_SEC);
+	CU_ASSERT(transport->opts.transport_specific == NULL);
 
 	rc = nvmf_tcp_qpair_init(&tqpair->qpair);
 	CU_ASSERT(rc == 0);
@@ -814,6 +824,229 @@ test_nvmf_tcp_qpair_init_mem_resource(void)
 	/* Free all of tqpair resource */
 	nvmf_tcp_qpair_destroy(tqpair);
 
+	/* The requests share a smaller number of in-capsule buffers */
+	ttransport.tcp_opts.in_capsule_buf_num = 4;
+	tqpair = calloc(1, sizeof(*tqpair));
+	SPDK_CU_ASSERT_FATAL(tqpair != NULL);
+	tqpair->qpair.transport = transport;
+	tqpair->group = &tgroup;
+	STAILQ_INIT(&tgroup.group.pending_buf_queue);
+	STAILQ_INIT(&tgroup.group.pending_qos_queue);
+
+	rc = nvmf_tcp_qpair_init(&tqpair->qpair);
+	CU_ASSERT(rc == 0);
+	rc = nvmf_tcp_qpair_init_mem_resource(tqpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(tqpair->bufs == NULL);
+	SPDK_CU_ASSERT_FATAL(tqpair->icd_buf_list != NULL);
+	CU_ASSERT(tqpair->reqs[0].buf == NULL);
+	CU_ASSERT(tqpair->reqs[127].buf == NULL);
+
+	for (i = 0; i < 4; i++) {
+		buf = nvmf_tcp_control_msg_get(tqpair->icd_buf_list);
+		CU_ASSERT(buf == (void *)((uintptr_t)tqpair->icd_buf_list->msg_buf + i * 4096));
+	}
+	CU_ASSERT(nvmf_tcp_control_msg_get(tqpair->icd_buf_list) == NULL);
+
+	/* Releasing a buffer moves the request waiting for one to the head of the queue */
+	STAILQ_INSERT_TAIL(&tgroup.group.pending_buf_queue, &tqpair->reqs[1].req, buf_link);
+	tcp_req = nvmf_tcp_req_get(tqpair);
+	SPDK_CU_ASSERT_FATAL(tcp_req != NULL);
+	nvmf_tcp_req_set_state(tcp_req, TCP_REQUEST_STATE_NEED_BUFFER);
+	STAILQ_INSERT_TAIL(&tgroup.group.pending_buf_queue, &tcp_req->req, buf_link);
+	tqpair->icd_buf_waiter = tcp_req;
+
+	nvmf_tcp_qpair_put_icd_buf(tqpair, buf);
+	CU_ASSERT(tqpair->icd_buf_waiter == NULL);
+	CU_ASSERT(STAILQ_FIRST(&tgroup.group.pending_buf_queue) == &tcp_req->req);
+	CU_ASSERT(nvmf_tcp_control_msg_get(tqpair->icd_buf_list) == buf);
+
+	STAILQ_INIT(&tgroup.group.pending_buf_queue);
+	STAILQ_INIT(&tgroup.group.pending_qos_queue);
+	nvmf_tcp_req_put(tqpair, tcp_req);
+	nvmf_tcp_qpair_destroy(tqpair);
+
+	spdk_thread_exit(thread);
+	while (!spdk_thread_is_exited(thread)) {
+		spdk_thread_poll(thread, 0, 0);
+	}
+	spdk_thread_destroy(thread);
+}
+
+static void
+ut_pdu_write_cb(void *cb_arg)
+{
+	int *count = cb_arg;
+
+	(*count)++;
+}
+
+static void
+test_nvmf_tcp_pdu_coalesce(void)
+{
+	int rc, count = 0;
+	struct spdk_nvmf_tcp_transport ttransport = {};
+	struct spdk_nvmf_tcp_poll_group tgroup = {};
+	struct spdk_nvmf_tcp_qpair *tqpair;
+	struct spdk_nvmf_tcp_send_buf *send_buf;
+	struct nvme_tcp_pdu *pdu;
+	struct spdk_thread *thread;
+	uint32_t i;
+
+	thread = spdk_thread_create(NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+	spdk_set_thread(thread);
+
+	nvmf_tcp_opts_init(&ttransport.transport.opts);
+	ttransport.tcp_opts.pdu_coalesce_size = 256;
+	TAILQ_INIT(&tgroup.send_pending);
+
+	tqpair = calloc(1, sizeof(*tqpair));
+	SPDK_CU_ASSERT_FATAL(tqpair != NULL);
+	tqpair->qpair.transport = &ttransport.transport;
+	TAILQ_INIT(&tqpair->tcp_req_free_queue);
+	TAILQ_INIT(&tqpair->tcp_req_working_queue);
+	rc = nvmf_tcp_qpair_init_mem_resource(tqpair);
+	CU_ASSERT(rc == 0);
+	send_buf = tqpair->send_buf;
+	SPDK_CU_ASSERT_FATAL(send_buf != NULL);
+	tqpair->group = &tgroup;
+
+	/* Capsule responses are copied into the send buffer */
+	for (i = 0; i < 2; i++) {
+		pdu = tqpair->reqs[i].pdu;
+		pdu->hdr.capsule_resp.common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_CAPSULE_RESP;
+		pdu->hdr.capsule_resp.common.hlen = sizeof(struct spdk_nvme_tcp_rsp);
+		pdu->hdr.capsule_resp.common.plen = sizeof(struct spdk_nvme_tcp_rsp);
+		pdu->hdr.capsule_resp.rccqe.cid = i;
+		nvmf_tcp_qpair_write_req_pdu(tqpair, &tqpair->reqs[i], ut_pdu_write_cb, &count);
+	}
+	CU_ASSERT(send_buf->len == 2 * sizeof(struct spdk_nvme_tcp_rsp));
+	CU_ASSERT(!send_buf->submitted);
+	CU_ASSERT(TAILQ_FIRST(&tgroup.send_pending) == tqpair);
+	CU_ASSERT(memcmp(send_buf->buf + sizeof(struct spdk_nvme_tcp_rsp),
+			 &tqpair->reqs[1].pdu->hdr.capsule_resp,
+			 sizeof(struct spdk_nvme_tcp_rsp)) == 0);
+
+	/* A larger PDU is written on its own, after the buffer is submitted */
+	pdu = tqpair->reqs[2].pdu;
+	pdu->hdr.c2h_data.common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_C2H_DATA;
+	pdu->hdr.c2h_data.common.hlen = sizeof(struct spdk_nvme_tcp_c2h_data_hdr);
+	pdu->hdr.c2h_data.common.plen = sizeof(struct spdk_nvme_tcp_c2h_data_hdr) + 4096;
+	pdu->data_len = 4096;
+	pdu->data_iov[0].iov_base = (void *)0xDEADBEEF;
+	pdu->data_iov[0].iov_len = 4096;
+	pdu->data_iovcnt = 1;
+	nvmf_tcp_qpair_write_req_pdu(tqpair, &tqpair->reqs[2], ut_pdu_write_cb, &count);
+	CU_ASSERT(send_buf->submitted);
+	CU_ASSERT(send_buf->iov.iov_len == 2 * sizeof(struct spdk_nvme_tcp_rsp));
+	CU_ASSERT(TAILQ_EMPTY(&tgroup.send_pending));
+	CU_ASSERT(count == 0);
+
+	/* Sending the buffer completes all of its PDUs */
+	_send_buf_write_done(send_buf, 0);
+	CU_ASSERT(count == 2);
+	CU_ASSERT(send_buf->len == 0);
+	CU_ASSERT(!send_buf->submitted);
+	CU_ASSERT(TAILQ_EMPTY(&send_buf->pdus));
+	CU_ASSERT(!tqpair->reqs[0].pdu_in_use);
+	CU_ASSERT(!tqpair->reqs[1].pdu_in_use);
+
+	tqpair->reqs[2].pdu_in_use = false;
+	nvmf_tcp_qpair_destroy(tqpair);
+
+	spdk_thread_exit(thread);
+	while (!spdk_thread_is_exited(thread)) {
+		spdk_thread_poll(thread, 0, 0);
+	}
+	spdk_thread_destroy(thread);
+}
+
+static int g_ut_quiesce_status;
+static bool g_ut_quiesce_done;
+
+static void
+ut_quiesce_cb(void *cb_arg, int status)
+{
+	g_ut_quiesce_done = true;
+	g_ut_quiesce_status = status;
+}
+
+static void
+test_nvmf_tcp_qpair_migrate(void)
+{
+	int rc;
+	struct spdk_nvmf_tcp_transport ttransport = {};
+	struct spdk_nvmf_tcp_poll_group tgroup[2] = {};
+	struct spdk_nvmf_tcp_qpair *tqpair;
+	struct spdk_nvmf_tcp_req *tcp_req;
+	struct spdk_thread *thread;
+	int i;
+
+	thread = spdk_thread_create(NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+	spdk_set_thread(thread);
+
+	nvmf_tcp_opts_init(&ttransport.transport.opts);
+	for (i = 0; i < 2; i++) {
+		TAILQ_INIT(&tgroup[i].qpairs);
+		TAILQ_INIT(&tgroup[i].await_req);
+		TAILQ_INIT(&tgroup[i].send_pending);
+		TAILQ_INIT(&tgroup[i].migrating);
+	}
+
+	tqpair = calloc(1, sizeof(*tqpair));
+	SPDK_CU_ASSERT_FATAL(tqpair != NULL);
+	tqpair->qpair.transport = &ttransport.transport;
+	TAILQ_INIT(&tqpair->tcp_req_free_queue);
+	TAILQ_INIT(&tqpair->tcp_req_working_queue);
+	rc = nvmf_tcp_qpair_init_mem_resource(tqpair);
+	CU_ASSERT(rc == 0);
+	tqpair->group = &tgroup[0];
+	tqpair->state = NVME_TCP_QPAIR_STATE_RUNNING;
+	nvmf_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
+	TAILQ_INSERT_TAIL(&tgroup[0].qpairs, tqpair, link);
+
+	/* No new PDU is read while a request is in flight */
+	tcp_req = nvmf_tcp_req_get(tqpair);
+	SPDK_CU_ASSERT_FATAL(tcp_req != NULL);
+	nvmf_tcp_qpair_quiesce(&tqpair->qpair, ut_quiesce_cb, NULL);
+	CU_ASSERT(tqpair->migrating);
+	CU_ASSERT(TAILQ_FIRST(&tgroup[0].migrating) == tqpair);
+	CU_ASSERT(!g_ut_quiesce_done);
+	rc = nvmf_tcp_sock_process(tqpair);
+	CU_ASSERT(rc == NVME_TCP_PDU_IN_PROGRESS);
+	CU_ASSERT(tqpair->recv_state == NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_READY);
+	nvmf_tcp_poll_group_poll(&tgroup[0].group);
+	CU_ASSERT(!g_ut_quiesce_done);
+
+	/* Quiesced once it completes */
+	nvmf_tcp_req_put(tqpair, tcp_req);
+	nvmf_tcp_poll_group_poll(&tgroup[0].group);
+	CU_ASSERT(g_ut_quiesce_done);
+	CU_ASSERT(g_ut_quiesce_status == 0);
+	CU_ASSERT(TAILQ_EMPTY(&tgroup[0].migrating));
+
+	rc = nvmf_tcp_poll_group_remove(&tgroup[0].group, &tqpair->qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(TAILQ_EMPTY(&tgroup[0].qpairs));
+	rc = nvmf_tcp_poll_group_migrate(&tgroup[1].group, &tqpair->qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(tqpair->group == &tgroup[1]);
+	CU_ASSERT(TAILQ_FIRST(&tgroup[1].qpairs) == tqpair);
+	CU_ASSERT(!tqpair->migrating);
+
+	/* Removing a qpair being quiesced cancels it */
+	g_ut_quiesce_done = false;
+	nvmf_tcp_qpair_quiesce(&tqpair->qpair, ut_quiesce_cb, NULL);
+	rc = nvmf_tcp_poll_group_remove(&tgroup[1].group, &tqpair->qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_ut_quiesce_done);
+	CU_ASSERT(g_ut_quiesce_status == -ECANCELED);
+	CU_ASSERT(TAILQ_EMPTY(&tgroup[1].migrating));
+
+	nvmf_tcp_qpair_destroy(tqpair);
+
 	spdk_thread_exit(thread);
 	while (!spdk_thread_is_exited(thread)) {
 		spdk_thread_poll(thread, 0, 0);
@@ -981,6 +1214,7 @@ test_nvmf_tcp_check_xfer_type(void)
 	group = &tcp_group.group;
 	group->transport = &ttransport.transport;
 	STAILQ_INIT(&group->pending_buf_queue);
+	STAILQ_INIT(&group->pending_qos_queue);
 	tqpair.group = &tcp_group;
 
 	TAILQ_INIT(&tqpair.tcp_req_free_queue);
@@ -1056,6 +1290,7 @@ test_nvmf_tcp_invalid_sgl(void)
 	group = &tcp_group.group;
 	group->transport = &ttransport.transport;
 	STAILQ_INIT(&group->pending_buf_queue);
+	STAILQ_INIT(&group->pending_qos_queue);
 	tqpair.group = &tcp_group;
 
 	TAILQ_INIT(&tqpair.tcp_req_free_queue);
@@ -1283,6 +1518,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_tcp_h2c_data_hdr_handle);
 	CU_ADD_TEST(suite, test_nvmf_tcp_in_capsule_data_handle);
 	CU_ADD_TEST(suite, test_nvmf_tcp_qpair_init_mem_resource);
+	CU_ADD_TEST(suite, test_nvmf_tcp_pdu_coalesce);
+	CU_ADD_TEST(suite, test_nvmf_tcp_qpair_migrate);
 	CU_ADD_TEST(suite, test_nvmf_tcp_send_c2h_term_req);
 	CU_ADD_TEST(suite, test_nvmf_tcp_send_capsule_resp_pdu);
 	CU_ADD_TEST(suite, test_nvmf_tcp_icreq_handle);
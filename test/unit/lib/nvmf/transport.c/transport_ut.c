@@ -82,6 +82,10 @@ DEFINE_STUB(spdk_nvmf_qpair_get_listen_trid, int, (struct spdk_nvmf_qpair *qpair
 DEFINE_STUB(ibv_reg_mr_iova2, struct ibv_mr *, (struct ibv_pd *pd, void *addr, size_t length,
 		uint64_t iova, unsigned int access), NULL);
 DEFINE_STUB(spdk_nvme_transport_id_adrfam_str, const char *, (enum spdk_nvmf_adrfam adrfam), NULL);
+DEFINE_STUB(nvmf_ctrlr_use_zcopy, bool, (struct spdk_nvmf_request *req), false);
+DEFINE_STUB(nvmf_request_qos_admit, bool, (struct spdk_nvmf_request *req, bool force), true);
+DEFINE_STUB_V(spdk_nvmf_request_zcopy_start, (struct spdk_nvmf_request *req));
+DEFINE_STUB_V(spdk_nvmf_request_zcopy_end, (struct spdk_nvmf_request *req, bool commit));
 DEFINE_STUB_V(ut_opts_init, (struct spdk_nvmf_transport_opts *opts));
 DEFINE_STUB(ut_transport_listen, int, (struct spdk_nvmf_transport *transport,
 				       const struct spdk_nvme_transport_id *trid, struct spdk_nvmf_listen_opts *opts), 0);
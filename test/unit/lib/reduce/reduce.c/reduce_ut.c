@@ -90,7 +90,7 @@ pmem_persist(const void *addr, size_t len)
 static void
 get_pm_file_size(void)
 {
-	struct spdk_reduce_vol_params params;
+	struct spdk_reduce_vol_params params = {};
 	uint64_t pm_size, expected_pm_size;
 
 	params.backing_io_unit_size = 4096;
@@ -1016,6 +1016,405 @@ readv_writev(void)
 	_readv_writev(4096);
 }
 
+static void
+multi_chunk(void)
+{
+	struct spdk_reduce_vol_params params = {};
+	struct spdk_reduce_backing_dev backing_dev = {};
+	struct iovec iov[3];
+	uint8_t buf[3 * 16 * 1024], read_buf[3 * 16 * 1024];
+	uint64_t offset = 20, length = 2 * 32 + 10;
+	uint64_t i;
+
+	params.chunk_size = 16 * 1024;
+	params.backing_io_unit_size = 4096;
+	params.logical_block_size = 512;
+	spdk_uuid_generate(&params.uuid);
+
+	backing_dev_init(&backing_dev, &params, 512);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_init(&params, &backing_dev, TEST_MD_PATH, init_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = i % 251;
+	}
+
+	/* A write spanning 3 chunks, with iovecs that don't end on the chunk boundaries */
+	iov[0].iov_base = buf;
+	iov[0].iov_len = 5 * params.logical_block_size;
+	iov[1].iov_base = buf + iov[0].iov_len;
+	iov[1].iov_len = 40 * params.logical_block_size;
+	iov[2].iov_base = buf + iov[0].iov_len + iov[1].iov_len;
+	iov[2].iov_len = (length - 45) * params.logical_block_size;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, iov, 3, offset, length, write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(g_vol->pm_logical_map[0] != REDUCE_EMPTY_MAP_ENTRY);
+	CU_ASSERT(g_vol->pm_logical_map[1] != REDUCE_EMPTY_MAP_ENTRY);
+	CU_ASSERT(g_vol->pm_logical_map[2] != REDUCE_EMPTY_MAP_ENTRY);
+	CU_ASSERT(g_vol->pm_logical_map[3] == REDUCE_EMPTY_MAP_ENTRY);
+
+	/* Read it back block by block, and as one read spanning all the chunks */
+	for (i = 0; i < length; i++) {
+		iov[0].iov_base = read_buf;
+		iov[0].iov_len = params.logical_block_size;
+		g_reduce_errno = -1;
+		spdk_reduce_vol_readv(g_vol, iov, 1, offset + i, 1, read_cb, NULL);
+		CU_ASSERT(g_reduce_errno == 0);
+		CU_ASSERT(memcmp(read_buf, buf + i * params.logical_block_size,
+				 params.logical_block_size) == 0);
+	}
+
+	memset(read_buf, 0xFF, sizeof(read_buf));
+	iov[0].iov_base = read_buf;
+	iov[0].iov_len = 4 * params.logical_block_size;
+	iov[1].iov_base = read_buf + iov[0].iov_len;
+	iov[1].iov_len = (length + 20 - 4) * params.logical_block_size;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, iov, 2, 0, length + 20, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(spdk_mem_all_zero(read_buf, offset * params.logical_block_size));
+	CU_ASSERT(memcmp(read_buf + offset * params.logical_block_size, buf,
+			 length * params.logical_block_size) == 0);
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	persistent_pm_buf_destroy();
+	backing_dev_destroy(&backing_dev);
+}
+
+static void
+ut_vol_fill(uint64_t offset, uint64_t length, uint8_t pattern)
+{
+	uint8_t buf[16 * 1024];
+	struct iovec iov;
+
+	memset(buf, pattern, length * 512);
+	iov.iov_base = buf;
+	iov.iov_len = length * 512;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, &iov, 1, offset, length, write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+}
+
+static void
+write_buffer(void)
+{
+	struct spdk_reduce_vol_params params = {};
+	struct spdk_reduce_backing_dev backing_dev = {};
+	struct iovec iov;
+	uint8_t buf[16 * 1024], compare_buf[16 * 1024];
+	uint64_t chunk0_map_index;
+
+	params.chunk_size = 16 * 1024;
+	params.backing_io_unit_size = 4096;
+	params.logical_block_size = 512;
+	params.write_buffer_chunks = 2;
+	spdk_uuid_generate(&params.uuid);
+
+	backing_dev_init(&backing_dev, &params, 512);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_init(&params, &backing_dev, TEST_MD_PATH, init_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	CU_ASSERT(g_vol->pm_file.size == _get_pm_file_size(&params));
+
+	/* A write smaller than a chunk is only buffered */
+	ut_vol_fill(2, 2, 0xAA);
+	CU_ASSERT(g_vol->pm_logical_map[0] == REDUCE_EMPTY_MAP_ENTRY);
+	CU_ASSERT(_reduce_vol_find_write_buffer(g_vol, 0) != NULL);
+
+	iov.iov_base = buf;
+	iov.iov_len = 4 * params.logical_block_size;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 0, 4, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(spdk_mem_all_zero(buf, 2 * params.logical_block_size));
+	memset(compare_buf, 0xAA, sizeof(compare_buf));
+	CU_ASSERT(memcmp(buf + 2 * params.logical_block_size, compare_buf,
+			 2 * params.logical_block_size) == 0);
+
+	/* The buffered blocks are persisted in the pm file */
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	CU_ASSERT(g_vol->params.write_buffer_chunks == 2);
+
+	memset(buf, 0xFF, sizeof(buf));
+	iov.iov_len = params.logical_block_size;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 3, 1, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(memcmp(buf, compare_buf, params.logical_block_size) == 0);
+
+	/* Completing the chunk writes it back to the backing device and frees the entry */
+	ut_vol_fill(0, 2, 0x11);
+	CU_ASSERT(g_vol->pm_logical_map[0] == REDUCE_EMPTY_MAP_ENTRY);
+	ut_vol_fill(4, 28, 0x22);
+	chunk0_map_index = g_vol->pm_logical_map[0];
+	CU_ASSERT(chunk0_map_index != REDUCE_EMPTY_MAP_ENTRY);
+	CU_ASSERT(_reduce_vol_find_write_buffer(g_vol, 0) == NULL);
+
+	/* Overwrite a block of the written chunk, reads merge it with the backing device */
+	ut_vol_fill(5, 1, 0x33);
+	CU_ASSERT(g_vol->pm_logical_map[0] == chunk0_map_index);
+
+	memset(compare_buf, 0x11, 2 * params.logical_block_size);
+	memset(compare_buf + 2 * params.logical_block_size, 0xAA, 2 * params.logical_block_size);
+	memset(compare_buf + 4 * params.logical_block_size, 0x22, 28 * params.logical_block_size);
+	memset(compare_buf + 5 * params.logical_block_size, 0x33, params.logical_block_size);
+	memset(buf, 0xFF, sizeof(buf));
+	iov.iov_len = params.chunk_size;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 0, 32, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(memcmp(buf, compare_buf, params.chunk_size) == 0);
+
+	/* Buffering a third chunk writes back the first entry, merged with the old chunk */
+	ut_vol_fill(40, 1, 0x44);
+	CU_ASSERT(g_vol->pm_logical_map[1] == REDUCE_EMPTY_MAP_ENTRY);
+	ut_vol_fill(70, 2, 0x55);
+	CU_ASSERT(g_vol->pm_logical_map[0] != chunk0_map_index);
+	CU_ASSERT(g_vol->pm_logical_map[0] != REDUCE_EMPTY_MAP_ENTRY);
+	CU_ASSERT(g_vol->pm_logical_map[2] == REDUCE_EMPTY_MAP_ENTRY);
+	CU_ASSERT(_reduce_vol_find_write_buffer(g_vol, 0) == NULL);
+	CU_ASSERT(_reduce_vol_find_write_buffer(g_vol, 1) != NULL);
+	CU_ASSERT(_reduce_vol_find_write_buffer(g_vol, 2) != NULL);
+
+	memset(buf, 0xFF, sizeof(buf));
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 0, 32, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(memcmp(buf, compare_buf, params.chunk_size) == 0);
+
+	memset(buf, 0xFF, sizeof(buf));
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 64, 32, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(spdk_mem_all_zero(buf, 6 * params.logical_block_size));
+	memset(compare_buf, 0x55, sizeof(compare_buf));
+	CU_ASSERT(memcmp(buf + 6 * params.logical_block_size, compare_buf,
+			 2 * params.logical_block_size) == 0);
+	CU_ASSERT(spdk_mem_all_zero(buf + 8 * params.logical_block_size,
+				    24 * params.logical_block_size));
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	persistent_pm_buf_destroy();
+	backing_dev_destroy(&backing_dev);
+}
+
+static void
+dram_md(void)
+{
+	struct spdk_reduce_vol_params params = {};
+	struct spdk_reduce_backing_dev backing_dev = {};
+	struct iovec iov;
+	uint8_t buf[16 * 1024], compare_buf[16 * 1024];
+	uint64_t num_chunks, i;
+
+	params.chunk_size = 16 * 1024;
+	params.backing_io_unit_size = 4096;
+	params.logical_block_size = 512;
+	spdk_uuid_generate(&params.uuid);
+
+	backing_dev_init(&backing_dev, &params, 512);
+
+	/* The write buffer needs a pm file */
+	params.write_buffer_chunks = 2;
+	g_vol = NULL;
+	g_reduce_errno = 0;
+	spdk_reduce_vol_init(&params, &backing_dev, NULL, init_cb, NULL);
+	CU_ASSERT(g_reduce_errno == -EINVAL);
+	CU_ASSERT(g_vol == NULL);
+
+	params.write_buffer_chunks = 0;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_init(&params, &backing_dev, NULL, init_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	SPDK_CU_ASSERT_FATAL(g_vol->md_log != NULL);
+	CU_ASSERT(g_vol->params.vol_size < _get_vol_size(params.chunk_size, 4 * 1024 * 1024));
+	CU_ASSERT(g_persistent_pm_buf == NULL);
+
+	/* Updates are journaled, and replayed when loading the volume */
+	num_chunks = g_vol->params.vol_size / params.chunk_size;
+	for (i = 0; i < num_chunks; i++) {
+		ut_vol_fill(i * 32, 32, i + 1);
+	}
+	CU_ASSERT(g_vol->md_log->tail != 0);
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+	SPDK_CU_ASSERT_FATAL(g_vol->md_log != NULL);
+
+	iov.iov_base = buf;
+	iov.iov_len = params.chunk_size;
+	for (i = 0; i < num_chunks; i++) {
+		memset(compare_buf, i + 1, sizeof(compare_buf));
+		g_reduce_errno = -1;
+		spdk_reduce_vol_readv(g_vol, &iov, 1, i * 32, 32, read_cb, NULL);
+		CU_ASSERT(g_reduce_errno == 0);
+		CU_ASSERT(memcmp(buf, compare_buf, params.chunk_size) == 0);
+	}
+
+	/* Overwriting the chunks fills the log, and checkpoints move its head */
+	for (i = 0; i < 4 * num_chunks; i++) {
+		ut_vol_fill((i % num_chunks) * 32, 32, i + 0x80);
+	}
+	CU_ASSERT(g_vol->md_log->head != 0);
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+
+	for (i = 0; i < num_chunks; i++) {
+		memset(compare_buf, 3 * num_chunks + i + 0x80, sizeof(compare_buf));
+		g_reduce_errno = -1;
+		spdk_reduce_vol_readv(g_vol, &iov, 1, i * 32, 32, read_cb, NULL);
+		CU_ASSERT(g_reduce_errno == 0);
+		CU_ASSERT(memcmp(buf, compare_buf, params.chunk_size) == 0);
+	}
+
+	/* A torn checkpoint makes the volume fail to load */
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	g_backing_dev_buf[REDUCE_MD_CHECKPOINT_OFFSET + 8] ^= 0xFF;
+	g_vol = NULL;
+	g_reduce_errno = 0;
+	spdk_reduce_vol_load(&backing_dev, load_cb, NULL);
+	CU_ASSERT(g_reduce_errno == -EILSEQ);
+	CU_ASSERT(g_vol == NULL);
+
+	backing_dev_destroy(&backing_dev);
+}
+
+static void
+ut_vol_write_chunk(uint64_t chunk, uint8_t *buf)
+{
+	struct iovec iov;
+
+	iov.iov_base = buf;
+	iov.iov_len = 16 * 1024;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_writev(g_vol, &iov, 1, chunk * 32, 32, write_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+}
+
+static void
+compress_bypass(void)
+{
+	struct spdk_reduce_vol_params params = {};
+	struct spdk_reduce_backing_dev backing_dev = {};
+	struct spdk_reduce_vol_stats stats;
+	struct iovec iov;
+	uint8_t buf[16 * 1024], read_buf[16 * 1024];
+	uint32_t i;
+
+	params.chunk_size = 16 * 1024;
+	params.backing_io_unit_size = 4096;
+	params.logical_block_size = 512;
+	spdk_uuid_generate(&params.uuid);
+
+	backing_dev_init(&backing_dev, &params, 512);
+
+	g_vol = NULL;
+	g_reduce_errno = -1;
+	spdk_reduce_vol_init(&params, &backing_dev, TEST_MD_PATH, init_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	SPDK_CU_ASSERT_FATAL(g_vol != NULL);
+
+	/* Compressible data */
+	memset(buf, 0xAA, sizeof(buf));
+	ut_vol_write_chunk(0, buf);
+	spdk_reduce_vol_get_stats(g_vol, &stats);
+	CU_ASSERT(stats.compressed_chunks == 1);
+	CU_ASSERT(stats.ratio_histogram[2] == 1);
+
+	/* Random data is not compressed at all */
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = rand();
+	}
+	ut_vol_write_chunk(1, buf);
+	spdk_reduce_vol_get_stats(g_vol, &stats);
+	CU_ASSERT(stats.compressed_chunks == 1);
+	CU_ASSERT(stats.incompressible_chunks == 0);
+	CU_ASSERT(stats.bypassed_chunks == 1);
+	CU_ASSERT(stats.ratio_histogram[SPDK_REDUCE_RATIO_BUCKETS - 1] == 1);
+	CU_ASSERT(_reduce_vol_get_chunk_map(g_vol, g_vol->pm_logical_map[1])->compressed_size ==
+		  params.chunk_size);
+
+	iov.iov_base = read_buf;
+	iov.iov_len = sizeof(read_buf);
+	g_reduce_errno = -1;
+	spdk_reduce_vol_readv(g_vol, &iov, 1, 32, 32, read_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+	CU_ASSERT(memcmp(buf, read_buf, sizeof(buf)) == 0);
+
+	/*
+	 * Alternating bytes don't look random, but don't compress either.  Once enough of
+	 *  them didn't compress, only a chunk now and then is compressed.
+	 */
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = i % 2;
+	}
+	for (i = 0; i < REDUCE_BYPASS_STREAK + REDUCE_BYPASS_PROBE_INTERVAL; i++) {
+		ut_vol_write_chunk(2, buf);
+	}
+	spdk_reduce_vol_get_stats(g_vol, &stats);
+	CU_ASSERT(stats.incompressible_chunks == REDUCE_BYPASS_STREAK + 1);
+	CU_ASSERT(stats.bypassed_chunks == REDUCE_BYPASS_PROBE_INTERVAL);
+
+	/* A probe that compresses again ends the bypass */
+	memset(buf, 0x55, sizeof(buf));
+	for (i = 0; i < REDUCE_BYPASS_PROBE_INTERVAL; i++) {
+		ut_vol_write_chunk(3, buf);
+	}
+	spdk_reduce_vol_get_stats(g_vol, &stats);
+	CU_ASSERT(stats.compressed_chunks == 2);
+	ut_vol_write_chunk(3, buf);
+	spdk_reduce_vol_get_stats(g_vol, &stats);
+	CU_ASSERT(stats.compressed_chunks == 3);
+
+	g_reduce_errno = -1;
+	spdk_reduce_vol_unload(g_vol, unload_cb, NULL);
+	CU_ASSERT(g_reduce_errno == 0);
+
+	persistent_pm_buf_destroy();
+	backing_dev_destroy(&backing_dev);
+}
+
 static void
 destroy_cb(void *ctx, int reduce_errno)
 {
@@ -1838,6 +2237,10 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, write_maps);
 	CU_ADD_TEST(suite, read_write);
 	CU_ADD_TEST(suite, readv_writev);
+	CU_ADD_TEST(suite, multi_chunk);
+	CU_ADD_TEST(suite, write_buffer);
+	CU_ADD_TEST(suite, dram_md);
+	CU_ADD_TEST(suite, compress_bypass);
 	CU_ADD_TEST(suite, destroy);
 	CU_ADD_TEST(suite, defer_bdev_io);
 	CU_ADD_TEST(suite, overlapped);
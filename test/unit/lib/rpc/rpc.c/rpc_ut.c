@@ -29,6 +29,9 @@ DEFINE_STUB(spdk_jsonrpc_server_listen, struct spdk_jsonrpc_server *, (int domai
 	    (struct spdk_jsonrpc_server *)0Xdeaddead);
 DEFINE_STUB(spdk_jsonrpc_server_poll, int, (struct spdk_jsonrpc_server *server), 0);
 DEFINE_STUB_V(spdk_jsonrpc_server_shutdown, (struct spdk_jsonrpc_server *server));
+DEFINE_STUB(spdk_jsonrpc_handle_local_request, int,
+	    (spdk_jsonrpc_handle_request_fn handle_request, const struct spdk_json_val *method,
+	     const struct spdk_json_val *params, spdk_jsonrpc_local_response_fn cb_fn, void *cb_arg), 0);
 
 DECLARE_WRAPPER(open, int, (const char *pathname, int flags, mode_t mode));
 DECLARE_WRAPPER(close, int, (int fd));
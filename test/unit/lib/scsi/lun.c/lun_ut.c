@@ -79,6 +79,7 @@ DEFINE_STUB_V(spdk_scsi_dev_delete_lun,
 
 DEFINE_STUB(scsi_pr_check, int, (struct spdk_scsi_task *task), 0);
 DEFINE_STUB(scsi2_reserve_check, int, (struct spdk_scsi_task *task), 0);
+DEFINE_STUB_V(scsi_pr_store_detach, (struct spdk_scsi_lun *lun));
 
 void
 bdev_scsi_reset(struct spdk_scsi_task *task)
@@ -652,6 +653,56 @@ lun_check_pending_tasks_only_for_specific_initiator(void)
 	scsi_lun_remove(lun);
 }
 
+static void
+lun_execute_scsi_task_max_tasks_per_initiator(void)
+{
+	struct spdk_scsi_lun *lun;
+	struct spdk_scsi_task task1, task2, task3;
+	struct spdk_scsi_dev dev = { 0 };
+	struct spdk_scsi_port initiator_port1 = {};
+	struct spdk_scsi_port initiator_port2 = {};
+
+	lun = lun_construct();
+	lun->dev = &dev;
+	lun->max_tasks_per_initiator = 1;
+
+	ut_init_task(&task1);
+	task1.lun = lun;
+	task1.initiator_port = &initiator_port1;
+	ut_init_task(&task2);
+	task2.lun = lun;
+	task2.initiator_port = &initiator_port1;
+	ut_init_task(&task3);
+	task3.lun = lun;
+	task3.initiator_port = &initiator_port2;
+
+	g_lun_execute_fail = false;
+	g_lun_execute_status = SPDK_SCSI_TASK_PENDING;
+
+	/* The second task of initiator 1 waits, the task of initiator 2 doesn't. */
+	scsi_lun_execute_task(lun, &task1);
+	scsi_lun_execute_task(lun, &task2);
+	scsi_lun_execute_task(lun, &task3);
+
+	CU_ASSERT(TAILQ_FIRST(&lun->tasks) == &task1);
+	CU_ASSERT(TAILQ_NEXT(&task1, scsi_link) == &task3);
+	CU_ASSERT(TAILQ_NEXT(&task3, scsi_link) == NULL);
+	CU_ASSERT(scsi_lun_has_pending_tasks(lun, &initiator_port1) == true);
+
+	/* Completing the first task of initiator 1 submits the second one. */
+	scsi_lun_complete_task(lun, &task1);
+	CU_ASSERT(TAILQ_FIRST(&lun->tasks) == &task3);
+	CU_ASSERT(TAILQ_NEXT(&task3, scsi_link) == &task2);
+	CU_ASSERT(g_task_count == 2);
+
+	scsi_lun_complete_task(lun, &task2);
+	scsi_lun_complete_task(lun, &task3);
+	CU_ASSERT(g_task_count == 0);
+	CU_ASSERT(scsi_lun_has_pending_tasks(lun, NULL) == false);
+
+	lun_destruct(lun);
+}
+
 static void
 abort_pending_mgmt_tasks_when_lun_is_removed(void)
 {
@@ -745,6 +796,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, lun_reset_task_wait_scsi_task_complete);
 	CU_ADD_TEST(suite, lun_reset_task_suspend_scsi_task);
 	CU_ADD_TEST(suite, lun_check_pending_tasks_only_for_specific_initiator);
+	CU_ADD_TEST(suite, lun_execute_scsi_task_max_tasks_per_initiator);
 	CU_ADD_TEST(suite, abort_pending_mgmt_tasks_when_lun_is_removed);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
@@ -14,6 +14,8 @@
 
 SPDK_LOG_REGISTER_COMPONENT(scsi)
 
+DEFINE_STUB_V(scsi_pr_store_persist, (struct spdk_scsi_lun *lun));
+
 void
 spdk_scsi_task_set_status(struct spdk_scsi_task *task, int sc, int sk,
 			  int asc, int ascq)
@@ -623,6 +625,64 @@ test_pr_with_scsi2_reserve_release(void)
 	ut_deinit_reservation_test();
 }
 
+static void
+test_reservation_restored_registrant(void)
+{
+	struct spdk_scsi_pr_registrant *reg;
+	struct spdk_scsi_task task = {0};
+	uint8_t cdb[32] = {};
+	int rc;
+
+	task.lun = &g_lun;
+	task.target_port = &g_t_port_0;
+	task.cdb = cdb;
+
+	ut_init_reservation_test();
+
+	/* Host A holds a Write Exclusive reservation loaded from a store, not
+	 * bound to any port yet.
+	 */
+	reg = calloc(1, sizeof(*reg));
+	SPDK_CU_ASSERT_FATAL(reg != NULL);
+	reg->rkey = 0xa;
+	snprintf(reg->initiator_port_name, sizeof(reg->initiator_port_name), "%s",
+		 g_i_port_a.name);
+	snprintf(reg->target_port_name, sizeof(reg->target_port_name), "%s",
+		 g_t_port_0.name);
+	TAILQ_INSERT_TAIL(&g_lun.reg_head, reg, link);
+	g_lun.reservation.rtype = SPDK_SCSI_PR_WRITE_EXCLUSIVE;
+	g_lun.reservation.crkey = 0xa;
+	g_lun.reservation.holder = reg;
+	g_lun.pr_state_gen++;
+
+	/* Test Case: Host B can't write */
+	task.initiator_port = &g_i_port_b;
+	task.cdb[0] = SPDK_SBC_WRITE_10;
+	task.status = 0;
+	rc = scsi_pr_check(&task);
+	SPDK_CU_ASSERT_FATAL(rc < 0);
+	SPDK_CU_ASSERT_FATAL(task.status == SPDK_SCSI_STATUS_RESERVATION_CONFLICT);
+	SPDK_CU_ASSERT_FATAL(reg->initiator_port == NULL);
+
+	/* Test Case: Host A is matched by name and can write */
+	task.initiator_port = &g_i_port_a;
+	task.status = 0;
+	rc = scsi_pr_check(&task);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	SPDK_CU_ASSERT_FATAL(reg->initiator_port == &g_i_port_a);
+	SPDK_CU_ASSERT_FATAL(reg->target_port == &g_t_port_0);
+
+	/* Test Case: Host A releases, Host B can write again */
+	rc = scsi_pr_out_release(&task, SPDK_SCSI_PR_WRITE_EXCLUSIVE, 0xa);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+	task.initiator_port = &g_i_port_b;
+	task.status = 0;
+	rc = scsi_pr_check(&task);
+	SPDK_CU_ASSERT_FATAL(rc == 0);
+
+	ut_deinit_reservation_test();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -640,6 +700,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_reservation_cmds_conflict);
 	CU_ADD_TEST(suite, test_scsi2_reserve_release);
 	CU_ADD_TEST(suite, test_pr_with_scsi2_reserve_release);
+	CU_ADD_TEST(suite, test_reservation_restored_registrant);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
@@ -127,6 +127,17 @@ flush(void)
 	CU_ASSERT(cb_arg1 == true);
 	CU_ASSERT(TAILQ_EMPTY(&sock->queued_reqs));
 
+	/* With kTLS, the requests are written to the socket directly */
+	psock.ssl = (SSL *)0xDEADBEEF;
+	psock.ktls_send = true;
+	spdk_sock_request_queue(sock, req1);
+	MOCK_SET(sendmsg, 64);
+	cb_arg1 = false;
+	rc = _sock_flush(sock);
+	CU_ASSERT(rc == 64);
+	CU_ASSERT(cb_arg1 == true);
+	CU_ASSERT(TAILQ_EMPTY(&sock->queued_reqs));
+
 	free(req1);
 	free(req2);
 }
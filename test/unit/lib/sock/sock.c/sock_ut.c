@@ -346,6 +346,7 @@ _sock(const char *ip, int port, char *impl_name)
 	char buffer[64];
 	ssize_t bytes_read, bytes_written;
 	struct iovec iov;
+	void *recv_buf, *recv_ctx;
 	int nbytes;
 	int rc;
 
@@ -442,6 +443,23 @@ _sock(const char *ip, int port, char *impl_name)
 
 	CU_ASSERT(strncmp(test_string, buffer, 7) == 0);
 
+	/* Test spdk_sock_recv_next */
+	iov.iov_base = test_string;
+	iov.iov_len = 7;
+	bytes_written = spdk_sock_writev(client_sock, &iov, 1);
+	CU_ASSERT(bytes_written == 7);
+
+	usleep(1000);
+
+	bytes_read = spdk_sock_recv_next(server_sock, &recv_buf, &recv_ctx);
+	CU_ASSERT(bytes_read == 7);
+	CU_ASSERT(strncmp(test_string, recv_buf, 7) == 0);
+	spdk_sock_recv_buf_release(server_sock, recv_ctx);
+
+	bytes_read = spdk_sock_recv_next(server_sock, &recv_buf, &recv_ctx);
+	CU_ASSERT(bytes_read == -1);
+	CU_ASSERT(errno == EAGAIN);
+
 	rc = spdk_sock_close(&client_sock);
 	CU_ASSERT(client_sock == NULL);
 	CU_ASSERT(rc == 0);
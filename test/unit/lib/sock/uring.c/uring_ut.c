@@ -29,6 +29,15 @@ DEFINE_STUB(__io_uring_get_cqe, int, (struct io_uring *ring, struct io_uring_cqe
 DEFINE_STUB(io_uring_submit, int, (struct io_uring *ring), 0);
 DEFINE_STUB(io_uring_queue_init, int, (unsigned entries, struct io_uring *ring, unsigned flags), 0);
 DEFINE_STUB_V(io_uring_queue_exit, (struct io_uring *ring));
+DEFINE_STUB(io_uring_register_files, int, (struct io_uring *ring, const int *files,
+		unsigned nr_files), 0);
+DEFINE_STUB(io_uring_register_files_update, int, (struct io_uring *ring, unsigned off,
+		int *files, unsigned nr_files), 1);
+#ifdef SPDK_URING_RECV_MULTISHOT
+DEFINE_STUB(io_uring_register_buf_ring, int, (struct io_uring *ring, struct io_uring_buf_reg *reg,
+		unsigned int flags), 0);
+DEFINE_STUB(io_uring_unregister_buf_ring, int, (struct io_uring *ring, int bgid), 0);
+#endif
 
 static void
 _req_cb(void *cb_arg, int len)
@@ -8,6 +8,7 @@
 #include "unit/lib/json_mock.c"
 
 #include "spdk/config.h"
+#include "spdk/histogram_data.h"
 #include "spdk/thread.h"
 
 #include "thread/iobuf.c"
@@ -45,6 +46,7 @@ ut_iobuf_foreach_cb(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *entr
 }
 
 #define SMALL_BUFSIZE 128
+#define MEDIUM_BUFSIZE 256
 #define LARGE_BUFSIZE 512
 
 static void
@@ -626,6 +628,702 @@ iobuf_cache(void)
 	free_cores();
 }
 
+static void
+iobuf_migrate(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 4,
+		.large_pool_count = 4,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = LARGE_BUFSIZE,
+	};
+	struct spdk_iobuf_channel iobuf_ch[2];
+	struct spdk_iobuf_buffer *buf;
+	void *old[2];
+	int rc, finish = 0;
+	uint32_t i;
+
+	allocate_cores(1);
+	allocate_threads(1);
+
+	set_thread(0);
+
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_register_module("ut_module0");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_channel_init(&iobuf_ch[0], "ut_module0", 2, 2);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	i = 0;
+	STAILQ_FOREACH(buf, &iobuf_ch[0].small.cache, stailq) {
+		old[i++] = buf;
+	}
+
+	/* The cached buffers are exchanged for ones from the pool */
+	spdk_iobuf_channel_migrate(&iobuf_ch[0]);
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.cache_count, 2);
+	CU_ASSERT_EQUAL(iobuf_ch[0].large.cache_count, 2);
+	STAILQ_FOREACH(buf, &iobuf_ch[0].small.cache, stailq) {
+		CU_ASSERT(buf != old[0] && buf != old[1]);
+	}
+
+	/* The old ones went back to the pool, so another channel can still take two buffers.
+	 * With the pool exhausted, the cache is kept as it is.
+	 */
+	rc = spdk_iobuf_channel_init(&iobuf_ch[1], "ut_module0", 2, 2);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	i = 0;
+	STAILQ_FOREACH(buf, &iobuf_ch[0].small.cache, stailq) {
+		old[i++] = buf;
+	}
+	spdk_iobuf_channel_migrate(&iobuf_ch[0]);
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.cache_count, 2);
+	CU_ASSERT_EQUAL(iobuf_ch[0].large.cache_count, 2);
+	i = 0;
+	STAILQ_FOREACH(buf, &iobuf_ch[0].small.cache, stailq) {
+		CU_ASSERT(buf == old[i++]);
+	}
+
+	spdk_iobuf_channel_fini(&iobuf_ch[0]);
+	spdk_iobuf_channel_fini(&iobuf_ch[1]);
+	poll_threads();
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+
+	free_threads();
+	free_cores();
+}
+
+static void
+iobuf_size_classes(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 2,
+		.large_pool_count = 2,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = LARGE_BUFSIZE,
+		.num_size_classes = 1,
+		.size_classes = {
+			{ .bufsize = MEDIUM_BUFSIZE, .pool_count = 2 },
+		},
+	};
+	struct spdk_iobuf_channel iobuf_ch;
+	struct ut_iobuf_entry entry = {};
+	void *bufs[3];
+	int rc, finish = 0;
+
+	allocate_cores(1);
+	allocate_threads(1);
+
+	set_thread(0);
+
+	/* We cannot use spdk_iobuf_set_opts(), as it won't allow us to use such small pools */
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_register_module("ut_module0");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_channel_init(&iobuf_ch, "ut_module0", 0, 1);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(iobuf_ch.num_classes, 1);
+	CU_ASSERT_EQUAL(iobuf_ch.classes[0].bufsize, MEDIUM_BUFSIZE);
+	CU_ASSERT_EQUAL(iobuf_ch.classes[0].cache_count, 1);
+
+	/* Requests between small and medium are served by the size class, first from the cache,
+	 * then from the pool */
+	bufs[0] = spdk_iobuf_get(&iobuf_ch, SMALL_BUFSIZE + 1, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(bufs[0]);
+	bufs[1] = spdk_iobuf_get(&iobuf_ch, MEDIUM_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(bufs[1]);
+	CU_ASSERT_EQUAL(iobuf_ch.classes[0].stats.cache, 1);
+	CU_ASSERT_EQUAL(iobuf_ch.classes[0].stats.main, 1);
+	CU_ASSERT_EQUAL(iobuf_ch.large.stats.cache, 0);
+	CU_ASSERT_EQUAL(iobuf_ch.large.stats.main, 0);
+
+	/* Larger requests still go to the large pool */
+	bufs[2] = spdk_iobuf_get(&iobuf_ch, MEDIUM_BUFSIZE + 1, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(bufs[2]);
+	CU_ASSERT_EQUAL(iobuf_ch.large.stats.cache, 1);
+	spdk_iobuf_put(&iobuf_ch, bufs[2], MEDIUM_BUFSIZE + 1);
+
+	/* With the size class exhausted, the request waits on its own queue, even though there
+	 * are large buffers available */
+	entry.ioch = &iobuf_ch;
+	entry.buf = spdk_iobuf_get(&iobuf_ch, MEDIUM_BUFSIZE, &entry.iobuf, ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NULL(entry.buf);
+	CU_ASSERT_EQUAL(iobuf_ch.classes[0].stats.retry, 1);
+	CU_ASSERT(!STAILQ_EMPTY(iobuf_ch.classes[0].queue));
+	CU_ASSERT(STAILQ_EMPTY(iobuf_ch.large.queue));
+
+	/* Iterating over all the pools finds it */
+	rc = spdk_iobuf_for_each_entry(&iobuf_ch, NULL, ut_iobuf_foreach_cb, (void *)0xfeedbeef);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(entry.buf, (void *)0xfeedbeef);
+	entry.buf = NULL;
+
+	/* Returning a buffer to the size class hands it to the waiting request */
+	spdk_iobuf_put(&iobuf_ch, bufs[0], SMALL_BUFSIZE + 1);
+	CU_ASSERT_EQUAL(entry.buf, bufs[0]);
+	CU_ASSERT(STAILQ_EMPTY(iobuf_ch.classes[0].queue));
+
+	/* Aborting a waiting request removes it from the size class queue */
+	entry.buf = spdk_iobuf_get(&iobuf_ch, MEDIUM_BUFSIZE, &entry.iobuf, ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NULL(entry.buf);
+	spdk_iobuf_entry_abort(&iobuf_ch, &entry.iobuf, MEDIUM_BUFSIZE);
+	CU_ASSERT(STAILQ_EMPTY(iobuf_ch.classes[0].queue));
+
+	spdk_iobuf_put(&iobuf_ch, bufs[0], MEDIUM_BUFSIZE);
+	spdk_iobuf_put(&iobuf_ch, bufs[1], MEDIUM_BUFSIZE);
+
+	spdk_iobuf_channel_fini(&iobuf_ch);
+	poll_threads();
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+
+	/* Size classes need to be increasing and fit between the small and large buffers */
+	opts.opts_size = sizeof(opts);
+	opts.small_pool_count = IOBUF_MIN_SMALL_POOL_SIZE;
+	opts.large_pool_count = IOBUF_MIN_LARGE_POOL_SIZE;
+	opts.small_bufsize = IOBUF_MIN_SMALL_BUFSIZE;
+	opts.large_bufsize = IOBUF_MIN_LARGE_BUFSIZE;
+	opts.num_size_classes = 2;
+	opts.size_classes[0].bufsize = opts.small_bufsize + 4096;
+	opts.size_classes[0].pool_count = 1;
+	opts.size_classes[1].bufsize = opts.small_bufsize + 8192;
+	opts.size_classes[1].pool_count = 1;
+	CU_ASSERT_EQUAL(spdk_iobuf_set_opts(&opts), 0);
+
+	opts.size_classes[1].bufsize = opts.size_classes[0].bufsize;
+	CU_ASSERT_EQUAL(spdk_iobuf_set_opts(&opts), -EINVAL);
+	opts.size_classes[1].bufsize = opts.large_bufsize;
+	CU_ASSERT_EQUAL(spdk_iobuf_set_opts(&opts), -EINVAL);
+	opts.size_classes[1].bufsize = opts.small_bufsize + 8192;
+	opts.size_classes[0].bufsize = opts.small_bufsize;
+	CU_ASSERT_EQUAL(spdk_iobuf_set_opts(&opts), -EINVAL);
+	opts.size_classes[0].bufsize = opts.small_bufsize + 4096;
+	opts.size_classes[0].pool_count = 0;
+	CU_ASSERT_EQUAL(spdk_iobuf_set_opts(&opts), -EINVAL);
+	opts.size_classes[0].pool_count = 1;
+	opts.num_size_classes = SPDK_IOBUF_MAX_SIZE_CLASSES + 1;
+	CU_ASSERT_EQUAL(spdk_iobuf_set_opts(&opts), -EINVAL);
+
+	free_threads();
+	free_cores();
+}
+
+static void
+iobuf_numa(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 2,
+		.large_pool_count = 2,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = LARGE_BUFSIZE,
+		.enable_numa = true,
+	};
+	struct spdk_iobuf_channel iobuf_ch[2];
+	struct spdk_mempool *mp[2];
+	void *bufs[3];
+	int rc, finish = 0;
+
+	allocate_cores(1);
+	allocate_threads(1);
+
+	set_thread(0);
+
+	/* All cores are on node 0, the pools of node 1 are added manually */
+	MOCK_SET(spdk_env_get_current_core, 0);
+	MOCK_SET(spdk_env_get_socket_id, 0);
+
+	/* We cannot use spdk_iobuf_set_opts(), as it won't allow us to use such small pools */
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_iobuf.num_nodes, 1);
+	rc = iobuf_node_init(1, 1);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_iobuf.num_nodes, 2);
+	mp[0] = g_iobuf.nodes[0].small_pool;
+	mp[1] = g_iobuf.nodes[1].small_pool;
+
+	rc = spdk_iobuf_register_module("ut_module0");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* Channels are bound to the pools of their thread's node */
+	rc = spdk_iobuf_channel_init(&iobuf_ch[0], "ut_module0", 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(iobuf_ch[0].node, 0);
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.pool, mp[0]);
+
+	MOCK_SET(spdk_env_get_socket_id, 1);
+	rc = spdk_iobuf_channel_init(&iobuf_ch[1], "ut_module0", 1, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(iobuf_ch[1].node, 1);
+	CU_ASSERT_EQUAL(iobuf_ch[1].small.pool, mp[1]);
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[1]), 1);
+
+	/* Once the local pool is exhausted, buffers are taken from the other node */
+	bufs[0] = spdk_iobuf_get(&iobuf_ch[0], SMALL_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(bufs[0]);
+	bufs[1] = spdk_iobuf_get(&iobuf_ch[0], SMALL_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(bufs[1]);
+	bufs[2] = spdk_iobuf_get(&iobuf_ch[0], SMALL_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(bufs[2]);
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.stats.main, 2);
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.stats.remote, 1);
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[0]), 0);
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[1]), 0);
+
+	/* Remote buffers go back to their own pool */
+	MOCK_SET(spdk_mempool_from_obj, mp[1]);
+	spdk_iobuf_put(&iobuf_ch[0], bufs[2], SMALL_BUFSIZE);
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[1]), 1);
+	MOCK_SET(spdk_mempool_from_obj, mp[0]);
+	spdk_iobuf_put(&iobuf_ch[0], bufs[0], SMALL_BUFSIZE);
+	spdk_iobuf_put(&iobuf_ch[0], bufs[1], SMALL_BUFSIZE);
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[0]), 2);
+
+	/* Moving a thread to another node rebinds its channel and exchanges the cache */
+	MOCK_SET(spdk_env_get_socket_id, 0);
+	spdk_iobuf_channel_migrate(&iobuf_ch[1]);
+	CU_ASSERT_EQUAL(iobuf_ch[1].node, 0);
+	CU_ASSERT_EQUAL(iobuf_ch[1].small.pool, mp[0]);
+	CU_ASSERT_EQUAL(iobuf_ch[1].small.cache_count, 1);
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[0]), 1);
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[1]), 2);
+
+	/* Remote buffers are dropped from the cache if the new node has none left */
+	MOCK_SET(spdk_env_get_socket_id, 1);
+	spdk_iobuf_channel_migrate(&iobuf_ch[0]);
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.pool, mp[1]);
+	bufs[0] = spdk_iobuf_get(&iobuf_ch[0], SMALL_BUFSIZE, NULL, NULL);
+	bufs[1] = spdk_iobuf_get(&iobuf_ch[0], SMALL_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(bufs[0]);
+	CU_ASSERT_PTR_NOT_NULL(bufs[1]);
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[1]), 0);
+
+	spdk_iobuf_channel_migrate(&iobuf_ch[1]);
+	CU_ASSERT_EQUAL(iobuf_ch[1].small.pool, mp[1]);
+	CU_ASSERT_EQUAL(iobuf_ch[1].small.cache_count, 0);
+	CU_ASSERT(STAILQ_EMPTY(&iobuf_ch[1].small.cache));
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[0]), 2);
+
+	/* The cache is refilled as buffers are released */
+	MOCK_SET(spdk_mempool_from_obj, mp[1]);
+	spdk_iobuf_put(&iobuf_ch[1], bufs[0], SMALL_BUFSIZE);
+	CU_ASSERT_EQUAL(iobuf_ch[1].small.cache_count, 1);
+	spdk_iobuf_put(&iobuf_ch[1], bufs[1], SMALL_BUFSIZE);
+	CU_ASSERT_EQUAL(iobuf_ch[1].small.cache_count, 1);
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[1]), 1);
+	MOCK_CLEAR(spdk_mempool_from_obj);
+
+	spdk_iobuf_channel_fini(&iobuf_ch[0]);
+	spdk_iobuf_channel_fini(&iobuf_ch[1]);
+	poll_threads();
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[0]), 2);
+	CU_ASSERT_EQUAL(spdk_mempool_count(mp[1]), 2);
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+	CU_ASSERT_EQUAL(g_iobuf.num_nodes, 0);
+
+	MOCK_CLEAR(spdk_env_get_socket_id);
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	free_threads();
+	free_cores();
+}
+
+static void
+iobuf_lazy_init(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 2,
+		.large_pool_count = 2,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = LARGE_BUFSIZE,
+		.enable_numa = true,
+		.lazy_init = true,
+	};
+	struct spdk_iobuf_channel iobuf_ch[3];
+	int rc, finish = 0;
+
+	allocate_cores(1);
+	allocate_threads(1);
+
+	set_thread(0);
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+	MOCK_SET(spdk_env_get_socket_id, 0);
+
+	/* No pools are created up front */
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_iobuf.num_nodes, 0);
+
+	rc = spdk_iobuf_register_module("ut_module0");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* The first channel on a node creates its pools, the following ones reuse them */
+	rc = spdk_iobuf_channel_init(&iobuf_ch[0], "ut_module0", 1, 1);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_iobuf.num_nodes, 1);
+	CU_ASSERT_EQUAL(iobuf_ch[0].node, 0);
+	CU_ASSERT_PTR_NOT_NULL(g_iobuf.nodes[0].small_pool);
+	CU_ASSERT_PTR_NOT_NULL(g_iobuf.nodes[0].large_pool);
+	CU_ASSERT_EQUAL(iobuf_ch[0].small.pool, g_iobuf.nodes[0].small_pool);
+
+	rc = spdk_iobuf_channel_init(&iobuf_ch[1], "ut_module0", 1, 1);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_iobuf.num_nodes, 1);
+	CU_ASSERT_EQUAL(iobuf_ch[1].small.pool, g_iobuf.nodes[0].small_pool);
+	CU_ASSERT_EQUAL(spdk_mempool_count(g_iobuf.nodes[0].small_pool), 0);
+
+	MOCK_SET(spdk_env_get_socket_id, 1);
+	rc = spdk_iobuf_channel_init(&iobuf_ch[2], "ut_module0", 1, 1);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_iobuf.num_nodes, 2);
+	CU_ASSERT_EQUAL(iobuf_ch[2].node, 1);
+	CU_ASSERT_PTR_NOT_NULL(g_iobuf.nodes[1].small_pool);
+	CU_ASSERT_EQUAL(iobuf_ch[2].small.pool, g_iobuf.nodes[1].small_pool);
+
+	spdk_iobuf_channel_fini(&iobuf_ch[0]);
+	spdk_iobuf_channel_fini(&iobuf_ch[1]);
+	spdk_iobuf_channel_fini(&iobuf_ch[2]);
+	poll_threads();
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+	CU_ASSERT_EQUAL(g_iobuf.num_nodes, 0);
+	CU_ASSERT_PTR_NULL(g_iobuf.nodes[0].small_pool);
+	CU_ASSERT_PTR_NULL(g_iobuf.nodes[1].small_pool);
+
+	MOCK_CLEAR(spdk_env_get_socket_id);
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	free_threads();
+	free_cores();
+}
+
+struct ut_iobuf_stats {
+	uint32_t			num_modules;
+	struct spdk_iobuf_module_stats	modules[2];
+	uint64_t			wait_count;
+	uint64_t			wait_ticks;
+	bool				done;
+};
+
+static void
+ut_iobuf_histogram_cb(void *ctx, uint64_t start, uint64_t end, uint64_t count, uint64_t total,
+		      uint64_t so_far)
+{
+	struct ut_iobuf_stats *stats = ctx;
+
+	if (count > 0) {
+		stats->wait_count += count;
+		stats->wait_ticks = start;
+	}
+}
+
+static void
+ut_iobuf_get_stats_cb(struct spdk_iobuf_module_stats *modules, uint32_t num_modules, void *ctx)
+{
+	struct ut_iobuf_stats *stats = ctx;
+	uint32_t i;
+
+	stats->num_modules = num_modules;
+	for (i = 0; i < spdk_min(num_modules, SPDK_COUNTOF(stats->modules)); i++) {
+		stats->modules[i] = modules[i];
+		/* The histograms are freed once the callback returns */
+		stats->modules[i].wait_histogram = NULL;
+		if (modules[i].wait_histogram != NULL) {
+			spdk_histogram_data_iterate(modules[i].wait_histogram,
+						    ut_iobuf_histogram_cb, stats);
+		}
+	}
+
+	stats->done = true;
+}
+
+static void
+iobuf_stats(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 2,
+		.large_pool_count = 2,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = LARGE_BUFSIZE,
+	};
+	struct spdk_iobuf_channel mod0_ch[2], mod1_ch[2];
+	struct ut_iobuf_entry entry = {};
+	struct ut_iobuf_stats stats = {};
+	void *bufs[4];
+	int rc, finish = 0;
+
+	allocate_cores(2);
+	allocate_threads(2);
+
+	set_thread(0);
+
+	/* We cannot use spdk_iobuf_set_opts(), as it won't allow us to use such small pools */
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_register_module("ut_module0");
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_iobuf_register_module("ut_module1");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	set_thread(0);
+	rc = spdk_iobuf_channel_init(&mod0_ch[0], "ut_module0", 1, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_iobuf_channel_init(&mod1_ch[0], "ut_module1", 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	set_thread(1);
+	rc = spdk_iobuf_channel_init(&mod0_ch[1], "ut_module0", 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	rc = spdk_iobuf_channel_init(&mod1_ch[1], "ut_module1", 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* Take the cached small buffer and the remaining one from the pool on thread 0, then
+	 * make a request from module1 wait for one */
+	set_thread(0);
+	bufs[0] = spdk_iobuf_get(&mod0_ch[0], SMALL_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(bufs[0]);
+	bufs[1] = spdk_iobuf_get(&mod0_ch[0], SMALL_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(bufs[1]);
+	entry.buf = spdk_iobuf_get(&mod1_ch[0], SMALL_BUFSIZE, &entry.iobuf, ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NULL(entry.buf);
+	CU_ASSERT_PTR_NOT_NULL(mod1_ch[0].small.wait_histogram);
+	CU_ASSERT_PTR_NULL(mod0_ch[0].small.wait_histogram);
+
+	/* Large buffers on the other thread */
+	set_thread(1);
+	bufs[2] = spdk_iobuf_get(&mod0_ch[1], LARGE_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(bufs[2]);
+	bufs[3] = spdk_iobuf_get(&mod1_ch[1], LARGE_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(bufs[3]);
+
+	/* Releasing a buffer from module0 records the time module1's request waited */
+	set_thread(0);
+	spdk_delay_us(100);
+	spdk_iobuf_put(&mod0_ch[0], bufs[0], SMALL_BUFSIZE);
+	CU_ASSERT_EQUAL(entry.buf, bufs[0]);
+
+	rc = spdk_iobuf_get_stats(ut_iobuf_get_stats_cb, &stats);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT(stats.done);
+
+	/* The modules are reported in registration order, summed up over both threads */
+	CU_ASSERT_EQUAL(stats.num_modules, 2);
+	CU_ASSERT_STRING_EQUAL(stats.modules[0].module, "ut_module0");
+	CU_ASSERT_EQUAL(stats.modules[0].small_pool.cache, 1);
+	CU_ASSERT_EQUAL(stats.modules[0].small_pool.main, 1);
+	CU_ASSERT_EQUAL(stats.modules[0].small_pool.retry, 0);
+	CU_ASSERT_EQUAL(stats.modules[0].large_pool.main, 1);
+	CU_ASSERT_STRING_EQUAL(stats.modules[1].module, "ut_module1");
+	CU_ASSERT_EQUAL(stats.modules[1].small_pool.cache, 0);
+	CU_ASSERT_EQUAL(stats.modules[1].small_pool.main, 0);
+	CU_ASSERT_EQUAL(stats.modules[1].small_pool.retry, 1);
+	CU_ASSERT_EQUAL(stats.modules[1].large_pool.main, 1);
+
+	/* A single wait of 100 ticks was recorded, with the bucket's granularity */
+	CU_ASSERT_EQUAL(stats.wait_count, 1);
+	CU_ASSERT(stats.wait_ticks <= 100 && stats.wait_ticks > 100 - (100 >> 2));
+
+	spdk_iobuf_put(&mod1_ch[0], bufs[0], SMALL_BUFSIZE);
+	spdk_iobuf_put(&mod0_ch[0], bufs[1], SMALL_BUFSIZE);
+	set_thread(1);
+	spdk_iobuf_put(&mod0_ch[1], bufs[2], LARGE_BUFSIZE);
+	spdk_iobuf_put(&mod1_ch[1], bufs[3], LARGE_BUFSIZE);
+
+	spdk_iobuf_channel_fini(&mod0_ch[1]);
+	spdk_iobuf_channel_fini(&mod1_ch[1]);
+	set_thread(0);
+	spdk_iobuf_channel_fini(&mod0_ch[0]);
+	spdk_iobuf_channel_fini(&mod1_ch[0]);
+	poll_threads();
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+
+	free_threads();
+	free_cores();
+}
+
+/* Takes count small buffers on the current thread and releases them, then lets a rebalancing
+ * period elapse. */
+static void
+ut_iobuf_rebalance_period(struct spdk_iobuf_channel *ch, uint32_t count)
+{
+	void *bufs[8];
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		bufs[i] = spdk_iobuf_get(ch, SMALL_BUFSIZE, NULL, NULL);
+		CU_ASSERT_PTR_NOT_NULL(bufs[i]);
+	}
+	for (i = 0; i < count; i++) {
+		spdk_iobuf_put(ch, bufs[i], SMALL_BUFSIZE);
+	}
+
+	spdk_delay_us(1000);
+	poll_threads();
+}
+
+static void
+iobuf_rebalance(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 8,
+		.large_pool_count = 2,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = LARGE_BUFSIZE,
+		.cache_rebalance_period_us = 1000,
+		.cache_rebalance_budget = 25,
+	};
+	struct spdk_iobuf_channel idle_ch, busy_ch;
+	int rc, finish = 0;
+
+	allocate_cores(2);
+	allocate_threads(2);
+
+	set_thread(0);
+
+	/* We cannot use spdk_iobuf_set_opts(), as it won't allow us to use such small pools */
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_register_module("ut_module");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	rc = spdk_iobuf_channel_init(&idle_ch, "ut_module", 4, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	set_thread(1);
+	rc = spdk_iobuf_channel_init(&busy_ch, "ut_module", 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* The idle cache is halved each period, while the busy one grows by the number of
+	 * buffers taken from the pool, at most doubling */
+	ut_iobuf_rebalance_period(&busy_ch, 4);
+	CU_ASSERT_EQUAL(idle_ch.small.cache_size, 2);
+	CU_ASSERT_EQUAL(idle_ch.small.cache_count, 2);
+	CU_ASSERT_EQUAL(busy_ch.small.cache_size, 1);
+
+	ut_iobuf_rebalance_period(&busy_ch, 4);
+	CU_ASSERT_EQUAL(idle_ch.small.cache_size, 1);
+	CU_ASSERT_EQUAL(busy_ch.small.cache_size, 2);
+
+	ut_iobuf_rebalance_period(&busy_ch, 4);
+	CU_ASSERT_EQUAL(idle_ch.small.cache_size, 0);
+	CU_ASSERT_EQUAL(idle_ch.small.cache_count, 0);
+	CU_ASSERT_EQUAL(busy_ch.small.cache_size, 4);
+
+	/* Once the idle cache is gone, only the budget of 2 buffers is left to grow by */
+	ut_iobuf_rebalance_period(&busy_ch, 4);
+	CU_ASSERT_EQUAL(busy_ch.small.cache_size, 6);
+	CU_ASSERT_EQUAL(g_iobuf.cache_growth[0], 2);
+
+	/* With the budget exhausted, the cache doesn't grow anymore */
+	ut_iobuf_rebalance_period(&busy_ch, 8);
+	CU_ASSERT_EQUAL(busy_ch.small.cache_size, 6);
+	CU_ASSERT_EQUAL(busy_ch.small.cache_count, 6);
+	CU_ASSERT_EQUAL(busy_ch.small.stats.main, 17);
+	CU_ASSERT_EQUAL(g_iobuf.cache_growth[0], 2);
+
+	/* An idle period shrinks the busy cache too */
+	ut_iobuf_rebalance_period(&busy_ch, 0);
+	CU_ASSERT_EQUAL(busy_ch.small.cache_size, 3);
+	CU_ASSERT_EQUAL(busy_ch.small.cache_count, 3);
+	CU_ASSERT_EQUAL(spdk_mempool_count(busy_ch.small.pool), 5);
+
+	/* The channels give back what they were rebalanced by */
+	spdk_iobuf_channel_fini(&busy_ch);
+	set_thread(0);
+	spdk_iobuf_channel_fini(&idle_ch);
+	CU_ASSERT_EQUAL(g_iobuf.cache_growth[0], 0);
+	poll_threads();
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+
+	free_threads();
+	free_cores();
+}
+
+static void
+iobuf_opts(void)
+{
+	struct spdk_iobuf_opts opts, orig = {
+		.small_pool_count = IOBUF_MIN_SMALL_POOL_SIZE,
+		.large_pool_count = IOBUF_MIN_LARGE_POOL_SIZE,
+		.small_bufsize = IOBUF_MIN_SMALL_BUFSIZE,
+		.large_bufsize = IOBUF_MIN_LARGE_BUFSIZE,
+		.opts_size = sizeof(orig),
+		.cache_rebalance_budget = 10,
+	};
+	size_t size;
+
+	CU_ASSERT_EQUAL(spdk_iobuf_set_opts(&orig), 0);
+	memset(&opts, 0, sizeof(opts));
+	spdk_iobuf_get_opts(&opts, sizeof(opts));
+	CU_ASSERT_EQUAL(opts.opts_size, sizeof(opts));
+	CU_ASSERT_EQUAL(opts.small_pool_count, orig.small_pool_count);
+	CU_ASSERT_EQUAL(opts.num_size_classes, 0);
+	CU_ASSERT_EQUAL(opts.cache_rebalance_budget, orig.cache_rebalance_budget);
+
+	/* opts_size has to be set */
+	memset(&opts, 0, sizeof(opts));
+	opts.small_pool_count = IOBUF_MIN_SMALL_POOL_SIZE * 2;
+	CU_ASSERT_EQUAL(spdk_iobuf_set_opts(&opts), -EINVAL);
+
+	/* A caller built against an older version only gets and sets the fields it knows about */
+	size = offsetof(struct spdk_iobuf_opts, opts_size) + sizeof(opts.opts_size);
+	memset(&opts, 0xff, sizeof(opts));
+	spdk_iobuf_get_opts(&opts, size);
+	CU_ASSERT_EQUAL(opts.opts_size, size);
+	CU_ASSERT_EQUAL(opts.small_pool_count, orig.small_pool_count);
+	CU_ASSERT_EQUAL(opts.large_bufsize, orig.large_bufsize);
+	CU_ASSERT_EQUAL(opts.num_size_classes, UINT32_MAX);
+	CU_ASSERT_EQUAL(opts.cache_rebalance_budget, UINT32_MAX);
+
+	opts.small_pool_count = orig.small_pool_count * 2;
+	CU_ASSERT_EQUAL(spdk_iobuf_set_opts(&opts), 0);
+
+	memset(&opts, 0, sizeof(opts));
+	spdk_iobuf_get_opts(&opts, sizeof(opts));
+	CU_ASSERT_EQUAL(opts.small_pool_count, orig.small_pool_count * 2);
+	CU_ASSERT_EQUAL(opts.num_size_classes, orig.num_size_classes);
+	CU_ASSERT_EQUAL(opts.cache_rebalance_budget, orig.cache_rebalance_budget);
+
+	CU_ASSERT_EQUAL(spdk_iobuf_set_opts(&orig), 0);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -638,6 +1336,13 @@ main(int argc, char **argv)
 	suite = CU_add_suite("io_channel", NULL, NULL);
 	CU_ADD_TEST(suite, iobuf);
 	CU_ADD_TEST(suite, iobuf_cache);
+	CU_ADD_TEST(suite, iobuf_migrate);
+	CU_ADD_TEST(suite, iobuf_size_classes);
+	CU_ADD_TEST(suite, iobuf_numa);
+	CU_ADD_TEST(suite, iobuf_lazy_init);
+	CU_ADD_TEST(suite, iobuf_stats);
+	CU_ADD_TEST(suite, iobuf_rebalance);
+	CU_ADD_TEST(suite, iobuf_opts);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 	CU_basic_run_tests();
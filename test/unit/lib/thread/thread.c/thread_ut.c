@@ -146,6 +146,144 @@ thread_send_msg(void)
 	free_threads();
 }
 
+static void
+steal_msg_cb(void *ctx)
+{
+	struct spdk_thread **thread = ctx;
+
+	*thread = spdk_get_thread();
+}
+
+static void
+thread_steal_msg(void)
+{
+	struct spdk_thread *thread0, *thread1;
+	struct spdk_thread *ran_on = NULL;
+	int rc;
+
+	allocate_threads(2);
+	set_thread(0);
+	thread0 = spdk_get_thread();
+	set_thread(1);
+	thread1 = spdk_get_thread();
+
+	/* A thread cannot steal from itself. */
+	rc = spdk_thread_steal_msgs(thread0, thread0, 0);
+	CU_ASSERT(rc == -EINVAL);
+
+	/* A stealable message is executed by its owner if nobody steals it. */
+	rc = spdk_thread_send_stealable_msg(thread0, steal_msg_cb, &ran_on);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(spdk_thread_get_stealable_msg_count(thread0) == 1);
+	CU_ASSERT(!spdk_thread_is_idle(thread0));
+	poll_thread(0);
+	CU_ASSERT(ran_on == thread0);
+	CU_ASSERT(spdk_thread_get_stealable_msg_count(thread0) == 0);
+
+	/* Thread 1 steals the message and runs it in its own context. */
+	ran_on = NULL;
+	rc = spdk_thread_send_stealable_msg(thread0, steal_msg_cb, &ran_on);
+	CU_ASSERT(rc == 0);
+	rc = spdk_thread_steal_msgs(thread1, thread0, 0);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(ran_on == thread1);
+	CU_ASSERT(spdk_thread_get_stealable_msg_count(thread0) == 0);
+
+	/* Regular messages are never stolen. */
+	ran_on = NULL;
+	rc = spdk_thread_send_msg(thread0, steal_msg_cb, &ran_on);
+	CU_ASSERT(rc == 0);
+	rc = spdk_thread_steal_msgs(thread1, thread0, 0);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(ran_on == NULL);
+	poll_thread(0);
+	CU_ASSERT(ran_on == thread0);
+
+	free_threads();
+}
+
+struct ut_batch_msg {
+	struct spdk_thread	*thread;
+	uint32_t		order;
+};
+
+static uint32_t g_batch_msg_order;
+
+static void
+batch_msg_cb(void *ctx)
+{
+	struct ut_batch_msg *msg = ctx;
+
+	msg->thread = spdk_get_thread();
+	msg->order = g_batch_msg_order++;
+}
+
+static void
+thread_msg_batch(void)
+{
+	struct spdk_thread_msg_batch *batch;
+	struct spdk_thread *thread1, *thread2;
+	struct ut_batch_msg msgs[3] = {};
+
+	allocate_threads(3);
+	set_thread(1);
+	thread1 = spdk_get_thread();
+	set_thread(2);
+	thread2 = spdk_get_thread();
+	set_thread(0);
+
+	CU_ASSERT(spdk_thread_msg_batch_alloc(0) == NULL);
+	batch = spdk_thread_msg_batch_alloc(3);
+	SPDK_CU_ASSERT_FATAL(batch != NULL);
+
+	/* Submitting an empty batch is a nop. */
+	CU_ASSERT(spdk_thread_msg_batch_submit(batch) == 0);
+
+	CU_ASSERT(spdk_thread_msg_batch_add(batch, thread1, batch_msg_cb, &msgs[0]) == 0);
+	CU_ASSERT(spdk_thread_msg_batch_add(batch, thread2, batch_msg_cb, &msgs[1]) == 0);
+	CU_ASSERT(spdk_thread_msg_batch_add(batch, thread1, batch_msg_cb, &msgs[2]) == 0);
+	CU_ASSERT(spdk_thread_msg_batch_add(batch, thread2, batch_msg_cb, &msgs[1]) == -ENOSPC);
+
+	/* Nothing is sent before the batch is submitted. */
+	poll_threads();
+	CU_ASSERT(msgs[0].thread == NULL);
+	CU_ASSERT(msgs[1].thread == NULL);
+	CU_ASSERT(msgs[2].thread == NULL);
+
+	CU_ASSERT(spdk_thread_msg_batch_submit(batch) == 0);
+	CU_ASSERT(spdk_ring_count(thread1->messages) == 2);
+	CU_ASSERT(spdk_ring_count(thread2->messages) == 1);
+
+	/* Messages to the same thread keep their order. */
+	poll_thread(1);
+	CU_ASSERT(msgs[0].thread == thread1);
+	CU_ASSERT(msgs[0].order == 0);
+	CU_ASSERT(msgs[2].thread == thread1);
+	CU_ASSERT(msgs[2].order == 1);
+	CU_ASSERT(msgs[1].thread == NULL);
+	poll_thread(2);
+	CU_ASSERT(msgs[1].thread == thread2);
+
+	/* The batch is reset after submission and can be reused. */
+	memset(msgs, 0, sizeof(msgs));
+	CU_ASSERT(spdk_thread_msg_batch_add(batch, thread2, batch_msg_cb, &msgs[0]) == 0);
+	CU_ASSERT(spdk_thread_msg_batch_submit(batch) == 0);
+	poll_threads();
+	CU_ASSERT(msgs[0].thread == thread2);
+
+	/* Messages can't be added for an exited thread. */
+	set_thread(2);
+	spdk_thread_exit(thread2);
+	poll_threads();
+	set_thread(0);
+	CU_ASSERT(spdk_thread_msg_batch_add(batch, thread2, batch_msg_cb, &msgs[0]) == -EIO);
+
+	spdk_thread_msg_batch_free(batch);
+	g_batch_msg_order = 0;
+
+	free_threads();
+}
+
 static int
 poller_run_done(void *ctx)
 {
@@ -805,6 +943,133 @@ channel(void)
 	CU_ASSERT(TAILQ_EMPTY(&g_threads));
 }
 
+static void
+channel_socket_id(void)
+{
+	struct spdk_io_channel *ch1, *ch2;
+	struct spdk_thread *thread;
+
+	allocate_threads(1);
+	set_thread(0);
+	thread = spdk_get_thread();
+
+	CU_ASSERT(spdk_io_device_set_socket_id(&g_device1, 1) == -ENODEV);
+
+	spdk_io_device_register(&g_device1, create_cb_1, destroy_cb_1, sizeof(g_ctx1), NULL);
+	spdk_io_device_register(&g_device2, create_cb_2, destroy_cb_2, sizeof(g_ctx2), NULL);
+
+	/* No channels, no home socket. */
+	CU_ASSERT(spdk_thread_get_socket_id(thread) == SPDK_ENV_SOCKET_ID_ANY);
+
+	/* Channel of a device without a socket doesn't count. */
+	ch1 = spdk_get_io_channel(&g_device1);
+	SPDK_CU_ASSERT_FATAL(ch1 != NULL);
+	CU_ASSERT(spdk_thread_get_socket_id(thread) == SPDK_ENV_SOCKET_ID_ANY);
+
+	CU_ASSERT(spdk_io_device_set_socket_id(&g_device1, 1) == 0);
+	CU_ASSERT(spdk_thread_get_socket_id(thread) == 1);
+
+	CU_ASSERT(spdk_io_device_set_socket_id(&g_device2, 0) == 0);
+	ch2 = spdk_get_io_channel(&g_device2);
+	SPDK_CU_ASSERT_FATAL(ch2 != NULL);
+	CU_ASSERT(spdk_thread_get_socket_id(thread) == 1 || spdk_thread_get_socket_id(thread) == 0);
+
+	spdk_put_io_channel(ch1);
+	poll_threads();
+	CU_ASSERT(spdk_thread_get_socket_id(thread) == 0);
+
+	spdk_put_io_channel(ch2);
+	poll_threads();
+	CU_ASSERT(spdk_thread_get_socket_id(thread) == SPDK_ENV_SOCKET_ID_ANY);
+
+	spdk_io_device_unregister(&g_device1, NULL);
+	poll_threads();
+	spdk_io_device_unregister(&g_device2, NULL);
+	poll_threads();
+	CU_ASSERT(RB_EMPTY(&g_io_devices));
+	free_threads();
+}
+
+static int g_migrate_cb_calls;
+static void *g_migrate_ctx;
+
+static void
+migrate_cb(void *io_device, void *ctx_buf)
+{
+	CU_ASSERT(io_device == &g_device1);
+	g_migrate_ctx = ctx_buf;
+	g_migrate_cb_calls++;
+}
+
+static void
+channel_migrate(void)
+{
+	struct spdk_io_channel *ch1, *ch2;
+	struct spdk_thread *thread;
+
+	allocate_threads(1);
+	set_thread(0);
+	thread = spdk_get_thread();
+
+	CU_ASSERT(spdk_io_device_set_migrate_cb(&g_device1, migrate_cb) == -ENODEV);
+
+	spdk_io_device_register(&g_device1, create_cb_1, destroy_cb_1, sizeof(g_ctx1), NULL);
+	spdk_io_device_register(&g_device2, create_cb_2, destroy_cb_2, sizeof(g_ctx2), NULL);
+	CU_ASSERT(spdk_io_device_set_migrate_cb(&g_device1, migrate_cb) == 0);
+
+	ch1 = spdk_get_io_channel(&g_device1);
+	SPDK_CU_ASSERT_FATAL(ch1 != NULL);
+	ch2 = spdk_get_io_channel(&g_device2);
+	SPDK_CU_ASSERT_FATAL(ch2 != NULL);
+
+	/* First placement doesn't migrate anything. */
+	MOCK_SET(spdk_env_get_current_core, 0);
+	MOCK_SET(spdk_env_get_socket_id, 0);
+	g_migrate_cb_calls = 0;
+	CU_ASSERT(spdk_thread_notify_migration(thread, 0) == 0);
+	poll_threads();
+	CU_ASSERT(g_migrate_cb_calls == 0);
+
+	/* Neither does a move within the socket. */
+	CU_ASSERT(spdk_thread_notify_migration(thread, 0) == 0);
+	poll_threads();
+	CU_ASSERT(g_migrate_cb_calls == 0);
+
+	/* Moving to another socket calls the callback once the thread runs there,
+	 * only for the devices which set one. */
+	MOCK_SET(spdk_env_get_socket_id, 1);
+	CU_ASSERT(spdk_thread_notify_migration(thread, 1) == 0);
+	CU_ASSERT(g_migrate_cb_calls == 0);
+	poll_threads();
+	CU_ASSERT(g_migrate_cb_calls == 1);
+	CU_ASSERT(g_migrate_ctx == spdk_io_channel_get_ctx(ch1));
+
+	/* If the thread moved back before being polled, there's nothing left to do. */
+	g_migrate_cb_calls = 0;
+	CU_ASSERT(spdk_thread_notify_migration(thread, 0) == 0);
+	poll_threads();
+	CU_ASSERT(g_migrate_cb_calls == 0);
+
+	/* Channels being released are skipped. */
+	MOCK_SET(spdk_env_get_socket_id, 0);
+	CU_ASSERT(spdk_thread_notify_migration(thread, 0) == 0);
+	spdk_put_io_channel(ch1);
+	poll_threads();
+	CU_ASSERT(g_migrate_cb_calls == 0);
+
+	MOCK_CLEAR(spdk_env_get_socket_id);
+	MOCK_CLEAR(spdk_env_get_current_core);
+
+	spdk_put_io_channel(ch2);
+	poll_threads();
+	spdk_io_device_unregister(&g_device1, NULL);
+	poll_threads();
+	spdk_io_device_unregister(&g_device2, NULL);
+	poll_threads();
+	CU_ASSERT(RB_EMPTY(&g_io_devices));
+	free_threads();
+}
+
 static int
 create_cb(void *io_device, void *ctx_buf)
 {
@@ -1102,6 +1367,140 @@ thread_update_stats_test(void)
 	free_threads();
 }
 
+static uint64_t
+histogram_get_count(const struct spdk_histogram_data *histogram, uint64_t datapoint)
+{
+	struct spdk_histogram_data *h = (struct spdk_histogram_data *)histogram;
+	uint32_t range = __spdk_histogram_data_get_bucket_range(h, datapoint);
+	uint32_t index = __spdk_histogram_data_get_bucket_index(h, datapoint, range);
+
+	return __spdk_histogram_get_count(h, range, index);
+}
+
+static void
+poller_histogram(void)
+{
+	struct spdk_poller *poller;
+	const struct spdk_histogram_data *histogram;
+
+	MOCK_SET(spdk_get_ticks, 10);
+
+	allocate_threads(1);
+	set_thread(0);
+
+	poller = spdk_poller_register(poller_run_busy, (void *)100, 0);
+	CU_ASSERT(poller != NULL);
+
+	/* Histograms are disabled by default. */
+	poll_thread_times(0, 1);
+	CU_ASSERT(spdk_poller_get_histogram(poller) == NULL);
+	CU_ASSERT(poller->histogram == NULL);
+
+	/* Once enabled, each run is accounted for. */
+	spdk_poller_enable_histograms(true);
+	CU_ASSERT(spdk_poller_histograms_enabled());
+	CU_ASSERT(spdk_poller_get_histogram(poller) == NULL);
+
+	poll_thread_times(0, 1);
+	histogram = spdk_poller_get_histogram(poller);
+	SPDK_CU_ASSERT_FATAL(histogram != NULL);
+	CU_ASSERT(histogram->bucket_shift == SPDK_POLLER_HISTOGRAM_BUCKET_SHIFT);
+	CU_ASSERT(histogram_get_count(histogram, 100) == 1);
+
+	poll_thread_times(0, 1);
+	CU_ASSERT(histogram_get_count(histogram, 100) == 2);
+
+	/* Disabling hides the histogram right away and frees it on the next run. */
+	spdk_poller_enable_histograms(false);
+	CU_ASSERT(!spdk_poller_histograms_enabled());
+	CU_ASSERT(spdk_poller_get_histogram(poller) == NULL);
+
+	poll_thread_times(0, 1);
+	CU_ASSERT(poller->histogram == NULL);
+
+	/* Re-enabling starts from an empty histogram. */
+	spdk_poller_enable_histograms(true);
+	poll_thread_times(0, 1);
+	histogram = spdk_poller_get_histogram(poller);
+	SPDK_CU_ASSERT_FATAL(histogram != NULL);
+	CU_ASSERT(histogram_get_count(histogram, 100) == 1);
+
+	/* The histogram is released along with the poller. */
+	spdk_poller_unregister(&poller);
+	poll_thread_times(0, 1);
+
+	spdk_poller_enable_histograms(false);
+
+	MOCK_CLEAR(spdk_get_ticks);
+
+	free_threads();
+}
+
+static void
+thread_adaptive_interrupt(void)
+{
+	struct spdk_thread *thread;
+	struct spdk_thread_intr_stats stats;
+	bool done = false;
+
+	CU_ASSERT(spdk_thread_set_adaptive_interrupt(100) == -ENOTSUP);
+
+	MOCK_SET(spdk_get_ticks, 10);
+	g_interrupt_mode = true;
+
+	allocate_threads(1);
+	set_thread(0);
+	thread = spdk_get_thread();
+
+	/* Threads start in interrupt mode, make this one poll first. */
+	spdk_thread_set_interrupt_mode(false);
+	CU_ASSERT(!thread->in_interrupt);
+
+	CU_ASSERT(spdk_thread_set_adaptive_interrupt(100) == 0);
+	CU_ASSERT(spdk_thread_get_adaptive_interrupt() == 100);
+
+	/* The thread keeps polling until it idles for longer than the budget. */
+	poll_thread_times(0, 1);
+	spdk_delay_us(50);
+	poll_thread_times(0, 1);
+	CU_ASSERT(!thread->in_interrupt);
+
+	spdk_delay_us(60);
+	poll_thread_times(0, 1);
+	CU_ASSERT(thread->in_interrupt);
+	spdk_thread_get_intr_stats(thread, &stats);
+	CU_ASSERT(stats.to_intr_count == 1);
+	CU_ASSERT(stats.to_poll_count == 0);
+
+	/* The first event brings it back to poll mode. */
+	spdk_thread_send_msg(thread, send_msg_cb, &done);
+	poll_thread_times(0, 1);
+	CU_ASSERT(done);
+	CU_ASSERT(!thread->in_interrupt);
+	spdk_thread_get_intr_stats(thread, &stats);
+	CU_ASSERT(stats.to_intr_count == 1);
+	CU_ASSERT(stats.to_poll_count == 1);
+
+	/* Explicitly set interrupt mode is kept even after events. */
+	spdk_thread_set_interrupt_mode(true);
+	done = false;
+	spdk_thread_send_msg(thread, send_msg_cb, &done);
+	poll_thread_times(0, 1);
+	CU_ASSERT(done);
+	CU_ASSERT(thread->in_interrupt);
+	spdk_thread_get_intr_stats(thread, &stats);
+	CU_ASSERT(stats.to_poll_count == 1);
+
+	CU_ASSERT(spdk_thread_set_adaptive_interrupt(0) == 0);
+
+	/* Exiting in interrupt mode needs a thread op to reschedule the thread. */
+	spdk_thread_set_interrupt_mode(false);
+	free_threads();
+
+	g_interrupt_mode = false;
+	MOCK_CLEAR(spdk_get_ticks);
+}
+
 struct ut_nested_ch {
 	struct spdk_io_channel *child;
 	struct spdk_poller *poller;
@@ -1638,6 +2037,150 @@ multi_timed_pollers_have_same_expiration(void)
 	free_threads();
 }
 
+struct ut_timer_poller {
+	struct spdk_poller	*poller;
+	uint64_t		period_us;
+	uint64_t		next_due;
+	uint32_t		run_count;
+};
+
+static int
+ut_timer_poller_fn(void *arg)
+{
+	struct ut_timer_poller *ctx = arg;
+
+	/* Never run early. */
+	CU_ASSERT(spdk_get_ticks() >= ctx->next_due);
+	ctx->next_due = spdk_get_ticks() + ctx->period_us;
+	ctx->run_count++;
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+timer_wheel(void)
+{
+	struct ut_timer_poller ctxs[64] = {}, far = {};
+	struct spdk_thread *thread;
+	struct spdk_poller *poller;
+	uint64_t now, next_due, seed = 1;
+	uint32_t i, j, count;
+
+	CU_ASSERT(spdk_thread_lib_set_timer_type(SPDK_THREAD_TIMER_WHEEL + 1) == -EINVAL);
+	CU_ASSERT(spdk_thread_lib_set_timer_type(SPDK_THREAD_TIMER_WHEEL) == 0);
+	CU_ASSERT(spdk_thread_lib_init_ext(NULL, NULL, 0, SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+	CU_ASSERT(spdk_thread_lib_set_timer_type(SPDK_THREAD_TIMER_RBTREE) == -EBUSY);
+
+	thread = spdk_thread_create(NULL, NULL);
+	SPDK_CU_ASSERT_FATAL(thread != NULL);
+	spdk_set_thread(thread);
+	SPDK_CU_ASSERT_FATAL(thread->timer_wheel != NULL);
+	CU_ASSERT(!spdk_thread_has_pollers(thread));
+
+	/* Periods spread over the first 4 levels of the wheel. */
+	for (i = 0; i < SPDK_COUNTOF(ctxs); i++) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		ctxs[i].period_us = 1 + (seed >> 33) % (1U << (6 * (i % 4 + 1)));
+		ctxs[i].next_due = spdk_get_ticks() + ctxs[i].period_us;
+		ctxs[i].poller = spdk_poller_register(ut_timer_poller_fn, &ctxs[i],
+						      ctxs[i].period_us);
+		SPDK_CU_ASSERT_FATAL(ctxs[i].poller != NULL);
+	}
+	CU_ASSERT(spdk_thread_has_pollers(thread));
+
+	/* All pollers can be iterated over. */
+	count = 0;
+	for (poller = spdk_thread_get_first_timed_poller(thread); poller != NULL;
+	     poller = spdk_thread_get_next_timed_poller(poller)) {
+		count++;
+	}
+	CU_ASSERT(count == SPDK_COUNTOF(ctxs));
+
+	/* Each poller runs exactly once it is due, whatever the steps of the time are. */
+	for (j = 0; j < 2000; j++) {
+		next_due = UINT64_MAX;
+		for (i = 0; i < SPDK_COUNTOF(ctxs); i++) {
+			next_due = spdk_min(next_due, ctxs[i].next_due);
+		}
+		CU_ASSERT(spdk_thread_next_poller_expiration(thread) == next_due);
+
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		spdk_delay_us((seed >> 33) % (j % 2 ? 64 : 20000));
+		spdk_thread_poll(thread, 0, 0);
+
+		now = spdk_get_ticks();
+		for (i = 0; i < SPDK_COUNTOF(ctxs); i++) {
+			CU_ASSERT(ctxs[i].next_due > now);
+		}
+	}
+
+	/* Paused and unregistered pollers don't run anymore. */
+	for (i = 0; i < SPDK_COUNTOF(ctxs); i++) {
+		if (i % 2) {
+			spdk_poller_pause(ctxs[i].poller);
+		} else {
+			spdk_poller_unregister(&ctxs[i].poller);
+		}
+		ctxs[i].run_count = 0;
+	}
+	spdk_delay_us(1U << 24);
+	spdk_thread_poll(thread, 0, 0);
+	spdk_delay_us(1U << 24);
+	spdk_thread_poll(thread, 0, 0);
+	for (i = 0; i < SPDK_COUNTOF(ctxs); i++) {
+		CU_ASSERT(ctxs[i].run_count == 0);
+	}
+	CU_ASSERT(spdk_thread_get_first_timed_poller(thread) == NULL);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == 0);
+
+	/* Resumed pollers are queued again. */
+	now = spdk_get_ticks();
+	for (i = 1; i < SPDK_COUNTOF(ctxs); i += 2) {
+		spdk_poller_resume(ctxs[i].poller);
+		ctxs[i].next_due = now + ctxs[i].period_us;
+	}
+	spdk_delay_us(1U << 24);
+	spdk_thread_poll(thread, 0, 0);
+	for (i = 1; i < SPDK_COUNTOF(ctxs); i += 2) {
+		CU_ASSERT(ctxs[i].run_count == 1);
+		spdk_poller_unregister(&ctxs[i].poller);
+	}
+
+	/* A period beyond the range of the wheel is requeued until it is due. */
+	far.period_us = 1ULL << 31;
+	far.next_due = spdk_get_ticks() + far.period_us;
+	far.poller = spdk_poller_register(ut_timer_poller_fn, &far, far.period_us);
+	SPDK_CU_ASSERT_FATAL(far.poller != NULL);
+
+	spdk_delay_us(1ULL << 30);
+	spdk_thread_poll(thread, 0, 0);
+	CU_ASSERT(far.run_count == 0);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == far.next_due);
+
+	spdk_delay_us(far.next_due - spdk_get_ticks() - 1);
+	spdk_thread_poll(thread, 0, 0);
+	CU_ASSERT(far.run_count == 0);
+
+	spdk_delay_us(1);
+	spdk_thread_poll(thread, 0, 0);
+	CU_ASSERT(far.run_count == 1);
+
+	/* Unregistered timed pollers are released once they expire. */
+	spdk_poller_unregister(&far.poller);
+	spdk_delay_us(far.period_us);
+	spdk_thread_poll(thread, 0, 0);
+	CU_ASSERT(!spdk_thread_has_pollers(thread));
+	CU_ASSERT(thread->timer_wheel->count == 0);
+
+	spdk_thread_exit(thread);
+	while (!spdk_thread_is_exited(thread)) {
+		spdk_thread_poll(thread, 0, 0);
+	}
+	spdk_thread_destroy(thread);
+	spdk_set_thread(NULL);
+	spdk_thread_lib_fini();
+}
+
 static int
 dummy_create_cb(void *io_device, void *ctx_buf)
 {
@@ -1926,6 +2469,8 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, thread_alloc);
 	CU_ADD_TEST(suite, thread_send_msg);
+	CU_ADD_TEST(suite, thread_steal_msg);
+	CU_ADD_TEST(suite, thread_msg_batch);
 	CU_ADD_TEST(suite, thread_poller);
 	CU_ADD_TEST(suite, poller_pause);
 	CU_ADD_TEST(suite, thread_for_each);
@@ -1933,13 +2478,18 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, for_each_channel_unreg);
 	CU_ADD_TEST(suite, thread_name);
 	CU_ADD_TEST(suite, channel);
+	CU_ADD_TEST(suite, channel_socket_id);
+	CU_ADD_TEST(suite, channel_migrate);
 	CU_ADD_TEST(suite, channel_destroy_races);
 	CU_ADD_TEST(suite, thread_exit_test);
 	CU_ADD_TEST(suite, thread_update_stats_test);
+	CU_ADD_TEST(suite, poller_histogram);
+	CU_ADD_TEST(suite, thread_adaptive_interrupt);
 	CU_ADD_TEST(suite, nested_channel);
 	CU_ADD_TEST(suite, device_unregister_and_thread_exit_race);
 	CU_ADD_TEST(suite, cache_closest_timed_poller);
 	CU_ADD_TEST(suite, multi_timed_pollers_have_same_expiration);
+	CU_ADD_TEST(suite, timer_wheel);
 	CU_ADD_TEST(suite, io_device_lookup);
 	CU_ADD_TEST(suite, spdk_spin);
 
@@ -317,6 +317,85 @@ test_mask_clear(void)
 	spdk_bit_array_free(&ba);
 }
 
+static void
+test_find_summary(void)
+{
+	/* Large enough for the summaries to span a few words */
+	const uint32_t num_bits = 64 * 64 * 6 + 17;
+	struct spdk_bit_array *ba;
+	uint32_t i;
+
+	ba = spdk_bit_array_create(num_bits);
+	SPDK_CU_ASSERT_FATAL(ba != NULL);
+
+	/* Set all bits, leaving a single clear one far from the start */
+	for (i = 0; i < num_bits; i++) {
+		CU_ASSERT(spdk_bit_array_set(ba, i) == 0);
+	}
+	CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == UINT32_MAX);
+
+	spdk_bit_array_clear(ba, 64 * 64 * 5 + 3);
+	CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == 64 * 64 * 5 + 3);
+	CU_ASSERT(spdk_bit_array_find_first_clear(ba, 64 * 64 * 5 + 3) == 64 * 64 * 5 + 3);
+	CU_ASSERT(spdk_bit_array_find_first_clear(ba, 64 * 64 * 5 + 4) == UINT32_MAX);
+
+	/* Filling the word back makes it full again */
+	CU_ASSERT(spdk_bit_array_set(ba, 64 * 64 * 5 + 3) == 0);
+	CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == UINT32_MAX);
+
+	/* The last, partial word is never full */
+	spdk_bit_array_clear(ba, num_bits - 1);
+	CU_ASSERT(spdk_bit_array_find_first_clear(ba, 0) == num_bits - 1);
+
+	/* Same with a single set bit */
+	spdk_bit_array_clear_mask(ba);
+	CU_ASSERT(spdk_bit_array_find_first_set(ba, 0) == UINT32_MAX);
+	CU_ASSERT(spdk_bit_array_set(ba, 64 * 64 * 4 + 63) == 0);
+	CU_ASSERT(spdk_bit_array_find_first_set(ba, 0) == 64 * 64 * 4 + 63);
+	CU_ASSERT(spdk_bit_array_find_first_set(ba, 64 * 64 * 4 + 64) == UINT32_MAX);
+	spdk_bit_array_clear(ba, 64 * 64 * 4 + 63);
+	CU_ASSERT(spdk_bit_array_find_first_set(ba, 0) == UINT32_MAX);
+
+	/* The summaries follow resizing */
+	CU_ASSERT(spdk_bit_array_set(ba, num_bits - 1) == 0);
+	CU_ASSERT(spdk_bit_array_resize(&ba, num_bits * 2) == 0);
+	CU_ASSERT(spdk_bit_array_find_first_set(ba, 0) == num_bits - 1);
+	CU_ASSERT(spdk_bit_array_find_first_set(ba, num_bits) == UINT32_MAX);
+	CU_ASSERT(spdk_bit_array_resize(&ba, num_bits - 1) == 0);
+	CU_ASSERT(spdk_bit_array_find_first_set(ba, 0) == UINT32_MAX);
+
+	spdk_bit_array_free(&ba);
+}
+
+static void
+test_pool_allocate_at(void)
+{
+	struct spdk_bit_pool *pool;
+
+	pool = spdk_bit_pool_create(8);
+	SPDK_CU_ASSERT_FATAL(pool != NULL);
+
+	CU_ASSERT(spdk_bit_pool_allocate_bit_at(pool, 8) == -EINVAL);
+
+	/* Allocating a bit above the lowest free one doesn't change the next allocation */
+	CU_ASSERT(spdk_bit_pool_allocate_bit_at(pool, 3) == 0);
+	CU_ASSERT(spdk_bit_pool_is_allocated(pool, 3));
+	CU_ASSERT(spdk_bit_pool_allocate_bit_at(pool, 3) == -EEXIST);
+	CU_ASSERT(spdk_bit_pool_count_free(pool) == 7);
+
+	/* Allocating the lowest free bit moves on to the next clear one */
+	CU_ASSERT(spdk_bit_pool_allocate_bit_at(pool, 0) == 0);
+	CU_ASSERT(spdk_bit_pool_allocate_bit(pool) == 1);
+	CU_ASSERT(spdk_bit_pool_allocate_bit(pool) == 2);
+	CU_ASSERT(spdk_bit_pool_allocate_bit(pool) == 4);
+	CU_ASSERT(spdk_bit_pool_count_free(pool) == 3);
+
+	spdk_bit_pool_free_bit(pool, 3);
+	CU_ASSERT(spdk_bit_pool_allocate_bit(pool) == 3);
+
+	spdk_bit_pool_free(&pool);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -336,6 +415,8 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_count);
 	CU_ADD_TEST(suite, test_mask_store_load);
 	CU_ADD_TEST(suite, test_mask_clear);
+	CU_ADD_TEST(suite, test_find_summary);
+	CU_ADD_TEST(suite, test_pool_allocate_at);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 
@@ -114,6 +114,31 @@ test_crc32c(void)
 	CU_ASSERT(crc == 0x6087809A);
 }
 
+static void
+test_crc32c_table(void)
+{
+	struct spdk_crc32_table table;
+	uint8_t buf[4096 + 8];
+	size_t offset, len;
+	uint32_t i;
+
+	/* Compare against the table implementation for all alignments and for lengths covering both
+	 * short buffers and the interleaved streams of the optimized implementations. */
+	crc32_table_init(&table, SPDK_CRC32C_POLYNOMIAL_REFLECT);
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = (uint8_t)(i * 31 + (i >> 8));
+	}
+
+	for (offset = 0; offset < 8; offset++) {
+		for (len = 0; len <= 4096; len += (len < 16 ? 1 : 253)) {
+			CU_ASSERT(spdk_crc32c_update(&buf[offset], len, 0xFFFFFFFFu) ==
+				  crc32_update(&table, &buf[offset], len, 0xFFFFFFFFu));
+		}
+		CU_ASSERT(spdk_crc32c_update(&buf[offset], 4096, 0x12345678u) ==
+			  crc32_update(&table, &buf[offset], 4096, 0x12345678u));
+	}
+}
+
 int
 main(int argc, char **argv)
 {
@@ -126,6 +151,7 @@ main(int argc, char **argv)
 	suite = CU_add_suite("crc32c", NULL, NULL);
 
 	CU_ADD_TEST(suite, test_crc32c);
+	CU_ADD_TEST(suite, test_crc32c_table);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 
@@ -503,6 +503,29 @@ test_strcpy_replace(void)
 	CU_ASSERT(strcmp(result, expected7) == 0);
 }
 
+static void
+test_mem_all_zero(void)
+{
+	uint8_t buf[4099] = {};
+	size_t i;
+
+	CU_ASSERT(spdk_mem_all_zero(buf, 0));
+	CU_ASSERT(spdk_mem_all_zero(buf, 1));
+	CU_ASSERT(spdk_mem_all_zero(buf, sizeof(buf)));
+
+	/* Check that a single non-zero byte is found at any position */
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = 0xff;
+		CU_ASSERT(!spdk_mem_all_zero(buf, sizeof(buf)));
+		CU_ASSERT(spdk_mem_all_zero(buf, i));
+		buf[i] = 0;
+	}
+
+	/* Equal non-zero bytes */
+	memset(buf, 0x5a, sizeof(buf));
+	CU_ASSERT(!spdk_mem_all_zero(buf, sizeof(buf)));
+}
+
 int
 main(int argc, char **argv)
 {
@@ -522,6 +545,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_strtoll);
 	CU_ADD_TEST(suite, test_strarray);
 	CU_ADD_TEST(suite, test_strcpy_replace);
+	CU_ADD_TEST(suite, test_mem_all_zero);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 
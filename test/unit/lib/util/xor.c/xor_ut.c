@@ -97,6 +97,142 @@ test_xor_gen(void)
 	free(ref);
 }
 
+/* Reference Q, the sum of 2^i * sources[i] in GF(2^8) */
+static void
+ref_q_gen(uint8_t *q, void **sources, uint32_t n, size_t len)
+{
+	size_t i, j, k;
+
+	memset(q, 0, len);
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < len; j++) {
+			uint8_t b = ((uint8_t *)sources[i])[j];
+
+			for (k = 0; k < i; k++) {
+				b = (b << 1) ^ (b & 0x80 ? 0x1d : 0);
+			}
+			q[j] ^= b;
+		}
+	}
+}
+
+static void
+test_pq_gen(void)
+{
+	void *bufs[SRC_BUF_COUNT];
+	void *bufs2[SRC_BUF_COUNT];
+	uint8_t *p, *q, *ref_p, *ref_q;
+	size_t i, j;
+	int ret;
+
+	for (i = 0; i < SRC_BUF_COUNT; i++) {
+		ret = posix_memalign(&bufs[i], spdk_xor_get_optimal_alignment(), BUF_SIZE);
+		SPDK_CU_ASSERT_FATAL(ret == 0);
+
+		for (j = 0; j < BUF_SIZE; j++) {
+			((uint8_t *)bufs[i])[j] = rand();
+		}
+	}
+	ret = posix_memalign((void **)&p, spdk_xor_get_optimal_alignment(), BUF_SIZE);
+	SPDK_CU_ASSERT_FATAL(ret == 0);
+	ret = posix_memalign((void **)&q, spdk_xor_get_optimal_alignment(), BUF_SIZE);
+	SPDK_CU_ASSERT_FATAL(ret == 0);
+	ref_p = malloc(BUF_SIZE);
+	SPDK_CU_ASSERT_FATAL(ref_p != NULL);
+	ref_q = malloc(BUF_SIZE);
+	SPDK_CU_ASSERT_FATAL(ref_q != NULL);
+
+	ret = spdk_xor_gen(ref_p, bufs, SRC_BUF_COUNT, BUF_SIZE);
+	CU_ASSERT(ret == 0);
+	ref_q_gen(ref_q, bufs, SRC_BUF_COUNT, BUF_SIZE);
+
+	ret = spdk_pq_gen(p, q, bufs, SRC_BUF_COUNT, BUF_SIZE);
+	CU_ASSERT(ret == 0);
+	CU_ASSERT(memcmp(p, ref_p, BUF_SIZE) == 0);
+	CU_ASSERT(memcmp(q, ref_q, BUF_SIZE) == 0);
+
+	/* Only Q, len not multiple of alignment */
+	memset(q, 0xba, BUF_SIZE);
+	ret = spdk_pq_gen(NULL, q, bufs, SRC_BUF_COUNT, BUF_SIZE - 1);
+	CU_ASSERT(ret == 0);
+	CU_ASSERT(memcmp(q, ref_q, BUF_SIZE - 1) == 0);
+
+	/* unaligned buffers */
+	memcpy(bufs2, bufs, sizeof(bufs2));
+	bufs2[1] += 1;
+	bufs2[2] += 2;
+	ret = spdk_xor_gen(ref_p, bufs2, SRC_BUF_COUNT, BUF_SIZE - 2);
+	CU_ASSERT(ret == 0);
+	ref_q_gen(ref_q, bufs2, SRC_BUF_COUNT, BUF_SIZE - 2);
+
+	ret = spdk_pq_gen(p + 1, q + 3, bufs2, SRC_BUF_COUNT, BUF_SIZE - 3);
+	CU_ASSERT(ret == 0);
+	CU_ASSERT(memcmp(p + 1, ref_p, BUF_SIZE - 3) == 0);
+	CU_ASSERT(memcmp(q + 3, ref_q, BUF_SIZE - 3) == 0);
+
+	CU_ASSERT(spdk_pq_gen(p, q, bufs, 1, BUF_SIZE) == -EINVAL);
+	CU_ASSERT(spdk_pq_gen(p, NULL, bufs, SRC_BUF_COUNT, BUF_SIZE) == -EINVAL);
+
+	for (i = 0; i < SRC_BUF_COUNT; i++) {
+		free(bufs[i]);
+	}
+	free(p);
+	free(q);
+	free(ref_p);
+	free(ref_q);
+}
+
+static void
+test_pq_recover(void)
+{
+	void *bufs[SRC_BUF_COUNT + 2];
+	void *ref[SRC_BUF_COUNT + 2];
+	uint32_t n = SRC_BUF_COUNT;
+	uint32_t a, b;
+	size_t i, j;
+	int ret;
+
+	for (i = 0; i < SRC_BUF_COUNT + 2; i++) {
+		ret = posix_memalign(&bufs[i], spdk_xor_get_optimal_alignment(), BUF_SIZE);
+		SPDK_CU_ASSERT_FATAL(ret == 0);
+		ref[i] = malloc(BUF_SIZE);
+		SPDK_CU_ASSERT_FATAL(ref[i] != NULL);
+
+		for (j = 0; j < BUF_SIZE; j++) {
+			((uint8_t *)bufs[i])[j] = rand();
+		}
+	}
+
+	ret = spdk_pq_gen(bufs[n], bufs[n + 1], bufs, n, BUF_SIZE);
+	CU_ASSERT(ret == 0);
+	for (i = 0; i < SRC_BUF_COUNT + 2; i++) {
+		memcpy(ref[i], bufs[i], BUF_SIZE);
+	}
+
+	/* Every single and double loss of the sources and the parity */
+	for (a = 0; a < n + 2; a++) {
+		for (b = a; b < n + 2; b++) {
+			memset(bufs[a], 0xba, BUF_SIZE);
+			memset(bufs[b], 0xba, BUF_SIZE);
+
+			ret = spdk_pq_recover(bufs, bufs[n], bufs[n + 1], n, BUF_SIZE, b, a);
+			CU_ASSERT(ret == 0);
+
+			for (i = 0; i < SRC_BUF_COUNT + 2; i++) {
+				CU_ASSERT(memcmp(ref[i], bufs[i], BUF_SIZE) == 0);
+			}
+		}
+	}
+
+	CU_ASSERT(spdk_pq_recover(bufs, bufs[n], bufs[n + 1], n, BUF_SIZE, 0, n + 2) == -EINVAL);
+	CU_ASSERT(spdk_pq_recover(bufs, bufs[n], bufs[n + 1], 1, BUF_SIZE, 0, 0) == -EINVAL);
+
+	for (i = 0; i < SRC_BUF_COUNT + 2; i++) {
+		free(bufs[i]);
+		free(ref[i]);
+	}
+}
+
 int
 main(int argc, char **argv)
 {
@@ -109,6 +245,8 @@ main(int argc, char **argv)
 	suite = CU_add_suite("xor", NULL, NULL);
 
 	CU_ADD_TEST(suite, test_xor_gen);
+	CU_ADD_TEST(suite, test_pq_gen);
+	CU_ADD_TEST(suite, test_pq_recover);
 
 	CU_basic_set_mode(CU_BRM_VERBOSE);
 
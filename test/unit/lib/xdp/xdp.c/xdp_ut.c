@@ -0,0 +1,244 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2026 SPDK contributors.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_cunit.h"
+#include "xdp/xdp.c"
+
+#define UT_FRAME_SIZE	2048
+#define UT_NUM_FRAMES	8
+#define UT_RING_SIZE	4
+
+/* Rings normally shared with the kernel: producer, consumer and flags, then the entries */
+struct ut_ring {
+	uint32_t	indexes[3];
+	struct xdp_desc	descs[UT_RING_SIZE];
+	uint64_t	addrs[UT_RING_SIZE];
+};
+
+static struct ut_ring g_fill, g_comp, g_rx, g_tx;
+static uint8_t g_umem[UT_NUM_FRAMES * UT_FRAME_SIZE];
+static uint64_t g_free_frames[UT_NUM_FRAMES];
+
+static void
+ut_ring_init(struct xdp_ring *ring, struct ut_ring *ut_ring, bool descs)
+{
+	memset(ut_ring, 0, sizeof(*ut_ring));
+	memset(ring, 0, sizeof(*ring));
+	ring->producer = &ut_ring->indexes[0];
+	ring->consumer = &ut_ring->indexes[1];
+	ring->flags = &ut_ring->indexes[2];
+	ring->entries = descs ? (void *)ut_ring->descs : (void *)ut_ring->addrs;
+	ring->size = UT_RING_SIZE;
+	ring->mask = UT_RING_SIZE - 1;
+}
+
+static void
+ut_port_init(struct spdk_xdp_port *port)
+{
+	uint32_t i;
+
+	memset(port, 0, sizeof(*port));
+	port->fd = -1;
+	port->umem = g_umem;
+	port->umem_size = sizeof(g_umem);
+	port->frame_size = UT_FRAME_SIZE;
+	ut_ring_init(&port->fill, &g_fill, false);
+	ut_ring_init(&port->comp, &g_comp, false);
+	ut_ring_init(&port->rx, &g_rx, true);
+	ut_ring_init(&port->tx, &g_tx, true);
+
+	port->free_frames = g_free_frames;
+	for (i = 0; i < UT_NUM_FRAMES / 2; i++) {
+		port->free_frames[port->num_free_frames++] = (uint64_t)i * UT_FRAME_SIZE;
+	}
+}
+
+static void
+xdp_port_opts(void)
+{
+	struct spdk_xdp_port_opts opts, user_opts;
+	struct spdk_xdp_port *port = NULL;
+	int rc;
+
+	spdk_xdp_port_get_default_opts(&opts, sizeof(opts));
+	CU_ASSERT(opts.opts_size == sizeof(opts));
+	CU_ASSERT(opts.num_frames == XDP_DEFAULT_NUM_FRAMES);
+	CU_ASSERT(opts.frame_size == XDP_DEFAULT_FRAME_SIZE);
+	CU_ASSERT(opts.ring_size == XDP_DEFAULT_RING_SIZE);
+	CU_ASSERT(opts.skb_mode == false);
+	CU_ASSERT(opts.zero_copy == false);
+
+	/* Only the fields within opts_size are set */
+	memset(&opts, 0xff, sizeof(opts));
+	spdk_xdp_port_get_default_opts(&opts, offsetof(struct spdk_xdp_port_opts, frame_size));
+	CU_ASSERT(opts.num_frames == XDP_DEFAULT_NUM_FRAMES);
+	CU_ASSERT(opts.frame_size == UINT32_MAX);
+
+	/* Options of an older caller are completed with the defaults */
+	spdk_xdp_port_get_default_opts(&opts, sizeof(opts));
+	memset(&user_opts, 0xff, sizeof(user_opts));
+	user_opts.opts_size = offsetof(struct spdk_xdp_port_opts, ring_size);
+	user_opts.num_frames = 64;
+	user_opts.frame_size = 4096;
+	xdp_port_opts_copy(&opts, &user_opts);
+	CU_ASSERT(opts.num_frames == 64);
+	CU_ASSERT(opts.frame_size == 4096);
+	CU_ASSERT(opts.ring_size == XDP_DEFAULT_RING_SIZE);
+	CU_ASSERT(opts.skb_mode == false);
+
+	/* Invalid options are rejected before anything is set up */
+	spdk_xdp_port_get_default_opts(&user_opts, sizeof(user_opts));
+	user_opts.num_frames = 100;
+	rc = spdk_xdp_port_open("lo", 0, &user_opts, &port);
+	CU_ASSERT(rc == -EINVAL);
+
+	spdk_xdp_port_get_default_opts(&user_opts, sizeof(user_opts));
+	user_opts.frame_size = 1024;
+	rc = spdk_xdp_port_open("lo", 0, &user_opts, &port);
+	CU_ASSERT(rc == -EINVAL);
+
+	spdk_xdp_port_get_default_opts(&user_opts, sizeof(user_opts));
+	user_opts.ring_size = 1000;
+	rc = spdk_xdp_port_open("lo", 0, &user_opts, &port);
+	CU_ASSERT(rc == -EINVAL);
+
+	rc = spdk_xdp_port_open("lo", XDP_MAX_QUEUES, NULL, &port);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(port == NULL);
+}
+
+static void
+xdp_port_rx(void)
+{
+	struct spdk_xdp_port port;
+	struct spdk_xdp_frame frames[UT_RING_SIZE];
+	int rc;
+
+	ut_port_init(&port);
+
+	/* Nothing received */
+	rc = spdk_xdp_port_rx_burst(&port, frames, UT_RING_SIZE);
+	CU_ASSERT(rc == 0);
+
+	/* The kernel received 3 frames, at an offset within their frame */
+	g_rx.descs[0].addr = 4 * UT_FRAME_SIZE + 256;
+	g_rx.descs[0].len = 60;
+	g_rx.descs[1].addr = 5 * UT_FRAME_SIZE + 256;
+	g_rx.descs[1].len = 1514;
+	g_rx.descs[2].addr = 6 * UT_FRAME_SIZE + 256;
+	g_rx.descs[2].len = 100;
+	g_rx.indexes[0] = 3;
+
+	rc = spdk_xdp_port_rx_burst(&port, frames, 2);
+	CU_ASSERT(rc == 2);
+	CU_ASSERT(frames[0].buf == g_umem + 4 * UT_FRAME_SIZE + 256);
+	CU_ASSERT(frames[0].len == 60);
+	CU_ASSERT(frames[1].buf == g_umem + 5 * UT_FRAME_SIZE + 256);
+	CU_ASSERT(frames[1].len == 1514);
+	CU_ASSERT(g_rx.indexes[1] == 2);
+
+	/* The frames are given back to the kernel to receive into */
+	spdk_xdp_port_rx_release(&port, frames, 2);
+	CU_ASSERT(g_fill.indexes[0] == 2);
+	CU_ASSERT(g_fill.addrs[0] == 4 * UT_FRAME_SIZE);
+	CU_ASSERT(g_fill.addrs[1] == 5 * UT_FRAME_SIZE);
+
+	rc = spdk_xdp_port_rx_burst(&port, frames, UT_RING_SIZE);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(frames[0].buf == g_umem + 6 * UT_FRAME_SIZE + 256);
+	CU_ASSERT(g_rx.indexes[1] == 3);
+
+	spdk_xdp_port_rx_release(&port, frames, 1);
+	CU_ASSERT(g_fill.indexes[0] == 3);
+	CU_ASSERT(g_fill.addrs[2] == 6 * UT_FRAME_SIZE);
+}
+
+static void
+xdp_port_tx(void)
+{
+	struct spdk_xdp_port port;
+	struct spdk_xdp_frame frames[UT_NUM_FRAMES];
+	uint32_t i;
+	int rc;
+
+	ut_port_init(&port);
+
+	rc = spdk_xdp_port_tx_alloc(&port, frames, 3);
+	CU_ASSERT(rc == 3);
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(frames[i].len == UT_FRAME_SIZE);
+		CU_ASSERT(((uint8_t *)frames[i].buf - g_umem) % UT_FRAME_SIZE == 0);
+		frames[i].len = 64 + i;
+	}
+	CU_ASSERT(port.num_free_frames == 1);
+
+	/* Allocating more frames than available returns what's left */
+	rc = spdk_xdp_port_tx_alloc(&port, &frames[3], 2);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(port.num_free_frames == 0);
+
+	rc = spdk_xdp_port_tx_burst(&port, frames, 3);
+	CU_ASSERT(rc == 3);
+	CU_ASSERT(port.tx_outstanding == 3);
+	CU_ASSERT(g_tx.indexes[0] == 3);
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(g_tx.descs[i].addr == (uint64_t)((uint8_t *)frames[i].buf - g_umem));
+		CU_ASSERT(g_tx.descs[i].len == 64 + i);
+	}
+
+	/* Only one entry is left in the tx ring, the rest still belongs to the caller */
+	frames[4] = frames[3];
+	rc = spdk_xdp_port_tx_burst(&port, &frames[3], 2);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(port.tx_outstanding == 4);
+	rc = spdk_xdp_port_tx_burst(&port, &frames[4], 0);
+	CU_ASSERT(rc == 0);
+
+	/* The kernel transmitted the first 2 frames, they are reclaimed on allocation */
+	g_tx.indexes[1] = 4;
+	g_comp.addrs[0] = g_tx.descs[0].addr;
+	g_comp.addrs[1] = g_tx.descs[1].addr;
+	g_comp.indexes[0] = 2;
+	rc = spdk_xdp_port_tx_alloc(&port, frames, 1);
+	CU_ASSERT(rc == 1);
+	CU_ASSERT(port.tx_outstanding == 2);
+	CU_ASSERT(port.num_free_frames == 1);
+	CU_ASSERT(g_comp.indexes[1] == 2);
+
+	/* Frames that aren't transmitted are freed */
+	spdk_xdp_port_tx_free(&port, frames, 1);
+	CU_ASSERT(port.num_free_frames == 2);
+
+	g_comp.addrs[2] = g_tx.descs[2].addr;
+	g_comp.addrs[3] = g_tx.descs[3].addr;
+	g_comp.indexes[0] = 4;
+	rc = spdk_xdp_port_tx_alloc(&port, frames, UT_NUM_FRAMES);
+	CU_ASSERT(rc == UT_NUM_FRAMES / 2);
+	CU_ASSERT(port.tx_outstanding == 0);
+	CU_ASSERT(port.num_free_frames == 0);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_set_error_action(CUEA_ABORT);
+	CU_initialize_registry();
+
+	suite = CU_add_suite("xdp", NULL, NULL);
+	CU_ADD_TEST(suite, xdp_port_opts);
+	CU_ADD_TEST(suite, xdp_port_rx);
+	CU_ADD_TEST(suite, xdp_port_tx);
+
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	num_failures = CU_get_number_of_failures();
+	CU_cleanup_registry();
+
+	return num_failures;
+}
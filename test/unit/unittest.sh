@@ -49,6 +49,8 @@ function unittest_blob() {
 function unittest_event() {
 	$valgrind $testdir/lib/event/app.c/app_ut
 	$valgrind $testdir/lib/event/reactor.c/reactor_ut
+	$valgrind $testdir/lib/event/scheduler_predictive.c/scheduler_predictive_ut
+	$valgrind $testdir/lib/event/scheduler_gscheduler.c/scheduler_gscheduler_ut
 }
 
 function unittest_ftl() {
@@ -227,6 +229,10 @@ if grep -q '#define SPDK_CONFIG_RAID5F 1' $rootdir/include/spdk/config.h; then
 	run_test "unittest_bdev_raid5f" $valgrind $testdir/lib/bdev/raid/raid5f.c/raid5f_ut
 fi
 
+if grep -q '#define SPDK_CONFIG_RAID6F 1' $rootdir/include/spdk/config.h; then
+	run_test "unittest_bdev_raid6f" $valgrind $testdir/lib/bdev/raid/raid6f.c/raid6f_ut
+fi
+
 run_test "unittest_blob_blobfs" unittest_blob
 run_test "unittest_event" unittest_event
 if [ $(uname -s) = Linux ]; then
@@ -245,6 +251,7 @@ run_test "unittest_notify" $valgrind $testdir/lib/notify/notify.c/notify_ut
 run_test "unittest_nvme" unittest_nvme
 run_test "unittest_log" $valgrind $testdir/lib/log/log.c/log_ut
 run_test "unittest_lvol" $valgrind $testdir/lib/lvol/lvol.c/lvol_ut
+run_test "unittest_metrics" $valgrind $testdir/lib/metrics/metrics.c/metrics_ut
 if grep -q '#define SPDK_CONFIG_RDMA 1' $rootdir/include/spdk/config.h; then
 	run_test "unittest_nvme_rdma" $valgrind $testdir/lib/nvme/nvme_rdma.c/nvme_rdma_ut
 	run_test "unittest_nvmf_transport" $valgrind $testdir/lib/nvmf/transport.c/transport_ut
@@ -278,6 +285,9 @@ fi
 run_test "unittest_thread" $valgrind $testdir/lib/thread/thread.c/thread_ut
 run_test "unittest_iobuf" $valgrind $testdir/lib/thread/iobuf.c/iobuf_ut
 run_test "unittest_util" unittest_util
+if grep -q '#define SPDK_CONFIG_XDP 1' $rootdir/include/spdk/config.h; then
+	run_test "unittest_xdp" $valgrind $testdir/lib/xdp/xdp.c/xdp_ut
+fi
 if grep -q '#define SPDK_CONFIG_VHOST 1' $rootdir/include/spdk/config.h; then
 	run_test "unittest_vhost" $valgrind $testdir/lib/vhost/vhost.c/vhost_ut
 fi